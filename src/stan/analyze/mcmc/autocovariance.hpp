@@ -5,6 +5,9 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
 #include <unsupported/Eigen/FFT>
 #include <complex>
 #include <vector>
@@ -129,6 +132,115 @@ void autocovariance(const std::vector<T>& y, std::vector<T>& acov) {
   autocovariance<T>(y_map, acov_map);
 }
 
+/**
+ * FFT engine and scratch buffers for computing the autocorrelations
+ * or autocovariances of many sequences, one after another.  The first
+ * sequence of a given length sets up the FFT plan and sizes the
+ * buffers; later sequences of the same length reuse both, so they do
+ * not allocate.  Results are identical to those of the free functions
+ * `autocorrelation` and `autocovariance`.
+ *
+ * A workspace must not be used by more than one thread at a time.
+ *
+ * @tparam T Scalar type.
+ */
+template <typename T>
+class autocovariance_workspace {
+ public:
+  /**
+   * Write autocorrelation estimates for every lag for the specified
+   * input sequence into the specified result, as
+   * `autocorrelation(y, ac, fft)`.
+   *
+   * @param y Input sequence.
+   * @param ac Autocorrelations.
+   */
+  template <typename DerivedA, typename DerivedB>
+  void autocorrelation(const Eigen::MatrixBase<DerivedA>& y,
+                       Eigen::MatrixBase<DerivedB>& ac) {
+    size_t N = y.size();
+    size_t M = math::internal::fft_next_good_size(N);
+    size_t Mt2 = 2 * M;
+
+    // centered_signal = y-mean(y) followed by zeros
+    centered_signal_.resize(Mt2);
+    centered_signal_.setZero();
+    centered_signal_.head(N) = y.array() - y.mean();
+
+    freqvec_.resize(Mt2);
+    fft_.fwd(freqvec_, centered_signal_);
+    // cwiseAbs2 == norm
+    freqvec_ = freqvec_.cwiseAbs2();
+
+    ac_tmp_.resize(Mt2);
+    fft_.inv(ac_tmp_, freqvec_);
+
+    // use "biased" estimate as recommended by Geyer (1992)
+    ac = ac_tmp_.head(N).real().array() / (N * N * 2);
+    ac /= ac(0);
+  }
+
+  /**
+   * Write autocovariance estimates for every lag for the specified
+   * input sequence into the specified result, as
+   * `autocovariance<T>(y, acov)`.
+   *
+   * @param y Input sequence.
+   * @param acov Autocovariances.
+   */
+  template <typename DerivedA, typename DerivedB>
+  void autocovariance(const Eigen::MatrixBase<DerivedA>& y,
+                      Eigen::MatrixBase<DerivedB>& acov) {
+    autocorrelation(y, acov);
+
+    using boost::accumulators::accumulator_set;
+    using boost::accumulators::stats;
+    using boost::accumulators::tag::variance;
+
+    accumulator_set<double, stats<variance>> acc;
+    for (int n = 0; n < y.size(); ++n) {
+      acc(y(n));
+    }
+
+    acov = acov.array() * boost::accumulators::variance(acc);
+  }
+
+ private:
+  Eigen::FFT<T> fft_;
+  Eigen::Matrix<T, Eigen::Dynamic, 1> centered_signal_;
+  Eigen::Matrix<std::complex<T>, Eigen::Dynamic, 1> freqvec_;
+  Eigen::Matrix<std::complex<T>, Eigen::Dynamic, 1> ac_tmp_;
+};
+
+/**
+ * Write autocovariance estimates for every lag of every column of the
+ * specified block of sequences into the corresponding column of the
+ * specified result, which is resized to match.  Columns are processed
+ * in parallel; every thread reuses one FFT plan and one set of scratch
+ * buffers for all the columns it processes.  Each column of the result
+ * is identical to `autocovariance<T>` of the matching input column.
+ *
+ * @tparam T Scalar type.
+ * @param y Input sequences, one per column.
+ * @param acov Autocovariances, one column per sequence.
+ */
+template <typename T, typename Derived>
+void batch_autocovariance(
+    const Eigen::MatrixBase<Derived>& y,
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& acov) {
+  acov.resize(y.rows(), y.cols());
+  tbb::enumerable_thread_specific<autocovariance_workspace<T>> workspaces;
+  tbb::parallel_for(tbb::blocked_range<Eigen::Index>(0, y.cols()),
+                    [&](const tbb::blocked_range<Eigen::Index>& r) {
+                      autocovariance_workspace<T>& workspace
+                          = workspaces.local();
+                      for (Eigen::Index k = r.begin(); k != r.end(); ++k) {
+                        auto acov_k = acov.col(k);
+                        workspace.autocovariance(y.col(k), acov_k);
+                      }
+                    });
+}
+
 }  // namespace analyze
 }  // namespace stan
 
@@ -11,6 +11,83 @@
 
 namespace stan {
 namespace analyze {
+/**
+ * Computes the effective sample size (ESS) from the autocovariances
+ * and the means of the chains, as
+ * <code>compute_effective_sample_size</code> does once it has checked
+ * the draws.  The value returned is the minimum of ESS and the
+ * number_total_draws * log10(number_total_draws).
+ *
+ * @param acov autocovariances of each chain, at least num_draws lags
+ * each
+ * @param chain_mean mean of each chain
+ * @param num_draws number of draws of each chain, at least four
+ * @return effective sample size
+ */
+inline double compute_effective_sample_size(
+    const Eigen::Matrix<Eigen::VectorXd, Eigen::Dynamic, 1>& acov,
+    const Eigen::VectorXd& chain_mean, size_t num_draws) {
+  const int num_chains = chain_mean.size();
+  Eigen::VectorXd chain_var(num_chains);
+  for (int chain = 0; chain < num_chains; ++chain)
+    chain_var(chain) = acov(chain)(0) * num_draws / (num_draws - 1);
+
+  double mean_var = chain_var.mean();
+  double var_plus = mean_var * (num_draws - 1) / num_draws;
+  if (num_chains > 1)
+    var_plus += math::variance(chain_mean);
+  Eigen::VectorXd rho_hat_s(num_draws);
+  rho_hat_s.setZero();
+  Eigen::VectorXd acov_s(num_chains);
+  for (int chain = 0; chain < num_chains; ++chain)
+    acov_s(chain) = acov(chain)(1);
+  double rho_hat_even = 1.0;
+  rho_hat_s(0) = rho_hat_even;
+  double rho_hat_odd = 1 - (mean_var - acov_s.mean()) / var_plus;
+  rho_hat_s(1) = rho_hat_odd;
+
+  // Convert raw autocovariance estimators into Geyer's initial
+  // positive sequence. Loop only until num_draws - 4 to
+  // leave the last pair of autocorrelations as a bias term that
+  // reduces variance in the case of antithetical chains.
+  size_t s = 1;
+  while (s < (num_draws - 4) && (rho_hat_even + rho_hat_odd) > 0) {
+    for (int chain = 0; chain < num_chains; ++chain)
+      acov_s(chain) = acov(chain)(s + 1);
+    rho_hat_even = 1 - (mean_var - acov_s.mean()) / var_plus;
+    for (int chain = 0; chain < num_chains; ++chain)
+      acov_s(chain) = acov(chain)(s + 2);
+    rho_hat_odd = 1 - (mean_var - acov_s.mean()) / var_plus;
+    if ((rho_hat_even + rho_hat_odd) >= 0) {
+      rho_hat_s(s + 1) = rho_hat_even;
+      rho_hat_s(s + 2) = rho_hat_odd;
+    }
+    s += 2;
+  }
+
+  int max_s = s;
+  // this is used in the improved estimate, which reduces variance
+  // in antithetic case -- see tau_hat below
+  if (rho_hat_even > 0)
+    rho_hat_s(max_s + 1) = rho_hat_even;
+
+  // Convert Geyer's initial positive sequence into an initial
+  // monotone sequence
+  for (int s = 1; s <= max_s - 3; s += 2) {
+    if (rho_hat_s(s + 1) + rho_hat_s(s + 2) > rho_hat_s(s - 1) + rho_hat_s(s)) {
+      rho_hat_s(s + 1) = (rho_hat_s(s - 1) + rho_hat_s(s)) / 2;
+      rho_hat_s(s + 2) = rho_hat_s(s + 1);
+    }
+  }
+
+  double num_total_draws = num_chains * num_draws;
+  // Geyer's truncated estimator for the asymptotic variance
+  // Improved estimate reduces variance in antithetic case
+  double tau_hat = -1 + 2 * rho_hat_s.head(max_s).sum() + rho_hat_s(max_s + 1);
+  return std::min(num_total_draws / tau_hat,
+                  num_total_draws * std::log10(num_total_draws));
+}
+
 /**
  * Computes the effective sample size (ESS) for the specified
  * parameter across all kept samples.  The value returned is the
@@ -27,10 +104,13 @@ namespace analyze {
  *
  * @param draws stores pointers to arrays of chains
  * @param sizes stores sizes of chains
+ * @param workspace FFT engine and buffers for the autocovariances,
+ * reused across calls
  * @return effective sample size for the specified parameter
  */
-inline double compute_effective_sample_size(std::vector<const double*> draws,
-                                            std::vector<size_t> sizes) {
+inline double compute_effective_sample_size(
+    std::vector<const double*> draws, std::vector<size_t> sizes,
+    autocovariance_workspace<double>& workspace) {
   int num_chains = sizes.size();
   size_t num_draws = sizes[0];
   for (int chain = 1; chain < num_chains; ++chain) {
@@ -72,69 +152,38 @@ inline double compute_effective_sample_size(std::vector<const double*> draws,
 
   Eigen::Matrix<Eigen::VectorXd, Eigen::Dynamic, 1> acov(num_chains);
   Eigen::VectorXd chain_mean(num_chains);
-  Eigen::VectorXd chain_var(num_chains);
   for (int chain = 0; chain < num_chains; ++chain) {
     Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, 1>> draw(
         draws[chain], sizes[chain]);
-    autocovariance<double>(draw, acov(chain));
+    workspace.autocovariance(draw, acov(chain));
     chain_mean(chain) = draw.mean();
-    chain_var(chain) = acov(chain)(0) * num_draws / (num_draws - 1);
   }
 
-  double mean_var = chain_var.mean();
-  double var_plus = mean_var * (num_draws - 1) / num_draws;
-  if (num_chains > 1)
-    var_plus += math::variance(chain_mean);
-  Eigen::VectorXd rho_hat_s(num_draws);
-  rho_hat_s.setZero();
-  Eigen::VectorXd acov_s(num_chains);
-  for (int chain = 0; chain < num_chains; ++chain)
-    acov_s(chain) = acov(chain)(1);
-  double rho_hat_even = 1.0;
-  rho_hat_s(0) = rho_hat_even;
-  double rho_hat_odd = 1 - (mean_var - acov_s.mean()) / var_plus;
-  rho_hat_s(1) = rho_hat_odd;
-
-  // Convert raw autocovariance estimators into Geyer's initial
-  // positive sequence. Loop only until num_draws - 4 to
-  // leave the last pair of autocorrelations as a bias term that
-  // reduces variance in the case of antithetical chains.
-  size_t s = 1;
-  while (s < (num_draws - 4) && (rho_hat_even + rho_hat_odd) > 0) {
-    for (int chain = 0; chain < num_chains; ++chain)
-      acov_s(chain) = acov(chain)(s + 1);
-    rho_hat_even = 1 - (mean_var - acov_s.mean()) / var_plus;
-    for (int chain = 0; chain < num_chains; ++chain)
-      acov_s(chain) = acov(chain)(s + 2);
-    rho_hat_odd = 1 - (mean_var - acov_s.mean()) / var_plus;
-    if ((rho_hat_even + rho_hat_odd) >= 0) {
-      rho_hat_s(s + 1) = rho_hat_even;
-      rho_hat_s(s + 2) = rho_hat_odd;
-    }
-    s += 2;
-  }
-
-  int max_s = s;
-  // this is used in the improved estimate, which reduces variance
-  // in antithetic case -- see tau_hat below
-  if (rho_hat_even > 0)
-    rho_hat_s(max_s + 1) = rho_hat_even;
-
-  // Convert Geyer's initial positive sequence into an initial
-  // monotone sequence
-  for (int s = 1; s <= max_s - 3; s += 2) {
-    if (rho_hat_s(s + 1) + rho_hat_s(s + 2) > rho_hat_s(s - 1) + rho_hat_s(s)) {
-      rho_hat_s(s + 1) = (rho_hat_s(s - 1) + rho_hat_s(s)) / 2;
-      rho_hat_s(s + 2) = rho_hat_s(s + 1);
-    }
-  }
+  return compute_effective_sample_size(acov, chain_mean, num_draws);
+}
 
-  double num_total_draws = num_chains * num_draws;
-  // Geyer's truncated estimator for the asymptotic variance
-  // Improved estimate reduces variance in antithetic case
-  double tau_hat = -1 + 2 * rho_hat_s.head(max_s).sum() + rho_hat_s(max_s + 1);
-  return std::min(num_total_draws / tau_hat,
-                  num_total_draws * std::log10(num_total_draws));
+/**
+ * Computes the effective sample size (ESS) for the specified
+ * parameter across all kept samples.  The value returned is the
+ * minimum of ESS and the number_total_draws *
+ * log10(number_total_draws).
+ *
+ * See more details in Stan reference manual section "Effective
+ * Sample Size". http://mc-stan.org/users/documentation
+ *
+ * Current implementation assumes draws are stored in contiguous
+ * blocks of memory.  Chains are trimmed from the back to match the
+ * length of the shortest chain.  Note that the effective sample size
+ * can not be estimated with less than four draws.
+ *
+ * @param draws stores pointers to arrays of chains
+ * @param sizes stores sizes of chains
+ * @return effective sample size for the specified parameter
+ */
+inline double compute_effective_sample_size(std::vector<const double*> draws,
+                                            std::vector<size_t> sizes) {
+  autocovariance_workspace<double> workspace;
+  return compute_effective_sample_size(draws, sizes, workspace);
 }
 
 /**
@@ -180,10 +229,13 @@ inline double compute_effective_sample_size(std::vector<const double*> draws,
  *
  * @param draws stores pointers to arrays of chains
  * @param sizes stores sizes of chains
+ * @param workspace FFT engine and buffers for the autocovariances,
+ * reused across calls
  * @return effective sample size for the specified parameter
  */
 inline double compute_split_effective_sample_size(
-    std::vector<const double*> draws, std::vector<size_t> sizes) {
+    std::vector<const double*> draws, std::vector<size_t> sizes,
+    autocovariance_workspace<double>& workspace) {
   int num_chains = sizes.size();
   size_t num_draws = sizes[0];
   for (int chain = 1; chain < num_chains; ++chain) {
@@ -195,7 +247,32 @@ inline double compute_split_effective_sample_size(
   double half = num_draws / 2.0;
   std::vector<size_t> half_sizes(2 * num_chains, std::floor(half));
 
-  return compute_effective_sample_size(split_draws, half_sizes);
+  return compute_effective_sample_size(split_draws, half_sizes, workspace);
+}
+
+/**
+ * Computes the split effective sample size (ESS) for the specified
+ * parameter across all kept samples.  The value returned is the
+ * minimum of ESS and the number_total_draws *
+ * log10(number_total_draws). When the number of total draws N is
+ * odd, the (N+1)/2th draw is ignored.
+ *
+ * See more details in Stan reference manual section "Effective
+ * Sample Size". http://mc-stan.org/users/documentation
+ *
+ * Current implementation assumes draws are stored in contiguous
+ * blocks of memory.  Chains are trimmed from the back to match the
+ * length of the shortest chain.  Note that the effective sample size
+ * can not be estimated with less than four draws.
+ *
+ * @param draws stores pointers to arrays of chains
+ * @param sizes stores sizes of chains
+ * @return effective sample size for the specified parameter
+ */
+inline double compute_split_effective_sample_size(
+    std::vector<const double*> draws, std::vector<size_t> sizes) {
+  autocovariance_workspace<double> workspace;
+  return compute_split_effective_sample_size(draws, sizes, workspace);
 }
 
 /**
@@ -0,0 +1,75 @@
+#ifndef STAN_ANALYZE_MCMC_COMPUTE_NESTED_POTENTIAL_SCALE_REDUCTION_HPP
+#define STAN_ANALYZE_MCMC_COMPUTE_NESTED_POTENTIAL_SCALE_REDUCTION_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cmath>
+#include <limits>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Computes the nested potential scale reduction (nested Rhat) of one
+ * parameter, for many short chains grouped into superchains whose chains
+ * started from the same initial value.  Unlike Rhat, it stays reliable
+ * when each chain has few draws, even a single one.  Based on the paper
+ * https://arxiv.org/abs/2110.13017
+ *
+ * With K superchains of M chains of N draws, the variance between the
+ * means of the superchains is compared to the mean of the variance
+ * within each superchain, the latter being the variance between the
+ * means of its chains plus the mean variance within its chains:
+ * <code>sqrt(1 + B / W)</code>.  The variance between the means of the
+ * chains is left out if M is one and the variance within the chains if
+ * N is one.
+ *
+ * @param draws stores chains in columns, the chains of each superchain
+ *   being consecutive
+ * @param num_superchains number of superchains K, dividing the number of
+ *   chains, at least two
+ * @return nested potential scale reduction, or NaN if it is undefined,
+ *   as for constant or non-finite draws
+ */
+inline double compute_nested_potential_scale_reduction(
+    const Eigen::MatrixXd& draws, Eigen::Index num_superchains) {
+  const Eigen::Index num_draws = draws.rows();
+  const Eigen::Index num_chains = draws.cols();
+  if (num_superchains < 2 || num_draws == 0
+      || num_chains % num_superchains != 0 || !draws.allFinite())
+    return std::numeric_limits<double>::quiet_NaN();
+  const Eigen::Index chains_per_superchain = num_chains / num_superchains;
+
+  const Eigen::RowVectorXd chain_means = draws.colwise().mean();
+  double within_variance = 0;
+  if (num_draws > 1)
+    within_variance = (draws.rowwise() - chain_means).squaredNorm()
+                      / ((num_draws - 1.0) * num_chains);
+
+  Eigen::VectorXd superchain_means(num_superchains);
+  double between_chain_variance = 0;
+  for (Eigen::Index k = 0; k < num_superchains; ++k) {
+    auto means
+        = chain_means.segment(k * chains_per_superchain, chains_per_superchain);
+    superchain_means(k) = means.mean();
+    if (chains_per_superchain > 1)
+      between_chain_variance += (means.array() - superchain_means(k))
+                                    .square()
+                                    .sum()
+                                / (chains_per_superchain - 1.0);
+  }
+  between_chain_variance /= num_superchains;
+
+  const double between_superchain_variance
+      = (superchain_means.array() - superchain_means.mean()).square().sum()
+        / (num_superchains - 1.0);
+  const double within_superchain_variance
+      = between_chain_variance + within_variance;
+  if (!(within_superchain_variance > 0))
+    return std::numeric_limits<double>::quiet_NaN();
+  return std::sqrt(1 + between_superchain_variance
+                           / within_superchain_variance);
+}
+
+}  // namespace analyze
+}  // namespace stan
+#endif
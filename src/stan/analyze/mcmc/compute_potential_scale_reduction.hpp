@@ -17,52 +17,6 @@
 namespace stan {
 namespace analyze {
 
-/**
- * Computes normalized average ranks for draws. Transforming them to normal
- * scores using inverse normal transformation and a fractional offset. Based on
- * paper https://arxiv.org/abs/1903.08008
- * @param chains stores chains in columns
- * @return normal scores for average ranks of draws
- */
-inline Eigen::MatrixXd rank_transform(const Eigen::MatrixXd& chains) {
-  const Eigen::Index rows = chains.rows();
-  const Eigen::Index cols = chains.cols();
-  const Eigen::Index size = rows * cols;
-
-  std::vector<std::pair<double, int>> value_with_index(size);
-
-  for (Eigen::Index i = 0; i < size; ++i) {
-    value_with_index[i] = {chains(i), i};
-  }
-
-  std::sort(value_with_index.begin(), value_with_index.end());
-
-  Eigen::MatrixXd rank_matrix = Eigen::MatrixXd::Zero(rows, cols);
-
-  // Assigning average ranks
-  for (Eigen::Index i = 0; i < size; ++i) {
-    // Handle ties by averaging ranks
-    Eigen::Index j = i + 1;
-    double sum_ranks = j;
-    Eigen::Index count = 1;
-
-    while (j < size && value_with_index[j].first == value_with_index[i].first) {
-      sum_ranks += j + 1;  // Rank starts from 1
-      ++j;
-      ++count;
-    }
-    double avg_rank = sum_ranks / count;
-    boost::math::normal_distribution<double> dist;
-    for (std::size_t k = i; k < j; ++k) {
-      double p = (avg_rank - 3.0 / 8.0) / (size - 2.0 * 3.0 / 8.0 + 1.0);
-      const Eigen::Index index = value_with_index[k].second;
-      rank_matrix(index) = boost::math::quantile(dist, p);
-    }
-    i = j - 1;  // Skip over tied elements
-  }
-  return rank_matrix;
-}
-
 /**
  * Computes square root of marginal posterior variance of the estimand by the
  * weigted average of within-chain variance W and between-chain variance B.
@@ -97,6 +51,194 @@ inline double rhat(const Eigen::MatrixXd& chains) {
   return sqrt((between_variance / within_variance + num_draws - 1) / num_draws);
 }
 
+/**
+ * Reusable storage for the rank normalization of draws.  Holding one
+ * workspace per thread and passing it to the rank based diagnostics
+ * avoids reallocating the sort buffers and the rank matrices for every
+ * parameter.  The normal scores of untied ranks are cached, since they
+ * only depend on the total number of draws.
+ *
+ * Both the ranks of the draws and the ranks of the draws folded around
+ * their median are computed from a single sort: the folded draws are
+ * ordered by merging the draws below and above the median.
+ *
+ * A workspace must not be used by more than one thread at a time.
+ */
+class rank_workspace {
+ public:
+  /**
+   * Write the normal scores of the average ranks of the draws to bulk.
+   *
+   * @param chains stores chains in columns
+   * @param[out] bulk normal scores, same size as chains
+   */
+  void rank_transform(const Eigen::MatrixXd& chains, Eigen::MatrixXd& bulk) {
+    sort_draws(chains);
+    bulk.resize(chains.rows(), chains.cols());
+    assign_scores(sorted_, bulk);
+  }
+
+  /**
+   * Write the normal scores of the average ranks of the draws to bulk
+   * and those of the absolute deviations of the draws from their
+   * median to tail.
+   *
+   * @param chains stores chains in columns
+   * @param[out] bulk normal scores of the draws, same size as chains
+   * @param[out] tail normal scores of the folded draws, same size as
+   *   chains
+   */
+  void rank_transform(const Eigen::MatrixXd& chains, Eigen::MatrixXd& bulk,
+                      Eigen::MatrixXd& tail) {
+    rank_transform(chains, bulk);
+    fold_sorted_draws();
+    tail.resize(chains.rows(), chains.cols());
+    assign_scores(folded_, tail);
+  }
+
+  /**
+   * Return the quantile of the draws last rank transformed, without
+   * sorting them again.  It is the quantile returned by
+   * math::quantile(draws, prob).
+   *
+   * @param prob probability of the quantile, between 0 and 1
+   */
+  double quantile(double prob) const {
+    const double index = (sorted_.size() - 1) * prob;
+    const Eigen::Index lo = std::floor(index);
+    const Eigen::Index hi = std::ceil(index);
+    const double h = index - lo;
+    return (1 - h) * sorted_[lo].first + h * sorted_[hi].first;
+  }
+
+  /**
+   * Return a matrix owned by the workspace, resized to the specified
+   * dimensions, to copy draws into.
+   */
+  Eigen::MatrixXd& draws(Eigen::Index rows, Eigen::Index cols) {
+    draws_.resize(rows, cols);
+    return draws_;
+  }
+
+  /**
+   * Return the rank based potential scale reductions of the bulk and
+   * the tail of the specified draws.
+   *
+   * @param chains stores chains in columns
+   * @return pair of bulk and tail potential scale reductions
+   */
+  std::pair<double, double> bulk_tail(const Eigen::MatrixXd& chains) {
+    rank_transform(chains, bulk_, tail_);
+    return std::make_pair(rhat(bulk_), rhat(tail_));
+  }
+
+ private:
+  void sort_draws(const Eigen::MatrixXd& chains) {
+    const Eigen::Index size = chains.size();
+    sorted_.resize(size);
+    for (Eigen::Index i = 0; i < size; ++i) {
+      sorted_[i] = {chains(i), i};
+    }
+    std::sort(sorted_.begin(), sorted_.end());
+  }
+
+  /**
+   * Order the absolute deviations from the median of the sorted draws
+   * by merging the draws below the median, taken downwards, with the
+   * draws above it, taken upwards.  The median is the one returned by
+   * math::quantile(draws, 0.5).
+   */
+  void fold_sorted_draws() {
+    const Eigen::Index size = sorted_.size();
+    const double median = quantile(0.5);
+
+    Eigen::Index above = std::upper_bound(sorted_.begin(), sorted_.end(),
+                                          std::make_pair(median, size))
+                         - sorted_.begin();
+    Eigen::Index below = above - 1;
+    folded_.resize(size);
+    for (Eigen::Index i = 0; i < size; ++i) {
+      const double folded_below
+          = below >= 0 ? std::abs(sorted_[below].first - median)
+                       : std::numeric_limits<double>::infinity();
+      const double folded_above
+          = above < size ? std::abs(sorted_[above].first - median)
+                         : std::numeric_limits<double>::infinity();
+      if (above >= size || (below >= 0 && folded_below <= folded_above)) {
+        folded_[i] = {folded_below, sorted_[below].second};
+        --below;
+      } else {
+        folded_[i] = {folded_above, sorted_[above].second};
+        ++above;
+      }
+    }
+  }
+
+  /**
+   * Assign the normal score of its average rank to every draw, in the
+   * order of the sorted draws.
+   */
+  void assign_scores(const std::vector<std::pair<double, Eigen::Index>>& sorted,
+                     Eigen::MatrixXd& ranks) {
+    const Eigen::Index size = sorted.size();
+    if (scores_.size() != static_cast<size_t>(size)) {
+      scores_.assign(size, std::numeric_limits<double>::quiet_NaN());
+    }
+    for (Eigen::Index i = 0; i < size; ++i) {
+      // Handle ties by averaging ranks
+      Eigen::Index j = i + 1;
+      double sum_ranks = j;
+      Eigen::Index count = 1;
+
+      while (j < size && sorted[j].first == sorted[i].first) {
+        sum_ranks += j + 1;  // Rank starts from 1
+        ++j;
+        ++count;
+      }
+      double score;
+      if (count == 1) {
+        if (std::isnan(scores_[i])) {
+          scores_[i] = normal_score(sum_ranks, size);
+        }
+        score = scores_[i];
+      } else {
+        score = normal_score(sum_ranks / count, size);
+      }
+      for (Eigen::Index k = i; k < j; ++k) {
+        ranks(sorted[k].second) = score;
+      }
+      i = j - 1;  // Skip over tied elements
+    }
+  }
+
+  static double normal_score(double avg_rank, Eigen::Index size) {
+    boost::math::normal_distribution<double> dist;
+    double p = (avg_rank - 3.0 / 8.0) / (size - 2.0 * 3.0 / 8.0 + 1.0);
+    return boost::math::quantile(dist, p);
+  }
+
+  std::vector<std::pair<double, Eigen::Index>> sorted_;
+  std::vector<std::pair<double, Eigen::Index>> folded_;
+  std::vector<double> scores_;
+  Eigen::MatrixXd draws_;
+  Eigen::MatrixXd bulk_;
+  Eigen::MatrixXd tail_;
+};
+
+/**
+ * Computes normalized average ranks for draws. Transforming them to normal
+ * scores using inverse normal transformation and a fractional offset. Based on
+ * paper https://arxiv.org/abs/1903.08008
+ * @param chains stores chains in columns
+ * @return normal scores for average ranks of draws
+ */
+inline Eigen::MatrixXd rank_transform(const Eigen::MatrixXd& chains) {
+  rank_workspace workspace;
+  Eigen::MatrixXd rank_matrix;
+  workspace.rank_transform(chains, rank_matrix);
+  return rank_matrix;
+}
+
 /**
  * Computes the potential scale reduction (Rhat) using rank based diagnostic for
  * the specified parameter across all kept samples. Based on paper
@@ -108,11 +250,12 @@ inline double rhat(const Eigen::MatrixXd& chains) {
  *
  * @param chain_begins stores pointers to arrays of chains
  * @param chain_sizes stores sizes of chains
+ * @param workspace rank normalization buffers to reuse
  * @return potential scale reduction for the specified parameter
  */
 inline std::pair<double, double> compute_potential_scale_reduction_rank(
     const std::vector<const double*>& chain_begins,
-    const std::vector<size_t>& chain_sizes) {
+    const std::vector<size_t>& chain_sizes, rank_workspace& workspace) {
   std::vector<const double*> nonzero_chain_begins;
   std::vector<std::size_t> nonzero_chain_sizes;
   nonzero_chain_begins.reserve(chain_begins.size());
@@ -136,7 +279,8 @@ inline std::pair<double, double> compute_potential_scale_reduction_rank(
   // check if chains are constant; all equal to first draw's value
   bool are_all_const = false;
   Eigen::VectorXd init_draw = Eigen::VectorXd::Zero(num_nonzero_chains);
-  Eigen::MatrixXd draws_matrix(min_num_draws, num_nonzero_chains);
+  Eigen::MatrixXd& draws_matrix
+      = workspace.draws(min_num_draws, num_nonzero_chains);
 
   for (std::size_t chain = 0; chain < num_nonzero_chains; chain++) {
     Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, 1>> draws(
@@ -159,12 +303,28 @@ inline std::pair<double, double> compute_potential_scale_reduction_rank(
             std::numeric_limits<double>::quiet_NaN()};
   }
 
-  double rhat_bulk = rhat(rank_transform(draws_matrix));
-  double rhat_tail = rhat(rank_transform(
-      (draws_matrix.array() - math::quantile(draws_matrix.reshaped(), 0.5))
-          .abs()));
+  return workspace.bulk_tail(draws_matrix);
+}
 
-  return std::make_pair(rhat_bulk, rhat_tail);
+/**
+ * Computes the potential scale reduction (Rhat) using rank based diagnostic for
+ * the specified parameter across all kept samples. Based on paper
+ * https://arxiv.org/abs/1903.08008
+ *
+ * Current implementation assumes draws are stored in contiguous
+ * blocks of memory.  Chains are trimmed from the back to match the
+ * length of the shortest chain.
+ *
+ * @param chain_begins stores pointers to arrays of chains
+ * @param chain_sizes stores sizes of chains
+ * @return potential scale reduction for the specified parameter
+ */
+inline std::pair<double, double> compute_potential_scale_reduction_rank(
+    const std::vector<const double*>& chain_begins,
+    const std::vector<size_t>& chain_sizes) {
+  rank_workspace workspace;
+  return compute_potential_scale_reduction_rank(chain_begins, chain_sizes,
+                                                workspace);
 }
 
 /**
@@ -314,11 +474,12 @@ inline double compute_potential_scale_reduction(
  *
  * @param chain_begins stores pointers to arrays of chains
  * @param chain_sizes stores sizes of chains
+ * @param workspace rank normalization buffers to reuse
  * @return potential scale reduction for the specified parameter
  */
 inline std::pair<double, double> compute_split_potential_scale_reduction_rank(
     const std::vector<const double*>& chain_begins,
-    const std::vector<size_t>& chain_sizes) {
+    const std::vector<size_t>& chain_sizes, rank_workspace& workspace) {
   size_t num_chains = chain_sizes.size();
   size_t num_draws = chain_sizes[0];
   for (size_t chain = 1; chain < num_chains; ++chain) {
@@ -331,7 +492,31 @@ inline std::pair<double, double> compute_split_potential_scale_reduction_rank(
   size_t half = std::floor(num_draws / 2.0);
   std::vector<size_t> half_sizes(2 * num_chains, half);
 
-  return compute_potential_scale_reduction_rank(split_draws, half_sizes);
+  return compute_potential_scale_reduction_rank(split_draws, half_sizes,
+                                                workspace);
+}
+
+/**
+ * Computes the potential scale reduction (Rhat) using rank based diagnostic for
+ * the specified parameter across all kept samples. Based on paper
+ * https://arxiv.org/abs/1903.08008
+ *
+ * When the number of total draws N is odd, the (N+1)/2th draw is ignored.
+ *
+ * Current implementation assumes draws are stored in contiguous
+ * blocks of memory. Chains are trimmed from the back to match the
+ * length of the shortest chain.
+ *
+ * @param chain_begins stores pointers to arrays of chains
+ * @param chain_sizes stores sizes of chains
+ * @return potential scale reduction for the specified parameter
+ */
+inline std::pair<double, double> compute_split_potential_scale_reduction_rank(
+    const std::vector<const double*>& chain_begins,
+    const std::vector<size_t>& chain_sizes) {
+  rank_workspace workspace;
+  return compute_split_potential_scale_reduction_rank(chain_begins,
+                                                      chain_sizes, workspace);
 }
 
 /**
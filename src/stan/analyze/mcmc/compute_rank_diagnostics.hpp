@@ -0,0 +1,257 @@
+#ifndef STAN_ANALYZE_MCMC_COMPUTE_RANK_DIAGNOSTICS_HPP
+#define STAN_ANALYZE_MCMC_COMPUTE_RANK_DIAGNOSTICS_HPP
+
+#include <stan/math/prim.hpp>
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/analyze/mcmc/split_chains.hpp>
+#include <unsupported/Eigen/FFT>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Rank based convergence diagnostics of one parameter, after
+ * https://arxiv.org/abs/1903.08008.
+ */
+struct rank_diagnostics {
+  /**
+   * Split effective sample size of the normal scores of the ranks
+   */
+  double ess_bulk;
+
+  /**
+   * Smaller of the split effective sample sizes of the indicators of
+   * the draws below their 5% and 95% quantiles
+   */
+  double ess_tail;
+
+  /**
+   * Split potential scale reduction of the normal scores of the ranks
+   */
+  double rhat_bulk;
+
+  /**
+   * Split potential scale reduction of the normal scores of the ranks
+   * of the draws folded around their median
+   */
+  double rhat_tail;
+};
+
+/**
+ * Reusable storage for <code>compute_split_rank_diagnostics</code>:
+ * the rank normalization, an FFT engine, and the buffers of the
+ * sequences whose autocovariances are taken.  Holding one workspace
+ * per thread avoids reallocating them for every parameter.
+ *
+ * A workspace must not be used by more than one thread at a time.
+ */
+class rank_diagnostics_workspace {
+ public:
+  /**
+   * Return the rank diagnostics of the specified draws.
+   *
+   * @param draws draws of the split chains, one chain per column
+   * @return rank diagnostics
+   */
+  rank_diagnostics compute(const Eigen::MatrixXd& draws) {
+    const Eigen::Index num_draws = draws.rows();
+    const Eigen::Index num_chains = draws.cols();
+    rank_diagnostics result;
+    ranks_.rank_transform(draws, bulk_, tail_);
+    result.rhat_bulk = rhat(bulk_);
+    result.rhat_tail = rhat(tail_);
+    result.ess_bulk = std::numeric_limits<double>::quiet_NaN();
+    result.ess_tail = std::numeric_limits<double>::quiet_NaN();
+    if (num_draws < 4)
+      return result;
+
+    // The normal scores, then the indicators of the draws below the
+    // 5% and 95% quantiles, one column per chain
+    const double q05 = ranks_.quantile(0.05);
+    const double q95 = ranks_.quantile(0.95);
+    sequences_.resize(num_draws, 3 * num_chains);
+    sequences_.leftCols(num_chains) = bulk_;
+    sequences_.middleCols(num_chains, num_chains)
+        = (draws.array() <= q05).cast<double>().matrix();
+    sequences_.rightCols(num_chains)
+        = (draws.array() <= q95).cast<double>().matrix();
+    autocovariances();
+
+    result.ess_bulk = effective_sample_size(0);
+    const double ess_05 = effective_sample_size(1);
+    const double ess_95 = effective_sample_size(2);
+    result.ess_tail = std::isnan(ess_05) || std::isnan(ess_95)
+                          ? std::numeric_limits<double>::quiet_NaN()
+                          : std::min(ess_05, ess_95);
+    return result;
+  }
+
+  /**
+   * Return a matrix owned by the workspace, resized to the specified
+   * dimensions, to copy draws into.
+   */
+  Eigen::MatrixXd& draws(Eigen::Index rows, Eigen::Index cols) {
+    return ranks_.draws(rows, cols);
+  }
+
+ private:
+  /**
+   * Write the autocovariances of every column of the sequences, two
+   * columns per complex FFT: the spectra of the real and imaginary
+   * parts of a complex signal are recovered from its transform by its
+   * conjugate symmetry, and their power spectra are transformed back
+   * together, as the real and imaginary parts of one signal.  The
+   * autocovariances are normalized by the number of draws, as those of
+   * <code>autocovariance</code>.
+   */
+  void autocovariances() {
+    const Eigen::Index num_draws = sequences_.rows();
+    const Eigen::Index num_sequences = sequences_.cols();
+    const Eigen::Index size
+        = 2 * math::internal::fft_next_good_size(num_draws);
+    acov_.resize(num_sequences);
+    means_ = sequences_.colwise().mean();
+    signal_.resize(size);
+    power_.resize(size);
+    for (Eigen::Index j = 0; j < num_sequences; j += 2) {
+      const bool pair = j + 1 < num_sequences;
+      signal_.setZero();
+      signal_.head(num_draws).real() = sequences_.col(j).array() - means_(j);
+      if (pair)
+        signal_.head(num_draws).imag()
+            = sequences_.col(j + 1).array() - means_(j + 1);
+      fft_.fwd(spectrum_, signal_);
+      for (Eigen::Index k = 0; k < size; ++k) {
+        const std::complex<double> z = spectrum_(k);
+        const std::complex<double> z_reflected
+            = std::conj(spectrum_((size - k) % size));
+        power_(k) = {std::norm(z + z_reflected) / 4,
+                     std::norm(z - z_reflected) / 4};
+      }
+      fft_.inv(signal_, power_);
+      acov_(j) = signal_.head(num_draws).real() / num_draws;
+      if (pair)
+        acov_(j + 1) = signal_.head(num_draws).imag() / num_draws;
+    }
+  }
+
+  /**
+   * Return the effective sample size of the specified block of
+   * sequences, or NaN if all their values are equal.
+   *
+   * @param block 0 for the normal scores, 1 and 2 for the indicators
+   *   of the draws below the 5% and 95% quantiles
+   */
+  double effective_sample_size(Eigen::Index block) const {
+    const Eigen::Index num_chains = sequences_.cols() / 3;
+    const auto sequences = sequences_.middleCols(block * num_chains,
+                                                 num_chains);
+    if ((sequences.array() == sequences(0, 0)).all())
+      return std::numeric_limits<double>::quiet_NaN();
+    return compute_effective_sample_size(
+        acov_.segment(block * num_chains, num_chains),
+        means_.segment(block * num_chains, num_chains).transpose(),
+        sequences_.rows());
+  }
+
+  rank_workspace ranks_;
+  Eigen::MatrixXd bulk_;
+  Eigen::MatrixXd tail_;
+  Eigen::MatrixXd sequences_;
+  Eigen::RowVectorXd means_;
+  Eigen::Matrix<Eigen::VectorXd, Eigen::Dynamic, 1> acov_;
+  Eigen::FFT<double> fft_;
+  Eigen::VectorXcd signal_;
+  Eigen::VectorXcd spectrum_;
+  Eigen::VectorXcd power_;
+};
+
+/**
+ * Computes the bulk and tail effective sample sizes and the bulk and
+ * tail rank based split potential scale reductions of the specified
+ * parameter across all kept samples, from a single sort of its split
+ * draws.  Based on paper https://arxiv.org/abs/1903.08008
+ *
+ * The potential scale reductions are those of
+ * <code>compute_split_potential_scale_reduction_rank</code>.  The bulk
+ * effective sample size is the split effective sample size of the
+ * normal scores of the ranks, and the tail effective sample size the
+ * smaller of those of the indicators of the draws below their 5% and
+ * 95% quantiles, each as <code>compute_effective_sample_size</code>
+ * computes it, up to rounding.  The autocovariances of the split
+ * chains of all three are taken two at a time, with one complex FFT.
+ *
+ * When the number of total draws N is odd, the (N+1)/2th draw is
+ * ignored.  All diagnostics are NaN if a draw is not finite or all
+ * draws are equal, and the effective sample sizes are NaN with less
+ * than four draws per split chain.
+ *
+ * Current implementation assumes draws are stored in contiguous
+ * blocks of memory.  Chains are trimmed from the back to match the
+ * length of the shortest chain.
+ *
+ * @param chain_begins stores pointers to arrays of chains
+ * @param chain_sizes stores sizes of chains
+ * @param workspace buffers to reuse
+ * @return rank diagnostics of the specified parameter
+ */
+inline rank_diagnostics compute_split_rank_diagnostics(
+    const std::vector<const double*>& chain_begins,
+    const std::vector<size_t>& chain_sizes,
+    rank_diagnostics_workspace& workspace) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const size_t num_chains = chain_sizes.size();
+  size_t num_draws = chain_sizes[0];
+  for (size_t chain = 1; chain < num_chains; ++chain) {
+    num_draws = std::min(num_draws, chain_sizes[chain]);
+  }
+  const size_t half = num_draws / 2;
+  if (half == 0) {
+    return {nan, nan, nan, nan};
+  }
+
+  std::vector<const double*> split_draws
+      = split_chains(chain_begins, chain_sizes);
+  Eigen::MatrixXd& draws = workspace.draws(half, 2 * num_chains);
+  for (size_t chain = 0; chain < 2 * num_chains; ++chain) {
+    for (size_t n = 0; n < half; ++n) {
+      if (!std::isfinite(split_draws[chain][n])) {
+        return {nan, nan, nan, nan};
+      }
+      draws(n, chain) = split_draws[chain][n];
+    }
+  }
+  if (draws.isApproxToConstant(draws(0, 0))) {
+    return {nan, nan, nan, nan};
+  }
+  return workspace.compute(draws);
+}
+
+/**
+ * Computes the bulk and tail effective sample sizes and the bulk and
+ * tail rank based split potential scale reductions of the specified
+ * parameter across all kept samples, as
+ * <code>compute_split_rank_diagnostics</code> with a workspace of its
+ * own.
+ *
+ * @param chain_begins stores pointers to arrays of chains
+ * @param chain_sizes stores sizes of chains
+ * @return rank diagnostics of the specified parameter
+ */
+inline rank_diagnostics compute_split_rank_diagnostics(
+    const std::vector<const double*>& chain_begins,
+    const std::vector<size_t>& chain_sizes) {
+  rank_diagnostics_workspace workspace;
+  return compute_split_rank_diagnostics(chain_begins, chain_sizes, workspace);
+}
+
+}  // namespace analyze
+}  // namespace stan
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef STAN_ANALYZE_MCMC_ONLINE_BATCH_MEANS_HPP
+#define STAN_ANALYZE_MCMC_ONLINE_BATCH_MEANS_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <stdexcept>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Accumulates the draws of one chain into the means and sums of
+ * squared deviations of consecutive, equally sized batches, for every
+ * parameter at once.
+ *
+ * The batch size starts at one and doubles, by merging neighbouring
+ * batches, whenever the maximum number of batches is reached, so the
+ * memory used does not grow with the number of draws.  Draws of the
+ * batch still being filled are kept in a running mean and sum of
+ * squared deviations and are not part of the completed batches.
+ */
+class online_batch_means {
+ public:
+  /**
+   * Construct an empty accumulator.
+   *
+   * @param[in] num_params number of parameters of each draw
+   * @param[in] max_batches maximum number of completed batches, even
+   *   and at least four
+   * @throw std::invalid_argument if max_batches is odd or less than four
+   */
+  explicit online_batch_means(Eigen::Index num_params,
+                              Eigen::Index max_batches = 64)
+      : batch_size_(1),
+        num_batches_(0),
+        current_count_(0),
+        current_mean_(Eigen::VectorXd::Zero(num_params)),
+        current_m2_(Eigen::VectorXd::Zero(num_params)),
+        means_(num_params, max_batches),
+        m2_(num_params, max_batches) {
+    if (max_batches < 4 || max_batches % 2 != 0)
+      throw std::invalid_argument(
+          "online_batch_means: max_batches must be even and at least 4");
+  }
+
+  /**
+   * Add a draw.
+   *
+   * @tparam Draw type of Eigen vector or expression
+   * @param[in] draw values of the parameters, one per parameter
+   * @throw std::invalid_argument if the size of the draw does not match
+   *   the number of parameters
+   */
+  template <typename Draw>
+  void add(const Draw& draw) {
+    if (draw.size() != num_params())
+      throw std::invalid_argument(
+          "online_batch_means: draw size does not match number of "
+          "parameters");
+    ++current_count_;
+    for (Eigen::Index i = 0; i < num_params(); ++i) {
+      double delta = draw(i) - current_mean_(i);
+      current_mean_(i) += delta / current_count_;
+      current_m2_(i) += delta * (draw(i) - current_mean_(i));
+    }
+    if (current_count_ < batch_size_)
+      return;
+    means_.col(num_batches_) = current_mean_;
+    m2_.col(num_batches_) = current_m2_;
+    ++num_batches_;
+    current_count_ = 0;
+    current_mean_.setZero();
+    current_m2_.setZero();
+    if (num_batches_ == max_batches())
+      merge();
+  }
+
+  /**
+   * Discard all draws.
+   */
+  void clear() {
+    batch_size_ = 1;
+    num_batches_ = 0;
+    current_count_ = 0;
+    current_mean_.setZero();
+    current_m2_.setZero();
+  }
+
+  inline Eigen::Index num_params() const { return means_.rows(); }
+
+  inline Eigen::Index max_batches() const { return means_.cols(); }
+
+  /**
+   * Return the number of draws in each completed batch.
+   */
+  inline Eigen::Index batch_size() const { return batch_size_; }
+
+  /**
+   * Return the number of completed batches.
+   */
+  inline Eigen::Index num_batches() const { return num_batches_; }
+
+  /**
+   * Return the number of draws in the completed batches.
+   */
+  inline Eigen::Index num_batched_draws() const {
+    return batch_size_ * num_batches_;
+  }
+
+  /**
+   * Return the number of draws added.
+   */
+  inline Eigen::Index num_draws() const {
+    return num_batched_draws() + current_count_;
+  }
+
+  /**
+   * Return the means of the completed batches, one column per batch.
+   */
+  inline auto batch_means() const { return means_.leftCols(num_batches_); }
+
+  /**
+   * Return the sums of squared deviations from the batch mean of the
+   * completed batches, one column per batch.
+   */
+  inline auto batch_m2() const { return m2_.leftCols(num_batches_); }
+
+  /**
+   * Combine a range of completed batches into the mean and sum of
+   * squared deviations of all their draws.
+   *
+   * @param[in] param index of the parameter
+   * @param[in] first index of the first batch
+   * @param[in] count number of batches, at least one
+   * @param[out] mean mean of the draws
+   * @param[out] m2 sum of squared deviations of the draws from the mean
+   */
+  void combine(Eigen::Index param, Eigen::Index first, Eigen::Index count,
+               double& mean, double& m2) const {
+    mean = means_.row(param).segment(first, count).mean();
+    m2 = m2_.row(param).segment(first, count).sum()
+         + batch_size_
+               * (means_.row(param).segment(first, count).array() - mean)
+                     .square()
+                     .sum();
+  }
+
+ private:
+  /**
+   * Merge neighbouring pairs of completed batches, doubling the batch
+   * size.
+   */
+  void merge() {
+    const double half_size = batch_size_ / 2.0;
+    for (Eigen::Index j = 0; j < num_batches_ / 2; ++j) {
+      for (Eigen::Index i = 0; i < num_params(); ++i) {
+        double a = means_(i, 2 * j);
+        double b = means_(i, 2 * j + 1);
+        means_(i, j) = 0.5 * (a + b);
+        m2_(i, j) = m2_(i, 2 * j) + m2_(i, 2 * j + 1)
+                    + (a - b) * (a - b) * half_size;
+      }
+    }
+    num_batches_ /= 2;
+    batch_size_ *= 2;
+  }
+
+  Eigen::Index batch_size_;
+  Eigen::Index num_batches_;
+
+  /**
+   * Running mean and sum of squared deviations of the batch being
+   * filled
+   */
+  Eigen::Index current_count_;
+  Eigen::VectorXd current_mean_;
+  Eigen::VectorXd current_m2_;
+
+  /**
+   * Means and sums of squared deviations of the completed batches, one
+   * column per batch
+   */
+  Eigen::MatrixXd means_;
+  Eigen::MatrixXd m2_;
+};
+
+}  // namespace analyze
+}  // namespace stan
+#endif
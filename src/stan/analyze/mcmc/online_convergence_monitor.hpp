@@ -0,0 +1,197 @@
+#ifndef STAN_ANALYZE_MCMC_ONLINE_CONVERGENCE_MONITOR_HPP
+#define STAN_ANALYZE_MCMC_ONLINE_CONVERGENCE_MONITOR_HPP
+
+#include <stan/analyze/mcmc/online_batch_means.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Monitors the effective sample size and potential scale reduction of
+ * every parameter of several chains while they run, using memory that
+ * does not grow with the number of draws.
+ *
+ * Each chain keeps an `online_batch_means` accumulator.  The
+ * asymptotic variance of each chain's mean is estimated from the
+ * spread of its batch means, and the split potential scale reduction
+ * is computed from the first and second halves of its completed
+ * batches.  Only completed batches enter the estimates.  These are
+ * approximations of `compute_effective_sample_size` and
+ * `compute_split_potential_scale_reduction`, which need all draws and
+ * are rank normalized; they are intended for deciding when to stop a
+ * run, not for reporting.
+ *
+ * Draws of different chains may be added concurrently from different
+ * threads, and the estimates may be read while draws are added.
+ */
+class online_convergence_monitor {
+ public:
+  /**
+   * Construct a monitor with no draws.
+   *
+   * @param[in] num_chains number of chains
+   * @param[in] num_params number of parameters of each draw
+   * @param[in] max_batches maximum number of batches kept for each
+   *   chain, even and at least four
+   */
+  online_convergence_monitor(std::size_t num_chains, Eigen::Index num_params,
+                             Eigen::Index max_batches = 64)
+      : chains_(num_chains, online_batch_means(num_params, max_batches)),
+        mutexes_(new std::mutex[num_chains]) {}
+
+  inline std::size_t num_chains() const { return chains_.size(); }
+
+  inline Eigen::Index num_params() const {
+    return chains_.empty() ? 0 : chains_[0].num_params();
+  }
+
+  /**
+   * Add a draw to a chain.
+   *
+   * @tparam Draw type of Eigen vector or expression
+   * @param[in] chain index of the chain
+   * @param[in] draw values of the parameters
+   * @throw std::invalid_argument if the size of the draw does not match
+   *   the number of parameters
+   */
+  template <typename Draw>
+  void add(std::size_t chain, const Draw& draw) {
+    std::lock_guard<std::mutex> lock(mutexes_[chain]);
+    chains_[chain].add(draw);
+  }
+
+  /**
+   * Return the number of draws added to a chain.
+   */
+  Eigen::Index num_draws(std::size_t chain) const {
+    std::lock_guard<std::mutex> lock(mutexes_[chain]);
+    return chains_[chain].num_draws();
+  }
+
+  /**
+   * Return the estimated effective sample size of a parameter,
+   * bounded like `compute_effective_sample_size` by
+   * num_total_draws * log10(num_total_draws), where num_total_draws
+   * counts the draws in completed batches.  Returns NaN if a chain
+   * has fewer than four completed batches or the batch means do not
+   * vary.
+   *
+   * @param[in] param index of the parameter
+   */
+  double effective_sample_size(Eigen::Index param) const {
+    const std::size_t num_chains = chains_.size();
+    Eigen::VectorXd chain_mean(num_chains);
+    Eigen::VectorXd chain_var(num_chains);
+    Eigen::VectorXd asymptotic_var(num_chains);
+    double num_total_draws = 0;
+    double min_draws = std::numeric_limits<double>::infinity();
+    for (std::size_t c = 0; c < num_chains; ++c) {
+      std::lock_guard<std::mutex> lock(mutexes_[c]);
+      const online_batch_means& acc = chains_[c];
+      const Eigen::Index a = acc.num_batches();
+      if (a < 4)
+        return std::numeric_limits<double>::quiet_NaN();
+      const double n = acc.num_batched_draws();
+      double m2;
+      acc.combine(param, 0, a, chain_mean(c), m2);
+      chain_var(c) = m2 / (n - 1);
+      asymptotic_var(c)
+          = acc.batch_size()
+            * (acc.batch_means().row(param).array() - chain_mean(c))
+                  .square()
+                  .sum()
+            / (a - 1);
+      num_total_draws += n;
+      min_draws = std::min(min_draws, n);
+    }
+    if (num_chains == 0 || !(asymptotic_var.mean() > 0))
+      return std::numeric_limits<double>::quiet_NaN();
+
+    double var_plus = chain_var.mean() * (min_draws - 1) / min_draws;
+    if (num_chains > 1)
+      var_plus += (chain_mean.array() - chain_mean.mean()).square().sum()
+                  / (num_chains - 1);
+    return std::min(num_total_draws * var_plus / asymptotic_var.mean(),
+                    num_total_draws * std::log10(num_total_draws));
+  }
+
+  /**
+   * Return the split potential scale reduction of a parameter,
+   * treating the first and second halves of the completed batches of
+   * each chain as separate chains.  With an odd number of batches the
+   * middle one is left out.  Returns NaN if a chain has fewer than
+   * four completed batches.
+   *
+   * @param[in] param index of the parameter
+   */
+  double split_potential_scale_reduction(Eigen::Index param) const {
+    const std::size_t num_chains = chains_.size();
+    if (num_chains == 0)
+      return std::numeric_limits<double>::quiet_NaN();
+    Eigen::VectorXd half_mean(2 * num_chains);
+    Eigen::VectorXd half_var(2 * num_chains);
+    double num_draws = std::numeric_limits<double>::infinity();
+    for (std::size_t c = 0; c < num_chains; ++c) {
+      std::lock_guard<std::mutex> lock(mutexes_[c]);
+      const online_batch_means& acc = chains_[c];
+      const Eigen::Index a = acc.num_batches();
+      if (a < 4)
+        return std::numeric_limits<double>::quiet_NaN();
+      const Eigen::Index half = a / 2;
+      const double n = half * acc.batch_size();
+      double m2;
+      acc.combine(param, 0, half, half_mean(2 * c), m2);
+      half_var(2 * c) = m2 / (n - 1);
+      acc.combine(param, a - half, half, half_mean(2 * c + 1), m2);
+      half_var(2 * c + 1) = m2 / (n - 1);
+      num_draws = std::min(num_draws, n);
+    }
+    double within_variance = half_var.mean();
+    double between_variance
+        = num_draws * (half_mean.array() - half_mean.mean()).square().sum()
+          / (half_mean.size() - 1);
+    return std::sqrt((between_variance / within_variance + num_draws - 1)
+                     / num_draws);
+  }
+
+  /**
+   * Return the estimated effective sample size of every parameter.
+   */
+  Eigen::VectorXd effective_sample_size() const {
+    Eigen::VectorXd ess(num_params());
+    for (Eigen::Index i = 0; i < ess.size(); ++i)
+      ess(i) = effective_sample_size(i);
+    return ess;
+  }
+
+  /**
+   * Return the split potential scale reduction of every parameter.
+   */
+  Eigen::VectorXd split_potential_scale_reduction() const {
+    Eigen::VectorXd rhat(num_params());
+    for (Eigen::Index i = 0; i < rhat.size(); ++i)
+      rhat(i) = split_potential_scale_reduction(i);
+    return rhat;
+  }
+
+ private:
+  std::vector<online_batch_means> chains_;
+
+  /**
+   * One mutex per chain guarding its accumulator
+   */
+  std::unique_ptr<std::mutex[]> mutexes_;
+};
+
+}  // namespace analyze
+}  // namespace stan
+#endif
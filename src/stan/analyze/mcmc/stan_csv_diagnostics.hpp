@@ -0,0 +1,112 @@
+#ifndef STAN_ANALYZE_MCMC_STAN_CSV_DIAGNOSTICS_HPP
+#define STAN_ANALYZE_MCMC_STAN_CSV_DIAGNOSTICS_HPP
+
+#include <stan/analyze/mcmc/autocovariance.hpp>
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+
+/**
+ * Return the number of warmup draws at the top of the samples of a
+ * Stan csv file, which is zero unless the warmup was saved.
+ *
+ * @param metadata metadata of the csv file
+ * @return number of leading warmup draws
+ */
+inline size_t num_warmup_draws(const stan::io::stan_csv_metadata& metadata) {
+  if (!metadata.save_warmup)
+    return 0;
+  size_t thin = metadata.thin > 0 ? metadata.thin : 1;
+  return (metadata.num_warmup + thin - 1) / thin;
+}
+
+/**
+ * Diagnostics read in place from the samples of Stan csv files, one
+ * file per chain.  The samples are stored column-major, so the kept
+ * draws of a column are contiguous and are passed to the pointer based
+ * diagnostics without being copied into an mcmc::chains object.  The
+ * FFT and rank buffers are kept between calls.
+ *
+ * The csv files must outlive this object and must not be modified
+ * while it is used.  An object must not be used by more than one
+ * thread at a time.
+ */
+class stan_csv_diagnostics {
+ public:
+  /**
+   * @param chains parsed csv files, one per chain, with the same header
+   */
+  explicit stan_csv_diagnostics(const std::vector<stan::io::stan_csv>& chains)
+      : chains_(chains), draws_(chains.size()), sizes_(chains.size()) {}
+
+  /**
+   * Return the split effective sample size of the specified column
+   * over the post warmup draws.
+   *
+   * @param index column index
+   * @return split effective sample size
+   */
+  double split_effective_sample_size(int index) {
+    column_draws(index);
+    return compute_split_effective_sample_size(draws_, sizes_, acov_);
+  }
+
+  /**
+   * Return the split potential scale reduction of the specified column
+   * over the post warmup draws.
+   *
+   * @param index column index
+   * @return split potential scale reduction
+   */
+  double split_potential_scale_reduction(int index) {
+    column_draws(index);
+    return compute_split_potential_scale_reduction(draws_, sizes_);
+  }
+
+  /**
+   * Return the rank normalized split potential scale reductions of
+   * the bulk and the tail of the specified column over the post warmup
+   * draws.
+   *
+   * @param index column index
+   * @return pair of bulk and tail potential scale reductions
+   */
+  std::pair<double, double> split_potential_scale_reduction_rank(int index) {
+    column_draws(index);
+    return compute_split_potential_scale_reduction_rank(draws_, sizes_,
+                                                        ranks_);
+  }
+
+ private:
+  /**
+   * Point the draws at the post warmup rows of the column in every
+   * chain.
+   */
+  void column_draws(int index) {
+    for (size_t chain = 0; chain < chains_.size(); ++chain) {
+      const Eigen::MatrixXd& samples = chains_[chain].samples;
+      const Eigen::Index warmup = std::min<Eigen::Index>(
+          num_warmup_draws(chains_[chain].metadata), samples.rows());
+      draws_[chain] = samples.col(index).data() + warmup;
+      sizes_[chain] = samples.rows() - warmup;
+    }
+  }
+
+  const std::vector<stan::io::stan_csv>& chains_;
+  std::vector<const double*> draws_;
+  std::vector<size_t> sizes_;
+  autocovariance_workspace<double> acov_;
+  rank_workspace ranks_;
+};
+
+}  // namespace analyze
+}  // namespace stan
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef STAN_ANALYZE_REPRODUCIBLE_SUM_HPP
+#define STAN_ANALYZE_REPRODUCIBLE_SUM_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace stan {
+namespace analyze {
+namespace internal {
+
+/**
+ * Sum the specified values by halving their range down to pairs, so
+ * the order of the additions depends only on their number.
+ *
+ * @tparam T type of the values, `double` or an Eigen vector
+ * @param[in] values values to sum, at least one
+ * @param[in] begin index of the first value
+ * @param[in] end one past the index of the last value
+ * @return sum of the values
+ */
+template <typename T>
+inline T pairwise_sum(const std::vector<T>& values, std::size_t begin,
+                      std::size_t end) {
+  if (end - begin == 1)
+    return values[begin];
+  const std::size_t middle = begin + (end - begin) / 2;
+  T sum = pairwise_sum(values, begin, middle);
+  sum += pairwise_sum(values, middle, end);
+  return sum;
+}
+
+}  // namespace internal
+
+/**
+ * Return the sum of `f(0), ..., f(n - 1)`, computed in parallel with a
+ * result that does not depend on the number of threads or on how TBB
+ * schedules the work.
+ *
+ * The terms are split into chunks of `chunk_size` consecutive terms,
+ * each summed in order by one task, and the sums of the chunks are
+ * added in a fixed pairwise tree.  The order of every addition is
+ * then fixed by `n` and `chunk_size` alone, so the result is
+ * bitwise reproducible for any thread count, which a TBB
+ * `parallel_reduce` does not guarantee.  The pairwise tree also bounds
+ * the rounding error by the logarithm of the number of chunks instead
+ * of their number.  A single chunk is summed on the calling thread.
+ *
+ * @tparam F type of the functor, callable with a `std::size_t` and
+ * returning a value convertible to `double`
+ * @param[in] n number of terms
+ * @param[in] f functor returning the term at an index, called once per
+ * index and possibly concurrently
+ * @param[in] chunk_size number of terms summed in order by one task;
+ * the result depends on it, so reproducibility requires a fixed value
+ * @return sum of the terms, zero if there are none
+ */
+template <typename F>
+inline double reproducible_sum(std::size_t n, const F& f,
+                               std::size_t chunk_size = 1024) {
+  chunk_size = std::max<std::size_t>(chunk_size, 1);
+  const std::size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+  auto sum_chunk = [&](std::size_t c) {
+    const std::size_t end = std::min(n, (c + 1) * chunk_size);
+    double sum = 0;
+    for (std::size_t i = c * chunk_size; i < end; ++i)
+      sum += f(i);
+    return sum;
+  };
+  if (num_chunks == 0)
+    return 0;
+  if (num_chunks == 1)
+    return sum_chunk(0);
+  std::vector<double> chunk_sums(num_chunks);
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, num_chunks, 1),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        for (std::size_t c = r.begin(); c != r.end(); ++c)
+          chunk_sums[c] = sum_chunk(c);
+      },
+      tbb::simple_partitioner());
+  return internal::pairwise_sum(chunk_sums, 0, num_chunks);
+}
+
+/**
+ * Return the sum of the coefficients of the specified vector, computed
+ * as `reproducible_sum` does.
+ *
+ * @tparam EigVec type inheriting from `Eigen::DenseBase` with one
+ * compile time column
+ * @param[in] x vector to sum
+ * @param[in] chunk_size number of coefficients summed in order by one
+ * task
+ * @return sum of the coefficients
+ */
+template <typename EigVec>
+inline double reproducible_sum(const Eigen::DenseBase<EigVec>& x,
+                               std::size_t chunk_size = 1024) {
+  return reproducible_sum(
+      static_cast<std::size_t>(x.size()),
+      [&x](std::size_t i) { return x.derived().coeff(i); }, chunk_size);
+}
+
+/**
+ * Return the sum of the columns of the specified matrix, such as
+ * gradients evaluated in parallel, computed as `reproducible_sum`
+ * does with chunks of `chunk_size` consecutive columns.
+ *
+ * @param[in] x matrix whose columns are summed
+ * @param[in] chunk_size number of columns summed in order by one task
+ * @return sum of the columns
+ */
+inline Eigen::VectorXd reproducible_rowwise_sum(const Eigen::MatrixXd& x,
+                                                std::size_t chunk_size = 64) {
+  chunk_size = std::max<std::size_t>(chunk_size, 1);
+  const std::size_t n = x.cols();
+  const std::size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+  auto sum_chunk = [&](std::size_t c) {
+    const std::size_t end = std::min(n, (c + 1) * chunk_size);
+    Eigen::VectorXd sum = Eigen::VectorXd::Zero(x.rows());
+    for (std::size_t i = c * chunk_size; i < end; ++i)
+      sum += x.col(i);
+    return sum;
+  };
+  if (num_chunks == 0)
+    return Eigen::VectorXd::Zero(x.rows());
+  if (num_chunks == 1)
+    return sum_chunk(0);
+  std::vector<Eigen::VectorXd> chunk_sums(num_chunks);
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, num_chunks, 1),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        for (std::size_t c = r.begin(); c != r.end(); ++c)
+          chunk_sums[c] = sum_chunk(c);
+      },
+      tbb::simple_partitioner());
+  return internal::pairwise_sum(chunk_sums, 0, num_chunks);
+}
+
+}  // namespace analyze
+}  // namespace stan
+#endif
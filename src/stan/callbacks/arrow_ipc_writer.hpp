@@ -0,0 +1,280 @@
+#ifndef STAN_CALLBACKS_ARROW_IPC_WRITER_HPP
+#define STAN_CALLBACKS_ARROW_IPC_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/arrow_ipc_format.hpp>
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * `arrow_ipc_writer` is an implementation of `writer` that writes draws
+ * as an Apache Arrow IPC stream, described in
+ * `stan/io/arrow_ipc_format.hpp`, so that dataframe libraries read or
+ * memory-map them without parsing, for instance with
+ * `pyarrow.ipc.open_stream` or `arrow::read_ipc_stream`.
+ *
+ * The names become the schema, with one non-nullable 64-bit float
+ * column per name, and draws are buffered into record batches of
+ * `rows_per_batch` draws.  With a positive chain id, the schema starts
+ * with a 32-bit integer column `chain__` holding it, so that the
+ * streams of several chains concatenate into one table.  Messages
+ * written before the names are kept in the custom metadata of the
+ * schema under the key `stan_messages`, one per line; later messages
+ * are kept in the custom metadata of the next record batch, written
+ * without rows if no draw follows them.  The stream is ended when the
+ * writer is destroyed.
+ *
+ * @tparam Stream A type derived from `std::ostream`, which should be
+ * opened in binary mode
+ * @tparam Deleter A class with a valid `operator()` method for deleting the
+ * output stream
+ */
+template <typename Stream, typename Deleter = std::default_delete<Stream>>
+class arrow_ipc_writer final : public writer {
+ public:
+  /**
+   * Constructs an Arrow IPC writer.
+   *
+   * @param[in, out] output A unique pointer to a type inheriting from
+   * `std::ostream`
+   * @param[in] rows_per_batch number of draws buffered before a record
+   * batch is written, at least one
+   * @param[in] chain_id chain id written in the `chain__` column, or 0
+   * for no such column
+   */
+  explicit arrow_ipc_writer(std::unique_ptr<Stream, Deleter>&& output,
+                            std::size_t rows_per_batch = 1024,
+                            int chain_id = 0)
+      : output_(std::move(output)),
+        rows_per_batch_(std::max<std::size_t>(rows_per_batch, 1)),
+        chain_id_(chain_id),
+        num_cols_(0),
+        num_rows_(0),
+        has_header_(false) {}
+
+  arrow_ipc_writer(arrow_ipc_writer& other) = delete;
+  arrow_ipc_writer(arrow_ipc_writer&& other)
+      : output_(std::move(other.output_)),
+        rows_per_batch_(other.rows_per_batch_),
+        chain_id_(other.chain_id_),
+        num_cols_(other.num_cols_),
+        num_rows_(other.num_rows_),
+        has_header_(other.has_header_),
+        batch_(std::move(other.batch_)),
+        messages_(std::move(other.messages_)) {
+    other.num_rows_ = 0;
+  }
+
+  /**
+   * Destructor, writing any buffered draws and messages and ending the
+   * stream.
+   */
+  virtual ~arrow_ipc_writer() {
+    if (output_ == nullptr)
+      return;
+    try {
+      if (!has_header_)
+        write_schema({});
+      write_batch(true);
+      io::arrow_ipc::write_end_of_stream(*output_);
+      output_->flush();
+    } catch (...) {
+    }
+  }
+
+  /**
+   * Writes the schema naming the columns of the draws that follow.
+   *
+   * @param[in] names Names in a std::vector
+   * @throw std::invalid_argument if the names were already written
+   */
+  void operator()(const std::vector<std::string>& names) {
+    if (output_ == nullptr)
+      return;
+    if (has_header_)
+      throw std::invalid_argument(
+          "arrow_ipc_writer: column names written more than once");
+    write_schema(names);
+  }
+
+  /**
+   * Appends one draw.
+   *
+   * @param[in] values Values in a std::vector, one per column
+   * @throw std::invalid_argument if no header has been written or the
+   * number of values does not match it
+   */
+  void operator()(const std::vector<double>& values) {
+    if (output_ == nullptr)
+      return;
+    check_row_size(values.size());
+    for (std::size_t j = 0; j < num_cols_; ++j)
+      batch_[j * rows_per_batch_ + num_rows_] = values[j];
+    if (++num_rows_ == rows_per_batch_)
+      write_batch(false);
+  }
+
+  /**
+   * Appends several draws.
+   *
+   * @param[in] values A matrix of values. The input is expected to have
+   * parameters in the rows and samples in the columns.
+   * @throw std::invalid_argument if no header has been written or the
+   * number of rows does not match it
+   */
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    if (output_ == nullptr)
+      return;
+    check_row_size(values.rows());
+    for (Eigen::Index i = 0; i < values.cols(); ++i) {
+      for (std::size_t j = 0; j < num_cols_; ++j)
+        batch_[j * rows_per_batch_ + num_rows_] = values(j, i);
+      if (++num_rows_ == rows_per_batch_)
+        write_batch(false);
+    }
+  }
+
+  /**
+   * Writes an empty message.
+   */
+  void operator()() { (*this)(std::string()); }
+
+  /**
+   * Keeps a message for the custom metadata of the schema or of the
+   * next record batch.
+   *
+   * @param[in] message A string
+   */
+  void operator()(const std::string& message) {
+    if (output_ == nullptr)
+      return;
+    messages_.push_back(message);
+  }
+
+  /**
+   * Writes buffered draws and messages and flushes the stream.
+   */
+  void flush() {
+    if (output_ == nullptr)
+      return;
+    if (has_header_)
+      write_batch(true);
+    output_->flush();
+  }
+
+  /**
+   * Get the underlying stream
+   */
+  inline auto& get_stream() noexcept { return *output_; }
+
+ private:
+  void check_row_size(std::size_t n) const {
+    if (!has_header_)
+      throw std::invalid_argument(
+          "arrow_ipc_writer: draws written before column names");
+    if (n != num_cols_)
+      throw std::invalid_argument(
+          "arrow_ipc_writer: number of values does not match number of "
+          "columns");
+  }
+
+  /**
+   * Return the kept messages as custom metadata, clearing them.
+   */
+  std::vector<io::arrow_ipc::key_value> take_messages() {
+    std::vector<io::arrow_ipc::key_value> metadata;
+    if (messages_.empty())
+      return metadata;
+    std::string lines;
+    for (std::size_t i = 0; i < messages_.size(); ++i) {
+      if (i > 0)
+        lines += '\n';
+      lines += messages_[i];
+    }
+    messages_.clear();
+    metadata.emplace_back("stan_messages", std::move(lines));
+    return metadata;
+  }
+
+  void write_schema(const std::vector<std::string>& names) {
+    std::vector<io::arrow_ipc::column> columns;
+    if (chain_id_ > 0)
+      columns.push_back({"chain__", true});
+    for (const auto& name : names)
+      columns.push_back({name, false});
+    io::arrow_ipc::write_message(
+        *output_, io::arrow_ipc::schema_message(columns, take_messages()));
+    num_cols_ = names.size();
+    has_header_ = true;
+    batch_.assign(num_cols_ * rows_per_batch_, 0.0);
+  }
+
+  /**
+   * Writes the buffered draws as one record batch, and the kept
+   * messages in its custom metadata.
+   *
+   * @param[in] with_messages true to write a batch without draws if
+   * messages are kept
+   */
+  void write_batch(bool with_messages) {
+    if (num_rows_ == 0 && (!with_messages || messages_.empty()))
+      return;
+    std::vector<std::size_t> sizes;
+    if (chain_id_ > 0)
+      sizes.push_back(num_rows_ * sizeof(std::int32_t));
+    sizes.insert(sizes.end(), num_cols_, num_rows_ * sizeof(double));
+    io::arrow_ipc::write_message(
+        *output_, io::arrow_ipc::record_batch_message(num_rows_, sizes,
+                                                      take_messages()));
+    if (chain_id_ > 0) {
+      for (std::size_t i = 0; i < num_rows_; ++i)
+        io::binary_format::write_u32(*output_, chain_id_);
+      io::arrow_ipc::write_padding(*output_, sizes.front());
+    }
+    for (std::size_t j = 0; j < num_cols_; ++j)
+      io::binary_format::write_doubles(
+          *output_, batch_.data() + j * rows_per_batch_, num_rows_);
+    num_rows_ = 0;
+  }
+
+  /**
+   * Output stream
+   */
+  std::unique_ptr<Stream, Deleter> output_;
+
+  std::size_t rows_per_batch_;
+  int chain_id_;
+  std::size_t num_cols_;
+
+  /**
+   * Number of draws buffered in the current record batch
+   */
+  std::size_t num_rows_;
+  bool has_header_;
+
+  /**
+   * Current record batch, stored column by column with room for
+   * rows_per_batch_ draws per column
+   */
+  std::vector<double> batch_;
+
+  /**
+   * Messages not yet written
+   */
+  std::vector<std::string> messages_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+
+#endif
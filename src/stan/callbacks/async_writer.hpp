@@ -0,0 +1,253 @@
+#ifndef STAN_CALLBACKS_ASYNC_WRITER_HPP
+#define STAN_CALLBACKS_ASYNC_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>async_writer</code> is an implementation of <code>writer</code>
+ * that forwards every call to another writer on a background thread.
+ *
+ * Calls are handed over through a bounded single-producer,
+ * single-consumer ring of preallocated slots.  The calling thread only
+ * copies its arguments into the next free slot, reusing the slot's
+ * storage, so formatting and I/O done by the wrapped writer no longer
+ * block it.  When the ring is full the caller waits for the
+ * background thread to catch up.  Calls reach the wrapped writer in
+ * the order they were made.
+ *
+ * Only one thread may write to an <code>async_writer</code> at a
+ * time.  An exception thrown by the wrapped writer is rethrown by the
+ * next call to this writer or to <code>flush()</code>.  The destructor
+ * drains all pending calls before returning.
+ */
+class async_writer final : public writer {
+ public:
+  /**
+   * Construct a writer forwarding to the specified writer through a
+   * ring with the specified number of slots.
+   *
+   * @param[in, out] sink writer receiving the calls; must outlive this
+   *   writer
+   * @param[in] capacity number of calls that may be pending at once,
+   *   at least one
+   */
+  explicit async_writer(writer& sink, std::size_t capacity = 64)
+      : sink_(sink),
+        slots_(capacity > 0 ? capacity : 1),
+        head_(0),
+        tail_(0),
+        closed_(false),
+        failed_(false),
+        worker_(&async_writer::run, this) {}
+
+  /**
+   * Destructor.  Waits until every pending call has been forwarded.
+   */
+  ~async_writer() {
+    closed_.store(true, std::memory_order_release);
+    worker_.join();
+  }
+
+  async_writer(const async_writer&) = delete;
+  async_writer& operator=(const async_writer&) = delete;
+
+  void operator()(const std::vector<std::string>& names) {
+    slot& s = acquire();
+    s.type = kind::names;
+    s.names = names;
+    publish();
+  }
+
+  void operator()(const std::vector<double>& state) {
+    slot& s = acquire();
+    s.type = kind::values;
+    s.values.assign(state.begin(), state.end());
+    publish();
+  }
+
+  void operator()() {
+    slot& s = acquire();
+    s.type = kind::blank;
+    publish();
+  }
+
+  void operator()(const std::string& message) {
+    slot& s = acquire();
+    s.type = kind::message;
+    s.message = message;
+    publish();
+  }
+
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    slot& s = acquire();
+    s.type = kind::matrix;
+    s.matrix = values;
+    publish();
+  }
+
+  /**
+   * Wait until every call made so far has been forwarded to the
+   * wrapped writer.
+   */
+  void flush() {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    int spins = 0;
+    while (tail_.load(std::memory_order_acquire) != head && !failed()) {
+      backoff(spins);
+    }
+    rethrow_if_failed();
+  }
+
+ private:
+  enum class kind { names, values, blank, message, matrix };
+
+  /**
+   * One pending call.  Its buffers keep their capacity between uses
+   * so that steady-state writes do not allocate.
+   */
+  struct slot {
+    kind type{kind::blank};
+    std::vector<std::string> names;
+    std::vector<double> values;
+    std::string message;
+    Eigen::MatrixXd matrix;
+  };
+
+  /**
+   * Wait for a free slot and return it.
+   */
+  slot& acquire() {
+    rethrow_if_failed();
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    int spins = 0;
+    while (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+      backoff(spins);
+      rethrow_if_failed();
+    }
+    return slots_[head % slots_.size()];
+  }
+
+  /**
+   * Hand the slot returned by the last call to acquire() to the
+   * background thread.
+   */
+  void publish() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  /**
+   * Body of the background thread: forward pending calls until the
+   * writer is closed and the ring is empty.
+   */
+  void run() {
+    int spins = 0;
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      if (tail == head_.load(std::memory_order_acquire)) {
+        if (closed_.load(std::memory_order_acquire)
+            && tail == head_.load(std::memory_order_acquire))
+          return;
+        backoff(spins);
+        continue;
+      }
+      spins = 0;
+      if (!failed()) {
+        try {
+          forward(slots_[tail % slots_.size()]);
+        } catch (...) {
+          error_ = std::current_exception();
+          failed_.store(true, std::memory_order_release);
+        }
+      }
+      tail_.store(++tail, std::memory_order_release);
+    }
+  }
+
+  void forward(slot& s) {
+    switch (s.type) {
+      case kind::names:
+        sink_(s.names);
+        break;
+      case kind::values:
+        sink_(s.values);
+        break;
+      case kind::blank:
+        sink_();
+        break;
+      case kind::message:
+        sink_(s.message);
+        break;
+      case kind::matrix:
+        sink_(Eigen::Ref<Eigen::Matrix<double, -1, -1>>(s.matrix));
+        break;
+    }
+  }
+
+  inline bool failed() const {
+    return failed_.load(std::memory_order_acquire);
+  }
+
+  void rethrow_if_failed() {
+    if (failed())
+      std::rethrow_exception(error_);
+  }
+
+  /**
+   * Wait politely: yield for a while, then sleep briefly.
+   *
+   * @param[in, out] spins number of times waited so far
+   */
+  static void backoff(int& spins) {
+    if (spins < 64) {
+      ++spins;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  /**
+   * The writer receiving the calls.
+   */
+  writer& sink_;
+
+  /**
+   * Ring of pending calls.
+   */
+  std::vector<slot> slots_;
+
+  /**
+   * Number of calls published by the writing thread.
+   */
+  std::atomic<std::size_t> head_;
+
+  /**
+   * Number of calls forwarded by the background thread.
+   */
+  std::atomic<std::size_t> tail_;
+
+  std::atomic<bool> closed_;
+  std::atomic<bool> failed_;
+  std::exception_ptr error_;
+
+  /**
+   * Background thread, started last so that every other member is
+   * initialized before it runs.
+   */
+  std::thread worker_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,222 @@
+#ifndef STAN_CALLBACKS_BINARY_WRITER_HPP
+#define STAN_CALLBACKS_BINARY_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * `binary_writer` is an implementation of `writer` that stores draws
+ * in the binary columnar format described in
+ * `stan/io/stan_binary_format.hpp` instead of as text.
+ *
+ * Draws are buffered into row groups and each full group is written
+ * as one block of doubles per column, which `io::stan_binary_reader`
+ * copies straight into the sample matrix.  Names are written as the
+ * header; strings and blank lines are kept as message chunks in their
+ * original order.  Opening an existing file for appending and writing
+ * the same names again continues it.
+ *
+ * @tparam Stream A type derived from `std::ostream`, which should be
+ * opened in binary mode
+ * @tparam Deleter A class with a valid `operator()` method for deleting the
+ * output stream
+ */
+template <typename Stream, typename Deleter = std::default_delete<Stream>>
+class binary_writer final : public writer {
+ public:
+  /**
+   * Constructs a binary writer.
+   *
+   * @param[in, out] output A unique pointer to a type inheriting from
+   * `std::ostream`
+   * @param[in] rows_per_group number of draws buffered before a row
+   * group is written, at least one
+   */
+  explicit binary_writer(std::unique_ptr<Stream, Deleter>&& output,
+                         std::size_t rows_per_group = 256)
+      : output_(std::move(output)),
+        rows_per_group_(std::max<std::size_t>(rows_per_group, 1)),
+        num_cols_(0),
+        num_rows_(0),
+        has_header_(false) {}
+
+  binary_writer(binary_writer& other) = delete;
+  binary_writer(binary_writer&& other)
+      : output_(std::move(other.output_)),
+        rows_per_group_(other.rows_per_group_),
+        num_cols_(other.num_cols_),
+        num_rows_(other.num_rows_),
+        has_header_(other.has_header_),
+        group_(std::move(other.group_)) {
+    other.num_rows_ = 0;
+  }
+
+  /**
+   * Destructor, writing any buffered draws.
+   */
+  virtual ~binary_writer() {
+    try {
+      write_group();
+    } catch (...) {
+    }
+  }
+
+  /**
+   * Writes the header naming the columns of the draws that follow.
+   *
+   * @param[in] names Names in a std::vector
+   */
+  void operator()(const std::vector<std::string>& names) {
+    if (output_ == nullptr)
+      return;
+    write_group();
+    std::uint64_t payload = 4;
+    for (const auto& name : names)
+      payload += 4 + name.size();
+    io::binary_format::write_chunk_start(
+        *output_, io::binary_format::header_tag, payload);
+    io::binary_format::write_u32(*output_, names.size());
+    for (const auto& name : names) {
+      io::binary_format::write_u32(*output_, name.size());
+      output_->write(name.data(), name.size());
+    }
+    num_cols_ = names.size();
+    has_header_ = true;
+    group_.assign(num_cols_ * rows_per_group_, 0.0);
+  }
+
+  /**
+   * Appends one draw.
+   *
+   * @param[in] values Values in a std::vector, one per column
+   * @throw std::invalid_argument if no header has been written or the
+   * number of values does not match it
+   */
+  void operator()(const std::vector<double>& values) {
+    if (output_ == nullptr)
+      return;
+    check_row_size(values.size());
+    for (std::size_t j = 0; j < num_cols_; ++j)
+      group_[j * rows_per_group_ + num_rows_] = values[j];
+    if (++num_rows_ == rows_per_group_)
+      write_group();
+  }
+
+  /**
+   * Appends several draws.
+   *
+   * @param[in] values A matrix of values. The input is expected to have
+   * parameters in the rows and samples in the columns.
+   * @throw std::invalid_argument if no header has been written or the
+   * number of rows does not match it
+   */
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    if (output_ == nullptr)
+      return;
+    check_row_size(values.rows());
+    for (Eigen::Index i = 0; i < values.cols(); ++i) {
+      for (std::size_t j = 0; j < num_cols_; ++j)
+        group_[j * rows_per_group_ + num_rows_] = values(j, i);
+      if (++num_rows_ == rows_per_group_)
+        write_group();
+    }
+  }
+
+  /**
+   * Writes an empty message.
+   */
+  void operator()() { (*this)(std::string()); }
+
+  /**
+   * Writes a message.  Buffered draws are written first so that the
+   * order of draws and messages is kept.
+   *
+   * @param[in] message A string
+   */
+  void operator()(const std::string& message) {
+    if (output_ == nullptr)
+      return;
+    write_group();
+    io::binary_format::write_chunk_start(
+        *output_, io::binary_format::message_tag, message.size());
+    output_->write(message.data(), message.size());
+  }
+
+  /**
+   * Writes buffered draws and flushes the stream.
+   */
+  void flush() {
+    if (output_ == nullptr)
+      return;
+    write_group();
+    output_->flush();
+  }
+
+  /**
+   * Get the underlying stream
+   */
+  inline auto& get_stream() noexcept { return *output_; }
+
+ private:
+  void check_row_size(std::size_t n) const {
+    if (!has_header_)
+      throw std::invalid_argument(
+          "binary_writer: draws written before column names");
+    if (n != num_cols_)
+      throw std::invalid_argument(
+          "binary_writer: number of values does not match number of "
+          "columns");
+  }
+
+  /**
+   * Writes the buffered draws as one row group.
+   */
+  void write_group() {
+    if (output_ == nullptr || num_rows_ == 0)
+      return;
+    std::uint64_t payload = 4 + num_cols_ * num_rows_ * sizeof(double);
+    io::binary_format::write_chunk_start(*output_, io::binary_format::rows_tag,
+                                         payload);
+    io::binary_format::write_u32(*output_, num_rows_);
+    for (std::size_t j = 0; j < num_cols_; ++j)
+      io::binary_format::write_doubles(
+          *output_, group_.data() + j * rows_per_group_, num_rows_);
+    num_rows_ = 0;
+  }
+
+  /**
+   * Output stream
+   */
+  std::unique_ptr<Stream, Deleter> output_;
+
+  std::size_t rows_per_group_;
+  std::size_t num_cols_;
+
+  /**
+   * Number of draws buffered in the current row group
+   */
+  std::size_t num_rows_;
+  bool has_header_;
+
+  /**
+   * Current row group, stored column by column with room for
+   * rows_per_group_ draws per column
+   */
+  std::vector<double> group_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+
+#endif
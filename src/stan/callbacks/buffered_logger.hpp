@@ -0,0 +1,107 @@
+#ifndef STAN_CALLBACKS_BUFFERED_LOGGER_HPP
+#define STAN_CALLBACKS_BUFFERED_LOGGER_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>buffered_logger</code> is an implementation of
+ * <code>logger</code> that keeps the messages it receives in memory
+ * until they are replayed to another logger.
+ *
+ * <p>This lets work run on another thread log its messages, which are
+ * then written by the calling thread in a deterministic order.
+ */
+class buffered_logger final : public logger {
+ public:
+  /**
+   * Level of a buffered message.
+   */
+  enum class level { debug, info, warn, error, fatal };
+
+ private:
+  std::vector<std::pair<level, std::string>> messages_;
+
+ public:
+  void debug(const std::string& message) {
+    messages_.emplace_back(level::debug, message);
+  }
+
+  void debug(const std::stringstream& message) { debug(message.str()); }
+
+  void info(const std::string& message) {
+    messages_.emplace_back(level::info, message);
+  }
+
+  void info(const std::stringstream& message) { info(message.str()); }
+
+  void warn(const std::string& message) {
+    messages_.emplace_back(level::warn, message);
+  }
+
+  void warn(const std::stringstream& message) { warn(message.str()); }
+
+  void error(const std::string& message) {
+    messages_.emplace_back(level::error, message);
+  }
+
+  void error(const std::stringstream& message) { error(message.str()); }
+
+  void fatal(const std::string& message) {
+    messages_.emplace_back(level::fatal, message);
+  }
+
+  void fatal(const std::stringstream& message) { fatal(message.str()); }
+
+  /**
+   * Return the buffered messages with their levels, in the order they
+   * were received.
+   */
+  const std::vector<std::pair<level, std::string>>& messages() const {
+    return messages_;
+  }
+
+  /**
+   * Send the buffered messages to the specified logger in the order
+   * they were received, then clear the buffer.
+   *
+   * @param[in,out] logger logger to which messages are sent
+   */
+  void replay(logger& logger) {
+    for (const auto& message : messages_) {
+      switch (message.first) {
+        case level::debug:
+          logger.debug(message.second);
+          break;
+        case level::info:
+          logger.info(message.second);
+          break;
+        case level::warn:
+          logger.warn(message.second);
+          break;
+        case level::error:
+          logger.error(message.second);
+          break;
+        case level::fatal:
+          logger.fatal(message.second);
+          break;
+      }
+    }
+    clear();
+  }
+
+  /**
+   * Discard the buffered messages.
+   */
+  void clear() { messages_.clear(); }
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,49 @@
+#ifndef STAN_CALLBACKS_CANCELLABLE_INTERRUPT_HPP
+#define STAN_CALLBACKS_CANCELLABLE_INTERRUPT_HPP
+
+#include <stan/callbacks/cancellation_token.hpp>
+#include <stan/callbacks/interrupt.hpp>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>cancellable_interrupt</code> forwards calls to another
+ * interrupt and ties it to a cancellation token shared with other
+ * workers.  A call throws <code>cancelled_error</code> once the token is
+ * cancelled, and an exception thrown by the wrapped interrupt, such as
+ * the one an interface throws on ctrl-c, cancels the token before it
+ * propagates, so every worker polling the token stops at its next
+ * iteration.
+ *
+ * The wrapped interrupt is called from the threads of all the workers
+ * sharing this object, as it would be without the wrapper.
+ */
+class cancellable_interrupt final : public interrupt {
+ public:
+  /**
+   * @param[in,out] wrapped interrupt to forward to
+   * @param[in,out] token cancellation token shared by the workers
+   */
+  cancellable_interrupt(interrupt& wrapped, cancellation_token& token)
+      : wrapped_(wrapped), token_(token) {}
+
+  void operator()() {
+    if (token_.cancelled())
+      throw cancelled_error();
+    try {
+      wrapped_();
+    } catch (...) {
+      token_.cancel();
+      throw;
+    }
+  }
+
+ private:
+  interrupt& wrapped_;
+  cancellation_token& token_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
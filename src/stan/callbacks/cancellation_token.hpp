@@ -0,0 +1,66 @@
+#ifndef STAN_CALLBACKS_CANCELLATION_TOKEN_HPP
+#define STAN_CALLBACKS_CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <stdexcept>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>cancellation_token</code> is a flag shared by the workers of
+ * one or more parallel runs, such as the chains of a multi-chain
+ * sampler, so that a fatal error or an interrupt in one worker stops
+ * all of them.  Setting and polling it are single relaxed atomic
+ * operations, cheap enough to poll every iteration.
+ */
+class cancellation_token {
+ public:
+  /**
+   * Request that every worker polling this token stops.
+   */
+  void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+
+  /**
+   * Return true if cancellation has been requested.
+   */
+  bool cancelled() const noexcept {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Request that every worker polling this token stops because the
+   * work is done, such as a sampling target having been reached,
+   * rather than because of an error.  Workers stop as after
+   * <code>cancel</code>, and the caller checks <code>finished</code>
+   * once they have joined to tell the two apart.
+   */
+  void finish() noexcept {
+    finished_.store(true, std::memory_order_relaxed);
+    cancel();
+  }
+
+  /**
+   * Return true if the workers were stopped by <code>finish</code>.
+   */
+  bool finished() const noexcept {
+    return finished_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<bool> cancelled_{false};
+  std::atomic<bool> finished_{false};
+};
+
+/**
+ * Exception thrown by a worker that stops because its cancellation
+ * token was cancelled by another worker.
+ */
+class cancelled_error : public std::runtime_error {
+ public:
+  cancelled_error() : std::runtime_error("Cancelled by another worker.") {}
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,232 @@
+#ifndef STAN_CALLBACKS_COLUMN_MAJOR_WRITER_HPP
+#define STAN_CALLBACKS_COLUMN_MAJOR_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>column_major_writer</code> is an implementation of
+ * <code>writer</code> storing the rows of values in memory, in a
+ * column-major buffer with one column per name of the header, for
+ * applications embedding Stan which hand the draws to a matrix of
+ * their own, such as a NumPy or R array, without copying them row by
+ * row.
+ *
+ * <p>The buffer is either provided by the caller, with room for a
+ * fixed number of rows, or allocated by the writer for the number of
+ * rows expected once the header gives the number of columns, and grown
+ * in place if more rows are written.  Value <code>j</code> of row
+ * <code>i</code> is stored at <code>data()[j * capacity() + i]</code>;
+ * <code>release()</code> packs the rows written so that the leading
+ * dimension becomes <code>num_rows()</code>.
+ *
+ * <p>Rows written past the end of a buffer provided by the caller are
+ * counted by <code>num_dropped()</code> and otherwise ignored.  Rows
+ * given as segments are written in place without being concatenated.
+ * Messages are kept as they are written.
+ */
+class column_major_writer final : public writer {
+ public:
+  /**
+   * Construct a writer allocating a buffer for the specified number of
+   * rows when the header is written.
+   *
+   * @param[in] num_rows expected number of rows, such as the number of
+   * draws
+   */
+  explicit column_major_writer(std::size_t num_rows)
+      : data_(nullptr), capacity_(num_rows), owned_(true) {}
+
+  /**
+   * Construct a writer storing the values in the specified buffer,
+   * which must outlive the writer and have room for the specified
+   * number of rows and columns.
+   *
+   * @param[in, out] data buffer of <code>num_rows * num_cols</code>
+   * values
+   * @param[in] num_rows number of rows of the buffer
+   * @param[in] num_cols number of columns of the buffer, which must be
+   * the number of names of the header
+   */
+  column_major_writer(double* data, std::size_t num_rows,
+                      std::size_t num_cols)
+      : data_(data), capacity_(num_rows), num_cols_(num_cols), owned_(false) {}
+
+  virtual ~column_major_writer() {}
+
+  /**
+   * Take the names of the header, which set the number of columns.
+   *
+   * @param[in] names names of the columns
+   * @throw std::invalid_argument if the number of names does not match
+   * the columns of a buffer provided by the caller or of rows already
+   * written
+   */
+  void operator()(const std::vector<std::string>& names) {
+    if ((!owned_ || num_rows_ > 0) && names.size() != num_cols_)
+      throw std::invalid_argument(
+          "column_major_writer: the header has " + std::to_string(names.size())
+          + " names but the buffer has " + std::to_string(num_cols_)
+          + " columns");
+    names_ = names;
+    if (owned_ && num_rows_ == 0) {
+      num_cols_ = names.size();
+      storage_.assign(capacity_ * num_cols_, 0);
+      data_ = storage_.data();
+    }
+  }
+
+  void operator()(const std::vector<double>& state) {
+    (*this)({value_span(state)});
+  }
+
+  void operator()(row_segments segments) {
+    std::size_t size = 0;
+    for (const value_span& segment : segments)
+      size += segment.size();
+    if (size != num_cols_)
+      throw std::invalid_argument(
+          "column_major_writer: a row has " + std::to_string(size)
+          + " values but the header has " + std::to_string(num_cols_)
+          + " names");
+    if (num_rows_ == capacity_ && !reserve_row())
+      return;
+    double* column = data_ + num_rows_;
+    for (const value_span& segment : segments)
+      for (double x : segment) {
+        *column = x;
+        column += capacity_;
+      }
+    ++num_rows_;
+  }
+
+  /**
+   * Write the columns of the specified matrix as rows.
+   *
+   * @param[in] values values with one column per row written
+   */
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    for (Eigen::Index n = 0; n < values.cols(); ++n)
+      (*this)({value_span(values.col(n).data(), values.rows())});
+  }
+
+  void operator()(const std::string& message) { messages_.push_back(message); }
+
+  /**
+   * Return the names of the header.
+   */
+  const std::vector<std::string>& names() const { return names_; }
+
+  /**
+   * Return the messages written, in order.
+   */
+  const std::vector<std::string>& messages() const { return messages_; }
+
+  /**
+   * Return the buffer of values, null before the header of a writer
+   * allocating its buffer.
+   */
+  const double* data() const { return data_; }
+
+  /**
+   * Return the number of rows written.
+   */
+  std::size_t num_rows() const { return num_rows_; }
+
+  /**
+   * Return the number of columns.
+   */
+  std::size_t num_cols() const { return num_cols_; }
+
+  /**
+   * Return the number of rows the buffer has room for, its leading
+   * dimension.
+   */
+  std::size_t capacity() const { return capacity_; }
+
+  /**
+   * Return the number of rows which did not fit the buffer provided by
+   * the caller.
+   */
+  std::size_t num_dropped() const { return num_dropped_; }
+
+  /**
+   * Return a map of the rows written, with the leading dimension of the
+   * buffer as its outer stride.
+   */
+  Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<>> values() const {
+    return Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<>>(
+        data_, num_rows_, num_cols_,
+        Eigen::OuterStride<>(std::max<std::size_t>(capacity_, 1)));
+  }
+
+  /**
+   * Pack the columns of the rows written to the start of the buffer, so
+   * that the leading dimension becomes <code>num_rows()</code>, and
+   * return the buffer allocated by the writer, which is left empty.  The
+   * columns are moved within the buffer, which is not reallocated.
+   *
+   * @return values of the rows written, column-major
+   * @throw std::logic_error if the buffer was provided by the caller
+   */
+  std::vector<double> release() {
+    if (!owned_)
+      throw std::logic_error(
+          "column_major_writer: the buffer belongs to the caller");
+    for (std::size_t j = 1; j < num_cols_; ++j)
+      std::memmove(data_ + j * num_rows_, data_ + j * capacity_,
+                   num_rows_ * sizeof(double));
+    storage_.resize(num_rows_ * num_cols_);
+    std::vector<double> released;
+    released.swap(storage_);
+    data_ = nullptr;
+    capacity_ = 0;
+    num_rows_ = 0;
+    return released;
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<std::string> messages_;
+  std::vector<double> storage_;
+  double* data_;
+  std::size_t capacity_;
+  std::size_t num_cols_{0};
+  std::size_t num_rows_{0};
+  std::size_t num_dropped_{0};
+  bool owned_;
+
+  /**
+   * Make room for another row, doubling the rows of a buffer allocated
+   * by the writer and moving its columns apart in place.
+   *
+   * @return <code>false</code> if the row does not fit the buffer of
+   * the caller
+   */
+  bool reserve_row() {
+    if (!owned_) {
+      ++num_dropped_;
+      return false;
+    }
+    std::size_t capacity = std::max<std::size_t>(2 * capacity_, 16);
+    storage_.resize(capacity * num_cols_);
+    data_ = storage_.data();
+    for (std::size_t j = num_cols_; j-- > 1;)
+      std::memmove(data_ + j * capacity, data_ + j * capacity_,
+                   num_rows_ * sizeof(double));
+    capacity_ = capacity;
+    return true;
+  }
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
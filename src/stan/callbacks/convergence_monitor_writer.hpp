@@ -0,0 +1,91 @@
+#ifndef STAN_CALLBACKS_CONVERGENCE_MONITOR_WRITER_HPP
+#define STAN_CALLBACKS_CONVERGENCE_MONITOR_WRITER_HPP
+
+#include <stan/analyze/mcmc/online_convergence_monitor.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>convergence_monitor_writer</code> is an implementation of
+ * <code>writer</code> that feeds every draw of one chain to an
+ * <code>analyze::online_convergence_monitor</code>, so that the
+ * effective sample size and potential scale reduction can be checked
+ * while sampling runs.  Strings and blank lines are ignored.
+ *
+ * Use one writer per chain, for example combined with the sample
+ * writer of each chain through a <code>tee_writer</code>.
+ */
+class convergence_monitor_writer final : public writer {
+ public:
+  /**
+   * Construct a writer adding draws to the specified chain.
+   *
+   * @param[in, out] monitor monitor receiving the draws; must outlive
+   *   this writer
+   * @param[in] chain index of the chain in the monitor
+   */
+  convergence_monitor_writer(analyze::online_convergence_monitor& monitor,
+                             std::size_t chain)
+      : monitor_(monitor), chain_(chain) {}
+
+  /**
+   * Checks that the names match the number of monitored parameters.
+   *
+   * @param[in] names Names in a std::vector
+   * @throw std::invalid_argument if the number of names differs from
+   *   the number of parameters of the monitor
+   */
+  void operator()(const std::vector<std::string>& names) {
+    if (static_cast<Eigen::Index>(names.size()) != monitor_.num_params())
+      throw std::invalid_argument(
+          "convergence_monitor_writer: number of names does not match "
+          "number of monitored parameters");
+  }
+
+  /**
+   * Adds a draw.
+   *
+   * @param[in] state Values in a std::vector
+   */
+  void operator()(const std::vector<double>& state) {
+    monitor_.add(chain_, Eigen::Map<const Eigen::VectorXd>(state.data(),
+                                                           state.size()));
+  }
+
+  /**
+   * Ignores blank input.
+   */
+  void operator()() {}
+
+  /**
+   * Ignores a string.
+   *
+   * @param[in] message A string
+   */
+  void operator()(const std::string& message) {}
+
+  /**
+   * Adds several draws, one per column.
+   *
+   * @param[in] values A matrix of values. The input is expected to have
+   * parameters in the rows and samples in the columns.
+   */
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    for (Eigen::Index j = 0; j < values.cols(); ++j)
+      monitor_.add(chain_, values.col(j));
+  }
+
+ private:
+  analyze::online_convergence_monitor& monitor_;
+  std::size_t chain_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,331 @@
+#ifndef STAN_CALLBACKS_GZIP_WRITER_HPP
+#define STAN_CALLBACKS_GZIP_WRITER_HPP
+
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/callbacks/unique_stream_writer.hpp>
+#include <zlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>gzip_streambuf</code> is a stream buffer which compresses the
+ * characters written to it with gzip on a background thread and
+ * writes them to another stream.
+ *
+ * The characters are gathered into chunks of a fixed size, each of
+ * which is compressed into a complete gzip member once it is full.
+ * Concatenated members form a valid gzip file which
+ * <code>gzip -d</code>, <code>zcat</code> and
+ * <code>stan::io::gzip_istream</code> decompress as a whole, in a
+ * streaming way.  The writing thread only copies characters into the
+ * current chunk and hands full chunks over to the background thread,
+ * waiting only when a number of chunks are already pending.
+ *
+ * <p>Because the writers flush their stream after each row, flushing
+ * does not compress a partial chunk; the last chunk is compressed by
+ * <code>close()</code> or the destructor.  If compressing or writing
+ * fails, later output fails and <code>close()</code> rethrows the
+ * error.
+ */
+class gzip_streambuf : public std::streambuf {
+ public:
+  /**
+   * Construct a stream buffer writing compressed output to the
+   * specified stream.
+   *
+   * @param[in, out] sink stream receiving the compressed output; must
+   *   outlive this buffer
+   * @param[in] level zlib compression level, from 1 (fastest) to 9
+   *   (smallest), or <code>Z_DEFAULT_COMPRESSION</code>
+   * @param[in] chunk_size number of characters compressed into each
+   *   gzip member
+   * @param[in] max_pending number of full chunks which may wait for the
+   *   background thread
+   * @throw std::invalid_argument if the level is not valid
+   */
+  explicit gzip_streambuf(std::ostream& sink,
+                          int level = Z_DEFAULT_COMPRESSION,
+                          std::size_t chunk_size = 1 << 20,
+                          std::size_t max_pending = 4)
+      : sink_(sink),
+        chunk_size_(chunk_size > 0 ? chunk_size : 1),
+        max_pending_(max_pending > 0 ? max_pending : 1),
+        closed_(false) {
+    zstream_.zalloc = Z_NULL;
+    zstream_.zfree = Z_NULL;
+    zstream_.opaque = Z_NULL;
+    // 15 + 16 selects the largest window with a gzip header and trailer
+    if (deflateInit2(&zstream_, level, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY)
+        != Z_OK)
+      throw std::invalid_argument("gzip_streambuf: invalid compression level");
+    start_chunk();
+    worker_ = std::thread(&gzip_streambuf::run, this);
+  }
+
+  /**
+   * Destructor.  Compresses and writes any remaining output.
+   */
+  ~gzip_streambuf() {
+    try {
+      close();
+    } catch (...) {
+    }
+    deflateEnd(&zstream_);
+  }
+
+  gzip_streambuf(const gzip_streambuf&) = delete;
+  gzip_streambuf& operator=(const gzip_streambuf&) = delete;
+
+  /**
+   * Compress the last chunk, wait until all output is written to the
+   * sink and stop the background thread.  Later output fails.
+   *
+   * @throw std::exception the first error raised while compressing or
+   *   writing
+   */
+  void close() {
+    if (worker_.joinable()) {
+      hand_over();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+      }
+      ready_.notify_one();
+      worker_.join();
+      sink_.flush();
+      setp(nullptr, nullptr);
+    }
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+ protected:
+  int_type overflow(int_type c) {
+    if (!worker_.joinable() || !hand_over())
+      return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) {
+    std::streamsize written = 0;
+    while (written < n) {
+      if (pptr() == epptr()
+          && overflow(traits_type::eof()) == traits_type::eof())
+        return written;
+      std::streamsize space = epptr() - pptr();
+      std::streamsize count = std::min(space, n - written);
+      traits_type::copy(pptr(), s + written, count);
+      pbump(static_cast<int>(count));
+      written += count;
+    }
+    return written;
+  }
+
+  int sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_ ? -1 : 0;
+  }
+
+ private:
+  /**
+   * Make a fresh chunk the put area.
+   */
+  void start_chunk() {
+    chunk_.resize(chunk_size_);
+    setp(&chunk_[0], &chunk_[0] + chunk_.size());
+  }
+
+  /**
+   * Hand the current chunk to the background thread, waiting while
+   * too many chunks are pending, and start a new one.
+   *
+   * @return false if the background thread has failed
+   */
+  bool hand_over() {
+    std::size_t size = pptr() - pbase();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (size > 0) {
+      done_.wait(lock,
+                 [this] { return error_ || pending_.size() < max_pending_; });
+      if (error_)
+        return false;
+      chunk_.resize(size);
+      pending_.push_back(std::move(chunk_));
+      lock.unlock();
+      ready_.notify_one();
+      start_chunk();
+      return true;
+    }
+    return !error_;
+  }
+
+  /**
+   * Body of the background thread: compress and write the pending
+   * chunks in order until the buffer is closed.
+   */
+  void run() {
+    std::string chunk;
+    std::string compressed;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return closed_ || !pending_.empty(); });
+        if (pending_.empty())
+          return;
+        chunk = std::move(pending_.front());
+        pending_.pop_front();
+      }
+      try {
+        compress(chunk, compressed);
+        sink_.write(compressed.data(), compressed.size());
+        if (!sink_)
+          throw std::runtime_error("gzip_streambuf: failed to write output");
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        pending_.clear();
+      }
+      done_.notify_one();
+    }
+  }
+
+  /**
+   * Compress the specified chunk into a complete gzip member.
+   *
+   * @param[in] chunk characters to compress
+   * @param[out] compressed gzip member
+   */
+  void compress(const std::string& chunk, std::string& compressed) {
+    compressed.resize(deflateBound(&zstream_, chunk.size()) + 32);
+    zstream_.next_in
+        = reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+    zstream_.avail_in = static_cast<uInt>(chunk.size());
+    zstream_.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    zstream_.avail_out = static_cast<uInt>(compressed.size());
+    int status = deflate(&zstream_, Z_FINISH);
+    if (status != Z_STREAM_END)
+      throw std::runtime_error("gzip_streambuf: compression failed");
+    compressed.resize(compressed.size() - zstream_.avail_out);
+    deflateReset(&zstream_);
+  }
+
+  std::ostream& sink_;
+  std::size_t chunk_size_;
+  std::size_t max_pending_;
+
+  /**
+   * Chunk being filled by the writing thread.
+   */
+  std::string chunk_;
+
+  /**
+   * Compression state, used by the background thread only.
+   */
+  z_stream zstream_;
+
+  /**
+   * Full chunks waiting for the background thread, the closing flag
+   * and the first error, guarded by the mutex.
+   */
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable done_;
+  std::deque<std::string> pending_;
+  bool closed_;
+  std::exception_ptr error_;
+
+  /**
+   * Background thread, started once every other member is
+   * initialized.
+   */
+  std::thread worker_;
+};
+
+/**
+ * <code>gzip_ostream</code> is an output stream writing gzip
+ * compressed output to a file or another stream through a
+ * <code>gzip_streambuf</code>.
+ */
+class gzip_ostream : public std::ostream {
+ public:
+  /**
+   * Construct a stream writing compressed output to the specified
+   * stream.
+   *
+   * @param[in, out] sink stream receiving the compressed output; must
+   *   outlive this stream
+   * @param[in] level zlib compression level
+   */
+  explicit gzip_ostream(std::ostream& sink, int level = Z_DEFAULT_COMPRESSION)
+      : std::ostream(nullptr), buf_(new gzip_streambuf(sink, level)) {
+    rdbuf(buf_.get());
+  }
+
+  /**
+   * Construct a stream writing compressed output to the specified
+   * stream, which it owns.
+   *
+   * @param[in] sink stream receiving the compressed output
+   * @param[in] level zlib compression level
+   */
+  explicit gzip_ostream(std::unique_ptr<std::ostream>&& sink,
+                        int level = Z_DEFAULT_COMPRESSION)
+      : std::ostream(nullptr),
+        sink_(std::move(sink)),
+        buf_(new gzip_streambuf(*sink_, level)) {
+    rdbuf(buf_.get());
+  }
+
+  /**
+   * Destructor.  Compresses and writes any remaining output before
+   * closing the owned stream, if any.
+   */
+  ~gzip_ostream() { buf_.reset(); }
+
+  /**
+   * Compress and write any remaining output.
+   *
+   * @throw std::exception the first error raised while compressing or
+   *   writing
+   */
+  void close() { buf_->close(); }
+
+ private:
+  std::unique_ptr<std::ostream> sink_;
+  std::unique_ptr<gzip_streambuf> buf_;
+};
+
+/**
+ * Writer of gzip compressed CSV output, compressing on a background
+ * thread.
+ */
+using gzip_stream_writer = unique_stream_writer<gzip_ostream>;
+
+/**
+ * Writer of gzip compressed JSON output, compressing on a background
+ * thread.
+ */
+using gzip_json_writer = json_writer<gzip_ostream>;
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
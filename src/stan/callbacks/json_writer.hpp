@@ -3,6 +3,7 @@
 
 #include <stan/math/prim/fun/Eigen.hpp>
 #include <stan/math/prim/meta.hpp>
+#include <stan/callbacks/row_buffer.hpp>
 #include <stan/callbacks/structured_writer.hpp>
 #include <ostream>
 #include <string>
@@ -38,6 +39,8 @@ class json_writer final : public structured_writer {
   // Depth of records (used to determine whether or not to print comma
   // separator)
   int record_depth_ = 0;
+  // Buffer the values of a key-value pair are formatted into
+  internal::row_buffer row_;
 
   /**
    * Determines whether a record's internal object requires a comma separator
@@ -112,54 +115,56 @@ class json_writer final : public structured_writer {
   }
 
   /**
-   * Writes a single value.  Corrects capitalization for inf and nans.
+   * Formats a single value into the row buffer.  Corrects
+   * capitalization for inf and nans.
    *
    * @param[in] v value
    */
   void write_value(double v) {
     if (unlikely(std::isinf(v))) {
       if (v > 0) {
-        *output_ << "Inf";
+        row_ << "Inf";
       } else {
-        *output_ << "-Inf";
+        row_ << "-Inf";
       }
     } else if (unlikely(std::isnan(v))) {
-      *output_ << "NaN";
+      row_ << "NaN";
     } else {
-      *output_ << v;
+      row_ << v;
     }
   }
 
   /**
-   * Writes a single complex value.
+   * Formats a single complex value into the row buffer.
    *
    * @param[in] v value
    */
   void write_complex_value(std::complex<double> v) {
-    *output_ << "[";
+    row_ << "[";
     write_value(v.real());
-    *output_ << ", ";
+    row_ << ", ";
     write_value(v.imag());
-    *output_ << "]";
+    row_ << "]";
   }
 
   /**
-   * Writes the set of comma separated values in an Eigen (row) vector.
+   * Formats the set of comma separated values in an Eigen (row) vector
+   * into the row buffer.
    *
    * @param[in] v Values in an `Eigen::Vector`
    */
   template <typename Derived>
   void write_eigen_vector(const Eigen::DenseBase<Derived>& v) {
-    *output_ << "[ ";
+    row_ << "[ ";
     if (v.size() > 0) {
       size_t last = v.size() - 1;
       for (Eigen::Index i = 0; i < last; ++i) {
         write_value(v[i]);
-        *output_ << ", ";
+        row_ << ", ";
       }
       write_value(v[last]);
     }
-    *output_ << " ]";
+    row_ << " ]";
   }
 
  public:
@@ -187,6 +192,11 @@ class json_writer final : public structured_writer {
 
   virtual ~json_writer() {}
 
+  /**
+   * Return true if the writer has an output stream.
+   */
+  bool enabled() const { return output_ != nullptr; }
+
   /**
    * Writes "{", initial token of a JSON record.
    */
@@ -335,7 +345,9 @@ class json_writer final : public structured_writer {
     }
     write_sep();
     write_key(key);
+    row_.reset(*output_);
     write_value(value);
+    row_.write_to(*output_);
   }
 
   /**
@@ -349,7 +361,9 @@ class json_writer final : public structured_writer {
     }
     write_sep();
     write_key(key);
+    row_.reset(*output_);
     write_complex_value(value);
+    row_.write_to(*output_);
   }
 
   /**
@@ -387,17 +401,19 @@ class json_writer final : public structured_writer {
     write_sep();
     write_key(key);
 
-    *output_ << "[ ";
+    row_.reset(*output_);
+    row_ << "[ ";
     if (values.size() > 0) {
       auto last = values.end();
       --last;
       for (auto it = values.begin(); it != last; ++it) {
         write_value(*it);
-        *output_ << ", ";
+        row_ << ", ";
       }
       write_value(values.back());
     }
-    *output_ << " ]";
+    row_ << " ]";
+    row_.write_to(*output_);
   }
 
   /**
@@ -436,16 +452,18 @@ class json_writer final : public structured_writer {
     write_sep();
     write_key(key);
 
-    *output_ << "[ ";
+    row_.reset(*output_);
+    row_ << "[ ";
     if (values.size() > 0) {
       size_t last = values.size() - 1;
       for (size_t i = 0; i < last; ++i) {
         write_complex_value(values[i]);
-        *output_ << ", ";
+        row_ << ", ";
       }
       write_complex_value(values[last]);
     }
-    *output_ << " ]";
+    row_ << " ]";
+    row_.write_to(*output_);
   }
 
   /**
@@ -459,7 +477,9 @@ class json_writer final : public structured_writer {
     }
     write_sep();
     write_key(key);
+    row_.reset(*output_);
     write_eigen_vector(vec);
+    row_.write_to(*output_);
   }
 
   /**
@@ -473,7 +493,9 @@ class json_writer final : public structured_writer {
     }
     write_sep();
     write_key(key);
+    row_.reset(*output_);
     write_eigen_vector(vec);
+    row_.write_to(*output_);
   }
 
   /**
@@ -487,16 +509,18 @@ class json_writer final : public structured_writer {
     }
     write_sep();
     write_key(key);
-    *output_ << "[ ";
+    row_.reset(*output_);
+    row_ << "[ ";
     if (mat.rows() > 0) {
       Eigen::Index last = mat.rows() - 1;
       for (Eigen::Index i = 0; i < last; ++i) {
         write_eigen_vector(mat.row(i));
-        *output_ << ", ";
+        row_ << ", ";
       }
       write_eigen_vector(mat.row(last));
     }
-    *output_ << " ]";
+    row_ << " ]";
+    row_.write_to(*output_);
   }
 };
 
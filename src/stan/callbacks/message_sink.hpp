@@ -0,0 +1,102 @@
+#ifndef STAN_CALLBACKS_MESSAGE_SINK_HPP
+#define STAN_CALLBACKS_MESSAGE_SINK_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <ios>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace stan {
+namespace callbacks {
+
+namespace internal {
+
+/**
+ * Stream buffer appending every character written to a string, with
+ * no put area, so that nothing is allocated until a character is
+ * written.
+ */
+class string_append_buf : public std::streambuf {
+ public:
+  std::string& str() noexcept { return str_; }
+  const std::string& str() const noexcept { return str_; }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+      str_.push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    str_.append(s, n);
+    return n;
+  }
+
+ private:
+  std::string str_;
+};
+
+}  // namespace internal
+
+/**
+ * <code>message_sink</code> is the stream passed as the
+ * <code>std::ostream* msgs</code> argument of the model on hot paths,
+ * in place of a <code>std::stringstream</code> constructed on every
+ * call.  Its storage is only allocated when the model prints, checking
+ * whether it holds messages does not copy them, and clearing it keeps
+ * its storage, so a sink kept across calls costs nothing while the
+ * model is silent.
+ *
+ * A copy of a sink starts empty, so that objects holding one, such as
+ * the Hamiltonians copied for each thread, remain copyable.
+ */
+class message_sink : public std::ostream {
+ public:
+  message_sink() : std::ostream(nullptr) { rdbuf(&buf_); }
+
+  message_sink(const message_sink&) : message_sink() {}
+
+  message_sink& operator=(const message_sink&) { return *this; }
+
+  /**
+   * Return true if no message has been written since construction or
+   * the last call to <code>clear_messages</code>.
+   */
+  bool empty() const noexcept { return buf_.str().empty(); }
+
+  /**
+   * Return the messages written.
+   */
+  const std::string& str() const noexcept { return buf_.str(); }
+
+  /**
+   * Discard the messages written, keeping the storage, and clear the
+   * error state of the stream.
+   */
+  void clear_messages() {
+    buf_.str().clear();
+    clear();
+  }
+
+  /**
+   * Log the messages written as one info message, if there are any,
+   * and discard them.
+   *
+   * @param[in,out] logger logger for the messages
+   */
+  void flush_to(logger& logger) {
+    if (!empty()) {
+      logger.info(buf_.str());
+      clear_messages();
+    }
+  }
+
+ private:
+  internal::string_append_buf buf_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
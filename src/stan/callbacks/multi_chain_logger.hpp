@@ -0,0 +1,185 @@
+#ifndef STAN_CALLBACKS_MULTI_CHAIN_LOGGER_HPP
+#define STAN_CALLBACKS_MULTI_CHAIN_LOGGER_HPP
+
+#include <stan/callbacks/buffered_logger.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>multi_chain_logger</code> gathers the messages of several
+ * chains, each logged from its own thread, into a single logger.
+ *
+ * Each chain logs to its own <code>logger</code>, returned by
+ * <code>chain(n)</code>, which tags messages with the prefix
+ * <code>"Chain [</code><i>id</i><code>] "</code> used by the progress
+ * messages of the samplers and keeps them in a buffer of its own.
+ * The buffer is passed on to the wrapped logger in one batch, under a
+ * lock shared by the chains, when:
+ * <ul>
+ * <li>it holds the batch size of messages;</li>
+ * <li>a message arrives at least the flush interval after the last
+ * batch was passed on;</li>
+ * <li>an error or fatal message is logged;</li>
+ * <li>the chain's logger is flushed.</li>
+ * </ul>
+ * Occasional messages, such as progress reports, are thus passed on as
+ * they arrive, while a model logging many warnings takes the lock once
+ * per batch rather than once per message.  The messages of each chain
+ * reach the wrapped logger in the order they were logged, in batches
+ * interleaved with those of the other chains.  Blank messages and
+ * messages already tagged with the chain are passed on as is.
+ *
+ * Only one thread may log to each chain's logger at a time.  The
+ * destructor flushes all chains.
+ */
+class multi_chain_logger {
+ public:
+  /**
+   * Construct a logger gathering the specified number of chains into
+   * the specified logger.
+   *
+   * @param[in, out] sink logger receiving the messages; must outlive
+   *   this logger
+   * @param[in] num_chains number of chains
+   * @param[in] batch_size largest number of messages of a chain passed
+   *   on together, at least one
+   * @param[in] flush_interval time after which the next message of a
+   *   chain is passed on with those buffered before it
+   * @param[in] init_chain_id id of the first chain written in the
+   *   prefix, the other chains being numbered consecutively
+   */
+  multi_chain_logger(
+      logger& sink, std::size_t num_chains, std::size_t batch_size = 32,
+      std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100),
+      int init_chain_id = 1)
+      : sink_(sink) {
+    chains_.reserve(num_chains);
+    for (std::size_t n = 0; n < num_chains; ++n)
+      chains_.emplace_back(
+          new chain_logger(*this, init_chain_id + static_cast<int>(n),
+                           batch_size, flush_interval));
+  }
+
+  /**
+   * Destructor.  Flushes the messages of every chain.
+   */
+  ~multi_chain_logger() {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  multi_chain_logger(const multi_chain_logger&) = delete;
+  multi_chain_logger& operator=(const multi_chain_logger&) = delete;
+
+  /**
+   * Return the logger of the specified chain.
+   *
+   * @param[in] n index of the chain, from 0
+   * @return logger of the chain
+   */
+  logger& chain(std::size_t n) { return *chains_[n]; }
+
+  /**
+   * Pass on the buffered messages of every chain.  The chains must not
+   * be logging concurrently.
+   */
+  void flush() {
+    for (auto& chain : chains_)
+      chain->flush();
+  }
+
+ private:
+  class chain_logger final : public logger {
+   public:
+    chain_logger(multi_chain_logger& parent, int chain_id,
+                 std::size_t batch_size,
+                 std::chrono::milliseconds flush_interval)
+        : parent_(parent),
+          prefix_("Chain [" + std::to_string(chain_id) + "] "),
+          batch_size_(batch_size < 1 ? 1 : batch_size),
+          flush_interval_(flush_interval),
+          last_flush_(std::chrono::steady_clock::now() - flush_interval) {}
+
+    void debug(const std::string& message) {
+      buffer_.debug(prefixed(message));
+      added();
+    }
+
+    void debug(const std::stringstream& message) { debug(message.str()); }
+
+    void info(const std::string& message) {
+      buffer_.info(prefixed(message));
+      added();
+    }
+
+    void info(const std::stringstream& message) { info(message.str()); }
+
+    void warn(const std::string& message) {
+      buffer_.warn(prefixed(message));
+      added();
+    }
+
+    void warn(const std::stringstream& message) { warn(message.str()); }
+
+    void error(const std::string& message) {
+      buffer_.error(prefixed(message));
+      flush();
+    }
+
+    void error(const std::stringstream& message) { error(message.str()); }
+
+    void fatal(const std::string& message) {
+      buffer_.fatal(prefixed(message));
+      flush();
+    }
+
+    void fatal(const std::stringstream& message) { fatal(message.str()); }
+
+    void flush() {
+      if (buffer_.messages().empty())
+        return;
+      last_flush_ = std::chrono::steady_clock::now();
+      std::lock_guard<std::mutex> lock(parent_.sink_mutex_);
+      buffer_.replay(parent_.sink_);
+    }
+
+   private:
+    multi_chain_logger& parent_;
+    const std::string prefix_;
+    const std::size_t batch_size_;
+    const std::chrono::steady_clock::duration flush_interval_;
+    std::chrono::steady_clock::time_point last_flush_;
+    buffered_logger buffer_;
+
+    std::string prefixed(const std::string& message) const {
+      return message.empty() || message.compare(0, prefix_.size(), prefix_) == 0
+                 ? message
+                 : prefix_ + message;
+    }
+
+    void added() {
+      if (buffer_.messages().size() >= batch_size_
+          || std::chrono::steady_clock::now() - last_flush_ >= flush_interval_)
+        flush();
+    }
+  };
+
+  logger& sink_;
+  std::mutex sink_mutex_;
+  std::vector<std::unique_ptr<chain_logger>> chains_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
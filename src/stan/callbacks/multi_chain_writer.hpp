@@ -0,0 +1,344 @@
+#ifndef STAN_CALLBACKS_MULTI_CHAIN_WRITER_HPP
+#define STAN_CALLBACKS_MULTI_CHAIN_WRITER_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>multi_chain_writer</code> gathers the output of several chains,
+ * each written from its own thread, into a single writer on a
+ * background thread, adding a leading <code>chain</code> column.
+ *
+ * Each chain writes to its own <code>writer</code>, returned by
+ * <code>chain(n)</code>, which hands calls over through a bounded
+ * single-producer, single-consumer ring of preallocated slots as
+ * <code>async_writer</code> does.  No lock is shared between the
+ * chains: the background thread visits the rings in turn and forwards
+ * whatever is pending, so the calls of each chain reach the wrapped
+ * writer in the order they were made, interleaved with those of the
+ * other chains as they arrive.  A chain waits only when its own ring
+ * is full.
+ *
+ * The calls are forwarded as follows:
+ * <ul>
+ * <li>the first set of names received is written with
+ * <code>"chain"</code> prepended and the names of all the chains,
+ * which are expected to be the same, are dropped afterwards;</li>
+ * <li>sets of values are written with the chain id prepended;</li>
+ * <li>messages are written prefixed with <code>"Chain </code><i>id</i>
+ * <code>: "</code>;</li>
+ * <li>matrices are written with a first row holding the chain id;</li>
+ * <li>blank input is written as is.</li>
+ * </ul>
+ *
+ * Only one thread may write to each chain's writer at a time.  An
+ * exception thrown by the wrapped writer is rethrown by the next call
+ * to the writer of any chain or to <code>flush()</code>.  The
+ * destructor drains all pending calls before returning.
+ */
+class multi_chain_writer {
+ public:
+  /**
+   * Construct a writer gathering the specified number of chains into
+   * the specified writer, each chain through a ring with the specified
+   * number of slots.
+   *
+   * @param[in, out] sink writer receiving the calls; must outlive this
+   *   writer
+   * @param[in] num_chains number of chains
+   * @param[in] capacity number of calls of each chain that may be
+   *   pending at once, at least one
+   * @param[in] init_chain_id id of the first chain written in the
+   *   chain column, the other chains being numbered consecutively
+   */
+  multi_chain_writer(writer& sink, std::size_t num_chains,
+                     std::size_t capacity = 64, int init_chain_id = 1)
+      : sink_(sink),
+        init_chain_id_(init_chain_id),
+        header_written_(false),
+        closed_(false),
+        failed_(false) {
+    chains_.reserve(num_chains);
+    for (std::size_t n = 0; n < num_chains; ++n)
+      chains_.emplace_back(new chain_writer(*this, capacity));
+    worker_ = std::thread(&multi_chain_writer::run, this);
+  }
+
+  /**
+   * Destructor.  Waits until every pending call has been forwarded.
+   */
+  ~multi_chain_writer() {
+    closed_.store(true, std::memory_order_release);
+    worker_.join();
+  }
+
+  multi_chain_writer(const multi_chain_writer&) = delete;
+  multi_chain_writer& operator=(const multi_chain_writer&) = delete;
+
+  /**
+   * Return the number of chains.
+   */
+  inline std::size_t num_chains() const noexcept { return chains_.size(); }
+
+  /**
+   * Return the writer of the specified chain.
+   *
+   * @param[in] n index of the chain, from zero
+   * @return writer of the chain, valid as long as this writer
+   */
+  inline writer& chain(std::size_t n) { return *chains_[n]; }
+
+  /**
+   * Wait until every call made so far by every chain has been
+   * forwarded to the wrapped writer.
+   */
+  void flush() {
+    for (auto& chain : chains_) {
+      const std::size_t head = chain->head_.load(std::memory_order_acquire);
+      int spins = 0;
+      while (chain->tail_.load(std::memory_order_acquire) != head
+             && !failed()) {
+        backoff(spins);
+      }
+    }
+    rethrow_if_failed();
+  }
+
+ private:
+  enum class kind { names, values, blank, message, matrix };
+
+  /**
+   * One pending call.  Its buffers keep their capacity between uses
+   * so that steady-state writes do not allocate.
+   */
+  struct slot {
+    kind type{kind::blank};
+    std::vector<std::string> names;
+    std::vector<double> values;
+    std::string message;
+    Eigen::MatrixXd matrix;
+  };
+
+  /**
+   * The writer of one chain, owning the chain's ring.
+   */
+  class chain_writer final : public writer {
+   public:
+    chain_writer(multi_chain_writer& owner, std::size_t capacity)
+        : owner_(owner), slots_(capacity > 0 ? capacity : 1), head_(0),
+          tail_(0) {}
+
+    void operator()(const std::vector<std::string>& names) {
+      slot& s = acquire();
+      s.type = kind::names;
+      s.names = names;
+      publish();
+    }
+
+    void operator()(const std::vector<double>& state) {
+      slot& s = acquire();
+      s.type = kind::values;
+      s.values.assign(state.begin(), state.end());
+      publish();
+    }
+
+    void operator()() {
+      slot& s = acquire();
+      s.type = kind::blank;
+      publish();
+    }
+
+    void operator()(const std::string& message) {
+      slot& s = acquire();
+      s.type = kind::message;
+      s.message = message;
+      publish();
+    }
+
+    void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+      slot& s = acquire();
+      s.type = kind::matrix;
+      s.matrix = values;
+      publish();
+    }
+
+   private:
+    friend class multi_chain_writer;
+
+    /**
+     * Wait for a free slot and return it.
+     */
+    slot& acquire() {
+      owner_.rethrow_if_failed();
+      const std::size_t head = head_.load(std::memory_order_relaxed);
+      int spins = 0;
+      while (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+        backoff(spins);
+        owner_.rethrow_if_failed();
+      }
+      return slots_[head % slots_.size()];
+    }
+
+    /**
+     * Hand the slot returned by the last call to acquire() to the
+     * background thread.
+     */
+    void publish() {
+      head_.store(head_.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_release);
+    }
+
+    multi_chain_writer& owner_;
+
+    /**
+     * Ring of pending calls.
+     */
+    std::vector<slot> slots_;
+
+    /**
+     * Number of calls published by the chain.
+     */
+    std::atomic<std::size_t> head_;
+
+    /**
+     * Number of calls forwarded by the background thread.
+     */
+    std::atomic<std::size_t> tail_;
+  };
+
+  /**
+   * Body of the background thread: forward the pending calls of each
+   * chain in turn until the writer is closed and every ring is empty.
+   */
+  void run() {
+    int spins = 0;
+    while (true) {
+      // Read before the rings so that calls published before closing
+      // are seen by this pass
+      const bool closed = closed_.load(std::memory_order_acquire);
+      bool forwarded = false;
+      for (std::size_t n = 0; n < chains_.size(); ++n) {
+        chain_writer& chain = *chains_[n];
+        std::size_t tail = chain.tail_.load(std::memory_order_relaxed);
+        const std::size_t head = chain.head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+          if (!failed()) {
+            try {
+              forward(n, chain.slots_[tail % chain.slots_.size()]);
+            } catch (...) {
+              error_ = std::current_exception();
+              failed_.store(true, std::memory_order_release);
+            }
+          }
+          chain.tail_.store(tail + 1, std::memory_order_release);
+          forwarded = true;
+        }
+      }
+      if (forwarded) {
+        spins = 0;
+      } else if (closed) {
+        return;
+      } else {
+        backoff(spins);
+      }
+    }
+  }
+
+  void forward(std::size_t n, slot& s) {
+    const int chain_id = init_chain_id_ + static_cast<int>(n);
+    switch (s.type) {
+      case kind::names:
+        if (!header_written_) {
+          header_.assign(1, "chain");
+          header_.insert(header_.end(), s.names.begin(), s.names.end());
+          sink_(header_);
+          header_written_ = true;
+        }
+        break;
+      case kind::values:
+        row_.assign(1, chain_id);
+        row_.insert(row_.end(), s.values.begin(), s.values.end());
+        sink_(row_);
+        break;
+      case kind::blank:
+        sink_();
+        break;
+      case kind::message:
+        sink_("Chain " + std::to_string(chain_id) + ": " + s.message);
+        break;
+      case kind::matrix:
+        matrix_.resize(s.matrix.rows() + 1, s.matrix.cols());
+        matrix_.row(0).setConstant(chain_id);
+        matrix_.bottomRows(s.matrix.rows()) = s.matrix;
+        sink_(Eigen::Ref<Eigen::Matrix<double, -1, -1>>(matrix_));
+        break;
+    }
+  }
+
+  inline bool failed() const {
+    return failed_.load(std::memory_order_acquire);
+  }
+
+  void rethrow_if_failed() {
+    if (failed())
+      std::rethrow_exception(error_);
+  }
+
+  /**
+   * Wait politely: yield for a while, then sleep briefly.
+   *
+   * @param[in, out] spins number of times waited so far
+   */
+  static void backoff(int& spins) {
+    if (spins < 64) {
+      ++spins;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+
+  /**
+   * The writer receiving the calls.
+   */
+  writer& sink_;
+
+  int init_chain_id_;
+
+  /**
+   * Writers of the chains.
+   */
+  std::vector<std::unique_ptr<chain_writer>> chains_;
+
+  /**
+   * Buffers of the background thread for the forwarded calls.
+   */
+  bool header_written_;
+  std::vector<std::string> header_;
+  std::vector<double> row_;
+  Eigen::MatrixXd matrix_;
+
+  std::atomic<bool> closed_;
+  std::atomic<bool> failed_;
+  std::exception_ptr error_;
+
+  /**
+   * Background thread, started once every other member is
+   * initialized.
+   */
+  std::thread worker_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,40 @@
+#ifndef STAN_CALLBACKS_PROGRESS_HPP
+#define STAN_CALLBACKS_PROGRESS_HPP
+
+#include <cstddef>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>progress</code> receives the progress of a sampler as numbers
+ * instead of the formatted "Iteration:" messages, at the iterations at
+ * which those messages would be logged.
+ *
+ * It is called from the thread running the chain, between
+ * iterations, so implementations should return quickly and leave any
+ * costly work, such as redrawing a display, to another thread.
+ */
+class progress {
+ public:
+  /**
+   * Callback function.
+   *
+   * @param[in] chain_id id of the chain
+   * @param[in] iteration number of the iteration starting, counting
+   *   from one and including the warmup iterations
+   * @param[in] num_iterations total number of iterations of the run
+   * @param[in] warmup true during warmup
+   */
+  virtual void operator()(size_t chain_id, int iteration, int num_iterations,
+                          bool warmup) {}
+
+  /**
+   * Virtual destructor.
+   */
+  virtual ~progress() {}
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -0,0 +1,197 @@
+#ifndef STAN_CALLBACKS_ROW_BUFFER_HPP
+#define STAN_CALLBACKS_ROW_BUFFER_HPP
+
+#include <charconv>
+#include <ios>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace stan {
+namespace callbacks {
+namespace internal {
+
+/**
+ * <code>row_buffer</code> formats the values of a row into a reusable
+ * character buffer, which the writers then hand to their stream in a
+ * single write.
+ *
+ * Numbers are formatted exactly as the stream given to
+ * <code>reset()</code> would format them, with its precision and
+ * floating point notation.  In the common case of a stream using the
+ * classic locale and no width, sign, point or case flags, they are
+ * formatted with <code>std::to_chars</code>, which is free of locale
+ * lookups and virtual calls; otherwise they go through a string stream
+ * with the same formatting state as the stream.
+ */
+class row_buffer {
+ public:
+  row_buffer() : precision_(6), notation_(notation::general) {}
+
+  /**
+   * The buffer only holds the row being written, so copies start
+   * empty, letting the writers holding one stay copyable.
+   */
+  row_buffer(const row_buffer&) : row_buffer() {}
+  row_buffer& operator=(const row_buffer&) { return *this; }
+
+  /**
+   * Empty the buffer and take the formatting state of the specified
+   * stream.  A stream which is not derived from
+   * <code>std::ios</code> is taken to use the default state.
+   *
+   * @tparam Stream type of the stream
+   * @param[in] out stream the row will be written to
+   */
+  template <typename Stream>
+  void reset(const Stream& out) {
+    buffer_.clear();
+    set_format(out, std::is_base_of<std::ios, Stream>());
+  }
+
+  /**
+   * Empty the buffer, keeping the formatting state.
+   */
+  void clear() { buffer_.clear(); }
+
+  row_buffer& operator<<(double x) {
+#ifdef __cpp_lib_to_chars
+    if (fast_) {
+      char chars[max_chars];
+      std::chars_format format = notation_ == notation::fixed
+                                     ? std::chars_format::fixed
+                                     : notation_ == notation::scientific
+                                           ? std::chars_format::scientific
+                                           : std::chars_format::general;
+      std::to_chars_result result
+          = std::to_chars(chars, chars + max_chars, x, format, precision_);
+      if (result.ec == std::errc()) {
+        buffer_.append(chars, result.ptr);
+        return *this;
+      }
+    }
+#endif
+    return append_slow(x);
+  }
+
+  row_buffer& operator<<(int x) {
+    if (fast_int_) {
+      char chars[16];
+      std::to_chars_result result = std::to_chars(chars, chars + 16, x);
+      buffer_.append(chars, result.ptr);
+      return *this;
+    }
+    return append_slow(x);
+  }
+
+  row_buffer& operator<<(const std::string& x) {
+    buffer_.append(x);
+    return *this;
+  }
+
+  row_buffer& operator<<(const char* x) {
+    buffer_.append(x);
+    return *this;
+  }
+
+  row_buffer& operator<<(char x) {
+    buffer_.push_back(x);
+    return *this;
+  }
+
+  /**
+   * Return the characters formatted so far.
+   */
+  inline const std::string& str() const noexcept { return buffer_; }
+
+  /**
+   * Write the characters formatted so far to the specified stream.
+   *
+   * @tparam Stream type of the stream, either derived from
+   *   <code>std::ostream</code> or with an
+   *   <code>operator<<(std::string)</code>
+   * @param[in, out] out stream to write to
+   */
+  template <typename Stream>
+  void write_to(Stream& out) const {
+    write_chars(out, std::is_base_of<std::ostream, Stream>());
+  }
+
+ private:
+  static constexpr int max_chars = 512;
+
+  enum class notation { general, fixed, scientific };
+
+  void set_format(const std::ios& out, std::true_type) {
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::ios_base::fmtflags float_field
+        = flags & std::ios_base::floatfield;
+    const bool plain
+        = out.width() == 0 && out.getloc() == std::locale::classic()
+          && !(flags
+               & (std::ios_base::showpos | std::ios_base::showpoint
+                  | std::ios_base::uppercase));
+    precision_ = static_cast<int>(out.precision());
+    if (float_field == std::ios_base::fixed)
+      notation_ = notation::fixed;
+    else if (float_field == std::ios_base::scientific)
+      notation_ = notation::scientific;
+    else
+      notation_ = notation::general;
+#ifdef __cpp_lib_to_chars
+    fast_ = plain && float_field != std::ios_base::floatfield
+            && precision_ >= 0;
+#else
+    fast_ = false;
+#endif
+    fast_int_
+        = plain && (flags & std::ios_base::basefield) == std::ios_base::dec;
+    if (!fast_ || !fast_int_)
+      slow_.copyfmt(out);
+  }
+
+  template <typename Stream>
+  void set_format(const Stream& out, std::false_type) {
+    precision_ = 6;
+    notation_ = notation::general;
+    fast_ = true;
+    fast_int_ = true;
+  }
+
+  template <typename T>
+  row_buffer& append_slow(T x) {
+    slow_.str(std::string());
+    slow_ << x;
+    buffer_.append(slow_.str());
+    return *this;
+  }
+
+  template <typename Stream>
+  void write_chars(Stream& out, std::true_type) const {
+    out.write(buffer_.data(), buffer_.size());
+  }
+
+  template <typename Stream>
+  void write_chars(Stream& out, std::false_type) const {
+    out << buffer_;
+  }
+
+  std::string buffer_;
+  int precision_;
+  notation notation_;
+  bool fast_{true};
+  bool fast_int_{true};
+
+  /**
+   * Stream with the formatting state of the output for the cases not
+   * handled by <code>std::to_chars</code>.
+   */
+  std::ostringstream slow_;
+};
+
+}  // namespace internal
+}  // namespace callbacks
+}  // namespace stan
+#endif
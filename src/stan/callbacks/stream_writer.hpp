@@ -1,6 +1,7 @@
 #ifndef STAN_CALLBACKS_STREAM_WRITER_HPP
 #define STAN_CALLBACKS_STREAM_WRITER_HPP
 
+#include <stan/callbacks/row_buffer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <ostream>
 #include <vector>
@@ -54,6 +55,15 @@ class stream_writer : public writer {
    */
   void operator()(const std::vector<double>& state) { write_vector(state); }
 
+  /**
+   * Writes a set of values given as consecutive segments in csv format
+   * followed by a newline, as the <code>std::vector</code> overload
+   * does, without concatenating them first.
+   *
+   * @param[in] segments Values in consecutive segments
+   */
+  void operator()(row_segments segments) { write_segments(segments); }
+
   /**
    * Writes the comment_prefix to the stream followed by a newline.
    */
@@ -79,9 +89,17 @@ class stream_writer : public writer {
    */
   std::string comment_prefix_;
 
+  /**
+   * Buffer the rows are formatted into
+   */
+  internal::row_buffer row_;
+
   /**
    * Writes a set of values in csv format followed by a newline.
    *
+   * The row is formatted into a buffer and written to the stream at
+   * once.
+   *
    * Note: the precision of the output is determined by the settings
    *  of the stream on construction.
    *
@@ -95,10 +113,36 @@ class stream_writer : public writer {
     typename std::vector<T>::const_iterator last = v.end();
     --last;
 
+    row_.reset(output_);
     for (typename std::vector<T>::const_iterator it = v.begin(); it != last;
          ++it)
-      output_ << *it << ",";
-    output_ << v.back() << std::endl;
+      row_ << *it << ',';
+    row_ << v.back();
+    row_.write_to(output_);
+    output_ << std::endl;
+  }
+
+  /**
+   * Writes a set of values given as consecutive segments in csv format
+   * followed by a newline, formatting the segments in place.
+   *
+   * @param[in] segments Values in consecutive segments
+   */
+  void write_segments(row_segments segments) {
+    row_.reset(output_);
+    bool first = true;
+    for (const value_span& segment : segments) {
+      for (double x : segment) {
+        if (!first)
+          row_ << ',';
+        row_ << x;
+        first = false;
+      }
+    }
+    if (first)
+      return;
+    row_.write_to(output_);
+    output_ << std::endl;
   }
 };
 
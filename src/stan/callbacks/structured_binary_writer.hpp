@@ -0,0 +1,336 @@
+#ifndef STAN_CALLBACKS_STRUCTURED_BINARY_WRITER_HPP
+#define STAN_CALLBACKS_STRUCTURED_BINARY_WRITER_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/io/structured_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * `structured_binary_writer` is an implementation of
+ * `structured_writer` that writes records in the binary format
+ * described in `stan/io/structured_binary_format.hpp` instead of as
+ * JSON text.  Arrays, vectors and matrices of doubles are written as
+ * blocks of raw doubles, so a large matrix such as a Hessian costs its
+ * size in bytes, and `io::structured_binary_reader` reads it back
+ * without parsing any number.
+ *
+ * @tparam Stream A type derived from `std::ostream`, which should be
+ * opened in binary mode
+ * @tparam Deleter A class with a valid `operator()` method for deleting the
+ * output stream
+ */
+template <typename Stream, typename Deleter = std::default_delete<Stream>>
+class structured_binary_writer final : public structured_writer {
+ private:
+  using item_type = io::structured_binary_format::item_type;
+
+  // Output stream
+  std::unique_ptr<Stream, Deleter> output_{nullptr};
+
+  /**
+   * Writes the type and key of an item.
+   */
+  void write_item(item_type type, const std::string& key) {
+    io::structured_binary_format::write_type(*output_, type);
+    io::structured_binary_format::write_string(*output_, key);
+  }
+
+  /**
+   * Writes an item whose value is a size followed by a block of doubles.
+   */
+  void write_doubles(item_type type, const std::string& key, const double* x,
+                     std::size_t n) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(type, key);
+    io::binary_format::write_u64(*output_, n);
+    io::binary_format::write_doubles(*output_, x, n);
+  }
+
+ public:
+  /**
+   * Constructs a no-op writer.
+   */
+  structured_binary_writer() : output_(nullptr) {}
+
+  /**
+   * Constructs a writer with an output stream, writing the tag of the
+   * format.
+   *
+   * @param[in, out] output unique pointer to a type inheriting from
+   * `std::ostream`
+   */
+  explicit structured_binary_writer(std::unique_ptr<Stream, Deleter>&& output)
+      : output_(std::move(output)) {
+    if (output_ != nullptr) {
+      output_->write(io::structured_binary_format::file_tag,
+                     io::binary_format::tag_size);
+    }
+  }
+
+  /** copy constructor */
+  structured_binary_writer(structured_binary_writer& other) = delete;
+
+  /** move constructor */
+  structured_binary_writer(structured_binary_writer&& other) noexcept
+      : output_(std::move(other.output_)) {}
+
+  virtual ~structured_binary_writer() {}
+
+  /**
+   * Return true if the writer has an output stream.
+   */
+  bool enabled() const { return output_ != nullptr; }
+
+  /**
+   * Writes the start of an unnamed record.
+   */
+  void begin_record() { begin_record(""); }
+
+  /**
+   * Writes the start of a named record.
+   * @param[in] key The name of the record.
+   */
+  void begin_record(const std::string& key) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::begin_record, key);
+  }
+
+  /**
+   * Writes the end of a record.
+   */
+  void end_record() {
+    if (output_ == nullptr) {
+      return;
+    }
+    io::structured_binary_format::write_type(*output_, item_type::end_record);
+  }
+
+  /**
+   * Write a key with a null value.
+   * @param key Name of the value pair
+   */
+  void write(const std::string& key) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::null_value, key);
+  }
+
+  /**
+   * Write a key-value pair where the value is a string.
+   * @param key Name of the value pair
+   * @param value string to write.
+   */
+  void write(const std::string& key, const std::string& value) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::string_value, key);
+    io::structured_binary_format::write_string(*output_, value);
+  }
+
+  /**
+   * Write a key-value pair where the value is a const char*.
+   * @param key Name of the value pair
+   * @param value pointer to chars to write.
+   */
+  void write(const std::string& key, const char* value) {
+    write(key, std::string(value));
+  }
+
+  /**
+   * Write a key-value pair where the value is a bool.
+   * @param key Name of the value pair
+   * @param value bool to write.
+   */
+  void write(const std::string& key, bool value) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::bool_value, key);
+    const char byte = value ? 1 : 0;
+    output_->write(&byte, 1);
+  }
+
+  /**
+   * Write a key-value pair where the value is an int.
+   * @param key Name of the value pair
+   * @param value int to write.
+   */
+  void write(const std::string& key, int value) {
+    write(key, static_cast<long long int>(value));  // NOLINT(runtime/int)
+  }
+
+  /**
+   * Write a key-value pair where the value is an `std::size_t`.
+   * @param key Name of the value pair
+   * @param value `std::size_t` to write.
+   */
+  void write(const std::string& key, std::size_t value) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::uint_value, key);
+    io::binary_format::write_u64(*output_, value);
+  }
+
+  /**
+   * Write a key-value pair where the value is a `long long int`.
+   * @param key Name of the value pair
+   * @param value `long long int` to write.
+   */
+  void write(const std::string& key,
+             long long int value  // NOLINT(runtime/int)
+  ) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::int_value, key);
+    io::binary_format::write_u64(*output_, static_cast<std::uint64_t>(value));
+  }
+
+  /**
+   * Write a key-value pair where the value is an `unsigned int`.
+   * @param key Name of the value pair
+   * @param value `unsigned int` to write.
+   */
+  void write(const std::string& key, unsigned int value) {
+    write(key, static_cast<std::size_t>(value));
+  }
+
+  /**
+   * Write a key-value pair where the value is a double.
+   * @param key Name of the value pair
+   * @param value double to write.
+   */
+  void write(const std::string& key, double value) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::real_value, key);
+    io::binary_format::write_doubles(*output_, &value, 1);
+  }
+
+  /**
+   * Write a key-value pair where the value is a complex value.
+   * @param key Name of the value pair
+   * @param value complex value to write.
+   */
+  void write(const std::string& key, const std::complex<double>& value) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::complex_value, key);
+    const double parts[2] = {value.real(), value.imag()};
+    io::binary_format::write_doubles(*output_, parts, 2);
+  }
+
+  /**
+   * Write a key-value pair where the value is a vector of strings.
+   * @param key Name of the value pair
+   * @param values vector of strings to write.
+   */
+  void write(const std::string& key, const std::vector<std::string>& values) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::string_array, key);
+    io::binary_format::write_u64(*output_, values.size());
+    for (const auto& value : values) {
+      io::structured_binary_format::write_string(*output_, value);
+    }
+  }
+
+  /**
+   * Write a key-value pair where the value is a vector of doubles.
+   * @param key Name of the value pair
+   * @param values vector to write.
+   */
+  void write(const std::string& key, const std::vector<double>& values) {
+    write_doubles(item_type::real_array, key, values.data(), values.size());
+  }
+
+  /**
+   * Write a key-value pair where the value is a vector of ints.
+   * @param key Name of the value pair
+   * @param values vector to write.
+   */
+  void write(const std::string& key, const std::vector<int>& values) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::int_array, key);
+    io::binary_format::write_u64(*output_, values.size());
+    for (int value : values) {
+      io::binary_format::write_u32(*output_, static_cast<std::uint32_t>(value));
+    }
+  }
+
+  /**
+   * Write a key-value pair where the value is a vector of complex values.
+   * @param key Name of the value pair
+   * @param values vector to write.
+   */
+  void write(const std::string& key,
+             const std::vector<std::complex<double>>& values) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::complex_array, key);
+    io::binary_format::write_u64(*output_, values.size());
+    // std::complex<double> is laid out as its real and imaginary parts
+    io::binary_format::write_doubles(
+        *output_, reinterpret_cast<const double*>(values.data()),
+        2 * values.size());
+  }
+
+  /**
+   * Write a key-value pair where the value is an Eigen Vector.
+   * @param key Name of the value pair
+   * @param vec Eigen Vector to write.
+   */
+  void write(const std::string& key, const Eigen::VectorXd& vec) {
+    write_doubles(item_type::vector, key, vec.data(), vec.size());
+  }
+
+  /**
+   * Write a key-value pair where the value is an Eigen RowVector.
+   * @param key Name of the value pair
+   * @param vec Eigen RowVector to write.
+   */
+  void write(const std::string& key, const Eigen::RowVectorXd& vec) {
+    write_doubles(item_type::row_vector, key, vec.data(), vec.size());
+  }
+
+  /**
+   * Write a key-value pair where the value is an Eigen Matrix, in
+   * column-major order.
+   * @param key Name of the value pair
+   * @param mat Eigen Matrix to write.
+   */
+  void write(const std::string& key, const Eigen::MatrixXd& mat) {
+    if (output_ == nullptr) {
+      return;
+    }
+    write_item(item_type::matrix, key);
+    io::binary_format::write_u64(*output_, mat.rows());
+    io::binary_format::write_u64(*output_, mat.cols());
+    io::binary_format::write_doubles(*output_, mat.data(), mat.size());
+  }
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
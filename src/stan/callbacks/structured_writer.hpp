@@ -20,6 +20,13 @@ class structured_writer {
    */
   virtual ~structured_writer() {}
 
+  /**
+   * Return true if this writer writes its records to an output, false
+   * for a no-op writer.  The samplers write the adapted metric to the
+   * sample output only when the metric writer does not write it.
+   */
+  virtual bool enabled() const { return false; }
+
   /**
    * Writes start token of a structured record.
    */
@@ -39,6 +39,11 @@ class tee_writer final : public writer {
     writer2_(state);
   }
 
+  void operator()(row_segments segments) {
+    writer1_(segments);
+    writer2_(segments);
+  }
+
   void operator()() {
     writer1_();
     writer2_();
@@ -0,0 +1,69 @@
+#ifndef STAN_CALLBACKS_TIMED_INTERRUPT_HPP
+#define STAN_CALLBACKS_TIMED_INTERRUPT_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <chrono>
+
+namespace stan {
+namespace callbacks {
+
+/**
+ * <code>timed_interrupt</code> forwards calls to another interrupt at
+ * most once per polling interval, for interfaces whose interrupt is
+ * costly to check, such as one polling the signals of an interpreter.
+ *
+ * The clock itself is read only every few calls.  The number of calls
+ * between readings doubles while they are far shorter than the
+ * interval and halves when they are longer, so the wrapped interrupt
+ * is still called within about two intervals of the previous call.
+ * The first call is always forwarded.
+ */
+class timed_interrupt final : public interrupt {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * @param[in,out] wrapped interrupt to forward to
+   * @param[in] interval minimum time between forwarded calls
+   */
+  explicit timed_interrupt(
+      interrupt& wrapped,
+      clock::duration interval = std::chrono::milliseconds(100))
+      : wrapped_(wrapped),
+        interval_(interval),
+        last_check_(clock::now()),
+        last_call_(last_check_ - interval),
+        stride_(1),
+        calls_since_check_(0) {}
+
+  void operator()() {
+    if (++calls_since_check_ < stride_)
+      return;
+    calls_since_check_ = 0;
+    const clock::time_point now = clock::now();
+    const clock::duration since_check = now - last_check_;
+    last_check_ = now;
+    if (since_check < interval_ / 8 && stride_ < max_stride_)
+      stride_ *= 2;
+    else if (since_check > interval_ && stride_ > 1)
+      stride_ /= 2;
+    if (now - last_call_ >= interval_) {
+      last_call_ = now;
+      wrapped_();
+    }
+  }
+
+ private:
+  static constexpr long max_stride_ = 1L << 20;
+
+  interrupt& wrapped_;
+  clock::duration interval_;
+  clock::time_point last_check_;
+  clock::time_point last_call_;
+  long stride_;
+  long calls_since_check_;
+};
+
+}  // namespace callbacks
+}  // namespace stan
+#endif
@@ -1,6 +1,7 @@
 #ifndef STAN_CALLBACKS_UNIQUE_STREAM_WRITER_HPP
 #define STAN_CALLBACKS_UNIQUE_STREAM_WRITER_HPP
 
+#include <stan/callbacks/row_buffer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
 #include <memory>
@@ -78,6 +79,32 @@ class unique_stream_writer final : public writer {
     write_vector(values);
   }
 
+  /**
+   * Writes a set of values given as consecutive segments in csv format
+   * followed by a newline, as the <code>std::vector</code> overload
+   * does, without concatenating them first.
+   *
+   * @param[in] segments Values in consecutive segments
+   */
+  void operator()(row_segments segments) {
+    if (output_ == nullptr)
+      return;
+    row_.reset(*output_);
+    bool first = true;
+    for (const value_span& segment : segments) {
+      for (double x : segment) {
+        if (!first)
+          row_ << ',';
+        row_ << x;
+        first = false;
+      }
+    }
+    if (first)
+      return;
+    row_.write_to(*output_);
+    *output_ << std::endl;
+  }
+
   /**
    * Writes multiple rows and columns of values in csv format.
    *
@@ -131,9 +158,17 @@ class unique_stream_writer final : public writer {
    */
   std::string comment_prefix_;
 
+  /**
+   * Buffer the rows are formatted into
+   */
+  internal::row_buffer row_;
+
   /**
    * Writes a set of values in csv format followed by a newline.
    *
+   * The row is formatted into a buffer and written to the stream at
+   * once.
+   *
    * Note: the precision of the output is determined by the settings
    *  of the stream on construction.
    *
@@ -148,10 +183,13 @@ class unique_stream_writer final : public writer {
     }
     auto last = v.end();
     --last;
+    row_.reset(*output_);
     for (auto it = v.begin(); it != last; ++it) {
-      *output_ << *it << ",";
+      row_ << *it << ',';
     }
-    *output_ << v.back() << std::endl;
+    row_ << v.back();
+    row_.write_to(*output_);
+    *output_ << std::endl;
   }
 };
 
@@ -2,12 +2,48 @@
 #define STAN_CALLBACKS_WRITER_HPP
 
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <initializer_list>
 #include <string>
 #include <vector>
 
 namespace stan {
 namespace callbacks {
 
+/**
+ * <code>value_span</code> is a non-owning view of contiguous values,
+ * one segment of a row written without copying it into a
+ * <code>std::vector</code>.  The values must outlive the call to the
+ * writer.
+ */
+class value_span {
+ public:
+  value_span(const double* data, std::size_t size)
+      : data_(data), size_(size) {}
+
+  value_span(const std::vector<double>& values)  // NOLINT(runtime/explicit)
+      : data_(values.data()), size_(values.size()) {}
+
+  value_span(const Eigen::VectorXd& values)  // NOLINT(runtime/explicit)
+      : data_(values.data()), size_(values.size()) {}
+
+  const double* data() const noexcept { return data_; }
+  std::size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  const double* begin() const noexcept { return data_; }
+  const double* end() const noexcept { return data_ + size_; }
+
+ private:
+  const double* data_;
+  std::size_t size_;
+};
+
+/**
+ * A row of values made of consecutive segments, written as if they
+ * were concatenated into one <code>std::vector</code>.
+ */
+using row_segments = std::initializer_list<value_span>;
+
 /**
  * <code>writer</code> is a base class defining the interface
  * for Stan writer callbacks. The base class can be used as a
@@ -34,6 +70,26 @@ class writer {
    */
   virtual void operator()(const std::vector<double>& state) {}
 
+  /**
+   * Writes a set of values given as consecutive segments, such as the
+   * sampler and model values of a draw, each viewing the storage of
+   * the caller.  Writers formatting the values themselves override it
+   * to write the segments in place; by default the segments are
+   * concatenated and written as a <code>std::vector</code>.
+   *
+   * @param[in] segments Values in consecutive segments
+   */
+  virtual void operator()(row_segments segments) {
+    std::size_t size = 0;
+    for (const value_span& segment : segments)
+      size += segment.size();
+    std::vector<double> state;
+    state.reserve(size);
+    for (const value_span& segment : segments)
+      state.insert(state.end(), segment.begin(), segment.end());
+    (*this)(state);
+  }
+
   /**
    * Writes blank input.
    */
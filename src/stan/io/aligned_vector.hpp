@@ -0,0 +1,95 @@
+#ifndef STAN_IO_ALIGNED_VECTOR_HPP
+#define STAN_IO_ALIGNED_VECTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace stan {
+
+namespace io {
+
+/**
+ * Alignment in bytes of the values of variables stored by the
+ * <code>var_context</code> implementations, that of a cache line and
+ * of the widest SIMD registers.
+ */
+constexpr std::size_t data_alignment = 64;
+
+/**
+ * Allocator returning storage aligned to the specified number of bytes
+ * and padded to a multiple of it, so that the values of a variable can
+ * be mapped in place as an aligned <code>Eigen::Map</code> and a
+ * vectorized kernel may load whole registers past the last value
+ * without reading another allocation.  The padding is not initialized.
+ *
+ * @tparam T type of the values
+ * @tparam Alignment alignment in bytes, a power of two
+ */
+template <typename T, std::size_t Alignment = data_alignment>
+class aligned_allocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = aligned_allocator<U, Alignment>;
+  };
+
+  aligned_allocator() noexcept {}
+
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        ::operator new(padded_bytes(n), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, Alignment>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, Alignment>&) const noexcept {
+    return false;
+  }
+
+ private:
+  static std::size_t padded_bytes(std::size_t n) {
+    if (n > (SIZE_MAX - Alignment) / sizeof(T))
+      throw std::bad_array_new_length();
+    return (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+  }
+};
+
+/**
+ * Vector whose values are aligned and padded by
+ * <code>aligned_allocator</code>.
+ *
+ * @tparam T type of the values
+ */
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+/**
+ * Return <code>true</code> if the specified pointer is aligned to
+ * <code>data_alignment</code> bytes.
+ *
+ * @param p pointer
+ */
+inline bool is_data_aligned(const void* p) {
+  return reinterpret_cast<std::uintptr_t>(p) % data_alignment == 0;
+}
+
+}  // namespace io
+
+}  // namespace stan
+
+#endif
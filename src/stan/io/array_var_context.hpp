@@ -1,17 +1,18 @@
 #ifndef STAN_IO_ARRAY_VAR_CONTEXT_HPP
 #define STAN_IO_ARRAY_VAR_CONTEXT_HPP
 
+#include <stan/io/aligned_vector.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/io/validate_dims.hpp>
 #include <stan/math.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
-#include <map>
 #include <algorithm>
 #include <functional>
 #include <numeric>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -26,12 +27,14 @@ namespace io {
  */
 class array_var_context : public var_context {
  private:
-  // Pair used in data maps
+  // Pair used in data maps, with the values aligned and padded
   template <typename T>
-  using data_pair_t = std::pair<std::vector<T>, std::vector<size_t>>;
+  using data_pair_t = std::pair<aligned_vector<T>, std::vector<size_t>>;
 
-  std::map<std::string, data_pair_t<double>> vars_r_;  // Holds data for reals
-  std::map<std::string, data_pair_t<int>> vars_i_;     // Holds data for doubles
+  // Holds data for reals
+  std::unordered_map<std::string, data_pair_t<double>> vars_r_;
+  // Holds data for integers
+  std::unordered_map<std::string, data_pair_t<int>> vars_i_;
   // When search for variable name fails, return one these
   const std::vector<double> empty_vec_r_;
   const std::vector<int> empty_vec_i_;
@@ -277,7 +280,7 @@ class array_var_context : public var_context {
   std::vector<double> vals_r(const std::string& name) const {
     const auto ret_val_r = vars_r_.find(name);
     if (ret_val_r != vars_r_.end()) {
-      return ret_val_r->second.first;
+      return {ret_val_r->second.first.begin(), ret_val_r->second.first.end()};
     } else {
       const auto ret_val_i = vars_i_.find(name);
       if (ret_val_i != vars_i_.end()) {
@@ -287,6 +290,27 @@ class array_var_context : public var_context {
     return empty_vec_r_;
   }
 
+  /**
+   * Return a view of the double values for the variable with the
+   * specified name, which refers to the stored values unless the
+   * variable has integer values.
+   *
+   * @param name Name of variable.
+   * @return View of the values of the variable.
+   */
+  values_view<double> vals_r_view(const std::string& name) const {
+    const auto ret_val_r = vars_r_.find(name);
+    if (ret_val_r != vars_r_.end()) {
+      return values_view<double>(ret_val_r->second.first);
+    }
+    const auto ret_val_i = vars_i_.find(name);
+    if (ret_val_i != vars_i_.end()) {
+      return values_view<double>(aligned_vector<double>(
+          ret_val_i->second.first.begin(), ret_val_i->second.first.end()));
+    }
+    return values_view<double>();
+  }
+
   /**
    * Return the double values for the variable with the specified
    * name or null.
@@ -356,11 +380,26 @@ class array_var_context : public var_context {
   std::vector<int> vals_i(const std::string& name) const {
     auto ret_val_i = vars_i_.find(name);
     if (ret_val_i != vars_i_.end()) {
-      return ret_val_i->second.first;
+      return {ret_val_i->second.first.begin(), ret_val_i->second.first.end()};
     }
     return empty_vec_i_;
   }
 
+  /**
+   * Return a view of the stored integer values for the variable with
+   * the specified name.
+   *
+   * @param name Name of variable.
+   * @return View of the values.
+   */
+  values_view<int> vals_i_view(const std::string& name) const {
+    auto ret_val_i = vars_i_.find(name);
+    if (ret_val_i != vars_i_.end()) {
+      return values_view<int>(ret_val_i->second.first);
+    }
+    return values_view<int>();
+  }
+
   /**
    * Return the dimensions for the integer variable with the specified
    * name.
@@ -412,6 +451,7 @@ class array_var_context : public var_context {
     for (const auto& vars_r_iter : vars_r_) {
       names.push_back(vars_r_iter.first);
     }
+    std::sort(names.begin(), names.end());
   }
 
   /**
@@ -423,9 +463,10 @@ class array_var_context : public var_context {
   virtual void names_i(std::vector<std::string>& names) const {
     names.clear();
     names.reserve(vars_i_.size());
-    for (const auto& vars_i_iter : vars_r_) {
+    for (const auto& vars_i_iter : vars_i_) {
       names.push_back(vars_i_iter.first);
     }
+    std::sort(names.begin(), names.end());
   }
 
   /**
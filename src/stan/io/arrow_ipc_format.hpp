@@ -0,0 +1,405 @@
+#ifndef STAN_IO_ARROW_IPC_FORMAT_HPP
+#define STAN_IO_ARROW_IPC_FORMAT_HPP
+
+#include <stan/io/stan_binary_format.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Encoding of the Apache Arrow IPC streaming format written by
+ * `callbacks::arrow_ipc_writer`, without a dependency on Arrow; see
+ * https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format
+ *
+ * A stream is a sequence of encapsulated messages: the continuation
+ * marker `0xFFFFFFFF`, the byte length of the metadata as a 32-bit
+ * integer, the metadata, a `Message` flatbuffer padded to a multiple of
+ * eight bytes, then the body of the message.  The first message holds
+ * the schema, every following one a record batch, whose body holds the
+ * buffers of its columns, and the stream ends with the marker followed
+ * by a zero length.  All integers and doubles are little-endian.
+ *
+ * Only what the writer needs is encoded: non-nullable columns of
+ * 64-bit floats and 32-bit signed integers, without compression, and
+ * key-value custom metadata on the schema and on the messages.
+ */
+namespace arrow_ipc {
+
+/**
+ * Type ids of the `MessageHeader` union of `Message.fbs`.
+ */
+constexpr std::uint8_t schema_header = 1;
+constexpr std::uint8_t record_batch_header = 3;
+
+/**
+ * `MetadataVersion::V5` of `Schema.fbs`.
+ */
+constexpr std::uint16_t metadata_version = 4;
+
+/**
+ * Type ids of the `Type` union of `Schema.fbs` for the column types
+ * written.
+ */
+constexpr std::uint8_t int_type = 2;
+constexpr std::uint8_t floating_point_type = 3;
+
+/**
+ * `Precision::DOUBLE` of `Schema.fbs`.
+ */
+constexpr std::uint16_t double_precision = 2;
+
+/**
+ * Alignment of the messages and of the buffers in their bodies.
+ */
+constexpr std::size_t alignment = 8;
+
+/**
+ * Return the specified size rounded up to a multiple of the alignment.
+ */
+inline std::size_t padded(std::size_t size) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Builds a flatbuffer front to back.  A flatbuffer is usually built
+ * from its leaves, but the offsets to tables, vectors and strings only
+ * have to point forward, so writing every object before the objects it
+ * refers to and patching the offsets once they are written gives the
+ * same encoding.  Scalars are aligned to their size and tables to eight
+ * bytes from the start of the buffer.
+ */
+class flatbuffer_builder {
+ public:
+  /**
+   * A scalar or offset field of a table.
+   */
+  struct field {
+    /**
+     * Index of the field in the schema of its table; a union takes two,
+     * its type id and its offset.
+     */
+    int slot;
+
+    /**
+     * Size in bytes of the scalar, 4 for an offset.
+     */
+    std::size_t size;
+
+    /**
+     * Value of the scalar, ignored for an offset.
+     */
+    std::uint64_t value;
+
+    /**
+     * True if the field is an offset to be patched with set_offset.
+     */
+    bool is_offset;
+  };
+
+  /**
+   * Start a buffer with room for the offset to its root table.
+   */
+  flatbuffer_builder() : buf_(4, '\0') {}
+
+  /**
+   * Position of a table and of its offset fields.
+   */
+  struct table_ref {
+    std::size_t start;
+
+    /**
+     * Positions of the offset fields, indexed by slot
+     */
+    std::vector<std::size_t> offsets;
+  };
+
+  /**
+   * Write a table with the specified fields, preceded by its vtable.
+   *
+   * @param[in] fields fields of the table
+   * @return position of the table and of its offset fields
+   */
+  table_ref table(const std::vector<field>& fields) {
+    int num_slots = 0;
+    for (const field& f : fields)
+      num_slots = std::max(num_slots, f.slot + 1);
+    align(2);
+    const std::size_t vtable = buf_.size();
+    buf_.resize(vtable + 4 + 2 * num_slots, 0);
+    align(alignment);
+    table_ref ref{buf_.size(), std::vector<std::size_t>(num_slots, 0)};
+    put(0, 4);
+    for (const field& f : fields) {
+      align(f.size);
+      const std::size_t pos = buf_.size();
+      put(f.value, f.size);
+      set(vtable + 4 + 2 * f.slot, pos - ref.start, 2);
+      if (f.is_offset)
+        ref.offsets[f.slot] = pos;
+    }
+    set(vtable, 4 + 2 * num_slots, 2);
+    set(vtable + 2, buf_.size() - ref.start, 2);
+    set(ref.start, ref.start - vtable, 4);
+    if (root_ == 0)
+      root_ = ref.start;
+    return ref;
+  }
+
+  /**
+   * Write a vector of offsets, whose elements at positions 4, 8, ...
+   * after the vector are to be patched with set_offset.
+   *
+   * @param[in] size number of elements
+   * @return position of the length of the vector
+   */
+  std::size_t offset_vector(std::size_t size) {
+    align(4);
+    const std::size_t pos = buf_.size();
+    put(size, 4);
+    buf_.resize(pos + 4 + 4 * size, 0);
+    return pos;
+  }
+
+  /**
+   * Write a vector of structs of two 64-bit integers, such as the
+   * `FieldNode` and `Buffer` structs of a record batch.
+   *
+   * @param[in] values elements of the vector
+   * @return position of the length of the vector
+   */
+  std::size_t pair_vector(
+      const std::vector<std::pair<std::uint64_t, std::uint64_t>>& values) {
+    align(4);
+    if ((buf_.size() + 4) % alignment != 0)
+      put(0, 4);
+    const std::size_t pos = buf_.size();
+    put(values.size(), 4);
+    for (const auto& value : values) {
+      put(value.first, 8);
+      put(value.second, 8);
+    }
+    return pos;
+  }
+
+  /**
+   * Write a string.
+   *
+   * @param[in] value string
+   * @return position of the length of the string
+   */
+  std::size_t string(const std::string& value) {
+    align(4);
+    const std::size_t pos = buf_.size();
+    put(value.size(), 4);
+    buf_.insert(buf_.end(), value.begin(), value.end());
+    buf_.push_back(0);
+    return pos;
+  }
+
+  /**
+   * Set the offset at the specified position to point to the specified
+   * object, which must come after it.
+   *
+   * @param[in] at position of the offset
+   * @param[in] target position of the object
+   */
+  void set_offset(std::size_t at, std::size_t target) {
+    set(at, target - at, 4);
+  }
+
+  /**
+   * Return the buffer, with the first table written as its root,
+   * padded to the alignment.
+   */
+  std::string finish() {
+    set_offset(0, root_);
+    align(alignment);
+    return buf_;
+  }
+
+ private:
+  std::string buf_;
+  std::size_t root_ = 0;
+
+  void align(std::size_t size) {
+    buf_.resize((buf_.size() + size - 1) / size * size, 0);
+  }
+
+  void put(std::uint64_t value, std::size_t size) {
+    buf_.resize(buf_.size() + size);
+    set(buf_.size() - size, value, size);
+  }
+
+  void set(std::size_t at, std::uint64_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i)
+      buf_[at + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+};
+
+/**
+ * A column of a schema.
+ */
+struct column {
+  std::string name;
+
+  /**
+   * True for 32-bit signed integers, false for 64-bit floats.
+   */
+  bool is_int;
+};
+
+using key_value = std::pair<std::string, std::string>;
+
+namespace internal {
+/**
+ * Write a `[KeyValue]` vector and set the specified offset to it.
+ */
+inline void write_metadata(flatbuffer_builder& fb, std::size_t at,
+                           const std::vector<key_value>& metadata) {
+  const std::size_t vector = fb.offset_vector(metadata.size());
+  fb.set_offset(at, vector);
+  for (std::size_t i = 0; i < metadata.size(); ++i) {
+    auto kv = fb.table({{0, 4, 0, true}, {1, 4, 0, true}});
+    fb.set_offset(vector + 4 * (i + 1), kv.start);
+    fb.set_offset(kv.offsets[0], fb.string(metadata[i].first));
+    fb.set_offset(kv.offsets[1], fb.string(metadata[i].second));
+  }
+}
+
+/**
+ * Write a `Message` table with the specified header and body length,
+ * returning the position of the offset to the header.
+ */
+inline std::size_t write_message(flatbuffer_builder& fb,
+                                 std::uint8_t header_type,
+                                 std::uint64_t body_length,
+                                 const std::vector<key_value>& metadata) {
+  std::vector<flatbuffer_builder::field> fields{{0, 2, metadata_version, false},
+                                                {1, 1, header_type, false},
+                                                {2, 4, 0, true},
+                                                {3, 8, body_length, false}};
+  if (!metadata.empty())
+    fields.push_back({4, 4, 0, true});
+  auto message = fb.table(fields);
+  if (!metadata.empty())
+    write_metadata(fb, message.offsets[4], metadata);
+  return message.offsets[2];
+}
+}  // namespace internal
+
+/**
+ * Return the metadata of a schema message.
+ *
+ * @param[in] columns columns of the schema
+ * @param[in] metadata custom metadata of the schema
+ */
+inline std::string schema_message(const std::vector<column>& columns,
+                                  const std::vector<key_value>& metadata) {
+  flatbuffer_builder fb;
+  const std::size_t header
+      = internal::write_message(fb, schema_header, 0, {});
+  std::vector<flatbuffer_builder::field> schema_fields{{1, 4, 0, true}};
+  if (!metadata.empty())
+    schema_fields.push_back({2, 4, 0, true});
+  auto schema = fb.table(schema_fields);
+  fb.set_offset(header, schema.start);
+  const std::size_t vector = fb.offset_vector(columns.size());
+  fb.set_offset(schema.offsets[1], vector);
+  for (std::size_t i = 0; i < columns.size(); ++i) {
+    const std::uint8_t type_id
+        = columns[i].is_int ? int_type : floating_point_type;
+    auto field = fb.table({{0, 4, 0, true},
+                           {1, 1, 0, false},
+                           {2, 1, type_id, false},
+                           {3, 4, 0, true},
+                           {5, 4, 0, true}});
+    fb.set_offset(vector + 4 * (i + 1), field.start);
+    fb.set_offset(field.offsets[0], fb.string(columns[i].name));
+    // Int is 32-bit signed, FloatingPoint double precision
+    auto type = columns[i].is_int
+                    ? fb.table({{0, 4, 32, false}, {1, 1, 1, false}})
+                    : fb.table({{0, 2, double_precision, false}});
+    fb.set_offset(field.offsets[3], type.start);
+    fb.set_offset(field.offsets[5], fb.offset_vector(0));
+  }
+  if (!metadata.empty())
+    internal::write_metadata(fb, schema.offsets[2], metadata);
+  return fb.finish();
+}
+
+/**
+ * Return the metadata of a record batch message whose body holds, for
+ * every column, an empty validity buffer and a data buffer of the
+ * specified size, each data buffer padded to the alignment.
+ *
+ * @param[in] num_rows number of rows of the batch
+ * @param[in] buffer_sizes size in bytes of the data of each column
+ * @param[in] metadata custom metadata of the message
+ */
+inline std::string record_batch_message(
+    std::size_t num_rows, const std::vector<std::size_t>& buffer_sizes,
+    const std::vector<key_value>& metadata) {
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> nodes;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> buffers;
+  std::uint64_t body_length = 0;
+  for (std::size_t size : buffer_sizes) {
+    nodes.emplace_back(num_rows, 0);
+    buffers.emplace_back(body_length, 0);
+    buffers.emplace_back(body_length, size);
+    body_length += padded(size);
+  }
+  flatbuffer_builder fb;
+  const std::size_t header = internal::write_message(
+      fb, record_batch_header, body_length, metadata);
+  auto batch = fb.table(
+      {{0, 8, num_rows, false}, {1, 4, 0, true}, {2, 4, 0, true}});
+  fb.set_offset(header, batch.start);
+  fb.set_offset(batch.offsets[1], fb.pair_vector(nodes));
+  fb.set_offset(batch.offsets[2], fb.pair_vector(buffers));
+  return fb.finish();
+}
+
+/**
+ * Write the prefix and the metadata of a message; its body follows.
+ *
+ * @param[in, out] out stream to write to
+ * @param[in] metadata metadata, padded to the alignment
+ */
+inline void write_message(std::ostream& out, const std::string& metadata) {
+  binary_format::write_u32(out, 0xFFFFFFFF);
+  binary_format::write_u32(out, metadata.size());
+  out.write(metadata.data(), metadata.size());
+}
+
+/**
+ * Write the end of the stream.
+ *
+ * @param[in, out] out stream to write to
+ */
+inline void write_end_of_stream(std::ostream& out) {
+  binary_format::write_u32(out, 0xFFFFFFFF);
+  binary_format::write_u32(out, 0);
+}
+
+/**
+ * Write zeros padding a buffer of the specified size to the alignment.
+ *
+ * @param[in, out] out stream to write to
+ * @param[in] size size of the buffer written
+ */
+inline void write_padding(std::ostream& out, std::size_t size) {
+  static const char zeros[alignment] = {};
+  out.write(zeros, padded(size) - size);
+}
+
+}  // namespace arrow_ipc
+}  // namespace io
+}  // namespace stan
+#endif
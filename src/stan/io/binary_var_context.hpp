@@ -0,0 +1,368 @@
+#ifndef STAN_IO_BINARY_VAR_CONTEXT_HPP
+#define STAN_IO_BINARY_VAR_CONTEXT_HPP
+
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/io/validate_dims.hpp>
+#include <stan/io/values_view.hpp>
+#include <stan/io/var_context.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Layout of the binary data format read by
+ * `io::binary_var_context` and written by `io::write_binary_data`.
+ *
+ * A file starts with the four byte tag `SBD1` and the number of
+ * variables as an unsigned 32-bit integer, followed by the header of
+ * each variable:
+ *
+ * - the length of its name as an unsigned 32-bit integer followed by
+ *   the name's bytes,
+ * - its type as an unsigned 32-bit integer, `int_type` for 32-bit
+ *   integers or `real_type` for doubles,
+ * - its number of dimensions as an unsigned 32-bit integer followed by
+ *   the dimensions as unsigned 64-bit integers,
+ * - the offset of its values from the start of the file as an
+ *   unsigned 64-bit integer, which must be a multiple of 8.
+ *
+ * The values of each variable are stored contiguously in column-major
+ * order.  All integers and doubles are little-endian.  As in the other
+ * variable contexts, complex values are stored as real values with a
+ * last dimension of 2 and the slots of tuples as variables named after
+ * the tuple and the slot number, separated by a dot.
+ */
+namespace binary_data {
+
+constexpr char tag[binary_format::tag_size + 1] = "SBD1";
+constexpr std::uint32_t int_type = 0;
+constexpr std::uint32_t real_type = 1;
+constexpr std::size_t alignment = 8;
+
+}  // namespace binary_data
+
+/**
+ * A <code>binary_var_context</code> is a <code>var_context</code>
+ * reading the variables of a file in the binary data format.  The
+ * file is memory mapped and only its header is read on construction,
+ * so the values are read from the mapping when they are requested and
+ * the views of values of the stored types refer to the mapping
+ * without copying it.
+ *
+ * <p>The binary data format is little-endian, so it can only be read
+ * on little-endian platforms.
+ */
+class binary_var_context : public var_context {
+ private:
+  struct variable {
+    bool is_int;
+    std::vector<size_t> dims;
+    const char* data;
+    size_t size;
+  };
+
+  boost::interprocess::mapped_region region_;
+  std::map<std::string, variable> vars_;
+
+  static void error(const std::string& msg) {
+    throw std::invalid_argument("binary data: " + msg);
+  }
+
+  /**
+   * Read the header of the data and check that the values of every
+   * variable lie within the data.
+   *
+   * @param data pointer to the data, aligned to 8 bytes
+   * @param size number of bytes of data
+   * @throw std::invalid_argument if the header is ill formed
+   */
+  void read_header(const char* data, size_t size) {
+    if (!binary_format::host_is_little_endian())
+      error("only supported on little-endian platforms");
+    if (reinterpret_cast<std::uintptr_t>(data) % binary_data::alignment)
+      error("data must be aligned to 8 bytes");
+    size_t pos = 0;
+    auto read = [&](void* x, size_t n) {
+      if (size - pos < n)
+        error("unexpected end of header");
+      std::memcpy(x, data + pos, n);
+      pos += n;
+    };
+    auto read_u32 = [&]() {
+      std::uint32_t x;
+      read(&x, sizeof(x));
+      return x;
+    };
+    auto read_u64 = [&]() {
+      std::uint64_t x;
+      read(&x, sizeof(x));
+      return x;
+    };
+
+    char tag[binary_format::tag_size];
+    read(tag, binary_format::tag_size);
+    if (std::memcmp(tag, binary_data::tag, binary_format::tag_size) != 0)
+      error("missing SBD1 tag");
+    std::uint32_t num_vars = read_u32();
+    for (std::uint32_t k = 0; k < num_vars; ++k) {
+      std::uint32_t name_size = read_u32();
+      if (size - pos < name_size)
+        error("unexpected end of header");
+      std::string name(data + pos, name_size);
+      pos += name_size;
+      variable var;
+      std::uint32_t type = read_u32();
+      if (type != binary_data::int_type && type != binary_data::real_type)
+        error("unknown type of variable " + name);
+      var.is_int = type == binary_data::int_type;
+      std::uint32_t num_dims = read_u32();
+      var.size = 1;
+      for (std::uint32_t i = 0; i < num_dims; ++i) {
+        std::uint64_t dim = read_u64();
+        if (dim != 0 && var.size > SIZE_MAX / dim)
+          error("too many values in variable " + name);
+        var.dims.push_back(dim);
+        var.size *= dim;
+      }
+      std::uint64_t offset = read_u64();
+      size_t value_size = var.is_int ? sizeof(int) : sizeof(double);
+      if (offset % binary_data::alignment)
+        error("values of variable " + name + " are not aligned");
+      if (offset > size || var.size > (size - offset) / value_size)
+        error("values of variable " + name + " exceed the data");
+      var.data = data + offset;
+      if (!vars_.emplace(std::move(name), std::move(var)).second)
+        error("duplicate variable");
+    }
+  }
+
+  const variable* find(const std::string& name) const {
+    auto it = vars_.find(name);
+    return it == vars_.end() ? nullptr : &it->second;
+  }
+
+  static const int* int_data(const variable& var) {
+    return reinterpret_cast<const int*>(var.data);
+  }
+
+  static const double* real_data(const variable& var) {
+    return reinterpret_cast<const double*>(var.data);
+  }
+
+ public:
+  /**
+   * Construct a binary_var_context mapping the specified file.
+   *
+   * @param file_name name of the file in the binary data format
+   * @throw std::invalid_argument if the file cannot be mapped or its
+   * header is ill formed
+   */
+  explicit binary_var_context(const std::string& file_name) {
+    try {
+      boost::interprocess::file_mapping file(
+          file_name.c_str(), boost::interprocess::read_only);
+      boost::interprocess::mapped_region region(
+          file, boost::interprocess::read_only);
+      region_.swap(region);
+    } catch (const boost::interprocess::interprocess_exception& e) {
+      error("cannot map file " + file_name + ": " + e.what());
+    }
+    read_header(static_cast<const char*>(region_.get_address()),
+                region_.get_size());
+  }
+
+  /**
+   * Construct a binary_var_context reading the specified data in the
+   * binary data format, which must outlive the context.
+   *
+   * @param data pointer to the data, aligned to 8 bytes
+   * @param size number of bytes of data
+   * @throw std::invalid_argument if the header is ill formed
+   */
+  binary_var_context(const char* data, size_t size) { read_header(data, size); }
+
+  bool contains_r(const std::string& name) const {
+    return find(name) != nullptr;
+  }
+
+  bool contains_i(const std::string& name) const {
+    const variable* var = find(name);
+    return var != nullptr && var->is_int;
+  }
+
+  std::vector<double> vals_r(const std::string& name) const {
+    const variable* var = find(name);
+    if (var == nullptr)
+      return {};
+    if (var->is_int)
+      return std::vector<double>(int_data(*var), int_data(*var) + var->size);
+    return std::vector<double>(real_data(*var), real_data(*var) + var->size);
+  }
+
+  /**
+   * Return a view of the double values for the variable with the
+   * specified name, which refers to the mapped values unless the
+   * variable has integer values.
+   *
+   * @param name Name of variable.
+   * @return View of the values of the variable.
+   */
+  values_view<double> vals_r_view(const std::string& name) const {
+    const variable* var = find(name);
+    if (var == nullptr)
+      return values_view<double>();
+    if (var->is_int)
+      return values_view<double>(vals_r(name));
+    return values_view<double>(real_data(*var), var->size);
+  }
+
+  std::vector<std::complex<double>> vals_c(const std::string& name) const {
+    const variable* var = find(name);
+    if (var == nullptr || var->dims.empty())
+      return {};
+    std::vector<double> vals = vals_r(name);
+    size_t offset = vals.size() / 2;
+    std::vector<std::complex<double>> vals_c(offset);
+    for (size_t i = 0; i < offset; ++i)
+      vals_c[i] = std::complex<double>{vals[i], vals[i + offset]};
+    return vals_c;
+  }
+
+  std::vector<size_t> dims_r(const std::string& name) const {
+    const variable* var = find(name);
+    return var == nullptr ? std::vector<size_t>() : var->dims;
+  }
+
+  std::vector<int> vals_i(const std::string& name) const {
+    const variable* var = find(name);
+    if (var == nullptr || !var->is_int)
+      return {};
+    return std::vector<int>(int_data(*var), int_data(*var) + var->size);
+  }
+
+  /**
+   * Return a view of the mapped integer values for the variable with
+   * the specified name.
+   *
+   * @param name Name of variable.
+   * @return View of the values.
+   */
+  values_view<int> vals_i_view(const std::string& name) const {
+    const variable* var = find(name);
+    if (var == nullptr || !var->is_int)
+      return values_view<int>();
+    return values_view<int>(int_data(*var), var->size);
+  }
+
+  std::vector<size_t> dims_i(const std::string& name) const {
+    return contains_i(name) ? find(name)->dims : std::vector<size_t>();
+  }
+
+  void names_r(std::vector<std::string>& names) const {
+    names.clear();
+    for (const auto& var : vars_)
+      if (!var.second.is_int)
+        names.push_back(var.first);
+  }
+
+  void names_i(std::vector<std::string>& names) const {
+    names.clear();
+    for (const auto& var : vars_)
+      if (var.second.is_int)
+        names.push_back(var.first);
+  }
+
+  void validate_dims(const std::string& stage, const std::string& name,
+                     const std::string& base_type,
+                     const std::vector<size_t>& dims_declared) const {
+    size_t num_elts = 1;
+    for (auto& d : dims_declared) {
+      num_elts *= d;
+    }
+    if (num_elts == 0) {
+      return;
+    }
+    stan::io::validate_dims(*this, stage, name, base_type, dims_declared);
+  }
+};
+
+/**
+ * Write the variables of the specified context in the binary data
+ * format.
+ *
+ * @param[in, out] out stream to write to
+ * @param[in] context variables to write
+ */
+inline void write_binary_data(std::ostream& out, const var_context& context) {
+  std::vector<std::string> names_i;
+  std::vector<std::string> names_r;
+  context.names_i(names_i);
+  context.names_r(names_r);
+  std::map<std::string, bool> is_int;
+  for (const auto& name : names_r)
+    is_int[name] = context.contains_i(name);
+  for (const auto& name : names_i)
+    is_int[name] = context.contains_i(name);
+
+  auto padding = [](std::uint64_t n) {
+    return (binary_data::alignment - n % binary_data::alignment)
+           % binary_data::alignment;
+  };
+  std::uint64_t header_size = binary_format::tag_size + 4;
+  for (const auto& var : is_int)
+    header_size
+        += 4 + var.first.size() + 8 + 8 * context.dims_r(var.first).size() + 8;
+
+  out.write(binary_data::tag, binary_format::tag_size);
+  binary_format::write_u32(out, is_int.size());
+  std::uint64_t offset = header_size + padding(header_size);
+  for (const auto& var : is_int) {
+    binary_format::write_u32(out, var.first.size());
+    out.write(var.first.data(), var.first.size());
+    binary_format::write_u32(
+        out, var.second ? binary_data::int_type : binary_data::real_type);
+    std::vector<size_t> dims = context.dims_r(var.first);
+    binary_format::write_u32(out, dims.size());
+    std::uint64_t size = 1;
+    for (size_t d : dims) {
+      binary_format::write_u64(out, d);
+      size *= d;
+    }
+    binary_format::write_u64(out, offset);
+    size *= var.second ? 4 : 8;
+    offset += size + padding(size);
+  }
+
+  const char zeros[binary_data::alignment] = {0};
+  out.write(zeros, padding(header_size));
+  for (const auto& var : is_int) {
+    std::uint64_t size;
+    if (var.second) {
+      std::vector<int> vals = context.vals_i(var.first);
+      for (int x : vals)
+        binary_format::write_u32(out, static_cast<std::uint32_t>(x));
+      size = 4 * vals.size();
+    } else {
+      std::vector<double> vals = context.vals_r(var.first);
+      binary_format::write_doubles(out, vals.data(), vals.size());
+      size = 8 * vals.size();
+    }
+    out.write(zeros, padding(size));
+  }
+}
+
+}  // namespace io
+}  // namespace stan
+#endif
@@ -4,6 +4,7 @@
 #include <stan/io/var_context.hpp>
 #include <stan/io/validate_dims.hpp>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace stan {
@@ -12,42 +13,109 @@ namespace io {
 /**
  * A chained_var_context object represents two objects of var_context
  * as one.
+ *
+ * <p>The context holding each variable listed by the two contexts is
+ * resolved on construction, the first taking precedence, so that a
+ * lookup costs one probe of a hash table followed by the accessor of
+ * the resolved context, instead of a <code>contains</code> call on the
+ * first context before it.  Variables the contexts do not list are
+ * resolved with <code>contains</code> calls as they are requested.
+ * The contexts must not change after construction.
  */
 class chained_var_context : public var_context {
  private:
   const var_context& vc1_;
   const var_context& vc2_;
 
+  // Context holding each listed variable with real or integer values
+  std::unordered_map<std::string, const var_context*> resolved_r_;
+  std::unordered_map<std::string, const var_context*> resolved_i_;
+
+  void resolve_names(const var_context& vc) {
+    std::vector<std::string> names;
+    vc.names_r(names);
+    for (const std::string& name : names)
+      resolved_r_.emplace(name, &vc);
+    vc.names_i(names);
+    for (const std::string& name : names) {
+      resolved_r_.emplace(name, &vc);
+      resolved_i_.emplace(name, &vc);
+    }
+  }
+
  public:
   chained_var_context(const var_context& v1, const var_context& v2)
-      : vc1_(v1), vc2_(v2) {}
+      : vc1_(v1), vc2_(v2) {
+    resolve_names(vc1_);
+    resolve_names(vc2_);
+  }
+
+  /**
+   * Return the context holding the variable of the specified name with
+   * real or integer values, the first if it holds it and the second
+   * otherwise.  Callers making several calls for a variable, such as
+   * for its dimensions and values, may resolve it once.
+   *
+   * @param name Name of variable.
+   * @return Context of the variable.
+   */
+  const var_context& resolve_r(const std::string& name) const {
+    auto it = resolved_r_.find(name);
+    if (it != resolved_r_.end())
+      return *it->second;
+    return vc1_.contains_r(name) ? vc1_ : vc2_;
+  }
+
+  /**
+   * Return the context holding the variable of the specified name with
+   * integer values, the first if it holds it and the second otherwise.
+   *
+   * @param name Name of variable.
+   * @return Context of the variable.
+   */
+  const var_context& resolve_i(const std::string& name) const {
+    auto it = resolved_i_.find(name);
+    if (it != resolved_i_.end())
+      return *it->second;
+    return vc1_.contains_i(name) ? vc1_ : vc2_;
+  }
 
   bool contains_i(const std::string& name) const {
-    return vc1_.contains_i(name) || vc2_.contains_i(name);
+    return resolved_i_.count(name) > 0 || vc1_.contains_i(name)
+           || vc2_.contains_i(name);
   }
 
   bool contains_r(const std::string& name) const {
-    return vc1_.contains_r(name) || vc2_.contains_r(name);
+    return resolved_r_.count(name) > 0 || vc1_.contains_r(name)
+           || vc2_.contains_r(name);
   }
 
   std::vector<double> vals_r(const std::string& name) const {
-    return vc1_.contains_r(name) ? vc1_.vals_r(name) : vc2_.vals_r(name);
+    return resolve_r(name).vals_r(name);
+  }
+
+  values_view<double> vals_r_view(const std::string& name) const {
+    return resolve_r(name).vals_r_view(name);
   }
 
   std::vector<std::complex<double>> vals_c(const std::string& name) const {
-    return vc1_.contains_r(name) ? vc1_.vals_c(name) : vc2_.vals_c(name);
+    return resolve_r(name).vals_c(name);
   }
 
   std::vector<int> vals_i(const std::string& name) const {
-    return vc1_.contains_i(name) ? vc1_.vals_i(name) : vc2_.vals_i(name);
+    return resolve_i(name).vals_i(name);
+  }
+
+  values_view<int> vals_i_view(const std::string& name) const {
+    return resolve_i(name).vals_i_view(name);
   }
 
   std::vector<size_t> dims_r(const std::string& name) const {
-    return vc1_.contains_r(name) ? vc1_.dims_r(name) : vc2_.dims_r(name);
+    return resolve_r(name).dims_r(name);
   }
 
   std::vector<size_t> dims_i(const std::string& name) const {
-    return vc1_.contains_r(name) ? vc1_.dims_i(name) : vc2_.dims_i(name);
+    return resolve_i(name).dims_i(name);
   }
 
   void names_r(std::vector<std::string>& names) const {
@@ -0,0 +1,142 @@
+#ifndef STAN_IO_COMPACT_INT_VECTOR_HPP
+#define STAN_IO_COMPACT_INT_VECTOR_HPP
+
+#include <stan/io/aligned_vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace stan {
+
+namespace io {
+
+/**
+ * Integer values of a variable stored with 32, 16 or 8 bits each, so
+ * that large arrays of small integers, such as group indexes or
+ * counts, take a half or a quarter of the memory of <code>int</code>
+ * values.
+ *
+ * <p>The values are stored with 32 bits unless narrowed by
+ * <code>narrow</code>, which checks that every value fits the
+ * narrower type.  The storage is aligned and padded as by
+ * <code>aligned_allocator</code>.  Conversions to <code>int</code> or
+ * <code>double</code> vectors are made only when requested.
+ */
+class compact_int_vector {
+ public:
+  /**
+   * Construct an empty vector.
+   */
+  compact_int_vector() {}
+
+  /**
+   * Construct a vector holding the specified values with 32 bits each,
+   * without copying them.
+   *
+   * @param values values to hold
+   */
+  explicit compact_int_vector(aligned_vector<int>&& values)
+      : i32_(std::move(values)) {}
+
+  /**
+   * Store the values in the narrowest of 8, 16 or 32 bits each, but no
+   * fewer than the specified number of bits, which holds every value.
+   * The values are copied once if they are narrowed, and the wider
+   * storage released.
+   *
+   * @param min_bits smallest number of bits per value, 8 or 16 to allow
+   * narrowing to that width, 32 to keep <code>int</code> values
+   * @return the number of bits per value
+   */
+  int narrow(int min_bits = 8) {
+    if (bits_ != 32 || min_bits >= 32)
+      return bits_;
+    if (min_bits <= 8 && fits<std::int8_t>()) {
+      i8_.assign(i32_.begin(), i32_.end());
+      bits_ = 8;
+    } else if (min_bits <= 16 && fits<std::int16_t>()) {
+      i16_.assign(i32_.begin(), i32_.end());
+      bits_ = 16;
+    } else {
+      return bits_;
+    }
+    aligned_vector<int>().swap(i32_);
+    return bits_;
+  }
+
+  /**
+   * Return the number of bits of each stored value, 8, 16 or 32.
+   */
+  int bits() const { return bits_; }
+
+  /**
+   * Return the number of values.
+   */
+  std::size_t size() const {
+    return bits_ == 32 ? i32_.size() : bits_ == 16 ? i16_.size() : i8_.size();
+  }
+
+  /**
+   * Return the value at the specified index.
+   *
+   * @param n index
+   */
+  int operator[](std::size_t n) const {
+    return bits_ == 32 ? i32_[n] : bits_ == 16 ? i16_[n] : i8_[n];
+  }
+
+  /**
+   * Return the stored values if they are stored with 32 bits each and
+   * <code>nullptr</code> otherwise.
+   */
+  const aligned_vector<int>* ints() const {
+    return bits_ == 32 ? &i32_ : nullptr;
+  }
+
+  /**
+   * Return a copy of the values converted to the specified vector
+   * type, such as <code>std::vector<double></code>.
+   *
+   * @tparam V type of vector constructed from a range of iterators
+   */
+  template <typename V>
+  V to() const {
+    if (bits_ == 32)
+      return V(i32_.begin(), i32_.end());
+    if (bits_ == 16)
+      return V(i16_.begin(), i16_.end());
+    return V(i8_.begin(), i8_.end());
+  }
+
+  /**
+   * Return the number of bytes allocated to hold the values.
+   */
+  std::size_t bytes() const {
+    return i32_.capacity() * sizeof(int)
+           + i16_.capacity() * sizeof(std::int16_t)
+           + i8_.capacity() * sizeof(std::int8_t);
+  }
+
+ private:
+  template <typename T>
+  bool fits() const {
+    for (int x : i32_)
+      if (x < std::numeric_limits<T>::min()
+          || x > std::numeric_limits<T>::max())
+        return false;
+    return true;
+  }
+
+  int bits_{32};
+  aligned_vector<int> i32_;
+  aligned_vector<std::int16_t> i16_;
+  aligned_vector<std::int8_t> i8_;
+};
+
+}  // namespace io
+
+}  // namespace stan
+
+#endif
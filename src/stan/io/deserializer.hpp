@@ -2,6 +2,9 @@
 #define STAN_IO_DESERIALIZER_HPP
 
 #include <stan/math/rev.hpp>
+#include <algorithm>
+#include <array>
+#include <utility>
 
 namespace stan {
 
@@ -84,6 +87,27 @@ class deserializer {
   using is_fp_or_ad = bool_constant<std::is_floating_point<S>::value
                                     || is_autodiff<S>::value>;
 
+  template <typename S>
+  using is_var_matrix_array
+      = bool_constant<is_var<T>::value
+                      && is_var_matrix<value_type_t<S>>::value>;
+
+  /**
+   * Return an array of maps of `sizes...` each, the `I`-th starting
+   * `I * size` scalars after `data`.
+   * @tparam Ret The Eigen type of each element.
+   * @param data Pointer to the first scalar, or null if `size` is zero.
+   * @param size Number of scalars of each element.
+   * @param sizes The dimensions of each element.
+   */
+  template <typename Ret, size_t... I, typename... Sizes>
+  inline auto map_block(const T* data, size_t size, std::index_sequence<I...>,
+                        Sizes... sizes) {
+    using map_t = decltype(this->read<Ret>(sizes...));
+    return std::array<map_t, sizeof...(I)>{
+        map_t(data == nullptr ? nullptr : data + I * size, sizes...)...};
+  }
+
  public:
   using matrix_t = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
   using vector_t = Eigen::Matrix<T, Eigen::Dynamic, 1>;
@@ -327,7 +351,8 @@ class deserializer {
    */
   template <typename Ret, typename... Sizes,
             require_std_vector_t<Ret>* = nullptr,
-            require_not_same_t<value_type_t<Ret>, T>* = nullptr>
+            require_not_same_t<value_type_t<Ret>, T>* = nullptr,
+            require_not_t<is_var_matrix_array<Ret>>* = nullptr>
   inline auto read(Eigen::Index m, Sizes... dims) {
     if (unlikely(m == 0)) {
       return std::decay_t<Ret>();
@@ -341,6 +366,50 @@ class deserializer {
     }
   }
 
+  /**
+   * Return an `std::vector` of `var_value` matrices or vectors.  The
+   * scalars of all the elements are copied to the arena at once and the
+   * adjoints of all the elements are propagated back to them by a single
+   * reverse pass callback, instead of one copy and one callback per
+   * element.
+   * @tparam Ret The type to return.
+   * @tparam Sizes integral types.
+   * @param m The size of the vector.
+   * @param dims The dimensions of each element.
+   */
+  template <typename Ret, typename... Sizes,
+            require_std_vector_t<Ret>* = nullptr,
+            require_t<is_var_matrix_array<Ret>>* = nullptr>
+  inline auto read(Eigen::Index m, Sizes... dims) {
+    using stan::math::var;
+    using inner_t = value_type_t<value_type_t<Ret>>;
+    using var_map_t
+        = Eigen::Map<stan::math::promote_scalar_t<var, inner_t>>;
+    std::decay_t<Ret> ret_vec;
+    if (unlikely(m == 0)) {
+      return ret_vec;
+    }
+    const size_t size = (static_cast<size_t>(dims) * ... * 1);
+    check_r_capacity(m * size);
+    stan::math::arena_t<Eigen::Matrix<var, -1, 1>> vars
+        = map_r_.segment(pos_r_, m * size);
+    pos_r_ += m * size;
+    stan::math::arena_t<std::decay_t<Ret>> rets;
+    rets.reserve(m);
+    for (size_t i = 0; i < m; ++i) {
+      rets.emplace_back(var_map_t(vars.data() + i * size, dims...).val());
+    }
+    stan::math::reverse_pass_callback([vars, rets, size]() mutable {
+      for (size_t i = 0; i < rets.size(); ++i) {
+        var_map_t(vars.data() + i * size, rets[i].rows(), rets[i].cols())
+            .adj()
+            += rets[i].adj();
+      }
+    });
+    ret_vec.assign(rets.begin(), rets.end());
+    return ret_vec;
+  }
+
   /**
    * Return an `std::vector` of scalars
    * @tparam Ret The type to return.
@@ -362,6 +431,76 @@ class deserializer {
     }
   }
 
+  /**
+   * Return the next `N` scalars in a `std::array`.  There is one check
+   * that enough scalars are left for all of them, so generated code can
+   * read a run of scalar parameters with one call.
+   * @tparam Ret The type of each element.
+   * @tparam N The number of elements.
+   */
+  template <typename Ret, size_t N, require_t<is_fp_or_ad<Ret>>* = nullptr>
+  inline std::array<T, N> read_block() {
+    check_r_capacity(N);
+    std::array<T, N> ret;
+    std::copy_n(map_r_.data() + pos_r_, N, ret.begin());
+    pos_r_ += N;
+    return ret;
+  }
+
+  /**
+   * Return the next `N` complex scalars in a `std::array`, checking
+   * once that enough reals are left for all of them.
+   * @tparam Ret The type of each element.
+   * @tparam N The number of elements.
+   */
+  template <typename Ret, size_t N, require_complex_t<Ret>* = nullptr>
+  inline std::array<std::complex<T>, N> read_block() {
+    check_r_capacity(2 * N);
+    std::array<std::complex<T>, N> ret;
+    for (auto& z : ret) {
+      auto real = scalar_ptr_increment(1);
+      auto imag = scalar_ptr_increment(1);
+      z = std::complex<T>{real, imag};
+    }
+    return ret;
+  }
+
+  /**
+   * Return the next `N` integers in a `std::array`, checking once that
+   * enough integers are left for all of them.
+   * @tparam Ret The type of each element.
+   * @tparam N The number of elements.
+   */
+  template <typename Ret, size_t N, require_integral_t<Ret>* = nullptr>
+  inline std::array<int, N> read_block() {
+    check_i_capacity(N);
+    std::array<int, N> ret;
+    std::copy_n(map_i_.data() + pos_i_, N, ret.begin());
+    pos_i_ += N;
+    return ret;
+  }
+
+  /**
+   * Return the next `N` Eigen vectors or matrices of the same size in a
+   * `std::array` of maps, as returned by `read<Ret>(sizes...)`.  There
+   * is one check that enough scalars are left for all of them.
+   * @tparam Ret The Eigen type of each element.
+   * @tparam N The number of elements.
+   * @tparam Sizes A parameter pack of integral types.
+   * @param sizes The dimensions of each element.
+   */
+  template <typename Ret, size_t N, typename... Sizes,
+            require_eigen_t<Ret>* = nullptr,
+            require_not_vt_complex<Ret>* = nullptr>
+  inline auto read_block(Sizes... sizes) {
+    const size_t size = (static_cast<size_t>(sizes) * ... * 1);
+    check_r_capacity(N * size);
+    const T* data = size == 0 ? nullptr : map_r_.data() + pos_r_;
+    pos_r_ += N * size;
+    return map_block<Ret>(data, size, std::make_index_sequence<N>(),
+                          sizes...);
+  }
+
   /**
    * Return the next object transformed to have the specified
    * lower bound, possibly incrementing the specified reference with the
@@ -542,6 +681,43 @@ class deserializer {
     return ret;
   }
 
+  /**
+   * Return the next `vecsize` unit vectors as the columns of one matrix,
+   * incrementing the specified reference with the log absolute
+   * Jacobian determinant.  The unconstrained values are read as one
+   * block and transformed column by column into a single allocation.
+   * The values are the same as those of
+   * `read_constrain_unit_vector` with a `std::vector` return.
+   *
+   * @tparam Ret The type to return, a dynamic Eigen matrix.
+   * @tparam Jacobian Whether to increment the log of the absolute Jacobian
+   * determinant of the transform.
+   * @tparam LP Type of log probability.
+   * @param lp The reference to the variable holding the log
+   * probability to increment.
+   * @param vecsize The number of unit vectors.
+   * @param size The size of each unit vector.
+   * @return Matrix of `size` rows and `vecsize` columns, each column a
+   * unit vector.
+   * @throw std::invalid_argument if size is zero
+   */
+  template <typename Ret, bool Jacobian, typename LP,
+            require_eigen_matrix_dynamic_t<Ret>* = nullptr>
+  inline auto read_constrain_unit_vector_batch(LP& lp, const size_t vecsize,
+                                               const size_t size) {
+    using stan::math::unit_vector_constrain;
+    auto y = this->read<matrix_t>(size, vecsize);
+    matrix_t ret(size, vecsize);
+    for (size_t i = 0; i < vecsize; ++i) {
+      if (Jacobian) {
+        ret.col(i) = unit_vector_constrain(y.col(i), lp);
+      } else {
+        ret.col(i) = unit_vector_constrain(y.col(i));
+      }
+    }
+    return ret;
+  }
+
   /**
    * Return the next simplex of the specified size (using one fewer
    * unconstrained scalars), incrementing the specified reference with the
@@ -604,6 +780,43 @@ class deserializer {
     return ret;
   }
 
+  /**
+   * Return the next `vecsize` simplexes as the columns of one matrix,
+   * incrementing the specified reference with the log absolute
+   * Jacobian determinant.  The unconstrained values are read as one
+   * block and transformed column by column into a single allocation.
+   * The values are the same as those of
+   * `read_constrain_simplex` with a `std::vector` return.
+   *
+   * @tparam Ret The type to return, a dynamic Eigen matrix.
+   * @tparam Jacobian Whether to increment the log of the absolute Jacobian
+   * determinant of the transform.
+   * @tparam LP Type of log probability.
+   * @param lp The reference to the variable holding the log
+   * probability to increment.
+   * @param vecsize The number of simplexes.
+   * @param size The number of cells of each simplex.
+   * @return Matrix of `size` rows and `vecsize` columns, each column a simplex.
+   * @throws std::invalid_argument if size is zero
+   */
+  template <typename Ret, bool Jacobian, typename LP,
+            require_eigen_matrix_dynamic_t<Ret>* = nullptr>
+  inline auto read_constrain_simplex_batch(LP& lp, const size_t vecsize,
+                                           const size_t size) {
+    using stan::math::simplex_constrain;
+    stan::math::check_positive("read_simplex", "size", size);
+    auto y = this->read<matrix_t>(size - 1, vecsize);
+    matrix_t ret(size, vecsize);
+    for (size_t i = 0; i < vecsize; ++i) {
+      if (Jacobian) {
+        ret.col(i) = simplex_constrain(y.col(i), lp);
+      } else {
+        ret.col(i) = simplex_constrain(y.col(i));
+      }
+    }
+    return ret;
+  }
+
   /**
    * Return the next ordered vector of the specified
    * size, incrementing the specified reference with the log
@@ -664,6 +877,42 @@ class deserializer {
     return ret;
   }
 
+  /**
+   * Return the next `vecsize` ordered vectors as the columns of one
+   * matrix, incrementing the specified reference with the log absolute
+   * Jacobian determinant.  The unconstrained values are read as one
+   * block and transformed column by column into a single allocation.
+   * The values are the same as those of
+   * `read_constrain_ordered` with a `std::vector` return.
+   *
+   * @tparam Ret The type to return, a dynamic Eigen matrix.
+   * @tparam Jacobian Whether to increment the log of the absolute Jacobian
+   * determinant of the transform.
+   * @tparam LP Type of log probability.
+   * @param lp The reference to the variable holding the log
+   * probability to increment.
+   * @param vecsize The number of ordered vectors.
+   * @param size The size of each ordered vector.
+   * @return Matrix of `size` rows and `vecsize` columns, each column an
+   * ordered vector.
+   */
+  template <typename Ret, bool Jacobian, typename LP,
+            require_eigen_matrix_dynamic_t<Ret>* = nullptr>
+  inline auto read_constrain_ordered_batch(LP& lp, const size_t vecsize,
+                                           const size_t size) {
+    using stan::math::ordered_constrain;
+    auto y = this->read<matrix_t>(size, vecsize);
+    matrix_t ret(size, vecsize);
+    for (size_t i = 0; i < vecsize; ++i) {
+      if (Jacobian) {
+        ret.col(i) = ordered_constrain(y.col(i), lp);
+      } else {
+        ret.col(i) = ordered_constrain(y.col(i));
+      }
+    }
+    return ret;
+  }
+
   /**
    * Return the next positive_ordered vector of the specified
    * size, incrementing the specified reference with the log
@@ -857,6 +1106,45 @@ class deserializer {
     return ret;
   }
 
+  /**
+   * Return the next `vecsize` Cholesky factors for correlation matrices
+   * side by side in one matrix, incrementing the specified reference
+   * with the log absolute Jacobian determinant.  The unconstrained
+   * values are read as one block and transformed factor by factor into
+   * a single allocation.  The values are the same as those of
+   * `read_constrain_cholesky_factor_corr` with a `std::vector` return.
+   *
+   * @tparam Ret The type to return, a dynamic Eigen matrix.
+   * @tparam Jacobian Whether to increment the log of the absolute Jacobian
+   * determinant of the transform.
+   * @tparam LP Type of log probability.
+   * @param lp The reference to the variable holding the log
+   * probability to increment.
+   * @param vecsize The number of Cholesky factors.
+   * @param K The dimensionality of each factor.
+   * @return Matrix of `K` rows and `K * vecsize` columns, the `i`-th
+   * factor in columns `i * K` to `(i + 1) * K - 1`.
+   * @throw std::domain_error if a matrix is not a valid
+   *    Cholesky factor for a correlation matrix.
+   */
+  template <typename Ret, bool Jacobian, typename LP,
+            require_eigen_matrix_dynamic_t<Ret>* = nullptr>
+  inline auto read_constrain_cholesky_factor_corr_batch(LP& lp,
+                                                        const size_t vecsize,
+                                                        Eigen::Index K) {
+    using stan::math::cholesky_corr_constrain;
+    auto y = this->read<matrix_t>((K * (K - 1)) / 2, vecsize);
+    matrix_t ret(K, K * vecsize);
+    for (size_t i = 0; i < vecsize; ++i) {
+      if (Jacobian) {
+        ret.middleCols(i * K, K) = cholesky_corr_constrain(y.col(i), K, lp);
+      } else {
+        ret.middleCols(i * K, K) = cholesky_corr_constrain(y.col(i), K);
+      }
+    }
+    return ret;
+  }
+
   /**
    * Return the next covariance matrix of the specified dimensionality,
    * incrementing the specified reference with the log absolute Jacobian
@@ -0,0 +1,68 @@
+#ifndef STAN_IO_DRAWS_CHUNK_READER_HPP
+#define STAN_IO_DRAWS_CHUNK_READER_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Source of draws read a fixed number of rows at a time, so that the
+ * draws of a fit never need to be in memory all at once.  A reader
+ * keeps a selection of the columns of the draws, in the order they were
+ * requested.
+ */
+class draws_chunk_reader {
+ public:
+  virtual ~draws_chunk_reader() {}
+
+  /**
+   * Return the number of columns of every draw read.
+   */
+  virtual std::size_t num_columns() const = 0;
+
+  /**
+   * Read the next draws, up to the specified number, into the first
+   * rows of the specified matrix, which is resized to that number of
+   * rows and one column per selected column if it is not already.
+   *
+   * @param[in, out] chunk matrix holding the draws, one per row
+   * @param[in] max_rows maximum number of draws to read
+   * @return number of draws read, zero at the end of the draws
+   * @throw std::invalid_argument if the draws are malformed
+   */
+  virtual std::size_t read(Eigen::MatrixXd& chunk, std::size_t max_rows) = 0;
+
+ protected:
+  /**
+   * Return the indices in the header of the specified column names.
+   *
+   * @param[in] header names of the columns of the draws
+   * @param[in] names names of the columns to select
+   * @throw std::invalid_argument if a name is not in the header
+   */
+  static std::vector<std::size_t> select_columns(
+      const std::vector<std::string>& header,
+      const std::vector<std::string>& names) {
+    std::vector<std::size_t> selected;
+    selected.reserve(names.size());
+    for (const auto& name : names) {
+      std::size_t j = 0;
+      while (j < header.size() && header[j] != name)
+        ++j;
+      if (j == header.size())
+        throw std::invalid_argument("Column " + name
+                                    + " not found in the draws");
+      selected.push_back(j);
+    }
+    return selected;
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
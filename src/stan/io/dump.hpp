@@ -1,16 +1,22 @@
 #ifndef STAN_IO_DUMP_HPP
 #define STAN_IO_DUMP_HPP
 
+#include <stan/io/aligned_vector.hpp>
 #include <stan/io/validate_zero_buf.hpp>
 #include <stan/io/validate_dims.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/math/prim.hpp>
 #include <iostream>
 #include <limits>
-#include <map>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <cctype>
@@ -109,21 +115,35 @@ namespace io {
  */
 class dump_reader {
  private:
+  std::string text_;
+  size_t pos_;
   std::string buf_;
   std::string name_;
   std::vector<int> stack_i_;
   std::vector<double> stack_r_;
   std::vector<size_t> dims_;
-  std::istream& in_;
+  size_t size_hint_;
 
-  bool scan_single_char(char c_expected) {
-    int c = in_.peek();
-    if (in_.fail())
+  bool at_end() const { return pos_ >= text_.size(); }
+
+  void skip_space() {
+    while (pos_ < text_.size() && std::isspace(text_[pos_]))
+      ++pos_;
+  }
+
+  // reads the next non-space character
+  bool read_char(char& c) {
+    skip_space();
+    if (at_end())
       return false;
-    if (c != c_expected)
+    c = text_[pos_++];
+    return true;
+  }
+
+  bool scan_single_char(char c_expected) {
+    if (at_end() || text_[pos_] != c_expected)
       return false;
-    char c_skip;
-    in_.get(c_skip);
+    ++pos_;
     return true;
   }
 
@@ -137,30 +157,23 @@ class dump_reader {
   }
 
   bool scan_char(char c_expected) {
-    char c;
-    in_ >> c;
-    if (in_.fail())
-      return false;
-    if (c != c_expected) {
-      in_.putback(c);
-      return false;
-    }
-    return true;
+    skip_space();
+    return scan_single_char(c_expected);
   }
 
   bool scan_name_unquoted() {
     char c;
-    in_ >> c;
-    if (in_.fail())
+    if (!read_char(c))
       return false;
     if (!std::isalpha(c))
       return false;
     name_.push_back(c);
-    while (in_.get(c)) {  // get turns off auto space skip
+    while (!at_end()) {
+      c = text_[pos_];
       if (std::isalpha(c) || std::isdigit(c) || c == '_' || c == '.') {
         name_.push_back(c);
+        ++pos_;
       } else {
-        in_.putback(c);
         return true;
       }
     }
@@ -186,63 +199,41 @@ class dump_reader {
   }
 
   bool scan_chars(const char* s, bool case_sensitive = true) {
+    size_t start = pos_;
     for (size_t i = 0; s[i]; ++i) {
       char c;
-      if (!(in_ >> c)) {
-        for (size_t j = 1; j < i; ++j)
-          in_.putback(s[i - j]);
-        return false;
-      }
       // all ASCII, so toupper is OK
-      if ((case_sensitive && c != s[i])
+      if (!read_char(c) || (case_sensitive && c != s[i])
           || (!case_sensitive && ::toupper(c) != ::toupper(s[i]))) {
-        in_.putback(c);
-        for (size_t j = 1; j < i; ++j)
-          in_.putback(s[i - j]);
+        pos_ = start;
         return false;
       }
     }
     return true;
   }
 
-  bool scan_chars(std::string s, bool case_sensitive = true) {
-    for (size_t i = 0; i < s.size(); ++i) {
-      char c;
-      if (!(in_ >> c)) {
-        for (size_t j = 1; j < i; ++j)
-          in_.putback(s[i - j]);
-        return false;
-      }
-      // all ASCII, so toupper is OK
-      if ((case_sensitive && c != s[i])
-          || (!case_sensitive && ::toupper(c) != ::toupper(s[i]))) {
-        in_.putback(c);
-        for (size_t j = 1; j < i; ++j)
-          in_.putback(s[i - j]);
-        return false;
-      }
-    }
-    return true;
-  }
-
-  size_t scan_dim() {
-    char c;
+  // reads digits into buf_, skipping spaces
+  void scan_digits() {
     buf_.clear();
-    while (in_.get(c)) {
-      if (std::isspace(c))
-        continue;
-      if (std::isdigit(c)) {
+    while (!at_end()) {
+      char c = text_[pos_];
+      if (std::isspace(c)) {
+        ++pos_;
+      } else if (std::isdigit(c)) {
         buf_.push_back(c);
+        ++pos_;
       } else {
-        in_.putback(c);
         break;
       }
     }
+  }
+
+  size_t scan_dim() {
+    scan_digits();
     scan_optional_long();
     size_t d = 0;
-    try {
-      d = std::stoull(buf_);
-    } catch (const std::logic_error& e) {
+    if (std::from_chars(buf_.data(), buf_.data() + buf_.size(), d).ec
+        != std::errc()) {
       std::string msg = "value " + buf_ + " beyond array dimension range";
       throw std::invalid_argument(msg);
     }
@@ -250,94 +241,100 @@ class dump_reader {
   }
 
   int scan_int() {
-    char c;
-    buf_.clear();
-    while (in_.get(c)) {
-      if (std::isspace(c))
-        continue;
-      if (std::isdigit(c)) {
-        buf_.push_back(c);
-      } else {
-        in_.putback(c);
-        break;
-      }
-    }
-    return (get_int());
+    scan_digits();
+    return get_int(buf_.data(), buf_.data() + buf_.size());
   }
 
-  int get_int() {
-    int n = 0;
-    try {
-      n = std::stol(buf_);
-    } catch (const std::logic_error& e) {
-      std::string msg = "value " + buf_ + " beyond int range";
+  int get_int(const char* first, const char* last) {
+    long n = 0;  // NOLINT(runtime/int)
+    if (std::from_chars(first, last, n).ec != std::errc()) {
+      std::string msg = "value " + std::string(first, last)
+                        + " beyond int range";
       throw std::invalid_argument(msg);
     }
-    return n;
+    return static_cast<int>(n);
   }
 
-  double scan_double() {
+  double scan_double(const char* first, const char* last) {
+    // leading '+' is accepted as in strtod
+    const char* start = first != last && *first == '+' ? first + 1 : first;
     double x = 0;
     try {
-      x = std::stod(buf_);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+      auto res = std::from_chars(start, last, x);
+      const char* end = res.ptr;
+      bool ok = res.ec == std::errc();
+#else
+      buf_.assign(start, last);
+      char* end_buf;
+      errno = 0;
+      x = std::strtod(buf_.c_str(), &end_buf);
+      const char* end = start + (end_buf - buf_.c_str());
+      bool ok = errno != ERANGE;
+#endif
+      if (!ok || end == start)
+        throw std::invalid_argument("not a number");
       if (x == 0)
-        validate_zero_buf(buf_);
+        validate_zero_buf(std::string(first, last));
     } catch (const std::logic_error& e) {
-      std::string msg = "value " + buf_ + " beyond numeric range";
+      std::string msg = "value " + std::string(first, last)
+                        + " beyond numeric range";
       throw std::invalid_argument(msg);
     }
     return x;
   }
 
+  // moves the integers read into the real values
+  void promote_to_double() {
+    stack_r_.reserve(std::max(size_hint_, stack_i_.size() + 1));
+    stack_r_.insert(stack_r_.end(), stack_i_.begin(), stack_i_.end());
+    stack_i_.clear();
+  }
+
   // scan number stores number or throws bad lexical cast exception
   void scan_number(bool negate_val) {
     // must take longest first!
     if (scan_chars("Inf")) {
       scan_chars("inity");  // read past if there
+      if (stack_r_.empty())
+        promote_to_double();
       stack_r_.push_back(negate_val ? -std::numeric_limits<double>::infinity()
                                     : std::numeric_limits<double>::infinity());
       return;
     }
     if (scan_chars("NaN", false)) {
+      if (stack_r_.empty())
+        promote_to_double();
       stack_r_.push_back(std::numeric_limits<double>::quiet_NaN());
       return;
     }
 
-    char c;
+    // the number is scanned in place
     bool is_double = false;
-    buf_.clear();
-    while (in_.get(c)) {
-      if (std::isdigit(c)) {  // before pre-scan || c == '-' || c == '+') {
-        buf_.push_back(c);
-      } else if (c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+') {
+    const char* first = text_.data() + pos_;
+    while (!at_end()) {
+      char c = text_[pos_];
+      if (c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+')
         is_double = true;
-        buf_.push_back(c);
-      } else {
-        in_.putback(c);
+      else if (!std::isdigit(c))
         break;
-      }
+      ++pos_;
     }
+    const char* last = text_.data() + pos_;
     if (!is_double && stack_r_.size() == 0) {
-      int n = get_int();
+      int n = get_int(first, last);
       stack_i_.push_back(negate_val ? -n : n);
       scan_optional_long();
     } else {
-      for (size_t j = 0; j < stack_i_.size(); ++j)
-        stack_r_.push_back(static_cast<double>(stack_i_[j]));
-      stack_i_.clear();
-      double x = scan_double();
+      if (stack_r_.empty())
+        promote_to_double();
+      double x = scan_double(first, last);
       stack_r_.push_back(negate_val ? -x : x);
     }
   }
 
   void scan_number() {
-    char c;
-    while (in_.get(c)) {
-      if (std::isspace(c))
-        continue;
-      in_.putback(c);
-      break;
-    }
+    skip_space();
     bool negate_val = scan_char('-');
     if (!negate_val)
       scan_char('+');  // flush leading +
@@ -354,9 +351,7 @@ class dump_reader {
     int s = scan_int();
     if (s < 0)
       return false;
-    for (int i = 0; i < s; ++i) {
-      stack_i_.push_back(0);
-    }
+    stack_i_.assign(s, 0);
     if (!scan_char(')'))
       return false;
     dims_.push_back(s);
@@ -373,15 +368,35 @@ class dump_reader {
     int s = scan_int();
     if (s < 0)
       return false;
-    for (int i = 0; i < s; ++i) {
-      stack_r_.push_back(0);
-    }
+    stack_r_.assign(s, 0);
     if (!scan_char(')'))
       return false;
     dims_.push_back(s);
     return true;
   }
 
+  // reserves the values of the sequence starting at the current
+  // position, counted by its commas
+  void reserve_seq() {
+    size_t end = text_.find(')', pos_);
+    if (end == std::string::npos)
+      end = text_.size();
+    size_hint_ = 1 + std::count(text_.begin() + pos_, text_.begin() + end, ',');
+    stack_i_.reserve(size_hint_);
+  }
+
+  void push_range(int start, int end) {
+    std::int64_t span = static_cast<std::int64_t>(end) - start;
+    stack_i_.reserve(stack_i_.size() + (span < 0 ? -span : span) + 1);
+    if (start <= end) {
+      for (int i = start; i <= end; ++i)
+        stack_i_.push_back(i);
+    } else {
+      for (int i = start; i >= end; --i)
+        stack_i_.push_back(i);
+    }
+  }
+
   bool scan_seq_value() {
     if (!scan_char('('))
       return false;
@@ -389,6 +404,7 @@ class dump_reader {
       dims_.push_back(0U);
       return true;
     }
+    reserve_seq();
     scan_number();  // first entry
     while (scan_char(',')) {
       scan_number();
@@ -411,13 +427,7 @@ class dump_reader {
       if (!scan_char(':'))
         return false;
       int end = scan_int();
-      if (start <= end) {
-        for (int i = start; i <= end; ++i)
-          stack_i_.push_back(i);
-      } else {
-        for (int i = start; i >= end; --i)
-          stack_i_.push_back(i);
-      }
+      push_range(start, end);
     }
     dims_.clear();
     if (!scan_char(','))
@@ -477,13 +487,7 @@ class dump_reader {
     int start = stack_i_[0];
     int end = stack_i_[1];
     stack_i_.clear();
-    if (start <= end) {
-      for (int i = start; i <= end; ++i)
-        stack_i_.push_back(i);
-    } else {
-      for (int i = start; i >= end; --i)
-        stack_i_.push_back(i);
-    }
+    push_range(start, end);
     dims_.push_back(stack_i_.size());
     return true;
   }
@@ -494,7 +498,11 @@ class dump_reader {
    *
    * @param in Input stream reference from which to read.
    */
-  explicit dump_reader(std::istream& in) : in_(in) {}
+  explicit dump_reader(std::istream& in) : pos_(0), size_hint_(0) {
+    std::vector<char> buffer(1 << 16);
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0)
+      text_.append(buffer.data(), in.gcount());
+  }
 
   /**
    * Destroy this reader.
@@ -536,6 +544,14 @@ class dump_reader {
    */
   std::vector<int> int_values() { return stack_i_; }
 
+  /**
+   * Returns the integer values from the last item like
+   * <code>int_values()</code>, moving them out of the reader.
+   *
+   * @return Integer values of last item.
+   */
+  std::vector<int> take_int_values() { return std::move(stack_i_); }
+
   /**
    * Returns the floating point values from the last item if the
    * last item read contained floating point values and the empty
@@ -545,6 +561,14 @@ class dump_reader {
    */
   std::vector<double> double_values() { return stack_r_; }
 
+  /**
+   * Returns the floating point values from the last item like
+   * <code>double_values()</code>, moving them out of the reader.
+   *
+   * @return Floating point values of last item.
+   */
+  std::vector<double> take_double_values() { return std::move(stack_r_); }
+
   /**
    * Read the next value from the input stream, returning
    * <code>true</code> if successful and <code>false</code> if no
@@ -558,6 +582,7 @@ class dump_reader {
     stack_i_.clear();
     dims_.clear();
     name_.erase();
+    size_hint_ = 0;
     if (!scan_name())  // set name
       return false;
     if (!scan_char('<'))  // set <-
@@ -595,9 +620,12 @@ class dump_reader {
  */
 class dump : public stan::io::var_context {
  private:
-  std::map<std::string, std::pair<std::vector<double>, std::vector<size_t>>>
+  // values are aligned and padded for mapping in place
+  std::unordered_map<std::string,
+                     std::pair<aligned_vector<double>, std::vector<size_t>>>
       vars_r_;
-  std::map<std::string, std::pair<std::vector<int>, std::vector<size_t>>>
+  std::unordered_map<std::string,
+                     std::pair<aligned_vector<int>, std::vector<size_t>>>
       vars_i_;
   std::vector<double> const empty_vec_r_;
   std::vector<int> const empty_vec_i_;
@@ -627,14 +655,17 @@ class dump : public stan::io::var_context {
     dump_reader reader(in);
     while (reader.next()) {
       if (reader.is_int()) {
+        std::vector<int> values = reader.take_int_values();
         vars_i_[reader.name()]
-            = std::pair<std::vector<int>, std::vector<size_t>>(
-                reader.int_values(), reader.dims());
-
+            = std::pair<aligned_vector<int>, std::vector<size_t>>(
+                aligned_vector<int>(values.begin(), values.end()),
+                reader.dims());
       } else {
+        std::vector<double> values = reader.take_double_values();
         vars_r_[reader.name()]
-            = std::pair<std::vector<double>, std::vector<size_t>>(
-                reader.double_values(), reader.dims());
+            = std::pair<aligned_vector<double>, std::vector<size_t>>(
+                aligned_vector<double>(values.begin(), values.end()),
+                reader.dims());
       }
     }
   }
@@ -672,18 +703,36 @@ class dump : public stan::io::var_context {
    */
   std::vector<double> vals_r(const std::string& name) const {
     if (contains_r_only(name)) {
-      return (vars_r_.find(name)->second).first;
+      const auto& vec_r = (vars_r_.find(name)->second).first;
+      return std::vector<double>(vec_r.begin(), vec_r.end());
     } else if (contains_i(name)) {
-      std::vector<int> vec_int = (vars_i_.find(name)->second).first;
-      std::vector<double> vec_r(vec_int.size());
-      for (size_t ii = 0; ii < vec_int.size(); ii++) {
-        vec_r[ii] = vec_int[ii];
-      }
-      return vec_r;
+      const auto& vec_int = (vars_i_.find(name)->second).first;
+      return std::vector<double>(vec_int.begin(), vec_int.end());
     }
     return empty_vec_r_;
   }
 
+  /**
+   * Return a view of the double values for the variable with the
+   * specified name, which refers to the stored values unless the
+   * variable has integer values.
+   *
+   * @param name Name of variable.
+   * @return View of the values of the variable.
+   */
+  values_view<double> vals_r_view(const std::string& name) const {
+    auto val_r = vars_r_.find(name);
+    if (val_r != vars_r_.end()) {
+      return values_view<double>(val_r->second.first);
+    }
+    auto val_i = vars_i_.find(name);
+    if (val_i != vars_i_.end()) {
+      return values_view<double>(aligned_vector<double>(
+          val_i->second.first.begin(), val_i->second.first.end()));
+    }
+    return values_view<double>();
+  }
+
   std::vector<std::complex<double>> vals_c(const std::string& name) const {
     const auto val_r = vars_r_.find(name);
     if (val_r != vars_r_.end()) {
@@ -740,11 +789,27 @@ class dump : public stan::io::var_context {
    */
   std::vector<int> vals_i(const std::string& name) const {
     if (contains_i(name)) {
-      return (vars_i_.find(name)->second).first;
+      const auto& vec_i = (vars_i_.find(name)->second).first;
+      return std::vector<int>(vec_i.begin(), vec_i.end());
     }
     return empty_vec_i_;
   }
 
+  /**
+   * Return a view of the stored integer values for the variable with
+   * the specified name.
+   *
+   * @param name Name of variable.
+   * @return View of the values.
+   */
+  values_view<int> vals_i_view(const std::string& name) const {
+    auto val_i = vars_i_.find(name);
+    if (val_i != vars_i_.end()) {
+      return values_view<int>(val_i->second.first);
+    }
+    return values_view<int>();
+  }
+
   /**
    * Return the dimensions for the integer variable with the specified
    * name.
@@ -767,12 +832,9 @@ class dump : public stan::io::var_context {
    */
   virtual void names_r(std::vector<std::string>& names) const {
     names.resize(0);
-    for (std::map<std::string, std::pair<std::vector<double>,
-                                         std::vector<size_t>>>::const_iterator
-             it
-         = vars_r_.begin();
-         it != vars_r_.end(); ++it)
-      names.push_back((*it).first);
+    for (const auto& var : vars_r_)
+      names.push_back(var.first);
+    std::sort(names.begin(), names.end());
   }
 
   /**
@@ -783,12 +845,9 @@ class dump : public stan::io::var_context {
    */
   virtual void names_i(std::vector<std::string>& names) const {
     names.resize(0);
-    for (std::map<std::string, std::pair<std::vector<int>,
-                                         std::vector<size_t>>>::const_iterator
-             it
-         = vars_i_.begin();
-         it != vars_i_.end(); ++it)
-      names.push_back((*it).first);
+    for (const auto& var : vars_i_)
+      names.push_back(var.first);
+    std::sort(names.begin(), names.end());
   }
 
   /**
@@ -39,6 +39,16 @@ class empty_var_context : public var_context {
     return std::vector<double>();
   }
 
+  /**
+   * Always returns an empty view.
+   *
+   * @param name Name of variable.
+   * @return empty view
+   */
+  values_view<double> vals_r_view(const std::string& name) const {
+    return values_view<double>();
+  }
+
   std::vector<std::complex<double>> vals_c(const std::string& name) const {
     return std::vector<std::complex<double>>();
   }
@@ -72,6 +82,16 @@ class empty_var_context : public var_context {
     return std::vector<int>();
   }
 
+  /**
+   * Always returns an empty view.
+   *
+   * @param name Name of variable.
+   * @return empty view
+   */
+  values_view<int> vals_i_view(const std::string& name) const {
+    return values_view<int>();
+  }
+
   /**
    * Return the dimensions of the specified floating point variable.
    * Returns an empty vector.
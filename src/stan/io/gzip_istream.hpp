@@ -0,0 +1,159 @@
+#ifndef STAN_IO_GZIP_ISTREAM_HPP
+#define STAN_IO_GZIP_ISTREAM_HPP
+
+#include <zlib.h>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * <code>gzip_streambuf</code> is a stream buffer which decompresses
+ * gzip or zlib input read from another stream as it is consumed.
+ *
+ * Input made of several concatenated gzip members, such as that of
+ * <code>stan::callbacks::gzip_ostream</code>, is decompressed as a
+ * whole.  If the input is not compressed, is corrupt or is truncated,
+ * the buffer throws <code>std::runtime_error</code>, which sets the
+ * <code>badbit</code> of the stream reading from it.
+ */
+class gzip_streambuf : public std::streambuf {
+ public:
+  /**
+   * Construct a stream buffer decompressing the specified stream.
+   *
+   * @param[in, out] source stream holding the compressed input; must
+   *   outlive this buffer
+   * @param[in] buffer_size number of characters read and decompressed
+   *   at a time
+   */
+  explicit gzip_streambuf(std::istream& source,
+                          std::size_t buffer_size = 1 << 16)
+      : source_(source),
+        in_(buffer_size > 0 ? buffer_size : 1),
+        out_(buffer_size > 0 ? buffer_size : 1),
+        finished_(false) {
+    zstream_.zalloc = Z_NULL;
+    zstream_.zfree = Z_NULL;
+    zstream_.opaque = Z_NULL;
+    zstream_.next_in = Z_NULL;
+    zstream_.avail_in = 0;
+    // 15 + 32 selects the largest window and detects gzip or zlib headers
+    if (inflateInit2(&zstream_, 15 + 32) != Z_OK)
+      throw std::runtime_error("gzip_streambuf: initialization failed");
+    setg(out_.data(), out_.data(), out_.data());
+  }
+
+  ~gzip_streambuf() { inflateEnd(&zstream_); }
+
+  gzip_streambuf(const gzip_streambuf&) = delete;
+  gzip_streambuf& operator=(const gzip_streambuf&) = delete;
+
+ protected:
+  int_type underflow() {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    while (!finished_) {
+      if (zstream_.avail_in == 0 && !refill()) {
+        finished_ = true;
+        if (started_member_)
+          throw std::runtime_error("gzip_streambuf: truncated input");
+        break;
+      }
+      zstream_.next_out = reinterpret_cast<Bytef*>(out_.data());
+      zstream_.avail_out = static_cast<uInt>(out_.size());
+      int status = inflate(&zstream_, Z_NO_FLUSH);
+      started_member_ = true;
+      if (status == Z_STREAM_END) {
+        // another member may follow
+        inflateReset(&zstream_);
+        started_member_ = false;
+      } else if (status != Z_OK && status != Z_BUF_ERROR) {
+        finished_ = true;
+        throw std::runtime_error("gzip_streambuf: invalid compressed input");
+      }
+      std::size_t size = out_.size() - zstream_.avail_out;
+      if (size > 0) {
+        setg(out_.data(), out_.data(), out_.data() + size);
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+    return traits_type::eof();
+  }
+
+ private:
+  /**
+   * Read more compressed input from the source.
+   *
+   * @return false at the end of the source
+   */
+  bool refill() {
+    source_.read(in_.data(), in_.size());
+    std::streamsize count = source_.gcount();
+    zstream_.next_in = reinterpret_cast<Bytef*>(in_.data());
+    zstream_.avail_in = static_cast<uInt>(count);
+    return count > 0;
+  }
+
+  std::istream& source_;
+  std::vector<char> in_;
+  std::vector<char> out_;
+  z_stream zstream_;
+  bool finished_;
+
+  /**
+   * True once part of a member has been decompressed and until its
+   * end is reached.
+   */
+  bool started_member_{false};
+};
+
+/**
+ * <code>gzip_istream</code> is an input stream decompressing gzip input
+ * read from a file or another stream through a
+ * <code>gzip_streambuf</code>, so that compressed output can be read
+ * back, e.g. with <code>stan_csv_reader</code>, without decompressing
+ * it first.
+ */
+class gzip_istream : public std::istream {
+ public:
+  /**
+   * Construct a stream decompressing the specified stream.
+   *
+   * @param[in, out] source stream holding the compressed input; must
+   *   outlive this stream
+   */
+  explicit gzip_istream(std::istream& source)
+      : std::istream(nullptr), buf_(new gzip_streambuf(source)) {
+    rdbuf(buf_.get());
+  }
+
+  /**
+   * Construct a stream decompressing the specified stream, which it
+   * owns.
+   *
+   * @param[in] source stream holding the compressed input
+   */
+  explicit gzip_istream(std::unique_ptr<std::istream>&& source)
+      : std::istream(nullptr),
+        source_(std::move(source)),
+        buf_(new gzip_streambuf(*source_)) {
+    rdbuf(buf_.get());
+  }
+
+  ~gzip_istream() { buf_.reset(); }
+
+ private:
+  std::unique_ptr<std::istream> source_;
+  std::unique_ptr<gzip_streambuf> buf_;
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
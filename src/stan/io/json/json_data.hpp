@@ -1,13 +1,15 @@
 #ifndef STAN_IO_JSON_JSON_DATA_HPP
 #define STAN_IO_JSON_JSON_DATA_HPP
 
+#include <stan/io/compact_int_vector.hpp>
 #include <stan/io/json/json_data_handler.hpp>
 #include <stan/io/json/json_error.hpp>
+#include <stan/io/json/rapidjson_parallel_parser.hpp>
 #include <stan/io/json/rapidjson_parser.hpp>
 #include <stan/io/var_context.hpp>
 #include <iostream>
 #include <limits>
-#include <map>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -38,11 +40,18 @@ namespace json {
  * <p><code>json_data</code> objects are created by using the
  * <code>json_parser</code> and a <code>json_data_handler</code>
  * to read a single JSON text from an input stream.
+ *
+ * <p>Integer arrays are stored with 32 bits per value, or fewer after
+ * <code>compact_ints</code>, and converted to double values only when
+ * these are requested.  The memory held by a variable is returned by
+ * <code>memory_bytes</code>.
  */
 class json_data : public stan::io::var_context {
  private:
   vars_map_r vars_r_;
-  vars_map_i vars_i_;
+  std::unordered_map<std::string,
+                     std::pair<io::compact_int_vector, std::vector<size_t>>>
+      vars_i_;
 
   std::vector<double> const empty_vec_r_;
   std::vector<int> const empty_vec_i_;
@@ -61,6 +70,20 @@ class json_data : public stan::io::var_context {
     return vars_r_.find(name) != vars_r_.end();
   }
 
+  /**
+   * Move the integer variables read by the handler into the compact
+   * storage, without copying their values.
+   *
+   * @param vars_i integer variables read by the handler
+   */
+  void store_ints(vars_map_i &vars_i) {
+    for (auto &var : vars_i)
+      vars_i_.emplace(var.first,
+                      std::make_pair(io::compact_int_vector(
+                                         std::move(var.second.first)),
+                                     std::move(var.second.second)));
+  }
+
  public:
   /**
    * Construct a json_data object from the specified input stream.
@@ -71,8 +94,79 @@ class json_data : public stan::io::var_context {
    * @throws json_exception if data is not well-formed stan data declaration
    */
   explicit json_data(std::istream &in) : vars_r_(), vars_i_() {
-    json_data_handler handler(vars_r_, vars_i_);
+    vars_map_i vars_i;
+    json_data_handler handler(vars_r_, vars_i);
     rapidjson_parse(in, handler);
+    store_ints(vars_i);
+  }
+
+  /**
+   * Construct a json_data object from the specified input stream,
+   * parsing the numbers of large arrays in parallel if specified.  The
+   * parallel parse reads the whole text into memory and yields the
+   * same variables as the serial one.
+   *
+   * <b>Warning:</b> This method does not close the input stream.
+   *
+   * @param in Input stream from which to read.
+   * @param parallel true to parse large arrays in parallel
+   * @throws json_exception if data is not well-formed stan data declaration
+   */
+  json_data(std::istream &in, bool parallel) : vars_r_(), vars_i_() {
+    vars_map_i vars_i;
+    json_data_handler handler(vars_r_, vars_i);
+    if (parallel)
+      rapidjson_parse_parallel(in, handler);
+    else
+      rapidjson_parse(in, handler);
+    store_ints(vars_i);
+  }
+
+  /**
+   * Store the values of each integer variable with the fewest of 8, 16
+   * or 32 bits, but no fewer than the specified number, which hold all
+   * of its values.  Views of narrowed variables from
+   * <code>vals_i_view</code> own a converted copy of the values.
+   *
+   * @param min_bits smallest number of bits per value, 8 or 16
+   */
+  void compact_ints(int min_bits = 8) {
+    for (auto &var : vars_i_)
+      var.second.first.narrow(min_bits);
+  }
+
+  /**
+   * Return the number of bits per value of the integer variable with
+   * the specified name, 8, 16 or 32, or zero if there is none.
+   *
+   * @param name Name of variable.
+   * @return Bits per value.
+   */
+  int int_bits(const std::string &name) const {
+    auto val_i = vars_i_.find(name);
+    return val_i == vars_i_.end() ? 0 : val_i->second.first.bits();
+  }
+
+  /**
+   * Return the number of bytes allocated to hold the values and the
+   * dimensions of the variable with the specified name, or zero if
+   * there is none.
+   *
+   * @param name Name of variable.
+   * @return Bytes held by the variable.
+   */
+  size_t memory_bytes(const std::string &name) const {
+    auto val_r = vars_r_.find(name);
+    if (val_r != vars_r_.end()) {
+      return val_r->second.first.capacity() * sizeof(double)
+             + val_r->second.second.capacity() * sizeof(size_t);
+    }
+    auto val_i = vars_i_.find(name);
+    if (val_i != vars_i_.end()) {
+      return val_i->second.first.bytes()
+             + val_i->second.second.capacity() * sizeof(size_t);
+    }
+    return 0;
   }
 
   /**
@@ -108,18 +202,35 @@ class json_data : public stan::io::var_context {
    */
   std::vector<double> vals_r(const std::string &name) const {
     if (contains_r_only(name)) {
-      return (vars_r_.find(name)->second).first;
+      const auto &vec_r = (vars_r_.find(name)->second).first;
+      return std::vector<double>(vec_r.begin(), vec_r.end());
     } else if (contains_i(name)) {
-      std::vector<int> vec_int = (vars_i_.find(name)->second).first;
-      std::vector<double> vec_r(vec_int.size());
-      for (size_t ii = 0; ii < vec_int.size(); ii++) {
-        vec_r[ii] = vec_int[ii];
-      }
-      return vec_r;
+      return (vars_i_.find(name)->second).first.to<std::vector<double>>();
     }
     return empty_vec_r_;
   }
 
+  /**
+   * Return a view of the double values for the variable with the
+   * specified name, which refers to the stored values unless the
+   * variable has integer values.
+   *
+   * @param name Name of variable.
+   * @return View of the values of the variable.
+   */
+  stan::io::values_view<double> vals_r_view(const std::string &name) const {
+    auto val_r = vars_r_.find(name);
+    if (val_r != vars_r_.end()) {
+      return stan::io::values_view<double>(val_r->second.first);
+    }
+    auto val_i = vars_i_.find(name);
+    if (val_i != vars_i_.end()) {
+      return stan::io::values_view<double>(
+          val_i->second.first.to<stan::io::aligned_vector<double>>());
+    }
+    return stan::io::values_view<double>();
+  }
+
   /**
    * Read out the complex values for the variable with the specified
    * name and return a flat vector of complex values.
@@ -184,11 +295,31 @@ class json_data : public stan::io::var_context {
    */
   std::vector<int> vals_i(const std::string &name) const {
     if (contains_i(name)) {
-      return (vars_i_.find(name)->second).first;
+      return (vars_i_.find(name)->second).first.to<std::vector<int>>();
     }
     return empty_vec_i_;
   }
 
+  /**
+   * Return a view of the integer values for the variable with the
+   * specified name, which refers to the stored values unless they have
+   * been narrowed by <code>compact_ints</code>.
+   *
+   * @param name Name of variable.
+   * @return View of the values.
+   */
+  stan::io::values_view<int> vals_i_view(const std::string &name) const {
+    auto val_i = vars_i_.find(name);
+    if (val_i != vars_i_.end()) {
+      const auto *ints = val_i->second.first.ints();
+      if (ints)
+        return stan::io::values_view<int>(*ints);
+      return stan::io::values_view<int>(
+          val_i->second.first.to<stan::io::aligned_vector<int>>());
+    }
+    return stan::io::values_view<int>();
+  }
+
   /**
    * Return the dimensions for the integer variable with the specified
    * name.
@@ -214,6 +345,7 @@ class json_data : public stan::io::var_context {
     for (vars_map_r::const_iterator it = vars_r_.begin(); it != vars_r_.end();
          ++it)
       names.push_back((*it).first);
+    std::sort(names.begin(), names.end());
   }
 
   /**
@@ -224,9 +356,9 @@ class json_data : public stan::io::var_context {
    */
   virtual void names_i(std::vector<std::string> &names) const {
     names.resize(0);
-    for (vars_map_i::const_iterator it = vars_i_.begin(); it != vars_i_.end();
-         ++it)
+    for (auto it = vars_i_.begin(); it != vars_i_.end(); ++it)
       names.push_back((*it).first);
+    std::sort(names.begin(), names.end());
   }
 
   /**
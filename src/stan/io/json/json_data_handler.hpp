@@ -1,6 +1,7 @@
 #ifndef STAN_IO_JSON_JSON_DATA_HANDLER_HPP
 #define STAN_IO_JSON_JSON_DATA_HANDLER_HPP
 
+#include <stan/io/aligned_vector.hpp>
 #include <stan/io/json/json_error.hpp>
 #include <stan/io/json/json_handler.hpp>
 #include <stan/io/json/rapidjson_parser.hpp>
@@ -9,10 +10,10 @@
 #include <iostream>
 #include <ostream>
 #include <limits>
-#include <map>
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <boost/algorithm/string.hpp>
@@ -22,11 +23,11 @@ namespace stan {
 
 namespace json {
 
-typedef std::pair<std::vector<double>, std::vector<size_t>> var_r;
-typedef std::pair<std::vector<int>, std::vector<size_t>> var_i;
+typedef std::pair<io::aligned_vector<double>, std::vector<size_t>> var_r;
+typedef std::pair<io::aligned_vector<int>, std::vector<size_t>> var_i;
 
-typedef std::map<std::string, var_r> vars_map_r;
-typedef std::map<std::string, var_i> vars_map_i;
+typedef std::unordered_map<std::string, var_r> vars_map_r;
+typedef std::unordered_map<std::string, var_i> vars_map_i;
 
 /** Enum of the kinds of structures the handler needs to manage.
  *  Determined by the initial sequence of start elements following
@@ -116,6 +117,10 @@ class tuple_slots {
  * are of the same shape.  To do this we track the number of slots in the tuple
  * as well as the dimensions of any array slots in the tuple.
  *
+ * The slots are indexed by their dotted names, e.g. "x.1.2", in hash
+ * maps.  The dotted name of the current slot is maintained as keys are
+ * pushed and popped, so it is not rebuilt for every event.
+ *
  * If the top-level object entry key is not a legal Stan variable name
  * the handler will not check the corresponding value, other than maintining
  * the event state and key_stack.
@@ -125,13 +130,17 @@ class json_data_handler : public stan::json::json_handler {
   vars_map_r& vars_r;
   vars_map_i& vars_i;
   std::vector<std::string> key_stack;
-  std::map<std::string, int> var_types_map;   // vars_r and vars_i entries
-  std::map<std::string, int> slot_types_map;  // all slots all vars parsed
-  std::map<std::string, array_dims> slot_dims_map;
-  std::map<std::string, tuple_slots> tuple_slots_map;
-  std::map<std::string, bool> int_slots_map;
-  std::vector<double> values_r;  // accumulates real var values
-  std::vector<int> values_i;     // accumulates int var values
+  std::string key_;                // key_stack joined by "."
+  std::vector<size_t> key_ends_;   // length of key_ for each key_stack prefix
+  std::unordered_map<std::string, int> var_types_map;   // vars_r and vars_i
+  std::unordered_map<std::string, int> slot_types_map;  // all slots parsed
+  std::unordered_map<std::string, array_dims> slot_dims_map;
+  std::unordered_map<std::string, tuple_slots> tuple_slots_map;
+  std::unordered_map<std::string, bool> int_slots_map;
+  bool* int_slot_;               // int_slots_map entry of key_, if looked up
+  // accumulate the values of the current var
+  io::aligned_vector<double> values_r;
+  io::aligned_vector<int> values_i;
   size_t array_start_i;          // index into values_i
   size_t array_start_r;          // index into values_r
   int event;                     // tracks most recent meta_event
@@ -146,18 +155,43 @@ class json_data_handler : public stan::json::json_handler {
     array_start_r = 0;
   }
 
-  inline std::string key_str() {
-    return boost::algorithm::join(key_stack, ".");
+  void push_key(const std::string& key) {
+    if (!key_stack.empty())
+      key_.push_back('.');
+    key_.append(key);
+    key_stack.push_back(key);
+    key_ends_.push_back(key_.size());
+    int_slot_ = nullptr;
+  }
+
+  void pop_key() {
+    key_stack.pop_back();
+    key_ends_.pop_back();
+    key_.resize(key_ends_.empty() ? 0 : key_ends_.back());
+    int_slot_ = nullptr;
+  }
+
+  /** Return the int_slots_map entry of the current slot, which is only
+   *  looked up once per key.
+   */
+  bool& is_int_slot() {
+    if (int_slot_ == nullptr)
+      int_slot_ = &int_slots_map[key_];
+    return *int_slot_;
+  }
+
+  /** Return the dotted name of the first n keys of the key stack.
+   */
+  std::string key_prefix(size_t n) const {
+    return n == 0 ? std::string() : key_.substr(0, key_ends_[n - 1]);
   }
 
+  inline const std::string& key_str() const { return key_; }
+
   std::string outer_key_str() {
     std::string result;
-    if (key_stack.size() > 1) {
-      std::string slot = key_stack.back();
-      key_stack.pop_back();
-      result = key_str();
-      key_stack.push_back(slot);
-    }
+    if (key_stack.size() > 1)
+      result = key_prefix(key_stack.size() - 1);
     return result;
   }
 
@@ -176,55 +210,33 @@ class json_data_handler : public stan::json::json_handler {
     return boost::regex_match(name, re);
   }
 
-  bool is_array_tuples(const std::vector<std::string>& keys) {
-    std::vector<std::string> stack(keys);
-    std::string key;
-    stack.pop_back();
-    while (!stack.empty()) {
-      key = boost::algorithm::join(stack, ".");
-      if (slot_types_map[key] == meta_type::ARRAY_OF_TUPLES)
-        return true;
-      stack.pop_back();
+  array_dims get_outer_dims() {
+    for (size_t n = key_stack.size() - 1; n > 0; --n) {
+      auto dims = slot_dims_map.find(key_prefix(n));
+      if (dims != slot_dims_map.end())
+        return dims->second;
     }
-    return false;
+    auto dims = slot_dims_map.find(key_str());
+    if (dims == slot_dims_map.end())
+      unexpected_error(key_str(), "not an array");
+    return dims->second;
   }
 
-  array_dims get_outer_dims(const std::vector<std::string>& keys) {
-    std::vector<std::string> stack(keys);
-    std::string key;
-    stack.pop_back();
-    while (!stack.empty()) {
-      key = boost::algorithm::join(stack, ".");
-      if (slot_dims_map.count(key) == 1)
-        return slot_dims_map[key];
-      stack.pop_back();
-    }
-    key = boost::algorithm::join(keys, ".");
-    if (slot_dims_map.count(key) != 1)
-      unexpected_error(key, "not an array");
-    return slot_dims_map[key];
-  }
-
-  void set_outer_dims(array_dims update) {
-    std::vector<std::string> stack = key_stack;
-    std::string key;
-    stack.pop_back();
-    while (!stack.empty()) {
-      key = boost::algorithm::join(stack, ".");
-      if (slot_dims_map.count(key) == 1)
-        break;
-      stack.pop_back();
-    }
-    if (stack.empty()) {
-      key = boost::algorithm::join(key_stack, ".");
-      unexpected_error(key, "ill-formed array");
+  void set_outer_dims(const array_dims& update) {
+    for (size_t n = key_stack.size() - 1; n > 0; --n) {
+      auto dims = slot_dims_map.find(key_prefix(n));
+      if (dims != slot_dims_map.end()) {
+        dims->second = update;
+        return;
+      }
     }
-    slot_dims_map[key] = update;
+    unexpected_error(key_str(), "ill-formed array");
   }
 
   void promote_to_double() {
-    if (int_slots_map[key_str()]) {
-      int_slots_map[key_str()] = false;
+    bool& is_int = is_int_slot();
+    if (is_int) {
+      is_int = false;
       values_r.reserve(values_i.size());
       values_r.insert(values_r.end(), values_i.begin(), values_i.end());
       array_start_r = array_start_i;
@@ -234,7 +246,8 @@ class json_data_handler : public stan::json::json_handler {
   }
 
   /* Save non-tuple vars and innermost tuple slots to vars_i and vars_r.
-   * Converts multi-dim arrays from row-major to column major.
+   * Converts multi-dim arrays from row-major to column major in place
+   * and moves the values of new variables into the maps.
    * For arrays of tuples we need to check that new elements are consistent
    * with previous tuple elements.
    */
@@ -242,53 +255,47 @@ class json_data_handler : public stan::json::json_handler {
     if (key_stack.empty())
       return;
     if (not_stan_var) {
-      key_stack.pop_back();
+      pop_key();
       return;
     }
-    std::string key = key_str();
-    if (slot_types_map.count(key) < 1)
+    const std::string& key = key_str();
+    auto slot_type = slot_types_map.find(key);
+    if (slot_type == slot_types_map.end())
       unexpected_error(key, "unknown variable");
-    if (slot_types_map[key] == meta_type::SCALAR
-        || slot_types_map[key] == meta_type::ARRAY) {
-      bool is_new = (vars_r.count(key) == 0 && vars_i.count(key) == 0);
-      bool is_int = int_slots_map[key];
+    if (slot_type->second == meta_type::SCALAR
+        || slot_type->second == meta_type::ARRAY) {
       bool is_real = vars_r.count(key) == 1;
-      bool was_int = !is_int && vars_i.count(key) == 1;
+      bool has_int = vars_i.count(key) == 1;
+      bool is_new = !is_real && !has_int;
+      bool is_int = is_int_slot();
+      bool was_int = !is_int && has_int;
       std::vector<size_t> dims;
-      if (slot_dims_map.count(key) == 1)
-        dims = slot_dims_map[key].dims;
+      auto slot_dims = slot_dims_map.find(key);
+      if (slot_dims != slot_dims_map.end())
+        dims = slot_dims->second.dims;
       if (dims.size() > 1) {
         if (is_int) {
-          std::vector<int> cm_values_i(values_i.size());
-          to_column_major(key, cm_values_i, values_i, dims);
-          values_i.assign(cm_values_i.begin(), cm_values_i.end());
+          to_column_major(key, values_i, dims);
         } else {
-          std::vector<double> cm_values_r(values_r.size());
-          to_column_major(key, cm_values_r, values_r, dims);
-          values_r.assign(cm_values_r.begin(), cm_values_r.end());
+          to_column_major(key, values_r, dims);
         }
       }
       if (is_new) {
-        var_types_map[key] = slot_types_map[key];
+        var_types_map[key] = slot_type->second;
         if (is_int) {
-          std::pair<std::vector<int>, std::vector<size_t>> pair;
-          pair = make_pair(values_i, dims);
-          vars_i[key] = pair;
+          vars_i[key] = std::make_pair(std::move(values_i), dims);
+          values_i.clear();
         } else {
-          std::pair<std::vector<double>, std::vector<size_t>> pair;
-          pair = make_pair(values_r, dims);
-          vars_r[key] = pair;
+          vars_r[key] = std::make_pair(std::move(values_r), dims);
+          values_r.clear();
         }
       } else {
         bool is_aot = false;
-        std::string vname;
-        for (auto& key : key_stack) {
-          vname.append(key);
-          if (slot_types_map[vname] == meta_type::ARRAY_OF_TUPLES) {
+        for (size_t n = 1; n <= key_stack.size(); ++n) {
+          if (slot_types_map[key_prefix(n)] == meta_type::ARRAY_OF_TUPLES) {
             is_aot = true;
             break;
           }
-          vname.append(".");
         }
         if (!is_aot)
           unexpected_error(key, "not array of tuples");
@@ -321,28 +328,31 @@ class json_data_handler : public stan::json::json_handler {
         }
         var_types_map[key] = meta_type::ARRAY;
         if ((!is_int && was_int) || (is_int && is_real)) {  // promote to double
-          std::vector<double> values_tmp;
-          for (auto& x : vars_i[key].first) {
-            values_tmp.push_back(x);
-          }
-          for (auto& x : values_r)
-            values_tmp.push_back(x);
-          std::pair<std::vector<double>, std::vector<size_t>> pair;
-          pair = make_pair(values_tmp, dims);
-          vars_r[key] = pair;
+          const io::aligned_vector<int>& prev_values_i
+              = vars_i[key].first;
+          io::aligned_vector<double> values_tmp;
+          values_tmp.reserve(prev_values_i.size() + values_r.size());
+          values_tmp.insert(values_tmp.end(), prev_values_i.begin(),
+                            prev_values_i.end());
+          values_tmp.insert(values_tmp.end(), values_r.begin(),
+                            values_r.end());
+          vars_r[key] = std::make_pair(std::move(values_tmp), dims);
           vars_i.erase(key);
         } else if (is_int) {
-          for (auto& x : values_i)
-            vars_i[key].first.push_back(x);
+          io::aligned_vector<int>& prev_values_i = vars_i[key].first;
+          prev_values_i.insert(prev_values_i.end(), values_i.begin(),
+                               values_i.end());
           vars_i[key].second = dims;
         } else {
-          for (auto& x : values_r)
-            vars_r[key].first.push_back(x);
+          io::aligned_vector<double>& prev_values_r
+              = vars_r[key].first;
+          prev_values_r.insert(prev_values_r.end(), values_r.begin(),
+                               values_r.end());
           vars_r[key].second = dims;
         }
       }
     }
-    key_stack.pop_back();
+    pop_key();
   }
 
   /* For array of tuples, concatenate dimensions
@@ -384,21 +394,32 @@ class json_data_handler : public stan::json::json_handler {
     }
   }
 
+  /* Permute the row-major values of a multi-dim array to column-major
+   * order in place by following the cycles of the permutation.
+   */
   template <typename T>
-  void to_column_major(std::string vname, std::vector<T>& cm_vals,
-                       const std::vector<T>& rm_vals,
+  void to_column_major(const std::string& vname,
+                       io::aligned_vector<T>& vals,
                        const std::vector<size_t>& dims) {
     size_t expected_size = 1;
     for (auto& x : dims)
       expected_size *= x;
-    if (expected_size != rm_vals.size()) {
+    if (expected_size != vals.size()) {
       std::stringstream errorMsg;
       errorMsg << "Variable: " << vname << ", error: ill-formed array.";
       throw json_error(errorMsg.str());
     }
-    for (size_t i = 0; i < rm_vals.size(); i++) {
-      size_t idx = convert_offset_rtl_2_ltr(vname, i, dims);
-      cm_vals[idx] = rm_vals[i];
+    std::vector<bool> placed(vals.size(), false);
+    for (size_t start = 0; start < vals.size(); start++) {
+      if (placed[start])
+        continue;
+      T carry = vals[start];
+      size_t i = start;
+      do {
+        i = convert_offset_rtl_2_ltr(vname, i, dims);
+        std::swap(carry, vals[i]);
+        placed[i] = true;
+      } while (i != start);
     }
   }
 
@@ -420,11 +441,14 @@ class json_data_handler : public stan::json::json_handler {
         vars_r(a_vars_r),
         vars_i(a_vars_i),
         key_stack(),
+        key_(),
+        key_ends_(),
         var_types_map(),
         slot_types_map(),
         slot_dims_map(),
         tuple_slots_map(),
         int_slots_map(),
+        int_slot_(nullptr),
         values_r(),
         values_i(),
         array_start_i(0),
@@ -442,6 +466,7 @@ class json_data_handler : public stan::json::json_handler {
     slot_dims_map.clear();
     tuple_slots_map.clear();
     int_slots_map.clear();
+    int_slot_ = nullptr;
     reset_values();
     not_stan_var = true;
   }
@@ -462,8 +487,7 @@ class json_data_handler : public stan::json::json_handler {
     }
     event = meta_event::KEY;
     reset_values();
-    std::string outer = key_str();
-    key_stack.push_back(key);
+    push_key(key);
     if (key_stack.size() == 1) {
       not_stan_var = !valid_varname(key);
     }
@@ -473,19 +497,19 @@ class json_data_handler : public stan::json::json_handler {
       std::stringstream errorMsg;
       errorMsg << "Attempt to redefine variable: " << key << ".";
       throw json_error(errorMsg.str());
-    } else if (key_stack.size() > 1
-               && slot_types_map[outer] == meta_type::ARRAY_OF_TUPLES) {
-      if (tuple_slots_map[outer].is_first) {
-        tuple_slots_map[outer].slots++;
-      } else {
-        tuple_slots_map[outer].slots_acc++;
+    } else if (key_stack.size() > 1) {
+      std::string outer = outer_key_str();
+      if (slot_types_map[outer] == meta_type::ARRAY_OF_TUPLES) {
+        tuple_slots& slots = tuple_slots_map[outer];
+        if (slots.is_first) {
+          slots.slots++;
+        } else {
+          slots.slots_acc++;
+        }
       }
     }
-    std::string vname = key_str();
-    if (slot_types_map.count(vname) == 0) {
-      slot_types_map[vname] = meta_type::SCALAR;
-      int_slots_map[vname] = true;
-    }
+    if (slot_types_map.emplace(key_str(), meta_type::SCALAR).second)
+      is_int_slot() = true;
   }
 
   /**
@@ -521,13 +545,13 @@ class json_data_handler : public stan::json::json_handler {
     event = meta_event::OBJ_CLOSE;
     if (not_stan_var) {
       if (!key_stack.empty())
-        key_stack.pop_back();
+        pop_key();
       return;
     }
     if (key_stack.size() > 1) {
       std::string tuple = outer_key_str();
       if (slot_types_map[tuple] == meta_type::ARRAY_OF_TUPLES) {
-        array_dims outer = get_outer_dims(key_stack);
+        array_dims outer = get_outer_dims();
         if (!outer.dims.empty()) {
           outer.dims_acc[outer.dims.size() - 1]++;
           set_outer_dims(outer);
@@ -561,20 +585,19 @@ class json_data_handler : public stan::json::json_handler {
     }
     if (not_stan_var)
       return;
-    std::string key(key_str());
-    if (slot_types_map[key] == meta_type::SCALAR
+    const std::string& key = key_str();
+    int& slot_type = slot_types_map[key];
+    if (slot_type == meta_type::SCALAR
         && !(values_r.empty() && values_r.empty())) {
       std::stringstream errorMsg;
       errorMsg << "Variable: " << key << ", error: non-scalar array value.";
       throw json_error(errorMsg.str());
     }
-    if (slot_types_map[key] == meta_type::SCALAR)
-      slot_types_map[key] = meta_type::ARRAY;
-    else if (slot_types_map[key] == meta_type::TUPLE)
+    if (slot_type == meta_type::SCALAR)
+      slot_type = meta_type::ARRAY;
+    else if (slot_type == meta_type::TUPLE)
       unexpected_error(key, "ill-formed tuple");
-    array_dims dims;
-    if (slot_dims_map.count(key) == 1)
-      dims = slot_dims_map[key];
+    array_dims& dims = slot_dims_map[key];
     dims.cur_dim++;
     if (dims.dims.empty() || dims.dims.size() < dims.cur_dim) {
       dims.dims.push_back(0);
@@ -582,7 +605,6 @@ class json_data_handler : public stan::json::json_handler {
     }
     if (dims.cur_dim > 1)
       dims.dims_acc[dims.cur_dim - 2]++;
-    slot_dims_map[key] = dims;
     array_start_i = values_i.size();
     array_start_r = values_r.size();
   }
@@ -596,12 +618,13 @@ class json_data_handler : public stan::json::json_handler {
   void end_array() {
     if (not_stan_var)
       return;
-    if (slot_dims_map.count(key_str()) == 0)
-      unexpected_error(key_str(), "ill-formed array");
-    std::string key(key_str());
-    array_dims dims = slot_dims_map[key];
+    const std::string& key = key_str();
+    auto slot_dims = slot_dims_map.find(key);
+    if (slot_dims == slot_dims_map.end())
+      unexpected_error(key, "ill-formed array");
+    array_dims& dims = slot_dims->second;
     int idx = dims.cur_dim - 1;
-    bool is_int = int_slots_map[key];
+    bool is_int = is_int_slot();
     bool is_last = (slot_types_map[key] != meta_type::ARRAY_OF_TUPLES
                     && dims.cur_dim == dims.dims.size());
     if (is_last && 0 == dims.dims[idx]) {  // innermost row of scalar elts
@@ -628,7 +651,6 @@ class json_data_handler : public stan::json::json_handler {
     }
     dims.dims_acc[idx] = 0;
     dims.cur_dim--;
-    slot_dims_map[key] = dims;
   }
 
   void null() {
@@ -683,7 +705,7 @@ class json_data_handler : public stan::json::json_handler {
   void number_int(int n) {
     if (not_stan_var)
       return;
-    if (int_slots_map[key_str()]) {
+    if (is_int_slot()) {
       values_i.push_back(n);
     } else {
       values_r.push_back(n);
@@ -696,7 +718,7 @@ class json_data_handler : public stan::json::json_handler {
     // if integer overflow, promote numeric data to double
     if (n > (unsigned)std::numeric_limits<int>::max())
       promote_to_double();
-    if (int_slots_map[key_str()]) {
+    if (is_int_slot()) {
       values_i.push_back(static_cast<int>(n));
     } else {
       values_r.push_back(n);
@@ -721,7 +743,7 @@ class json_data_handler : public stan::json::json_handler {
   /** This function provides the column-major offset of an array element
    *  given its row-major offset and the array dimensions.
    */
-  size_t convert_offset_rtl_2_ltr(std::string vname, size_t rtl_offset,
+  size_t convert_offset_rtl_2_ltr(const std::string& vname, size_t rtl_offset,
                                   const std::vector<size_t>& dims) {
     size_t rtl_dsize = 1;
     for (size_t i = 1; i < dims.size(); i++)
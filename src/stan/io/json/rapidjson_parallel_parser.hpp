@@ -0,0 +1,330 @@
+#ifndef STAN_IO_JSON_RAPIDJSON_PARALLEL_PARSER_HPP
+#define STAN_IO_JSON_RAPIDJSON_PARALLEL_PARSER_HPP
+
+#include <stan/io/json/json_error.hpp>
+#include <stan/io/json/rapidjson_parser.hpp>
+#include <rapidjson/reader.h>
+#include <rapidjson/stream.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace json {
+namespace internal {
+
+/**
+ * A number read by the reader, with the type of the event it was
+ * reported with.
+ */
+struct number_token {
+  enum class kind : char { Int, Uint, Int64, Uint64, Double };
+  kind kind_;
+  union {
+    int64_t i_;
+    uint64_t u_;
+    double d_;
+  };
+};
+
+/**
+ * Handler recording the numbers of a JSON array of numbers, failing on
+ * any other event.
+ */
+struct number_recorder {
+  explicit number_recorder(std::vector<number_token> &tokens)
+      : tokens_(tokens), depth_(0) {}
+  void push(number_token::kind k) {
+    tokens_.emplace_back();
+    tokens_.back().kind_ = k;
+  }
+  bool Null() { return false; }
+  bool Bool(bool b) { return false; }
+  bool Int(int i) {
+    push(number_token::kind::Int);
+    tokens_.back().i_ = i;
+    return true;
+  }
+  bool Uint(unsigned u) {
+    push(number_token::kind::Uint);
+    tokens_.back().u_ = u;
+    return true;
+  }
+  bool Int64(int64_t i) {
+    push(number_token::kind::Int64);
+    tokens_.back().i_ = i;
+    return true;
+  }
+  bool Uint64(uint64_t u) {
+    push(number_token::kind::Uint64);
+    tokens_.back().u_ = u;
+    return true;
+  }
+  bool Double(double d) {
+    push(number_token::kind::Double);
+    tokens_.back().d_ = d;
+    return true;
+  }
+  bool RawNumber(const char *str, rapidjson::SizeType length, bool copy) {
+    return false;
+  }
+  bool String(const char *str, rapidjson::SizeType length, bool copy) {
+    return false;
+  }
+  bool StartObject() { return false; }
+  bool Key(const char *str, rapidjson::SizeType length, bool copy) {
+    return false;
+  }
+  bool EndObject(rapidjson::SizeType memberCount) { return false; }
+  bool StartArray() { return depth_++ == 0; }
+  bool EndArray(rapidjson::SizeType elementCount) { return true; }
+
+  std::vector<number_token> &tokens_;
+  int depth_;
+};
+
+/**
+ * The elements of an array of the JSON text which holds no array,
+ * object or string.
+ */
+struct flat_array {
+  /** offset of the first character after the opening bracket */
+  size_t begin_;
+  /** offset of the closing bracket */
+  size_t end_;
+  /** index of the first chunk of the elements */
+  size_t first_chunk_;
+};
+
+/**
+ * Return the arrays of the specified JSON text which hold no array,
+ * object or string and whose elements take at least the specified
+ * number of characters, in the order of the text.
+ *
+ * <p>The text is scanned once for brackets, braces and quotes, skipping
+ * the contents of strings, so only the structure of the text is
+ * indexed; the elements are not checked.
+ *
+ * @param text JSON text
+ * @param min_bytes minimum length of the elements of an array
+ */
+inline std::vector<flat_array> index_flat_arrays(const std::string &text,
+                                                 size_t min_bytes) {
+  std::vector<flat_array> arrays;
+  const size_t none = std::string::npos;
+  size_t open = none;
+  for (size_t n = 0; n < text.size(); ++n) {
+    switch (text[n]) {
+      case '"':
+        open = none;
+        for (++n; n < text.size() && text[n] != '"'; ++n)
+          if (text[n] == '\\')
+            ++n;
+        break;
+      case '{':
+        open = none;
+        break;
+      case '[':
+        open = n + 1;
+        break;
+      case ']':
+        if (open != none && n - open >= min_bytes)
+          arrays.push_back({open, n, 0});
+        open = none;
+        break;
+    }
+  }
+  return arrays;
+}
+
+/**
+ * Rapidjson handler replaying the numbers of the flat arrays parsed in
+ * parallel when the reader starts the array left in their place in the
+ * skeleton of the text.
+ */
+template <typename Handler>
+struct ParallelRapidJSONHandler : public RapidJSONHandler<Handler> {
+  ParallelRapidJSONHandler(
+      Handler &h, const rapidjson::StringStream &is,
+      const std::vector<size_t> &skeleton_offsets,
+      const std::vector<flat_array> &arrays,
+      const std::vector<std::vector<number_token>> &chunk_tokens)
+      : RapidJSONHandler<Handler>(h),
+        is_(is),
+        skeleton_offsets_(skeleton_offsets),
+        arrays_(arrays),
+        chunk_tokens_(chunk_tokens),
+        next_(0) {}
+
+  bool replay(const number_token &t) {
+    switch (t.kind_) {
+      case number_token::kind::Int:
+        return this->Int(static_cast<int>(t.i_));
+      case number_token::kind::Uint:
+        return this->Uint(static_cast<unsigned>(t.u_));
+      case number_token::kind::Int64:
+        return this->Int64(t.i_);
+      case number_token::kind::Uint64:
+        return this->Uint64(t.u_);
+      default:
+        return this->Double(t.d_);
+    }
+  }
+
+  bool StartArray() {
+    RapidJSONHandler<Handler>::StartArray();
+    if (next_ == arrays_.size() || is_.Tell() != skeleton_offsets_[next_])
+      return true;
+    size_t end_chunk = next_ + 1 < arrays_.size()
+                           ? arrays_[next_ + 1].first_chunk_
+                           : chunk_tokens_.size();
+    for (size_t c = arrays_[next_].first_chunk_; c < end_chunk; ++c)
+      for (const auto &t : chunk_tokens_[c])
+        if (!replay(t))
+          return false;
+    ++next_;
+    return true;
+  }
+
+  const rapidjson::StringStream &is_;
+  const std::vector<size_t> &skeleton_offsets_;
+  const std::vector<flat_array> &arrays_;
+  const std::vector<std::vector<number_token>> &chunk_tokens_;
+  size_t next_;
+};
+
+}  // namespace internal
+
+/**
+ * Parse the JSON text represented by the specified input stream,
+ * sending events to the specified handler, parsing the numbers of
+ * large arrays in parallel.
+ *
+ * <p>The text is read into memory and its structure indexed to find
+ * the arrays which hold no array, object or string and whose elements
+ * take at least <code>min_array_bytes</code> characters.  The elements
+ * of these arrays are split at commas into chunks of about
+ * <code>chunk_bytes</code> characters, which are parsed in parallel.
+ * The rest of the text is then parsed serially, with the numbers of
+ * each of these arrays sent to the handler when their array starts.
+ *
+ * <p>All numbers are parsed by the same reader as in
+ * <code>rapidjson_parse</code>, so the handler receives the same events
+ * with the same values.  If an array holds anything but numbers, the
+ * whole text is parsed serially, so errors are reported with the same
+ * messages and offsets.
+ *
+ * @tparam Handler
+ * @param in Input stream from which to parse
+ * @param handler Handler for events from parser
+ * @param min_array_bytes minimum length of the elements of an array
+ * parsed in parallel
+ * @param chunk_bytes length of the chunks parsed in parallel
+ */
+template <typename Handler>
+void rapidjson_parse_parallel(std::istream &in, Handler &handler,
+                              size_t min_array_bytes = 1 << 20,
+                              size_t chunk_bytes = 1 << 20) {
+  std::string text;
+  std::vector<char> buffer(1 << 16);
+  while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0)
+    text.append(buffer.data(), in.gcount());
+
+  std::vector<internal::flat_array> arrays
+      = internal::index_flat_arrays(text, min_array_bytes);
+  std::vector<std::pair<size_t, size_t>> chunks;
+  for (auto &array : arrays) {
+    array.first_chunk_ = chunks.size();
+    size_t begin = array.begin_;
+    while (begin < array.end_) {
+      size_t end = begin + chunk_bytes < array.end_
+                       ? text.find(',', begin + chunk_bytes)
+                       : array.end_;
+      if (end > array.end_)
+        end = array.end_;
+      chunks.emplace_back(begin, end);
+      begin = end + 1;
+    }
+    if (text[array.end_ - 1] == ',')
+      chunks.emplace_back(array.end_, array.end_);
+  }
+
+  std::vector<std::vector<internal::number_token>> chunk_tokens(
+      chunks.size());
+  std::vector<char> chunk_ok(chunks.size());
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, chunks.size(), 1),
+      [&](const tbb::blocked_range<size_t> &r) {
+        for (size_t c = r.begin(); c != r.end(); ++c) {
+          std::string chunk = "[";
+          chunk.append(text, chunks[c].first,
+                       chunks[c].second - chunks[c].first);
+          chunk.push_back(']');
+          // An empty chunk is an empty element of the array
+          chunk_ok[c] = chunk.find_first_not_of(" \t\n\r", 1) + 1
+                        < chunk.size();
+          if (!chunk_ok[c])
+            continue;
+          rapidjson::Reader reader;
+          rapidjson::StringStream ss(chunk.c_str());
+          internal::number_recorder recorder(chunk_tokens[c]);
+          chunk_ok[c] = !reader.Parse<rapidjson_parse_flags>(ss, recorder)
+                             .IsError();
+        }
+      });
+
+  bool all_ok = true;
+  for (char ok : chunk_ok)
+    all_ok = all_ok && ok;
+  if (!all_ok) {
+    rapidjson::Reader reader;
+    RapidJSONHandler<Handler> filter(handler);
+    rapidjson::StringStream ss(text.c_str());
+    handler.start_text();
+    if (!reader.Parse<rapidjson_parse_flags>(ss, filter))
+      throw json_error(parse_error_message(reader.GetParseErrorCode(),
+                                           reader.GetErrorOffset(),
+                                           filter.error_message_));
+    handler.end_text();
+    return;
+  }
+
+  // The text without the elements of the arrays parsed in parallel
+  std::string skeleton;
+  std::vector<size_t> skeleton_offsets;
+  size_t begin = 0;
+  for (const auto &array : arrays) {
+    skeleton.append(text, begin, array.begin_ - begin);
+    skeleton_offsets.push_back(skeleton.size());
+    begin = array.end_;
+  }
+  skeleton.append(text, begin, std::string::npos);
+  text.clear();
+  text.shrink_to_fit();
+
+  rapidjson::Reader reader;
+  rapidjson::StringStream ss(skeleton.c_str());
+  internal::ParallelRapidJSONHandler<Handler> filter(
+      handler, ss, skeleton_offsets, arrays, chunk_tokens);
+  handler.start_text();
+  if (!reader.Parse<rapidjson_parse_flags>(ss, filter)) {
+    // Errors are outside of the removed elements, map back their offset
+    size_t offset = reader.GetErrorOffset();
+    size_t text_offset = offset;
+    for (size_t k = 0; k < arrays.size() && skeleton_offsets[k] < offset;
+         ++k)
+      text_offset += arrays[k].end_ - arrays[k].begin_;
+    throw json_error(parse_error_message(reader.GetParseErrorCode(),
+                                         text_offset, filter.error_message_));
+  }
+  handler.end_text();
+}
+
+}  // namespace json
+}  // namespace stan
+#endif
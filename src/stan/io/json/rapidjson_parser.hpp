@@ -21,6 +21,13 @@ namespace stan {
 namespace json {
 enum class ParsingState { Idle, Started, End };
 
+/**
+ * Flags of the rapidjson reader used to parse JSON data.
+ */
+constexpr unsigned rapidjson_parse_flags
+    = rapidjson::kParseNanAndInfFlag | rapidjson::kParseValidateEncodingFlag
+      | rapidjson::kParseFullPrecisionFlag;
+
 template <typename Handler>
 struct RapidJSONHandler {
   explicit RapidJSONHandler(Handler &h) : h_(h), state_(ParsingState::Idle) {}
@@ -99,9 +106,33 @@ struct RapidJSONHandler {
   std::string last_key_;
 };
 
+/**
+ * Return the message of a parse error.
+ *
+ * @param err error code of the reader
+ * @param offset offset of the error in the JSON text
+ * @param handler_message message of the handler, used instead of the
+ * one of the error code if not empty
+ */
+inline std::string parse_error_message(rapidjson::ParseErrorCode err,
+                                       size_t offset,
+                                       const std::string &handler_message) {
+  std::stringstream ss;
+  ss << "Error in JSON parsing " << std::endl
+     << "at offset " << offset << ": " << std::endl;
+  if (handler_message.size() > 0) {
+    ss << handler_message << std::endl;
+  } else {
+    ss << rapidjson::GetParseError_En(err) << std::endl;
+  }
+  return ss.str();
+}
+
 /**
  * Parse the JSON text represented by the specified input stream,
- * sending events to the specified handler.
+ * sending events to the specified handler.  To read a large file on a
+ * background thread while it is parsed, pass a
+ * <code>stan::io::prefetch_istream</code> wrapping it.
  *
  * @tparam Handler
  * @param in Input stream from which to parse
@@ -113,19 +144,10 @@ void rapidjson_parse(std::istream &in, Handler &handler) {
   RapidJSONHandler<Handler> filter(handler);
   rapidjson::IStreamWrapper isw(in);
   handler.start_text();
-  if (!reader.Parse<rapidjson::kParseNanAndInfFlag
-                    | rapidjson::kParseValidateEncodingFlag
-                    | rapidjson::kParseFullPrecisionFlag>(isw, filter)) {
-    rapidjson::ParseErrorCode err = reader.GetParseErrorCode();
-    std::stringstream ss;
-    ss << "Error in JSON parsing " << std::endl
-       << "at offset " << reader.GetErrorOffset() << ": " << std::endl;
-    if (filter.error_message_.size() > 0) {
-      ss << filter.error_message_ << std::endl;
-    } else {
-      ss << rapidjson::GetParseError_En(err) << std::endl;
-    }
-    throw json_error(ss.str());
+  if (!reader.Parse<rapidjson_parse_flags>(isw, filter)) {
+    throw json_error(parse_error_message(reader.GetParseErrorCode(),
+                                         reader.GetErrorOffset(),
+                                         filter.error_message_));
   }
   handler.end_text();
 }
@@ -0,0 +1,203 @@
+#ifndef STAN_IO_PREFETCH_ISTREAM_HPP
+#define STAN_IO_PREFETCH_ISTREAM_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * <code>prefetch_streambuf</code> is a stream buffer reading another
+ * stream in large chunks on a background thread, into two buffers, so
+ * that the next chunk is read while the previous one is consumed, e.g.
+ * by the SAX parser of <code>json_data</code> or by
+ * <code>stan_csv_reader</code>, and the latency of reading is hidden
+ * behind the parsing.
+ *
+ * The background thread starts reading on construction and may read up
+ * to two chunks ahead of what has been consumed, so the source must not
+ * be read or repositioned otherwise while this buffer exists, and its
+ * position afterwards is unspecified.  If reading the source fails, the
+ * buffer throws <code>std::runtime_error</code> once the chunks read
+ * before the failure have been consumed, which sets the
+ * <code>badbit</code> of the stream reading from it.  The buffer cannot
+ * seek.
+ */
+class prefetch_streambuf : public std::streambuf {
+ public:
+  /**
+   * Construct a stream buffer prefetching the specified stream.
+   *
+   * @param[in, out] source stream to read; must outlive this buffer
+   * @param[in] chunk_size number of characters read at a time
+   */
+  explicit prefetch_streambuf(std::istream& source,
+                              std::size_t chunk_size = 1 << 20)
+      : source_(source) {
+    for (slot& s : slots_)
+      s.data.resize(chunk_size > 0 ? chunk_size : 1);
+    setg(nullptr, nullptr, nullptr);
+    reader_ = std::thread([this]() { read_ahead(); });
+  }
+
+  ~prefetch_streambuf() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    changed_.notify_all();
+    reader_.join();
+  }
+
+  prefetch_streambuf(const prefetch_streambuf&) = delete;
+  prefetch_streambuf& operator=(const prefetch_streambuf&) = delete;
+
+ protected:
+  int_type underflow() {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (consuming_) {
+      // hand the consumed buffer back to the reader
+      slots_[next_consumed_].full = false;
+      next_consumed_ ^= 1;
+      consuming_ = false;
+      changed_.notify_all();
+    }
+    changed_.wait(lock,
+                  [this]() { return slots_[next_consumed_].full || done_; });
+    slot& s = slots_[next_consumed_];
+    if (!s.full) {
+      setg(nullptr, nullptr, nullptr);
+      if (error_)
+        throw std::runtime_error("prefetch_streambuf: error reading source");
+      return traits_type::eof();
+    }
+    consuming_ = true;
+    setg(s.data.data(), s.data.data(), s.data.data() + s.size);
+    return traits_type::to_int_type(*gptr());
+  }
+
+ private:
+  struct slot {
+    std::vector<char> data;
+    std::size_t size{0};
+    /**
+     * True while the buffer holds a chunk not yet consumed, during
+     * which only the consumer accesses it.
+     */
+    bool full{false};
+  };
+
+  /**
+   * Read chunks of the source into the buffers in turn, waiting for
+   * each to be consumed, until the end of the source, an error or
+   * destruction.
+   */
+  void read_ahead() {
+    std::size_t next = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&]() { return stop_ || !slots_[next].full; });
+        if (stop_)
+          return;
+      }
+      slot& s = slots_[next];
+      std::streamsize count = 0;
+      bool failed = false;
+      try {
+        source_.read(s.data.data(), s.data.size());
+        count = source_.gcount();
+        failed = source_.bad();
+      } catch (...) {
+        failed = true;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (count > 0) {
+        s.size = count;
+        s.full = true;
+        next ^= 1;
+      }
+      if (count == 0 || failed || !source_.good()) {
+        error_ = failed;
+        done_ = true;
+      }
+      changed_.notify_all();
+      if (done_)
+        return;
+    }
+  }
+
+  std::istream& source_;
+  slot slots_[2];
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread reader_;
+  std::size_t next_consumed_{0};
+  bool consuming_{false};
+  bool done_{false};
+  bool error_{false};
+  bool stop_{false};
+};
+
+/**
+ * <code>prefetch_istream</code> is an input stream reading a file or
+ * another stream through a <code>prefetch_streambuf</code>, so that
+ * large data or output files are read on a background thread while
+ * they are parsed, e.g.
+ *
+ * <pre>
+ * std::ifstream file("data.json");
+ * stan::io::prefetch_istream in(file);
+ * stan::json::json_data data(in);
+ * </pre>
+ */
+class prefetch_istream : public std::istream {
+ public:
+  /**
+   * Construct a stream prefetching the specified stream.
+   *
+   * @param[in, out] source stream to read; must outlive this stream
+   * @param[in] chunk_size number of characters read at a time
+   */
+  explicit prefetch_istream(std::istream& source,
+                            std::size_t chunk_size = 1 << 20)
+      : std::istream(nullptr),
+        buf_(new prefetch_streambuf(source, chunk_size)) {
+    rdbuf(buf_.get());
+  }
+
+  /**
+   * Construct a stream prefetching the specified stream, which it owns.
+   *
+   * @param[in] source stream to read
+   * @param[in] chunk_size number of characters read at a time
+   */
+  explicit prefetch_istream(std::unique_ptr<std::istream>&& source,
+                            std::size_t chunk_size = 1 << 20)
+      : std::istream(nullptr),
+        source_(std::move(source)),
+        buf_(new prefetch_streambuf(*source_, chunk_size)) {
+    rdbuf(buf_.get());
+  }
+
+  ~prefetch_istream() { buf_.reset(); }
+
+ private:
+  std::unique_ptr<std::istream> source_;
+  std::unique_ptr<prefetch_streambuf> buf_;
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
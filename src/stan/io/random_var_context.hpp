@@ -98,6 +98,22 @@ class random_var_context : public var_context {
     return vals_r_[loc - names_.begin()];
   }
 
+  /**
+   * Returns a view of the values of the constrained variables.
+   *
+   * @param name Name of variable.
+   *
+   * @return a view of the constrained values if the variable is in the
+   *   var_context; an empty view is returned otherwise
+   */
+  values_view<double> vals_r_view(const std::string& name) const {
+    std::vector<std::string>::const_iterator loc
+        = std::find(names_.begin(), names_.end(), name);
+    if (loc == names_.end())
+      return values_view<double>();
+    return values_view<double>(vals_r_[loc - names_.begin()]);
+  }
+
   std::vector<std::complex<double>> vals_c(const std::string& name) const {
     std::vector<std::string>::const_iterator loc
         = std::find(names_.begin(), names_.end(), name);
@@ -152,6 +168,16 @@ class random_var_context : public var_context {
     return empty_vals_i;
   }
 
+  /**
+   * Returns an empty view.
+   *
+   * @param name Name of variable.
+   * @return empty view
+   */
+  values_view<int> vals_i_view(const std::string& name) const {
+    return values_view<int>();
+  }
+
   /**
    * Return the dimensions of the specified floating point variable.
    * Returns an empty vector.
@@ -2,6 +2,7 @@
 #define STAN_IO_SERIALIZER_HPP
 
 #include <stan/math/rev.hpp>
+#include <algorithm>
 
 namespace stan {
 namespace io {
@@ -12,9 +13,14 @@ namespace io {
  *`T` is the storage scalar type. Variables written by the serializer must
  * have a scalar type convertible to type `T`.
  *
+ * With `Checked` false, writes do not check that the storage has room
+ * for them.  This is for storage already sized for everything written,
+ * for instance from `num_params_r()` or `get_dims()` of a model.
+ *
  * @tparam T Basic scalar type.
+ * @tparam Checked Whether writes check the storage capacity.
  */
-template <typename T>
+template <typename T, bool Checked = true>
 class serializer {
  private:
   Eigen::Map<Eigen::Matrix<T, -1, 1>> map_r_;  // map of reals.
@@ -28,6 +34,9 @@ class serializer {
    * @throws std::runtime_error if there isn't room for m reals
    */
   void check_r_capacity(size_t m) const {
+    if (!Checked) {
+      return;
+    }
     if (pos_r_ + m > r_size_) {
       [](auto r_size_, auto pos_r_, auto m)
           STAN_COLD_PATH {
@@ -47,6 +56,41 @@ class serializer {
   using is_arithmetic_or_ad
       = bool_constant<std::is_arithmetic<S>::value || is_autodiff<S>::value>;
 
+  /**
+   * Copy the values of an Eigen object to storage in column-major
+   * order, with a single copy of the whole block when its scalars have
+   * type `T` and lie contiguously in column-major order.  The capacity
+   * must have been checked.
+   *
+   * @tparam Mat An Eigen type
+   * @param x The values to copy
+   */
+  template <typename Mat>
+  inline void copy_dense(const Mat& x) {
+    using mat_t = std::decay_t<Mat>;
+    constexpr bool direct
+        = std::is_same<typename mat_t::Scalar, T>::value
+          && static_cast<bool>(mat_t::Flags & Eigen::DirectAccessBit);
+    copy_dense(x, bool_constant<direct>());
+  }
+
+  template <typename Mat>
+  inline void copy_dense(const Mat& x, std::true_type) {
+    bool col_major = !(std::decay_t<Mat>::Flags & Eigen::RowMajorBit)
+                     || x.rows() == 1 || x.cols() == 1;
+    if (col_major && x.innerStride() == 1
+        && (x.outerSize() <= 1 || x.outerStride() == x.innerSize())) {
+      std::copy_n(x.data(), x.size(), map_r_.data() + pos_r_);
+    } else {
+      copy_dense(x, std::false_type());
+    }
+  }
+
+  template <typename Mat>
+  inline void copy_dense(const Mat& x, std::false_type) {
+    map_matrix_t(map_r_.data() + pos_r_, x.rows(), x.cols()) = x;
+  }
+
  public:
   using matrix_t = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
   using vector_t = Eigen::Matrix<T, Eigen::Dynamic, 1>;
@@ -116,7 +160,7 @@ class serializer {
             require_not_vt_complex<Vec>* = nullptr>
   inline void write(Vec&& vec) {
     check_r_capacity(vec.size());
-    map_vector_t(&map_r_.coeffRef(pos_r_), vec.size()) = vec;
+    copy_dense(vec);
     pos_r_ += vec.size();
   }
 
@@ -147,7 +191,7 @@ class serializer {
             require_not_vt_complex<Vec>* = nullptr>
   inline void write(Vec&& vec) {
     check_r_capacity(vec.size());
-    map_row_vector_t(&map_r_.coeffRef(pos_r_), vec.size()) = vec;
+    copy_dense(vec);
     pos_r_ += vec.size();
   }
 
@@ -178,7 +222,7 @@ class serializer {
             require_not_vt_complex<Mat>* = nullptr>
   inline void write(Mat&& mat) {
     check_r_capacity(mat.size());
-    map_matrix_t(&map_r_.coeffRef(pos_r_), mat.rows(), mat.cols()) = mat;
+    copy_dense(mat);
     pos_r_ += mat.size();
   }
 
@@ -229,11 +273,25 @@ class serializer {
     this->write(stan::math::value_of(x));
   }
 
+  /**
+   * Write a `std::vector` of scalars to storage, checking its capacity
+   * once for the whole vector.
+   * @tparam StdVec The type to write
+   */
+  template <typename StdVec, require_std_vector_t<StdVec>* = nullptr,
+            require_t<is_arithmetic_or_ad<value_type_t<StdVec>>>* = nullptr>
+  inline void write(StdVec&& x) {
+    check_r_capacity(x.size());
+    std::copy(x.begin(), x.end(), map_r_.data() + pos_r_);
+    pos_r_ += x.size();
+  }
+
   /**
    * Write a `std::vector` to storage
    * @tparam StdVec The type to write
    */
-  template <typename StdVec, require_std_vector_t<StdVec>* = nullptr>
+  template <typename StdVec, require_std_vector_t<StdVec>* = nullptr,
+            require_not_t<is_arithmetic_or_ad<value_type_t<StdVec>>>* = nullptr>
   inline void write(StdVec&& x) {
     for (const auto& x_i : x) {
       this->write(x_i);
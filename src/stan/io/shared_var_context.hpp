@@ -0,0 +1,176 @@
+#ifndef STAN_IO_SHARED_VAR_CONTEXT_HPP
+#define STAN_IO_SHARED_VAR_CONTEXT_HPP
+
+#include <stan/io/binary_var_context.hpp>
+#include <stan/io/var_context.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+
+namespace stan {
+namespace io {
+
+namespace internal {
+
+/**
+ * Stream buffer discarding what is written to it and counting its
+ * characters, to size a segment before writing to it.
+ */
+class counting_streambuf : public std::streambuf {
+ public:
+  std::size_t count() const { return count_; }
+
+ protected:
+  int_type overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+      ++count_;
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) {
+    count_ += n;
+    return n;
+  }
+
+ private:
+  std::size_t count_{0};
+};
+
+/**
+ * Holder of the mapping of a segment, a base of
+ * <code>shared_var_context</code> so that the segment is mapped before
+ * its header is read.
+ */
+struct shared_data_region {
+  boost::interprocess::mapped_region shared_region_;
+};
+
+}  // namespace internal
+
+/**
+ * A <code>shared_data_publisher</code> publishes the variables of a
+ * context in a named shared memory segment, a POSIX shared memory
+ * object on POSIX systems, in the binary data format of
+ * <code>binary_var_context</code>, for the other processes of a node to
+ * attach to with <code>shared_var_context</code>.
+ *
+ * <p>The data are written once, directly into the segment, and the
+ * name is removed when the publisher is destroyed.  Processes already
+ * attached keep their mapping until they detach, so the publisher only
+ * needs to live until the others have attached.
+ */
+class shared_data_publisher {
+ public:
+  /**
+   * Publish the variables of the specified context in a new segment of
+   * the specified name.
+   *
+   * @param name name of the segment, e.g. <code>"stan_data"</code>
+   * @param context variables to publish
+   * @throw std::invalid_argument if a segment of the name exists or
+   * cannot be created
+   */
+  shared_data_publisher(const std::string& name, const var_context& context)
+      : name_(name) {
+    internal::counting_streambuf counter;
+    std::ostream count_out(&counter);
+    write_binary_data(count_out, context);
+    size_ = counter.count();
+    try {
+      boost::interprocess::shared_memory_object segment(
+          boost::interprocess::create_only, name.c_str(),
+          boost::interprocess::read_write);
+      owner_ = true;
+      segment.truncate(size_);
+      boost::interprocess::mapped_region region(
+          segment, boost::interprocess::read_write);
+      boost::interprocess::obufferstream out(
+          static_cast<char*>(region.get_address()), size_);
+      write_binary_data(out, context);
+      if (!out)
+        throw std::invalid_argument("shared data: cannot write segment "
+                                    + name);
+    } catch (const boost::interprocess::interprocess_exception& e) {
+      remove();
+      throw std::invalid_argument("shared data: cannot create segment "
+                                  + name + ": " + e.what());
+    } catch (...) {
+      remove();
+      throw;
+    }
+  }
+
+  ~shared_data_publisher() { remove(); }
+
+  shared_data_publisher(const shared_data_publisher&) = delete;
+  shared_data_publisher& operator=(const shared_data_publisher&) = delete;
+
+  /**
+   * Return the name of the segment.
+   */
+  const std::string& name() const { return name_; }
+
+  /**
+   * Return the number of bytes of the published data.
+   */
+  std::size_t size() const { return size_; }
+
+ private:
+  std::string name_;
+  std::size_t size_{0};
+  bool owner_{false};
+
+  void remove() {
+    if (owner_)
+      boost::interprocess::shared_memory_object::remove(name_.c_str());
+    owner_ = false;
+  }
+};
+
+/**
+ * A <code>shared_var_context</code> is a <code>binary_var_context</code>
+ * attached read-only to a segment published by
+ * <code>shared_data_publisher</code>.  Only the header is read, and the
+ * views of the values refer to the segment, whose pages are shared by
+ * every attached process, so attaching neither parses the data nor
+ * takes memory for another copy of it.
+ */
+class shared_var_context : private internal::shared_data_region,
+                           public binary_var_context {
+ public:
+  /**
+   * Attach to the segment of the specified name.
+   *
+   * @param name name of the segment
+   * @throw std::invalid_argument if there is no segment of the name or
+   * it does not hold data in the binary data format
+   */
+  explicit shared_var_context(const std::string& name)
+      : internal::shared_data_region{attach(name)},
+        binary_var_context(
+            static_cast<const char*>(shared_region_.get_address()),
+            shared_region_.get_size()) {}
+
+ private:
+  static boost::interprocess::mapped_region attach(const std::string& name) {
+    try {
+      boost::interprocess::shared_memory_object segment(
+          boost::interprocess::open_only, name.c_str(),
+          boost::interprocess::read_only);
+      return boost::interprocess::mapped_region(
+          segment, boost::interprocess::read_only);
+    } catch (const boost::interprocess::interprocess_exception& e) {
+      throw std::invalid_argument("shared data: cannot attach to segment "
+                                  + name + ": " + e.what());
+    }
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
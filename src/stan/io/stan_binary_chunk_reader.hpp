@@ -0,0 +1,132 @@
+#ifndef STAN_IO_STAN_BINARY_CHUNK_READER_HPP
+#define STAN_IO_STAN_BINARY_CHUNK_READER_HPP
+
+#include <stan/io/draws_chunk_reader.hpp>
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/io/stan_binary_reader.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Reads the draws of a file written by `callbacks::binary_writer` a
+ * chunk of rows at a time, keeping only the selected columns.  Unlike
+ * `stan_binary_reader::parse`, the file is read in a single pass, with
+ * one row group in memory at a time, so the stream need not be
+ * seekable.  Messages are kept as they are met.
+ */
+class stan_binary_chunk_reader : public draws_chunk_reader {
+ public:
+  /**
+   * Read the header of the file and select the columns with the
+   * specified names.
+   *
+   * @param[in, out] in stream positioned at the first chunk, opened in
+   * binary mode
+   * @param[in] columns names of the columns to read
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if the file does not start with a
+   * header or the header does not have one of the columns
+   */
+  stan_binary_chunk_reader(std::istream& in,
+                           const std::vector<std::string>& columns,
+                           std::ostream* out)
+      : in_(in), out_(out) {
+    char tag[binary_format::tag_size];
+    if (!stan_binary_reader::read_tag(in, tag))
+      throw std::invalid_argument("stan_binary_reader: empty input");
+    if (!stan_binary_reader::is_tag(tag, binary_format::header_tag))
+      throw std::invalid_argument(
+          "stan_binary_reader: input does not start with a header");
+    binary_format::read_u64(in);
+    stan_binary_reader::read_header(in, header_, false);
+    columns_ = select_columns(header_, columns);
+  }
+
+  std::size_t num_columns() const override { return columns_.size(); }
+
+  std::size_t read(Eigen::MatrixXd& chunk, std::size_t max_rows) override {
+    if (static_cast<std::size_t>(chunk.rows()) != max_rows
+        || static_cast<std::size_t>(chunk.cols()) != columns_.size())
+      chunk.resize(max_rows, columns_.size());
+    std::size_t n = 0;
+    while (n < max_rows) {
+      if (next_row_ == static_cast<std::size_t>(group_.rows())
+          && !read_group())
+        break;
+      const std::size_t rows = std::min<std::size_t>(
+          max_rows - n, group_.rows() - next_row_);
+      for (std::size_t k = 0; k < columns_.size(); ++k)
+        chunk.col(k).segment(n, rows)
+            = group_.col(columns_[k]).segment(next_row_, rows);
+      next_row_ += rows;
+      n += rows;
+    }
+    return n;
+  }
+
+  const std::vector<std::string>& header() const { return header_; }
+
+  /**
+   * Return the messages read so far.
+   */
+  const std::vector<std::string>& messages() const { return messages_; }
+
+ private:
+  /**
+   * Read the chunks up to and including the next row group, returning
+   * false at the end of the input.
+   */
+  bool read_group() {
+    char tag[binary_format::tag_size];
+    while (stan_binary_reader::read_tag(in_, tag)) {
+      const std::uint64_t payload = binary_format::read_u64(in_);
+      if (stan_binary_reader::is_tag(tag, binary_format::rows_tag)) {
+        const std::uint32_t rows = binary_format::read_u32(in_);
+        if (payload != 4 + header_.size() * rows * sizeof(double))
+          throw std::invalid_argument(
+              "stan_binary_reader: row group size does not match header");
+        group_.resize(rows, header_.size());
+        for (Eigen::Index j = 0; j < group_.cols(); ++j)
+          binary_format::read_doubles(in_, group_.col(j).data(), rows);
+        next_row_ = 0;
+        if (rows > 0)
+          return true;
+      } else if (stan_binary_reader::is_tag(tag,
+                                            binary_format::header_tag)) {
+        stan_binary_reader::read_header(in_, header_, true);
+      } else {
+        std::string bytes(payload, '\0');
+        binary_format::read_bytes(in_, &bytes[0], payload);
+        if (stan_binary_reader::is_tag(tag, binary_format::message_tag))
+          messages_.push_back(bytes);
+        else if (out_)
+          *out_ << "Warning: skipping unknown chunk "
+                << std::string(tag, binary_format::tag_size) << std::endl;
+      }
+    }
+    group_.resize(0, header_.size());
+    next_row_ = 0;
+    return false;
+  }
+
+  std::istream& in_;
+  std::ostream* out_;
+  std::vector<std::string> header_;
+  std::vector<std::size_t> columns_;
+  std::vector<std::string> messages_;
+  Eigen::MatrixXd group_;
+  std::size_t next_row_ = 0;
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
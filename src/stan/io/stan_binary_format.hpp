@@ -0,0 +1,152 @@
+#ifndef STAN_IO_STAN_BINARY_FORMAT_HPP
+#define STAN_IO_STAN_BINARY_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace stan {
+namespace io {
+
+/**
+ * Layout of the binary draws format written by
+ * `callbacks::binary_writer` and read by `io::stan_binary_reader`.
+ *
+ * A file is a sequence of chunks.  Every chunk starts with a four byte
+ * tag and the byte length of its payload as an unsigned 64-bit
+ * integer, so readers can skip chunks they do not understand.  All
+ * integers and doubles are little-endian.
+ *
+ * - header (`SBH1`): number of columns as an unsigned 32-bit integer,
+ *   then for each column the length of its name as an unsigned 32-bit
+ *   integer followed by the name's bytes.
+ * - row group (`SBR1`): number of rows as an unsigned 32-bit integer,
+ *   then one block of doubles per column, each holding that column's
+ *   values for all rows of the group.
+ * - message (`SBM1`): the bytes of a comment line; blank lines are
+ *   empty messages.
+ *
+ * The first chunk is a header.  Appending to an existing file writes
+ * another header, which must name the same columns, followed by more
+ * row groups.
+ */
+namespace binary_format {
+
+constexpr std::size_t tag_size = 4;
+constexpr char header_tag[tag_size + 1] = "SBH1";
+constexpr char rows_tag[tag_size + 1] = "SBR1";
+constexpr char message_tag[tag_size + 1] = "SBM1";
+
+/**
+ * Return true if doubles and integers are stored little-endian on
+ * this platform, in which case blocks are copied without conversion.
+ */
+inline bool host_is_little_endian() {
+  const std::uint32_t one = 1;
+  unsigned char first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+inline void write_u32(std::ostream& out, std::uint32_t x) {
+  char bytes[4];
+  for (int i = 0; i < 4; ++i)
+    bytes[i] = static_cast<char>((x >> (8 * i)) & 0xff);
+  out.write(bytes, 4);
+}
+
+inline void write_u64(std::ostream& out, std::uint64_t x) {
+  char bytes[8];
+  for (int i = 0; i < 8; ++i)
+    bytes[i] = static_cast<char>((x >> (8 * i)) & 0xff);
+  out.write(bytes, 8);
+}
+
+/**
+ * Write a contiguous block of doubles.
+ *
+ * @param[in, out] out stream to write to
+ * @param[in] x pointer to the first value
+ * @param[in] n number of values
+ */
+inline void write_doubles(std::ostream& out, const double* x, std::size_t n) {
+  if (host_is_little_endian()) {
+    out.write(reinterpret_cast<const char*>(x), n * sizeof(double));
+    return;
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    std::uint64_t bits;
+    std::memcpy(&bits, x + i, sizeof(double));
+    write_u64(out, bits);
+  }
+}
+
+/**
+ * Write a chunk tag and payload length.
+ *
+ * @param[in, out] out stream to write to
+ * @param[in] tag one of the chunk tags
+ * @param[in] payload_size number of payload bytes that follow
+ */
+inline void write_chunk_start(std::ostream& out, const char* tag,
+                              std::uint64_t payload_size) {
+  out.write(tag, tag_size);
+  write_u64(out, payload_size);
+}
+
+/**
+ * Read exactly n bytes or throw.
+ */
+inline void read_bytes(std::istream& in, char* bytes, std::size_t n) {
+  in.read(bytes, n);
+  if (static_cast<std::size_t>(in.gcount()) != n)
+    throw std::invalid_argument("binary draws: unexpected end of input");
+}
+
+inline std::uint32_t read_u32(std::istream& in) {
+  unsigned char bytes[4];
+  read_bytes(in, reinterpret_cast<char*>(bytes), 4);
+  std::uint32_t x = 0;
+  for (int i = 0; i < 4; ++i)
+    x |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+  return x;
+}
+
+inline std::uint64_t read_u64(std::istream& in) {
+  unsigned char bytes[8];
+  read_bytes(in, reinterpret_cast<char*>(bytes), 8);
+  std::uint64_t x = 0;
+  for (int i = 0; i < 8; ++i)
+    x |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+  return x;
+}
+
+/**
+ * Read a contiguous block of doubles straight into the destination.
+ *
+ * @param[in, out] in stream to read from
+ * @param[out] x pointer to storage for n values
+ * @param[in] n number of values
+ */
+inline void read_doubles(std::istream& in, double* x, std::size_t n) {
+  read_bytes(in, reinterpret_cast<char*>(x), n * sizeof(double));
+  if (host_is_little_endian())
+    return;
+  for (std::size_t i = 0; i < n; ++i) {
+    unsigned char bytes[8];
+    std::memcpy(bytes, x + i, 8);
+    std::uint64_t bits = 0;
+    for (int b = 0; b < 8; ++b)
+      bits |= static_cast<std::uint64_t>(bytes[b]) << (8 * b);
+    std::memcpy(x + i, &bits, sizeof(double));
+  }
+}
+
+}  // namespace binary_format
+}  // namespace io
+}  // namespace stan
+#endif
@@ -0,0 +1,219 @@
+#ifndef STAN_IO_STAN_BINARY_MAPPING_HPP
+#define STAN_IO_STAN_BINARY_MAPPING_HPP
+
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * A <code>stan_binary_mapping</code> memory maps a file in the binary
+ * draws format written by `callbacks::binary_writer`.  Construction
+ * only walks the chunk headers, so the draws stay on disk and a column
+ * is read from the mapping when it is requested, touching only the
+ * pages of its blocks in every row group.
+ *
+ * <p>The draws of a column are split over the row groups of the file
+ * and the blocks are not aligned, so columns are copied out of the
+ * mapping rather than viewed in place.
+ *
+ * <p>The binary draws format is little-endian, so it can only be
+ * mapped on little-endian platforms.
+ */
+class stan_binary_mapping {
+ private:
+  struct row_group {
+    std::uint64_t first_row;
+    std::uint32_t rows;
+    const char* data;
+  };
+
+  boost::interprocess::mapped_region region_;
+  std::vector<std::string> header_;
+  std::vector<std::string> messages_;
+  std::vector<row_group> groups_;
+  std::uint64_t num_rows_ = 0;
+
+  static void error(const std::string& msg) {
+    throw std::invalid_argument("stan_binary_mapping: " + msg);
+  }
+
+  /**
+   * Walk the chunks of the data, reading the header and messages and
+   * recording where the blocks of every row group start.
+   *
+   * @param data pointer to the data
+   * @param size number of bytes of data
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if the data is not in the binary draws
+   * format, is truncated, or repeats the header with different columns
+   */
+  void read_chunks(const char* data, size_t size, std::ostream* out) {
+    if (!binary_format::host_is_little_endian())
+      error("only supported on little-endian platforms");
+    size_t pos = 0;
+    size_t end = size;
+    auto read = [&](void* x, size_t n) {
+      if (end - pos < n)
+        error("unexpected end of input");
+      std::memcpy(x, data + pos, n);
+      pos += n;
+    };
+    auto read_u32 = [&]() {
+      std::uint32_t x;
+      read(&x, sizeof(x));
+      return x;
+    };
+    auto read_string = [&](size_t n) {
+      if (end - pos < n)
+        error("unexpected end of input");
+      std::string s(data + pos, n);
+      pos += n;
+      return s;
+    };
+
+    bool has_header = false;
+    while (pos < size) {
+      end = size;
+      char tag[binary_format::tag_size];
+      read(tag, binary_format::tag_size);
+      std::uint64_t payload;
+      read(&payload, sizeof(payload));
+      if (size - pos < payload)
+        error("unexpected end of input");
+      end = pos + payload;
+      if (std::memcmp(tag, binary_format::header_tag, binary_format::tag_size)
+          == 0) {
+        std::vector<std::string> names(read_u32());
+        for (auto& name : names)
+          name = read_string(read_u32());
+        if (has_header && names != header_)
+          error("appended header does not match the first header");
+        header_.swap(names);
+        has_header = true;
+      } else if (!has_header) {
+        error("input does not start with a header");
+      } else if (std::memcmp(tag, binary_format::rows_tag,
+                             binary_format::tag_size)
+                 == 0) {
+        std::uint32_t rows = read_u32();
+        if (payload != 4 + header_.size() * rows * sizeof(double))
+          error("row group size does not match header");
+        groups_.push_back({num_rows_, rows, data + pos});
+        num_rows_ += rows;
+      } else if (std::memcmp(tag, binary_format::message_tag,
+                             binary_format::tag_size)
+                 == 0) {
+        messages_.push_back(read_string(payload));
+      } else if (out) {
+        *out << "Warning: skipping unknown chunk "
+             << std::string(tag, binary_format::tag_size) << std::endl;
+      }
+      pos = end;
+    }
+    if (!has_header)
+      error("empty input");
+  }
+
+ public:
+  /**
+   * Construct a mapping of the specified file.
+   *
+   * @param file_name name of the file in the binary draws format
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if the file cannot be mapped or is
+   * not in the binary draws format
+   */
+  explicit stan_binary_mapping(const std::string& file_name,
+                               std::ostream* out = nullptr) {
+    try {
+      boost::interprocess::file_mapping file(file_name.c_str(),
+                                             boost::interprocess::read_only);
+      boost::interprocess::mapped_region region(file,
+                                                boost::interprocess::read_only);
+      region_.swap(region);
+    } catch (const boost::interprocess::interprocess_exception& e) {
+      error("cannot map file " + file_name + ": " + e.what());
+    }
+    read_chunks(static_cast<const char*>(region_.get_address()),
+                region_.get_size(), out);
+  }
+
+  /**
+   * Construct a mapping of the specified data in the binary draws
+   * format, which must outlive the mapping.
+   *
+   * @param data pointer to the data
+   * @param size number of bytes of data
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if the data is not in the binary draws
+   * format
+   */
+  stan_binary_mapping(const char* data, size_t size,
+                      std::ostream* out = nullptr) {
+    read_chunks(data, size, out);
+  }
+
+  const std::vector<std::string>& header() const { return header_; }
+
+  const std::vector<std::string>& messages() const { return messages_; }
+
+  std::uint64_t num_rows() const { return num_rows_; }
+
+  std::size_t num_cols() const { return header_.size(); }
+
+  /**
+   * Copy consecutive draws of a column out of the mapping.
+   *
+   * @param[in] col index of the column
+   * @param[in] first_row index of the first draw
+   * @param[in] rows number of draws
+   * @param[out] x storage for the draws
+   * @throw std::out_of_range if the column or draws are not in the file
+   */
+  void read_column(std::size_t col, std::uint64_t first_row,
+                   std::uint64_t rows, double* x) const {
+    if (col >= num_cols() || first_row > num_rows_
+        || rows > num_rows_ - first_row)
+      throw std::out_of_range("stan_binary_mapping: draws out of range");
+    const std::uint64_t last_row = first_row + rows;
+    for (const auto& group : groups_) {
+      const std::uint64_t group_end = group.first_row + group.rows;
+      if (group_end <= first_row || group.first_row >= last_row)
+        continue;
+      const std::uint64_t begin = std::max(first_row, group.first_row);
+      const std::uint64_t end = std::min(last_row, group_end);
+      const char* block = group.data + (col * group.rows + begin
+                                        - group.first_row) * sizeof(double);
+      std::memcpy(x + (begin - first_row), block,
+                  (end - begin) * sizeof(double));
+    }
+  }
+
+  /**
+   * Return the draws of a column.
+   *
+   * @param[in] col index of the column
+   * @throw std::out_of_range if the column is not in the file
+   */
+  Eigen::VectorXd column(std::size_t col) const {
+    Eigen::VectorXd x(num_rows_);
+    read_column(col, 0, num_rows_, x.data());
+    return x;
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
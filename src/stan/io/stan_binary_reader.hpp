@@ -0,0 +1,172 @@
+#ifndef STAN_IO_STAN_BINARY_READER_HPP
+#define STAN_IO_STAN_BINARY_READER_HPP
+
+#include <stan/io/stan_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Contents of a file in the binary draws format.
+ */
+struct stan_binary {
+  std::vector<std::string> header;
+  Eigen::MatrixXd samples;
+  std::vector<std::string> messages;
+};
+
+class stan_binary_chunk_reader;
+
+/**
+ * Reads from a file written by `callbacks::binary_writer`.
+ *
+ * Reading makes two passes.  The first walks the chunk headers,
+ * seeking past every payload, to validate the file and count the
+ * draws.  The second allocates the sample matrix once and reads each
+ * column block of every row group directly into its place in the
+ * matrix, so no number is ever parsed.  The stream must therefore be
+ * seekable and opened in binary mode.
+ */
+class stan_binary_reader {
+  friend class stan_binary_chunk_reader;
+
+ public:
+  stan_binary_reader() {}
+  ~stan_binary_reader() {}
+
+  /**
+   * Read a whole file.
+   *
+   * @param[in, out] in stream positioned at the first chunk
+   * @param[in, out] out stream for warnings, may be null
+   * @return header, draws and messages of the file
+   * @throw std::invalid_argument if the file is not in the binary
+   * draws format, is truncated, or repeats the header with different
+   * columns
+   */
+  static stan_binary parse(std::istream& in, std::ostream* out) {
+    stan_binary draws;
+    const std::streampos start = in.tellg();
+    in.seekg(0, std::ios_base::end);
+    const std::streampos end = in.tellg();
+    in.seekg(start);
+
+    std::uint64_t num_rows = 0;
+    bool has_header = false;
+    while (true) {
+      char tag[binary_format::tag_size];
+      if (!read_tag(in, tag))
+        break;
+      std::uint64_t payload = binary_format::read_u64(in);
+      const std::streampos payload_start = in.tellg();
+      if (static_cast<std::uint64_t>(end - payload_start) < payload)
+        throw std::invalid_argument(
+            "stan_binary_reader: unexpected end of input");
+      if (is_tag(tag, binary_format::header_tag)) {
+        read_header(in, draws.header, has_header);
+        has_header = true;
+      } else if (!has_header) {
+        throw std::invalid_argument(
+            "stan_binary_reader: input does not start with a header");
+      } else if (is_tag(tag, binary_format::rows_tag)) {
+        std::uint32_t rows = binary_format::read_u32(in);
+        if (payload != 4 + draws.header.size() * rows * sizeof(double))
+          throw std::invalid_argument(
+              "stan_binary_reader: row group size does not match header");
+        num_rows += rows;
+      } else if (is_tag(tag, binary_format::message_tag)) {
+        std::string message(payload, '\0');
+        binary_format::read_bytes(in, &message[0], payload);
+        draws.messages.push_back(message);
+      } else if (out) {
+        *out << "Warning: skipping unknown chunk "
+             << std::string(tag, binary_format::tag_size) << std::endl;
+      }
+      skip_to(in, payload_start, payload);
+    }
+    if (!has_header)
+      throw std::invalid_argument("stan_binary_reader: empty input");
+
+    in.clear();
+    in.seekg(start);
+    draws.samples.resize(num_rows, draws.header.size());
+    std::uint64_t row = 0;
+    while (true) {
+      char tag[binary_format::tag_size];
+      if (!read_tag(in, tag))
+        break;
+      std::uint64_t payload = binary_format::read_u64(in);
+      const std::streampos payload_start = in.tellg();
+      if (is_tag(tag, binary_format::rows_tag)) {
+        std::uint32_t rows = binary_format::read_u32(in);
+        for (Eigen::Index j = 0; j < draws.samples.cols(); ++j)
+          binary_format::read_doubles(in, &draws.samples(row, j), rows);
+        row += rows;
+      }
+      skip_to(in, payload_start, payload);
+    }
+    return draws;
+  }
+
+ private:
+  /**
+   * Read a chunk tag, returning false at the end of the input.
+   */
+  static bool read_tag(std::istream& in, char* tag) {
+    in.read(tag, binary_format::tag_size);
+    if (in.gcount() == 0 && in.eof())
+      return false;
+    if (static_cast<std::size_t>(in.gcount()) != binary_format::tag_size)
+      throw std::invalid_argument(
+          "stan_binary_reader: unexpected end of input");
+    return true;
+  }
+
+  static bool is_tag(const char* tag, const char* expected) {
+    return std::memcmp(tag, expected, binary_format::tag_size) == 0;
+  }
+
+  /**
+   * Read a header chunk.  A repeated header, written when a file is
+   * appended to, must match the first one.
+   */
+  static void read_header(std::istream& in, std::vector<std::string>& header,
+                          bool has_header) {
+    std::uint32_t num_cols = binary_format::read_u32(in);
+    std::vector<std::string> names(num_cols);
+    for (auto& name : names) {
+      std::uint32_t size = binary_format::read_u32(in);
+      name.resize(size);
+      binary_format::read_bytes(in, &name[0], size);
+    }
+    if (has_header && names != header)
+      throw std::invalid_argument(
+          "stan_binary_reader: appended header does not match the first "
+          "header");
+    header.swap(names);
+  }
+
+  /**
+   * Position the stream at the end of the current payload.
+   */
+  static void skip_to(std::istream& in, std::streampos payload_start,
+                      std::uint64_t payload) {
+    in.seekg(payload_start + static_cast<std::streamoff>(payload));
+    if (!in)
+      throw std::invalid_argument(
+          "stan_binary_reader: unexpected end of input");
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
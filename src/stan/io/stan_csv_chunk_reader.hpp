@@ -0,0 +1,105 @@
+#ifndef STAN_IO_STAN_CSV_CHUNK_READER_HPP
+#define STAN_IO_STAN_CSV_CHUNK_READER_HPP
+
+#include <stan/io/draws_chunk_reader.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * Reads the draws of a Stan CSV file a chunk of rows at a time, one
+ * line at a time, keeping only the selected columns.  The metadata,
+ * header and adaptation are read on construction; comment lines among
+ * the draws, such as the timing, are skipped.
+ */
+class stan_csv_chunk_reader : public draws_chunk_reader {
+ public:
+  /**
+   * Read the metadata, header and adaptation of the file and select
+   * the columns with the specified names, as written in the header.
+   *
+   * @param[in, out] in stream positioned at the start of the file
+   * @param[in] columns names of the columns to read
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if the header cannot be read or does
+   * not have one of the columns
+   */
+  stan_csv_chunk_reader(std::istream& in,
+                        const std::vector<std::string>& columns,
+                        std::ostream* out)
+      : in_(in) {
+    if (!stan_csv_reader::read_metadata(in, metadata_, out) && out)
+      *out << "Warning: non-fatal error reading metadata" << std::endl;
+    if (!stan_csv_reader::read_header(in, header_, out, false))
+      throw std::invalid_argument("Error with header of input file");
+    const std::vector<std::size_t> selected
+        = select_columns(header_, columns);
+    // parse_row converts the columns in increasing order
+    order_.resize(selected.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::sort(order_.begin(), order_.end(),
+              [&](std::size_t a, std::size_t b) {
+                return selected[a] < selected[b];
+              });
+    for (std::size_t k : order_)
+      sorted_columns_.push_back(selected[k]);
+    values_.resize(selected.size());
+    stan_csv_reader::read_adaptation(in, adaptation_, out);
+  }
+
+  std::size_t num_columns() const override { return order_.size(); }
+
+  std::size_t read(Eigen::MatrixXd& chunk, std::size_t max_rows) override {
+    if (static_cast<std::size_t>(chunk.rows()) != max_rows
+        || static_cast<std::size_t>(chunk.cols()) != order_.size())
+      chunk.resize(max_rows, order_.size());
+    std::size_t n = 0;
+    while (n < max_rows && std::getline(in_, line_)) {
+      if (line_.empty() || line_[0] == '#')
+        continue;
+      const std::size_t cols = stan_csv_reader::parse_row(
+          line_.data(), line_.data() + line_.size(), &sorted_columns_,
+          values_);
+      ++line_number_;
+      if (cols != header_.size())
+        throw std::invalid_argument(
+            "Expected " + std::to_string(header_.size())
+            + " columns, but found " + std::to_string(cols)
+            + " instead for row " + std::to_string(line_number_));
+      for (std::size_t k = 0; k < order_.size(); ++k)
+        chunk(n, order_[k]) = values_(k);
+      ++n;
+    }
+    return n;
+  }
+
+  const stan_csv_metadata& metadata() const { return metadata_; }
+
+  const std::vector<std::string>& header() const { return header_; }
+
+  const stan_csv_adaptation& adaptation() const { return adaptation_; }
+
+ private:
+  std::istream& in_;
+  stan_csv_metadata metadata_;
+  std::vector<std::string> header_;
+  stan_csv_adaptation adaptation_;
+  std::vector<std::size_t> order_;
+  std::vector<std::size_t> sorted_columns_;
+  Eigen::RowVectorXd values_;
+  std::string line_;
+  std::size_t line_number_ = 0;
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
@@ -2,12 +2,22 @@
 #define STAN_IO_STAN_CSV_READER_HPP
 
 #include <boost/algorithm/string.hpp>
+#include <stan/io/structured_binary_reader.hpp>
 #include <stan/math/prim.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
 #include <istream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 namespace stan {
@@ -74,8 +84,12 @@ struct stan_csv_metadata {
 struct stan_csv_adaptation {
   double step_size;
   Eigen::MatrixXd metric;
+  // true if the metric was written to the metric output instead of the
+  // csv file; it is then read with stan_csv_reader::read_metric
+  bool metric_in_metric_output;
 
-  stan_csv_adaptation() : step_size(0), metric(0, 0) {}
+  stan_csv_adaptation()
+      : step_size(0), metric(0, 0), metric_in_metric_output(false) {}
 };
 
 struct stan_csv_timing {
@@ -93,10 +107,35 @@ struct stan_csv {
   stan_csv_timing timing;
 };
 
+/**
+ * Options selecting the draws kept by <code>stan_csv_reader::parse</code>.
+ * The draws dropped are skipped without their values being converted.
+ */
+struct stan_csv_read_options {
+  /**
+   * True to drop the warmup draws, which are at the top of the draws
+   * when the metadata has <code>save_warmup</code> set, one per
+   * <code>thin</code> of the <code>num_warmup</code> iterations.
+   */
+  bool skip_warmup;
+
+  /**
+   * Keep every <code>thin</code>-th draw, starting with the first draw
+   * kept after the warmup; one keeps them all.
+   */
+  size_t thin;
+
+  stan_csv_read_options() : skip_warmup(false), thin(1) {}
+};
+
+class stan_csv_chunk_reader;
+
 /**
  * Reads from a Stan output csv file.
  */
 class stan_csv_reader {
+  friend class stan_csv_chunk_reader;
+
  public:
   stan_csv_reader() {}
   ~stan_csv_reader() {}
@@ -232,7 +271,7 @@ class stan_csv_reader {
     }
     ss.seekg(std::ios_base::beg);
 
-    if (lines < 4)
+    if (lines < 3)
       return false;
 
     char comment;  // Buffer for comment indicator, #
@@ -245,6 +284,15 @@ class stan_csv_reader {
     boost::trim(line);
     ss >> adaptation.step_size;
 
+    // The metric is in the metric output, read on demand
+    if (lines == 3) {
+      std::getline(ss, line);
+      std::getline(ss, line);
+      adaptation.metric_in_metric_output
+          = line.find("written to the metric output") != std::string::npos;
+      return adaptation.metric_in_metric_output;
+    }
+
     // Metric parameters
     std::getline(ss, line);
     std::getline(ss, line);
@@ -274,84 +322,251 @@ class stan_csv_reader {
       return true;
   }
 
+  /**
+   * Reads the adapted metric from a metric output written in the binary
+   * structured format by `callbacks::structured_binary_writer`, for a
+   * csv file whose adaptation section refers to it.  A diagonal metric
+   * is read as one row, as from the csv file.
+   *
+   * @param[in, out] in metric output, opened in binary mode
+   * @param[in, out] adaptation adaptation whose metric is read
+   * @return true if the metric was read
+   */
+  static bool read_metric(std::istream& in, stan_csv_adaptation& adaptation) {
+    try {
+      const structured_value state = structured_binary_reader::parse(in);
+      if (state.items.empty())
+        return false;
+      const structured_value& inv_metric = state.items.front()["inv_metric"];
+      if (inv_metric.type == structured_value::item_type::vector)
+        adaptation.metric = inv_metric.reals.transpose();
+      else
+        adaptation.metric = inv_metric.reals;
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Reads the draws and the timing comments that follow the
+   * adaptation section.
+   *
+   * The rest of the stream is read into one buffer.  Line boundaries
+   * are then found in parallel over fixed size chunks of the buffer,
+   * and the rows are converted in parallel directly into the sample
+   * matrix, which is allocated once.
+   *
+   * @param[in, out] in input stream positioned at the first draw
+   * @param[out] samples draws, one row per line; left unchanged if no
+   * draws are found or the rows differ in length
+   * @param[in, out] timing warmup and sampling times, incremented by the
+   * values of the timing comments
+   * @param[in, out] out stream for error messages, may be null
+   * @return false if there are no draws to read or the rows differ in
+   * length, true otherwise
+   */
   static bool read_samples(std::istream& in, Eigen::MatrixXd& samples,
                            stan_csv_timing& timing, std::ostream* out) {
-    std::stringstream ss;
-    std::string line;
+    return read_selected_samples(in, samples, timing, out, nullptr);
+  }
 
-    int rows = 0;
-    int cols = -1;
+  /**
+   * Reads the specified columns of the draws and the timing comments
+   * that follow the adaptation section.  The other values are skipped
+   * without being converted.
+   *
+   * @param[in, out] in input stream positioned at the first draw
+   * @param[out] samples draws of the selected columns, one row per
+   * line; left unchanged if no draws are found or the rows differ in
+   * length
+   * @param[in, out] timing warmup and sampling times, incremented by the
+   * values of the timing comments
+   * @param[in, out] out stream for error messages, may be null
+   * @param[in] columns zero-based indices of the columns to read, in
+   * increasing order
+   * @return false if there are no draws to read, the rows differ in
+   * length, or a selected column is missing, true otherwise
+   */
+  static bool read_samples(std::istream& in, Eigen::MatrixXd& samples,
+                           stan_csv_timing& timing, std::ostream* out,
+                           const std::vector<std::size_t>& columns) {
+    return read_selected_samples(in, samples, timing, out, &columns);
+  }
 
-    if (in.peek() == '#' || in.good() == false)
-      return false;
+  /**
+   * Parses the file.  A large file can be read on a background thread
+   * while it is parsed by passing a <code>prefetch_istream</code>
+   * wrapping it.
+   *
+   * @param[in] in input stream to parse
+   * @param[out] out output stream to send messages
+   */
+  static stan_csv parse(std::istream& in, std::ostream* out) {
+    return parse_selected(in, out, nullptr);
+  }
 
-    while (in.good()) {
-      bool comment_line = (in.peek() == '#');
-      bool empty_line = (in.peek() == '\n');
+  /**
+   * Parses the file, keeping only the draws of the specified columns.
+   *
+   * A column is kept if one of the specified strings is a prefix of
+   * its name, either as written in the file or prettified, so that
+   * `beta.` and `beta[` both select every element of `beta`, and
+   * `lp__` selects `lp__`.  The kept columns are in the order of the
+   * file.  The adaptation section is read in full.
+   *
+   * @param[in] in input stream to parse
+   * @param[out] out output stream to send messages
+   * @param[in] columns names or name prefixes of the columns to keep
+   */
+  static stan_csv parse(std::istream& in, std::ostream* out,
+                        const std::vector<std::string>& columns) {
+    return parse_selected(in, out, &columns);
+  }
 
-      std::getline(in, line);
+  /**
+   * Parses the file, keeping only the draws selected by the options.
+   *
+   * When the warmup draws are skipped, <code>save_warmup</code> is
+   * cleared in the metadata returned, and when the draws are thinned,
+   * <code>thin</code> is multiplied by the thinning of the options, so
+   * that the metadata describe the draws kept.
+   *
+   * @param[in] in input stream to parse
+   * @param[out] out output stream to send messages
+   * @param[in] options draws to keep
+   */
+  static stan_csv parse(std::istream& in, std::ostream* out,
+                        const stan_csv_read_options& options) {
+    return parse_selected(in, out, nullptr, options);
+  }
 
-      if (empty_line)
-        continue;
-      if (!line.length())
-        break;
+  /**
+   * Parses the file, keeping only the draws selected by the options
+   * and, of those, only the specified columns, as
+   * <code>parse(in, out, columns)</code> does.
+   *
+   * @param[in] in input stream to parse
+   * @param[out] out output stream to send messages
+   * @param[in] columns names or name prefixes of the columns to keep
+   * @param[in] options draws to keep
+   */
+  static stan_csv parse(std::istream& in, std::ostream* out,
+                        const std::vector<std::string>& columns,
+                        const stan_csv_read_options& options) {
+    return parse_selected(in, out, &columns, options);
+  }
 
-      if (comment_line) {
-        if (line.find("(Warm-up)") != std::string::npos) {
-          int left = 17;
-          int right = line.find(" seconds");
-          double warmup;
-          std::stringstream(line.substr(left, right - left)) >> warmup;
-          timing.warmup += warmup;
-        } else if (line.find("(Sampling)") != std::string::npos) {
-          int left = 17;
-          int right = line.find(" seconds");
-          double sampling;
-          std::stringstream(line.substr(left, right - left)) >> sampling;
-          timing.sampling += sampling;
-        }
-      } else {
-        ss << line << '\n';
-        int current_cols = std::count(line.begin(), line.end(), ',') + 1;
-        if (cols == -1) {
-          cols = current_cols;
-        } else if (cols != current_cols) {
-          if (out)
-            *out << "Error: expected " << cols << " columns, but found "
-                 << current_cols << " instead for row " << rows + 1
-                 << std::endl;
-          return false;
-        }
-        rows++;
+ private:
+  /**
+   * Read the draws, converting only the selected columns of the rows
+   * kept: every <code>thin</code>-th row after the first
+   * <code>skip_rows</code> rows.  Only the rows kept are checked to
+   * have as many values as the first row.
+   */
+  static bool read_selected_samples(std::istream& in, Eigen::MatrixXd& samples,
+                                    stan_csv_timing& timing, std::ostream* out,
+                                    const std::vector<std::size_t>* columns,
+                                    std::size_t skip_rows = 0,
+                                    std::size_t thin = 1) {
+    if (in.peek() == '#' || in.good() == false)
+      return false;
+
+    std::string buffer;
+    read_remaining(in, buffer);
+
+    // Lines starting in each chunk of the buffer, found in parallel.
+    const std::size_t num_chunks = buffer.size() / csv_chunk_size + 1;
+    std::vector<csv_lines> chunks(num_chunks);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_chunks),
+                      [&](const tbb::blocked_range<std::size_t>& r) {
+                        for (std::size_t k = r.begin(); k != r.end(); ++k)
+                          find_lines(buffer, k * csv_chunk_size,
+                                     (k + 1) * csv_chunk_size, chunks[k]);
+                      });
+
+    std::vector<std::pair<std::size_t, std::size_t>> rows;
+    std::vector<csv_comment> comments;
+    for (auto& chunk : chunks) {
+      for (auto& comment : chunk.comments) {
+        comment.rows_before += rows.size();
+        comments.push_back(comment);
       }
+      rows.insert(rows.end(), chunk.rows.begin(), chunk.rows.end());
+    }
 
-      in.peek();
+    // Rows kept, as indices into rows, and the first of them, whose
+    // length the others must have.
+    thin = std::max<std::size_t>(thin, 1);
+    std::vector<std::size_t> kept;
+    for (std::size_t i = skip_rows; i < rows.size(); i += thin)
+      kept.push_back(i);
+    const std::size_t first = kept.empty() ? 0 : kept[0];
+
+    std::size_t bad_row = rows.size();
+    Eigen::MatrixXd parsed;
+    if (!rows.empty()) {
+      const std::size_t cols
+          = std::count(buffer.begin() + rows[first].first,
+                       buffer.begin() + rows[first].second, ',')
+            + 1;
+      if (columns && !columns->empty() && columns->back() >= cols) {
+        if (out)
+          *out << "Error: selected column " << columns->back() + 1
+               << ", but found only " << cols << " columns" << std::endl;
+        return false;
+      }
+      parsed.resize(kept.size(), columns ? columns->size() : cols);
+      std::atomic<std::size_t> first_bad(rows.size());
+      tbb::parallel_for(
+          tbb::blocked_range<std::size_t>(0, kept.size(), 64),
+          [&](const tbb::blocked_range<std::size_t>& r) {
+            for (std::size_t k = r.begin(); k != r.end(); ++k) {
+              const std::size_t i = kept[k];
+              if (parse_row(buffer.data() + rows[i].first,
+                            buffer.data() + rows[i].second, columns,
+                            parsed.row(k))
+                  == cols)
+                continue;
+              std::size_t current = first_bad.load();
+              while (i < current
+                     && !first_bad.compare_exchange_weak(current, i)) {
+              }
+            }
+          });
+      bad_row = first_bad.load();
     }
 
-    ss.seekg(std::ios_base::beg);
+    // The timing comments are those that precede the first bad row.
+    for (const auto& comment : comments) {
+      if (comment.rows_before > bad_row)
+        break;
+      read_timing(buffer.substr(comment.begin, comment.end - comment.begin),
+                  timing);
+    }
 
-    if (rows > 0) {
-      samples.resize(rows, cols);
-      for (int row = 0; row < rows; row++) {
-        std::getline(ss, line);
-        std::stringstream ls(line);
-        for (int col = 0; col < cols; col++) {
-          std::getline(ls, line, ',');
-          boost::trim(line);
-          std::stringstream(line) >> samples(row, col);
-        }
-      }
+    if (bad_row < rows.size()) {
+      if (out)
+        *out << "Error: expected "
+             << std::count(buffer.begin() + rows[first].first,
+                           buffer.begin() + rows[first].second, ',')
+                    + 1
+             << " columns, but found "
+             << std::count(buffer.begin() + rows[bad_row].first,
+                           buffer.begin() + rows[bad_row].second, ',')
+                    + 1
+             << " instead for row " << bad_row + 1 << std::endl;
+      return false;
     }
+    if (!rows.empty())
+      samples.swap(parsed);
     return true;
   }
 
-  /**
-   * Parses the file.
-   *
-   * @param[in] in input stream to parse
-   * @param[out] out output stream to send messages
-   */
-  static stan_csv parse(std::istream& in, std::ostream* out) {
+  static stan_csv parse_selected(
+      std::istream& in, std::ostream* out,
+      const std::vector<std::string>* columns,
+      const stan_csv_read_options& options = stan_csv_read_options()) {
     stan_csv data;
 
     if (!read_metadata(in, data.metadata, out)) {
@@ -359,12 +574,37 @@ class stan_csv_reader {
         *out << "Warning: non-fatal error reading metadata" << std::endl;
     }
 
-    if (!read_header(in, data.header, out)) {
+    std::size_t skip_rows = 0;
+    if (options.skip_warmup && data.metadata.save_warmup) {
+      const std::size_t thin = std::max<std::size_t>(data.metadata.thin, 1);
+      skip_rows = (data.metadata.num_warmup + thin - 1) / thin;
+      data.metadata.save_warmup = false;
+    }
+    const std::size_t thin = std::max<std::size_t>(options.thin, 1);
+    if (data.metadata.thin > 0)
+      data.metadata.thin *= thin;
+
+    if (!read_header(in, data.header, out, columns == nullptr)) {
       if (out)
         *out << "Error: error reading header" << std::endl;
       throw std::invalid_argument("Error with header of input file in parse");
     }
 
+    std::vector<std::size_t> selected;
+    if (columns) {
+      std::vector<std::string> header;
+      for (std::size_t i = 0; i < data.header.size(); ++i) {
+        std::string name = data.header[i];
+        prettify_stan_csv_name(name);
+        if (has_prefix(data.header[i], *columns)
+            || has_prefix(name, *columns)) {
+          selected.push_back(i);
+          header.push_back(name);
+        }
+      }
+      data.header.swap(header);
+    }
+
     if (!read_adaptation(in, data.adaptation, out)) {
       if (out)
         *out << "Warning: non-fatal error reading adaptation data" << std::endl;
@@ -373,13 +613,177 @@ class stan_csv_reader {
     data.timing.warmup = 0;
     data.timing.sampling = 0;
 
-    if (!read_samples(in, data.samples, data.timing, out)) {
+    if (!read_selected_samples(in, data.samples, data.timing, out,
+                               columns ? &selected : nullptr, skip_rows,
+                               thin)) {
       if (out)
         *out << "Warning: non-fatal error reading samples" << std::endl;
     }
 
     return data;
   }
+
+  /**
+   * Return true if one of the prefixes is a prefix of the name.
+   */
+  static bool has_prefix(const std::string& name,
+                         const std::vector<std::string>& prefixes) {
+    for (const auto& prefix : prefixes)
+      if (name.compare(0, prefix.size(), prefix) == 0)
+        return true;
+    return false;
+  }
+
+  /**
+   * Size in bytes of the chunks of the buffer scanned for lines in
+   * parallel by read_samples.
+   */
+  static constexpr std::size_t csv_chunk_size = 1 << 20;
+
+  /**
+   * Comment line in the draws section, with the number of draws read
+   * before it.
+   */
+  struct csv_comment {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t rows_before;
+  };
+
+  /**
+   * Draws and comment lines starting in one chunk of the buffer, as
+   * offsets into the buffer.
+   */
+  struct csv_lines {
+    std::vector<std::pair<std::size_t, std::size_t>> rows;
+    std::vector<csv_comment> comments;
+  };
+
+  /**
+   * Read everything left in the stream into the buffer.
+   */
+  static void read_remaining(std::istream& in, std::string& buffer) {
+    const std::streampos pos = in.tellg();
+    if (pos != std::streampos(-1)) {
+      in.seekg(0, std::ios_base::end);
+      const std::streampos end = in.tellg();
+      in.seekg(pos);
+      if (end > pos)
+        buffer.reserve(static_cast<std::size_t>(end - pos));
+    }
+    std::size_t size = 0;
+    while (in.good()) {
+      buffer.resize(size + csv_chunk_size);
+      in.read(&buffer[size], csv_chunk_size);
+      size += in.gcount();
+    }
+    buffer.resize(size);
+  }
+
+  /**
+   * Find the lines starting in [chunk_begin, chunk_end) of the buffer.
+   * Empty lines are skipped.
+   */
+  static void find_lines(const std::string& buffer, std::size_t chunk_begin,
+                         std::size_t chunk_end, csv_lines& lines) {
+    const std::size_t size = buffer.size();
+    chunk_end = std::min(chunk_end, size);
+    std::size_t begin = chunk_begin;
+    if (begin > 0) {
+      begin = buffer.find('\n', begin - 1);
+      begin = begin == std::string::npos ? size : begin + 1;
+    }
+    while (begin < chunk_end) {
+      std::size_t end = buffer.find('\n', begin);
+      if (end == std::string::npos)
+        end = size;
+      if (end > begin) {
+        if (buffer[begin] == '#')
+          lines.comments.push_back({begin, end, lines.rows.size()});
+        else
+          lines.rows.emplace_back(begin, end);
+      }
+      begin = end + 1;
+    }
+  }
+
+  /**
+   * Add the time of a timing comment to the warmup or sampling time.
+   */
+  static void read_timing(const std::string& line, stan_csv_timing& timing) {
+    if (line.find("(Warm-up)") != std::string::npos) {
+      int left = 17;
+      int right = line.find(" seconds");
+      double warmup;
+      std::stringstream(line.substr(left, right - left)) >> warmup;
+      timing.warmup += warmup;
+    } else if (line.find("(Sampling)") != std::string::npos) {
+      int left = 17;
+      int right = line.find(" seconds");
+      double sampling;
+      std::stringstream(line.substr(left, right - left)) >> sampling;
+      timing.sampling += sampling;
+    }
+  }
+
+  /**
+   * Convert the comma separated values of one line.  Values beyond the
+   * size of the row are not converted.
+   *
+   * @param[in] begin first character of the line
+   * @param[in] end one past the last character of the line
+   * @param[in] columns increasing indices of the values to convert, or
+   * null to convert every value
+   * @param[out] row destination of the converted values
+   * @return number of values in the line
+   */
+  template <typename Row>
+  static std::size_t parse_row(const char* begin, const char* end,
+                               const std::vector<std::size_t>* columns,
+                               Row&& row) {
+    const std::size_t size = row.size();
+    std::size_t col = 0;
+    std::size_t next = 0;
+    while (true) {
+      const char* token_end
+          = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+      if (token_end == nullptr)
+        token_end = end;
+      if (columns == nullptr) {
+        if (col < size)
+          row(col) = parse_double(begin, token_end);
+      } else if (next < size && (*columns)[next] == col) {
+        row(next++) = parse_double(begin, token_end);
+      }
+      ++col;
+      if (token_end == end)
+        return col;
+      begin = token_end + 1;
+    }
+  }
+
+  /**
+   * Convert one value, ignoring surrounding whitespace.  A value that
+   * cannot be converted is read as zero.
+   */
+  static double parse_double(const char* begin, const char* end) {
+    while (begin < end && std::isspace(static_cast<unsigned char>(*begin)))
+      ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(end[-1])))
+      --end;
+    if (begin < end && *begin == '+')
+      ++begin;
+    double x = 0;
+    if (begin == end)
+      return x;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    if (std::from_chars(begin, end, x).ec != std::errc())
+      return 0;
+#else
+    x = std::strtod(std::string(begin, end).c_str(), nullptr);
+#endif
+    return x;
+  }
 };
 
 }  // namespace io
@@ -0,0 +1,102 @@
+#ifndef STAN_IO_STRUCTURED_BINARY_FORMAT_HPP
+#define STAN_IO_STRUCTURED_BINARY_FORMAT_HPP
+
+#include <stan/io/stan_binary_format.hpp>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace stan {
+namespace io {
+
+/**
+ * Layout of the binary structured format written by
+ * `callbacks::structured_binary_writer` and read by
+ * `io::structured_binary_reader`, the binary counterpart of the JSON
+ * written by `callbacks::json_writer`.
+ *
+ * A file starts with the tag `SBS1`, followed by a sequence of items.
+ * Every item starts with a one byte type.  All but the end of a record
+ * then have a key, written as a string: its length as an unsigned
+ * 32-bit integer followed by its bytes.  Records without a name have an
+ * empty key.  The value of the item follows the key:
+ *
+ * - begin record: nothing, the items of the record follow up to the
+ *   matching end of record.
+ * - null: nothing.
+ * - string: a string.
+ * - boolean: one byte, 0 or 1.
+ * - integer: a signed 64-bit integer.
+ * - unsigned integer: an unsigned 64-bit integer.
+ * - real: a double.
+ * - complex: the real and imaginary parts as two doubles.
+ * - array of reals, vector and row vector: the number of values as an
+ *   unsigned 64-bit integer, then the values as one block of doubles.
+ * - matrix: the number of rows and of columns as unsigned 64-bit
+ *   integers, then the values in column-major order as one block of
+ *   doubles.
+ * - array of complex values: the number of values as an unsigned 64-bit
+ *   integer, then the real and imaginary parts of every value as one
+ *   block of doubles.
+ * - array of integers: the number of values as an unsigned 64-bit
+ *   integer, then every value as a signed 32-bit integer.
+ * - array of strings: the number of strings as an unsigned 64-bit
+ *   integer, then every string.
+ *
+ * Integers and doubles are little-endian, as in the binary draws format,
+ * so large arrays and matrices cost their raw bytes to write and read.
+ */
+namespace structured_binary_format {
+
+constexpr char file_tag[binary_format::tag_size + 1] = "SBS1";
+
+/**
+ * Type of an item.
+ */
+enum class item_type : unsigned char {
+  begin_record = 1,
+  end_record,
+  null_value,
+  string_value,
+  bool_value,
+  int_value,
+  uint_value,
+  real_value,
+  complex_value,
+  real_array,
+  vector,
+  row_vector,
+  matrix,
+  complex_array,
+  int_array,
+  string_array
+};
+
+inline void write_type(std::ostream& out, item_type type) {
+  const char byte = static_cast<char>(type);
+  out.write(&byte, 1);
+}
+
+inline void write_string(std::ostream& out, const std::string& s) {
+  binary_format::write_u32(out, s.size());
+  out.write(s.data(), s.size());
+}
+
+inline item_type read_type(std::istream& in) {
+  char byte;
+  binary_format::read_bytes(in, &byte, 1);
+  return static_cast<item_type>(static_cast<unsigned char>(byte));
+}
+
+inline std::string read_string(std::istream& in) {
+  std::string s(binary_format::read_u32(in), '\0');
+  if (!s.empty())
+    binary_format::read_bytes(in, &s[0], s.size());
+  return s;
+}
+
+}  // namespace structured_binary_format
+}  // namespace io
+}  // namespace stan
+#endif
@@ -0,0 +1,196 @@
+#ifndef STAN_IO_STRUCTURED_BINARY_READER_HPP
+#define STAN_IO_STRUCTURED_BINARY_READER_HPP
+
+#include <stan/io/structured_binary_format.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace io {
+
+/**
+ * An item read from a file in the binary structured format: a record
+ * with its items, or a key with its value.  Only the member for the
+ * type of the item is set.  Arrays of reals, vectors and row vectors
+ * are kept in `reals` with one column, one row and one row respectively
+ * of a matrix of the right shape.
+ */
+struct structured_value {
+  using item_type = structured_binary_format::item_type;
+
+  item_type type = item_type::begin_record;
+  std::string key;
+  std::string string_value;
+  bool bool_value = false;
+  std::int64_t int_value = 0;
+  std::uint64_t uint_value = 0;
+  double real_value = 0;
+  std::complex<double> complex_value;
+  Eigen::MatrixXd reals;
+  std::vector<std::complex<double>> complexes;
+  std::vector<int> ints;
+  std::vector<std::string> strings;
+  std::vector<structured_value> items;
+
+  /**
+   * Return true if this is a record.
+   */
+  bool is_record() const { return type == item_type::begin_record; }
+
+  /**
+   * Return the first item of a record with the specified key.
+   *
+   * @param[in] name key of the item
+   * @throw std::out_of_range if the record has no such item
+   */
+  const structured_value& operator[](const std::string& name) const {
+    for (const auto& item : items) {
+      if (item.key == name)
+        return item;
+    }
+    throw std::out_of_range("structured record has no item " + name);
+  }
+};
+
+/**
+ * Reads a file written by `callbacks::structured_binary_writer`.
+ * Blocks of doubles are read straight into the storage of the result.
+ */
+class structured_binary_reader {
+ public:
+  /**
+   * Read a whole file, returning an unnamed record holding its
+   * top-level items.
+   *
+   * @param[in, out] in stream positioned at the start of the file,
+   * opened in binary mode
+   * @return record of the items of the file
+   * @throw std::invalid_argument if the input is not in the binary
+   * structured format, is truncated, or has unbalanced records
+   */
+  static structured_value parse(std::istream& in) {
+    char tag[binary_format::tag_size];
+    binary_format::read_bytes(in, tag, binary_format::tag_size);
+    if (std::memcmp(tag, structured_binary_format::file_tag,
+                    binary_format::tag_size)
+        != 0)
+      throw std::invalid_argument(
+          "binary structured output: not in the binary structured format");
+    structured_value root;
+    std::vector<structured_value*> open{&root};
+    while (in.peek() != std::char_traits<char>::eof()) {
+      const auto type = structured_binary_format::read_type(in);
+      if (type == item_type::end_record) {
+        if (open.size() == 1)
+          throw std::invalid_argument(
+              "binary structured output: end of a record never begun");
+        open.pop_back();
+        continue;
+      }
+      open.back()->items.emplace_back();
+      structured_value& item = open.back()->items.back();
+      item.type = type;
+      item.key = structured_binary_format::read_string(in);
+      read_value(in, item);
+      if (type == item_type::begin_record)
+        open.push_back(&item);
+    }
+    if (open.size() != 1)
+      throw std::invalid_argument(
+          "binary structured output: record not ended");
+    return root;
+  }
+
+ private:
+  using item_type = structured_binary_format::item_type;
+
+  static std::uint64_t read_size(std::istream& in) {
+    return binary_format::read_u64(in);
+  }
+
+  /**
+   * Read the value of an item whose type and key are read.
+   */
+  static void read_value(std::istream& in, structured_value& item) {
+    switch (item.type) {
+      case item_type::begin_record:
+      case item_type::null_value:
+        break;
+      case item_type::string_value:
+        item.string_value = structured_binary_format::read_string(in);
+        break;
+      case item_type::bool_value: {
+        char byte;
+        binary_format::read_bytes(in, &byte, 1);
+        item.bool_value = byte != 0;
+        break;
+      }
+      case item_type::int_value:
+        item.int_value = static_cast<std::int64_t>(binary_format::read_u64(in));
+        break;
+      case item_type::uint_value:
+        item.uint_value = binary_format::read_u64(in);
+        break;
+      case item_type::real_value:
+        binary_format::read_doubles(in, &item.real_value, 1);
+        break;
+      case item_type::complex_value: {
+        double parts[2];
+        binary_format::read_doubles(in, parts, 2);
+        item.complex_value = {parts[0], parts[1]};
+        break;
+      }
+      case item_type::real_array:
+      case item_type::vector: {
+        item.reals.resize(read_size(in), 1);
+        binary_format::read_doubles(in, item.reals.data(), item.reals.size());
+        break;
+      }
+      case item_type::row_vector: {
+        item.reals.resize(1, read_size(in));
+        binary_format::read_doubles(in, item.reals.data(), item.reals.size());
+        break;
+      }
+      case item_type::matrix: {
+        const std::uint64_t rows = read_size(in);
+        const std::uint64_t cols = read_size(in);
+        item.reals.resize(rows, cols);
+        binary_format::read_doubles(in, item.reals.data(), item.reals.size());
+        break;
+      }
+      case item_type::complex_array: {
+        item.complexes.resize(read_size(in));
+        // std::complex<double> is laid out as its real and imaginary parts
+        binary_format::read_doubles(
+            in, reinterpret_cast<double*>(item.complexes.data()),
+            2 * item.complexes.size());
+        break;
+      }
+      case item_type::int_array: {
+        item.ints.resize(read_size(in));
+        for (int& value : item.ints)
+          value = static_cast<std::int32_t>(binary_format::read_u32(in));
+        break;
+      }
+      case item_type::string_array: {
+        item.strings.resize(read_size(in));
+        for (std::string& value : item.strings)
+          value = structured_binary_format::read_string(in);
+        break;
+      }
+      default:
+        throw std::invalid_argument(
+            "binary structured output: unknown item type");
+    }
+  }
+};
+
+}  // namespace io
+}  // namespace stan
+#endif
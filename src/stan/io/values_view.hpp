@@ -0,0 +1,143 @@
+#ifndef STAN_IO_VALUES_VIEW_HPP
+#define STAN_IO_VALUES_VIEW_HPP
+
+#include <stan/io/aligned_vector.hpp>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace stan {
+
+namespace io {
+
+/**
+ * A read-only, contiguous view of the values of a variable in a
+ * <code>var_context</code>.
+ *
+ * <p>When the context stores the values with the requested type, the
+ * view refers to that storage without copying it and is only valid
+ * while the context is alive and unchanged.  Otherwise, for instance
+ * when integer values are read as floating point values, the view owns
+ * a converted copy of the values.
+ *
+ * <p>The values stored by <code>json_data</code>,
+ * <code>array_var_context</code> and <code>dump</code>, and the copies
+ * owned by views, are aligned to <code>data_alignment</code> bytes and
+ * padded, see <code>is_aligned</code>.
+ *
+ * <p>Views can be moved but not copied.
+ *
+ * @tparam T type of the values
+ */
+template <typename T>
+class values_view {
+ public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  /**
+   * Construct an empty view.
+   */
+  values_view() : data_(nullptr), size_(0) {}
+
+  /**
+   * Construct a view of values stored elsewhere.
+   *
+   * @param data pointer to the first value
+   * @param size number of values
+   */
+  values_view(const T* data, size_t size) : data_(data), size_(size) {}
+
+  /**
+   * Construct a view of values stored in a vector, which must outlive
+   * the view.
+   *
+   * @param values values to view
+   */
+  explicit values_view(const std::vector<T>& values)
+      : data_(values.data()), size_(values.size()) {}
+
+  /**
+   * Construct a view of values stored in an aligned vector, which must
+   * outlive the view.
+   *
+   * @param values values to view
+   */
+  explicit values_view(const aligned_vector<T>& values)
+      : data_(values.data()), size_(values.size()) {}
+
+  /**
+   * Construct a view owning an aligned copy of the specified values.
+   *
+   * @param values values to own
+   */
+  explicit values_view(std::vector<T>&& values)
+      : storage_(values.begin(), values.end()),
+        data_(storage_.data()),
+        size_(storage_.size()) {}
+
+  /**
+   * Construct a view owning the specified values.
+   *
+   * @param values values to own
+   */
+  explicit values_view(aligned_vector<T>&& values)
+      : storage_(std::move(values)),
+        data_(storage_.data()),
+        size_(storage_.size()) {}
+
+  values_view(const values_view&) = delete;
+  values_view& operator=(const values_view&) = delete;
+  values_view(values_view&&) = default;
+  values_view& operator=(values_view&&) = default;
+
+  /**
+   * Return a pointer to the first value.
+   */
+  const T* data() const { return data_; }
+
+  /**
+   * Return the number of values.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * Return <code>true</code> if there are no values.
+   */
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * Return <code>true</code> if the view owns a copy of the values
+   * instead of referring to the storage of the context.
+   */
+  bool owns_values() const { return !storage_.empty(); }
+
+  /**
+   * Return <code>true</code> if the values start on a boundary of
+   * <code>data_alignment</code> bytes, so that they can be mapped as an
+   * <code>Eigen::Map</code> with <code>Eigen::Aligned64</code>.
+   */
+  bool is_aligned() const { return is_data_aligned(data_); }
+
+  const T& operator[](size_t n) const { return data_[n]; }
+
+  const_iterator begin() const { return data_; }
+
+  const_iterator end() const { return data_ + size_; }
+
+  /**
+   * Return a copy of the values.
+   */
+  std::vector<T> to_vector() const { return std::vector<T>(begin(), end()); }
+
+ private:
+  aligned_vector<T> storage_;
+  const T* data_;
+  size_t size_;
+};
+
+}  // namespace io
+
+}  // namespace stan
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef STAN_IO_VAR_CONTEXT_HPP
 #define STAN_IO_VAR_CONTEXT_HPP
 
+#include <stan/io/values_view.hpp>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -56,6 +57,23 @@ class var_context {
    */
   virtual std::vector<double> vals_r(const std::string& name) const = 0;
 
+  /**
+   * Return a read-only view of the floating point values for the
+   * variable of the specified name in last-index-major order, or an
+   * empty view if there is no variable of that name.
+   *
+   * <p>Contexts storing the values as floating point values return a
+   * view of their storage without copying it, which is valid while the
+   * context is unchanged.  The default implementation owns the values
+   * returned by <code>vals_r()</code>.
+   *
+   * @param name Name of variable.
+   * @return View of the values for the named variable.
+   */
+  virtual values_view<double> vals_r_view(const std::string& name) const {
+    return values_view<double>(vals_r(name));
+  }
+
   /**
    * Return the complex floating point values for the variable of the
    * specified variable name in last-index-major order.  This
@@ -101,6 +119,23 @@ class var_context {
    */
   virtual std::vector<int> vals_i(const std::string& name) const = 0;
 
+  /**
+   * Return a read-only view of the integer values for the variable of
+   * the specified name in last-index-major order, or an empty view if
+   * the variable is not defined.
+   *
+   * <p>Contexts storing the values as integers return a view of their
+   * storage without copying it, which is valid while the context is
+   * unchanged.  The default implementation owns the values returned by
+   * <code>vals_i()</code>.
+   *
+   * @param name Name of variable.
+   * @return View of the integer values.
+   */
+  virtual values_view<int> vals_i_view(const std::string& name) const {
+    return values_view<int>(vals_i(name));
+  }
+
   /**
    * Return the dimensions of the specified floating point variable.
    * If the variable doesn't exist (or if it is a scalar), the
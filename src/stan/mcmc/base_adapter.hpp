@@ -1,12 +1,14 @@
 #ifndef STAN_MCMC_BASE_ADAPTER_HPP
 #define STAN_MCMC_BASE_ADAPTER_HPP
 
+#include <chrono>
+
 namespace stan {
 namespace mcmc {
 
 class base_adapter {
  public:
-  base_adapter() : adapt_flag_(false) {}
+  base_adapter() : adapt_flag_(false), adaptation_time_(0) {}
 
   virtual void engage_adaptation() { adapt_flag_ = true; }
 
@@ -14,8 +16,26 @@ class base_adapter {
 
   bool adapting() { return adapt_flag_; }
 
+  /**
+   * Return the wall-clock time in seconds spent updating the
+   * adaptation since construction.
+   */
+  double adaptation_time() const { return adaptation_time_; }
+
  protected:
   bool adapt_flag_;
+  double adaptation_time_;
+
+  /**
+   * Add the time elapsed since start to the adaptation time.
+   *
+   * @param start time at which the adaptation update began
+   */
+  void add_adaptation_time(std::chrono::steady_clock::time_point start) {
+    adaptation_time_ += std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  }
 };
 
 }  // namespace mcmc
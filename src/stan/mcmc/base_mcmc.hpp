@@ -3,7 +3,9 @@
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/diagnostic_fields.hpp>
 #include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/sampler_instrumentation.hpp>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -19,6 +21,16 @@ class base_mcmc {
 
   virtual sample transition(sample& init_sample, callbacks::logger& logger) = 0;
 
+  /**
+   * Take the storage of a sample that is about to be replaced by the
+   * draw of the last transition, for the next transition to write its
+   * draw into instead of allocating.  The continuous parameters of the
+   * sample are left unspecified.
+   *
+   * @param[in, out] s sample no longer needed
+   */
+  virtual void recycle(sample& s) {}
+
   virtual void get_sampler_param_names(std::vector<std::string>& names) {}
 
   virtual void get_sampler_params(std::vector<double>& values) {}
@@ -29,6 +41,30 @@ class base_mcmc {
       std::vector<std::string>& model_names, std::vector<std::string>& names) {}
 
   virtual void get_sampler_diagnostics(std::vector<double>& values) {}
+
+  /**
+   * Select the blocks of the state written as diagnostics, for samplers
+   * whose diagnostics are the state of a point in phase space.  It
+   * must be called before the diagnostic names are taken.
+   *
+   * @param[in] fields blocks of the state written
+   */
+  virtual void set_diagnostic_fields(const diagnostic_fields& fields) {}
+
+  /**
+   * Ask for the working vectors of the sampler to be backed with
+   * transparent huge pages, for samplers that keep vectors the size of
+   * the model.
+   */
+  virtual void enable_huge_pages() {}
+
+  /**
+   * Add the gradient evaluations, leapfrog steps and tree depth of the
+   * work done since the previous call to the instrumentation record.
+   *
+   * @param[in,out] stats instrumentation record
+   */
+  virtual void record_instrumentation(sampler_instrumentation& stats) {}
 };
 
 }  // namespace mcmc
@@ -0,0 +1,145 @@
+#ifndef STAN_MCMC_BLOCK_WELFORD_VAR_ESTIMATOR_HPP
+#define STAN_MCMC_BLOCK_WELFORD_VAR_ESTIMATOR_HPP
+
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
+#include <stan/mcmc/huge_pages.hpp>
+#include <cstddef>
+
+namespace stan {
+
+namespace mcmc {
+
+/**
+ * Streaming estimator of the mean and variance of a sequence of draws,
+ * with the interface of <code>stan::math::welford_var_estimator</code>.
+ *
+ * The draws are gathered into blocks of B columns and each full block
+ * is folded in with vectorized column reductions of its centered
+ * draws, combined with the running moments by the pairwise update of
+ * Chan, Golub and LeVeque.  Pending draws are folded in before the
+ * moments are read.
+ */
+class block_welford_var_estimator {
+ public:
+  /**
+   * @param n number of dimensions
+   * @param block_size number of draws folded in at a time
+   */
+  explicit block_welford_var_estimator(int n, int block_size = 32)
+      : m_(Eigen::VectorXd::Zero(n)),
+        m2_(Eigen::VectorXd::Zero(n)),
+        block_(n, block_size > 0 ? block_size : 1),
+        num_samples_(0),
+        num_buffered_(0) {}
+
+  void restart() {
+    num_samples_ = 0;
+    num_buffered_ = 0;
+    m_.setZero();
+    m2_.setZero();
+  }
+
+  void add_sample(const Eigen::VectorXd& q) {
+    block_.col(num_buffered_) = q;
+    if (++num_buffered_ == block_.cols())
+      fold_block();
+  }
+
+  int num_samples() const { return num_samples_ + num_buffered_; }
+
+  /**
+   * Advise the moments and the block of pending draws to be backed with
+   * huge pages, as in <code>stan::mcmc::advise_huge_pages</code>.
+   *
+   * @return number of bytes advised
+   */
+  std::size_t advise_huge_pages() {
+    return mcmc::advise_huge_pages(m_) + mcmc::advise_huge_pages(m2_)
+           + mcmc::advise_huge_pages(block_);
+  }
+
+  void sample_mean(Eigen::VectorXd& mean) {
+    fold_block();
+    mean = m_;
+  }
+
+  void sample_variance(Eigen::VectorXd& var) {
+    fold_block();
+    if (num_samples_ > 1)
+      var = m2_ / (num_samples_ - 1.0);
+  }
+
+  /**
+   * Write the running moments and the pending draws.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    writer.write(num_samples_);
+    writer.write(m_);
+    writer.write(m2_);
+    writer.write(block_.leftCols(num_buffered_));
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().  The block size
+   * may differ from the one of the written estimator.
+   *
+   * @param reader checkpoint reader
+   * @throw std::runtime_error if the number of dimensions differs
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    const Eigen::Index n = m_.size();
+    reader.read(num_samples_);
+    reader.read(m_, n, 1);
+    reader.read(m2_, n, 1);
+    Eigen::MatrixXd pending;
+    reader.read(pending);
+    if (pending.rows() != n)
+      throw std::runtime_error(
+          "Checkpoint does not match the dimensions of the sampler.");
+    num_buffered_ = 0;
+    for (Eigen::Index i = 0; i < pending.cols(); ++i)
+      add_sample(pending.col(i));
+  }
+
+ private:
+  /**
+   * Fold the pending draws into the running moments.
+   */
+  void fold_block() {
+    if (num_buffered_ == 0)
+      return;
+    const double n = num_samples_;
+    const double b = num_buffered_;
+    block_mean_ = block_.leftCols(num_buffered_).rowwise().mean();
+    delta_ = block_mean_ - m_;
+
+    m2_ += (block_.leftCols(num_buffered_).colwise() - block_mean_)
+               .rowwise()
+               .squaredNorm()
+           + (n * b / (n + b)) * delta_.cwiseAbs2();
+    m_ += (b / (n + b)) * delta_;
+
+    num_samples_ += num_buffered_;
+    num_buffered_ = 0;
+  }
+
+  Eigen::VectorXd m_;
+  Eigen::VectorXd m2_;
+
+  // Pending draws, one per column, and buffers for folding them in
+  Eigen::MatrixXd block_;
+  Eigen::VectorXd block_mean_;
+  Eigen::VectorXd delta_;
+
+  int num_samples_;
+  int num_buffered_;
+};
+
+}  // namespace mcmc
+
+}  // namespace stan
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef STAN_MCMC_CHAIN_REDUCER_HPP
+#define STAN_MCMC_CHAIN_REDUCER_HPP
+
+#include <stan/math/prim.hpp>
+#include <cstddef>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Reduction over the processes that share a pooled warmup, for chains
+ * that all run in this process.  A reducer sums values over every
+ * process in place and returns the offset of the chains of this process
+ * among all chains; with a single process both are the identity.
+ *
+ * Every process must call the reducer the same number of times with
+ * values of the same sizes.
+ */
+class local_chain_reducer {
+ public:
+  /**
+   * Sum the value over all processes in place.
+   *
+   * @param[in,out] x value to sum
+   */
+  void sum(double& x) const {}
+
+  /**
+   * Sum the matrix over all processes elementwise in place.
+   *
+   * @tparam Derived type of the matrix
+   * @param[in,out] x matrix to sum
+   */
+  template <typename Derived>
+  void sum(Eigen::MatrixBase<Derived>& x) const {}
+
+  /**
+   * Return the number of chains run by the processes before this one.
+   *
+   * @param num_chains number of chains run by this process
+   * @return index of the first chain of this process among all chains
+   */
+  size_t chain_offset(size_t num_chains) const { return 0; }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -1,6 +1,7 @@
 #ifndef STAN_MCMC_CHAINS_HPP
 #define STAN_MCMC_CHAINS_HPP
 
+#include <stan/io/stan_binary_reader.hpp>
 #include <stan/io/stan_csv_reader.hpp>
 #include <stan/math/prim.hpp>
 #include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
@@ -8,14 +9,17 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
-#include <boost/accumulators/statistics/tail_quantile.hpp>
-#include <boost/accumulators/statistics/p_square_quantile.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
 #include <boost/accumulators/statistics/covariance.hpp>
 #include <boost/accumulators/statistics/variates/covariate.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
 #include <algorithm>
 #include <cmath>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <stdexcept>
 #include <string>
@@ -28,6 +32,31 @@ namespace stan {
 namespace mcmc {
 using Eigen::Dynamic;
 
+/**
+ * Summary statistics of every parameter of an <code>mcmc::chains</code>
+ * object over the kept samples of all chains, as returned by
+ * <code>chains::summary()</code>.  Entry <code>i</code> of each member
+ * belongs to parameter <code>i</code>.
+ */
+struct chains_summary {
+  Eigen::VectorXd mean;
+  Eigen::VectorXd sd;
+
+  /**
+   * Quantiles, one row per parameter and one column per probability
+   */
+  Eigen::MatrixXd quantiles;
+  Eigen::VectorXd effective_sample_size;
+  Eigen::VectorXd split_potential_scale_reduction;
+
+  /**
+   * Rank normalized split potential scale reduction, one row per
+   * parameter with the bulk in the first column and the tail in the
+   * second
+   */
+  Eigen::MatrixXd split_potential_scale_reduction_rank;
+};
+
 /**
  * An <code>mcmc::chains</code> object stores parameter names and
  * dimensionalities along with samples from multiple chains.
@@ -41,12 +70,27 @@ using Eigen::Dynamic;
  * as global or single-chain read or write methods.
  *
  * <p><b>Storage Order</b>: Storage is column/last-index major.
+ * The storage of a chain grows geometrically, so appending draws to a
+ * chain in batches takes amortized constant time per draw.
+ *
+ * <p><b>Storage Type</b>: Draws are stored as <code>T</code>, which
+ * is <code>double</code> or <code>float</code>.  Storing them as
+ * <code>float</code> halves the memory of the chains, which loses
+ * nothing for draws read from CSV files written with the default six
+ * significant digits.  Draws are returned and statistics are
+ * accumulated in <code>double</code> in either case.
+ *
+ * @tparam T type of the stored draws
  */
-template <typename Unused = void*>
+template <typename T = double>
 class chains {
  private:
+  using matrix_t = Eigen::Matrix<T, Dynamic, Dynamic>;
+
   std::vector<std::string> param_names_;
-  Eigen::Matrix<Eigen::MatrixXd, Dynamic, 1> samples_;
+  // Rows past num_samples_ are spare capacity for appended draws
+  Eigen::Matrix<matrix_t, Dynamic, 1> samples_;
+  Eigen::VectorXi num_samples_;
   Eigen::VectorXi warmup_;
 
   static double mean(const Eigen::VectorXd& x) {
@@ -108,64 +152,16 @@ class chains {
   }
 
   static double quantile(const Eigen::VectorXd& x, const double prob) {
-    using boost::accumulators::accumulator_set;
-    using boost::accumulators::left;
-    using boost::accumulators::quantile;
-    using boost::accumulators::quantile_probability;
-    using boost::accumulators::right;
-    using boost::accumulators::stats;
-    using boost::accumulators::tag::tail;
-    using boost::accumulators::tag::tail_quantile;
-    double M = x.rows();
-    // size_t cache_size = std::min(prob, 1-prob)*M + 2;
-    size_t cache_size = M;
-
-    if (prob < 0.5) {
-      accumulator_set<double, stats<tail_quantile<left> > > acc(
-          tail<left>::cache_size = cache_size);
-      for (int i = 0; i < M; i++)
-        acc(x(i));
-      return quantile(acc, quantile_probability = prob);
-    }
-    accumulator_set<double, stats<tail_quantile<right> > > acc(
-        tail<right>::cache_size = cache_size);
-    for (int i = 0; i < M; i++)
-      acc(x(i));
-    return quantile(acc, quantile_probability = prob);
+    std::vector<double> draws(x.data(), x.data() + x.size());
+    return selected_quantile(draws, prob);
   }
 
   static Eigen::VectorXd quantiles(const Eigen::VectorXd& x,
                                    const Eigen::VectorXd& probs) {
-    using boost::accumulators::accumulator_set;
-    using boost::accumulators::left;
-    using boost::accumulators::quantile;
-    using boost::accumulators::quantile_probability;
-    using boost::accumulators::right;
-    using boost::accumulators::stats;
-    using boost::accumulators::tag::tail;
-    using boost::accumulators::tag::tail_quantile;
-    double M = x.rows();
-
-    // size_t cache_size = M/2 + 2;
-    size_t cache_size = M;  // 2 + 2;
-
-    accumulator_set<double, stats<tail_quantile<left> > > acc_left(
-        tail<left>::cache_size = cache_size);
-    accumulator_set<double, stats<tail_quantile<right> > > acc_right(
-        tail<right>::cache_size = cache_size);
-
-    for (int i = 0; i < M; i++) {
-      acc_left(x(i));
-      acc_right(x(i));
-    }
-
+    std::vector<double> draws(x.data(), x.data() + x.size());
+    std::vector<std::pair<size_t, int>> order;
     Eigen::VectorXd q(probs.size());
-    for (int i = 0; i < probs.size(); i++) {
-      if (probs(i) < 0.5)
-        q(i) = quantile(acc_left, quantile_probability = probs(i));
-      else
-        q(i) = quantile(acc_right, quantile_probability = probs(i));
-    }
+    selected_quantiles(draws, probs, order, q);
     return q;
   }
 
@@ -245,6 +241,41 @@ class chains {
     return sqrt((var_between / var_within + n - 1) / n);
   }
 
+  /**
+   * Add empty chains up to the specified number of chains, keeping the
+   * storage of the existing ones.
+   *
+   * @param n number of chains
+   */
+  void resize_chains(const int n) {
+    const int old_n = num_chains();
+
+    // Need this block for Windows. conservativeResize
+    // does not keep the references.
+    Eigen::Matrix<matrix_t, Dynamic, 1> samples_copy(old_n);
+    Eigen::VectorXi num_samples_copy(old_n);
+    Eigen::VectorXi warmup_copy(old_n);
+    for (int i = 0; i < old_n; i++) {
+      samples_copy(i).swap(samples_(i));
+      num_samples_copy(i) = num_samples_(i);
+      warmup_copy(i) = warmup_(i);
+    }
+
+    samples_.resize(n);
+    num_samples_.resize(n);
+    warmup_.resize(n);
+    for (int i = 0; i < old_n; i++) {
+      samples_(i).swap(samples_copy(i));
+      num_samples_(i) = num_samples_copy(i);
+      warmup_(i) = warmup_copy(i);
+    }
+    for (int i = old_n; i < n; i++) {
+      samples_(i) = matrix_t(0, num_params());
+      num_samples_(i) = 0;
+      warmup_(i) = 0;
+    }
+  }
+
  public:
   explicit chains(const std::vector<std::string>& param_names)
       : param_names_(param_names) {}
@@ -255,6 +286,11 @@ class chains {
       add(stan_csv);
   }
 
+  explicit chains(const stan::io::stan_binary& draws) : chains(draws.header) {
+    if (draws.samples.rows() > 0)
+      add(draws);
+  }
+
   inline int num_chains() const { return samples_.size(); }
 
   inline int num_params() const { return param_names_.size(); }
@@ -281,7 +317,7 @@ class chains {
 
   int warmup(const int chain) const { return warmup_(chain); }
 
-  int num_samples(const int chain) const { return samples_(chain).rows(); }
+  int num_samples(const int chain) const { return num_samples_(chain); }
 
   int num_samples() const {
     int n = 0;
@@ -306,33 +342,31 @@ class chains {
       throw std::invalid_argument(
           "add(chain, sample): number of columns"
           " in sample does not match chains");
-    if (num_chains() == 0 || chain >= num_chains()) {
-      int n = num_chains();
-
-      // Need this block for Windows. conservativeResize
-      // does not keep the references.
-      Eigen::Matrix<Eigen::MatrixXd, Dynamic, 1> samples_copy(num_chains());
-      Eigen::VectorXi warmup_copy(num_chains());
-      for (int i = 0; i < n; i++) {
-        samples_copy(i) = samples_(i);
-        warmup_copy(i) = warmup_(i);
-      }
+    if (num_chains() == 0 || chain >= num_chains())
+      resize_chains(chain + 1);
+    int row = num_samples_(chain);
+    if (row + sample.rows() > samples_(chain).rows())
+      reserve(chain, std::max<Eigen::Index>(2 * samples_(chain).rows(),
+                                            row + sample.rows()));
+    samples_(chain).middleRows(row, sample.rows()) = sample.cast<T>();
+    num_samples_(chain) = row + sample.rows();
+  }
 
-      samples_.resize(chain + 1);
-      warmup_.resize(chain + 1);
-      for (int i = 0; i < n; i++) {
-        samples_(i) = samples_copy(i);
-        warmup_(i) = warmup_copy(i);
-      }
-      for (int i = n; i < chain + 1; i++) {
-        samples_(i) = Eigen::MatrixXd(0, num_params());
-        warmup_(i) = 0;
-      }
-    }
-    int row = samples_(chain).rows();
-    Eigen::MatrixXd new_samples(row + sample.rows(), num_params());
-    new_samples << samples_(chain), sample;
-    samples_(chain) = new_samples;
+  /**
+   * Reserve storage for at least the specified number of draws in an
+   * existing chain, so that appending up to that many draws does not
+   * reallocate.
+   *
+   * @param chain index of the chain
+   * @param capacity number of draws to hold
+   */
+  void reserve(const int chain, const int capacity) {
+    if (capacity <= samples_(chain).rows())
+      return;
+    matrix_t grown(capacity, num_params());
+    grown.topRows(num_samples_(chain))
+        = samples_(chain).topRows(num_samples_(chain));
+    samples_(chain).swap(grown);
   }
 
   void add(const Eigen::MatrixXd& sample) {
@@ -383,8 +417,93 @@ class chains {
       set_warmup(num_chains() - 1, stan_csv.metadata.num_warmup);
   }
 
+  /**
+   * Add one chain per parsed stan CSV file.  The headers are all
+   * checked before any chain is added, the storage of the chains is
+   * resized once, and the draws of each file are moved into their
+   * chain without being copied when they are stored as doubles.
+   *
+   * @param[in, out] stan_csvs parsed files, whose draws are taken
+   * @throw std::invalid_argument if the header of a file does not
+   * match the chains
+   */
+  void add(std::vector<stan::io::stan_csv>&& stan_csvs) {
+    for (const auto& stan_csv : stan_csvs) {
+      if (stan_csv.header != param_names_)
+        throw std::invalid_argument(
+            "add(stan_csvs): header of a file does not match chains");
+    }
+    int chain = num_chains();
+    resize_chains(chain + stan_csvs.size());
+    for (auto& stan_csv : stan_csvs) {
+      num_samples_(chain) = stan_csv.samples.rows();
+      take_samples(samples_(chain), stan_csv.samples);
+      if (stan_csv.metadata.save_warmup)
+        warmup_(chain) = stan_csv.metadata.num_warmup;
+      ++chain;
+    }
+  }
+
+  /**
+   * Read stan CSV files into chains, one chain per file.  The files are
+   * parsed concurrently, the headers are checked once they are all
+   * read, and the draws of each file are moved into their chain.  The
+   * messages of the reader for each file are written to the output
+   * stream in the order of the files.
+   *
+   * @param[in] file_names names of the files
+   * @param[in, out] out stream for messages of the reader, may be null
+   * @return chains with the parameter names of the first file
+   * @throw std::invalid_argument if there are no files, a file cannot
+   * be opened or read, or the headers of the files differ
+   */
+  static chains read_stan_csv_files(const std::vector<std::string>& file_names,
+                                    std::ostream* out = nullptr) {
+    if (file_names.empty())
+      throw std::invalid_argument("read_stan_csv_files: no files");
+    const size_t n = file_names.size();
+    std::vector<stan::io::stan_csv> stan_csvs(n);
+    std::vector<std::string> messages(n);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, n, 1),
+        [&](const tbb::blocked_range<size_t>& r) {
+          for (size_t i = r.begin(); i != r.end(); ++i) {
+            std::ifstream in(file_names[i]);
+            if (!in)
+              throw std::invalid_argument("read_stan_csv_files: cannot open "
+                                          + file_names[i]);
+            std::stringstream msg;
+            stan_csvs[i] = stan::io::stan_csv_reader::parse(in, &msg);
+            messages[i] = msg.str();
+          }
+        });
+    if (out) {
+      for (const auto& message : messages)
+        *out << message;
+    }
+    chains result(stan_csvs[0].header);
+    result.add(std::move(stan_csvs));
+    return result;
+  }
+
+  void add(const stan::io::stan_binary& draws) {
+    if (draws.header.size() != num_params())
+      throw std::invalid_argument(
+          "add(stan_binary): number of columns in"
+          " sample does not match chains");
+    for (int i = 0; i < num_params(); i++) {
+      if (param_names_[i] != draws.header[i]) {
+        std::stringstream ss;
+        ss << "add(stan_binary): header " << param_names_[i]
+           << " does not match chain's header (" << draws.header[i] << ")";
+        throw std::invalid_argument(ss.str());
+      }
+    }
+    add(draws.samples);
+  }
+
   Eigen::VectorXd samples(const int chain, const int index) const {
-    return samples_(chain).col(index).bottomRows(num_kept_samples(chain));
+    return kept_samples(chain, index).template cast<double>();
   }
 
   Eigen::VectorXd samples(const int index) const {
@@ -392,7 +511,8 @@ class chains {
     int start = 0;
     for (int chain = 0; chain < num_chains(); chain++) {
       int n = num_kept_samples(chain);
-      s.middleRows(start, n) = samples_(chain).col(index).bottomRows(n);
+      s.middleRows(start, n)
+          = kept_samples(chain, index).template cast<double>();
       start += n;
     }
     return s;
@@ -514,6 +634,44 @@ class chains {
     return quantiles(index(name), probs);
   }
 
+  /**
+   * Return the quantiles of every parameter, with one row per
+   * parameter and one column per probability, as
+   * <code>quantiles(index, probs)</code> returns them.  The parameters
+   * are processed in parallel, each thread selecting the quantiles
+   * from its own copy of one parameter's draws at a time.
+   *
+   * @param probs probabilities of the quantiles
+   * @return quantiles of the parameters
+   */
+  Eigen::MatrixXd quantiles(const Eigen::VectorXd& probs) const {
+    const int n_params = num_params();
+    const int n_chains = num_chains();
+    Eigen::MatrixXd result(n_params, probs.size());
+    struct scratch {
+      std::vector<double> draws;
+      std::vector<std::pair<size_t, int>> order;
+    };
+    tbb::enumerable_thread_specific<scratch> scratches;
+    tbb::parallel_for(tbb::blocked_range<int>(0, n_params),
+                      [&](const tbb::blocked_range<int>& r) {
+                        scratch& local = scratches.local();
+                        for (int index = r.begin(); index != r.end();
+                             ++index) {
+                          local.draws.clear();
+                          for (int chain = 0; chain < n_chains; ++chain) {
+                            auto draws = kept_samples(chain, index);
+                            local.draws.insert(local.draws.end(),
+                                               draws.data(),
+                                               draws.data() + draws.size());
+                          }
+                          selected_quantiles(local.draws, probs, local.order,
+                                             result.row(index));
+                        }
+                      });
+    return result;
+  }
+
   Eigen::Vector2d central_interval(int chain, int index, double prob) const {
     double low_prob = (1 - prob) / 2;
     double high_prob = 1 - low_prob;
@@ -563,11 +721,11 @@ class chains {
     int n_chains = num_chains();
     std::vector<const double*> draws(n_chains);
     std::vector<size_t> sizes(n_chains);
+    std::vector<Eigen::VectorXd> buffers(n_chains);
     int n_kept_samples = 0;
     for (int chain = 0; chain < n_chains; ++chain) {
       n_kept_samples = num_kept_samples(chain);
-      draws[chain]
-          = samples_(chain).col(index).bottomRows(n_kept_samples).data();
+      draws[chain] = kept_draws(chain, index, buffers[chain]);
       sizes[chain] = n_kept_samples;
     }
     return analyze::compute_effective_sample_size(draws, sizes);
@@ -581,11 +739,11 @@ class chains {
     int n_chains = num_chains();
     std::vector<const double*> draws(n_chains);
     std::vector<size_t> sizes(n_chains);
+    std::vector<Eigen::VectorXd> buffers(n_chains);
     int n_kept_samples = 0;
     for (int chain = 0; chain < n_chains; ++chain) {
       n_kept_samples = num_kept_samples(chain);
-      draws[chain]
-          = samples_(chain).col(index).bottomRows(n_kept_samples).data();
+      draws[chain] = kept_draws(chain, index, buffers[chain]);
       sizes[chain] = n_kept_samples;
     }
     return analyze::compute_split_effective_sample_size(draws, sizes);
@@ -600,11 +758,11 @@ class chains {
     int n_chains = num_chains();
     std::vector<const double*> draws(n_chains);
     std::vector<size_t> sizes(n_chains);
+    std::vector<Eigen::VectorXd> buffers(n_chains);
     int n_kept_samples = 0;
     for (int chain = 0; chain < n_chains; ++chain) {
       n_kept_samples = num_kept_samples(chain);
-      draws[chain]
-          = samples_(chain).col(index).bottomRows(n_kept_samples).data();
+      draws[chain] = kept_draws(chain, index, buffers[chain]);
       sizes[chain] = n_kept_samples;
     }
 
@@ -615,11 +773,11 @@ class chains {
     int n_chains = num_chains();
     std::vector<const double*> draws(n_chains);
     std::vector<size_t> sizes(n_chains);
+    std::vector<Eigen::VectorXd> buffers(n_chains);
     int n_kept_samples = 0;
     for (int chain = 0; chain < n_chains; ++chain) {
       n_kept_samples = num_kept_samples(chain);
-      draws[chain]
-          = samples_(chain).col(index).bottomRows(n_kept_samples).data();
+      draws[chain] = kept_draws(chain, index, buffers[chain]);
       sizes[chain] = n_kept_samples;
     }
 
@@ -634,6 +792,203 @@ class chains {
   double split_potential_scale_reduction(const std::string& name) const {
     return split_potential_scale_reduction(index(name));
   }
+
+  /**
+   * Return the mean, standard deviation, quantiles, effective sample
+   * size and split potential scale reductions of every parameter.
+   *
+   * The values are those of <code>mean(index)</code>,
+   * <code>sd(index)</code>, <code>quantiles(index, probs)</code>,
+   * <code>effective_sample_size(index)</code>,
+   * <code>split_potential_scale_reduction(index)</code> and
+   * <code>split_potential_scale_reduction_rank(index)</code>, up to
+   * rounding, but are computed in parallel over the parameters.  The
+   * moments and diagnostics are read directly from the stored draws;
+   * only the quantiles need a copy of one parameter's draws at a time
+   * per thread.
+   *
+   * @param probs probabilities of the quantiles
+   * @return summary with one entry per parameter
+   */
+  chains_summary summary(const Eigen::VectorXd& probs) const {
+    const int n_params = num_params();
+    const int n_chains = num_chains();
+    const int n_kept = num_kept_samples();
+    chains_summary result;
+    result.mean.resize(n_params);
+    result.sd.resize(n_params);
+    result.quantiles.resize(n_params, probs.size());
+    result.effective_sample_size.resize(n_params);
+    result.split_potential_scale_reduction.resize(n_params);
+    result.split_potential_scale_reduction_rank.resize(n_params, 2);
+
+    struct scratch {
+      analyze::autocovariance_workspace<double> workspace;
+      analyze::rank_workspace ranks;
+      std::vector<double> draws;
+      std::vector<std::pair<size_t, int>> order;
+      std::vector<Eigen::VectorXd> buffers;
+    };
+    tbb::enumerable_thread_specific<scratch> scratches;
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, n_params),
+        [&](const tbb::blocked_range<int>& r) {
+          scratch& local = scratches.local();
+          local.buffers.resize(n_chains);
+          std::vector<const double*> draws(n_chains);
+          std::vector<size_t> sizes(n_chains);
+          for (int index = r.begin(); index != r.end(); ++index) {
+            double m = 0;
+            for (int chain = 0; chain < n_chains; ++chain) {
+              sizes[chain] = num_kept_samples(chain);
+              draws[chain] = kept_draws(chain, index, local.buffers[chain]);
+              m += (Eigen::VectorXd::Map(draws[chain], sizes[chain]).array()
+                    / n_kept)
+                       .sum();
+            }
+            double var = 0;
+            for (int chain = 0; chain < n_chains; ++chain)
+              var += ((Eigen::VectorXd::Map(draws[chain], sizes[chain]).array()
+                       - m)
+                      / std::sqrt(n_kept - 1.0))
+                         .square()
+                         .sum();
+            result.mean(index) = m;
+            result.sd(index) = std::sqrt(var);
+
+            local.draws.clear();
+            for (int chain = 0; chain < n_chains; ++chain)
+              local.draws.insert(local.draws.end(), draws[chain],
+                                 draws[chain] + sizes[chain]);
+            selected_quantiles(local.draws, probs, local.order,
+                               result.quantiles.row(index));
+
+            result.effective_sample_size(index)
+                = analyze::compute_effective_sample_size(draws, sizes,
+                                                         local.workspace);
+            result.split_potential_scale_reduction(index)
+                = analyze::compute_split_potential_scale_reduction(draws,
+                                                                   sizes);
+            std::pair<double, double> rhat_rank
+                = analyze::compute_split_potential_scale_reduction_rank(
+                    draws, sizes, local.ranks);
+            result.split_potential_scale_reduction_rank(index, 0)
+                = rhat_rank.first;
+            result.split_potential_scale_reduction_rank(index, 1)
+                = rhat_rank.second;
+          }
+        });
+    return result;
+  }
+
+ private:
+  /**
+   * Return the kept samples of a parameter in a chain without copying.
+   */
+  auto kept_samples(const int chain, const int index) const {
+    return samples_(chain).col(index).segment(warmup(chain),
+                                              num_kept_samples(chain));
+  }
+
+  /**
+   * Return a pointer to the kept samples of a parameter in a chain as
+   * doubles, without copying them if they are stored as doubles and
+   * widening them into the buffer otherwise.
+   */
+  const double* kept_draws(const int chain, const int index,
+                           Eigen::VectorXd& buffer) const {
+    return as_doubles(kept_samples(chain, index).data(),
+                      num_kept_samples(chain), buffer);
+  }
+
+  static const double* as_doubles(const double* x, const Eigen::Index n,
+                                  Eigen::VectorXd& buffer) {
+    return x;
+  }
+
+  static const double* as_doubles(const float* x, const Eigen::Index n,
+                                  Eigen::VectorXd& buffer) {
+    buffer = Eigen::VectorXf::Map(x, n).cast<double>();
+    return buffer.data();
+  }
+
+  /**
+   * Move parsed draws into the storage of a chain, converting them if
+   * they are not stored as doubles.
+   */
+  static void take_samples(Eigen::MatrixXd& storage, Eigen::MatrixXd& draws) {
+    storage.swap(draws);
+  }
+
+  template <typename Storage>
+  static void take_samples(Storage& storage, Eigen::MatrixXd& draws) {
+    storage = draws.cast<typename Storage::Scalar>();
+    draws.resize(0, 0);
+  }
+
+  /**
+   * Return the index in the sorted draws of the quantile with the
+   * specified probability, matching the tail quantiles of
+   * boost::accumulators with a cache of all the draws, or the number
+   * of draws if the quantile is not defined.
+   */
+  static size_t quantile_rank(const size_t M, const double prob) {
+    const size_t n = static_cast<size_t>(
+        std::ceil(M * (prob < 0.5 ? prob : 1.0 - prob)));
+    if (n == 0 || n >= M)
+      return M;
+    return prob < 0.5 ? n - 1 : M - n;
+  }
+
+  /**
+   * Return the quantile with the specified probability of the
+   * specified draws, partially sorting them.
+   */
+  static double selected_quantile(std::vector<double>& x, const double prob) {
+    const size_t k = quantile_rank(x.size(), prob);
+    if (k == x.size())
+      return std::numeric_limits<double>::quiet_NaN();
+    std::nth_element(x.begin(), x.begin() + k, x.end());
+    return x[k];
+  }
+
+  /**
+   * Write the quantiles with the specified probabilities of the
+   * specified draws, partially sorting them.
+   *
+   * The quantiles are selected in increasing order, each partition
+   * only covering the draws above the previous quantile, so the cost
+   * is that of a single selection over the draws plus one per
+   * quantile over a shrinking range.
+   *
+   * @param[in,out] x draws
+   * @param[in] probs probabilities of the quantiles
+   * @param[in,out] order scratch space for the order of the quantiles
+   * @param[out] q quantiles, NaN where not defined
+   */
+  template <typename Quantiles>
+  static void selected_quantiles(std::vector<double>& x,
+                                 const Eigen::VectorXd& probs,
+                                 std::vector<std::pair<size_t, int>>& order,
+                                 Quantiles&& q) {
+    const size_t M = x.size();
+    order.clear();
+    for (int i = 0; i < probs.size(); ++i)
+      order.emplace_back(quantile_rank(M, probs(i)), i);
+    std::sort(order.begin(), order.end());
+    size_t begin = 0;
+    for (const auto& rank : order) {
+      if (rank.first == M) {
+        q(rank.second) = std::numeric_limits<double>::quiet_NaN();
+        continue;
+      }
+      if (rank.first >= begin) {
+        std::nth_element(x.begin() + begin, x.begin() + rank.first, x.end());
+        begin = rank.first + 1;
+      }
+      q(rank.second) = x[rank.first];
+    }
+  }
 };
 
 }  // namespace mcmc
@@ -0,0 +1,140 @@
+#ifndef STAN_MCMC_CHECKPOINT_HPP
+#define STAN_MCMC_CHECKPOINT_HPP
+
+#include <stan/mcmc/base_adapter.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace stan {
+namespace mcmc {
+namespace internal {
+
+constexpr char checkpoint_magic[8] = {'s', 't', 'a', 'n', 'c', 'k', 'p', 't'};
+constexpr std::uint32_t checkpoint_version = 1;
+
+/**
+ * Trait detecting whether the adaptation of a sampler can be written
+ * to a checkpoint.
+ *
+ * @tparam Sampler type of sampler
+ */
+template <typename Sampler, typename = void>
+struct has_adaptation_checkpoint : std::false_type {};
+
+template <typename Sampler>
+struct has_adaptation_checkpoint<
+    Sampler,
+    decltype(std::declval<const Sampler&>().write_adaptation_checkpoint(
+        std::declval<checkpoint_writer&>()))> : std::true_type {};
+
+template <class Sampler>
+inline void write_adaptation_checkpoint(const Sampler& sampler,
+                                        checkpoint_writer& writer,
+                                        std::true_type) {
+  sampler.write_adaptation_checkpoint(writer);
+}
+
+template <class Sampler>
+inline void write_adaptation_checkpoint(const Sampler& sampler,
+                                        checkpoint_writer& writer,
+                                        std::false_type) {}
+
+template <class Sampler>
+inline void read_adaptation_checkpoint(Sampler& sampler,
+                                       checkpoint_reader& reader,
+                                       std::true_type) {
+  sampler.read_adaptation_checkpoint(reader);
+}
+
+template <class Sampler>
+inline void read_adaptation_checkpoint(Sampler& sampler,
+                                       checkpoint_reader& reader,
+                                       std::false_type) {}
+
+}  // namespace internal
+
+/**
+ * Write a binary checkpoint of a Hamiltonian sampler from which the
+ * chain can be continued with <code>read_checkpoint</code>, as if it
+ * had not been interrupted.  The checkpoint holds the specified
+ * iteration, the current point with its gradient and metric, the step
+ * size, the state of the random number generator and, for adaptive
+ * samplers, the state of the step size and metric adaptation.
+ *
+ * The checkpoint is only readable on the same kind of machine; see
+ * <code>checkpoint_writer</code>.
+ *
+ * @tparam Sampler type of sampler, derived from
+ *   <code>stan::mcmc::base_hmc</code>
+ * @param sampler sampler
+ * @param iteration number of iterations run, to resume from
+ * @param[in,out] out stream to write to, opened in binary mode
+ * @throw std::runtime_error if the stream cannot be written
+ */
+template <class Sampler>
+void write_checkpoint(const Sampler& sampler, int iteration,
+                      std::ostream& out) {
+  using has_adaptation = internal::has_adaptation_checkpoint<Sampler>;
+  static_assert(!std::is_base_of<base_adapter, Sampler>::value
+                    || has_adaptation::value,
+                "The adaptation of this sampler cannot be checkpointed.");
+  checkpoint_writer writer(out);
+  out.write(internal::checkpoint_magic, sizeof(internal::checkpoint_magic));
+  writer.write(internal::checkpoint_version);
+  writer.write(static_cast<std::int32_t>(iteration));
+  writer.write(static_cast<std::uint8_t>(has_adaptation::value));
+  sampler.write_checkpoint(writer);
+  internal::write_adaptation_checkpoint(sampler, writer, has_adaptation());
+  out.flush();
+  if (!out)
+    throw std::runtime_error("Cannot write checkpoint.");
+}
+
+/**
+ * Restore the state written by <code>write_checkpoint</code> into a
+ * sampler of the same type, constructed for the same model and with
+ * the same settings.  The chain then continues from the returned
+ * iteration with a sample built from the restored point,
+ * <code>sample(sampler.z().q, -sampler.z().V, 0)</code>.
+ *
+ * @tparam Sampler type of sampler, derived from
+ *   <code>stan::mcmc::base_hmc</code>
+ * @param[out] sampler sampler
+ * @param[in,out] in stream to read from, opened in binary mode
+ * @return number of iterations run when the checkpoint was written
+ * @throw std::runtime_error if the stream does not hold a checkpoint
+ *   of this kind of sampler with the dimensions of the model
+ */
+template <class Sampler>
+int read_checkpoint(Sampler& sampler, std::istream& in) {
+  using has_adaptation = internal::has_adaptation_checkpoint<Sampler>;
+  checkpoint_reader reader(in);
+  char magic[sizeof(internal::checkpoint_magic)];
+  std::uint32_t version;
+  in.read(magic, sizeof(magic));
+  if (!in
+      || std::memcmp(magic, internal::checkpoint_magic, sizeof(magic)) != 0)
+    throw std::runtime_error("Not a sampler checkpoint.");
+  reader.read(version);
+  if (version != internal::checkpoint_version)
+    throw std::runtime_error("Unsupported sampler checkpoint version.");
+  std::int32_t iteration;
+  std::uint8_t adaptive;
+  reader.read(iteration);
+  reader.read(adaptive);
+  if (adaptive != has_adaptation::value)
+    throw std::runtime_error("Checkpoint was written by another sampler.");
+  sampler.read_checkpoint(reader);
+  internal::read_adaptation_checkpoint(sampler, reader, has_adaptation());
+  return iteration;
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,155 @@
+#ifndef STAN_MCMC_CHECKPOINT_IO_HPP
+#define STAN_MCMC_CHECKPOINT_IO_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Writes the state of samplers and adaptations to a binary stream.
+ *
+ * Values are written in the native byte order and floating point
+ * representation, so a checkpoint can be read back exactly on the same
+ * kind of machine but is not portable across architectures.  Matrices
+ * are written with their dimensions.
+ */
+class checkpoint_writer {
+ public:
+  explicit checkpoint_writer(std::ostream& out) : out_(out) {}
+
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+  void write(T x) {
+    write_bytes(&x, sizeof(T));
+  }
+
+  template <typename Derived>
+  void write(const Eigen::MatrixBase<Derived>& x) {
+    const Eigen::MatrixXd& values = x.eval();
+    write(static_cast<std::int64_t>(values.rows()));
+    write(static_cast<std::int64_t>(values.cols()));
+    write_bytes(values.data(), sizeof(double) * values.size());
+  }
+
+  void write(const std::string& x) {
+    write(static_cast<std::int64_t>(x.size()));
+    write_bytes(x.data(), x.size());
+  }
+
+  /**
+   * Write the state of a random number generator, in the text form
+   * of its stream operator.
+   *
+   * @tparam RNG type of random number generator
+   * @param rng random number generator
+   */
+  template <class RNG>
+  void write_rng(const RNG& rng) {
+    std::stringstream state;
+    state << rng;
+    write(state.str());
+  }
+
+ private:
+  std::ostream& out_;
+
+  void write_bytes(const void* data, std::size_t size) {
+    out_.write(static_cast<const char*>(data), size);
+    if (!out_)
+      throw std::runtime_error("Cannot write checkpoint.");
+  }
+};
+
+/**
+ * Reads the state written by a <code>checkpoint_writer</code>.
+ *
+ * The reader throws if the stream ends early or its contents do not
+ * fit the object being restored, which may then be left partially
+ * restored.
+ */
+class checkpoint_reader {
+ public:
+  explicit checkpoint_reader(std::istream& in) : in_(in) {}
+
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+  void read(T& x) {
+    read_bytes(&x, sizeof(T));
+  }
+
+  template <int R, int C>
+  void read(Eigen::Matrix<double, R, C>& x) {
+    std::int64_t rows, cols;
+    read(rows);
+    read(cols);
+    if (rows < 0 || cols < 0 || (R != Eigen::Dynamic && rows != R)
+        || (C != Eigen::Dynamic && cols != C))
+      throw std::runtime_error("Checkpoint is corrupt.");
+    x.resize(rows, cols);
+    read_bytes(x.data(), sizeof(double) * x.size());
+  }
+
+  /**
+   * Read a vector or matrix, which must have the dimensions of the
+   * specified one.
+   *
+   * @param[out] x vector or matrix
+   * @param rows expected number of rows
+   * @param cols expected number of columns
+   * @throw std::runtime_error if the dimensions differ
+   */
+  template <int R, int C>
+  void read(Eigen::Matrix<double, R, C>& x, Eigen::Index rows,
+            Eigen::Index cols) {
+    read(x);
+    if (x.rows() != rows || x.cols() != cols)
+      throw std::runtime_error(
+          "Checkpoint does not match the dimensions of the sampler.");
+  }
+
+  void read(std::string& x) {
+    std::int64_t size;
+    read(size);
+    if (size < 0)
+      throw std::runtime_error("Checkpoint is corrupt.");
+    x.resize(size);
+    read_bytes(&x[0], size);
+  }
+
+  /**
+   * Restore the state of a random number generator.
+   *
+   * @tparam RNG type of random number generator
+   * @param[out] rng random number generator
+   */
+  template <class RNG>
+  void read_rng(RNG& rng) {
+    std::string state;
+    read(state);
+    std::stringstream state_stream(state);
+    state_stream >> rng;
+    if (state_stream.fail())
+      throw std::runtime_error("Checkpoint is corrupt.");
+  }
+
+ private:
+  std::istream& in_;
+
+  void read_bytes(void* data, std::size_t size) {
+    in_.read(static_cast<char*>(data), size);
+    if (!in_)
+      throw std::runtime_error("Checkpoint is truncated.");
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
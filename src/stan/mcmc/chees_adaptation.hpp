@@ -0,0 +1,228 @@
+#ifndef STAN_MCMC_CHEES_ADAPTATION_HPP
+#define STAN_MCMC_CHEES_ADAPTATION_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/mcmc/base_adaptation.hpp>
+#include <stan/mcmc/stepsize_adaptation.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Adapts the step size, integration time and diagonal metric shared by
+ * many chains of <code>base_chees_hmc</code> from statistics across the
+ * chains, following ChEES-HMC (Hoffman, Radul and Sountsov, 2021).
+ *
+ * After every transition of all chains:
+ * <ul>
+ * <li>the step size is learned by dual averaging on the mean acceptance
+ * probability of the chains;</li>
+ * <li>the log integration time takes an Adam step, without momentum,
+ * along the gradient of the change in the expected squared jumped
+ * distance (ChEES) estimated from the initial and proposed positions of
+ * the chains, weighted by their acceptance probabilities, and is kept
+ * between one and the maximum number of leapfrog steps;</li>
+ * <li>until the end of the metric adaptation, the inverse metric is the
+ * variance of the positions across the chains, regularized as in
+ * <code>var_adaptation</code>.</li>
+ * </ul>
+ * The final step size and integration time are averages of the iterates,
+ * as in the dual averaging of the step size.
+ *
+ * The jitter of the integration time is taken from the van der Corput
+ * sequence, so that all chains integrate for the same time, and
+ * consecutive transitions cover short and long times evenly.
+ */
+class chees_adaptation : public base_adaptation {
+ public:
+  chees_adaptation()
+      : learning_rate_(0.025),
+        beta_(0.95),
+        kappa_(0.75),
+        max_num_steps_(1000),
+        metric_adaptation_end_(0) {
+    restart();
+  }
+
+  stepsize_adaptation& get_stepsize_adaptation() {
+    return stepsize_adaptation_;
+  }
+
+  const stepsize_adaptation& get_stepsize_adaptation() const noexcept {
+    return stepsize_adaptation_;
+  }
+
+  void set_learning_rate(double r) {
+    if (r > 0)
+      learning_rate_ = r;
+  }
+
+  void set_max_num_steps(int n) {
+    if (n > 0)
+      max_num_steps_ = n;
+  }
+
+  /**
+   * Set the number of iterations over which the metric is adapted.
+   *
+   * @param n number of iterations, from the start of the adaptation
+   */
+  void set_metric_adaptation_end(int n) { metric_adaptation_end_ = n; }
+
+  double get_learning_rate() const noexcept { return learning_rate_; }
+
+  int get_max_num_steps() const noexcept { return max_num_steps_; }
+
+  void restart() {
+    counter_ = 0;
+    second_moment_ = 0;
+    log_T_bar_ = 0;
+    stepsize_adaptation_.restart();
+  }
+
+  /**
+   * Return the jitter of the integration time of a transition, the
+   * element of the van der Corput sequence in base 2 following the
+   * specified index.
+   *
+   * @param n index of the transition, from 0
+   * @return jitter in (0, 1)
+   */
+  static double jitter(unsigned long n) {
+    ++n;
+    double jitter = 0;
+    double scale = 0.5;
+    for (; n > 0; n >>= 1, scale *= 0.5)
+      jitter += (n & 1) * scale;
+    return jitter;
+  }
+
+  /**
+   * Update the step size, integration time and metric of the chains
+   * from their last transition, which they must all have made with the
+   * same settings.
+   *
+   * @tparam Sampler type of sampler, e.g. diag_e_chees_hmc
+   * @param[in,out] samplers samplers of every chain
+   */
+  template <class Sampler>
+  void learn(std::vector<Sampler>& samplers) {
+    ++counter_;
+    const double num_chains = samplers.size();
+    double epsilon = samplers[0].get_nominal_stepsize();
+    const double time = samplers[0].num_steps() * epsilon;
+    double log_T = std::log(samplers[0].get_T());
+
+    // ChEES gradient with respect to the log integration time
+    double sum_accept = 0;
+    initial_mean_.setZero(samplers[0].initial_position().size());
+    proposed_mean_.setZero(initial_mean_.size());
+    for (auto& sampler : samplers) {
+      const double accept = sampler.accept_prob();
+      sum_accept += accept;
+      initial_mean_ += accept * sampler.initial_position();
+      proposed_mean_ += accept * sampler.proposed_position();
+    }
+    double gradient = 0;
+    if (sum_accept > 0) {
+      initial_mean_ /= sum_accept;
+      proposed_mean_ /= sum_accept;
+      for (auto& sampler : samplers) {
+        const double accept = sampler.accept_prob();
+        if (accept == 0)
+          continue;
+        diff_ = sampler.proposed_position() - proposed_mean_;
+        const double change
+            = diff_.squaredNorm()
+              - (sampler.initial_position() - initial_mean_).squaredNorm();
+        gradient += accept * change * diff_.dot(sampler.proposed_velocity());
+      }
+      gradient *= time / sum_accept;
+    }
+    if (std::isfinite(gradient) && gradient != 0) {
+      second_moment_
+          = beta_ * second_moment_ + (1 - beta_) * gradient * gradient;
+      const double scale
+          = std::sqrt(second_moment_ / (1 - std::pow(beta_, counter_)));
+      log_T += learning_rate_ * gradient / (scale + 1e-8);
+    }
+
+    stepsize_adaptation_.learn_stepsize(epsilon, sum_accept / num_chains);
+    log_T = clamp_log_T(log_T, epsilon);
+    const double eta = std::pow(counter_, -kappa_);
+    log_T_bar_ = (1 - eta) * log_T_bar_ + eta * log_T;
+
+    bool update_metric = counter_ <= metric_adaptation_end_;
+    if (update_metric) {
+      const Eigen::Index n = samplers[0].z().q.size();
+      mean_.setZero(n);
+      var_.setZero(n);
+      for (auto& sampler : samplers)
+        mean_ += sampler.z().q;
+      mean_ /= num_chains;
+      for (auto& sampler : samplers)
+        var_.array() += (sampler.z().q - mean_).array().square();
+      var_ /= num_chains - 1;
+      var_ = (num_chains / (num_chains + 5.0)) * var_.array()
+             + 1e-3 * (5.0 / (num_chains + 5.0));
+      update_metric = var_.allFinite();
+    }
+
+    const double T = std::exp(log_T);
+    for (auto& sampler : samplers) {
+      sampler.set_nominal_stepsize_and_T(epsilon, T);
+      if (update_metric)
+        sampler.set_metric(var_);
+    }
+  }
+
+  /**
+   * Set the step size and integration time of the chains to the
+   * averages of their iterates.
+   *
+   * @tparam Sampler type of sampler, e.g. diag_e_chees_hmc
+   * @param[in,out] samplers samplers of every chain
+   */
+  template <class Sampler>
+  void complete_adaptation(std::vector<Sampler>& samplers) {
+    if (counter_ == 0)
+      return;
+    double epsilon = 0;
+    stepsize_adaptation_.complete_adaptation(epsilon);
+    const double T = std::exp(clamp_log_T(log_T_bar_, epsilon));
+    for (auto& sampler : samplers)
+      sampler.set_nominal_stepsize_and_T(epsilon, T);
+  }
+
+ protected:
+  double learning_rate_;  // Adam learning rate of the log integration time
+  double beta_;           // Decay of the second moment of the gradient
+  double kappa_;          // Shrinkage of the averaged log integration time
+  int max_num_steps_;
+  int metric_adaptation_end_;
+
+  double counter_;
+  double second_moment_;
+  double log_T_bar_;
+  stepsize_adaptation stepsize_adaptation_;
+
+  Eigen::VectorXd initial_mean_;
+  Eigen::VectorXd proposed_mean_;
+  Eigen::VectorXd diff_;
+  Eigen::VectorXd mean_;
+  Eigen::VectorXd var_;
+
+  double clamp_log_T(double log_T, double epsilon) const {
+    const double log_epsilon = std::log(epsilon);
+    const double log_max_T
+        = log_epsilon + std::log(static_cast<double>(max_num_steps_));
+    return std::min(std::max(log_T, log_epsilon), log_max_T);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
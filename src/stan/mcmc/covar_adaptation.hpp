@@ -2,7 +2,10 @@
 #define STAN_MCMC_COVAR_ADAPTATION_HPP
 
 #include <stan/math/prim.hpp>
+#include <stan/mcmc/block_welford_covar_estimator.hpp>
+#include <stan/mcmc/chain_reducer.hpp>
 #include <stan/mcmc/windowed_adaptation.hpp>
+#include <cstddef>
 #include <vector>
 
 namespace stan {
@@ -12,7 +15,11 @@ namespace mcmc {
 class covar_adaptation : public windowed_adaptation {
  public:
   explicit covar_adaptation(int n)
-      : windowed_adaptation("covariance"), estimator_(n) {}
+      : windowed_adaptation("covariance"),
+        estimator_(n),
+        window_num_samples_(0),
+        window_mean_(Eigen::VectorXd::Zero(n)),
+        window_covar_(Eigen::MatrixXd::Zero(n, n)) {}
 
   bool learn_covariance(Eigen::MatrixXd& covar, const Eigen::VectorXd& q) {
     if (adaptation_window())
@@ -23,18 +30,11 @@ class covar_adaptation : public windowed_adaptation {
 
       estimator_.sample_covariance(covar);
 
-      double n = static_cast<double>(estimator_.num_samples());
-      covar = (n / (n + 5.0)) * covar
-              + 1e-3 * (5.0 / (n + 5.0))
-                    * Eigen::MatrixXd::Identity(covar.rows(), covar.cols());
+      window_num_samples_ = estimator_.num_samples();
+      estimator_.sample_mean(window_mean_);
+      window_covar_ = covar;
 
-      if (!covar.allFinite())
-        throw std::runtime_error(
-            "Numerical overflow in metric adaptation. "
-            "This occurs when the sampler encounters extreme values on the "
-            "unconstrained space; this may happen when the posterior density "
-            "function is too wide or improper. "
-            "There may be problems with your model specification.");
+      regularize(covar, window_num_samples_);
 
       estimator_.restart();
 
@@ -46,8 +46,126 @@ class covar_adaptation : public windowed_adaptation {
     return false;
   }
 
+  /**
+   * Set the covariance to the regularized estimate a single estimator
+   * would have produced from the draws of the last completed window of
+   * every adaptation, combining their means and covariances.  The
+   * adaptations must follow the same window schedule.
+   *
+   * @param[in,out] covar pooled covariance, unchanged if the windows hold
+   *   fewer than two draws in total
+   * @param adaptations adaptations to pool
+   * @throw std::runtime_error if the pooled covariance is not finite
+   */
+  static void pool_windows(Eigen::MatrixXd& covar,
+                           const std::vector<covar_adaptation*>& adaptations) {
+    pool_windows(covar, adaptations, local_chain_reducer());
+  }
+
+  /**
+   * Set the covariance to the estimate pooled over the last completed
+   * window of the adaptations of every process, reducing the moments
+   * with the specified reducer.
+   *
+   * @tparam Reducer type of the reduction over processes
+   * @param[in,out] covar pooled covariance, unchanged if the windows hold
+   *   fewer than two draws in total
+   * @param adaptations adaptations of this process to pool
+   * @param reducer reduction over the processes
+   * @throw std::runtime_error if the pooled covariance is not finite
+   */
+  template <class Reducer>
+  static void pool_windows(Eigen::MatrixXd& covar,
+                           const std::vector<covar_adaptation*>& adaptations,
+                           const Reducer& reducer) {
+    double n = 0;
+    Eigen::VectorXd mean = Eigen::VectorXd::Zero(covar.rows());
+    for (const covar_adaptation* adaptation : adaptations) {
+      n += adaptation->window_num_samples_;
+      mean += adaptation->window_num_samples_ * adaptation->window_mean_;
+    }
+    reducer.sum(n);
+    reducer.sum(mean);
+    if (n < 2)
+      return;
+    mean /= n;
+
+    Eigen::MatrixXd m2 = Eigen::MatrixXd::Zero(covar.rows(), covar.cols());
+    for (const covar_adaptation* adaptation : adaptations) {
+      double n_i = adaptation->window_num_samples_;
+      if (n_i < 1)
+        continue;
+      Eigen::VectorXd delta = adaptation->window_mean_ - mean;
+      m2 += (n_i - 1) * adaptation->window_covar_
+            + n_i * delta * delta.transpose();
+    }
+    reducer.sum(m2);
+    covar = m2 / (n - 1);
+    regularize(covar, n);
+  }
+
+  /**
+   * Advise the storage of the estimator and of the moments of the last
+   * window to be backed with huge pages.
+   *
+   * @return number of bytes advised
+   */
+  std::size_t advise_huge_pages() {
+    return estimator_.advise_huge_pages()
+           + mcmc::advise_huge_pages(window_mean_)
+           + mcmc::advise_huge_pages(window_covar_);
+  }
+
+  /**
+   * Write the window schedule, the covariance estimator and the moments of
+   * the last completed window.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    windowed_adaptation::write_checkpoint(writer);
+    estimator_.write_checkpoint(writer);
+    writer.write(window_num_samples_);
+    writer.write(window_mean_);
+    writer.write(window_covar_);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().
+   *
+   * @param reader checkpoint reader
+   * @throw std::runtime_error if the number of dimensions differs
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    const Eigen::Index n = window_mean_.size();
+    windowed_adaptation::read_checkpoint(reader);
+    estimator_.read_checkpoint(reader);
+    reader.read(window_num_samples_);
+    reader.read(window_mean_, n, 1);
+    reader.read(window_covar_, n, n);
+  }
+
  protected:
-  stan::math::welford_covar_estimator estimator_;
+  block_welford_covar_estimator estimator_;
+
+  // Size, mean and unregularized covariance of the last completed window
+  double window_num_samples_;
+  Eigen::VectorXd window_mean_;
+  Eigen::MatrixXd window_covar_;
+
+  static void regularize(Eigen::MatrixXd& covar, double n) {
+    covar = (n / (n + 5.0)) * covar
+            + 1e-3 * (5.0 / (n + 5.0))
+                  * Eigen::MatrixXd::Identity(covar.rows(), covar.cols());
+
+    if (!covar.allFinite())
+      throw std::runtime_error(
+          "Numerical overflow in metric adaptation. "
+          "This occurs when the sampler encounters extreme values on the "
+          "unconstrained space; this may happen when the posterior density "
+          "function is too wide or improper. "
+          "There may be problems with your model specification.");
+  }
 };
 
 }  // namespace mcmc
@@ -0,0 +1,35 @@
+#ifndef STAN_MCMC_DIAGNOSTIC_FIELDS_HPP
+#define STAN_MCMC_DIAGNOSTIC_FIELDS_HPP
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Blocks of the phase space state that an HMC sampler writes as the
+ * diagnostics of every transition: the position, the momentum and the
+ * gradient of the potential.  Every block has one column per
+ * unconstrained parameter, so each block left out shrinks the
+ * diagnostic output by a third.
+ *
+ * The default writes every block.
+ */
+struct diagnostic_fields {
+  /**
+   * Whether the position, <code>q</code>, is written.
+   */
+  bool position = true;
+
+  /**
+   * Whether the momentum, <code>p</code>, is written.
+   */
+  bool momentum = true;
+
+  /**
+   * Whether the gradient of the potential, <code>g</code>, is written.
+   */
+  bool gradient = true;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -1,16 +1,24 @@
 #ifndef STAN_MCMC_HMC_BASE_HMC_HPP
 #define STAN_MCMC_HMC_BASE_HMC_HPP
 
+#include <stan/callbacks/buffered_logger.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/callbacks/structured_writer.hpp>
 #include <stan/mcmc/base_mcmc.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
 #include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <boost/random/uniform_01.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <cmath>
+#include <cstddef>
+#include <exception>
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace stan {
@@ -38,7 +46,11 @@ class base_hmc : public base_mcmc {
         rand_uniform_(rand_int_),
         nom_epsilon_(0.1),
         epsilon_(nom_epsilon_),
-        epsilon_jitter_(0.0) {}
+        epsilon_jitter_(0.0),
+        stepsize_search_probes_(1),
+        recorded_gradient_evaluations_(0),
+        recorded_gradient_time_(0),
+        recorded_leapfrog_steps_(0) {}
 
   /**
    * format and write stepsize
@@ -75,22 +87,80 @@ class base_hmc : public base_mcmc {
     struct_writer.end_record();
   }
 
+  /**
+   * Write the state needed to continue the chain: the current point
+   * with its gradient and metric, the step sizes and the state of the
+   * random number generator.  The settings of the sampler, such as
+   * the maximum tree depth, are not written.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    z_.write_checkpoint(writer);
+    writer.write(nom_epsilon_);
+    writer.write(epsilon_);
+    writer.write(epsilon_jitter_);
+    writer.write_rng(rand_int_);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint() into a sampler
+   * constructed for the same model.  The gradient of the restored
+   * point is stored in the gradient cache, so the next transition does
+   * not evaluate it again.
+   *
+   * @param reader checkpoint reader
+   * @throw std::runtime_error if the checkpoint is truncated or does
+   *   not match the dimensions of the sampler
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    z_.read_checkpoint(reader);
+    reader.read(nom_epsilon_);
+    reader.read(epsilon_);
+    reader.read(epsilon_jitter_);
+    reader.read_rng(rand_int_);
+    hamiltonian_.cache_gradient(z_);
+  }
+
   void get_sampler_diagnostic_names(std::vector<std::string>& model_names,
                                     std::vector<std::string>& names) {
-    z_.get_param_names(model_names, names);
+    z_.get_param_names(model_names, names, diagnostic_fields_);
   }
 
   void get_sampler_diagnostics(std::vector<double>& values) {
-    z_.get_params(values);
+    z_.get_params(values, diagnostic_fields_);
+  }
+
+  void set_diagnostic_fields(const diagnostic_fields& fields) {
+    diagnostic_fields_ = fields;
   }
 
   void seed(const Eigen::VectorXd& q) { z_.q = q; }
 
+  /**
+   * Set the position to a point at which the log density and its
+   * gradient are already known, and store them in the gradient cache
+   * so that initializing the Hamiltonian there, as when initializing
+   * the step size, does not evaluate the gradient again.
+   *
+   * @param q position
+   * @param log_prob log density at the position, dropping constants
+   * @param gradient gradient of the log density at the position
+   */
+  void seed(const Eigen::VectorXd& q, double log_prob,
+            const Eigen::VectorXd& gradient) {
+    z_.q = q;
+    z_.V = -log_prob;
+    z_.g = -gradient;
+    hamiltonian_.cache_gradient(z_);
+  }
+
   void init_hamiltonian(callbacks::logger& logger) {
     this->hamiltonian_.init(this->z_, logger);
   }
 
   void init_stepsize(callbacks::logger& logger) {
+    STAN_TRACE_SCOPE("init_stepsize");
     ps_point z_init(this->z_);
 
     // Skip initialization for extreme step sizes
@@ -115,6 +185,12 @@ class base_hmc : public base_mcmc {
 
     int direction = delta_H > std::log(0.8) ? 1 : -1;
 
+    if (stepsize_search_probes_ > 1) {
+      search_stepsize_concurrently(z_init, direction, logger);
+      this->z_.ps_point::operator=(z_init);
+      return;
+    }
+
     while (1) {
       this->z_.ps_point::operator=(z_init);
 
@@ -186,6 +262,91 @@ class base_hmc : public base_mcmc {
 
   double get_stepsize_jitter() const noexcept { return this->epsilon_jitter_; }
 
+  /**
+   * Return the number of model gradient evaluations made through the
+   * Hamiltonian.
+   */
+  long num_gradient_evaluations() const noexcept {
+    return hamiltonian_.num_gradient_evaluations();
+  }
+
+  /**
+   * Return the number of gradient updates that the Hamiltonian served
+   * from its gradient cache instead of evaluating the model.
+   */
+  long num_gradient_cache_hits() const noexcept {
+    return hamiltonian_.num_gradient_cache_hits();
+  }
+
+  /**
+   * Enable or disable the gradient cache of the Hamiltonian.
+   */
+  void set_gradient_cache(bool use_cache) {
+    hamiltonian_.set_gradient_cache(use_cache);
+  }
+
+  /**
+   * Enable or disable differentiating the terms of the log density in
+   * parallel in the gradients of the Hamiltonian.
+   */
+  void set_parallel_terms(bool use_terms) {
+    hamiltonian_.set_parallel_terms(use_terms);
+  }
+
+  /**
+   * Set the number of step sizes the step size initialization tries
+   * concurrently.  With more than one, each round of the doubling or
+   * halving search evaluates that many successive candidates at once,
+   * from the same initial point and with the momenta the sequential
+   * search would draw, and the random number generator is left as the
+   * sequential search leaves it, so the chosen step size and the rest
+   * of the run are the same.  This holds for the metrics whose
+   * momentum distribution does not depend on the position, that is
+   * all but the SoftAbs metrics.  The candidates past the chosen one
+   * are wasted work, which is only worth it for costly gradients.
+   *
+   * @param num_probes number of candidates per round; one, the
+   *   default, runs the sequential search
+   */
+  void set_stepsize_search_probes(int num_probes) {
+    stepsize_search_probes_ = num_probes > 1 ? num_probes : 1;
+  }
+
+  /**
+   * Ask for the working vectors of the sampler, those of its points,
+   * trajectory and adaptation, to be backed with transparent huge
+   * pages, as in <code>stan::mcmc::advise_huge_pages</code>.  This only
+   * pays off for models with hundreds of thousands of parameters or
+   * more, whose vectors span whole huge pages.  The bytes advised are
+   * reported in the instrumentation record.
+   */
+  void enable_huge_pages() { huge_page_bytes_ = advise_huge_pages(); }
+
+  void record_instrumentation(sampler_instrumentation& stats) {
+    long num_gradients = hamiltonian_.num_gradient_evaluations();
+    double gradient_time = hamiltonian_.gradient_time();
+    long num_steps = integrator_.num_steps();
+    // The Hamiltonian counters may have been reset since the last call
+    if (num_gradients < recorded_gradient_evaluations_
+        || gradient_time < recorded_gradient_time_) {
+      recorded_gradient_evaluations_ = 0;
+      recorded_gradient_time_ = 0;
+    }
+    stats.num_gradient_evaluations
+        += num_gradients - recorded_gradient_evaluations_;
+    stats.gradient_time += gradient_time - recorded_gradient_time_;
+    stats.num_leapfrog_steps += num_steps - recorded_leapfrog_steps_;
+    recorded_gradient_evaluations_ = num_gradients;
+    recorded_gradient_time_ = gradient_time;
+    recorded_leapfrog_steps_ = num_steps;
+    stats.add_tape_usage(hamiltonian_.peak_tape_usage().bytes,
+                         hamiltonian_.peak_tape_usage().vars);
+    hamiltonian_.reset_peak_tape_usage();
+    stats.add_huge_page_usage(huge_page_bytes());
+  }
+
+  void recycle(sample& s) { s.swap_cont_params(recycled_cont_params_); }
+
   void sample_stepsize() {
     this->epsilon_ = this->nom_epsilon_;
     if (this->epsilon_jitter_)
@@ -194,6 +355,32 @@ class base_hmc : public base_mcmc {
   }
 
  protected:
+  /**
+   * Return the draw at the current point, copying its position into
+   * the storage passed to recycle, if any, rather than a new vector.
+   *
+   * @param log_prob log density of the draw
+   * @param accept_stat acceptance statistic of the transition
+   */
+  sample current_sample(double log_prob, double accept_stat) {
+    recycled_cont_params_ = z_.q;
+    return sample(std::move(recycled_cont_params_), log_prob, accept_stat);
+  }
+
+  /**
+   * Advise the working vectors of the sampler to be backed with huge
+   * pages.  Samplers with working vectors of their own add theirs.
+   *
+   * @return number of bytes advised
+   */
+  virtual std::size_t advise_huge_pages() { return z_.advise_huge_pages(); }
+
+  /**
+   * Return the number of bytes of working vectors advised to be backed
+   * with huge pages.
+   */
+  virtual std::size_t huge_page_bytes() const { return huge_page_bytes_; }
+
   typename Hamiltonian<Model, BaseRNG>::PointType z_;
   Integrator<Hamiltonian<Model, BaseRNG>> integrator_;
   Hamiltonian<Model, BaseRNG> hamiltonian_;
@@ -206,6 +393,140 @@ class base_hmc : public base_mcmc {
   double nom_epsilon_;
   double epsilon_;
   double epsilon_jitter_;
+
+  // Candidate step sizes evaluated at once by init_stepsize
+  int stepsize_search_probes_;
+
+  // Totals already added to an instrumentation record
+  long recorded_gradient_evaluations_;
+  double recorded_gradient_time_;
+  long recorded_leapfrog_steps_;
+
+  // Storage of a recycled draw, reused by current_sample
+  Eigen::VectorXd recycled_cont_params_;
+
+  // Blocks of the point written as diagnostics
+  diagnostic_fields diagnostic_fields_;
+
+  // Bytes of working vectors advised to be backed with huge pages
+  std::size_t huge_page_bytes_{0};
+
+ private:
+  /**
+   * Run the loop of init_stepsize in rounds of concurrently evaluated
+   * candidates, each with its own copy of the point, Hamiltonian and
+   * integrator.  The results are then scanned in order as the
+   * sequential loop would see them: only the messages of the
+   * candidates it would have evaluated are logged, its errors are
+   * raised at the same candidate, and the generator is rewound and
+   * advanced by the momenta it would have drawn.
+   *
+   * @param z_init initial point
+   * @param direction 1 to double the step size, -1 to halve it
+   * @param logger logger for messages
+   */
+  void search_stepsize_concurrently(const ps_point& z_init, int direction,
+                                    callbacks::logger& logger) {
+    using point_t = typename Hamiltonian<Model, BaseRNG>::PointType;
+    const int num_probes = stepsize_search_probes_;
+    std::vector<point_t> points(num_probes, this->z_);
+    std::vector<double> epsilons(num_probes);
+    std::vector<double> delta_Hs(num_probes);
+    std::vector<callbacks::buffered_logger> loggers(num_probes);
+    std::vector<std::exception_ptr> errors(num_probes);
+    std::vector<long> num_gradients(num_probes);
+    std::vector<long> num_cache_hits(num_probes);
+    std::vector<double> gradient_times(num_probes);
+    std::vector<long> num_steps(num_probes);
+
+    while (1) {
+      // The candidates stop at the first step size out of bounds
+      BaseRNG rng_start = this->rand_int_;
+      int num_candidates = 0;
+      double epsilon = this->nom_epsilon_;
+      bool out_of_bounds = false;
+      while (num_candidates < num_probes && !out_of_bounds) {
+        point_t& z = points[num_candidates];
+        z.ps_point::operator=(z_init);
+        this->hamiltonian_.sample_p(z, this->rand_int_);
+        epsilons[num_candidates++] = epsilon;
+        epsilon = direction == 1 ? 2.0 * epsilon : 0.5 * epsilon;
+        out_of_bounds = epsilon > 1e7 || epsilon == 0;
+      }
+
+      tbb::parallel_for(
+          tbb::blocked_range<int>(0, num_candidates),
+          [&](const tbb::blocked_range<int>& r) {
+            for (int k = r.begin(); k < r.end(); ++k) {
+              Hamiltonian<Model, BaseRNG> hamiltonian(this->hamiltonian_);
+              hamiltonian.reset_gradient_counters();
+              Integrator<Hamiltonian<Model, BaseRNG>> integrator(
+                  this->integrator_);
+              loggers[k] = callbacks::buffered_logger();
+              errors[k] = nullptr;
+              try {
+                hamiltonian.init(points[k], loggers[k]);
+                double H0 = hamiltonian.H(points[k]);
+                integrator.evolve(points[k], hamiltonian, epsilons[k],
+                                  loggers[k]);
+                double h = hamiltonian.H(points[k]);
+                if (std::isnan(h))
+                  h = std::numeric_limits<double>::infinity();
+                delta_Hs[k] = H0 - h;
+              } catch (...) {
+                errors[k] = std::current_exception();
+              }
+              num_gradients[k] = hamiltonian.num_gradient_evaluations();
+              num_cache_hits[k] = hamiltonian.num_gradient_cache_hits();
+              gradient_times[k] = hamiltonian.gradient_time();
+              num_steps[k]
+                  = integrator.num_steps() - this->integrator_.num_steps();
+            }
+          },
+          tbb::simple_partitioner());
+
+      int num_used = 0;
+      bool found = false;
+      while (num_used < num_candidates && !found && !errors[num_used]) {
+        const double delta_H = delta_Hs[num_used];
+        found = direction == 1 ? !(delta_H > std::log(0.8))
+                               : !(delta_H < std::log(0.8));
+        ++num_used;
+      }
+      const bool failed = num_used < num_candidates && !found;
+      if (failed)
+        ++num_used;
+
+      this->rand_int_ = rng_start;
+      for (int k = 0; k < num_used; ++k) {
+        this->hamiltonian_.sample_p(points[0], this->rand_int_);
+        loggers[k].replay(logger);
+      }
+      for (int k = 0; k < num_candidates; ++k)
+        this->hamiltonian_.add_gradient_counters(
+            num_gradients[k], num_cache_hits[k], gradient_times[k]);
+      for (int k = 0; k < num_candidates; ++k)
+        this->integrator_.add_steps(num_steps[k]);
+
+      if (failed)
+        std::rethrow_exception(errors[num_used - 1]);
+      if (found) {
+        this->nom_epsilon_ = epsilons[num_used - 1];
+        return;
+      }
+      this->nom_epsilon_ = epsilon;
+
+      if (this->nom_epsilon_ > 1e7)
+        throw std::runtime_error(
+            "Posterior is improper. "
+            "Please check your model.");
+      if (this->nom_epsilon_ == 0)
+        throw std::runtime_error(
+            "No acceptably small step size could "
+            "be found. Perhaps the posterior is "
+            "not continuous?");
+    }
+  }
 };
 
 }  // namespace mcmc
@@ -0,0 +1,260 @@
+#ifndef STAN_MCMC_HMC_CHEES_BASE_CHEES_HMC_HPP
+#define STAN_MCMC_HMC_CHEES_BASE_CHEES_HMC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/static_uniform/base_static_uniform.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Hamiltonian Monte Carlo with a static, jittered integration time, for
+ * running many chains which share their step size and integration time,
+ * as adapted by <code>chees_adaptation</code> from the statistics of all
+ * chains.
+ *
+ * Each transition integrates for the fraction of the integration time
+ * set by <code>set_jitter</code>, rounded up to whole leapfrog steps,
+ * and accepts the final state of the trajectory with a Metropolis
+ * correction.  The jitter is set from outside, so that all chains take
+ * the same number of leapfrog steps and can be advanced in lockstep by
+ * <code>lockstep_driver</code>, with the same interface as
+ * <code>base_nuts_lockstep</code>.  The initial and proposed positions,
+ * the velocity at the proposal and the acceptance probability of the
+ * last transition are kept for the adaptation.
+ *
+ * Only the explicit leapfrog integrator can be split around the
+ * gradient evaluation, so the integrator is fixed.
+ */
+template <class Model, template <class, class> class Hamiltonian,
+          class BaseRNG>
+class base_chees_hmc
+    : public base_static_uniform<Model, Hamiltonian, expl_leapfrog,
+                                 BaseRNG> {
+ public:
+  base_chees_hmc(const Model& model, BaseRNG& rng)
+      : base_static_uniform<Model, Hamiltonian, expl_leapfrog, BaseRNG>(
+          model, rng),
+        q_proposal_(this->z_.q.size()),
+        velocity_proposal_(this->z_.q.size()) {}
+
+  /**
+   * Set the fraction of the integration time of the next transitions.
+   *
+   * @param jitter fraction in (0, 1]; other values are ignored
+   */
+  void set_jitter(double jitter) {
+    if (jitter > 0 && jitter <= 1)
+      jitter_ = jitter;
+  }
+
+  double get_jitter() const noexcept { return jitter_; }
+
+  /**
+   * Return the number of leapfrog steps of the next transition.
+   */
+  int num_steps() const {
+    int steps = static_cast<int>(
+        std::ceil(jitter_ * this->T_ / this->nom_epsilon_));
+    return steps < 1 ? 1 : steps;
+  }
+
+  /**
+   * Begin a new transition from the specified sample.  Afterwards the
+   * sampler awaits the gradient at the initial position.
+   *
+   * @param init_sample sample to start from
+   * @param logger Logger for messages
+   */
+  void begin_transition(sample& init_sample, callbacks::logger& logger) {
+    this->sample_stepsize();
+    this->seed(init_sample.cont_params());
+    this->hamiltonian_.sample_p(this->z_, this->rand_int_);
+    num_steps_ = num_steps();
+    step_ = 0;
+    phase_ = phase::init;
+  }
+
+  /**
+   * Return whether the current transition needs another gradient
+   * evaluation before it can advance.
+   */
+  inline bool awaiting_gradient() const noexcept {
+    return phase_ != phase::done;
+  }
+
+  /**
+   * Return the unconstrained position at which the next gradient is
+   * needed.
+   */
+  inline const Eigen::VectorXd& position() const noexcept {
+    return this->z_.q;
+  }
+
+  /**
+   * Store an externally computed log density and gradient for the
+   * current position.
+   *
+   * @param log_prob log density at position()
+   * @param gradient gradient of the log density at position()
+   */
+  void set_log_prob_gradient(double log_prob,
+                             const Eigen::VectorXd& gradient) {
+    this->z_.V = -log_prob;
+    this->z_.g = -gradient;
+  }
+
+  /**
+   * Evaluate the log density and gradient for the current position
+   * through the Hamiltonian, which reports any error to the logger
+   * and rejects the point.  The initial position of a transition may
+   * be served from the gradient cache.
+   *
+   * @param logger Logger for messages
+   */
+  void update_log_prob_gradient(callbacks::logger& logger) {
+    if (phase_ == phase::init)
+      this->hamiltonian_.init(this->z_, logger);
+    else
+      this->hamiltonian_.update_potential_gradient(this->z_, logger);
+  }
+
+  /**
+   * Consume the gradient at the current position and move the
+   * trajectory forward until the next gradient is needed or the
+   * trajectory is complete.
+   *
+   * @param logger Logger for messages
+   */
+  void advance(callbacks::logger& logger) {
+    if (phase_ == phase::init) {
+      this->z_init_ = this->z_;
+      H0_ = this->hamiltonian_.H(this->z_);
+      drift(logger);
+      return;
+    }
+    this->integrator_.end_update_p(this->z_, this->hamiltonian_,
+                                   0.5 * this->epsilon_, logger);
+    if (++step_ < num_steps_) {
+      drift(logger);
+      return;
+    }
+
+    double h = this->hamiltonian_.H(this->z_);
+    if (std::isnan(h))
+      h = std::numeric_limits<double>::infinity();
+    accept_prob_ = H0_ - h > 0 ? 1 : std::exp(H0_ - h);
+    q_proposal_ = this->z_.q;
+    velocity_proposal_.setZero();
+    this->hamiltonian_.add_dtau_dp(this->z_, 1, velocity_proposal_);
+    if (!(this->rand_uniform_() < accept_prob_))
+      this->z_.ps_point::operator=(this->z_init_);
+    phase_ = phase::done;
+  }
+
+  /**
+   * Finish the current transition and return the new sample.
+   *
+   * @param logger Logger for messages
+   * @return accepted state or the initial one
+   */
+  sample end_transition(callbacks::logger& logger) {
+    this->hamiltonian_.cache_gradient(this->z_);
+    this->energy_ = this->hamiltonian_.H(this->z_);
+    return this->current_sample(-this->z_.V, accept_prob_);
+  }
+
+  /**
+   * Run a complete transition, evaluating every gradient through the
+   * Hamiltonian of this chain alone.
+   *
+   * @param init_sample sample to start from
+   * @param logger Logger for messages
+   * @return new sample
+   */
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    begin_transition(init_sample, logger);
+    while (awaiting_gradient()) {
+      update_log_prob_gradient(logger);
+      advance(logger);
+    }
+    return end_transition(logger);
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {
+    names.push_back("stepsize__");
+    names.push_back("int_time__");
+    names.push_back("n_leapfrog__");
+    names.push_back("energy__");
+  }
+
+  void get_sampler_params(std::vector<double>& values) {
+    values.push_back(this->epsilon_);
+    values.push_back(this->T_);
+    values.push_back(num_steps_);
+    values.push_back(this->energy_);
+  }
+
+  /**
+   * Return the position at the start of the last transition.
+   */
+  const Eigen::VectorXd& initial_position() const noexcept {
+    return this->z_init_.q;
+  }
+
+  /**
+   * Return the final position of the last trajectory, before the
+   * Metropolis correction.
+   */
+  const Eigen::VectorXd& proposed_position() const noexcept {
+    return q_proposal_;
+  }
+
+  /**
+   * Return the velocity, the derivative of the position with respect
+   * to time, at the final position of the last trajectory.
+   */
+  const Eigen::VectorXd& proposed_velocity() const noexcept {
+    return velocity_proposal_;
+  }
+
+  /**
+   * Return the acceptance probability of the last proposal.
+   */
+  double accept_prob() const noexcept { return accept_prob_; }
+
+ protected:
+  enum class phase { done, init, leaf };
+
+  /**
+   * Apply the first half momentum update and the position update of
+   * the next leapfrog step, leaving the sampler at the position whose
+   * gradient is needed next.
+   *
+   * @param logger Logger for messages
+   */
+  void drift(callbacks::logger& logger) {
+    this->integrator_.begin_update_p(this->z_, this->hamiltonian_,
+                                     0.5 * this->epsilon_, logger);
+    this->hamiltonian_.add_dtau_dp(this->z_, this->epsilon_, this->z_.q);
+    phase_ = phase::leaf;
+  }
+
+  phase phase_{phase::done};
+  double jitter_{1};
+  int num_steps_{0};
+  int step_{0};
+  double H0_{0};
+  double accept_prob_{0};
+  Eigen::VectorXd q_proposal_;
+  Eigen::VectorXd velocity_proposal_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
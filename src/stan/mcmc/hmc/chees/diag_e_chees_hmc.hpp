@@ -0,0 +1,28 @@
+#ifndef STAN_MCMC_HMC_CHEES_DIAG_E_CHEES_HMC_HPP
+#define STAN_MCMC_HMC_CHEES_DIAG_E_CHEES_HMC_HPP
+
+#include <stan/mcmc/hmc/chees/base_chees_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Hamiltonian Monte Carlo with a static, jittered integration time
+ * shared between chains
+ * with a Gaussian-Euclidean disintegration and diagonal metric
+ */
+template <class Model, class BaseRNG>
+class diag_e_chees_hmc : public base_chees_hmc<Model, diag_e_metric, BaseRNG> {
+ public:
+  diag_e_chees_hmc(const Model& model, BaseRNG& rng)
+      : base_chees_hmc<Model, diag_e_metric, BaseRNG>(model, rng) {}
+
+  void set_metric(const Eigen::VectorXd& inv_e_metric) {
+    this->z_.set_metric(inv_e_metric);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -2,11 +2,18 @@
 #define STAN_MCMC_HMC_HAMILTONIANS_BASE_HAMILTONIAN_HPP
 
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <stan/model/gradient.hpp>
+#include <stan/model/log_prob_grad_terms.hpp>
 #include <stan/model/log_prob_propto.hpp>
+#include <stan/model/tape_memory.hpp>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
@@ -16,7 +23,15 @@ namespace mcmc {
 template <class Model, class Point, class BaseRNG>
 class base_hamiltonian {
  public:
-  explicit base_hamiltonian(const Model& model) : model_(model) {}
+  explicit base_hamiltonian(const Model& model)
+      : model_(model),
+        use_gradient_cache_(true),
+        use_parallel_terms_(false),
+        gradient_cache_valid_(false),
+        gradient_cache_V_(0),
+        num_gradient_evaluations_(0),
+        num_gradient_cache_hits_(0),
+        gradient_time_(0) {}
 
   ~base_hamiltonian() {}
 
@@ -40,12 +55,71 @@ class base_hamiltonian {
 
   virtual Eigen::VectorXd dtau_dp(Point& z) = 0;
 
+  /**
+   * Write dtau_dp at z to p_sharp and return the Hamiltonian at z.
+   * Metrics that can compute both in one pass over the momentum
+   * override this.
+   *
+   * @param z point in phase space
+   * @param[out] p_sharp velocity at z
+   * @return Hamiltonian at z
+   */
+  virtual double H_and_dtau_dp(Point& z, Eigen::VectorXd& p_sharp) {
+    p_sharp = dtau_dp(z);
+    return H(z);
+  }
+
+  /**
+   * Add scale times dtau_dp at z to out.  The integrators update the
+   * position with this once per leapfrog step; metrics whose velocity
+   * is a simple expression of the momentum override it to accumulate
+   * into out without a temporary vector.
+   *
+   * @param z point in phase space
+   * @param scale factor multiplying dtau_dp
+   * @param[in, out] out vector to add to, not aliasing z.p
+   */
+  virtual void add_dtau_dp(Point& z, double scale, Eigen::VectorXd& out) {
+    out += scale * dtau_dp(z);
+  }
+
   // phi = 0.5 * log | Lambda (q) | + V(q)
   virtual Eigen::VectorXd dphi_dq(Point& z, callbacks::logger& logger) = 0;
 
+  /**
+   * Add scale times dphi_dq at z to out.  Euclidean metrics override
+   * this to accumulate the potential gradient held by z without a
+   * copy.
+   *
+   * @param z point in phase space
+   * @param scale factor multiplying dphi_dq
+   * @param[in, out] out vector to add to, not aliasing z.g
+   * @param logger logger for messages
+   */
+  virtual void add_dphi_dq(Point& z, double scale, Eigen::VectorXd& out,
+                           callbacks::logger& logger) {
+    out += scale * dphi_dq(z, logger);
+  }
+
   virtual void sample_p(Point& z, BaseRNG& rng) = 0;
 
+  /**
+   * Update the potential and its gradient at the start of a
+   * transition.  If z.q is exactly the position stored by
+   * cache_gradient, usually the state returned by the previous
+   * transition, the stored values are copied instead of evaluating
+   * the model again.  Gradients along the trajectory go through
+   * update_potential_gradient, which never consults the cache.
+   */
   void init(Point& z, callbacks::logger& logger) {
+    if (use_gradient_cache_ && gradient_cache_valid_
+        && z.q.size() == gradient_cache_q_.size()
+        && (z.q.array() == gradient_cache_q_.array()).all()) {
+      z.V = gradient_cache_V_;
+      z.g = gradient_cache_g_;
+      ++num_gradient_cache_hits_;
+      return;
+    }
     this->update_potential_gradient(z, logger);
   }
 
@@ -59,16 +133,127 @@ class base_hamiltonian {
   }
 
   void update_potential_gradient(Point& z, callbacks::logger& logger) {
+    STAN_TRACE_SCOPE("gradient");
+    ++num_gradient_evaluations_;
+    auto start = std::chrono::steady_clock::now();
     try {
-      stan::model::gradient(model_, z.q, z.V, z.g, logger);
+      if (use_parallel_terms_)
+        terms_gradient_(z, logger);
+      else
+        stan::model::gradient(model_, z.q, z.V, z.g, tape_usage_, msgs_,
+                              logger);
       z.V = -z.V;
+      peak_tape_usage_.update_peak(tape_usage_);
     } catch (const std::domain_error& e) {
       this->write_error_msg_(e, logger);
       z.V = std::numeric_limits<double>::infinity();
     }
+    gradient_time_ += std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
     z.g = -z.g;
   }
 
+  /**
+   * Store the position, potential and gradient of a point whose
+   * gradient is known to be current as the single entry of the
+   * gradient cache, so that init at the same position is free.
+   * Samplers call this with the state they return from a transition,
+   * whose gradient is usually not the last one evaluated.
+   *
+   * @param z point with up to date potential and gradient
+   */
+  void cache_gradient(const Point& z) {
+    if (!use_gradient_cache_ || !std::isfinite(z.V))
+      return;
+    gradient_cache_q_ = z.q;
+    gradient_cache_V_ = z.V;
+    gradient_cache_g_ = z.g;
+    gradient_cache_valid_ = true;
+  }
+
+  /**
+   * Discard the gradient cache entry.
+   */
+  void clear_gradient_cache() { gradient_cache_valid_ = false; }
+
+  /**
+   * Enable or disable the gradient cache.  Disabling it also discards
+   * the current entry.
+   */
+  void set_gradient_cache(bool use_cache) {
+    use_gradient_cache_ = use_cache;
+    gradient_cache_valid_ = false;
+  }
+
+  /**
+   * Enable or disable parallel terms.  When enabled, gradients are
+   * evaluated with <code>stan::model::log_prob_grad_terms</code>, which
+   * differentiates the terms of a model that splits its log density
+   * into independent terms on separate threads; other models are
+   * evaluated as usual.
+   */
+  void set_parallel_terms(bool use_terms) { use_parallel_terms_ = use_terms; }
+
+  /**
+   * Return the number of model gradient evaluations made by
+   * update_potential_gradient.
+   */
+  inline long num_gradient_evaluations() const noexcept {
+    return num_gradient_evaluations_;
+  }
+
+  /**
+   * Return the number of gradient updates served by the cache.
+   */
+  inline long num_gradient_cache_hits() const noexcept {
+    return num_gradient_cache_hits_;
+  }
+
+  /**
+   * Return the wall-clock time in seconds spent in model gradient
+   * evaluations made by update_potential_gradient.
+   */
+  inline double gradient_time() const noexcept { return gradient_time_; }
+
+  /**
+   * Return the size of the reverse-mode tape of the last gradient
+   * evaluated by update_potential_gradient.  Gradients evaluated with
+   * parallel terms record their tapes elsewhere and are not measured.
+   */
+  inline const stan::model::tape_usage& last_tape_usage() const noexcept {
+    return tape_usage_;
+  }
+
+  /**
+   * Return the largest sizes of the reverse-mode tapes of the gradients
+   * evaluated by update_potential_gradient since construction or the
+   * last call to reset_peak_tape_usage.
+   */
+  inline const stan::model::tape_usage& peak_tape_usage() const noexcept {
+    return peak_tape_usage_;
+  }
+
+  void reset_peak_tape_usage() { peak_tape_usage_ = stan::model::tape_usage(); }
+
+  /**
+   * Add the gradient counters of a copy of this Hamiltonian which did
+   * work on its behalf, e.g. on another thread.
+   */
+  void add_gradient_counters(long num_gradient_evaluations,
+                             long num_gradient_cache_hits,
+                             double gradient_time) {
+    num_gradient_evaluations_ += num_gradient_evaluations;
+    num_gradient_cache_hits_ += num_gradient_cache_hits;
+    gradient_time_ += gradient_time;
+  }
+
+  void reset_gradient_counters() {
+    num_gradient_evaluations_ = 0;
+    num_gradient_cache_hits_ = 0;
+    gradient_time_ = 0;
+  }
+
   void update_metric(Point& z, callbacks::logger& logger) {}
 
   void update_metric_gradient(Point& z, callbacks::logger& logger) {}
@@ -80,6 +265,45 @@ class base_hamiltonian {
  protected:
   const Model& model_;
 
+  /**
+   * One-entry cache of the potential and gradient, keyed on position
+   * and consulted only by init
+   */
+  bool use_gradient_cache_;
+  bool gradient_cache_valid_;
+  Eigen::VectorXd gradient_cache_q_;
+  double gradient_cache_V_;
+  Eigen::VectorXd gradient_cache_g_;
+
+  /**
+   * Whether the terms of the log density are differentiated in parallel
+   */
+  bool use_parallel_terms_;
+
+  /**
+   * Sink for the messages of the model, kept across gradient
+   * evaluations
+   */
+  callbacks::message_sink msgs_;
+
+  long num_gradient_evaluations_;
+  long num_gradient_cache_hits_;
+  double gradient_time_;
+  stan::model::tape_usage tape_usage_;
+  stan::model::tape_usage peak_tape_usage_;
+
+  void terms_gradient_(Point& z, callbacks::logger& logger) {
+    msgs_.clear_messages();
+    try {
+      z.V = stan::model::log_prob_grad_terms<true, true>(model_, z.q, z.g,
+                                                        &msgs_);
+    } catch (const std::exception& e) {
+      msgs_.flush_to(logger);
+      throw;
+    }
+    msgs_.flush_to(logger);
+  }
+
   void write_error_msg_(const std::exception& e, callbacks::logger& logger) {
     logger.error(
         "Informational Message: The current Metropolis proposal "
@@ -18,9 +18,7 @@ class dense_e_metric : public base_hamiltonian<Model, dense_e_point, BaseRNG> {
   explicit dense_e_metric(const Model& model)
       : base_hamiltonian<Model, dense_e_point, BaseRNG>(model) {}
 
-  double T(dense_e_point& z) {
-    return 0.5 * z.p.transpose() * z.inv_e_metric_ * z.p;
-  }
+  double T(dense_e_point& z) { return 0.5 * z.p.dot(z.velocity()); }
 
   double tau(dense_e_point& z) { return T(z); }
 
@@ -34,23 +32,34 @@ class dense_e_metric : public base_hamiltonian<Model, dense_e_point, BaseRNG> {
     return Eigen::VectorXd::Zero(this->model_.num_params_r());
   }
 
-  Eigen::VectorXd dtau_dp(dense_e_point& z) { return z.inv_e_metric_ * z.p; }
+  Eigen::VectorXd dtau_dp(dense_e_point& z) { return z.velocity(); }
+
+  void add_dtau_dp(dense_e_point& z, double scale, Eigen::VectorXd& out) {
+    out += scale * z.velocity();
+  }
 
   Eigen::VectorXd dphi_dq(dense_e_point& z, callbacks::logger& logger) {
     return z.g;
   }
 
+  void add_dphi_dq(dense_e_point& z, double scale, Eigen::VectorXd& out,
+                   callbacks::logger& logger) {
+    out += scale * z.g;
+  }
+
+  /**
+   * Draw the standard normals into the momentum and solve in place,
+   * without a temporary vector.
+   */
   void sample_p(dense_e_point& z, BaseRNG& rng) {
     typedef typename stan::math::index_type<Eigen::VectorXd>::type idx_t;
     boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
         rand_dense_gaus(rng, boost::normal_distribution<>());
 
-    Eigen::VectorXd u(z.p.size());
-
-    for (idx_t i = 0; i < u.size(); ++i)
-      u(i) = rand_dense_gaus();
+    for (idx_t i = 0; i < z.p.size(); ++i)
+      z.p(i) = rand_dense_gaus();
 
-    z.p = z.inv_e_metric_.llt().matrixU().solve(u);
+    z.inv_e_metric_llt().matrixU().solveInPlace(z.p);
   }
 };
 
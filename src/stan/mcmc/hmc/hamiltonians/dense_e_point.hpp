@@ -3,6 +3,7 @@
 
 #include <stan/callbacks/writer.hpp>
 #include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <Eigen/Cholesky>
 
 namespace stan {
 namespace mcmc {
@@ -13,7 +14,8 @@ namespace mcmc {
 class dense_e_point : public ps_point {
  public:
   /**
-   * Inverse mass matrix.
+   * Inverse mass matrix.  Code that modifies it in place must call
+   * notify_metric_changed() afterwards.
    */
   Eigen::MatrixXd inv_e_metric_;
 
@@ -23,7 +25,8 @@ class dense_e_point : public ps_point {
    *
    * @param n number of dimensions
    */
-  explicit dense_e_point(int n) : ps_point(n), inv_e_metric_(n, n) {
+  explicit dense_e_point(int n)
+      : ps_point(n), inv_e_metric_(n, n), metric_changed_(true) {
     inv_e_metric_.setIdentity();
   }
 
@@ -34,6 +37,57 @@ class dense_e_point : public ps_point {
    */
   void set_metric(const Eigen::MatrixXd& inv_e_metric) {
     inv_e_metric_ = inv_e_metric;
+    notify_metric_changed();
+  }
+
+  /**
+   * Set elements of mass matrix together with its Cholesky
+   * factorization, which is then not recomputed.
+   *
+   * @param inv_e_metric initial mass matrix
+   * @param inv_e_metric_llt Cholesky factorization of inv_e_metric
+   */
+  void set_metric(const Eigen::MatrixXd& inv_e_metric,
+                  const Eigen::LLT<Eigen::MatrixXd>& inv_e_metric_llt) {
+    inv_e_metric_ = inv_e_metric;
+    notify_metric_changed();
+    inv_e_metric_llt_ = inv_e_metric_llt;
+    metric_changed_ = false;
+  }
+
+  /**
+   * Discard the cached Cholesky factor and velocity after
+   * inv_e_metric_ has been modified in place.
+   */
+  inline void notify_metric_changed() {
+    metric_changed_ = true;
+    velocity_p_.resize(0);
+  }
+
+  /**
+   * Return the Cholesky decomposition of the inverse mass matrix,
+   * computed the first time it is needed after the metric changed.
+   */
+  inline const Eigen::LLT<Eigen::MatrixXd>& inv_e_metric_llt() {
+    if (metric_changed_) {
+      inv_e_metric_llt_.compute(inv_e_metric_);
+      metric_changed_ = false;
+    }
+    return inv_e_metric_llt_;
+  }
+
+  /**
+   * Return the velocity, the product of the inverse mass matrix and
+   * the momentum.  The product is recomputed only when p differs from
+   * the momentum of the previous call, so the kinetic energy and its
+   * gradient at the same point share one matrix-vector product.
+   */
+  inline const Eigen::VectorXd& velocity() {
+    if (velocity_p_.size() != p.size() || velocity_p_ != p) {
+      velocity_.noalias() = inv_e_metric_ * p;
+      velocity_p_ = p;
+    }
+    return velocity_;
   }
 
   /**
@@ -52,7 +106,33 @@ class dense_e_point : public ps_point {
     }
   }
 
+  inline std::size_t advise_huge_pages() {
+    return ps_point::advise_huge_pages()
+           + mcmc::advise_huge_pages(inv_e_metric_);
+  }
+
+  inline void write_checkpoint(checkpoint_writer& writer) const {
+    ps_point::write_checkpoint(writer);
+    writer.write(inv_e_metric_);
+  }
+
+  inline void read_checkpoint(checkpoint_reader& reader) {
+    ps_point::read_checkpoint(reader);
+    reader.read(inv_e_metric_, q.size(), q.size());
+    notify_metric_changed();
+  }
+
   inline std::string metric_type() { return "dense_e"; }
+
+ private:
+  bool metric_changed_;
+  Eigen::LLT<Eigen::MatrixXd> inv_e_metric_llt_;
+
+  /**
+   * Momentum at which velocity_ was computed
+   */
+  Eigen::VectorXd velocity_p_;
+  Eigen::VectorXd velocity_;
 };
 
 }  // namespace mcmc
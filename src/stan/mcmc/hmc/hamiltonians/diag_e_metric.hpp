@@ -6,6 +6,7 @@
 #include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
 #include <boost/random/variate_generator.hpp>
 #include <boost/random/normal_distribution.hpp>
+#include <algorithm>
 
 namespace stan {
 namespace mcmc {
@@ -37,16 +38,50 @@ class diag_e_metric : public base_hamiltonian<Model, diag_e_point, BaseRNG> {
     return z.inv_e_metric_.cwiseProduct(z.p);
   }
 
+  void add_dtau_dp(diag_e_point& z, double scale, Eigen::VectorXd& out) {
+    out.array() += scale * z.inv_e_metric_.array() * z.p.array();
+  }
+
+  /**
+   * Compute the velocity and the kinetic energy block by block, so
+   * that each block of the momentum is read from cache by the second
+   * product.
+   */
+  double H_and_dtau_dp(diag_e_point& z, Eigen::VectorXd& p_sharp) {
+    const Eigen::Index block_size = 256;
+    const Eigen::Index n = z.p.size();
+    p_sharp.resize(n);
+    double p_dot_p_sharp = 0;
+    for (Eigen::Index i = 0; i < n; i += block_size) {
+      const Eigen::Index m = std::min(block_size, n - i);
+      p_sharp.segment(i, m).noalias()
+          = z.inv_e_metric_.segment(i, m).cwiseProduct(z.p.segment(i, m));
+      p_dot_p_sharp += z.p.segment(i, m).dot(p_sharp.segment(i, m));
+    }
+    return 0.5 * p_dot_p_sharp + this->V(z);
+  }
+
   Eigen::VectorXd dphi_dq(diag_e_point& z, callbacks::logger& logger) {
     return z.g;
   }
 
+  void add_dphi_dq(diag_e_point& z, double scale, Eigen::VectorXd& out,
+                   callbacks::logger& logger) {
+    out += scale * z.g;
+  }
+
+  /**
+   * Draw the standard normals in one sweep, keeping the order in which
+   * they are taken from the generator, then scale them in a single
+   * vectorized pass.
+   */
   void sample_p(diag_e_point& z, BaseRNG& rng) {
     boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
         rand_diag_gaus(rng, boost::normal_distribution<>());
 
     for (int i = 0; i < z.p.size(); ++i)
-      z.p(i) = rand_diag_gaus() / sqrt(z.inv_e_metric_(i));
+      z.p(i) = rand_diag_gaus();
+    z.p.array() /= z.inv_e_metric_.array().sqrt();
   }
 };
 
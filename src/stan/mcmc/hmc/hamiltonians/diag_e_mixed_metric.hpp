@@ -0,0 +1,51 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_DIAG_E_MIXED_METRIC_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_DIAG_E_MIXED_METRIC_HPP
+
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Euclidean manifold with diagonal metric whose position updates use
+ * a single precision copy of the inverse metric.
+ *
+ * The copy is refreshed by sample_p, which starts every trajectory, so
+ * a metric changed by adaptation is picked up at the next transition.
+ * The kinetic energy, and with it the Hamiltonian checked against the
+ * divergence tolerance, is still computed in double precision.
+ */
+template <class Model, class BaseRNG>
+class diag_e_mixed_metric : public diag_e_metric<Model, BaseRNG> {
+ public:
+  explicit diag_e_mixed_metric(const Model& model)
+      : diag_e_metric<Model, BaseRNG>(model) {}
+
+  void sample_p(diag_e_point& z, BaseRNG& rng) {
+    inv_e_metric_f_ = z.inv_e_metric_.template cast<float>();
+    diag_e_metric<Model, BaseRNG>::sample_p(z, rng);
+  }
+
+  /**
+   * Move the position along the velocity by the specified step,
+   * computing the velocity in single precision.
+   *
+   * @param z point to update
+   * @param epsilon step size
+   */
+  void add_velocity(diag_e_point& z, double epsilon) {
+    if (inv_e_metric_f_.size() != z.inv_e_metric_.size())
+      inv_e_metric_f_ = z.inv_e_metric_.template cast<float>();
+    z.q.array() += (static_cast<float>(epsilon) * inv_e_metric_f_.array()
+                    * z.p.array().template cast<float>())
+                       .template cast<double>();
+  }
+
+ private:
+  Eigen::VectorXf inv_e_metric_f_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
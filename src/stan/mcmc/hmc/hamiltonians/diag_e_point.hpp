@@ -50,6 +50,21 @@ class diag_e_point : public ps_point {
     writer(inv_e_metric_ss.str());
   }
 
+  inline std::size_t advise_huge_pages() {
+    return ps_point::advise_huge_pages()
+           + mcmc::advise_huge_pages(inv_e_metric_);
+  }
+
+  inline void write_checkpoint(checkpoint_writer& writer) const {
+    ps_point::write_checkpoint(writer);
+    writer.write(inv_e_metric_);
+  }
+
+  inline void read_checkpoint(checkpoint_reader& reader) {
+    ps_point::read_checkpoint(reader);
+    reader.read(inv_e_metric_, q.size(), 1);
+  }
+
   inline std::string metric_type() { return "diag_e"; }
 };
 
@@ -0,0 +1,87 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_LANCZOS_EIGEN_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_LANCZOS_EIGEN_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Approximate the eigenpairs of largest magnitude of a symmetric
+ * matrix that is only available through matrix-vector products.
+ *
+ * Runs num_steps iterations of the Lanczos process from the start
+ * vector, reorthogonalizing every new vector against the whole Krylov
+ * basis, and returns the Ritz pairs of largest absolute value.  With
+ * num_steps equal to the dimension the decomposition is exact up to
+ * rounding, unless the start vector lies in an invariant subspace, in
+ * which case the process stops early and fewer pairs may be returned.
+ *
+ * @tparam F type of functor with signature
+ *   Eigen::VectorXd(const Eigen::VectorXd&)
+ * @param[in] times functor returning the product of the matrix with a
+ *   vector
+ * @param[in] start nonzero start vector
+ * @param[in] num_steps maximum dimension of the Krylov basis
+ * @param[in] k maximum number of eigenpairs returned
+ * @param[out] values eigenvalues, in decreasing order of magnitude
+ * @param[out] vectors orthonormal eigenvectors, one column per value
+ */
+template <typename F>
+void lanczos_eigen(const F& times, const Eigen::VectorXd& start,
+                   int num_steps, int k, Eigen::VectorXd& values,
+                   Eigen::MatrixXd& vectors) {
+  const Eigen::Index n = start.size();
+  const Eigen::Index m_max
+      = std::max<Eigen::Index>(1, std::min<Eigen::Index>(num_steps, n));
+  Eigen::MatrixXd basis(n, m_max);
+  Eigen::VectorXd diag(m_max);
+  Eigen::VectorXd sub_diag(m_max);
+
+  basis.col(0) = start / start.norm();
+  Eigen::Index m = 0;
+  double scale = 0;
+  while (m < m_max) {
+    Eigen::VectorXd w = times(basis.col(m));
+    diag(m) = basis.col(m).dot(w);
+    scale = std::max(scale, w.norm());
+    // Two passes of Gram-Schmidt keep the basis orthogonal to rounding
+    for (int pass = 0; pass < 2; ++pass)
+      w.noalias() -= basis.leftCols(m + 1)
+                     * (basis.leftCols(m + 1).transpose() * w);
+    ++m;
+    if (m == m_max)
+      break;
+    sub_diag(m - 1) = w.norm();
+    if (!(sub_diag(m - 1) > 1e-12 * scale))
+      break;
+    basis.col(m) = w / sub_diag(m - 1);
+  }
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritz;
+  ritz.computeFromTridiagonal(diag.head(m), sub_diag.head(m - 1));
+
+  std::vector<Eigen::Index> order(m);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](Eigen::Index a, Eigen::Index b) {
+                     return std::fabs(ritz.eigenvalues()(a))
+                            > std::fabs(ritz.eigenvalues()(b));
+                   });
+
+  const Eigen::Index num_pairs = std::max(0, std::min<int>(k, m));
+  values.resize(num_pairs);
+  vectors.resize(n, num_pairs);
+  for (Eigen::Index j = 0; j < num_pairs; ++j) {
+    values(j) = ritz.eigenvalues()(order[j]);
+    vectors.col(j) = basis.leftCols(m) * ritz.eigenvectors().col(order[j]);
+  }
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,172 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_E_POINT_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_E_POINT_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Point in a phase space with a base
+ * Euclidean manifold with a metric whose inverse is
+ * a diagonal matrix plus a low-rank term,
+ * inv_e_metric = diag(d) + W * W^T.
+ *
+ * With S = diag(sqrt(d)) the inverse metric is kept as
+ * S * (I + Q * diag(lambda) * Q^T) * S, where the orthonormal columns
+ * of Q and the nonnegative lambda come from a thin decomposition of
+ * S^-1 * W, so that every product with the metric, its inverse or
+ * their square roots costs O(N k) for rank k.
+ */
+class lowrank_e_point : public ps_point {
+ public:
+  /**
+   * Vector of diagonal elements d of the inverse mass matrix.
+   */
+  Eigen::VectorXd inv_e_metric_;
+
+  /**
+   * Low-rank factor W of the inverse mass matrix, one column per
+   * direction.
+   */
+  Eigen::MatrixXd inv_e_metric_lowrank_;
+
+  /**
+   * Construct a low-rank point in n-dimensional phase space
+   * with the identity as inverse mass matrix.
+   *
+   * @param n number of dimensions
+   */
+  explicit lowrank_e_point(int n)
+      : ps_point(n), inv_e_metric_(n), inv_e_metric_lowrank_(n, 0) {
+    inv_e_metric_.setOnes();
+    update_factors();
+  }
+
+  /**
+   * Set the diagonal of the inverse mass matrix, dropping the low-rank
+   * term.
+   *
+   * @param inv_e_metric diagonal elements of the inverse mass matrix
+   */
+  void set_metric(const Eigen::VectorXd& inv_e_metric) {
+    inv_e_metric_ = inv_e_metric;
+    inv_e_metric_lowrank_.resize(inv_e_metric.size(), 0);
+    update_factors();
+  }
+
+  /**
+   * Set the inverse mass matrix to diag(inv_e_metric) + lowrank *
+   * lowrank^T.
+   *
+   * @param inv_e_metric diagonal elements of the inverse mass matrix
+   * @param lowrank low-rank factor, one column per direction
+   */
+  void set_metric(const Eigen::VectorXd& inv_e_metric,
+                  const Eigen::MatrixXd& lowrank) {
+    inv_e_metric_ = inv_e_metric;
+    inv_e_metric_lowrank_ = lowrank;
+    update_factors();
+  }
+
+  /**
+   * Recompute the factors used by the metric.  Must be called after
+   * inv_e_metric_ or inv_e_metric_lowrank_ are changed directly.
+   */
+  void update_factors() {
+    sqrt_inv_e_metric_ = inv_e_metric_.array().sqrt();
+    const Eigen::Index k = inv_e_metric_lowrank_.cols();
+    if (k == 0) {
+      lowrank_basis_.resize(inv_e_metric_.size(), 0);
+      lowrank_values_.resize(0);
+      return;
+    }
+    Eigen::MatrixXd scaled = sqrt_inv_e_metric_.cwiseInverse().asDiagonal()
+                             * inv_e_metric_lowrank_;
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(scaled, Eigen::ComputeThinU);
+    lowrank_basis_ = svd.matrixU();
+    lowrank_values_ = svd.singularValues().array().square();
+  }
+
+  /**
+   * Return inv_e_metric * p.
+   *
+   * @param p momentum
+   */
+  Eigen::VectorXd inv_e_metric_times(const Eigen::VectorXd& p) const {
+    return inv_e_metric_.cwiseProduct(p)
+           + inv_e_metric_lowrank_ * (inv_e_metric_lowrank_.transpose() * p);
+  }
+
+  /**
+   * Return a matrix square root of the mass matrix times z, so that
+   * z drawn from a standard normal gives momenta with covariance equal
+   * to the mass matrix.
+   *
+   * @param z vector of standard normal variates
+   */
+  Eigen::VectorXd sqrt_e_metric_times(const Eigen::VectorXd& z) const {
+    Eigen::VectorXd scale
+        = (1.0 + lowrank_values_.array()).rsqrt() - 1.0;
+    Eigen::VectorXd y
+        = z
+          + lowrank_basis_
+                * scale.cwiseProduct(lowrank_basis_.transpose() * z);
+    return y.cwiseQuotient(sqrt_inv_e_metric_);
+  }
+
+  /**
+   * Write elements of mass matrix to string and handoff to writer.
+   *
+   * @param writer Stan writer callback
+   */
+  inline void write_metric(stan::callbacks::writer& writer) {
+    writer("Diagonal elements of inverse mass matrix:");
+    std::stringstream inv_e_metric_ss;
+    inv_e_metric_ss << inv_e_metric_(0);
+    for (int i = 1; i < inv_e_metric_.size(); ++i)
+      inv_e_metric_ss << ", " << inv_e_metric_(i);
+    writer(inv_e_metric_ss.str());
+    if (inv_e_metric_lowrank_.cols() == 0)
+      return;
+    writer("Low-rank factor of inverse mass matrix:");
+    for (int j = 0; j < inv_e_metric_lowrank_.cols(); ++j) {
+      std::stringstream lowrank_ss;
+      lowrank_ss << inv_e_metric_lowrank_(0, j);
+      for (int i = 1; i < inv_e_metric_lowrank_.rows(); ++i)
+        lowrank_ss << ", " << inv_e_metric_lowrank_(i, j);
+      writer(lowrank_ss.str());
+    }
+  }
+
+  inline void write_checkpoint(checkpoint_writer& writer) const {
+    ps_point::write_checkpoint(writer);
+    writer.write(inv_e_metric_);
+    writer.write(inv_e_metric_lowrank_);
+  }
+
+  inline void read_checkpoint(checkpoint_reader& reader) {
+    ps_point::read_checkpoint(reader);
+    reader.read(inv_e_metric_, q.size(), 1);
+    reader.read(inv_e_metric_lowrank_);
+    if (inv_e_metric_lowrank_.rows() != q.size())
+      throw std::runtime_error(
+          "Checkpoint does not match the dimensions of the sampler.");
+    update_factors();
+  }
+
+  inline std::string metric_type() { return "lowrank_e"; }
+
+ private:
+  Eigen::VectorXd sqrt_inv_e_metric_;
+  Eigen::MatrixXd lowrank_basis_;
+  Eigen::VectorXd lowrank_values_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_SOFTABS_METRIC_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_SOFTABS_METRIC_HPP
+
+#include <stan/math/mix.hpp>
+#include <stan/mcmc/hmc/hamiltonians/base_hamiltonian.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lanczos_eigen.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_softabs_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/softabs_metric.hpp>
+#include <stan/model/hessian_times_vector.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <cmath>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Riemannian manifold with a SoftAbs metric of a low-rank
+ * approximation of the Hessian.
+ *
+ * The Hessian of the potential is only touched through
+ * Hessian-vector products: a Lanczos process finds its k eigenpairs
+ * of largest magnitude, and the remaining eigenvalues are treated as
+ * zero, so that the metric is the SoftAbs transform of the rank-k
+ * truncation, namely softabs(lambda_i) along the kept eigenvectors and
+ * 1 / alpha in every other direction.  The gradients of the metric
+ * follow the same model, which makes them exact when the rest of the
+ * spectrum vanishes and approximate otherwise; they need k + 2
+ * third-order directional derivatives instead of the dense Hessian,
+ * its O(N^3) eigendecomposition and the O(N) sweeps of
+ * grad_tr_mat_times_hessian.  With k equal to the dimension this is
+ * the softabs_metric.
+ */
+template <class Model, class BaseRNG>
+class lowrank_softabs_metric
+    : public base_hamiltonian<Model, lowrank_softabs_point, BaseRNG> {
+ public:
+  explicit lowrank_softabs_metric(const Model& model)
+      : base_hamiltonian<Model, lowrank_softabs_point, BaseRNG>(model) {}
+
+  double T(lowrank_softabs_point& z) {
+    return this->tau(z) + 0.5 * z.log_det_metric;
+  }
+
+  double tau(lowrank_softabs_point& z) { return 0.5 * z.p.dot(dtau_dp(z)); }
+
+  double phi(lowrank_softabs_point& z) {
+    return this->V(z) + 0.5 * z.log_det_metric;
+  }
+
+  double dG_dt(lowrank_softabs_point& z, callbacks::logger& logger) {
+    return 2 * T(z) - z.q.dot(dtau_dq(z, logger) + dphi_dq(z, logger));
+  }
+
+  Eigen::VectorXd dtau_dq(lowrank_softabs_point& z,
+                          callbacks::logger& logger) {
+    const Eigen::Index k = z.eigenvalues.size();
+    if (k == 0)
+      return Eigen::VectorXd::Zero(z.q.size());
+
+    // Inverse metric times p, split into the kept eigenbasis and the
+    // orthogonal rest
+    Eigen::VectorXd v = dtau_dp(z);
+    Eigen::VectorXd a = z.eigenvectors.transpose() * v;
+    Eigen::VectorXd w = v - z.eigenvectors * a;
+
+    // The derivative is the trace of M times the derivative of the
+    // Hessian with M = U (J o a a^T) U^T + x w^T + w x^T, written as a
+    // weighted sum of k + 2 rank one terms
+    Eigen::MatrixXd J = z.pseudo_j.selfadjointView<Eigen::Lower>();
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> b_deco(
+        J.cwiseProduct(a * a.transpose()));
+    Eigen::VectorXd x = z.eigenvectors * z.pseudo_j_iso.cwiseProduct(a);
+
+    Eigen::MatrixXd directions(z.q.size(), k + 2);
+    Eigen::VectorXd weights(k + 2);
+    directions.leftCols(k) = z.eigenvectors * b_deco.eigenvectors();
+    weights.head(k) = b_deco.eigenvalues();
+    directions.col(k) = x + w;
+    weights(k) = 0.5;
+    directions.col(k + 1) = x - w;
+    weights(k + 1) = -0.5;
+
+    return 0.5 * grad_hessian_forms(z.q, directions, weights);
+  }
+
+  Eigen::VectorXd dtau_dp(lowrank_softabs_point& z) {
+    const double iso_inv = 1.0 / z.softabs_iso();
+    Eigen::VectorXd up = z.eigenvectors.transpose() * z.p;
+    return iso_inv * z.p
+           + z.eigenvectors
+                 * (z.softabs_lambda_inv.array() - iso_inv)
+                       .matrix()
+                       .cwiseProduct(up);
+  }
+
+  Eigen::VectorXd dphi_dq(lowrank_softabs_point& z,
+                          callbacks::logger& logger) {
+    if (z.eigenvalues.size() == 0)
+      return z.g;
+    Eigen::VectorXd weights
+        = z.softabs_lambda_inv.cwiseProduct(z.pseudo_j.diagonal());
+    return -0.5 * grad_hessian_forms(z.q, z.eigenvectors, weights) + z.g;
+  }
+
+  void sample_p(lowrank_softabs_point& z, BaseRNG& rng) {
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_unit_gaus(rng, boost::normal_distribution<>());
+
+    Eigen::VectorXd a(z.p.size());
+    for (Eigen::Index n = 0; n < a.size(); ++n)
+      a(n) = rand_unit_gaus();
+
+    const double sqrt_iso = std::sqrt(z.softabs_iso());
+    Eigen::VectorXd ua = z.eigenvectors.transpose() * a;
+    z.p = sqrt_iso * a
+          + z.eigenvectors
+                * (z.softabs_lambda.array().sqrt() - sqrt_iso)
+                      .matrix()
+                      .cwiseProduct(ua);
+  }
+
+  void init(lowrank_softabs_point& z, callbacks::logger& logger) {
+    update_metric(z, logger);
+    update_metric_gradient(z, logger);
+  }
+
+  void update_metric(lowrank_softabs_point& z, callbacks::logger& logger) {
+    this->update_potential_gradient(z, logger);
+
+    // A fixed start vector keeps the metric a function of q alone
+    Eigen::VectorXd start(z.q.size());
+    for (Eigen::Index i = 0; i < start.size(); ++i)
+      start(i) = 1.0 + 0.5 * std::sin(1.0 + i);
+
+    lanczos_eigen(
+        [&](const Eigen::VectorXd& v) {
+          double lp;
+          Eigen::VectorXd hv;
+          stan::model::hessian_times_vector(this->model_, z.q, v, lp, hv);
+          return Eigen::VectorXd(-hv);
+        },
+        start, z.krylov_dim(), z.rank, z.eigenvalues, z.eigenvectors);
+
+    const Eigen::Index k = z.eigenvalues.size();
+    z.softabs_lambda.resize(k);
+    z.softabs_lambda_inv.resize(k);
+    for (Eigen::Index i = 0; i < k; ++i) {
+      z.softabs_lambda(i) = softabs(z.alpha, z.eigenvalues(i));
+      z.softabs_lambda_inv(i) = 1.0 / z.softabs_lambda(i);
+    }
+
+    // Compute the log determinant of the metric
+    z.log_det_metric = (z.q.size() - k) * std::log(z.softabs_iso());
+    for (Eigen::Index i = 0; i < k; ++i)
+      z.log_det_metric += std::log(z.softabs_lambda(i));
+  }
+
+  void update_metric_gradient(lowrank_softabs_point& z,
+                              callbacks::logger& logger) {
+    const Eigen::Index k = z.eigenvalues.size();
+    z.pseudo_j.resize(k, k);
+    z.pseudo_j_iso.resize(k);
+    // Compute the pseudo-Jacobian of the SoftAbs transform
+    for (Eigen::Index i = 0; i < k; ++i) {
+      for (Eigen::Index j = 0; j <= i; ++j) {
+        double delta = z.eigenvalues(i) - z.eigenvalues(j);
+        if (std::fabs(delta) < softabs_type::jacobian_thresh)
+          z.pseudo_j(i, j) = softabs_derivative(z.alpha, z.eigenvalues(i),
+                                                z.softabs_lambda(i));
+        else
+          z.pseudo_j(i, j)
+              = (z.softabs_lambda(i) - z.softabs_lambda(j)) / delta;
+      }
+
+      // Against the zero eigenvalue of the isotropic rest
+      double lambda = z.eigenvalues(i);
+      double alpha_lambda = z.alpha * lambda;
+      if (std::fabs(alpha_lambda) < softabs_type::lower_softabs_thresh)
+        z.pseudo_j_iso(i) = (1.0 / 3.0) * alpha_lambda;
+      else
+        z.pseudo_j_iso(i) = (z.softabs_lambda(i) - z.softabs_iso()) / lambda;
+    }
+  }
+
+  void update_gradients(lowrank_softabs_point& z, callbacks::logger& logger) {
+    update_metric_gradient(z, logger);
+  }
+
+ private:
+  typedef softabs_metric<Model, BaseRNG> softabs_type;
+
+  /**
+   * SoftAbs transform lambda * coth(alpha * lambda) of an eigenvalue,
+   * with the approximations of softabs_metric.
+   */
+  static double softabs(double alpha, double lambda) {
+    double alpha_lambda = alpha * lambda;
+    if (std::fabs(alpha_lambda) < softabs_type::lower_softabs_thresh)
+      return (1.0 + (1.0 / 3.0) * alpha_lambda * alpha_lambda) / alpha;
+    else if (std::fabs(alpha_lambda) > softabs_type::upper_softabs_thresh)
+      return std::fabs(lambda);
+    return lambda / std::tanh(alpha_lambda);
+  }
+
+  /**
+   * Derivative of the SoftAbs transform at an eigenvalue.
+   */
+  static double softabs_derivative(double alpha, double lambda,
+                                   double softabs_lambda) {
+    double alpha_lambda = alpha * lambda;
+    if (std::fabs(alpha_lambda) < softabs_type::lower_softabs_thresh)
+      return (2.0 / 3.0) * alpha_lambda
+             * (1.0 - (2.0 / 15.0) * alpha_lambda * alpha_lambda);
+    else if (std::fabs(alpha_lambda) > softabs_type::upper_softabs_thresh)
+      return lambda > 0 ? 1 : -1;
+    double sdx = std::sinh(alpha_lambda) / lambda;
+    return (softabs_lambda - alpha / (sdx * sdx)) / lambda;
+  }
+
+  /**
+   * Return the gradient with respect to q of
+   * sum_j weights(j) * d_j^T H(q) d_j, where H is the Hessian of the
+   * log density and d_j is column j of directions, using one
+   * forward-over-forward-over-reverse sweep per direction.
+   */
+  Eigen::VectorXd grad_hessian_forms(const Eigen::VectorXd& q,
+                                     const Eigen::MatrixXd& directions,
+                                     const Eigen::VectorXd& weights) {
+    using stan::math::fvar;
+    using stan::math::var;
+    stan::math::nested_rev_autodiff nested;
+
+    Eigen::Matrix<var, Eigen::Dynamic, 1> q_var(q.size());
+    for (Eigen::Index i = 0; i < q.size(); ++i)
+      q_var(i) = q(i);
+
+    softabs_fun<Model> f(this->model_, 0);
+    var sum = 0;
+    Eigen::Matrix<fvar<fvar<var> >, Eigen::Dynamic, 1> x(q.size());
+    for (Eigen::Index j = 0; j < directions.cols(); ++j) {
+      for (Eigen::Index i = 0; i < q.size(); ++i)
+        x(i) = fvar<fvar<var> >(fvar<var>(q_var(i), directions(i, j)),
+                                fvar<var>(directions(i, j), 0));
+      sum += weights(j) * f(x).d_.d_;
+    }
+    sum.grad();
+
+    Eigen::VectorXd grad(q.size());
+    for (Eigen::Index i = 0; i < q.size(); ++i)
+      grad(i) = q_var(i).adj();
+    return grad;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
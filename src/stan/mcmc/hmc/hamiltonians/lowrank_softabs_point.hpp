@@ -0,0 +1,80 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_SOFTABS_POINT_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_LOWRANK_SOFTABS_POINT_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Point in a phase space with a base
+ * Riemannian manifold with a SoftAbs metric
+ * built from the leading eigenpairs of the Hessian
+ */
+class lowrank_softabs_point : public ps_point {
+ public:
+  explicit lowrank_softabs_point(int n)
+      : ps_point(n),
+        alpha(1.0),
+        rank(std::min(n, 10)),
+        num_lanczos_steps(0),
+        eigenvectors(n, 0),
+        eigenvalues(0),
+        log_det_metric(0),
+        softabs_lambda(0),
+        softabs_lambda_inv(0),
+        pseudo_j(0, 0),
+        pseudo_j_iso(0) {}
+
+  // SoftAbs regularization parameter
+  double alpha;
+
+  // Maximum number of Hessian eigenpairs kept
+  int rank;
+
+  // Dimension of the Krylov basis, or zero for min(n, 2 * rank + 20)
+  int num_lanczos_steps;
+
+  // Leading eigenpairs of the Hessian, one column per eigenvalue
+  Eigen::MatrixXd eigenvectors;
+  Eigen::VectorXd eigenvalues;
+
+  // Log determinant of metric
+  double log_det_metric;
+
+  // SoftAbs transformed eigenvalues of Hessian
+  Eigen::VectorXd softabs_lambda;
+  Eigen::VectorXd softabs_lambda_inv;
+
+  // Psuedo-Jacobian of the kept eigenvalues
+  Eigen::MatrixXd pseudo_j;
+
+  // Psuedo-Jacobian between each kept eigenvalue and the isotropic rest
+  Eigen::VectorXd pseudo_j_iso;
+
+  /**
+   * Metric eigenvalue of the directions orthogonal to the kept
+   * eigenvectors, the SoftAbs transform of a zero eigenvalue.
+   */
+  inline double softabs_iso() const { return 1.0 / alpha; }
+
+  inline int krylov_dim() const {
+    const int n = q.size();
+    return num_lanczos_steps > 0 ? std::min(num_lanczos_steps, n)
+                                 : std::min(n, 2 * rank + 20);
+  }
+
+  virtual inline void write_metric(stan::callbacks::writer& writer) {
+    writer("No free parameters for low-rank SoftAbs metric");
+  }
+
+  inline std::string metric_type() { return "lowrank_softabs"; }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+#endif
@@ -2,7 +2,11 @@
 #define STAN_MCMC_HMC_HAMILTONIANS_PS_POINT_HPP
 
 #include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
+#include <stan/mcmc/diagnostic_fields.hpp>
+#include <stan/mcmc/huge_pages.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -22,25 +26,61 @@ class ps_point {
   Eigen::VectorXd g;
   double V{0};
 
-  virtual inline void get_param_names(std::vector<std::string>& model_names,
-                                      std::vector<std::string>& names) {
-    names.reserve(q.size() + p.size() + g.size());
-    for (int i = 0; i < q.size(); ++i)
-      names.emplace_back(model_names[i]);
-    for (int i = 0; i < p.size(); ++i)
-      names.emplace_back(std::string("p_") + model_names[i]);
-    for (int i = 0; i < g.size(); ++i)
-      names.emplace_back(std::string("g_") + model_names[i]);
+  /**
+   * Append the names of the diagnostics of the point: the position,
+   * momentum and gradient, each only if selected.
+   *
+   * @param model_names names of the unconstrained parameters
+   * @param names names the diagnostic names are appended to
+   * @param fields blocks of the state written
+   */
+  virtual inline void get_param_names(
+      std::vector<std::string>& model_names, std::vector<std::string>& names,
+      const diagnostic_fields& fields = diagnostic_fields()) {
+    names.reserve(names.size() + (fields.position ? q.size() : 0)
+                  + (fields.momentum ? p.size() : 0)
+                  + (fields.gradient ? g.size() : 0));
+    if (fields.position)
+      for (int i = 0; i < q.size(); ++i)
+        names.emplace_back(model_names[i]);
+    if (fields.momentum)
+      for (int i = 0; i < p.size(); ++i)
+        names.emplace_back(std::string("p_") + model_names[i]);
+    if (fields.gradient)
+      for (int i = 0; i < g.size(); ++i)
+        names.emplace_back(std::string("g_") + model_names[i]);
   }
 
-  virtual inline void get_params(std::vector<double>& values) {
-    values.reserve(q.size() + p.size() + g.size());
-    for (int i = 0; i < q.size(); ++i)
-      values.push_back(q[i]);
-    for (int i = 0; i < p.size(); ++i)
-      values.push_back(p[i]);
-    for (int i = 0; i < g.size(); ++i)
-      values.push_back(g[i]);
+  /**
+   * Append the diagnostics of the point, in the order of
+   * get_param_names().
+   *
+   * @param values values the diagnostics are appended to
+   * @param fields blocks of the state written
+   */
+  virtual inline void get_params(
+      std::vector<double>& values,
+      const diagnostic_fields& fields = diagnostic_fields()) {
+    values.reserve(values.size() + (fields.position ? q.size() : 0)
+                   + (fields.momentum ? p.size() : 0)
+                   + (fields.gradient ? g.size() : 0));
+    if (fields.position)
+      values.insert(values.end(), q.data(), q.data() + q.size());
+    if (fields.momentum)
+      values.insert(values.end(), p.data(), p.data() + p.size());
+    if (fields.gradient)
+      values.insert(values.end(), g.data(), g.data() + g.size());
+  }
+
+  /**
+   * Ask for the storage of the point to be backed with transparent
+   * huge pages, as in <code>stan::mcmc::advise_huge_pages</code>.
+   *
+   * @return number of bytes advised
+   */
+  virtual inline std::size_t advise_huge_pages() {
+    return mcmc::advise_huge_pages(q) + mcmc::advise_huge_pages(p)
+           + mcmc::advise_huge_pages(g);
   }
 
   /**
@@ -49,6 +89,33 @@ class ps_point {
    * @param writer writer callback
    */
   virtual inline void write_metric(stan::callbacks::writer& writer) {}
+
+  /**
+   * Write the position, momentum, potential and gradient, and in
+   * derived points the metric.
+   *
+   * @param writer checkpoint writer
+   */
+  virtual inline void write_checkpoint(checkpoint_writer& writer) const {
+    writer.write(q);
+    writer.write(p);
+    writer.write(g);
+    writer.write(V);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().
+   *
+   * @param reader checkpoint reader
+   * @throw std::runtime_error if the number of dimensions differs
+   */
+  virtual inline void read_checkpoint(checkpoint_reader& reader) {
+    const Eigen::Index n = q.size();
+    reader.read(q, n, 1);
+    reader.read(p, n, 1);
+    reader.read(g, n, 1);
+    reader.read(V);
+  }
 };
 
 }  // namespace mcmc
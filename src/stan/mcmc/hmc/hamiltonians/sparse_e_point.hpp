@@ -0,0 +1,202 @@
+#ifndef STAN_MCMC_HMC_HAMILTONIANS_SPARSE_E_POINT_HPP
+#define STAN_MCMC_HMC_HAMILTONIANS_SPARSE_E_POINT_HPP
+
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <Eigen/Sparse>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Point in a phase space with a base
+ * Euclidean manifold with a sparse metric.
+ *
+ * The mass matrix M, the precision of the momenta, is kept sparse
+ * with its sparse Cholesky factorization P M P^T = L D L^T, so drawing
+ * momenta is a product with L and the velocity M^-1 p is two sparse
+ * triangular solves, and both cost O(nnz(L)) instead of O(N^2).  For a
+ * banded mass matrix L keeps the band.
+ */
+class sparse_e_point : public ps_point {
+ public:
+  /**
+   * Mass matrix, with both triangles stored.  Code that modifies it in
+   * place must call update_factors() afterwards.
+   */
+  Eigen::SparseMatrix<double> e_metric_;
+
+  /**
+   * Construct a sparse point in n-dimensional phase space
+   * with identity matrix as mass matrix.
+   *
+   * @param n number of dimensions
+   */
+  explicit sparse_e_point(int n) : ps_point(n), e_metric_(n, n) {
+    e_metric_.setIdentity();
+    update_factors();
+  }
+
+  /**
+   * Set the mass matrix.
+   *
+   * @param e_metric sparse symmetric positive-definite mass matrix
+   * @throw std::domain_error if the mass matrix is not positive
+   * definite, in which case the previous mass matrix is kept
+   */
+  void set_metric(const Eigen::SparseMatrix<double>& e_metric) {
+    Eigen::SparseMatrix<double> previous = std::move(e_metric_);
+    e_metric_ = e_metric;
+    try {
+      update_factors();
+    } catch (const std::domain_error&) {
+      e_metric_ = std::move(previous);
+      throw;
+    }
+  }
+
+  /**
+   * Recompute the factorization of the mass matrix.  Must be called
+   * after e_metric_ is changed directly.
+   *
+   * @throw std::domain_error if the mass matrix is not positive definite
+   */
+  void update_factors() {
+    e_metric_.makeCompressed();
+    auto ldlt = std::make_shared<sparse_ldlt>(e_metric_);
+    if (ldlt->info() != Eigen::Success || !(ldlt->vectorD().array() > 0).all())
+      throw std::domain_error("Sparse mass matrix is not positive definite.");
+    e_metric_ldlt_ = std::move(ldlt);
+    sqrt_d_ = e_metric_ldlt_->vectorD().cwiseSqrt();
+    velocity_p_.resize(0);
+  }
+
+  /**
+   * Return the velocity, the product of the inverse mass matrix and
+   * the momentum.  The product is recomputed only when p differs from
+   * the momentum of the previous call, so the kinetic energy and its
+   * gradient at the same point share one solve.
+   */
+  inline const Eigen::VectorXd& velocity() {
+    if (velocity_p_.size() != p.size() || velocity_p_ != p) {
+      velocity_ = e_metric_ldlt_->solve(p);
+      velocity_p_ = p;
+    }
+    return velocity_;
+  }
+
+  /**
+   * Return P^T L D^1/2 z, a matrix square root of the mass matrix
+   * times z, so that z drawn from a standard normal gives momenta with
+   * covariance equal to the mass matrix.
+   *
+   * @param z vector of standard normal variates
+   */
+  Eigen::VectorXd sqrt_e_metric_times(const Eigen::VectorXd& z) const {
+    Eigen::VectorXd y = z.cwiseProduct(sqrt_d_);
+    y = e_metric_ldlt_->matrixL() * y;
+    return e_metric_ldlt_->permutationPinv() * y;
+  }
+
+  /**
+   * Write the nonzero elements of the lower triangle of the mass matrix
+   * to string and handoff to writer, one line per element.
+   *
+   * @param writer Stan writer callback
+   */
+  inline void write_metric(stan::callbacks::writer& writer) {
+    writer("Nonzero elements of mass matrix (row, column, value):");
+    for (int j = 0; j < e_metric_.outerSize(); ++j) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(e_metric_, j); it;
+           ++it) {
+        if (it.row() < j)
+          continue;
+        std::stringstream e_metric_ss;
+        e_metric_ss << it.row() << ", " << j << ", " << it.value();
+        writer(e_metric_ss.str());
+      }
+    }
+  }
+
+  /**
+   * Return the rows, columns and values of the nonzero elements of the
+   * lower triangle of the mass matrix, in column-major order.
+   *
+   * @param[out] rows zero-based rows
+   * @param[out] cols zero-based columns
+   * @param[out] values values
+   */
+  void get_metric_triplets(std::vector<int>& rows, std::vector<int>& cols,
+                           std::vector<double>& values) const {
+    rows.clear();
+    cols.clear();
+    values.clear();
+    for (int j = 0; j < e_metric_.outerSize(); ++j) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(e_metric_, j); it;
+           ++it) {
+        if (it.row() < j)
+          continue;
+        rows.push_back(it.row());
+        cols.push_back(j);
+        values.push_back(it.value());
+      }
+    }
+  }
+
+  inline void write_checkpoint(checkpoint_writer& writer) const {
+    ps_point::write_checkpoint(writer);
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+    get_metric_triplets(rows, cols, values);
+    Eigen::MatrixXd triplets(3, values.size());
+    for (size_t k = 0; k < values.size(); ++k)
+      triplets.col(k) << rows[k], cols[k], values[k];
+    writer.write(triplets);
+  }
+
+  inline void read_checkpoint(checkpoint_reader& reader) {
+    ps_point::read_checkpoint(reader);
+    Eigen::MatrixXd triplets;
+    reader.read(triplets);
+    const int n = q.size();
+    std::vector<Eigen::Triplet<double>> elements;
+    elements.reserve(2 * triplets.cols());
+    for (Eigen::Index k = 0; k < triplets.cols(); ++k) {
+      const int i = triplets(0, k);
+      const int j = triplets(1, k);
+      if (triplets.rows() != 3 || i < j || i >= n || j < 0)
+        throw std::runtime_error(
+            "Checkpoint does not match the dimensions of the sampler.");
+      elements.emplace_back(i, j, triplets(2, k));
+      if (i != j)
+        elements.emplace_back(j, i, triplets(2, k));
+    }
+    e_metric_.resize(n, n);
+    e_metric_.setFromTriplets(elements.begin(), elements.end());
+    update_factors();
+  }
+
+  inline std::string metric_type() { return "sparse_e"; }
+
+ private:
+  using sparse_ldlt = Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>;
+
+  // The factorization cannot be copied, and copies of the point share it
+  std::shared_ptr<const sparse_ldlt> e_metric_ldlt_;
+  Eigen::VectorXd sqrt_d_;
+
+  /**
+   * Momentum at which velocity_ was computed
+   */
+  Eigen::VectorXd velocity_p_;
+  Eigen::VectorXd velocity_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+#endif
@@ -32,10 +32,19 @@ class unit_e_metric : public base_hamiltonian<Model, unit_e_point, BaseRNG> {
 
   Eigen::VectorXd dtau_dp(unit_e_point& z) { return z.p; }
 
+  void add_dtau_dp(unit_e_point& z, double scale, Eigen::VectorXd& out) {
+    out += scale * z.p;
+  }
+
   Eigen::VectorXd dphi_dq(unit_e_point& z, callbacks::logger& logger) {
     return z.g;
   }
 
+  void add_dphi_dq(unit_e_point& z, double scale, Eigen::VectorXd& out,
+                   callbacks::logger& logger) {
+    out += scale * z.g;
+  }
+
   void sample_p(unit_e_point& z, BaseRNG& rng) {
     boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
         rand_unit_gaus(rng, boost::normal_distribution<>());
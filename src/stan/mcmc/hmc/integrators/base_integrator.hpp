@@ -9,12 +9,43 @@ namespace mcmc {
 template <class Hamiltonian>
 class base_integrator {
  public:
-  base_integrator() {}
+  base_integrator() : num_steps_(0) {}
 
   virtual void evolve(typename Hamiltonian::PointType& z,
                       Hamiltonian& hamiltonian, const double epsilon,
                       callbacks::logger& logger)
       = 0;
+
+  /**
+   * Take the specified number of steps along the trajectory.
+   * Integrators that can share work between consecutive steps
+   * override this.
+   *
+   * @param z point to move
+   * @param hamiltonian Hamiltonian of the trajectory
+   * @param epsilon step size
+   * @param num_steps number of steps
+   * @param logger logger for messages
+   */
+  virtual void evolve_steps(typename Hamiltonian::PointType& z,
+                            Hamiltonian& hamiltonian, const double epsilon,
+                            int num_steps, callbacks::logger& logger) {
+    for (int n = 0; n < num_steps; ++n)
+      evolve(z, hamiltonian, epsilon, logger);
+  }
+
+  /**
+   * Return the number of integration steps taken since construction.
+   */
+  inline long num_steps() const noexcept { return num_steps_; }
+
+  /**
+   * Add the steps taken by another integrator on behalf of this one.
+   */
+  inline void add_steps(long num_steps) noexcept { num_steps_ += num_steps; }
+
+ protected:
+  long num_steps_;
 };
 
 }  // namespace mcmc
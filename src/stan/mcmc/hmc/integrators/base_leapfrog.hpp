@@ -3,6 +3,7 @@
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/mcmc/hmc/integrators/base_integrator.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <iostream>
 #include <iomanip>
 
@@ -16,6 +17,8 @@ class base_leapfrog : public base_integrator<Hamiltonian> {
 
   void evolve(typename Hamiltonian::PointType& z, Hamiltonian& hamiltonian,
               const double epsilon, callbacks::logger& logger) {
+    STAN_TRACE_SCOPE("leapfrog");
+    ++this->num_steps_;
     begin_update_p(z, hamiltonian, 0.5 * epsilon, logger);
     update_q(z, hamiltonian, epsilon, logger);
     end_update_p(z, hamiltonian, 0.5 * epsilon, logger);
@@ -58,6 +61,7 @@ class base_leapfrog : public base_integrator<Hamiltonian> {
 
     double H0 = hamiltonian.H(z);
 
+    ++this->num_steps_;
     begin_update_p(z, hamiltonian, 0.5 * epsilon, logger);
 
     double H1 = hamiltonian.H(z);
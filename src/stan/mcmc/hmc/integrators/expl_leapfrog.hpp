@@ -3,6 +3,7 @@
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/mcmc/hmc/integrators/base_leapfrog.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
 
 namespace stan {
@@ -16,19 +17,43 @@ class expl_leapfrog : public base_leapfrog<Hamiltonian> {
   void begin_update_p(typename Hamiltonian::PointType& z,
                       Hamiltonian& hamiltonian, double epsilon,
                       callbacks::logger& logger) {
-    z.p -= epsilon * hamiltonian.dphi_dq(z, logger);
+    hamiltonian.add_dphi_dq(z, -epsilon, z.p, logger);
   }
 
   void update_q(typename Hamiltonian::PointType& z, Hamiltonian& hamiltonian,
                 double epsilon, callbacks::logger& logger) {
-    z.q += epsilon * hamiltonian.dtau_dp(z);
+    hamiltonian.add_dtau_dp(z, epsilon, z.q);
     hamiltonian.update_potential_gradient(z, logger);
   }
 
   void end_update_p(typename Hamiltonian::PointType& z,
                     Hamiltonian& hamiltonian, double epsilon,
                     callbacks::logger& logger) {
-    z.p -= epsilon * hamiltonian.dphi_dq(z, logger);
+    hamiltonian.add_dphi_dq(z, -epsilon, z.p, logger);
+  }
+
+  /**
+   * Take the specified number of leapfrog steps, merging the closing
+   * half step of the momentum of each step with the opening half step
+   * of the next into a single full step, as both use the gradient at
+   * the same position.  This saves a pass over the momentum per step;
+   * the trajectory matches that of repeated calls to evolve up to
+   * rounding, but its intermediate momenta are never formed.
+   */
+  void evolve_steps(typename Hamiltonian::PointType& z,
+                    Hamiltonian& hamiltonian, const double epsilon,
+                    int num_steps, callbacks::logger& logger) {
+    if (num_steps < 1)
+      return;
+    STAN_TRACE_SCOPE("leapfrog_steps");
+    this->num_steps_ += num_steps;
+    begin_update_p(z, hamiltonian, 0.5 * epsilon, logger);
+    for (int n = 1; n < num_steps; ++n) {
+      update_q(z, hamiltonian, epsilon, logger);
+      hamiltonian.add_dphi_dq(z, -epsilon, z.p, logger);
+    }
+    update_q(z, hamiltonian, epsilon, logger);
+    end_update_p(z, hamiltonian, 0.5 * epsilon, logger);
   }
 };
 
@@ -0,0 +1,45 @@
+#ifndef STAN_MCMC_HMC_INTEGRATORS_EXPL_MIXED_LEAPFROG_HPP
+#define STAN_MCMC_HMC_INTEGRATORS_EXPL_MIXED_LEAPFROG_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/integrators/base_leapfrog.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Explicit leapfrog for diag_e_mixed_metric.  The momentum updates
+ * read the gradient in place, and the position update takes the
+ * single precision velocity of the Hamiltonian, so a step streams the
+ * inverse metric at half width and creates no temporaries.  Positions
+ * drift from those of expl_leapfrog by single precision rounding of
+ * the velocity, so it is only suited to models that tolerate it.
+ */
+template <class Hamiltonian>
+class expl_mixed_leapfrog : public base_leapfrog<Hamiltonian> {
+ public:
+  expl_mixed_leapfrog() : base_leapfrog<Hamiltonian>() {}
+
+  void begin_update_p(typename Hamiltonian::PointType& z,
+                      Hamiltonian& hamiltonian, double epsilon,
+                      callbacks::logger& logger) {
+    z.p -= epsilon * z.g;
+  }
+
+  void update_q(typename Hamiltonian::PointType& z, Hamiltonian& hamiltonian,
+                double epsilon, callbacks::logger& logger) {
+    hamiltonian.add_velocity(z, epsilon);
+    hamiltonian.update_potential_gradient(z, logger);
+  }
+
+  void end_update_p(typename Hamiltonian::PointType& z,
+                    Hamiltonian& hamiltonian, double epsilon,
+                    callbacks::logger& logger) {
+    z.p -= epsilon * z.g;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
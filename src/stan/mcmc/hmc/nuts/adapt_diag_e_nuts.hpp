@@ -26,6 +26,7 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
     sample s = diag_e_nuts<Model, BaseRNG>::transition(init_sample, logger);
 
     if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
 
@@ -38,6 +39,7 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
         this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
         this->stepsize_adaptation_.restart();
       }
+      this->add_adaptation_time(adapt_start);
     }
     return s;
   }
@@ -46,6 +48,12 @@ class adapt_diag_e_nuts : public diag_e_nuts<Model, BaseRNG>,
     base_adapter::disengage_adaptation();
     this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
   }
+
+ protected:
+  std::size_t advise_huge_pages() {
+    return diag_e_nuts<Model, BaseRNG>::advise_huge_pages()
+           + this->var_adaptation_.advise_huge_pages();
+  }
 };
 
 }  // namespace mcmc
@@ -0,0 +1,46 @@
+#ifndef STAN_MCMC_HMC_NUTS_ADAPT_LOWRANK_SOFTABS_NUTS_HPP
+#define STAN_MCMC_HMC_NUTS_ADAPT_LOWRANK_SOFTABS_NUTS_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/nuts/lowrank_softabs_nuts.hpp>
+#include <stan/mcmc/stepsize_adapter.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling
+ * with a Gaussian-Riemannian disintegration and SoftAbs metric
+ * of a low-rank approximation of the Hessian and adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_lowrank_softabs_nuts : public lowrank_softabs_nuts<Model, BaseRNG>,
+                                   public stepsize_adapter {
+ public:
+  adapt_lowrank_softabs_nuts(const Model& model, BaseRNG& rng)
+      : lowrank_softabs_nuts<Model, BaseRNG>(model, rng) {}
+
+  ~adapt_lowrank_softabs_nuts() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s
+        = lowrank_softabs_nuts<Model, BaseRNG>::transition(init_sample, logger);
+
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+      this->add_adaptation_time(adapt_start);
+    }
+
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -24,9 +24,12 @@ class adapt_softabs_nuts : public softabs_nuts<Model, BaseRNG>,
   sample transition(sample& init_sample, callbacks::logger& logger) {
     sample s = softabs_nuts<Model, BaseRNG>::transition(init_sample, logger);
 
-    if (this->adapt_flag_)
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
+      this->add_adaptation_time(adapt_start);
+    }
 
     return s;
   }
@@ -0,0 +1,66 @@
+#ifndef STAN_MCMC_HMC_NUTS_ADAPT_SPARSE_E_NUTS_HPP
+#define STAN_MCMC_HMC_NUTS_ADAPT_SPARSE_E_NUTS_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/stepsize_sparse_adapter.hpp>
+#include <stan/mcmc/hmc/nuts/sparse_e_nuts.hpp>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling
+ * with a Gaussian-Euclidean disintegration and adaptive
+ * sparse metric and adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_sparse_e_nuts : public sparse_e_nuts<Model, BaseRNG>,
+                            public stepsize_sparse_adapter {
+ public:
+  /**
+   * @param model model to sample from
+   * @param rng random number generator
+   * @param pattern rows of the nonzeros of each column of the adapted
+   * mass matrix, zero-based
+   * @throw std::invalid_argument if the pattern does not match the
+   * number of parameters
+   */
+  adapt_sparse_e_nuts(const Model& model, BaseRNG& rng,
+                      const std::vector<std::vector<int>>& pattern)
+      : sparse_e_nuts<Model, BaseRNG>(model, rng),
+        stepsize_sparse_adapter(model.num_params_r(), pattern) {}
+
+  ~adapt_sparse_e_nuts() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s = sparse_e_nuts<Model, BaseRNG>::transition(init_sample, logger);
+
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+
+      bool update = this->sparse_adaptation_.learn_metric(this->z_.e_metric_,
+                                                          this->z_.q);
+
+      if (update) {
+        this->z_.update_factors();
+        this->init_stepsize(logger);
+
+        this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
+        this->stepsize_adaptation_.restart();
+      }
+      this->add_adaptation_time(adapt_start);
+    }
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -4,11 +4,21 @@
 #include <stan/callbacks/logger.hpp>
 #include <stan/math/prim.hpp>
 #include <stan/mcmc/hmc/base_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_softabs_point.hpp>
 #include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/softabs_point.hpp>
+#include <stan/mcmc/hmc/nuts/nuts_speculated_steps.hpp>
+#include <stan/mcmc/hmc/nuts/nuts_tree_scratch.hpp>
+#include <stan/mcmc/trace_events.hpp>
+#include <tbb/task_group.h>
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <exception>
 #include <limits>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace stan {
@@ -27,7 +37,26 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         max_deltaH_(1000),
         n_leapfrog_(0),
         divergent_(false),
-        energy_(0) {}
+        energy_(0),
+        z_fwd_(this->z_.q.size()),
+        z_bck_(this->z_.q.size()),
+        z_sample_(this->z_.q.size()),
+        z_propose_(this->z_.q.size()),
+        p_fwd_fwd_(this->z_.q.size()),
+        p_sharp_fwd_fwd_(this->z_.q.size()),
+        p_fwd_bck_(this->z_.q.size()),
+        p_sharp_fwd_bck_(this->z_.q.size()),
+        p_bck_fwd_(this->z_.q.size()),
+        p_sharp_bck_fwd_(this->z_.q.size()),
+        p_bck_bck_(this->z_.q.size()),
+        p_sharp_bck_bck_(this->z_.q.size()),
+        rho_(this->z_.q.size()),
+        rho_fwd_(this->z_.q.size()),
+        rho_bck_(this->z_.q.size()),
+        rho_extended_(this->z_.q.size()),
+        tree_scratch_(this->z_.q.size()) {
+    tree_scratch_.reserve(max_depth_);
+  }
 
   /**
    * specialized constructor for specified diag mass matrix
@@ -40,7 +69,26 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         max_deltaH_(1000),
         n_leapfrog_(0),
         divergent_(false),
-        energy_(0) {}
+        energy_(0),
+        z_fwd_(this->z_.q.size()),
+        z_bck_(this->z_.q.size()),
+        z_sample_(this->z_.q.size()),
+        z_propose_(this->z_.q.size()),
+        p_fwd_fwd_(this->z_.q.size()),
+        p_sharp_fwd_fwd_(this->z_.q.size()),
+        p_fwd_bck_(this->z_.q.size()),
+        p_sharp_fwd_bck_(this->z_.q.size()),
+        p_bck_fwd_(this->z_.q.size()),
+        p_sharp_bck_fwd_(this->z_.q.size()),
+        p_bck_bck_(this->z_.q.size()),
+        p_sharp_bck_bck_(this->z_.q.size()),
+        rho_(this->z_.q.size()),
+        rho_fwd_(this->z_.q.size()),
+        rho_bck_(this->z_.q.size()),
+        rho_extended_(this->z_.q.size()),
+        tree_scratch_(this->z_.q.size()) {
+    tree_scratch_.reserve(max_depth_);
+  }
 
   /**
    * specialized constructor for specified dense mass matrix
@@ -53,7 +101,26 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         max_deltaH_(1000),
         n_leapfrog_(0),
         divergent_(false),
-        energy_(0) {}
+        energy_(0),
+        z_fwd_(this->z_.q.size()),
+        z_bck_(this->z_.q.size()),
+        z_sample_(this->z_.q.size()),
+        z_propose_(this->z_.q.size()),
+        p_fwd_fwd_(this->z_.q.size()),
+        p_sharp_fwd_fwd_(this->z_.q.size()),
+        p_fwd_bck_(this->z_.q.size()),
+        p_sharp_fwd_bck_(this->z_.q.size()),
+        p_bck_fwd_(this->z_.q.size()),
+        p_sharp_bck_fwd_(this->z_.q.size()),
+        p_bck_bck_(this->z_.q.size()),
+        p_sharp_bck_bck_(this->z_.q.size()),
+        rho_(this->z_.q.size()),
+        rho_fwd_(this->z_.q.size()),
+        rho_bck_(this->z_.q.size()),
+        rho_extended_(this->z_.q.size()),
+        tree_scratch_(this->z_.q.size()) {
+    tree_scratch_.reserve(max_depth_);
+  }
 
   ~base_nuts() {}
 
@@ -61,13 +128,20 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     this->z_.set_metric(inv_e_metric);
   }
 
+  void set_metric(const Eigen::MatrixXd& inv_e_metric,
+                  const Eigen::LLT<Eigen::MatrixXd>& inv_e_metric_llt) {
+    this->z_.set_metric(inv_e_metric, inv_e_metric_llt);
+  }
+
   void set_metric(const Eigen::VectorXd& inv_e_metric) {
     this->z_.set_metric(inv_e_metric);
   }
 
   void set_max_depth(int d) {
-    if (d > 0)
+    if (d > 0) {
       max_depth_ = d;
+      tree_scratch_.reserve(max_depth_);
+    }
   }
 
   void set_max_delta(double d) { max_deltaH_ = d; }
@@ -75,7 +149,52 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
   int get_max_depth() { return this->max_depth_; }
   double get_max_delta() { return this->max_deltaH_; }
 
+  /**
+   * Enable or disable speculative expansion of the trajectory.  When
+   * enabled, each doubling also integrates, on a second TBB worker, the
+   * leapfrog steps the next doubling would take in the other direction,
+   * from the other end of the trajectory, which does not move during
+   * the doubling.  If a later doubling goes in that direction its steps
+   * are taken from the speculated ones, with their messages and
+   * errors, instead of being integrated again.
+   *
+   * <p>Directions and multinomial samples are still drawn on the
+   * calling thread and the leapfrog steps are deterministic, so the
+   * draws are exactly those of the sequential sampler, while the
+   * latency of a transition drops by up to a half when the doublings
+   * alternate direction.  The speculated steps which are not used are
+   * wasted gradient evaluations, counted with the others.  Evaluating
+   * the model on two threads requires building with `STAN_THREADS`.
+   *
+   * <p>The speculation integrates with its own copies of the
+   * Hamiltonian, integrator and point, made here from those of the
+   * chain and refreshed in place at each transition, so speculating
+   * allocates nothing per transition.  Settings of the Hamiltonian
+   * changed afterwards take effect on the speculated steps when
+   * speculation is enabled again.
+   *
+   * <p>Points whose metric depends on the position, those of the
+   * SoftAbs metrics, are not speculated and the setting is ignored.
+   *
+   * @param speculative `true` to expand speculatively
+   */
+  virtual void set_speculative(bool speculative) {
+    speculative_ = speculative && can_speculate_;
+    if (speculative_) {
+      spec_hamiltonian_.emplace(this->hamiltonian_);
+      spec_integrator_.emplace(this->integrator_);
+      spec_point_.emplace(this->z_);
+    } else {
+      spec_hamiltonian_.reset();
+      spec_integrator_.reset();
+      spec_point_.reset();
+    }
+  }
+
+  bool get_speculative() const { return speculative_; }
+
   sample transition(sample& init_sample, callbacks::logger& logger) {
+    STAN_TRACE_SCOPE("nuts_transition");
     // Initialize the algorithm
     this->sample_stepsize();
 
@@ -84,30 +203,56 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     this->hamiltonian_.sample_p(this->z_, this->rand_int_);
     this->hamiltonian_.init(this->z_, logger);
 
-    ps_point z_fwd(this->z_);  // State at forward end of trajectory
-    ps_point z_bck(z_fwd);     // State at backward end of trajectory
+    if (speculative_) {
+      spec_fwd_.clear();
+      spec_bck_.clear();
+      // Takes the metric of the chain, which adaptation may have changed
+      *spec_point_ = this->z_;
+    }
+
+    // All trajectory state lives in preallocated members so that a
+    // transition performs no heap allocation of its own
+    ps_point& z_fwd = z_fwd_;  // State at forward end of trajectory
+    ps_point& z_bck = z_bck_;  // State at backward end of trajectory
+    ps_point& z_sample = z_sample_;
+    ps_point& z_propose = z_propose_;
 
-    ps_point z_sample(z_fwd);
-    ps_point z_propose(z_fwd);
+    z_fwd = this->z_;
+    z_bck = z_fwd;
+    z_sample = z_fwd;
+    z_propose = z_fwd;
 
     // Momentum and sharp momentum at forward end of forward subtree
-    Eigen::VectorXd p_fwd_fwd = this->z_.p;
-    Eigen::VectorXd p_sharp_fwd_fwd = this->hamiltonian_.dtau_dp(this->z_);
+    Eigen::VectorXd& p_fwd_fwd = p_fwd_fwd_;
+    Eigen::VectorXd& p_sharp_fwd_fwd = p_sharp_fwd_fwd_;
+    p_fwd_fwd = this->z_.p;
+    p_sharp_fwd_fwd = this->hamiltonian_.dtau_dp(this->z_);
 
     // Momentum and sharp momentum at backward end of forward subtree
-    Eigen::VectorXd p_fwd_bck = this->z_.p;
-    Eigen::VectorXd p_sharp_fwd_bck = p_sharp_fwd_fwd;
+    Eigen::VectorXd& p_fwd_bck = p_fwd_bck_;
+    Eigen::VectorXd& p_sharp_fwd_bck = p_sharp_fwd_bck_;
+    p_fwd_bck = this->z_.p;
+    p_sharp_fwd_bck = p_sharp_fwd_fwd;
 
     // Momentum and sharp momentum at forward end of backward subtree
-    Eigen::VectorXd p_bck_fwd = this->z_.p;
-    Eigen::VectorXd p_sharp_bck_fwd = p_sharp_fwd_fwd;
+    Eigen::VectorXd& p_bck_fwd = p_bck_fwd_;
+    Eigen::VectorXd& p_sharp_bck_fwd = p_sharp_bck_fwd_;
+    p_bck_fwd = this->z_.p;
+    p_sharp_bck_fwd = p_sharp_fwd_fwd;
 
     // Momentum and sharp momentum at backward end of backward subtree
-    Eigen::VectorXd p_bck_bck = this->z_.p;
-    Eigen::VectorXd p_sharp_bck_bck = p_sharp_fwd_fwd;
+    Eigen::VectorXd& p_bck_bck = p_bck_bck_;
+    Eigen::VectorXd& p_sharp_bck_bck = p_sharp_bck_bck_;
+    p_bck_bck = this->z_.p;
+    p_sharp_bck_bck = p_sharp_fwd_fwd;
 
     // Integrated momenta along trajectory
-    Eigen::VectorXd rho = this->z_.p.transpose();
+    Eigen::VectorXd& rho = rho_;
+    rho = this->z_.p;
+
+    Eigen::VectorXd& rho_fwd = rho_fwd_;
+    Eigen::VectorXd& rho_bck = rho_bck_;
+    Eigen::VectorXd& rho_extended = rho_extended_;
 
     // Log sum of state weights (offset by H0) along trajectory
     double log_sum_weight = 0;  // log(exp(H0 - H0))
@@ -121,14 +266,31 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     this->divergent_ = false;
 
     while (this->depth_ < this->max_depth_) {
+      STAN_TRACE_SCOPE("tree_doubling");
       // Build a new subtree in a random direction
-      Eigen::VectorXd rho_fwd = Eigen::VectorXd::Zero(rho.size());
-      Eigen::VectorXd rho_bck = Eigen::VectorXd::Zero(rho.size());
+      rho_fwd.setZero();
+      rho_bck.setZero();
 
       bool valid_subtree = false;
       double log_sum_weight_subtree = -std::numeric_limits<double>::infinity();
 
-      if (this->rand_uniform_() > 0.5) {
+      const bool forward = this->rand_uniform_() > 0.5;
+
+      // Speculate the steps of the next doubling in the other direction,
+      // whose end the subtree below does not move.  If building the
+      // subtree throws, the task group waits for it when destroyed.
+      tbb::task_group speculation;
+      const bool speculating
+          = speculative_ && this->depth_ + 1 < this->max_depth_;
+      if (speculating) {
+        const std::size_t num_steps = std::size_t(1) << (this->depth_ + 1);
+        speculation.run([&, forward, num_steps]() {
+          speculate_(forward ? spec_bck_ : spec_fwd_, forward ? z_bck : z_fwd,
+                     forward ? -1 : 1, num_steps, H0);
+        });
+      }
+
+      if (forward) {
         // Extend the current trajectory forward
         this->z_.ps_point::operator=(z_fwd);
         rho_bck = rho;
@@ -154,6 +316,13 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         z_bck.ps_point::operator=(this->z_);
       }
 
+      if (speculating) {
+        speculation.wait();
+        this->hamiltonian_.add_gradient_counters(spec_gradients_, 0,
+                                                 spec_gradient_time_);
+        this->integrator_.add_steps(spec_steps_);
+      }
+
       if (!valid_subtree)
         break;
 
@@ -179,7 +348,7 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
           = compute_criterion(p_sharp_bck_bck, p_sharp_fwd_fwd, rho);
 
       // Demand satisfaction between subtrees
-      Eigen::VectorXd rho_extended = rho_bck + p_fwd_bck;
+      rho_extended = rho_bck + p_fwd_bck;
 
       persist_criterion
           &= compute_criterion(p_sharp_bck_bck, p_sharp_fwd_bck, rho_extended);
@@ -199,8 +368,9 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     double accept_prob = sum_metro_prob / static_cast<double>(n_leapfrog);
 
     this->z_.ps_point::operator=(z_sample);
+    this->hamiltonian_.cache_gradient(this->z_);
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->z_.V, accept_prob);
+    return this->current_sample(-this->z_.V, accept_prob);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
@@ -219,6 +389,12 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     values.push_back(this->energy_);
   }
 
+  void record_instrumentation(sampler_instrumentation& stats) {
+    base_hmc<Model, Hamiltonian, Integrator, BaseRNG>::record_instrumentation(
+        stats);
+    stats.add_tree_depth(this->depth_);
+  }
+
   virtual bool compute_criterion(Eigen::VectorXd& p_sharp_minus,
                                  Eigen::VectorXd& p_sharp_plus,
                                  Eigen::VectorXd& rho) {
@@ -244,18 +420,21 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
    * @param sum_metro_prob Summed Metropolis probabilities across trajectory
    * @param logger Logger for messages
    */
-  bool build_tree(int depth, ps_point& z_propose, Eigen::VectorXd& p_sharp_beg,
-                  Eigen::VectorXd& p_sharp_end, Eigen::VectorXd& rho,
-                  Eigen::VectorXd& p_beg, Eigen::VectorXd& p_end, double H0,
-                  double sign, int& n_leapfrog, double& log_sum_weight,
-                  double& sum_metro_prob, callbacks::logger& logger) {
+  virtual bool build_tree(int depth, ps_point& z_propose,
+                          Eigen::VectorXd& p_sharp_beg,
+                          Eigen::VectorXd& p_sharp_end, Eigen::VectorXd& rho,
+                          Eigen::VectorXd& p_beg, Eigen::VectorXd& p_end,
+                          double H0, double sign, int& n_leapfrog,
+                          double& log_sum_weight, double& sum_metro_prob,
+                          callbacks::logger& logger) {
     // Base case
     if (depth == 0) {
-      this->integrator_.evolve(this->z_, this->hamiltonian_,
-                               sign * this->epsilon_, logger);
+      if (!take_speculated_step_(sign, logger))
+        this->integrator_.evolve(this->z_, this->hamiltonian_,
+                                 sign * this->epsilon_, logger);
       ++n_leapfrog;
 
-      double h = this->hamiltonian_.H(this->z_);
+      double h = this->hamiltonian_.H_and_dtau_dp(this->z_, p_sharp_beg);
       if (std::isnan(h))
         h = std::numeric_limits<double>::infinity();
 
@@ -271,7 +450,6 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
 
       z_propose = this->z_;
 
-      p_sharp_beg = this->hamiltonian_.dtau_dp(this->z_);
       p_sharp_end = p_sharp_beg;
 
       rho += this->z_.p;
@@ -281,15 +459,18 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
       return !this->divergent_;
     }
     // General recursion
+    this->tree_scratch_.reserve(depth);
+    nuts_subtree_buffers& scratch = this->tree_scratch_[depth];
 
     // Build the initial subtree
     double log_sum_weight_init = -std::numeric_limits<double>::infinity();
 
     // Momentum and sharp momentum at end of the initial subtree
-    Eigen::VectorXd p_init_end(this->z_.p.size());
-    Eigen::VectorXd p_sharp_init_end(this->z_.p.size());
+    Eigen::VectorXd& p_init_end = scratch.p_init_end;
+    Eigen::VectorXd& p_sharp_init_end = scratch.p_sharp_init_end;
 
-    Eigen::VectorXd rho_init = Eigen::VectorXd::Zero(rho.size());
+    Eigen::VectorXd& rho_init = scratch.rho_init;
+    rho_init.setZero();
 
     bool valid_init
         = build_tree(depth - 1, z_propose, p_sharp_beg, p_sharp_init_end,
@@ -300,15 +481,16 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
       return false;
 
     // Build the final subtree
-    ps_point z_propose_final(this->z_);
+    ps_point& z_propose_final = scratch.z_propose_final;
 
     double log_sum_weight_final = -std::numeric_limits<double>::infinity();
 
     // Momentum and sharp momentum at beginning of the final subtree
-    Eigen::VectorXd p_final_beg(this->z_.p.size());
-    Eigen::VectorXd p_sharp_final_beg(this->z_.p.size());
+    Eigen::VectorXd& p_final_beg = scratch.p_final_beg;
+    Eigen::VectorXd& p_sharp_final_beg = scratch.p_sharp_final_beg;
 
-    Eigen::VectorXd rho_final = Eigen::VectorXd::Zero(rho.size());
+    Eigen::VectorXd& rho_final = scratch.rho_final;
+    rho_final.setZero();
 
     bool valid_final
         = build_tree(depth - 1, z_propose_final, p_sharp_final_beg, p_sharp_end,
@@ -332,7 +514,8 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         z_propose = z_propose_final;
     }
 
-    Eigen::VectorXd rho_subtree = rho_init + rho_final;
+    Eigen::VectorXd& rho_subtree = scratch.rho_subtree;
+    rho_subtree = rho_init + rho_final;
     rho += rho_subtree;
 
     // Demand satisfaction around merged subtrees
@@ -358,6 +541,147 @@ class base_nuts : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
   int n_leapfrog_;
   bool divergent_;
   double energy_;
+
+ protected:
+  std::size_t advise_huge_pages() {
+    using base_t = base_hmc<Model, Hamiltonian, Integrator, BaseRNG>;
+    std::size_t bytes = base_t::advise_huge_pages();
+    for (ps_point* z : {&z_fwd_, &z_bck_, &z_sample_, &z_propose_})
+      bytes += z->advise_huge_pages();
+    for (Eigen::VectorXd* v :
+         {&p_fwd_fwd_, &p_sharp_fwd_fwd_, &p_fwd_bck_, &p_sharp_fwd_bck_,
+          &p_bck_fwd_, &p_sharp_bck_fwd_, &p_bck_bck_, &p_sharp_bck_bck_,
+          &rho_, &rho_fwd_, &rho_bck_, &rho_extended_})
+      bytes += stan::mcmc::advise_huge_pages(*v);
+    tree_scratch_.enable_huge_pages();
+    return bytes;
+  }
+
+  // The scratch of deeper trees is advised as it is reserved
+  std::size_t huge_page_bytes() const {
+    return base_hmc<Model, Hamiltonian, Integrator, BaseRNG>::huge_page_bytes()
+           + tree_scratch_.huge_page_bytes();
+  }
+
+  // Trajectory endpoints, multinomial sample and proposal
+  ps_point z_fwd_;
+  ps_point z_bck_;
+  ps_point z_sample_;
+  ps_point z_propose_;
+
+  // Momenta and sharp momenta at the ends of the forward and backward
+  // subtrees
+  Eigen::VectorXd p_fwd_fwd_;
+  Eigen::VectorXd p_sharp_fwd_fwd_;
+  Eigen::VectorXd p_fwd_bck_;
+  Eigen::VectorXd p_sharp_fwd_bck_;
+  Eigen::VectorXd p_bck_fwd_;
+  Eigen::VectorXd p_sharp_bck_fwd_;
+  Eigen::VectorXd p_bck_bck_;
+  Eigen::VectorXd p_sharp_bck_bck_;
+
+  // Integrated momenta along the trajectory and its subtrees
+  Eigen::VectorXd rho_;
+  Eigen::VectorXd rho_fwd_;
+  Eigen::VectorXd rho_bck_;
+  Eigen::VectorXd rho_extended_;
+
+  // Per-depth buffers used by build_tree
+  nuts_tree_scratch tree_scratch_;
+
+  using point_t = typename Hamiltonian<Model, BaseRNG>::PointType;
+
+  // Points whose metric depends on the position carry state which the
+  // speculated steps do not keep
+  static constexpr bool can_speculate_
+      = !std::is_base_of<softabs_point, point_t>::value
+        && !std::is_base_of<lowrank_softabs_point, point_t>::value;
+
+  bool speculative_{false};
+
+  // Steps speculated ahead of the forward and backward ends
+  nuts_speculated_steps spec_fwd_;
+  nuts_speculated_steps spec_bck_;
+
+  // Hamiltonian, integrator and point the speculation integrates with,
+  // held while speculation is enabled
+  std::optional<Hamiltonian<Model, BaseRNG>> spec_hamiltonian_;
+  std::optional<Integrator<Hamiltonian<Model, BaseRNG>>> spec_integrator_;
+  std::optional<point_t> spec_point_;
+
+  /**
+   * Speculate leapfrog steps ahead of an end of the trajectory until
+   * the specified number of them is pending or a step diverges or
+   * fails, with the Hamiltonian and integrator of the speculation,
+   * whose gradient counters and steps are then added to those of the
+   * sampler.
+   *
+   * @param spec steps speculated ahead of the end
+   * @param z_end end of the trajectory
+   * @param sign direction of the steps
+   * @param num_steps number of pending steps to reach
+   * @param H0 Hamiltonian of the initial state
+   */
+  void speculate_(nuts_speculated_steps& spec, const ps_point& z_end,
+                  double sign, std::size_t num_steps, double H0) {
+    Hamiltonian<Model, BaseRNG>& hamiltonian = *spec_hamiltonian_;
+    Integrator<Hamiltonian<Model, BaseRNG>>& integrator = *spec_integrator_;
+    point_t& z = *spec_point_;
+    if (spec.num_pending() == 0) {
+      spec.clear();
+      z.ps_point::operator=(z_end);
+    } else {
+      z.ps_point::operator=(spec.points[spec.size - 1]);
+    }
+    hamiltonian.reset_gradient_counters();
+    const long start_steps = integrator.num_steps();
+    while (spec.num_pending() < num_steps && !spec.stopped) {
+      callbacks::buffered_logger logger;
+      std::exception_ptr error;
+      try {
+        integrator.evolve(z, hamiltonian, sign * this->epsilon_, logger);
+        double h = hamiltonian.H(z);
+        spec.stopped = std::isnan(h) || (h - H0) > this->max_deltaH_;
+      } catch (...) {
+        error = std::current_exception();
+        spec.stopped = true;
+      }
+      std::size_t k = spec.push(z);
+      spec.loggers[k] = std::move(logger);
+      spec.errors[k] = error;
+    }
+    spec_gradients_ = hamiltonian.num_gradient_evaluations();
+    spec_gradient_time_ = hamiltonian.gradient_time();
+    spec_steps_ = integrator.num_steps() - start_steps;
+  }
+
+  // Counters of the last speculation, added to the sampler's after it
+  long spec_gradients_{0};
+  double spec_gradient_time_{0};
+  long spec_steps_{0};
+
+  /**
+   * Take the next leapfrog step in the specified direction from the
+   * speculated ones if there is one, replaying its messages and
+   * raising its error.
+   *
+   * @param sign direction of the step
+   * @param logger logger for messages
+   * @return `true` if the step was taken
+   */
+  bool take_speculated_step_(double sign, callbacks::logger& logger) {
+    if (!speculative_)
+      return false;
+    nuts_speculated_steps& spec = sign > 0 ? spec_fwd_ : spec_bck_;
+    if (spec.num_pending() == 0)
+      return false;
+    std::size_t k = spec.next++;
+    spec.loggers[k].replay(logger);
+    if (spec.errors[k])
+      std::rethrow_exception(spec.errors[k]);
+    this->z_.ps_point::operator=(spec.points[k]);
+    return true;
+  }
 };
 
 }  // namespace mcmc
@@ -0,0 +1,58 @@
+#ifndef STAN_MCMC_HMC_NUTS_LOWRANK_E_NUTS_HPP
+#define STAN_MCMC_HMC_NUTS_LOWRANK_E_NUTS_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling
+ * with a Gaussian-Euclidean disintegration and diagonal plus
+ * low-rank metric
+ */
+template <class Model, class BaseRNG>
+class lowrank_e_nuts
+    : public base_nuts<Model, lowrank_e_metric, expl_leapfrog, BaseRNG> {
+ public:
+  lowrank_e_nuts(const Model& model, BaseRNG& rng)
+      : base_nuts<Model, lowrank_e_metric, expl_leapfrog, BaseRNG>(model,
+                                                                   rng) {}
+
+  /**
+   * Set the inverse metric to diag(inv_e_metric) + lowrank * lowrank^T.
+   *
+   * @param inv_e_metric diagonal elements of the inverse metric
+   * @param lowrank low-rank factor, one column per direction
+   */
+  void set_metric(const Eigen::VectorXd& inv_e_metric,
+                  const Eigen::MatrixXd& lowrank) {
+    this->z_.set_metric(inv_e_metric, lowrank);
+  }
+
+  void set_metric(const Eigen::VectorXd& inv_e_metric) {
+    this->z_.set_metric(inv_e_metric);
+  }
+
+  /**
+   * Write stepsize and the diagonal and low-rank parts of the inverse
+   * metric.
+   *
+   * @param struct_writer writer for the sampler state
+   */
+  void write_sampler_state_struct(callbacks::structured_writer& struct_writer) {
+    struct_writer.begin_record();
+    struct_writer.write("stepsize", this->get_nominal_stepsize());
+    struct_writer.write("metric_type", this->z_.metric_type());
+    struct_writer.write("inv_metric", this->z_.inv_e_metric_);
+    struct_writer.write("inv_metric_lowrank", this->z_.inv_e_metric_lowrank_);
+    struct_writer.end_record();
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,66 @@
+#ifndef STAN_MCMC_HMC_NUTS_NUTS_SPECULATED_STEPS_HPP
+#define STAN_MCMC_HMC_NUTS_NUTS_SPECULATED_STEPS_HPP
+
+#include <stan/callbacks/buffered_logger.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Leapfrog steps integrated ahead of one end of a NUTS trajectory by
+ * speculative expansion, with the messages logged and the error raised
+ * by each, consumed in order when the trajectory is extended in that
+ * direction.  The storage of the steps is kept across transitions.
+ */
+struct nuts_speculated_steps {
+  /**
+   * Discard the steps.
+   */
+  void clear() {
+    size = 0;
+    next = 0;
+    stopped = false;
+  }
+
+  /**
+   * Return the number of steps not yet consumed.
+   */
+  std::size_t num_pending() const { return size - next; }
+
+  /**
+   * Append a step and return its index, its logger and error cleared.
+   *
+   * @param z point after the step
+   */
+  std::size_t push(const ps_point& z) {
+    if (size == points.size()) {
+      points.push_back(z);
+      loggers.emplace_back();
+      errors.emplace_back();
+    } else {
+      points[size] = z;
+      loggers[size] = callbacks::buffered_logger();
+      errors[size] = nullptr;
+    }
+    return size++;
+  }
+
+  std::vector<ps_point> points;
+  std::vector<callbacks::buffered_logger> loggers;
+  std::vector<std::exception_ptr> errors;
+
+  // Number of steps held and index of the next one to consume
+  std::size_t size{0};
+  std::size_t next{0};
+
+  // Whether the last step diverged or failed, ending the speculation
+  bool stopped{false};
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,150 @@
+#ifndef STAN_MCMC_HMC_NUTS_NUTS_TREE_SCRATCH_HPP
+#define STAN_MCMC_HMC_NUTS_NUTS_TREE_SCRATCH_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/mcmc/huge_pages.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Working storage used by one level of the recursive NUTS tree
+ * builder: the proposal drawn from the final subtree together with the
+ * momenta and summed momenta at the junction of the two subtrees.
+ */
+struct nuts_subtree_buffers {
+  /**
+   * Construct buffers for an n-dimensional phase space.
+   *
+   * @param n number of dimensions
+   */
+  explicit nuts_subtree_buffers(int n)
+      : z_propose_final(n),
+        p_init_end(n),
+        p_sharp_init_end(n),
+        rho_init(n),
+        p_final_beg(n),
+        p_sharp_final_beg(n),
+        rho_final(n),
+        rho_subtree(n) {}
+
+  /**
+   * Advise the buffers to be backed with huge pages.
+   *
+   * @return number of bytes advised
+   */
+  std::size_t advise_huge_pages() {
+    return z_propose_final.advise_huge_pages()
+           + mcmc::advise_huge_pages(p_init_end)
+           + mcmc::advise_huge_pages(p_sharp_init_end)
+           + mcmc::advise_huge_pages(rho_init)
+           + mcmc::advise_huge_pages(p_final_beg)
+           + mcmc::advise_huge_pages(p_sharp_final_beg)
+           + mcmc::advise_huge_pages(rho_final)
+           + mcmc::advise_huge_pages(rho_subtree);
+  }
+
+  ps_point z_propose_final;
+  Eigen::VectorXd p_init_end;
+  Eigen::VectorXd p_sharp_init_end;
+  Eigen::VectorXd rho_init;
+  Eigen::VectorXd p_final_beg;
+  Eigen::VectorXd p_sharp_final_beg;
+  Eigen::VectorXd rho_final;
+  Eigen::VectorXd rho_subtree;
+};
+
+/**
+ * Per-sampler arena holding one set of subtree buffers for every tree
+ * depth.  Once reserved up to the maximum depth, building a trajectory
+ * only reuses the storage and performs no heap allocation.
+ */
+class nuts_tree_scratch {
+ public:
+  /**
+   * Construct an empty arena for an n-dimensional phase space.
+   *
+   * @param n number of dimensions
+   */
+  explicit nuts_tree_scratch(int n)
+      : n_(n), huge_pages_(false), huge_page_bytes_(0) {}
+
+  /**
+   * Make sure buffers exist for every depth up to and including the
+   * specified depth.  Existing buffers are left untouched.
+   *
+   * @param depth deepest level needed
+   */
+  void reserve(int depth) {
+    if (depth < 0)
+      return;
+    if (levels_.size() <= static_cast<size_t>(depth)) {
+      levels_.reserve(depth + 1);
+      while (levels_.size() <= static_cast<size_t>(depth)) {
+        levels_.emplace_back(n_);
+        if (huge_pages_)
+          huge_page_bytes_ += levels_.back().advise_huge_pages();
+      }
+    }
+  }
+
+  /**
+   * Advise the buffers of every depth, those reserved and those
+   * reserved later, to be backed with huge pages.
+   */
+  void enable_huge_pages() {
+    huge_pages_ = true;
+    huge_page_bytes_ = 0;
+    for (nuts_subtree_buffers& level : levels_)
+      huge_page_bytes_ += level.advise_huge_pages();
+  }
+
+  /**
+   * Return the number of bytes of the buffers advised to be backed with
+   * huge pages.
+   */
+  inline std::size_t huge_page_bytes() const noexcept {
+    return huge_page_bytes_;
+  }
+
+  /**
+   * Release all buffers.
+   */
+  void clear() {
+    levels_.clear();
+    levels_.shrink_to_fit();
+    huge_page_bytes_ = 0;
+  }
+
+  /**
+   * Return the buffers for the specified depth, which must have been
+   * reserved.
+   *
+   * @param depth tree depth
+   * @return buffers for that depth
+   */
+  inline nuts_subtree_buffers& operator[](int depth) { return levels_[depth]; }
+
+  /**
+   * Return the number of levels currently reserved.
+   */
+  inline size_t size() const noexcept { return levels_.size(); }
+
+  /**
+   * Return the dimension of the phase space.
+   */
+  inline int dimension() const noexcept { return n_; }
+
+ private:
+  int n_;
+  std::vector<nuts_subtree_buffers> levels_;
+  bool huge_pages_;
+  std::size_t huge_page_bytes_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
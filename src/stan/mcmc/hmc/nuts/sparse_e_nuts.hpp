@@ -0,0 +1,57 @@
+#ifndef STAN_MCMC_HMC_NUTS_SPARSE_E_NUTS_HPP
+#define STAN_MCMC_HMC_NUTS_SPARSE_E_NUTS_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/hmc/hamiltonians/sparse_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/sparse_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling
+ * with a Gaussian-Euclidean disintegration and sparse metric
+ */
+template <class Model, class BaseRNG>
+class sparse_e_nuts
+    : public base_nuts<Model, sparse_e_metric, expl_leapfrog, BaseRNG> {
+ public:
+  sparse_e_nuts(const Model& model, BaseRNG& rng)
+      : base_nuts<Model, sparse_e_metric, expl_leapfrog, BaseRNG>(model, rng) {
+  }
+
+  /**
+   * Set the mass matrix.
+   *
+   * @param e_metric sparse symmetric positive-definite mass matrix
+   * @throw std::domain_error if the mass matrix is not positive definite
+   */
+  void set_metric(const Eigen::SparseMatrix<double>& e_metric) {
+    this->z_.set_metric(e_metric);
+  }
+
+  /**
+   * Write stepsize and the nonzero elements of the lower triangle of
+   * the mass matrix, with zero-based rows and columns.
+   *
+   * @param struct_writer writer for the sampler state
+   */
+  void write_sampler_state_struct(callbacks::structured_writer& struct_writer) {
+    std::vector<int> rows, cols;
+    std::vector<double> values;
+    this->z_.get_metric_triplets(rows, cols, values);
+    struct_writer.begin_record();
+    struct_writer.write("stepsize", this->get_nominal_stepsize());
+    struct_writer.write("metric_type", this->z_.metric_type());
+    struct_writer.write("metric_rows", rows);
+    struct_writer.write("metric_cols", cols);
+    struct_writer.write("metric_values", values);
+    struct_writer.end_record();
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
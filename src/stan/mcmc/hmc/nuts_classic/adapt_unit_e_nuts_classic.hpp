@@ -25,9 +25,12 @@ class adapt_unit_e_nuts_classic : public unit_e_nuts_classic<Model, BaseRNG>,
     sample s
         = unit_e_nuts_classic<Model, BaseRNG>::transition(init_sample, logger);
 
-    if (this->adapt_flag_)
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
+      this->add_adaptation_time(adapt_start);
+    }
 
     return s;
   }
@@ -150,8 +150,9 @@ class base_nuts_classic
     double accept_prob = util.sum_prob / static_cast<double>(util.n_tree);
 
     this->z_.ps_point::operator=(z_sample);
+    this->hamiltonian_.cache_gradient(this->z_);
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->z_.V, accept_prob);
+    return this->current_sample(-this->z_.V, accept_prob);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
@@ -170,6 +171,12 @@ class base_nuts_classic
     values.push_back(this->energy_);
   }
 
+  void record_instrumentation(sampler_instrumentation& stats) {
+    base_hmc<Model, Hamiltonian, Integrator, BaseRNG>::record_instrumentation(
+        stats);
+    stats.add_tree_depth(this->depth_);
+  }
+
   virtual bool compute_criterion(
       ps_point& start, typename Hamiltonian<Model, BaseRNG>::PointType& finish,
       Eigen::VectorXd& rho)
@@ -0,0 +1,59 @@
+#ifndef STAN_MCMC_HMC_NUTS_ITERATIVE_ADAPT_DENSE_E_NUTS_ITERATIVE_HPP
+#define STAN_MCMC_HMC_NUTS_ITERATIVE_ADAPT_DENSE_E_NUTS_ITERATIVE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/stepsize_covar_adapter.hpp>
+#include <stan/mcmc/hmc/nuts_iterative/dense_e_nuts_iterative.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling and an
+ * iterative trajectory builder
+ * with a Gaussian-Euclidean disintegration and adaptive
+ * dense metric and adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_dense_e_nuts_iterative
+    : public dense_e_nuts_iterative<Model, BaseRNG>,
+      public stepsize_covar_adapter {
+ public:
+  adapt_dense_e_nuts_iterative(const Model& model, BaseRNG& rng)
+      : dense_e_nuts_iterative<Model, BaseRNG>(model, rng),
+        stepsize_covar_adapter(model.num_params_r()) {}
+
+  ~adapt_dense_e_nuts_iterative() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s = dense_e_nuts_iterative<Model, BaseRNG>::transition(
+        init_sample, logger);
+
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+
+      bool update = this->covar_adaptation_.learn_covariance(
+          this->z_.inv_e_metric_, this->z_.q);
+
+      if (update) {
+        this->z_.notify_metric_changed();
+        this->init_stepsize(logger);
+
+        this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
+        this->stepsize_adaptation_.restart();
+      }
+      this->add_adaptation_time(adapt_start);
+    }
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
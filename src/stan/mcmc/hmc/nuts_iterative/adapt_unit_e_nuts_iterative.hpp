@@ -0,0 +1,48 @@
+#ifndef STAN_MCMC_HMC_NUTS_ITERATIVE_ADAPT_UNIT_E_NUTS_ITERATIVE_HPP
+#define STAN_MCMC_HMC_NUTS_ITERATIVE_ADAPT_UNIT_E_NUTS_ITERATIVE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/nuts_iterative/unit_e_nuts_iterative.hpp>
+#include <stan/mcmc/stepsize_adapter.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling and an
+ * iterative trajectory builder
+ * with a Gaussian-Euclidean disintegration and unit metric
+ * and adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_unit_e_nuts_iterative
+    : public unit_e_nuts_iterative<Model, BaseRNG>,
+      public stepsize_adapter {
+ public:
+  adapt_unit_e_nuts_iterative(const Model& model, BaseRNG& rng)
+      : unit_e_nuts_iterative<Model, BaseRNG>(model, rng) {}
+
+  ~adapt_unit_e_nuts_iterative() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s = unit_e_nuts_iterative<Model, BaseRNG>::transition(
+        init_sample, logger);
+
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+      this->add_adaptation_time(adapt_start);
+    }
+
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
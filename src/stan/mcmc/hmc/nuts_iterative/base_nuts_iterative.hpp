@@ -0,0 +1,361 @@
+#ifndef STAN_MCMC_HMC_NUTS_ITERATIVE_BASE_NUTS_ITERATIVE_HPP
+#define STAN_MCMC_HMC_NUTS_ITERATIVE_BASE_NUTS_ITERATIVE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Summary of a completed subtree of a NUTS trajectory: everything the
+ * merge with its sibling needs, i.e. its multinomial proposal, the
+ * momenta and sharp momenta at both ends, its summed momentum and its
+ * log summed weight.
+ */
+struct nuts_checkpoint {
+  /**
+   * Construct a checkpoint for an n-dimensional phase space.
+   *
+   * @param n number of dimensions
+   */
+  explicit nuts_checkpoint(int n)
+      : z_propose(n),
+        p_sharp_beg(n),
+        p_sharp_end(n),
+        p_beg(n),
+        p_end(n),
+        rho(n),
+        log_sum_weight(-std::numeric_limits<double>::infinity()) {}
+
+  /**
+   * Exchange the contents of two checkpoints without copying or
+   * allocating.
+   *
+   * @param other checkpoint to swap with
+   */
+  void swap(nuts_checkpoint& other) {
+    z_propose.q.swap(other.z_propose.q);
+    z_propose.p.swap(other.z_propose.p);
+    z_propose.g.swap(other.z_propose.g);
+    std::swap(z_propose.V, other.z_propose.V);
+    p_sharp_beg.swap(other.p_sharp_beg);
+    p_sharp_end.swap(other.p_sharp_end);
+    p_beg.swap(other.p_beg);
+    p_end.swap(other.p_end);
+    rho.swap(other.rho);
+    std::swap(log_sum_weight, other.log_sum_weight);
+  }
+
+  ps_point z_propose;
+  Eigen::VectorXd p_sharp_beg;
+  Eigen::VectorXd p_sharp_end;
+  Eigen::VectorXd p_beg;
+  Eigen::VectorXd p_end;
+  Eigen::VectorXd rho;
+  double log_sum_weight;
+};
+
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling, building
+ * each subtree iteratively instead of recursively.
+ *
+ * A subtree of depth d is built leaf by leaf.  Completed subtrees that
+ * are still waiting for their sibling are kept in a table of
+ * checkpoints with one slot per depth, laid out contiguously and
+ * allocated once, so memory use is O(max_depth) vectors and does not
+ * depend on the call stack.  Leaves are visited, subtrees merged and
+ * random numbers consumed in exactly the same order as in the
+ * recursive base_nuts::build_tree, so both produce identical draws for
+ * the same seed.
+ */
+template <class Model, template <class, class> class Hamiltonian,
+          template <class> class Integrator, class BaseRNG>
+class base_nuts_iterative
+    : public base_nuts<Model, Hamiltonian, Integrator, BaseRNG> {
+ public:
+  base_nuts_iterative(const Model& model, BaseRNG& rng)
+      : base_nuts<Model, Hamiltonian, Integrator, BaseRNG>(model, rng),
+        current_(this->z_.q.size()),
+        rho_subtree_(this->z_.q.size()),
+        rho_junction_(this->z_.q.size()) {
+    this->tree_scratch_.clear();
+    reserve_checkpoints(this->max_depth_);
+  }
+
+  base_nuts_iterative(const Model& model, BaseRNG& rng,
+                      Eigen::VectorXd& inv_e_metric)
+      : base_nuts<Model, Hamiltonian, Integrator, BaseRNG>(model, rng,
+                                                           inv_e_metric),
+        current_(this->z_.q.size()),
+        rho_subtree_(this->z_.q.size()),
+        rho_junction_(this->z_.q.size()) {
+    this->tree_scratch_.clear();
+    reserve_checkpoints(this->max_depth_);
+  }
+
+  base_nuts_iterative(const Model& model, BaseRNG& rng,
+                      Eigen::MatrixXd& inv_e_metric)
+      : base_nuts<Model, Hamiltonian, Integrator, BaseRNG>(model, rng,
+                                                           inv_e_metric),
+        current_(this->z_.q.size()),
+        rho_subtree_(this->z_.q.size()),
+        rho_junction_(this->z_.q.size()) {
+    this->tree_scratch_.clear();
+    reserve_checkpoints(this->max_depth_);
+  }
+
+  void set_max_depth(int d) {
+    base_nuts<Model, Hamiltonian, Integrator, BaseRNG>::set_max_depth(d);
+    this->tree_scratch_.clear();
+    reserve_checkpoints(this->max_depth_);
+  }
+
+  /**
+   * Speculative expansion is not supported: the leaves are always
+   * integrated here, so steps speculated ahead of the trajectory would
+   * never be used.  Speculation stays disabled whatever the setting.
+   *
+   * @param speculative ignored
+   */
+  void set_speculative(bool speculative) {
+    base_nuts<Model, Hamiltonian, Integrator, BaseRNG>::set_speculative(false);
+  }
+
+  /**
+   * Return the table of pending subtree checkpoints, one per depth.
+   *
+   * @return checkpoint table
+   */
+  const std::vector<nuts_checkpoint>& checkpoints() const noexcept {
+    return checkpoints_;
+  }
+
+  /**
+   * Iteratively build a new subtree to completion or until
+   * the subtree becomes invalid.  Returns validity of the
+   * resulting subtree.
+   *
+   * @param depth Depth of the desired subtree
+   * @param z_propose State proposed from subtree
+   * @param p_sharp_beg Sharp momentum at beginning of new tree
+   * @param p_sharp_end Sharp momentum at end of new tree
+   * @param rho Summed momentum across trajectory
+   * @param p_beg Momentum at beginning of returned tree
+   * @param p_end Momentum at end of returned tree
+   * @param H0 Hamiltonian of initial state
+   * @param sign Direction in time to built subtree
+   * @param n_leapfrog Summed number of leapfrog evaluations
+   * @param log_sum_weight Log of summed weights across trajectory
+   * @param sum_metro_prob Summed Metropolis probabilities across trajectory
+   * @param logger Logger for messages
+   */
+  bool build_tree(int depth, ps_point& z_propose, Eigen::VectorXd& p_sharp_beg,
+                  Eigen::VectorXd& p_sharp_end, Eigen::VectorXd& rho,
+                  Eigen::VectorXd& p_beg, Eigen::VectorXd& p_end, double H0,
+                  double sign, int& n_leapfrog, double& log_sum_weight,
+                  double& sum_metro_prob, callbacks::logger& logger) {
+    reserve_checkpoints(depth);
+
+    const int num_leaves = 1 << depth;
+    for (int n = 0; n < num_leaves; ++n) {
+      if (!build_leaf(current_, H0, sign, n_leapfrog, sum_metro_prob, logger))
+        return false;
+      if (!complete_leaf(n, num_leaves))
+        return false;
+    }
+
+    export_subtree(z_propose, p_sharp_beg, p_sharp_end, rho, p_beg, p_end,
+                   log_sum_weight);
+    return true;
+  }
+
+ protected:
+  /**
+   * Make sure there is one checkpoint slot for every depth below the
+   * specified depth.
+   *
+   * @param depth deepest subtree that will be built
+   */
+  void reserve_checkpoints(int depth) {
+    if (checkpoints_.size() < static_cast<size_t>(depth)) {
+      checkpoints_.reserve(depth);
+      while (checkpoints_.size() < static_cast<size_t>(depth))
+        checkpoints_.emplace_back(this->z_.q.size());
+    }
+  }
+
+  /**
+   * Take a single leapfrog step from the current state and record the
+   * resulting one-point subtree.
+   *
+   * @param leaf Checkpoint to fill with the new leaf
+   * @param H0 Hamiltonian of initial state
+   * @param sign Direction in time to built subtree
+   * @param n_leapfrog Summed number of leapfrog evaluations
+   * @param sum_metro_prob Summed Metropolis probabilities across trajectory
+   * @param logger Logger for messages
+   * @return whether the leaf is valid
+   */
+  bool build_leaf(nuts_checkpoint& leaf, double H0, double sign,
+                  int& n_leapfrog, double& sum_metro_prob,
+                  callbacks::logger& logger) {
+    this->integrator_.evolve(this->z_, this->hamiltonian_,
+                             sign * this->epsilon_, logger);
+    ++n_leapfrog;
+    return record_leaf(leaf, H0, sum_metro_prob);
+  }
+
+  /**
+   * Record the current state, which has just been reached by a
+   * leapfrog step, as a one-point subtree.
+   *
+   * @param leaf Checkpoint to fill with the new leaf
+   * @param H0 Hamiltonian of initial state
+   * @param sum_metro_prob Summed Metropolis probabilities across trajectory
+   * @return whether the leaf is valid
+   */
+  bool record_leaf(nuts_checkpoint& leaf, double H0, double& sum_metro_prob) {
+    double h = this->hamiltonian_.H_and_dtau_dp(this->z_, leaf.p_sharp_beg);
+    if (std::isnan(h))
+      h = std::numeric_limits<double>::infinity();
+
+    if ((h - H0) > this->max_deltaH_)
+      this->divergent_ = true;
+
+    leaf.log_sum_weight = H0 - h;
+
+    if (H0 - h > 0)
+      sum_metro_prob += 1;
+    else
+      sum_metro_prob += std::exp(H0 - h);
+
+    leaf.z_propose = this->z_;
+
+    leaf.p_sharp_end = leaf.p_sharp_beg;
+
+    leaf.rho = this->z_.p;
+    leaf.p_beg = this->z_.p;
+    leaf.p_end = leaf.p_beg;
+
+    return !this->divergent_;
+  }
+
+  /**
+   * Fold the leaf just recorded in `current_` into the pending
+   * subtrees.  Every trailing one bit of the leaf index marks a
+   * pending subtree of matching size that the new leaf completes.
+   * Unless the leaf is the last one, the resulting subtree is parked
+   * as a checkpoint to wait for its sibling.
+   *
+   * @param n Index of the leaf within the subtree being built
+   * @param num_leaves Number of leaves in the subtree being built
+   * @return whether all merged subtrees are valid
+   */
+  bool complete_leaf(int n, int num_leaves) {
+    int level = 0;
+    for (; (n >> level) & 1; ++level) {
+      if (!merge_subtrees(checkpoints_[level], current_))
+        return false;
+    }
+
+    if (n + 1 < num_leaves)
+      checkpoints_[level].swap(current_);
+    return true;
+  }
+
+  /**
+   * Copy the completed subtree held in `current_` into the outputs of
+   * build_tree.
+   *
+   * @param z_propose State proposed from subtree
+   * @param p_sharp_beg Sharp momentum at beginning of new tree
+   * @param p_sharp_end Sharp momentum at end of new tree
+   * @param rho Summed momentum across trajectory
+   * @param p_beg Momentum at beginning of returned tree
+   * @param p_end Momentum at end of returned tree
+   * @param log_sum_weight Log of summed weights across trajectory
+   */
+  void export_subtree(ps_point& z_propose, Eigen::VectorXd& p_sharp_beg,
+                      Eigen::VectorXd& p_sharp_end, Eigen::VectorXd& rho,
+                      Eigen::VectorXd& p_beg, Eigen::VectorXd& p_end,
+                      double& log_sum_weight) {
+    log_sum_weight
+        = math::log_sum_exp(log_sum_weight, current_.log_sum_weight);
+    z_propose = current_.z_propose;
+    p_sharp_beg = current_.p_sharp_beg;
+    p_sharp_end = current_.p_sharp_end;
+    p_beg = current_.p_beg;
+    p_end = current_.p_end;
+    rho += current_.rho;
+  }
+
+  /**
+   * Merge a completed final subtree into its pending initial sibling,
+   * leaving the merged subtree in place of the final one.  Returns
+   * whether the merged subtree satisfies the no-u-turn criterion.
+   *
+   * @param init Initial subtree, earlier in time along the trajectory
+   * @param last Final subtree, overwritten with the merged subtree
+   * @return whether the merged subtree is valid
+   */
+  bool merge_subtrees(nuts_checkpoint& init, nuts_checkpoint& last) {
+    // Multinomial sample from right subtree
+    double log_sum_weight_subtree
+        = math::log_sum_exp(init.log_sum_weight, last.log_sum_weight);
+
+    bool take_last = last.log_sum_weight > log_sum_weight_subtree;
+    if (!take_last) {
+      double accept_prob
+          = std::exp(last.log_sum_weight - log_sum_weight_subtree);
+      take_last = this->rand_uniform_() < accept_prob;
+    }
+    if (!take_last) {
+      last.z_propose.q.swap(init.z_propose.q);
+      last.z_propose.p.swap(init.z_propose.p);
+      last.z_propose.g.swap(init.z_propose.g);
+      std::swap(last.z_propose.V, init.z_propose.V);
+    }
+    last.log_sum_weight = log_sum_weight_subtree;
+
+    rho_subtree_ = init.rho + last.rho;
+
+    // Demand satisfaction around merged subtrees
+    bool persist_criterion = this->compute_criterion(
+        init.p_sharp_beg, last.p_sharp_end, rho_subtree_);
+
+    // Demand satisfaction between subtrees
+    rho_junction_ = init.rho + last.p_beg;
+    persist_criterion &= this->compute_criterion(
+        init.p_sharp_beg, last.p_sharp_beg, rho_junction_);
+
+    rho_junction_ = last.rho + init.p_end;
+    persist_criterion &= this->compute_criterion(
+        init.p_sharp_end, last.p_sharp_end, rho_junction_);
+
+    last.rho.swap(rho_subtree_);
+    last.p_beg.swap(init.p_beg);
+    last.p_sharp_beg.swap(init.p_sharp_beg);
+
+    return persist_criterion;
+  }
+
+  // Pending initial subtrees, indexed by depth
+  std::vector<nuts_checkpoint> checkpoints_;
+
+  // Subtree currently being built
+  nuts_checkpoint current_;
+
+  Eigen::VectorXd rho_subtree_;
+  Eigen::VectorXd rho_junction_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,28 @@
+#ifndef STAN_MCMC_HMC_NUTS_ITERATIVE_DIAG_E_NUTS_ITERATIVE_HPP
+#define STAN_MCMC_HMC_NUTS_ITERATIVE_DIAG_E_NUTS_ITERATIVE_HPP
+
+#include <stan/mcmc/hmc/nuts_iterative/base_nuts_iterative.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling and an
+ * iterative trajectory builder
+ * with a Gaussian-Euclidean disintegration and diagonal metric
+ */
+template <class Model, class BaseRNG>
+class diag_e_nuts_iterative
+    : public base_nuts_iterative<Model, diag_e_metric, expl_leapfrog,
+                                 BaseRNG> {
+ public:
+  diag_e_nuts_iterative(const Model& model, BaseRNG& rng)
+      : base_nuts_iterative<Model, diag_e_metric, expl_leapfrog, BaseRNG>(
+          model, rng) {}
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
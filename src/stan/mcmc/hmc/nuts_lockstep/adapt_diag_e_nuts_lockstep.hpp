@@ -0,0 +1,75 @@
+#ifndef STAN_MCMC_HMC_NUTS_LOCKSTEP_ADAPT_DIAG_E_NUTS_LOCKSTEP_HPP
+#define STAN_MCMC_HMC_NUTS_LOCKSTEP_ADAPT_DIAG_E_NUTS_LOCKSTEP_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/stepsize_var_adapter.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/diag_e_nuts_lockstep.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling and lockstep
+ * gradient evaluation
+ * with a Gaussian-Euclidean disintegration and adaptive
+ * diagonal metric and adaptive step size
+ */
+template <class Model, class BaseRNG>
+class adapt_diag_e_nuts_lockstep : public diag_e_nuts_lockstep<Model, BaseRNG>,
+                                   public stepsize_var_adapter {
+ public:
+  adapt_diag_e_nuts_lockstep(const Model& model, BaseRNG& rng)
+      : diag_e_nuts_lockstep<Model, BaseRNG>(model, rng),
+        stepsize_var_adapter(model.num_params_r()) {}
+
+  ~adapt_diag_e_nuts_lockstep() {}
+
+  sample end_transition(callbacks::logger& logger) {
+    sample s = diag_e_nuts_lockstep<Model, BaseRNG>::end_transition(logger);
+    adapt(s, logger);
+    return s;
+  }
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    sample s
+        = diag_e_nuts_lockstep<Model, BaseRNG>::transition(init_sample, logger);
+    adapt(s, logger);
+    return s;
+  }
+
+  void disengage_adaptation() {
+    base_adapter::disengage_adaptation();
+    this->stepsize_adaptation_.complete_adaptation(this->nom_epsilon_);
+  }
+
+ protected:
+  /**
+   * Update the step size and metric adaptation with a new sample.
+   * When a metric window closes, the step size is reinitialized with
+   * the chain's own gradient evaluations.
+   *
+   * @param s sample just drawn
+   * @param logger Logger for messages
+   */
+  void adapt(sample& s, callbacks::logger& logger) {
+    if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
+      this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
+                                                s.accept_stat());
+
+      bool update = this->var_adaptation_.learn_variance(this->z_.inv_e_metric_,
+                                                         this->z_.q);
+
+      if (update) {
+        this->init_stepsize(logger);
+
+        this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
+        this->stepsize_adaptation_.restart();
+      }
+      this->add_adaptation_time(adapt_start);
+    }
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,350 @@
+#ifndef STAN_MCMC_HMC_NUTS_LOCKSTEP_BASE_NUTS_LOCKSTEP_HPP
+#define STAN_MCMC_HMC_NUTS_LOCKSTEP_BASE_NUTS_LOCKSTEP_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/nuts_iterative/base_nuts_iterative.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <cmath>
+#include <limits>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling, written as
+ * a resumable state machine so that several chains can be advanced
+ * in lockstep and share one batched gradient evaluation per leapfrog
+ * step.
+ *
+ * A transition is driven from outside:
+ *
+ * ```
+ * sampler.begin_transition(init_sample, logger);
+ * while (sampler.awaiting_gradient()) {
+ *   // evaluate the log density and gradient at sampler.position()
+ *   sampler.set_log_prob_gradient(log_prob, gradient);
+ *   sampler.advance(logger);
+ * }
+ * sample s = sampler.end_transition(logger);
+ * ```
+ *
+ * Between two calls to advance() the sampler sits on a position whose
+ * gradient it needs next.  The trajectory is built with the iterative
+ * scheme of base_nuts_iterative, so the leaves, merges and random
+ * numbers are visited in the same order as base_nuts::transition and
+ * both produce identical draws for the same seed.  Only the explicit
+ * leapfrog integrator can be split around the gradient evaluation, so
+ * the integrator is fixed.
+ */
+template <class Model, template <class, class> class Hamiltonian,
+          class BaseRNG>
+class base_nuts_lockstep
+    : public base_nuts_iterative<Model, Hamiltonian, expl_leapfrog,
+                                 BaseRNG> {
+ public:
+  base_nuts_lockstep(const Model& model, BaseRNG& rng)
+      : base_nuts_iterative<Model, Hamiltonian, expl_leapfrog, BaseRNG>(
+          model, rng) {}
+
+  base_nuts_lockstep(const Model& model, BaseRNG& rng,
+                     Eigen::VectorXd& inv_e_metric)
+      : base_nuts_iterative<Model, Hamiltonian, expl_leapfrog, BaseRNG>(
+          model, rng, inv_e_metric) {}
+
+  base_nuts_lockstep(const Model& model, BaseRNG& rng,
+                     Eigen::MatrixXd& inv_e_metric)
+      : base_nuts_iterative<Model, Hamiltonian, expl_leapfrog, BaseRNG>(
+          model, rng, inv_e_metric) {}
+
+  /**
+   * Begin a new transition from the specified sample.  Afterwards the
+   * sampler awaits the gradient at the initial position.
+   *
+   * @param init_sample sample to start from
+   * @param logger Logger for messages
+   */
+  void begin_transition(sample& init_sample, callbacks::logger& logger) {
+    this->sample_stepsize();
+    this->seed(init_sample.cont_params());
+    this->hamiltonian_.sample_p(this->z_, this->rand_int_);
+    phase_ = phase::init;
+  }
+
+  /**
+   * Return whether the current transition needs another gradient
+   * evaluation before it can advance.
+   */
+  inline bool awaiting_gradient() const noexcept {
+    return phase_ != phase::done;
+  }
+
+  /**
+   * Return the unconstrained position at which the next gradient is
+   * needed.
+   */
+  inline const Eigen::VectorXd& position() const noexcept {
+    return this->z_.q;
+  }
+
+  /**
+   * Store an externally computed log density and gradient for the
+   * current position.
+   *
+   * @param log_prob log density at position()
+   * @param gradient gradient of the log density at position()
+   */
+  void set_log_prob_gradient(double log_prob,
+                             const Eigen::VectorXd& gradient) {
+    this->z_.V = -log_prob;
+    this->z_.g = -gradient;
+  }
+
+  /**
+   * Evaluate the log density and gradient for the current position
+   * through the Hamiltonian, which reports any error to the logger
+   * and rejects the point.  The initial position of a transition may
+   * be served from the gradient cache.
+   *
+   * @param logger Logger for messages
+   */
+  void update_log_prob_gradient(callbacks::logger& logger) {
+    if (phase_ == phase::init)
+      this->hamiltonian_.init(this->z_, logger);
+    else
+      this->hamiltonian_.update_potential_gradient(this->z_, logger);
+  }
+
+  /**
+   * Consume the gradient at the current position and move the
+   * trajectory forward until the next gradient is needed or the
+   * trajectory is complete.
+   *
+   * @param logger Logger for messages
+   */
+  void advance(callbacks::logger& logger) {
+    if (phase_ == phase::init) {
+      begin_trajectory();
+      begin_subtree(logger);
+      return;
+    }
+
+    const double epsilon = sign_ * this->epsilon_;
+    this->integrator_.end_update_p(this->z_, this->hamiltonian_,
+                                   0.5 * epsilon, logger);
+    ++leapfrog_count_;
+
+    bool valid_subtree = this->record_leaf(this->current_, H0_,
+                                           sum_metro_prob_)
+                         && this->complete_leaf(leaf_, num_leaves_);
+
+    if (valid_subtree && ++leaf_ < num_leaves_) {
+      drift(logger);
+      return;
+    }
+    end_subtree(valid_subtree, logger);
+  }
+
+  /**
+   * Finish the current transition and return the new sample.
+   *
+   * @param logger Logger for messages
+   * @return sample drawn from the trajectory
+   */
+  sample end_transition(callbacks::logger& logger) {
+    this->n_leapfrog_ = leapfrog_count_;
+
+    // Compute average acceptance probability across entire trajectory,
+    // even over subtrees that may have been rejected
+    double accept_prob
+        = sum_metro_prob_ / static_cast<double>(leapfrog_count_);
+
+    this->z_.ps_point::operator=(this->z_sample_);
+    this->hamiltonian_.cache_gradient(this->z_);
+    this->energy_ = this->hamiltonian_.H(this->z_);
+    return this->current_sample(-this->z_.V, accept_prob);
+  }
+
+  /**
+   * Run a complete transition, evaluating every gradient through the
+   * Hamiltonian of this chain alone.
+   *
+   * @param init_sample sample to start from
+   * @param logger Logger for messages
+   * @return new sample
+   */
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    begin_transition(init_sample, logger);
+    while (awaiting_gradient()) {
+      update_log_prob_gradient(logger);
+      advance(logger);
+    }
+    return end_transition(logger);
+  }
+
+ protected:
+  enum class phase { done, init, leaf };
+
+  /**
+   * Set up the trajectory around the initial point, whose gradient
+   * has just been stored.
+   */
+  void begin_trajectory() {
+    this->z_fwd_ = this->z_;
+    this->z_bck_ = this->z_fwd_;
+    this->z_sample_ = this->z_fwd_;
+    this->z_propose_ = this->z_fwd_;
+
+    this->p_fwd_fwd_ = this->z_.p;
+    this->p_sharp_fwd_fwd_ = this->hamiltonian_.dtau_dp(this->z_);
+    this->p_fwd_bck_ = this->z_.p;
+    this->p_sharp_fwd_bck_ = this->p_sharp_fwd_fwd_;
+    this->p_bck_fwd_ = this->z_.p;
+    this->p_sharp_bck_fwd_ = this->p_sharp_fwd_fwd_;
+    this->p_bck_bck_ = this->z_.p;
+    this->p_sharp_bck_bck_ = this->p_sharp_fwd_fwd_;
+
+    this->rho_ = this->z_.p;
+
+    log_sum_weight_ = 0;  // log(exp(H0 - H0))
+    H0_ = this->hamiltonian_.H(this->z_);
+    leapfrog_count_ = 0;
+    sum_metro_prob_ = 0;
+
+    this->depth_ = 0;
+    this->divergent_ = false;
+  }
+
+  /**
+   * Start a new subtree in a random direction, or finish the
+   * trajectory if the maximum depth has been reached.
+   *
+   * @param logger Logger for messages
+   */
+  void begin_subtree(callbacks::logger& logger) {
+    if (this->depth_ >= this->max_depth_) {
+      phase_ = phase::done;
+      return;
+    }
+
+    this->rho_fwd_.setZero();
+    this->rho_bck_.setZero();
+    log_sum_weight_subtree_ = -std::numeric_limits<double>::infinity();
+
+    if (this->rand_uniform_() > 0.5) {
+      // Extend the current trajectory forward
+      this->z_.ps_point::operator=(this->z_fwd_);
+      this->rho_bck_ = this->rho_;
+      this->p_bck_fwd_ = this->p_fwd_fwd_;
+      this->p_sharp_bck_fwd_ = this->p_sharp_fwd_fwd_;
+      sign_ = 1;
+    } else {
+      // Extend the current trajectory backwards
+      this->z_.ps_point::operator=(this->z_bck_);
+      this->rho_fwd_ = this->rho_;
+      this->p_fwd_bck_ = this->p_bck_bck_;
+      this->p_sharp_fwd_bck_ = this->p_sharp_bck_bck_;
+      sign_ = -1;
+    }
+
+    this->reserve_checkpoints(this->depth_);
+    leaf_ = 0;
+    num_leaves_ = 1 << this->depth_;
+    drift(logger);
+  }
+
+  /**
+   * Apply the first half momentum update and the position update of
+   * the next leapfrog step, leaving the sampler at the position whose
+   * gradient is needed next.
+   *
+   * @param logger Logger for messages
+   */
+  void drift(callbacks::logger& logger) {
+    const double epsilon = sign_ * this->epsilon_;
+    this->integrator_.begin_update_p(this->z_, this->hamiltonian_,
+                                     0.5 * epsilon, logger);
+    this->hamiltonian_.add_dtau_dp(this->z_, epsilon, this->z_.q);
+    phase_ = phase::leaf;
+  }
+
+  /**
+   * Fold a finished subtree into the trajectory and either start the
+   * next subtree or finish the trajectory.
+   *
+   * @param valid_subtree whether the subtree was built to completion
+   * @param logger Logger for messages
+   */
+  void end_subtree(bool valid_subtree, callbacks::logger& logger) {
+    if (sign_ > 0) {
+      if (valid_subtree)
+        this->export_subtree(this->z_propose_, this->p_sharp_fwd_bck_,
+                             this->p_sharp_fwd_fwd_, this->rho_fwd_,
+                             this->p_fwd_bck_, this->p_fwd_fwd_,
+                             log_sum_weight_subtree_);
+      this->z_fwd_.ps_point::operator=(this->z_);
+    } else {
+      if (valid_subtree)
+        this->export_subtree(this->z_propose_, this->p_sharp_bck_fwd_,
+                             this->p_sharp_bck_bck_, this->rho_bck_,
+                             this->p_bck_fwd_, this->p_bck_bck_,
+                             log_sum_weight_subtree_);
+      this->z_bck_.ps_point::operator=(this->z_);
+    }
+
+    if (!valid_subtree) {
+      phase_ = phase::done;
+      return;
+    }
+
+    // Sample from accepted subtree
+    ++(this->depth_);
+
+    if (log_sum_weight_subtree_ > log_sum_weight_) {
+      this->z_sample_ = this->z_propose_;
+    } else {
+      double accept_prob = std::exp(log_sum_weight_subtree_ - log_sum_weight_);
+      if (this->rand_uniform_() < accept_prob)
+        this->z_sample_ = this->z_propose_;
+    }
+
+    log_sum_weight_
+        = math::log_sum_exp(log_sum_weight_, log_sum_weight_subtree_);
+
+    // Break when no-u-turn criterion is no longer satisfied
+    this->rho_ = this->rho_bck_ + this->rho_fwd_;
+
+    // Demand satisfaction around merged subtrees
+    bool persist_criterion = this->compute_criterion(
+        this->p_sharp_bck_bck_, this->p_sharp_fwd_fwd_, this->rho_);
+
+    // Demand satisfaction between subtrees
+    this->rho_extended_ = this->rho_bck_ + this->p_fwd_bck_;
+    persist_criterion &= this->compute_criterion(
+        this->p_sharp_bck_bck_, this->p_sharp_fwd_bck_, this->rho_extended_);
+
+    this->rho_extended_ = this->rho_fwd_ + this->p_bck_fwd_;
+    persist_criterion &= this->compute_criterion(
+        this->p_sharp_bck_fwd_, this->p_sharp_fwd_fwd_, this->rho_extended_);
+
+    if (!persist_criterion) {
+      phase_ = phase::done;
+      return;
+    }
+    begin_subtree(logger);
+  }
+
+  phase phase_{phase::done};
+  double sign_{1};
+  int leaf_{0};
+  int num_leaves_{0};
+  int leapfrog_count_{0};
+  double H0_{0};
+  double log_sum_weight_{0};
+  double log_sum_weight_subtree_{0};
+  double sum_metro_prob_{0};
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
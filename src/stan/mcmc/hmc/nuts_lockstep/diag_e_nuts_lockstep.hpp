@@ -0,0 +1,25 @@
+#ifndef STAN_MCMC_HMC_NUTS_LOCKSTEP_DIAG_E_NUTS_LOCKSTEP_HPP
+#define STAN_MCMC_HMC_NUTS_LOCKSTEP_DIAG_E_NUTS_LOCKSTEP_HPP
+
+#include <stan/mcmc/hmc/nuts_lockstep/base_nuts_lockstep.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * The No-U-Turn sampler (NUTS) with multinomial sampling and lockstep
+ * gradient evaluation
+ * with a Gaussian-Euclidean disintegration and diagonal metric
+ */
+template <class Model, class BaseRNG>
+class diag_e_nuts_lockstep
+    : public base_nuts_lockstep<Model, diag_e_metric, BaseRNG> {
+ public:
+  diag_e_nuts_lockstep(const Model& model, BaseRNG& rng)
+      : base_nuts_lockstep<Model, diag_e_metric, BaseRNG>(model, rng) {}
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,124 @@
+#ifndef STAN_MCMC_HMC_NUTS_LOCKSTEP_LOCKSTEP_DRIVER_HPP
+#define STAN_MCMC_HMC_NUTS_LOCKSTEP_LOCKSTEP_DRIVER_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/model/log_prob_grad_batch.hpp>
+#include <algorithm>
+#include <exception>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Advances several lockstep NUTS chains on the same model together.
+ * At every leapfrog step the positions of all chains that still need
+ * a gradient are gathered into the columns of one matrix and handed
+ * to `stan::model::log_prob_grad_batch` in a single call.  Chains
+ * whose trajectories terminate early simply drop out of later
+ * batches.
+ *
+ * If the batched evaluation throws, the positions of that step are
+ * evaluated again one chain at a time through each chain's own
+ * Hamiltonian, so that the error is reported and the proposal rejected
+ * exactly as it would be for a chain run on its own.
+ *
+ * @tparam Model Model class
+ */
+template <class Model>
+class lockstep_driver {
+ public:
+  /**
+   * Construct a driver evaluating the specified model.
+   *
+   * @param model model shared by all chains
+   */
+  explicit lockstep_driver(const Model& model) : model_(model) {}
+
+  /**
+   * Run one transition of every chain.
+   *
+   * @tparam Sampler type of lockstep sampler, e.g. base_nuts_lockstep
+   * @param[in,out] samplers samplers, one per chain
+   * @param[in,out] samples current sample of each chain, replaced with
+   *   the new one
+   * @param[in,out] logger logger for messages
+   */
+  template <class Sampler>
+  void transition(std::vector<Sampler>& samplers, std::vector<sample>& samples,
+                  callbacks::logger& logger) {
+    active_.clear();
+    for (size_t k = 0; k < samplers.size(); ++k) {
+      samplers[k].begin_transition(samples[k], logger);
+      if (samplers[k].awaiting_gradient())
+        active_.push_back(k);
+    }
+
+    while (!active_.empty()) {
+      step(samplers, logger);
+      active_.erase(std::remove_if(active_.begin(), active_.end(),
+                                   [&samplers](size_t k) {
+                                     return !samplers[k].awaiting_gradient();
+                                   }),
+                    active_.end());
+    }
+
+    for (size_t k = 0; k < samplers.size(); ++k)
+      samples[k] = samplers[k].end_transition(logger);
+  }
+
+ private:
+  /**
+   * Evaluate the gradients of all active chains and advance each of
+   * them to its next position.
+   */
+  template <class Sampler>
+  void step(std::vector<Sampler>& samplers, callbacks::logger& logger) {
+    const size_t num_active = active_.size();
+    positions_.resize(samplers[active_[0]].position().size(), num_active);
+    for (size_t j = 0; j < num_active; ++j)
+      positions_.col(j) = samplers[active_[j]].position();
+
+    bool batched = true;
+    std::stringstream msgs;
+    try {
+      stan::model::log_prob_grad_batch<true, true>(model_, positions_,
+                                                  log_prob_, gradient_, &msgs);
+    } catch (const std::exception&) {
+      batched = false;
+    }
+
+    if (batched) {
+      if (msgs.str().length() > 0)
+        logger.info(msgs);
+      for (size_t j = 0; j < num_active; ++j) {
+        gradient_col_ = gradient_.col(j);
+        samplers[active_[j]].set_log_prob_gradient(log_prob_(j),
+                                                   gradient_col_);
+      }
+    } else {
+      for (size_t j = 0; j < num_active; ++j)
+        samplers[active_[j]].update_log_prob_gradient(logger);
+    }
+
+    for (size_t j = 0; j < num_active; ++j)
+      samplers[active_[j]].advance(logger);
+  }
+
+  const Model& model_;
+
+  // Indices of the chains that still need gradients this transition
+  std::vector<size_t> active_;
+
+  Eigen::MatrixXd positions_;
+  Eigen::VectorXd log_prob_;
+  Eigen::MatrixXd gradient_;
+  Eigen::VectorXd gradient_col_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -22,6 +22,7 @@ class base_static_hmc
  public:
   base_static_hmc(const Model& model, BaseRNG& rng)
       : base_hmc<Model, Hamiltonian, Integrator, BaseRNG>(model, rng),
+        z_init_(this->z_.q.size()),
         T_(1),
         energy_(0) {
     update_L_();
@@ -33,6 +34,11 @@ class base_static_hmc
     this->z_.set_metric(inv_e_metric);
   }
 
+  void set_metric(const Eigen::MatrixXd& inv_e_metric,
+                  const Eigen::LLT<Eigen::MatrixXd>& inv_e_metric_llt) {
+    this->z_.set_metric(inv_e_metric, inv_e_metric_llt);
+  }
+
   void set_metric(const Eigen::VectorXd& inv_e_metric) {
     this->z_.set_metric(inv_e_metric);
   }
@@ -45,13 +51,15 @@ class base_static_hmc
     this->hamiltonian_.sample_p(this->z_, this->rand_int_);
     this->hamiltonian_.init(this->z_, logger);
 
-    ps_point z_init(this->z_);
+    // The initial state is kept in a preallocated member so that a
+    // transition performs no heap allocation of its own
+    ps_point& z_init = z_init_;
+    z_init = this->z_;
 
     double H0 = this->hamiltonian_.H(this->z_);
 
-    for (int i = 0; i < L_; ++i)
-      this->integrator_.evolve(this->z_, this->hamiltonian_, this->epsilon_,
-                               logger);
+    this->integrator_.evolve_steps(this->z_, this->hamiltonian_,
+                                   this->epsilon_, L_, logger);
 
     double h = this->hamiltonian_.H(this->z_);
     if (std::isnan(h))
@@ -63,9 +71,10 @@ class base_static_hmc
       this->z_.ps_point::operator=(z_init);
 
     acceptProb = acceptProb > 1 ? 1 : acceptProb;
+    this->hamiltonian_.cache_gradient(this->z_);
 
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->hamiltonian_.V(this->z_), acceptProb);
+    return this->current_sample(-this->hamiltonian_.V(this->z_), acceptProb);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
@@ -115,6 +124,9 @@ class base_static_hmc
   int get_L() { return this->L_; }
 
  protected:
+  // Initial state, restored when the endpoint is rejected
+  ps_point z_init_;
+
   double T_;
   int L_;
   double energy_;
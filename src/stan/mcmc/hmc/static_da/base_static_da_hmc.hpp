@@ -0,0 +1,178 @@
+#ifndef STAN_MCMC_HMC_STATIC_DA_BASE_STATIC_DA_HMC_HPP
+#define STAN_MCMC_HMC_STATIC_DA_BASE_STATIC_DA_HMC_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/hmc/static/base_static_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Delayed acceptance Hamiltonian Monte Carlo with a static integration
+ * time, for models whose gradients are too expensive to evaluate at
+ * every leapfrog step.
+ *
+ * The trajectories are integrated on a cheap surrogate density, such
+ * as a `gaussian_surrogate` fitted at the end of warmup or an
+ * approximate model, and their endpoint is accepted in two stages.
+ * The first is the Metropolis test of static HMC on the surrogate; a
+ * proposal it rejects costs no evaluation of the model.  A proposal
+ * passing it is accepted with probability
+ *
+ *   min(1, exp(lp(q') - lp(q) - (ls(q') - ls(q))))
+ *
+ * where `lp` is the log density of the model and `ls` that of the
+ * surrogate, which corrects for the surrogate so that the chain keeps
+ * the model's density as its stationary distribution.  Each transition
+ * thus evaluates the model's log density at most once, without its
+ * gradient, the log density at the current position being kept from
+ * the previous transition.  The better the surrogate matches the
+ * model, the closer the second stage acceptance is to one.
+ *
+ * The accept statistic is that of the first stage, which the step size
+ * adaptation targets; the second stage acceptance probability is
+ * written as the sampler parameter `da_accept_stat__`.
+ *
+ * @tparam Model type of the model
+ * @tparam Surrogate type of the surrogate, providing `num_params_r()`
+ * and a `log_prob` template as a model does
+ */
+template <class Model, class Surrogate,
+          template <class, class> class Hamiltonian,
+          template <class> class Integrator, class BaseRNG>
+class base_static_da_hmc
+    : public base_static_hmc<Surrogate, Hamiltonian, Integrator, BaseRNG> {
+ public:
+  /**
+   * Construct the sampler.  The model and the surrogate are held by
+   * reference and must outlive the sampler.
+   *
+   * @param[in] model model
+   * @param[in] surrogate surrogate density over the model's
+   * unconstrained parameters
+   * @param[in,out] rng random number generator
+   * @throw std::invalid_argument if the surrogate is not over as many
+   * parameters as the model
+   */
+  base_static_da_hmc(const Model& model, const Surrogate& surrogate,
+                     BaseRNG& rng)
+      : base_static_hmc<Surrogate, Hamiltonian, Integrator, BaseRNG>(
+          surrogate, rng),
+        model_(model),
+        target_q_(this->z_.q.size()) {
+    if (surrogate.num_params_r() != model.num_params_r())
+      throw std::invalid_argument(
+          "The surrogate and the model have different numbers of "
+          "parameters");
+  }
+
+  ~base_static_da_hmc() {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    this->sample_stepsize();
+
+    this->seed(init_sample.cont_params());
+    if (!target_valid_ || (this->z_.q.array() != target_q_.array()).any()) {
+      target_q_ = this->z_.q;
+      target_lp_ = target_log_prob_(this->z_.q, logger);
+      target_valid_ = true;
+    }
+
+    this->hamiltonian_.sample_p(this->z_, this->rand_int_);
+    this->hamiltonian_.init(this->z_, logger);
+
+    ps_point& z_init = this->z_init_;
+    z_init = this->z_;
+
+    double H0 = this->hamiltonian_.H(this->z_);
+
+    this->integrator_.evolve_steps(this->z_, this->hamiltonian_,
+                                   this->epsilon_, this->L_, logger);
+
+    double h = this->hamiltonian_.H(this->z_);
+    if (std::isnan(h))
+      h = std::numeric_limits<double>::infinity();
+
+    double accept_prob = std::exp(H0 - h);
+    accept_prob = accept_prob > 1 ? 1 : accept_prob;
+    da_accept_prob_ = 0;
+
+    if (accept_prob == 1 || this->rand_uniform_() <= accept_prob) {
+      const double lp = target_log_prob_(this->z_.q, logger);
+      // the surrogate's log density is -V at both ends
+      double log_ratio = lp - target_lp_ - z_init.V + this->z_.V;
+      if (std::isnan(log_ratio))
+        log_ratio = -std::numeric_limits<double>::infinity();
+      da_accept_prob_ = log_ratio > 0 ? 1 : std::exp(log_ratio);
+      if (da_accept_prob_ == 1 || this->rand_uniform_() < da_accept_prob_) {
+        target_q_ = this->z_.q;
+        target_lp_ = lp;
+      } else {
+        this->z_.ps_point::operator=(z_init);
+      }
+    } else {
+      this->z_.ps_point::operator=(z_init);
+    }
+
+    this->hamiltonian_.cache_gradient(this->z_);
+
+    this->energy_ = this->hamiltonian_.H(this->z_);
+    return this->current_sample(target_lp_, accept_prob);
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {
+    base_static_hmc<Surrogate, Hamiltonian, Integrator,
+                    BaseRNG>::get_sampler_param_names(names);
+    names.push_back("da_accept_stat__");
+  }
+
+  void get_sampler_params(std::vector<double>& values) {
+    base_static_hmc<Surrogate, Hamiltonian, Integrator,
+                    BaseRNG>::get_sampler_params(values);
+    values.push_back(da_accept_prob_);
+  }
+
+  /**
+   * Return the number of evaluations of the model's log density made by
+   * the transitions of the sampler, one per proposal passing the first
+   * stage and one for each initial position not reached by the previous
+   * transition.
+   */
+  long num_target_evaluations() const { return num_target_evaluations_; }
+
+ protected:
+  const Model& model_;
+
+  // Position of the last evaluation of the model and its log density
+  Eigen::VectorXd target_q_;
+  double target_lp_{0};
+  bool target_valid_{false};
+
+  double da_accept_prob_{0};
+  long num_target_evaluations_{0};
+
+  double target_log_prob_(const Eigen::VectorXd& q,
+                          callbacks::logger& logger) {
+    ++num_target_evaluations_;
+    try {
+      return stan::model::log_prob_propto<true>(model_, q);
+    } catch (const std::domain_error& e) {
+      logger.error(
+          "Informational Message: The current Metropolis proposal "
+          "is about to be rejected because of the following issue:");
+      logger.error(e.what());
+      logger.error("");
+      return -std::numeric_limits<double>::infinity();
+    }
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
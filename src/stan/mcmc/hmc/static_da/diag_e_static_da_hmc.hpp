@@ -0,0 +1,30 @@
+#ifndef STAN_MCMC_HMC_STATIC_DA_DIAG_E_STATIC_DA_HMC_HPP
+#define STAN_MCMC_HMC_STATIC_DA_DIAG_E_STATIC_DA_HMC_HPP
+
+#include <stan/mcmc/hmc/hamiltonians/diag_e_point.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/mcmc/hmc/static_da/base_static_da_hmc.hpp>
+
+namespace stan {
+namespace mcmc {
+/**
+ * Delayed acceptance Hamiltonian Monte Carlo implementation using the
+ * endpoint of trajectories on a surrogate density with a static
+ * integration time with a Gaussian-Euclidean disintegration and
+ * diagonal metric
+ */
+template <class Model, class Surrogate, class BaseRNG>
+class diag_e_static_da_hmc
+    : public base_static_da_hmc<Model, Surrogate, diag_e_metric, expl_leapfrog,
+                                BaseRNG> {
+ public:
+  diag_e_static_da_hmc(const Model& model, const Surrogate& surrogate,
+                       BaseRNG& rng)
+      : base_static_da_hmc<Model, Surrogate, diag_e_metric, expl_leapfrog,
+                           BaseRNG>(model, surrogate, rng) {}
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
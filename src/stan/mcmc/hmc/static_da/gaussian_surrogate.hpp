@@ -0,0 +1,93 @@
+#ifndef STAN_MCMC_HMC_STATIC_DA_GAUSSIAN_SURROGATE_HPP
+#define STAN_MCMC_HMC_STATIC_DA_GAUSSIAN_SURROGATE_HPP
+
+#include <stan/math/rev.hpp>
+#include <iostream>
+#include <stdexcept>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Multivariate normal density over the unconstrained parameters of a
+ * model, used as the cheap surrogate whose gradients drive the
+ * trajectories of delayed acceptance HMC.
+ *
+ * It provides the members of a model used by the Hamiltonians,
+ * `num_params_r()` and a `log_prob` template, so it can stand in for
+ * the model.  The log density is evaluated up to a constant as
+ * `-0.5 |W (q - mu)|^2`, where `W` is the inverse of the Cholesky
+ * factor of the covariance, at a cost quadratic in the number of
+ * parameters.
+ *
+ * The mean and covariance are typically those of a Laplace
+ * approximation at the mode, with the covariance the inverse of the
+ * negative Hessian, or are estimated with `from_draws` from the
+ * approximate draws of Pathfinder or the draws of warmup.
+ */
+class gaussian_surrogate {
+ public:
+  /**
+   * Construct the surrogate with the specified mean and covariance.
+   *
+   * @param[in] mean mean
+   * @param[in] covar covariance, symmetric positive definite
+   * @throw std::invalid_argument if the sizes do not match or the
+   * covariance is not positive definite
+   */
+  gaussian_surrogate(const Eigen::VectorXd& mean, const Eigen::MatrixXd& covar)
+      : mean_(mean) {
+    if (covar.rows() != mean.size() || covar.cols() != mean.size())
+      throw std::invalid_argument(
+          "gaussian_surrogate: covariance does not match the mean");
+    Eigen::LLT<Eigen::MatrixXd> llt(covar);
+    if (llt.info() != Eigen::Success)
+      throw std::invalid_argument(
+          "gaussian_surrogate: covariance is not positive definite");
+    whiten_ = llt.matrixL().solve(
+        Eigen::MatrixXd::Identity(mean.size(), mean.size()));
+  }
+
+  /**
+   * Return the surrogate with the sample mean and the regularized
+   * sample covariance of the specified draws, regularized towards a
+   * small multiple of the identity as the covariance adaptation of
+   * warmup does.
+   *
+   * @param[in] draws unconstrained draws, one per row
+   * @return surrogate fitted to the draws
+   * @throw std::invalid_argument if there are fewer than two draws
+   */
+  static gaussian_surrogate from_draws(const Eigen::MatrixXd& draws) {
+    const double n = draws.rows();
+    if (draws.rows() < 2)
+      throw std::invalid_argument(
+          "gaussian_surrogate: at least two draws are required");
+    Eigen::VectorXd mean = draws.colwise().mean().transpose();
+    Eigen::MatrixXd centered = draws.rowwise() - mean.transpose();
+    Eigen::MatrixXd covar = centered.transpose() * centered / (n - 1);
+    covar = (n / (n + 5.0)) * covar
+            + 1e-3 * (5.0 / (n + 5.0))
+                  * Eigen::MatrixXd::Identity(covar.rows(), covar.cols());
+    return gaussian_surrogate(mean, covar);
+  }
+
+  size_t num_params_r() const { return mean_.size(); }
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, -1, 1>& params_r, std::ostream* msgs) const {
+    return -0.5
+           * stan::math::dot_self(stan::math::multiply(
+               whiten_, stan::math::subtract(params_r, mean_)));
+  }
+
+  const Eigen::VectorXd& mean() const { return mean_; }
+
+ private:
+  Eigen::VectorXd mean_;
+  Eigen::MatrixXd whiten_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -28,6 +28,7 @@ class adapt_dense_e_static_uniform
                                                                   logger);
 
     if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
 
@@ -35,10 +36,12 @@ class adapt_dense_e_static_uniform
           this->z_.inv_e_metric_, this->z_.q);
 
       if (update) {
+        this->z_.notify_metric_changed();
         this->init_stepsize(logger);
         this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
         this->stepsize_adaptation_.restart();
       }
+      this->add_adaptation_time(adapt_start);
     }
     return s;
   }
@@ -27,9 +27,11 @@ class adapt_softabs_static_uniform
     sample s = softabs_static_uniform<Model, BaseRNG>::transition(init_sample,
                                                                   logger);
     if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
       this->update_L_();
+      this->add_adaptation_time(adapt_start);
     }
 
     return s;
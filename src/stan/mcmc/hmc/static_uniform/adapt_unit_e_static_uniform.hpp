@@ -28,9 +28,11 @@ class adapt_unit_e_static_uniform
                                                                  logger);
 
     if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
       this->update_L_();
+      this->add_adaptation_time(adapt_start);
     }
 
     return s;
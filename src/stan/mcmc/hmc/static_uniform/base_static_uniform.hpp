@@ -24,6 +24,8 @@ class base_static_uniform
  public:
   base_static_uniform(const Model& model, BaseRNG& rng)
       : base_hmc<Model, Hamiltonian, Integrator, BaseRNG>(model, rng),
+        z_init_(this->z_.q.size()),
+        z_sample_(this->z_.q.size()),
         T_(1),
         energy_(0) {
     update_L_();
@@ -39,10 +41,14 @@ class base_static_uniform
     this->hamiltonian_.sample_p(this->z_, this->rand_int_);
     this->hamiltonian_.init(this->z_, logger);
 
-    ps_point z_init(this->z_);
+    // The initial state and the sample are kept in preallocated members
+    // so that a transition performs no heap allocation of its own
+    ps_point& z_init = z_init_;
+    z_init = this->z_;
     double H0 = this->hamiltonian_.H(this->z_);
 
-    ps_point z_sample(this->z_);
+    ps_point& z_sample = z_sample_;
+    z_sample = this->z_;
     double sum_prob = 1;
     double sum_metro_prob = 1;
 
@@ -86,8 +92,9 @@ class base_static_uniform
     double accept_prob = sum_metro_prob / static_cast<double>(L_);
 
     this->z_.ps_point::operator=(z_sample);
+    this->hamiltonian_.cache_gradient(this->z_);
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->hamiltonian_.V(this->z_), accept_prob);
+    return this->current_sample(-this->hamiltonian_.V(this->z_), accept_prob);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
@@ -137,6 +144,10 @@ class base_static_uniform
   int get_L() { return this->L_; }
 
  protected:
+  // Initial state of the trajectory and the state sampled from it
+  ps_point z_init_;
+  ps_point z_sample_;
+
   double T_;
   int L_;
   double energy_;
@@ -26,6 +26,7 @@ class adapt_diag_e_xhmc : public diag_e_xhmc<Model, BaseRNG>,
     sample s = diag_e_xhmc<Model, BaseRNG>::transition(init_sample, logger);
 
     if (this->adapt_flag_) {
+      auto adapt_start = std::chrono::steady_clock::now();
       this->stepsize_adaptation_.learn_stepsize(this->nom_epsilon_,
                                                 s.accept_stat());
 
@@ -38,6 +39,7 @@ class adapt_diag_e_xhmc : public diag_e_xhmc<Model, BaseRNG>,
         this->stepsize_adaptation_.set_mu(log(10 * this->nom_epsilon_));
         this->stepsize_adaptation_.restart();
       }
+      this->add_adaptation_time(adapt_start);
     }
     return s;
   }
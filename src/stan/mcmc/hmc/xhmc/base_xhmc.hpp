@@ -30,13 +30,21 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         x_delta_(0.1),
         n_leapfrog_(0),
         divergent_(0),
-        energy_(0) {}
+        energy_(0),
+        z_plus_(this->z_.q.size()),
+        z_minus_(this->z_.q.size()),
+        z_sample_(this->z_.q.size()),
+        z_propose_(this->z_.q.size()) {
+    reserve_tree(max_depth_);
+  }
 
   ~base_xhmc() {}
 
   void set_max_depth(int d) {
-    if (d > 0)
+    if (d > 0) {
       max_depth_ = d;
+      reserve_tree(max_depth_);
+    }
   }
 
   void set_max_deltaH(double d) { max_deltaH_ = d; }
@@ -59,11 +67,14 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     this->hamiltonian_.sample_p(this->z_, this->rand_int_);
     this->hamiltonian_.init(this->z_, logger);
 
-    ps_point z_plus(this->z_);
-    ps_point z_minus(z_plus);
-
-    ps_point z_sample(z_plus);
-    ps_point z_propose(z_plus);
+    ps_point& z_plus = z_plus_;
+    ps_point& z_minus = z_minus_;
+    ps_point& z_sample = z_sample_;
+    ps_point& z_propose = z_propose_;
+    z_plus = this->z_;
+    z_minus = z_plus;
+    z_sample = z_plus;
+    z_propose = z_plus;
 
     double ave = this->hamiltonian_.dG_dt(this->z_, logger);
     double log_sum_weight = 0;  // log(exp(H0 - H0))
@@ -120,8 +131,9 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     double accept_prob = sum_metro_prob / static_cast<double>(n_leapfrog + 1);
 
     this->z_.ps_point::operator=(z_sample);
+    this->hamiltonian_.cache_gradient(this->z_);
     this->energy_ = this->hamiltonian_.H(this->z_);
-    return sample(this->z_.q, -this->z_.V, accept_prob);
+    return this->current_sample(-this->z_.V, accept_prob);
   }
 
   void get_sampler_param_names(std::vector<std::string>& names) {
@@ -140,6 +152,12 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
     values.push_back(this->energy_);
   }
 
+  void record_instrumentation(sampler_instrumentation& stats) {
+    base_hmc<Model, Hamiltonian, Integrator, BaseRNG>::record_instrumentation(
+        stats);
+    stats.add_tree_depth(this->depth_);
+  }
+
   /**
    * Recursively build a new subtree to completion or until
    * the subtree becomes invalid.  Returns validity of the
@@ -203,7 +221,9 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
         = stable_sum(ave, log_sum_weight, ave_left, log_sum_weight_left);
 
     // Build the right subtree
-    ps_point z_propose_right(this->z_);
+    reserve_tree(depth + 1);
+    ps_point& z_propose_right = z_propose_right_[depth];
+    z_propose_right = this->z_;
     double ave_right = 0;
     double log_sum_weight_right = -std::numeric_limits<double>::infinity();
 
@@ -272,6 +292,31 @@ class base_xhmc : public base_hmc<Model, Hamiltonian, Integrator, BaseRNG> {
   int n_leapfrog_;
   bool divergent_;
   double energy_;
+
+ protected:
+  /**
+   * Make sure a right subtree proposal exists for every depth below
+   * the specified depth, so that building a trajectory reuses the
+   * storage instead of allocating a point per subtree.
+   *
+   * @param depth maximum tree depth
+   */
+  void reserve_tree(int depth) {
+    if (z_propose_right_.size() < static_cast<size_t>(depth)) {
+      z_propose_right_.reserve(depth);
+      while (z_propose_right_.size() < static_cast<size_t>(depth))
+        z_propose_right_.emplace_back(this->z_.q.size());
+    }
+  }
+
+  // Trajectory state of transition, owned here to avoid reallocation
+  ps_point z_plus_;
+  ps_point z_minus_;
+  ps_point z_sample_;
+  ps_point z_propose_;
+
+  // Proposal of the right subtree at each depth of build_tree
+  std::vector<ps_point> z_propose_right_;
 };
 
 }  // namespace mcmc
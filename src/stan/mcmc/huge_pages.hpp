@@ -0,0 +1,74 @@
+#ifndef STAN_MCMC_HUGE_PAGES_HPP
+#define STAN_MCMC_HUGE_PAGES_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <cstddef>
+#include <cstdint>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Size of the transparent huge pages of x86-64 and aarch64 Linux.
+ */
+constexpr std::size_t huge_page_bytes = std::size_t(2) << 20;
+
+/**
+ * Ask the kernel to back the whole huge pages within the specified
+ * range with transparent huge pages.
+ *
+ * The working vectors of a model with millions of parameters span
+ * thousands of 4 KiB pages each, so that every leapfrog step misses
+ * the TLB on most of them.  Eigen allocates them with
+ * <code>malloc</code>, which maps buffers this large directly, so they
+ * hold whole huge pages without a pool of their own; only the pages
+ * within the range are advised, never its unaligned ends, so the
+ * advice never reaches memory owned by anything else.  Pages touched
+ * before the advice are collapsed into huge pages in the background
+ * by the kernel.
+ *
+ * This does nothing where transparent huge pages are not available,
+ * and the advice may be ignored, for instance when they are disabled
+ * system-wide.
+ *
+ * @param data start of the range
+ * @param bytes size of the range in bytes
+ * @return number of bytes advised
+ */
+inline std::size_t advise_huge_pages(void* data, std::size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data);
+  const std::uintptr_t first
+      = (begin + huge_page_bytes - 1) & ~(huge_page_bytes - 1);
+  const std::uintptr_t last = (begin + bytes) & ~(huge_page_bytes - 1);
+  if (data == nullptr || last <= first)
+    return 0;
+  if (madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE)
+      != 0)
+    return 0;
+  return last - first;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Ask the kernel to back the storage of the specified vector or matrix
+ * with transparent huge pages.
+ *
+ * @tparam Derived type of vector or matrix
+ * @param x vector or matrix
+ * @return number of bytes advised
+ */
+template <typename Derived>
+inline std::size_t advise_huge_pages(Eigen::PlainObjectBase<Derived>& x) {
+  return advise_huge_pages(
+      x.data(), x.size() * sizeof(typename Derived::Scalar));
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
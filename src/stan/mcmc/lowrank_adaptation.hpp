@@ -0,0 +1,140 @@
+#ifndef STAN_MCMC_LOWRANK_ADAPTATION_HPP
+#define STAN_MCMC_LOWRANK_ADAPTATION_HPP
+
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/windowed_adaptation.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace stan {
+
+namespace mcmc {
+
+/**
+ * Windowed adaptation of an inverse metric diag(d) + W * W^T.
+ *
+ * At the end of each window the sample covariance of the draws,
+ * standardized by the regularized variance of var_adaptation, is
+ * approximated by its leading eigenpairs.  The eigenpairs come from
+ * whichever of the covariance and the Gram matrix of the draws is
+ * smaller, so a window of n draws costs O(N n min(N, n)) and no N by N
+ * matrix is needed when n is small.  Eigenvectors whose eigenvalue
+ * exceeds one, the average over all directions, become the columns of
+ * W, and d is what remains of the variance.  Both are shrunk like the
+ * dense covariance of covar_adaptation, so the result is the
+ * regularized sample covariance with its trailing directions replaced
+ * by their diagonal.
+ */
+class lowrank_adaptation : public windowed_adaptation {
+ public:
+  /**
+   * @param n number of dimensions
+   * @param rank maximum number of columns of the low-rank factor
+   */
+  lowrank_adaptation(int n, int rank)
+      : windowed_adaptation("low-rank covariance"),
+        estimator_(n),
+        rank_(std::max(0, std::min(rank, n))) {}
+
+  inline int rank() const { return rank_; }
+
+  bool learn_lowrank(Eigen::VectorXd& var, Eigen::MatrixXd& lowrank,
+                     const Eigen::VectorXd& q) {
+    if (adaptation_window()) {
+      estimator_.add_sample(q);
+      draws_.push_back(q);
+    }
+
+    if (end_adaptation_window()) {
+      compute_next_window();
+
+      estimator_.sample_variance(var);
+
+      double n = static_cast<double>(estimator_.num_samples());
+      var = (n / (n + 5.0)) * var
+            + 1e-3 * (5.0 / (n + 5.0)) * Eigen::VectorXd::Ones(var.size());
+
+      if (!var.allFinite())
+        throw std::runtime_error(
+            "Numerical overflow in metric adaptation. "
+            "This occurs when the sampler encounters extreme values on the "
+            "unconstrained space; this may happen when the posterior density "
+            "function is too wide or improper. "
+            "There may be problems with your model specification.");
+
+      learn_factor(var, n, lowrank);
+
+      estimator_.restart();
+      draws_.clear();
+
+      ++adapt_window_counter_;
+      return true;
+    }
+
+    ++adapt_window_counter_;
+    return false;
+  }
+
+ protected:
+  /**
+   * Compute the low-rank factor from the draws of the window and
+   * subtract its contribution from the regularized variance.
+   */
+  void learn_factor(Eigen::VectorXd& var, double n, Eigen::MatrixXd& lowrank) {
+    const Eigen::Index dim = var.size();
+    const Eigen::Index num_draws = draws_.size();
+    lowrank.resize(dim, 0);
+    if (rank_ == 0 || num_draws < 2)
+      return;
+
+    Eigen::VectorXd mean = Eigen::VectorXd::Zero(dim);
+    for (const auto& q : draws_)
+      mean += q;
+    mean /= num_draws;
+    Eigen::VectorXd sd = var.array().sqrt();
+    Eigen::MatrixXd z(dim, num_draws);
+    for (Eigen::Index j = 0; j < num_draws; ++j)
+      z.col(j) = (draws_[j] - mean).cwiseQuotient(sd);
+    z /= std::sqrt(num_draws - 1.0);
+
+    // Eigenvalues are in increasing order; eigenvectors of the Gram
+    // matrix map to those of the covariance through z
+    const bool use_gram = num_draws < dim;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(
+        use_gram ? Eigen::MatrixXd(z.transpose() * z)
+                 : Eigen::MatrixXd(z * z.transpose()));
+    if (eigen.info() != Eigen::Success || !eigen.eigenvalues().allFinite())
+      throw std::runtime_error(
+          "Numerical overflow in metric adaptation. "
+          "The eigendecomposition of the sample covariance failed.");
+
+    const Eigen::Index size = eigen.eigenvalues().size();
+    int k = 0;
+    while (k < rank_ && k < size && eigen.eigenvalues()(size - 1 - k) > 1.0)
+      ++k;
+    if (k == 0)
+      return;
+
+    const double shrink = n / (n + 5.0);
+    const double floor = 1e-3 * (5.0 / (n + 5.0));
+    lowrank.resize(dim, k);
+    for (int j = 0; j < k; ++j) {
+      const double sigma2 = eigen.eigenvalues()(size - 1 - j);
+      Eigen::VectorXd u = eigen.eigenvectors().col(size - 1 - j);
+      if (use_gram)
+        u = z * u / std::sqrt(sigma2);
+      lowrank.col(j) = std::sqrt(shrink * sigma2) * sd.cwiseProduct(u);
+    }
+    var = (var - lowrank.rowwise().squaredNorm()).cwiseMax(floor);
+  }
+
+  stan::math::welford_var_estimator estimator_;
+  std::vector<Eigen::VectorXd> draws_;
+  int rank_;
+};
+
+}  // namespace mcmc
+
+}  // namespace stan
+#endif
@@ -0,0 +1,230 @@
+#ifndef STAN_MCMC_MAPPED_CHAINS_HPP
+#define STAN_MCMC_MAPPED_CHAINS_HPP
+
+#include <stan/io/stan_binary_mapping.hpp>
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <cmath>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Out-of-core counterpart of <code>chains</code> for runs too large to
+ * hold in memory.  Each chain is a file in the binary draws format,
+ * which is memory mapped rather than read, so the draws stay on disk
+ * and only the columns being summarized are paged in.  The accessors
+ * and diagnostics match those of <code>chains</code>; the samples of a
+ * parameter are copied out of the mappings when they are requested.
+ */
+class mapped_chains {
+ public:
+  /**
+   * Map one chain per file.
+   *
+   * @param[in] file_names names of the files in the binary draws format
+   * @param[in, out] out stream for warnings, may be null
+   * @throw std::invalid_argument if there are no files, a file cannot
+   * be mapped or is not in the binary draws format, or the headers of
+   * the files differ
+   */
+  explicit mapped_chains(const std::vector<std::string>& file_names,
+                         std::ostream* out = nullptr) {
+    if (file_names.empty())
+      throw std::invalid_argument("mapped_chains: no files");
+    files_.reserve(file_names.size());
+    for (const auto& file_name : file_names) {
+      files_.emplace_back(file_name, out);
+      if (files_.back().header() != files_.front().header())
+        throw std::invalid_argument("mapped_chains: header of " + file_name
+                                    + " does not match chains");
+    }
+    warmup_ = Eigen::VectorXi::Zero(files_.size());
+  }
+
+  int num_chains() const { return files_.size(); }
+
+  int num_params() const { return param_names().size(); }
+
+  const std::vector<std::string>& param_names() const {
+    return files_.front().header();
+  }
+
+  const std::string& param_name(int j) const { return param_names()[j]; }
+
+  int index(const std::string& name) const {
+    for (int i = 0; i < num_params(); i++)
+      if (param_names()[i] == name)
+        return i;
+    return -1;
+  }
+
+  void set_warmup(const int chain, const int warmup) {
+    warmup_(chain) = warmup;
+  }
+
+  void set_warmup(const int warmup) { warmup_.setConstant(warmup); }
+
+  int warmup(const int chain) const { return warmup_(chain); }
+
+  int num_samples(const int chain) const { return files_[chain].num_rows(); }
+
+  int num_samples() const {
+    int n = 0;
+    for (int chain = 0; chain < num_chains(); chain++)
+      n += num_samples(chain);
+    return n;
+  }
+
+  int num_kept_samples(const int chain) const {
+    return num_samples(chain) - warmup(chain);
+  }
+
+  int num_kept_samples() const {
+    int n = 0;
+    for (int chain = 0; chain < num_chains(); chain++)
+      n += num_kept_samples(chain);
+    return n;
+  }
+
+  Eigen::VectorXd samples(const int chain, const int index) const {
+    Eigen::VectorXd s(num_kept_samples(chain));
+    files_[chain].read_column(index, warmup(chain), s.size(), s.data());
+    return s;
+  }
+
+  Eigen::VectorXd samples(const int index) const {
+    Eigen::VectorXd s(num_kept_samples());
+    int start = 0;
+    for (int chain = 0; chain < num_chains(); chain++) {
+      int n = num_kept_samples(chain);
+      files_[chain].read_column(index, warmup(chain), n, s.data() + start);
+      start += n;
+    }
+    return s;
+  }
+
+  Eigen::VectorXd samples(const int chain, const std::string& name) const {
+    return samples(chain, index(name));
+  }
+
+  Eigen::VectorXd samples(const std::string& name) const {
+    return samples(index(name));
+  }
+
+  double mean(const int chain, const int index) const {
+    return mean(samples(chain, index));
+  }
+
+  double mean(const int index) const { return mean(samples(index)); }
+
+  double mean(const std::string& name) const { return mean(index(name)); }
+
+  double sd(const int chain, const int index) const {
+    return std::sqrt(variance(chain, index));
+  }
+
+  double sd(const int index) const { return std::sqrt(variance(index)); }
+
+  double sd(const std::string& name) const { return sd(index(name)); }
+
+  double variance(const int chain, const int index) const {
+    return variance(samples(chain, index));
+  }
+
+  double variance(const int index) const { return variance(samples(index)); }
+
+  double variance(const std::string& name) const {
+    return variance(index(name));
+  }
+
+  double effective_sample_size(const int index) const {
+    std::vector<Eigen::VectorXd> draws = chain_samples(index);
+    return analyze::compute_effective_sample_size(pointers(draws),
+                                                  sizes(draws));
+  }
+
+  double effective_sample_size(const std::string& name) const {
+    return effective_sample_size(index(name));
+  }
+
+  double split_effective_sample_size(const int index) const {
+    std::vector<Eigen::VectorXd> draws = chain_samples(index);
+    return analyze::compute_split_effective_sample_size(pointers(draws),
+                                                        sizes(draws));
+  }
+
+  double split_effective_sample_size(const std::string& name) const {
+    return split_effective_sample_size(index(name));
+  }
+
+  std::pair<double, double> split_potential_scale_reduction_rank(
+      const int index) const {
+    std::vector<Eigen::VectorXd> draws = chain_samples(index);
+    return analyze::compute_split_potential_scale_reduction_rank(
+        pointers(draws), sizes(draws));
+  }
+
+  std::pair<double, double> split_potential_scale_reduction_rank(
+      const std::string& name) const {
+    return split_potential_scale_reduction_rank(index(name));
+  }
+
+  double split_potential_scale_reduction(const int index) const {
+    std::vector<Eigen::VectorXd> draws = chain_samples(index);
+    return analyze::compute_split_potential_scale_reduction(pointers(draws),
+                                                            sizes(draws));
+  }
+
+  double split_potential_scale_reduction(const std::string& name) const {
+    return split_potential_scale_reduction(index(name));
+  }
+
+ private:
+  std::vector<io::stan_binary_mapping> files_;
+  Eigen::VectorXi warmup_;
+
+  static double mean(const Eigen::VectorXd& x) {
+    return (x.array() / x.size()).sum();
+  }
+
+  static double variance(const Eigen::VectorXd& x) {
+    double m = mean(x);
+    return ((x.array() - m) / std::sqrt((x.size() - 1.0))).square().sum();
+  }
+
+  /**
+   * Return the kept samples of a parameter in every chain.
+   */
+  std::vector<Eigen::VectorXd> chain_samples(const int index) const {
+    std::vector<Eigen::VectorXd> draws;
+    draws.reserve(num_chains());
+    for (int chain = 0; chain < num_chains(); ++chain)
+      draws.push_back(samples(chain, index));
+    return draws;
+  }
+
+  static std::vector<const double*> pointers(
+      const std::vector<Eigen::VectorXd>& draws) {
+    std::vector<const double*> p;
+    for (const auto& d : draws)
+      p.push_back(d.data());
+    return p;
+  }
+
+  static std::vector<size_t> sizes(const std::vector<Eigen::VectorXd>& draws) {
+    std::vector<size_t> n;
+    for (const auto& d : draws)
+      n.push_back(d.size());
+    return n;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,80 @@
+#ifndef STAN_MCMC_MPI_CHAIN_REDUCER_HPP
+#define STAN_MCMC_MPI_CHAIN_REDUCER_HPP
+
+#ifdef STAN_MPI
+
+#include <stan/math/prim.hpp>
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Reduction over the processes of an MPI communicator that share a
+ * pooled warmup, each running a subset of the chains.  Sums are
+ * computed with an all-reduce, so every process receives the same
+ * pooled values and takes the same decisions.
+ *
+ * See <code>local_chain_reducer</code> for the interface.
+ */
+class mpi_chain_reducer {
+ public:
+  /**
+   * @param communicator processes running the chains
+   */
+  explicit mpi_chain_reducer(const boost::mpi::communicator& communicator)
+      : communicator_(communicator) {}
+
+  void sum(double& x) const {
+    double local = x;
+    boost::mpi::all_reduce(communicator_, local, x, std::plus<double>());
+  }
+
+  template <typename Derived>
+  void sum(Eigen::MatrixBase<Derived>& x) const {
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> local = x;
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> total(x.rows(),
+                                                                x.cols());
+    boost::mpi::all_reduce(communicator_, local.data(),
+                           static_cast<int>(local.size()), total.data(),
+                           std::plus<double>());
+    x = total;
+  }
+
+  size_t chain_offset(size_t num_chains) const {
+    return boost::mpi::scan(communicator_, num_chains, std::plus<size_t>())
+           - num_chains;
+  }
+
+  /**
+   * Return the first chain and the number of chains this process runs
+   * when the chains are split as evenly as possible over the processes
+   * of the communicator, in rank order.
+   *
+   * @param communicator processes running the chains
+   * @param num_chains total number of chains
+   * @return offset of the first chain of this process and its number of
+   *   chains
+   */
+  static std::pair<size_t, size_t> partition(
+      const boost::mpi::communicator& communicator, size_t num_chains) {
+    size_t size = communicator.size();
+    size_t rank = communicator.rank();
+    size_t begin = num_chains * rank / size;
+    size_t end = num_chains * (rank + 1) / size;
+    return {begin, end - begin};
+  }
+
+ private:
+  boost::mpi::communicator communicator_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+#endif
+#endif
@@ -0,0 +1,143 @@
+#ifndef STAN_MCMC_REPLICA_EXCHANGE_HPP
+#define STAN_MCMC_REPLICA_EXCHANGE_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Swap moves of parallel tempering between replicas targeting the
+ * densities of a ladder of inverse temperatures along the geometric
+ * path of <code>tempered_model</code>,
+ *
+ * <code>log p_beta(q) = beta * log p(q) + (1 - beta) * log r(q)</code>.
+ *
+ * The ladder starts at 1, the posterior, and decreases strictly to a
+ * last inverse temperature of at least 0, the reference.  A round of
+ * swaps proposes to exchange the states of the neighbouring replicas
+ * <code>(k, k + 1)</code> for every <code>k</code> of the same parity,
+ * even in one round and odd in the next, so that states travel along
+ * the ladder without reversing at every round.  A proposal is accepted
+ * with probability
+ *
+ * <code>min(1, exp((beta_k - beta_{k+1})
+ *   * (L(q_{k+1}) - L(q_k))))</code>,
+ *
+ * where <code>L = log p - log r</code> is the log density ratio of
+ * <code>tempered_model::log_density_ratio</code>, which leaves the
+ * tempered density of every replica invariant.
+ */
+class replica_exchange {
+ public:
+  /**
+   * @param inverse_temperatures ladder of inverse temperatures
+   * @throw std::invalid_argument if the ladder is not valid
+   */
+  explicit replica_exchange(const std::vector<double>& inverse_temperatures)
+      : betas_(inverse_temperatures),
+        parity_(0),
+        num_proposed_(inverse_temperatures.size(), 0),
+        num_accepted_(inverse_temperatures.size(), 0) {
+    if (!is_valid_ladder(betas_))
+      throw std::invalid_argument(
+          "replica_exchange: inverse temperatures must decrease strictly "
+          "from 1 to no less than 0");
+  }
+
+  /**
+   * Return true if the inverse temperatures start at 1 and decrease
+   * strictly to no less than 0.
+   *
+   * @param inverse_temperatures ladder of inverse temperatures
+   */
+  static bool is_valid_ladder(const std::vector<double>& inverse_temperatures) {
+    if (inverse_temperatures.empty() || inverse_temperatures[0] != 1)
+      return false;
+    for (size_t k = 1; k < inverse_temperatures.size(); ++k)
+      if (!(inverse_temperatures[k] < inverse_temperatures[k - 1]
+            && inverse_temperatures[k] >= 0))
+        return false;
+    return true;
+  }
+
+  size_t num_replicas() const noexcept { return betas_.size(); }
+
+  double inverse_temperature(size_t k) const { return betas_[k]; }
+
+  /**
+   * Make a round of swap proposals, exchanging the accepted states and
+   * their log density ratios.  A uniform draw is taken for every
+   * proposal, accepted or not.
+   *
+   * @tparam RNG type of random number generator
+   * @param[in,out] states state of each replica
+   * @param[in,out] log_ratio log density ratio of the state of each
+   *   replica, or negative infinity where it cannot be evaluated
+   * @param[in,out] rng random number generator
+   */
+  template <class RNG>
+  void exchange(std::vector<sample>& states, Eigen::VectorXd& log_ratio,
+                RNG& rng) {
+    boost::uniform_01<RNG&> uniform(rng);
+    for (size_t k = parity_; k + 1 < betas_.size(); k += 2) {
+      ++num_proposed_[k];
+      // NaN, from two states that cannot be evaluated, is rejected
+      const double log_accept
+          = (betas_[k] - betas_[k + 1]) * (log_ratio(k + 1) - log_ratio(k));
+      if (std::log(uniform()) < log_accept) {
+        std::swap(states[k], states[k + 1]);
+        std::swap(log_ratio(k), log_ratio(k + 1));
+        ++num_accepted_[k];
+      }
+    }
+    parity_ = 1 - parity_;
+  }
+
+  /**
+   * Return the number of swaps proposed between replicas
+   * <code>k</code> and <code>k + 1</code>.
+   */
+  long num_proposed(size_t k) const { return num_proposed_[k]; }
+
+  /**
+   * Return the number of swaps accepted between replicas
+   * <code>k</code> and <code>k + 1</code>.
+   */
+  long num_accepted(size_t k) const { return num_accepted_[k]; }
+
+  /**
+   * Return the fraction of the swaps proposed between replicas
+   * <code>k</code> and <code>k + 1</code> that were accepted, or NaN
+   * if none was proposed.
+   */
+  double swap_rate(size_t k) const {
+    if (num_proposed_[k] == 0)
+      return std::numeric_limits<double>::quiet_NaN();
+    return static_cast<double>(num_accepted_[k]) / num_proposed_[k];
+  }
+
+  void reset_counters() {
+    std::fill(num_proposed_.begin(), num_proposed_.end(), 0);
+    std::fill(num_accepted_.begin(), num_accepted_.end(), 0);
+  }
+
+ private:
+  std::vector<double> betas_;
+  size_t parity_;
+  std::vector<long> num_proposed_;
+  std::vector<long> num_accepted_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
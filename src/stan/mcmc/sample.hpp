@@ -35,6 +35,14 @@ class sample {
 
   const Eigen::VectorXd& cont_params() const { return cont_params_; }
 
+  /**
+   * Exchange the continuous parameters with the specified vector, so
+   * that their storage can be reused for another draw.
+   *
+   * @param[in, out] q vector to exchange with
+   */
+  void swap_cont_params(Eigen::VectorXd& q) { cont_params_.swap(q); }
+
   inline double log_prob() const { return log_prob_; }
 
   inline double accept_stat() const { return accept_stat_; }
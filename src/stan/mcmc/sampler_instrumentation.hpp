@@ -0,0 +1,160 @@
+#ifndef STAN_MCMC_SAMPLER_INSTRUMENTATION_HPP
+#define STAN_MCMC_SAMPLER_INSTRUMENTATION_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Counters and timings of the work done by a sampler over a sequence
+ * of transitions, typically one phase (warmup or sampling) of a chain.
+ *
+ * The sampler adds its own share after each transition through
+ * base_mcmc::record_instrumentation; the caller running the
+ * transitions adds the transition, output and adaptation times.  All
+ * times are wall-clock seconds.  The gradient time is part of the
+ * transition time, and so is the adaptation time of adaptive samplers,
+ * which also includes any gradients evaluated while the step size is
+ * reinitialized.
+ */
+class sampler_instrumentation {
+ public:
+  sampler_instrumentation() { reset(); }
+
+  /**
+   * Number of transitions
+   */
+  std::size_t num_transitions;
+
+  /**
+   * Number of model gradient evaluations
+   */
+  std::size_t num_gradient_evaluations;
+
+  /**
+   * Number of leapfrog steps taken by the integrator
+   */
+  std::size_t num_leapfrog_steps;
+
+  /**
+   * Time spent in transitions
+   */
+  double transition_time;
+
+  /**
+   * Time spent evaluating the log density and its gradient
+   */
+  double gradient_time;
+
+  /**
+   * Time spent writing draws and diagnostics, including write_array
+   */
+  double output_time;
+
+  /**
+   * Time spent updating the adaptation
+   */
+  double adaptation_time;
+
+  /**
+   * Number of transitions that reached each tree depth, indexed by
+   * depth; empty for samplers that do not build trees
+   */
+  std::vector<int> tree_depth_histogram;
+
+  /**
+   * Largest reverse-mode tape of a gradient, in bytes of the autodiff
+   * arena blocks in use
+   */
+  std::size_t peak_tape_bytes;
+
+  /**
+   * Largest number of vars on the tape of a gradient
+   */
+  std::size_t peak_tape_vars;
+
+  /**
+   * Largest number of bytes of working vectors the sampler advised to
+   * be backed with transparent huge pages; zero unless enabled
+   */
+  std::size_t huge_page_bytes;
+
+  void reset() {
+    num_transitions = 0;
+    num_gradient_evaluations = 0;
+    num_leapfrog_steps = 0;
+    transition_time = 0;
+    gradient_time = 0;
+    output_time = 0;
+    adaptation_time = 0;
+    tree_depth_histogram.clear();
+    peak_tape_bytes = 0;
+    peak_tape_vars = 0;
+    huge_page_bytes = 0;
+  }
+
+  /**
+   * Count one transition at the given tree depth.
+   *
+   * @param depth tree depth of the transition, ignored if negative
+   */
+  void add_tree_depth(int depth) {
+    if (depth < 0)
+      return;
+    if (tree_depth_histogram.size() <= static_cast<std::size_t>(depth))
+      tree_depth_histogram.resize(depth + 1, 0);
+    ++tree_depth_histogram[depth];
+  }
+
+  /**
+   * Keep the larger of the recorded and the specified tape sizes.
+   *
+   * @param bytes bytes of a tape
+   * @param vars number of vars of a tape
+   */
+  void add_tape_usage(std::size_t bytes, std::size_t vars) {
+    peak_tape_bytes = bytes > peak_tape_bytes ? bytes : peak_tape_bytes;
+    peak_tape_vars = vars > peak_tape_vars ? vars : peak_tape_vars;
+  }
+
+  /**
+   * Keep the larger of the recorded and the specified bytes backed
+   * with huge pages.
+   *
+   * @param bytes bytes advised to be backed with huge pages
+   */
+  void add_huge_page_usage(std::size_t bytes) {
+    huge_page_bytes = bytes > huge_page_bytes ? bytes : huge_page_bytes;
+  }
+
+  /**
+   * Write the counters and timings as a record.
+   *
+   * @param writer structured writer receiving the record
+   * @param key name of the record
+   */
+  void write(callbacks::structured_writer& writer,
+             const std::string& key) const {
+    writer.begin_record(key);
+    writer.write("transitions", num_transitions);
+    writer.write("gradient_evaluations", num_gradient_evaluations);
+    writer.write("leapfrog_steps", num_leapfrog_steps);
+    writer.write("transition_time", transition_time);
+    writer.write("gradient_time", gradient_time);
+    writer.write("output_time", output_time);
+    writer.write("adaptation_time", adaptation_time);
+    writer.write("tree_depth_histogram", tree_depth_histogram);
+    writer.write("peak_tape_bytes", peak_tape_bytes);
+    writer.write("peak_tape_vars", peak_tape_vars);
+    writer.write("huge_page_bytes", huge_page_bytes);
+    writer.end_record();
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,125 @@
+#ifndef STAN_MCMC_SMC_TEMPERED_MODEL_HPP
+#define STAN_MCMC_SMC_TEMPERED_MODEL_HPP
+
+#include <stan/math/rev.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Geometric path between a reference density and the density of a
+ * model on the unconstrained scale,
+ *
+ * <code>log p_beta(q) = beta * log p(q) + (1 - beta) * log r(q)</code>,
+ *
+ * where the reference <code>r</code> is a normal density with mean zero
+ * and the specified scale in every coordinate.  The adaptor has the
+ * <code>num_params_r</code> and <code>log_prob</code> members the
+ * Hamiltonians use, so that the HMC samplers of a model move states
+ * targeting any density along the path, as the mutation kernel of
+ * sequential Monte Carlo.
+ *
+ * The reference is normalized and the model density includes its
+ * constants and the Jacobian of the transform, so that the ratio of
+ * the normalizing constants at <code>beta = 1</code> and
+ * <code>beta = 0</code> is the marginal likelihood of the model.
+ *
+ * @tparam Model Model class
+ */
+template <class Model>
+class tempered_model {
+ public:
+  /**
+   * @param model model at the end of the path
+   * @param scale standard deviation of the reference, positive
+   */
+  tempered_model(const Model& model, double scale)
+      : model_(model), scale_(scale), beta_(0) {}
+
+  size_t num_params_r() const { return model_.num_params_r(); }
+
+  double get_beta() const noexcept { return beta_; }
+
+  void set_beta(double beta) { beta_ = beta; }
+
+  const Model& model() const noexcept { return model_; }
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = nullptr) const {
+    if (beta_ == 0)
+      return reference_log_prob<propto>(params_r);
+    T lp = model_.template log_prob<propto, jacobian>(params_r, msgs);
+    if (beta_ == 1)
+      return lp;
+    return beta_ * lp + (1 - beta_) * reference_log_prob<propto>(params_r);
+  }
+
+  /**
+   * Return the log density of the reference at the specified point.
+   *
+   * @tparam propto true to drop the constant terms
+   * @tparam T scalar type
+   * @param params_r unconstrained parameters
+   */
+  template <bool propto, typename T>
+  T reference_log_prob(const Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r)
+      const {
+    T lp = -0.5 * stan::math::dot_self(params_r) / (scale_ * scale_);
+    if (!propto)
+      lp -= params_r.size() * (std::log(scale_) + 0.5 * std::log(2 * M_PI));
+    return lp;
+  }
+
+  /**
+   * Return the log ratio of the normalized model density to the
+   * reference density at the specified point, the derivative of the
+   * log tempered density with respect to <code>beta</code>, or negative
+   * infinity if the model density cannot be evaluated there.
+   *
+   * @param params_r unconstrained parameters
+   * @param msgs stream for messages of the model
+   */
+  double log_density_ratio(Eigen::VectorXd& params_r,
+                           std::ostream* msgs = nullptr) const {
+    double lp;
+    try {
+      lp = model_.template log_prob<false, true>(params_r, msgs);
+    } catch (const std::domain_error&) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    lp -= reference_log_prob<false>(params_r);
+    return std::isnan(lp) ? -std::numeric_limits<double>::infinity() : lp;
+  }
+
+  /**
+   * Draw a point from the reference.
+   *
+   * @tparam RNG type of random number generator
+   * @param[in,out] rng random number generator
+   * @param[out] params_r unconstrained parameters
+   */
+  template <class RNG>
+  void sample_reference(RNG& rng, Eigen::VectorXd& params_r) const {
+    boost::variate_generator<RNG&, boost::normal_distribution<> > rand_gaus(
+        rng, boost::normal_distribution<>(0, scale_));
+    params_r.resize(num_params_r());
+    for (Eigen::Index n = 0; n < params_r.size(); ++n)
+      params_r(n) = rand_gaus();
+  }
+
+ private:
+  const Model& model_;
+  double scale_;
+  double beta_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,116 @@
+#ifndef STAN_MCMC_SMC_TEMPERING_HPP
+#define STAN_MCMC_SMC_TEMPERING_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Return the effective sample size of particles with the specified
+ * unnormalized log weights, zero if no weight is positive.
+ *
+ * @param log_weights log weights, possibly negative infinity
+ * @return effective sample size between 0 and the number of particles
+ */
+inline double effective_sample_size(const Eigen::VectorXd& log_weights) {
+  const double max = log_weights.maxCoeff();
+  if (!std::isfinite(max))
+    return 0;
+  const Eigen::ArrayXd weights = (log_weights.array() - max).exp();
+  const double sum = weights.sum();
+  return sum * sum / weights.square().sum();
+}
+
+/**
+ * Return the log of the mean of the exponentials of the specified
+ * values, negative infinity if they are all negative infinity.
+ *
+ * @param log_weights values
+ */
+inline double log_mean_exp(const Eigen::VectorXd& log_weights) {
+  const double max = log_weights.maxCoeff();
+  if (!std::isfinite(max))
+    return max;
+  return max
+         + std::log((log_weights.array() - max).exp().sum()
+                    / log_weights.size());
+}
+
+/**
+ * Return the next inverse temperature of particles with equal weights,
+ * the largest one up to 1 at which reweighting them leaves the
+ * specified effective sample size, found by bisection.  The weights of
+ * the particles at the next inverse temperature <code>b</code> are
+ * <code>exp((b - beta) * log_ratio)</code>.
+ *
+ * @param log_ratio derivative of the log tempered density of every
+ * particle with respect to the inverse temperature
+ * @param beta current inverse temperature, less than 1
+ * @param target_ess effective sample size to leave
+ * @return next inverse temperature, greater than beta
+ */
+inline double next_temperature(const Eigen::VectorXd& log_ratio, double beta,
+                               double target_ess) {
+  auto ess = [&](double next) {
+    return effective_sample_size((next - beta) * log_ratio);
+  };
+  if (ess(1) >= target_ess)
+    return 1;
+  double lower = beta;
+  double upper = 1;
+  for (int n = 0; n < 64 && lower < upper; ++n) {
+    const double middle = 0.5 * (lower + upper);
+    if (middle == lower || middle == upper)
+      break;
+    if (ess(middle) >= target_ess)
+      lower = middle;
+    else
+      upper = middle;
+  }
+  return lower > beta ? lower : upper;
+}
+
+/**
+ * Systematic resampling of particles with the specified unnormalized
+ * log weights: output particle <code>j</code> is the copy of the
+ * particle whose interval of cumulative normalized weights holds
+ * <code>(u + j) / n</code>.  The ancestors are found in parallel.
+ *
+ * @param log_weights log weights, at least one finite
+ * @param u uniform random number in [0, 1)
+ * @param[out] ancestors index of the particle copied to every output
+ * particle, in increasing order
+ */
+inline void systematic_resample(const Eigen::VectorXd& log_weights, double u,
+                                std::vector<Eigen::Index>& ancestors) {
+  const Eigen::Index n = log_weights.size();
+  const double max = log_weights.maxCoeff();
+  std::vector<double> cumulative(n);
+  for (Eigen::Index i = 0; i < n; ++i)
+    cumulative[i] = std::exp(log_weights(i) - max);
+  std::partial_sum(cumulative.begin(), cumulative.end(), cumulative.begin());
+  const double total = cumulative.back();
+  ancestors.resize(n);
+  tbb::parallel_for(tbb::blocked_range<Eigen::Index>(0, n),
+                    [&](const tbb::blocked_range<Eigen::Index>& r) {
+                      for (Eigen::Index j = r.begin(); j < r.end(); ++j) {
+                        const double point = total * (u + j) / n;
+                        const Eigen::Index i
+                            = std::upper_bound(cumulative.begin(),
+                                               cumulative.end(), point)
+                              - cumulative.begin();
+                        ancestors[j] = std::min(i, n - 1);
+                      }
+                    });
+}
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,172 @@
+#ifndef STAN_MCMC_SPARSE_ADAPTATION_HPP
+#define STAN_MCMC_SPARSE_ADAPTATION_HPP
+
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/windowed_adaptation.hpp>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+
+namespace mcmc {
+
+/**
+ * Return the sparsity pattern of a banded matrix, as the rows of the
+ * nonzeros of each column.
+ *
+ * @param n number of rows and columns
+ * @param bandwidth number of nonzero diagonals on each side of the
+ * main diagonal
+ */
+inline std::vector<std::vector<int>> banded_pattern(int n, int bandwidth) {
+  std::vector<std::vector<int>> pattern(n);
+  for (int j = 0; j < n; ++j)
+    for (int i = std::max(0, j - bandwidth);
+         i <= std::min(n - 1, j + bandwidth); ++i)
+      pattern[j].push_back(i);
+  return pattern;
+}
+
+/**
+ * Windowed adaptation of a sparse mass matrix, the precision of the
+ * draws, restricted to a sparsity pattern.
+ *
+ * At the end of each window every parameter is regressed on the
+ * parameters that precede it and are its neighbors in the pattern,
+ * using the sample covariance of the draws of the window restricted to
+ * those parameters and regularized like the dense covariance of
+ * covar_adaptation.  With the regression coefficients in the strictly
+ * lower triangular B and the residual variances in D, the mass matrix
+ * is (I - B)^T D^-1 (I - B), which is positive definite by
+ * construction.  It has the nonzeros of the pattern, plus those
+ * between two preceding neighbors of a common parameter, so a banded
+ * pattern gives a mass matrix with the same band.  A window of n draws
+ * costs O(n k^2 + k^3) per parameter with k neighbors, and no N by N
+ * matrix is formed.
+ */
+class sparse_adaptation : public windowed_adaptation {
+ public:
+  /**
+   * @param n number of dimensions
+   * @param pattern rows of the nonzeros of each column of the mass
+   * matrix, zero-based; it is made symmetric and the diagonal is
+   * always included
+   * @throw std::invalid_argument if the pattern does not have n columns
+   * or has rows outside of [0, n)
+   */
+  sparse_adaptation(int n, const std::vector<std::vector<int>>& pattern)
+      : windowed_adaptation("sparse precision"), neighbors_(n) {
+    if (pattern.size() != static_cast<size_t>(n))
+      throw std::invalid_argument(
+          "Sparsity pattern of the metric has " + std::to_string(pattern.size())
+          + " columns, expecting " + std::to_string(n) + ".");
+    for (int j = 0; j < n; ++j) {
+      for (int i : pattern[j]) {
+        if (i < 0 || i >= n)
+          throw std::invalid_argument(
+              "Sparsity pattern of the metric has a row out of range.");
+        if (i < j)
+          neighbors_[j].push_back(i);
+        else if (i > j)
+          neighbors_[i].push_back(j);
+      }
+    }
+    for (auto& rows : neighbors_) {
+      std::sort(rows.begin(), rows.end());
+      rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    }
+  }
+
+  bool learn_metric(Eigen::SparseMatrix<double>& metric,
+                    const Eigen::VectorXd& q) {
+    if (adaptation_window())
+      draws_.push_back(q);
+
+    if (end_adaptation_window()) {
+      compute_next_window();
+
+      learn_precision(metric);
+
+      draws_.clear();
+
+      ++adapt_window_counter_;
+      return true;
+    }
+
+    ++adapt_window_counter_;
+    return false;
+  }
+
+ protected:
+  /**
+   * Compute the mass matrix from the draws of the window.
+   */
+  void learn_precision(Eigen::SparseMatrix<double>& metric) {
+    const int dim = neighbors_.size();
+    const Eigen::Index num_draws = draws_.size();
+    Eigen::VectorXd mean = Eigen::VectorXd::Zero(dim);
+    for (const auto& q : draws_)
+      mean += q;
+    if (num_draws > 0)
+      mean /= num_draws;
+    Eigen::MatrixXd x(dim, num_draws);
+    for (Eigen::Index j = 0; j < num_draws; ++j)
+      x.col(j) = draws_[j] - mean;
+
+    const double n = num_draws;
+    const double shrink = n / (n + 5.0) / std::max(n - 1.0, 1.0);
+    const double floor = 1e-3 * (5.0 / (n + 5.0));
+
+    std::vector<Eigen::Triplet<double>> factor;
+    Eigen::VectorXd inv_resid_var(dim);
+    for (int i = 0; i < dim; ++i) {
+      const std::vector<int>& parents = neighbors_[i];
+      const int k = parents.size();
+      Eigen::MatrixXd local(k + 1, num_draws);
+      for (int j = 0; j < k; ++j)
+        local.row(j) = x.row(parents[j]);
+      local.row(k) = x.row(i);
+      Eigen::MatrixXd covar = shrink * local * local.transpose();
+      covar.diagonal().array() += floor;
+
+      double resid_var = covar(k, k);
+      factor.emplace_back(i, i, 1.0);
+      if (k > 0) {
+        Eigen::VectorXd coef
+            = covar.topLeftCorner(k, k).llt().solve(covar.col(k).head(k));
+        resid_var -= covar.col(k).head(k).dot(coef);
+        for (int j = 0; j < k; ++j)
+          factor.emplace_back(i, parents[j], -coef(j));
+      }
+      inv_resid_var(i) = 1.0 / resid_var;
+    }
+
+    Eigen::SparseMatrix<double> lower(dim, dim);
+    lower.setFromTriplets(factor.begin(), factor.end());
+    Eigen::SparseMatrix<double> scaled = inv_resid_var.asDiagonal() * lower;
+    metric = Eigen::SparseMatrix<double>(lower.transpose()) * scaled;
+
+    if (!inv_resid_var.allFinite() || (inv_resid_var.array() <= 0).any()
+        || !Eigen::Map<const Eigen::VectorXd>(metric.valuePtr(),
+                                              metric.nonZeros())
+                .allFinite())
+      throw std::runtime_error(
+          "Numerical overflow in metric adaptation. "
+          "This occurs when the sampler encounters extreme values on the "
+          "unconstrained space; this may happen when the posterior density "
+          "function is too wide or improper. "
+          "There may be problems with your model specification.");
+  }
+
+  // Neighbors of each parameter in the pattern that precede it
+  std::vector<std::vector<int>> neighbors_;
+  std::vector<Eigen::VectorXd> draws_;
+};
+
+}  // namespace mcmc
+
+}  // namespace stan
+#endif
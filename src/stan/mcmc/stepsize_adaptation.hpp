@@ -2,6 +2,7 @@
 #define STAN_MCMC_STEPSIZE_ADAPTATION_HPP
 
 #include <stan/mcmc/base_adaptation.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
 #include <cmath>
 
 namespace stan {
@@ -46,6 +47,12 @@ class stepsize_adaptation : public base_adaptation {
 
   double get_t0() const noexcept { return t0_; }
 
+  /**
+   * Return the dual averaging estimate of the log step size, which
+   * complete_adaptation() exponentiates.
+   */
+  double get_x_bar() const noexcept { return x_bar_; }
+
   void restart() {
     counter_ = 0;
     s_bar_ = 0;
@@ -72,6 +79,38 @@ class stepsize_adaptation : public base_adaptation {
 
   void complete_adaptation(double& epsilon) { epsilon = std::exp(x_bar_); }
 
+  /**
+   * Write the dual averaging state and its parameters.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    writer.write(counter_);
+    writer.write(s_bar_);
+    writer.write(x_bar_);
+    writer.write(mu_);
+    writer.write(delta_);
+    writer.write(gamma_);
+    writer.write(kappa_);
+    writer.write(t0_);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().
+   *
+   * @param reader checkpoint reader
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    reader.read(counter_);
+    reader.read(s_bar_);
+    reader.read(x_bar_);
+    reader.read(mu_);
+    reader.read(delta_);
+    reader.read(gamma_);
+    reader.read(kappa_);
+    reader.read(t0_);
+  }
+
  protected:
   double counter_;  // Adaptation iteration
   double s_bar_;    // Moving average statistic
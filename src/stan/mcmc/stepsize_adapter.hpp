@@ -20,6 +20,28 @@ class stepsize_adapter : public base_adapter {
     return stepsize_adaptation_;
   }
 
+  /**
+   * Write the state of the adaptation.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_adaptation_checkpoint(checkpoint_writer& writer) const {
+    writer.write(adapt_flag_);
+    writer.write(adaptation_time_);
+    stepsize_adaptation_.write_checkpoint(writer);
+  }
+
+  /**
+   * Restore the state written by write_adaptation_checkpoint().
+   *
+   * @param reader checkpoint reader
+   */
+  void read_adaptation_checkpoint(checkpoint_reader& reader) {
+    reader.read(adapt_flag_);
+    reader.read(adaptation_time_);
+    stepsize_adaptation_.read_checkpoint(reader);
+  }
+
  protected:
   stepsize_adaptation stepsize_adaptation_;
 };
@@ -0,0 +1,42 @@
+#ifndef STAN_MCMC_STEPSIZE_SPARSE_ADAPTER_HPP
+#define STAN_MCMC_STEPSIZE_SPARSE_ADAPTER_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/base_adapter.hpp>
+#include <stan/mcmc/stepsize_adaptation.hpp>
+#include <stan/mcmc/sparse_adaptation.hpp>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+class stepsize_sparse_adapter : public base_adapter {
+ public:
+  stepsize_sparse_adapter(int n, const std::vector<std::vector<int>>& pattern)
+      : sparse_adaptation_(n, pattern) {}
+
+  stepsize_adaptation& get_stepsize_adaptation() {
+    return stepsize_adaptation_;
+  }
+
+  const stepsize_adaptation& get_stepsize_adaptation() const noexcept {
+    return stepsize_adaptation_;
+  }
+
+  sparse_adaptation& get_sparse_adaptation() { return sparse_adaptation_; }
+
+  void set_window_params(unsigned int num_warmup, unsigned int init_buffer,
+                         unsigned int term_buffer, unsigned int base_window,
+                         callbacks::logger& logger) {
+    sparse_adaptation_.set_window_params(num_warmup, init_buffer, term_buffer,
+                                         base_window, logger);
+  }
+
+ protected:
+  stepsize_adaptation stepsize_adaptation_;
+  sparse_adaptation sparse_adaptation_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+#endif
@@ -0,0 +1,201 @@
+#ifndef STAN_MCMC_TRACE_EVENTS_HPP
+#define STAN_MCMC_TRACE_EVENTS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+/**
+ * Timestamped event of a trace: the beginning ('B') or end ('E') of a
+ * scope, or an instant ('i').  The name must outlive the trace, which
+ * string literals do.
+ */
+struct trace_event {
+  const char* name;
+  char phase;
+  std::int64_t time_ns;
+};
+
+/**
+ * Ring buffer of the trace events of one thread.  Only the owning
+ * thread records events, without locking; when the buffer is full the
+ * oldest events are overwritten.  The events are read after the
+ * threads recording them are done, e.g. at the end of sampling.
+ */
+class trace_buffer {
+ public:
+  static constexpr std::size_t capacity = std::size_t(1) << 16;
+
+  explicit trace_buffer(int thread_id)
+      : thread_id_(thread_id), events_(capacity), count_(0) {}
+
+  void record(const char* name, char phase) noexcept {
+    const std::uint64_t n = count_.load(std::memory_order_relaxed);
+    trace_event& event = events_[n & (capacity - 1)];
+    event.name = name;
+    event.phase = phase;
+    event.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+    count_.store(n + 1, std::memory_order_release);
+  }
+
+  /**
+   * Apply the specified function to the events kept, oldest first.
+   */
+  template <class F>
+  void for_each(F&& f) const {
+    const std::uint64_t n = count_.load(std::memory_order_acquire);
+    for (std::uint64_t k = n > capacity ? n - capacity : 0; k < n; ++k)
+      f(events_[k & (capacity - 1)]);
+  }
+
+  /**
+   * Return the number of events kept.
+   */
+  std::size_t size() const noexcept {
+    const std::uint64_t n = count_.load(std::memory_order_acquire);
+    return n > capacity ? capacity : n;
+  }
+
+  void clear() noexcept { count_.store(0, std::memory_order_release); }
+
+  int thread_id() const noexcept { return thread_id_; }
+
+ private:
+  int thread_id_;
+  std::vector<trace_event> events_;
+  std::atomic<std::uint64_t> count_;
+};
+
+/**
+ * Process-wide set of the trace buffers of all threads.  A thread
+ * registers its buffer on its first event, under a lock; recording
+ * events afterwards does not lock.  The buffers live as long as the
+ * registry, so the events of threads that have exited can still be
+ * written.
+ */
+class trace_registry {
+ public:
+  static trace_registry& instance() {
+    static trace_registry registry;
+    return registry;
+  }
+
+  /**
+   * Return the trace buffer of the calling thread.
+   */
+  trace_buffer& local_buffer() {
+    thread_local trace_buffer* buffer = nullptr;
+    if (buffer == nullptr) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffers_.emplace_back(new trace_buffer(buffers_.size()));
+      buffer = buffers_.back().get();
+    }
+    return *buffer;
+  }
+
+  /**
+   * Discard the events of all threads, which must not be recording.
+   */
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffer : buffers_)
+      buffer->clear();
+  }
+
+  /**
+   * Write the events of all threads in the Chrome trace event format,
+   * which chrome://tracing and Perfetto display as a timeline with one
+   * track per thread.  The threads must not be recording.
+   *
+   * @param[in,out] o stream to write to
+   */
+  void write_json(std::ostream& o) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::ios_base::fmtflags flags = o.flags();
+    const std::streamsize precision = o.precision();
+    std::int64_t start = std::numeric_limits<std::int64_t>::max();
+    for (auto& buffer : buffers_)
+      buffer->for_each([&](const trace_event& event) {
+        start = event.time_ns < start ? event.time_ns : start;
+      });
+    o << "{\"traceEvents\":[";
+    bool first = true;
+    for (auto& buffer : buffers_) {
+      const int tid = buffer->thread_id();
+      buffer->for_each([&](const trace_event& event) {
+        o << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name
+          << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << std::fixed
+          << std::setprecision(3) << (event.time_ns - start) / 1000.0
+          << ",\"pid\":0,\"tid\":" << tid;
+        if (event.phase == 'i')
+          o << ",\"s\":\"t\"";
+        o << "}";
+        first = false;
+      });
+    }
+    o << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    o.flags(flags);
+    o.precision(precision);
+  }
+
+ private:
+  trace_registry() = default;
+  std::mutex mutex_;
+  std::deque<std::unique_ptr<trace_buffer>> buffers_;
+};
+
+/**
+ * Records the beginning of a scope in the trace of the calling thread
+ * on construction and its end on destruction.
+ */
+class trace_scope {
+ public:
+  explicit trace_scope(const char* name)
+      : name_(name), buffer_(trace_registry::instance().local_buffer()) {
+    buffer_.record(name_, 'B');
+  }
+
+  ~trace_scope() { buffer_.record(name_, 'E'); }
+
+  trace_scope(const trace_scope&) = delete;
+  trace_scope& operator=(const trace_scope&) = delete;
+
+ private:
+  const char* name_;
+  trace_buffer& buffer_;
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+/**
+ * Trace points of the samplers, recorded when compiled with
+ * <code>STAN_TRACE</code> defined and compiled out otherwise.  Write
+ * the trace with
+ * <code>stan::mcmc::trace_registry::instance().write_json(o)</code>.
+ */
+#define STAN_TRACE_CONCAT_(a, b) a##b
+#define STAN_TRACE_CONCAT(a, b) STAN_TRACE_CONCAT_(a, b)
+#ifdef STAN_TRACE
+#define STAN_TRACE_SCOPE(name) \
+  ::stan::mcmc::trace_scope STAN_TRACE_CONCAT(stan_trace_scope_, __LINE__)(name)
+#define STAN_TRACE_INSTANT(name) \
+  ::stan::mcmc::trace_registry::instance().local_buffer().record(name, 'i')
+#else
+#define STAN_TRACE_SCOPE(name) static_cast<void>(0)
+#define STAN_TRACE_INSTANT(name) static_cast<void>(0)
+#endif
+
+#endif
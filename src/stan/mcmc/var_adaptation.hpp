@@ -2,7 +2,10 @@
 #define STAN_MCMC_VAR_ADAPTATION_HPP
 
 #include <stan/math/prim.hpp>
+#include <stan/mcmc/block_welford_var_estimator.hpp>
+#include <stan/mcmc/chain_reducer.hpp>
 #include <stan/mcmc/windowed_adaptation.hpp>
+#include <cstddef>
 #include <vector>
 
 namespace stan {
@@ -12,7 +15,11 @@ namespace mcmc {
 class var_adaptation : public windowed_adaptation {
  public:
   explicit var_adaptation(int n)
-      : windowed_adaptation("variance"), estimator_(n) {}
+      : windowed_adaptation("variance"),
+        estimator_(n),
+        window_num_samples_(0),
+        window_mean_(Eigen::VectorXd::Zero(n)),
+        window_var_(Eigen::VectorXd::Zero(n)) {}
 
   bool learn_variance(Eigen::VectorXd& var, const Eigen::VectorXd& q) {
     if (adaptation_window())
@@ -23,17 +30,11 @@ class var_adaptation : public windowed_adaptation {
 
       estimator_.sample_variance(var);
 
-      double n = static_cast<double>(estimator_.num_samples());
-      var = (n / (n + 5.0)) * var
-            + 1e-3 * (5.0 / (n + 5.0)) * Eigen::VectorXd::Ones(var.size());
+      window_num_samples_ = estimator_.num_samples();
+      estimator_.sample_mean(window_mean_);
+      window_var_ = var;
 
-      if (!var.allFinite())
-        throw std::runtime_error(
-            "Numerical overflow in metric adaptation. "
-            "This occurs when the sampler encounters extreme values on the "
-            "unconstrained space; this may happen when the posterior density "
-            "function is too wide or improper. "
-            "There may be problems with your model specification.");
+      regularize(var, window_num_samples_);
 
       estimator_.restart();
 
@@ -45,8 +46,124 @@ class var_adaptation : public windowed_adaptation {
     return false;
   }
 
+  /**
+   * Set the variance to the regularized estimate a single estimator
+   * would have produced from the draws of the last completed window of
+   * every adaptation, combining their means and variances.  The
+   * adaptations must follow the same window schedule.
+   *
+   * @param[in,out] var pooled variance, unchanged if the windows hold
+   *   fewer than two draws in total
+   * @param adaptations adaptations to pool
+   * @throw std::runtime_error if the pooled variance is not finite
+   */
+  static void pool_windows(Eigen::VectorXd& var,
+                           const std::vector<var_adaptation*>& adaptations) {
+    pool_windows(var, adaptations, local_chain_reducer());
+  }
+
+  /**
+   * Set the variance to the estimate pooled over the last completed
+   * window of the adaptations of every process, reducing the moments
+   * with the specified reducer.
+   *
+   * @tparam Reducer type of the reduction over processes
+   * @param[in,out] var pooled variance, unchanged if the windows hold
+   *   fewer than two draws in total
+   * @param adaptations adaptations of this process to pool
+   * @param reducer reduction over the processes
+   * @throw std::runtime_error if the pooled variance is not finite
+   */
+  template <class Reducer>
+  static void pool_windows(Eigen::VectorXd& var,
+                           const std::vector<var_adaptation*>& adaptations,
+                           const Reducer& reducer) {
+    double n = 0;
+    Eigen::VectorXd mean = Eigen::VectorXd::Zero(var.size());
+    for (const var_adaptation* adaptation : adaptations) {
+      n += adaptation->window_num_samples_;
+      mean += adaptation->window_num_samples_ * adaptation->window_mean_;
+    }
+    reducer.sum(n);
+    reducer.sum(mean);
+    if (n < 2)
+      return;
+    mean /= n;
+
+    Eigen::VectorXd m2 = Eigen::VectorXd::Zero(var.size());
+    for (const var_adaptation* adaptation : adaptations) {
+      double n_i = adaptation->window_num_samples_;
+      if (n_i < 1)
+        continue;
+      m2 += (n_i - 1) * adaptation->window_var_
+            + n_i * (adaptation->window_mean_ - mean).array().square().matrix();
+    }
+    reducer.sum(m2);
+    var = m2 / (n - 1);
+    regularize(var, n);
+  }
+
+  /**
+   * Advise the storage of the estimator and of the moments of the last
+   * window to be backed with huge pages.
+   *
+   * @return number of bytes advised
+   */
+  std::size_t advise_huge_pages() {
+    return estimator_.advise_huge_pages()
+           + mcmc::advise_huge_pages(window_mean_)
+           + mcmc::advise_huge_pages(window_var_);
+  }
+
+  /**
+   * Write the window schedule, the variance estimator and the moments of
+   * the last completed window.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    windowed_adaptation::write_checkpoint(writer);
+    estimator_.write_checkpoint(writer);
+    writer.write(window_num_samples_);
+    writer.write(window_mean_);
+    writer.write(window_var_);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().
+   *
+   * @param reader checkpoint reader
+   * @throw std::runtime_error if the number of dimensions differs
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    const Eigen::Index n = window_mean_.size();
+    windowed_adaptation::read_checkpoint(reader);
+    estimator_.read_checkpoint(reader);
+    reader.read(window_num_samples_);
+    reader.read(window_mean_, n, 1);
+    reader.read(window_var_, n, 1);
+  }
+
  protected:
-  stan::math::welford_var_estimator estimator_;
+  block_welford_var_estimator estimator_;
+
+  // Size, mean and unregularized variance of the last completed window
+  double window_num_samples_;
+  Eigen::VectorXd window_mean_;
+  Eigen::VectorXd window_var_;
+
+  static void regularize(Eigen::VectorXd& var, double n) {
+    var = (n / (n + 5.0)) * var
+          + 1e-3 * (5.0 / (n + 5.0)) * Eigen::VectorXd::Ones(var.size());
+
+    if (!var.allFinite())
+      throw std::runtime_error(
+          "Numerical overflow in metric adaptation. "
+          "This occurs when the sampler encounters extreme values on the "
+          "unconstrained space; this may happen when the posterior density "
+          "function is too wide or improper. "
+          "There may be problems with your model specification.");
+  }
 };
 
 }  // namespace mcmc
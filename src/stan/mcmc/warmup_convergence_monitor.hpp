@@ -0,0 +1,141 @@
+#ifndef STAN_MCMC_WARMUP_CONVERGENCE_MONITOR_HPP
+#define STAN_MCMC_WARMUP_CONVERGENCE_MONITOR_HPP
+
+#include <stan/math/prim.hpp>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace stan {
+
+namespace mcmc {
+
+/**
+ * Watches the state of an adaptation at the end of each slow
+ * adaptation window and tells when it has stabilized, so that the
+ * remaining windows can be skipped.
+ *
+ * The adaptation is stable once, from one window to the next:
+ * <ul>
+ * <li>the relative change of the adapted metric, in Frobenius norm,
+ * is below the metric tolerance;</li>
+ * <li>the change of the dual averaging estimate of the log step size
+ * is below the step size tolerance;</li>
+ * <li>and the split potential scale reduction of the
+ * <code>lp__</code> draws of the window, comparing its two halves, is
+ * below the threshold, so the chain has stopped drifting.</li>
+ * </ul>
+ */
+class warmup_convergence_monitor {
+ public:
+  /**
+   * @param metric_tolerance maximum relative change of the metric
+   * @param stepsize_tolerance maximum change of the log step size
+   * @param max_lp_rhat maximum split potential scale reduction of
+   *   lp__ within a window
+   */
+  explicit warmup_convergence_monitor(double metric_tolerance = 0.1,
+                                      double stepsize_tolerance = 0.1,
+                                      double max_lp_rhat = 1.05)
+      : metric_tolerance_(metric_tolerance),
+        stepsize_tolerance_(stepsize_tolerance),
+        max_lp_rhat_(max_lp_rhat) {
+    restart();
+  }
+
+  void restart() {
+    num_windows_ = 0;
+    metric_change_ = std::numeric_limits<double>::infinity();
+    stepsize_change_ = std::numeric_limits<double>::infinity();
+    lp_rhat_ = std::numeric_limits<double>::infinity();
+  }
+
+  /**
+   * Record the state at the end of a slow adaptation window.
+   *
+   * @tparam Metric type of the metric, a vector or a matrix
+   * @param metric metric adapted from the draws of the window
+   * @param log_stepsize dual averaging estimate of the log step size
+   *   before the window closed
+   * @param window_lp lp__ of the draws of the window
+   * @return true if the adaptation is stable
+   */
+  template <typename Metric>
+  bool end_window(const Metric& metric, double log_stepsize,
+                  const std::vector<double>& window_lp) {
+    Eigen::Map<const Eigen::VectorXd> flat(metric.data(), metric.size());
+    if (num_windows_ > 0 && flat.size() == metric_.size()) {
+      double norm = metric_.norm();
+      metric_change_ = norm > 0 ? (flat - metric_).norm() / norm
+                                : std::numeric_limits<double>::infinity();
+      stepsize_change_ = std::fabs(log_stepsize - log_stepsize_);
+    }
+    metric_ = flat;
+    log_stepsize_ = log_stepsize;
+    lp_rhat_ = split_rhat(window_lp);
+    ++num_windows_;
+    return converged();
+  }
+
+  /**
+   * Return true if the last two windows met every criterion.
+   */
+  bool converged() const {
+    return num_windows_ > 1 && metric_change_ < metric_tolerance_
+           && stepsize_change_ < stepsize_tolerance_ && lp_rhat_ < max_lp_rhat_;
+  }
+
+  inline int num_windows() const noexcept { return num_windows_; }
+
+  inline double metric_change() const noexcept { return metric_change_; }
+
+  inline double stepsize_change() const noexcept { return stepsize_change_; }
+
+  inline double lp_rhat() const noexcept { return lp_rhat_; }
+
+ private:
+  /**
+   * Return the potential scale reduction of the two halves of the
+   * specified draws, ignoring the middle draw of an odd number, or
+   * infinity if there are fewer than four draws or no variation.
+   */
+  static double split_rhat(const std::vector<double>& draws) {
+    const size_t n = draws.size() / 2;
+    if (n < 2)
+      return std::numeric_limits<double>::infinity();
+    Eigen::Map<const Eigen::VectorXd> first(draws.data(), n);
+    Eigen::Map<const Eigen::VectorXd> second(draws.data() + draws.size() - n,
+                                             n);
+    const double mean_first = first.mean();
+    const double mean_second = second.mean();
+    const double within
+        = ((first.array() - mean_first).square().sum()
+           + (second.array() - mean_second).square().sum())
+          / (2.0 * (n - 1));
+    if (!(within > 0))
+      return std::numeric_limits<double>::infinity();
+    const double between
+        = n * 0.5 * (mean_first - mean_second) * (mean_first - mean_second);
+    const double var_plus = (n - 1.0) / n * within + between / n;
+    return std::sqrt(var_plus / within);
+  }
+
+  double metric_tolerance_;
+  double stepsize_tolerance_;
+  double max_lp_rhat_;
+
+  // State at the end of the last window
+  int num_windows_;
+  Eigen::VectorXd metric_;
+  double log_stepsize_;
+
+  double metric_change_;
+  double stepsize_change_;
+  double lp_rhat_;
+};
+
+}  // namespace mcmc
+
+}  // namespace stan
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/mcmc/base_adaptation.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <ostream>
 #include <string>
 
@@ -89,6 +91,7 @@ class windowed_adaptation : public base_adaptation {
   }
 
   void compute_next_window() {
+    STAN_TRACE_INSTANT("adaptation_window_close");
     if (adapt_next_window_ == num_warmup_ - adapt_term_buffer_ - 1)
       return;
 
@@ -109,6 +112,60 @@ class windowed_adaptation : public base_adaptation {
     }
   }
 
+  /**
+   * Return the number of iterations until the current slow adaptation
+   * window closes, counting the iteration that closes it, or zero if
+   * no window is left to close.
+   */
+  unsigned int iterations_to_window_end() const {
+    if (adapt_next_window_ >= num_warmup_ - adapt_term_buffer_
+        || adapt_window_counter_ > adapt_next_window_)
+      return 0;
+    return adapt_next_window_ - adapt_window_counter_ + 1;
+  }
+
+  /**
+   * Skip the remaining slow adaptation windows, so that the warmup
+   * continues with the terminal fast interval only.
+   *
+   * @return number of warmup iterations left
+   */
+  unsigned int end_slow_adaptation() {
+    num_warmup_ = adapt_window_counter_ + adapt_term_buffer_;
+    adapt_next_window_ = num_warmup_;
+    return adapt_term_buffer_;
+  }
+
+  /**
+   * Write the window schedule and the position in it.
+   *
+   * @param writer checkpoint writer
+   */
+  void write_checkpoint(checkpoint_writer& writer) const {
+    writer.write(num_warmup_);
+    writer.write(adapt_init_buffer_);
+    writer.write(adapt_term_buffer_);
+    writer.write(adapt_base_window_);
+    writer.write(adapt_window_counter_);
+    writer.write(adapt_next_window_);
+    writer.write(adapt_window_size_);
+  }
+
+  /**
+   * Restore the state written by write_checkpoint().
+   *
+   * @param reader checkpoint reader
+   */
+  void read_checkpoint(checkpoint_reader& reader) {
+    reader.read(num_warmup_);
+    reader.read(adapt_init_buffer_);
+    reader.read(adapt_term_buffer_);
+    reader.read(adapt_base_window_);
+    reader.read(adapt_window_counter_);
+    reader.read(adapt_next_window_);
+    reader.read(adapt_window_size_);
+  }
+
  protected:
   std::string estimator_name_;
 
@@ -0,0 +1,69 @@
+#ifndef STAN_MODEL_DOUBLE_ARENA_HPP
+#define STAN_MODEL_DOUBLE_ARENA_HPP
+
+#include <stan/math/memory/stack_alloc.hpp>
+#include <cstddef>
+
+namespace stan {
+namespace model {
+
+/**
+ * Return the arena of the calling thread for the temporaries of the
+ * `double` evaluations of a model, `log_prob<propto, jacobian, double>`
+ * and `write_array`.
+ *
+ * It is a bump allocator like the one holding the autodiff stack,
+ * separate from it so that `double` evaluations made while a gradient
+ * is being taped do not interleave with the tape.  Allocations are
+ * released all at once by the `double_arena_scope` enclosing the
+ * evaluation, which keeps the blocks for the next one, so evaluations
+ * repeated in a loop, such as the draws of an ELBO estimate or the
+ * `write_array` calls of a sampler, stop allocating once the arena has
+ * grown to the size of one evaluation.
+ *
+ * @return arena of the calling thread
+ */
+inline math::stack_alloc& double_arena() {
+  static thread_local math::stack_alloc arena;
+  return arena;
+}
+
+/**
+ * Allocate an uninitialized array of the specified number of values
+ * in the arena of the calling thread, valid until the innermost
+ * enclosing `double_arena_scope` ends.  The values are not destroyed,
+ * so `T` must be trivially destructible.
+ *
+ * @tparam T type of the values
+ * @param[in] n number of values
+ * @return pointer to the first value
+ */
+template <typename T>
+inline T* double_arena_alloc(std::size_t n) {
+  return double_arena().alloc_array<T>(n);
+}
+
+/**
+ * Scope of a `double` evaluation of a model.  The allocations made in
+ * `double_arena()` of the thread during its lifetime are released when
+ * it ends, the way `stan::math::recover_memory` releases the autodiff
+ * stack after a gradient.  Scopes may be nested, e.g. when the model's
+ * `write_array` calls a function which itself opens one, and must end
+ * on the thread which opened them.
+ */
+class double_arena_scope {
+ public:
+  double_arena_scope() : arena_(double_arena()) { arena_.start_nested(); }
+
+  ~double_arena_scope() { arena_.recover_nested(); }
+
+  double_arena_scope(const double_arena_scope&) = delete;
+  double_arena_scope& operator=(const double_arena_scope&) = delete;
+
+ private:
+  math::stack_alloc& arena_;
+};
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -2,7 +2,14 @@
 #define STAN_MODEL_FINITE_DIFF_GRAD_HPP
 
 #include <stan/callbacks/interrupt.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 
 namespace stan {
@@ -51,6 +58,88 @@ void finite_diff_grad(const M& model, stan::callbacks::interrupt& interrupt,
   }
 }
 
+/**
+ * Compute the gradient using finite differences for the specified
+ * parameters, writing the result into the specified gradient, using
+ * the specified perturbation, with the parameters perturbed in
+ * parallel.
+ *
+ * The parameters are split into chunks of <code>grainsize</code>
+ * which are differenced by TBB worker threads, each perturbing its own
+ * copy of the parameters.  The result is the same as that of
+ * <code>finite_diff_grad</code>, and so are the messages written by
+ * the model, which are buffered and written in the order of the
+ * parameters.  The interrupt callback is called on the calling thread
+ * before each round of chunks, one chunk per available thread.
+ *
+ * <p>The model's log probability must be thread safe, as for running
+ * chains in parallel.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to the
+ * log probability.
+ * @tparam M Class of model.
+ * @param model Model.
+ * @param interrupt interrupt callback to be called before each round
+ *   of chunks.
+ * @param params_r Real-valued parameters.
+ * @param params_i Integer-valued parameters.
+ * @param[out] grad Vector into which gradient is written.
+ * @param epsilon
+ * @param[in,out] msgs
+ * @param grainsize number of parameters differenced by a thread at a
+ *   time
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+void finite_diff_grad_parallel(const M& model,
+                               stan::callbacks::interrupt& interrupt,
+                               std::vector<double>& params_r,
+                               std::vector<int>& params_i,
+                               std::vector<double>& grad,
+                               double epsilon = 1e-6, std::ostream* msgs = 0,
+                               size_t grainsize = 1) {
+  grainsize = std::max<size_t>(1, grainsize);
+  const size_t num_params = params_r.size();
+  const size_t round_size
+      = grainsize * std::max(1, tbb::this_task_arena::max_concurrency());
+  grad.resize(num_params);
+  tbb::enumerable_thread_specific<std::vector<double>> perturbed(params_r);
+  std::vector<std::string> chunk_msgs;
+  for (size_t start = 0; start < num_params; start += round_size) {
+    interrupt();
+    const size_t end = std::min(num_params, start + round_size);
+    chunk_msgs.assign(end - start, std::string());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(start, end, grainsize),
+        [&](const tbb::blocked_range<size_t>& r) {
+          std::vector<double>& x = perturbed.local();
+          std::stringstream chunk_msg;
+          std::ostream* chunk_out = msgs ? &chunk_msg : 0;
+          for (size_t k = r.begin(); k != r.end(); ++k) {
+            x[k] += epsilon;
+            double logp_plus
+                = model.template log_prob<propto, jacobian_adjust_transform>(
+                    x, params_i, chunk_out);
+            x[k] = params_r[k] - epsilon;
+            double logp_minus
+                = model.template log_prob<propto, jacobian_adjust_transform>(
+                    x, params_i, chunk_out);
+            grad[k] = (logp_plus - logp_minus) / (2 * epsilon);
+            x[k] = params_r[k];
+          }
+          if (msgs)
+            chunk_msgs[r.begin() - start] = chunk_msg.str();
+        },
+        tbb::simple_partitioner());
+    if (msgs) {
+      for (const std::string& msg : chunk_msgs)
+        *msgs << msg;
+    }
+  }
+}
+
 }  // namespace model
 }  // namespace stan
 #endif
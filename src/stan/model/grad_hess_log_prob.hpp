@@ -2,6 +2,8 @@
 #define STAN_MODEL_GRAD_HESS_LOG_PROB_HPP
 
 #include <stan/model/log_prob_grad.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <iostream>
 #include <vector>
 
@@ -14,6 +16,11 @@ namespace model {
  * numerically by finite-differencing the gradient, at a cost of
  * O(params_r.size()^2).
  *
+ * The gradients at the perturbed parameters are evaluated in parallel
+ * and then accumulated in a fixed order, so the result does not depend
+ * on the number of threads.  They can only be evaluated in parallel if
+ * Stan Math is built with <code>STAN_THREADS</code>.
+ *
  * @tparam propto True if calculation is up to proportion
  * (double-only terms dropped).
  * @tparam jacobian_adjust_transform True if the log absolute
@@ -48,23 +55,32 @@ double grad_hess_log_prob(const M& model, std::vector<double>& params_r,
          half_epsilon * coefficients[2], half_epsilon * coefficients[3]};
   double result = log_prob_grad<propto, jacobian_adjust_transform>(
       model, params_r, params_i, gradient, msgs);
-  hessian.assign(params_r.size() * params_r.size(), 0);
-  std::vector<double> temp_grad(params_r.size());
-  std::vector<double> perturbed_params(params_r.begin(), params_r.end());
-  for (size_t d = 0; d < params_r.size(); ++d) {
-    const int row_iter = d * params_r.size();
+  const size_t N = params_r.size();
+  std::vector<std::vector<double>> temp_grads(N * order);
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, N * order),
+      [&](const tbb::blocked_range<size_t>& r) {
+        std::vector<double> perturbed_params(params_r.begin(), params_r.end());
+        for (size_t k = r.begin(); k != r.end(); ++k) {
+          const size_t d = k / order;
+          perturbed_params[d] = params_r[d] + perturbations[k % order];
+          log_prob_grad<propto, jacobian_adjust_transform>(
+              model, perturbed_params, params_i, temp_grads[k]);
+          perturbed_params[d] = params_r[d];
+        }
+      });
+  hessian.assign(N * N, 0);
+  for (size_t d = 0; d < N; ++d) {
+    const int row_iter = d * N;
     for (int i = 0; i < order; ++i) {
-      perturbed_params[d] = params_r[d] + perturbations[i];
-      log_prob_grad<propto, jacobian_adjust_transform>(model, perturbed_params,
-                                                       params_i, temp_grad);
-      for (size_t dd = 0; dd < params_r.size(); ++dd) {
+      const std::vector<double>& temp_grad = temp_grads[d * order + i];
+      for (size_t dd = 0; dd < N; ++dd) {
         const double increment = half_epsilon_coeff[i] * temp_grad[dd];
-        const int col_iter = dd * params_r.size();
+        const int col_iter = dd * N;
         hessian[dd + row_iter] += increment;
         hessian[d + col_iter] += increment;
       }
     }
-    perturbed_params[d] = params_r[d];
   }
   return result;
 }
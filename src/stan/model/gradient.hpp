@@ -2,6 +2,7 @@
 #define STAN_MODEL_GRADIENT_HPP
 
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/math/rev.hpp>
 #include <stan/model/model_functional.hpp>
@@ -22,16 +23,14 @@ template <class M>
 void gradient(const M& model, const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
               double& f, Eigen::Matrix<double, Eigen::Dynamic, 1>& grad_f,
               callbacks::logger& logger) {
-  std::stringstream ss;
+  callbacks::message_sink msgs;
   try {
-    stan::math::gradient(model_functional<M>(model, &ss), x, f, grad_f);
+    stan::math::gradient(model_functional<M>(model, &msgs), x, f, grad_f);
   } catch (std::exception& e) {
-    if (ss.str().length() > 0)
-      logger.info(ss);
+    msgs.flush_to(logger);
     throw;
   }
-  if (ss.str().length() > 0)
-    logger.info(ss);
+  msgs.flush_to(logger);
 }
 
 }  // namespace model
@@ -18,6 +18,34 @@ void gradient_dot_vector(const M& model,
                                   grad_f_dot_v);
 }
 
+/**
+ * Compute the log density and its gradient dotted with each column of
+ * the specified matrix of directions, at the same point.
+ *
+ * Rather than a forward mode sweep per direction, the gradient is
+ * computed with a single reverse mode sweep and multiplied by the
+ * directions, which is cheaper as soon as there are more than a few
+ * directions.
+ *
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] x Unconstrained parameters.
+ * @param[in] v Directions, one per column.
+ * @param[out] f Log density at x.
+ * @param[out] grad_f_dot_v Gradient dotted with each direction.
+ * @param[in,out] msgs
+ */
+template <class M>
+void gradient_dot_vector(
+    const M& model, const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
+    const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>& v, double& f,
+    Eigen::Matrix<double, Eigen::Dynamic, 1>& grad_f_dot_v,
+    std::ostream* msgs = 0) {
+  Eigen::Matrix<double, Eigen::Dynamic, 1> grad_f;
+  stan::math::gradient(model_functional<M>(model, msgs), x, f, grad_f);
+  grad_f_dot_v = v.transpose() * grad_f;
+}
+
 }  // namespace model
 }  // namespace stan
 #endif
@@ -18,6 +18,58 @@ void hessian_times_vector(
                                    hess_f_dot_v);
 }
 
+/**
+ * Compute the log density and its Hessian times each column of the
+ * specified matrix of directions, at the same point.
+ *
+ * The unconstrained parameters are recorded once on a nested autodiff
+ * stack shared by all of the directions, each of which then costs a
+ * single forward-over-reverse sweep whose tape is recovered before the
+ * next one.  This saves setting up the autodiff stack and the leaves
+ * for each direction, as calling the single direction overload would.
+ *
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] x Unconstrained parameters.
+ * @param[in] v Directions, one per column.
+ * @param[out] f Log density at x.
+ * @param[out] hess_f_dot_v Hessian times each direction, one per
+ *   column.
+ * @param[in,out] msgs
+ */
+template <class M>
+void hessian_times_vector(
+    const M& model, const Eigen::Matrix<double, Eigen::Dynamic, 1>& x,
+    const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>& v, double& f,
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>& hess_f_dot_v,
+    std::ostream* msgs = 0) {
+  using stan::math::fvar;
+  using stan::math::var;
+  model_functional<M> log_density(model, msgs);
+  hess_f_dot_v.resize(x.size(), v.cols());
+  stan::math::nested_rev_autodiff nested;
+  Eigen::Matrix<var, Eigen::Dynamic, 1> x_var(x.size());
+  for (Eigen::Index i = 0; i < x.size(); ++i)
+    x_var(i) = x(i);
+  if (v.cols() == 0) {
+    f = log_density(x_var).val();
+    return;
+  }
+  Eigen::Matrix<fvar<var>, Eigen::Dynamic, 1> x_fvar(x.size());
+  for (Eigen::Index k = 0; k < v.cols(); ++k) {
+    stan::math::nested_rev_autodiff direction;
+    for (Eigen::Index i = 0; i < x.size(); ++i)
+      x_fvar(i) = fvar<var>(x_var(i), v(i, k));
+    fvar<var> fx = log_density(x_fvar);
+    f = fx.val_.val();
+    stan::math::grad(fx.d_.vi_);
+    for (Eigen::Index i = 0; i < x.size(); ++i) {
+      hess_f_dot_v(i, k) = x_var(i).adj();
+      x_var(i).adj() = 0;
+    }
+  }
+}
+
 }  // namespace model
 }  // namespace stan
 #endif
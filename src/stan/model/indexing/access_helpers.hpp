@@ -5,6 +5,10 @@
 #include <stan/math/rev/meta.hpp>
 #include <stan/math/rev/core.hpp>
 #include <stan/math/rev/fun/to_arena.hpp>
+#include <stan/math/prim/err.hpp>
+#include <stan/model/indexing/index.hpp>
+#include <unordered_set>
+#include <vector>
 
 namespace stan {
 
@@ -161,6 +165,165 @@ inline void assign_impl(Tuple1&& x, Tuple2&& y, const char* name) {
   x = std::forward<Tuple2>(y);
 }
 
+/**
+ * The indexes of a multiple index shifted to start at zero, in the
+ * form taken by Eigen's indexed views.  The indexes are not copied, so
+ * they must outlive the views using them.
+ */
+struct zero_based_multi {
+  const std::vector<int>* ns_;
+
+  Eigen::Index size() const { return ns_->size(); }
+
+  Eigen::Index operator[](Eigen::Index i) const { return (*ns_)[i] - 1; }
+};
+
+/**
+ * Check that the indexes of a multiple index are in range and return
+ * them shifted to start at zero.
+ *
+ * @param[in] function Name of the indexing operation.
+ * @param[in] name Name of the variable.
+ * @param[in] max Size of the indexed dimension.
+ * @param[in] idx Multiple index.
+ * @throw std::out_of_range If any of the indices are out of bounds.
+ */
+inline zero_based_multi check_multi(const char* function, const char* name,
+                                    int max, const index_multi& idx) {
+  if (idx.stride_ > 0) {
+    // Increasing indexes are in range if the first and last are
+    math::check_range(function, name, max, idx.ns_.front());
+    math::check_range(function, name, max, idx.ns_.back());
+  } else {
+    for (int n : idx.ns_) {
+      math::check_range(function, name, max, n);
+    }
+  }
+  return {&idx.ns_};
+}
+
+/**
+ * Zero-based positions stored in a vector, in the form taken by
+ * Eigen's indexed views.  The positions are not copied.
+ */
+struct positions_view {
+  const int* data_;
+  Eigen::Index size_;
+
+  Eigen::Index size() const { return size_; }
+
+  Eigen::Index operator[](Eigen::Index i) const { return data_[i]; }
+};
+
+/**
+ * Return a view of the specified zero-based positions.
+ *
+ * @tparam IntVec A standard vector of integers
+ * @param[in] pos Positions.
+ */
+template <typename IntVec>
+inline positions_view view_positions(const IntVec& pos) {
+  return {pos.data(), static_cast<Eigen::Index>(pos.size())};
+}
+
+/**
+ * Store the zero-based positions of the indexes of a multiple index,
+ * which must have been checked.
+ *
+ * @tparam IntVec A standard vector of integers
+ * @param[in] idx Multiple index.
+ * @param[out] pos Zero-based positions.
+ * @return true if the positions are in nondecreasing order
+ */
+template <typename IntVec>
+inline bool multi_positions(const index_multi& idx, IntVec& pos) {
+  const size_t size = idx.ns_.size();
+  pos.resize(size);
+  bool sorted = true;
+  for (size_t i = 0; i < size; ++i) {
+    pos[i] = idx.ns_[i] - 1;
+    sorted = sorted && (i == 0 || pos[i] >= pos[i - 1]);
+  }
+  return sorted;
+}
+
+/**
+ * Call a functor on each run of equal positions, with the position,
+ * the start of the run and its length.  For sorted positions, these
+ * are all the occurrences of each position.
+ *
+ * @tparam IntVec A standard vector of integers
+ * @tparam F Type of the functor
+ * @param[in] pos Positions.
+ * @param[in] f Functor.
+ */
+template <typename IntVec, typename F>
+inline void for_each_run(const IntVec& pos, F&& f) {
+  const Eigen::Index size = pos.size();
+  Eigen::Index start = 0;
+  while (start < size) {
+    Eigen::Index end = start + 1;
+    while (end < size && pos[end] == pos[start]) {
+      ++end;
+    }
+    f(pos[start], start, end - start);
+    start = end;
+  }
+}
+
+/**
+ * Find the positions assigned by a multiple index together with the
+ * value left in each of them by assigning the values in order, so the
+ * assignment can be done, and undone, with each position written once.
+ *
+ * All the indexes are checked before anything is returned.  The
+ * indexes are scanned from the last, and the first time a position is
+ * seen gives the value that remains there.
+ *
+ * @tparam IntVec A standard vector of integers
+ * @param[in] function Name of the indexing operation.
+ * @param[in] name Name of the variable.
+ * @param[in] max Size of the indexed dimension.
+ * @param[in] idx Multiple index.
+ * @param[out] x_pos Zero-based positions assigned.
+ * @param[out] y_pos Positions of the values assigned to them.
+ * @throw std::out_of_range If any of the indices are out of bounds.
+ */
+template <typename IntVec>
+inline void unique_multi(const char* function, const char* name, int max,
+                         const index_multi& idx, IntVec& x_pos,
+                         IntVec& y_pos) {
+  check_multi(function, name, max, idx);
+  const int size = idx.ns_.size();
+  x_pos.clear();
+  y_pos.clear();
+  x_pos.reserve(size);
+  y_pos.reserve(size);
+  // A bitmap is cheaper than hashing unless the dimension is much
+  // larger than the number of indexes
+  if (max <= 64 * size) {
+    std::vector<bool> seen(max);
+    for (int i = size - 1; i >= 0; --i) {
+      const int m = idx.ns_[i] - 1;
+      if (!seen[m]) {
+        seen[m] = true;
+        x_pos.push_back(m);
+        y_pos.push_back(i);
+      }
+    }
+  } else {
+    std::unordered_set<int> seen;
+    seen.reserve(size);
+    for (int i = size - 1; i >= 0; --i) {
+      const int m = idx.ns_[i] - 1;
+      if (seen.insert(m).second) {
+        x_pos.push_back(m);
+        y_pos.push_back(i);
+      }
+    }
+  }
+}
+
 }  // namespace internal
 }  // namespace model
 }  // namespace stan
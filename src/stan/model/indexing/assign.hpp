@@ -6,6 +6,7 @@
 #include <stan/math/prim/functor.hpp>
 #include <stan/math/prim/fun/to_ref.hpp>
 #include <stan/model/indexing/access_helpers.hpp>
+#include <stan/model/indexing/deep_copy.hpp>
 #include <stan/model/indexing/index.hpp>
 #include <stan/model/indexing/rvalue_at.hpp>
 #include <stan/model/indexing/rvalue_index_size.hpp>
@@ -86,7 +87,9 @@ inline void assign(Vec&& x, const U& y, const char* name, index_uni idx) {
 }
 
 /**
- * Assign to a non-contiguous subset of elements in a vector.
+ * Assign to a non-contiguous subset of elements in a vector.  A
+ * range of increasing indexes is assigned as a segment, or as a
+ * strided slice if the indexes are not consecutive.
  *
  * Types:  vector[multi] <- vector
  *
@@ -107,10 +110,14 @@ inline void assign(Vec1&& x, const Vec2& y, const char* name,
   const auto& y_ref = stan::math::to_ref(y);
   stan::math::check_size_match("vector[multi] assign", name, idx.ns_.size(),
                                "right hand side", y_ref.size());
-  const auto x_size = x.size();
-  for (int n = 0; n < y_ref.size(); ++n) {
-    stan::math::check_range("vector[multi] assign", name, x_size, idx.ns_[n]);
-    x.coeffRef(idx.ns_[n] - 1) = y_ref.coeff(n);
+  const auto ns
+      = internal::check_multi("vector[multi] assign", name, x.size(), idx);
+  if (idx.is_contiguous()) {
+    x.segment(idx.ns_.front() - 1, idx.ns_.size()) = y_ref;
+  } else if (idx.stride_ > 0) {
+    x(Eigen::seqN(idx.ns_.front() - 1, idx.ns_.size(), idx.stride_)) = y_ref;
+  } else {
+    x(ns) = y_ref;
   }
 }
 
@@ -255,7 +262,9 @@ inline void assign(Mat&& x, const RowVec& y, const char* name, index_uni idx) {
 }
 
 /**
- * Assign to a non-contiguous subset of a matrice's rows.
+ * Assign to a non-contiguous subset of a matrice's rows.  A range of
+ * increasing indexes is assigned as a block of rows, or as a strided
+ * slice of rows if the indexes are not consecutive.
  *
  * Types:  mat[multi] = mat
  *
@@ -279,10 +288,16 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
                                y.rows());
   stan::math::check_size_match("matrix[multi] assign columns", name, x.cols(),
                                "right hand side columns", y.cols());
-  for (int i = 0; i < idx.ns_.size(); ++i) {
-    const int n = idx.ns_[i];
-    stan::math::check_range("matrix[multi] assign row", name, x.rows(), n);
-    x.row(n - 1) = y_ref.row(i);
+  const auto ns
+      = internal::check_multi("matrix[multi] assign row", name, x.rows(), idx);
+  if (idx.is_contiguous()) {
+    x.middleRows(idx.ns_.front() - 1, idx.ns_.size()) = y_ref;
+  } else if (idx.stride_ > 0) {
+    x(Eigen::seqN(idx.ns_.front() - 1, idx.ns_.size(), idx.stride_),
+      Eigen::all)
+        = y_ref;
+  } else {
+    x(ns, Eigen::all) = y_ref;
   }
 }
 
@@ -423,7 +438,9 @@ inline void assign(Mat1&& x, Mat2&& y, const char* name, index_min_max idx) {
  * matrix and right-hand side matrix do not match.
  */
 template <typename Mat1, typename Mat2,
-          require_dense_dynamic_t<Mat1>* = nullptr>
+          require_dense_dynamic_t<Mat1>* = nullptr,
+          require_not_t<internal::is_deep_copy_ref<std::decay_t<Mat2>>>*
+          = nullptr>
 inline void assign(Mat1&& x, Mat2&& y, const char* name, index_min_max row_idx,
                    index_min_max col_idx) {
   if (likely((row_idx.max_ >= row_idx.min_)
@@ -533,10 +550,13 @@ inline void assign(Mat1&& x, const Vec& y, const char* name, index_uni row_idx,
   stan::math::check_size_match("matrix[uni, multi] assign", name,
                                col_idx.ns_.size(), "right hand side",
                                y_ref.size());
-  for (int i = 0; i < col_idx.ns_.size(); ++i) {
-    stan::math::check_range("matrix[uni, multi] assign column", name, x.cols(),
-                            col_idx.ns_[i]);
-    x.coeffRef(row_idx.n_ - 1, col_idx.ns_[i] - 1) = y_ref.coeff(i);
+  const auto ns = internal::check_multi("matrix[uni, multi] assign column",
+                                        name, x.cols(), col_idx);
+  if (col_idx.is_contiguous()) {
+    x.row(row_idx.n_ - 1).segment(col_idx.ns_.front() - 1, col_idx.ns_.size())
+        = y_ref;
+  } else {
+    x.row(row_idx.n_ - 1)(ns) = y_ref;
   }
 }
 
@@ -568,16 +588,16 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
   stan::math::check_size_match("matrix[multi,multi] assign columns", name,
                                col_idx.ns_.size(), "right hand side columns",
                                y_ref.cols());
-  for (int j = 0; j < y_ref.cols(); ++j) {
-    const int n = col_idx.ns_[j];
-    stan::math::check_range("matrix[multi,multi] assign column", name, x.cols(),
-                            n);
-    for (int i = 0; i < y_ref.rows(); ++i) {
-      const int m = row_idx.ns_[i];
-      stan::math::check_range("matrix[multi,multi] assign row", name, x.rows(),
-                              m);
-      x.coeffRef(m - 1, n - 1) = y_ref.coeff(i, j);
-    }
+  const auto cols = internal::check_multi("matrix[multi,multi] assign column",
+                                          name, x.cols(), col_idx);
+  const auto rows = internal::check_multi("matrix[multi,multi] assign row",
+                                          name, x.rows(), row_idx);
+  if (row_idx.is_contiguous() && col_idx.is_contiguous()) {
+    x.block(row_idx.ns_.front() - 1, col_idx.ns_.front() - 1,
+            row_idx.ns_.size(), col_idx.ns_.size())
+        = y_ref;
+  } else {
+    x(rows, cols) = y_ref;
   }
 }
 
@@ -657,7 +677,9 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
  * matrix and value matrix do not match.
  */
 template <typename Mat1, typename Mat2, typename Idx,
-          require_dense_dynamic_t<Mat1>* = nullptr>
+          require_dense_dynamic_t<Mat1>* = nullptr,
+          require_not_t<internal::is_deep_copy_ref<std::decay_t<Mat2>>>*
+          = nullptr>
 inline void assign(Mat1&& x, Mat2&& y, const char* name, const Idx& row_idx,
                    index_omni /* idx */) {
   assign(x, std::forward<Mat2>(y), name, row_idx);
@@ -747,7 +769,9 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
  * matrix and right-hand side matrix do not match.
  */
 template <typename Mat1, typename Mat2, typename Idx,
-          require_dense_dynamic_t<Mat1>* = nullptr>
+          require_dense_dynamic_t<Mat1>* = nullptr,
+          require_not_t<internal::is_deep_copy_ref<std::decay_t<Mat2>>>*
+          = nullptr>
 inline void assign(Mat1&& x, Mat2&& y, const char* name, const Idx& row_idx,
                    index_min_max col_idx) {
   if (likely(col_idx.max_ >= col_idx.min_)) {
@@ -815,7 +839,8 @@ inline void assign(T&& x, U&& y, const char* name) {
  * tail assignment.
  */
 template <typename StdVec, typename U, typename... Idxs,
-          require_std_vector_t<StdVec>* = nullptr>
+          require_std_vector_t<StdVec>* = nullptr,
+          require_not_t<internal::is_deep_copy_ref<std::decay_t<U>>>* = nullptr>
 inline void assign(StdVec&& x, U&& y, const char* name, index_uni idx1,
                    const Idxs&... idxs) {
   stan::math::check_range("array[uni,...] assign", name, x.size(), idx1.n_);
@@ -839,7 +864,8 @@ inline void assign(StdVec&& x, U&& y, const char* name, index_uni idx1,
  * tail assignment.
  */
 template <typename StdVec, typename U, require_std_vector_t<StdVec>* = nullptr,
-          require_t<std::is_assignable<value_type_t<StdVec>&, U>>* = nullptr>
+          require_t<std::is_assignable<value_type_t<StdVec>&, U>>* = nullptr,
+          require_not_t<internal::is_deep_copy_ref<std::decay_t<U>>>* = nullptr>
 inline void assign(StdVec&& x, U&& y, const char* name, index_uni idx) {
   stan::math::check_range("array[uni,...] assign", name, x.size(), idx.n_);
   assign(x[idx.n_ - 1], std::forward<U>(y), name);
@@ -928,6 +954,59 @@ inline void assign(Tuple1&& x, Tuple2&& y, const char* name) {
       internal::make_tuple_seq(std::make_index_sequence<t1_size>()));
 }
 
+namespace internal {
+/**
+ * Return true if the value may overlap the elements of the variable
+ * assigned by the specified indices.
+ */
+template <typename T, typename U>
+inline bool assign_may_alias(const T& x, const U& y) {
+  return may_alias(x, y);
+}
+
+template <typename T, typename U, typename Idx, typename... Idxs>
+inline bool assign_may_alias(const T& x, const U& y, const Idx& /* idx */,
+                             const Idxs&... /* idxs */) {
+  return may_alias(x, y);
+}
+
+template <typename StdVec, typename U, typename... Idxs,
+          require_std_vector_t<StdVec>* = nullptr>
+inline bool assign_may_alias(const StdVec& x, const U& y, const index_uni& idx,
+                             const Idxs&... idxs) {
+  // Out of range indices are left to assign() to report
+  if (idx.n_ < 1 || static_cast<size_t>(idx.n_) > x.size())
+    return true;
+  return assign_may_alias(x[idx.n_ - 1], y, idxs...);
+}
+}  // namespace internal
+
+/**
+ * Assign a value which may alias the variable assigned, as returned by
+ * <code>deep_copy()</code>.  The value is copied first only if its
+ * memory overlaps that of the elements assigned, as found from the
+ * leading single indices into standard vectors, or of the whole
+ * variable otherwise.
+ *
+ * @tparam T type of the variable
+ * @tparam U type of the value
+ * @tparam Idxs types of the indices
+ * @param[in,out] x variable to be assigned
+ * @param[in] y reference to the value
+ * @param[in] name name of the variable
+ * @param[in] idxs indices of the elements assigned
+ */
+template <typename T, typename U, typename... Idxs>
+inline void assign(T&& x, deep_copy_ref<U>&& y, const char* name,
+                   Idxs&&... idxs) {
+  if (internal::assign_may_alias(x, y.get(), idxs...)) {
+    assign(std::forward<T>(x), plain_type_t<U>(y.get()), name,
+           std::forward<Idxs>(idxs)...);
+  } else {
+    assign(std::forward<T>(x), y.get(), name, std::forward<Idxs>(idxs)...);
+  }
+}
+
 }  // namespace model
 }  // namespace stan
 #endif
@@ -91,7 +91,8 @@ inline void assign(VarVec&& x, const U& y, const char* name, index_uni idx) {
 }
 
 /**
- * Assign to a non-contiguous subset of elements in a vector.
+ * Assign to a non-contiguous subset of elements in a vector.  A
+ * range of consecutive increasing indexes is assigned as a segment.
  *
  * Types:  vector[multi] <- vector
  *
@@ -113,58 +114,58 @@ inline void assign(Vec1&& x, const Vec2& y, const char* name,
                    const index_multi& idx) {
   stan::math::check_size_match("vector[multi] assign", name, idx.ns_.size(),
                                "right hand side", y.size());
-  const auto x_size = x.size();
-  const auto assign_size = idx.ns_.size();
-  arena_t<std::vector<int>> x_idx(assign_size);
-  arena_t<Eigen::Matrix<double, -1, 1>> prev_vals(assign_size);
-  Eigen::Matrix<double, -1, 1> y_idx_vals(assign_size);
-  std::unordered_set<int> x_set;
-  x_set.reserve(assign_size);
-  const auto& y_val = stan::math::value_of(y);
-  // We have to use two loops to avoid aliasing issues.
-  for (int i = assign_size - 1; i >= 0; --i) {
-    if (likely(x_set.insert(idx.ns_[i]).second)) {
-      stan::math::check_range("vector[multi] assign", name, x_size, idx.ns_[i]);
-      x_idx[i] = idx.ns_[i] - 1;
-      prev_vals.coeffRef(i) = x.vi_->val_.coeffRef(x_idx[i]);
-      y_idx_vals.coeffRef(i) = y_val.coeff(i);
+  if (idx.is_contiguous()) {
+    internal::check_multi("vector[multi] assign", name, x.size(), idx);
+    const Eigen::Index start = idx.ns_.front() - 1;
+    const Eigen::Index size = idx.ns_.size();
+    arena_t<Eigen::Matrix<double, -1, 1>> prev_vals
+        = x.vi_->val_.segment(start, size);
+    // Read all the values before writing, as y may alias x
+    Eigen::Matrix<double, -1, 1> y_vals = stan::math::value_of(y);
+    x.vi_->val_.segment(start, size) = y_vals;
+    if (!is_constant<Vec2>::value) {
+      stan::math::reverse_pass_callback([x, y, start, size,
+                                         prev_vals]() mutable {
+        x.vi_->val_.segment(start, size) = prev_vals;
+        math::forward_as<math::promote_scalar_t<math::var, Vec2>>(y).adj()
+            += x.adj().segment(start, size);
+        x.adj().segment(start, size).setZero();
+      });
     } else {
-      x_idx[i] = -1;
-    }
-  }
-  for (int i = assign_size - 1; i >= 0; --i) {
-    if (likely(x_idx[i] != -1)) {
-      x.vi_->val_.coeffRef(x_idx[i]) = y_idx_vals.coeff(i);
+      stan::math::reverse_pass_callback([x, start, size, prev_vals]() mutable {
+        x.vi_->val_.segment(start, size) = prev_vals;
+        x.adj().segment(start, size).setZero();
+      });
     }
+    return;
   }
+  arena_t<std::vector<int>> x_pos;
+  arena_t<std::vector<int>> y_pos;
+  internal::unique_multi("vector[multi] assign", name, x.size(), idx, x_pos,
+                         y_pos);
+  const auto x_view = internal::view_positions(x_pos);
+  arena_t<Eigen::Matrix<double, -1, 1>> prev_vals = x.vi_->val_(x_view);
+  // Read all the values before writing, as y may alias x
+  Eigen::Matrix<double, -1, 1> y_vals
+      = stan::math::value_of(y)(internal::view_positions(y_pos));
+  x.vi_->val_(x_view) = y_vals;
 
   if (!is_constant<Vec2>::value) {
-    stan::math::reverse_pass_callback([x, y, x_idx, prev_vals]() mutable {
-      for (Eigen::Index i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          x.vi_->val_.coeffRef(x_idx[i]) = prev_vals.coeffRef(i);
-          prev_vals.coeffRef(i) = x.adj().coeffRef(x_idx[i]);
-          x.adj().coeffRef(x_idx[i]) = 0.0;
-        }
-      }
-      for (Eigen::Index i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          math::forward_as<math::promote_scalar_t<math::var, Vec2>>(y)
-              .adj()
-              .coeffRef(i)
-              += prev_vals.coeff(i);
-        }
-      }
+    stan::math::reverse_pass_callback([x, y, x_pos, y_pos,
+                                       prev_vals]() mutable {
+      const auto x_view = internal::view_positions(x_pos);
+      x.vi_->val_(x_view) = prev_vals;
+      prev_vals = x.adj()(x_view);
+      x.adj()(x_view).setZero();
+      math::forward_as<math::promote_scalar_t<math::var, Vec2>>(y).adj()(
+          internal::view_positions(y_pos))
+          += prev_vals;
     });
   } else {
-    stan::math::reverse_pass_callback([x, x_idx, prev_vals]() mutable {
-      for (Eigen::Index i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          x.vi_->val_.coeffRef(x_idx[i]) = prev_vals.coeff(i);
-          prev_vals.coeffRef(i) = x.adj().coeff(x_idx[i]);
-          x.adj().coeffRef(x_idx[i]) = 0.0;
-        }
-      }
+    stan::math::reverse_pass_callback([x, x_pos, prev_vals]() mutable {
+      const auto x_view = internal::view_positions(x_pos);
+      x.vi_->val_(x_view) = prev_vals;
+      x.adj()(x_view).setZero();
     });
   }
 }
@@ -232,58 +233,34 @@ inline void assign(Mat1&& x, const Vec& y, const char* name, index_uni row_idx,
   stan::math::check_size_match("matrix[uni, multi] assign columns", name,
                                assign_cols, "right hand side", y.size());
   const int row_idx_val = row_idx.n_ - 1;
-  arena_t<std::vector<int>> x_idx(assign_cols);
-  arena_t<Eigen::Matrix<double, -1, 1>> prev_val(assign_cols);
-  Eigen::Matrix<double, -1, 1> y_val_idx(assign_cols);
-  std::unordered_set<int> x_set;
-  x_set.reserve(assign_cols);
-  const auto& y_val = stan::math::value_of(y);
-  // Need to remove duplicates for cases like {2, 3, 2, 2}
-  for (int i = assign_cols - 1; i >= 0; --i) {
-    if (likely(x_set.insert(col_idx.ns_[i]).second)) {
-      stan::math::check_range("matrix[uni, multi] assign", name, x.cols(),
-                              col_idx.ns_[i]);
-      x_idx[i] = col_idx.ns_[i] - 1;
-      prev_val.coeffRef(i) = x.val().coeff(row_idx_val, x_idx[i]);
-      y_val_idx.coeffRef(i) = y_val.coeff(i);
-    } else {
-      x_idx[i] = -1;
-    }
-  }
-  for (int i = assign_cols - 1; i >= 0; --i) {
-    if (likely(x_idx[i] != -1)) {
-      x.vi_->val_.coeffRef(row_idx_val, x_idx[i]) = y_val_idx.coeff(i);
-    }
-  }
+  arena_t<std::vector<int>> x_pos;
+  arena_t<std::vector<int>> y_pos;
+  internal::unique_multi("matrix[uni, multi] assign", name, x.cols(), col_idx,
+                         x_pos, y_pos);
+  const auto x_view = internal::view_positions(x_pos);
+  arena_t<Eigen::Matrix<double, 1, -1>> prev_vals
+      = x.vi_->val_.row(row_idx_val)(x_view);
+  // Read all the values before writing, as y may alias x
+  Eigen::Matrix<double, 1, -1> y_vals
+      = stan::math::value_of(y)(internal::view_positions(y_pos));
+  x.vi_->val_.row(row_idx_val)(x_view) = y_vals;
   if (!is_constant<Vec>::value) {
     stan::math::reverse_pass_callback(
-        [x, y, row_idx_val, x_idx, prev_val]() mutable {
-          for (size_t i = 0; i < x_idx.size(); ++i) {
-            if (likely(x_idx[i] != -1)) {
-              x.vi_->val_.coeffRef(row_idx_val, x_idx[i]) = prev_val.coeff(i);
-              prev_val.coeffRef(i) = x.adj().coeff(row_idx_val, x_idx[i]);
-              x.adj().coeffRef(row_idx_val, x_idx[i]) = 0.0;
-            }
-          }
-          for (size_t i = 0; i < x_idx.size(); ++i) {
-            if (likely(x_idx[i] != -1)) {
-              math::forward_as<math::promote_scalar_t<math::var, Vec>>(y)
-                  .adj()
-                  .coeffRef(i)
-                  += prev_val.coeff(i);
-            }
-          }
+        [x, y, row_idx_val, x_pos, y_pos, prev_vals]() mutable {
+          const auto x_view = internal::view_positions(x_pos);
+          x.vi_->val_.row(row_idx_val)(x_view) = prev_vals;
+          prev_vals = x.adj().row(row_idx_val)(x_view);
+          x.adj().row(row_idx_val)(x_view).setZero();
+          math::forward_as<math::promote_scalar_t<math::var, Vec>>(y).adj()(
+              internal::view_positions(y_pos))
+              += prev_vals;
         });
   } else {
     stan::math::reverse_pass_callback(
-        [x, row_idx_val, x_idx, prev_val]() mutable {
-          for (size_t i = 0; i < x_idx.size(); ++i) {
-            if (likely(x_idx[i] != -1)) {
-              x.vi_->val_.coeffRef(row_idx_val, x_idx[i]) = prev_val.coeff(i);
-              prev_val.coeffRef(i) = x.adj().coeffRef(row_idx_val, x_idx[i]);
-              x.adj().coeffRef(row_idx_val, x_idx[i]) = 0.0;
-            }
-          }
+        [x, row_idx_val, x_pos, prev_vals]() mutable {
+          const auto x_view = internal::view_positions(x_pos);
+          x.vi_->val_.row(row_idx_val)(x_view) = prev_vals;
+          x.adj().row(row_idx_val)(x_view).setZero();
         });
   }
 }
@@ -291,6 +268,8 @@ inline void assign(Mat1&& x, const Vec& y, const char* name, index_uni row_idx,
 /**
  * Assign to multiple possibly unordered rows of a matrix from an input
  * matrix.
+ * A range of consecutive increasing indexes is assigned as a block of
+ * rows.
  *
  * Types:  mat[multi] = mat
  *
@@ -314,57 +293,59 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
                                "right hand side rows", y.rows());
   stan::math::check_size_match("matrix[multi] assign columns", name, x.cols(),
                                "right hand side rows", y.cols());
-  arena_t<std::vector<int>> x_idx(assign_rows);
-  arena_t<Eigen::Matrix<double, -1, -1>> prev_vals(assign_rows, x.cols());
-  Eigen::Matrix<double, -1, -1> y_val_idx(assign_rows, x.cols());
-  std::unordered_set<int> x_set;
-  x_set.reserve(assign_rows);
-  const auto& y_val = stan::math::value_of(y);
-  // Need to remove duplicates for cases like {2, 3, 2, 2}
-  for (int i = assign_rows - 1; i >= 0; --i) {
-    if (likely(x_set.insert(idx.ns_[i]).second)) {
-      stan::math::check_range("matrix[multi, multi] assign row", name, x.rows(),
-                              idx.ns_[i]);
-      x_idx[i] = idx.ns_[i] - 1;
-      prev_vals.row(i) = x.vi_->val_.row(x_idx[i]);
-      y_val_idx.row(i) = y_val.row(i);
+  if (idx.is_contiguous()) {
+    internal::check_multi("matrix[multi] assign row", name, x.rows(), idx);
+    const Eigen::Index start = idx.ns_.front() - 1;
+    const Eigen::Index rows = idx.ns_.size();
+    arena_t<Eigen::Matrix<double, -1, -1>> prev_vals
+        = x.vi_->val_.middleRows(start, rows);
+    // Read all the values before writing, as y may alias x
+    Eigen::Matrix<double, -1, -1> y_vals = stan::math::value_of(y);
+    x.vi_->val_.middleRows(start, rows) = y_vals;
+    if (!is_constant<Mat2>::value) {
+      stan::math::reverse_pass_callback([x, y, start, rows,
+                                         prev_vals]() mutable {
+        x.vi_->val_.middleRows(start, rows) = prev_vals;
+        math::forward_as<math::promote_scalar_t<math::var, Mat2>>(y).adj()
+            += x.adj().middleRows(start, rows);
+        x.adj().middleRows(start, rows).setZero();
+      });
     } else {
-      x_idx[i] = -1;
-    }
-  }
-  for (int i = assign_rows - 1; i >= 0; --i) {
-    if (likely(x_idx[i] != -1)) {
-      x.vi_->val_.row(x_idx[i]) = y_val_idx.row(i);
+      stan::math::reverse_pass_callback([x, start, rows, prev_vals]() mutable {
+        x.vi_->val_.middleRows(start, rows) = prev_vals;
+        x.adj().middleRows(start, rows).setZero();
+      });
     }
+    return;
   }
+  arena_t<std::vector<int>> x_pos;
+  arena_t<std::vector<int>> y_pos;
+  internal::unique_multi("matrix[multi] assign row", name, x.rows(), idx,
+                         x_pos, y_pos);
+  const auto x_view = internal::view_positions(x_pos);
+  arena_t<Eigen::Matrix<double, -1, -1>> prev_vals
+      = x.vi_->val_(x_view, Eigen::all);
+  // Read all the values before writing, as y may alias x
+  Eigen::Matrix<double, -1, -1> y_vals
+      = stan::math::value_of(y)(internal::view_positions(y_pos), Eigen::all);
+  x.vi_->val_(x_view, Eigen::all) = y_vals;
 
   if (!is_constant<Mat2>::value) {
-    stan::math::reverse_pass_callback([x, y, prev_vals, x_idx]() mutable {
-      for (size_t i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          x.vi_->val_.row(x_idx[i]) = prev_vals.row(i);
-          prev_vals.row(i) = x.adj().row(x_idx[i]);
-          x.adj().row(x_idx[i]).fill(0);
-        }
-      }
-      for (size_t i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          math::forward_as<math::promote_scalar_t<math::var, Mat2>>(y)
-              .adj()
-              .row(i)
-              += prev_vals.row(i);
-        }
-      }
+    stan::math::reverse_pass_callback([x, y, prev_vals, x_pos,
+                                       y_pos]() mutable {
+      const auto x_view = internal::view_positions(x_pos);
+      x.vi_->val_(x_view, Eigen::all) = prev_vals;
+      prev_vals = x.adj()(x_view, Eigen::all);
+      x.adj()(x_view, Eigen::all).setZero();
+      math::forward_as<math::promote_scalar_t<math::var, Mat2>>(y).adj()(
+          internal::view_positions(y_pos), Eigen::all)
+          += prev_vals;
     });
   } else {
-    stan::math::reverse_pass_callback([x, prev_vals, x_idx]() mutable {
-      for (size_t i = 0; i < x_idx.size(); ++i) {
-        if (likely(x_idx[i] != -1)) {
-          x.vi_->val_.row(x_idx[i]) = prev_vals.row(i);
-          prev_vals.row(i) = x.adj().row(x_idx[i]);
-          x.adj().row(x_idx[i]).setZero();
-        }
-      }
+    stan::math::reverse_pass_callback([x, prev_vals, x_pos]() mutable {
+      const auto x_view = internal::view_positions(x_pos);
+      x.vi_->val_(x_view, Eigen::all) = prev_vals;
+      x.adj()(x_view, Eigen::all).setZero();
     });
   }
 }
@@ -397,96 +378,44 @@ inline void assign(Mat1&& x, const Mat2& y, const char* name,
   stan::math::check_size_match("matrix[multi,multi] assign columns", name,
                                assign_cols, "right hand side columns",
                                y.cols());
-  using arena_vec = std::vector<int, stan::math::arena_allocator<int>>;
-  arena_vec x_col_idx(assign_cols);
-  arena_vec x_row_idx(assign_rows);
-  std::unordered_set<int> x_set;
-  x_set.reserve(assign_cols);
-  std::unordered_set<int> x_row_set;
-  x_row_set.reserve(assign_rows);
-  arena_t<Eigen::Matrix<double, -1, -1>> prev_vals(assign_rows, assign_cols);
-  Eigen::Matrix<double, -1, -1> y_vals(assign_rows, assign_cols);
-  // Need to remove duplicates for cases like {{2, 3, 2, 2}, {1, 2, 2}}
-  for (int i = assign_rows - 1; i >= 0; --i) {
-    if (likely(x_row_set.insert(row_idx.ns_[i]).second)) {
-      stan::math::check_range("matrix[multi, multi] assign row", name, x.rows(),
-                              row_idx.ns_[i]);
-      x_row_idx[i] = row_idx.ns_[i] - 1;
-    } else {
-      x_row_idx[i] = -1;
-    }
-  }
-  const auto& y_val = stan::math::value_of(y);
-  for (int j = assign_cols - 1; j >= 0; --j) {
-    if (likely(x_set.insert(col_idx.ns_[j]).second)) {
-      stan::math::check_range("matrix[multi, multi] assign col", name, x.cols(),
-                              col_idx.ns_[j]);
-      x_col_idx[j] = col_idx.ns_[j] - 1;
-      for (int i = assign_rows - 1; i >= 0; --i) {
-        if (likely(x_row_idx[i] != -1)) {
-          prev_vals.coeffRef(i, j)
-              = x.vi_->val_.coeff(x_row_idx[i], x_col_idx[j]);
-          y_vals.coeffRef(i, j) = y_val.coeff(i, j);
-        }
-      }
-    } else {
-      x_col_idx[j] = -1;
-    }
-  }
-  for (int j = assign_cols - 1; j >= 0; --j) {
-    if (likely(x_col_idx[j] != -1)) {
-      for (int i = assign_rows - 1; i >= 0; --i) {
-        if (likely(x_row_idx[i] != -1)) {
-          x.vi_->val_.coeffRef(x_row_idx[i], x_col_idx[j]) = y_vals.coeff(i, j);
-        }
-      }
-    }
-  }
+  // The last assignment to a cell is from the last row and column
+  // assigned to it, so rows and columns are deduplicated separately
+  arena_t<std::vector<int>> x_rows;
+  arena_t<std::vector<int>> y_rows;
+  arena_t<std::vector<int>> x_cols;
+  arena_t<std::vector<int>> y_cols;
+  internal::unique_multi("matrix[multi, multi] assign row", name, x.rows(),
+                         row_idx, x_rows, y_rows);
+  internal::unique_multi("matrix[multi, multi] assign col", name, x.cols(),
+                         col_idx, x_cols, y_cols);
+  const auto x_row_view = internal::view_positions(x_rows);
+  const auto x_col_view = internal::view_positions(x_cols);
+  arena_t<Eigen::Matrix<double, -1, -1>> prev_vals
+      = x.vi_->val_(x_row_view, x_col_view);
+  // Read all the values before writing, as y may alias x
+  Eigen::Matrix<double, -1, -1> y_vals = stan::math::value_of(y)(
+      internal::view_positions(y_rows), internal::view_positions(y_cols));
+  x.vi_->val_(x_row_view, x_col_view) = y_vals;
   if (!is_constant<Mat2>::value) {
     stan::math::reverse_pass_callback(
-        [x, y, prev_vals, x_col_idx, x_row_idx]() mutable {
-          for (int j = 0; j < x_col_idx.size(); ++j) {
-            if (likely(x_col_idx[j] != -1)) {
-              for (int i = 0; i < x_row_idx.size(); ++i) {
-                if (likely(x_row_idx[i] != -1)) {
-                  x.vi_->val_.coeffRef(x_row_idx[i], x_col_idx[j])
-                      = prev_vals.coeff(i, j);
-                  prev_vals.coeffRef(i, j)
-                      = x.adj().coeff(x_row_idx[i], x_col_idx[j]);
-                  x.adj().coeffRef(x_row_idx[i], x_col_idx[j]) = 0;
-                }
-              }
-            }
-          }
-          for (int j = 0; j < x_col_idx.size(); ++j) {
-            if (likely(x_col_idx[j] != -1)) {
-              for (int i = 0; i < x_row_idx.size(); ++i) {
-                if (likely(x_row_idx[i] != -1)) {
-                  math::forward_as<math::promote_scalar_t<math::var, Mat2>>(y)
-                      .adj()
-                      .coeffRef(i, j)
-                      += prev_vals.coeff(i, j);
-                }
-              }
-            }
-          }
+        [x, y, prev_vals, x_rows, y_rows, x_cols, y_cols]() mutable {
+          const auto x_row_view = internal::view_positions(x_rows);
+          const auto x_col_view = internal::view_positions(x_cols);
+          x.vi_->val_(x_row_view, x_col_view) = prev_vals;
+          prev_vals = x.adj()(x_row_view, x_col_view);
+          x.adj()(x_row_view, x_col_view).setZero();
+          math::forward_as<math::promote_scalar_t<math::var, Mat2>>(y).adj()(
+              internal::view_positions(y_rows),
+              internal::view_positions(y_cols))
+              += prev_vals;
         });
   } else {
     stan::math::reverse_pass_callback(
-        [x, prev_vals, x_col_idx, x_row_idx]() mutable {
-          for (int j = 0; j < x_col_idx.size(); ++j) {
-            if (likely(x_col_idx[j] != -1)) {
-              for (int i = 0; i < x_row_idx.size(); ++i) {
-                if (likely(x_row_idx[i] != -1)) {
-                  x.vi_->val_.coeffRef(x_row_idx[i], x_col_idx[j])
-                      = prev_vals.coeff(i, j);
-                  prev_vals.coeffRef(i, j)
-                      = x.adj().coeff(x_row_idx[i], x_col_idx[j]);
-                  x.adj().coeffRef(x_row_idx[i], x_col_idx[j]) = 0;
-                }
-              }
-            }
-          }
+        [x, prev_vals, x_rows, x_cols]() mutable {
+          const auto x_row_view = internal::view_positions(x_rows);
+          const auto x_col_view = internal::view_positions(x_cols);
+          x.vi_->val_(x_row_view, x_col_view) = prev_vals;
+          x.adj()(x_row_view, x_col_view).setZero();
         });
   }
 }
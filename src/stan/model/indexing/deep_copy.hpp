@@ -3,12 +3,155 @@
 
 #include <stan/math/prim/fun/Eigen.hpp>
 #include <stan/math/prim/meta.hpp>
+#include <functional>
+#include <type_traits>
 #include <vector>
 
 namespace stan {
 
 namespace model {
 
+namespace internal {
+
+/**
+ * Trait for the types whose memory is known to <code>assign</code>:
+ * Eigen matrices and standard vectors of scalars or of such types.
+ * Their memory is the object itself and, for the containers, the
+ * storage of their elements.
+ */
+template <typename T, typename = void>
+struct is_alias_checkable : std::false_type {};
+
+template <typename T>
+struct is_alias_checkable<
+    T, require_all_t<is_eigen<T>, is_plain_type<T>,
+                     is_stan_scalar<value_type_t<T>>>> : std::true_type {};
+
+template <typename T, typename Alloc>
+struct is_alias_checkable<std::vector<T, Alloc>, void>
+    : bool_constant<is_stan_scalar<T>::value
+                    || is_alias_checkable<T>::value> {};
+
+/**
+ * Return true if the memory ranges [begin1, end1) and [begin2, end2)
+ * overlap.
+ */
+inline bool ranges_overlap(const void* begin1, const void* end1,
+                           const void* begin2, const void* end2) {
+  std::less<const void*> less;
+  return less(begin1, end2) && less(begin2, end1);
+}
+
+/**
+ * Return true if the memory of the specified scalar overlaps the
+ * specified range.
+ */
+template <typename T, require_stan_scalar_t<T>* = nullptr>
+inline bool overlaps(const T& x, const void* begin, const void* end) {
+  return ranges_overlap(&x, &x + 1, begin, end);
+}
+
+/**
+ * Return true if the memory of the specified Eigen matrix, or of its
+ * elements, overlaps the specified range.
+ */
+template <typename T, require_eigen_t<T>* = nullptr,
+          require_t<is_alias_checkable<T>>* = nullptr>
+inline bool overlaps(const T& x, const void* begin, const void* end) {
+  return ranges_overlap(&x, &x + 1, begin, end)
+         || ranges_overlap(x.data(), x.data() + x.size(), begin, end);
+}
+
+/**
+ * Return true if the memory of the specified standard vector, or of its
+ * elements, overlaps the specified range.
+ */
+template <typename T, require_std_vector_t<T>* = nullptr,
+          require_t<is_alias_checkable<T>>* = nullptr>
+inline bool overlaps(const T& x, const void* begin, const void* end) {
+  if (ranges_overlap(&x, &x + 1, begin, end)
+      || ranges_overlap(x.data(), x.data() + x.size(), begin, end))
+    return true;
+  if (!is_stan_scalar<value_type_t<T>>::value)
+    for (const auto& x_i : x)
+      if (overlaps(x_i, begin, end))
+        return true;
+  return false;
+}
+
+/**
+ * Return true, as the memory of other types is not known.
+ */
+template <typename T, require_not_stan_scalar_t<T>* = nullptr,
+          require_not_t<is_alias_checkable<T>>* = nullptr>
+inline bool overlaps(const T& x, const void* begin, const void* end) {
+  return true;
+}
+
+/**
+ * Return true if the memory of the first argument may overlap that of
+ * the second, whose type must be alias checkable or a scalar.
+ */
+template <typename T, typename U, require_stan_scalar_t<U>* = nullptr>
+inline bool may_alias(const T& x, const U& y) {
+  return overlaps(x, &y, &y + 1);
+}
+
+template <typename T, typename U, require_eigen_t<U>* = nullptr>
+inline bool may_alias(const T& x, const U& y) {
+  return overlaps(x, &y, &y + 1)
+         || overlaps(x, y.data(), y.data() + y.size());
+}
+
+template <typename T, typename U, require_std_vector_t<U>* = nullptr>
+inline bool may_alias(const T& x, const U& y) {
+  if (overlaps(x, &y, &y + 1) || overlaps(x, y.data(), y.data() + y.size()))
+    return true;
+  if (!is_stan_scalar<value_type_t<U>>::value)
+    for (const auto& y_i : y)
+      if (may_alias(x, y_i))
+        return true;
+  return false;
+}
+
+}  // namespace internal
+
+/**
+ * A value which may alias the variable it is assigned to, returned by
+ * <code>deep_copy()</code> for an lvalue whose memory is known.  It
+ * refers to the value rather than copying it, so that
+ * <code>assign()</code> copies it only if it overlaps the elements
+ * assigned; converting it to its plain type copies it.
+ *
+ * @tparam T type of the value
+ */
+template <typename T>
+class deep_copy_ref {
+ public:
+  explicit deep_copy_ref(const T& x) : x_(x) {}
+
+  /**
+   * Return the value referred to.
+   */
+  const T& get() const noexcept { return x_; }
+
+  /**
+   * Return a copy of the value.
+   */
+  operator plain_type_t<T>() const { return x_; }
+
+ private:
+  const T& x_;
+};
+
+namespace internal {
+template <typename T>
+struct is_deep_copy_ref : std::false_type {};
+
+template <typename T>
+struct is_deep_copy_ref<deep_copy_ref<T>> : std::true_type {};
+}  // namespace internal
+
 /**
  * Return the specified argument as a constant reference.
  *
@@ -26,6 +169,21 @@ inline plain_type_t<T> deep_copy(T&& x) {
   return std::forward<T>(x);
 }
 
+/**
+ * Return a reference to the specified lvalue, an Eigen matrix or a
+ * standard vector, which <code>assign()</code> copies only if it
+ * overlaps the elements assigned.
+ *
+ * @tparam T type of the value
+ * @param x Input value.
+ * @return Reference to the input, which converts to a copy of it.
+ */
+template <typename T,
+          require_t<internal::is_alias_checkable<std::decay_t<T>>>* = nullptr>
+inline deep_copy_ref<std::decay_t<T>> deep_copy(T& x) {
+  return deep_copy_ref<std::decay_t<T>>(x);
+}
+
 }  // namespace model
 }  // namespace stan
 #endif
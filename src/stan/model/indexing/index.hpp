@@ -2,6 +2,8 @@
 #define STAN_MODEL_INDEXING_INDEX_HPP
 
 #include <stan/math/prim/meta.hpp>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace stan {
@@ -31,9 +33,19 @@ struct index_uni {
 /**
  * Structure for an indexing consisting of multiple indexes.  The
  * indexes do not need to be unique or in order.
+ *
+ * Whether the indexes are increasing with a constant stride is found
+ * once, at construction, so indexing with a range of indexes can be
+ * done with blocks instead of one cell at a time.  The indexes are
+ * const so that the stride cannot go stale.
  */
 struct index_multi {
-  std::vector<int> ns_;
+  const std::vector<int> ns_;
+  /**
+   * Difference between consecutive indexes if they are increasing with
+   * a constant difference, and 0 if not or if there are no indexes.
+   */
+  const int stride_;
 
   /**
    * Construct a multiple indexing from the specified indexes.
@@ -41,7 +53,31 @@ struct index_multi {
    * @param ns multiple indexes.
    */
   template <typename T, require_std_vector_vt<std::is_integral, T>* = nullptr>
-  explicit index_multi(T&& ns) noexcept : ns_(std::forward<T>(ns)) {}
+  explicit index_multi(T&& ns) noexcept
+      : ns_(std::forward<T>(ns)), stride_(find_stride(ns_)) {}
+
+  /**
+   * Return whether the indexes are a range of consecutive increasing
+   * indexes, from the first to the last.
+   */
+  inline bool is_contiguous() const noexcept { return stride_ == 1; }
+
+ private:
+  static int find_stride(const std::vector<int>& ns) noexcept {
+    if (ns.size() < 2) {
+      return ns.empty() ? 0 : 1;
+    }
+    const std::int64_t stride = static_cast<std::int64_t>(ns[1]) - ns[0];
+    if (stride <= 0 || stride > std::numeric_limits<int>::max()) {
+      return 0;
+    }
+    for (size_t i = 2; i < ns.size(); ++i) {
+      if (static_cast<std::int64_t>(ns[i]) - ns[i - 1] != stride) {
+        return 0;
+      }
+    }
+    return stride;
+  }
 };
 
 /**
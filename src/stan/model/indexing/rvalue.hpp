@@ -39,6 +39,11 @@ namespace model {
  * Std vector:
  *  - single element and elementwise overloads
  *  - General overload for nested std vectors.
+ * Multiple indexes of Eigen types are checked up front and return
+ * indexed views, which are only evaluated when they are used.  The
+ * views hold a copy of the indexes, which are often temporaries.  Like
+ * the other expressions returned here, they refer to the indexed value,
+ * so assigning them back to it goes through <code>deep_copy()</code>.
  */
 
 /**
@@ -153,16 +158,12 @@ inline auto rvalue(Vec&& v, const char* name, index_uni idx) {
  */
 template <typename EigVec, require_eigen_vector_t<EigVec>* = nullptr>
 inline auto rvalue(EigVec&& v, const char* name, const index_multi& idx) {
+  internal::check_multi("vector[multi] indexing", name, v.size(), idx);
   return stan::math::make_holder(
-      [name, &idx](auto& v_ref) {
-        return plain_type_t<EigVec>::NullaryExpr(
-            idx.ns_.size(), [name, &idx, &v_ref](Eigen::Index i) {
-              math::check_range("vector[multi] indexing", name, v_ref.size(),
-                                idx.ns_[i]);
-              return v_ref.coeff(idx.ns_[i] - 1);
-            });
+      [](auto& v_ref, const auto& ns) {
+        return v_ref(internal::zero_based_multi{&ns});
       },
-      stan::math::to_ref(v));
+      stan::math::to_ref(std::forward<EigVec>(v)), std::vector<int>(idx.ns_));
 }
 
 /**
@@ -263,20 +264,13 @@ inline auto rvalue(Mat&& x, const char* name, index_uni idx) {
  * @throw std::out_of_range If any of the indices are out of bounds.
  */
 template <typename EigMat, require_eigen_dense_dynamic_t<EigMat>* = nullptr>
-inline plain_type_t<EigMat> rvalue(EigMat&& x, const char* name,
-                                   const index_multi& idx) {
-  for (int i = 0; i < idx.ns_.size(); ++i) {
-    math::check_range("matrix[multi] row indexing", name, x.rows(), idx.ns_[i]);
-  }
+inline auto rvalue(EigMat&& x, const char* name, const index_multi& idx) {
+  internal::check_multi("matrix[multi] row indexing", name, x.rows(), idx);
   return stan::math::make_holder(
-      [&idx](auto& x_ref) {
-        return plain_type_t<EigMat>::NullaryExpr(
-            idx.ns_.size(), x_ref.cols(),
-            [&idx, &x_ref](Eigen::Index i, Eigen::Index j) {
-              return x_ref.coeff(idx.ns_[i] - 1, j);
-            });
+      [](auto& x_ref, const auto& ns) {
+        return x_ref(internal::zero_based_multi{&ns}, Eigen::all);
       },
-      stan::math::to_ref(x));
+      stan::math::to_ref(std::forward<EigMat>(x)), std::vector<int>(idx.ns_));
 }
 
 /**
@@ -426,22 +420,18 @@ inline auto rvalue(Mat&& x, const char* name, index_uni row_idx,
  * @throw std::out_of_range If any of the indices are out of bounds.
  */
 template <typename EigMat, require_eigen_dense_dynamic_t<EigMat>* = nullptr>
-inline Eigen::Matrix<value_type_t<EigMat>, 1, Eigen::Dynamic> rvalue(
-    EigMat&& x, const char* name, index_uni row_idx,
-    const index_multi& col_idx) {
+inline auto rvalue(EigMat&& x, const char* name, index_uni row_idx,
+                   const index_multi& col_idx) {
   math::check_range("matrix[uni, multi] row indexing", name, x.rows(),
                     row_idx.n_);
+  internal::check_multi("matrix[uni, multi] column indexing", name, x.cols(),
+                        col_idx);
   return stan::math::make_holder(
-      [name, row_idx, &col_idx](auto& x_ref) {
-        return Eigen::Matrix<value_type_t<EigMat>, 1, Eigen::Dynamic>::
-            NullaryExpr(col_idx.ns_.size(), [name, row_i = row_idx.n_ - 1,
-                                             &col_idx, &x_ref](Eigen::Index i) {
-              math::check_range("matrix[uni, multi] column indexing", name,
-                                x_ref.cols(), col_idx.ns_[i]);
-              return x_ref.coeff(row_i, col_idx.ns_[i] - 1);
-            });
+      [row_i = row_idx.n_ - 1](auto& x_ref, const auto& ns) {
+        return x_ref.row(row_i)(internal::zero_based_multi{&ns});
       },
-      stan::math::to_ref(x));
+      stan::math::to_ref(std::forward<EigMat>(x)),
+      std::vector<int>(col_idx.ns_));
 }
 
 /**
@@ -458,24 +448,18 @@ inline Eigen::Matrix<value_type_t<EigMat>, 1, Eigen::Dynamic> rvalue(
  * @throw std::out_of_range If any of the indices are out of bounds.
  */
 template <typename EigMat, require_eigen_dense_dynamic_t<EigMat>* = nullptr>
-inline Eigen::Matrix<value_type_t<EigMat>, Eigen::Dynamic, 1> rvalue(
-    EigMat&& x, const char* name, const index_multi& row_idx,
-    index_uni col_idx) {
+inline auto rvalue(EigMat&& x, const char* name, const index_multi& row_idx,
+                   index_uni col_idx) {
   math::check_range("matrix[multi, uni] column indexing", name, x.cols(),
                     col_idx.n_);
-
+  internal::check_multi("matrix[multi, uni] row indexing", name, x.rows(),
+                        row_idx);
   return stan::math::make_holder(
-      [name, &row_idx, col_idx](auto& x_ref) {
-        return Eigen::Matrix<value_type_t<EigMat>, Eigen::Dynamic, 1>::
-            NullaryExpr(row_idx.ns_.size(),
-                        [name, &row_idx, col_i = col_idx.n_ - 1,
-                         &x_ref](Eigen::Index i) {
-                          math::check_range("matrix[multi, uni] row indexing",
-                                            name, x_ref.rows(), row_idx.ns_[i]);
-                          return x_ref.coeff(row_idx.ns_[i] - 1, col_i);
-                        });
+      [col_i = col_idx.n_ - 1](auto& x_ref, const auto& ns) {
+        return x_ref.col(col_i)(internal::zero_based_multi{&ns});
       },
-      stan::math::to_ref(x));
+      stan::math::to_ref(std::forward<EigMat>(x)),
+      std::vector<int>(row_idx.ns_));
 }
 
 /**
@@ -492,25 +476,19 @@ inline Eigen::Matrix<value_type_t<EigMat>, Eigen::Dynamic, 1> rvalue(
  * @return Result of indexing matrix.
  */
 template <typename EigMat, require_eigen_dense_dynamic_t<EigMat>* = nullptr>
-inline plain_type_t<EigMat> rvalue(EigMat&& x, const char* name,
-                                   const index_multi& row_idx,
-                                   const index_multi& col_idx) {
-  const auto& x_ref = stan::math::to_ref(x);
-  const Eigen::Index rows = row_idx.ns_.size();
-  const Eigen::Index cols = col_idx.ns_.size();
-  plain_type_t<EigMat> x_ret(rows, cols);
-  for (Eigen::Index j = 0; j < cols; ++j) {
-    for (Eigen::Index i = 0; i < rows; ++i) {
-      const Eigen::Index m = row_idx.ns_[i];
-      const Eigen::Index n = col_idx.ns_[j];
-      math::check_range("matrix[multi,multi] row indexing", name, x_ref.rows(),
-                        m);
-      math::check_range("matrix[multi,multi] column indexing", name,
-                        x_ref.cols(), n);
-      x_ret.coeffRef(i, j) = x_ref.coeff(m - 1, n - 1);
-    }
-  }
-  return x_ret;
+inline auto rvalue(EigMat&& x, const char* name, const index_multi& row_idx,
+                   const index_multi& col_idx) {
+  internal::check_multi("matrix[multi,multi] row indexing", name, x.rows(),
+                        row_idx);
+  internal::check_multi("matrix[multi,multi] column indexing", name, x.cols(),
+                        col_idx);
+  return stan::math::make_holder(
+      [](auto& x_ref, const auto& rows, const auto& cols) {
+        return x_ref(internal::zero_based_multi{&rows},
+                     internal::zero_based_multi{&cols});
+      },
+      stan::math::to_ref(std::forward<EigMat>(x)),
+      std::vector<int>(row_idx.ns_), std::vector<int>(col_idx.ns_));
 }
 
 /**
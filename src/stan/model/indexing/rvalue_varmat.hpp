@@ -39,7 +39,11 @@ namespace model {
  */
 
 /**
- * Return a non-contiguous subset of elements in a vector.
+ * Return a non-contiguous subset of elements in a vector.  A range of
+ * consecutive increasing indexes is copied as a segment, with a single
+ * vectorized update of the adjoints.  If the indexes are sorted, the
+ * adjoints of repeated indexes are summed before the adjoint of the
+ * cell they index is updated, once.
  *
  * Types:  vector[multi] = vector
  *
@@ -54,31 +58,47 @@ namespace model {
  */
 template <typename Vec, require_var_vector_t<Vec>* = nullptr>
 inline auto rvalue(Vec&& x, const char* name, const index_multi& idx) {
-  using stan::math::arena_allocator;
-  using stan::math::check_range;
   using stan::math::reverse_pass_callback;
   using stan::math::var_value;
-  using arena_std_vec = std::vector<int, arena_allocator<int>>;
   const Eigen::Index x_size = x.size();
   const auto ret_size = idx.ns_.size();
-  arena_t<value_type_t<Vec>> x_ret_vals(ret_size);
-  arena_std_vec row_idx(ret_size);
-  for (int i = 0; i < ret_size; ++i) {
-    check_range("vector[multi] assign range", name, x_size, idx.ns_[i]);
-    row_idx[i] = idx.ns_[i] - 1;
-    x_ret_vals.coeffRef(i) = x.vi_->val_.coeff(row_idx[i]);
+  internal::check_multi("vector[multi] indexing", name, x_size, idx);
+  if (idx.is_contiguous()) {
+    const Eigen::Index start = idx.ns_.front() - 1;
+    var_value<plain_type_t<value_type_t<Vec>>> x_ret(
+        x.val().segment(start, ret_size));
+    reverse_pass_callback([x, x_ret, start]() mutable {
+      x.adj().segment(start, x_ret.size()) += x_ret.adj();
+    });
+    return x_ret;
+  }
+  arena_t<std::vector<int>> pos;
+  const bool sorted = internal::multi_positions(idx, pos);
+  var_value<plain_type_t<value_type_t<Vec>>> x_ret(
+      x.val()(internal::view_positions(pos)));
+  if (sorted) {
+    reverse_pass_callback([x, x_ret, pos]() mutable {
+      internal::for_each_run(
+          pos, [&](int p, Eigen::Index start, Eigen::Index size) {
+            x.adj().coeffRef(p) += x_ret.adj().segment(start, size).sum();
+          });
+    });
+  } else {
+    reverse_pass_callback([x, x_ret, pos]() mutable {
+      for (Eigen::Index i = 0; i < x_ret.size(); ++i) {
+        x.adj().coeffRef(pos[i]) += x_ret.adj().coeff(i);
+      }
+    });
   }
-  var_value<plain_type_t<value_type_t<Vec>>> x_ret(x_ret_vals);
-  reverse_pass_callback([x, x_ret, row_idx]() mutable {
-    for (Eigen::Index i = 0; i < row_idx.size(); ++i) {
-      x.adj().coeffRef(row_idx[i]) += x_ret.adj().coeff(i);
-    }
-  });
   return x_ret;
 }
 
 /**
- * Return a non-contiguous subset of elements in a matrix.
+ * Return a non-contiguous subset of elements in a matrix.  A range of
+ * consecutive increasing indexes is copied as a block of rows, with a
+ * single vectorized update of the adjoints.  If the indexes are sorted,
+ * the adjoints of repeated indexes are summed before the adjoints of
+ * the row they index are updated, once.
  *
  * Types:  matrix[multi] = matrix
  *
@@ -91,25 +111,41 @@ inline auto rvalue(Vec&& x, const char* name, const index_multi& idx) {
  */
 template <typename VarMat, require_var_dense_dynamic_t<VarMat>* = nullptr>
 inline auto rvalue(VarMat&& x, const char* name, const index_multi& idx) {
-  using stan::math::arena_allocator;
-  using stan::math::check_range;
   using stan::math::reverse_pass_callback;
   using stan::math::var_value;
-  using arena_std_vec = std::vector<int, arena_allocator<int>>;
   const auto ret_rows = idx.ns_.size();
-  arena_t<value_type_t<VarMat>> x_ret_vals(ret_rows, x.cols());
-  arena_std_vec row_idx(ret_rows);
-  for (int i = 0; i < ret_rows; ++i) {
-    check_range("matrix[multi] subset range", name, x.rows(), idx.ns_[i]);
-    row_idx[i] = idx.ns_[i] - 1;
-    x_ret_vals.row(i) = x.val().row(row_idx[i]);
+  internal::check_multi("matrix[multi] row indexing", name, x.rows(), idx);
+  if (idx.is_contiguous()) {
+    const Eigen::Index start = idx.ns_.front() - 1;
+    var_value<plain_type_t<value_type_t<VarMat>>> x_ret(
+        x.val().middleRows(start, ret_rows));
+    reverse_pass_callback([x, x_ret, start]() mutable {
+      x.adj().middleRows(start, x_ret.rows()) += x_ret.adj();
+    });
+    return x_ret;
+  }
+  arena_t<std::vector<int>> pos;
+  const bool sorted = internal::multi_positions(idx, pos);
+  var_value<plain_type_t<value_type_t<VarMat>>> x_ret(
+      x.val()(internal::view_positions(pos), Eigen::all));
+  if (sorted) {
+    reverse_pass_callback([x, x_ret, pos]() mutable {
+      internal::for_each_run(
+          pos, [&](int p, Eigen::Index start, Eigen::Index size) {
+            x.adj().row(p)
+                += x_ret.adj().middleRows(start, size).colwise().sum();
+          });
+    });
+  } else {
+    reverse_pass_callback([x, x_ret, pos]() mutable {
+      // Column by column, as the matrices are stored
+      for (Eigen::Index j = 0; j < x_ret.cols(); ++j) {
+        for (Eigen::Index i = 0; i < x_ret.rows(); ++i) {
+          x.adj().coeffRef(pos[i], j) += x_ret.adj().coeff(i, j);
+        }
+      }
+    });
   }
-  var_value<plain_type_t<value_type_t<VarMat>>> x_ret(x_ret_vals);
-  reverse_pass_callback([x, x_ret, row_idx]() mutable {
-    for (Eigen::Index i = 0; i < row_idx.size(); ++i) {
-      x.adj().row(row_idx[i]) += x_ret.adj().row(i);
-    }
-  });
   return x_ret;
 }
 
@@ -0,0 +1,139 @@
+#ifndef STAN_MODEL_LOG_PROB_GRAD_BATCH_HPP
+#define STAN_MODEL_LOG_PROB_GRAD_BATCH_HPP
+
+#include <stan/math/rev.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+namespace stan {
+namespace model {
+namespace internal {
+
+/**
+ * Trait detecting whether a model provides its own batched
+ * `log_prob_grad_batch` member template.
+ *
+ * @tparam M Class of model.
+ */
+template <typename M, typename = void>
+struct has_log_prob_grad_batch : std::false_type {};
+
+template <typename M>
+struct has_log_prob_grad_batch<
+    M, decltype(static_cast<void>(
+           std::declval<const M&>().template log_prob_grad_batch<true, true>(
+               std::declval<const Eigen::MatrixXd&>(),
+               std::declval<Eigen::VectorXd&>(),
+               std::declval<Eigen::MatrixXd&>(),
+               std::declval<std::ostream*>())))> : std::true_type {};
+
+}  // namespace internal
+
+/**
+ * Compute the log density and its gradient at every column of the
+ * specified matrix of unconstrained parameters, one reverse-mode
+ * sweep per column.
+ *
+ * This is the fallback used for models that do not provide a
+ * batched implementation of their own.  If evaluation throws for any
+ * column, the exception propagates and the outputs are unspecified.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to
+ * the log probability.
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] params_r Real-valued parameters, one point per column.
+ * @param[out] log_prob Log density at each column.
+ * @param[out] gradient Gradient at each column.
+ * @param[in,out] msgs
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+void log_prob_grad_batch_loop(const M& model, const Eigen::MatrixXd& params_r,
+                              Eigen::VectorXd& log_prob,
+                              Eigen::MatrixXd& gradient,
+                              std::ostream* msgs = 0) {
+  log_prob.resize(params_r.cols());
+  gradient.resize(params_r.rows(), params_r.cols());
+  Eigen::VectorXd theta(params_r.rows());
+  Eigen::VectorXd grad(params_r.rows());
+  for (Eigen::Index k = 0; k < params_r.cols(); ++k) {
+    theta = params_r.col(k);
+    log_prob(k) = log_prob_grad<propto, jacobian_adjust_transform>(
+        model, theta, grad, msgs);
+    gradient.col(k) = grad;
+  }
+}
+
+namespace internal {
+
+template <bool propto, bool jacobian_adjust_transform, class M>
+inline void log_prob_grad_batch_impl(const M& model,
+                                     const Eigen::MatrixXd& params_r,
+                                     Eigen::VectorXd& log_prob,
+                                     Eigen::MatrixXd& gradient,
+                                     std::ostream* msgs, std::true_type) {
+  model.template log_prob_grad_batch<propto, jacobian_adjust_transform>(
+      params_r, log_prob, gradient, msgs);
+}
+
+template <bool propto, bool jacobian_adjust_transform, class M>
+inline void log_prob_grad_batch_impl(const M& model,
+                                     const Eigen::MatrixXd& params_r,
+                                     Eigen::VectorXd& log_prob,
+                                     Eigen::MatrixXd& gradient,
+                                     std::ostream* msgs, std::false_type) {
+  log_prob_grad_batch_loop<propto, jacobian_adjust_transform>(
+      model, params_r, log_prob, gradient, msgs);
+}
+
+}  // namespace internal
+
+/**
+ * Compute the log density and its gradient at every column of the
+ * specified matrix of unconstrained parameters in a single call.
+ *
+ * Models exposing a member template with the signature
+ *
+ * ```
+ * template <bool propto, bool jacobian>
+ * void log_prob_grad_batch(const Eigen::MatrixXd& params_r,
+ *                          Eigen::VectorXd& log_prob,
+ *                          Eigen::MatrixXd& gradient,
+ *                          std::ostream* msgs) const;
+ * ```
+ *
+ * are dispatched to it statically, which lets a model share work
+ * across points (vectorized likelihoods, a single device transfer,
+ * and so on).  All other models are evaluated column by column with
+ * `log_prob_grad_batch_loop`.  If evaluation throws for any column,
+ * the exception propagates and the outputs are unspecified.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to
+ * the log probability.
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] params_r Real-valued parameters, one point per column.
+ * @param[out] log_prob Log density at each column.
+ * @param[out] gradient Gradient at each column.
+ * @param[in,out] msgs
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+void log_prob_grad_batch(const M& model, const Eigen::MatrixXd& params_r,
+                         Eigen::VectorXd& log_prob, Eigen::MatrixXd& gradient,
+                         std::ostream* msgs = 0) {
+  internal::log_prob_grad_batch_impl<propto, jacobian_adjust_transform>(
+      model, params_r, log_prob, gradient, msgs,
+      internal::has_log_prob_grad_batch<M>{});
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -0,0 +1,142 @@
+#ifndef STAN_MODEL_LOG_PROB_GRAD_TERMS_HPP
+#define STAN_MODEL_LOG_PROB_GRAD_TERMS_HPP
+
+#include <stan/callbacks/message_sink.hpp>
+#include <stan/math/rev.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace model {
+namespace internal {
+
+/**
+ * Trait detecting whether a model splits its log density into terms
+ * with `num_log_prob_terms` and a `log_prob_term` member template.
+ *
+ * @tparam M Class of model.
+ */
+template <typename M, typename = void>
+struct has_log_prob_terms : std::false_type {};
+
+template <typename M>
+struct has_log_prob_terms<
+    M, decltype(static_cast<void>(
+           std::declval<const M&>().num_log_prob_terms()
+           + std::declval<const M&>()
+                 .template log_prob_term<true, true>(
+                     std::declval<size_t>(),
+                     std::declval<Eigen::Matrix<math::var, -1, 1>&>(),
+                     std::declval<std::ostream*>())
+                 .val()))> : std::true_type {};
+
+template <bool propto, bool jacobian_adjust_transform, class M>
+inline double log_prob_grad_terms_impl(const M& model,
+                                       Eigen::VectorXd& params_r,
+                                       Eigen::VectorXd& gradient,
+                                       std::ostream* msgs, std::true_type) {
+  const size_t num_terms = model.num_log_prob_terms();
+  if (num_terms <= 1)
+    return log_prob_grad<propto, jacobian_adjust_transform>(model, params_r,
+                                                            gradient, msgs);
+
+  // One column per term, summed in order so the result does not depend
+  // on the scheduling
+  Eigen::VectorXd term_lp(num_terms);
+  Eigen::MatrixXd term_gradient(params_r.size(), num_terms);
+  std::vector<callbacks::message_sink> term_msgs(msgs ? num_terms : 0);
+  auto write_msgs = [&]() {
+    for (auto& term_msg : term_msgs)
+      *msgs << term_msg.str();
+  };
+  try {
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_terms),
+        [&](const tbb::blocked_range<size_t>& r) {
+          for (size_t k = r.begin(); k != r.end(); ++k) {
+            stan::math::nested_rev_autodiff nested;
+            Eigen::Matrix<math::var, -1, 1> ad_params_r
+                = params_r.template cast<math::var>();
+            math::var lp = model.template log_prob_term<
+                propto, jacobian_adjust_transform>(
+                k, ad_params_r, msgs ? &term_msgs[k] : nullptr);
+            lp.grad();
+            term_lp(k) = lp.val();
+            term_gradient.col(k) = ad_params_r.adj();
+          }
+        });
+  } catch (...) {
+    write_msgs();
+    throw;
+  }
+  write_msgs();
+  gradient = term_gradient.rowwise().sum();
+  return term_lp.sum();
+}
+
+template <bool propto, bool jacobian_adjust_transform, class M>
+inline double log_prob_grad_terms_impl(const M& model,
+                                       Eigen::VectorXd& params_r,
+                                       Eigen::VectorXd& gradient,
+                                       std::ostream* msgs, std::false_type) {
+  return log_prob_grad<propto, jacobian_adjust_transform>(model, params_r,
+                                                          gradient, msgs);
+}
+
+}  // namespace internal
+
+/**
+ * Compute the log density and its gradient, evaluating the terms of a
+ * model whose log density is a sum of separately computable terms in
+ * parallel.
+ *
+ * Models whose likelihood factors over groups may declare
+ *
+ * ```
+ * size_t num_log_prob_terms() const;
+ *
+ * template <bool propto, bool jacobian, typename T>
+ * T log_prob_term(size_t k, Eigen::Matrix<T, -1, 1>& params_r,
+ *                 std::ostream* msgs) const;
+ * ```
+ *
+ * such that the terms `k = 0, ..., num_log_prob_terms() - 1` sum to
+ * `log_prob<propto, jacobian>`; the prior and the Jacobian go into one
+ * of them.  The terms are then differentiated on separate TBB workers,
+ * each on its own nested reverse-mode tape, which requires building
+ * with `STAN_THREADS`.  The gradient of each term is kept and the
+ * terms are summed in order, so the result does not depend on the
+ * number of threads.  Each term costs a full gradient of memory and
+ * one sweep over the parameters, so terms should be coarse, e.g. one
+ * per group and not one per observation.  Models with one term or
+ * without the members are evaluated with `log_prob_grad`.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to
+ * the log probability.
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @param[in] params_r Real-valued parameters.
+ * @param[out] gradient Vector into which gradient is written.
+ * @param[in,out] msgs
+ * @return log density
+ */
+template <bool propto, bool jacobian_adjust_transform, class M>
+double log_prob_grad_terms(const M& model, Eigen::VectorXd& params_r,
+                           Eigen::VectorXd& gradient, std::ostream* msgs = 0) {
+  return internal::log_prob_grad_terms_impl<propto,
+                                            jacobian_adjust_transform>(
+      model, params_r, gradient, msgs, internal::has_log_prob_terms<M>());
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -72,19 +72,16 @@ double log_prob_propto(const M& model, std::vector<double>& params_r,
  * @param[in,out] msgs
  */
 template <bool jacobian_adjust_transform, class M>
-double log_prob_propto(const M& model, Eigen::VectorXd& params_r,
+double log_prob_propto(const M& model, const Eigen::VectorXd& params_r,
                        std::ostream* msgs = 0) {
   using stan::math::var;
-  using std::vector;
-  vector<int> params_i(0);
   try {
-    vector<var> ad_params_r;
-    ad_params_r.reserve(model.num_params_r());
+    Eigen::Matrix<var, Eigen::Dynamic, 1> ad_params_r(params_r.size());
     for (size_t i = 0; i < model.num_params_r(); ++i)
-      ad_params_r.push_back(params_r(i));
+      ad_params_r(i) = params_r(i);
     double lp = model
                     .template log_prob<true, jacobian_adjust_transform>(
-                        ad_params_r, params_i, msgs)
+                        ad_params_r, msgs)
                     .val();
     stan::math::recover_memory();
     return lp;
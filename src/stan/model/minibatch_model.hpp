@@ -0,0 +1,196 @@
+#ifndef STAN_MODEL_MINIBATCH_MODEL_HPP
+#define STAN_MODEL_MINIBATCH_MODEL_HPP
+
+#include <stan/math/rev.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace model {
+namespace internal {
+
+/**
+ * Trait detecting whether a model splits its log density into a log
+ * prior and a log likelihood summed over rows of data, with
+ * `num_minibatch_rows`, `log_prior` and `log_likelihood_rows`.
+ *
+ * @tparam M Class of model.
+ */
+template <typename M, typename = void>
+struct has_minibatch_log_prob : std::false_type {};
+
+template <typename M>
+struct has_minibatch_log_prob<
+    M, decltype(static_cast<void>(
+           std::declval<const M&>().num_minibatch_rows()
+           + std::declval<const M&>()
+                 .template log_prior<true, true>(
+                     std::declval<Eigen::Matrix<math::var, -1, 1>&>(),
+                     std::declval<std::ostream*>())
+                 .val()
+           + std::declval<const M&>()
+                 .template log_likelihood_rows<true>(
+                     std::declval<const std::vector<size_t>&>(),
+                     std::declval<Eigen::Matrix<math::var, -1, 1>&>(),
+                     std::declval<std::ostream*>())
+                 .val()))> : std::true_type {};
+
+template <class M>
+inline size_t num_minibatch_rows_impl(const M& model, std::true_type) {
+  return model.num_minibatch_rows();
+}
+
+template <class M>
+inline size_t num_minibatch_rows_impl(const M& model, std::false_type) {
+  return 0;
+}
+
+}  // namespace internal
+
+/**
+ * Return the number of rows of data a model's likelihood sums over, or
+ * zero if the model cannot evaluate its likelihood on a subset of them.
+ *
+ * @tparam M Class of model.
+ * @param[in] model Model.
+ * @return number of rows
+ */
+template <class M>
+inline size_t num_minibatch_rows(const M& model) {
+  return internal::num_minibatch_rows_impl(
+      model, internal::has_minibatch_log_prob<M>());
+}
+
+/**
+ * A view of a model whose log density is an unbiased estimate of the
+ * model's, computed from a minibatch of its rows of data, for
+ * stochastic variational inference.
+ *
+ * Models whose likelihood is a sum over independent rows of data may
+ * declare
+ *
+ * ```
+ * size_t num_minibatch_rows() const;
+ *
+ * template <bool propto, bool jacobian, typename T>
+ * T log_prior(Eigen::Matrix<T, -1, 1>& params_r,
+ *             std::ostream* msgs) const;
+ *
+ * template <bool propto, typename T>
+ * T log_likelihood_rows(const std::vector<size_t>& rows,
+ *                       Eigen::Matrix<T, -1, 1>& params_r,
+ *                       std::ostream* msgs) const;
+ * ```
+ *
+ * such that `log_prior` plus `log_likelihood_rows` of all the rows is
+ * `log_prob`.  The log density of the view is the log prior plus the
+ * log likelihood of the `batch_size` rows drawn by `draw_rows`, scaled
+ * by the number of rows over the batch size.  As the rows are drawn
+ * uniformly without replacement, its expectation and that of its
+ * gradient are those of the model, at a cost proportional to the batch
+ * size instead of the number of rows.
+ *
+ * The view has the `log_prob` member template and `num_params_r` used
+ * by `stan::model::gradient` and `stan::model::log_prob_grad`, and keeps
+ * a reference to the model, which must outlive it.
+ *
+ * @tparam M Class of model.
+ */
+template <class M>
+class minibatch_model {
+ public:
+  /**
+   * @param[in] model Model, with `num_minibatch_rows()` positive
+   * @param[in] batch_size Number of rows in each minibatch, at most the
+   * number of rows of the model
+   * @throw std::invalid_argument if the model has no rows or the batch
+   * size is zero or exceeds the number of rows
+   */
+  minibatch_model(const M& model, size_t batch_size)
+      : model_(model), num_rows_(num_minibatch_rows(model)) {
+    if (num_rows_ == 0)
+      throw std::invalid_argument(
+          "minibatch_model: model does not declare rows of data");
+    if (batch_size == 0 || batch_size > num_rows_)
+      throw std::invalid_argument(
+          "minibatch_model: batch size must be between 1 and the number "
+          "of rows of data");
+    rows_.resize(batch_size);
+    for (size_t n = 0; n < batch_size; ++n)
+      rows_[n] = n;
+  }
+
+  /**
+   * Draw the rows of the next minibatch uniformly without replacement,
+   * with Floyd's algorithm, so that drawing costs in proportion to the
+   * batch size.  The rows are sorted, so that the model reads its data
+   * in order.
+   *
+   * @tparam RNG Class of random number generator
+   * @param[in,out] rng random number generator
+   */
+  template <class RNG>
+  void draw_rows(RNG& rng) {
+    const size_t batch_size = rows_.size();
+    std::unordered_set<size_t> drawn;
+    drawn.reserve(batch_size);
+    for (size_t j = num_rows_ - batch_size; j < num_rows_; ++j) {
+      const size_t t
+          = boost::random::uniform_int_distribution<size_t>(0, j)(rng);
+      if (!drawn.insert(t).second)
+        drawn.insert(j);
+    }
+    rows_.assign(drawn.begin(), drawn.end());
+    std::sort(rows_.begin(), rows_.end());
+  }
+
+  /**
+   * Return the rows of the current minibatch.
+   */
+  const std::vector<size_t>& rows() const { return rows_; }
+
+  /**
+   * Return the number of rows of the model.
+   */
+  size_t num_rows() const { return num_rows_; }
+
+  /**
+   * Return the number of unconstrained parameters of the model.
+   */
+  size_t num_params_r() const { return model_.num_params_r(); }
+
+  /**
+   * Return the estimate of the log density from the current minibatch.
+   *
+   * @tparam propto `true` if normalizing constants may be dropped
+   * @tparam jacobian `true` if the Jacobian adjustment is included
+   * @tparam T scalar type of the parameters
+   * @param[in] params_r unconstrained parameters
+   * @param[in,out] msgs message stream
+   * @return estimate of the log density for specified parameters
+   */
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, -1, 1>& params_r,
+             std::ostream* msgs = nullptr) const {
+    const double scale = static_cast<double>(num_rows_) / rows_.size();
+    return model_.template log_prior<propto, jacobian>(params_r, msgs)
+           + scale
+                 * model_.template log_likelihood_rows<propto>(rows_,
+                                                               params_r, msgs);
+  }
+
+ private:
+  const M& model_;
+  const size_t num_rows_;
+  std::vector<size_t> rows_;
+};
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -32,6 +32,19 @@ namespace model {
  *<p>The approach to defining models used by the Stan language code
  * generator is use the curiously recursive template base class defined
  * in the extension `stan::model::model_base_crtp`.
+ *
+ * <p><i>Thread safety:</i> A model holds its data and transformed data,
+ * which are fixed at construction.  Every `const` method must be safe
+ * to call concurrently on the same instance from several threads, so
+ * a model may not keep `mutable` scratch space or caches, and must
+ * only write through its arguments.  Each calling thread supplies its
+ * own parameters, random number generator and message stream, and
+ * evaluates reverse-mode autodiff on its own thread-local stack, which
+ * requires Stan Math to be built with `STAN_THREADS`.  The multi-chain
+ * services rely on this to run all chains on a single model instance,
+ * so one copy of the data serves every chain;
+ * `stan::model::test_concurrent_log_prob_grad` checks it for a given
+ * model.
  */
 class model_base : public prob_grad {
  public:
@@ -2,10 +2,14 @@
 #define STAN_MODEL_MODEL_BASE_CRTP_HPP
 
 #include <stan/model/model_base.hpp>
+#include <stan/model/double_arena.hpp>
+#include <stan/model/log_prob_grad_batch.hpp>
+#include <stan/model/log_prob_grad_terms.hpp>
 #ifdef STAN_MODEL_FVAR_VAR
 #include <stan/math/mix.hpp>
 #endif
 #include <iostream>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -67,6 +71,14 @@ namespace model {
  * general, the template parameter `M` for this class is called the
  * derived class, and must be declared to extend `foo_model<M>`.
  *
+ * <p>The `double` evaluations made through the virtual methods run in a
+ * `double_arena_scope`, so that the model may allocate its temporaries
+ * in `double_arena()`, which is reset after each call.
+ *
+ * <p>The template methods must be `const` and follow the thread safety
+ * contract of `model_base`: they may be called concurrently on the same
+ * instance, so they may not modify the model.
+ *
  * @tparam M type of derived model, which must implemented the
  * template methods defined in the class documentation
  */
@@ -90,6 +102,7 @@ class model_base_crtp : public stan::model::model_base {
 
   inline double log_prob(Eigen::VectorXd& theta,
                          std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<false, false, double>(
         theta, msgs);
   }
@@ -101,6 +114,7 @@ class model_base_crtp : public stan::model::model_base {
 
   inline double log_prob_jacobian(Eigen::VectorXd& theta,
                                   std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<false, true>(theta,
                                                                        msgs);
   }
@@ -112,6 +126,7 @@ class model_base_crtp : public stan::model::model_base {
 
   inline double log_prob_propto(Eigen::VectorXd& theta,
                                 std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<true, false>(theta,
                                                                        msgs);
   }
@@ -123,6 +138,7 @@ class model_base_crtp : public stan::model::model_base {
 
   inline double log_prob_propto_jacobian(Eigen::VectorXd& theta,
                                          std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<true, true>(theta,
                                                                       msgs);
   }
@@ -137,6 +153,7 @@ class model_base_crtp : public stan::model::model_base {
                    Eigen::VectorXd& vars, bool include_tparams = true,
                    bool include_gqs = true,
                    std::ostream* msgs = 0) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->write_array(
         rng, theta, vars, include_tparams, include_gqs, msgs);
   }
@@ -153,6 +170,7 @@ class model_base_crtp : public stan::model::model_base {
 
   inline double log_prob(std::vector<double>& theta, std::vector<int>& theta_i,
                          std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<false, false>(
         theta, theta_i, msgs);
   }
@@ -166,6 +184,7 @@ class model_base_crtp : public stan::model::model_base {
   inline double log_prob_jacobian(std::vector<double>& theta,
                                   std::vector<int>& theta_i,
                                   std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<false, true>(
         theta, theta_i, msgs);
   }
@@ -179,6 +198,7 @@ class model_base_crtp : public stan::model::model_base {
   inline double log_prob_propto(std::vector<double>& theta,
                                 std::vector<int>& theta_i,
                                 std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<true, false>(
         theta, theta_i, msgs);
   }
@@ -192,6 +212,7 @@ class model_base_crtp : public stan::model::model_base {
   inline double log_prob_propto_jacobian(std::vector<double>& theta,
                                          std::vector<int>& theta_i,
                                          std::ostream* msgs) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->template log_prob<true, true>(
         theta, theta_i, msgs);
   }
@@ -206,6 +227,7 @@ class model_base_crtp : public stan::model::model_base {
                    std::vector<int>& theta_i, std::vector<double>& vars,
                    bool include_tparams = true, bool include_gqs = true,
                    std::ostream* msgs = 0) const override {
+    double_arena_scope scope;
     return static_cast<const M*>(this)->write_array(
         rng, theta, theta_i, vars, include_tparams, include_gqs, msgs);
   }
@@ -217,6 +239,36 @@ class model_base_crtp : public stan::model::model_base {
                                                           params_r, msgs);
   }
 
+  /**
+   * Convert every row of the specified matrix of constrained
+   * parameters to unconstrained parameters, written to the same row of
+   * the output, which is resized to one column per unconstrained
+   * parameter.  The rows are converted one at a time with the vector
+   * overload, reusing one pair of buffers.
+   *
+   * <p>This overload is not virtual and is hidden by the
+   * `unconstrain_array` of the derived model; call it through a
+   * reference to this class.
+   *
+   * @param[in] params_r_constrained constrained parameters, one draw
+   * per row
+   * @param[out] params_r unconstrained parameters, one draw per row
+   * @param[in,out] msgs message stream
+   */
+  inline void unconstrain_array(const Eigen::MatrixXd& params_r_constrained,
+                                Eigen::MatrixXd& params_r,
+                                std::ostream* msgs = nullptr) const {
+    params_r.resize(params_r_constrained.rows(), this->num_params_r());
+    Eigen::VectorXd constrained(params_r_constrained.cols());
+    Eigen::VectorXd unconstrained(this->num_params_r());
+    for (Eigen::Index i = 0; i < params_r_constrained.rows(); ++i) {
+      constrained = params_r_constrained.row(i).transpose();
+      static_cast<const M*>(this)->unconstrain_array(constrained,
+                                                     unconstrained, msgs);
+      params_r.row(i) = unconstrained.transpose();
+    }
+  }
+
   void transform_inits(const io::var_context& context,
                        Eigen::VectorXd& params_r,
                        std::ostream* msgs) const override {
@@ -224,6 +276,172 @@ class model_base_crtp : public stan::model::model_base {
                                                         msgs);
   }
 
+  /**
+   * Compute the log density and its gradient at every column of the
+   * specified matrix of unconstrained parameters.
+   *
+   * <p>This default evaluates the columns one at a time.  A derived
+   * model that can share work across points may declare a member
+   * template with the same signature, which hides this one and is
+   * picked up statically by `stan::model::log_prob_grad_batch`.
+   *
+   * @tparam propto `true` if normalizing constants may be dropped
+   * @tparam jacobian `true` if the Jacobian adjustment is included
+   * @param[in] params_r unconstrained parameters, one point per column
+   * @param[out] log_prob log density at each column
+   * @param[out] gradient gradient at each column
+   * @param[in,out] msgs message stream
+   */
+  template <bool propto, bool jacobian>
+  inline void log_prob_grad_batch(const Eigen::MatrixXd& params_r,
+                                  Eigen::VectorXd& log_prob,
+                                  Eigen::MatrixXd& gradient,
+                                  std::ostream* msgs = nullptr) const {
+    stan::model::log_prob_grad_batch_loop<propto, jacobian>(
+        *static_cast<const M*>(this), params_r, log_prob, gradient, msgs);
+  }
+
+  /**
+   * Return the number of terms the log density is split into for
+   * `stan::model::log_prob_grad_terms`.
+   *
+   * <p>This default returns one, the whole log density.  A derived
+   * model whose likelihood factors over groups may declare this member
+   * together with `log_prob_term`, hiding both, to have the terms
+   * differentiated in parallel.
+   *
+   * @return number of terms
+   */
+  inline size_t num_log_prob_terms() const { return 1; }
+
+  /**
+   * Return the specified term of the log density.  The terms of a
+   * model sum to its log density.
+   *
+   * <p>This default returns the whole log density for the single term.
+   *
+   * @tparam propto `true` if normalizing constants may be dropped
+   * @tparam jacobian `true` if the Jacobian adjustment is included
+   * @tparam T scalar type of the parameters
+   * @param[in] k index of the term
+   * @param[in] params_r unconstrained parameters
+   * @param[in,out] msgs message stream
+   * @return term of the log density for specified parameters
+   */
+  template <bool propto, bool jacobian, typename T>
+  inline T log_prob_term(size_t k, Eigen::Matrix<T, -1, 1>& params_r,
+                         std::ostream* msgs = nullptr) const {
+    return static_cast<const M*>(this)->template log_prob<propto, jacobian>(
+        params_r, msgs);
+  }
+
+  /**
+   * Write a snapshot of the data state of the model, its data and
+   * transformed data, from which `read_data_snapshot` restores an
+   * identical model without running the constructor.
+   *
+   * <p>This default writes nothing and returns `false`, as the model
+   * cannot be restored from a snapshot.  A derived model whose
+   * transformed data are expensive to compute may declare this member
+   * together with a static `read_data_snapshot`, hiding both, to be
+   * restored by `stan::services::util::construct_model`.
+   *
+   * @param[in,out] out binary stream to write the snapshot to
+   * @return `true` if the snapshot was written
+   */
+  inline bool write_data_snapshot(std::ostream& out) const { return false; }
+
+  /**
+   * Return a model restored from a snapshot written by
+   * `write_data_snapshot`, or a null pointer if the model cannot be
+   * restored from a snapshot.
+   *
+   * <p>This default reads nothing and returns a null pointer.
+   *
+   * @param[in,out] in binary stream to read the snapshot from
+   * @return restored model
+   */
+  static std::unique_ptr<M> read_data_snapshot(std::istream& in) {
+    return nullptr;
+  }
+
+  /**
+   * Replace the data of the model with the specified data, which has
+   * the same dimensions as the data the model was constructed with,
+   * and recompute the transformed data, reusing the storage of the
+   * model instead of constructing a new one.
+   *
+   * <p>This default rebinds nothing and returns `false`.  A derived
+   * model refitted to a stream of batches of data may declare this
+   * member, hiding it, to be rebound by
+   * `stan::services::util::rebind_model`; it returns `false`, leaving
+   * the model unchanged, if the dimensions of the data differ, and
+   * validates the values of the data as its constructor does.
+   *
+   * @param[in] data new data of the model
+   * @param[in,out] msgs message stream
+   * @return `true` if the data was rebound
+   */
+  inline bool rebind_data(const io::var_context& data,
+                          std::ostream* msgs = nullptr) {
+    return false;
+  }
+
+  /**
+   * Return the number of rows of data the likelihood sums over for
+   * `stan::model::minibatch_model`.
+   *
+   * <p>This default returns zero, as the likelihood cannot be
+   * evaluated on a subset of the data.  A derived model whose
+   * likelihood is a sum over independent rows may declare this member
+   * together with `log_prior` and `log_likelihood_rows`, hiding all
+   * three, to be fit by stochastic variational inference.
+   *
+   * @return number of rows
+   */
+  inline size_t num_minibatch_rows() const { return 0; }
+
+  /**
+   * Return the log density without the terms of the rows of data,
+   * that is the log prior, with the Jacobian if `jacobian` is `true`.
+   *
+   * <p>This default returns the whole log density.
+   *
+   * @tparam propto `true` if normalizing constants may be dropped
+   * @tparam jacobian `true` if the Jacobian adjustment is included
+   * @tparam T scalar type of the parameters
+   * @param[in] params_r unconstrained parameters
+   * @param[in,out] msgs message stream
+   * @return log prior for specified parameters
+   */
+  template <bool propto, bool jacobian, typename T>
+  inline T log_prior(Eigen::Matrix<T, -1, 1>& params_r,
+                     std::ostream* msgs = nullptr) const {
+    return static_cast<const M*>(this)->template log_prob<propto, jacobian>(
+        params_r, msgs);
+  }
+
+  /**
+   * Return the sum of the log likelihood of the specified rows of
+   * data.  With all the rows, it adds to `log_prior` to make the log
+   * density.
+   *
+   * <p>This default returns zero, as no rows are declared.
+   *
+   * @tparam propto `true` if normalizing constants may be dropped
+   * @tparam T scalar type of the parameters
+   * @param[in] rows indexes of the rows, sorted, without duplicates
+   * @param[in] params_r unconstrained parameters
+   * @param[in,out] msgs message stream
+   * @return log likelihood of the rows for specified parameters
+   */
+  template <bool propto, typename T>
+  inline T log_likelihood_rows(const std::vector<size_t>& rows,
+                               Eigen::Matrix<T, -1, 1>& params_r,
+                               std::ostream* msgs = nullptr) const {
+    return T(0);
+  }
+
 #ifdef STAN_MODEL_FVAR_VAR
 
   /**
@@ -0,0 +1,148 @@
+#ifndef STAN_MODEL_MODEL_METADATA_HPP
+#define STAN_MODEL_MODEL_METADATA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Names and dimensions of the constrained variables of a model, built
+ * once and shared by reference by the writers of every chain and
+ * service run with the model.
+ *
+ * A model builds a new string for every scalar each time its names are
+ * requested, so for a model with a million columns every chain and
+ * every service writing a header builds a million strings.  The
+ * metadata holds them once, in the order of the model: parameters,
+ * transformed parameters, then generated quantities.  Its members
+ * have the signatures of those of the model, so that code templated
+ * on the model which only asks for names and dimensions, such as
+ * <code>gq_writer::write_gq_names</code>, also takes the metadata.
+ *
+ * The metadata is immutable once constructed, so it may be read by
+ * several threads at once.  It must not outlive changes to the
+ * dimensions of the model, such as rebinding data of other sizes.
+ */
+class model_metadata {
+ public:
+  /**
+   * Build the metadata of the model.
+   *
+   * @tparam Model type of model
+   * @param[in] model model
+   */
+  template <class Model>
+  explicit model_metadata(const Model& model)
+      : model_name_(model.model_name()) {
+    model.constrained_param_names(names_, true, true);
+    model.get_dims(dims_, true, true);
+
+    // The sizes of the blocks come from their dimensions, without
+    // building their names again, unless those do not add up
+    std::vector<std::vector<size_t>> dims;
+    model.get_dims(dims, false, false);
+    num_param_vars_ = dims.size();
+    num_params_ = num_scalars(dims);
+    model.get_dims(dims, true, false);
+    num_tparam_vars_ = dims.size() - num_param_vars_;
+    num_tparams_ = num_scalars(dims) - num_params_;
+    if (num_scalars(dims_) != names_.size()) {
+      std::vector<std::string> names;
+      model.constrained_param_names(names, false, false);
+      num_params_ = names.size();
+      names.clear();
+      model.constrained_param_names(names, true, false);
+      num_tparams_ = names.size() - num_params_;
+    }
+  }
+
+  const std::string& model_name() const noexcept { return model_name_; }
+
+  /**
+   * Return the names of every constrained variable.
+   */
+  const std::vector<std::string>& constrained_param_names() const noexcept {
+    return names_;
+  }
+
+  /**
+   * Append the names of the constrained variables of the specified
+   * blocks to the specified sequence, as the model would.
+   *
+   * @param[in,out] names sequence the names are appended to
+   * @param[in] include_tparams true to include the transformed
+   *   parameters
+   * @param[in] include_gqs true to include the generated quantities
+   */
+  void constrained_param_names(std::vector<std::string>& names,
+                               bool include_tparams = true,
+                               bool include_gqs = true) const {
+    const auto params_end = names_.begin() + num_params_;
+    const auto tparams_end = params_end + num_tparams_;
+    names.reserve(names.size()
+                  + num_constrained_params(include_tparams, include_gqs));
+    names.insert(names.end(), names_.begin(),
+                 include_tparams ? tparams_end : params_end);
+    if (include_gqs)
+      names.insert(names.end(), tparams_end, names_.end());
+  }
+
+  /**
+   * Set the specified sequence to the dimensions of the constrained
+   * variables of the specified blocks, as the model would.
+   *
+   * @param[out] dimss dimensions of each variable
+   * @param[in] include_tparams true to include the transformed
+   *   parameters
+   * @param[in] include_gqs true to include the generated quantities
+   */
+  void get_dims(std::vector<std::vector<size_t>>& dimss,
+                bool include_tparams = true, bool include_gqs = true) const {
+    const auto params_end = dims_.begin() + num_param_vars_;
+    const auto tparams_end = params_end + num_tparam_vars_;
+    dimss.assign(dims_.begin(), include_tparams ? tparams_end : params_end);
+    if (include_gqs)
+      dimss.insert(dimss.end(), tparams_end, dims_.end());
+  }
+
+  /**
+   * Return the number of scalars of the constrained variables of the
+   * specified blocks.
+   *
+   * @param[in] include_tparams true to include the transformed
+   *   parameters
+   * @param[in] include_gqs true to include the generated quantities
+   */
+  size_t num_constrained_params(bool include_tparams = true,
+                                bool include_gqs = true) const noexcept {
+    return num_params_ + (include_tparams ? num_tparams_ : 0)
+           + (include_gqs ? names_.size() - num_params_ - num_tparams_ : 0);
+  }
+
+ private:
+  std::string model_name_;
+  std::vector<std::string> names_;
+  std::vector<std::vector<size_t>> dims_;
+  size_t num_params_;
+  size_t num_tparams_;
+  size_t num_param_vars_;
+  size_t num_tparam_vars_;
+
+  static size_t num_scalars(const std::vector<std::vector<size_t>>& dimss) {
+    size_t n = 0;
+    for (const std::vector<size_t>& dims : dimss) {
+      size_t size = 1;
+      for (size_t d : dims)
+        size *= d;
+      n += size;
+    }
+    return n;
+  }
+};
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -0,0 +1,169 @@
+#ifndef STAN_MODEL_PROFILE_DATA_HPP
+#define STAN_MODEL_PROFILE_DATA_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/math/rev.hpp>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace stan {
+namespace model {
+
+namespace internal {
+inline stan::math::profile_map*& registered_profile_data() {
+  static stan::math::profile_map* profiles = nullptr;
+  return profiles;
+}
+}  // namespace internal
+
+/**
+ * Register the map the <code>profile</code> blocks of the model record
+ * their timings in, so that the services write the timings of every
+ * run.  The generated code of a model keeps the map in its own
+ * namespace and returns it from <code>get_stan_profile_data()</code>;
+ * interfaces register it once, before running any service.  Passing
+ * null stops the services from reading it.
+ *
+ * @param[in] profiles profile map of the model, or null
+ */
+inline void set_profile_data(stan::math::profile_map* profiles) {
+  internal::registered_profile_data() = profiles;
+}
+
+/**
+ * Return the registered profile map, or null if none is registered.
+ */
+inline stan::math::profile_map* profile_data() {
+  return internal::registered_profile_data();
+}
+
+/**
+ * Totals of one <code>profile</code> block on one thread, as kept by
+ * <code>stan::math::profile_info</code>.  Times are in seconds.
+ */
+struct profile_totals {
+  double fwd_time = 0;
+  double rev_time = 0;
+  std::size_t ad_fwd_passes = 0;
+  std::size_t no_ad_fwd_passes = 0;
+  std::size_t rev_passes = 0;
+  std::size_t chain_stack = 0;
+  std::size_t nochain_stack = 0;
+};
+
+/**
+ * Totals of the <code>profile</code> blocks of a model on one thread,
+ * keyed by the name of the block.
+ *
+ * The profile map of Stan Math accumulates over the whole process, with
+ * one entry per block and thread, so a snapshot is taken at the start
+ * and at the end of each phase of a run and the record written is their
+ * difference.  A chain, path or optimization runs on the thread that
+ * took the snapshot; blocks running on other threads on its behalf,
+ * such as the partial sums of <code>reduce_sum</code>, are not counted,
+ * and neither is work stolen by the thread from other tasks while it
+ * waits on them.
+ */
+class profile_snapshot {
+ public:
+  profile_snapshot() {}
+
+  /**
+   * Take a snapshot of the totals of the calling thread in the
+   * registered profile map, which is empty if none is registered.
+   */
+  static profile_snapshot current_thread() {
+    profile_snapshot snapshot;
+    stan::math::profile_map* profiles = profile_data();
+    if (profiles == nullptr)
+      return snapshot;
+    const std::thread::id thread = std::this_thread::get_id();
+    for (auto& entry : *profiles) {
+      if (entry.first.second != thread)
+        continue;
+      // The accessors of profile_info are not const
+      stan::math::profile_info info = entry.second;
+      profile_totals& totals = snapshot.totals_[entry.first.first];
+      totals.fwd_time = info.get_fwd_time();
+      totals.rev_time = info.get_rev_time();
+      totals.ad_fwd_passes = info.get_num_AD_fwd_passes();
+      totals.no_ad_fwd_passes = info.get_num_no_AD_fwd_passes();
+      totals.rev_passes = info.get_num_rev_passes();
+      totals.chain_stack = info.get_chain_stack_used();
+      totals.nochain_stack = info.get_nochain_stack_used();
+    }
+    return snapshot;
+  }
+
+  /**
+   * Return the totals accumulated since the specified earlier snapshot
+   * of the same thread.
+   *
+   * @param[in] start earlier snapshot
+   */
+  profile_snapshot since(const profile_snapshot& start) const {
+    profile_snapshot diff(*this);
+    for (auto& entry : diff.totals_) {
+      auto found = start.totals_.find(entry.first);
+      if (found == start.totals_.end())
+        continue;
+      const profile_totals& before = found->second;
+      profile_totals& totals = entry.second;
+      totals.fwd_time -= before.fwd_time;
+      totals.rev_time -= before.rev_time;
+      totals.ad_fwd_passes -= before.ad_fwd_passes;
+      totals.no_ad_fwd_passes -= before.no_ad_fwd_passes;
+      totals.rev_passes -= before.rev_passes;
+      totals.chain_stack -= before.chain_stack;
+      totals.nochain_stack -= before.nochain_stack;
+    }
+    return diff;
+  }
+
+  /**
+   * Return the totals keyed by the name of the block.
+   */
+  const std::map<std::string, profile_totals>& totals() const {
+    return totals_;
+  }
+
+  /**
+   * Write the totals as a record with the specified key, holding one
+   * record per block with the total, forward and reverse pass times,
+   * the numbers of forward passes with and without autodiff and of
+   * reverse passes, and the sizes of the chaining and non-chaining
+   * stacks.  Nothing is written when no profile map is registered.
+   *
+   * @param[in,out] writer structured writer receiving the record
+   * @param[in] key name of the record
+   */
+  void write(callbacks::structured_writer& writer,
+             const std::string& key) const {
+    if (profile_data() == nullptr)
+      return;
+    writer.begin_record(key);
+    for (const auto& entry : totals_) {
+      const profile_totals& totals = entry.second;
+      writer.begin_record(entry.first);
+      writer.write("total_time", totals.fwd_time + totals.rev_time);
+      writer.write("forward_time", totals.fwd_time);
+      writer.write("reverse_time", totals.rev_time);
+      writer.write("autodiff_calls", totals.ad_fwd_passes);
+      writer.write("no_autodiff_calls", totals.no_ad_fwd_passes);
+      writer.write("reverse_calls", totals.rev_passes);
+      writer.write("chain_stack", totals.chain_stack);
+      writer.write("no_chain_stack", totals.nochain_stack);
+      writer.end_record();
+    }
+    writer.end_record();
+  }
+
+ private:
+  std::map<std::string, profile_totals> totals_;
+};
+
+}  // namespace model
+}  // namespace stan
+#endif
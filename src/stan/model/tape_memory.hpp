@@ -0,0 +1,177 @@
+#ifndef STAN_MODEL_TAPE_MEMORY_HPP
+#define STAN_MODEL_TAPE_MEMORY_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
+#include <stan/math/rev.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+
+namespace stan {
+namespace model {
+
+/**
+ * Size of the reverse-mode tape of the calling thread: the bytes of the
+ * arena blocks in use, which counts the last block in full, and the
+ * number of vars on the chaining and non-chaining stacks.
+ */
+struct tape_usage {
+  std::size_t bytes = 0;
+  std::size_t vars = 0;
+
+  /**
+   * Keep the larger of each size of this and the specified usage.
+   */
+  void update_peak(const tape_usage& other) {
+    bytes = std::max(bytes, other.bytes);
+    vars = std::max(vars, other.vars);
+  }
+};
+
+/**
+ * Return the current size of the reverse-mode tape of the calling
+ * thread.
+ */
+inline tape_usage current_tape_usage() {
+  const auto& stack = *stan::math::ChainableStack::instance_;
+  tape_usage usage;
+  usage.bytes = stack.memalloc_.bytes_allocated();
+  usage.vars = stack.var_stack_.size() + stack.var_nochain_stack_.size();
+  return usage;
+}
+
+/**
+ * Reserve room for a tape of the specified size in the arena and var
+ * stacks of the calling thread, so that recording a tape up to that
+ * size allocates no further memory.  The arena gets one block of at
+ * least the specified bytes unless it already has one; the arena grows
+ * by doubling its last block otherwise, which for a tape of a few
+ * megabytes takes several allocations spread over the first gradients.
+ * Nothing is reserved while a tape is being recorded.
+ *
+ * @param usage size of the tape to make room for
+ */
+inline void reserve_tape(const tape_usage& usage) {
+  auto& stack = *stan::math::ChainableStack::instance_;
+  if (!stack.var_stack_.empty() || !stack.var_nochain_stack_.empty()
+      || !stack.nested_var_stack_sizes_.empty())
+    return;
+  if (usage.bytes > 0) {
+    stack.memalloc_.alloc(usage.bytes);
+    stack.memalloc_.recover_all();
+  }
+  stack.var_stack_.reserve(usage.vars);
+}
+
+/**
+ * Functor for the gradient of a model that records the size of the
+ * tape once the log density has been evaluated, when the tape is at
+ * its largest.
+ */
+template <class M>
+struct tape_usage_functional {
+  const M& model;
+  std::ostream* o;
+  tape_usage& usage;
+
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& x) const {
+    // log_prob() requires non-const but doesn't modify its argument
+    T lp = model.template log_prob<true, true, T>(
+        const_cast<Eigen::Matrix<T, -1, 1>&>(x), o);
+    usage = current_tape_usage();
+    return lp;
+  }
+};
+
+/**
+ * Compute the log density and its gradient as
+ * <code>stan::model::gradient</code> does, also returning the size of
+ * the tape recorded for it.  The messages of the model are written to
+ * the specified sink, cleared first, and logged.  A caller evaluating
+ * gradients repeatedly keeps the sink across calls, so a silent model
+ * allocates nothing for its messages.
+ *
+ * @tparam M Class of model
+ * @param[in] model model
+ * @param[in] x unconstrained parameters
+ * @param[out] f log density
+ * @param[out] grad_f gradient of the log density
+ * @param[out] usage size of the tape
+ * @param[in,out] msgs sink for the messages of the model
+ * @param[in,out] logger logger for messages of the model
+ */
+template <class M>
+void gradient(const M& model, const Eigen::VectorXd& x, double& f,
+              Eigen::VectorXd& grad_f, tape_usage& usage,
+              callbacks::message_sink& msgs, callbacks::logger& logger) {
+  msgs.clear_messages();
+  try {
+    stan::math::gradient(tape_usage_functional<M>{model, &msgs, usage}, x, f,
+                         grad_f);
+  } catch (std::exception& e) {
+    msgs.flush_to(logger);
+    throw;
+  }
+  msgs.flush_to(logger);
+}
+
+/**
+ * Evaluate the log density of the model and its gradient, recording the
+ * size of the tape, as by the overload taking a message sink, with a
+ * sink for this call only.
+ *
+ * @tparam M Class of model
+ * @param[in] model model
+ * @param[in] x unconstrained parameters
+ * @param[out] f log density
+ * @param[out] grad_f gradient of the log density
+ * @param[out] usage size of the tape
+ * @param[in,out] logger logger for messages of the model
+ */
+template <class M>
+void gradient(const M& model, const Eigen::VectorXd& x, double& f,
+              Eigen::VectorXd& grad_f, tape_usage& usage,
+              callbacks::logger& logger) {
+  callbacks::message_sink msgs;
+  gradient(model, x, f, grad_f, usage, msgs, logger);
+}
+
+/**
+ * Evaluate the gradient of the model at the specified point to measure
+ * its tape and reserve the specified multiple of it on the calling
+ * thread, with <code>reserve_tape</code>.  Errors evaluating the model
+ * leave the tape as it is.
+ *
+ * @tparam M Class of model
+ * @param[in] model model
+ * @param[in] x unconstrained parameters of the probe
+ * @param[in] headroom multiple of the measured tape to reserve, at
+ * least 1
+ * @param[in,out] logger logger for messages of the model
+ * @return size of the tape at the probe, zero if it failed
+ */
+template <class M>
+tape_usage reserve_tape_from_probe(const M& model, const Eigen::VectorXd& x,
+                                   double headroom,
+                                   callbacks::logger& logger) {
+  tape_usage usage;
+  try {
+    double f;
+    Eigen::VectorXd grad_f;
+    stan::model::gradient(model, x, f, grad_f, usage, logger);
+  } catch (const std::exception&) {
+    return tape_usage();
+  }
+  tape_usage reserved;
+  reserved.bytes = static_cast<std::size_t>(headroom * usage.bytes);
+  reserved.vars = static_cast<std::size_t>(headroom * usage.vars);
+  reserve_tape(reserved);
+  return usage;
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
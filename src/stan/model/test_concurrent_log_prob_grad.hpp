@@ -0,0 +1,84 @@
+#ifndef STAN_MODEL_TEST_CONCURRENT_LOG_PROB_GRAD_HPP
+#define STAN_MODEL_TEST_CONCURRENT_LOG_PROB_GRAD_HPP
+
+#include <stan/math/rev.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Test that log_prob_grad() can be evaluated concurrently on a single
+ * model instance, as required by the thread safety contract of
+ * `model_base`.
+ *
+ * The log density and gradient are first evaluated serially at every
+ * point, then every point is evaluated `num_repeats` more times from
+ * parallel tasks on the same instance, and each result is compared with
+ * its serial value.  A thread safe model evaluates deterministically,
+ * so the comparison is exact; a model that keeps scratch state between
+ * calls produces differences, either from the concurrent access or
+ * from the repeated evaluation alone.
+ *
+ * Stan Math must be built with `STAN_THREADS` and its thread pool
+ * initialized with `stan::math::init_threadpool_tbb()`; messages from
+ * the concurrent evaluations are discarded.
+ *
+ * @tparam propto True if calculation is up to proportion
+ * (double-only terms dropped).
+ * @tparam jacobian_adjust_transform True if the log absolute
+ * Jacobian determinant of inverse parameter transforms is added to the
+ * log probability.
+ * @tparam Model Class of model.
+ * @param[in] model Model.
+ * @param[in] params_r Unconstrained parameter values to evaluate at.
+ * @param[in] num_repeats Number of concurrent evaluations per point.
+ * @param[in,out] msgs Stream for messages of the serial evaluations.
+ * @return number of concurrent evaluations that threw or differ from
+ * the serial one, so 0 if the model passes
+ * @throw std::exception if a serial evaluation throws
+ */
+template <bool propto, bool jacobian_adjust_transform, class Model>
+int test_concurrent_log_prob_grad(const Model& model,
+                                  const std::vector<Eigen::VectorXd>& params_r,
+                                  std::size_t num_repeats,
+                                  std::ostream* msgs = 0) {
+  const std::size_t num_points = params_r.size();
+  std::vector<double> lp(num_points);
+  std::vector<Eigen::VectorXd> grad(num_points);
+  for (std::size_t k = 0; k < num_points; ++k) {
+    Eigen::VectorXd theta = params_r[k];
+    lp[k] = log_prob_grad<propto, jacobian_adjust_transform>(model, theta,
+                                                             grad[k], msgs);
+  }
+
+  std::atomic<int> num_failed{0};
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, num_points * num_repeats),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        Eigen::VectorXd theta;
+        Eigen::VectorXd g;
+        for (std::size_t n = r.begin(); n != r.end(); ++n) {
+          const std::size_t k = n % num_points;
+          theta = params_r[k];
+          try {
+            double lp_n = log_prob_grad<propto, jacobian_adjust_transform>(
+                model, theta, g);
+            if (!(lp_n == lp[k]) || !(g == grad[k]))
+              ++num_failed;
+          } catch (const std::exception& e) {
+            ++num_failed;
+          }
+        }
+      });
+  return num_failed;
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
@@ -2,10 +2,12 @@
 #define STAN_MODEL_TEST_GRADIENTS_HPP
 
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/model/finite_diff_grad.hpp>
 #include <stan/model/log_prob_grad.hpp>
 #include <cmath>
+#include <iomanip>
 #include <sstream>
 #include <vector>
 
@@ -18,6 +20,9 @@ namespace model {
  * be necessary when using autodiff, but is useful for finding
  * bugs in hand-written code (or var).
  *
+ * The finite differences of the parameters are computed in parallel,
+ * so the model's log probability must be thread safe.
+ *
  * @tparam propto True if calculation is up to proportion
  * (double-only terms dropped).
  * @tparam jacobian_adjust_transform True if the log absolute
@@ -31,7 +36,7 @@ namespace model {
  *   Reasonable value is 1e-6.
  * @param[in] error Real-valued scalar saying how much error to allow.
  *   Reasonable value is 1e-6.
- * @param[in,out] interrupt callback to be called at every iteration
+ * @param[in,out] interrupt callback to be called periodically
  * @param[in,out] logger Logger for messages
  * @param[in,out] parameter_writer Writer callback for file output
  * @return number of failed gradient comparisons versus allowed
@@ -43,21 +48,21 @@ int test_gradients(const Model& model, std::vector<double>& params_r,
                    stan::callbacks::interrupt& interrupt,
                    stan::callbacks::logger& logger,
                    stan::callbacks::writer& parameter_writer) {
-  std::stringstream msg;
+  stan::callbacks::message_sink msg;
   std::vector<double> grad;
   double lp = log_prob_grad<propto, jacobian_adjust_transform>(
       model, params_r, params_i, grad, &msg);
-  if (msg.str().length() > 0) {
-    logger.info(msg);
+  if (!msg.empty()) {
     parameter_writer(msg.str());
+    msg.flush_to(logger);
   }
 
   std::vector<double> grad_fd;
-  finite_diff_grad<false, true, Model>(model, interrupt, params_r, params_i,
-                                       grad_fd, epsilon, &msg);
-  if (msg.str().length() > 0) {
-    logger.info(msg);
+  finite_diff_grad_parallel<false, true, Model>(
+      model, interrupt, params_r, params_i, grad_fd, epsilon, &msg);
+  if (!msg.empty()) {
     parameter_writer(msg.str());
+    msg.flush_to(logger);
   }
 
   int num_failed = 0;
@@ -0,0 +1,129 @@
+#ifndef STAN_MODEL_TEST_GRADIENTS_PROJECTION_HPP
+#define STAN_MODEL_TEST_GRADIENTS_PROJECTION_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/model/gradient_dot_vector.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace model {
+
+/**
+ * Test the model's gradient against finite differences along random
+ * directions.  For each direction <code>v</code>, drawn uniformly on
+ * the unit sphere, the directional derivative of the log density
+ * computed by <code>gradient_dot_vector</code> in forward mode is
+ * compared to the central difference
+ * <code>(lp(x + epsilon v) - lp(x - epsilon v)) / (2 epsilon)</code>.
+ *
+ * Each direction costs one forward mode and two double evaluations of
+ * the log density, whatever the number of parameters, so this is much
+ * cheaper than <code>test_gradients</code> for large models, while an
+ * error in any component of the gradient shows up in almost every
+ * direction.  The directional derivatives are computed with
+ * <code>propto</code> and the Jacobian adjustment, as by
+ * <code>stan::services::diagnose::diagnose</code>.
+ *
+ * @tparam Model Class of model.
+ * @tparam RNG Class of random number generator.
+ * @param[in] model Model.
+ * @param[in] params_r Real-valued parameter vector.
+ * @param[in] params_i Integer-valued parameter vector.
+ * @param[in] epsilon Real-valued scalar saying how much to perturb.
+ *   Reasonable value is 1e-6.
+ * @param[in] error Real-valued scalar saying how much error to allow.
+ *   Reasonable value is 1e-6.
+ * @param[in] num_directions Number of random directions to test.
+ * @param[in,out] rng Random number generator for the directions.
+ * @param[in,out] interrupt callback to be called for every direction
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] parameter_writer Writer callback for file output
+ * @return number of failed directional derivative comparisons versus
+ * allowed error, so 0 if all directions pass
+ */
+template <class Model, class RNG>
+int test_gradients_projection(const Model& model,
+                              std::vector<double>& params_r,
+                              std::vector<int>& params_i, double epsilon,
+                              double error, int num_directions, RNG& rng,
+                              stan::callbacks::interrupt& interrupt,
+                              stan::callbacks::logger& logger,
+                              stan::callbacks::writer& parameter_writer) {
+  std::stringstream msg;
+  Eigen::Map<const Eigen::VectorXd> x(params_r.data(), params_r.size());
+  boost::variate_generator<RNG&, boost::normal_distribution<> >
+      rand_unit_gaus(rng, boost::normal_distribution<>());
+
+  std::vector<double> dir_derivative(num_directions);
+  std::vector<double> dir_derivative_fd(num_directions);
+  double lp = 0;
+  std::vector<double> perturbed(params_r.size());
+  Eigen::VectorXd v(params_r.size());
+  for (int n = 0; n < num_directions; ++n) {
+    interrupt();
+    for (Eigen::Index i = 0; i < v.size(); ++i)
+      v(i) = rand_unit_gaus();
+    double norm = v.norm();
+    if (norm > 0)
+      v /= norm;
+
+    gradient_dot_vector(model, x, v, lp, dir_derivative[n], &msg);
+
+    Eigen::Map<Eigen::VectorXd>(perturbed.data(), perturbed.size())
+        = x + epsilon * v;
+    double logp_plus
+        = model.template log_prob<false, true>(perturbed, params_i, &msg);
+    Eigen::Map<Eigen::VectorXd>(perturbed.data(), perturbed.size())
+        = x - epsilon * v;
+    double logp_minus
+        = model.template log_prob<false, true>(perturbed, params_i, &msg);
+    dir_derivative_fd[n] = (logp_plus - logp_minus) / (2 * epsilon);
+  }
+  if (msg.str().length() > 0) {
+    logger.info(msg);
+    parameter_writer(msg.str());
+  }
+
+  int num_failed = 0;
+
+  std::stringstream lp_msg;
+  lp_msg << " Log probability=" << lp;
+
+  parameter_writer();
+  parameter_writer(lp_msg.str());
+  parameter_writer();
+
+  logger.info("");
+  logger.info(lp_msg);
+  logger.info("");
+
+  std::stringstream header;
+  header << std::setw(10) << "direction" << std::setw(16) << "model"
+         << std::setw(16) << "finite diff" << std::setw(16) << "error";
+
+  parameter_writer(header.str());
+  logger.info(header);
+
+  for (int n = 0; n < num_directions; ++n) {
+    std::stringstream line;
+    line << std::setw(10) << n << std::setw(16) << dir_derivative[n]
+         << std::setw(16) << dir_derivative_fd[n] << std::setw(16)
+         << (dir_derivative[n] - dir_derivative_fd[n]);
+    parameter_writer(line.str());
+    logger.info(line);
+    if (std::fabs(dir_derivative[n] - dir_derivative_fd[n]) > error)
+      num_failed++;
+  }
+  return num_failed;
+}
+
+}  // namespace model
+}  // namespace stan
+#endif
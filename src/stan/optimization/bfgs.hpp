@@ -8,6 +8,7 @@
 #include <stan/optimization/bfgs_update.hpp>
 #include <stan/optimization/lbfgs_update.hpp>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <limits>
@@ -286,29 +287,49 @@ template <class M, bool jacobian = false>
 class ModelAdaptor {
  private:
   M &_model;
-  std::vector<int> _params_i;
   std::ostream *_msgs;
-  std::vector<double> _x, _g;
   size_t _fevals;
+  double _eval_time;
+
+  /**
+   * Adds the wall time from its construction to its destruction to the
+   * time spent evaluating the model.
+   */
+  class eval_timer {
+   public:
+    explicit eval_timer(double &total)
+        : _total(total), _start(std::chrono::steady_clock::now()) {}
+    ~eval_timer() {
+      _total += std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                              - _start)
+                    .count();
+    }
+
+   private:
+    double &_total;
+    std::chrono::steady_clock::time_point _start;
+  };
 
  public:
   ModelAdaptor(M &model, const std::vector<int> &params_i, std::ostream *msgs)
-      : _model(model), _params_i(params_i), _msgs(msgs), _fevals(0) {}
+      : _model(model),
+        _msgs(msgs),
+        _fevals(0),
+        _eval_time(0) {}
 
   size_t fevals() const { return _fevals; }
+
+  /**
+   * Return the wall time in seconds spent evaluating the model.
+   */
+  double eval_time() const { return _eval_time; }
+
   int operator()(const Eigen::Matrix<double, Eigen::Dynamic, 1> &x, double &f) {
-    using Eigen::Dynamic;
-    using Eigen::Matrix;
-    using stan::math::index_type;
+    eval_timer timer(_eval_time);
     using stan::model::log_prob_propto;
-    typedef typename index_type<Matrix<double, Dynamic, 1> >::type idx_t;
-
-    _x.resize(x.size());
-    for (idx_t i = 0; i < x.size(); i++)
-      _x[i] = x[i];
 
     try {
-      f = -log_prob_propto<jacobian>(_model, _x, _params_i, _msgs);
+      f = -log_prob_propto<jacobian>(_model, x, _msgs);
     } catch (const std::domain_error &e) {
       if (_msgs)
         (*_msgs) << e.what() << std::endl;
@@ -327,37 +348,27 @@ class ModelAdaptor {
   }
   int operator()(const Eigen::Matrix<double, Eigen::Dynamic, 1> &x, double &f,
                  Eigen::Matrix<double, Eigen::Dynamic, 1> &g) {
-    using Eigen::Dynamic;
-    using Eigen::Matrix;
-    using stan::math::index_type;
+    eval_timer timer(_eval_time);
     using stan::model::log_prob_grad;
-    typedef typename index_type<Matrix<double, Dynamic, 1> >::type idx_t;
-
-    _x.resize(x.size());
-    for (idx_t i = 0; i < x.size(); i++)
-      _x[i] = x[i];
 
     _fevals++;
 
     try {
-      f = -log_prob_grad<true, jacobian>(_model, _x, _params_i, _g, _msgs);
+      f = -log_prob_grad<true, jacobian>(_model, x, g, _msgs);
     } catch (const std::domain_error &e) {
       if (_msgs)
         (*_msgs) << e.what() << std::endl;
       return 1;
     }
 
-    g.resize(_g.size());
-    for (size_t i = 0; i < _g.size(); i++) {
-      if (!std::isfinite(_g[i])) {
-        if (_msgs)
-          *_msgs << "Error evaluating model log probability: "
-                    "Non-finite gradient."
-                 << std::endl;
-        return 3;
-      }
-      g[i] = -_g[i];
+    if (!g.allFinite()) {
+      if (_msgs)
+        *_msgs << "Error evaluating model log probability: "
+                  "Non-finite gradient."
+               << std::endl;
+      return 3;
     }
+    g = -g;
 
     if (std::isfinite(f)) {
       return 0;
@@ -413,6 +424,7 @@ class BFGSLineSearch
   }
 
   size_t grad_evals() { return this->_func.fevals(); }
+  double eval_time() { return this->_func.eval_time(); }
   double logp() { return -(this->curr_f()); }
   double grad_norm() { return this->curr_g().norm(); }
   void grad(std::vector<double> &g) {
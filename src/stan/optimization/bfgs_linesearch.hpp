@@ -106,6 +106,63 @@ Scalar CubicInterp(const Scalar &x0, const Scalar &f0, const Scalar &df0,
   return x0 + CubicInterp(df0, x1 - x0, f1 - f0, df1, loX - x0, hiX - x0);
 }
 
+/**
+ * A cache of the most recent function evaluations of one line search,
+ * keyed by the step size.  When a zoom bracket collapses to adjacent
+ * floating point values the next trial step size rounds to one of its
+ * ends, which is then looked up instead of evaluated again.
+ *
+ * @tparam Scalar A scalar type
+ * @tparam XType A vector type
+ **/
+template <typename Scalar, typename XType>
+class LineSearchCache {
+ public:
+  /**
+   * Set x to x0 + alpha * p and evaluate the function there, or look
+   * up the evaluation if the step size was tried before.
+   *
+   * @param func Function which is being minimized.
+   * @param alpha Step size.
+   * @param[out] x Point, x0 + alpha * p.
+   * @param[out] f Function value at x.
+   * @param[out] df Gradient at x.
+   * @param x0 Starting point of the line search.
+   * @param p Search direction.
+   * @return Return code of the function, non-zero if it failed.
+   **/
+  template <typename FunctorType>
+  int operator()(FunctorType &func, const Scalar &alpha, XType &x, Scalar &f,
+                 XType &df, const XType &x0, const XType &p) {
+    x.noalias() = x0 + alpha * p;
+    for (size_t i = 0; i < _size; ++i) {
+      if (_alpha[i] == alpha) {
+        f = _f[i];
+        df = _df[i];
+        return _ret[i];
+      }
+    }
+    int ret = func(x, f, df);
+    _alpha[_next] = alpha;
+    _f[_next] = f;
+    _df[_next] = df;
+    _ret[_next] = ret;
+    _next = (_next + 1) % capacity;
+    if (_size < capacity)
+      ++_size;
+    return ret;
+  }
+
+ private:
+  static constexpr size_t capacity = 4;
+  size_t _size = 0;
+  size_t _next = 0;
+  Scalar _alpha[capacity];
+  Scalar _f[capacity];
+  XType _df[capacity];
+  int _ret[capacity];
+};
+
 /**
  * An internal utility function for implementing WolfeLineSearch()
  **/
@@ -115,7 +172,8 @@ int WolfLSZoom(Scalar &alpha, XType &newX, Scalar &newF, XType &newDF,
                const Scalar &dfp, const Scalar &c1dfp, const Scalar &c2dfp,
                const XType &p, Scalar alo, Scalar aloF, Scalar aloDFp,
                Scalar ahi, Scalar ahiF, Scalar ahiDFp,
-               const Scalar &min_range) {
+               const Scalar &min_range,
+               LineSearchCache<Scalar, XType> &cache) {
   Scalar d1, d2, newDFp;
   int itNum(0);
 
@@ -141,12 +199,10 @@ int WolfLSZoom(Scalar &alpha, XType &newX, Scalar &newF, XType &newDF,
         alpha = 0.5 * (alo + ahi);
     }
 
-    newX = x + alpha * p;
-    while (func(newX, newF, newDF)) {
+    while (cache(func, alpha, newX, newF, newDF, x, p)) {
       alpha = 0.5 * (alpha + std::min(alo, ahi));
       if (std::fabs(std::min(alo, ahi) - alpha) < min_range)
         return 1;
-      newX = x + alpha * p;
     }
     newDFp = newDF.dot(p);
     if (newF > (f + alpha * c1dfp) || newF >= aloF) {
@@ -169,6 +225,22 @@ int WolfLSZoom(Scalar &alpha, XType &newX, Scalar &newF, XType &newDF,
   return 0;
 }
 
+/**
+ * An internal utility function for implementing WolfeLineSearch(),
+ * with a cache of its own.
+ **/
+template <typename FunctorType, typename Scalar, typename XType>
+int WolfLSZoom(Scalar &alpha, XType &newX, Scalar &newF, XType &newDF,
+               FunctorType &func, const XType &x, const Scalar &f,
+               const Scalar &dfp, const Scalar &c1dfp, const Scalar &c2dfp,
+               const XType &p, Scalar alo, Scalar aloF, Scalar aloDFp,
+               Scalar ahi, Scalar ahiF, Scalar ahiDFp,
+               const Scalar &min_range) {
+  LineSearchCache<Scalar, XType> cache;
+  return WolfLSZoom(alpha, newX, newF, newDF, func, x, f, dfp, c1dfp, c2dfp,
+                    p, alo, aloF, aloDFp, ahi, ahiF, ahiDFp, min_range, cache);
+}
+
 /**
  * Perform a line search which finds an approximate solution to:
  * \f[
@@ -223,6 +295,9 @@ int WolfLSZoom(Scalar &alpha, XType &newX, Scalar &newF, XType &newDF,
  * @param maxLSRestarts Maximum number of times line search will
  * restart with \f$ f() \f$ failing.
  *
+ * The evaluations at the most recent step sizes are cached, so a step
+ * size tried again is not evaluated again; see LineSearchCache.
+ *
  * @return Returns zero on success, non-zero otherwise.
  **/
 template <typename FunctorType, typename Scalar, typename XType>
@@ -244,6 +319,7 @@ int WolfeLineSearch(FunctorType &func, Scalar &alpha, XType &x1,
   Scalar newDFp;
 
   int retCode = 0, nits = 0, lsRestarts = 0, ret;
+  LineSearchCache<Scalar, XType> cache;
 
   while (1) {
     if (nits >= maxLSIts) {
@@ -251,8 +327,7 @@ int WolfeLineSearch(FunctorType &func, Scalar &alpha, XType &x1,
       break;
     }
 
-    x1.noalias() = x0 + alpha1 * p;
-    ret = func(x1, func_val, gradx1);
+    ret = cache(func, alpha1, x1, func_val, gradx1, x0, p);
     if (ret != 0) {
       if (lsRestarts >= maxLSRestarts) {
         retCode = 1;
@@ -269,7 +344,7 @@ int WolfeLineSearch(FunctorType &func, Scalar &alpha, XType &x1,
     if ((func_val > f0 + alpha * c1dfp) || (func_val >= prevF && nits > 0)) {
       retCode = WolfLSZoom(alpha, x1, func_val, gradx1, func, x0, f0, dfp,
                            c1dfp, c2dfp, p, alpha0, prevF, prevDFp, alpha1,
-                           func_val, newDFp, 1e-16);
+                           func_val, newDFp, 1e-16, cache);
       break;
     }
     if (std::fabs(newDFp) <= -c2dfp) {
@@ -279,7 +354,7 @@ int WolfeLineSearch(FunctorType &func, Scalar &alpha, XType &x1,
     if (newDFp >= 0) {
       retCode = WolfLSZoom(alpha, x1, func_val, gradx1, func, x0, f0, dfp,
                            c1dfp, c2dfp, p, alpha1, func_val, newDFp, alpha0,
-                           prevF, prevDFp, 1e-16);
+                           prevF, prevDFp, 1e-16, cache);
       break;
     }
 
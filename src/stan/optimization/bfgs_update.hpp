@@ -58,6 +58,108 @@ class BFGSUpdate_HInv {
  private:
   HessianT _Hk;
 };
+/**
+ * BFGS update of the inverse Hessian approximation, storing only its
+ * lower triangle, packed column by column, in N (N + 1) / 2 scalars
+ * instead of the N^2 of BFGSUpdate_HInv.
+ *
+ * The update is applied in place as the symmetric rank-2 update
+ * H += s w^T + w s^T with w = -rho H y + (rho^2 y^T H y + rho) s / 2,
+ * which equals (I - rho s y^T) H (I - rho y s^T) + rho s s^T, so an
+ * iteration costs O(N^2) operations, each a pass over the contiguous
+ * packed columns, and no N x N temporary.
+ **/
+template <typename Scalar = double, int DimAtCompile = Eigen::Dynamic>
+class BFGSUpdate_HInv_packed {
+ public:
+  typedef Eigen::Matrix<Scalar, DimAtCompile, 1> VectorT;
+  typedef Eigen::Matrix<Scalar, DimAtCompile, DimAtCompile> HessianT;
+
+  /**
+   * Update the inverse Hessian approximation.
+   *
+   * @param yk Difference between the current and previous gradient vector.
+   * @param sk Difference between the current and previous state vector.
+   * @param reset Whether to reset the approximation, forgetting about
+   * previous values.
+   * @return In the case of a reset, returns the optimal scaling of the
+   * initial Hessian approximation which is useful for predicting
+   * step-sizes.
+   **/
+  inline Scalar update(const VectorT &yk, const VectorT &sk,
+                       bool reset = false) {
+    const Eigen::Index n = yk.size();
+    const Scalar skyk = yk.dot(sk);
+    const Scalar rhok = 1.0 / skyk;
+    Scalar B0fact;
+    if (reset) {
+      B0fact = yk.squaredNorm() / skyk;
+      _n = n;
+      _Hk.setZero(n * (n + 1) / 2);
+      for (Eigen::Index j = 0; j < n; ++j)
+        _Hk(offset(j)) = 1.0 / B0fact;
+    } else {
+      B0fact = 1.0;
+    }
+    multiply(yk, _wk);
+    _wk = -rhok * _wk + (0.5 * (rhok * rhok * yk.dot(_wk) + rhok)) * sk;
+    for (Eigen::Index j = 0; j < n; ++j) {
+      _Hk.segment(offset(j), n - j)
+          += sk.tail(n - j) * _wk(j) + _wk.tail(n - j) * sk(j);
+    }
+    return B0fact;
+  }
+
+  /**
+   * Compute the search direction based on the current (inverse) Hessian
+   * approximation and given gradient.
+   *
+   * @param[out] pk The negative product of the inverse Hessian and gradient
+   * direction gk.
+   * @param[in] gk Gradient direction.
+   **/
+  inline void search_direction(VectorT &pk, const VectorT &gk) const {
+    multiply(gk, pk);
+    pk = -pk;
+  }
+
+  /**
+   * Return the inverse Hessian approximation as a dense matrix.
+   **/
+  HessianT inverse_hessian() const {
+    HessianT H(_n, _n);
+    for (Eigen::Index j = 0; j < _n; ++j) {
+      H.col(j).tail(_n - j) = _Hk.segment(offset(j), _n - j);
+      H.row(j).tail(_n - j) = _Hk.segment(offset(j), _n - j).transpose();
+    }
+    return H;
+  }
+
+ private:
+  /**
+   * Return the index in the packed storage of the diagonal element of
+   * column j.
+   **/
+  inline Eigen::Index offset(Eigen::Index j) const {
+    return j * _n - j * (j - 1) / 2;
+  }
+
+  /**
+   * Compute Hk x from the packed lower triangle, column by column.
+   **/
+  inline void multiply(const VectorT &x, VectorT &result) const {
+    result.setZero(_n);
+    for (Eigen::Index j = 0; j < _n; ++j) {
+      auto col = _Hk.segment(offset(j), _n - j);
+      result(j) += col.dot(x.tail(_n - j));
+      result.tail(_n - j - 1) += col.tail(_n - j - 1) * x(j);
+    }
+  }
+
+  Eigen::Index _n = 0;
+  Eigen::Matrix<Scalar, Eigen::Dynamic, 1> _Hk;
+  VectorT _wk;
+};
 }  // namespace optimization
 }  // namespace stan
 
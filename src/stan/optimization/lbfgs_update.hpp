@@ -2,16 +2,69 @@
 #define STAN_OPTIMIZATION_LBFGS_UPDATE_HPP
 
 #include <stan/math/prim/fun/Eigen.hpp>
-#include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <cmath>
 #include <tuple>
-#include <vector>
 
 namespace stan {
 namespace optimization {
+/**
+ * Return the diagonal approximation of the inverse Hessian updated with
+ * a pair of changes in the gradient and in the state, by eq 4.9 of
+ * Gilbert, J.C., Lemaréchal, C. Some numerical experiments with
+ * variable-storage quasi-Newton algorithms. Mathematical Programming 45,
+ * 407–435 (1989). https://doi.org/10.1007/BF01589113
+ *
+ * @param diag diagonal of the inverse Hessian approximation
+ * @param yk change in the gradient
+ * @param sk change in the state
+ * @return updated diagonal
+ **/
+template <typename Diag, typename VecY, typename VecS>
+inline typename Diag::PlainObject diagonal_inverse_hessian_update(
+    const Eigen::MatrixBase<Diag> &diag, const Eigen::MatrixBase<VecY> &yk,
+    const Eigen::MatrixBase<VecS> &sk) {
+  const auto y_diag_y = yk.dot(diag.asDiagonal() * yk);
+  const auto y_s = yk.dot(sk);
+  const auto s_inv_diag_s
+      = sk.dot(diag.array().inverse().matrix().asDiagonal() * sk);
+  const auto s_scaled = (sk.array() / diag.array()).square();
+  return (y_s
+          / (y_diag_y / diag.array() + yk.array().square()
+             - (y_diag_y / s_inv_diag_s) * s_scaled))
+      .matrix();
+}
+
+/**
+ * Update the diagonal approximation of the inverse Hessian in place
+ * with a pair of changes in the gradient and in the state, as
+ * diagonal_inverse_hessian_update, unless the curvature of the pair is
+ * not positive or not tame: the pair is skipped unless yk' sk > 0 and
+ * |yk|^2 / yk' sk <= 1e12.
+ *
+ * @param[in,out] diag diagonal of the inverse Hessian approximation
+ * @param yk change in the gradient
+ * @param sk change in the state
+ * @return true if the diagonal was updated
+ **/
+template <typename Diag, typename VecY, typename VecS>
+inline bool update_diagonal_inverse_hessian(Eigen::MatrixBase<Diag> &diag,
+                                            const Eigen::MatrixBase<VecY> &yk,
+                                            const Eigen::MatrixBase<VecS> &sk) {
+  const auto y_s = yk.dot(sk);
+  if (!(y_s > 0 && std::abs(yk.squaredNorm() / y_s) <= 1e12))
+    return false;
+  diag = diagonal_inverse_hessian_update(diag, yk, sk);
+  return true;
+}
+
 /**
  * Implement a limited memory version of the BFGS update.  This
  * class maintains a circular buffer of inverse Hessian updates
- * which can be applied to compute the search direction.
+ * which can be applied to compute the search direction.  The update
+ * vectors are stored, oldest first, in a window of consecutive columns
+ * of two matrices holding twice the history, so that the history can
+ * be read as a block without copying.
  **/
 template <typename Scalar = double, int DimAtCompile = Eigen::Dynamic>
 class LBFGSUpdate {
@@ -20,15 +73,60 @@ class LBFGSUpdate {
   typedef Eigen::Matrix<Scalar, DimAtCompile, DimAtCompile> HessianT;
   // NOLINTNEXTLINE(build/include_what_you_use)
   typedef std::tuple<Scalar, VectorT, VectorT> UpdateT;
+  typedef Eigen::Matrix<Scalar, DimAtCompile, Eigen::Dynamic> HistoryT;
+  typedef typename HistoryT::ConstColsBlockXpr HistoryBlockT;
+
+  explicit LBFGSUpdate(size_t L = 5)
+      : _capacity(L),
+        _start(0),
+        _size(0),
+        _rho(2 * L),
+        _alphas(2 * L),
+        _use_diagonal(false) {}
+
+  /**
+   * Scale the initial inverse Hessian approximation of the two-loop
+   * recursion per coordinate, by a diagonal updated from every pair of
+   * updates as in update_diagonal_inverse_hessian, rather than by the
+   * single scalar of the newest pair.  This takes fewer iterations on
+   * badly scaled problems.  The diagonal starts from the identity and
+   * is restarted with the history.
+   *
+   * @param use_diagonal true for a diagonal initial approximation
+   **/
+  void set_diagonal_scaling(bool use_diagonal) {
+    _use_diagonal = use_diagonal;
+    _diagonal.resize(0);
+  }
 
-  explicit LBFGSUpdate(size_t L = 5) : _buf(L) {}
+  /**
+   * Return the diagonal of the initial inverse Hessian approximation,
+   * empty unless diagonal scaling is set and an update was made.
+   **/
+  inline const VectorT &diagonal() const { return _diagonal; }
 
   /**
-   * Set the number of inverse Hessian updates to keep.
+   * Set the number of inverse Hessian updates to keep.  The most
+   * recent updates are kept.
    *
    * @param L New size of buffer.
    **/
-  void set_history_size(size_t L) { _buf.rset_capacity(L); }
+  void set_history_size(size_t L) {
+    const size_t keep = std::min(_size, L);
+    HistoryT ys(_ys.rows(), 2 * L);
+    HistoryT ss(_ss.rows(), 2 * L);
+    Eigen::Matrix<Scalar, Eigen::Dynamic, 1> rho(2 * L);
+    ys.leftCols(keep) = _ys.middleCols(index(_size - keep), keep);
+    ss.leftCols(keep) = _ss.middleCols(index(_size - keep), keep);
+    rho.head(keep) = _rho.segment(index(_size - keep), keep);
+    _ys.swap(ys);
+    _ss.swap(ss);
+    _rho.swap(rho);
+    _alphas.resize(2 * L);
+    _capacity = L;
+    _start = 0;
+    _size = keep;
+  }
 
   /**
    * Add a new set of update vectors to the history.
@@ -48,16 +146,46 @@ class LBFGSUpdate {
     Scalar B0fact;
     if (reset) {
       B0fact = yk.squaredNorm() / skyk;
-      _buf.clear();
+      _start = 0;
+      _size = 0;
     } else {
       B0fact = 1.0;
     }
 
-    // New updates are pushed to the "back" of the circular buffer
-    Scalar invskyk = 1.0 / skyk;
     _gammak = skyk / yk.squaredNorm();
-    _buf.push_back();
-    _buf.back() = std::tie(invskyk, yk, sk);
+    if (_use_diagonal) {
+      if (reset || _diagonal.size() != yk.size())
+        _diagonal.setOnes(yk.size());
+      update_diagonal_inverse_hessian(_diagonal, yk, sk);
+    }
+    if (_capacity == 0)
+      return B0fact;
+    if (_ys.rows() != yk.size() || _ys.cols() != Eigen::Index(2 * _capacity)) {
+      _ys.resize(yk.size(), 2 * _capacity);
+      _ss.resize(sk.size(), 2 * _capacity);
+      _start = 0;
+      _size = 0;
+    }
+
+    // New updates are written after the newest one, dropping the oldest
+    // once the history is full.  When the window reaches the last
+    // column it is moved back to the first, once every _capacity
+    // updates; the source and destination columns never overlap.
+    if (_size == _capacity) {
+      ++_start;
+      --_size;
+    }
+    if (_start + _size == 2 * _capacity) {
+      _ys.leftCols(_size) = _ys.middleCols(_start, _size);
+      _ss.leftCols(_size) = _ss.middleCols(_start, _size);
+      _rho.head(_size) = _rho.segment(_start, _size);
+      _start = 0;
+    }
+    const size_t col = index(_size);
+    ++_size;
+    _rho(col) = 1.0 / skyk;
+    _ys.col(col) = yk;
+    _ss.col(col) = sk;
 
     return B0fact;
   }
@@ -71,40 +199,67 @@ class LBFGSUpdate {
    * @param[in] gk Gradient direction.
    **/
   inline void search_direction(VectorT &pk, const VectorT &gk) const {
-    std::vector<Scalar> alphas(_buf.size());
-    typename boost::circular_buffer<UpdateT>::const_reverse_iterator buf_rit;
-    typename boost::circular_buffer<UpdateT>::const_iterator buf_it;
-    typename std::vector<Scalar>::const_iterator alpha_it;
-    typename std::vector<Scalar>::reverse_iterator alpha_rit;
-
     pk.noalias() = -gk;
-    for (buf_rit = _buf.rbegin(), alpha_rit = alphas.rbegin();
-         buf_rit != _buf.rend(); buf_rit++, alpha_rit++) {
-      Scalar alpha;
-      const Scalar &rhoi(std::get<0>(*buf_rit));
-      const VectorT &yi(std::get<1>(*buf_rit));
-      const VectorT &si(std::get<2>(*buf_rit));
-
-      alpha = rhoi * si.dot(pk);
-      pk -= alpha * yi;
-      *alpha_rit = alpha;
+    for (size_t j = _size; j-- > 0;) {
+      const size_t col = index(j);
+      const Scalar alpha = _rho(col) * _ss.col(col).dot(pk);
+      pk.noalias() -= alpha * _ys.col(col);
+      _alphas(col) = alpha;
     }
-    pk *= _gammak;
-    for (buf_it = _buf.begin(), alpha_it = alphas.begin(); buf_it != _buf.end();
-         buf_it++, alpha_it++) {
-      Scalar beta;
-      const Scalar &rhoi(std::get<0>(*buf_it));
-      const VectorT &yi(std::get<1>(*buf_it));
-      const VectorT &si(std::get<2>(*buf_it));
-
-      beta = rhoi * yi.dot(pk);
-      pk += (*alpha_it - beta) * si;
+    if (_use_diagonal && _diagonal.size() == pk.size())
+      pk.array() *= _diagonal.array();
+    else
+      pk *= _gammak;
+    for (size_t j = 0; j < _size; ++j) {
+      const size_t col = index(j);
+      const Scalar beta = _rho(col) * _ys.col(col).dot(pk);
+      pk.noalias() += (_alphas(col) - beta) * _ss.col(col);
     }
   }
 
+  /**
+   * Return the number of updates in the history.
+   **/
+  inline size_t history_size() const { return _size; }
+
+  /**
+   * Return the differences in the gradient of the updates in the
+   * history as columns, oldest first.
+   **/
+  inline HistoryBlockT y_history() const {
+    return _ys.middleCols(_start, _size);
+  }
+
+  /**
+   * Return the differences in the state of the updates in the history
+   * as columns, oldest first.
+   **/
+  inline HistoryBlockT s_history() const {
+    return _ss.middleCols(_start, _size);
+  }
+
  protected:
-  boost::circular_buffer<UpdateT> _buf;
+  /**
+   * Return the column of the history holding the update with the
+   * specified age, 0 being the oldest.
+   *
+   * @param j Age of the update.
+   * @return Column of the update.
+   **/
+  size_t index(size_t j) const { return _start + j; }
+
+  // The updates are kept in consecutive columns, so that the two-loop
+  // recursion sweeps contiguous memory and does not allocate
+  size_t _capacity;
+  size_t _start;
+  size_t _size;
+  HistoryT _ys;
+  HistoryT _ss;
+  Eigen::Matrix<Scalar, Eigen::Dynamic, 1> _rho;
+  mutable Eigen::Matrix<Scalar, Eigen::Dynamic, 1> _alphas;
   Scalar _gammak;
+  bool _use_diagonal;
+  VectorT _diagonal;
 };
 }  // namespace optimization
 }  // namespace stan
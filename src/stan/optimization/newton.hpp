@@ -3,7 +3,10 @@
 
 #include <stan/model/grad_hess_log_prob.hpp>
 #include <stan/model/log_prob_grad.hpp>
+#include <stan/model/sparse_hessian.hpp>
 #include <stan/math/prim/fun/Eigen.hpp>
+#include <Eigen/Sparse>
+#include <memory>
 #include <vector>
 
 namespace stan {
@@ -26,24 +29,130 @@ inline void make_negative_definite_and_solve(matrix_d& H, vector_d& g) {
   g = eigenvectors * eigenprojections;
 }
 
+/**
+ * Eigendecomposition of the Hessian, or sparse Cholesky factorization
+ * of the negative Hessian, kept between Newton steps that reuse it.
+ */
+struct newton_hessian {
+  /**
+   * Sparsity pattern and coloring of the Hessian, to compute it from one
+   * Hessian-vector product per color, or null for a dense Hessian
+   */
+  std::shared_ptr<const stan::model::hessian_coloring> coloring;
+  /**
+   * Sparse Cholesky factorization of the negative Hessian, or null if the
+   * eigendecomposition is used
+   */
+  std::shared_ptr<const Eigen::SimplicialLLT<Eigen::SparseMatrix<double>>>
+      sparse_llt;
+  /** Eigenvectors of the Hessian */
+  matrix_d eigenvectors;
+  /** Absolute values of the eigenvalues of the Hessian */
+  vector_d abs_eigenvalues;
+  /** Number of steps taken with this Hessian */
+  int age = 0;
+  /** Whether the decomposition can be reused */
+  bool valid = false;
+};
+
+/**
+ * Take a Newton step, reusing the Hessian of earlier steps.
+ *
+ * The Hessian is recomputed with `grad_hess_log_prob` if `hessian` is not
+ * valid or has already been used for `max_reuse` steps, and only the
+ * gradient is computed otherwise.  The step is made along the Newton
+ * direction of the Hessian with its eigenvalues made negative, with step
+ * halving until the log density does not decrease.  The step quality is
+ * the ratio of the actual increase of the log density to the increase
+ * predicted by the quadratic model, and the Hessian is marked for
+ * recomputation when it falls below `min_ratio`.  If no step size
+ * increases the log density with a reused Hessian, the step is retried
+ * with a recomputed one.
+ *
+ * With `max_reuse = 0` this is the same as `newton_step` without reuse.
+ *
+ * If `hessian.coloring` is set, the Hessian is computed with
+ * `stan::model::sparse_hessian` and the Newton direction is solved with
+ * a sparse Cholesky factorization of the negative Hessian, which costs
+ * a number of gradients independent of the number of parameters for a
+ * banded or block diagonal Hessian.  A sparse Hessian that is not
+ * negative definite falls back to the dense eigendecomposition.
+ *
+ * @tparam M type of model
+ * @tparam jacobian `true` to include the Jacobian adjustment
+ * @param[in] model model
+ * @param[in,out] params_r unconstrained parameters, updated with the step
+ * @param[in] params_i integer parameters
+ * @param[in,out] hessian decomposition of the Hessian kept between steps
+ * @param[in] max_reuse number of steps after the first a Hessian is used for
+ * @param[in] min_ratio step quality below which the Hessian is recomputed
+ * @param[in,out] output_stream unused
+ * @return log density at the updated parameters
+ */
 template <typename M, bool jacobian = false>
 double newton_step(M& model, std::vector<double>& params_r,
-                   std::vector<int>& params_i,
+                   std::vector<int>& params_i, newton_hessian& hessian,
+                   int max_reuse, double min_ratio,
                    std::ostream* output_stream = 0) {
   std::vector<double> gradient;
-  std::vector<double> hessian;
-
-  double f0 = stan::model::grad_hess_log_prob<true, jacobian>(
-      model, params_r, params_i, gradient, hessian);
-  matrix_d H(params_r.size(), params_r.size());
-  for (size_t i = 0; i < hessian.size(); i++) {
-    H(i) = hessian[i];
+  const bool reused = hessian.valid && hessian.age <= max_reuse;
+  double f0;
+  if (reused) {
+    f0 = stan::model::log_prob_grad<true, jacobian>(model, params_r,
+                                                    params_i, gradient);
+  } else if (hessian.coloring) {
+    vector_d params = Eigen::Map<const vector_d>(params_r.data(),
+                                                 params_r.size());
+    vector_d grad;
+    Eigen::SparseMatrix<double> H;
+    f0 = stan::model::sparse_hessian<jacobian>(model, params,
+                                               *hessian.coloring, grad, H);
+    gradient.assign(grad.data(), grad.data() + grad.size());
+    const Eigen::SparseMatrix<double> neg_H = -H;
+    auto llt = std::make_shared<
+        Eigen::SimplicialLLT<Eigen::SparseMatrix<double>>>(neg_H);
+    if (llt->info() == Eigen::Success) {
+      hessian.sparse_llt = llt;
+    } else {
+      hessian.sparse_llt.reset();
+      Eigen::SelfAdjointEigenSolver<matrix_d> solver{matrix_d(H)};
+      hessian.eigenvectors = solver.eigenvectors();
+      hessian.abs_eigenvalues = solver.eigenvalues().cwiseAbs();
+    }
+    hessian.age = 0;
+    hessian.valid = true;
+  } else {
+    std::vector<double> hessian_vec;
+    f0 = stan::model::grad_hess_log_prob<true, jacobian>(
+        model, params_r, params_i, gradient, hessian_vec);
+    matrix_d H(params_r.size(), params_r.size());
+    for (size_t i = 0; i < hessian_vec.size(); i++) {
+      H(i) = hessian_vec[i];
+    }
+    Eigen::SelfAdjointEigenSolver<matrix_d> solver(H);
+    hessian.eigenvectors = solver.eigenvectors();
+    hessian.abs_eigenvalues = solver.eigenvalues().cwiseAbs();
+    hessian.sparse_llt.reset();
+    hessian.age = 0;
+    hessian.valid = true;
   }
+  ++hessian.age;
   vector_d g(params_r.size());
   for (size_t i = 0; i < gradient.size(); i++)
     g(i) = gradient[i];
-  make_negative_definite_and_solve(H, g);
-  //         H.ldlt().solveInPlace(g);
+  vector_d u;
+  if (hessian.sparse_llt) {
+    // -H is positive definite, so |H|^-1 g = (-H)^-1 g
+    u = -hessian.sparse_llt->solve(g);
+  } else {
+    vector_d eigenprojections = hessian.eigenvectors.transpose() * g;
+    for (int i = 0; i < g.size(); i++) {
+      eigenprojections[i] = -eigenprojections[i] / hessian.abs_eigenvalues[i];
+    }
+    u = hessian.eigenvectors * eigenprojections;
+  }
+  // increase of the quadratic model along -u per unit step
+  const double slope = -g.dot(u);
 
   std::vector<double> new_params_r(params_r.size());
   double step_size = 2;
@@ -52,11 +161,17 @@ double newton_step(M& model, std::vector<double>& params_r,
 
   while (f1 < f0) {
     step_size *= 0.5;
-    if (step_size < min_step_size)
+    if (step_size < min_step_size) {
+      if (reused) {
+        hessian.valid = false;
+        return newton_step<M, jacobian>(model, params_r, params_i, hessian,
+                                        max_reuse, min_ratio, output_stream);
+      }
       return f0;
+    }
 
     for (size_t i = 0; i < params_r.size(); i++)
-      new_params_r[i] = params_r[i] - step_size * g[i];
+      new_params_r[i] = params_r[i] - step_size * u[i];
     try {
       f1 = stan::model::log_prob_grad<true, jacobian>(model, new_params_r,
                                                       params_i, gradient);
@@ -68,9 +183,21 @@ double newton_step(M& model, std::vector<double>& params_r,
   for (size_t i = 0; i < params_r.size(); i++)
     params_r[i] = new_params_r[i];
 
+  const double predicted = (step_size - 0.5 * step_size * step_size) * slope;
+  if (!(f1 - f0 >= min_ratio * predicted))
+    hessian.valid = false;
   return f1;
 }
 
+template <typename M, bool jacobian = false>
+double newton_step(M& model, std::vector<double>& params_r,
+                   std::vector<int>& params_i,
+                   std::ostream* output_stream = 0) {
+  newton_hessian hessian;
+  return newton_step<M, jacobian>(model, params_r, params_i, hessian, 0, 0,
+                                  output_stream);
+}
+
 }  // namespace optimization
 }  // namespace stan
 #endif
@@ -0,0 +1,163 @@
+#ifndef STAN_OPTIMIZATION_NEWTON_CG_HPP
+#define STAN_OPTIMIZATION_NEWTON_CG_HPP
+
+#include <stan/math/mix.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/model/model_functional.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace stan {
+namespace optimization {
+
+/**
+ * State of the trust region Newton-CG optimizer kept between its steps.
+ */
+struct newton_cg_state {
+  /** Radius of the trust region */
+  double radius = 1;
+  /** Largest radius of the trust region */
+  double max_radius = 1e10;
+  /** Norm of the gradient at the point before the last step */
+  double grad_norm = std::numeric_limits<double>::infinity();
+  /** Number of Hessian-vector products of the last step */
+  int cg_iterations = 0;
+  /** Ratio of the actual to the predicted increase of the last step */
+  double step_quality = 0;
+  /** Whether the last step was accepted */
+  bool accepted = false;
+};
+
+namespace internal {
+
+/**
+ * Return the step size `tau >= 0` for which `p + tau * d` is on the
+ * boundary of the trust region, from within it.
+ */
+inline double to_trust_region_boundary(const Eigen::VectorXd& p,
+                                       const Eigen::VectorXd& d,
+                                       double radius) {
+  const double dd = d.squaredNorm();
+  const double pd = p.dot(d);
+  const double pp = p.squaredNorm();
+  const double disc = std::max(0.0, pd * pd + dd * (radius * radius - pp));
+  return (-pd + std::sqrt(disc)) / dd;
+}
+
+}  // namespace internal
+
+/**
+ * Take a step of the truncated Newton method with conjugate gradients
+ * in a trust region, the Steihaug-Toint method, to maximize the log
+ * density of a model.
+ *
+ * The step approximately maximizes the quadratic model of the log
+ * density within the trust region, by conjugate gradients on the
+ * Newton equations.  Each conjugate gradient iteration evaluates one
+ * product of the Hessian with a vector by forward-over-reverse
+ * autodiff, without forming the Hessian, so memory is linear in the
+ * number of parameters.  The iterations stop when the residual is
+ * below `min(0.5, sqrt(|g|)) |g|`, for a superlinear rate near the
+ * mode, when the step reaches the boundary of the trust region, or when
+ * a direction of nonnegative curvature is found, which is followed to
+ * the boundary.
+ *
+ * The step is accepted if it increases the log density, and the radius
+ * is shrunk if the increase is less than a quarter of the predicted one
+ * and grown if it is more than three quarters of it with the step on
+ * the boundary.
+ *
+ * @tparam M type of model
+ * @tparam jacobian `true` to include the Jacobian adjustment
+ * @param[in] model model
+ * @param[in,out] params_r unconstrained parameters, updated if the step
+ * is accepted
+ * @param[in,out] state trust region kept between steps
+ * @param[in] max_cg_iterations largest number of conjugate gradient
+ * iterations of a step
+ * @param[in,out] msgs message stream
+ * @return log density at the parameters after the step
+ * @throw std::domain_error if the log density or its gradient cannot be
+ * evaluated at the parameters before the step
+ */
+template <typename M, bool jacobian = false>
+double newton_cg_step(const M& model, Eigen::VectorXd& params_r,
+                      newton_cg_state& state, int max_cg_iterations = 1000,
+                      std::ostream* msgs = nullptr) {
+  Eigen::VectorXd g;
+  const double f0 = stan::model::log_prob_grad<true, jacobian>(
+      model, params_r, g, msgs);
+  const double g_norm = g.norm();
+  state.grad_norm = g_norm;
+  state.cg_iterations = 0;
+  state.accepted = false;
+  if (g_norm == 0)
+    return f0;
+
+  // Conjugate gradients for B p = g with B = -H, the Hessian of the
+  // negative log density, keeping B p to evaluate the quadratic model.
+  const stan::model::model_functional<M, jacobian> log_density(model, msgs);
+  const double tolerance = std::min(0.5, std::sqrt(g_norm)) * g_norm;
+  const Eigen::Index n = params_r.size();
+  Eigen::VectorXd p = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd Bp = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd r = g;
+  Eigen::VectorXd d = r;
+  Eigen::VectorXd Bd(n);
+  double rr = r.squaredNorm();
+  bool on_boundary = false;
+  for (int k = 0; k < std::max(max_cg_iterations, 1); ++k) {
+    double f;
+    stan::math::hessian_times_vector(log_density, params_r, d, f, Bd);
+    Bd = -Bd;
+    ++state.cg_iterations;
+    const double dBd = d.dot(Bd);
+    const double alpha = rr / dBd;
+    if (!(dBd > 0) || (p + alpha * d).norm() >= state.radius) {
+      const double tau
+          = internal::to_trust_region_boundary(p, d, state.radius);
+      p += tau * d;
+      Bp += tau * Bd;
+      on_boundary = true;
+      break;
+    }
+    p += alpha * d;
+    Bp += alpha * Bd;
+    r -= alpha * Bd;
+    const double rr_next = r.squaredNorm();
+    if (std::sqrt(rr_next) < tolerance)
+      break;
+    d = r + (rr_next / rr) * d;
+    rr = rr_next;
+  }
+
+  const double predicted = g.dot(p) - 0.5 * p.dot(Bp);
+  Eigen::VectorXd candidate = params_r + p;
+  double f1 = -std::numeric_limits<double>::infinity();
+  try {
+    f1 = stan::model::log_prob_propto<jacobian>(model, candidate, msgs);
+  } catch (const std::domain_error& e) {
+  }
+  if (!std::isfinite(f1))
+    f1 = -std::numeric_limits<double>::infinity();
+  state.step_quality = predicted > 0 ? (f1 - f0) / predicted : 0;
+
+  if (state.step_quality < 0.25)
+    state.radius = 0.25 * p.norm();
+  else if (state.step_quality > 0.75 && on_boundary)
+    state.radius = std::min(2 * state.radius, state.max_radius);
+
+  if (f1 > f0) {
+    params_r = candidate;
+    state.accepted = true;
+    return f1;
+  }
+  return f0;
+}
+
+}  // namespace optimization
+}  // namespace stan
+#endif
@@ -0,0 +1,127 @@
+#ifndef STAN_SERVICES_BATCH_FIT_DATASETS_HPP
+#define STAN_SERVICES_BATCH_FIT_DATASETS_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/services/error_codes.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace batch {
+
+/**
+ * Fit a model to each of a number of datasets in parallel, in one
+ * process, for when the same model is fit to many small datasets.
+ *
+ * Each dataset is loaded, its model constructed and its fit run by one
+ * task, the tasks being scheduled with work stealing on the current TBB
+ * arena; to share an arena with limits between all of the fits, call
+ * this through <code>util::execute</code>.  Any parallel work of the
+ * fits, such as the chains of a multi-chain service, runs on the same
+ * arena.  Datasets are only loaded when their fit starts, so only those
+ * being fit are held in memory at a time.
+ *
+ * Each thread running fits owns one workspace, default constructed the
+ * first time the thread runs a fit and passed to every fit it runs, in
+ * which a fit can keep buffers or other objects to reuse in later fits.
+ *
+ * A fit writes its results to callbacks of its own, usually made from
+ * the index of the dataset.  An exception thrown while loading, building
+ * or fitting a dataset is logged as an error for that dataset, whose
+ * return code is then <code>error_codes::SOFTWARE</code>; the other
+ * fits are not affected.
+ *
+ * @tparam Workspace type of the per-thread workspace
+ * @tparam LoadData type of the function loading a dataset
+ * @tparam MakeModel type of the function constructing a model
+ * @tparam Fit type of the function fitting a model
+ * @param[in] num_datasets number of datasets
+ * @param[in] load_data function called with the index of a dataset,
+ *   from 0 to <code>num_datasets - 1</code>, returning its data, such as
+ *   a <code>stan::io::var_context</code>
+ * @param[in] make_model function called with an lvalue of the data of a
+ *   dataset, returning the model to fit to it
+ * @param[in] fit function called with the index of a dataset, its model
+ *   and the workspace of the thread, returning the return code of the
+ *   fit, usually that of a service
+ * @param[in,out] logger logger for the errors of the fits, called from
+ *   one thread at a time
+ * @return return code of each dataset
+ */
+template <typename Workspace, typename LoadData, typename MakeModel,
+          typename Fit>
+inline std::vector<int> fit_datasets(std::size_t num_datasets,
+                                     LoadData&& load_data,
+                                     MakeModel&& make_model, Fit&& fit,
+                                     callbacks::logger& logger) {
+  std::vector<int> return_codes(num_datasets, error_codes::OK);
+  tbb::enumerable_thread_specific<Workspace> workspaces;
+  std::mutex logger_mutex;
+  tbb::parallel_for(
+      tbb::blocked_range<std::size_t>(0, num_datasets, 1),
+      [&](const tbb::blocked_range<std::size_t>& r) {
+        for (std::size_t i = r.begin(); i != r.end(); ++i) {
+          std::string error;
+          try {
+            auto data = load_data(i);
+            auto model = make_model(data);
+            return_codes[i] = fit(i, model, workspaces.local());
+            continue;
+          } catch (const std::exception& e) {
+            error = e.what();
+          } catch (...) {
+            error = "unknown exception";
+          }
+          return_codes[i] = error_codes::SOFTWARE;
+          std::lock_guard<std::mutex> lock(logger_mutex);
+          logger.error("Dataset " + std::to_string(i) + ": " + error);
+        }
+      },
+      tbb::simple_partitioner());
+  return return_codes;
+}
+
+namespace internal {
+struct no_workspace {};
+}  // namespace internal
+
+/**
+ * Fit a model to each of a number of datasets in parallel, in one
+ * process, without a per-thread workspace.  See the overload with a
+ * workspace; here <code>fit</code> is called with the index of a
+ * dataset and its model.
+ *
+ * @tparam LoadData type of the function loading a dataset
+ * @tparam MakeModel type of the function constructing a model
+ * @tparam Fit type of the function fitting a model
+ * @param[in] num_datasets number of datasets
+ * @param[in] load_data function returning the data of a dataset
+ * @param[in] make_model function returning the model of a dataset
+ * @param[in] fit function returning the return code of a fit
+ * @param[in,out] logger logger for the errors of the fits
+ * @return return code of each dataset
+ */
+template <typename LoadData, typename MakeModel, typename Fit>
+inline std::vector<int> fit_datasets(std::size_t num_datasets,
+                                     LoadData&& load_data,
+                                     MakeModel&& make_model, Fit&& fit,
+                                     callbacks::logger& logger) {
+  return fit_datasets<internal::no_workspace>(
+      num_datasets, load_data, make_model,
+      [&fit](std::size_t i, auto& model, internal::no_workspace&) {
+        return fit(i, model);
+      },
+      logger);
+}
+
+}  // namespace batch
+}  // namespace services
+}  // namespace stan
+#endif
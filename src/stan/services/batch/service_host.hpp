@@ -0,0 +1,347 @@
+#ifndef STAN_SERVICES_BATCH_SERVICE_HOST_HPP
+#define STAN_SERVICES_BATCH_SERVICE_HOST_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/services/batch/fit_datasets.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/optimize/defaults.hpp>
+#include <stan/services/optimize/lbfgs.hpp>
+#include <stan/services/pathfinder/single.hpp>
+#include <stan/services/sample/defaults.hpp>
+#include <stan/services/sample/hmc_nuts_diag_e_adapt.hpp>
+#include <stan/services/sample/standalone_gqs.hpp>
+#include <stan/services/util/create_unit_e_diag_inv_metric.hpp>
+#include <stan/services/util/execution_policy.hpp>
+#include <stan/services/util/warm_start_cache.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/task_arena.h>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace stan {
+namespace services {
+namespace batch {
+
+/**
+ * Callbacks of one request to a <code>service_host</code>, through
+ * which its results are returned.  Writers a service does not use are
+ * ignored.
+ */
+struct request_callbacks {
+  callbacks::interrupt& interrupt;
+  callbacks::logger& logger;
+  callbacks::writer& init_writer;
+  callbacks::writer& sample_writer;
+  callbacks::writer& diagnostic_writer;
+};
+
+/**
+ * Configuration of a request to sample with NUTS, adapting a diagonal
+ * metric, as run by <code>sample::hmc_nuts_diag_e_adapt</code>.  The
+ * members default to the defaults of the services.
+ */
+struct sample_request {
+  /** Initial values, or null for random inits. */
+  const io::var_context* init = nullptr;
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int num_warmup = sample::num_warmup::default_value();
+  int num_samples = sample::num_samples::default_value();
+  int num_thin = sample::thin::default_value();
+  bool save_warmup = sample::save_warmup::default_value();
+  int refresh = 0;
+  double stepsize = sample::stepsize::default_value();
+  double stepsize_jitter = sample::stepsize_jitter::default_value();
+  int max_depth = sample::max_depth::default_value();
+  double delta = 0.8;
+  double gamma = sample::gamma::default_value();
+  double kappa = sample::kappa::default_value();
+  double t0 = sample::t0::default_value();
+  unsigned int init_buffer = sample::init_buffer::default_value();
+  unsigned int term_buffer = sample::term_buffer::default_value();
+  unsigned int window = sample::window::default_value();
+  /**
+   * Adapted state of the previous request to continue from, replaced by
+   * that of this request, or null to warm up from scratch.
+   */
+  util::warm_start* warm_start = nullptr;
+  /** Number of warmup iterations when continuing from a warm start. */
+  int warm_num_warmup = 0;
+};
+
+/**
+ * Configuration of a request to optimize with L-BFGS, as run by
+ * <code>optimize::lbfgs</code>; the optimum is written to the sample
+ * writer.  The members default to the defaults of the services.
+ */
+struct optimize_request {
+  /** Initial values, or null for random inits. */
+  const io::var_context* init = nullptr;
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int history_size = optimize::history_size::default_value();
+  double init_alpha = optimize::init_alpha::default_value();
+  double tol_obj = optimize::tol_obj::default_value();
+  double tol_rel_obj = optimize::tol_rel_obj::default_value();
+  double tol_grad = optimize::tol_grad::default_value();
+  double tol_rel_grad = optimize::tol_rel_grad::default_value();
+  double tol_param = optimize::tol_param::default_value();
+  int num_iterations = optimize::iter::default_value();
+  bool save_iterations = optimize::save_iterations::default_value();
+  int refresh = 0;
+};
+
+/**
+ * Configuration of a request to run single-path Pathfinder, as run by
+ * <code>pathfinder::pathfinder_lbfgs_single</code>; the approximate
+ * draws are written to the sample writer.
+ */
+struct pathfinder_request {
+  /** Initial values, or null for random inits. */
+  const io::var_context* init = nullptr;
+  unsigned int random_seed = 0;
+  unsigned int stride_id = 1;
+  double init_radius = 2;
+  int history_size = optimize::history_size::default_value();
+  double init_alpha = optimize::init_alpha::default_value();
+  double tol_obj = optimize::tol_obj::default_value();
+  double tol_rel_obj = optimize::tol_rel_obj::default_value();
+  double tol_grad = optimize::tol_grad::default_value();
+  double tol_rel_grad = optimize::tol_rel_grad::default_value();
+  double tol_param = optimize::tol_param::default_value();
+  int num_iterations = optimize::iter::default_value();
+  int num_elbo_draws = 25;
+  int num_draws = 1000;
+  bool save_iterations = false;
+  int refresh = 0;
+};
+
+/**
+ * Configuration of a request to generate quantities from draws of the
+ * parameters, as run by <code>standalone_generate</code>; the
+ * quantities are written to the sample writer.
+ */
+struct generate_quantities_request {
+  /** Constrained parameters, one draw per row. */
+  const Eigen::MatrixXd* draws = nullptr;
+  unsigned int random_seed = 0;
+};
+
+/**
+ * A long-lived host for a constructed model, answering requests to
+ * sample, optimize, run Pathfinder or generate quantities, for a
+ * process serving many runs of the same model with different seeds,
+ * inits or configurations.
+ *
+ * The model is constructed once, by the caller, and kept for every
+ * request.  The host owns a TBB arena with the limits of its execution
+ * policy, initialized when the host is constructed, and every request
+ * runs in it, so the worker threads stay up between requests instead
+ * of an arena being made for each one as by <code>util::execute</code>.
+ *
+ * Requests may be made concurrently from several threads, which then
+ * share the arena; the model is only used through its `const` methods,
+ * which may be called concurrently.  As in <code>fit_datasets</code>,
+ * each thread running requests owns one workspace, default constructed
+ * the first time the thread runs a request through <code>run</code>,
+ * in which a request can keep buffers to reuse in later requests.
+ *
+ * The results of a request are written to the writers of its
+ * callbacks.  An exception escaping a request is logged as an error
+ * and its return code is then <code>error_codes::SOFTWARE</code>.
+ *
+ * @tparam Model type of the model
+ * @tparam Workspace type of the per-thread workspace
+ */
+template <class Model, typename Workspace = internal::no_workspace>
+class service_host {
+ public:
+  /**
+   * Construct a host for the specified model.
+   *
+   * @param[in] model constructed model, owned by the host
+   * @param[in] policy limits on the threads running the requests
+   * @throw std::invalid_argument if the policy cannot be honored; see
+   *   <code>util::make_task_arena</code>
+   */
+  explicit service_host(std::unique_ptr<Model>&& model,
+                        const util::execution_policy& policy = {})
+      : model_(std::move(model)),
+        policy_(policy),
+        arena_(util::make_task_arena(policy_)) {
+    arena_.initialize();
+  }
+
+  service_host(const service_host&) = delete;
+  service_host& operator=(const service_host&) = delete;
+
+  /**
+   * Return the model of the host.
+   */
+  const Model& model() const { return *model_; }
+
+  /**
+   * Run a request in the arena of the host.
+   *
+   * @tparam F type of the request
+   * @param[in] f function called with the model and the workspace of
+   *   the thread, returning the return code of the request, usually
+   *   that of a service
+   * @param[in,out] logger logger for an exception escaping the request
+   * @return return code of the request
+   */
+  template <typename F>
+  int run(F&& f, callbacks::logger& logger) {
+    return arena_.execute([&]() {
+      util::internal::execution_policy_scope scope(policy_);
+      std::string error;
+      try {
+        return static_cast<int>(f(*model_, workspaces_.local()));
+      } catch (const std::exception& e) {
+        error = e.what();
+      } catch (...) {
+        error = "unknown exception";
+      }
+      std::lock_guard<std::mutex> lock(logger_mutex_);
+      logger.error(error);
+      return static_cast<int>(error_codes::SOFTWARE);
+    });
+  }
+
+  /**
+   * Sample with NUTS, adapting a diagonal metric.
+   *
+   * @param[in] request configuration of the sampler
+   * @param[in,out] callbacks callbacks for the results
+   * @return return code of the service
+   */
+  int sample(const sample_request& request, request_callbacks& callbacks) {
+    return run(
+        [&](Model& model, Workspace&) {
+          io::empty_var_context empty;
+          if (request.warm_start) {
+            auto unit_metric
+                = util::create_unit_e_diag_inv_metric(model.num_params_r());
+            callbacks::structured_writer metric_writer;
+            return sample::hmc_nuts_diag_e_adapt(
+                model, request.init ? *request.init : empty, unit_metric,
+                request.random_seed, request.chain, request.init_radius,
+                request.num_warmup, request.num_samples, request.num_thin,
+                request.save_warmup, request.refresh, request.stepsize,
+                request.stepsize_jitter, request.max_depth, request.delta,
+                request.gamma, request.kappa, request.t0,
+                request.init_buffer, request.term_buffer, request.window,
+                callbacks.interrupt, callbacks.logger, callbacks.init_writer,
+                callbacks.sample_writer, callbacks.diagnostic_writer,
+                metric_writer, *request.warm_start, request.warm_num_warmup);
+          }
+          return sample::hmc_nuts_diag_e_adapt(
+              model, request.init ? *request.init : empty,
+              request.random_seed, request.chain, request.init_radius,
+              request.num_warmup, request.num_samples, request.num_thin,
+              request.save_warmup, request.refresh, request.stepsize,
+              request.stepsize_jitter, request.max_depth, request.delta,
+              request.gamma, request.kappa, request.t0, request.init_buffer,
+              request.term_buffer, request.window, callbacks.interrupt,
+              callbacks.logger, callbacks.init_writer,
+              callbacks.sample_writer, callbacks.diagnostic_writer);
+        },
+        callbacks.logger);
+  }
+
+  /**
+   * Optimize with L-BFGS.
+   *
+   * @param[in] request configuration of the optimizer
+   * @param[in,out] callbacks callbacks for the results
+   * @return return code of the service
+   */
+  int optimize(const optimize_request& request, request_callbacks& callbacks) {
+    return run(
+        [&](Model& model, Workspace&) {
+          io::empty_var_context empty;
+          return optimize::lbfgs<Model, false>(
+              model, request.init ? *request.init : empty,
+              request.random_seed, request.chain, request.init_radius,
+              request.history_size, request.init_alpha, request.tol_obj,
+              request.tol_rel_obj, request.tol_grad, request.tol_rel_grad,
+              request.tol_param, request.num_iterations,
+              request.save_iterations, request.refresh, callbacks.interrupt,
+              callbacks.logger, callbacks.init_writer,
+              callbacks.sample_writer);
+        },
+        callbacks.logger);
+  }
+
+  /**
+   * Run single-path Pathfinder.
+   *
+   * @param[in] request configuration of Pathfinder
+   * @param[in,out] callbacks callbacks for the results
+   * @return return code of the service
+   */
+  int pathfinder(const pathfinder_request& request,
+                 request_callbacks& callbacks) {
+    return run(
+        [&](Model& model, Workspace&) {
+          io::empty_var_context empty;
+          callbacks::structured_writer diagnostic_writer;
+          return pathfinder::pathfinder_lbfgs_single(
+              model, request.init ? *request.init : empty,
+              request.random_seed, request.stride_id, request.init_radius,
+              request.history_size, request.init_alpha, request.tol_obj,
+              request.tol_rel_obj, request.tol_grad, request.tol_rel_grad,
+              request.tol_param, request.num_iterations,
+              request.num_elbo_draws, request.num_draws,
+              request.save_iterations, request.refresh, callbacks.interrupt,
+              callbacks.logger, callbacks.init_writer,
+              callbacks.sample_writer, diagnostic_writer);
+        },
+        callbacks.logger);
+  }
+
+  /**
+   * Generate quantities from draws of the parameters.
+   *
+   * @param[in] request draws and seed
+   * @param[in,out] callbacks callbacks for the results
+   * @return return code of the service
+   */
+  int generate_quantities(const generate_quantities_request& request,
+                          request_callbacks& callbacks) {
+    return run(
+        [&](Model& model, Workspace&) {
+          if (request.draws == nullptr) {
+            callbacks.logger.error("No draws to generate quantities from.");
+            return static_cast<int>(error_codes::DATAERR);
+          }
+          return services::standalone_generate(
+              model, *request.draws, request.random_seed, callbacks.interrupt,
+              callbacks.logger, callbacks.sample_writer);
+        },
+        callbacks.logger);
+  }
+
+ private:
+  std::unique_ptr<Model> model_;
+  util::execution_policy policy_;
+  tbb::task_arena arena_;
+  tbb::enumerable_thread_specific<Workspace> workspaces_;
+  std::mutex logger_mutex_;
+};
+
+}  // namespace batch
+}  // namespace services
+}  // namespace stan
+#endif
@@ -6,6 +6,7 @@
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/model/test_gradients.hpp>
+#include <stan/model/test_gradients_projection.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <vector>
@@ -58,6 +59,62 @@ int diagnose(Model& model, const stan::io::var_context& init,
   return num_failed;
 }
 
+/**
+ * Checks the gradients of the model computed using autodiff against
+ * finite differences along random directions, or against the finite
+ * difference of every parameter.
+ *
+ * With a positive number of directions, the directional derivatives
+ * along that many random unit vectors are compared to directional
+ * finite differences with
+ * <code>stan::model::test_gradients_projection</code>, which costs the
+ * same whatever the number of parameters.  Otherwise every component
+ * of the gradient is checked as by the overload without the number of
+ * directions.  The directions are drawn from the same generator as
+ * the initial values.
+ *
+ * @tparam Model A model implementation
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] epsilon epsilon to use for finite differences
+ * @param[in] error amount of absolute error to allow
+ * @param[in] num_directions number of random directions to check, or 0
+ *   to check every parameter
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer Writer callback for file output
+ * @return the number of parameters or directions that are not within
+ * epsilon of the finite difference calculation
+ */
+template <class Model>
+int diagnose(Model& model, const stan::io::var_context& init,
+             unsigned int random_seed, unsigned int chain, double init_radius,
+             double epsilon, double error, int num_directions,
+             callbacks::interrupt& interrupt, callbacks::logger& logger,
+             callbacks::writer& init_writer,
+             callbacks::writer& parameter_writer) {
+  if (num_directions <= 0)
+    return diagnose(model, init, random_seed, chain, init_radius, epsilon,
+                    error, interrupt, logger, init_writer, parameter_writer);
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+
+  std::vector<int> disc_vector;
+  std::vector<double> cont_vector = util::initialize(
+      model, init, rng, init_radius, false, logger, init_writer);
+
+  logger.info("TEST GRADIENT MODE");
+
+  int num_failed = stan::model::test_gradients_projection(
+      model, cont_vector, disc_vector, epsilon, error, num_directions, rng,
+      interrupt, logger, parameter_writer);
+
+  return num_failed;
+}
+
 }  // namespace diagnose
 }  // namespace services
 }  // namespace stan
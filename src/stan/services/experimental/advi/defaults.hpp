@@ -310,6 +310,38 @@ struct output_draws {
   static int default_value() { return 1000; }
 };
 
+/**
+ * Rank of the low-rank term of the low rank approximation.
+ */
+struct rank {
+  /**
+   * Return the string description of rank.
+   *
+   * @return description
+   */
+  static std::string description() {
+    return "Rank of the covariance factor of the low rank approximation.";
+  }
+
+  /**
+   * Validates rank; must be greater than 0.
+   *
+   * @param[in] rank argument to validate
+   * @throw std::invalid_argument unless rank is greater than zero
+   */
+  static void validate(int rank) {
+    if (!(rank > 0))
+      throw std::invalid_argument("rank must be greater than 0.");
+  }
+
+  /**
+   * Return the default rank.
+   *
+   * @return 1
+   */
+  static int default_value() { return 1; }
+};
+
 }  // namespace advi
 }  // namespace experimental
 }  // namespace services
@@ -9,6 +9,7 @@
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/io/var_context.hpp>
+#include <stan/model/minibatch_model.hpp>
 #include <stan/variational/advi.hpp>
 #include <string>
 #include <vector>
@@ -45,6 +46,10 @@ namespace advi {
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] parameter_writer output for parameter values
  * @param[in,out] diagnostic_writer output for diagnostic values
+ * @param[in] minibatch_size if positive, number of rows of data from
+ *   which each gradient of the ELBO is estimated, for models declaring
+ *   rows of data (see `stan::model::minibatch_model`); other models use
+ *   all their data
  * @return error_codes::OK if successful
  */
 template <class Model>
@@ -56,8 +61,13 @@ int meanfield(Model& model, const stan::io::var_context& init,
               callbacks::interrupt& interrupt, callbacks::logger& logger,
               callbacks::writer& init_writer,
               callbacks::writer& parameter_writer,
-              callbacks::writer& diagnostic_writer) {
+              callbacks::writer& diagnostic_writer,
+              size_t minibatch_size = 0) {
   util::experimental_message(logger);
+  if (minibatch_size > 0 && stan::model::num_minibatch_rows(model) == 0)
+    logger.info(
+        "The model does not declare rows of data; "
+        "gradients are computed from all the data.");
 
   stan::rng_t rng = util::create_rng(random_seed, chain);
 
@@ -84,10 +94,11 @@ int meanfield(Model& model, const stan::io::var_context& init,
   stan::variational::advi<Model, stan::variational::normal_meanfield,
                           stan::rng_t>
       cmd_advi(model, cont_params, rng, grad_samples, elbo_samples, eval_elbo,
-               output_samples);
+               output_samples, false, false, minibatch_size);
   try {
     cmd_advi.run(eta, adapt_engaged, adapt_iterations, tol_rel_obj,
-                 max_iterations, logger, parameter_writer, diagnostic_writer);
+                 max_iterations, logger, parameter_writer, diagnostic_writer,
+                 &interrupt);
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::SOFTWARE;
@@ -0,0 +1,293 @@
+#ifndef STAN_SERVICES_EXPERIMENTAL_ADVI_MULTI_HPP
+#define STAN_SERVICES_EXPERIMENTAL_ADVI_MULTI_HPP
+
+#include <stan/callbacks/cancellable_interrupt.hpp>
+#include <stan/callbacks/cancellation_token.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/multi_chain_logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/services/util/experimental_message.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/variational/advi.hpp>
+#include <stan/variational/elbo_leader.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace experimental {
+namespace advi {
+namespace internal {
+
+/**
+ * Runs several instances of ADVI with the variational family `Q` in
+ * parallel and writes the approximation of the run with the best final
+ * ELBO, see `meanfield_multi`.
+ */
+template <class Q, class Model, typename InitContextPtr, typename InitWriter,
+          typename DiagnosticWriter>
+int run_advi_multi(
+    Model& model, const std::vector<InitContextPtr>& init,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int grad_samples, int elbo_samples, int max_iterations,
+    double tol_rel_obj, double eta, bool adapt_engaged, int adapt_iterations,
+    int eval_elbo, int output_samples, size_t num_runs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writers,
+    std::vector<DiagnosticWriter>& diagnostic_writers,
+    callbacks::writer& parameter_writer, double abandon_elbo_margin,
+    int abandon_min_iterations) {
+  using advi_t = stan::variational::advi<Model, Q, stan::rng_t>;
+  util::experimental_message(logger);
+
+  std::vector<std::string> names;
+  names.push_back("lp__");
+  names.push_back("log_p__");
+  names.push_back("log_g__");
+  model.constrained_param_names(names, true, true);
+  parameter_writer(names);
+
+  // The runs keep their generators, parameters and approximations so
+  // that the draws of the best one are made by its own generator
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_runs);
+  for (size_t k = 0; k < num_runs; ++k)
+    rngs.emplace_back(util::create_rng(random_seed, init_chain_id + k));
+  std::vector<Eigen::VectorXd> cont_params(num_runs);
+  std::vector<std::unique_ptr<advi_t>> runs(num_runs);
+  std::vector<std::unique_ptr<Q>> approximations(num_runs);
+  std::vector<double> elbos(num_runs,
+                            -std::numeric_limits<double>::infinity());
+
+  stan::variational::elbo_leader leader(abandon_min_iterations,
+                                        abandon_elbo_margin);
+  callbacks::multi_chain_logger run_loggers(
+      logger, num_runs, 32, std::chrono::milliseconds(100), init_chain_id);
+  // An interrupt in one run stops the others at their next iteration
+  callbacks::cancellation_token cancel;
+  callbacks::cancellable_interrupt run_interrupt(interrupt, cancel);
+  // One run per task, so the threads of abandoned runs take up the runs
+  // not yet started
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_runs, 1),
+      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t k = r.begin(); k < r.end(); ++k) {
+          callbacks::logger& run_logger = run_loggers.chain(k);
+          try {
+            std::vector<double> cont_vector
+                = util::initialize(model, *init[k], rngs[k], init_radius,
+                                   true, run_logger, init_writers[k]);
+            cont_params[k] = Eigen::Map<Eigen::VectorXd>(cont_vector.data(),
+                                                         cont_vector.size());
+            runs[k] = std::make_unique<advi_t>(
+                model, cont_params[k], rngs[k], grad_samples, elbo_samples,
+                eval_elbo, output_samples);
+            Q variational(cont_params[k]);
+            callbacks::writer eta_writer;
+            if (runs[k]->fit(variational, eta, adapt_engaged,
+                             adapt_iterations, tol_rel_obj, max_iterations,
+                             run_logger, eta_writer, diagnostic_writers[k],
+                             &run_interrupt, &leader)) {
+              elbos[k] = runs[k]->calc_ELBO(variational, run_logger);
+              approximations[k] = std::make_unique<Q>(variational);
+            }
+          } catch (const callbacks::cancelled_error&) {
+          } catch (const std::exception& e) {
+            run_logger.error(e.what());
+          }
+          run_logger.flush();
+        }
+      },
+      tbb::simple_partitioner());
+  run_loggers.flush();
+  if (cancel.cancelled())
+    return error_codes::SOFTWARE;
+
+  size_t best = num_runs;
+  for (size_t k = 0; k < num_runs; ++k) {
+    if (approximations[k] && (best == num_runs || elbos[k] > elbos[best]))
+      best = k;
+  }
+  if (best == num_runs) {
+    logger.error("No ADVI runs completed successfully");
+    return error_codes::SOFTWARE;
+  }
+  if (leader.num_abandoned() > 0)
+    logger.info("Abandoned ADVI runs: "
+                + std::to_string(leader.num_abandoned()));
+  std::stringstream msg;
+  msg << "Kept run " << init_chain_id + best << " with final ELBO "
+      << elbos[best];
+  logger.info(msg);
+  parameter_writer(msg.str());
+
+  try {
+    runs[best]->write_approximation(*approximations[best], logger,
+                                    parameter_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  logger.info("COMPLETED.");
+  return error_codes::OK;
+}
+
+}  // namespace internal
+
+/**
+ * Runs several instances of mean field ADVI in parallel, sharing the
+ * model, and writes the approximation of the run with the best final
+ * ELBO.
+ *
+ * ADVI converges to different local optima depending on its initial
+ * values and random numbers, so the runs start from their own initial
+ * values, with their own random number generators.  The final ELBO of
+ * each run is estimated afresh with `elbo_samples` draws once its
+ * stochastic gradient ascent stops.  If `abandon_elbo_margin` is
+ * finite, a run whose best ELBO trails the best ELBO of all runs by
+ * more than the margin after `abandon_min_iterations` iterations is
+ * abandoned, freeing its thread for the runs not yet started.
+ *
+ * The mean and draws of the kept run are written as those of
+ * `meanfield`, preceded by a message naming it.  The eta of each run is
+ * adapted, if engaged, but not written.
+ *
+ * @tparam Model A model implementation
+ * @tparam InitContextPtr A pointer like type to a var context
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var contexts for initialization, one per run
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id chain id of the first run; the random number
+ *   generator of each run is advanced by its own chain id
+ * @param[in] init_radius radius to initialize
+ * @param[in] grad_samples number of samples for Monte Carlo estimate
+ *   of gradients
+ * @param[in] elbo_samples number of samples for Monte Carlo estimate
+ *   of ELBO
+ * @param[in] max_iterations maximum number of iterations
+ * @param[in] tol_rel_obj convergence tolerance on the relative norm
+ *   of the objective
+ * @param[in] eta stepsize scaling parameter for variational inference
+ * @param[in] adapt_engaged adaptation engaged?
+ * @param[in] adapt_iterations number of iterations for eta adaptation
+ * @param[in] eval_elbo evaluate ELBO every Nth iteration
+ * @param[in] output_samples number of posterior samples to draw and
+ *   save
+ * @param[in] num_runs number of runs
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages, tagged with the chain id
+ *   of each run
+ * @param[in,out] init_writers Writer callbacks for unconstrained inits,
+ *   one per run
+ * @param[in,out] diagnostic_writers output for diagnostic values, one
+ *   per run
+ * @param[in,out] parameter_writer output for parameter values of the
+ *   kept run
+ * @param[in] abandon_elbo_margin Non-negative difference of ELBO by
+ *   which a run's best ELBO must trail the best of all runs for the run
+ *   to be abandoned. The default of infinity never abandons a run.
+ * @param[in] abandon_min_iterations Number of iterations a run makes
+ *   before it can be abandoned
+ * @return error_codes::OK if at least one run completed
+ */
+template <class Model, typename InitContextPtr, typename InitWriter,
+          typename DiagnosticWriter>
+int meanfield_multi(
+    Model& model, const std::vector<InitContextPtr>& init,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int grad_samples, int elbo_samples, int max_iterations,
+    double tol_rel_obj, double eta, bool adapt_engaged, int adapt_iterations,
+    int eval_elbo, int output_samples, size_t num_runs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writers,
+    std::vector<DiagnosticWriter>& diagnostic_writers,
+    callbacks::writer& parameter_writer,
+    double abandon_elbo_margin = std::numeric_limits<double>::infinity(),
+    int abandon_min_iterations = 0) {
+  return internal::run_advi_multi<stan::variational::normal_meanfield>(
+      model, init, random_seed, init_chain_id, init_radius, grad_samples,
+      elbo_samples, max_iterations, tol_rel_obj, eta, adapt_engaged,
+      adapt_iterations, eval_elbo, output_samples, num_runs, interrupt,
+      logger, init_writers, diagnostic_writers, parameter_writer,
+      abandon_elbo_margin, abandon_min_iterations);
+}
+
+/**
+ * Runs several instances of full rank ADVI in parallel, sharing the
+ * model, and writes the approximation of the run with the best final
+ * ELBO, as `meanfield_multi` does for mean field ADVI.
+ *
+ * @tparam Model A model implementation
+ * @tparam InitContextPtr A pointer like type to a var context
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var contexts for initialization, one per run
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id chain id of the first run
+ * @param[in] init_radius radius to initialize
+ * @param[in] grad_samples number of samples for Monte Carlo estimate
+ *   of gradients
+ * @param[in] elbo_samples number of samples for Monte Carlo estimate
+ *   of ELBO
+ * @param[in] max_iterations maximum number of iterations
+ * @param[in] tol_rel_obj convergence tolerance on the relative norm
+ *   of the objective
+ * @param[in] eta stepsize scaling parameter for variational inference
+ * @param[in] adapt_engaged adaptation engaged?
+ * @param[in] adapt_iterations number of iterations for eta adaptation
+ * @param[in] eval_elbo evaluate ELBO every Nth iteration
+ * @param[in] output_samples number of posterior samples to draw and
+ *   save
+ * @param[in] num_runs number of runs
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writers Writer callbacks for unconstrained inits,
+ *   one per run
+ * @param[in,out] diagnostic_writers output for diagnostic values, one
+ *   per run
+ * @param[in,out] parameter_writer output for parameter values of the
+ *   kept run
+ * @param[in] abandon_elbo_margin Non-negative difference of ELBO by
+ *   which a run must trail the best run to be abandoned
+ * @param[in] abandon_min_iterations Number of iterations a run makes
+ *   before it can be abandoned
+ * @return error_codes::OK if at least one run completed
+ */
+template <class Model, typename InitContextPtr, typename InitWriter,
+          typename DiagnosticWriter>
+int fullrank_multi(
+    Model& model, const std::vector<InitContextPtr>& init,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int grad_samples, int elbo_samples, int max_iterations,
+    double tol_rel_obj, double eta, bool adapt_engaged, int adapt_iterations,
+    int eval_elbo, int output_samples, size_t num_runs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writers,
+    std::vector<DiagnosticWriter>& diagnostic_writers,
+    callbacks::writer& parameter_writer,
+    double abandon_elbo_margin = std::numeric_limits<double>::infinity(),
+    int abandon_min_iterations = 0) {
+  return internal::run_advi_multi<stan::variational::normal_fullrank>(
+      model, init, random_seed, init_chain_id, init_radius, grad_samples,
+      elbo_samples, max_iterations, tol_rel_obj, eta, adapt_engaged,
+      adapt_iterations, eval_elbo, output_samples, num_runs, interrupt,
+      logger, init_writers, diagnostic_writers, parameter_writer,
+      abandon_elbo_margin, abandon_min_iterations);
+}
+
+}  // namespace advi
+}  // namespace experimental
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,242 @@
+#ifndef STAN_SERVICES_LOG_PROB_LOG_PROB_GRAD_HPP
+#define STAN_SERVICES_LOG_PROB_LOG_PROB_GRAD_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/rev.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <stan/services/error_codes.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace log_prob {
+
+namespace internal {
+
+/**
+ * The log density and gradient of one draw, with the messages logged
+ * while evaluating them, kept until the draws before it are written.
+ */
+struct log_prob_draw {
+  std::vector<double> values;
+  std::vector<std::string> info;
+  std::vector<std::string> errors;
+  int return_code = error_codes::OK;
+};
+
+/**
+ * Buffers reused by a thread for the draws it evaluates.
+ */
+struct log_prob_buffers {
+  std::vector<double> row;
+  std::vector<double> unconstrained;
+  Eigen::VectorXd params_r;
+  Eigen::VectorXd gradient;
+};
+
+/**
+ * Evaluate the log density, and its gradient if specified, of a draw,
+ * keeping the values and messages in the specified result.  The log
+ * density drops constant terms and includes the Jacobian of the
+ * constraining transforms if specified.  A draw outside the support of
+ * the density, for which the model throws a domain error, gets a log
+ * density of negative infinity and a gradient of NaN.
+ *
+ * @tparam jacobian true to include the Jacobian
+ * @tparam Model model class
+ * @tparam Row type of the draw
+ * @param[in] model instantiated model
+ * @param[in] draw parameter values
+ * @param[in] constrained true if the draw is of the constrained
+ * parameters, which are unconstrained first
+ * @param[in] gradient true to evaluate the gradient
+ * @param[in, out] buffers buffers of the calling thread
+ * @param[out] result values, messages and return code of the draw
+ */
+template <bool jacobian, class Model, typename Row>
+void log_prob_grad_draw(const Model& model, const Row& draw, bool constrained,
+                        bool gradient, log_prob_buffers& buffers,
+                        log_prob_draw& result) {
+  result.info.clear();
+  result.errors.clear();
+  result.return_code = error_codes::OK;
+  std::stringstream msg;
+  if (constrained) {
+    buffers.row.resize(draw.size());
+    Eigen::Map<Eigen::RowVectorXd>(buffers.row.data(), draw.size()) = draw;
+    try {
+      model.unconstrain_array(buffers.row, buffers.unconstrained, &msg);
+    } catch (const std::exception& e) {
+      if (msg.str().length() > 0)
+        result.errors.push_back(msg.str());
+      result.errors.push_back(e.what());
+      result.return_code = error_codes::DATAERR;
+      return;
+    }
+    buffers.params_r = Eigen::Map<const Eigen::VectorXd>(
+        buffers.unconstrained.data(), buffers.unconstrained.size());
+  } else {
+    buffers.params_r = draw.transpose();
+  }
+
+  const size_t num_params = buffers.params_r.size();
+  result.values.resize(gradient ? 1 + num_params : 1);
+  try {
+    if (gradient) {
+      result.values[0] = stan::model::log_prob_grad<true, jacobian>(
+          model, buffers.params_r, buffers.gradient, &msg);
+      std::copy(buffers.gradient.data(), buffers.gradient.data() + num_params,
+                result.values.begin() + 1);
+    } else {
+      result.values[0] = stan::model::log_prob_propto<jacobian>(
+          model, buffers.params_r, &msg);
+    }
+    if (msg.str().length() > 0)
+      result.info.push_back(msg.str());
+  } catch (const std::domain_error& e) {
+    if (msg.str().length() > 0)
+      result.info.push_back(msg.str());
+    result.info.push_back(e.what());
+    std::fill(result.values.begin(), result.values.end(),
+              std::numeric_limits<double>::quiet_NaN());
+    result.values[0] = -std::numeric_limits<double>::infinity();
+  } catch (const std::exception& e) {
+    if (msg.str().length() > 0)
+      result.info.push_back(msg.str());
+    result.errors.push_back(e.what());
+    result.return_code = error_codes::SOFTWARE;
+  }
+}
+
+}  // namespace internal
+
+/**
+ * Evaluate the log density of the model, and its gradient with respect
+ * to the unconstrained parameters if specified, at each of a set of
+ * draws, in parallel, and write them to the writer in the order of the
+ * draws.  Matrix of draws consists of one row per draw, one column per
+ * parameter, either of the constrained parameters, as written by the
+ * samplers without the sampler diagnostics, transformed parameters and
+ * generated quantities, or of the unconstrained parameters.
+ * Return code indicates success or type of error.
+ *
+ * <p>The log density drops constant terms, as it does for the
+ * samplers, and includes the log absolute determinant of the Jacobian
+ * of the constraining transforms if specified.  The writer gets the
+ * column names <code>lp__</code> and, with the gradient,
+ * <code>g_1</code> to <code>g_N</code> for the N unconstrained
+ * parameters, then one row per draw.  A draw at which the model
+ * rejects, throwing a domain error, has a log density of negative
+ * infinity and a gradient of NaN, and its message is logged as info.
+ * A draw whose constrained parameters cannot be unconstrained stops
+ * the evaluation with <code>error_codes::DATAERR</code>.
+ *
+ * <p>The draws are evaluated in parallel by blocks of draws, each
+ * thread reusing its buffers.  A bounded window of draws is evaluated
+ * before their values are written, in order, by the calling thread,
+ * which also calls the interrupt and logger, so the output does not
+ * depend on the number of threads.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in] draws draws of the parameters, one per row
+ * @param[in] constrained true if the draws are of the constrained
+ * parameters, false if of the unconstrained parameters
+ * @param[in] jacobian true to include the Jacobian of the transforms
+ * @param[in] gradient true to also evaluate the gradient
+ * @param[in, out] interrupt called for every draw written
+ * @param[in, out] logger logger to which to write messages
+ * @param[in, out] output_writer writer to which the values are written
+ * @return error code
+ */
+template <class Model>
+int log_prob_grad(const Model& model, const Eigen::MatrixXd& draws,
+                  bool constrained, bool jacobian, bool gradient,
+                  callbacks::interrupt& interrupt, callbacks::logger& logger,
+                  callbacks::writer& output_writer) {
+  if (draws.size() == 0) {
+    logger.error("Empty set of draws.");
+    return error_codes::DATAERR;
+  }
+  size_t num_columns = model.num_params_r();
+  if (constrained) {
+    std::vector<std::string> p_names;
+    model.constrained_param_names(p_names, false, false);
+    num_columns = p_names.size();
+  }
+  if (static_cast<size_t>(draws.cols()) != num_columns) {
+    std::stringstream msg;
+    msg << "Wrong number of " << (constrained ? "" : "un")
+        << "constrained parameter values in draws.  Expecting "
+        << num_columns << " columns, found " << draws.cols() << " columns.";
+    logger.error(msg.str());
+    return error_codes::DATAERR;
+  }
+
+  std::vector<std::string> names{"lp__"};
+  if (gradient)
+    for (size_t i = 0; i < model.num_params_r(); ++i)
+      names.push_back("g_" + std::to_string(i + 1));
+  output_writer(names);
+
+  const size_t num_draws = draws.rows();
+  const size_t block_size = 16;
+  const size_t window = std::min<size_t>(
+      num_draws,
+      block_size * 4 * std::max(tbb::this_task_arena::max_concurrency(), 1));
+  tbb::enumerable_thread_specific<internal::log_prob_buffers> buffers;
+  std::vector<internal::log_prob_draw> results(window);
+  try {
+    for (size_t first = 0; first < num_draws; first += window) {
+      const size_t last = std::min(num_draws, first + window);
+      tbb::parallel_for(
+          tbb::blocked_range<size_t>(first, last, block_size),
+          [&](const tbb::blocked_range<size_t>& r) {
+            internal::log_prob_buffers& thread_buffers = buffers.local();
+            for (size_t i = r.begin(); i != r.end(); ++i) {
+              if (jacobian)
+                internal::log_prob_grad_draw<true>(
+                    model, draws.row(i), constrained, gradient,
+                    thread_buffers, results[i - first]);
+              else
+                internal::log_prob_grad_draw<false>(
+                    model, draws.row(i), constrained, gradient,
+                    thread_buffers, results[i - first]);
+            }
+          });
+
+      for (size_t i = first; i < last; ++i) {
+        internal::log_prob_draw& result = results[i - first];
+        interrupt();  // call out to interrupt and fail
+        for (const auto& info : result.info)
+          logger.info(info);
+        if (result.return_code != error_codes::OK) {
+          for (const auto& error : result.errors)
+            logger.error(error);
+          return result.return_code;
+        }
+        output_writer(result.values);
+      }
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace log_prob
+}  // namespace services
+}  // namespace stan
+#endif
@@ -3,10 +3,13 @@
 
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/optimization/bfgs.hpp>
+#include <stan/services/optimize/lbfgs.hpp>
+#include <stan/services/optimize/iteration_recorder.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <fstream>
@@ -19,46 +22,31 @@ namespace stan {
 namespace services {
 namespace optimize {
 
+namespace internal {
+
 /**
- * Runs the BFGS algorithm for a model.
+ * Runs the BFGS algorithm for a model with the given random number
+ * generator and update of the inverse Hessian approximation, as
+ * stan::services::optimize::bfgs does.
  *
+ * @tparam jacobian `true` to include Jacobian adjustment
+ * @tparam QNUpdate update of the inverse Hessian approximation,
+ *   stan::optimization::BFGSUpdate_HInv or BFGSUpdate_HInv_packed
  * @tparam Model A model implementation
- * @tparam jacobian `true` to include Jacobian adjust (default `false`)
- * @param[in] model Input model to test (with data already instantiated)
- * @param[in] init var context for initialization
- * @param[in] random_seed random seed for the random number generator
- * @param[in] chain chain id to advance the pseudo random number generator
- * @param[in] init_radius radius to initialize
- * @param[in] init_alpha line search step size for first iteration
- * @param[in] tol_obj convergence tolerance on absolute changes in
- *   objective function value
- * @param[in] tol_rel_obj convergence tolerance on relative changes
- *   in objective function value
- * @param[in] tol_grad convergence tolerance on the norm of the gradient
- * @param[in] tol_rel_grad convergence tolerance on the relative norm of
- *   the gradient
- * @param[in] tol_param convergence tolerance on changes in parameter
- *   value
- * @param[in] num_iterations maximum number of iterations
- * @param[in] save_iterations indicates whether all the iterations should
- *   be saved to the parameter_writer
- * @param[in] refresh how often to write output to logger
- * @param[in,out] interrupt callback to be called every iteration
- * @param[in,out] logger Logger for messages
- * @param[in,out] init_writer Writer callback for unconstrained inits
- * @param[in,out] parameter_writer output for parameter values
+ * @param[in,out] rng random number generator
+ * @see stan::services::optimize::bfgs for the other parameters
  * @return error_codes::OK if successful
  */
-template <class Model, bool jacobian = false>
-int bfgs(Model& model, const stan::io::var_context& init,
-         unsigned int random_seed, unsigned int chain, double init_radius,
-         double init_alpha, double tol_obj, double tol_rel_obj, double tol_grad,
-         double tol_rel_grad, double tol_param, int num_iterations,
-         bool save_iterations, int refresh, callbacks::interrupt& interrupt,
-         callbacks::logger& logger, callbacks::writer& init_writer,
-         callbacks::writer& parameter_writer) {
-  stan::rng_t rng = util::create_rng(random_seed, chain);
-
+template <bool jacobian, class QNUpdate, class Model>
+int run_bfgs(Model& model, const stan::io::var_context& init,
+             stan::rng_t& rng, double init_radius, double init_alpha,
+             double tol_obj, double tol_rel_obj, double tol_grad,
+             double tol_rel_grad, double tol_param, int num_iterations,
+             bool save_iterations, int refresh,
+             callbacks::interrupt& interrupt, callbacks::logger& logger,
+             callbacks::writer& init_writer,
+             callbacks::writer& parameter_writer,
+             callbacks::structured_writer& iteration_writer) {
   std::vector<int> disc_vector;
   std::vector<double> cont_vector;
   try {
@@ -70,8 +58,7 @@ int bfgs(Model& model, const stan::io::var_context& init,
   }
   std::stringstream bfgs_ss;
   typedef stan::optimization::BFGSLineSearch<
-      Model, stan::optimization::BFGSUpdate_HInv<>, double, Eigen::Dynamic,
-      jacobian>
+      Model, QNUpdate, double, Eigen::Dynamic, jacobian>
       Optimizer;
   Optimizer bfgs(model, cont_vector, disc_vector, &bfgs_ss);
   bfgs._ls_opts.alpha0 = init_alpha;
@@ -113,6 +100,8 @@ int bfgs(Model& model, const stan::io::var_context& init,
     parameter_writer(values);
   }
   int ret = 0;
+  internal::iteration_recorder<Optimizer> recorder(iteration_writer, bfgs,
+                                                   "bfgs");
 
   try {
     while (ret == 0) {
@@ -129,7 +118,9 @@ int bfgs(Model& model, const stan::io::var_context& init,
             "  # evals"
             "  Notes ");
 
+      recorder.begin_step();
       ret = bfgs.step();
+      recorder.end_step(ret);
 
       lp = bfgs.logp();
       bfgs.params_r(cont_vector);
@@ -211,6 +202,147 @@ int bfgs(Model& model, const stan::io::var_context& init,
   return return_code;
 }
 
+}  // namespace internal
+
+/**
+ * Runs the BFGS algorithm for a model.
+ *
+ * The BFGS approximation of the inverse Hessian takes memory quadratic
+ * in the number of parameters, so it is stored packed, or replaced by
+ * L-BFGS, when it would take more than `max_hessian_mb` megabytes.
+ *
+ * @tparam Model A model implementation
+ * @tparam jacobian `true` to include Jacobian adjust (default `false`)
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] init_alpha line search step size for first iteration
+ * @param[in] tol_obj convergence tolerance on absolute changes in
+ *   objective function value
+ * @param[in] tol_rel_obj convergence tolerance on relative changes
+ *   in objective function value
+ * @param[in] tol_grad convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad convergence tolerance on the relative norm of
+ *   the gradient
+ * @param[in] tol_param convergence tolerance on changes in parameter
+ *   value
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved to the parameter_writer
+ * @param[in] refresh how often to write output to logger
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @param[in,out] iteration_writer output for the record of the
+ *   iterations: per iteration the log density, step and gradient norms,
+ *   line search step sizes and trials, evaluation counts and the wall
+ *   time, total and inside the model
+ * @param[in] max_hessian_mb memory in megabytes the inverse Hessian
+ *   approximation may take.  The dense approximation, with its
+ *   temporaries, takes 3 N^2 values for N unconstrained parameters.
+ *   Above the limit the lower triangle is stored packed, in N (N + 1) / 2
+ *   values, and above the limit for that the optimization switches to
+ *   L-BFGS with the default history size of 5, logging the switch.
+ * @return error_codes::OK if successful
+ */
+template <class Model, bool jacobian = false>
+int bfgs(Model& model, const stan::io::var_context& init,
+         unsigned int random_seed, unsigned int chain, double init_radius,
+         double init_alpha, double tol_obj, double tol_rel_obj, double tol_grad,
+         double tol_rel_grad, double tol_param, int num_iterations,
+         bool save_iterations, int refresh, callbacks::interrupt& interrupt,
+         callbacks::logger& logger, callbacks::writer& init_writer,
+         callbacks::writer& parameter_writer,
+         callbacks::structured_writer& iteration_writer,
+         double max_hessian_mb = 1024) {
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+  const double num_params = model.num_params_r();
+  const double value_mb = sizeof(double) / (1024.0 * 1024.0);
+  if (3 * num_params * num_params * value_mb <= max_hessian_mb) {
+    return internal::run_bfgs<jacobian,
+                              stan::optimization::BFGSUpdate_HInv<>>(
+        model, init, rng, init_radius, init_alpha, tol_obj, tol_rel_obj,
+        tol_grad, tol_rel_grad, tol_param, num_iterations, save_iterations,
+        refresh, interrupt, logger, init_writer, parameter_writer,
+        iteration_writer);
+  }
+  if (0.5 * num_params * (num_params + 1) * value_mb <= max_hessian_mb) {
+    std::stringstream msg;
+    msg << "Storing the BFGS inverse Hessian approximation packed to fit "
+        << "in " << max_hessian_mb << " MB.";
+    logger.info(msg);
+    return internal::run_bfgs<jacobian,
+                              stan::optimization::BFGSUpdate_HInv_packed<>>(
+        model, init, rng, init_radius, init_alpha, tol_obj, tol_rel_obj,
+        tol_grad, tol_rel_grad, tol_param, num_iterations, save_iterations,
+        refresh, interrupt, logger, init_writer, parameter_writer,
+        iteration_writer);
+  }
+  std::stringstream msg;
+  msg << "The BFGS inverse Hessian approximation would not fit in "
+      << max_hessian_mb << " MB, using L-BFGS with a history size of 5.";
+  logger.info(msg);
+  internal::lbfgs_result result;
+  return internal::run_lbfgs<jacobian>(
+      model, init, rng, init_radius, 5, init_alpha, tol_obj, tol_rel_obj,
+      tol_grad, tol_rel_grad, tol_param, num_iterations, save_iterations,
+      refresh, interrupt, logger, init_writer, parameter_writer,
+      iteration_writer, "", nullptr, result);
+}
+
+/**
+ * Runs the BFGS algorithm for a model, without a record of the
+ * iterations.
+ *
+ * @tparam Model A model implementation
+ * @tparam jacobian `true` to include Jacobian adjust (default `false`)
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] init_alpha line search step size for first iteration
+ * @param[in] tol_obj convergence tolerance on absolute changes in
+ *   objective function value
+ * @param[in] tol_rel_obj convergence tolerance on relative changes
+ *   in objective function value
+ * @param[in] tol_grad convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad convergence tolerance on the relative norm of
+ *   the gradient
+ * @param[in] tol_param convergence tolerance on changes in parameter
+ *   value
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved to the parameter_writer
+ * @param[in] refresh how often to write output to logger
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @param[in] max_hessian_mb memory in megabytes the inverse Hessian
+ *   approximation may take, see the overload with an iteration writer
+ * @return error_codes::OK if successful
+ */
+template <class Model, bool jacobian = false>
+int bfgs(Model& model, const stan::io::var_context& init,
+         unsigned int random_seed, unsigned int chain, double init_radius,
+         double init_alpha, double tol_obj, double tol_rel_obj, double tol_grad,
+         double tol_rel_grad, double tol_param, int num_iterations,
+         bool save_iterations, int refresh, callbacks::interrupt& interrupt,
+         callbacks::logger& logger, callbacks::writer& init_writer,
+         callbacks::writer& parameter_writer, double max_hessian_mb = 1024) {
+  callbacks::structured_writer dummy_iteration_writer;
+  return bfgs<Model, jacobian>(model, init, random_seed, chain, init_radius,
+                               init_alpha, tol_obj, tol_rel_obj, tol_grad,
+                               tol_rel_grad, tol_param, num_iterations,
+                               save_iterations, refresh, interrupt, logger,
+                               init_writer, parameter_writer,
+                               dummy_iteration_writer, max_hessian_mb);
+}
+
 }  // namespace optimize
 }  // namespace services
 }  // namespace stan
@@ -0,0 +1,121 @@
+#ifndef STAN_SERVICES_OPTIMIZE_ITERATION_RECORDER_HPP
+#define STAN_SERVICES_OPTIMIZE_ITERATION_RECORDER_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/model/profile_data.hpp>
+#include <chrono>
+#include <string>
+
+namespace stan {
+namespace services {
+namespace optimize {
+namespace internal {
+
+/**
+ * Writes a structured record of the iterations of a BFGS or L-BFGS
+ * optimizer, for tuning the optimizer.
+ *
+ * The record is opened on construction and closed on destruction.  It
+ * holds the name of the algorithm, a record per iteration keyed by the
+ * iteration number, and the totals of the run.  Each iteration writes
+ * the log density, the norms of the step and the gradient, the initial
+ * and final line search step sizes, the number of line search trials
+ * (each of which evaluates the log density and its gradient), the
+ * cumulative number of evaluations, the wall time of the iteration and
+ * the part of it spent evaluating the model, the optimizer's note and
+ * its return code.  Times are in seconds.  When the profile map of the
+ * model is registered, the totals also hold those of its
+ * <code>profile</code> blocks on the thread of the run.
+ *
+ * @tparam Optimizer A stan::optimization::BFGSLineSearch
+ */
+template <class Optimizer>
+class iteration_recorder {
+ public:
+  /**
+   * Open the record of the run.
+   *
+   * @param[in,out] writer writer for the record
+   * @param[in] optimizer optimizer, initialized
+   * @param[in] algorithm name of the algorithm
+   */
+  iteration_recorder(callbacks::structured_writer& writer,
+                     Optimizer& optimizer, const std::string& algorithm)
+      : writer_(writer),
+        optimizer_(optimizer),
+        start_(std::chrono::steady_clock::now()),
+        step_start_(start_),
+        step_evals_(0),
+        step_eval_time_(0),
+        profile_(stan::model::profile_snapshot::current_thread()) {
+    writer_.begin_record();
+    writer_.write("algorithm", algorithm);
+    writer_.begin_record("iterations");
+  }
+
+  /**
+   * Close the record, writing the totals of the run.
+   */
+  ~iteration_recorder() {
+    writer_.end_record();
+    writer_.write("evaluations", optimizer_.grad_evals());
+    writer_.write("time", seconds_since(start_));
+    writer_.write("model_time", optimizer_.eval_time());
+    stan::model::profile_snapshot::current_thread().since(profile_).write(
+        writer_, "profile");
+    writer_.end_record();
+  }
+
+  /**
+   * Mark the start of an iteration.
+   */
+  void begin_step() {
+    step_start_ = std::chrono::steady_clock::now();
+    step_evals_ = optimizer_.grad_evals();
+    step_eval_time_ = optimizer_.eval_time();
+  }
+
+  /**
+   * Write the record of the iteration started by the last call to
+   * <code>begin_step</code>.
+   *
+   * @param[in] return_code return code of the iteration
+   */
+  void end_step(int return_code) {
+    const double time = seconds_since(step_start_);
+    writer_.begin_record(std::to_string(optimizer_.iter_num()));
+    writer_.write("lp", optimizer_.logp());
+    writer_.write("step_norm", optimizer_.prev_step_size());
+    writer_.write("grad_norm", optimizer_.grad_norm());
+    writer_.write("alpha", optimizer_.alpha());
+    writer_.write("alpha0", optimizer_.alpha0());
+    writer_.write("line_search_trials", optimizer_.grad_evals() - step_evals_);
+    writer_.write("evaluations", optimizer_.grad_evals());
+    writer_.write("time", time);
+    writer_.write("model_time", optimizer_.eval_time() - step_eval_time_);
+    writer_.write("note", optimizer_.note());
+    writer_.write("return_code", return_code);
+    writer_.end_record();
+  }
+
+ private:
+  callbacks::structured_writer& writer_;
+  Optimizer& optimizer_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::time_point step_start_;
+  size_t step_evals_;
+  double step_eval_time_;
+  stan::model::profile_snapshot profile_;
+
+  static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                         - start)
+        .count();
+  }
+};
+
+}  // namespace internal
+}  // namespace optimize
+}  // namespace services
+}  // namespace stan
+#endif
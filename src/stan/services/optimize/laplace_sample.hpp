@@ -1,13 +1,25 @@
 #ifndef STAN_SERVICES_OPTIMIZE_LAPLACE_SAMPLE_HPP
 #define STAN_SERVICES_OPTIMIZE_LAPLACE_SAMPLE_HPP
 
+#include <stan/analyze/psis.hpp>
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/callbacks/structured_writer.hpp>
-#include <stan/math/rev.hpp>
+#include <stan/math/mix.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <stan/model/sparse_hessian.hpp>
 #include <stan/services/error_codes.hpp>
+#include <stan/services/pathfinder/single.hpp>
 #include <stan/services/util/create_rng.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -16,12 +28,171 @@ namespace stan {
 namespace services {
 namespace internal {
 
+/**
+ * Functor for the log density of a model, templated on the scalar type
+ * so that it can be differentiated with nested forward-over-reverse
+ * autodiff.
+ */
 template <bool jacobian, typename Model>
-void laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
-                    int draws, bool calculate_lp, unsigned int random_seed,
-                    int refresh, callbacks::interrupt& interrupt,
-                    callbacks::logger& logger, callbacks::writer& sample_writer,
-                    callbacks::structured_writer& hessian_writer) {
+struct laplace_log_density {
+  const Model& model_;
+  std::ostream* msgs_;
+
+  laplace_log_density(const Model& model, std::ostream* msgs)
+      : model_(model), msgs_(msgs) {}
+
+  template <typename T>
+  T operator()(const Eigen::Matrix<T, -1, 1>& theta) const {
+    return model_.template log_prob<true, jacobian, T>(
+        const_cast<Eigen::Matrix<T, -1, 1>&>(theta), msgs_);
+  }
+};
+
+/**
+ * Calculate the log density, gradient, and Hessian of a model by finite
+ * differences of gradients, with the gradients at the perturbed points
+ * evaluated in parallel.
+ *
+ * The perturbations and the combination of the gradients are those of
+ * `stan::math::internal::finite_diff_hessian_auto`, so the result does
+ * not depend on the number of threads.  Messages of the evaluations are
+ * written to `msgs` in the order of the perturbations.  Gradients can
+ * only be evaluated in parallel if Stan Math is built with
+ * `STAN_THREADS`.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @param[in] model model
+ * @param[in] theta unconstrained parameters
+ * @param[out] log_p log density at `theta`
+ * @param[out] grad gradient at `theta`
+ * @param[out] hessian Hessian at `theta`
+ * @param[in,out] msgs stream for messages of the model
+ */
+template <bool jacobian, typename Model>
+void parallel_finite_diff_hessian(const Model& model,
+                                  const Eigen::VectorXd& theta, double& log_p,
+                                  Eigen::VectorXd& grad,
+                                  Eigen::MatrixXd& hessian,
+                                  std::ostream& msgs) {
+  const int N = theta.size();
+  Eigen::VectorXd epsilons(N);
+  for (int n = 0; n < N; ++n) {
+    epsilons(n) = math::finite_diff_stepsize(theta(n));
+  }
+  // the first N gradients are at theta + epsilon, the last N at
+  // theta - epsilon
+  std::vector<Eigen::VectorXd> grads(2 * N);
+  std::vector<std::string> grad_msgs(2 * N);
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, 2 * N),
+                    [&](const tbb::blocked_range<size_t>& r) {
+                      for (size_t k = r.begin(); k != r.end(); ++k) {
+                        const int n = k % N;
+                        Eigen::VectorXd theta_k(theta);
+                        theta_k(n) += k < static_cast<size_t>(N) ? epsilons(n)
+                                                             : -epsilons(n);
+                        std::stringstream ss;
+                        stan::model::log_prob_grad<true, jacobian>(
+                            model, theta_k, grads[k], &ss);
+                        grad_msgs[k] = ss.str();
+                      }
+                    });
+  for (const auto& msg : grad_msgs) {
+    msgs << msg;
+  }
+
+  hessian.resize(N, N);
+  for (int i = 0; i < N; ++i) {
+    for (int j = i; j < N; ++j) {
+      hessian(j, i) = (grads[j](i) - grads[N + j](i)) / (4 * epsilons(j))
+                      + (grads[i](j) - grads[N + i](j)) / (4 * epsilons(i));
+      hessian(i, j) = hessian(j, i);
+    }
+  }
+  Eigen::VectorXd theta_copy(theta);
+  log_p = stan::model::log_prob_grad<true, jacobian>(model, theta_copy, grad,
+                                                     &msgs);
+}
+
+/**
+ * Calculate the products of the Hessian of the log density of a model
+ * with the columns of a matrix, evaluated in parallel over the columns.
+ *
+ * The products are either calculated with forward-over-reverse autodiff
+ * or approximated by central finite differences of gradients along each
+ * column.  Messages of the evaluations are written to `msgs` in the order
+ * of the columns.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @param[in] model model
+ * @param[in] theta unconstrained parameters
+ * @param[in] V matrix whose columns are multiplied by the Hessian
+ * @param[in] autodiff whether to use autodiff instead of finite
+ * differences
+ * @param[in,out] msgs stream for messages of the model
+ * @return Hessian at `theta` times `V`
+ */
+template <bool jacobian, typename Model>
+Eigen::MatrixXd hessian_times_vectors(const Model& model,
+                                      const Eigen::VectorXd& theta,
+                                      const Eigen::MatrixXd& V, bool autodiff,
+                                      std::ostream& msgs) {
+  Eigen::MatrixXd HV(V.rows(), V.cols());
+  std::vector<std::string> hv_msgs(V.cols());
+  const double scale
+      = math::finite_diff_stepsize(theta.lpNorm<Eigen::Infinity>());
+  tbb::parallel_for(
+      tbb::blocked_range<Eigen::Index>(0, V.cols()),
+      [&](const tbb::blocked_range<Eigen::Index>& r) {
+        for (Eigen::Index k = r.begin(); k != r.end(); ++k) {
+          std::stringstream ss;
+          const Eigen::VectorXd v = V.col(k);
+          if (autodiff) {
+            double log_p;
+            Eigen::VectorXd hv;
+            math::hessian_times_vector(
+                laplace_log_density<jacobian, Model>(model, &ss), theta, v,
+                log_p, hv);
+            HV.col(k) = hv;
+          } else {
+            const double epsilon = scale / v.lpNorm<Eigen::Infinity>();
+            Eigen::VectorXd theta_plus = theta + epsilon * v;
+            Eigen::VectorXd theta_minus = theta - epsilon * v;
+            Eigen::VectorXd g_plus;
+            Eigen::VectorXd g_minus;
+            stan::model::log_prob_grad<true, jacobian>(model, theta_plus,
+                                                       g_plus, &ss);
+            stan::model::log_prob_grad<true, jacobian>(model, theta_minus,
+                                                       g_minus, &ss);
+            HV.col(k) = (g_plus - g_minus) / (2 * epsilon);
+          }
+          hv_msgs[k] = ss.str();
+        }
+      });
+  for (const auto& msg : hv_msgs) {
+    msgs << msg;
+  }
+  return HV;
+}
+
+/**
+ * Check the arguments of the Laplace samplers and write the names of
+ * the output columns to the sample writer.
+ *
+ * @tparam Model a Stan model
+ * @param[in] model model
+ * @param[in] theta_hat unconstrained mode
+ * @param[in] draws number of draws
+ * @param[in,out] sample_writer callback for writing the names
+ * @throw std::domain_error if the number of draws is not positive or
+ * the mode is the wrong size
+ */
+template <typename Model>
+void start_laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
+                          int draws, callbacks::writer& sample_writer) {
   if (draws <= 0) {
     throw std::domain_error("Number of draws must be > 0; found draws = "
                             + std::to_string(draws));
@@ -39,38 +210,165 @@ void laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
         + std::to_string(theta_hat.size()));
   }
 
-  std::vector<std::string> param_tp_gq_names;
-  model.constrained_param_names(param_tp_gq_names, true, true);
-  size_t draw_size = param_tp_gq_names.size();
-
   // write names of params, tps, and gqs to sample writer
   std::vector<std::string> names;
   names.push_back("log_p__");
   names.push_back("log_q__");
+  model.constrained_param_names(names, true, true);
+  sample_writer(names);
+}
+
+/**
+ * Generate draws from a Laplace approximation at the mode and write
+ * them with their log densities to the sample writer.
+ *
+ * The draws are generated in batches: the standard normal variates of a
+ * batch are drawn as one matrix from `rng` and transformed with matrix
+ * operations, and the draws are then constrained in parallel chunks of
+ * fixed size.  Each chunk gets its own random number generator for the
+ * generated quantities, created from `random_seed` and the index of the
+ * chunk, so the output does not depend on the number of threads.
+ * Messages and draws are written in the order of the draws.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @tparam F type of function returning the deviations from the mode of
+ * draws given a matrix whose columns are standard normal variates
+ * @tparam G type of function returning the unnormalized log densities of
+ * the approximation given the deviations of draws from the mode
+ * @param[in] model model
+ * @param[in] theta_hat unconstrained mode
+ * @param[in] draws number of draws
+ * @param[in] calculate_lp whether to calculate the log probability of
+ * the draws
+ * @param[in] random_seed seed of the generators of the chunks
+ * @param[in,out] rng random number generator for the normal variates
+ * @param[in] refresh period between iterations at which updates are given
+ * @param[in] interrupt callback for interrupting sampling
+ * @param[in,out] logger callback for writing console messages
+ * @param[in,out] sample_writer callback for writing the draws
+ * @param[in] deviations function computing the deviations of draws
+ * @param[in] log_q function computing the log densities of the
+ * approximation
+ * @param[out] log_ratios if not null and `calculate_lp` is `true`, the
+ * differences `log_p__ - log_q__` of the draws are appended to it
+ */
+template <bool jacobian, typename Model, typename F, typename G>
+void write_laplace_draws(const Model& model, const Eigen::VectorXd& theta_hat,
+                         int draws, bool calculate_lp,
+                         unsigned int random_seed, stan::rng_t& rng,
+                         int refresh, callbacks::interrupt& interrupt,
+                         callbacks::logger& logger,
+                         callbacks::writer& sample_writer,
+                         const F& deviations, const G& log_q,
+                         std::vector<double>* log_ratios = nullptr) {
   static const bool include_tp = true;
   static const bool include_gq = true;
-  model.constrained_param_names(names, include_tp, include_gq);
-  sample_writer(names);
+  std::vector<std::string> param_tp_gq_names;
+  model.constrained_param_names(param_tp_gq_names, include_tp, include_gq);
+  size_t draw_size = param_tp_gq_names.size();
+  const int num_unc_params = theta_hat.size();
+  // a batch holds about 2^22 variates, in whole chunks
+  const int chunk_size = 64;
+  const int batch_size
+      = chunk_size
+        * std::max(1, (1 << 22) / (chunk_size * std::max(num_unc_params, 1)));
 
-  // create log density functor for vars and vals
-  std::stringstream log_density_msgs;
-  auto log_density_fun
-      = [&](const Eigen::Matrix<stan::math::var, -1, 1>& theta) {
-          return model.template log_prob<true, jacobian, stan::math::var>(
-              const_cast<Eigen::Matrix<stan::math::var, -1, 1>&>(theta),
-              &log_density_msgs);
-        };
+  if (refresh > 0) {
+    logger.info("Generating draws");
+  }
+  std::stringstream refresh_msg;
+  std::vector<std::vector<double>> batch_draws(batch_size);
+  std::vector<std::string> batch_msgs(batch_size);
+  for (int start = 0; start < draws; start += batch_size) {
+    interrupt();
+    const int num_batch = std::min(batch_size, draws - start);
+    Eigen::MatrixXd z(num_unc_params, num_batch);
+    for (int m = 0; m < num_batch; ++m) {
+      for (int n = 0; n < num_unc_params; ++n) {
+        z(n, m) = math::std_normal_rng(rng);
+      }
+    }
+    const Eigen::MatrixXd diff = deviations(z);
+    const Eigen::VectorXd log_qs = log_q(diff);
+
+    const int num_chunks = (num_batch + chunk_size - 1) / chunk_size;
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, num_chunks, 1),
+        [&](const tbb::blocked_range<int>& r) {
+          Eigen::VectorXd unc_draw;
+          Eigen::VectorXd draw_vec;
+          for (int c = r.begin(); c != r.end(); ++c) {
+            stan::rng_t chunk_rng = util::create_rng(
+                random_seed, 1 + (start + c * chunk_size) / chunk_size);
+            const int end = std::min(num_batch, (c + 1) * chunk_size);
+            for (int m = c * chunk_size; m < end; ++m) {
+              unc_draw = theta_hat + diff.col(m);
+              std::stringstream write_array_msgs;
+              model.write_array(chunk_rng, unc_draw, draw_vec, include_tp,
+                                include_gq, &write_array_msgs);
+              // output log_p, log_q, draw
+              double log_p = std::numeric_limits<double>::quiet_NaN();
+              if (calculate_lp) {
+                log_p = stan::model::log_prob_propto<jacobian>(model,
+                                                               unc_draw);
+              }
+              std::vector<double>& draw = batch_draws[m];
+              draw.clear();
+              draw.reserve(draw_size + 2);
+              draw.push_back(log_p);
+              draw.push_back(log_qs(m));
+              draw.insert(draw.end(), draw_vec.data(),
+                          draw_vec.data() + draw_size);
+              batch_msgs[m] = write_array_msgs.str();
+            }
+          }
+        },
+        tbb::simple_partitioner());
+
+    for (int m = 0; m < num_batch; ++m) {
+      interrupt();  // allow interpution each iteration
+      if (refresh > 0 && (start + m) % refresh == 0) {
+        refresh_msg << "iteration: " << std::to_string(start + m);
+        logger.info(refresh_msg);
+        refresh_msg.str(std::string());
+      }
+      if (refresh > 0 && !batch_msgs[m].empty())
+        logger.info(batch_msgs[m]);
+      if (log_ratios != nullptr && calculate_lp)
+        log_ratios->push_back(batch_draws[m][0] - batch_draws[m][1]);
+      sample_writer(batch_draws[m]);
+    }
+  }
+}
+
+template <bool jacobian, typename Model>
+void laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
+                    int draws, bool calculate_lp, unsigned int random_seed,
+                    int refresh, callbacks::interrupt& interrupt,
+                    callbacks::logger& logger, callbacks::writer& sample_writer,
+                    callbacks::structured_writer& hessian_writer,
+                    bool autodiff_hessian) {
+  start_laplace_sample(model, theta_hat, draws, sample_writer);
 
   // calculate inverse negative Hessian's Cholesky factor
   if (refresh > 0) {
     logger.info("Calculating Hessian");
   }
+  std::stringstream log_density_msgs;
   double log_p;          // dummy
   Eigen::VectorXd grad;  // dummy
   Eigen::MatrixXd hessian;
   interrupt();
-  math::internal::finite_diff_hessian_auto(log_density_fun, theta_hat, log_p,
-                                           grad, hessian);
+  if (autodiff_hessian) {
+    math::hessian<laplace_log_density<jacobian, Model>>(
+        laplace_log_density<jacobian, Model>(model, &log_density_msgs),
+        theta_hat, log_p, grad, hessian);
+  } else {
+    parallel_finite_diff_hessian<jacobian>(model, theta_hat, log_p, grad,
+                                           hessian, log_density_msgs);
+  }
   if (refresh > 0 && log_density_msgs.peek() != std::char_traits<char>::eof())
     logger.info(log_density_msgs);
 
@@ -88,50 +386,357 @@ void laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
   }
   Eigen::MatrixXd L_neg_hessian = (-hessian).llt().matrixL();
   interrupt();
-  Eigen::MatrixXd inv_sqrt_neg_hessian = L_neg_hessian.inverse().transpose();
-  interrupt();
   Eigen::MatrixXd half_hessian = 0.5 * hessian;
 
+  // with -H = L L^T, L^(-T) z has covariance (-H)^(-1)
+  stan::rng_t rng = util::create_rng(random_seed, 0);
+  write_laplace_draws<jacobian>(
+      model, theta_hat, draws, calculate_lp, random_seed, rng, refresh,
+      interrupt, logger, sample_writer,
+      [&](const Eigen::MatrixXd& z) -> Eigen::MatrixXd {
+        return L_neg_hessian.transpose().triangularView<Eigen::Upper>().solve(
+            z);
+      },
+      [&](const Eigen::MatrixXd& diff) -> Eigen::VectorXd {
+        return diff.cwiseProduct(half_hessian * diff).colwise().sum()
+            .transpose();
+      });
+}
+
+/**
+ * Approximate the negative Hessian at the mode by a diagonal plus
+ * low-rank matrix from Hessian-vector products and take draws from the
+ * Laplace approximation with that precision matrix.
+ *
+ * The low-rank part `U diag(lambda) U^T` is found with a randomized
+ * range finder: the negative Hessian is applied to `rank` standard
+ * normal vectors, and projected onto the span of the products, whose
+ * nonnegative eigenpairs are kept.  The diagonal of the remainder is
+ * estimated from `num_probes` Rademacher probes and floored at
+ * `sqrt(epsilon)` times the largest diagonal or eigenvalue, so the
+ * approximation is positive definite.  The draws are generated from the
+ * factored form with the Woodbury identity, without forming any
+ * `N x N` matrix.
+ */
+template <bool jacobian, typename Model>
+void laplace_sample_low_rank(const Model& model,
+                             const Eigen::VectorXd& theta_hat, int draws,
+                             bool calculate_lp, int rank, int num_probes,
+                             unsigned int random_seed, int refresh,
+                             callbacks::interrupt& interrupt,
+                             callbacks::logger& logger,
+                             callbacks::writer& sample_writer,
+                             callbacks::structured_writer& hessian_writer,
+                             bool autodiff_hessian) {
+  start_laplace_sample(model, theta_hat, draws, sample_writer);
+  if (rank < 0) {
+    throw std::domain_error("Rank must be >= 0; found rank = "
+                            + std::to_string(rank));
+  }
+  if (num_probes <= 0) {
+    throw std::domain_error(
+        "Number of probes must be > 0; found num_probes = "
+        + std::to_string(num_probes));
+  }
+  const int N = theta_hat.size();
+  rank = std::min(rank, N);
+
   if (refresh > 0) {
-    logger.info("Generating draws");
+    logger.info("Approximating Hessian");
   }
-  // generate draws
-  std::stringstream refresh_msg;
   stan::rng_t rng = util::create_rng(random_seed, 0);
-  Eigen::VectorXd draw_vec;  // declare draw_vec, msgs here to avoid re-alloc
-  for (int m = 0; m < draws; ++m) {
-    interrupt();  // allow interpution each iteration
-    if (refresh > 0 && m % refresh == 0) {
-      refresh_msg << "iteration: " << std::to_string(m);
-      logger.info(refresh_msg);
-      refresh_msg.str(std::string());
+  std::stringstream log_density_msgs;
+  interrupt();
+  Eigen::MatrixXd Omega(N, rank);
+  for (int j = 0; j < rank; ++j) {
+    for (int n = 0; n < N; ++n) {
+      Omega(n, j) = math::std_normal_rng(rng);
     }
-    Eigen::VectorXd z(num_unc_params);
-    for (int n = 0; n < num_unc_params; ++n) {
-      z(n) = math::std_normal_rng(rng);
+  }
+  Eigen::VectorXd lambda(0);
+  Eigen::MatrixXd U(N, 0);
+  if (rank > 0) {
+    Eigen::MatrixXd Y = -hessian_times_vectors<jacobian>(
+        model, theta_hat, Omega, autodiff_hessian, log_density_msgs);
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(Y);
+    Eigen::MatrixXd Q
+        = qr.householderQ() * Eigen::MatrixXd::Identity(N, rank);
+    interrupt();
+    Eigen::MatrixXd B
+        = Q.transpose()
+          * -hessian_times_vectors<jacobian>(model, theta_hat, Q,
+                                             autodiff_hessian,
+                                             log_density_msgs);
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen_B(
+        0.5 * (B + B.transpose()));
+    lambda = eigen_B.eigenvalues().cwiseMax(0);
+    U = Q * eigen_B.eigenvectors();
+  }
+
+  interrupt();
+  Eigen::MatrixXd Psi(N, num_probes);
+  for (int j = 0; j < num_probes; ++j) {
+    for (int n = 0; n < N; ++n) {
+      Psi(n, j) = math::bernoulli_rng(0.5, rng) ? 1.0 : -1.0;
     }
-    Eigen::VectorXd unc_draw = theta_hat + inv_sqrt_neg_hessian * z;
-    std::stringstream write_array_msgs;
-    model.write_array(rng, unc_draw, draw_vec, include_tp, include_gq,
-                      &write_array_msgs);
-    if (refresh > 0 && write_array_msgs.peek() != std::char_traits<char>::eof())
-      logger.info(write_array_msgs);
-    // output draw, log_p, log_q
-    std::vector<double> draw(&draw_vec(0), &draw_vec(0) + draw_size);
-
-    double log_p;
-    if (calculate_lp) {
-      log_p = log_density_fun(unc_draw).val();
-    } else {
-      log_p = std::numeric_limits<double>::quiet_NaN();
+  }
+  Eigen::MatrixXd residual
+      = -hessian_times_vectors<jacobian>(model, theta_hat, Psi,
+                                         autodiff_hessian, log_density_msgs)
+        - U * (lambda.asDiagonal() * (U.transpose() * Psi));
+  Eigen::VectorXd diag
+      = Psi.cwiseProduct(residual).rowwise().sum() / num_probes;
+  double max_scale = std::max(diag.maxCoeff(),
+                              rank > 0 ? lambda.maxCoeff() : 0.0);
+  double min_diag = std::sqrt(std::numeric_limits<double>::epsilon())
+                    * (max_scale > 0 ? max_scale : 1.0);
+  diag = diag.cwiseMax(min_diag);
+
+  Eigen::VectorXd grad;
+  Eigen::VectorXd theta_copy(theta_hat);
+  double log_p = stan::model::log_prob_grad<true, jacobian>(
+      model, theta_copy, grad, &log_density_msgs);
+  if (refresh > 0 && log_density_msgs.peek() != std::char_traits<char>::eof())
+    logger.info(log_density_msgs);
+
+  interrupt();
+  hessian_writer.begin_record();
+  hessian_writer.write("lp_mode", log_p);
+  hessian_writer.write("gradient", grad);
+  hessian_writer.write("neg_hessian_diagonal", diag);
+  hessian_writer.write("neg_hessian_eigenvalues", lambda);
+  hessian_writer.write("neg_hessian_eigenvectors", U);
+  hessian_writer.end_record();
+
+  // The precision is D^(1/2) (I + W W^T) D^(1/2) with
+  // W = D^(-1/2) U diag(lambda)^(1/2), so with the thin SVD
+  // W = V diag(sigma) R^T a square root of its inverse is
+  // D^(-1/2) (I + V diag((1 + sigma^2)^(-1/2) - 1) V^T)
+  interrupt();
+  Eigen::VectorXd inv_sqrt_diag = diag.cwiseSqrt().cwiseInverse();
+  Eigen::MatrixXd W
+      = inv_sqrt_diag.asDiagonal() * U * lambda.cwiseSqrt().asDiagonal();
+  Eigen::MatrixXd V(N, 0);
+  Eigen::VectorXd shrink(0);
+  if (rank > 0) {
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(W, Eigen::ComputeThinU);
+    V = svd.matrixU();
+    shrink = (1 + svd.singularValues().array().square()).rsqrt() - 1;
+  }
+  Eigen::MatrixXd sqrt_lambda_Ut
+      = lambda.cwiseSqrt().asDiagonal() * U.transpose();
+
+  write_laplace_draws<jacobian>(
+      model, theta_hat, draws, calculate_lp, random_seed, rng, refresh,
+      interrupt, logger, sample_writer,
+      [&](const Eigen::MatrixXd& z) -> Eigen::MatrixXd {
+        Eigen::MatrixXd w
+            = z + V * (shrink.asDiagonal() * (V.transpose() * z));
+        return inv_sqrt_diag.asDiagonal() * w;
+      },
+      [&](const Eigen::MatrixXd& diff) -> Eigen::VectorXd {
+        return -0.5
+               * (diag.transpose() * diff.cwiseAbs2()
+                  + (sqrt_lambda_Ut * diff).colwise().squaredNorm())
+                     .transpose();
+      });
+}
+
+/**
+ * Take draws from the Laplace approximation whose covariance is the
+ * inverse Hessian approximation of L-BFGS at the mode, built from the
+ * history of updates as in Pathfinder, with no evaluation of the
+ * Hessian or gradient.  The diagonal of the initial inverse Hessian is
+ * updated with each pair of the history in turn, as Pathfinder does
+ * along the optimization path, and the draws are generated with
+ * `pathfinder::internal::approximate_samples`, at a cost linear in the
+ * number of parameters per draw when the history is small.  With
+ * `calculate_lp`, the Pareto k of the importance ratios of the draws is
+ * logged and written to the Hessian writer.
+ */
+template <bool jacobian, typename Model>
+void laplace_sample_lbfgs(const Model& model, const Eigen::VectorXd& theta_hat,
+                          const Eigen::MatrixXd& y_history,
+                          const Eigen::MatrixXd& s_history, int draws,
+                          bool calculate_lp, unsigned int random_seed,
+                          int refresh, callbacks::interrupt& interrupt,
+                          callbacks::logger& logger,
+                          callbacks::writer& sample_writer,
+                          callbacks::structured_writer& hessian_writer) {
+  start_laplace_sample(model, theta_hat, draws, sample_writer);
+  const Eigen::Index N = theta_hat.size();
+  const Eigen::Index history_size = y_history.cols();
+  if (y_history.rows() != N || s_history.rows() != N
+      || s_history.cols() != history_size || history_size == 0) {
+    throw std::domain_error(
+        "L-BFGS history must have one row per unconstrained parameter and "
+        "the same positive number of changes in the gradient and in the "
+        "parameters; found "
+        + std::to_string(y_history.rows()) + " x "
+        + std::to_string(history_size) + " and "
+        + std::to_string(s_history.rows()) + " x "
+        + std::to_string(s_history.cols()));
+  }
+
+  if (refresh > 0) {
+    logger.info("Approximating Hessian from the L-BFGS history");
+  }
+  interrupt();
+  Eigen::VectorXd alpha = Eigen::VectorXd::Ones(N);
+  for (Eigen::Index j = 0; j < history_size; ++j) {
+    auto Yk = y_history.col(j);
+    auto Sk = s_history.col(j);
+    stan::optimization::update_diagonal_inverse_hessian(alpha, Yk, Sk);
+  }
+  Eigen::MatrixXd Rk = Eigen::MatrixXd::Zero(history_size, history_size);
+  Rk.triangularView<Eigen::Upper>() = s_history.transpose() * y_history;
+  Eigen::VectorXd Dk = Rk.diagonal();
+  if (!(Dk.array() > 0).all()) {
+    throw std::domain_error(
+        "L-BFGS history has an update of nonpositive curvature");
+  }
+  Eigen::MatrixXd ninvRST = -s_history.transpose();
+  Rk.triangularView<Eigen::Upper>().solveInPlace(ninvRST);
+  // A zero gradient centers the approximation at the mode
+  Eigen::MatrixXd Wkbar;
+  pathfinder::internal::taylor_approx_t taylor_approx
+      = pathfinder::internal::taylor_approximation(
+          y_history, alpha, Dk, ninvRST, theta_hat,
+          Eigen::VectorXd::Zero(N).eval(), Wkbar);
+
+  // The draws are the mode plus a square root of the covariance times
+  // standard normal variates z, so log_q is -0.5 z^T z up to a constant
+  Eigen::MatrixXd batch_z;
+  std::vector<double> log_ratios;
+  stan::rng_t rng = util::create_rng(random_seed, 0);
+  write_laplace_draws<jacobian>(
+      model, theta_hat, draws, calculate_lp, random_seed, rng, refresh,
+      interrupt, logger, sample_writer,
+      [&](const Eigen::MatrixXd& z) -> Eigen::MatrixXd {
+        batch_z = z;
+        return pathfinder::internal::approximate_samples(Eigen::MatrixXd(z),
+                                                         taylor_approx)
+                   .colwise()
+               - theta_hat;
+      },
+      [&](const Eigen::MatrixXd& /* diff */) -> Eigen::VectorXd {
+        return -0.5 * batch_z.colwise().squaredNorm().transpose();
+      },
+      &log_ratios);
+
+  hessian_writer.begin_record();
+  hessian_writer.write("inv_hessian_initial_diagonal", alpha);
+  hessian_writer.write("log_det_cholesky_inv_hessian",
+                       taylor_approx.logdetcholHk);
+  if (calculate_lp) {
+    Eigen::Map<const Eigen::ArrayXd> ratios(log_ratios.data(),
+                                            log_ratios.size());
+    const double pareto_k = stan::analyze::psis_pareto_k(
+        ratios, stan::analyze::psis_tail_length(ratios.size()));
+    if (std::isfinite(pareto_k)) {
+      hessian_writer.write("pareto_k", pareto_k);
+      std::stringstream msg;
+      msg << "Pareto k of the importance ratios = " << std::setprecision(2)
+          << pareto_k;
+      if (pareto_k > 0.7) {
+        msg << ", greater than 0.7, which indicates that the L-BFGS "
+            << "approximation of the Hessian is poor.";
+        logger.warn(msg);
+      } else if (refresh > 0) {
+        logger.info(msg);
+      }
     }
-    draw.insert(draw.begin(), log_p);
-    Eigen::VectorXd diff = unc_draw - theta_hat;
-    double log_q = diff.transpose() * half_hessian * diff;
-    draw.insert(draw.begin() + 1, log_q);
-    sample_writer(draw);
   }
-}  // namespace internal
+  hessian_writer.end_record();
+}
+
+/**
+ * Compute the Hessian at the mode as a sparse matrix, from one
+ * Hessian-vector product per color of a coloring of its detected
+ * sparsity pattern, and take draws from the Laplace approximation with
+ * a sparse Cholesky factor of the negative Hessian.  With the fill
+ * reducing ordering of the factorization, -H = P^T L L^T P, a draw is
+ * the mode plus P^T L^-T z for standard normal z.
+ */
+template <bool jacobian, typename Model>
+void laplace_sample_sparse(const Model& model, const Eigen::VectorXd& theta_hat,
+                           int draws, bool calculate_lp,
+                           unsigned int random_seed, int refresh,
+                           callbacks::interrupt& interrupt,
+                           callbacks::logger& logger,
+                           callbacks::writer& sample_writer,
+                           callbacks::structured_writer& hessian_writer) {
+  start_laplace_sample(model, theta_hat, draws, sample_writer);
+
+  if (refresh > 0) {
+    logger.info("Detecting Hessian sparsity");
+  }
+  std::stringstream log_density_msgs;
+  interrupt();
+  const stan::model::hessian_coloring coloring
+      = stan::model::hessian_sparsity<jacobian>(model, theta_hat,
+                                                &log_density_msgs);
+  if (refresh > 0) {
+    std::stringstream msg;
+    msg << "Calculating sparse Hessian with " << coloring.num_nonzeros()
+        << " nonzeros from " << coloring.num_colors
+        << " Hessian-vector products";
+    logger.info(msg);
+  }
+  interrupt();
+  Eigen::VectorXd grad;
+  Eigen::SparseMatrix<double> hessian;
+  const double log_p = stan::model::sparse_hessian<jacobian>(
+      model, theta_hat, coloring, grad, hessian, &log_density_msgs);
+  if (refresh > 0 && log_density_msgs.peek() != std::char_traits<char>::eof())
+    logger.info(log_density_msgs);
+
+  interrupt();
+  std::vector<int> hessian_rows;
+  std::vector<int> hessian_cols;
+  std::vector<double> hessian_values;
+  hessian_rows.reserve(hessian.nonZeros());
+  hessian_cols.reserve(hessian.nonZeros());
+  hessian_values.reserve(hessian.nonZeros());
+  for (int j = 0; j < hessian.outerSize(); ++j) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(hessian, j); it;
+         ++it) {
+      hessian_rows.push_back(it.row() + 1);
+      hessian_cols.push_back(it.col() + 1);
+      hessian_values.push_back(it.value());
+    }
+  }
+  hessian_writer.begin_record();
+  hessian_writer.write("lp_mode", log_p);
+  hessian_writer.write("gradient", grad);
+  hessian_writer.write("hessian_rows", hessian_rows);
+  hessian_writer.write("hessian_cols", hessian_cols);
+  hessian_writer.write("hessian_values", hessian_values);
+  hessian_writer.end_record();
+
+  interrupt();
+  if (refresh > 0) {
+    logger.info("Calculating sparse Cholesky factor");
+  }
+  const Eigen::SparseMatrix<double> neg_hessian = -hessian;
+  Eigen::SimplicialLLT<Eigen::SparseMatrix<double>> llt(neg_hessian);
+  if (llt.info() != Eigen::Success) {
+    throw std::domain_error("Hessian at the mode is not negative definite");
+  }
+
+  stan::rng_t rng = util::create_rng(random_seed, 0);
+  write_laplace_draws<jacobian>(
+      model, theta_hat, draws, calculate_lp, random_seed, rng, refresh,
+      interrupt, logger, sample_writer,
+      [&](const Eigen::MatrixXd& z) -> Eigen::MatrixXd {
+        Eigen::MatrixXd u = llt.matrixU().solve(z);
+        return llt.permutationPinv() * u;
+      },
+      [&](const Eigen::MatrixXd& diff) -> Eigen::VectorXd {
+        return 0.5 * diff.cwiseProduct(hessian * diff).colwise().sum()
+                         .transpose();
+      });
+}
 }  // namespace internal
 
 /**
@@ -167,6 +772,9 @@ void laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
  * and then draws
  * @param[in,out] hessian_writer callback for writing the log probability,
  * gradient, and Hessian at the mode for diagnostic purposes
+ * @param[in] autodiff_hessian whether to calculate the Hessian with
+ * forward-over-reverse autodiff instead of finite differences of
+ * gradients, which requires the model to support `fvar<var>`
  * @return a return code, with 0 indicating success
  */
 template <bool jacobian, typename Model>
@@ -174,11 +782,221 @@ int laplace_sample(const Model& model, const Eigen::VectorXd& theta_hat,
                    int draws, bool calculate_lp, unsigned int random_seed,
                    int refresh, callbacks::interrupt& interrupt,
                    callbacks::logger& logger, callbacks::writer& sample_writer,
-                   callbacks::structured_writer& hessian_writer) {
+                   callbacks::structured_writer& hessian_writer,
+                   bool autodiff_hessian = false) {
   try {
     internal::laplace_sample<jacobian>(model, theta_hat, draws, calculate_lp,
                                        random_seed, refresh, interrupt, logger,
-                                       sample_writer, hessian_writer);
+                                       sample_writer, hessian_writer,
+                                       autodiff_hessian);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  return error_codes::OK;
+}
+
+/**
+ * Take the specified number of draws from a low-memory Laplace
+ * approximation for the model at the specified unconstrained mode,
+ * writing the draws, unnormalized log density, and unnormalized density
+ * of the approximation to the sample writer and writing messages to the
+ * logger, returning a return code of zero if successful.
+ *
+ * The negative Hessian at the mode is approximated by a diagonal plus
+ * rank `rank` matrix built from `2 * rank + num_probes` Hessian-vector
+ * products, so the memory used grows linearly with the number of
+ * parameters.  Instead of the Hessian, its diagonal, eigenvalues and
+ * eigenvectors are written to the Hessian writer.  The approximation
+ * is exact for a Hessian of rank at most `rank` plus a diagonal, up to
+ * the error of the diagonal estimate.
+ *
+ * Interrupts are called between compute-intensive operations.  To
+ * turn off all console messages sent to the logger, set refresh to 0.
+ * If an exception is thrown by the model, the return value is
+ * non-zero, and if refresh > 0, its message is given to the logger as
+ * an error.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @param[in] model model from which to sample
+ * @param[in] theta_hat unconstrained mode at which to center the
+ * Laplace approximation
+ * @param[in] draws number of draws to generate
+ * @param[in] calculate_lp whether to calculate the log probability of the
+ * approximate draws
+ * @param[in] rank rank of the low-rank part of the negative Hessian
+ * @param[in] num_probes number of random probes estimating the diagonal
+ * part of the negative Hessian
+ * @param[in] random_seed seed for generating random numbers in the
+ * Stan program, in the probes and in sampling
+ * @param[in] refresh period between iterations at which updates are
+ * given, with a value of 0 turning off all messages
+ * @param[in] interrupt callback for interrupting sampling
+ * @param[in,out] logger callback for writing console messages from
+ * sampler and from Stan programs
+ * @param[in,out] sample_writer callback for writing parameter names
+ * and then draws
+ * @param[in,out] hessian_writer callback for writing the log probability,
+ * gradient, and factors of the approximate negative Hessian at the mode
+ * @param[in] autodiff_hessian whether to calculate the Hessian-vector
+ * products with forward-over-reverse autodiff instead of finite
+ * differences of gradients, which requires the model to support
+ * `fvar<var>`
+ * @return a return code, with 0 indicating success
+ */
+template <bool jacobian, typename Model>
+int laplace_sample_low_rank(
+    const Model& model, const Eigen::VectorXd& theta_hat, int draws,
+    bool calculate_lp, int rank, int num_probes, unsigned int random_seed,
+    int refresh, callbacks::interrupt& interrupt, callbacks::logger& logger,
+    callbacks::writer& sample_writer,
+    callbacks::structured_writer& hessian_writer,
+    bool autodiff_hessian = false) {
+  try {
+    internal::laplace_sample_low_rank<jacobian>(
+        model, theta_hat, draws, calculate_lp, rank, num_probes, random_seed,
+        refresh, interrupt, logger, sample_writer, hessian_writer,
+        autodiff_hessian);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  return error_codes::OK;
+}
+
+/**
+ * Take the specified number of draws from the Laplace approximation
+ * for the model at the specified unconstrained mode with the inverse
+ * Hessian approximation of the L-BFGS run that found the mode, writing
+ * the draws, unnormalized log density, and unnormalized density of the
+ * approximation to the sample writer and writing messages to the
+ * logger, returning a return code of zero if successful.
+ *
+ * The covariance of the approximation is built from the history of
+ * L-BFGS updates as in Pathfinder, so no Hessian or gradient is
+ * evaluated and a draw costs O(N J) for N parameters and J updates when
+ * 2 J is less than N.  The approximation is only as good as the
+ * history, which spans the directions the optimizer explored last: the
+ * Pareto k of the importance ratios `log_p__ - log_q__`, written to the
+ * Hessian writer with the initial inverse Hessian diagonal and the log
+ * determinant of the Cholesky factor of the covariance, tells whether
+ * the draws can be trusted, and a value above 0.7 is logged as a
+ * warning.
+ *
+ * Interrupts are called between compute-intensive operations.  To
+ * turn off all console messages sent to the logger, set refresh to 0.
+ * If an exception is thrown by the model, the return value is
+ * non-zero, and if refresh > 0, its message is given to the logger as
+ * an error.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @param[in] model model from which to sample
+ * @param[in] theta_hat unconstrained mode at which to center the
+ * Laplace approximation
+ * @param[in] y_history changes in the gradient of the negative log
+ * density of the L-BFGS updates, one per column, oldest first, as
+ * returned by `LBFGSUpdate::y_history`
+ * @param[in] s_history changes in the unconstrained parameters of the
+ * L-BFGS updates, as returned by `LBFGSUpdate::s_history`
+ * @param[in] draws number of draws to generate
+ * @param[in] calculate_lp whether to calculate the log probability of the
+ * approximate draws, which the Pareto k diagnostic requires
+ * @param[in] random_seed seed for generating random numbers in the
+ * Stan program and in sampling
+ * @param[in] refresh period between iterations at which updates are
+ * given, with a value of 0 turning off all messages
+ * @param[in] interrupt callback for interrupting sampling
+ * @param[in,out] logger callback for writing console messages from
+ * sampler and from Stan programs
+ * @param[in,out] sample_writer callback for writing parameter names
+ * and then draws
+ * @param[in,out] hessian_writer callback for writing the factors of the
+ * approximation and the Pareto k diagnostic
+ * @return a return code, with 0 indicating success
+ */
+template <bool jacobian, typename Model>
+int laplace_sample_lbfgs(const Model& model, const Eigen::VectorXd& theta_hat,
+                         const Eigen::MatrixXd& y_history,
+                         const Eigen::MatrixXd& s_history, int draws,
+                         bool calculate_lp, unsigned int random_seed,
+                         int refresh, callbacks::interrupt& interrupt,
+                         callbacks::logger& logger,
+                         callbacks::writer& sample_writer,
+                         callbacks::structured_writer& hessian_writer) {
+  try {
+    internal::laplace_sample_lbfgs<jacobian>(
+        model, theta_hat, y_history, s_history, draws, calculate_lp,
+        random_seed, refresh, interrupt, logger, sample_writer,
+        hessian_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  return error_codes::OK;
+}
+
+/**
+ * Take the specified number of draws from the Laplace approximation
+ * for the model at the specified unconstrained mode with a sparse
+ * Hessian, writing the draws, unnormalized log density, and
+ * unnormalized density of the approximation to the sample writer and
+ * writing messages to the logger, returning a return code of zero if
+ * successful.
+ *
+ * The sparsity pattern of the Hessian is detected at the mode and its
+ * columns colored so that columns of the same color share no row, then
+ * the Hessian is computed by finite differences from one Hessian-vector
+ * product per color, so a banded or block diagonal Hessian costs a
+ * number of gradients independent of the number of parameters.  The
+ * draws use a sparse Cholesky factorization of the negative Hessian
+ * with a fill reducing ordering.  The Hessian writer gets the log
+ * density and gradient at the mode and the nonzeros of the Hessian as
+ * one-based `hessian_rows`, `hessian_cols` and `hessian_values`.
+ *
+ * Interrupts are called between compute-intensive operations.  To
+ * turn off all console messages sent to the logger, set refresh to 0.
+ * If an exception is thrown by the model, or the Hessian is not
+ * negative definite, the return value is non-zero, and its message is
+ * given to the logger as an error.
+ *
+ * @tparam jacobian `true` to include Jacobian adjustment for
+ * constrained parameters
+ * @tparam Model a Stan model
+ * @param[in] model model from which to sample
+ * @param[in] theta_hat unconstrained mode at which to center the
+ * Laplace approximation
+ * @param[in] draws number of draws to generate
+ * @param[in] calculate_lp whether to calculate the log probability of the
+ * approximate draws
+ * @param[in] random_seed seed for generating random numbers in the
+ * Stan program and in sampling
+ * @param[in] refresh period between iterations at which updates are
+ * given, with a value of 0 turning off all messages
+ * @param[in] interrupt callback for interrupting sampling
+ * @param[in,out] logger callback for writing console messages from
+ * sampler and from Stan programs
+ * @param[in,out] sample_writer callback for writing parameter names
+ * and then draws
+ * @param[in,out] hessian_writer callback for writing the log probability,
+ * gradient, and nonzeros of the Hessian at the mode
+ * @return a return code, with 0 indicating success
+ */
+template <bool jacobian, typename Model>
+int laplace_sample_sparse(const Model& model, const Eigen::VectorXd& theta_hat,
+                          int draws, bool calculate_lp,
+                          unsigned int random_seed, int refresh,
+                          callbacks::interrupt& interrupt,
+                          callbacks::logger& logger,
+                          callbacks::writer& sample_writer,
+                          callbacks::structured_writer& hessian_writer) {
+  try {
+    internal::laplace_sample_sparse<jacobian>(
+        model, theta_hat, draws, calculate_lp, random_seed, refresh,
+        interrupt, logger, sample_writer, hessian_writer);
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::CONFIG;
@@ -3,15 +3,24 @@
 
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/optimization/bfgs.hpp>
 #include <stan/services/error_codes.hpp>
+#include <stan/services/optimize/iteration_recorder.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/create_rng.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -19,15 +28,58 @@ namespace stan {
 namespace services {
 namespace optimize {
 
+namespace internal {
+
 /**
- * Runs the L-BFGS algorithm for a model.
+ * Outcome of one run of the L-BFGS algorithm
+ */
+struct lbfgs_result {
+  /**
+   * BFGS termination code of the run, see
+   * stan::optimization::BFGSMinimizer::get_code_string
+   */
+  int termination = 0;
+
+  /**
+   * Log density at the final iterate
+   */
+  double lp = -std::numeric_limits<double>::infinity();
+
+  /**
+   * Unconstrained parameters at the final iterate
+   */
+  std::vector<double> cont_vector;
+
+  /**
+   * Row written for the final iterate: lp__ followed by the constrained
+   * parameters
+   */
+  std::vector<double> values;
+
+  /**
+   * Changes in the gradient of the negative log density and in the
+   * unconstrained parameters of the updates in the L-BFGS history at the
+   * final iterate, one per column, oldest first, from which
+   * laplace_sample_lbfgs draws without evaluating the Hessian
+   */
+  Eigen::MatrixXd y_history;
+  Eigen::MatrixXd s_history;
+
+  /**
+   * True if the run was stopped through its cancellation flag
+   */
+  bool cancelled = false;
+};
+
+/**
+ * Runs the L-BFGS algorithm for a model with the given random number
+ * generator, as stan::services::optimize::lbfgs does.
  *
+ * @tparam jacobian `true` to include Jacobian adjustment
  * @tparam Model A model implementation
- * @tparam jacobian `true` to include Jacobian adjustment (default `false`)
  * @param[in] model Input model to test (with data already instantiated)
  * @param[in] init var context for initialization
- * @param[in] random_seed random seed for the random number generator
- * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in,out] rng random number generator
  * @param[in] init_radius radius to initialize
  * @param[in] history_size amount of history to keep for L-BFGS
  * @param[in] init_alpha line search step size for first iteration
@@ -48,19 +100,28 @@ namespace optimize {
  * @param[in,out] logger Logger for messages
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] parameter_writer output for parameter values
- * @return error_codes::OK if successful
+ * @param[in,out] iteration_writer output for the record of the
+ *   iterations, see iteration_recorder
+ * @param[in] prefix prepended to the progress messages
+ * @param[in] cancel if not null, the run stops at the next iteration
+ *   once it is set
+ * @param[out] result outcome of the run
+ * @param[in] diagonal_scaling true to scale the initial inverse Hessian
+ *   of L-BFGS per coordinate, see LBFGSUpdate::set_diagonal_scaling
+ * @return error_codes::OK if successful or cancelled
  */
-template <class Model, bool jacobian = false>
-int lbfgs(Model& model, const stan::io::var_context& init,
-          unsigned int random_seed, unsigned int chain, double init_radius,
-          int history_size, double init_alpha, double tol_obj,
-          double tol_rel_obj, double tol_grad, double tol_rel_grad,
-          double tol_param, int num_iterations, bool save_iterations,
-          int refresh, callbacks::interrupt& interrupt,
-          callbacks::logger& logger, callbacks::writer& init_writer,
-          callbacks::writer& parameter_writer) {
-  stan::rng_t rng = util::create_rng(random_seed, chain);
-
+template <bool jacobian, class Model>
+int run_lbfgs(Model& model, const stan::io::var_context& init,
+              stan::rng_t& rng, double init_radius, int history_size,
+              double init_alpha, double tol_obj, double tol_rel_obj,
+              double tol_grad, double tol_rel_grad, double tol_param,
+              int num_iterations, bool save_iterations, int refresh,
+              callbacks::interrupt& interrupt, callbacks::logger& logger,
+              callbacks::writer& init_writer,
+              callbacks::writer& parameter_writer,
+              callbacks::structured_writer& iteration_writer,
+              const std::string& prefix, const std::atomic<bool>* cancel,
+              lbfgs_result& result, bool diagonal_scaling = false) {
   std::vector<int> disc_vector;
   std::vector<double> cont_vector;
 
@@ -78,6 +139,7 @@ int lbfgs(Model& model, const stan::io::var_context& init,
       Optimizer;
   Optimizer lbfgs(model, cont_vector, disc_vector, &lbfgs_ss);
   lbfgs.get_qnupdate().set_history_size(history_size);
+  lbfgs.get_qnupdate().set_diagonal_scaling(diagonal_scaling);
   lbfgs._ls_opts.alpha0 = init_alpha;
   lbfgs._conv_opts.tolAbsF = tol_obj;
   lbfgs._conv_opts.tolRelF = tol_rel_obj;
@@ -89,7 +151,7 @@ int lbfgs(Model& model, const stan::io::var_context& init,
   double lp = lbfgs.logp();
 
   std::stringstream initial_msg;
-  initial_msg << "Initial log joint probability = " << lp;
+  initial_msg << prefix << "Initial log joint probability = " << lp;
   logger.info(initial_msg);
 
   std::vector<std::string> names;
@@ -108,14 +170,21 @@ int lbfgs(Model& model, const stan::io::var_context& init,
     parameter_writer(values);
   }
   int ret = 0;
+  iteration_recorder<Optimizer> recorder(iteration_writer, lbfgs, "lbfgs");
 
   try {
     while (ret == 0) {
       interrupt();
+      if (cancel != nullptr && *cancel) {
+        logger.info(prefix + "Optimization cancelled: enough starts agree");
+        result.cancelled = true;
+        return error_codes::OK;
+      }
       if (refresh > 0
           && (lbfgs.iter_num() == 0 || ((lbfgs.iter_num() + 1) % refresh == 0)))
         logger.info(
-            "    Iter"
+            prefix
+            + "    Iter"
             "      log prob"
             "        ||dx||"
             "      ||grad||"
@@ -124,7 +193,9 @@ int lbfgs(Model& model, const stan::io::var_context& init,
             "  # evals"
             "  Notes ");
 
+      recorder.begin_step();
       ret = lbfgs.step();
+      recorder.end_step(ret);
 
       lp = lbfgs.logp();
       lbfgs.params_r(cont_vector);
@@ -133,7 +204,7 @@ int lbfgs(Model& model, const stan::io::var_context& init,
           && (ret != 0 || !lbfgs.note().empty() || lbfgs.iter_num() == 0
               || ((lbfgs.iter_num() + 1) % refresh == 0))) {
         std::stringstream msg;
-        msg << " " << std::setw(7) << lbfgs.iter_num() << " ";
+        msg << prefix << " " << std::setw(7) << lbfgs.iter_num() << " ";
         msg << " " << std::setw(12) << std::setprecision(6) << lp << " ";
         msg << " " << std::setw(12) << std::setprecision(6)
             << lbfgs.prev_step_size() << " ";
@@ -163,6 +234,7 @@ int lbfgs(Model& model, const stan::io::var_context& init,
 
         values.insert(values.begin(), lp);
         parameter_writer(values);
+        result.values = std::move(values);
       }
     }
   } catch (const std::exception& e) {
@@ -188,24 +260,282 @@ int lbfgs(Model& model, const stan::io::var_context& init,
 
     values.insert(values.begin(), lp);
     parameter_writer(values);
+    result.values = std::move(values);
   }
+  result.lp = lp;
+  result.cont_vector = std::move(cont_vector);
+  result.y_history = lbfgs.get_qnupdate().y_history();
+  result.s_history = lbfgs.get_qnupdate().s_history();
+  result.termination = ret;
 
   int return_code;
   auto error_string = lbfgs.get_code_string(ret);
 
   if (ret >= 0) {
-    logger.info("Optimization terminated normally: ");
-    logger.info("  " + error_string);
+    logger.info(prefix + "Optimization terminated normally: ");
+    logger.info(prefix + "  " + error_string);
     return_code = error_codes::OK;
   } else {
-    logger.error("Optimization terminated with error: ");
-    logger.error("  " + error_string);
+    logger.error(prefix + "Optimization terminated with error: ");
+    logger.error(prefix + "  " + error_string);
     return_code = error_codes::SOFTWARE;
   }
 
   return return_code;
 }
 
+}  // namespace internal
+
+/**
+ * Runs the L-BFGS algorithm for a model.
+ *
+ * @tparam Model A model implementation
+ * @tparam jacobian `true` to include Jacobian adjustment (default `false`)
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] history_size amount of history to keep for L-BFGS
+ * @param[in] init_alpha line search step size for first iteration
+ * @param[in] tol_obj convergence tolerance on absolute changes in
+ *   objective function value
+ * @param[in] tol_rel_obj convergence tolerance on relative changes
+ *   in objective function value
+ * @param[in] tol_grad convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad convergence tolerance on the relative norm of
+ *   the gradient
+ * @param[in] tol_param convergence tolerance on changes in parameter
+ *   value
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved to the parameter_writer
+ * @param[in] refresh how often to write output to logger
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @param[in,out] iteration_writer output for the record of the
+ *   iterations: per iteration the log density, step and gradient norms,
+ *   line search step sizes and trials, evaluation counts and the wall
+ *   time, total and inside the model
+ * @param[in] diagonal_scaling true to scale the initial inverse Hessian
+ *   per coordinate, by a diagonal updated from every pair of updates,
+ *   rather than by a single scalar; this takes fewer iterations on
+ *   badly scaled posteriors
+ * @return error_codes::OK if successful
+ */
+template <class Model, bool jacobian = false>
+int lbfgs(Model& model, const stan::io::var_context& init,
+          unsigned int random_seed, unsigned int chain, double init_radius,
+          int history_size, double init_alpha, double tol_obj,
+          double tol_rel_obj, double tol_grad, double tol_rel_grad,
+          double tol_param, int num_iterations, bool save_iterations,
+          int refresh, callbacks::interrupt& interrupt,
+          callbacks::logger& logger, callbacks::writer& init_writer,
+          callbacks::writer& parameter_writer,
+          callbacks::structured_writer& iteration_writer,
+          bool diagonal_scaling = false) {
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+  internal::lbfgs_result result;
+  return internal::run_lbfgs<jacobian>(
+      model, init, rng, init_radius, history_size, init_alpha, tol_obj,
+      tol_rel_obj, tol_grad, tol_rel_grad, tol_param, num_iterations,
+      save_iterations, refresh, interrupt, logger, init_writer,
+      parameter_writer, iteration_writer, "", nullptr, result,
+      diagonal_scaling);
+}
+
+/**
+ * Runs the L-BFGS algorithm for a model, without a record of the
+ * iterations.
+ *
+ * @tparam Model A model implementation
+ * @tparam jacobian `true` to include Jacobian adjustment (default `false`)
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] history_size amount of history to keep for L-BFGS
+ * @param[in] init_alpha line search step size for first iteration
+ * @param[in] tol_obj convergence tolerance on absolute changes in
+ *   objective function value
+ * @param[in] tol_rel_obj convergence tolerance on relative changes
+ *   in objective function value
+ * @param[in] tol_grad convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad convergence tolerance on the relative norm of
+ *   the gradient
+ * @param[in] tol_param convergence tolerance on changes in parameter
+ *   value
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved to the parameter_writer
+ * @param[in] refresh how often to write output to logger
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] parameter_writer output for parameter values
+ * @return error_codes::OK if successful
+ */
+template <class Model, bool jacobian = false>
+int lbfgs(Model& model, const stan::io::var_context& init,
+          unsigned int random_seed, unsigned int chain, double init_radius,
+          int history_size, double init_alpha, double tol_obj,
+          double tol_rel_obj, double tol_grad, double tol_rel_grad,
+          double tol_param, int num_iterations, bool save_iterations,
+          int refresh, callbacks::interrupt& interrupt,
+          callbacks::logger& logger, callbacks::writer& init_writer,
+          callbacks::writer& parameter_writer) {
+  callbacks::structured_writer dummy_iteration_writer;
+  return lbfgs<Model, jacobian>(
+      model, init, random_seed, chain, init_radius, history_size, init_alpha,
+      tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param, num_iterations,
+      save_iterations, refresh, interrupt, logger, init_writer,
+      parameter_writer, dummy_iteration_writer);
+}
+
+/**
+ * Runs the L-BFGS algorithm for a model from several initial values in
+ * parallel, sharing the model.
+ *
+ * Every start writes its iterations and mode to its own parameter writer,
+ * and the mode with the highest log density among the starts that
+ * terminated normally is also written to `best_writer`.  If `num_agree` is
+ * positive, the remaining starts are cancelled as soon as that many starts
+ * have converged to the same mode, which is when their unconstrained
+ * parameters differ by at most `tol_agree` in every coordinate.  Starts
+ * that reach the iteration limit do not count as converged.
+ *
+ * @tparam Model A model implementation
+ * @tparam jacobian `true` to include Jacobian adjustment (default `false`)
+ * @tparam InitContextPtr A pointer like type to a var context
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam ParamWriter A type derived from `stan::callbacks::writer`
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] num_starts The number of optimizations to run in parallel.
+ * `init`, `init_writer`, and `parameter_writer` must be the same length as
+ * this value.
+ * @param[in] init An std vector of init var contexts for initialization of
+ * each start.
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id first chain id. The pseudo random number generator
+ * will advance for each start by an integer sequence from `init_chain_id` to
+ * `init_chain_id+num_starts-1`
+ * @param[in] init_radius radius to initialize
+ * @param[in] history_size amount of history to keep for L-BFGS
+ * @param[in] init_alpha line search step size for first iteration
+ * @param[in] tol_obj convergence tolerance on absolute changes in
+ *   objective function value
+ * @param[in] tol_rel_obj convergence tolerance on relative changes
+ *   in objective function value
+ * @param[in] tol_grad convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad convergence tolerance on the relative norm of
+ *   the gradient
+ * @param[in] tol_param convergence tolerance on changes in parameter
+ *   value
+ * @param[in] num_iterations maximum number of iterations
+ * @param[in] save_iterations indicates whether all the iterations should
+ *   be saved to the parameter writers
+ * @param[in] refresh how often to write output to logger
+ * @param[in] num_agree number of starts converged to the same mode after
+ *   which the other starts are cancelled, or 0 to run every start to the end
+ * @param[in] tol_agree largest difference of the unconstrained parameters of
+ *   two modes considered the same
+ * @param[in,out] interrupt callback to be called every iteration
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer std vector of Writer callbacks for unconstrained
+ * inits of each start.
+ * @param[in,out] parameter_writer std vector of Writers for the parameter
+ * values of each start.
+ * @param[in,out] best_writer output for the best mode
+ * @param[in] diagonal_scaling true to scale the initial inverse Hessian
+ *   of L-BFGS per coordinate, as in the single start
+ * @return error_codes::OK if at least one start terminated normally
+ */
+template <class Model, bool jacobian = false, typename InitContextPtr,
+          typename InitWriter, typename ParamWriter>
+int lbfgs(Model& model, size_t num_starts,
+          const std::vector<InitContextPtr>& init, unsigned int random_seed,
+          unsigned int init_chain_id, double init_radius, int history_size,
+          double init_alpha, double tol_obj, double tol_rel_obj,
+          double tol_grad, double tol_rel_grad, double tol_param,
+          int num_iterations, bool save_iterations, int refresh,
+          size_t num_agree, double tol_agree, callbacks::interrupt& interrupt,
+          callbacks::logger& logger, std::vector<InitWriter>& init_writer,
+          std::vector<ParamWriter>& parameter_writer,
+          callbacks::writer& best_writer, bool diagonal_scaling = false) {
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_starts);
+  for (size_t i = 0; i < num_starts; ++i) {
+    rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
+  }
+  std::vector<internal::lbfgs_result> results(num_starts);
+  std::vector<int> return_codes(num_starts, error_codes::SOFTWARE);
+  std::vector<size_t> converged;
+  std::mutex converged_mutex;
+  std::atomic<bool> cancel{false};
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_starts, 1),
+      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+          const std::string prefix
+              = "Start [" + std::to_string(init_chain_id + i) + "] ";
+          callbacks::structured_writer dummy_iteration_writer;
+          return_codes[i] = internal::run_lbfgs<jacobian>(
+              model, *init[i], rngs[i], init_radius, history_size, init_alpha,
+              tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+              num_iterations, save_iterations, refresh, interrupt, logger,
+              init_writer[i], parameter_writer[i], dummy_iteration_writer,
+              prefix, num_agree > 0 ? &cancel : nullptr, results[i],
+              diagonal_scaling);
+          const int termination = results[i].termination;
+          if (num_agree == 0 || return_codes[i] != error_codes::OK
+              || results[i].cancelled || termination <= 0
+              || termination == stan::optimization::TERM_MAXIT) {
+            continue;
+          }
+          std::lock_guard<std::mutex> lock(converged_mutex);
+          size_t num_same = 1;
+          for (size_t j : converged) {
+            double max_diff = 0;
+            for (size_t n = 0; n < results[i].cont_vector.size(); ++n) {
+              max_diff = std::max(max_diff,
+                                  std::fabs(results[i].cont_vector[n]
+                                            - results[j].cont_vector[n]));
+            }
+            if (max_diff <= tol_agree)
+              ++num_same;
+          }
+          converged.push_back(i);
+          if (num_same >= num_agree)
+            cancel = true;
+        }
+      },
+      tbb::simple_partitioner());
+
+  int best = -1;
+  for (size_t i = 0; i < num_starts; ++i) {
+    if (return_codes[i] == error_codes::OK && !results[i].cancelled
+        && (best == -1 || results[i].lp > results[best].lp))
+      best = i;
+  }
+  if (best == -1) {
+    logger.error("No optimization terminated normally");
+    return error_codes::SOFTWARE;
+  }
+  std::stringstream best_msg;
+  best_msg << "Best mode found by start [" << init_chain_id + best
+           << "] with log joint probability = " << results[best].lp;
+  logger.info(best_msg);
+  std::vector<std::string> names;
+  names.push_back("lp__");
+  model.constrained_param_names(names, true, true);
+  best_writer(names);
+  best_writer(results[best].values);
+  return error_codes::OK;
+}
+
 }  // namespace optimize
 }  // namespace services
 }  // namespace stan
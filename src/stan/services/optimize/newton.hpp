@@ -10,7 +10,9 @@
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <cmath>
+#include <iomanip>
 #include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -35,6 +37,14 @@ namespace optimize {
  * @param[in,out] logger Logger for messages
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] parameter_writer output for parameter values
+ * @param[in] max_hessian_reuse number of further iterations the Hessian of
+ *   an iteration may be reused for, 0 to recompute it every iteration
+ * @param[in] min_step_quality ratio of actual to predicted improvement of
+ *   the log density below which a reused Hessian is recomputed
+ * @param[in] sparse_hessian whether to detect the sparsity pattern of the
+ *   Hessian at the initial values and compute the Hessian from one
+ *   Hessian-vector product per color of a coloring of its columns, with
+ *   a sparse Cholesky factorization for the Newton direction
  * @return error_codes::OK if successful
  */
 template <class Model, bool jacobian = false>
@@ -42,8 +52,9 @@ int newton(Model& model, const stan::io::var_context& init,
            unsigned int random_seed, unsigned int chain, double init_radius,
            int num_iterations, bool save_iterations,
            callbacks::interrupt& interrupt, callbacks::logger& logger,
-           callbacks::writer& init_writer,
-           callbacks::writer& parameter_writer) {
+           callbacks::writer& init_writer, callbacks::writer& parameter_writer,
+           int max_hessian_reuse = 0, double min_step_quality = 0.25,
+           bool sparse_hessian = false) {
   stan::rng_t rng = util::create_rng(random_seed, chain);
 
   std::vector<int> disc_vector;
@@ -90,6 +101,23 @@ int newton(Model& model, const stan::io::var_context& init,
   parameter_writer(names);
 
   double lastlp = lp;
+  stan::optimization::newton_hessian hessian;
+  if (sparse_hessian) {
+    try {
+      Eigen::VectorXd params_r = Eigen::Map<const Eigen::VectorXd>(
+          cont_vector.data(), cont_vector.size());
+      hessian.coloring = std::make_shared<stan::model::hessian_coloring>(
+          stan::model::hessian_sparsity<jacobian>(model, params_r));
+      std::stringstream sparsity_msg;
+      sparsity_msg << "Sparse Hessian with " << hessian.coloring->num_nonzeros()
+                   << " nonzeros and " << hessian.coloring->num_colors
+                   << " colors";
+      logger.info(sparsity_msg);
+    } catch (const std::domain_error& e) {
+      logger.info("Hessian sparsity not detected, using a dense Hessian: "
+                  + std::string(e.what()));
+    }
+  }
   for (int m = 0; m < num_iterations; m++) {
     if (save_iterations) {
       std::vector<double> values;
@@ -102,8 +130,9 @@ int newton(Model& model, const stan::io::var_context& init,
     }
     interrupt();
     lastlp = lp;
-    lp = stan::optimization::newton_step<Model, jacobian>(model, cont_vector,
-                                                          disc_vector);
+    lp = stan::optimization::newton_step<Model, jacobian>(
+        model, cont_vector, disc_vector, hessian, max_hessian_reuse,
+        min_step_quality);
 
     std::stringstream msg2;
     msg2 << "Iteration " << std::setw(2) << (m + 1) << "."
@@ -111,8 +140,14 @@ int newton(Model& model, const stan::io::var_context& init,
          << ". Improved by " << (lp - lastlp) << ".";
     logger.info(msg2);
 
-    if (std::fabs(lp - lastlp) <= 1e-8)
+    if (std::fabs(lp - lastlp) <= 1e-8) {
+      // a reused Hessian may stall before the mode
+      if (hessian.age > 1) {
+        hessian.valid = false;
+        continue;
+      }
       break;
+    }
   }
 
   {
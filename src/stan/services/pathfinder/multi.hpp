@@ -1,6 +1,8 @@
 #ifndef STAN_SERVICES_PATHFINDER_MULTI_HPP
 #define STAN_SERVICES_PATHFINDER_MULTI_HPP
 
+#include <stan/analyze/psis.hpp>
+#include <stan/callbacks/cancellable_interrupt.hpp>
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
@@ -8,19 +10,85 @@
 #include <stan/optimization/bfgs.hpp>
 #include <stan/optimization/lbfgs_update.hpp>
 #include <stan/services/pathfinder/single.hpp>
-#include <stan/services/pathfinder/psis.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/duration_diff.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <tbb/parallel_for.h>
 #include <boost/random/discrete_distribution.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 namespace stan {
 namespace services {
 namespace pathfinder {
+namespace internal {
+
+/**
+ * Temporary file holding the draws of the finished paths of a multi-path
+ * pathfinder until the resampling selects the draws to write, so the
+ * draws of all the paths are not held in memory at once.
+ */
+class draws_spill {
+ public:
+  draws_spill() : file_(std::tmpfile()) {
+    if (file_ == nullptr) {
+      throw std::runtime_error(
+          "Cannot create a temporary file for the draws of the paths.");
+    }
+  }
+  ~draws_spill() { std::fclose(file_); }
+  draws_spill(const draws_spill&) = delete;
+  draws_spill& operator=(const draws_spill&) = delete;
+
+  /**
+   * Append the draws of a path, one per column, which must have the same
+   * number of rows as the draws appended before.
+   * @param draws Draws of a path
+   * @return Index of the first draw appended among all the draws
+   */
+  Eigen::Index append(const Eigen::MatrixXd& draws) {
+    rows_ = draws.rows();
+    std::fseek(file_, 0, SEEK_END);
+    if (std::fwrite(draws.data(), sizeof(double), draws.size(), file_)
+        != static_cast<std::size_t>(draws.size())) {
+      throw std::runtime_error(
+          "Cannot write the draws of a path to a temporary file.");
+    }
+    const Eigen::Index first = num_draws_;
+    num_draws_ += draws.cols();
+    return first;
+  }
+
+  /**
+   * Read a draw.
+   * @param i Index of the draw among all the draws
+   * @param[out] draw The draw
+   */
+  void read(Eigen::Index i, Eigen::VectorXd& draw) {
+    draw.resize(rows_);
+    std::fseek(file_, static_cast<long>(i * rows_ * sizeof(double)),  // NOLINT
+               SEEK_SET);
+    if (std::fread(draw.data(), sizeof(double), rows_, file_)
+        != static_cast<std::size_t>(rows_)) {
+      throw std::runtime_error(
+          "Cannot read the draws of a path from a temporary file.");
+    }
+  }
+
+ private:
+  std::FILE* file_;
+  Eigen::Index rows_{0};
+  Eigen::Index num_draws_{0};
+};
+
+}  // namespace internal
 
 /**
  * Runs multiple pathfinders with final approximate samples drawn using PSIS.
@@ -87,6 +155,30 @@ namespace pathfinder {
  *  samples are written to `parameter_writer`. If `false`, no psis resampling is
  * performed and (`num_paths` * `num_draws`) samples are written to
  * `parameter_writer`.
+ * @param[in] elbo_spacing Ratio between the L-BFGS iterations at which each
+ * single pathfinder estimates the ELBO, see `pathfinder_lbfgs_single`
+ * @param[in] constrain_selected_only If `true`, the single pathfinders keep
+ * their draws on the unconstrained scale and only the draws written to
+ * `parameter_writer` are constrained, one at a time, after the resampling.
+ * This avoids holding the constrained draws of every path in memory, but the
+ * generated quantities use a different random number stream than with
+ * `false`.
+ * @param[in] abandon_elbo_margin Non-negative difference of ELBO by which
+ * a path's best ELBO must trail the best ELBO of all paths for the path to
+ * be abandoned. An abandoned path stops its L-BFGS iterations, freeing its
+ * thread for the paths still running, and its draws are left out of the
+ * resampling. The default of infinity never abandons a path.
+ * @param[in] abandon_min_iterations Number of L-BFGS iterations a path runs
+ * before it can be abandoned.
+ * @param[in] stream_paths If `true`, the draws of each path are taken out of
+ * memory as soon as the path finishes. Without resampling they are written
+ * to `parameter_writer` right away, in the order the paths finish, and
+ * `constrain_selected_only` is ignored. With resampling they are appended
+ * to a temporary file, from which the resampled draws are read, so the
+ * memory held does not grow with `num_paths` beyond the log density ratios.
+ * @param[in] min_elbo_draws If positive, the number of draws at which each
+ * single pathfinder starts estimating the ELBO of an iteration, see
+ * `pathfinder_lbfgs_single`
  * @return error_codes::OK if successful
  */
 template <class Model, typename InitContext, typename InitWriter,
@@ -103,7 +195,11 @@ inline int pathfinder_lbfgs_multi(
     std::vector<SingleParamWriter>& single_path_parameter_writer,
     std::vector<SingleDiagnosticWriter>& single_path_diagnostic_writer,
     ParamWriter& parameter_writer, DiagnosticWriter& diagnostic_writer,
-    bool calculate_lp = true, bool psis_resample = true) {
+    bool calculate_lp = true, bool psis_resample = true,
+    double elbo_spacing = 1.0, bool constrain_selected_only = false,
+    double abandon_elbo_margin = std::numeric_limits<double>::infinity(),
+    int abandon_min_iterations = 0, bool stream_paths = false,
+    int min_elbo_draws = 0) {
   const auto start_pathfinders_time = std::chrono::steady_clock::now();
   std::vector<std::string> param_names;
   param_names.push_back("lp_approx__");
@@ -113,13 +209,30 @@ inline int pathfinder_lbfgs_multi(
   parameter_writer(param_names);
   std::vector<Eigen::Array<double, Eigen::Dynamic, 1>> individual_lp_ratios;
   individual_lp_ratios.resize(num_paths);
-  std::vector<Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>>
+  std::vector<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>>
       individual_samples;
   individual_samples.resize(num_paths);
   std::atomic<size_t> lp_calls{0};
+  internal::elbo_leader leader(abandon_min_iterations, abandon_elbo_margin);
+  const bool resample = psis_resample && calculate_lp;
+  // Without resampling, streamed draws are written as they are returned
+  const bool constrain_draws
+      = !constrain_selected_only || (stream_paths && !resample);
+  std::unique_ptr<internal::draws_spill> spill;
+  std::vector<Eigen::Index> spill_first(num_paths, 0);
+  std::mutex stream_mutex;
+  // An interrupt in one path stops the others at their next iteration
+  callbacks::cancellation_token cancel;
+  callbacks::cancellable_interrupt path_interrupt(interrupt, cancel);
   try {
+    if (stream_paths && resample) {
+      spill = std::make_unique<internal::draws_spill>();
+    }
+    // One path per task, so the threads of abandoned paths take up the
+    // paths not yet started
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, num_paths), [&](tbb::blocked_range<int> r) {
+        tbb::blocked_range<int>(0, num_paths, 1),
+        [&](tbb::blocked_range<int> r) {
           for (int iter = r.begin(); iter < r.end(); ++iter) {
             auto pathfinder_ret
                 = stan::services::pathfinder::pathfinder_lbfgs_single<true>(
@@ -127,25 +240,48 @@ inline int pathfinder_lbfgs_multi(
                     init_radius, history_size, init_alpha, tol_obj, tol_rel_obj,
                     tol_grad, tol_rel_grad, tol_param, num_iterations,
                     num_elbo_draws, num_draws, save_iterations, refresh,
-                    interrupt, logger, init_writers[iter],
+                    path_interrupt, logger, init_writers[iter],
                     single_path_parameter_writer[iter],
-                    single_path_diagnostic_writer[iter], calculate_lp);
+                    single_path_diagnostic_writer[iter], calculate_lp,
+                    elbo_spacing, constrain_draws, &leader,
+                    min_elbo_draws);
             if (unlikely(std::get<0>(pathfinder_ret) != error_codes::OK)) {
               logger.error(std::string("Pathfinder iteration: ")
                            + std::to_string(iter) + " failed.");
               return;
             }
             individual_lp_ratios[iter] = std::move(std::get<1>(pathfinder_ret));
-            individual_samples[iter] = std::move(std::get<2>(pathfinder_ret));
+            if (stream_paths) {
+              auto&& samples = std::get<2>(pathfinder_ret);
+              std::lock_guard<std::mutex> lock(stream_mutex);
+              // an abandoned path has no draws
+              if (samples.size() > 0 && spill) {
+                spill_first[iter] = spill->append(samples);
+              } else if (samples.size() > 0) {
+                parameter_writer(samples);
+              }
+            } else {
+              individual_samples[iter] = std::move(std::get<2>(pathfinder_ret));
+            }
             lp_calls += std::get<3>(pathfinder_ret);
           }
-        });
+        },
+        tbb::simple_partitioner());
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::SOFTWARE;
   }
 
-  // if any pathfinders failed, we want to remove their empty results
+  // if any pathfinders failed or were abandoned, remove their empty results
+  if (spill) {
+    std::size_t num_kept = 0;
+    for (int i = 0; i < num_paths; ++i) {
+      if (individual_lp_ratios[i].size() > 0) {
+        spill_first[num_kept++] = spill_first[i];
+      }
+    }
+    spill_first.resize(num_kept);
+  }
   individual_lp_ratios.erase(
       std::remove_if(individual_lp_ratios.begin(), individual_lp_ratios.end(),
                      [](const auto& v) { return v.size() == 0; }),
@@ -160,7 +296,7 @@ inline int pathfinder_lbfgs_multi(
   const double pathfinders_delta_time = stan::services::util::duration_diff(
       start_pathfinders_time, end_pathfinders_time);
   const auto start_psis_time = std::chrono::steady_clock::now();
-  const size_t successful_pathfinders = individual_samples.size();
+  const size_t successful_pathfinders = individual_lp_ratios.size();
   if (successful_pathfinders == 0) {
     logger.info("No pathfinders ran successfully");
     return error_codes::SOFTWARE;
@@ -168,38 +304,54 @@ inline int pathfinder_lbfgs_multi(
   if (refresh != 0) {
     logger.info("Total log probability function evaluations:"
                 + std::to_string(lp_calls));
+    if (leader.num_abandoned() > 0) {
+      logger.info("Abandoned pathfinders: "
+                  + std::to_string(leader.num_abandoned()));
+    }
   }
-  size_t num_returned_samples = 0;
-  // Because of failure in single pathfinder we can have multiple returned sizes
-  for (auto&& ilpr : individual_lp_ratios) {
-    num_returned_samples += ilpr.size();
-  }
-  // Rows are individual parameters and columns are samples per iteration
-  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> samples(
-      individual_samples[0].rows(), num_returned_samples);
-  Eigen::Index filling_start_row = 0;
+  // Offset of the draws of each path in the draws of all paths
+  std::vector<Eigen::Index> path_offsets(successful_pathfinders + 1, 0);
   for (size_t i = 0; i < successful_pathfinders; ++i) {
-    const Eigen::Index individ_num_samples = individual_samples[i].cols();
-    samples.middleCols(filling_start_row, individ_num_samples)
-        = individual_samples[i].matrix();
-    filling_start_row += individ_num_samples;
+    path_offsets[i + 1] = path_offsets[i] + individual_lp_ratios[i].size();
   }
+  const Eigen::Index num_returned_samples = path_offsets.back();
+  stan::rng_t rng = util::create_rng(random_seed, stride_id);
+  Eigen::VectorXd unconstrained_draw;
+  Eigen::VectorXd constrained_draw;
+  Eigen::VectorXd draw(param_names.size());
+  Eigen::VectorXd spilled_draw;
+  // Write a draw, constraining it if the path kept it unconstrained
+  auto write_sample = [&](const auto& sample) {
+    if (!constrain_selected_only) {
+      parameter_writer(sample);
+      return;
+    }
+    unconstrained_draw = sample.tail(sample.size() - 2);
+    model.write_array(rng, unconstrained_draw, constrained_draw);
+    draw.head(2) = sample.head(2);
+    draw.tail(param_names.size() - 2) = constrained_draw;
+    parameter_writer(draw);
+  };
+  // Write draw j of path i
+  auto write_draw = [&](size_t i, Eigen::Index j) {
+    if (spill) {
+      spill->read(spill_first[i] + j, spilled_draw);
+      write_sample(spilled_draw);
+    } else {
+      write_sample(individual_samples[i].col(j));
+    }
+  };
   double psis_delta_time = 0;
-  if (psis_resample && calculate_lp) {
+  if (resample) {
     Eigen::Array<double, Eigen::Dynamic, 1> lp_ratios(num_returned_samples);
-    filling_start_row = 0;
     for (size_t i = 0; i < successful_pathfinders; ++i) {
-      const Eigen::Index individ_num_samples = individual_lp_ratios[i].size();
-      lp_ratios.segment(filling_start_row, individ_num_samples)
+      lp_ratios.segment(path_offsets[i], individual_lp_ratios[i].size())
           = individual_lp_ratios[i];
-      filling_start_row += individ_num_samples;
     }
 
-    const auto tail_len = std::min(0.2 * num_returned_samples,
-                                   3 * std::sqrt(num_returned_samples));
+    const auto tail_len = stan::analyze::psis_tail_length(num_returned_samples);
     Eigen::Array<double, Eigen::Dynamic, 1> weight_vals
-        = stan::services::psis::psis_weights(lp_ratios, tail_len, logger);
-    stan::rng_t rng = util::create_rng(random_seed, stride_id);
+        = stan::analyze::psis_weights(lp_ratios, tail_len, logger);
     boost::variate_generator<stan::rng_t&, boost::random::discrete_distribution<
                                                Eigen::Index, double>>
         rand_psis_idx(
@@ -207,15 +359,31 @@ inline int pathfinder_lbfgs_multi(
                      boost::iterator_range<double*>(
                          weight_vals.data(),
                          weight_vals.data() + weight_vals.size())));
-    for (size_t i = 0; i <= num_multi_draws - 1; ++i) {
-      parameter_writer(samples.col(rand_psis_idx()));
+    // Resample all indices before any draw is constrained with rng
+    std::vector<Eigen::Index> psis_idx(num_multi_draws);
+    for (size_t i = 0; i < num_multi_draws; ++i) {
+      psis_idx[i] = rand_psis_idx();
+    }
+    for (Eigen::Index idx : psis_idx) {
+      const size_t path
+          = std::upper_bound(path_offsets.begin(), path_offsets.end(), idx)
+            - path_offsets.begin() - 1;
+      write_draw(path, idx - path_offsets[path]);
     }
     const auto end_psis_time = std::chrono::steady_clock::now();
     psis_delta_time
         = stan::services::util::duration_diff(start_psis_time, end_psis_time);
 
-  } else {
-    parameter_writer(samples);
+  } else if (!stream_paths) {
+    for (size_t i = 0; i < successful_pathfinders; ++i) {
+      if (constrain_selected_only) {
+        for (Eigen::Index j = 0; j < individual_samples[i].cols(); ++j) {
+          write_draw(i, j);
+        }
+      } else {
+        parameter_writer(individual_samples[i]);
+      }
+    }
   }
   parameter_writer();
   const auto time_header = std::string("Elapsed Time: ");
@@ -1,20 +1,28 @@
 #ifndef STAN_SERVICES_PATHFINDER_SINGLE_HPP
 #define STAN_SERVICES_PATHFINDER_SINGLE_HPP
 
+#include <stan/analyze/reproducible_sum.hpp>
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/optimization/bfgs.hpp>
+#include <stan/model/double_arena.hpp>
+#include <stan/model/profile_data.hpp>
 #include <stan/optimization/lbfgs_update.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/duration_diff.hpp>
-#include <boost/circular_buffer.hpp>
+#include <stan/services/util/resource_usage.hpp>
+#include <stan/variational/elbo_leader.hpp>
+#include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/concurrent_queue.h>
 #include <tbb/task_group.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <string>
 #include <vector>
 #include <atomic>
@@ -98,35 +106,42 @@ struct elbo_est_t {
 /**
  * Generate approximate draws using either the full or sparse taylor
  * approximation.
+ *
+ * All the draws are transformed at once, with matrix products over the
+ * whole block of standard normal draws.  The Cholesky factor is upper
+ * triangular, so only its triangle is multiplied.  For the sparse
+ * approximation, the draws are first projected on the columns of `Qk`,
+ * whose number is at most twice the history size, so the products
+ * involving the number of parameters are one by `Qk` each way and the
+ * diagonal scaling.
  * @tparam EigMat A type inheriting from `Eigen::DenseBase` with dynamic rows
  * and columns.
- * @tparam EigVec A type inheriting from `Eigen::DenseBase` with the compile
- * time number of columns equal to 1.
- * @param u A matrix of gaussian IID samples with rows equal to the size of the
- * number of samples to be made and columns equal to the number of parameters.
+ * @param u A matrix of gaussian IID samples with columns equal to the number
+ * of samples to be made and rows equal to the number of parameters. When
+ * passed as an rvalue `Eigen::MatrixXd`, its storage holds the result.
  * @param taylor_approx Approximation from `taylor_approximation`.
- * @return A matrix with rows equal to the number of samples and columns equal
+ * @return A matrix with columns equal to the number of samples and rows equal
  * to the number of parameters.
  */
 template <typename EigMat, require_eigen_matrix_dynamic_t<EigMat>* = nullptr>
 inline Eigen::MatrixXd approximate_samples(
     EigMat&& u, const taylor_approx_t& taylor_approx) {
+  Eigen::MatrixXd draws = std::forward<EigMat>(u);
   if (taylor_approx.use_full) {
-    return (taylor_approx.L_approx.transpose() * std::forward<EigMat>(u))
-               .colwise()
-           + taylor_approx.x_center;
+    draws = taylor_approx.L_approx.transpose().triangularView<Eigen::Lower>()
+            * draws;
   } else {
-    return (taylor_approx.alpha.array().sqrt().matrix().asDiagonal()
-            * (taylor_approx.Qk
-                   * (taylor_approx.L_approx
-                      - Eigen::MatrixXd::Identity(
-                          taylor_approx.L_approx.rows(),
-                          taylor_approx.L_approx.cols()))
-                   * (taylor_approx.Qk.transpose() * u)
-               + u))
-               .colwise()
-           + taylor_approx.x_center;
+    // Qk' u, then (L - I) Qk' u, are small: twice the history size by the
+    // number of draws
+    Eigen::MatrixXd proj = taylor_approx.Qk.transpose() * draws;
+    Eigen::MatrixXd update
+        = taylor_approx.L_approx.triangularView<Eigen::Upper>() * proj;
+    update -= proj;
+    draws.noalias() += taylor_approx.Qk * update;
+    draws.array().colwise() *= taylor_approx.alpha.array().sqrt();
   }
+  draws.colwise() += taylor_approx.x_center;
+  return draws;
 }
 
 /**
@@ -188,6 +203,12 @@ generate_matrix(Generator&& variate_generator, const Eigen::Index num_params,
                   [&variate_generator]() { return variate_generator(); });
 }
 
+/**
+ * Best ELBO reached so far by the paths of a multi-path pathfinder, see
+ * `stan::variational::elbo_leader`.
+ */
+using elbo_leader = stan::variational::elbo_leader;
+
 /**
  * Estimate the approximate draws given the taylor approximation.
  *
@@ -210,6 +231,14 @@ generate_matrix(Generator&& variate_generator, const Eigen::Index num_params,
  * @param logger A callback writer for messages
  * @param calculate_lp If true, calculate the log probability of the samples.
  * Else set to `NaN` for each sample.
+ * @param best_elbo The best ELBO of the previous iterations
+ * @param min_samples If positive and `best_elbo` is finite, the log density
+ * is first evaluated at this many of the samples, doubling the number until
+ * all the samples are evaluated or the upper end of a confidence interval of
+ * the ELBO falls below `best_elbo`. In that case the iteration cannot be the
+ * best, and the returned ELBO, samples and ratios are those of the samples
+ * evaluated. All the samples are drawn, so the random number generator
+ * advances as when every sample is evaluated.
  * @return A struct with the ELBO estimate along with the samples and log
  * probability ratios.
  */
@@ -220,7 +249,10 @@ inline elbo_est_t est_approx_draws(LPF&& lp_fun, ConstrainF&& constrain_fun,
                                    const taylor_approx_t& taylor_approx,
                                    size_t num_samples, const EigVec& alpha,
                                    const std::string& iter_msg, Logger&& logger,
-                                   bool calculate_lp = true) {
+                                   bool calculate_lp = true,
+                                   double best_elbo
+                                   = -std::numeric_limits<double>::infinity(),
+                                   size_t min_samples = 0) {
   boost::variate_generator<stan::rng_t&, boost::normal_distribution<>>
       rand_unit_gaus(rng, boost::normal_distribution<>());
   const auto num_params = taylor_approx.x_center.size();
@@ -234,26 +266,66 @@ inline elbo_est_t est_approx_draws(LPF&& lp_fun, ConstrainF&& constrain_fun,
                            + num_params * stan::math::LOG_TWO_PI);
   Eigen::MatrixXd approx_samples
       = approximate_samples(std::move(unit_samps), taylor_approx);
-  const auto log_stream
-      = [](auto& logger, auto& pathfinder_ss, const auto& iter_msg) {
-          if (pathfinder_ss.str().length() == 0)
-            return;
-          logger.info(iter_msg + pathfinder_ss.str());
-          pathfinder_ss.str(std::string());
-        };
-  Eigen::VectorXd approx_samples_col;
-  std::stringstream pathfinder_ss;
   Eigen::Array<double, Eigen::Dynamic, 1> lp_ratio;
   if (calculate_lp) {
-    for (Eigen::Index i = 0; i < num_samples; ++i) {
-      try {
-        approx_samples_col = approx_samples.col(i);
-        ++lp_fun_calls;
-        lp_mat.coeffRef(i, 1) = lp_fun(approx_samples_col, pathfinder_ss);
-      } catch (const std::domain_error& e) {
-        lp_mat.coeffRef(i, 1) = -std::numeric_limits<double>::infinity();
+    // The draws are already generated, so evaluating them in parallel
+    // gives the same results as the serial loop
+    std::vector<std::string> lp_msgs(num_samples);
+    auto evaluate = [&](Eigen::Index begin, Eigen::Index end) {
+      tbb::parallel_for(
+          tbb::blocked_range<Eigen::Index>(begin, end),
+          [&](const tbb::blocked_range<Eigen::Index>& r) {
+            Eigen::VectorXd approx_samples_col;
+            std::stringstream pathfinder_ss;
+            for (Eigen::Index i = r.begin(); i != r.end(); ++i) {
+              try {
+                approx_samples_col = approx_samples.col(i);
+                lp_mat.coeffRef(i, 1)
+                    = lp_fun(approx_samples_col, pathfinder_ss);
+              } catch (const std::domain_error& e) {
+                lp_mat.coeffRef(i, 1)
+                    = -std::numeric_limits<double>::infinity();
+              }
+              lp_msgs[i] = pathfinder_ss.str();
+              pathfinder_ss.str(std::string());
+            }
+          });
+    };
+    // True if the upper end of a one sided 99.9% interval of the ELBO of the
+    // first n samples is below the best ELBO
+    auto below_best = [&](Eigen::Index n) {
+      auto ratios = lp_mat.col(1).head(n) - lp_mat.col(0).head(n);
+      const double mean = ratios.mean();
+      if (mean == -std::numeric_limits<double>::infinity()) {
+        return true;
+      }
+      const double sd = std::sqrt((ratios - mean).square().sum() / (n - 1));
+      return mean + 3.1 * sd / std::sqrt(static_cast<double>(n)) < best_elbo;
+    };
+    Eigen::Index num_evaluated = num_samples;
+    if (ReturnElbo && min_samples > 0
+        && best_elbo > -std::numeric_limits<double>::infinity()) {
+      num_evaluated = std::min<Eigen::Index>(
+          std::max<Eigen::Index>(min_samples, 2), num_samples);
+      evaluate(0, num_evaluated);
+      while (num_evaluated < static_cast<Eigen::Index>(num_samples)
+             && !below_best(num_evaluated)) {
+        const Eigen::Index next
+            = std::min<Eigen::Index>(2 * num_evaluated, num_samples);
+        evaluate(num_evaluated, next);
+        num_evaluated = next;
       }
-      log_stream(logger, pathfinder_ss, iter_msg);
+      if (num_evaluated < static_cast<Eigen::Index>(num_samples)) {
+        approx_samples.conservativeResize(Eigen::NoChange, num_evaluated);
+        lp_mat.conservativeResize(num_evaluated, Eigen::NoChange);
+      }
+    } else {
+      evaluate(0, num_samples);
+    }
+    lp_fun_calls = num_evaluated;
+    for (Eigen::Index i = 0; i < num_evaluated; ++i) {
+      if (lp_msgs[i].length() > 0)
+        logger.info(iter_msg + lp_msgs[i]);
     }
     lp_ratio = lp_mat.col(1) - lp_mat.col(0);
   } else {
@@ -263,7 +335,8 @@ inline elbo_est_t est_approx_draws(LPF&& lp_fun, ConstrainF&& constrain_fun,
         lp_mat.rows(), std::numeric_limits<double>::quiet_NaN());
   }
   if (ReturnElbo) {
-    double elbo = lp_ratio.mean();
+    double elbo
+        = stan::analyze::reproducible_sum(lp_ratio) / lp_ratio.size();
     return elbo_est_t{elbo, lp_fun_calls, std::move(approx_samples),
                       std::move(lp_mat), std::move(lp_ratio)};
   } else {
@@ -346,22 +419,27 @@ inline taylor_approx_t taylor_approximation_dense(
  * @param ninvRST The solution of X = R^-1 * S
  * @param point_est The parameters for the given iteration of LBFGS
  * @param grad_est The gradients for the given iteration of LBFGS
+ * @param[in,out] Wkbar Working memory for the `num_params` by twice the
+ * history size factor that is decomposed in place. Passing the same matrix at
+ * every iteration avoids reallocating it.
  * @return The components of the sparse taylor approximation
  */
 template <typename GradMat, typename AlphaVec, typename DkVec, typename InvMat,
           typename EigVec>
 inline taylor_approx_t taylor_approximation_sparse(
     GradMat&& Ykt_mat, const AlphaVec& alpha, const DkVec& Dk,
-    const InvMat& ninvRST, const EigVec& point_est, const EigVec& grad_est) {
+    const InvMat& ninvRST, const EigVec& point_est, const EigVec& grad_est,
+    Eigen::MatrixXd& Wkbar) {
   const Eigen::Index history_size = Ykt_mat.cols();
   const Eigen::Index history_size_times_2 = history_size * 2;
   const Eigen::Index num_params = alpha.size();
-  Eigen::MatrixXd y_mul_sqrt_alpha
-      = Ykt_mat.transpose() * alpha.array().sqrt().matrix().asDiagonal();
-  Eigen::MatrixXd Wkbart(history_size_times_2, num_params);
-  Wkbart.topRows(history_size) = y_mul_sqrt_alpha;
-  Wkbart.bottomRows(history_size)
-      = ninvRST * alpha.array().inverse().sqrt().matrix().asDiagonal();
+  // Wkbar is formed directly in column major order, so it needs no transpose
+  Wkbar.resize(num_params, history_size_times_2);
+  Wkbar.leftCols(history_size)
+      = alpha.array().sqrt().matrix().asDiagonal() * Ykt_mat;
+  Wkbar.rightCols(history_size)
+      = alpha.array().inverse().sqrt().matrix().asDiagonal()
+        * ninvRST.transpose();
   Eigen::MatrixXd Mkbar(history_size_times_2, history_size_times_2);
   Mkbar.topLeftCorner(history_size, history_size).setZero();
   Mkbar.topRightCorner(history_size, history_size)
@@ -369,16 +447,15 @@ inline taylor_approx_t taylor_approximation_sparse(
   Mkbar.bottomLeftCorner(history_size, history_size)
       = Eigen::MatrixXd::Identity(history_size, history_size);
   Eigen::MatrixXd y_tcrossprod_alpha
-      = Eigen::MatrixXd(y_mul_sqrt_alpha.rows(), y_mul_sqrt_alpha.rows())
+      = Eigen::MatrixXd(history_size, history_size)
             .setZero()
             .selfadjointView<Eigen::Lower>()
-            .rankUpdate(std::move(y_mul_sqrt_alpha));
+            .rankUpdate(Wkbar.leftCols(history_size).transpose());
   y_tcrossprod_alpha += Dk.asDiagonal();
   Mkbar.bottomRightCorner(history_size, history_size) = y_tcrossprod_alpha;
-  Wkbart.transposeInPlace();
   const auto min_size = std::min(num_params, history_size_times_2);
-  // Note: This is doing the QR decomp inplace using Wkbart's memory
-  Eigen::HouseholderQR<Eigen::Ref<decltype(Wkbart)>> qr(Wkbart);
+  // Note: This is doing the QR decomp inplace using Wkbar's memory
+  Eigen::HouseholderQR<Eigen::Ref<Eigen::MatrixXd>> qr(Wkbar);
   Eigen::MatrixXd Rkbar
       = qr.matrixQR().topLeftCorner(min_size, history_size_times_2);
   Rkbar.triangularView<Eigen::StrictlyLower>().setZero();
@@ -427,13 +504,16 @@ inline taylor_approx_t taylor_approximation_sparse(
  * @param ninvRST
  * @param point_est The parameters for the given iteration of LBFGS
  * @param grad_est The gradients for the given iteration of LBFGS
+ * @param[in,out] Wkbar Working memory of the sparse approximation, see
+ * `taylor_approximation_sparse`
  * @return The components of either the sparse or dense taylor approximation
  */
 template <typename GradMat, typename AlphaVec, typename DkVec, typename InvMat,
           typename EigVec>
 inline taylor_approx_t taylor_approximation(
     GradMat&& Ykt_mat, const AlphaVec& alpha, const DkVec& Dk,
-    const InvMat& ninvRST, const EigVec& point_est, const EigVec& grad_est) {
+    const InvMat& ninvRST, const EigVec& point_est, const EigVec& grad_est,
+    Eigen::MatrixXd& Wkbar) {
   // If twice the current history size is larger than the number of params
   // use a sparse approximation
   const auto history_size = Ykt_mat.cols();
@@ -443,7 +523,7 @@ inline taylor_approx_t taylor_approximation(
                                       grad_est);
   } else {
     return taylor_approximation_sparse(Ykt_mat, alpha, Dk, ninvRST, point_est,
-                                       grad_est);
+                                       grad_est, Wkbar);
   }
 }
 
@@ -474,6 +554,20 @@ inline auto ret_pathfinder(int return_code, EigVec&& lp_ratio, EigMat&& samples,
   return return_code;
 }
 
+/**
+ * Return the first iteration after `iter` at which the ELBO is estimated,
+ * spacing the estimates geometrically by a factor of `elbo_spacing`.
+ *
+ * @param iter Iteration at which the ELBO was last estimated
+ * @param elbo_spacing Ratio between the iterations of successive
+ * estimates. Values of at most 1 estimate the ELBO at every iteration.
+ * @return The next iteration at which the ELBO is estimated
+ */
+inline int next_elbo_iteration(int iter, double elbo_spacing) {
+  return std::max(iter + 1,
+                  static_cast<int>(std::ceil(iter * elbo_spacing)));
+}
+
 /**
  * Estimate the approximate draws given the taylor approximation.
  * @tparam RNG Type of random number generator
@@ -498,12 +592,15 @@ inline auto ret_pathfinder(int return_code, EigVec&& lp_ratio, EigMat&& samples,
  * @param current_params Parameters from iteration of LBFGS
  * @param current_grads Gradients from iteration of LBFGS
  * @param Ykt_mat Matrix of the last `history_size` changes in the gradient.
- * @param[in,out] Skt_mat Matrix of the last `history_size` changes in the
- * parameters. `Skt_mat` is transformed in this function and will hold inverse
- * solution of RS^T
+ * @param Skt_mat Matrix of the last `history_size` changes in the
+ * parameters.
+ * @param[in,out] Wkbar Working memory of the sparse taylor approximation
  * @param num_elbo_draws Number of draws for the ELBO estimation
  * @param iter_msg The beginning of messages that includes the iteration number
  * @param logger A callback writer for messages
+ * @param best_elbo The best ELBO of the previous iterations
+ * @param min_elbo_draws If positive, the number of draws at which the ELBO
+ * estimation starts, see `est_approx_draws`
  * @return A pair holding the elbo estimate information and the taylor
  * approximation information.
  */
@@ -513,22 +610,26 @@ template <typename RNG, typename LPFun, typename ConstrainFun,
 auto pathfinder_impl(RNG&& rng, LPFun&& lp_fun, ConstrainFun&& constrain_fun,
                      AlphaVec&& alpha, CurrentParams&& current_params,
                      CurrentGrads&& current_grads, GradMat&& Ykt_mat,
-                     ParamMat&& Skt_mat, std::size_t num_elbo_draws,
-                     const std::string& iter_msg, Logger&& logger) {
+                     ParamMat&& Skt_mat, Eigen::MatrixXd& Wkbar,
+                     std::size_t num_elbo_draws, const std::string& iter_msg,
+                     Logger&& logger,
+                     double best_elbo
+                     = -std::numeric_limits<double>::infinity(),
+                     std::size_t min_elbo_draws = 0) {
   const auto history_size = Ykt_mat.cols();
   Eigen::MatrixXd Rk = Eigen::MatrixXd::Zero(history_size, history_size);
   Rk.template triangularView<Eigen::Upper>() = Skt_mat.transpose() * Ykt_mat;
   Eigen::VectorXd Dk = Rk.diagonal();
   // Unfolded algorithm in paper for inverse RST
-  Rk.triangularView<Eigen::Upper>().solveInPlace(Skt_mat.transpose());
-  // Skt_mat is now ninvRST
-  Skt_mat = -Skt_mat;
+  Eigen::MatrixXd ninvRST = -Skt_mat.transpose();
+  Rk.triangularView<Eigen::Upper>().solveInPlace(ninvRST);
   internal::taylor_approx_t taylor_appx = internal::taylor_approximation(
-      Ykt_mat, alpha, Dk, Skt_mat.transpose(), current_params, current_grads);
+      Ykt_mat, alpha, Dk, ninvRST, current_params, current_grads, Wkbar);
   try {
     return std::make_pair(internal::est_approx_draws<true>(
                               lp_fun, constrain_fun, rng, taylor_appx,
-                              num_elbo_draws, alpha, iter_msg, logger),
+                              num_elbo_draws, alpha, iter_msg, logger, true,
+                              best_elbo, min_elbo_draws),
                           taylor_appx);
   } catch (const std::domain_error& e) {
     logger.warn(iter_msg + "ELBO estimation failed "
@@ -583,13 +684,39 @@ auto pathfinder_impl(RNG&& rng, LPFun&& lp_fun, ConstrainFun&& constrain_fun,
  * @param[in,out] logger Logger for messages
  * @param[in,out] init_writer Writer callback for unconstrained inits
  * @param[in,out] parameter_writer Writer callback for parameter values
- * @param[in,out] diagnostic_writer output for diagnostics values
+ * @param[in,out] diagnostic_writer output for diagnostics values. When
+ * the profile map of the model is registered with
+ * `stan::model::set_profile_data`, the record of the path ends with the
+ * totals of its `profile` blocks on the thread of the path. The record
+ * also ends with the resource usage of the thread of the path, see
+ * `stan::services::util::resource_snapshot`.
  * @param[in] calculate_lp Whether single pathfinder should return lp
  * calculations. If `true`, calculates the joint log probability for each
  * sample. If `false`, (`num_draws` - `num_elbo_draws`) of the joint log
  * probability calculations will be `NA` and psis resampling will not be
  * performed. Setting this parameter to `false` will also set all of the lp
  * ratios to `NaN`.
+ * @param[in] elbo_spacing Ratio between the L-BFGS iterations at which the
+ * ELBO is estimated. If larger than 1, the ELBO is estimated only at
+ * iterations 1, 2, 3, 5, 8, ... (for a ratio of 1.5) and at the final
+ * iteration, and the best approximation is chosen among those. The default
+ * of 1 estimates the ELBO at every iteration.
+ * @param[in] constrain_draws If `false`, the returned draws hold the
+ * unconstrained parameters after `lp_approx__` and `lp__` instead of the
+ * constrained ones, and are not written to `parameter_writer`.
+ * @param[in,out] leader If not null, the best ELBO shared with the other
+ * paths of a multi-path pathfinder. The path reports its best ELBO after
+ * each estimate and stops once it trails the leader, returning
+ * `error_codes::OK` with no draws.
+ * @param[in] min_elbo_draws If positive, the ELBO of an iteration is first
+ * estimated with this many draws, doubled until `num_elbo_draws` only while
+ * a confidence interval of the ELBO overlaps the best ELBO so far. This saves
+ * log density evaluations at iterations that are clearly worse than the best,
+ * which is then the same with high probability. The default of 0 always
+ * uses `num_elbo_draws` draws.
+ * @param[in] diagonal_scaling If `true`, L-BFGS scales its initial inverse
+ * Hessian per coordinate, by a diagonal updated from every pair of updates as
+ * the diagonal of the approximation, rather than by a single scalar.
  * @return If `ReturnLpSamples` is `true`, returns a tuple of the error code,
  * approximate draws, and a vector of the lp ratio. If `false`, only returns an
  * error code `error_codes::OK` if successful, `error_codes::SOFTWARE`
@@ -605,7 +732,10 @@ inline auto pathfinder_lbfgs_single(
     int num_elbo_draws, int num_draws, bool save_iterations, int refresh,
     callbacks::interrupt& interrupt, callbacks::logger& logger,
     callbacks::writer& init_writer, ParamWriter& parameter_writer,
-    DiagnosticWriter& diagnostic_writer, bool calculate_lp = true) {
+    DiagnosticWriter& diagnostic_writer, bool calculate_lp = true,
+    double elbo_spacing = 1.0, bool constrain_draws = true,
+    internal::elbo_leader* leader = nullptr, int min_elbo_draws = 0,
+    bool diagonal_scaling = false) {
   const auto start_pathfinder_time = std::chrono::steady_clock::now();
   stan::rng_t rng = util::create_rng(random_seed, stride_id);
   std::vector<int> disc_vector;
@@ -636,6 +766,7 @@ inline auto pathfinder_lbfgs_single(
   using lbfgs_update_t
       = stan::optimization::LBFGSUpdate<double, Eigen::Dynamic>;
   lbfgs_update_t lbfgs_update(max_history_size);
+  lbfgs_update.set_diagonal_scaling(diagonal_scaling);
   using Optimizer
       = stan::optimization::BFGSLineSearch<Model, lbfgs_update_t, double,
                                            Eigen::Dynamic, true>;
@@ -652,14 +783,19 @@ inline auto pathfinder_lbfgs_single(
   model.constrained_param_names(names, true, true);
   parameter_writer(names);
   int ret = 0;
-  boost::circular_buffer<Eigen::VectorXd> param_buff(max_history_size);
-  boost::circular_buffer<Eigen::VectorXd> grad_buff(max_history_size);
-  Eigen::VectorXd prev_params
-      = Eigen::Map<Eigen::VectorXd>(cont_vector.data(), cont_vector.size());
+  // The history of the updates is read from the optimizer
+  const lbfgs_update_t& lbfgs_history = lbfgs.get_qnupdate();
   std::size_t history_size = 0;
-  Eigen::VectorXd prev_grads(num_parameters);
-  stan::model::log_prob_grad<true, true>(model, prev_params, prev_grads);
+  Eigen::VectorXd prev_params;
+  Eigen::VectorXd prev_grads;
+  auto start_profile = stan::model::profile_snapshot::current_thread();
+  auto start_resources
+      = stan::services::util::resource_snapshot::current_thread();
   if (unlikely(save_iterations)) {
+    prev_params
+        = Eigen::Map<Eigen::VectorXd>(cont_vector.data(), cont_vector.size());
+    prev_grads.resize(num_parameters);
+    stan::model::log_prob_grad<true, true>(model, prev_params, prev_grads);
     diagnostic_writer.begin_record();
     diagnostic_writer.begin_record("0");
     diagnostic_writer.write("iter", static_cast<int>(0));
@@ -669,19 +805,23 @@ inline auto pathfinder_lbfgs_single(
   }
   auto constrain_fun = [&model](auto&& rng, auto&& unconstrained_draws,
                                 auto&& constrained_draws) {
+    stan::model::double_arena_scope scope;
     model.write_array(rng, unconstrained_draws, constrained_draws);
     return constrained_draws;
   };
   auto lp_fun = [&model](auto&& u, auto&& streamer) {
+    stan::model::double_arena_scope scope;
     return model.template log_prob<false, true>(u, &streamer);
   };
   Eigen::VectorXd alpha = Eigen::VectorXd::Ones(num_parameters);
   Eigen::Index best_iteration = -1;
+  int next_elbo_iter = 0;
+  bool abandoned = false;
   internal::elbo_est_t elbo_best;
   internal::taylor_approx_t taylor_approx_best;
   std::size_t num_evals{lbfgs.grad_evals()};
-  Eigen::MatrixXd Ykt_mat(num_parameters, max_history_size);
-  Eigen::MatrixXd Skt_mat(num_parameters, max_history_size);
+  // Reused by the sparse taylor approximation of every iteration
+  Eigen::MatrixXd Wkbar;
   std::string log_header = path_num + " Iter      log prob        ||dx||      "
   "||grad||     alpha      alpha0      # evals       ELBO    Best ELBO        "
   "Notes \n";
@@ -718,8 +858,7 @@ inline auto pathfinder_lbfgs_single(
           << std::setw(11) << std::scientific << std::setprecision(3)
           << lbfgs.alpha0();
     }
-    history_size = std::min(history_size + 1,
-                            static_cast<std::size_t>(max_history_size));
+    history_size = lbfgs_history.history_size();
 
     if (unlikely(save_iterations)) {
       diagnostic_writer.begin_record(std::to_string(lbfgs.iter_num()));
@@ -747,38 +886,40 @@ inline auto pathfinder_lbfgs_single(
       break;
     }
     try {
-      param_buff.push_back(lbfgs.curr_x() - prev_params);
-      grad_buff.push_back(lbfgs.curr_g() - prev_grads);
-      prev_params = lbfgs.curr_x();
-      prev_grads = lbfgs.curr_g();
-      auto&& Yk = grad_buff.back();
-      auto&& Sk = param_buff.back();
-      if (internal::check_curve(Yk, Sk)) {
-        double y_alpha_y = Yk.dot(alpha.asDiagonal() * Yk);
-        double y_s = Yk.dot(Sk);
-        alpha = y_s
-                / (y_alpha_y / alpha.array() + Yk.array().square()
-                   - (y_alpha_y
-                      / Sk.dot(alpha.array().inverse().matrix().asDiagonal()
-                               * Sk))
-                         * (Sk.array() / alpha.array()).square());
-      }
-      Eigen::Map<Eigen::MatrixXd> Ykt_map(Ykt_mat.data(), num_parameters,
-                                          history_size);
-      for (Eigen::Index i = 0; i < history_size; ++i) {
-        Ykt_map.col(i) = grad_buff[i];
+      if (unlikely(save_iterations)) {
+        prev_params = lbfgs.curr_x();
+        prev_grads = lbfgs.curr_g();
       }
-      Eigen::Map<Eigen::MatrixXd> Skt_map(Skt_mat.data(), num_parameters,
-                                          history_size);
-      for (Eigen::Index i = 0; i < history_size; ++i) {
-        Skt_map.col(i) = param_buff[i];
+      auto Ykt_mat = lbfgs_history.y_history();
+      auto Skt_mat = lbfgs_history.s_history();
+      auto Yk = Ykt_mat.col(history_size - 1);
+      auto Sk = Skt_mat.col(history_size - 1);
+      stan::optimization::update_diagonal_inverse_hessian(alpha, Yk, Sk);
+      if (ret == 0 && lbfgs.iter_num() < next_elbo_iter) {
+        print_log_remainder(write_log_cond, msg, ret, num_evals, lbfgs,
+                            elbo_best.elbo,
+                            std::numeric_limits<double>::quiet_NaN(),
+                            lbfgs_ss, logger);
+        if (unlikely(save_iterations)) {
+          diagnostic_writer.write("lbfgs_success", true);
+          diagnostic_writer.write("lbfgs_note", lbfgs_ss.str());
+          diagnostic_writer.end_record();
+        }
+        if (lbfgs_ss.str().length() > 0) {
+          logger.info(lbfgs_ss);
+          lbfgs_ss.str("");
+        }
+        continue;
       }
+      next_elbo_iter
+          = internal::next_elbo_iteration(lbfgs.iter_num(), elbo_spacing);
       std::string iter_msg(path_num + "Iter: ["
                            + std::to_string(lbfgs.iter_num()) + "] ");
 
       auto pathfinder_res = internal::pathfinder_impl(
           rng, lp_fun, constrain_fun, alpha, lbfgs.curr_x(), lbfgs.curr_g(),
-          Ykt_map, Skt_map, num_elbo_draws, iter_msg, logger);
+          Ykt_mat, Skt_mat, Wkbar, num_elbo_draws, iter_msg, logger,
+          elbo_best.elbo, std::max(min_elbo_draws, 0));
       num_evals += pathfinder_res.first.fn_calls;
       print_log_remainder(write_log_cond, msg, ret, num_evals, lbfgs,
                           pathfinder_res.first.elbo, pathfinder_res.first.elbo,
@@ -806,6 +947,13 @@ inline auto pathfinder_lbfgs_single(
         taylor_approx_best = std::move(pathfinder_res.second);
         best_iteration = lbfgs.iter_num();
       }
+      if (leader != nullptr) {
+        leader->update(elbo_best.elbo);
+        if (leader->trails(lbfgs.iter_num(), elbo_best.elbo)) {
+          abandoned = true;
+          break;
+        }
+      }
     } catch (const std::exception& e) {
       if (unlikely(save_iterations)) {
         diagnostic_writer.write("lbfgs_success", true);
@@ -833,8 +981,27 @@ inline auto pathfinder_lbfgs_single(
     }
   }
   if (unlikely(save_iterations)) {
+    stan::model::profile_snapshot::current_thread()
+        .since(start_profile)
+        .write(diagnostic_writer, "profile");
+    stan::services::util::resource_snapshot::current_thread()
+        .since(start_resources)
+        .write(diagnostic_writer, "resources");
     diagnostic_writer.end_record();
   }
+  if (abandoned) {
+    leader->abandon();
+    if (refresh > 0) {
+      logger.info(path_num + "Abandoned at iteration "
+                  + std::to_string(lbfgs.iter_num()) + ", best ELBO ("
+                  + std::to_string(elbo_best.elbo)
+                  + ") trails the best ELBO of the other paths");
+    }
+    return internal::ret_pathfinder<ReturnLpSamples>(
+        error_codes::OK, Eigen::Array<double, Eigen::Dynamic, 1>(0),
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(0, 0),
+        std::atomic<size_t>{num_evals + lbfgs.grad_evals()});
+  }
   if (unlikely(ret <= 0)) {
     std::string prefix_err_msg
         = "Optimization terminated with error: " + lbfgs.get_code_string(ret);
@@ -873,6 +1040,24 @@ inline auto pathfinder_lbfgs_single(
   auto&& elbo_lp_mat = elbo_best.lp_mat;
   const int remaining_draws = num_draws - elbo_lp_ratio.rows();
   const Eigen::Index num_unconstrained_params = names.size() - 2;
+  const Eigen::Index num_draw_rows
+      = constrain_draws ? names.size() : 2 + num_parameters;
+  Eigen::VectorXd unconstrained_col;
+  Eigen::VectorXd approx_samples_constrained_col;
+  // Fill column i of draws_mat with the log densities and the draw
+  auto fill_draw = [&](auto& draws_mat, Eigen::Index i, const auto& lp_row,
+                       const auto& unconstrained_draw) {
+    draws_mat.col(i).head(2) = lp_row.matrix();
+    if (constrain_draws) {
+      unconstrained_col = unconstrained_draw;
+      draws_mat.col(i).tail(num_unconstrained_params)
+          = constrain_fun(rng, unconstrained_col,
+                          approx_samples_constrained_col)
+                .matrix();
+    } else {
+      draws_mat.col(i).tail(num_parameters) = unconstrained_draw;
+    }
+  };
   if (likely(remaining_draws > 0)) {
     try {
       internal::elbo_est_t est_draws = internal::est_approx_draws<false>(
@@ -888,26 +1073,15 @@ inline auto pathfinder_lbfgs_single(
       lp_ratio.tail(new_lp_ratio.size()) = new_lp_ratio.array();
       const auto total_size = elbo_draws.cols() + new_draws.cols();
       constrained_draws_mat
-          = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(names.size(),
+          = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(num_draw_rows,
                                                                   total_size);
-      Eigen::VectorXd unconstrained_col;
-      Eigen::VectorXd approx_samples_constrained_col;
       for (Eigen::Index i = 0; i < elbo_draws.cols(); ++i) {
-        constrained_draws_mat.col(i).head(2) = elbo_lp_mat.row(i).matrix();
-        unconstrained_col = elbo_draws.col(i);
-        constrained_draws_mat.col(i).tail(num_unconstrained_params)
-            = constrain_fun(rng, unconstrained_col,
-                            approx_samples_constrained_col)
-                  .matrix();
+        fill_draw(constrained_draws_mat, i, elbo_lp_mat.row(i),
+                  elbo_draws.col(i));
       }
       for (Eigen::Index i = elbo_draws.cols(), j = 0; i < total_size;
            ++i, ++j) {
-        constrained_draws_mat.col(i).head(2) = lp_draws.row(j).matrix();
-        unconstrained_col = new_draws.col(j);
-        constrained_draws_mat.col(i).tail(num_unconstrained_params)
-            = constrain_fun(rng, unconstrained_col,
-                            approx_samples_constrained_col)
-                  .matrix();
+        fill_draw(constrained_draws_mat, i, lp_draws.row(j), new_draws.col(j));
       }
     } catch (const std::domain_error& e) {
       std::string err_msg = e.what();
@@ -919,37 +1093,27 @@ inline auto pathfinder_lbfgs_single(
           + err_msg);
       constrained_draws_mat
           = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(
-              names.size(), elbo_draws.cols());
-      Eigen::VectorXd approx_samples_constrained_col;
-      Eigen::VectorXd unconstrained_col;
+              num_draw_rows, elbo_draws.cols());
       for (Eigen::Index i = 0; i < elbo_draws.cols(); ++i) {
-        constrained_draws_mat.col(i).head(2) = elbo_lp_mat.row(i).matrix();
-        unconstrained_col = elbo_draws.col(i);
-        constrained_draws_mat.col(i).tail(num_unconstrained_params)
-            = constrain_fun(rng, unconstrained_col,
-                            approx_samples_constrained_col)
-                  .matrix();
+        fill_draw(constrained_draws_mat, i, elbo_lp_mat.row(i),
+                  elbo_draws.col(i));
       }
       lp_ratio = std::move(elbo_best.lp_ratio);
     }
   } else {
     // output only first num_draws from what we computed for ELBO
     constrained_draws_mat
-        = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(names.size(),
+        = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>(num_draw_rows,
                                                                 num_draws);
-    Eigen::VectorXd approx_samples_constrained_col;
-    Eigen::VectorXd unconstrained_col;
     for (Eigen::Index i = 0; i < num_draws; ++i) {
-      constrained_draws_mat.col(i).head(2) = elbo_lp_mat.row(i).matrix();
-      unconstrained_col = elbo_draws.col(i);
-      constrained_draws_mat.col(i).tail(num_unconstrained_params)
-          = constrain_fun(rng, unconstrained_col,
-                          approx_samples_constrained_col)
-                .matrix();
+      fill_draw(constrained_draws_mat, i, elbo_lp_mat.row(i),
+                elbo_draws.col(i));
     }
     lp_ratio = std::move(elbo_best.lp_ratio.head(num_draws));
   }
-  parameter_writer(constrained_draws_mat);
+  if (constrain_draws) {
+    parameter_writer(constrained_draws_mat);
+  }
   parameter_writer();
   const auto end_pathfinder_time = std::chrono::steady_clock::now();
   const double pathfinder_delta_time = stan::services::util::duration_diff(
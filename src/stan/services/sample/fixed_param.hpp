@@ -11,7 +11,17 @@
 #include <stan/services/util/generate_transitions.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/parallel_chains.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
 #include <vector>
 
 namespace stan {
@@ -162,27 +172,23 @@ int fixed_param(Model& model, const std::size_t num_chains,
   }
 
   try {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, num_chains, 1),
-        [&samplers, &writers, &samples, &model, &rngs, &interrupt, &logger,
-         num_samples, num_thin, refresh, chain,
-         num_chains](const tbb::blocked_range<size_t>& r) {
-          for (size_t i = r.begin(); i != r.end(); ++i) {
-            auto start = std::chrono::steady_clock::now();
-            util::generate_transitions(
-                samplers[i], num_samples, 0, num_samples, num_thin, refresh,
-                true, false, writers[i], samples[i], model, rngs[i], interrupt,
-                logger, chain + i, num_chains);
-            auto end = std::chrono::steady_clock::now();
-            double sample_delta_t
-                = std::chrono::duration_cast<std::chrono::milliseconds>(end
-                                                                        - start)
-                      .count()
-                  / 1000.0;
-            writers[i].write_timing(0.0, sample_delta_t);
-          }
-        },
-        tbb::simple_partitioner());
+    util::parallel_chains(
+        num_chains, interrupt,
+        [&](size_t i, callbacks::interrupt& chain_interrupt) {
+          auto start = std::chrono::steady_clock::now();
+          util::generate_transitions(samplers[i], num_samples, 0, num_samples,
+                                     num_thin, refresh, true, false,
+                                     writers[i], samples[i], model, rngs[i],
+                                     chain_interrupt, logger, chain + i,
+                                     num_chains);
+          auto end = std::chrono::steady_clock::now();
+          double sample_delta_t
+              = std::chrono::duration_cast<std::chrono::milliseconds>(end
+                                                                      - start)
+                    .count()
+                / 1000.0;
+          writers[i].write_timing(0.0, sample_delta_t);
+        });
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::SOFTWARE;
@@ -190,6 +196,204 @@ int fixed_param(Model& model, const std::size_t num_chains,
   return error_codes::OK;
 }
 
+namespace internal {
+
+/**
+ * Constrained values of a saved fixed_param draw and the messages of
+ * computing them, kept until the draws before it are written.
+ */
+struct fixed_param_draw {
+  std::vector<double> model_values;
+  std::vector<std::string> info;
+  bool failed = false;
+};
+
+/**
+ * Buffers reused by a thread for the draws it computes.
+ */
+struct fixed_param_buffers {
+  std::vector<double> cont_params;
+  std::vector<int> params_i;
+  std::stringstream msgs;
+};
+
+}  // namespace internal
+
+/**
+ * Runs the fixed parameter sampler, computing the constrained values
+ * of the saved draws in parallel.
+ *
+ * The parameters are initialized as in <code>fixed_param</code>.  As the
+ * sampler never moves, only model.write_array() differs between draws;
+ * it is evaluated for blocks of <code>block_size</code> saved draws in
+ * parallel, each block with the generator of its own substream of the
+ * chain, so the output does not depend on the number of threads.  The
+ * generated quantities differ from those of <code>fixed_param</code>,
+ * which uses one generator for all draws.  Each thread reuses its
+ * buffers, and a bounded window of blocks is computed before the
+ * calling thread writes it in order, calling the interrupt and the
+ * logger.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model to test (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] refresh Controls the output
+ * @param[in] block_size number of saved draws per block sharing a
+ *   generator
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int fixed_param_batched(Model& model, const stan::io::var_context& init,
+                         unsigned int random_seed, unsigned int chain,
+                         double init_radius, int num_samples, int num_thin,
+                         int refresh, size_t block_size,
+                         callbacks::interrupt& interrupt,
+                         callbacks::logger& logger,
+                         callbacks::writer& init_writer,
+                         callbacks::writer& sample_writer,
+                         callbacks::writer& diagnostic_writer) {
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+
+  std::vector<double> cont_vector;
+  try {
+    cont_vector = util::initialize(model, init, rng, init_radius, false, logger,
+                                   init_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+
+  stan::mcmc::fixed_param_sampler sampler;
+  services::util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  Eigen::VectorXd cont_params = Eigen::Map<Eigen::VectorXd>(
+      cont_vector.data(), cont_vector.size());
+  stan::mcmc::sample s(cont_params, 0, 0);
+
+  // Headers
+  writer.write_sample_names(s, sampler, model);
+  writer.write_diagnostic_names(s, sampler, model);
+
+  auto start = std::chrono::steady_clock::now();
+  block_size = std::max<size_t>(block_size, 1);
+  num_thin = std::max(num_thin, 1);
+  const size_t num_saved
+      = num_samples > 0 ? (num_samples + num_thin - 1) / num_thin : 0;
+  const size_t num_blocks = (num_saved + block_size - 1) / block_size;
+  const size_t window = std::min<size_t>(
+      num_blocks, 4 * std::max(tbb::this_task_arena::max_concurrency(), 1));
+  const bool include_tparams = writer.output_spec().include_tparams;
+  const bool include_gqs = writer.output_spec().include_gqs;
+  const bool need_model_values = writer.need_model_values();
+  const int it_print_width
+      = std::ceil(std::log10(static_cast<double>(std::max(num_samples, 1))));
+  tbb::enumerable_thread_specific<internal::fixed_param_buffers> buffers;
+  std::vector<internal::fixed_param_draw> results(window * block_size);
+  int m = 0;
+  auto advance = [&](int next) {
+    for (; m < next; ++m) {
+      interrupt();
+      if (refresh > 0
+          && (m + 1 == num_samples || m == 0 || (m + 1) % refresh == 0)) {
+        std::stringstream message;
+        message << "Iteration: " << std::setw(it_print_width) << m + 1
+                << " / " << num_samples << " [" << std::setw(3)
+                << static_cast<int>((100.0 * (m + 1)) / num_samples)
+                << "%]  (Sampling)";
+        logger.info(message);
+      }
+    }
+  };
+  try {
+    for (size_t first = 0; first < num_blocks; first += window) {
+      const size_t last = std::min(num_blocks, first + window);
+      const size_t offset = first * block_size;
+      if (need_model_values) {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(first, last, 1),
+            [&](const tbb::blocked_range<size_t>& r) {
+              internal::fixed_param_buffers& local = buffers.local();
+              local.cont_params = cont_vector;
+              for (size_t block = r.begin(); block != r.end(); ++block) {
+                stan::rng_t block_rng
+                    = util::create_rng(random_seed, chain, block);
+                const size_t end
+                    = std::min(num_saved, (block + 1) * block_size);
+                for (size_t i = block * block_size; i < end; ++i) {
+                  internal::fixed_param_draw& result = results[i - offset];
+                  result.model_values.clear();
+                  result.info.clear();
+                  result.failed = false;
+                  local.params_i.clear();
+                  local.msgs.str(std::string());
+                  local.msgs.clear();
+                  try {
+                    model.write_array(block_rng, local.cont_params,
+                                      local.params_i, result.model_values,
+                                      include_tparams, include_gqs,
+                                      &local.msgs);
+                  } catch (const std::domain_error& e) {
+                    result.info.push_back(local.msgs.str());
+                    local.msgs.str(std::string());
+                    result.info.push_back(e.what());
+                  } catch (const std::exception& e) {
+                    result.info.push_back(local.msgs.str());
+                    local.msgs.str(std::string());
+                    result.info.push_back(e.what());
+                    result.failed = true;
+                    // Draws after an error are never written
+                    break;
+                  }
+                  if (local.msgs.tellp() > 0)
+                    result.info.push_back(local.msgs.str());
+                }
+              }
+            },
+            tbb::simple_partitioner());
+      }
+
+      const size_t end = std::min(num_saved, last * block_size);
+      for (size_t i = offset; i < end; ++i) {
+        // Iterations between saved draws leave the state unchanged
+        advance(i * num_thin + 1);
+        internal::fixed_param_draw& result = results[i - offset];
+        if (!need_model_values)
+          result.model_values.clear();
+        for (const auto& info : result.info)
+          if (!info.empty())
+            logger.info(info);
+        if (result.failed) {
+          logger.error(result.info.back());
+          return error_codes::SOFTWARE;
+        }
+        writer.write_sample_params(s, sampler, result.model_values);
+        writer.write_diagnostic_params(s, sampler);
+      }
+    }
+    advance(num_samples);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  auto end = std::chrono::steady_clock::now();
+  double sample_delta_t
+      = std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
+            .count()
+        / 1000.0;
+  writer.write_timing(0.0, sample_delta_t);
+
+  return error_codes::OK;
+}
+
 }  // namespace sample
 }  // namespace services
 }  // namespace stan
@@ -0,0 +1,158 @@
+#ifndef STAN_SERVICES_SAMPLE_HMC_CHEES_DIAG_E_ADAPT_HPP
+#define STAN_SERVICES_SAMPLE_HMC_CHEES_DIAG_E_ADAPT_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/chees_adaptation.hpp>
+#include <stan/mcmc/hmc/chees/diag_e_chees_hmc.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/run_adaptive_chees_sampler.hpp>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+
+/**
+ * Runs many short chains of HMC with a jittered static integration time
+ * (ChEES-HMC) using a diagonal Euclidean metric, with the step size,
+ * integration time and metric shared by all chains and adapted from
+ * statistics across them during warmup.
+ *
+ * All chains integrate for the same number of leapfrog steps in every
+ * iteration, so they advance in lockstep and the gradients at the
+ * positions of all chains are computed in one call to
+ * `stan::model::log_prob_grad_batch` per step, without the idle lanes of
+ * chains whose NUTS trajectories stop early.  The metric is the variance
+ * of the positions across the chains over the first three quarters of
+ * warmup.  With hundreds of chains, a warmup of a few hundred iterations
+ * and a few draws per chain are usually enough.
+ *
+ * The chains are grouped into `num_superchains` superchains of
+ * consecutive chains, all the chains of a superchain starting from the
+ * same initial value.  After sampling, the nested potential scale
+ * reduction (nested Rhat) over the draws of all chains is logged, as a
+ * warning if it exceeds 1.01.
+ *
+ * @tparam Model Model class
+ * @tparam InitContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam SamplerWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] num_chains The number of chains. `init_writer`,
+ * `sample_writer`, `diagnostic_writer` and `metric_writer` must be the same
+ * length as this value.
+ * @param[in] num_superchains The number of superchains, at least two and
+ * dividing `num_chains`
+ * @param[in] init A std vector of init var contexts for the initialization
+ * of each superchain.
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id first chain id. The pseudo random number generator
+ * will advance for each chain by an integer sequence from `init_chain_id` to
+ * `init_chain_id + num_chains - 1`
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] max_num_steps Maximum number of leapfrog steps of a transition
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] learning_rate learning rate of the log integration time
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer std vector of Writer callbacks for unconstrained
+ * inits of each chain.
+ * @param[in,out] sample_writer std vector of Writers for draws of each chain.
+ * @param[in,out] diagnostic_writer std vector of Writers for diagnostic
+ * information of each chain.
+ * @param[in,out] metric_writer std vector of Writers for tuning params
+ * @return error_codes::OK if successful
+ */
+template <class Model, typename InitContextPtr, typename InitWriter,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+int hmc_chees_diag_e_adapt(
+    Model& model, size_t num_chains, size_t num_superchains,
+    const std::vector<InitContextPtr>& init, unsigned int random_seed,
+    unsigned int init_chain_id, double init_radius, int num_warmup,
+    int num_samples, int num_thin, bool save_warmup, int refresh,
+    double stepsize, int max_num_steps, double delta, double gamma,
+    double kappa, double t0, double learning_rate,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer) {
+  if (num_superchains < 2 || num_chains % num_superchains != 0) {
+    logger.error("The number of superchains must be at least two and divide "
+                 "the number of chains; found num_chains = "
+                 + std::to_string(num_chains) + " and num_superchains = "
+                 + std::to_string(num_superchains) + ".");
+    return error_codes::CONFIG;
+  }
+  const size_t chains_per_superchain = num_chains / num_superchains;
+  using sample_t = stan::mcmc::diag_e_chees_hmc<Model, stan::rng_t>;
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_chains);
+  std::vector<std::vector<double>> cont_vectors;
+  cont_vectors.reserve(num_chains);
+  std::vector<sample_t> samplers;
+  samplers.reserve(num_chains);
+  stan::mcmc::chees_adaptation adaptation;
+  try {
+    for (size_t i = 0; i < num_chains; ++i) {
+      rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
+      if (i % chains_per_superchain == 0) {
+        cont_vectors.emplace_back(util::initialize(
+            model, *init[i / chains_per_superchain], rngs[i], init_radius,
+            true, logger, init_writer[i]));
+      } else {
+        cont_vectors.emplace_back(cont_vectors[i - 1]);
+        init_writer[i](cont_vectors[i]);
+      }
+      samplers.emplace_back(model, rngs[i]);
+      samplers[i].set_nominal_stepsize(stepsize);
+    }
+    adaptation.get_stepsize_adaptation().set_mu(log(10 * stepsize));
+    adaptation.get_stepsize_adaptation().set_delta(delta);
+    adaptation.get_stepsize_adaptation().set_gamma(gamma);
+    adaptation.get_stepsize_adaptation().set_kappa(kappa);
+    adaptation.get_stepsize_adaptation().set_t0(t0);
+    adaptation.set_learning_rate(learning_rate);
+    adaptation.set_max_num_steps(max_num_steps);
+    adaptation.set_metric_adaptation_end(3 * num_warmup / 4);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  try {
+    util::run_adaptive_chees_sampler(
+        samplers, adaptation, model, cont_vectors, num_warmup, num_samples,
+        num_thin, refresh, save_warmup, num_superchains, rngs, interrupt,
+        logger, sample_writer, diagnostic_writer, metric_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
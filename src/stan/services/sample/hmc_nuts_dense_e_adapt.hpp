@@ -3,6 +3,7 @@
 
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/multi_chain_logger.hpp>
 #include <stan/callbacks/structured_writer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
@@ -12,6 +13,7 @@
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/inv_metric.hpp>
+#include <stan/services/util/parallel_chains.hpp>
 #include <stan/services/util/run_adaptive_sampler.hpp>
 #include <vector>
 
@@ -71,12 +73,13 @@ int hmc_nuts_dense_e_adapt(
   std::vector<double> cont_vector;
 
   Eigen::MatrixXd inv_metric;
+  Eigen::LLT<Eigen::MatrixXd> inv_metric_llt;
   try {
     cont_vector = util::initialize(model, init, rng, init_radius, true, logger,
                                    init_writer);
     inv_metric = util::read_dense_inv_metric(init_inv_metric,
                                              model.num_params_r(), logger);
-    util::validate_dense_inv_metric(inv_metric, logger);
+    inv_metric_llt = util::validate_dense_inv_metric(inv_metric, logger);
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::CONFIG;
@@ -84,7 +87,7 @@ int hmc_nuts_dense_e_adapt(
 
   stan::mcmc::adapt_dense_e_nuts<Model, stan::rng_t> sampler(model, rng);
 
-  sampler.set_metric(inv_metric);
+  sampler.set_metric(inv_metric, inv_metric_llt);
 
   sampler.set_nominal_stepsize(stepsize);
   sampler.set_stepsize_jitter(stepsize_jitter);
@@ -354,51 +357,55 @@ int hmc_nuts_dense_e_adapt(
   rngs.reserve(num_chains);
   std::vector<std::vector<double>> cont_vectors;
   cont_vectors.reserve(num_chains);
-  std::vector<sample_t> samplers;
-  samplers.reserve(num_chains);
+  std::vector<Eigen::MatrixXd> inv_metrics;
+  inv_metrics.reserve(num_chains);
+  std::vector<Eigen::LLT<Eigen::MatrixXd>> inv_metric_llts;
+  inv_metric_llts.reserve(num_chains);
   try {
     for (int i = 0; i < num_chains; ++i) {
       rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
       cont_vectors.emplace_back(util::initialize(
           model, *init[i], rngs[i], init_radius, true, logger, init_writer[i]));
-      Eigen::MatrixXd inv_metric = util::read_dense_inv_metric(
-          *init_inv_metric[i], model.num_params_r(), logger);
-      util::validate_dense_inv_metric(inv_metric, logger);
-
-      samplers.emplace_back(model, rngs[i]);
-      samplers[i].set_metric(inv_metric);
-      samplers[i].set_nominal_stepsize(stepsize);
-      samplers[i].set_stepsize_jitter(stepsize_jitter);
-      samplers[i].set_max_depth(max_depth);
-
-      samplers[i].get_stepsize_adaptation().set_mu(log(10 * stepsize));
-      samplers[i].get_stepsize_adaptation().set_delta(delta);
-      samplers[i].get_stepsize_adaptation().set_gamma(gamma);
-      samplers[i].get_stepsize_adaptation().set_kappa(kappa);
-      samplers[i].get_stepsize_adaptation().set_t0(t0);
-      samplers[i].set_window_params(num_warmup, init_buffer, term_buffer,
-                                    window, logger);
+      inv_metrics.emplace_back(util::read_dense_inv_metric(
+          *init_inv_metric[i], model.num_params_r(), logger));
+      inv_metric_llts.emplace_back(
+          util::validate_dense_inv_metric(inv_metrics[i], logger));
     }
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::CONFIG;
   }
   try {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, num_chains, 1),
-        [num_warmup, num_samples, num_thin, refresh, save_warmup, num_chains,
-         init_chain_id, &samplers, &model, &rngs, &interrupt, &logger,
-         &sample_writer, &cont_vectors, &diagnostic_writer,
-         &metric_writer](const tbb::blocked_range<size_t>& r) {
-          for (size_t i = r.begin(); i != r.end(); ++i) {
-            util::run_adaptive_sampler(
-                samplers[i], model, cont_vectors[i], num_warmup, num_samples,
-                num_thin, refresh, save_warmup, rngs[i], interrupt, logger,
-                sample_writer[i], diagnostic_writer[i], metric_writer[i],
-                init_chain_id + i, num_chains);
-          }
-        },
-        tbb::simple_partitioner());
+    // Each chain logs through its own buffer, passed on in batches
+    callbacks::multi_chain_logger chain_loggers(
+        logger, num_chains, 32, std::chrono::milliseconds(100),
+        init_chain_id);
+    // Each sampler is built by the thread running its chain, so that its
+    // metric and points are allocated in memory local to that thread
+    auto run_chain = [&](size_t i, callbacks::interrupt& chain_interrupt) {
+      callbacks::logger& chain_logger = chain_loggers.chain(i);
+      sample_t sampler(model, rngs[i]);
+      sampler.set_metric(inv_metrics[i], inv_metric_llts[i]);
+      inv_metrics[i].resize(0, 0);
+      inv_metric_llts[i] = Eigen::LLT<Eigen::MatrixXd>();
+      sampler.set_nominal_stepsize(stepsize);
+      sampler.set_stepsize_jitter(stepsize_jitter);
+      sampler.set_max_depth(max_depth);
+
+      sampler.get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      sampler.get_stepsize_adaptation().set_delta(delta);
+      sampler.get_stepsize_adaptation().set_gamma(gamma);
+      sampler.get_stepsize_adaptation().set_kappa(kappa);
+      sampler.get_stepsize_adaptation().set_t0(t0);
+      sampler.set_window_params(num_warmup, init_buffer, term_buffer, window,
+                                chain_logger);
+      util::run_adaptive_sampler(
+          sampler, model, cont_vectors[i], num_warmup, num_samples, num_thin,
+          refresh, save_warmup, rngs[i], chain_interrupt, chain_logger,
+          sample_writer[i], diagnostic_writer[i], metric_writer[i],
+          init_chain_id + i, num_chains);
+    };
+    util::parallel_chains(num_chains, interrupt, run_chain);
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::SOFTWARE;
@@ -1,6 +1,7 @@
 #ifndef STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_HPP
 #define STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_HPP
 
+#include <stan/callbacks/cancellation_token.hpp>
 #include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/structured_writer.hpp>
@@ -8,11 +9,19 @@
 #include <stan/io/var_context.hpp>
 #include <stan/math/prim.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/model/model_metadata.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/inv_metric.hpp>
 #include <stan/services/util/initialize.hpp>
+#include <stan/services/util/initialize_chains.hpp>
 #include <stan/services/util/run_adaptive_sampler.hpp>
+#include <stan/services/util/run_pooled_adaptive_sampler.hpp>
+#include <stan/services/util/sampling_target.hpp>
+#include <stan/services/util/warm_start_cache.hpp>
+#include <stan/services/util/parallel_chains.hpp>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace stan {
@@ -111,6 +120,236 @@ int hmc_nuts_diag_e_adapt(
   return error_codes::OK;
 }
 
+namespace internal {
+
+/**
+ * Return whether the adapted state is that of a run of the model with
+ * a diagonal metric.
+ */
+template <class Model>
+inline bool is_diag_warm_start(const Model& model,
+                               const util::warm_start& warm_start) {
+  return warm_start.model_name == model.model_name()
+         && warm_start.cont_params.size() == model.num_params_r()
+         && warm_start.inv_metric.rows()
+                == static_cast<int>(model.num_params_r())
+         && warm_start.inv_metric.cols() == 1;
+}
+
+}  // namespace internal
+
+/**
+ * Runs HMC with NUTS with adaptation using diagonal Euclidean metric,
+ * starting from the adapted state of an earlier run of the model when
+ * one is given, and saves the adapted state of this run to it.  For a
+ * stream of refits of a model whose data is rebound between fits by
+ * <code>util::rebind_model</code>, each fit continues from the last.
+ *
+ * If <code>warm_start</code> holds the state of a run of the same
+ * model with a diagonal metric, the chain starts from its position,
+ * step size and inverse metric instead of <code>init</code>,
+ * <code>init_inv_metric</code> and <code>stepsize</code>, and warms up
+ * for <code>warm_num_warmup</code> iterations instead of
+ * <code>num_warmup</code>.  With fewer than 20 such iterations only the
+ * step size is adapted, verifying the previous step size, and the
+ * previous metric is kept.  Otherwise, as for a default constructed
+ * <code>warm_start</code>, the chain is run as by the overload without
+ * one.  The state is only replaced if the run succeeds.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] init_inv_metric var context exposing an initial diagonal
+ *              inverse Euclidean metric (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in,out] metric_writer Writer for tuning params
+ * @param[in,out] warm_start adapted state of the previous run, replaced
+ *   by that of this run
+ * @param[in] warm_num_warmup Number of warmup samples from a warm start
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_diag_e_adapt(
+    Model& model, const stan::io::var_context& init,
+    const stan::io::var_context& init_inv_metric, unsigned int random_seed,
+    unsigned int chain, double init_radius, int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize,
+    double stepsize_jitter, int max_depth, double delta, double gamma,
+    double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    callbacks::structured_writer& metric_writer, util::warm_start& warm_start,
+    int warm_num_warmup) {
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+
+  const bool warm = internal::is_diag_warm_start(model, warm_start);
+
+  std::vector<double> cont_vector;
+
+  Eigen::VectorXd inv_metric;
+  try {
+    if (warm) {
+      cont_vector = warm_start.cont_params;
+      init_writer(cont_vector);
+      inv_metric = warm_start.inv_metric.col(0);
+      stepsize = warm_start.stepsize;
+      num_warmup = warm_num_warmup;
+    } else {
+      cont_vector = util::initialize(model, init, rng, init_radius, true,
+                                     logger, init_writer);
+      inv_metric = util::read_diag_inv_metric(init_inv_metric,
+                                              model.num_params_r(), logger);
+    }
+    util::validate_diag_inv_metric(inv_metric, logger);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+
+  stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t> sampler(model, rng);
+
+  sampler.set_metric(inv_metric);
+  sampler.set_nominal_stepsize(stepsize);
+  sampler.set_stepsize_jitter(stepsize_jitter);
+  sampler.set_max_depth(max_depth);
+
+  sampler.get_stepsize_adaptation().set_mu(log(10 * stepsize));
+  sampler.get_stepsize_adaptation().set_delta(delta);
+  sampler.get_stepsize_adaptation().set_gamma(gamma);
+  sampler.get_stepsize_adaptation().set_kappa(kappa);
+  sampler.get_stepsize_adaptation().set_t0(t0);
+
+  sampler.set_window_params(num_warmup, init_buffer, term_buffer, window,
+                            logger);
+
+  try {
+    util::run_adaptive_sampler(sampler, model, cont_vector, num_warmup,
+                               num_samples, num_thin, refresh, save_warmup, rng,
+                               interrupt, logger, sample_writer,
+                               diagnostic_writer, metric_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+
+  warm_start.model_name = model.model_name();
+  warm_start.stepsize = sampler.get_nominal_stepsize();
+  warm_start.inv_metric = sampler.z().inv_e_metric_;
+  warm_start.cont_params.assign(sampler.z().q.data(),
+                                sampler.z().q.data() + sampler.z().q.size());
+  return error_codes::OK;
+}
+
+/**
+ * Runs HMC with NUTS with adaptation using diagonal Euclidean metric,
+ * starting from the adapted state of an earlier run of the model on
+ * the same data when the warm start cache holds one, and saves the
+ * adapted state of this run to the cache.
+ *
+ * On a cache hit the chain starts from the cached position, step size
+ * and inverse metric instead of <code>init</code>,
+ * <code>init_inv_metric</code> and <code>stepsize</code>, and warms up
+ * for <code>warm_num_warmup</code> iterations instead of
+ * <code>num_warmup</code>.  With fewer than 20 such iterations only the
+ * step size is adapted, verifying the cached step size, and the cached
+ * metric is kept.  Otherwise the chain is run as by the overload
+ * without a cache.  A cache entry that cannot be written is reported as
+ * a warning and does not fail the run.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] init_inv_metric var context exposing an initial diagonal
+ *              inverse Euclidean metric (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number generator
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in,out] metric_writer Writer for tuning params
+ * @param[in] data var context the model was constructed with
+ * @param[in] warm_start_cache cache of adapted states
+ * @param[in] warm_num_warmup Number of warmup samples on a cache hit
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_diag_e_adapt(
+    Model& model, const stan::io::var_context& init,
+    const stan::io::var_context& init_inv_metric, unsigned int random_seed,
+    unsigned int chain, double init_radius, int num_warmup, int num_samples,
+    int num_thin, bool save_warmup, int refresh, double stepsize,
+    double stepsize_jitter, int max_depth, double delta, double gamma,
+    double kappa, double t0, unsigned int init_buffer, unsigned int term_buffer,
+    unsigned int window, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& init_writer,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    callbacks::structured_writer& metric_writer,
+    const stan::io::var_context& data,
+    const util::warm_start_cache& warm_start_cache, int warm_num_warmup) {
+  const std::string key = util::warm_start_cache::key(model, data);
+  util::warm_start state;
+  if (warm_start_cache.read(key, state)
+      && internal::is_diag_warm_start(model, state)) {
+    logger.info("Warm start from " + warm_start_cache.path(key));
+    logger.info("");
+  }
+  int return_code = hmc_nuts_diag_e_adapt(
+      model, init, init_inv_metric, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init_writer, sample_writer, diagnostic_writer,
+      metric_writer, state, warm_num_warmup);
+  if (return_code != error_codes::OK)
+    return return_code;
+  try {
+    warm_start_cache.write(key, state);
+  } catch (const std::exception& e) {
+    logger.warn(e.what());
+  }
+  return error_codes::OK;
+}
+
 /**
  * Runs HMC with NUTS with adaptation using diagonal Euclidean metric
  * with a pre-specified diagonal metric.
@@ -273,6 +512,118 @@ int hmc_nuts_diag_e_adapt(
       dummy_metric_writer);
 }
 
+namespace internal {
+
+/**
+ * Runs the chains of the multi-chain <code>hmc_nuts_diag_e_adapt</code>,
+ * stopping them all through the specified cancellation token, which is
+ * cancelled when a chain fails or is interrupted.  Chains stopped by
+ * finishing the token end the run successfully.
+ */
+template <class Model, typename InitContextPtr, typename InitInvContextPtr,
+          typename InitWriter, typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+int hmc_nuts_diag_e_adapt_chains(
+    Model& model, size_t num_chains, const std::vector<InitContextPtr>& init,
+    const std::vector<InitInvContextPtr>& init_inv_metric,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer,
+    callbacks::cancellation_token& cancel) {
+  using sample_t = stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t>;
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_chains);
+  for (size_t i = 0; i < num_chains; ++i)
+    rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
+  std::vector<util::chain_init> chain_inits = util::initialize_chains(
+      model, init, rngs, init_radius, true, num_chains, logger, init_writer);
+  bool all_initialized = true;
+  for (size_t i = 0; i < num_chains; ++i) {
+    if (!chain_inits[i].ok) {
+      logger.error("Chain " + std::to_string(init_chain_id + i)
+                   + " could not be initialized.");
+      all_initialized = false;
+    }
+  }
+  if (!all_initialized)
+    return error_codes::CONFIG;
+  std::vector<std::vector<double>> cont_vectors;
+  cont_vectors.reserve(num_chains);
+  std::vector<sample_t> samplers;
+  samplers.reserve(num_chains);
+  try {
+    for (int i = 0; i < num_chains; ++i) {
+      cont_vectors.emplace_back(std::move(chain_inits[i].cont_vector));
+      samplers.emplace_back(model, rngs[i]);
+      // Start from the evaluated gradient, so initializing the step size
+      // does not evaluate it again
+      samplers[i].seed(
+          Eigen::Map<const Eigen::VectorXd>(cont_vectors[i].data(),
+                                            cont_vectors[i].size()),
+          chain_inits[i].log_prob,
+          Eigen::Map<const Eigen::VectorXd>(chain_inits[i].gradient.data(),
+                                            chain_inits[i].gradient.size()));
+      Eigen::VectorXd inv_metric = util::read_diag_inv_metric(
+          *init_inv_metric[i], model.num_params_r(), logger);
+      util::validate_diag_inv_metric(inv_metric, logger);
+
+      samplers[i].set_metric(inv_metric);
+      samplers[i].set_nominal_stepsize(stepsize);
+      samplers[i].set_stepsize_jitter(stepsize_jitter);
+      samplers[i].set_max_depth(max_depth);
+
+      samplers[i].get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      samplers[i].get_stepsize_adaptation().set_delta(delta);
+      samplers[i].get_stepsize_adaptation().set_gamma(gamma);
+      samplers[i].get_stepsize_adaptation().set_kappa(kappa);
+      samplers[i].get_stepsize_adaptation().set_t0(t0);
+      samplers[i].set_window_params(num_warmup, init_buffer, term_buffer,
+                                    window, logger);
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  try {
+    // The names of the model are built once for the headers of all
+    // chains
+    const stan::model::model_metadata metadata(model);
+    util::sample_output_spec output_spec;
+    output_spec.metadata = &metadata;
+    util::parallel_chains(
+        num_chains, interrupt,
+        [&](size_t i, callbacks::interrupt& chain_interrupt) {
+          callbacks::structured_writer instrumentation_writer;
+          util::run_adaptive_sampler(
+              samplers[i], model, cont_vectors[i], num_warmup, num_samples,
+              num_thin, refresh, save_warmup, rngs[i], chain_interrupt, logger,
+              sample_writer[i], diagnostic_writer[i], metric_writer[i],
+              instrumentation_writer, init_chain_id + i, num_chains,
+              output_spec);
+        },
+        cancel);
+  } catch (const callbacks::cancelled_error& e) {
+    // Chains stopped by a finished token have done their work
+    if (!cancel.finished()) {
+      logger.error(e.what());
+      return error_codes::SOFTWARE;
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace internal
+
 /**
  * Runs multiple chains of HMC with NUTS with adaptation using diagonal
  * Euclidean metric with a pre-specified diagonal metric and saves adapted
@@ -349,61 +700,123 @@ int hmc_nuts_diag_e_adapt(
         init_buffer, term_buffer, window, interrupt, logger, init_writer[0],
         sample_writer[0], diagnostic_writer[0], metric_writer[0]);
   }
-  using sample_t = stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t>;
-  std::vector<stan::rng_t> rngs;
-  rngs.reserve(num_chains);
-  std::vector<std::vector<double>> cont_vectors;
-  cont_vectors.reserve(num_chains);
-  std::vector<sample_t> samplers;
-  samplers.reserve(num_chains);
-  try {
-    for (int i = 0; i < num_chains; ++i) {
-      rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
-      cont_vectors.emplace_back(util::initialize(
-          model, *init[i], rngs[i], init_radius, true, logger, init_writer[i]));
-      samplers.emplace_back(model, rngs[i]);
-      Eigen::VectorXd inv_metric = util::read_diag_inv_metric(
-          *init_inv_metric[i], model.num_params_r(), logger);
-      util::validate_diag_inv_metric(inv_metric, logger);
-
-      samplers[i].set_metric(inv_metric);
-      samplers[i].set_nominal_stepsize(stepsize);
-      samplers[i].set_stepsize_jitter(stepsize_jitter);
-      samplers[i].set_max_depth(max_depth);
+  callbacks::cancellation_token cancel;
+  return internal::hmc_nuts_diag_e_adapt_chains(
+      model, num_chains, init, init_inv_metric, random_seed, init_chain_id,
+      init_radius, num_warmup, num_samples, num_thin, save_warmup, refresh,
+      stepsize, stepsize_jitter, max_depth, delta, gamma, kappa, t0,
+      init_buffer, term_buffer, window, interrupt, logger, init_writer,
+      sample_writer, diagnostic_writer, metric_writer, cancel);
+}
 
-      samplers[i].get_stepsize_adaptation().set_mu(log(10 * stepsize));
-      samplers[i].get_stepsize_adaptation().set_delta(delta);
-      samplers[i].get_stepsize_adaptation().set_gamma(gamma);
-      samplers[i].get_stepsize_adaptation().set_kappa(kappa);
-      samplers[i].get_stepsize_adaptation().set_t0(t0);
-      samplers[i].set_window_params(num_warmup, init_buffer, term_buffer,
-                                    window, logger);
-    }
-  } catch (const std::exception& e) {
-    logger.error(e.what());
-    return error_codes::CONFIG;
-  }
+/**
+ * Runs multiple chains of HMC with NUTS with adaptation using diagonal
+ * Euclidean metric until a sampling target is reached, with
+ * <code>num_samples</code> as an upper bound on the number of draws of
+ * each chain.
+ *
+ * The draws of every chain after warmup are fed to a
+ * <code>util::sampling_target_monitor</code>, which checks the target
+ * across chains every <code>target.check_every</code> draws of a chain
+ * and, once it is reached, stops every chain at its next iteration
+ * through the cancellation token the chains share.  The draws written
+ * so far are kept, so chains may end with slightly different numbers
+ * of draws, and the timing of the chains is not written.
+ *
+ * @tparam Model Model class
+ * @tparam InitContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitInvContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam SamplerWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] num_chains The number of chains to run in parallel. `init`,
+ * `init_inv_metric`, `init_writer`, `sample_writer`, and `diagnostic_writer`
+ * must be the same length as this value.
+ * @param[in] init A std vector of init var contexts for per-chain
+ * initialization.
+ * @param[in] init_inv_metric A std vector of var contexts exposing an initial
+ * diagonal inverse Euclidean metric for each chain (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id first chain id. The pseudo random number generator
+ * will advance for each chain by an integer sequence from `init_chain_id` to
+ * `init_chain_id + num_chains - 1`
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Maximum number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer std vector of Writer callbacks for unconstrained
+ * inits of each chain.
+ * @param[in,out] sample_writer std vector of Writers for draws of each chain.
+ * @param[in,out] diagnostic_writer std vector of Writers for diagnostic
+ * information of each chain.
+ * @param[in,out] metric_writer std vector of Writers for tuning params
+ * @param[in] target convergence target at which sampling stops
+ * @return error_codes::OK if successful, whether or not the target was
+ * reached
+ */
+template <class Model, typename InitContextPtr, typename InitInvContextPtr,
+          typename InitWriter, typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+int hmc_nuts_diag_e_adapt(
+    Model& model, size_t num_chains, const std::vector<InitContextPtr>& init,
+    const std::vector<InitInvContextPtr>& init_inv_metric,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer,
+    const util::sampling_target& target) {
+  callbacks::cancellation_token cancel;
+  std::unique_ptr<util::sampling_target_monitor> monitor;
   try {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, num_chains, 1),
-        [num_warmup, num_samples, num_thin, refresh, save_warmup, num_chains,
-         init_chain_id, &samplers, &model, &rngs, &interrupt, &logger,
-         &sample_writer, &cont_vectors, &diagnostic_writer,
-         &metric_writer](const tbb::blocked_range<size_t>& r) {
-          for (size_t i = r.begin(); i != r.end(); ++i) {
-            util::run_adaptive_sampler(
-                samplers[i], model, cont_vectors[i], num_warmup, num_samples,
-                num_thin, refresh, save_warmup, rngs[i], interrupt, logger,
-                sample_writer[i], diagnostic_writer[i], metric_writer[i],
-                init_chain_id + i, num_chains);
-          }
-        },
-        tbb::simple_partitioner());
+    monitor = std::make_unique<util::sampling_target_monitor>(
+        target, num_chains, cancel);
   } catch (const std::exception& e) {
     logger.error(e.what());
-    return error_codes::SOFTWARE;
+    return error_codes::CONFIG;
   }
-  return error_codes::OK;
+  // The saved warmup draws, one every num_thin iterations, come first
+  const int num_saved_warmup
+      = save_warmup ? (num_warmup + num_thin - 1) / num_thin : 0;
+  std::vector<util::sampling_target_writer> target_writer;
+  target_writer.reserve(num_chains);
+  for (size_t i = 0; i < num_chains; ++i)
+    target_writer.emplace_back(sample_writer[i], *monitor, i,
+                               num_saved_warmup);
+  int return_code = internal::hmc_nuts_diag_e_adapt_chains(
+      model, num_chains, init, init_inv_metric, random_seed, init_chain_id,
+      init_radius, num_warmup, num_samples, num_thin, save_warmup, refresh,
+      stepsize, stepsize_jitter, max_depth, delta, gamma, kappa, t0,
+      init_buffer, term_buffer, window, interrupt, logger, init_writer,
+      target_writer, diagnostic_writer, metric_writer, cancel);
+  if (return_code == error_codes::OK && monitor->reached())
+    logger.info("Sampling target reached after "
+                + std::to_string(monitor->reached_num_draws())
+                + " draws per chain.");
+  return return_code;
 }
 
 /**
@@ -654,6 +1067,195 @@ int hmc_nuts_diag_e_adapt(
       sample_writer, diagnostic_writer, dummy_metric_writer);
 }
 
+/**
+ * Runs multiple chains of HMC with NUTS with a cooperative adaptation
+ * using diagonal Euclidean metric with a pre-specified diagonal metric
+ * and saves adapted tuning parameters stepsize and inverse metric.
+ *
+ * The chains synchronize at the end of each slow adaptation window,
+ * where they share the variance estimated from the draws of all chains
+ * and continue from a common step size; after the warmup every chain
+ * samples with the same adapted step size and metric.  If
+ * `max_warmup_rhat` is positive the warmup stops early, running only
+ * the terminal fast interval, once the split potential scale reduction
+ * of lp__ over a window is below it.
+ *
+ * The chains may be spread over several processes, for instance the
+ * ranks of an MPI communicator with stan::mcmc::mpi_chain_reducer.
+ * Each process calls this function for its own chains, passing the id
+ * of its first chain as `init_chain_id`, and the reducer pools the
+ * adaptation over the chains of all processes.  Each process writes
+ * the output of its own chains.
+ *
+ * @tparam Model Model class
+ * @tparam InitContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitInvContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam SamplerWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @tparam Reducer Type of the reduction over processes
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] num_chains The number of chains to run in parallel. `init`,
+ * `init_inv_metric`, `init_writer`, `sample_writer`, `diagnostic_writer` and
+ * `metric_writer` must be the same length as this value.
+ * @param[in] init A std vector of init var contexts for per-chain
+ * initialization.
+ * @param[in] init_inv_metric A std vector of var contexts exposing an initial
+ * diagonal inverse Euclidean metric for each chain (must be positive definite)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id first chain id. The pseudo random number generator
+ * will advance for each chain by an integer sequence from `init_chain_id` to
+ * `init_chain_id + num_chains - 1`
+ * @param[in] init_radius radius to initialize
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in] max_warmup_rhat potential scale reduction of lp__ below which
+ * the warmup stops early, or zero to run the full warmup
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer std vector of Writer callbacks for unconstrained
+ * inits of each chain.
+ * @param[in,out] sample_writer std vector of Writers for draws of each chain.
+ * @param[in,out] diagnostic_writer std vector of Writers for diagnostic
+ * information of each chain.
+ * @param[in,out] metric_writer std vector of Writers for tuning params
+ * @param[in] reducer reduction over the processes running the chains
+ * @return error_codes::OK if successful
+ */
+template <class Model, typename InitContextPtr, typename InitInvContextPtr,
+          typename InitWriter, typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter, typename Reducer>
+int hmc_nuts_diag_e_adapt(
+    Model& model, size_t num_chains, const std::vector<InitContextPtr>& init,
+    const std::vector<InitInvContextPtr>& init_inv_metric,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    double max_warmup_rhat, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer, const Reducer& reducer) {
+  using sample_t = stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t>;
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_chains);
+  for (size_t i = 0; i < num_chains; ++i)
+    rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
+  std::vector<util::chain_init> chain_inits = util::initialize_chains(
+      model, init, rngs, init_radius, true, num_chains, logger, init_writer);
+  bool all_initialized = true;
+  for (size_t i = 0; i < num_chains; ++i) {
+    if (!chain_inits[i].ok) {
+      logger.error("Chain " + std::to_string(init_chain_id + i)
+                   + " could not be initialized.");
+      all_initialized = false;
+    }
+  }
+  double num_failed = all_initialized ? 0 : 1;
+  reducer.sum(num_failed);
+  if (num_failed > 0)
+    return error_codes::CONFIG;
+  std::vector<std::vector<double>> cont_vectors;
+  cont_vectors.reserve(num_chains);
+  std::vector<sample_t> samplers;
+  samplers.reserve(num_chains);
+  try {
+    for (int i = 0; i < num_chains; ++i) {
+      cont_vectors.emplace_back(std::move(chain_inits[i].cont_vector));
+      samplers.emplace_back(model, rngs[i]);
+      // Start from the evaluated gradient, so initializing the step size
+      // does not evaluate it again
+      samplers[i].seed(
+          Eigen::Map<const Eigen::VectorXd>(cont_vectors[i].data(),
+                                            cont_vectors[i].size()),
+          chain_inits[i].log_prob,
+          Eigen::Map<const Eigen::VectorXd>(chain_inits[i].gradient.data(),
+                                            chain_inits[i].gradient.size()));
+      Eigen::VectorXd inv_metric = util::read_diag_inv_metric(
+          *init_inv_metric[i], model.num_params_r(), logger);
+      util::validate_diag_inv_metric(inv_metric, logger);
+
+      samplers[i].set_metric(inv_metric);
+      samplers[i].set_nominal_stepsize(stepsize);
+      samplers[i].set_stepsize_jitter(stepsize_jitter);
+      samplers[i].set_max_depth(max_depth);
+
+      samplers[i].get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      samplers[i].get_stepsize_adaptation().set_delta(delta);
+      samplers[i].get_stepsize_adaptation().set_gamma(gamma);
+      samplers[i].get_stepsize_adaptation().set_kappa(kappa);
+      samplers[i].get_stepsize_adaptation().set_t0(t0);
+      samplers[i].set_window_params(num_warmup, init_buffer, term_buffer,
+                                    window, logger);
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    num_failed = 1;
+  }
+  reducer.sum(num_failed);
+  if (num_failed > 0)
+    return error_codes::CONFIG;
+  try {
+    util::run_pooled_adaptive_sampler(
+        samplers, model, cont_vectors, num_warmup, num_samples, num_thin,
+        refresh, save_warmup, max_warmup_rhat, rngs, interrupt, logger,
+        sample_writer, diagnostic_writer, metric_writer, init_chain_id,
+        reducer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+/**
+ * Runs multiple chains of HMC with NUTS with a cooperative adaptation
+ * using diagonal Euclidean metric with a pre-specified diagonal metric,
+ * all in this process.  See the overload taking a reducer.
+ */
+template <class Model, typename InitContextPtr, typename InitInvContextPtr,
+          typename InitWriter, typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+int hmc_nuts_diag_e_adapt(
+    Model& model, size_t num_chains, const std::vector<InitContextPtr>& init,
+    const std::vector<InitInvContextPtr>& init_inv_metric,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    double max_warmup_rhat, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer) {
+  return hmc_nuts_diag_e_adapt(
+      model, num_chains, init, init_inv_metric, random_seed, init_chain_id,
+      init_radius, num_warmup, num_samples, num_thin, save_warmup, refresh,
+      stepsize, stepsize_jitter, max_depth, delta, gamma, kappa, t0,
+      init_buffer, term_buffer, window, max_warmup_rhat, interrupt, logger,
+      init_writer, sample_writer, diagnostic_writer, metric_writer,
+      stan::mcmc::local_chain_reducer());
+}
+
 }  // namespace sample
 }  // namespace services
 }  // namespace stan
@@ -0,0 +1,294 @@
+#ifndef STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_PATHFINDER_HPP
+#define STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_PATHFINDER_HPP
+
+#include <stan/analyze/psis.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/pathfinder/single.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/inv_metric.hpp>
+#include <stan/services/util/run_adaptive_sampler.hpp>
+#include <stan/services/util/parallel_chains.hpp>
+#include <boost/random/discrete_distribution.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+namespace internal {
+
+/**
+ * Return the diagonal inverse metric estimated from weighted draws, the
+ * weighted variance of each parameter regularized toward 1e-3 as the
+ * variance adaptation of the samplers does, with the effective sample
+ * size of the weights as the number of draws.
+ *
+ * @param[in] draws draws on the unconstrained scale, one per column
+ * @param[in] weights normalized weight of each draw
+ * @return diagonal of the inverse metric
+ */
+inline Eigen::VectorXd weighted_diag_inv_metric(
+    const Eigen::MatrixXd& draws, const Eigen::VectorXd& weights) {
+  const Eigen::VectorXd mean = draws * weights;
+  const Eigen::VectorXd var
+      = (draws.colwise() - mean).array().square().matrix() * weights;
+  const double n = 1.0 / weights.squaredNorm();
+  return (n / (n + 5.0)) * var.array() + 1e-3 * (5.0 / (n + 5.0));
+}
+
+}  // namespace internal
+
+/**
+ * Runs several chains of HMC with NUTS with adaptation using a diagonal
+ * Euclidean metric, initialized from multi-path Pathfinder.
+ *
+ * Pathfinder is first run from <code>num_paths</code> initial values.
+ * The draws of all of the paths are importance weighted with Pareto
+ * smoothed importance sampling; the initial value of each chain is
+ * resampled from them and the initial diagonal inverse metric of every
+ * chain is the weighted variance of the draws.  As the chains start in
+ * the typical set with a metric close to the adapted one, a warmup of a
+ * few hundred iterations, with short initial and terminal buffers, is
+ * usually enough where the samplers would otherwise need the default
+ * thousand.  Where the Pathfinder approximation is poor the step size and
+ * metric adaptation still correct it, given a long enough warmup.
+ *
+ * The initial value of each chain is written to its init writer; the
+ * draws of Pathfinder are not written.  If the importance weights are not
+ * finite, as when a path could not evaluate the log density of its
+ * draws, the draws are weighted uniformly.
+ *
+ * @tparam Model Model class
+ * @tparam InitContextPtr A pointer with underlying type derived from
+ * `stan::io::var_context`
+ * @tparam InitWriter A type derived from `stan::callbacks::writer`
+ * @tparam SampleWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] num_chains The number of chains to run in parallel.
+ * `init_writer`, `sample_writer`, `diagnostic_writer` and `metric_writer`
+ * must be the same length as this value.
+ * @param[in] init A std vector of init var contexts for the initialization
+ * of each path, of length `num_paths`
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] init_chain_id first chain id. The pseudo random number generator
+ * will advance for each chain by an integer sequence from `init_chain_id` to
+ * `init_chain_id + num_chains - 1`, and for each path from `init_chain_id` to
+ * `init_chain_id + num_paths - 1`
+ * @param[in] init_radius radius to initialize the paths
+ * @param[in] num_paths Number of Pathfinder paths
+ * @param[in] history_size Non-negative value for (J in paper) amount of
+ * history to keep for L-BFGS
+ * @param[in] init_alpha Non-negative value for line search step size to
+ * start with
+ * @param[in] tol_obj Convergence tolerance on absolute changes in the
+ * objective function
+ * @param[in] tol_rel_obj Convergence tolerance on relative changes in the
+ * objective function
+ * @param[in] tol_grad Convergence tolerance on the norm of the gradient
+ * @param[in] tol_rel_grad Convergence tolerance on the relative norm of the
+ * gradient
+ * @param[in] tol_param Convergence tolerance on changes in the L1 norm of
+ * the parameters
+ * @param[in] num_iterations Maximum number of L-BFGS iterations of a path
+ * @param[in] num_elbo_draws Number of draws to evaluate the ELBO
+ * @param[in] num_draws Number of approximate draws of each path
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer std vector of Writer callbacks for unconstrained
+ * inits of each chain.
+ * @param[in,out] sample_writer std vector of Writers for draws of each chain.
+ * @param[in,out] diagnostic_writer std vector of Writers for diagnostic
+ * information of each chain.
+ * @param[in,out] metric_writer std vector of Writers for tuning params
+ * @return error_codes::OK if successful
+ */
+template <class Model, typename InitContextPtr, typename InitWriter,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+int hmc_nuts_diag_e_adapt_pathfinder(
+    Model& model, size_t num_chains, const std::vector<InitContextPtr>& init,
+    unsigned int random_seed, unsigned int init_chain_id, double init_radius,
+    int num_paths, int history_size, double init_alpha, double tol_obj,
+    double tol_rel_obj, double tol_grad, double tol_rel_grad,
+    double tol_param, int num_iterations, int num_elbo_draws, int num_draws,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<InitWriter>& init_writer,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer) {
+  std::vector<Eigen::Array<double, Eigen::Dynamic, 1>> path_lp_ratios(
+      num_paths);
+  std::vector<Eigen::MatrixXd> path_draws(num_paths);
+  try {
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, num_paths), [&](tbb::blocked_range<int> r) {
+          callbacks::writer dummy_init_writer;
+          callbacks::writer dummy_parameter_writer;
+          callbacks::structured_writer dummy_diagnostic_writer;
+          for (int i = r.begin(); i < r.end(); ++i) {
+            auto ret = pathfinder::pathfinder_lbfgs_single<true>(
+                model, *init[i], random_seed, init_chain_id + i, init_radius,
+                history_size, init_alpha, tol_obj, tol_rel_obj, tol_grad,
+                tol_rel_grad, tol_param, num_iterations, num_elbo_draws,
+                num_draws, false, refresh, interrupt, logger,
+                dummy_init_writer, dummy_parameter_writer,
+                dummy_diagnostic_writer, true, 1.0, false);
+            if (std::get<0>(ret) != error_codes::OK) {
+              logger.error("Pathfinder path " + std::to_string(i)
+                           + " failed.");
+              continue;
+            }
+            path_lp_ratios[i] = std::move(std::get<1>(ret));
+            path_draws[i] = std::move(std::get<2>(ret));
+          }
+        });
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+
+  // Gather the unconstrained draws of the paths which succeeded, dropping
+  // lp_approx__ and lp__
+  const Eigen::Index num_params = model.num_params_r();
+  Eigen::Index num_pathfinder_draws = 0;
+  for (const auto& draws : path_draws)
+    num_pathfinder_draws += draws.cols();
+  if (num_pathfinder_draws == 0) {
+    logger.error("No Pathfinder path ran successfully.");
+    return error_codes::SOFTWARE;
+  }
+  Eigen::MatrixXd draws(num_params, num_pathfinder_draws);
+  Eigen::Array<double, Eigen::Dynamic, 1> lp_ratios(num_pathfinder_draws);
+  Eigen::Index offset = 0;
+  for (int i = 0; i < num_paths; ++i) {
+    const Eigen::Index n = path_draws[i].cols();
+    draws.middleCols(offset, n) = path_draws[i].bottomRows(num_params);
+    lp_ratios.segment(offset, n) = path_lp_ratios[i];
+    offset += n;
+  }
+  path_draws.clear();
+
+  Eigen::VectorXd weights;
+  if (lp_ratios.allFinite()) {
+    weights = stan::analyze::psis_weights(
+                  lp_ratios, stan::analyze::psis_tail_length(lp_ratios.size()),
+                  logger)
+                  .matrix();
+    weights /= weights.sum();
+  }
+  if (weights.size() != num_pathfinder_draws || !weights.allFinite()) {
+    logger.warn(
+        "Pathfinder importance weights are not finite; weighting the draws "
+        "uniformly.");
+    weights = Eigen::VectorXd::Constant(num_pathfinder_draws,
+                                        1.0 / num_pathfinder_draws);
+  }
+  const Eigen::VectorXd inv_metric
+      = internal::weighted_diag_inv_metric(draws, weights);
+
+  using sample_t = stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t>;
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_chains);
+  for (size_t i = 0; i < num_chains; ++i)
+    rngs.emplace_back(util::create_rng(random_seed, init_chain_id + i));
+  stan::rng_t resample_rng = util::create_rng(random_seed, init_chain_id);
+  boost::random::discrete_distribution<Eigen::Index, double> resample(
+      weights.data(), weights.data() + weights.size());
+  std::vector<std::vector<double>> cont_vectors;
+  cont_vectors.reserve(num_chains);
+  std::vector<sample_t> samplers;
+  samplers.reserve(num_chains);
+  try {
+    util::validate_diag_inv_metric(inv_metric, logger);
+    std::vector<int> disc_vector;
+    std::vector<double> gradient;
+    for (size_t i = 0; i < num_chains; ++i) {
+      const Eigen::Index draw = resample(resample_rng);
+      cont_vectors.emplace_back(draws.col(draw).data(),
+                                draws.col(draw).data() + num_params);
+      double log_prob;
+      if (!util::internal::evaluate_init<true>(model, cont_vectors[i],
+                                               disc_vector, false, log_prob,
+                                               gradient, logger)) {
+        logger.error("Chain " + std::to_string(init_chain_id + i)
+                     + " could not be initialized.");
+        return error_codes::CONFIG;
+      }
+      init_writer[i](cont_vectors[i]);
+      samplers.emplace_back(model, rngs[i]);
+      samplers[i].seed(
+          Eigen::Map<const Eigen::VectorXd>(cont_vectors[i].data(),
+                                            cont_vectors[i].size()),
+          log_prob,
+          Eigen::Map<const Eigen::VectorXd>(gradient.data(), gradient.size()));
+      samplers[i].set_metric(inv_metric);
+      samplers[i].set_nominal_stepsize(stepsize);
+      samplers[i].set_stepsize_jitter(stepsize_jitter);
+      samplers[i].set_max_depth(max_depth);
+
+      samplers[i].get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      samplers[i].get_stepsize_adaptation().set_delta(delta);
+      samplers[i].get_stepsize_adaptation().set_gamma(gamma);
+      samplers[i].get_stepsize_adaptation().set_kappa(kappa);
+      samplers[i].get_stepsize_adaptation().set_t0(t0);
+      samplers[i].set_window_params(num_warmup, init_buffer, term_buffer,
+                                    window, logger);
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+  try {
+    util::parallel_chains(
+        num_chains, interrupt,
+        [&](size_t i, callbacks::interrupt& chain_interrupt) {
+          util::run_adaptive_sampler(
+              samplers[i], model, cont_vectors[i], num_warmup, num_samples,
+              num_thin, refresh, save_warmup, rngs[i], chain_interrupt, logger,
+              sample_writer[i], diagnostic_writer[i], metric_writer[i],
+              init_chain_id + i, num_chains);
+        });
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,169 @@
+#ifndef STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_TEMPERING_HPP
+#define STAN_SERVICES_SAMPLE_HMC_NUTS_DIAG_E_ADAPT_TEMPERING_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/mcmc/replica_exchange.hpp>
+#include <stan/mcmc/smc/tempered_model.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/inv_metric.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/run_adaptive_tempering_sampler.hpp>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+
+/**
+ * Runs parallel tempering with HMC with NUTS with adaptation using
+ * diagonal Euclidean metric, for posteriors with several modes that
+ * independent chains rarely move between.
+ *
+ * One replica runs for every inverse temperature of the ladder, each
+ * with the transitions of `stan::mcmc::adapt_diag_e_nuts` targeting
+ * the tempered density of `stan::mcmc::tempered_model`, between a
+ * normal reference with mean zero and standard deviation `init_radius`
+ * at inverse temperature 0 and the posterior at 1.  The replicas make
+ * their transitions in parallel, in lockstep, and every `swap_every`
+ * iterations neighbouring replicas propose to exchange their states as
+ * in `stan::mcmc::replica_exchange`, so that the hot replicas, which
+ * move between modes freely, carry their states down to the posterior.
+ * Each replica adapts its own step size and metric during warmup.
+ *
+ * Only the replica at inverse temperature 1 is written: its draws,
+ * diagnostics and adapted tuning parameters have the same layout as
+ * those of `hmc_nuts_diag_e_adapt`.  The swap rates between the
+ * replicas during sampling are logged; rates near zero call for more
+ * closely spaced inverse temperatures.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] init var context for initialization
+ * @param[in] init_inv_metric var context exposing an initial diagonal
+ *              inverse Euclidean metric (must be positive definite)
+ * @param[in] inverse_temperatures ladder of inverse temperatures of
+ *   the replicas, decreasing strictly from 1 to no less than 0
+ * @param[in] swap_every number of iterations between rounds of swaps
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id to advance the pseudo random number
+ *   generator. The replicas and the swaps use substreams of the chain.
+ * @param[in] init_radius radius to initialize, and standard deviation
+ *   of the reference density; must be positive
+ * @param[in] num_warmup Number of warmup samples
+ * @param[in] num_samples Number of samples
+ * @param[in] num_thin Number to thin the samples
+ * @param[in] save_warmup Indicates whether to save the warmup iterations
+ * @param[in] refresh Controls the output
+ * @param[in] stepsize initial stepsize for discrete evolution
+ * @param[in] stepsize_jitter uniform random jitter of stepsize
+ * @param[in] max_depth Maximum tree depth
+ * @param[in] delta adaptation target acceptance statistic
+ * @param[in] gamma adaptation regularization scale
+ * @param[in] kappa adaptation relaxation exponent
+ * @param[in] t0 adaptation iteration offset
+ * @param[in] init_buffer width of initial fast adaptation interval
+ * @param[in] term_buffer width of final fast adaptation interval
+ * @param[in] window initial width of slow adaptation interval
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] init_writer Writer callback for unconstrained inits of
+ *   the replica at inverse temperature 1
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for diagnostic information
+ * @param[in,out] metric_writer Writer for tuning params
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int hmc_nuts_diag_e_adapt_tempering(
+    Model& model, const stan::io::var_context& init,
+    const stan::io::var_context& init_inv_metric,
+    const std::vector<double>& inverse_temperatures, int swap_every,
+    unsigned int random_seed, unsigned int chain, double init_radius,
+    int num_warmup, int num_samples, int num_thin, bool save_warmup,
+    int refresh, double stepsize, double stepsize_jitter, int max_depth,
+    double delta, double gamma, double kappa, double t0,
+    unsigned int init_buffer, unsigned int term_buffer, unsigned int window,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    callbacks::writer& init_writer, callbacks::writer& sample_writer,
+    callbacks::writer& diagnostic_writer,
+    callbacks::structured_writer& metric_writer) {
+  if (!stan::mcmc::replica_exchange::is_valid_ladder(inverse_temperatures)
+      || swap_every < 1 || !(init_radius > 0)) {
+    logger.error(
+        "Parallel tempering requires inverse temperatures decreasing "
+        "strictly from 1 to no less than 0, a positive swap interval and "
+        "a positive init radius.");
+    return error_codes::CONFIG;
+  }
+  using tempered_t = stan::mcmc::tempered_model<Model>;
+  using sampler_t = stan::mcmc::adapt_diag_e_nuts<tempered_t, stan::rng_t>;
+  const size_t num_replicas = inverse_temperatures.size();
+
+  stan::mcmc::replica_exchange exchange(inverse_temperatures);
+  stan::rng_t swap_rng = util::create_rng(random_seed, chain, 0);
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(num_replicas);
+  std::vector<tempered_t> tempered;
+  tempered.reserve(num_replicas);
+  std::vector<sampler_t> samplers;
+  samplers.reserve(num_replicas);
+  std::vector<std::vector<double>> cont_vectors;
+  cont_vectors.reserve(num_replicas);
+  try {
+    Eigen::VectorXd inv_metric = util::read_diag_inv_metric(
+        init_inv_metric, model.num_params_r(), logger);
+    util::validate_diag_inv_metric(inv_metric, logger);
+    callbacks::writer dummy_init_writer;
+    for (size_t k = 0; k < num_replicas; ++k) {
+      // The first replica draws as the chain would without tempering
+      rngs.emplace_back(k == 0 ? util::create_rng(random_seed, chain)
+                               : util::create_rng(random_seed, chain, k));
+      cont_vectors.emplace_back(util::initialize(
+          model, init, rngs[k], init_radius, k == 0, logger,
+          k == 0 ? init_writer : dummy_init_writer));
+      tempered.emplace_back(model, init_radius);
+      tempered[k].set_beta(inverse_temperatures[k]);
+      samplers.emplace_back(tempered[k], rngs[k]);
+
+      samplers[k].set_metric(inv_metric);
+      samplers[k].set_nominal_stepsize(stepsize);
+      samplers[k].set_stepsize_jitter(stepsize_jitter);
+      samplers[k].set_max_depth(max_depth);
+
+      samplers[k].get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      samplers[k].get_stepsize_adaptation().set_delta(delta);
+      samplers[k].get_stepsize_adaptation().set_gamma(gamma);
+      samplers[k].get_stepsize_adaptation().set_kappa(kappa);
+      samplers[k].get_stepsize_adaptation().set_t0(t0);
+      samplers[k].set_window_params(num_warmup, init_buffer, term_buffer,
+                                    window, logger);
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::CONFIG;
+  }
+
+  try {
+    util::run_adaptive_tempering_sampler(
+        samplers, tempered, exchange, swap_every, model, cont_vectors,
+        num_warmup, num_samples, num_thin, refresh, save_warmup, rngs,
+        swap_rng, interrupt, logger, sample_writer, diagnostic_writer,
+        metric_writer);
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
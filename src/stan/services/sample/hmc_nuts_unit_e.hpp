@@ -11,6 +11,7 @@
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/initialize.hpp>
 #include <stan/services/util/run_sampler.hpp>
+#include <stan/services/util/parallel_chains.hpp>
 #include <vector>
 
 namespace stan {
@@ -160,21 +161,15 @@ int hmc_nuts_unit_e(Model& model, size_t num_chains,
     return error_codes::CONFIG;
   }
   try {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, num_chains, 1),
-        [num_warmup, num_samples, num_thin, refresh, save_warmup, num_chains,
-         init_chain_id, &samplers, &model, &rngs, &interrupt, &logger,
-         &sample_writer, &cont_vectors,
-         &diagnostic_writer](const tbb::blocked_range<size_t>& r) {
-          for (size_t i = r.begin(); i != r.end(); ++i) {
-            util::run_sampler(samplers[i], model, cont_vectors[i], num_warmup,
-                              num_samples, num_thin, refresh, save_warmup,
-                              rngs[i], interrupt, logger, sample_writer[i],
-                              diagnostic_writer[i], init_chain_id + i,
-                              num_chains);
-          }
-        },
-        tbb::simple_partitioner());
+    util::parallel_chains(
+        num_chains, interrupt,
+        [&](size_t i, callbacks::interrupt& chain_interrupt) {
+          util::run_sampler(samplers[i], model, cont_vectors[i], num_warmup,
+                            num_samples, num_thin, refresh, save_warmup,
+                            rngs[i], chain_interrupt, logger, sample_writer[i],
+                            diagnostic_writer[i], init_chain_id + i,
+                            num_chains);
+        });
   } catch (const std::exception& e) {
     logger.error(e.what());
     return error_codes::SOFTWARE;
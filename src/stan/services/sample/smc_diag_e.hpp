@@ -0,0 +1,239 @@
+#ifndef STAN_SERVICES_SAMPLE_SMC_DIAG_E_HPP
+#define STAN_SERVICES_SAMPLE_SMC_DIAG_E_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/mcmc/hmc/static/diag_e_static_hmc.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/smc/tempered_model.hpp>
+#include <stan/mcmc/smc/tempering.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace sample {
+
+/**
+ * Runs sequential Monte Carlo with tempering, moving particles from a
+ * normal reference density on the unconstrained scale to the posterior
+ * along the geometric path of `stan::mcmc::tempered_model`, and
+ * estimates the log marginal likelihood of the model.
+ *
+ * The particles start as independent draws from the reference, normal
+ * with mean zero and standard deviation `init_radius`.  At every stage:
+ * <ul>
+ * <li>the next inverse temperature is the largest one at which the
+ * importance weights of the particles leave an effective sample size
+ * of `ess_fraction` times the number of particles;</li>
+ * <li>the mean of the weights updates the log marginal likelihood, and
+ * the particles are resampled systematically;</li>
+ * <li>every particle makes `num_mutations` transitions of static HMC
+ * with a diagonal metric (`stan::mcmc::diag_e_static_hmc`) targeting
+ * the new tempered density, with the variance of the particles as the
+ * inverse metric.</li>
+ * </ul>
+ * The step size of the next stage is scaled up when the mean acceptance
+ * statistic of the mutations exceeds `delta` and down otherwise.  The
+ * resampling and the mutations run in parallel across particles, each
+ * particle with its own random number generator, so the output does not
+ * depend on the number of threads.
+ *
+ * The log density of the model includes its constants for the weights,
+ * so the estimate is of the marginal likelihood of the full model; it
+ * is logged and written with the schedule of the stages to the
+ * diagnostic writer.  The particles of the last stage are written to
+ * the sample writer as draws of the posterior.
+ *
+ * @tparam Model Model class
+ * @param[in] model Input model (with data already instantiated)
+ * @param[in] random_seed random seed for the random number generator
+ * @param[in] chain chain id. The particles use the pseudo random number
+ * generators of chains `chain + 1` to `chain + num_particles`.
+ * @param[in] init_radius standard deviation of the reference density
+ * @param[in] num_particles number of particles, at least two
+ * @param[in] ess_fraction fraction of the particles the effective sample
+ * size is kept at between stages, in (0, 1)
+ * @param[in] num_mutations number of HMC transitions of every particle
+ * per stage
+ * @param[in] stepsize initial step size of the HMC transitions
+ * @param[in] int_time integration time of the HMC transitions
+ * @param[in] delta target acceptance statistic of the HMC transitions
+ * @param[in] max_num_stages maximum number of stages
+ * @param[in] refresh Controls the output
+ * @param[in,out] interrupt Callback for interrupts
+ * @param[in,out] logger Logger for messages
+ * @param[in,out] sample_writer Writer for draws
+ * @param[in,out] diagnostic_writer Writer for the stages
+ * @return error_codes::OK if successful
+ */
+template <class Model>
+int smc_diag_e(Model& model, unsigned int random_seed, unsigned int chain,
+               double init_radius, int num_particles, double ess_fraction,
+               int num_mutations, double stepsize, double int_time,
+               double delta, int max_num_stages, int refresh,
+               callbacks::interrupt& interrupt, callbacks::logger& logger,
+               callbacks::writer& sample_writer,
+               callbacks::writer& diagnostic_writer) {
+  if (num_particles < 2 || !(ess_fraction > 0 && ess_fraction < 1)
+      || !(init_radius > 0) || num_mutations < 1 || !(stepsize > 0)
+      || !(int_time > 0) || max_num_stages < 1) {
+    logger.error(
+        "Sequential Monte Carlo requires at least two particles, an "
+        "ESS fraction in (0, 1), a positive init radius, step size and "
+        "integration time, and at least one mutation and one stage.");
+    return error_codes::CONFIG;
+  }
+  using tempered_t = stan::mcmc::tempered_model<Model>;
+  using sampler_t = stan::mcmc::diag_e_static_hmc<tempered_t, stan::rng_t>;
+  const size_t N = num_particles;
+  const Eigen::Index num_params = model.num_params_r();
+
+  tempered_t tempered(model, init_radius);
+  stan::rng_t rng = util::create_rng(random_seed, chain);
+  boost::uniform_01<stan::rng_t&> uniform(rng);
+  std::vector<stan::rng_t> rngs;
+  rngs.reserve(N);
+  std::vector<sampler_t> samplers;
+  samplers.reserve(N);
+  for (size_t i = 0; i < N; ++i) {
+    rngs.emplace_back(util::create_rng(random_seed, chain + 1 + i));
+    samplers.emplace_back(tempered, rngs[i]);
+  }
+
+  Eigen::MatrixXd particles(num_params, N);
+  Eigen::MatrixXd resampled(num_params, N);
+  Eigen::VectorXd log_ratio(N);
+  Eigen::VectorXd resampled_log_ratio(N);
+  Eigen::VectorXd log_prob(N);
+  Eigen::VectorXd accept_stat(N);
+  Eigen::VectorXd last_accept_stat(N);
+  std::vector<Eigen::Index> ancestors;
+  Eigen::VectorXd inv_metric(num_params);
+
+  auto parallel = [N](auto&& f) {
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, N),
+                      [&](const tbb::blocked_range<size_t>& r) {
+                        for (size_t i = r.begin(); i < r.end(); ++i)
+                          f(i);
+                      });
+  };
+
+  double beta = 0;
+  double log_marginal = 0;
+  std::vector<std::string> names{"stage__",    "beta__",   "ess__",
+                                 "log_marg__", "accept__", "stepsize__"};
+  diagnostic_writer(names);
+  try {
+    parallel([&](size_t i) {
+      Eigen::VectorXd q;
+      tempered.sample_reference(rngs[i], q);
+      particles.col(i) = q;
+      log_ratio(i) = tempered.log_density_ratio(q);
+    });
+
+    for (int stage = 1; beta < 1; ++stage) {
+      if (stage > max_num_stages) {
+        logger.error("Sequential Monte Carlo did not reach the posterior in "
+                     + std::to_string(max_num_stages) + " stages.");
+        return error_codes::SOFTWARE;
+      }
+      interrupt();
+
+      // Reweight at the next temperature and resample
+      const double next
+          = stan::mcmc::next_temperature(log_ratio, beta, ess_fraction * N);
+      const Eigen::VectorXd log_weights = (next - beta) * log_ratio;
+      const double ess = stan::mcmc::effective_sample_size(log_weights);
+      if (!(ess > 0)) {
+        logger.error("Sequential Monte Carlo: every particle has zero "
+                     "weight.");
+        return error_codes::SOFTWARE;
+      }
+      log_marginal += stan::mcmc::log_mean_exp(log_weights);
+      stan::mcmc::systematic_resample(log_weights, uniform(), ancestors);
+      parallel([&](size_t i) {
+        resampled.col(i) = particles.col(ancestors[i]);
+        resampled_log_ratio(i) = log_ratio(ancestors[i]);
+      });
+      particles.swap(resampled);
+      log_ratio.swap(resampled_log_ratio);
+      beta = next;
+      tempered.set_beta(beta);
+
+      // Regularized variance of the particles as the inverse metric
+      const Eigen::VectorXd mean = particles.rowwise().mean();
+      inv_metric = (particles.colwise() - mean).rowwise().squaredNorm()
+                   / (N - 1.0);
+      inv_metric = (N / (N + 5.0)) * inv_metric.array()
+                   + 1e-3 * (5.0 / (N + 5.0));
+      if (!inv_metric.allFinite())
+        inv_metric.setOnes();
+
+      // Mutate the particles with HMC at the new temperature
+      parallel([&](size_t i) {
+        sampler_t& sampler = samplers[i];
+        // Clears the gradients cached at the previous temperature
+        sampler.set_gradient_cache(true);
+        sampler.set_metric(inv_metric);
+        sampler.set_nominal_stepsize_and_T(stepsize, int_time);
+        stan::mcmc::sample s(particles.col(i), 0, 0);
+        double sum_accept = 0;
+        for (int m = 0; m < num_mutations; ++m) {
+          s = sampler.transition(s, logger);
+          sum_accept += s.accept_stat();
+        }
+        Eigen::VectorXd q = s.cont_params();
+        particles.col(i) = q;
+        log_prob(i) = s.log_prob();
+        accept_stat(i) = sum_accept / num_mutations;
+        last_accept_stat(i) = s.accept_stat();
+        log_ratio(i) = tempered.log_density_ratio(q);
+      });
+
+      const double mean_accept = accept_stat.mean();
+      diagnostic_writer(std::vector<double>{static_cast<double>(stage), beta,
+                                            ess, log_marginal, mean_accept,
+                                            stepsize});
+      if (refresh > 0 && (stage == 1 || beta == 1 || stage % refresh == 0)) {
+        std::stringstream message;
+        message << "Stage: " << stage << "  beta = " << beta
+                << "  ESS = " << ess << "  log marginal = " << log_marginal;
+        logger.info(message);
+      }
+      stepsize *= std::exp(mean_accept - delta);
+    }
+
+    std::stringstream message;
+    message << "Log marginal likelihood estimate: " << log_marginal;
+    logger.info(message);
+
+    util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+    for (size_t i = 0; i < N; ++i) {
+      stan::mcmc::sample s(particles.col(i), log_prob(i),
+                           last_accept_stat(i));
+      if (i == 0)
+        writer.write_sample_names(s, samplers[0], model);
+      writer.write_sample_params(rngs[i], s, samplers[i], model);
+    }
+  } catch (const std::exception& e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+}  // namespace sample
+}  // namespace services
+}  // namespace stan
+#endif
@@ -5,10 +5,18 @@
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/array_var_context.hpp>
+#include <stan/io/draws_chunk_reader.hpp>
 #include <stan/math/prim.hpp>
+#include <stan/model/model_metadata.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/services/util/gq_writer.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -119,11 +127,10 @@ int standalone_generate(const Model &model, const int num_chains,
                                sample_writers[0]);
   }
 
-  std::vector<std::string> p_names;
-  model.constrained_param_names(p_names, false, false);
-  std::vector<std::string> gq_names;
-  model.constrained_param_names(gq_names, false, true);
-  if (!(p_names.size() < gq_names.size())) {
+  // The names are built once for the headers of all chains
+  const stan::model::model_metadata metadata(model);
+  const size_t num_params = metadata.num_constrained_params(false, false);
+  if (!(num_params < metadata.num_constrained_params(false, true))) {
     logger.error("Model doesn't generate any quantities of interest.");
     return error_codes::CONFIG;
   }
@@ -136,18 +143,18 @@ int standalone_generate(const Model &model, const int num_chains,
       logger.error("Empty set of draws from fitted model.");
       return error_codes::DATAERR;
     }
-    if (p_names.size() != draws[i].cols()) {
+    if (num_params != draws[i].cols()) {
       std::stringstream msg;
       msg << "Wrong number of parameter values in draws from fitted model.  ";
-      msg << "Expecting " << p_names.size() << " columns, ";
+      msg << "Expecting " << num_params << " columns, ";
       msg << "found " << draws[i].cols() << " columns in draws from chain " << i
           << ".";
       std::string msgstr = msg.str();
       logger.error(msgstr);
       return error_codes::DATAERR;
     }
-    writers.emplace_back(sample_writers[i], logger, p_names.size());
-    writers[i].write_gq_names(model);
+    writers.emplace_back(sample_writers[i], logger, num_params);
+    writers[i].write_gq_names(metadata);
     rngs.emplace_back(util::create_rng(seed, i + 1));
   }
   bool error_any = false;
@@ -188,6 +195,373 @@ int standalone_generate(const Model &model, const int num_chains,
   return error_any ? error_codes::DATAERR : error_codes::OK;
 }
 
+namespace internal {
+
+/**
+ * The generated quantities of one draw, with the messages logged while
+ * generating them, kept until the draws before it are written.
+ */
+struct gq_draw {
+  std::vector<double> values;
+  std::vector<std::string> info;
+  std::vector<std::string> errors;
+  int return_code = error_codes::OK;
+};
+
+/**
+ * Buffers reused by a thread for the draws it generates.
+ */
+struct gq_buffers {
+  std::vector<double> row;
+  std::vector<double> unconstrained_params_r;
+  std::vector<int> params_i;
+  std::vector<double> values;
+};
+
+/**
+ * Generate the quantities of interest of a draw as
+ * <code>util::gq_writer::write_gq_values</code> does, keeping the
+ * values and messages in the specified result instead of writing them.
+ *
+ * @tparam Model model class
+ * @tparam RNG pseudo random number generator class
+ * @tparam Row type of the draw
+ * @param[in] model instantiated model
+ * @param[in, out] rng pseudo random number generator
+ * @param[in] draw constrained parameter values
+ * @param[in] num_params number of constrained parameters
+ * @param[in, out] buffers buffers of the calling thread
+ * @param[out] result values, messages and return code of the draw
+ */
+template <class Model, class RNG, typename Row>
+void generate_gq_draw(const Model &model, RNG &rng, const Row &draw,
+                      size_t num_params, gq_buffers &buffers,
+                      gq_draw &result) {
+  result.info.clear();
+  result.errors.clear();
+  result.return_code = error_codes::OK;
+  buffers.row.resize(draw.size());
+  Eigen::Map<Eigen::RowVectorXd>(buffers.row.data(), draw.size()) = draw;
+  std::stringstream msg;
+  try {
+    model.unconstrain_array(buffers.row, buffers.unconstrained_params_r, &msg);
+  } catch (const std::exception &e) {
+    if (msg.str().length() > 0)
+      result.errors.push_back(msg.str());
+    result.errors.push_back(e.what());
+    result.return_code = error_codes::DATAERR;
+    return;
+  }
+  std::stringstream ss;
+  try {
+    model.write_array(rng, buffers.unconstrained_params_r, buffers.params_i,
+                      buffers.values, false, true, &ss);
+    if (ss.str().length() > 0)
+      result.info.push_back(ss.str());
+  } catch (const std::domain_error &e) {
+    if (ss.str().length() > 0)
+      result.info.push_back(ss.str());
+    result.info.push_back(e.what());
+  } catch (const std::exception &e) {
+    if (ss.str().length() > 0)
+      result.info.push_back(ss.str());
+    result.info.push_back(e.what());
+    result.errors.push_back(e.what());
+    result.return_code = error_codes::SOFTWARE;
+    return;
+  }
+  result.values.assign(buffers.values.begin() + num_params,
+                       buffers.values.end());
+}
+
+/**
+ * Generate the quantities of interest of a set of draws in parallel, by
+ * blocks of draws sharing a pseudo random number generator created from
+ * the seed and the index of the block, keeping the results of the
+ * draws in the specified vector.  The draws of a block after one that
+ * fails are not generated.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in] draws draws of constrained parameters, one per row
+ * @param[in] first_block index of the block of the first draw in the
+ * whole set of draws
+ * @param[in] block_size number of draws per block
+ * @param[in] seed seed to use for randomization
+ * @param[in] num_params number of constrained parameters
+ * @param[in, out] buffers buffers of the threads
+ * @param[out] results results of the draws, at least one per draw
+ */
+template <class Model>
+void generate_gq_blocks(
+    const Model &model, const Eigen::Ref<const Eigen::MatrixXd> &draws,
+    size_t first_block, size_t block_size, unsigned int seed,
+    size_t num_params, tbb::enumerable_thread_specific<gq_buffers> &buffers,
+    std::vector<gq_draw> &results) {
+  const size_t num_draws = draws.rows();
+  const size_t num_blocks = (num_draws + block_size - 1) / block_size;
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_blocks, 1),
+      [&](const tbb::blocked_range<size_t> &r) {
+        gq_buffers &thread_buffers = buffers.local();
+        for (size_t block = r.begin(); block != r.end(); ++block) {
+          stan::rng_t rng = util::create_rng(seed, first_block + block + 1);
+          const size_t end = std::min(num_draws, (block + 1) * block_size);
+          for (size_t i = block * block_size; i < end; ++i) {
+            gq_draw &result = results[i];
+            generate_gq_draw(model, rng, draws.row(i), num_params,
+                             thread_buffers, result);
+            // Draws after an error are never written
+            if (result.return_code != error_codes::OK)
+              break;
+          }
+        }
+      },
+      tbb::simple_partitioner());
+}
+
+/**
+ * Write the values of the first draws of the specified results, in
+ * order, calling the interrupt and logging their messages, up to the
+ * first draw that failed.
+ *
+ * @param[in] results results of the draws
+ * @param[in] num_draws number of draws to write
+ * @param[in, out] interrupt called every draw
+ * @param[in, out] logger logger to which to write messages
+ * @param[in, out] sample_writer writer to which values are written
+ * @return error code of the first draw that failed, or OK
+ */
+inline int write_gq_results(const std::vector<gq_draw> &results,
+                            size_t num_draws, callbacks::interrupt &interrupt,
+                            callbacks::logger &logger,
+                            callbacks::writer &sample_writer) {
+  for (size_t i = 0; i < num_draws; ++i) {
+    const gq_draw &result = results[i];
+    if (result.return_code == error_codes::DATAERR) {
+      for (const auto &error : result.errors)
+        logger.error(error);
+      return error_codes::DATAERR;
+    }
+    interrupt();  // call out to interrupt and fail
+    for (const auto &info : result.info)
+      logger.info(info);
+    if (result.return_code != error_codes::OK) {
+      for (const auto &error : result.errors)
+        logger.error(error);
+      return result.return_code;
+    }
+    sample_writer(result.values);
+  }
+  return error_codes::OK;
+}
+
+}  // namespace internal
+
+/**
+ * Given a set of draws from a fitted model, generate corresponding
+ * quantities of interest in parallel and write them to the callback
+ * writer in the order of the draws.
+ * Matrix of draws consists of one row per draw, one column per parameter.
+ * Return code indicates success or type of error.
+ *
+ * <p>The draws are split into blocks of <code>block_size</code> draws
+ * which are generated in parallel, each with its own pseudo random
+ * number generator created from the seed and the index of the block,
+ * so the output does not depend on the number of threads.  Each thread
+ * reuses its buffers across draws.  A bounded window of blocks is
+ * generated before their values are written, in order, by the calling
+ * thread, which also calls the interrupt and logger.
+ *
+ * <p>With one block, the output matches that of
+ * <code>standalone_generate</code> with the same seed.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in] draws sequence of draws of constrained parameters
+ * @param[in] seed seed to use for randomization
+ * @param[in] block_size number of draws per block sharing a generator
+ * @param[in, out] interrupt called every iteration
+ * @param[in, out] logger logger to which to write warning and error messages
+ * @param[in, out] sample_writer writer to which draws are written
+ * @return error code
+ */
+template <class Model>
+int standalone_generate_parallel(const Model &model,
+                                 const Eigen::MatrixXd &draws,
+                                 unsigned int seed, size_t block_size,
+                                 callbacks::interrupt &interrupt,
+                                 callbacks::logger &logger,
+                                 callbacks::writer &sample_writer) {
+  if (draws.size() == 0) {
+    logger.error("Empty set of draws from fitted model.");
+    return error_codes::DATAERR;
+  }
+
+  std::vector<std::string> p_names;
+  model.constrained_param_names(p_names, false, false);
+  std::vector<std::string> gq_names;
+  model.constrained_param_names(gq_names, false, true);
+  if (!(p_names.size() < gq_names.size())) {
+    logger.error("Model doesn't generate any quantities of interest.");
+    return error_codes::CONFIG;
+  }
+
+  if (p_names.size() != draws.cols()) {
+    std::stringstream msg;
+    msg << "Wrong number of parameter values in draws from fitted model.  ";
+    msg << "Expecting " << p_names.size() << " columns, ";
+    msg << "found " << draws.cols() << " columns.";
+    std::string msgstr = msg.str();
+    logger.error(msgstr);
+    return error_codes::DATAERR;
+  }
+  util::gq_writer writer(sample_writer, logger, p_names.size());
+  writer.write_gq_names(model);
+
+  block_size = std::max<size_t>(block_size, 1);
+  const size_t num_draws = draws.rows();
+  const size_t num_blocks = (num_draws + block_size - 1) / block_size;
+  const size_t window = std::min<size_t>(
+      num_blocks, 4 * std::max(tbb::this_task_arena::max_concurrency(), 1));
+  tbb::enumerable_thread_specific<internal::gq_buffers> buffers;
+  std::vector<internal::gq_draw> results(window * block_size);
+  try {
+    for (size_t first = 0; first < num_blocks; first += window) {
+      const size_t last = std::min(num_blocks, first + window);
+      const size_t offset = first * block_size;
+      const size_t end = std::min(num_draws, last * block_size);
+      internal::generate_gq_blocks(
+          model, draws.middleRows(offset, end - offset), first, block_size,
+          seed, p_names.size(), buffers, results);
+      int return_code = internal::write_gq_results(
+          results, end - offset, interrupt, logger, sample_writer);
+      if (return_code != error_codes::OK)
+        return return_code;
+    }
+  } catch (const std::exception &e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
+/**
+ * Given draws from a fitted model read a chunk at a time from the
+ * specified reader, generate corresponding quantities of interest in
+ * parallel and write them to the callback writer in the order of the
+ * draws, holding at most two chunks of draws in memory whatever the
+ * number of draws.  The reader must select the constrained parameters
+ * of the model, in the order of <code>constrained_param_names</code>.
+ * Return code indicates success or type of error.
+ *
+ * <p>Reading, generating and writing overlap: while the draws of one
+ * chunk are generated in parallel, the calling thread reads the next
+ * chunk, then writes the values of the first chunk, in order, calling
+ * the interrupt and logger.  The chunk size is rounded up to a
+ * multiple of <code>block_size</code> and the generators are created
+ * from the seed and the index of the block in the whole set of draws,
+ * so the output matches that of
+ * <code>standalone_generate_parallel</code> with the same seed and
+ * block size.  An error reading the draws is logged after the values
+ * of the draws before it are written.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in, out] reader source of the draws of constrained parameters
+ * @param[in] seed seed to use for randomization
+ * @param[in] block_size number of draws per block sharing a generator
+ * @param[in] chunk_size number of draws read at a time
+ * @param[in, out] interrupt called every iteration
+ * @param[in, out] logger logger to which to write warning and error messages
+ * @param[in, out] sample_writer writer to which draws are written
+ * @return error code
+ */
+template <class Model>
+int standalone_generate_streaming(const Model &model,
+                                  io::draws_chunk_reader &reader,
+                                  unsigned int seed, size_t block_size,
+                                  size_t chunk_size,
+                                  callbacks::interrupt &interrupt,
+                                  callbacks::logger &logger,
+                                  callbacks::writer &sample_writer) {
+  std::vector<std::string> p_names;
+  model.constrained_param_names(p_names, false, false);
+  std::vector<std::string> gq_names;
+  model.constrained_param_names(gq_names, false, true);
+  if (!(p_names.size() < gq_names.size())) {
+    logger.error("Model doesn't generate any quantities of interest.");
+    return error_codes::CONFIG;
+  }
+
+  if (p_names.size() != reader.num_columns()) {
+    std::stringstream msg;
+    msg << "Wrong number of parameter values in draws from fitted model.  ";
+    msg << "Expecting " << p_names.size() << " columns, ";
+    msg << "found " << reader.num_columns() << " columns.";
+    std::string msgstr = msg.str();
+    logger.error(msgstr);
+    return error_codes::DATAERR;
+  }
+
+  block_size = std::max<size_t>(block_size, 1);
+  chunk_size = (std::max(chunk_size, block_size) + block_size - 1)
+               / block_size * block_size;
+  Eigen::MatrixXd chunk;
+  Eigen::MatrixXd next_chunk;
+  size_t rows = 0;
+  try {
+    rows = reader.read(chunk, chunk_size);
+  } catch (const std::exception &e) {
+    logger.error(e.what());
+    return error_codes::DATAERR;
+  }
+  if (rows == 0) {
+    logger.error("Empty set of draws from fitted model.");
+    return error_codes::DATAERR;
+  }
+  util::gq_writer writer(sample_writer, logger, p_names.size());
+  writer.write_gq_names(model);
+
+  tbb::enumerable_thread_specific<internal::gq_buffers> buffers;
+  std::vector<internal::gq_draw> results(chunk_size);
+  size_t first_block = 0;
+  std::string read_error;
+  try {
+    while (rows > 0) {
+      tbb::task_group generating;
+      generating.run([&]() {
+        internal::generate_gq_blocks(model, chunk.topRows(rows), first_block,
+                                     block_size, seed, p_names.size(),
+                                     buffers, results);
+      });
+      size_t next_rows = 0;
+      try {
+        next_rows = reader.read(next_chunk, chunk_size);
+      } catch (const std::exception &e) {
+        read_error = e.what();
+      }
+      generating.wait();
+
+      int return_code = internal::write_gq_results(results, rows, interrupt,
+                                                   logger, sample_writer);
+      if (return_code != error_codes::OK)
+        return return_code;
+      if (!read_error.empty()) {
+        logger.error(read_error);
+        return error_codes::DATAERR;
+      }
+      first_block += (rows + block_size - 1) / block_size;
+      chunk.swap(next_chunk);
+      rows = next_rows;
+    }
+  } catch (const std::exception &e) {
+    logger.error(e.what());
+    return error_codes::SOFTWARE;
+  }
+  return error_codes::OK;
+}
+
 /**
  * DEPRECATED: This function assumes dimensions are rectangular,
  * a restriction which the Stan language may soon relax.
@@ -0,0 +1,222 @@
+#ifndef STAN_SERVICES_TRANSFORM_TRANSFORM_DRAWS_HPP
+#define STAN_SERVICES_TRANSFORM_TRANSFORM_DRAWS_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace transform {
+
+namespace internal {
+
+/**
+ * Buffers reused by a thread for the draws it transforms.
+ */
+struct transform_buffers {
+  Eigen::VectorXd in;
+  Eigen::VectorXd out;
+};
+
+/**
+ * Outcome of transforming one block of draws: the messages the model
+ * printed and, if a draw failed, the first failing draw and its error.
+ */
+struct transform_block {
+  std::string messages;
+  size_t failed_draw = 0;
+  std::string error;
+  int return_code = error_codes::OK;
+};
+
+/**
+ * Apply the specified function to every draw, by blocks of the
+ * specified number of draws processed in parallel, then log the
+ * messages and the first error in the order of the draws.
+ *
+ * @tparam F type of the function
+ * @param[in] num_draws number of draws
+ * @param[in] block_size number of draws per block
+ * @param[in] f function called with the index of a block, the index of
+ * a draw, the buffers of the thread and the message stream of the
+ * block, and throwing on failure
+ * @param[in, out] logger logger to which to write messages
+ * @param[in] what description of the transform, for the errors
+ * @return error code of the first failing draw, or OK
+ */
+template <typename F>
+int for_each_draw(size_t num_draws, size_t block_size, F&& f,
+                  callbacks::logger& logger, const std::string& what) {
+  block_size = std::max<size_t>(block_size, 1);
+  const size_t num_blocks = (num_draws + block_size - 1) / block_size;
+  tbb::enumerable_thread_specific<transform_buffers> buffers;
+  std::vector<transform_block> blocks(num_blocks);
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_blocks, 1),
+      [&](const tbb::blocked_range<size_t>& r) {
+        transform_buffers& thread_buffers = buffers.local();
+        for (size_t block = r.begin(); block != r.end(); ++block) {
+          std::stringstream msg;
+          const size_t end = std::min(num_draws, (block + 1) * block_size);
+          for (size_t i = block * block_size; i < end; ++i) {
+            try {
+              f(block, i, thread_buffers, msg);
+            } catch (const std::domain_error& e) {
+              blocks[block].failed_draw = i;
+              blocks[block].error = e.what();
+              blocks[block].return_code = error_codes::DATAERR;
+              break;
+            } catch (const std::exception& e) {
+              blocks[block].failed_draw = i;
+              blocks[block].error = e.what();
+              blocks[block].return_code = error_codes::SOFTWARE;
+              break;
+            }
+          }
+          blocks[block].messages = msg.str();
+        }
+      },
+      tbb::simple_partitioner());
+  for (const auto& block : blocks) {
+    if (!block.messages.empty())
+      logger.info(block.messages);
+    if (block.return_code != error_codes::OK) {
+      logger.error("Error " + what + " draw "
+                   + std::to_string(block.failed_draw + 1) + ": "
+                   + block.error);
+      return block.return_code;
+    }
+  }
+  return error_codes::OK;
+}
+
+}  // namespace internal
+
+/**
+ * Transform draws of the constrained parameters of a model to the
+ * unconstrained space, with <code>unconstrain_array</code>, in
+ * parallel.  Matrix of draws consists of one row per draw, one column
+ * per constrained parameter, as written by the samplers without the
+ * sampler diagnostics, transformed parameters and generated
+ * quantities.
+ *
+ * <p>The draws are transformed by blocks of <code>block_size</code>
+ * draws in parallel, every thread reusing its buffers.  A draw that
+ * cannot be unconstrained, for instance because it is outside the
+ * support of its constraint, stops the transform with
+ * <code>error_codes::DATAERR</code> after logging the first such draw.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in] draws draws of the constrained parameters, one per row
+ * @param[in] block_size number of draws per parallel block
+ * @param[out] unconstrained draws of the unconstrained parameters, one
+ * per row
+ * @param[in, out] logger logger to which to write messages
+ * @return error code
+ */
+template <class Model>
+int unconstrain_draws(const Model& model, const Eigen::MatrixXd& draws,
+                      size_t block_size, Eigen::MatrixXd& unconstrained,
+                      callbacks::logger& logger) {
+  std::vector<std::string> p_names;
+  model.constrained_param_names(p_names, false, false);
+  if (p_names.size() != static_cast<size_t>(draws.cols())) {
+    std::stringstream msg;
+    msg << "Wrong number of parameter values in draws.  Expecting "
+        << p_names.size() << " columns, found " << draws.cols()
+        << " columns.";
+    logger.error(msg.str());
+    return error_codes::DATAERR;
+  }
+  unconstrained.resize(draws.rows(), model.num_params_r());
+  return internal::for_each_draw(
+      draws.rows(), block_size,
+      [&](size_t /* block */, size_t i, internal::transform_buffers& buffers,
+          std::stringstream& msg) {
+        buffers.in = draws.row(i).transpose();
+        model.unconstrain_array(buffers.in, buffers.out, &msg);
+        unconstrained.row(i) = buffers.out.transpose();
+      },
+      logger, "unconstraining");
+}
+
+/**
+ * Transform draws of the unconstrained parameters of a model to the
+ * constrained parameters, and optionally the transformed parameters
+ * and generated quantities, with <code>write_array</code>, in
+ * parallel.  The columns of the result are those of
+ * <code>constrained_param_names</code> with the same flags.
+ *
+ * <p>The draws are transformed by blocks of <code>block_size</code>
+ * draws in parallel, every thread reusing its buffers.  The generated
+ * quantities of each block are drawn with a pseudo random number
+ * generator created from the seed and the index of the block, so the
+ * result does not depend on the number of threads, as in
+ * <code>standalone_generate_parallel</code>.  A draw at which the model
+ * throws stops the transform after logging the first such draw.
+ *
+ * @tparam Model model class
+ * @param[in] model instantiated model
+ * @param[in] draws draws of the unconstrained parameters, one per row
+ * @param[in] include_tparams true to include the transformed parameters
+ * @param[in] include_gqs true to include the generated quantities
+ * @param[in] seed seed of the pseudo random number generators
+ * @param[in] block_size number of draws per parallel block
+ * @param[out] constrained constrained values, one draw per row
+ * @param[in, out] logger logger to which to write messages
+ * @return error code
+ */
+template <class Model>
+int constrain_draws(const Model& model, const Eigen::MatrixXd& draws,
+                    bool include_tparams, bool include_gqs, unsigned int seed,
+                    size_t block_size, Eigen::MatrixXd& constrained,
+                    callbacks::logger& logger) {
+  if (static_cast<size_t>(draws.cols()) != model.num_params_r()) {
+    std::stringstream msg;
+    msg << "Wrong number of unconstrained parameter values in draws.  "
+        << "Expecting " << model.num_params_r() << " columns, found "
+        << draws.cols() << " columns.";
+    logger.error(msg.str());
+    return error_codes::DATAERR;
+  }
+  std::vector<std::string> names;
+  model.constrained_param_names(names, include_tparams, include_gqs);
+  constrained.resize(draws.rows(), names.size());
+  block_size = std::max<size_t>(block_size, 1);
+  std::vector<stan::rng_t> rngs;
+  if (include_gqs) {
+    const size_t num_blocks = (draws.rows() + block_size - 1) / block_size;
+    rngs.reserve(num_blocks);
+    for (size_t block = 0; block < num_blocks; ++block)
+      rngs.emplace_back(util::create_rng(seed, block + 1));
+  }
+  stan::rng_t unused_rng = util::create_rng(seed, 0);
+  return internal::for_each_draw(
+      draws.rows(), block_size,
+      [&](size_t block, size_t i, internal::transform_buffers& buffers,
+          std::stringstream& msg) {
+        buffers.in = draws.row(i).transpose();
+        // Without generated quantities the generator is not used
+        stan::rng_t& rng = include_gqs ? rngs[block] : unused_rng;
+        model.write_array(rng, buffers.in, buffers.out, include_tparams,
+                          include_gqs, &msg);
+        constrained.row(i) = buffers.out.transpose();
+      },
+      logger, "constraining");
+}
+
+}  // namespace transform
+}  // namespace services
+}  // namespace stan
+#endif
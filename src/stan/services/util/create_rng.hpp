@@ -33,6 +33,33 @@ inline rng_t create_rng(unsigned int seed, unsigned int chain) {
   return rng;
 }
 
+/**
+ * Creates a pseudo random number generator for one substream of a
+ * chain, for parallel work within the chain such as a loop over
+ * iterations or draws.  Every (seed, chain, substream) triple seeds
+ * its own stream, disjoint from the others and from the stream of
+ * create_rng(seed, chain), so a parallel loop that takes the
+ * generator of each item from its index produces the same draws for
+ * any number of threads and any schedule.
+ *
+ * Several indices, such as an iteration and a draw within it, should
+ * be combined into one, e.g. iteration * num_draws + draw.  Seeding
+ * jumps ahead in the sequence, which costs about as much as a few
+ * hundred draws, so a substream should serve a batch of draws rather
+ * than a single one.
+ *
+ * @param[in] seed the random seed
+ * @param[in] chain the chain id
+ * @param[in] substream index of the substream within the chain
+ * @return an stan::rng_t instance
+ */
+inline rng_t create_rng(unsigned int seed, unsigned int chain,
+                        unsigned int substream) {
+  // The second word is 1 for the chain streams, 2 for the substreams
+  rng_t rng(substream, 2, seed, chain);
+  return rng;
+}
+
 }  // namespace util
 }  // namespace services
 }  // namespace stan
@@ -0,0 +1,204 @@
+#ifndef STAN_SERVICES_UTIL_DATA_SNAPSHOT_CACHE_HPP
+#define STAN_SERVICES_UTIL_DATA_SNAPSHOT_CACHE_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/io/var_context.hpp>
+#include <stan/services/util/warm_start_cache.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+
+namespace stan {
+namespace services {
+namespace util {
+
+namespace internal {
+
+constexpr char data_snapshot_magic[8]
+    = {'s', 't', 'a', 'n', 'd', 'a', 't', 'a'};
+
+}  // namespace internal
+
+/**
+ * A directory of snapshots of the data state of constructed models,
+ * their data and transformed data, keyed by a fingerprint of the model
+ * type and its data, so that later runs on the same data restore the
+ * model instead of running its constructor.
+ *
+ * Only models that declare the `write_data_snapshot` and
+ * `read_data_snapshot` hooks of `model_base_crtp` are cached.  The
+ * fingerprint identifies the model by the name of its C++ type, not by
+ * its code, so a model that is changed and recompiled must use a new
+ * directory or have the directory cleared.  Snapshots are written by
+ * the model in its own binary layout, so a cache is only readable on
+ * the same kind of machine.  A snapshot is written to a temporary file
+ * and renamed, so that concurrent runs never read a partially written
+ * snapshot.
+ */
+class data_snapshot_cache {
+ public:
+  /**
+   * Construct a cache in the specified directory, which must exist.
+   *
+   * @param[in] directory directory of the snapshots
+   */
+  explicit data_snapshot_cache(const std::string& directory)
+      : directory_(directory) {}
+
+  /**
+   * Return the key of the snapshot of a model with the specified data.
+   *
+   * @tparam Model type of model
+   * @param[in] data data the model is constructed with
+   * @return key of the snapshot
+   */
+  template <class Model>
+  static std::string key(const io::var_context& data) {
+    internal::fnv1a_hash hash;
+    hash.add(std::string(typeid(Model).name()));
+    internal::hash_data(hash, data);
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash.value();
+    return key.str();
+  }
+
+  /**
+   * Restore the model with the specified key from its snapshot.
+   *
+   * @tparam Model type of model
+   * @param[in] key key of the snapshot
+   * @return the restored model, or a null pointer if there is no
+   *   snapshot or it could not be read
+   */
+  template <class Model>
+  std::unique_ptr<Model> read(const std::string& key) const {
+    std::ifstream in(path(key), std::ios::binary);
+    if (!in)
+      return nullptr;
+    char magic[sizeof(internal::data_snapshot_magic)];
+    in.read(magic, sizeof(magic));
+    if (!in
+        || std::memcmp(magic, internal::data_snapshot_magic, sizeof(magic))
+               != 0)
+      return nullptr;
+    try {
+      return Model::read_data_snapshot(in);
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  /**
+   * Write the snapshot of a model with the specified key, replacing
+   * any earlier one.
+   *
+   * @tparam Model type of model
+   * @param[in] key key of the snapshot
+   * @param[in] model model to write
+   * @return `true` if the snapshot was written, `false` if the model
+   *   does not support snapshots
+   * @throw std::runtime_error if the snapshot cannot be written
+   */
+  template <class Model>
+  bool write(const std::string& key, const Model& model) const {
+    const std::string snapshot = path(key);
+    const std::string temporary = snapshot + ".tmp";
+    bool written;
+    {
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if (!out)
+        throw std::runtime_error("Cannot write data snapshot " + snapshot
+                                 + ".");
+      out.write(internal::data_snapshot_magic,
+                sizeof(internal::data_snapshot_magic));
+      try {
+        written = model.write_data_snapshot(out);
+      } catch (...) {
+        out.close();
+        std::remove(temporary.c_str());
+        throw;
+      }
+      out.flush();
+      if (written && !out) {
+        out.close();
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot write data snapshot " + snapshot
+                                 + ".");
+      }
+    }
+    if (!written) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+    if (std::rename(temporary.c_str(), snapshot.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw std::runtime_error("Cannot write data snapshot " + snapshot
+                               + ".");
+    }
+    return true;
+  }
+
+  /**
+   * Return the path of the snapshot with the specified key.
+   *
+   * @param[in] key key of the snapshot
+   * @return path of the snapshot
+   */
+  std::string path(const std::string& key) const {
+    return directory_ + "/" + key + ".snapshot";
+  }
+
+ private:
+  std::string directory_;
+};
+
+/**
+ * Construct a model, restoring it from its snapshot in the cache when
+ * there is one for the same data, and otherwise running its
+ * constructor and writing its snapshot for later runs.  A snapshot
+ * that cannot be read is ignored and one that cannot be written is
+ * reported to the logger, so the model is always constructed.
+ *
+ * @tparam Model type of model, with the constructor of generated models
+ * @param[in] data data of the model
+ * @param[in] seed seed passed to the constructor
+ * @param[in] cache cache of snapshots
+ * @param[in,out] logger logger for messages
+ * @param[in,out] msgs stream for messages of the constructor
+ * @return the model
+ */
+template <class Model>
+std::unique_ptr<Model> construct_model(io::var_context& data,
+                                       unsigned int seed,
+                                       const data_snapshot_cache& cache,
+                                       callbacks::logger& logger,
+                                       std::ostream* msgs = nullptr) {
+  const std::string key = data_snapshot_cache::key<Model>(data);
+  std::unique_ptr<Model> model = cache.read<Model>(key);
+  if (model) {
+    logger.info("Restored model from data snapshot " + cache.path(key));
+    return model;
+  }
+  model = std::make_unique<Model>(data, seed, msgs);
+  try {
+    if (cache.write(key, *model))
+      logger.info("Wrote data snapshot " + cache.path(key));
+  } catch (const std::exception& e) {
+    logger.warn(e.what());
+  }
+  return model;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,189 @@
+#ifndef STAN_SERVICES_UTIL_EXECUTION_POLICY_HPP
+#define STAN_SERVICES_UTIL_EXECUTION_POLICY_HPP
+
+#include <tbb/task_arena.h>
+#if TBB_INTERFACE_VERSION >= 12000
+#include <tbb/info.h>
+#endif
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Limits on the threads that run the parallel parts of a service, so
+ * that several jobs can share a machine without oversubscribing it.
+ *
+ * The services run their chains, paths and draws with TBB.  A service
+ * called through <code>execute</code> runs in a TBB arena with these
+ * limits, and all of the parallel work it spawns, including that of
+ * the model, stays in the arena.
+ */
+struct execution_policy {
+  /**
+   * Maximum number of threads, including the calling thread, or -1
+   * for as many threads as TBB allows.
+   */
+  int num_threads = -1;
+
+  /**
+   * NUMA node to run the threads on, or -1 for no placement.  Placing
+   * the threads requires oneTBB built with NUMA support.
+   */
+  int numa_node = -1;
+
+  /**
+   * Priority of the work relative to that of other arenas in the
+   * process.  Only available with oneTBB.
+   */
+  enum class priority { low, normal, high };
+  priority arena_priority = priority::normal;
+
+  /**
+   * NUMA nodes to spread the chains of the multi-chain services over,
+   * chain <code>i</code> running on node
+   * <code>chain_numa_nodes[i % chain_numa_nodes.size()]</code> with its
+   * sampler built there, or empty for no placement.  The threads are
+   * split evenly between the nodes.
+   */
+  std::vector<int> chain_numa_nodes;
+};
+
+namespace internal {
+
+#if TBB_INTERFACE_VERSION >= 12000
+inline tbb::task_arena::priority arena_priority(
+    execution_policy::priority priority) {
+  switch (priority) {
+    case execution_policy::priority::low:
+      return tbb::task_arena::priority::low;
+    case execution_policy::priority::high:
+      return tbb::task_arena::priority::high;
+    default:
+      return tbb::task_arena::priority::normal;
+  }
+}
+#endif
+
+/**
+ * Return the policy of the innermost call to <code>execute</code>
+ * running on this thread, or a null pointer outside of one.
+ */
+inline const execution_policy*& current_execution_policy() {
+  static thread_local const execution_policy* policy = nullptr;
+  return policy;
+}
+
+/**
+ * Makes a policy the current policy of this thread for its lifetime.
+ */
+class execution_policy_scope {
+ public:
+  explicit execution_policy_scope(const execution_policy& policy)
+      : previous_(current_execution_policy()) {
+    current_execution_policy() = &policy;
+  }
+  ~execution_policy_scope() { current_execution_policy() = previous_; }
+
+ private:
+  const execution_policy* previous_;
+};
+
+}  // namespace internal
+
+/**
+ * Return a TBB arena with the limits of the specified policy.
+ *
+ * @param[in] policy limits on the threads of the arena
+ * @return arena, not yet initialized
+ * @throw std::invalid_argument if the number of threads is not positive
+ *   or -1, or if the NUMA node or the priority cannot be honored by
+ *   this version of TBB
+ */
+inline tbb::task_arena make_task_arena(const execution_policy& policy) {
+  if (policy.num_threads == 0 || policy.num_threads < -1)
+    throw std::invalid_argument("Number of threads must be positive or -1; "
+                                "found num_threads = "
+                                + std::to_string(policy.num_threads));
+  const int max_concurrency = policy.num_threads == -1
+                                  ? tbb::task_arena::automatic
+                                  : policy.num_threads;
+#if TBB_INTERFACE_VERSION >= 12000
+  tbb::task_arena::constraints constraints;
+  constraints.set_max_concurrency(max_concurrency);
+  if (policy.numa_node != -1) {
+    std::vector<tbb::numa_node_id> nodes = tbb::info::numa_nodes();
+    if (std::find(nodes.begin(), nodes.end(), policy.numa_node)
+        == nodes.end())
+      throw std::invalid_argument("NUMA node "
+                                  + std::to_string(policy.numa_node)
+                                  + " is not available.");
+    constraints.set_numa_id(policy.numa_node);
+  }
+  return tbb::task_arena(constraints, 1,
+                         internal::arena_priority(policy.arena_priority));
+#else
+  if (policy.numa_node != -1)
+    throw std::invalid_argument(
+        "Placing threads on a NUMA node requires oneTBB.");
+  if (policy.arena_priority != execution_policy::priority::normal)
+    throw std::invalid_argument("Arena priorities require oneTBB.");
+  return tbb::task_arena(max_concurrency);
+#endif
+}
+
+/**
+ * Return the policy for the chains run on the specified NUMA node, with
+ * the threads of the specified policy split evenly between its chain
+ * nodes.
+ *
+ * @param[in] policy policy spreading chains over NUMA nodes
+ * @param[in] numa_node NUMA node of the chains
+ * @return policy for the chains on the node
+ */
+inline execution_policy chain_execution_policy(const execution_policy& policy,
+                                               int numa_node) {
+  execution_policy chain_policy;
+  if (policy.num_threads != -1)
+    chain_policy.num_threads = std::max<int>(
+        1, policy.num_threads / policy.chain_numa_nodes.size());
+  chain_policy.numa_node = numa_node;
+  chain_policy.arena_priority = policy.arena_priority;
+  return chain_policy;
+}
+
+/**
+ * Call the specified function, usually a service, in a TBB arena with
+ * the limits of the specified policy.
+ *
+ * For example, to sample with at most four threads,
+ * <code>execute(policy, [&]() { return hmc_nuts_diag_e_adapt(...); })</code>
+ * with <code>policy.num_threads = 4</code>.
+ *
+ * @tparam F type of function
+ * @param[in] policy limits on the threads running the function
+ * @param[in] f function taking no arguments
+ * @return value returned by the function
+ * @throw std::invalid_argument if the policy, or the policy of the
+ *   chains on any of its chain NUMA nodes, cannot be honored; see
+ *   <code>make_task_arena</code>
+ */
+template <typename F>
+inline decltype(auto) execute(const execution_policy& policy, F&& f) {
+  tbb::task_arena arena = make_task_arena(policy);
+  for (int numa_node : policy.chain_numa_nodes)
+    make_task_arena(chain_execution_policy(policy, numa_node));
+  return arena.execute([&policy, &f]() -> decltype(auto) {
+    internal::execution_policy_scope scope(policy);
+    return f();
+  });
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
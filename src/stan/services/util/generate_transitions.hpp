@@ -2,9 +2,15 @@
 #define STAN_SERVICES_UTIL_GENERATE_TRANSITIONS_HPP
 
 #include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/progress.hpp>
 #include <stan/mcmc/base_mcmc.hpp>
+#include <stan/mcmc/sampler_instrumentation.hpp>
+#include <stan/mcmc/trace_events.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/progress_logger.hpp>
+#include <chrono>
 #include <string>
+#include <utility>
 
 namespace stan {
 namespace services {
@@ -27,7 +33,146 @@ namespace util {
  *   to the mcmc_writer. If false, transitions will not be written
  * @param[in] warmup indicates whether these transitions are warmup. Used
  *   for printing iteration number messages
- * @param[in,out] mcmc_writer writer to handle mcmc output
+ * @param[in,out] mcmc_writer writer to handle mcmc output; draws it
+ *   defers are written before returning or throwing
+ * @param[in,out] init_s starts as the initial unconstrained parameter
+ *   values. When the function completes, this will have the final
+ *   iteration's unconstrained parameter values
+ * @param[in] model model
+ * @param[in,out] base_rng random number generator
+ * @param[in,out] callback interrupt callback called once an iteration;
+ *   wrap it in a <code>callbacks::timed_interrupt</code> to poll a
+ *   costly interrupt on a timer instead
+ * @param[in,out] logger logger for messages of the sampler
+ * @param[in,out] progress progress callback called instead of logging
+ *   the iteration number messages
+ * @param[in,out] instrumentation record to which the counters and
+ *   timings of the transitions and of their output are added
+ * @param[in] chain_id The id of the current chain, passed to the
+ *  progress callback.
+ */
+template <class Model, class RNG>
+void generate_transitions(stan::mcmc::base_mcmc& sampler, int num_iterations,
+                          int start, int finish, int num_thin, int refresh,
+                          bool save, bool warmup,
+                          util::mcmc_writer& mcmc_writer,
+                          stan::mcmc::sample& init_s, Model& model,
+                          RNG& base_rng, callbacks::interrupt& callback,
+                          callbacks::logger& logger,
+                          callbacks::progress& progress,
+                          stan::mcmc::sampler_instrumentation& instrumentation,
+                          size_t chain_id = 1) {
+  try {
+    for (int m = 0; m < num_iterations; ++m) {
+      STAN_TRACE_SCOPE(warmup ? "warmup_iteration" : "sampling_iteration");
+      callback();
+
+      if (refresh > 0
+          && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0))
+        progress(chain_id, start + m + 1, finish, warmup);
+
+      auto start_transition = std::chrono::steady_clock::now();
+      stan::mcmc::sample next_s = sampler.transition(init_s, logger);
+      sampler.recycle(init_s);
+      init_s = std::move(next_s);
+      auto end_transition = std::chrono::steady_clock::now();
+      instrumentation.transition_time
+          += std::chrono::duration<double>(end_transition - start_transition)
+                 .count();
+      ++instrumentation.num_transitions;
+      sampler.record_instrumentation(instrumentation);
+
+      if (save && ((m % num_thin) == 0)) {
+        mcmc_writer.write_sample_params(base_rng, init_s, sampler, model);
+        mcmc_writer.write_diagnostic_params(init_s, sampler);
+        instrumentation.output_time
+            += std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                             - end_transition)
+                   .count();
+      }
+    }
+  } catch (...) {
+    // Keep the draws deferred before an interrupt or an error stopped
+    // the chain
+    mcmc_writer.flush_deferred();
+    throw;
+  }
+  auto start_flush = std::chrono::steady_clock::now();
+  mcmc_writer.flush_deferred();
+  instrumentation.output_time += std::chrono::duration<double>(
+                                     std::chrono::steady_clock::now()
+                                     - start_flush)
+                                     .count();
+}
+
+/**
+ * Generates MCMC transitions.
+ *
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] sampler MCMC sampler used to generate transitions
+ * @param[in] num_iterations number of MCMC transitions
+ * @param[in] start starting iteration number used for printing messages
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writer writer to handle mcmc output; draws it
+ *   defers are written before returning
+ * @param[in,out] init_s starts as the initial unconstrained parameter
+ *   values. When the function completes, this will have the final
+ *   iteration's unconstrained parameter values
+ * @param[in] model model
+ * @param[in,out] base_rng random number generator
+ * @param[in,out] callback interrupt callback called once an iteration
+ * @param[in,out] logger logger for messages
+ * @param[in,out] instrumentation record to which the counters and
+ *   timings of the transitions and of their output are added
+ * @param[in] chain_id The id of the current chain, used in output.
+ * @param[in] num_chains The number of chains used in the program. This
+ *  is used in generate transitions to print out the chain number.
+ */
+template <class Model, class RNG>
+void generate_transitions(stan::mcmc::base_mcmc& sampler, int num_iterations,
+                          int start, int finish, int num_thin, int refresh,
+                          bool save, bool warmup,
+                          util::mcmc_writer& mcmc_writer,
+                          stan::mcmc::sample& init_s, Model& model,
+                          RNG& base_rng, callbacks::interrupt& callback,
+                          callbacks::logger& logger,
+                          stan::mcmc::sampler_instrumentation& instrumentation,
+                          size_t chain_id = 1, size_t num_chains = 1) {
+  progress_logger progress(logger, num_chains);
+  generate_transitions(sampler, num_iterations, start, finish, num_thin,
+                       refresh, save, warmup, mcmc_writer, init_s, model,
+                       base_rng, callback, logger, progress, instrumentation,
+                       chain_id);
+}
+
+/**
+ * Generates MCMC transitions.
+ *
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] sampler MCMC sampler used to generate transitions
+ * @param[in] num_iterations number of MCMC transitions
+ * @param[in] start starting iteration number used for printing messages
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writer writer to handle mcmc output; draws it
+ *   defers are written before returning
  * @param[in,out] init_s starts as the initial unconstrained parameter
  *   values. When the function completes, this will have the final
  *   iteration's unconstrained parameter values
@@ -48,32 +193,11 @@ void generate_transitions(stan::mcmc::base_mcmc& sampler, int num_iterations,
                           RNG& base_rng, callbacks::interrupt& callback,
                           callbacks::logger& logger, size_t chain_id = 1,
                           size_t num_chains = 1) {
-  for (int m = 0; m < num_iterations; ++m) {
-    callback();
-
-    if (refresh > 0
-        && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
-      int it_print_width = std::ceil(std::log10(static_cast<double>(finish)));
-      std::stringstream message;
-      if (num_chains != 1) {
-        message << "Chain [" << chain_id << "] ";
-      }
-      message << "Iteration: ";
-      message << std::setw(it_print_width) << m + 1 + start << " / " << finish;
-      message << " [" << std::setw(3)
-              << static_cast<int>((100.0 * (start + m + 1)) / finish) << "%] ";
-      message << (warmup ? " (Warmup)" : " (Sampling)");
-
-      logger.info(message);
-    }
-
-    init_s = sampler.transition(init_s, logger);
-
-    if (save && ((m % num_thin) == 0)) {
-      mcmc_writer.write_sample_params(base_rng, init_s, sampler, model);
-      mcmc_writer.write_diagnostic_params(init_s, sampler);
-    }
-  }
+  stan::mcmc::sampler_instrumentation instrumentation;
+  generate_transitions(sampler, num_iterations, start, finish, num_thin,
+                       refresh, save, warmup, mcmc_writer, init_s, model,
+                       base_rng, callback, logger, instrumentation, chain_id,
+                       num_chains);
 }
 
 }  // namespace util
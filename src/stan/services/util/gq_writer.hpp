@@ -45,7 +45,8 @@ class gq_writer {
    * Write names of variables declared in the generated quantities block
    * to stream `sample_writer_`.
    *
-   * @tparam M model class
+   * @tparam Model model class, or `stan::model::model_metadata` to copy
+   *   the names built once for the model
    */
   template <class Model>
   void write_gq_names(const Model& model) {
@@ -1,14 +1,21 @@
 #ifndef STAN_SERVICES_UTIL_INITIALIZE_HPP
 #define STAN_SERVICES_UTIL_INITIALIZE_HPP
 
+#include <stan/callbacks/buffered_logger.hpp>
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/var_context.hpp>
 #include <stan/io/random_var_context.hpp>
 #include <stan/io/chained_var_context.hpp>
+#include <stan/model/double_arena.hpp>
 #include <stan/model/log_prob_grad.hpp>
 #include <stan/math/prim.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
 #include <chrono>
+#include <exception>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -17,6 +24,204 @@ namespace stan {
 namespace services {
 namespace util {
 
+namespace internal {
+
+/**
+ * Generate a candidate initial value of the parameters of the model on
+ * the unconstrained scale, as one try of <code>initialize</code>.
+ *
+ * @tparam Model the type of the model class
+ * @tparam InitContext the type of the initial values
+ * @tparam RNG the type of the random number generator
+ * @param[in] model the model
+ * @param[in] init a var_context with initial values
+ * @param[in,out] rng random number generator
+ * @param[in] init_radius the radius for generating random values
+ * @param[in] is_initialized_with_zero whether missing values are zero
+ * @param[in] any_initialized whether init provides any parameter
+ * @param[in,out] disc_vector discrete parameters
+ * @param[out] unconstrained the candidate
+ * @param[in,out] logger logger for messages
+ * @throws exception passed through from the model if the model has a
+ *   fatal error (not a std::domain_error)
+ * @return true if the candidate was generated, false if it was rejected
+ */
+template <typename Model, typename InitContext, typename RNG>
+bool generate_init(Model& model, const InitContext& init, RNG& rng,
+                   double init_radius, bool is_initialized_with_zero,
+                   bool any_initialized, std::vector<int>& disc_vector,
+                   std::vector<double>& unconstrained,
+                   stan::callbacks::logger& logger) {
+  stan::callbacks::message_sink msg;
+  try {
+    stan::io::random_var_context random_context(model, rng, init_radius,
+                                                is_initialized_with_zero);
+
+    if (!any_initialized) {
+      unconstrained = random_context.get_unconstrained();
+    } else {
+      stan::io::chained_var_context context(init, random_context);
+
+      model.transform_inits(context, disc_vector, unconstrained, &msg);
+    }
+  } catch (std::domain_error& e) {
+    msg.flush_to(logger);
+    logger.warn("Rejecting initial value:");
+    logger.warn(
+        "  Error evaluating the log probability"
+        " at the initial value.");
+    logger.warn(e.what());
+    return false;
+  } catch (std::exception& e) {
+    msg.flush_to(logger);
+    logger.error(
+        "Unrecoverable error evaluating the log probability"
+        " at the initial value.");
+    throw;
+  }
+  return true;
+}
+
+/**
+ * Evaluate the log probability and its gradient at a candidate initial
+ * value, as one try of <code>initialize</code>.
+ *
+ * @tparam Jacobian indicates whether to include the Jacobian term when
+ *   evaluating the log density function
+ * @tparam Model the type of the model class
+ * @param[in] model the model
+ * @param[in] unconstrained the candidate
+ * @param[in,out] disc_vector discrete parameters
+ * @param[in] print_timing indicates whether a timing message should
+ *   be printed to the logger
+ * @param[out] log_prob log probability at the candidate, up to a
+ *   constant, if it is valid
+ * @param[out] gradient gradient of the log probability at the
+ *   candidate
+ * @param[in,out] logger logger for messages
+ * @throws exception passed through from the model if the model has a
+ *   fatal error (not a std::domain_error)
+ * @return true if the candidate is a valid initial value
+ */
+template <bool Jacobian, typename Model>
+bool evaluate_init(Model& model, std::vector<double>& unconstrained,
+                   std::vector<int>& disc_vector, bool print_timing,
+                   double& log_prob, std::vector<double>& gradient,
+                   stan::callbacks::logger& logger) {
+  stan::callbacks::message_sink msg;
+  log_prob = 0;
+  try {
+    stan::model::double_arena_scope scope;
+    // we evaluate the log_prob function with propto=false
+    // because we're evaluating with `double` as the type of
+    // the parameters.
+    log_prob = model.template log_prob<false, Jacobian>(unconstrained,
+                                                        disc_vector, &msg);
+    msg.flush_to(logger);
+  } catch (std::domain_error& e) {
+    msg.flush_to(logger);
+    logger.warn("Rejecting initial value:");
+    logger.warn(
+        "  Error evaluating the log probability"
+        " at the initial value.");
+    logger.warn(e.what());
+    return false;
+  } catch (std::exception& e) {
+    msg.flush_to(logger);
+    logger.error(
+        "Unrecoverable error evaluating the log probability"
+        " at the initial value.");
+    throw;
+  }
+  if (!std::isfinite(log_prob)) {
+    logger.warn("Rejecting initial value:");
+    logger.warn(
+        "  Log probability evaluates to log(0),"
+        " i.e. negative infinity.");
+    logger.warn(
+        "  Stan can't start sampling from this"
+        " initial value.");
+    return false;
+  }
+  stan::callbacks::message_sink log_prob_msg;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    // we evaluate this with propto=true since we're
+    // evaluating with autodiff variables
+    log_prob = stan::model::log_prob_grad<true, Jacobian>(
+        model, unconstrained, disc_vector, gradient, &log_prob_msg);
+  } catch (const std::exception& e) {
+    log_prob_msg.flush_to(logger);
+    logger.error(e.what());
+    throw;
+  }
+  auto end = std::chrono::steady_clock::now();
+  double deltaT
+      = std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count()
+        / 1000000.0;
+  log_prob_msg.flush_to(logger);
+
+  bool gradient_ok = std::isfinite(stan::math::sum(gradient));
+
+  if (!gradient_ok) {
+    logger.warn("Rejecting initial value:");
+    logger.warn(
+        "  Gradient evaluated at the initial value"
+        " is not finite.");
+    logger.warn(
+        "  Stan can't start sampling from this"
+        " initial value.");
+  }
+  if (gradient_ok && print_timing) {
+    logger.info("");
+    std::stringstream msg1;
+    msg1 << "Gradient evaluation took " << deltaT << " seconds";
+    logger.info(msg1);
+
+    std::stringstream msg2;
+    msg2 << "1000 transitions using 10 leapfrog steps"
+         << " per transition would take"
+         << " " << 1e4 * deltaT << " seconds.";
+    logger.info(msg2);
+
+    logger.info("Adjust your expectations accordingly!");
+    logger.info("");
+    logger.info("");
+  }
+  return gradient_ok;
+}
+
+/**
+ * Log the failure of all tries to initialize and throw.
+ *
+ * @param[in] init_radius the radius for generating random values
+ * @param[in] is_initialized_with_zero whether missing values are zero
+ * @param[in] max_init_tries the number of tries
+ * @param[in,out] logger logger for messages
+ * @throws std::domain_error always
+ */
+[[noreturn]] inline void init_failed(double init_radius,
+                                     bool is_initialized_with_zero,
+                                     int max_init_tries,
+                                     stan::callbacks::logger& logger) {
+  if (!is_initialized_with_zero) {
+    logger.info("");
+    std::stringstream msg;
+    msg << "Initialization between (-" << init_radius << ", " << init_radius
+        << ") failed after"
+        << " " << max_init_tries << " attempts. ";
+    logger.error(msg);
+    logger.error(
+        " Try specifying initial values,"
+        " reducing ranges of constrained values,"
+        " or reparameterizing the model.");
+  }
+  throw std::domain_error("Initialization failed.");
+}
+
+}  // namespace internal
+
 /**
  * Returns a valid initial value of the parameters of the model
  * on the unconstrained scale.
@@ -73,6 +278,8 @@ std::vector<double> initialize(Model& model, const InitContext& init, RNG& rng,
                                stan::callbacks::writer& init_writer) {
   std::vector<double> unconstrained;
   std::vector<int> disc_vector;
+  double log_prob;
+  std::vector<double> gradient;
 
   bool is_fully_initialized = true;
   bool any_initialized = false;
@@ -89,141 +296,155 @@ std::vector<double> initialize(Model& model, const InitContext& init, RNG& rng,
       = is_fully_initialized || is_initialized_with_zero ? 1 : 100;
   int num_init_tries = 0;
   for (; num_init_tries < MAX_INIT_TRIES; num_init_tries++) {
-    std::stringstream msg;
-    try {
-      stan::io::random_var_context random_context(model, rng, init_radius,
-                                                  is_initialized_with_zero);
-
-      if (!any_initialized) {
-        unconstrained = random_context.get_unconstrained();
-      } else {
-        stan::io::chained_var_context context(init, random_context);
-
-        model.transform_inits(context, disc_vector, unconstrained, &msg);
-      }
-    } catch (std::domain_error& e) {
-      if (msg.str().length() > 0)
-        logger.info(msg);
-      logger.warn("Rejecting initial value:");
-      logger.warn(
-          "  Error evaluating the log probability"
-          " at the initial value.");
-      logger.warn(e.what());
+    if (!internal::generate_init(model, init, rng, init_radius,
+                                 is_initialized_with_zero, any_initialized,
+                                 disc_vector, unconstrained, logger))
       continue;
-    } catch (std::exception& e) {
-      if (msg.str().length() > 0)
-        logger.info(msg);
-      logger.error(
-          "Unrecoverable error evaluating the log probability"
-          " at the initial value.");
-      throw;
-    }
-
-    msg.str("");
-    double log_prob(0);
-    try {
-      // we evaluate the log_prob function with propto=false
-      // because we're evaluating with `double` as the type of
-      // the parameters.
-      log_prob = model.template log_prob<false, Jacobian>(unconstrained,
-                                                          disc_vector, &msg);
-      if (msg.str().length() > 0)
-        logger.info(msg);
-    } catch (std::domain_error& e) {
-      if (msg.str().length() > 0)
-        logger.info(msg);
-      logger.warn("Rejecting initial value:");
-      logger.warn(
-          "  Error evaluating the log probability"
-          " at the initial value.");
-      logger.warn(e.what());
-      continue;
-    } catch (std::exception& e) {
-      if (msg.str().length() > 0)
-        logger.info(msg);
-      logger.error(
-          "Unrecoverable error evaluating the log probability"
-          " at the initial value.");
-      throw;
-    }
-    if (!std::isfinite(log_prob)) {
-      logger.warn("Rejecting initial value:");
-      logger.warn(
-          "  Log probability evaluates to log(0),"
-          " i.e. negative infinity.");
-      logger.warn(
-          "  Stan can't start sampling from this"
-          " initial value.");
-      continue;
-    }
-    std::stringstream log_prob_msg;
-    std::vector<double> gradient;
-    auto start = std::chrono::steady_clock::now();
-    try {
-      // we evaluate this with propto=true since we're
-      // evaluating with autodiff variables
-      log_prob = stan::model::log_prob_grad<true, Jacobian>(
-          model, unconstrained, disc_vector, gradient, &log_prob_msg);
-    } catch (const std::exception& e) {
-      if (log_prob_msg.str().length() > 0)
-        logger.info(log_prob_msg);
-      logger.error(e.what());
-      throw;
-    }
-    auto end = std::chrono::steady_clock::now();
-    double deltaT
-        = std::chrono::duration_cast<std::chrono::microseconds>(end - start)
-              .count()
-          / 1000000.0;
-    if (log_prob_msg.str().length() > 0)
-      logger.info(log_prob_msg);
-
-    bool gradient_ok = std::isfinite(stan::math::sum(gradient));
-
-    if (!gradient_ok) {
-      logger.warn("Rejecting initial value:");
-      logger.warn(
-          "  Gradient evaluated at the initial value"
-          " is not finite.");
-      logger.warn(
-          "  Stan can't start sampling from this"
-          " initial value.");
-    }
-    if (gradient_ok && print_timing) {
-      logger.info("");
-      std::stringstream msg1;
-      msg1 << "Gradient evaluation took " << deltaT << " seconds";
-      logger.info(msg1);
-
-      std::stringstream msg2;
-      msg2 << "1000 transitions using 10 leapfrog steps"
-           << " per transition would take"
-           << " " << 1e4 * deltaT << " seconds.";
-      logger.info(msg2);
-
-      logger.info("Adjust your expectations accordingly!");
-      logger.info("");
-      logger.info("");
-    }
-    if (gradient_ok) {
+    if (internal::evaluate_init<Jacobian>(model, unconstrained, disc_vector,
+                                          print_timing, log_prob, gradient,
+                                          logger)) {
       init_writer(unconstrained);
       return unconstrained;
     }
   }
+  internal::init_failed(init_radius, is_initialized_with_zero, MAX_INIT_TRIES,
+                        logger);
+}
 
-  if (!is_initialized_with_zero) {
-    logger.info("");
-    std::stringstream msg;
-    msg << "Initialization between (-" << init_radius << ", " << init_radius
-        << ") failed after"
-        << " " << MAX_INIT_TRIES << " attempts. ";
-    logger.error(msg);
-    logger.error(
-        " Try specifying initial values,"
-        " reducing ranges of constrained values,"
-        " or reparameterizing the model.");
+/**
+ * Returns a valid initial value of the parameters of the model on the
+ * unconstrained scale, evaluating batches of candidates in parallel.
+ *
+ * This returns the same initial value as <code>initialize</code> with
+ * the same logging and leaves the random number generator in the same
+ * state.  The candidates of a batch are generated one after the other
+ * from <code>rng</code>, then the log probability and its gradient are
+ * evaluated at all of them in parallel, with the messages of each
+ * candidate buffered.  The candidates are then examined in the order
+ * they were generated: the messages of each are logged, and the first
+ * valid one is returned after restoring the state of the generator
+ * that followed it.
+ *
+ * <p>The model's log probability must be thread safe, as for running
+ * chains in parallel.  A batch size of one is the same as
+ * <code>initialize</code>.
+ *
+ * @tparam Jacobian indicates whether to include the Jacobian term when
+ *   evaluating the log density function
+ * @tparam Model the type of the model class
+ * @tparam RNG the type of the random number generator, which must be
+ *   copy assignable
+ *
+ * @param[in] model the model
+ * @param[in] init a var_context with initial values
+ * @param[in,out] rng random number generator
+ * @param[in] init_radius the radius for generating random values.
+ *   A value of 0 indicates that the unconstrained parameters (not
+ *   provided by init) should be initialized with 0.
+ * @param[in] print_timing indicates whether a timing message should
+ *   be printed to the logger
+ * @param[in] batch_size number of candidates evaluated in parallel
+ * @param[in,out] logger logger for messages
+ * @param[in,out] init_writer init writer (on the unconstrained scale)
+ * @throws exception passed through from the model if the model has a
+ *   fatal error (not a std::domain_error)
+ * @throws std::domain_error if the model can not be initialized and
+ *   the model does not have a fatal error (only allows for
+ *   std::domain_error)
+ * @return valid unconstrained parameters for the model
+ */
+template <bool Jacobian = true, typename Model, typename InitContext,
+          typename RNG>
+std::vector<double> initialize_parallel(Model& model, const InitContext& init,
+                                        RNG& rng, double init_radius,
+                                        bool print_timing, size_t batch_size,
+                                        stan::callbacks::logger& logger,
+                                        stan::callbacks::writer& init_writer) {
+  bool is_fully_initialized = true;
+  bool any_initialized = false;
+  std::vector<std::string> param_names;
+  model.get_param_names(param_names, false, false);
+  for (size_t n = 0; n < param_names.size(); n++) {
+    is_fully_initialized &= init.contains_r(param_names[n]);
+    any_initialized |= init.contains_r(param_names[n]);
   }
-  throw std::domain_error("Initialization failed.");
+
+  bool is_initialized_with_zero = init_radius == 0.0;
+
+  int MAX_INIT_TRIES
+      = is_fully_initialized || is_initialized_with_zero ? 1 : 100;
+  if (MAX_INIT_TRIES == 1 || batch_size <= 1) {
+    return initialize<Jacobian>(model, init, rng, init_radius, print_timing,
+                                logger, init_writer);
+  }
+
+  struct candidate {
+    std::vector<double> unconstrained;
+    std::vector<int> disc_vector;
+    stan::callbacks::buffered_logger log;
+    RNG rng_after;
+    bool generated;
+    bool valid;
+    std::exception_ptr error;
+  };
+  std::vector<candidate> candidates;
+  candidates.reserve(batch_size);
+  for (int num_init_tries = 0; num_init_tries < MAX_INIT_TRIES;) {
+    candidates.clear();
+    size_t num_candidates = std::min<size_t>(batch_size,
+                                             MAX_INIT_TRIES - num_init_tries);
+    for (size_t k = 0; k < num_candidates; ++k) {
+      candidates.push_back({{}, {}, {}, rng, false, false, nullptr});
+      candidate& c = candidates.back();
+      try {
+        c.generated = internal::generate_init(
+            model, init, rng, init_radius, is_initialized_with_zero,
+            any_initialized, c.disc_vector, c.unconstrained, c.log);
+      } catch (...) {
+        // Later candidates are never examined
+        c.error = std::current_exception();
+        c.rng_after = rng;
+        break;
+      }
+      c.rng_after = rng;
+    }
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, candidates.size(), 1),
+        [&](const tbb::blocked_range<size_t>& r) {
+          for (size_t k = r.begin(); k != r.end(); ++k) {
+            candidate& c = candidates[k];
+            if (!c.generated)
+              continue;
+            try {
+              double log_prob;
+              std::vector<double> gradient;
+              c.valid = internal::evaluate_init<Jacobian>(
+                  model, c.unconstrained, c.disc_vector, print_timing,
+                  log_prob, gradient, c.log);
+            } catch (...) {
+              c.error = std::current_exception();
+            }
+          }
+        },
+        tbb::simple_partitioner());
+
+    for (candidate& c : candidates) {
+      c.log.replay(logger);
+      if (c.error) {
+        rng = c.rng_after;
+        std::rethrow_exception(c.error);
+      }
+      if (c.valid) {
+        rng = c.rng_after;
+        init_writer(c.unconstrained);
+        return c.unconstrained;
+      }
+    }
+    num_init_tries += candidates.size();
+  }
+  internal::init_failed(init_radius, is_initialized_with_zero, MAX_INIT_TRIES,
+                        logger);
 }
 
 }  // namespace util
@@ -0,0 +1,230 @@
+#ifndef STAN_SERVICES_UTIL_INITIALIZE_CHAINS_HPP
+#define STAN_SERVICES_UTIL_INITIALIZE_CHAINS_HPP
+
+#include <stan/callbacks/buffered_logger.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * The initial value of a chain found by <code>initialize_chains</code>,
+ * with the log density and its gradient evaluated there.
+ */
+struct chain_init {
+  /** initial value on the unconstrained scale */
+  std::vector<double> cont_vector;
+  /** log density at the initial value, dropping constants */
+  double log_prob{0};
+  /** gradient of the log density at the initial value */
+  std::vector<double> gradient;
+  /** false if the chain could not be initialized */
+  bool ok{false};
+};
+
+/**
+ * Returns valid initial values of the parameters of the model on the
+ * unconstrained scale for several chains, evaluating the candidates of
+ * all chains in one parallel pool.
+ *
+ * Each chain draws its candidates from its own generator exactly as
+ * <code>initialize</code> would, so every chain gets the same initial
+ * value and leaves its generator in the same state as when initialized
+ * on its own.  In each round, the chains which are not yet initialized
+ * share <code>pool_size</code> candidates, at least one each, whose log
+ * density and gradient are evaluated in parallel.  The messages of each
+ * chain are buffered and logged in the order of the chains once all of
+ * them are done, followed by the initial values sent to the init
+ * writers.
+ *
+ * <p>Unlike <code>initialize</code>, a chain which can not be
+ * initialized does not stop the others: its messages end with the
+ * error and its result is marked as not ok.  The log density and
+ * gradient at the initial values are returned so that a sampler can
+ * start from them without evaluating them again.
+ *
+ * <p>The model's log probability must be thread safe, as for running
+ * chains in parallel.
+ *
+ * @tparam Jacobian indicates whether to include the Jacobian term when
+ *   evaluating the log density function
+ * @tparam Model the type of the model class
+ * @tparam InitContextPtr a pointer with underlying type derived from
+ *   <code>stan::io::var_context</code>
+ * @tparam RNG the type of the random number generator, which must be
+ *   copy assignable
+ * @tparam InitWriter a type derived from
+ *   <code>stan::callbacks::writer</code>
+ *
+ * @param[in] model the model
+ * @param[in] init initial values of each chain
+ * @param[in,out] rngs random number generator of each chain
+ * @param[in] init_radius the radius for generating random values.
+ *   A value of 0 indicates that the unconstrained parameters (not
+ *   provided by init) should be initialized with 0.
+ * @param[in] print_timing indicates whether a timing message should
+ *   be printed to the logger
+ * @param[in] pool_size number of candidates evaluated in parallel
+ * @param[in,out] logger logger for messages
+ * @param[in,out] init_writer init writer of each chain (on the
+ *   unconstrained scale)
+ * @return initial value of each chain
+ */
+template <bool Jacobian = true, typename Model, typename InitContextPtr,
+          typename RNG, typename InitWriter>
+std::vector<chain_init> initialize_chains(
+    Model& model, const std::vector<InitContextPtr>& init,
+    std::vector<RNG>& rngs, double init_radius, bool print_timing,
+    size_t pool_size, stan::callbacks::logger& logger,
+    std::vector<InitWriter>& init_writer) {
+  const size_t num_chains = rngs.size();
+  const bool is_initialized_with_zero = init_radius == 0.0;
+  std::vector<std::string> param_names;
+  model.get_param_names(param_names, false, false);
+
+  struct chain_state {
+    bool any_initialized;
+    int max_init_tries;
+    int num_init_tries;
+    bool done;
+    stan::callbacks::buffered_logger log;
+  };
+  std::vector<chain_state> chains(num_chains);
+  for (size_t i = 0; i < num_chains; ++i) {
+    bool is_fully_initialized = true;
+    bool any_initialized = false;
+    for (size_t n = 0; n < param_names.size(); n++) {
+      is_fully_initialized &= init[i]->contains_r(param_names[n]);
+      any_initialized |= init[i]->contains_r(param_names[n]);
+    }
+    chains[i].any_initialized = any_initialized;
+    chains[i].max_init_tries
+        = is_fully_initialized || is_initialized_with_zero ? 1 : 100;
+    chains[i].num_init_tries = 0;
+    chains[i].done = false;
+  }
+
+  struct candidate {
+    size_t chain;
+    std::vector<double> unconstrained;
+    std::vector<int> disc_vector;
+    stan::callbacks::buffered_logger log;
+    RNG rng_after;
+    bool generated;
+    bool valid;
+    double log_prob;
+    std::vector<double> gradient;
+    std::exception_ptr error;
+  };
+  std::vector<chain_init> inits(num_chains);
+  std::vector<candidate> candidates;
+  while (true) {
+    size_t num_pending = 0;
+    for (const auto& chain : chains)
+      num_pending += !chain.done;
+    if (num_pending == 0)
+      break;
+    size_t per_chain = std::max<size_t>(1, pool_size / num_pending);
+
+    candidates.clear();
+    for (size_t i = 0; i < num_chains; ++i) {
+      chain_state& chain = chains[i];
+      if (chain.done)
+        continue;
+      size_t num_candidates = std::min<size_t>(
+          per_chain, chain.max_init_tries - chain.num_init_tries);
+      for (size_t k = 0; k < num_candidates; ++k) {
+        candidates.push_back(
+            {i, {}, {}, {}, rngs[i], false, false, 0, {}, nullptr});
+        candidate& c = candidates.back();
+        try {
+          c.generated = internal::generate_init(
+              model, *init[i], rngs[i], init_radius, is_initialized_with_zero,
+              chain.any_initialized, c.disc_vector, c.unconstrained, c.log);
+        } catch (...) {
+          // Later candidates of the chain are never examined
+          c.error = std::current_exception();
+          c.rng_after = rngs[i];
+          break;
+        }
+        c.rng_after = rngs[i];
+      }
+    }
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, candidates.size(), 1),
+        [&](const tbb::blocked_range<size_t>& r) {
+          for (size_t k = r.begin(); k != r.end(); ++k) {
+            candidate& c = candidates[k];
+            if (!c.generated)
+              continue;
+            try {
+              c.valid = internal::evaluate_init<Jacobian>(
+                  model, c.unconstrained, c.disc_vector, print_timing,
+                  c.log_prob, c.gradient, c.log);
+            } catch (...) {
+              c.error = std::current_exception();
+            }
+          }
+        },
+        tbb::simple_partitioner());
+
+    for (candidate& c : candidates) {
+      chain_state& chain = chains[c.chain];
+      if (chain.done)
+        continue;
+      c.log.replay(chain.log);
+      ++chain.num_init_tries;
+      if (c.error) {
+        rngs[c.chain] = c.rng_after;
+        chain.done = true;
+        try {
+          std::rethrow_exception(c.error);
+        } catch (const std::exception& e) {
+          chain.log.error(e.what());
+        } catch (...) {
+          chain.log.error("Unknown error during initialization.");
+        }
+      } else if (c.valid) {
+        rngs[c.chain] = c.rng_after;
+        chain.done = true;
+        inits[c.chain].cont_vector = std::move(c.unconstrained);
+        inits[c.chain].log_prob = c.log_prob;
+        inits[c.chain].gradient = std::move(c.gradient);
+        inits[c.chain].ok = true;
+      }
+    }
+    for (auto& chain : chains) {
+      if (chain.done || chain.num_init_tries < chain.max_init_tries)
+        continue;
+      chain.done = true;
+      try {
+        internal::init_failed(init_radius, is_initialized_with_zero,
+                              chain.max_init_tries, chain.log);
+      } catch (const std::domain_error& e) {
+        chain.log.error(e.what());
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_chains; ++i) {
+    chains[i].log.replay(logger);
+    if (inits[i].ok)
+      init_writer[i](inits[i].cont_vector);
+  }
+  return inits;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
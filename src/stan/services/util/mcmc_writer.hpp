@@ -2,10 +2,19 @@
 #define STAN_SERVICES_UTIL_MCMC_WRITER_HPP
 
 #include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/message_sink.hpp>
+#include <stan/callbacks/structured_writer.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/mcmc/base_mcmc.hpp>
 #include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/trace_events.hpp>
+#include <stan/model/double_arena.hpp>
 #include <stan/model/prob_grad.hpp>
+#include <stan/services/util/sample_output_spec.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <iomanip>
 #include <limits>
 #include <sstream>
@@ -25,6 +34,140 @@ class mcmc_writer {
   callbacks::writer& diagnostic_writer_;
   callbacks::logger& logger_;
 
+  // Row buffers reused across draws so that writing a draw does not
+  // allocate once they have grown to size
+  std::vector<double> values_;
+  std::vector<double> model_values_;
+  std::vector<double> cont_params_;
+  std::vector<int> params_i_;
+  callbacks::message_sink msgs_;
+
+  // Draws whose constrained values are still to be computed, when
+  // write_array is deferred; the first num_deferred_ entries are in
+  // use and the others keep their storage for later batches
+  size_t max_deferred_;
+  size_t num_deferred_;
+  std::vector<std::vector<double>> deferred_values_;
+  std::vector<std::vector<double>> deferred_params_;
+  std::function<void(mcmc_writer&)> write_deferred_;
+
+  // Columns and precision of the output, and the indices into the full
+  // row of the selected columns, set by write_sample_names
+  sample_output_spec spec_;
+  bool select_all_;
+  bool need_model_values_;
+  std::vector<size_t> selected_;
+
+  /**
+   * Return true if the specified column name is selected by the
+   * specified name: equal to it or one of its elements.
+   */
+  static bool selects(const std::string& selection, const std::string& name) {
+    if (name.compare(0, selection.size(), selection) != 0)
+      return false;
+    return name.size() == selection.size() || name[selection.size()] == '.'
+           || name[selection.size()] == '[';
+  }
+
+  /**
+   * Round the specified value to the specified number of significant
+   * digits, zero keeping it as is.
+   */
+  static double round_digits(double x, int digits) {
+    if (digits <= 0 || !std::isfinite(x) || x == 0)
+      return x;
+    char chars[32];
+    std::snprintf(chars, sizeof(chars), "%.*e", digits - 1, x);
+    return std::strtod(chars, nullptr);
+  }
+
+  /**
+   * Compute the constrained values of the specified unconstrained
+   * parameters with model.write_array() into model_values_, logging
+   * its messages.  Domain errors are logged and leave the values
+   * incomplete; other errors are rethrown.
+   */
+  template <class Model, class RNG>
+  void compute_model_values(RNG& rng, std::vector<double>& cont_params,
+                            Model& model) {
+    model_values_.clear();
+    if (!need_model_values_)
+      return;
+    params_i_.clear();
+    msgs_.clear_messages();
+    try {
+      stan::model::double_arena_scope scope;
+      model.write_array(rng, cont_params, params_i_, model_values_,
+                        spec_.include_tparams, spec_.include_gqs, &msgs_);
+    } catch (const std::domain_error& e) {
+      msgs_.flush_to(logger_);
+      logger_.info(e.what());
+    } catch (const std::exception& e) {
+      msgs_.flush_to(logger_);
+      logger_.info(e.what());
+      throw;
+    }
+    msgs_.flush_to(logger_);
+  }
+
+  /**
+   * Append model_values_ to the specified row, padded with NaN up to
+   * the number of model parameters, and write the selected columns of
+   * the row at their precision.
+   */
+  void write_row(std::vector<double>& values) {
+    if (select_all_ && spec_.sampler_digits <= 0 && spec_.model_digits <= 0
+        && model_values_.size() == num_model_params_) {
+      // The row is written from the two buffers, without joining them
+      sample_writer_({values, model_values_});
+      return;
+    }
+    if (model_values_.size() > 0)
+      values.insert(values.end(), model_values_.begin(), model_values_.end());
+    if (model_values_.size() < num_model_params_)
+      values.insert(values.end(), num_model_params_ - model_values_.size(),
+                    std::numeric_limits<double>::quiet_NaN());
+
+    if (spec_.sampler_digits > 0 || spec_.model_digits > 0) {
+      const size_t num_sampler = num_sample_params_ + num_sampler_params_;
+      for (size_t n = 0; n < values.size(); ++n)
+        values[n] = round_digits(values[n], n < num_sampler
+                                                ? spec_.sampler_digits
+                                                : spec_.model_digits);
+    }
+    if (!select_all_) {
+      // The indices are increasing, so the row is compacted in place
+      for (size_t k = 0; k < selected_.size(); ++k)
+        values[k] = values[selected_[k]];
+      values.resize(selected_.size());
+    }
+
+    sample_writer_(values);
+  }
+
+  /**
+   * Return the storage of the next deferred draw in the specified
+   * buffers, growing them if needed.
+   */
+  std::vector<double>& deferred_slot(std::vector<std::vector<double>>& slots) {
+    if (slots.size() <= num_deferred_)
+      slots.resize(num_deferred_ + 1);
+    return slots[num_deferred_];
+  }
+
+  /**
+   * Compute the constrained values of the deferred draws and write
+   * them in order.
+   */
+  template <class Model, class RNG>
+  void write_deferred(RNG& rng, Model& model) {
+    for (size_t n = 0; n < num_deferred_; ++n) {
+      compute_model_values(rng, deferred_params_[n], model);
+      write_row(deferred_values_[n]);
+    }
+    num_deferred_ = 0;
+  }
+
  public:
   size_t num_sample_params_;
   size_t num_sampler_params_;
@@ -42,10 +185,57 @@ class mcmc_writer {
       : sample_writer_(sample_writer),
         diagnostic_writer_(diagnostic_writer),
         logger_(logger),
+        max_deferred_(0),
+        num_deferred_(0),
+        select_all_(true),
+        need_model_values_(true),
         num_sample_params_(0),
         num_sampler_params_(0),
         num_model_params_(0) {}
 
+  /**
+   * Defer computing the constrained values of saved draws, so that
+   * model.write_array() runs for batches of up to the specified number
+   * of draws instead of once per transition.  Rows are written in
+   * order when a batch is full, when flush_deferred() is called and
+   * before adaptation or timing information is written.  Zero, the
+   * default, computes and writes each draw as it is saved.
+   *
+   * The generated quantities of a deferred draw use the random number
+   * generator after the transitions of the whole batch, so the draws
+   * differ from those written without deferral for the same seed.
+   *
+   * @param[in] batch_size maximum number of deferred draws
+   */
+  void defer_model_values(size_t batch_size) {
+    flush_deferred();
+    max_deferred_ = batch_size;
+  }
+
+  /**
+   * Compute and write the draws whose constrained values were
+   * deferred.
+   */
+  void flush_deferred() {
+    if (num_deferred_ > 0) {
+      STAN_TRACE_SCOPE("writer_flush");
+      write_deferred_(*this);
+    }
+  }
+
+  /**
+   * Set the columns and the precision of the draws written from now
+   * on.  It must be called before write_sample_names(), which applies
+   * the column selection.  If no model column is selected,
+   * model.write_array() is not called at all.
+   *
+   * @param[in] spec output specification
+   */
+  void set_output_spec(const sample_output_spec& spec) {
+    flush_deferred();
+    spec_ = spec;
+  }
+
   /**
    * Outputs parameter string names. First outputs the names stored in
    * the sample object (stan::mcmc::sample), then uses the sampler
@@ -53,7 +243,8 @@ class mcmc_writer {
    * constrained parameter names.
    *
    * The names are written to the sample_stream as comma separated values
-   * with a newline at the end.
+   * with a newline at the end.  Only the columns selected by the output
+   * specification are written.
    *
    * @tparam Model Model class
    * @param[in] sample a sample (unconstrained) that works with the model
@@ -71,9 +262,33 @@ class mcmc_writer {
     sampler.get_sampler_param_names(names);
     num_sampler_params_ = names.size() - num_sample_params_;
 
-    model.constrained_param_names(names, true, true);
+    if (spec_.metadata)
+      spec_.metadata->constrained_param_names(names, spec_.include_tparams,
+                                              spec_.include_gqs);
+    else
+      model.constrained_param_names(names, spec_.include_tparams,
+                                    spec_.include_gqs);
     num_model_params_ = names.size() - num_sample_params_ - num_sampler_params_;
 
+    select_all_ = spec_.columns.empty();
+    need_model_values_ = select_all_;
+    selected_.clear();
+    if (!select_all_) {
+      std::vector<std::string> selected_names;
+      for (size_t n = 0; n < names.size(); ++n) {
+        for (const std::string& column : spec_.columns) {
+          if (selects(column, names[n])) {
+            selected_.push_back(n);
+            selected_names.push_back(names[n]);
+            if (n >= num_sample_params_ + num_sampler_params_)
+              need_model_values_ = true;
+            break;
+          }
+        }
+      }
+      names.swap(selected_names);
+    }
+
     sample_writer_(names);
   }
 
@@ -97,43 +312,67 @@ class mcmc_writer {
   template <class Model, class RNG>
   void write_sample_params(RNG& rng, stan::mcmc::sample& sample,
                            stan::mcmc::base_mcmc& sampler, Model& model) {
-    std::vector<double> values;
+    STAN_TRACE_SCOPE("write_draw");
+    std::vector<double>& values
+        = max_deferred_ > 0 ? deferred_slot(deferred_values_) : values_;
+    values.clear();
 
     sample.get_sample_params(values);
     sampler.get_sampler_params(values);
 
-    std::vector<double> model_values;
-    std::vector<int> params_i;
-    std::stringstream ss;
-    try {
-      std::vector<double> cont_params(
-          sample.cont_params().data(),
-          sample.cont_params().data() + sample.cont_params().size());
-      model.write_array(rng, cont_params, params_i, model_values, true, true,
-                        &ss);
-    } catch (const std::domain_error& e) {
-      if (ss.str().length() > 0)
-        logger_.info(ss);
-      ss.str("");
-      logger_.info(e.what());
-    } catch (const std::exception& e) {
-      if (ss.str().length() > 0)
-        logger_.info(ss);
-      logger_.info(e.what());
-      throw;
+    std::vector<double>& cont_params
+        = max_deferred_ > 0 ? deferred_slot(deferred_params_) : cont_params_;
+    cont_params.assign(
+        sample.cont_params().data(),
+        sample.cont_params().data() + sample.cont_params().size());
+
+    if (max_deferred_ > 0) {
+      ++num_deferred_;
+      write_deferred_ = [&rng, &model](mcmc_writer& writer) {
+        writer.write_deferred(rng, model);
+      };
+      if (num_deferred_ >= max_deferred_)
+        flush_deferred();
+      return;
     }
-    if (ss.str().length() > 0)
-      logger_.info(ss);
 
-    if (model_values.size() > 0)
-      values.insert(values.end(), model_values.begin(), model_values.end());
-    if (model_values.size() < num_model_params_)
-      values.insert(values.end(), num_model_params_ - model_values.size(),
-                    std::numeric_limits<double>::quiet_NaN());
+    compute_model_values(rng, cont_params, model);
+    write_row(values);
+  }
 
-    sample_writer_(values);
+  /**
+   * Outputs a sample whose model values were computed by the caller,
+   * e.g. on another thread, with model.write_array() and the include
+   * flags of output_spec().  The model values may be incomplete, as
+   * after a domain error, and are padded with NaN.
+   *
+   * @param[in] sample the sample in constrained space
+   * @param[in] sampler the sampler
+   * @param[in,out] model_values constrained values of the sample, left
+   *   in an unspecified state
+   */
+  void write_sample_params(stan::mcmc::sample& sample,
+                           stan::mcmc::base_mcmc& sampler,
+                           std::vector<double>& model_values) {
+    flush_deferred();
+    values_.clear();
+    sample.get_sample_params(values_);
+    sampler.get_sampler_params(values_);
+    model_values_.swap(model_values);
+    write_row(values_);
   }
 
+  /**
+   * Return the output specification of the draws.
+   */
+  const sample_output_spec& output_spec() const { return spec_; }
+
+  /**
+   * Return true if model.write_array() has to be called for the
+   * selected columns, known once write_sample_names() was called.
+   */
+  bool need_model_values() const { return need_model_values_; }
+
   /**
    * Prints additional info to the streams
    *
@@ -142,11 +381,39 @@ class mcmc_writer {
    * @param[in] sampler sampler
    */
   void write_adapt_finish(stan::mcmc::base_mcmc& sampler) {
+    flush_deferred();
     sample_writer_("Adaptation terminated");
   }
 
   /**
-   * Print diagnostic names
+   * Write the adapted step size and metric of the sampler.
+   *
+   * The step size is written to the sample stream.  If the metric
+   * writer writes to an output, the metric is written only there and
+   * the sample stream gets a line referring to it, so that a large
+   * dense metric is not formatted as comment lines of the sample
+   * stream.  Otherwise the metric is written to both, as before.
+   *
+   * @tparam Sampler type of sampler, derived from `mcmc::base_hmc`
+   * @param[in] sampler sampler
+   * @param[in, out] metric_writer writer for the step size and metric
+   */
+  template <class Sampler>
+  void write_adapted_state(Sampler& sampler,
+                           callbacks::structured_writer& metric_writer) {
+    flush_deferred();
+    if (metric_writer.enabled()) {
+      sampler.write_sampler_stepsize(sample_writer_);
+      sample_writer_("Inverse mass matrix written to the metric output");
+    } else {
+      sampler.write_sampler_state(sample_writer_);
+    }
+    sampler.write_sampler_state_struct(metric_writer);
+  }
+
+  /**
+   * Print diagnostic names.  The sampler is set to write the blocks of
+   * its state selected by the output specification.
    *
    * @tparam Model Model class
    * @param[in] sample unconstrained sample
@@ -164,6 +431,7 @@ class mcmc_writer {
     std::vector<std::string> model_names;
     model.unconstrained_param_names(model_names, false, false);
 
+    sampler.set_diagnostic_fields(spec_.diagnostic_fields);
     sampler.get_sampler_diagnostic_names(model_names, names);
 
     diagnostic_writer_(names);
@@ -177,7 +445,8 @@ class mcmc_writer {
    */
   void write_diagnostic_params(stan::mcmc::sample& sample,
                                stan::mcmc::base_mcmc& sampler) {
-    std::vector<double> values;
+    std::vector<double>& values = values_;
+    values.clear();
 
     sample.get_sample_params(values);
     sampler.get_sampler_params(values);
@@ -253,6 +522,7 @@ class mcmc_writer {
    * @param[in] sampleDeltaT sample time (sec)
    */
   void write_timing(double warmDeltaT, double sampleDeltaT) {
+    flush_deferred();
     write_timing(warmDeltaT, sampleDeltaT, sample_writer_);
     write_timing(warmDeltaT, sampleDeltaT, diagnostic_writer_);
     log_timing(warmDeltaT, sampleDeltaT);
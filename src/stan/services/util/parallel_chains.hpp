@@ -0,0 +1,158 @@
+#ifndef STAN_SERVICES_UTIL_PARALLEL_CHAINS_HPP
+#define STAN_SERVICES_UTIL_PARALLEL_CHAINS_HPP
+
+#include <stan/callbacks/cancellable_interrupt.hpp>
+#include <stan/callbacks/cancellation_token.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/services/util/execution_policy.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Run the chains of a multi-chain service in parallel, each chain on a
+ * single thread.
+ *
+ * Each chain should build its sampler and buffers inside the function,
+ * so that their memory is first touched by the thread running it.  If
+ * the service runs under an <code>execution_policy</code> that spreads
+ * chains over NUMA nodes, the chains on each node run in an arena bound
+ * to that node.
+ *
+ * <p>With a cancellation token, a chain that throws cancels the token,
+ * so chains polling it, through a <code>cancellable_interrupt</code>,
+ * stop at their next iteration with <code>cancelled_error</code>
+ * instead of running to the end.  The error of the chain that failed
+ * is thrown rather than those of the chains it stopped.
+ *
+ * @tparam F type of function
+ * @param[in] num_chains number of chains
+ * @param[in] f function called with the index of each chain, from 0 to
+ *   <code>num_chains - 1</code>
+ * @param[in,out] cancel if not null, cancellation token cancelled when a
+ *   chain throws
+ * @throw the first exception thrown by a chain, other than
+ *   <code>cancelled_error</code> if there is one, after all of the chains
+ *   have finished
+ */
+template <typename F>
+inline void parallel_chains(std::size_t num_chains, F&& f,
+                            callbacks::cancellation_token* cancel = nullptr) {
+  std::mutex error_mutex;
+  std::exception_ptr chain_error;
+  bool chain_error_is_cancel = false;
+  auto run_chain = [&](std::size_t i) {
+    std::exception_ptr error;
+    bool is_cancel = false;
+    try {
+      f(i);
+      return;
+    } catch (const callbacks::cancelled_error&) {
+      error = std::current_exception();
+      is_cancel = true;
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (cancel != nullptr)
+      cancel->cancel();
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (!chain_error || (chain_error_is_cancel && !is_cancel)) {
+      chain_error = error;
+      chain_error_is_cancel = is_cancel;
+    }
+  };
+  const execution_policy* policy = internal::current_execution_policy();
+  if (policy == nullptr || policy->chain_numa_nodes.empty()) {
+    tbb::parallel_for(
+        tbb::blocked_range<std::size_t>(0, num_chains, 1),
+        [&run_chain](const tbb::blocked_range<std::size_t>& r) {
+          for (std::size_t i = r.begin(); i != r.end(); ++i)
+            run_chain(i);
+        },
+        tbb::simple_partitioner());
+    if (chain_error)
+      std::rethrow_exception(chain_error);
+    return;
+  }
+  const std::vector<int>& nodes = policy->chain_numa_nodes;
+  std::vector<tbb::task_arena> arenas;
+  arenas.reserve(nodes.size());
+  for (int numa_node : nodes)
+    arenas.push_back(
+        make_task_arena(chain_execution_policy(*policy, numa_node)));
+  std::vector<tbb::task_group> groups(nodes.size());
+  for (std::size_t i = 0; i < num_chains; ++i) {
+    const std::size_t k = i % nodes.size();
+    arenas[k].execute([&groups, &run_chain, i, k]() {
+      groups[k].run([&run_chain, i]() { run_chain(i); });
+    });
+  }
+  for (std::size_t k = 0; k < nodes.size(); ++k)
+    arenas[k].execute([&groups, k]() { groups[k].wait(); });
+  if (chain_error)
+    std::rethrow_exception(chain_error);
+}
+
+/**
+ * Run the chains of a multi-chain service in parallel, each chain on a
+ * single thread, polling the specified interrupt of the interface
+ * through a <code>cancellable_interrupt</code> tied to the specified
+ * cancellation token.  A chain that fails or is interrupted cancels the
+ * token, so the other chains stop at their next iteration.
+ *
+ * @tparam F type of function
+ * @param[in] num_chains number of chains
+ * @param[in,out] interrupt interrupt of the interface
+ * @param[in] f function called with the index of each chain, from 0 to
+ *   <code>num_chains - 1</code>, and the interrupt the chain polls
+ * @param[in,out] cancel cancellation token shared by the chains
+ * @throw the first exception thrown by a chain, other than
+ *   <code>cancelled_error</code> if there is one, after all of the chains
+ *   have finished
+ */
+template <typename F>
+inline void parallel_chains(std::size_t num_chains,
+                            callbacks::interrupt& interrupt, F&& f,
+                            callbacks::cancellation_token& cancel) {
+  callbacks::cancellable_interrupt chain_interrupt(interrupt, cancel);
+  parallel_chains(
+      num_chains,
+      [&f, &chain_interrupt](std::size_t i) { f(i, chain_interrupt); },
+      &cancel);
+}
+
+/**
+ * Run the chains of a multi-chain service in parallel, each chain on a
+ * single thread, polling the specified interrupt of the interface, with
+ * a cancellation token of their own.
+ *
+ * @tparam F type of function
+ * @param[in] num_chains number of chains
+ * @param[in,out] interrupt interrupt of the interface
+ * @param[in] f function called with the index of each chain, from 0 to
+ *   <code>num_chains - 1</code>, and the interrupt the chain polls
+ * @throw the first exception thrown by a chain, other than
+ *   <code>cancelled_error</code> if there is one, after all of the chains
+ *   have finished
+ */
+template <typename F>
+inline void parallel_chains(std::size_t num_chains,
+                            callbacks::interrupt& interrupt, F&& f) {
+  callbacks::cancellation_token cancel;
+  parallel_chains(num_chains, interrupt, std::forward<F>(f), cancel);
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,79 @@
+#ifndef STAN_SERVICES_UTIL_PROGRESS_LOGGER_HPP
+#define STAN_SERVICES_UTIL_PROGRESS_LOGGER_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/progress.hpp>
+#include <cmath>
+#include <string>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Progress callback logging the "Iteration:" messages of the samplers,
+ * such as
+ *
+ * ```
+ * Chain [2] Iteration:  100 / 2000 [  5%]  (Warmup)
+ * ```
+ *
+ * where the chain is only named if there is more than one.  The parts
+ * that do not change between messages are formatted once, when the
+ * total number of iterations changes, and each message is assembled
+ * into a reused string.
+ */
+class progress_logger final : public callbacks::progress {
+ public:
+  /**
+   * @param[in,out] logger logger for the messages
+   * @param[in] num_chains number of chains of the run
+   */
+  explicit progress_logger(callbacks::logger& logger, size_t num_chains = 1)
+      : logger_(logger),
+        num_chains_(num_chains),
+        chain_id_(0),
+        num_iterations_(0),
+        width_(0) {}
+
+  void operator()(size_t chain_id, int iteration, int num_iterations,
+                  bool warmup) {
+    if (chain_id != chain_id_ || num_iterations != num_iterations_) {
+      chain_id_ = chain_id;
+      num_iterations_ = num_iterations;
+      prefix_ = num_chains_ != 1
+                    ? "Chain [" + std::to_string(chain_id) + "] Iteration: "
+                    : "Iteration: ";
+      width_ = std::ceil(std::log10(static_cast<double>(num_iterations)));
+      total_ = " / " + std::to_string(num_iterations) + " [";
+    }
+    message_ = prefix_;
+    append_padded(iteration, width_);
+    message_ += total_;
+    append_padded(static_cast<int>((100.0 * iteration) / num_iterations), 3);
+    message_ += warmup ? "%]  (Warmup)" : "%]  (Sampling)";
+    logger_.info(message_);
+  }
+
+ private:
+  callbacks::logger& logger_;
+  size_t num_chains_;
+  size_t chain_id_;
+  int num_iterations_;
+  int width_;
+  std::string prefix_;
+  std::string total_;
+  std::string message_;
+
+  void append_padded(int value, int width) {
+    const std::string digits = std::to_string(value);
+    if (static_cast<int>(digits.size()) < width)
+      message_.append(width - digits.size(), ' ');
+    message_ += digits;
+  }
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,61 @@
+#ifndef STAN_SERVICES_UTIL_REBIND_MODEL_HPP
+#define STAN_SERVICES_UTIL_REBIND_MODEL_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/io/var_context.hpp>
+#include <memory>
+#include <ostream>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Bind new data to a model for the next fit of a stream of refits.
+ * The data is rebound into the existing model when the model supports
+ * it, through the `rebind_data` hook of `model_base_crtp`, and the
+ * dimensions of the data are unchanged; otherwise a new model is
+ * constructed from the data, replacing the existing one, and the
+ * fallback is logged.
+ *
+ * The adapted state of the previous fit, saved in a
+ * <code>warm_start</code>, can then be handed to the next fit of the
+ * rebound model, so each refit continues from the step size, metric
+ * and position of the last.
+ *
+ * @tparam Model type of model, with the constructor of generated models
+ * @param[in,out] model model to rebind, or a null pointer to construct
+ *   the first model
+ * @param[in] data new data of the model
+ * @param[in] seed seed passed to the constructor
+ * @param[in,out] logger logger for whether the data was rebound
+ * @param[in,out] msgs stream for messages of the model
+ * @return `true` if the data was rebound into the existing model,
+ *   `false` if a new model was constructed
+ * @throw std::exception if the data is invalid for the model, in which
+ *   case a rebound model must not be used
+ */
+template <class Model>
+bool rebind_model(std::unique_ptr<Model>& model, const io::var_context& data,
+                  unsigned int seed, callbacks::logger& logger,
+                  std::ostream* msgs = nullptr) {
+  if (model) {
+    if (model->rebind_data(data, msgs)) {
+      logger.info("Rebound data into the existing model");
+      return true;
+    }
+    logger.info(
+        "Could not rebind data into the existing model, constructing a new "
+        "model");
+  }
+  // Generated models take their data by non-const reference but only
+  // read it
+  model = std::make_unique<Model>(const_cast<io::var_context&>(data), seed,
+                                  msgs);
+  return false;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
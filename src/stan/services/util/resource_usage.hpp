@@ -0,0 +1,183 @@
+#ifndef STAN_SERVICES_UTIL_RESOURCE_USAGE_HPP
+#define STAN_SERVICES_UTIL_RESOURCE_USAGE_HPP
+
+#include <stan/callbacks/structured_writer.hpp>
+#include <string>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Resource usage of the calling thread at one point of a run, taken
+ * with `getrusage`, from which the usage of a phase of the run, such
+ * as the warmup or the sampling of a chain, is the difference of the
+ * snapshots taken at its start and end, see `since`.
+ *
+ * The CPU times, context switches and page faults are those of the
+ * thread, from `RUSAGE_THREAD`, where the platform provides it, which
+ * Linux does.  Elsewhere they are not available and nothing is
+ * written, except the peak resident set size.  That one is of the
+ * whole process, as the operating system keeps no peak per thread,
+ * and is the peak since the process started rather than within the
+ * phase.  A chain runs on the thread taking the snapshots; work done
+ * for it on other threads, such as the partial sums of `reduce_sum`,
+ * is not counted, and neither is work of other tasks the thread picks
+ * up while it waits on them.
+ */
+class resource_snapshot {
+ public:
+  resource_snapshot() {}
+
+  /**
+   * Take a snapshot of the usage of the calling thread and the peak
+   * resident set size of the process.
+   */
+  static resource_snapshot current_thread() {
+    resource_snapshot snapshot;
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+      snapshot.peak_rss_bytes_ = usage.ru_maxrss;
+#else
+      snapshot.peak_rss_bytes_ = 1024LL * usage.ru_maxrss;
+#endif
+    }
+#ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+      snapshot.per_thread_ = true;
+      snapshot.user_time_ = seconds(usage.ru_utime);
+      snapshot.system_time_ = seconds(usage.ru_stime);
+      snapshot.voluntary_switches_ = usage.ru_nvcsw;
+      snapshot.involuntary_switches_ = usage.ru_nivcsw;
+      snapshot.minor_faults_ = usage.ru_minflt;
+      snapshot.major_faults_ = usage.ru_majflt;
+    }
+#endif
+#endif
+    return snapshot;
+  }
+
+  /**
+   * Return the usage of the thread since the specified earlier snapshot
+   * of the same thread, with the peak resident set size of this one.
+   *
+   * @param[in] start earlier snapshot
+   */
+  resource_snapshot since(const resource_snapshot& start) const {
+    resource_snapshot diff(*this);
+    diff.per_thread_ = per_thread_ && start.per_thread_;
+    diff.user_time_ -= start.user_time_;
+    diff.system_time_ -= start.system_time_;
+    diff.voluntary_switches_ -= start.voluntary_switches_;
+    diff.involuntary_switches_ -= start.involuntary_switches_;
+    diff.minor_faults_ -= start.minor_faults_;
+    diff.major_faults_ -= start.major_faults_;
+    return diff;
+  }
+
+  /**
+   * Return `true` if the usage of the thread is available.
+   */
+  bool per_thread() const { return per_thread_; }
+
+  /**
+   * Return the user CPU time of the thread, in seconds.
+   */
+  double user_time() const { return user_time_; }
+
+  /**
+   * Return the system CPU time of the thread, in seconds.
+   */
+  double system_time() const { return system_time_; }
+
+  /**
+   * Return the number of voluntary context switches of the thread.
+   */
+  long long voluntary_context_switches() const {  // NOLINT(runtime/int)
+    return voluntary_switches_;
+  }
+
+  /**
+   * Return the number of involuntary context switches of the thread.
+   */
+  long long involuntary_context_switches() const {  // NOLINT(runtime/int)
+    return involuntary_switches_;
+  }
+
+  /**
+   * Return the number of page faults of the thread served without I/O.
+   */
+  long long minor_page_faults() const {  // NOLINT(runtime/int)
+    return minor_faults_;
+  }
+
+  /**
+   * Return the number of page faults of the thread which required I/O.
+   */
+  long long major_page_faults() const {  // NOLINT(runtime/int)
+    return major_faults_;
+  }
+
+  /**
+   * Return the peak resident set size of the process, in bytes, or zero
+   * if it is not available.
+   */
+  long long peak_rss_bytes() const {  // NOLINT(runtime/int)
+    return peak_rss_bytes_;
+  }
+
+  /**
+   * Write the usage as a record with the specified key, holding the
+   * peak resident set size of the process and, where available, the
+   * user and system CPU times in seconds, the voluntary and involuntary
+   * context switches and the minor and major page faults of the thread.
+   * Nothing is written when neither is available.
+   *
+   * @param[in,out] writer structured writer receiving the record
+   * @param[in] key name of the record
+   */
+  void write(callbacks::structured_writer& writer,
+             const std::string& key) const {
+    if (!per_thread_ && peak_rss_bytes_ == 0)
+      return;
+    writer.begin_record(key);
+    if (peak_rss_bytes_ > 0)
+      writer.write("peak_rss_bytes", peak_rss_bytes_);
+    if (per_thread_) {
+      writer.write("user_time", user_time_);
+      writer.write("system_time", system_time_);
+      writer.write("voluntary_context_switches", voluntary_switches_);
+      writer.write("involuntary_context_switches", involuntary_switches_);
+      writer.write("minor_page_faults", minor_faults_);
+      writer.write("major_page_faults", major_faults_);
+    }
+    writer.end_record();
+  }
+
+ private:
+#if defined(__unix__) || defined(__APPLE__)
+  static double seconds(const struct timeval& t) {
+    return t.tv_sec + 1e-6 * t.tv_usec;
+  }
+#endif
+
+  bool per_thread_ = false;
+  double user_time_ = 0;
+  double system_time_ = 0;
+  long long voluntary_switches_ = 0;    // NOLINT(runtime/int)
+  long long involuntary_switches_ = 0;  // NOLINT(runtime/int)
+  long long minor_faults_ = 0;          // NOLINT(runtime/int)
+  long long major_faults_ = 0;          // NOLINT(runtime/int)
+  long long peak_rss_bytes_ = 0;        // NOLINT(runtime/int)
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,259 @@
+#ifndef STAN_SERVICES_UTIL_RUN_ADAPTIVE_CHEES_SAMPLER_HPP
+#define STAN_SERVICES_UTIL_RUN_ADAPTIVE_CHEES_SAMPLER_HPP
+
+#include <stan/analyze/mcmc/compute_nested_potential_scale_reduction.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/chees_adaptation.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/lockstep_driver.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Generates transitions of many chains of ChEES-HMC advanced in
+ * lockstep, all integrating for the same jittered time.  During warmup
+ * the shared step size, integration time and metric are adapted after
+ * every transition; after warmup the draws of every chain are kept for
+ * the nested potential scale reduction.
+ *
+ * @tparam Sampler type of sampler, e.g. diag_e_chees_hmc
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] samplers samplers, one per chain
+ * @param[in,out] driver lockstep driver batching the gradients
+ * @param[in,out] adaptation adaptation shared by the chains, or a null
+ *   pointer not to adapt
+ * @param[in] num_iterations number of transitions
+ * @param[in] start starting iteration number, also indexing the jitter
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writers writers to handle mcmc output, one per chain
+ * @param[in,out] samples current sample of each chain
+ * @param[out] draws if not null, the log density and the unconstrained
+ *   parameters of every transition, one matrix per quantity with a column
+ *   per chain
+ * @param[in] model model
+ * @param[in,out] rngs random number generators, one per chain
+ * @param[in,out] callback interrupt callback called once an iteration
+ * @param[in,out] logger logger for messages
+ */
+template <class Sampler, class Model, class RNG>
+void generate_chees_transitions(
+    std::vector<Sampler>& samplers, stan::mcmc::lockstep_driver<Model>& driver,
+    stan::mcmc::chees_adaptation* adaptation, int num_iterations, int start,
+    int finish, int num_thin, int refresh, bool save, bool warmup,
+    std::vector<util::mcmc_writer>& mcmc_writers,
+    std::vector<stan::mcmc::sample>& samples,
+    std::vector<Eigen::MatrixXd>* draws, Model& model, std::vector<RNG>& rngs,
+    callbacks::interrupt& callback, callbacks::logger& logger) {
+  for (int m = 0; m < num_iterations; ++m) {
+    callback();
+
+    if (refresh > 0
+        && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
+      int it_print_width = std::ceil(std::log10(static_cast<double>(finish)));
+      std::stringstream message;
+      message << "Iteration: ";
+      message << std::setw(it_print_width) << m + 1 + start << " / " << finish;
+      message << " [" << std::setw(3)
+              << static_cast<int>((100.0 * (start + m + 1)) / finish) << "%] ";
+      message << (warmup ? " (Warmup)" : " (Sampling)");
+
+      logger.info(message);
+    }
+
+    const double jitter = stan::mcmc::chees_adaptation::jitter(start + m);
+    for (auto& sampler : samplers)
+      sampler.set_jitter(jitter);
+    driver.transition(samplers, samples, logger);
+    if (adaptation)
+      adaptation->learn(samplers);
+
+    if (draws) {
+      for (size_t k = 0; k < samplers.size(); ++k) {
+        (*draws)[0](m, k) = samples[k].log_prob();
+        for (Eigen::Index i = 0; i < samples[k].cont_params().size(); ++i)
+          (*draws)[i + 1](m, k) = samples[k].cont_params(i);
+      }
+    }
+
+    if (save && ((m % num_thin) == 0)) {
+      for (size_t k = 0; k < samplers.size(); ++k) {
+        mcmc_writers[k].write_sample_params(rngs[k], samples[k], samplers[k],
+                                            model);
+        mcmc_writers[k].write_diagnostic_params(samples[k], samplers[k]);
+      }
+    }
+  }
+}
+
+/**
+ * Runs many chains of ChEES-HMC together, with writers for the sample,
+ * diagnostics, and the adapted hmc tuning parameters of each chain.  The
+ * chains are advanced in lockstep and share their step size, integration
+ * time and metric, adapted by <code>chees_adaptation</code> during
+ * warmup.
+ *
+ * The chains are grouped into superchains of consecutive chains, which
+ * should share their initial values.  After sampling, the nested
+ * potential scale reduction of the log density and of every
+ * unconstrained parameter is computed over the draws of all chains, and
+ * the largest is logged, as a warning if it exceeds 1.01.
+ *
+ * @tparam Sampler Type of sampler, e.g. diag_e_chees_hmc.
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @tparam SampleWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @param[in,out] samplers the mcmc samplers, one per chain
+ * @param[in,out] adaptation adaptation shared by the chains
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vectors initial parameter values of each chain
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in] num_superchains number of superchains, dividing the number
+ *   of chains
+ * @param[in,out] rngs random number generators, one per chain
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writers for draws of each chain
+ * @param[in,out] diagnostic_writer writers for diagnostic information of
+ *   each chain
+ * @param[in,out] metric_writer writers for adapted stepsize, metric of
+ *   each chain
+ * @return largest nested potential scale reduction, NaN if undefined
+ */
+template <typename Sampler, typename Model, typename RNG,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+double run_adaptive_chees_sampler(
+    std::vector<Sampler>& samplers, stan::mcmc::chees_adaptation& adaptation,
+    Model& model, std::vector<std::vector<double>>& cont_vectors,
+    int num_warmup, int num_samples, int num_thin, int refresh,
+    bool save_warmup, size_t num_superchains, std::vector<RNG>& rngs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer) {
+  const size_t num_chains = samplers.size();
+  std::vector<stan::mcmc::sample> samples;
+  samples.reserve(num_chains);
+  // Every chain finds its own initial step size, the chains starting
+  // from their geometric mean
+  double sum_log_stepsize = 0;
+  for (size_t k = 0; k < num_chains; ++k) {
+    Eigen::Map<Eigen::VectorXd> cont_params(cont_vectors[k].data(),
+                                            cont_vectors[k].size());
+    try {
+      samplers[k].z().q = cont_params;
+      samplers[k].init_stepsize(logger);
+    } catch (const std::exception& e) {
+      logger.error("Exception initializing step size.");
+      logger.error(e.what());
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    sum_log_stepsize += std::log(samplers[k].get_nominal_stepsize());
+    samples.emplace_back(cont_params, 0, 0);
+  }
+  const double stepsize = std::exp(sum_log_stepsize / num_chains);
+  for (auto& sampler : samplers)
+    sampler.set_nominal_stepsize_and_T(stepsize, stepsize);
+
+  std::vector<services::util::mcmc_writer> writers;
+  writers.reserve(num_chains);
+  for (size_t k = 0; k < num_chains; ++k) {
+    writers.emplace_back(sample_writer[k], diagnostic_writer[k], logger);
+
+    // Headers
+    writers[k].write_sample_names(samples[k], samplers[k], model);
+    writers[k].write_diagnostic_names(samples[k], samplers[k], model);
+  }
+
+  stan::mcmc::lockstep_driver<Model> driver(model);
+
+  auto start_warm = std::chrono::steady_clock::now();
+  util::generate_chees_transitions(
+      samplers, driver, &adaptation, num_warmup, 0, num_warmup + num_samples,
+      num_thin, refresh, save_warmup, true, writers, samples, nullptr, model,
+      rngs, interrupt, logger);
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+  adaptation.complete_adaptation(samplers);
+  for (size_t k = 0; k < num_chains; ++k) {
+    writers[k].write_adapt_finish(samplers[k]);
+    writers[k].write_adapted_state(samplers[k], metric_writer[k]);
+  }
+
+  std::vector<Eigen::MatrixXd> draws(model.num_params_r() + 1,
+                                     Eigen::MatrixXd(num_samples, num_chains));
+  auto start_sample = std::chrono::steady_clock::now();
+  util::generate_chees_transitions(
+      samplers, driver, nullptr, num_samples, num_warmup,
+      num_warmup + num_samples, num_thin, refresh, true, false, writers,
+      samples, &draws, model, rngs, interrupt, logger);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  for (size_t k = 0; k < num_chains; ++k)
+    writers[k].write_timing(warm_delta_t, sample_delta_t);
+
+  std::vector<std::string> names{"lp__"};
+  model.unconstrained_param_names(names, false, false);
+  double max_rhat = std::numeric_limits<double>::quiet_NaN();
+  size_t max_index = 0;
+  for (size_t i = 0; i < draws.size(); ++i) {
+    const double rhat = stan::analyze::compute_nested_potential_scale_reduction(
+        draws[i], num_superchains);
+    if (rhat > max_rhat || (std::isnan(max_rhat) && !std::isnan(rhat))) {
+      max_rhat = rhat;
+      max_index = i;
+    }
+  }
+  if (!std::isnan(max_rhat)) {
+    std::stringstream message;
+    message << "Largest nested R-hat: " << max_rhat << " (" << names[max_index]
+            << ")";
+    if (max_rhat > 1.01)
+      logger.warn(message);
+    else
+      logger.info(message);
+  }
+  return max_rhat;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
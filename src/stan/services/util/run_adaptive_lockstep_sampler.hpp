@@ -0,0 +1,191 @@
+#ifndef STAN_SERVICES_UTIL_RUN_ADAPTIVE_LOCKSTEP_SAMPLER_HPP
+#define STAN_SERVICES_UTIL_RUN_ADAPTIVE_LOCKSTEP_SAMPLER_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/lockstep_driver.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Generates MCMC transitions for several chains advanced in lockstep,
+ * so that the gradients of all chains are evaluated in one batched
+ * call per leapfrog step.
+ *
+ * @tparam Sampler type of lockstep sampler
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] samplers MCMC samplers, one per chain
+ * @param[in,out] driver lockstep driver batching the gradients
+ * @param[in] num_iterations number of MCMC transitions
+ * @param[in] start starting iteration number used for printing messages
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writers writers to handle mcmc output, one per chain
+ * @param[in,out] samples current unconstrained parameter values of each
+ *   chain, replaced with the final iteration's values
+ * @param[in] model model
+ * @param[in,out] rngs random number generators, one per chain
+ * @param[in,out] callback interrupt callback called once an iteration
+ * @param[in,out] logger logger for messages
+ */
+template <class Sampler, class Model, class RNG>
+void generate_lockstep_transitions(
+    std::vector<Sampler>& samplers, stan::mcmc::lockstep_driver<Model>& driver,
+    int num_iterations, int start, int finish, int num_thin, int refresh,
+    bool save, bool warmup, std::vector<util::mcmc_writer>& mcmc_writers,
+    std::vector<stan::mcmc::sample>& samples, Model& model,
+    std::vector<RNG>& rngs, callbacks::interrupt& callback,
+    callbacks::logger& logger) {
+  for (int m = 0; m < num_iterations; ++m) {
+    callback();
+
+    if (refresh > 0
+        && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
+      int it_print_width = std::ceil(std::log10(static_cast<double>(finish)));
+      std::stringstream message;
+      message << "Iteration: ";
+      message << std::setw(it_print_width) << m + 1 + start << " / " << finish;
+      message << " [" << std::setw(3)
+              << static_cast<int>((100.0 * (start + m + 1)) / finish) << "%] ";
+      message << (warmup ? " (Warmup)" : " (Sampling)");
+
+      logger.info(message);
+    }
+
+    driver.transition(samplers, samples, logger);
+
+    if (save && ((m % num_thin) == 0)) {
+      for (size_t k = 0; k < samplers.size(); ++k) {
+        mcmc_writers[k].write_sample_params(rngs[k], samples[k], samplers[k],
+                                            model);
+        mcmc_writers[k].write_diagnostic_params(samples[k], samplers[k]);
+      }
+    }
+  }
+}
+
+/**
+ * Runs several chains of an adaptive lockstep sampler together, with
+ * writers for the sample, diagnostics, and the adapted hmc tuning
+ * parameters of each chain.  The output of every chain has the same
+ * layout as that of run_adaptive_sampler.
+ *
+ * @tparam Sampler Type of adaptive lockstep sampler.
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @tparam SampleWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @param[in,out] samplers the mcmc samplers, one per chain
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vectors initial parameter values of each chain
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in,out] rngs random number generators, one per chain
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writers for draws of each chain
+ * @param[in,out] diagnostic_writer writers for diagnostic information of
+ *   each chain
+ * @param[in,out] metric_writer writers for adapted stepsize, metric of
+ *   each chain
+ */
+template <typename Sampler, typename Model, typename RNG,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+void run_adaptive_lockstep_sampler(
+    std::vector<Sampler>& samplers, Model& model,
+    std::vector<std::vector<double>>& cont_vectors, int num_warmup,
+    int num_samples, int num_thin, int refresh, bool save_warmup,
+    std::vector<RNG>& rngs, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer) {
+  const size_t num_chains = samplers.size();
+  std::vector<stan::mcmc::sample> samples;
+  samples.reserve(num_chains);
+  for (size_t k = 0; k < num_chains; ++k) {
+    Eigen::Map<Eigen::VectorXd> cont_params(cont_vectors[k].data(),
+                                            cont_vectors[k].size());
+    samplers[k].engage_adaptation();
+    try {
+      samplers[k].z().q = cont_params;
+      samplers[k].init_stepsize(logger);
+    } catch (const std::exception& e) {
+      logger.error("Exception initializing step size.");
+      logger.error(e.what());
+      return;
+    }
+    samples.emplace_back(cont_params, 0, 0);
+  }
+
+  std::vector<services::util::mcmc_writer> writers;
+  writers.reserve(num_chains);
+  for (size_t k = 0; k < num_chains; ++k) {
+    writers.emplace_back(sample_writer[k], diagnostic_writer[k], logger);
+
+    // Headers
+    writers[k].write_sample_names(samples[k], samplers[k], model);
+    writers[k].write_diagnostic_names(samples[k], samplers[k], model);
+  }
+
+  stan::mcmc::lockstep_driver<Model> driver(model);
+
+  auto start_warm = std::chrono::steady_clock::now();
+  util::generate_lockstep_transitions(
+      samplers, driver, num_warmup, 0, num_warmup + num_samples, num_thin,
+      refresh, save_warmup, true, writers, samples, model, rngs, interrupt,
+      logger);
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+  for (size_t k = 0; k < num_chains; ++k) {
+    samplers[k].disengage_adaptation();
+    writers[k].write_adapt_finish(samplers[k]);
+    writers[k].write_adapted_state(samplers[k], metric_writer[k]);
+  }
+
+  auto start_sample = std::chrono::steady_clock::now();
+  util::generate_lockstep_transitions(
+      samplers, driver, num_samples, num_warmup, num_warmup + num_samples,
+      num_thin, refresh, true, false, writers, samples, model, rngs, interrupt,
+      logger);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  for (size_t k = 0; k < num_chains; ++k)
+    writers[k].write_timing(warm_delta_t, sample_delta_t);
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -4,8 +4,13 @@
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/structured_writer.hpp>
 #include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/sampler_instrumentation.hpp>
+#include <stan/model/profile_data.hpp>
+#include <stan/model/tape_memory.hpp>
 #include <stan/services/util/generate_transitions.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/resource_usage.hpp>
+#include <stan/services/util/sample_output_spec.hpp>
 #include <tbb/parallel_for.h>
 #include <chrono>
 #include <iostream>
@@ -17,7 +22,26 @@ namespace util {
 
 /**
  * Runs the sampler with adaptation, with writers for the sample,
- * diagnostics, and the adapted hmc tuning parameters.
+ * diagnostics, the adapted hmc tuning parameters and the
+ * instrumentation of the chain.
+ *
+ * The instrumentation record of the chain holds its id and, for the
+ * warmup and the sampling phase, the counters and timings of
+ * stan::mcmc::sampler_instrumentation, including the peak size of the
+ * autodiff tape of its gradients.  When the profile map of the model is
+ * registered with stan::model::set_profile_data, the record also holds
+ * the totals of the <code>profile</code> blocks of the model on the
+ * thread running the chain during each phase, see
+ * stan::model::profile_snapshot.  It also holds the resource usage of
+ * the thread running the chain during each phase, its CPU times,
+ * context switches and page faults, and the peak resident set size of
+ * the process, see resource_snapshot.
+ *
+ * Before warmup, one gradient at the initial values measures the tape
+ * of the model, and twice its size is reserved in the autodiff arena of
+ * the thread running the chain, so that tapes growing during the first
+ * iterations do not stall on repeated block allocations.  The arena is
+ * per thread, so chains sharing a thread share the reservation.
  *
  * @tparam Sampler Type of adaptive sampler.
  * @tparam Model Type of model
@@ -38,10 +62,15 @@ namespace util {
  * @param[in,out] sample_writer writer for draws
  * @param[in,out] diagnostic_writer writer for diagnostic information
  * @param[in,out] metric_writer writer for adapted stepsize, metric
+ * @param[in,out] instrumentation_writer writer for the gradient
+ *   evaluation counts and per-phase timings
  * @param[in] chain_id The id for a given chain, (optional, default == 1)
  * @param[in] num_chains The number of chains used in the program. This
  *  is used in generate transitions to print out the chain number,
  *  (optional, default == 1)
+ * @param[in] output_spec columns and precision of the draws written to
+ *  the sample writer, (optional, default writes every column at full
+ *  precision)
  */
 template <typename Sampler, typename Model, typename RNG>
 void run_adaptive_sampler(Sampler& sampler, Model& model,
@@ -53,13 +82,17 @@ void run_adaptive_sampler(Sampler& sampler, Model& model,
                           callbacks::writer& sample_writer,
                           callbacks::writer& diagnostic_writer,
                           callbacks::structured_writer& metric_writer,
-                          size_t chain_id = 1, size_t num_chains = 1) {
+                          callbacks::structured_writer& instrumentation_writer,
+                          size_t chain_id = 1, size_t num_chains = 1,
+                          const sample_output_spec& output_spec
+                          = sample_output_spec()) {
   Eigen::Map<Eigen::VectorXd> cont_params(cont_vector.data(),
                                           cont_vector.size());
 
   sampler.engage_adaptation();
   try {
     sampler.z().q = cont_params;
+    stan::model::reserve_tape_from_probe(model, sampler.z().q, 2, logger);
     sampler.init_stepsize(logger);
   } catch (const std::exception& e) {
     logger.error("Exception initializing step size.");
@@ -68,38 +101,111 @@ void run_adaptive_sampler(Sampler& sampler, Model& model,
   }
 
   services::util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  writer.set_output_spec(output_spec);
   stan::mcmc::sample s(cont_params, 0, 0);
 
   // Headers
   writer.write_sample_names(s, sampler, model);
   writer.write_diagnostic_names(s, sampler, model);
 
+  // The warmup record also holds the step size initialization
+  stan::mcmc::sampler_instrumentation warmup_stats;
+  stan::mcmc::sampler_instrumentation sampling_stats;
+  double start_adaptation_time = sampler.adaptation_time();
+  auto warmup_profile = stan::model::profile_snapshot::current_thread();
+  auto warmup_resources = resource_snapshot::current_thread();
+
   auto start_warm = std::chrono::steady_clock::now();
   util::generate_transitions(sampler, num_warmup, 0, num_warmup + num_samples,
                              num_thin, refresh, save_warmup, true, writer, s,
-                             model, rng, interrupt, logger, chain_id,
-                             num_chains);
+                             model, rng, interrupt, logger, warmup_stats,
+                             chain_id, num_chains);
   auto end_warm = std::chrono::steady_clock::now();
   double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
                             end_warm - start_warm)
                             .count()
                         / 1000.0;
+  warmup_stats.adaptation_time
+      = sampler.adaptation_time() - start_adaptation_time;
   sampler.disengage_adaptation();
   writer.write_adapt_finish(sampler);
-  sampler.write_sampler_state(sample_writer);
-  sampler.write_sampler_state_struct(metric_writer);
+  writer.write_adapted_state(sampler, metric_writer);
+  auto sampling_profile = stan::model::profile_snapshot::current_thread();
+  auto sampling_resources = resource_snapshot::current_thread();
 
   auto start_sample = std::chrono::steady_clock::now();
   util::generate_transitions(sampler, num_samples, num_warmup,
                              num_warmup + num_samples, num_thin, refresh, true,
                              false, writer, s, model, rng, interrupt, logger,
-                             chain_id, num_chains);
+                             sampling_stats, chain_id, num_chains);
   auto end_sample = std::chrono::steady_clock::now();
   double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
                               end_sample - start_sample)
                               .count()
                           / 1000.0;
   writer.write_timing(warm_delta_t, sample_delta_t);
+  auto end_profile = stan::model::profile_snapshot::current_thread();
+  auto end_resources = resource_snapshot::current_thread();
+
+  instrumentation_writer.begin_record();
+  instrumentation_writer.write("chain_id", chain_id);
+  warmup_stats.write(instrumentation_writer, "warmup");
+  sampling_stats.write(instrumentation_writer, "sampling");
+  sampling_profile.since(warmup_profile)
+      .write(instrumentation_writer, "warmup_profile");
+  end_profile.since(sampling_profile)
+      .write(instrumentation_writer, "sampling_profile");
+  sampling_resources.since(warmup_resources)
+      .write(instrumentation_writer, "warmup_resources");
+  end_resources.since(sampling_resources)
+      .write(instrumentation_writer, "sampling_resources");
+  instrumentation_writer.end_record();
+}
+
+/**
+ * Runs the sampler with adaptation, with writers for the sample,
+ * diagnostics, and the adapted hmc tuning parameters.
+ *
+ * @tparam Sampler Type of adaptive sampler.
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @param[in,out] sampler the mcmc sampler to use on the model
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vector initial parameter values
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in,out] rng random number generator
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writer for draws
+ * @param[in,out] diagnostic_writer writer for diagnostic information
+ * @param[in,out] metric_writer writer for adapted stepsize, metric
+ * @param[in] chain_id The id for a given chain, (optional, default == 1)
+ * @param[in] num_chains The number of chains used in the program. This
+ *  is used in generate transitions to print out the chain number,
+ *  (optional, default == 1)
+ */
+template <typename Sampler, typename Model, typename RNG>
+void run_adaptive_sampler(Sampler& sampler, Model& model,
+                          std::vector<double>& cont_vector, int num_warmup,
+                          int num_samples, int num_thin, int refresh,
+                          bool save_warmup, RNG& rng,
+                          callbacks::interrupt& interrupt,
+                          callbacks::logger& logger,
+                          callbacks::writer& sample_writer,
+                          callbacks::writer& diagnostic_writer,
+                          callbacks::structured_writer& metric_writer,
+                          size_t chain_id = 1, size_t num_chains = 1) {
+  callbacks::structured_writer dummy_instrumentation_writer;
+  return run_adaptive_sampler(
+      sampler, model, cont_vector, num_warmup, num_samples, num_thin, refresh,
+      save_warmup, rng, interrupt, logger, sample_writer, diagnostic_writer,
+      metric_writer, dummy_instrumentation_writer, chain_id, num_chains);
 }
 
 /**
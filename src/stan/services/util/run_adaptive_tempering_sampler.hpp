@@ -0,0 +1,218 @@
+#ifndef STAN_SERVICES_UTIL_RUN_ADAPTIVE_TEMPERING_SAMPLER_HPP
+#define STAN_SERVICES_UTIL_RUN_ADAPTIVE_TEMPERING_SAMPLER_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/replica_exchange.hpp>
+#include <stan/mcmc/sample.hpp>
+#include <stan/mcmc/smc/tempered_model.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Generates MCMC transitions of the replicas of parallel tempering.
+ * Every iteration makes one transition of each replica, in parallel,
+ * then writes the state of the first replica, at inverse temperature
+ * 1, and every <code>swap_every</code> iterations makes a round of
+ * swaps between the replicas.
+ *
+ * @tparam Sampler type of sampler of the tempered models
+ * @tparam Model model class
+ * @tparam RNG random number generator class
+ * @param[in,out] samplers samplers of the replicas
+ * @param[in] tempered tempered models of the replicas
+ * @param[in,out] exchange swap moves between the replicas
+ * @param[in] swap_every number of iterations between rounds of swaps
+ * @param[in] num_iterations number of MCMC transitions
+ * @param[in] start starting iteration number used for printing messages
+ * @param[in] finish end iteration number used for printing messages
+ * @param[in] num_thin when save is true, a draw will be written to the
+ *   mcmc_writer every num_thin iterations
+ * @param[in] refresh number of iterations to print a message. If
+ *   refresh is zero, iteration number messages will not be printed
+ * @param[in] save if save is true, the transitions will be written
+ *   to the mcmc_writer. If false, transitions will not be written
+ * @param[in] warmup indicates whether these transitions are warmup. Used
+ *   for printing iteration number messages
+ * @param[in,out] mcmc_writer writer of the first replica
+ * @param[in,out] samples current state of each replica, replaced with
+ *   the final iteration's values
+ * @param[in] model model
+ * @param[in,out] rng random number generator of the first replica
+ * @param[in,out] swap_rng random number generator of the swaps
+ * @param[in,out] callback interrupt callback called once an iteration
+ * @param[in,out] logger logger for messages
+ */
+template <class Sampler, class Model, class RNG>
+void generate_tempering_transitions(
+    std::vector<Sampler>& samplers,
+    const std::vector<stan::mcmc::tempered_model<Model>>& tempered,
+    stan::mcmc::replica_exchange& exchange, int swap_every,
+    int num_iterations, int start, int finish, int num_thin, int refresh,
+    bool save, bool warmup, util::mcmc_writer& mcmc_writer,
+    std::vector<stan::mcmc::sample>& samples, Model& model, RNG& rng,
+    RNG& swap_rng, callbacks::interrupt& callback, callbacks::logger& logger) {
+  const size_t num_replicas = samplers.size();
+  Eigen::VectorXd log_ratio(num_replicas);
+  for (int m = 0; m < num_iterations; ++m) {
+    callback();
+
+    if (refresh > 0
+        && (start + m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
+      int it_print_width = std::ceil(std::log10(static_cast<double>(finish)));
+      std::stringstream message;
+      message << "Iteration: ";
+      message << std::setw(it_print_width) << m + 1 + start << " / " << finish;
+      message << " [" << std::setw(3)
+              << static_cast<int>((100.0 * (start + m + 1)) / finish) << "%] ";
+      message << (warmup ? " (Warmup)" : " (Sampling)");
+
+      logger.info(message);
+    }
+
+    const bool swap = (start + m + 1) % swap_every == 0;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_replicas),
+                      [&](const tbb::blocked_range<size_t>& r) {
+                        for (size_t k = r.begin(); k < r.end(); ++k) {
+                          samples[k] = samplers[k].transition(samples[k],
+                                                              logger);
+                          if (swap) {
+                            Eigen::VectorXd q = samples[k].cont_params();
+                            log_ratio(k) = tempered[k].log_density_ratio(q);
+                          }
+                        }
+                      });
+
+    if (save && ((m % num_thin) == 0)) {
+      mcmc_writer.write_sample_params(rng, samples[0], samplers[0], model);
+      mcmc_writer.write_diagnostic_params(samples[0], samplers[0]);
+    }
+
+    // The first replica is written before the swaps, so that its draws
+    // come with the log density and diagnostics of its own transition
+    if (swap)
+      exchange.exchange(samples, log_ratio, swap_rng);
+  }
+}
+
+/**
+ * Runs parallel tempering with adaptive samplers, one per replica,
+ * writing the draws, diagnostics and adapted tuning parameters of the
+ * first replica, whose tempered model is the posterior.  Each replica
+ * adapts its own step size and metric during warmup, and swaps are
+ * made during warmup and sampling.  The swap rate between every pair
+ * of neighbouring replicas during sampling is logged at the end.
+ *
+ * @tparam Sampler Type of adaptive sampler of the tempered models
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @param[in,out] samplers the mcmc samplers, one per replica
+ * @param[in] tempered tempered models of the replicas
+ * @param[in,out] exchange swap moves between the replicas
+ * @param[in] swap_every number of iterations between rounds of swaps
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vectors initial parameter values of each replica
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in,out] rngs random number generators, one per replica
+ * @param[in,out] swap_rng random number generator of the swaps
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writer for draws
+ * @param[in,out] diagnostic_writer writer for diagnostic information
+ * @param[in,out] metric_writer writer for adapted stepsize, metric
+ */
+template <typename Sampler, typename Model, typename RNG>
+void run_adaptive_tempering_sampler(
+    std::vector<Sampler>& samplers,
+    const std::vector<stan::mcmc::tempered_model<Model>>& tempered,
+    stan::mcmc::replica_exchange& exchange, int swap_every, Model& model,
+    std::vector<std::vector<double>>& cont_vectors, int num_warmup,
+    int num_samples, int num_thin, int refresh, bool save_warmup,
+    std::vector<RNG>& rngs, RNG& swap_rng, callbacks::interrupt& interrupt,
+    callbacks::logger& logger, callbacks::writer& sample_writer,
+    callbacks::writer& diagnostic_writer,
+    callbacks::structured_writer& metric_writer) {
+  const size_t num_replicas = samplers.size();
+  std::vector<stan::mcmc::sample> samples;
+  samples.reserve(num_replicas);
+  for (size_t k = 0; k < num_replicas; ++k) {
+    Eigen::Map<Eigen::VectorXd> cont_params(cont_vectors[k].data(),
+                                            cont_vectors[k].size());
+    samplers[k].engage_adaptation();
+    try {
+      samplers[k].z().q = cont_params;
+      samplers[k].init_stepsize(logger);
+    } catch (const std::exception& e) {
+      logger.error("Exception initializing step size.");
+      logger.error(e.what());
+      return;
+    }
+    samples.emplace_back(cont_params, 0, 0);
+  }
+
+  services::util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+
+  // Headers
+  writer.write_sample_names(samples[0], samplers[0], model);
+  writer.write_diagnostic_names(samples[0], samplers[0], model);
+
+  auto start_warm = std::chrono::steady_clock::now();
+  util::generate_tempering_transitions(
+      samplers, tempered, exchange, swap_every, num_warmup, 0,
+      num_warmup + num_samples, num_thin, refresh, save_warmup, true, writer,
+      samples, model, rngs[0], swap_rng, interrupt, logger);
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+  for (size_t k = 0; k < num_replicas; ++k)
+    samplers[k].disengage_adaptation();
+  writer.write_adapt_finish(samplers[0]);
+  writer.write_adapted_state(samplers[0], metric_writer);
+  exchange.reset_counters();
+
+  auto start_sample = std::chrono::steady_clock::now();
+  util::generate_tempering_transitions(
+      samplers, tempered, exchange, swap_every, num_samples, num_warmup,
+      num_warmup + num_samples, num_thin, refresh, true, false, writer,
+      samples, model, rngs[0], swap_rng, interrupt, logger);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  writer.write_timing(warm_delta_t, sample_delta_t);
+
+  for (size_t k = 0; k + 1 < num_replicas; ++k) {
+    std::stringstream message;
+    message << "Swap rate between inverse temperatures "
+            << exchange.inverse_temperature(k) << " and "
+            << exchange.inverse_temperature(k + 1) << ": "
+            << exchange.swap_rate(k);
+    logger.info(message);
+  }
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
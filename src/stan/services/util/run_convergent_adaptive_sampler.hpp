@@ -0,0 +1,170 @@
+#ifndef STAN_SERVICES_UTIL_RUN_CONVERGENT_ADAPTIVE_SAMPLER_HPP
+#define STAN_SERVICES_UTIL_RUN_CONVERGENT_ADAPTIVE_SAMPLER_HPP
+
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/mcmc/warmup_convergence_monitor.hpp>
+#include <stan/services/util/generate_transitions.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/progress_logger.hpp>
+#include <stan/services/util/window_schedule.hpp>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Runs the sampler with adaptation, ending the warmup early once the
+ * adaptation has converged.  At the end of every slow adaptation window
+ * the adapted metric, the dual averaging estimate of the log step size
+ * and the lp__ draws of the window are passed to the monitor.  Once
+ * the monitor reports them stable, the remaining slow windows are
+ * skipped and only the terminal fast interval is run, so the number of
+ * warmup draws written is then smaller than num_warmup.
+ *
+ * For a low rank metric only its diagonal part is monitored.
+ *
+ * @tparam Sampler Type of adaptive sampler, derived from
+ *   stan::mcmc::stepsize_var_adapter, stan::mcmc::stepsize_covar_adapter
+ *   or stan::mcmc::stepsize_lowrank_adapter
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @param[in,out] sampler the mcmc sampler to use on the model
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vector initial parameter values
+ * @param[in] num_warmup maximum number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in,out] monitor convergence criteria of the adaptation, restarted
+ *   before the warmup
+ * @param[in,out] rng random number generator
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writer for draws
+ * @param[in,out] diagnostic_writer writer for diagnostic information
+ * @param[in,out] metric_writer writer for adapted stepsize, metric
+ * @param[in] chain_id The id for a given chain, (optional, default == 1)
+ * @param[in] num_chains The number of chains used in the program. This
+ *  is used in generate transitions to print out the chain number,
+ *  (optional, default == 1)
+ * @return number of warmup iterations run
+ */
+template <typename Sampler, typename Model, typename RNG>
+int run_convergent_adaptive_sampler(
+    Sampler& sampler, Model& model, std::vector<double>& cont_vector,
+    int num_warmup, int num_samples, int num_thin, int refresh,
+    bool save_warmup, stan::mcmc::warmup_convergence_monitor& monitor,
+    RNG& rng, callbacks::interrupt& interrupt, callbacks::logger& logger,
+    callbacks::writer& sample_writer, callbacks::writer& diagnostic_writer,
+    callbacks::structured_writer& metric_writer, size_t chain_id = 1,
+    size_t num_chains = 1) {
+  Eigen::Map<Eigen::VectorXd> cont_params(cont_vector.data(),
+                                          cont_vector.size());
+
+  sampler.engage_adaptation();
+  try {
+    sampler.z().q = cont_params;
+    sampler.init_stepsize(logger);
+  } catch (const std::exception& e) {
+    logger.error("Exception initializing step size.");
+    logger.error(e.what());
+    return 0;
+  }
+
+  services::util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  stan::mcmc::sample s(cont_params, 0, 0);
+
+  // Headers
+  writer.write_sample_names(s, sampler, model);
+  writer.write_diagnostic_names(s, sampler, model);
+
+  monitor.restart();
+  std::vector<double> window_lp;
+  progress_logger progress(logger, num_chains);
+  int warmup_end = num_warmup;
+  int iteration = 0;
+  auto start_warm = std::chrono::steady_clock::now();
+  while (iteration < warmup_end) {
+    int to_window_end
+        = internal::window_schedule(sampler).iterations_to_window_end();
+    int num_iterations = warmup_end - iteration;
+    if (to_window_end > 0 && to_window_end < num_iterations)
+      num_iterations = to_window_end;
+
+    window_lp.clear();
+    double log_stepsize = 0;
+    for (int m = iteration; m < iteration + num_iterations; ++m) {
+      interrupt();
+
+      int finish = warmup_end + num_samples;
+      if (refresh > 0
+          && (m + 1 == finish || m == 0 || (m + 1) % refresh == 0))
+        progress(chain_id, m + 1, finish, true);
+
+      // The step size adaptation restarts when the window closes
+      log_stepsize = sampler.get_stepsize_adaptation().get_x_bar();
+      s = sampler.transition(s, logger);
+      window_lp.push_back(s.log_prob());
+
+      if (save_warmup && ((m % num_thin) == 0)) {
+        writer.write_sample_params(rng, s, sampler, model);
+        writer.write_diagnostic_params(s, sampler);
+      }
+    }
+    iteration += num_iterations;
+
+    // Nothing to skip after the last slow window
+    if (num_iterations != to_window_end
+        || internal::window_schedule(sampler).iterations_to_window_end() == 0)
+      continue;
+
+    if (monitor.end_window(sampler.z().inv_e_metric_, log_stepsize,
+                           window_lp)) {
+      warmup_end
+          = iteration + internal::window_schedule(sampler).end_slow_adaptation();
+      std::stringstream message;
+      message << "Adaptation converged after " << iteration
+              << " warmup iterations (metric change = "
+              << monitor.metric_change()
+              << ", step size change = " << monitor.stepsize_change()
+              << ", lp__ R-hat = " << monitor.lp_rhat() << ");"
+              << " ending warmup after " << warmup_end << " iterations.";
+      logger.info(message);
+    }
+  }
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+  sampler.disengage_adaptation();
+  writer.write_adapt_finish(sampler);
+  writer.write_adapted_state(sampler, metric_writer);
+
+  auto start_sample = std::chrono::steady_clock::now();
+  util::generate_transitions(sampler, num_samples, warmup_end,
+                             warmup_end + num_samples, num_thin, refresh, true,
+                             false, writer, s, model, rng, interrupt, logger,
+                             chain_id, num_chains);
+  auto end_sample = std::chrono::steady_clock::now();
+  double sample_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              end_sample - start_sample)
+                              .count()
+                          / 1000.0;
+  writer.write_timing(warm_delta_t, sample_delta_t);
+  return warmup_end;
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
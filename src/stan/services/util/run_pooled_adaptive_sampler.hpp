@@ -0,0 +1,349 @@
+#ifndef STAN_SERVICES_UTIL_RUN_POOLED_ADAPTIVE_SAMPLER_HPP
+#define STAN_SERVICES_UTIL_RUN_POOLED_ADAPTIVE_SAMPLER_HPP
+
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/logger.hpp>
+#include <stan/mcmc/chain_reducer.hpp>
+#include <stan/mcmc/stepsize_covar_adapter.hpp>
+#include <stan/mcmc/stepsize_var_adapter.hpp>
+#include <stan/services/util/generate_transitions.hpp>
+#include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/window_schedule.hpp>
+#include <tbb/parallel_for.h>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+namespace internal {
+
+/**
+ * Set the metric of every sampler to the variance pooled over the last
+ * completed adaptation window of all of them and of the chains of the
+ * other processes.
+ */
+template <class Sampler, class Reducer>
+void pool_window_metric(std::vector<Sampler>& samplers,
+                        stan::mcmc::stepsize_var_adapter*,
+                        const Reducer& reducer) {
+  std::vector<stan::mcmc::var_adaptation*> adaptations;
+  for (auto& sampler : samplers)
+    adaptations.push_back(&sampler.get_var_adaptation());
+  Eigen::VectorXd inv_metric = samplers[0].z().inv_e_metric_;
+  stan::mcmc::var_adaptation::pool_windows(inv_metric, adaptations,
+                                             reducer);
+  for (auto& sampler : samplers)
+    sampler.set_metric(inv_metric);
+}
+
+/**
+ * Set the metric of every sampler to the covariance pooled over the
+ * last completed adaptation window of all of them.
+ */
+template <class Sampler, class Reducer>
+void pool_window_metric(std::vector<Sampler>& samplers,
+                        stan::mcmc::stepsize_covar_adapter*,
+                        const Reducer& reducer) {
+  std::vector<stan::mcmc::covar_adaptation*> adaptations;
+  for (auto& sampler : samplers)
+    adaptations.push_back(&sampler.get_covar_adaptation());
+  Eigen::MatrixXd inv_metric = samplers[0].z().inv_e_metric_;
+  stan::mcmc::covar_adaptation::pool_windows(inv_metric, adaptations,
+                                             reducer);
+  for (auto& sampler : samplers)
+    sampler.set_metric(inv_metric);
+}
+
+/**
+ * Return the geometric mean of the nominal step sizes of the samplers
+ * of every process.
+ */
+template <class Sampler, class Reducer>
+double pooled_stepsize(const std::vector<Sampler>& samplers,
+                       const Reducer& reducer) {
+  double log_stepsize = 0;
+  for (const auto& sampler : samplers)
+    log_stepsize += std::log(sampler.get_nominal_stepsize());
+  double num_chains = samplers.size();
+  reducer.sum(log_stepsize);
+  reducer.sum(num_chains);
+  return std::exp(log_stepsize / num_chains);
+}
+
+/**
+ * Return the split potential scale reduction of the lp__ draws of a
+ * window over the chains of every process.
+ */
+template <class Reducer>
+double pooled_lp_rhat(const std::vector<std::vector<double>>& window_lp,
+                      int num_iterations, const Reducer& reducer) {
+  double num_chains = window_lp.size();
+  reducer.sum(num_chains);
+  size_t offset = reducer.chain_offset(window_lp.size());
+  Eigen::MatrixXd lp = Eigen::MatrixXd::Zero(num_iterations, num_chains);
+  for (size_t i = 0; i < window_lp.size(); ++i)
+    lp.col(offset + i)
+        = Eigen::Map<const Eigen::VectorXd>(window_lp[i].data(), num_iterations);
+  reducer.sum(lp);
+  std::vector<const double*> lp_draws;
+  for (Eigen::Index i = 0; i < lp.cols(); ++i)
+    lp_draws.push_back(lp.col(i).data());
+  return stan::analyze::compute_split_potential_scale_reduction(
+      lp_draws, num_iterations);
+}
+
+}  // namespace internal
+
+/**
+ * Runs several chains of an adaptive sampler with a cooperative
+ * warmup.  The chains advance in parallel up to the end of each slow
+ * adaptation window and synchronize there: every metric is replaced by
+ * the estimate pooled over the draws of all chains in the window, and
+ * every chain restarts its step size adaptation from a common step
+ * size.  After the warmup the adapted step sizes are replaced by their
+ * geometric mean, so all chains sample with the same tuning
+ * parameters.
+ *
+ * If max_warmup_rhat is positive, the warmup ends early once the split
+ * potential scale reduction of lp__ over the draws of a completed
+ * window falls below it: the remaining slow windows are skipped and
+ * only the terminal fast interval is run.  The number of warmup draws
+ * written is then smaller than num_warmup.
+ *
+ * The chains may be spread over several processes, each calling this
+ * function for its own chains with the same settings; the reducer then
+ * pools the window estimates, step sizes and lp__ draws over all of
+ * them.  If any process fails to initialize a step size, every process
+ * returns before sampling.
+ *
+ * @tparam Sampler Type of adaptive sampler, derived from
+ *   stan::mcmc::stepsize_var_adapter or stan::mcmc::stepsize_covar_adapter
+ * @tparam Model Type of model
+ * @tparam RNG Type of random number generator
+ * @tparam SampleWriter A type derived from `stan::callbacks::writer`
+ * @tparam DiagnosticWriter A type derived from `stan::callbacks::writer`
+ * @tparam MetricWriter A type derived from `stan::callbacks::structured_writer`
+ * @tparam Reducer Type of the reduction over processes, such as
+ *   stan::mcmc::local_chain_reducer
+ * @param[in,out] samplers the mcmc samplers, one per chain, with the
+ *   same window parameters
+ * @param[in] model the model concept to use for computing log probability
+ * @param[in] cont_vectors initial parameter values of each chain
+ * @param[in] num_warmup number of warmup draws
+ * @param[in] num_samples number of post warmup draws
+ * @param[in] num_thin number to thin the draws. Must be greater than
+ *   or equal to 1.
+ * @param[in] refresh controls output to the <code>logger</code>
+ * @param[in] save_warmup indicates whether the warmup draws should be
+ *   sent to the sample writer
+ * @param[in] max_warmup_rhat threshold of the potential scale reduction
+ *   of lp__ below which the warmup ends early, or zero to run the full
+ *   warmup
+ * @param[in,out] rngs random number generator of each chain
+ * @param[in,out] interrupt interrupt callback
+ * @param[in,out] logger logger for messages
+ * @param[in,out] sample_writer writer for draws of each chain
+ * @param[in,out] diagnostic_writer writer for diagnostic information of
+ *   each chain
+ * @param[in,out] metric_writer writer for adapted stepsize, metric of
+ *   each chain
+ * @param[in] init_chain_id id of the first chain of this process
+ * @param[in] reducer reduction over the processes running the chains
+ */
+template <typename Sampler, typename Model, typename RNG,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter, typename Reducer>
+void run_pooled_adaptive_sampler(
+    std::vector<Sampler>& samplers, Model& model,
+    std::vector<std::vector<double>>& cont_vectors, int num_warmup,
+    int num_samples, int num_thin, int refresh, bool save_warmup,
+    double max_warmup_rhat, std::vector<RNG>& rngs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer, size_t init_chain_id,
+    const Reducer& reducer) {
+  const size_t num_chains = samplers.size();
+  std::vector<services::util::mcmc_writer> writers;
+  writers.reserve(num_chains);
+  std::vector<stan::mcmc::sample> draws;
+  draws.reserve(num_chains);
+  double num_failed = 0;
+  for (size_t i = 0; i < num_chains && num_failed == 0; ++i) {
+    Eigen::Map<Eigen::VectorXd> cont_params(cont_vectors[i].data(),
+                                            cont_vectors[i].size());
+    samplers[i].engage_adaptation();
+    try {
+      samplers[i].z().q = cont_params;
+      samplers[i].init_stepsize(logger);
+    } catch (const std::exception& e) {
+      logger.error("Exception initializing step size.");
+      logger.error(e.what());
+      num_failed = 1;
+    }
+  }
+  // Every process returns if any of them failed
+  reducer.sum(num_failed);
+  if (num_failed > 0)
+    return;
+  for (size_t i = 0; i < num_chains; ++i) {
+    Eigen::Map<Eigen::VectorXd> cont_params(cont_vectors[i].data(),
+                                            cont_vectors[i].size());
+    writers.emplace_back(sample_writer[i], diagnostic_writer[i], logger);
+    draws.emplace_back(cont_params, 0, 0);
+    writers[i].write_sample_names(draws[i], samplers[i], model);
+    writers[i].write_diagnostic_names(draws[i], samplers[i], model);
+  }
+
+  std::vector<std::vector<double>> window_lp(num_chains);
+  int warmup_end = num_warmup;
+  int iteration = 0;
+  auto start_warm = std::chrono::steady_clock::now();
+  while (iteration < warmup_end) {
+    int to_window_end
+        = internal::window_schedule(samplers[0]).iterations_to_window_end();
+    int num_iterations = warmup_end - iteration;
+    if (to_window_end > 0 && to_window_end < num_iterations)
+      num_iterations = to_window_end;
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_chains, 1),
+        [&](const tbb::blocked_range<size_t>& r) {
+          for (size_t i = r.begin(); i != r.end(); ++i) {
+            window_lp[i].clear();
+            for (int m = iteration; m < iteration + num_iterations; ++m) {
+              interrupt();
+
+              int finish = warmup_end + num_samples;
+              if (refresh > 0
+                  && (m + 1 == finish || m == 0 || (m + 1) % refresh == 0)) {
+                int it_print_width
+                    = std::ceil(std::log10(static_cast<double>(finish)));
+                std::stringstream message;
+                if (num_chains != 1) {
+                  message << "Chain [" << init_chain_id + i << "] ";
+                }
+                message << "Iteration: ";
+                message << std::setw(it_print_width) << m + 1 << " / "
+                        << finish;
+                message << " [" << std::setw(3)
+                        << static_cast<int>((100.0 * (m + 1)) / finish)
+                        << "%] ";
+                message << " (Warmup)";
+                logger.info(message);
+              }
+
+              draws[i] = samplers[i].transition(draws[i], logger);
+              window_lp[i].push_back(draws[i].log_prob());
+
+              if (save_warmup && ((m % num_thin) == 0)) {
+                writers[i].write_sample_params(rngs[i], draws[i], samplers[i],
+                                               model);
+                writers[i].write_diagnostic_params(draws[i], samplers[i]);
+              }
+            }
+          }
+        },
+        tbb::simple_partitioner());
+    iteration += num_iterations;
+
+    if (num_iterations != to_window_end)
+      continue;
+
+    // Every chain closed the same window
+    internal::pool_window_metric(samplers, &samplers[0], reducer);
+    for (auto& sampler : samplers)
+      sampler.init_stepsize(logger);
+    double stepsize = internal::pooled_stepsize(samplers, reducer);
+    for (auto& sampler : samplers) {
+      sampler.set_nominal_stepsize(stepsize);
+      sampler.get_stepsize_adaptation().set_mu(log(10 * stepsize));
+      sampler.get_stepsize_adaptation().restart();
+    }
+
+    if (max_warmup_rhat > 0
+        && internal::window_schedule(samplers[0]).iterations_to_window_end()
+               > 0) {
+      double rhat
+          = internal::pooled_lp_rhat(window_lp, num_iterations, reducer);
+      if (rhat < max_warmup_rhat) {
+        int remaining = 0;
+        for (auto& sampler : samplers)
+          remaining = internal::window_schedule(sampler).end_slow_adaptation();
+        warmup_end = iteration + remaining;
+        std::stringstream message;
+        message << "Potential scale reduction of lp__ = " << rhat
+                << " after " << iteration << " warmup iterations;"
+                << " ending warmup after " << warmup_end << " iterations.";
+        logger.info(message);
+      }
+    }
+  }
+  auto end_warm = std::chrono::steady_clock::now();
+  double warm_delta_t = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            end_warm - start_warm)
+                            .count()
+                        / 1000.0;
+
+  for (auto& sampler : samplers)
+    sampler.disengage_adaptation();
+  double stepsize = internal::pooled_stepsize(samplers, reducer);
+  for (size_t i = 0; i < num_chains; ++i) {
+    samplers[i].set_nominal_stepsize(stepsize);
+    writers[i].write_adapt_finish(samplers[i]);
+    writers[i].write_adapted_state(samplers[i], metric_writer[i]);
+  }
+
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>(0, num_chains, 1),
+      [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+          auto start_sample = std::chrono::steady_clock::now();
+          util::generate_transitions(
+              samplers[i], num_samples, warmup_end, warmup_end + num_samples,
+              num_thin, refresh, true, false, writers[i], draws[i], model,
+              rngs[i], interrupt, logger, init_chain_id + i, num_chains);
+          auto end_sample = std::chrono::steady_clock::now();
+          double sample_delta_t
+              = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    end_sample - start_sample)
+                    .count()
+                / 1000.0;
+          writers[i].write_timing(warm_delta_t, sample_delta_t);
+        }
+      },
+      tbb::simple_partitioner());
+}
+
+/**
+ * Runs several chains of an adaptive sampler with a cooperative
+ * warmup, all in this process.  See the overload taking a reducer.
+ */
+template <typename Sampler, typename Model, typename RNG,
+          typename SampleWriter, typename DiagnosticWriter,
+          typename MetricWriter>
+void run_pooled_adaptive_sampler(
+    std::vector<Sampler>& samplers, Model& model,
+    std::vector<std::vector<double>>& cont_vectors, int num_warmup,
+    int num_samples, int num_thin, int refresh, bool save_warmup,
+    double max_warmup_rhat, std::vector<RNG>& rngs,
+    callbacks::interrupt& interrupt, callbacks::logger& logger,
+    std::vector<SampleWriter>& sample_writer,
+    std::vector<DiagnosticWriter>& diagnostic_writer,
+    std::vector<MetricWriter>& metric_writer, size_t init_chain_id = 1) {
+  run_pooled_adaptive_sampler(samplers, model, cont_vectors, num_warmup,
+                              num_samples, num_thin, refresh, save_warmup,
+                              max_warmup_rhat, rngs, interrupt, logger,
+                              sample_writer, diagnostic_writer, metric_writer,
+                              init_chain_id, stan::mcmc::local_chain_reducer());
+}
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
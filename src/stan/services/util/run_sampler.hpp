@@ -5,6 +5,7 @@
 #include <stan/callbacks/writer.hpp>
 #include <stan/services/util/generate_transitions.hpp>
 #include <stan/services/util/mcmc_writer.hpp>
+#include <stan/services/util/sample_output_spec.hpp>
 #include <chrono>
 #include <vector>
 
@@ -35,6 +36,8 @@ namespace util {
  * @param[in] chain_id The id for a given chain.
  * @param[in] num_chains The number of chains used in the program. This
  *  is used in generate transitions to print out the chain number.
+ * @param[in] output_spec columns and precision of the draws written to
+ *  the sample writer
  */
 template <class Model, class RNG>
 void run_sampler(stan::mcmc::base_mcmc& sampler, Model& model,
@@ -43,10 +46,12 @@ void run_sampler(stan::mcmc::base_mcmc& sampler, Model& model,
                  RNG& rng, callbacks::interrupt& interrupt,
                  callbacks::logger& logger, callbacks::writer& sample_writer,
                  callbacks::writer& diagnostic_writer, size_t chain_id = 1,
-                 size_t num_chains = 1) {
+                 size_t num_chains = 1,
+                 const sample_output_spec& output_spec = sample_output_spec()) {
   Eigen::Map<Eigen::VectorXd> cont_params(cont_vector.data(),
                                           cont_vector.size());
   services::util::mcmc_writer writer(sample_writer, diagnostic_writer, logger);
+  writer.set_output_spec(output_spec);
   stan::mcmc::sample s(cont_params, 0, 0);
 
   // Headers
@@ -0,0 +1,73 @@
+#ifndef STAN_SERVICES_UTIL_SAMPLE_OUTPUT_SPEC_HPP
+#define STAN_SERVICES_UTIL_SAMPLE_OUTPUT_SPEC_HPP
+
+#include <stan/mcmc/diagnostic_fields.hpp>
+#include <stan/model/model_metadata.hpp>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Specification of the columns written for each draw by
+ * <code>mcmc_writer</code> and of their precision.
+ *
+ * The default specification writes every column at full precision.
+ */
+struct sample_output_spec {
+  /**
+   * Names of the columns to write.  A name selects the column with
+   * that name and, for a container, all of its elements, so that
+   * <code>beta</code> selects <code>beta.1</code>,
+   * <code>beta.2</code>, ...  The selected columns keep their order;
+   * empty selects every column.
+   */
+  std::vector<std::string> columns;
+
+  /**
+   * Whether the transformed parameters are computed and written.
+   */
+  bool include_tparams = true;
+
+  /**
+   * Whether the generated quantities are computed and written.
+   */
+  bool include_gqs = true;
+
+  /**
+   * Number of significant digits the values of the sample and sampler
+   * columns, such as <code>lp__</code> and
+   * <code>stepsize__</code>, are rounded to; zero keeps them at full
+   * precision.
+   */
+  int sampler_digits = 0;
+
+  /**
+   * Number of significant digits the values of the model columns are
+   * rounded to; zero keeps them at full precision.  Seven digits is
+   * about the precision of a single precision float.
+   */
+  int model_digits = 0;
+
+  /**
+   * Blocks of the phase space state of HMC samplers written to the
+   * diagnostic writer after the sampler columns.  With a
+   * <code>callbacks::binary_writer</code> as the diagnostic writer the
+   * selected blocks are stored without formatting them as text.
+   */
+  stan::mcmc::diagnostic_fields diagnostic_fields;
+
+  /**
+   * Names of the model built once, shared by the writers of every
+   * chain given this specification, or null to ask the model for its
+   * names in each writer.  It must outlive the writers.
+   */
+  const stan::model::model_metadata* metadata = nullptr;
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,272 @@
+#ifndef STAN_SERVICES_UTIL_SAMPLING_TARGET_HPP
+#define STAN_SERVICES_UTIL_SAMPLING_TARGET_HPP
+
+#include <stan/analyze/mcmc/online_convergence_monitor.hpp>
+#include <stan/callbacks/cancellation_token.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Convergence target of a sampler run until it is reached, with the
+ * number of draws as an upper bound.  The target is reached once every
+ * monitored parameter has at least <code>min_ess</code> effective draws
+ * and a split potential scale reduction of at most
+ * <code>max_rhat</code>, as estimated over all chains by
+ * <code>analyze::online_convergence_monitor</code>.
+ */
+struct sampling_target {
+  /**
+   * Minimum estimated effective sample size of each parameter.
+   */
+  double min_ess = 400;
+
+  /**
+   * Maximum split potential scale reduction of each parameter.
+   */
+  double max_rhat = 1.01;
+
+  /**
+   * Names of the monitored columns of the draws, or empty for every
+   * column other than those of the sampler, whose names end in "__".
+   */
+  std::vector<std::string> params;
+
+  /**
+   * Number of draws of a chain between checks of the target.
+   */
+  int check_every = 100;
+};
+
+/**
+ * Checks a <code>sampling_target</code> against the draws of several
+ * chains while they run, and finishes a cancellation token shared by
+ * the chains once the target is reached.
+ *
+ * The monitored columns are found from the names of the first chain to
+ * write its header.  Each chain checks the target every
+ * <code>check_every</code> draws it adds, so the chains stop at their
+ * next iteration after the first check that succeeds.  Draws may be
+ * added concurrently by different chains.
+ */
+class sampling_target_monitor {
+ public:
+  /**
+   * @param[in] target convergence target
+   * @param[in] num_chains number of chains
+   * @param[in,out] cancel token finished once the target is reached
+   * @throw std::invalid_argument if <code>check_every</code> is not
+   *   positive
+   */
+  sampling_target_monitor(const sampling_target& target,
+                          std::size_t num_chains,
+                          callbacks::cancellation_token& cancel)
+      : target_(target),
+        num_chains_(num_chains),
+        cancel_(cancel),
+        num_draws_(new std::atomic<int>[num_chains]) {
+    if (target_.check_every <= 0)
+      throw std::invalid_argument(
+          "sampling_target: check_every must be positive");
+    for (std::size_t c = 0; c < num_chains; ++c)
+      num_draws_[c] = 0;
+  }
+
+  /**
+   * Set the monitored columns from the names of the columns of the
+   * draws.  Only the first call has an effect.
+   *
+   * @param[in] names names of the columns
+   * @throw std::invalid_argument if a monitored parameter is not a
+   *   column
+   */
+  void set_names(const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(names_mutex_);
+    if (monitor_)
+      return;
+    std::vector<std::size_t> columns;
+    if (target_.params.empty()) {
+      for (std::size_t i = 0; i < names.size(); ++i)
+        if (!is_sampler_param(names[i]))
+          columns.push_back(i);
+    } else {
+      for (const std::string& param : target_.params) {
+        std::size_t i = 0;
+        while (i < names.size() && names[i] != param)
+          ++i;
+        if (i == names.size())
+          throw std::invalid_argument("sampling_target: no parameter named "
+                                      + param);
+        columns.push_back(i);
+      }
+    }
+    columns_ = std::move(columns);
+    monitor_ = std::make_unique<analyze::online_convergence_monitor>(
+        num_chains_, columns_.size());
+    monitor_ptr_.store(monitor_.get(), std::memory_order_release);
+  }
+
+  /**
+   * Add a draw of a chain, checking the target every
+   * <code>check_every</code> draws of the chain.
+   *
+   * @param[in] chain index of the chain
+   * @param[in] draw values of every column, in consecutive segments
+   */
+  void add(std::size_t chain, callbacks::row_segments draw) {
+    analyze::online_convergence_monitor* monitor
+        = monitor_ptr_.load(std::memory_order_acquire);
+    if (monitor == nullptr || reached())
+      return;
+    Eigen::VectorXd values(columns_.size());
+    for (std::size_t i = 0; i < columns_.size(); ++i) {
+      std::size_t column = columns_[i];
+      for (const callbacks::value_span& segment : draw) {
+        if (column < segment.size()) {
+          values(i) = segment.data()[column];
+          break;
+        }
+        column -= segment.size();
+      }
+    }
+    monitor->add(chain, values);
+    const int num_draws = ++num_draws_[chain];
+    if (num_draws % target_.check_every == 0 && check()) {
+      reached_num_draws_ = num_draws;
+      reached_ = true;
+      cancel_.finish();
+    }
+  }
+
+  /**
+   * Return true if the target has been reached.
+   */
+  bool reached() const { return reached_; }
+
+  /**
+   * Return the number of draws of the chain which reached the target,
+   * or 0 if it has not been reached.
+   */
+  int reached_num_draws() const { return reached_num_draws_; }
+
+  /**
+   * Return true if every monitored parameter meets the target with the
+   * draws added so far.  Estimates that are not available yet, with too
+   * few draws, do not meet it.
+   */
+  bool check() const {
+    const analyze::online_convergence_monitor* monitor
+        = monitor_ptr_.load(std::memory_order_acquire);
+    if (monitor == nullptr)
+      return false;
+    for (Eigen::Index i = 0; i < monitor->num_params(); ++i) {
+      if (!(monitor->effective_sample_size(i) >= target_.min_ess))
+        return false;
+      if (!(monitor->split_potential_scale_reduction(i) <= target_.max_rhat))
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  sampling_target target_;
+  std::size_t num_chains_;
+  callbacks::cancellation_token& cancel_;
+  std::unique_ptr<std::atomic<int>[]> num_draws_;
+  std::atomic<bool> reached_{false};
+  std::atomic<int> reached_num_draws_{0};
+
+  // Set once, under the mutex, by the first header, and published to
+  // the chains through monitor_ptr_
+  std::mutex names_mutex_;
+  std::vector<std::size_t> columns_;
+  std::unique_ptr<analyze::online_convergence_monitor> monitor_;
+  std::atomic<analyze::online_convergence_monitor*> monitor_ptr_{nullptr};
+
+  static bool is_sampler_param(const std::string& name) {
+    return name.size() >= 2 && name.compare(name.size() - 2, 2, "__") == 0;
+  }
+};
+
+/**
+ * Writer of the draws of one chain of a run until a sampling target.
+ * Everything is forwarded to the sample writer of the chain; the names
+ * and the draws after the first <code>num_skipped</code>, the saved
+ * warmup draws, are also passed to the
+ * <code>sampling_target_monitor</code>.
+ */
+class sampling_target_writer final : public callbacks::writer {
+ public:
+  /**
+   * @param[in,out] writer sample writer of the chain
+   * @param[in,out] monitor monitor of the target
+   * @param[in] chain index of the chain
+   * @param[in] num_skipped number of leading draws not monitored
+   */
+  sampling_target_writer(callbacks::writer& writer,
+                         sampling_target_monitor& monitor, std::size_t chain,
+                         int num_skipped)
+      : writer_(&writer),
+        monitor_(&monitor),
+        chain_(chain),
+        num_skipped_(num_skipped) {}
+
+  void operator()(const std::vector<std::string>& names) {
+    monitor_->set_names(names);
+    (*writer_)(names);
+  }
+
+  void operator()(const std::vector<double>& state) {
+    (*writer_)(state);
+    if (num_skipped_ > 0)
+      --num_skipped_;
+    else
+      monitor_->add(chain_, {callbacks::value_span(state)});
+  }
+
+  void operator()(callbacks::row_segments segments) {
+    (*writer_)(segments);
+    if (num_skipped_ > 0)
+      --num_skipped_;
+    else
+      monitor_->add(chain_, segments);
+  }
+
+  void operator()() { (*writer_)(); }
+
+  void operator()(const std::string& message) { (*writer_)(message); }
+
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    (*writer_)(values);
+    Eigen::VectorXd state(values.rows());
+    for (Eigen::Index j = 0; j < values.cols(); ++j) {
+      if (num_skipped_ > 0) {
+        --num_skipped_;
+        continue;
+      }
+      state = values.col(j);
+      monitor_->add(chain_, {callbacks::value_span(state)});
+    }
+  }
+
+ private:
+  callbacks::writer* writer_;
+  sampling_target_monitor* monitor_;
+  std::size_t chain_;
+  int num_skipped_;
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
@@ -0,0 +1,110 @@
+#ifndef STAN_SERVICES_UTIL_STD_NORMAL_BATCH_HPP
+#define STAN_SERVICES_UTIL_STD_NORMAL_BATCH_HPP
+
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Generator of standard normal draws that transforms the output of a
+ * random number generator a block at a time.  A block of uniforms is
+ * taken from the generator and turned into a block of normals with a
+ * Box-Muller transform evaluated on Eigen arrays, so the logarithms and
+ * trigonometric functions are vectorized.  Draws are handed out from
+ * the block until it is exhausted.
+ *
+ * The sequence of draws depends only on the state of the generator, so
+ * it is reproducible for a given seed, but it differs from the sequence
+ * of boost::normal_distribution.  Draws left in the block when the
+ * object is destroyed are discarded, so a single object should be kept
+ * for a stream of draws.
+ *
+ * @tparam RNG type of random number generator, e.g. stan::rng_t
+ */
+template <class RNG>
+class std_normal_batch {
+ public:
+  /**
+   * Number of normals made from one block of uniforms.
+   */
+  static constexpr int block_size = 256;
+
+  /**
+   * @param rng random number generator the uniforms are drawn from,
+   *   which must outlive this object
+   */
+  explicit std_normal_batch(RNG& rng) : rng_(rng), next_(block_size) {}
+
+  /**
+   * Return the next standard normal draw.
+   */
+  inline double operator()() {
+    if (next_ == block_size)
+      refill();
+    return normals_(next_++);
+  }
+
+  /**
+   * Fill every coefficient of the specified matrix expression with
+   * standard normal draws, in column-major order.  The draws are the
+   * same as those of successive calls to operator().
+   *
+   * @tparam Derived type of the matrix expression
+   * @param[out] x matrix, vector or block to fill
+   */
+  template <typename Derived>
+  void fill(Eigen::DenseBase<Derived>& x) {
+    for (Eigen::Index j = 0; j < x.cols(); ++j) {
+      Eigen::Index i = 0;
+      while (i < x.rows()) {
+        if (next_ == block_size)
+          refill();
+        const Eigen::Index m
+            = std::min<Eigen::Index>(block_size - next_, x.rows() - i);
+        x.col(j).segment(i, m) = normals_.segment(next_, m);
+        next_ += m;
+        i += m;
+      }
+    }
+  }
+
+  template <typename Derived>
+  inline void fill(Eigen::DenseBase<Derived>&& x) {
+    fill(x);
+  }
+
+ private:
+  /**
+   * Draw a block of uniforms on (0, 1) and transform pairs of them
+   * into normals.
+   */
+  void refill() {
+    const double scale
+        = 1.0 / (static_cast<double>(rng_.max() - rng_.min()) + 1.0);
+    for (int i = 0; i < block_size; ++i)
+      uniforms_(i) = (static_cast<double>(rng_() - rng_.min()) + 0.5) * scale;
+
+    constexpr int half = block_size / 2;
+    radius_ = (-2.0 * uniforms_.template head<half>().log()).sqrt();
+    angle_ = (2.0 * M_PI) * uniforms_.template tail<half>();
+    normals_.template head<half>() = radius_ * angle_.cos();
+    normals_.template tail<half>() = radius_ * angle_.sin();
+    next_ = 0;
+  }
+
+  RNG& rng_;
+  int next_;
+  Eigen::Array<double, block_size, 1> uniforms_;
+  Eigen::Array<double, block_size / 2, 1> radius_;
+  Eigen::Array<double, block_size / 2, 1> angle_;
+  Eigen::Array<double, block_size, 1> normals_;
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
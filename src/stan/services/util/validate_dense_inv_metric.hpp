@@ -3,27 +3,41 @@
 
 #include <stan/callbacks/logger.hpp>
 #include <stan/math/prim.hpp>
+#include <Eigen/Cholesky>
 
 namespace stan {
 namespace services {
 namespace util {
 
 /**
- * Validate that dense inverse Euclidean metric is positive definite
+ * Validate that dense inverse Euclidean metric is positive definite.
+ *
+ * The Cholesky factorization computed by the check is returned so it
+ * can be passed on to the sampler with the metric instead of being
+ * recomputed.
  *
  * @param[in] inv_metric  inverse Euclidean metric
  * @param[in,out] logger Logger for messages
  * @throws std::domain_error if matrix is not positive definite
+ * @return Cholesky factorization of inv_metric
  */
-inline void validate_dense_inv_metric(const Eigen::MatrixXd& inv_metric,
-                                      callbacks::logger& logger) {
+inline Eigen::LLT<Eigen::MatrixXd> validate_dense_inv_metric(
+    const Eigen::MatrixXd& inv_metric, callbacks::logger& logger) {
+  Eigen::LLT<Eigen::MatrixXd> inv_metric_llt;
   try {
-    stan::math::check_pos_definite("check_pos_definite", "inv_metric",
-                                   inv_metric);
+    stan::math::check_symmetric("check_pos_definite", "inv_metric",
+                                inv_metric);
+    inv_metric_llt.compute(inv_metric);
+    // The diagonal check also rejects NaN and infinite elements
+    if (inv_metric.rows() == 0 || inv_metric_llt.info() != Eigen::Success
+        || !(inv_metric_llt.matrixLLT().diagonal().array() > 0.0).all()
+        || !inv_metric_llt.matrixLLT().diagonal().allFinite())
+      throw std::domain_error("inv_metric is not positive definite");
   } catch (const std::domain_error& e) {
     logger.error("Inverse Euclidean metric not positive definite.");
     throw std::domain_error("Initialization failure");
   }
+  return inv_metric_llt;
 }
 
 }  // namespace util
@@ -0,0 +1,250 @@
+#ifndef STAN_SERVICES_UTIL_WARM_START_CACHE_HPP
+#define STAN_SERVICES_UTIL_WARM_START_CACHE_HPP
+
+#include <stan/io/var_context.hpp>
+#include <stan/mcmc/checkpoint_io.hpp>
+#include <stan/math/prim/fun/Eigen.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace stan {
+namespace services {
+namespace util {
+
+/**
+ * Adapted state of a chain, from which a later run of the same model
+ * on the same data can start instead of warming up from scratch.
+ */
+struct warm_start {
+  /**
+   * Name of the model.
+   */
+  std::string model_name;
+
+  /**
+   * Adapted step size.
+   */
+  double stepsize = 1;
+
+  /**
+   * Adapted inverse metric, the diagonal for a diagonal metric or the
+   * matrix for a dense one.
+   */
+  Eigen::MatrixXd inv_metric;
+
+  /**
+   * Unconstrained parameters of the last draw.
+   */
+  std::vector<double> cont_params;
+};
+
+namespace internal {
+
+constexpr char warm_start_magic[8] = {'s', 't', 'a', 'n', 'w', 'a', 'r', 'm'};
+constexpr std::uint32_t warm_start_version = 1;
+
+/**
+ * 64-bit FNV-1a hash, fed incrementally.
+ */
+class fnv1a_hash {
+ public:
+  void add(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      hash_ ^= bytes[i];
+      hash_ *= 1099511628211ULL;
+    }
+  }
+
+  template <typename T>
+  void add(const T& x) {
+    add(&x, sizeof(T));
+  }
+
+  void add(const std::string& x) {
+    add(static_cast<std::uint64_t>(x.size()));
+    add(x.data(), x.size());
+  }
+
+  std::uint64_t value() const { return hash_; }
+
+ private:
+  std::uint64_t hash_ = 14695981039346656037ULL;
+};
+
+template <typename T>
+inline void hash_values(fnv1a_hash& hash, const std::string& name,
+                        const std::vector<std::size_t>& dims,
+                        const T* values, std::size_t size) {
+  hash.add(name);
+  hash.add(static_cast<std::uint64_t>(dims.size()));
+  for (std::size_t dim : dims)
+    hash.add(static_cast<std::uint64_t>(dim));
+  hash.add(values, sizeof(T) * size);
+}
+
+/**
+ * Add the names, dimensions and values of every variable of the data
+ * to the hash, in an order that does not depend on the data's order.
+ */
+inline void hash_data(fnv1a_hash& hash, const io::var_context& data) {
+  std::vector<std::string> names;
+  data.names_r(names);
+  std::sort(names.begin(), names.end());
+  for (const std::string& name : names) {
+    io::values_view<double> values = data.vals_r_view(name);
+    hash_values(hash, name, data.dims_r(name), values.data(), values.size());
+  }
+  names.clear();
+  data.names_i(names);
+  std::sort(names.begin(), names.end());
+  for (const std::string& name : names) {
+    io::values_view<int> values = data.vals_i_view(name);
+    hash_values(hash, name, data.dims_i(name), values.data(), values.size());
+  }
+}
+
+}  // namespace internal
+
+/**
+ * A directory of the adapted states of earlier runs, keyed by a
+ * fingerprint of the model and its data, so that reruns on the same
+ * data can start from the adapted step size, metric and position of
+ * the last run and shorten their warmup.
+ *
+ * The fingerprint hashes the name of the model, its number of
+ * unconstrained parameters and the names, dimensions and values of
+ * every variable of the data; any change to the data starts a new
+ * entry.  Entries are written in the binary format of the sampler
+ * checkpoints, so a cache is only readable on the same kind of
+ * machine.  An entry is written to a temporary file and renamed, so
+ * that concurrent runs never read a partially written entry.
+ */
+class warm_start_cache {
+ public:
+  /**
+   * Construct a cache in the specified directory, which must exist.
+   *
+   * @param[in] directory directory of the cache entries
+   */
+  explicit warm_start_cache(const std::string& directory)
+      : directory_(directory) {}
+
+  /**
+   * Return the key of the entry of a model with the specified data.
+   *
+   * @tparam Model type of model
+   * @param[in] model model
+   * @param[in] data data the model was constructed with
+   * @return key of the entry
+   */
+  template <class Model>
+  static std::string key(const Model& model, const io::var_context& data) {
+    internal::fnv1a_hash hash;
+    hash.add(model.model_name());
+    hash.add(static_cast<std::uint64_t>(model.num_params_r()));
+    internal::hash_data(hash, data);
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash.value();
+    return key.str();
+  }
+
+  /**
+   * Read the entry with the specified key.
+   *
+   * @param[in] key key of the entry
+   * @param[out] state adapted state of the entry
+   * @return <code>true</code> if the entry exists and could be read;
+   *   otherwise <code>state</code> is left unspecified
+   */
+  bool read(const std::string& key, warm_start& state) const {
+    std::ifstream in(path(key), std::ios::binary);
+    if (!in)
+      return false;
+    try {
+      char magic[sizeof(internal::warm_start_magic)];
+      in.read(magic, sizeof(magic));
+      if (!in
+          || std::memcmp(magic, internal::warm_start_magic, sizeof(magic))
+                 != 0)
+        return false;
+      stan::mcmc::checkpoint_reader reader(in);
+      std::uint32_t version;
+      reader.read(version);
+      if (version != internal::warm_start_version)
+        return false;
+      reader.read(state.model_name);
+      reader.read(state.stepsize);
+      reader.read(state.inv_metric);
+      Eigen::VectorXd cont_params;
+      reader.read(cont_params);
+      state.cont_params.assign(cont_params.data(),
+                               cont_params.data() + cont_params.size());
+    } catch (const std::runtime_error&) {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Write the entry with the specified key, replacing any earlier one.
+   *
+   * @param[in] key key of the entry
+   * @param[in] state adapted state to write
+   * @throw std::runtime_error if the entry cannot be written
+   */
+  void write(const std::string& key, const warm_start& state) const {
+    const std::string entry = path(key);
+    const std::string temporary = entry + ".tmp";
+    {
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if (!out)
+        throw std::runtime_error("Cannot write warm start cache entry "
+                                 + entry + ".");
+      out.write(internal::warm_start_magic,
+                sizeof(internal::warm_start_magic));
+      stan::mcmc::checkpoint_writer writer(out);
+      writer.write(internal::warm_start_version);
+      writer.write(state.model_name);
+      writer.write(state.stepsize);
+      writer.write(state.inv_metric);
+      writer.write(Eigen::Map<const Eigen::VectorXd>(
+          state.cont_params.data(), state.cont_params.size()));
+      out.flush();
+      if (!out)
+        throw std::runtime_error("Cannot write warm start cache entry "
+                                 + entry + ".");
+    }
+    if (std::rename(temporary.c_str(), entry.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw std::runtime_error("Cannot write warm start cache entry " + entry
+                               + ".");
+    }
+  }
+
+  /**
+   * Return the path of the entry with the specified key.
+   *
+   * @param[in] key key of the entry
+   * @return path of the entry
+   */
+  std::string path(const std::string& key) const {
+    return directory_ + "/" + key + ".warmstart";
+  }
+
+ private:
+  std::string directory_;
+};
+
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
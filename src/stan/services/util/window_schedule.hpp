@@ -0,0 +1,37 @@
+#ifndef STAN_SERVICES_UTIL_WINDOW_SCHEDULE_HPP
+#define STAN_SERVICES_UTIL_WINDOW_SCHEDULE_HPP
+
+#include <stan/mcmc/stepsize_covar_adapter.hpp>
+#include <stan/mcmc/stepsize_lowrank_adapter.hpp>
+#include <stan/mcmc/stepsize_var_adapter.hpp>
+#include <stan/mcmc/windowed_adaptation.hpp>
+
+namespace stan {
+namespace services {
+namespace util {
+namespace internal {
+
+/**
+ * Return the windowed adaptation whose schedule drives the slow
+ * adaptation windows of an adaptive sampler.
+ */
+inline stan::mcmc::windowed_adaptation& window_schedule(
+    stan::mcmc::stepsize_var_adapter& adapter) {
+  return adapter.get_var_adaptation();
+}
+
+inline stan::mcmc::windowed_adaptation& window_schedule(
+    stan::mcmc::stepsize_covar_adapter& adapter) {
+  return adapter.get_covar_adaptation();
+}
+
+inline stan::mcmc::windowed_adaptation& window_schedule(
+    stan::mcmc::stepsize_lowrank_adapter& adapter) {
+  return adapter.get_lowrank_adaptation();
+}
+
+}  // namespace internal
+}  // namespace util
+}  // namespace services
+}  // namespace stan
+#endif
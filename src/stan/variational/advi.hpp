@@ -2,17 +2,34 @@
 #define STAN_VARIATIONAL_ADVI_HPP
 
 #include <stan/math.hpp>
+#include <stan/analyze/reproducible_sum.hpp>
+#include <stan/callbacks/buffered_logger.hpp>
+#include <stan/callbacks/cancellable_interrupt.hpp>
+#include <stan/callbacks/cancellation_token.hpp>
+#include <stan/callbacks/interrupt.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/callbacks/stream_writer.hpp>
 #include <stan/services/error_codes.hpp>
+#include <stan/model/double_arena.hpp>
+#include <stan/model/minibatch_model.hpp>
+#include <stan/variational/elbo_leader.hpp>
+#include <stan/variational/parallel_monte_carlo.hpp>
 #include <stan/variational/print_progress.hpp>
 #include <stan/variational/families/normal_fullrank.hpp>
+#include <stan/variational/families/normal_lowrank.hpp>
 #include <stan/variational/families/normal_meanfield.hpp>
 #include <boost/circular_buffer.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <queue>
@@ -47,6 +64,15 @@ class advi {
    * @param[in] n_monte_carlo_elbo number of samples for ELBO computation
    * @param[in] eval_elbo evaluate ELBO at every "eval_elbo" iters
    * @param[in] n_posterior_samples number of samples to draw from posterior
+   * @param[in] parallel evaluate the Monte Carlo draws of the ELBO and
+   * its gradient in parallel, see parallel_monte_carlo(), and run the
+   * eta trials and the draws of the approximation of run()
+   * concurrently, see adapt_eta_parallel() and write_draws_parallel()
+   * @param[in] sticking_the_landing estimate the gradient of the ELBO
+   * with the "sticking the landing" estimator, see calc_ELBO_grad()
+   * @param[in] minibatch_size if positive and the model declares rows
+   * of data, estimate the gradient of the ELBO from minibatches of that
+   * many rows, see calc_ELBO_grad()
    * @throw std::runtime_error if n_monte_carlo_grad is not positive
    * @throw std::runtime_error if n_monte_carlo_elbo is not positive
    * @throw std::runtime_error if eval_elbo is not positive
@@ -54,14 +80,18 @@ class advi {
    */
   advi(Model& m, Eigen::VectorXd& cont_params, BaseRNG& rng,
        int n_monte_carlo_grad, int n_monte_carlo_elbo, int eval_elbo,
-       int n_posterior_samples)
+       int n_posterior_samples, bool parallel = false,
+       bool sticking_the_landing = false, size_t minibatch_size = 0)
       : model_(m),
         cont_params_(cont_params),
         rng_(rng),
         n_monte_carlo_grad_(n_monte_carlo_grad),
         n_monte_carlo_elbo_(n_monte_carlo_elbo),
         eval_elbo_(eval_elbo),
-        n_posterior_samples_(n_posterior_samples) {
+        n_posterior_samples_(n_posterior_samples),
+        parallel_(parallel),
+        sticking_the_landing_(sticking_the_landing),
+        minibatch_size_(minibatch_size) {
     static const char* function = "stan::variational::advi";
     math::check_positive(function,
                          "Number of Monte Carlo samples for gradients",
@@ -74,6 +104,54 @@ class advi {
                          n_posterior_samples_);
   }
 
+  /**
+   * Constructor starting from the specified variational approximation
+   * instead of one centered at the continuous parameters with unit
+   * covariance.  Families with settings beyond the dimensionality,
+   * such as the rank of <code>normal_lowrank</code>, are run this way;
+   * the gradient and step size statistics take the shape of the
+   * initial approximation.
+   *
+   * @param[in] m stan model
+   * @param[in] cont_params continuous parameters, overwritten with the
+   * draws from the approximation
+   * @param[in] init_variational initial variational approximation
+   * @param[in,out] rng random number generator
+   * @param[in] n_monte_carlo_grad number of samples for gradient computation
+   * @param[in] n_monte_carlo_elbo number of samples for ELBO computation
+   * @param[in] eval_elbo evaluate ELBO at every "eval_elbo" iters
+   * @param[in] n_posterior_samples number of samples to draw from posterior
+   * @param[in] parallel evaluate the Monte Carlo draws of the ELBO and
+   * its gradient in parallel, see parallel_monte_carlo(), and run the
+   * eta trials and the draws of the approximation of run()
+   * concurrently, see adapt_eta_parallel() and write_draws_parallel()
+   * @param[in] sticking_the_landing estimate the gradient of the ELBO
+   * with the "sticking the landing" estimator, see calc_ELBO_grad()
+   * @param[in] minibatch_size if positive and the model declares rows
+   * of data, estimate the gradient of the ELBO from minibatches of that
+   * many rows, see calc_ELBO_grad()
+   * @throw std::runtime_error if n_monte_carlo_grad is not positive
+   * @throw std::runtime_error if n_monte_carlo_elbo is not positive
+   * @throw std::runtime_error if eval_elbo is not positive
+   * @throw std::runtime_error if n_posterior_samples is not positive
+   * @throw std::invalid_argument if the dimensionality of the
+   * approximation is not the number of parameters of the model
+   */
+  advi(Model& m, Eigen::VectorXd& cont_params, const Q& init_variational,
+       BaseRNG& rng, int n_monte_carlo_grad, int n_monte_carlo_elbo,
+       int eval_elbo, int n_posterior_samples, bool parallel = false,
+       bool sticking_the_landing = false, size_t minibatch_size = 0)
+      : advi(m, cont_params, rng, n_monte_carlo_grad, n_monte_carlo_elbo,
+             eval_elbo, n_posterior_samples, parallel, sticking_the_landing,
+             minibatch_size) {
+    math::check_size_match("stan::variational::advi",
+                           "Dimension of variational q",
+                           init_variational.dimension(),
+                           "Dimension of variables in model",
+                           model_.num_params_r());
+    init_variational_ = std::make_shared<const Q>(init_variational);
+  }
+
   /**
    * Calculates the Evidence Lower BOund (ELBO) by sampling from
    * the variational distribution and then evaluating the log joint,
@@ -89,18 +167,69 @@ class advi {
    * that the variational distribution has somehow collapsed.
    */
   double calc_ELBO(const Q& variational, callbacks::logger& logger) const {
+    return calc_ELBO(variational, rng_, logger);
+  }
+
+  /**
+   * Calculates the Evidence Lower BOund (ELBO) as above, drawing from
+   * the specified random number generator.
+   *
+   * @param[in] variational variational approximation at which to evaluate
+   * the ELBO.
+   * @param[in,out] rng random number generator
+   * @param logger logger for messages
+   * @return the evidence lower bound.
+   * @throw std::domain_error If all the draws give non-finite log joint
+   * evaluations
+   */
+  double calc_ELBO(const Q& variational, BaseRNG& rng,
+                   callbacks::logger& logger) const {
     static const char* function = "stan::variational::advi::calc_ELBO";
 
     double elbo = 0.0;
     int dim = variational.dimension();
-    Eigen::VectorXd zeta(dim);
+    if (parallel_) {
+      Eigen::MatrixXd zetas(dim, n_monte_carlo_elbo_);
+      std::vector<double> log_probs(n_monte_carlo_elbo_);
+      parallel_monte_carlo(
+          function, n_monte_carlo_elbo_, n_monte_carlo_elbo_,
+          [&](int i) {
+            Eigen::VectorXd zeta(dim);
+            variational.sample(rng, zeta);
+            zetas.col(i) = zeta;
+          },
+          [&](int i, std::ostream& msgs) {
+            try {
+              Eigen::VectorXd zeta = zetas.col(i);
+              stan::model::double_arena_scope scope;
+              double log_prob
+                  = model_.template log_prob<false, true>(zeta, &msgs);
+              stan::math::check_finite(function, "log_prob", log_prob);
+              log_probs[i] = log_prob;
+            } catch (const std::domain_error& e) {
+              return false;
+            }
+            return true;
+          },
+          logger);
+      elbo = stan::analyze::reproducible_sum(
+          log_probs.size(), [&](std::size_t i) { return log_probs[i]; });
+      elbo /= n_monte_carlo_elbo_;
+      elbo += variational.entropy();
+      return elbo;
+    }
 
+    Eigen::VectorXd zeta(dim);
     int n_dropped_evaluations = 0;
     for (int i = 0; i < n_monte_carlo_elbo_;) {
-      variational.sample(rng_, zeta);
+      variational.sample(rng, zeta);
       try {
         std::stringstream ss;
-        double log_prob = model_.template log_prob<false, true>(zeta, &ss);
+        double log_prob;
+        {
+          stan::model::double_arena_scope scope;
+          log_prob = model_.template log_prob<false, true>(zeta, &ss);
+        }
         if (ss.str().length() > 0)
           logger.info(ss);
         stan::math::check_finite(function, "log_prob", log_prob);
@@ -127,6 +256,24 @@ class advi {
   /**
    * Calculates the "black box" gradient of the ELBO.
    *
+   * <p>By default the gradient of the expected log density is estimated
+   * by Monte Carlo and that of the entropy is exact.  With "sticking the
+   * landing" (Roeder, Wu and Duvenaud, 2017), the gradient of the log
+   * density of the approximation with respect to the draw is subtracted
+   * from that of the model, without differentiating the parameters of
+   * the approximation, and the exact gradient of the entropy is
+   * dropped.  The estimate has the same expectation, and its variance
+   * vanishes as the approximation reaches the posterior, so fewer draws
+   * are needed per iteration for the same convergence of the ELBO.
+   *
+   * <p>With a positive minibatch size, for a model that declares rows
+   * of data (see <code>stan::model::minibatch_model</code>), the
+   * likelihood of each draw is estimated from the same minibatch of
+   * rows, drawn afresh at every call and scaled to the number of rows.
+   * The estimate keeps its expectation and costs in proportion to the
+   * minibatch size instead of the number of rows; the ELBO itself, as
+   * used for convergence, is still computed from all the rows.
+   *
    * @param[in] variational variational approximation at which to evaluate
    * the ELBO.
    * @param[out] elbo_grad gradient of ELBO with respect to variational
@@ -135,6 +282,22 @@ class advi {
    */
   void calc_ELBO_grad(const Q& variational, Q& elbo_grad,
                       callbacks::logger& logger) const {
+    calc_ELBO_grad(variational, elbo_grad, rng_, logger);
+  }
+
+  /**
+   * Calculates the "black box" gradient of the ELBO as above, drawing
+   * from the specified random number generator.
+   *
+   * @param[in] variational variational approximation at which to evaluate
+   * the ELBO.
+   * @param[out] elbo_grad gradient of ELBO with respect to variational
+   * approximation.
+   * @param[in,out] rng random number generator
+   * @param logger logger for messages
+   */
+  void calc_ELBO_grad(const Q& variational, Q& elbo_grad, BaseRNG& rng,
+                      callbacks::logger& logger) const {
     static const char* function = "stan::variational::advi::calc_ELBO_grad";
 
     stan::math::check_size_match(
@@ -144,8 +307,17 @@ class advi {
         function, "Dimension of variational q", variational.dimension(),
         "Dimension of variables in model", cont_params_.size());
 
+    if (minibatch_size_ > 0
+        && minibatch_size_ < stan::model::num_minibatch_rows(model_)) {
+      stan::model::minibatch_model<Model> minibatch(model_, minibatch_size_);
+      minibatch.draw_rows(rng);
+      variational.calc_grad(elbo_grad, minibatch, cont_params_,
+                            n_monte_carlo_grad_, rng, logger, parallel_,
+                            sticking_the_landing_);
+      return;
+    }
     variational.calc_grad(elbo_grad, model_, cont_params_, n_monte_carlo_grad_,
-                          rng_, logger);
+                          rng, logger, parallel_, sticking_the_landing_);
   }
 
   /**
@@ -155,13 +327,16 @@ class advi {
    * @param[in] adapt_iterations number of iterations to spend doing stochastic
    * gradient ascent at each proposed eta value.
    * @param[in,out] logger logger for messages
+   * @param[in,out] interrupt interrupt callback called once an iteration,
+   * or nullptr
    * @return adapted (tuned) value of eta via heuristic grid search
    * @throw std::domain_error If either (a) the initial ELBO cannot be
    * computed at the initial variational distribution, (b) all step-size
    * proposals in eta_sequence fail.
    */
   double adapt_eta(Q& variational, int adapt_iterations,
-                   callbacks::logger& logger) const {
+                   callbacks::logger& logger,
+                   callbacks::interrupt* interrupt = nullptr) const {
     static const char* function = "stan::variational::advi::adapt_eta";
 
     stan::math::check_positive(function, "Number of adaptation iterations",
@@ -190,10 +365,10 @@ class advi {
     }
 
     // Variational family to store gradients
-    Q elbo_grad = Q(model_.num_params_r());
+    Q elbo_grad = zero_variational();
 
     // Adaptive step-size sequence
-    Q history_grad_squared = Q(model_.num_params_r());
+    Q history_grad_squared = zero_variational();
     double tau = 1.0;
     double pre_factor = 0.9;
     double post_factor = 0.1;
@@ -210,6 +385,8 @@ class advi {
 
       int print_progress_m;
       for (int iter_tune = 1; iter_tune <= adapt_iterations; ++iter_tune) {
+        if (interrupt)
+          (*interrupt)();
         print_progress_m = eta_sequence_index * adapt_iterations + iter_tune;
         variational ::print_progress(print_progress_m, 0,
                                      adapt_iterations * eta_sequence_size,
@@ -225,15 +402,15 @@ class advi {
 
         // Update step-size
         if (iter_tune == 1) {
-          history_grad_squared += elbo_grad.square();
+          history_grad_squared.add_weighted_square(elbo_grad, 1.0, 1.0);
         } else {
-          history_grad_squared = pre_factor * history_grad_squared
-                                 + post_factor * elbo_grad.square();
+          history_grad_squared.add_weighted_square(elbo_grad, pre_factor,
+                                                   post_factor);
         }
         eta_scaled = eta / sqrt(static_cast<double>(iter_tune));
         // Stochastic gradient update
-        variational
-            += eta_scaled * elbo_grad / (tau + history_grad_squared.sqrt());
+        variational.add_scaled_step(elbo_grad, history_grad_squared, eta_scaled,
+                                    tau);
       }
 
       // (ROBUST) Compute ELBO. It's OK if it has diverged.
@@ -285,8 +462,191 @@ class advi {
         history_grad_squared.set_to_zero();
       }
       ++eta_sequence_index;
-      variational = Q(cont_params_);
+      variational = initial_variational();
+    }
+    return eta_best;
+  }
+
+  /**
+   * Heuristic grid search to adapt eta to the scale of the problem, as
+   * <code>adapt_eta()</code>, with the trials of the eta values run
+   * concurrently.
+   *
+   * <p>Every trial starts from its own copy of the approximation, the
+   * first from the specified one and the others from the initial one,
+   * and draws from its own random number generator, seeded in turn
+   * from the generator of this object, so the result does not depend
+   * on the number of threads.  The messages of the trials are kept and
+   * logged in the order of the eta sequence.  The winner is chosen by
+   * the rule of <code>adapt_eta()</code>: the trials after the first
+   * one whose ELBO is worse than that of the previous one are not
+   * needed and are cancelled as soon as that one is known.  A trial
+   * whose mean is no longer finite has diverged and stops early, with
+   * the lowest ELBO.
+   *
+   * <p>The random number generator must be constructible from one of
+   * its own draws.
+   *
+   * @param[in] variational initial variational distribution.
+   * @param[in] adapt_iterations number of iterations to spend doing stochastic
+   * gradient ascent at each proposed eta value.
+   * @param[in,out] logger logger for messages
+   * @param[in,out] interrupt interrupt callback called once an iteration
+   * of every trial, or nullptr; when it throws in one trial the others
+   * stop at their next iteration
+   * @return adapted (tuned) value of eta via heuristic grid search
+   * @throw std::domain_error If either (a) the initial ELBO cannot be
+   * computed at the initial variational distribution, (b) all step-size
+   * proposals in eta_sequence fail.
+   */
+  double adapt_eta_parallel(Q& variational, int adapt_iterations,
+                            callbacks::logger& logger,
+                            callbacks::interrupt* interrupt = nullptr) const {
+    static const char* function
+        = "stan::variational::advi::adapt_eta_parallel";
+
+    stan::math::check_positive(function, "Number of adaptation iterations",
+                               adapt_iterations);
+
+    logger.info("Begin eta adaptation.");
+
+    // Sequence of eta values to try during adaptation
+    const int eta_sequence_size = 5;
+    const double eta_sequence[eta_sequence_size] = {100, 10, 1, 0.1, 0.01};
+
+    double elbo_init;
+    try {
+      elbo_init = calc_ELBO(variational, logger);
+    } catch (const std::domain_error& e) {
+      const char* name
+          = "Cannot compute ELBO using the initial "
+            "variational distribution.";
+      const char* msg1
+          = "Your model may be either "
+            "severely ill-conditioned or misspecified.";
+      stan::math::throw_domain_error(function, name, "", msg1);
+    }
+
+    std::vector<BaseRNG> rngs;
+    rngs.reserve(eta_sequence_size);
+    for (int k = 0; k < eta_sequence_size; ++k)
+      rngs.emplace_back(rng_());
+    std::vector<double> elbos(eta_sequence_size);
+    std::vector<char> done(eta_sequence_size, false);
+    std::vector<callbacks::buffered_logger> loggers(eta_sequence_size);
+    // Index of the last trial which may decide the winner
+    std::atomic<int> last_needed(eta_sequence_size - 1);
+    std::mutex done_mutex;
+    callbacks::cancellation_token cancel;
+    std::unique_ptr<callbacks::cancellable_interrupt> trial_interrupt;
+    if (interrupt)
+      trial_interrupt.reset(
+          new callbacks::cancellable_interrupt(*interrupt, cancel));
+
+    auto run_trial = [&](int k) {
+      Q trial = k == 0 ? variational : initial_variational();
+      Q elbo_grad = zero_variational();
+      Q history_grad_squared = zero_variational();
+      const double tau = 1.0;
+      const double pre_factor = 0.9;
+      const double post_factor = 0.1;
+      bool diverged = false;
+      for (int iter_tune = 1; iter_tune <= adapt_iterations; ++iter_tune) {
+        if (k > last_needed.load())
+          return;
+        if (trial_interrupt)
+          (*trial_interrupt)();
+        variational::print_progress(k * adapt_iterations + iter_tune, 0,
+                                    adapt_iterations * eta_sequence_size,
+                                    adapt_iterations, true, "", "",
+                                    loggers[k]);
+        // (ROBUST) Compute gradient of ELBO. It's OK if it diverges.
+        try {
+          calc_ELBO_grad(trial, elbo_grad, rngs[k], loggers[k]);
+        } catch (const std::domain_error& e) {
+          elbo_grad.set_to_zero();
+        }
+        if (iter_tune == 1)
+          history_grad_squared.add_weighted_square(elbo_grad, 1.0, 1.0);
+        else
+          history_grad_squared.add_weighted_square(elbo_grad, pre_factor,
+                                                   post_factor);
+        double eta_scaled
+            = eta_sequence[k] / sqrt(static_cast<double>(iter_tune));
+        trial.add_scaled_step(elbo_grad, history_grad_squared, eta_scaled,
+                              tau);
+        if (!trial.mean().allFinite()) {
+          diverged = true;
+          break;
+        }
+      }
+
+      // (ROBUST) Compute ELBO. It's OK if it has diverged.
+      double elbo = -std::numeric_limits<double>::max();
+      if (!diverged) {
+        try {
+          elbo = calc_ELBO(trial, rngs[k], loggers[k]);
+        } catch (const std::domain_error& e) {
+          elbo = -std::numeric_limits<double>::max();
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(done_mutex);
+      elbos[k] = elbo;
+      done[k] = true;
+      // Cancel the trials after the first one known to stop the search
+      double elbo_best = -std::numeric_limits<double>::max();
+      for (int j = 0; j < eta_sequence_size && done[j]; ++j) {
+        if (elbos[j] < elbo_best && elbo_best > elbo_init) {
+          if (j < last_needed.load())
+            last_needed.store(j);
+          break;
+        }
+        elbo_best = elbos[j];
+      }
+    };
+
+    tbb::task_group trials;
+    for (int k = 0; k < eta_sequence_size; ++k)
+      trials.run([&run_trial, k]() { run_trial(k); });
+    trials.wait();
+
+    // Replay the trials and choose the winner as adapt_eta() does
+    double elbo_best = -std::numeric_limits<double>::max();
+    double eta_best = 0.0;
+    for (int k = 0; k < eta_sequence_size; ++k) {
+      loggers[k].replay(logger);
+      if (elbos[k] < elbo_best && elbo_best > elbo_init) {
+        std::stringstream ss;
+        ss << "Success!"
+           << " Found best value [eta = " << eta_best << "]";
+        if (k < eta_sequence_size - 1)
+          ss << (" earlier than expected.");
+        else
+          ss << ".";
+        logger.info(ss);
+        logger.info("");
+        break;
+      }
+      if (k < eta_sequence_size - 1) {
+        elbo_best = elbos[k];
+        eta_best = eta_sequence[k];
+      } else if (elbos[k] > elbo_init) {
+        std::stringstream ss;
+        ss << "Success!"
+           << " Found best value [eta = " << eta_best << "].";
+        logger.info(ss);
+        logger.info("");
+        eta_best = eta_sequence[k];
+      } else {
+        const char* name = "All proposed step-sizes";
+        const char* msg1
+            = "failed. Your model may be either "
+              "severely ill-conditioned or misspecified.";
+        stan::math::throw_domain_error(function, name, "", msg1);
+      }
     }
+    variational = initial_variational();
     return eta_best;
   }
 
@@ -299,13 +659,23 @@ class advi {
    * @param[in] max_iterations max number of iterations to run algorithm
    * @param[in,out] logger logger for messages
    * @param[in,out] diagnostic_writer writer for diagnostic information
+   * @param[in,out] interrupt interrupt callback called once an iteration,
+   * or nullptr
+   * @param[in,out] leader if not null, the best ELBO shared with other
+   * approximations fit in parallel: the best ELBO of this one is
+   * reported at every evaluation of the ELBO, and the ascent stops once
+   * it trails the leader
+   * @return false if the ascent was abandoned because it trailed the
+   * leader, true otherwise
    * @throw std::domain_error If the ELBO or its gradient is ever
    * non-finite, at any iteration
    */
-  void stochastic_gradient_ascent(Q& variational, double eta,
+  bool stochastic_gradient_ascent(Q& variational, double eta,
                                   double tol_rel_obj, int max_iterations,
                                   callbacks::logger& logger,
-                                  callbacks::writer& diagnostic_writer) const {
+                                  callbacks::writer& diagnostic_writer,
+                                  callbacks::interrupt* interrupt = nullptr,
+                                  elbo_leader* leader = nullptr) const {
     static const char* function
         = "stan::variational::advi::stochastic_gradient_ascent";
 
@@ -315,10 +685,10 @@ class advi {
     stan::math::check_positive(function, "Maximum iterations", max_iterations);
 
     // Gradient parameters
-    Q elbo_grad = Q(model_.num_params_r());
+    Q elbo_grad = zero_variational();
 
     // Stepsize sequence parameters
-    Q history_grad_squared = Q(model_.num_params_r());
+    Q history_grad_squared = zero_variational();
     double tau = 1.0;
     double pre_factor = 0.9;
     double post_factor = 0.1;
@@ -351,21 +721,24 @@ class advi {
     // Main loop
     bool do_more_iterations = true;
     for (int iter_counter = 1; do_more_iterations; ++iter_counter) {
+      if (interrupt)
+        (*interrupt)();
+
       // Compute gradient using Monte Carlo integration
       calc_ELBO_grad(variational, elbo_grad, logger);
 
       // Update step-size
       if (iter_counter == 1) {
-        history_grad_squared += elbo_grad.square();
+        history_grad_squared.add_weighted_square(elbo_grad, 1.0, 1.0);
       } else {
-        history_grad_squared = pre_factor * history_grad_squared
-                               + post_factor * elbo_grad.square();
+        history_grad_squared.add_weighted_square(elbo_grad, pre_factor,
+                                                 post_factor);
       }
       eta_scaled = eta / sqrt(static_cast<double>(iter_counter));
 
       // Stochastic gradient update
-      variational
-          += eta_scaled * elbo_grad / (tau + history_grad_squared.sqrt());
+      variational.add_scaled_step(elbo_grad, history_grad_squared, eta_scaled,
+                                  tau);
 
       // Check for convergence every "eval_elbo_"th iteration
       if (iter_counter % eval_elbo_ == 0) {
@@ -415,6 +788,19 @@ class advi {
 
         logger.info(ss);
 
+        if (leader != nullptr) {
+          leader->update(elbo_best);
+          if (do_more_iterations && leader->trails(iter_counter, elbo_best)) {
+            leader->abandon();
+            std::stringstream msg;
+            msg << "Abandoned at iteration " << iter_counter
+                << ", best ELBO (" << elbo_best
+                << ") trails the best ELBO of the other runs";
+            logger.info(msg);
+            return false;
+          }
+        }
+
         if (do_more_iterations == false
             && rel_difference(elbo, elbo_best) > 0.05) {
           logger.info(
@@ -438,41 +824,67 @@ class advi {
         do_more_iterations = false;
       }
     }
+    return true;
   }
 
   /**
-   * Runs ADVI and writes to output.
+   * Fits the approximation of run(): adapts eta, if engaged, writing
+   * the adapted value to the parameter writer, then runs the
+   * stochastic gradient ascent, writing its diagnostics.
    *
+   * @param[out] variational fitted approximation
    * @param[in] eta eta parameter of stepsize sequence
    * @param[in] adapt_engaged boolean flag for eta adaptation
    * @param[in] adapt_iterations number of iterations for eta adaptation
    * @param[in] tol_rel_obj relative tolerance parameter for convergence
    * @param[in] max_iterations max number of iterations to run algorithm
    * @param[in,out] logger logger for messages
-   * @param[in,out] parameter_writer writer for parameters
-   *   (typically to file)
+   * @param[in,out] parameter_writer writer for the adapted eta
    * @param[in,out] diagnostic_writer writer for diagnostic information
+   * @param[in,out] interrupt interrupt callback called once an
+   *   iteration, or nullptr
+   * @param[in,out] leader if not null, the best ELBO shared with other
+   *   approximations fit in parallel, see stochastic_gradient_ascent()
+   * @return false if the fit was abandoned because it trailed the
+   *   leader, true otherwise
    */
-  int run(double eta, bool adapt_engaged, int adapt_iterations,
-          double tol_rel_obj, int max_iterations, callbacks::logger& logger,
-          callbacks::writer& parameter_writer,
-          callbacks::writer& diagnostic_writer) const {
+  bool fit(Q& variational, double eta, bool adapt_engaged,
+           int adapt_iterations, double tol_rel_obj, int max_iterations,
+           callbacks::logger& logger, callbacks::writer& parameter_writer,
+           callbacks::writer& diagnostic_writer,
+           callbacks::interrupt* interrupt = nullptr,
+           elbo_leader* leader = nullptr) const {
     diagnostic_writer("iter,time_in_seconds,ELBO");
 
     // Initialize variational approximation
-    Q variational = Q(cont_params_);
+    variational = initial_variational();
 
     if (adapt_engaged) {
-      eta = adapt_eta(variational, adapt_iterations, logger);
+      eta = parallel_
+                ? adapt_eta_parallel(variational, adapt_iterations, logger,
+                                     interrupt)
+                : adapt_eta(variational, adapt_iterations, logger, interrupt);
       parameter_writer("Stepsize adaptation complete.");
       std::stringstream ss;
       ss << "eta = " << eta;
       parameter_writer(ss.str());
     }
 
-    stochastic_gradient_ascent(variational, eta, tol_rel_obj, max_iterations,
-                               logger, diagnostic_writer);
+    return stochastic_gradient_ascent(variational, eta, tol_rel_obj,
+                                      max_iterations, logger,
+                                      diagnostic_writer, interrupt, leader);
+  }
 
+  /**
+   * Writes the mean of the specified approximation, then the draws
+   * from it with their log densities, as run() does.
+   *
+   * @param[in] variational approximation
+   * @param[in,out] logger logger for messages
+   * @param[in,out] parameter_writer writer for parameters
+   */
+  void write_approximation(const Q& variational, callbacks::logger& logger,
+                           callbacks::writer& parameter_writer) const {
     // Write posterior mean of variational approximations.
     cont_params_ = variational.mean();
     std::vector<double> cont_vector(cont_params_.size());
@@ -497,25 +909,57 @@ class advi {
     ss << "Drawing a sample of size " << n_posterior_samples_
        << " from the approximate posterior... ";
     logger.info(ss);
-    double log_p = 0;
-    double log_g = 0;
-    // Draw posterior sample. log_g is the log normal densities.
-    for (int n = 0; n < n_posterior_samples_; ++n) {
-      variational.sample_log_g(rng_, cont_params_, log_g);
-      for (int i = 0; i < cont_params_.size(); ++i) {
-        cont_vector.at(i) = cont_params_(i);
+    if (parallel_) {
+      write_draws_parallel(variational, logger, parameter_writer);
+    } else {
+      double log_p = 0;
+      double log_g = 0;
+      // Draw posterior sample. log_g is the log normal densities.
+      for (int n = 0; n < n_posterior_samples_; ++n) {
+        variational.sample_log_g(rng_, cont_params_, log_g);
+        for (int i = 0; i < cont_params_.size(); ++i) {
+          cont_vector.at(i) = cont_params_(i);
+        }
+        std::stringstream msg2;
+        model_.write_array(rng_, cont_vector, disc_vector, values, true, true,
+                           &msg2);
+        //  log_p: Log probability in the unconstrained space
+        log_p = model_.template log_prob<false, true>(cont_params_, &msg2);
+        if (msg2.str().length() > 0)
+          logger.info(msg2);
+        // Write lp__, log_p, and log_g.
+        values.insert(values.begin(), {0, log_p, log_g});
+        parameter_writer(values);
       }
-      std::stringstream msg2;
-      model_.write_array(rng_, cont_vector, disc_vector, values, true, true,
-                         &msg2);
-      //  log_p: Log probability in the unconstrained space
-      log_p = model_.template log_prob<false, true>(cont_params_, &msg2);
-      if (msg2.str().length() > 0)
-        logger.info(msg2);
-      // Write lp__, log_p, and log_g.
-      values.insert(values.begin(), {0, log_p, log_g});
-      parameter_writer(values);
     }
+  }
+
+  /**
+   * Runs ADVI and writes to output.
+   *
+   * @param[in] eta eta parameter of stepsize sequence
+   * @param[in] adapt_engaged boolean flag for eta adaptation
+   * @param[in] adapt_iterations number of iterations for eta adaptation
+   * @param[in] tol_rel_obj relative tolerance parameter for convergence
+   * @param[in] max_iterations max number of iterations to run algorithm
+   * @param[in,out] logger logger for messages
+   * @param[in,out] parameter_writer writer for parameters
+   *   (typically to file)
+   * @param[in,out] diagnostic_writer writer for diagnostic information
+   * @param[in,out] interrupt interrupt callback called once an iteration
+   *   of the eta adaptation and of the stochastic gradient ascent, or
+   *   nullptr; the ELBO written so far is kept when it throws
+   */
+  int run(double eta, bool adapt_engaged, int adapt_iterations,
+          double tol_rel_obj, int max_iterations, callbacks::logger& logger,
+          callbacks::writer& parameter_writer,
+          callbacks::writer& diagnostic_writer,
+          callbacks::interrupt* interrupt = nullptr) const {
+    Q variational = initial_variational();
+    fit(variational, eta, adapt_engaged, adapt_iterations, tol_rel_obj,
+        max_iterations, logger, parameter_writer, diagnostic_writer,
+        interrupt);
+    write_approximation(variational, logger, parameter_writer);
     logger.info("COMPLETED.");
     return stan::services::error_codes::OK;
   }
@@ -553,6 +997,96 @@ class advi {
   }
 
  protected:
+  /**
+   * Draw the sample of the approximate posterior written by run(), in
+   * parallel, and write the draws with their log densities in order.
+   *
+   * <p>The draws are made by chunks of consecutive draws, each with its
+   * own random number generator, seeded in turn from the generator of
+   * this object, used both to draw from the approximation and for the
+   * generated quantities, so the output does not depend on the number
+   * of threads.  A bounded window of chunks is drawn before the draws
+   * and their messages are written by the calling thread.
+   *
+   * <p>The random number generator must be constructible from one of
+   * its own draws.
+   *
+   * @param[in] variational approximation from which to draw
+   * @param[in,out] logger logger for messages
+   * @param[in,out] parameter_writer writer for the draws
+   */
+  void write_draws_parallel(const Q& variational, callbacks::logger& logger,
+                            callbacks::writer& parameter_writer) const {
+    const int chunk_size = 64;
+    const int window
+        = chunk_size * 4
+          * std::max(tbb::this_task_arena::max_concurrency(), 1);
+    const int num_chunks_window = window / chunk_size;
+    std::vector<std::vector<double>> draws(window);
+    std::vector<std::string> msgs(window);
+    std::vector<typename BaseRNG::result_type> seeds(num_chunks_window);
+    for (int first = 0; first < n_posterior_samples_; first += window) {
+      const int num_draws = std::min(window, n_posterior_samples_ - first);
+      const int num_chunks = (num_draws + chunk_size - 1) / chunk_size;
+      for (int c = 0; c < num_chunks; ++c)
+        seeds[c] = rng_();
+      tbb::parallel_for(
+          tbb::blocked_range<int>(0, num_chunks, 1),
+          [&](const tbb::blocked_range<int>& r) {
+            Eigen::VectorXd zeta(cont_params_.size());
+            std::vector<double> cont_vector(cont_params_.size());
+            std::vector<int> disc_vector;
+            for (int c = r.begin(); c != r.end(); ++c) {
+              BaseRNG chunk_rng(seeds[c]);
+              const int end = std::min(num_draws, (c + 1) * chunk_size);
+              for (int n = c * chunk_size; n < end; ++n) {
+                double log_g = 0;
+                variational.sample_log_g(chunk_rng, zeta, log_g);
+                for (int i = 0; i < zeta.size(); ++i)
+                  cont_vector[i] = zeta(i);
+                std::stringstream msg;
+                std::vector<double>& values = draws[n];
+                stan::model::double_arena_scope scope;
+                model_.write_array(chunk_rng, cont_vector, disc_vector, values,
+                                   true, true, &msg);
+                //  log_p: Log probability in the unconstrained space
+                double log_p
+                    = model_.template log_prob<false, true>(zeta, &msg);
+                values.insert(values.begin(), {0, log_p, log_g});
+                msgs[n] = msg.str();
+              }
+            }
+          },
+          tbb::simple_partitioner());
+
+      for (int n = 0; n < num_draws; ++n) {
+        if (msgs[n].length() > 0)
+          logger.info(msgs[n]);
+        parameter_writer(draws[n]);
+      }
+    }
+  }
+
+  /**
+   * Return the initial variational approximation, the one given on
+   * construction or else one centered at the continuous parameters.
+   */
+  Q initial_variational() const {
+    return init_variational_ ? *init_variational_ : Q(cont_params_);
+  }
+
+  /**
+   * Return an approximation of the shape of the initial one with all
+   * entries zero.
+   */
+  Q zero_variational() const {
+    if (!init_variational_)
+      return Q(model_.num_params_r());
+    Q zero(*init_variational_);
+    zero.set_to_zero();
+    return zero;
+  }
+
   Model& model_;
   Eigen::VectorXd& cont_params_;
   BaseRNG& rng_;
@@ -560,6 +1094,10 @@ class advi {
   int n_monte_carlo_elbo_;
   int eval_elbo_;
   int n_posterior_samples_;
+  bool parallel_;
+  bool sticking_the_landing_;
+  size_t minibatch_size_;
+  std::shared_ptr<const Q> init_variational_;
 };
 }  // namespace variational
 }  // namespace stan
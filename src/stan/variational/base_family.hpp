@@ -82,7 +82,8 @@ class base_family {
   template <class M, class BaseRNG>
   void calc_grad(base_family& elbo_grad, M& m, Eigen::VectorXd& cont_params,
                  int n_monte_carlo_grad, BaseRNG& rng,
-                 callbacks::logger& logger) const;
+                 callbacks::logger& logger, bool parallel = false,
+                 bool sticking_the_landing = false) const;
 
  protected:
   void write_error_msg_(std::ostream* error_msgs,
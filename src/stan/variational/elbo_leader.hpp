@@ -0,0 +1,70 @@
+#ifndef STAN_VARIATIONAL_ELBO_LEADER_HPP
+#define STAN_VARIATIONAL_ELBO_LEADER_HPP
+
+#include <atomic>
+#include <limits>
+
+namespace stan {
+namespace variational {
+
+/**
+ * Best ELBO reached so far by several variational approximations fit
+ * in parallel, such as the paths of a multi-path pathfinder or the runs
+ * of a multi-run ADVI, shared by them so that one whose best ELBO
+ * trails the leader by more than a margin, after a minimum number of
+ * iterations, can stop early instead of spending its remaining
+ * iterations on an approximation that would not be kept or would be
+ * given little weight.
+ */
+class elbo_leader {
+ public:
+  /**
+   * @param min_iterations Number of iterations before an approximation
+   * can be abandoned
+   * @param margin Non-negative difference of ELBO by which an
+   * approximation must trail the leader to be abandoned. Infinity never
+   * abandons one.
+   */
+  elbo_leader(int min_iterations, double margin)
+      : min_iterations_(min_iterations), margin_(margin) {}
+
+  /**
+   * Update the leading ELBO with the best ELBO of an approximation.
+   * @param elbo best ELBO of an approximation
+   */
+  void update(double elbo) {
+    double best = best_.load();
+    while (elbo > best && !best_.compare_exchange_weak(best, elbo)) {
+    }
+  }
+
+  /**
+   * Return `true` if an approximation should be abandoned. The one
+   * holding the leading ELBO never is, so at least one always completes.
+   * @param iter Current iteration of the approximation
+   * @param elbo Best ELBO of the approximation
+   */
+  bool trails(int iter, double elbo) const {
+    return iter >= min_iterations_ && elbo < best_.load() - margin_;
+  }
+
+  /**
+   * Record that an approximation was abandoned.
+   */
+  void abandon() { ++num_abandoned_; }
+
+  /**
+   * Return the number of approximations abandoned.
+   */
+  int num_abandoned() const { return num_abandoned_.load(); }
+
+ private:
+  const int min_iterations_;
+  const double margin_;
+  std::atomic<double> best_{-std::numeric_limits<double>::infinity()};
+  std::atomic<int> num_abandoned_{0};
+};
+
+}  // namespace variational
+}  // namespace stan
+#endif
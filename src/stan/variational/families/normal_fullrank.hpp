@@ -5,6 +5,7 @@
 #include <stan/math/prim.hpp>
 #include <stan/model/gradient.hpp>
 #include <stan/variational/base_family.hpp>
+#include <stan/variational/parallel_monte_carlo.hpp>
 #include <algorithm>
 #include <ostream>
 #include <vector>
@@ -168,8 +169,8 @@ class normal_fullrank : public base_family {
    * matrix to zero.
    */
   void set_to_zero() {
-    mu_ = Eigen::VectorXd::Zero(dimension());
-    L_chol_ = Eigen::MatrixXd::Zero(dimension(), dimension());
+    mu_.setZero();
+    L_chol_.setZero();
   }
 
   /**
@@ -299,6 +300,66 @@ class normal_fullrank : public base_family {
     return *this;
   }
 
+  /**
+   * Return this approximation after setting each entry in the mean
+   * and Cholesky factor to <code>decay * x + weight * y^2</code>,
+   * where <code>y</code> is the corresponding entry of the specified
+   * approximation.  Equivalent to
+   * <code>*this = decay * *this + weight * rhs.square()</code>
+   * without temporaries.
+   *
+   * @param[in] rhs Approximation whose entries are squared.
+   * @param[in] decay Weight of the entries of this approximation.
+   * @param[in] weight Weight of the squared entries.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality of the specified
+   * approximation does not match this approximation's dimensionality.
+   */
+  normal_fullrank& add_weighted_square(const normal_fullrank& rhs,
+                                       double decay, double weight) {
+    static const char* function
+        = "stan::variational::normal_fullrank::add_weighted_square";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    mu_.array() = decay * mu_.array() + weight * rhs.mu_.array().square();
+    L_chol_.array()
+        = decay * L_chol_.array() + weight * rhs.L_chol_.array().square();
+    return *this;
+  }
+
+  /**
+   * Return this approximation after adding to each entry in the mean
+   * and Cholesky factor <code>step * y / (offset + sqrt(h))</code>,
+   * where <code>y</code> and <code>h</code> are the corresponding
+   * entries of the specified approximations.  Equivalent to
+   * <code>*this += step * rhs / (offset + scale.sqrt())</code>
+   * without temporaries.
+   *
+   * @param[in] rhs Approximation giving the direction of the step.
+   * @param[in] scale Approximation whose square roots scale the step.
+   * @param[in] step Step size.
+   * @param[in] offset Scalar added to the square roots.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality of the specified
+   * approximations does not match this approximation's dimensionality.
+   */
+  normal_fullrank& add_scaled_step(const normal_fullrank& rhs,
+                                   const normal_fullrank& scale, double step,
+                                   double offset) {
+    static const char* function
+        = "stan::variational::normal_fullrank::add_scaled_step";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of scale", scale.dimension());
+    mu_.array()
+        += (step * rhs.mu_.array()) / (scale.mu_.array().sqrt() + offset);
+    L_chol_.array()
+        += (step * rhs.L_chol_.array())
+           / (scale.L_chol_.array().sqrt() + offset);
+    return *this;
+  }
+
   /**
    * Returns the mean vector for this approximation.
    *
@@ -348,7 +409,7 @@ class normal_fullrank : public base_family {
                                  dimension());
     stan::math::check_not_nan(function, "Input vector", eta);
 
-    return (L_chol_ * eta) + mu_;
+    return (L_chol_.triangularView<Eigen::Lower>() * eta) + mu_;
   }
 
   template <class BaseRNG>
@@ -388,19 +449,25 @@ class normal_fullrank : public base_family {
    *
    * @tparam M Model class.
    * @tparam BaseRNG Class of base random number generator.
-   * @param[in] elbo_grad Approximation to store "blackbox" gradient.
+   * @param[out] elbo_grad Approximation to store "blackbox" gradient,
+   * other than this one.
    * @param[in] m Model.
    * @param[in] cont_params Continuous parameters.
    * @param[in] n_monte_carlo_grad Sample size for gradient computation.
    * @param[in,out] rng Random number generator.
    * @param[in,out] logger logger for messages
+   * @param[in] parallel evaluate the Monte Carlo draws in parallel, see
+   * parallel_monte_carlo()
+   * @param[in] sticking_the_landing use the "sticking the landing"
+   * estimator, see <code>advi</code>
    * @throw std::domain_error If the number of divergent
    * iterations exceeds its specified bounds.
    */
   template <class M, class BaseRNG>
   void calc_grad(normal_fullrank& elbo_grad, M& m, Eigen::VectorXd& cont_params,
                  int n_monte_carlo_grad, BaseRNG& rng,
-                 callbacks::logger& logger) const {
+                 callbacks::logger& logger, bool parallel = false,
+                 bool sticking_the_landing = false) const {
     static const char* function
         = "stan::variational::normal_fullrank::calc_grad";
     stan::math::check_size_match(function, "Dimension of elbo_grad",
@@ -410,56 +477,94 @@ class normal_fullrank : public base_family {
                                  dimension(), "Dimension of variables in model",
                                  cont_params.size());
 
-    Eigen::VectorXd mu_grad = Eigen::VectorXd::Zero(dimension());
-    Eigen::MatrixXd L_grad = Eigen::MatrixXd::Zero(dimension(), dimension());
+    // The gradient is accumulated in place; its Cholesky factor part
+    // stays lower triangular
+    Eigen::VectorXd& mu_grad = elbo_grad.mu_;
+    Eigen::MatrixXd& L_grad = elbo_grad.L_chol_;
+    L_grad.setZero();
     double tmp_lp = 0.0;
     Eigen::VectorXd tmp_mu_grad = Eigen::VectorXd::Zero(dimension());
     Eigen::VectorXd eta = Eigen::VectorXd::Zero(dimension());
     Eigen::VectorXd zeta = Eigen::VectorXd::Zero(dimension());
+    // The draws and their gradients, one per column, so the gradient of
+    // the Cholesky factor is accumulated by a single matrix product
+    Eigen::MatrixXd etas(dimension(), n_monte_carlo_grad);
+    Eigen::MatrixXd grads(dimension(), n_monte_carlo_grad);
 
     // Naive Monte Carlo integration
     static const int n_retries = 10;
-    for (int i = 0, n_monte_carlo_drop = 0; i < n_monte_carlo_grad;) {
-      // Draw from standard normal and transform to real-coordinate space
-      for (int d = 0; d < dimension(); ++d) {
-        eta(d) = stan::math::normal_rng(0, 1, rng);
-      }
-      zeta = transform(eta);
-      try {
-        std::stringstream ss;
-        stan::model::gradient(m, zeta, tmp_lp, tmp_mu_grad, &ss);
-        if (ss.str().length() > 0)
-          logger.info(ss);
-        stan::math::check_finite(function, "Gradient of mu", tmp_mu_grad);
-
-        mu_grad += tmp_mu_grad;
-        for (int ii = 0; ii < dimension(); ++ii) {
-          for (int jj = 0; jj <= ii; ++jj) {
-            L_grad(ii, jj) += tmp_mu_grad(ii) * eta(jj);
-          }
+    if (parallel) {
+      parallel_monte_carlo(
+          function, n_monte_carlo_grad, n_retries * n_monte_carlo_grad,
+          [&](int i) {
+            for (int d = 0; d < dimension(); ++d)
+              etas(d, i) = stan::math::normal_rng(0, 1, rng);
+          },
+          [&](int i, std::ostream& msgs) {
+            double lp = 0.0;
+            Eigen::VectorXd grad;
+            try {
+              stan::model::gradient(m, transform(etas.col(i)), lp, grad,
+                                    &msgs);
+              stan::math::check_finite(function, "Gradient of mu", grad);
+            } catch (const std::exception& e) {
+              return false;
+            }
+            grads.col(i) = grad;
+            return true;
+          },
+          logger);
+      // The gradient of -log q(zeta) with respect to zeta is
+      // L^{-T} eta, added to that of the model for sticking the landing
+      if (sticking_the_landing)
+        grads += L_chol_.triangularView<Eigen::Lower>().transpose().solve(
+            etas);
+    } else {
+      for (int i = 0, n_monte_carlo_drop = 0; i < n_monte_carlo_grad;) {
+        // Draw from standard normal and transform to real-coordinate space
+        for (int d = 0; d < dimension(); ++d) {
+          eta(d) = stan::math::normal_rng(0, 1, rng);
         }
-        ++i;
-      } catch (const std::exception& e) {
-        ++n_monte_carlo_drop;
-        if (n_monte_carlo_drop >= n_retries * n_monte_carlo_grad) {
-          const char* name = "The number of dropped evaluations";
-          const char* msg1 = "has reached its maximum amount (";
-          int y = n_retries * n_monte_carlo_grad;
-          const char* msg2
-              = "). Your model may be either severely "
-                "ill-conditioned or misspecified.";
-          stan::math::throw_domain_error(function, name, y, msg1, msg2);
+        zeta = transform(eta);
+        try {
+          std::stringstream ss;
+          stan::model::gradient(m, zeta, tmp_lp, tmp_mu_grad, &ss);
+          if (ss.str().length() > 0)
+            logger.info(ss);
+          stan::math::check_finite(function, "Gradient of mu", tmp_mu_grad);
+          if (sticking_the_landing)
+            tmp_mu_grad
+                += L_chol_.triangularView<Eigen::Lower>().transpose().solve(
+                    eta);
+
+          etas.col(i) = eta;
+          grads.col(i) = tmp_mu_grad;
+          ++i;
+        } catch (const std::exception& e) {
+          ++n_monte_carlo_drop;
+          if (n_monte_carlo_drop >= n_retries * n_monte_carlo_grad) {
+            const char* name = "The number of dropped evaluations";
+            const char* msg1 = "has reached its maximum amount (";
+            int y = n_retries * n_monte_carlo_grad;
+            const char* msg2
+                = "). Your model may be either severely "
+                  "ill-conditioned or misspecified.";
+            stan::math::throw_domain_error(function, name, y, msg1, msg2);
+          }
         }
       }
     }
+    mu_grad = grads.rowwise().sum();
+    L_grad.triangularView<Eigen::Lower>() = grads * etas.transpose();
     mu_grad /= static_cast<double>(n_monte_carlo_grad);
     L_grad /= static_cast<double>(n_monte_carlo_grad);
 
-    // Add gradient of entropy term
-    L_grad.diagonal().array() += L_chol_.diagonal().array().inverse();
+    // Add gradient of entropy term, which sticking the landing estimates
+    if (!sticking_the_landing)
+      L_grad.diagonal().array() += L_chol_.diagonal().array().inverse();
 
-    elbo_grad.set_mu(mu_grad);
-    elbo_grad.set_L_chol(L_grad);
+    stan::math::check_not_nan(function, "Gradient of mu", mu_grad);
+    stan::math::check_not_nan(function, "Gradient of L_chol", L_grad);
   }
 };
 
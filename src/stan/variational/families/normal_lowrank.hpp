@@ -0,0 +1,778 @@
+#ifndef STAN_VARIATIONAL_NORMAL_LOWRANK_HPP
+#define STAN_VARIATIONAL_NORMAL_LOWRANK_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <stan/model/gradient.hpp>
+#include <stan/variational/base_family.hpp>
+#include <stan/variational/parallel_monte_carlo.hpp>
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+namespace stan {
+
+namespace variational {
+
+/**
+ * Variational family approximation with a multivariate normal
+ * distribution whose covariance is a diagonal plus a low-rank term,
+ *
+ * Sigma = B * B.transpose() + diag(exp(2 * omega)),
+ *
+ * where B is a dim x rank factor.  Draws, the entropy and the
+ * gradient cost O(dim * rank^2) time and O(dim * rank) memory, in
+ * between the mean field and the full rank approximations.
+ *
+ * A draw is the transform of a standard normal vector of size
+ * dim + rank; see <code>transform()</code>.
+ */
+class normal_lowrank : public base_family {
+ private:
+  /**
+   * Mean vector.
+   */
+  Eigen::VectorXd mu_;
+
+  /**
+   * Log standard deviation of the diagonal term.
+   */
+  Eigen::VectorXd omega_;
+
+  /**
+   * Factor of the low-rank term of the covariance.
+   */
+  Eigen::MatrixXd B_;
+
+  /**
+   * Dimensionality of distribution.
+   */
+  const int dimension_;
+
+  /**
+   * Rank of the low-rank term of the covariance.
+   */
+  const int rank_;
+
+  /**
+   * Raise a domain exception if the specified vector contains
+   * not-a-number values.
+   *
+   * @param[in] mu Mean vector.
+   * @throw std::domain_error If the mean vector contains NaN
+   * values or does not match this distribution's dimensionality.
+   */
+  void validate_mean(const char* function, const Eigen::VectorXd& mu) {
+    stan::math::check_not_nan(function, "Mean vector", mu);
+    stan::math::check_size_match(function, "Dimension of input vector",
+                                 mu.size(), "Dimension of current vector",
+                                 dimension());
+  }
+
+  /**
+   * Raise a domain exception if the specified vector contains
+   * not-a-number values.
+   *
+   * @param[in] omega Log standard deviation vector.
+   * @throw std::domain_error If the log standard deviation vector
+   * contains NaN values or does not match this distribution's
+   * dimensionality.
+   */
+  void validate_omega(const char* function, const Eigen::VectorXd& omega) {
+    stan::math::check_not_nan(function, "Log standard deviation vector",
+                              omega);
+    stan::math::check_size_match(function, "Dimension of input vector",
+                                 omega.size(), "Dimension of current vector",
+                                 dimension());
+  }
+
+  /**
+   * Raise a domain exception if the specified matrix contains
+   * not-a-number values or is not of size dim x rank.
+   *
+   * @param[in] B Factor of the low-rank term.
+   * @throw std::domain_error If the factor contains NaN values or
+   * does not match this distribution's dimensionality and rank.
+   */
+  void validate_factor(const char* function, const Eigen::MatrixXd& B) {
+    stan::math::check_size_match(function, "Rows of factor", B.rows(),
+                                 "Dimension of mean vector", dimension());
+    stan::math::check_size_match(function, "Columns of factor", B.cols(),
+                                 "Rank of approximation", rank());
+    stan::math::check_not_nan(function, "Factor", B);
+  }
+
+  /**
+   * Return the Cholesky factorization of the rank x rank matrix
+   * I + V^T V, where V = diag(exp(-omega)) * B.  By the matrix
+   * determinant lemma and the Woodbury identity it carries the
+   * determinant and the inverse of the covariance.
+   *
+   * @param[out] V Factor scaled by the inverse diagonal standard
+   * deviations.
+   * @return Cholesky factorization of I + V^T V.
+   */
+  Eigen::LLT<Eigen::MatrixXd> capacitance(Eigen::MatrixXd& V) const {
+    V = (-omega_).array().exp().matrix().asDiagonal() * B_;
+    Eigen::MatrixXd C = Eigen::MatrixXd::Identity(rank(), rank());
+    C.noalias() += V.transpose() * V;
+    return Eigen::LLT<Eigen::MatrixXd>(C);
+  }
+
+ public:
+  /**
+   * Construct a variational distribution of the specified
+   * dimensionality and rank with a zero mean, zero log standard
+   * deviation and zero factor.
+   *
+   * @param[in] dimension Dimensionality of distribution.
+   * @param[in] rank Rank of the low-rank term.
+   * @throw std::domain_error If the rank is not positive.
+   */
+  explicit normal_lowrank(size_t dimension, size_t rank = 1)
+      : mu_(Eigen::VectorXd::Zero(dimension)),
+        omega_(Eigen::VectorXd::Zero(dimension)),
+        B_(Eigen::MatrixXd::Zero(dimension, rank)),
+        dimension_(dimension),
+        rank_(rank) {
+    stan::math::check_positive("stan::variational::normal_lowrank", "Rank",
+                               rank_);
+  }
+
+  /**
+   * Construct a variational distribution with specified mean vector,
+   * identity covariance and a zero factor of the specified rank.
+   *
+   * @param[in] cont_params Mean vector.
+   * @param[in] rank Rank of the low-rank term.
+   * @throw std::domain_error If the rank is not positive.
+   */
+  explicit normal_lowrank(const Eigen::VectorXd& cont_params,
+                          size_t rank = 1)
+      : mu_(cont_params),
+        omega_(Eigen::VectorXd::Zero(cont_params.size())),
+        B_(Eigen::MatrixXd::Zero(cont_params.size(), rank)),
+        dimension_(cont_params.size()),
+        rank_(rank) {
+    stan::math::check_positive("stan::variational::normal_lowrank", "Rank",
+                               rank_);
+  }
+
+  /**
+   * Construct a variational distribution with specified mean, log
+   * standard deviation of the diagonal term and factor of the
+   * low-rank term.
+   *
+   * @param[in] mu Mean vector.
+   * @param[in] omega Log standard deviation vector.
+   * @param[in] B Factor of the low-rank term.
+   * @throw std::domain_error If the factor has no columns, if the
+   * sizes do not match, or if any of the elements is not-a-number.
+   */
+  normal_lowrank(const Eigen::VectorXd& mu, const Eigen::VectorXd& omega,
+                 const Eigen::MatrixXd& B)
+      : mu_(mu),
+        omega_(omega),
+        B_(B),
+        dimension_(mu.size()),
+        rank_(B.cols()) {
+    static const char* function = "stan::variational::normal_lowrank";
+    stan::math::check_positive(function, "Rank", rank_);
+    validate_mean(function, mu);
+    validate_omega(function, omega);
+    validate_factor(function, B);
+  }
+
+  /**
+   * Return the dimensionality of the approximation.
+   */
+  int dimension() const { return dimension_; }
+
+  /**
+   * Return the rank of the low-rank term of the covariance.
+   */
+  int rank() const { return rank_; }
+
+  /**
+   * Return the mean vector.
+   */
+  const Eigen::VectorXd& mu() const { return mu_; }
+
+  /**
+   * Return the log standard deviation vector of the diagonal term.
+   */
+  const Eigen::VectorXd& omega() const { return omega_; }
+
+  /**
+   * Return the factor of the low-rank term of the covariance.
+   */
+  const Eigen::MatrixXd& B() const { return B_; }
+
+  /**
+   * Set the mean vector to the specified value.
+   *
+   * @param[in] mu Mean vector.
+   * @throw std::domain_error If the mean vector's size does not
+   * match this approximation's dimensionality, or if it contains
+   * not-a-number values.
+   */
+  void set_mu(const Eigen::VectorXd& mu) {
+    static const char* function = "stan::variational::set_mu";
+    validate_mean(function, mu);
+    mu_ = mu;
+  }
+
+  /**
+   * Set the log standard deviation vector to the specified value.
+   *
+   * @param[in] omega Log standard deviation vector.
+   * @throw std::domain_error If the log standard deviation vector's
+   * size does not match this approximation's dimensionality, or if it
+   * contains not-a-number values.
+   */
+  void set_omega(const Eigen::VectorXd& omega) {
+    static const char* function = "stan::variational::set_omega";
+    validate_omega(function, omega);
+    omega_ = omega;
+  }
+
+  /**
+   * Set the factor of the low-rank term to the specified value.
+   *
+   * @param[in] B Factor of the low-rank term.
+   * @throw std::domain_error If the factor is not of size dim x rank,
+   * or if it contains not-a-number values.
+   */
+  void set_B(const Eigen::MatrixXd& B) {
+    static const char* function = "stan::variational::set_B";
+    validate_factor(function, B);
+    B_ = B;
+  }
+
+  /**
+   * Set the mean, log standard deviation and factor to zero.
+   */
+  void set_to_zero() {
+    mu_.setZero();
+    omega_.setZero();
+    B_.setZero();
+  }
+
+  /**
+   * Return a new low rank approximation resulting from squaring
+   * the entries in the mean, log standard deviation and factor.
+   * The new approximation does not hold any references to this
+   * approximation.
+   */
+  normal_lowrank square() const {
+    return normal_lowrank(Eigen::VectorXd(mu_.array().square()),
+                          Eigen::VectorXd(omega_.array().square()),
+                          Eigen::MatrixXd(B_.array().square()));
+  }
+
+  /**
+   * Return a new low rank approximation resulting from taking the
+   * square root of the entries in the mean, log standard deviation
+   * and factor.  The new approximation does not hold any references
+   * to this approximation.
+   *
+   * <b>Warning:</b>  No checks are carried out to ensure the
+   * entries are non-negative before taking square roots, so
+   * not-a-number values may result.
+   */
+  normal_lowrank sqrt() const {
+    return normal_lowrank(Eigen::VectorXd(mu_.array().sqrt()),
+                          Eigen::VectorXd(omega_.array().sqrt()),
+                          Eigen::MatrixXd(B_.array().sqrt()));
+  }
+
+  /**
+   * Return this approximation after setting its mean, log standard
+   * deviation and factor to the values given by the specified
+   * approximation.
+   *
+   * @param[in] rhs Approximation from which to gather the values.
+   * @return This approximation after assignment.
+   * @throw std::invalid_argument If the dimensionality or rank of the
+   * specified approximation does not match this approximation's.
+   */
+  normal_lowrank& operator=(const normal_lowrank& rhs) {
+    static const char* function
+        = "stan::variational::normal_lowrank::operator=";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of rhs", rhs.rank());
+    mu_ = rhs.mu();
+    omega_ = rhs.omega();
+    B_ = rhs.B();
+    return *this;
+  }
+
+  /**
+   * Add the mean, log standard deviation and factor of the specified
+   * approximation to this approximation.
+   *
+   * @param[in] rhs Approximation from which to gather the values.
+   * @return This approximation after adding the specified
+   * approximation.
+   * @throw std::invalid_argument If the dimensionality or rank of the
+   * specified approximation does not match this approximation's.
+   */
+  normal_lowrank& operator+=(const normal_lowrank& rhs) {
+    static const char* function
+        = "stan::variational::normal_lowrank::operator+=";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of rhs", rhs.rank());
+    mu_ += rhs.mu();
+    omega_ += rhs.omega();
+    B_ += rhs.B();
+    return *this;
+  }
+
+  /**
+   * Return this approximation after elementwise division by the
+   * specified approximation's mean, log standard deviation and
+   * factor.
+   *
+   * @param[in] rhs Approximation from which to gather the values.
+   * @return This approximation after elementwise division by the
+   * specified approximation.
+   * @throw std::invalid_argument If the dimensionality or rank of the
+   * specified approximation does not match this approximation's.
+   */
+  normal_lowrank& operator/=(const normal_lowrank& rhs) {
+    static const char* function
+        = "stan::variational::normal_lowrank::operator/=";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of rhs", rhs.rank());
+    mu_.array() /= rhs.mu().array();
+    omega_.array() /= rhs.omega().array();
+    B_.array() /= rhs.B().array();
+    return *this;
+  }
+
+  /**
+   * Return this approximation after adding the specified scalar
+   * to each entry in the mean, log standard deviation and factor.
+   *
+   * <b>Warning:</b> No finiteness check is made on the scalar, so
+   * it may introduce NaNs.
+   *
+   * @param[in] scalar Scalar to add.
+   * @return This approximation after elementwise addition of the
+   * specified scalar.
+   */
+  normal_lowrank& operator+=(double scalar) {
+    mu_.array() += scalar;
+    omega_.array() += scalar;
+    B_.array() += scalar;
+    return *this;
+  }
+
+  /**
+   * Return this approximation after multiplying each entry in the
+   * mean, log standard deviation and factor by the specified scalar.
+   *
+   * <b>Warning:</b> No finiteness check is made on the scalar, so
+   * it may introduce NaNs.
+   *
+   * @param[in] scalar Scalar to multiply by.
+   * @return This approximation after elementwise multiplication by
+   * the specified scalar.
+   */
+  normal_lowrank& operator*=(double scalar) {
+    mu_ *= scalar;
+    omega_ *= scalar;
+    B_ *= scalar;
+    return *this;
+  }
+
+  /**
+   * Return this approximation after setting each entry in the mean,
+   * log standard deviation and factor to
+   * <code>decay * x + weight * y^2</code>, where <code>y</code> is
+   * the corresponding entry of the specified approximation.
+   *
+   * @param[in] rhs Approximation whose entries are squared.
+   * @param[in] decay Weight of the entries of this approximation.
+   * @param[in] weight Weight of the squared entries.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality or rank of the
+   * specified approximation does not match this approximation's.
+   */
+  normal_lowrank& add_weighted_square(const normal_lowrank& rhs,
+                                      double decay, double weight) {
+    static const char* function
+        = "stan::variational::normal_lowrank::add_weighted_square";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of rhs", rhs.rank());
+    mu_.array() = decay * mu_.array() + weight * rhs.mu_.array().square();
+    omega_.array()
+        = decay * omega_.array() + weight * rhs.omega_.array().square();
+    B_.array() = decay * B_.array() + weight * rhs.B_.array().square();
+    return *this;
+  }
+
+  /**
+   * Return this approximation after adding to each entry in the
+   * mean, log standard deviation and factor
+   * <code>step * y / (offset + sqrt(h))</code>, where <code>y</code>
+   * and <code>h</code> are the corresponding entries of the specified
+   * approximations.
+   *
+   * @param[in] rhs Approximation giving the direction of the step.
+   * @param[in] scale Approximation whose square roots scale the step.
+   * @param[in] step Step size.
+   * @param[in] offset Scalar added to the square roots.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality or rank of the
+   * specified approximations does not match this approximation's.
+   */
+  normal_lowrank& add_scaled_step(const normal_lowrank& rhs,
+                                  const normal_lowrank& scale, double step,
+                                  double offset) {
+    static const char* function
+        = "stan::variational::normal_lowrank::add_scaled_step";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of rhs", rhs.rank());
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of scale", scale.dimension());
+    stan::math::check_size_match(function, "Rank of lhs", rank(),
+                                 "Rank of scale", scale.rank());
+    mu_.array()
+        += (step * rhs.mu_.array()) / (scale.mu_.array().sqrt() + offset);
+    omega_.array()
+        += (step * rhs.omega_.array()) / (scale.omega_.array().sqrt() + offset);
+    B_.array() += (step * rhs.B_.array()) / (scale.B_.array().sqrt() + offset);
+    return *this;
+  }
+
+  /**
+   * Returns the mean vector for this approximation.
+   *
+   * See: <code>mu()</code>.
+   *
+   * @return Mean vector for this approximation.
+   */
+  const Eigen::VectorXd& mean() const { return mu(); }
+
+  /**
+   * Return the entropy of this approximation.
+   *
+   * <p>By the matrix determinant lemma the entropy is
+   *   0.5 * dim * (1+log2pi) + 0.5 * log det Sigma
+   * = 0.5 * dim * (1+log2pi) + sum(omega) + 0.5 * log det (I + V^T V),
+   * with V = diag(exp(-omega)) * B.
+   *
+   * @return Entropy of this approximation.
+   */
+  double entropy() const {
+    Eigen::MatrixXd V;
+    Eigen::LLT<Eigen::MatrixXd> C_llt = capacitance(V);
+    return 0.5 * static_cast<double>(dimension())
+               * (1.0 + stan::math::LOG_TWO_PI)
+           + omega_.sum()
+           + C_llt.matrixLLT().diagonal().array().log().sum();
+  }
+
+  /**
+   * Return the transform of the specified standard normal vector of
+   * size dim + rank.
+   *
+   * The transform is defined by
+   * S^{-1}(eta) = mu + exp(omega) * eta_1 + B * eta_2,
+   * where eta_1 holds the first dim and eta_2 the last rank entries
+   * of eta.
+   *
+   * @param[in] eta Vector to transform.
+   * @throw std::invalid_argument If the specified vector's size is
+   * not dim + rank.
+   * @throw std::domain_error If the specified vector contains
+   * not-a-number values.
+   * @return Transformed vector.
+   */
+  Eigen::VectorXd transform(const Eigen::VectorXd& eta) const {
+    static const char* function
+        = "stan::variational::normal_lowrank::transform";
+    stan::math::check_size_match(function, "Dimension of input vector",
+                                 eta.size(), "Dimension plus rank",
+                                 dimension() + rank());
+    stan::math::check_not_nan(function, "Input vector", eta);
+    Eigen::VectorXd zeta = mu_;
+    zeta.array() += eta.head(dimension()).array() * omega_.array().exp();
+    zeta.noalias() += B_ * eta.tail(rank());
+    return zeta;
+  }
+
+  template <class BaseRNG>
+  void sample(BaseRNG& rng, Eigen::VectorXd& eta) const {
+    // Draw from standard normal and transform to real-coordinate space
+    Eigen::VectorXd draw(dimension() + rank());
+    for (int d = 0; d < draw.size(); ++d)
+      draw(d) = stan::math::normal_rng(0, 1, rng);
+    eta = transform(draw);
+  }
+
+  template <class BaseRNG>
+  void sample_log_g(BaseRNG& rng, Eigen::VectorXd& eta, double& log_g) const {
+    // Draw from the approximation
+    Eigen::VectorXd draw(dimension() + rank());
+    for (int d = 0; d < draw.size(); ++d)
+      draw(d) = stan::math::normal_rng(0, 1, rng);
+    // Compute the log density of the transformed draw
+    log_g = calc_log_g(draw);
+    // Transform to real-coordinate space
+    eta = transform(draw);
+  }
+
+  /**
+   * Return the log density of this approximation at the transform
+   * of the specified standard normal vector of size dim + rank,
+   * dropping the terms that do not depend on it,
+   *
+   * -0.5 * r^T Sigma^{-1} r, with r = S^{-1}(eta) - mu.
+   *
+   * Unlike for the mean field and full rank approximations, the
+   * transform is not invertible, so this is not the standard normal
+   * density of eta.
+   *
+   * @param[in] eta Vector of size dim + rank.
+   * @return The unnormalized log density of the transformed vector.
+   */
+  double calc_log_g(const Eigen::VectorXd& eta) const {
+    Eigen::MatrixXd V;
+    Eigen::LLT<Eigen::MatrixXd> C_llt = capacitance(V);
+    // u = D^{-1} r, so that r^T Sigma^{-1} r = |u|^2 - |L^{-1} V^T u|^2
+    Eigen::VectorXd u = eta.head(dimension());
+    u.noalias() += V * eta.tail(rank());
+    Eigen::VectorXd t = V.transpose() * u;
+    C_llt.matrixL().solveInPlace(t);
+    return -0.5 * (u.squaredNorm() - t.squaredNorm());
+  }
+
+  /**
+   * Calculates the "blackbox" gradient with respect to the location
+   * vector (mu), the log standard deviation vector (omega) and the
+   * factor (B).  It uses the same gradient computed from a set of
+   * Monte Carlo samples.
+   *
+   * The gradient of the entropy uses the Woodbury identity,
+   * Sigma^{-1} B = diag(exp(-2 omega)) * B * (I + V^T V)^{-1}, so no
+   * dim x dim matrix is formed.
+   *
+   * @tparam M Model class.
+   * @tparam BaseRNG Class of base random number generator.
+   * @param[out] elbo_grad Approximation to store "blackbox" gradient,
+   * other than this one.
+   * @param[in] m Model.
+   * @param[in] cont_params Continuous parameters.
+   * @param[in] n_monte_carlo_grad Sample size for gradient computation.
+   * @param[in,out] rng Random number generator.
+   * @param[in,out] logger logger for messages
+   * @param[in] parallel evaluate the Monte Carlo draws in parallel, see
+   * parallel_monte_carlo()
+   * @param[in] sticking_the_landing use the "sticking the landing"
+   * estimator, see <code>advi</code>
+   * @throw std::domain_error If the number of divergent
+   * iterations exceeds its specified bounds.
+   */
+  template <class M, class BaseRNG>
+  void calc_grad(normal_lowrank& elbo_grad, M& m, Eigen::VectorXd& cont_params,
+                 int n_monte_carlo_grad, BaseRNG& rng,
+                 callbacks::logger& logger, bool parallel = false,
+                 bool sticking_the_landing = false) const {
+    static const char* function
+        = "stan::variational::normal_lowrank::calc_grad";
+    stan::math::check_size_match(function, "Dimension of elbo_grad",
+                                 elbo_grad.dimension(),
+                                 "Dimension of variational q", dimension());
+    stan::math::check_size_match(function, "Rank of elbo_grad",
+                                 elbo_grad.rank(), "Rank of variational q",
+                                 rank());
+    stan::math::check_size_match(function, "Dimension of variational q",
+                                 dimension(), "Dimension of variables in model",
+                                 cont_params.size());
+
+    // The gradient is accumulated in place
+    Eigen::VectorXd& mu_grad = elbo_grad.mu_;
+    Eigen::VectorXd& omega_grad = elbo_grad.omega_;
+    Eigen::MatrixXd& B_grad = elbo_grad.B_;
+    mu_grad.setZero();
+    omega_grad.setZero();
+    B_grad.setZero();
+    double tmp_lp = 0.0;
+    Eigen::VectorXd tmp_mu_grad = Eigen::VectorXd::Zero(dimension());
+    Eigen::VectorXd eta = Eigen::VectorXd::Zero(dimension() + rank());
+    Eigen::VectorXd zeta = Eigen::VectorXd::Zero(dimension());
+    Eigen::MatrixXd V;
+    Eigen::LLT<Eigen::MatrixXd> C_llt = capacitance(V);
+    const Eigen::VectorXd inv_sigma = (-omega_).array().exp();
+    // The gradient of -log q(zeta) with respect to zeta, added to that
+    // of the model for sticking the landing, is Sigma^{-1} (zeta - mu)
+    // = diag(exp(-omega)) * (I - V (I + V^T V)^{-1} V^T) * u, with
+    // u = eta_1 + V eta_2 for the draws eta_1 and eta_2 of D and B
+    auto add_score = [&](auto&& grad, const auto& eta) {
+      Eigen::MatrixXd u = eta.topRows(dimension());
+      u.noalias() += V * eta.bottomRows(rank());
+      Eigen::MatrixXd w = C_llt.solve(V.transpose() * u);
+      u.noalias() -= V * w;
+      grad += inv_sigma.asDiagonal() * u;
+    };
+
+    // Naive Monte Carlo integration
+    static const int n_retries = 10;
+    if (parallel) {
+      Eigen::MatrixXd etas(dimension() + rank(), n_monte_carlo_grad);
+      Eigen::MatrixXd grads(dimension(), n_monte_carlo_grad);
+      parallel_monte_carlo(
+          function, n_monte_carlo_grad, n_retries * n_monte_carlo_grad,
+          [&](int i) {
+            for (int d = 0; d < etas.rows(); ++d)
+              etas(d, i) = stan::math::normal_rng(0, 1, rng);
+          },
+          [&](int i, std::ostream& msgs) {
+            double lp = 0.0;
+            Eigen::VectorXd grad;
+            try {
+              stan::model::gradient(m, transform(etas.col(i)), lp, grad,
+                                    &msgs);
+              stan::math::check_finite(function, "Gradient of mu", grad);
+            } catch (const std::exception& e) {
+              return false;
+            }
+            grads.col(i) = grad;
+            return true;
+          },
+          logger);
+      if (sticking_the_landing)
+        add_score(grads, etas);
+      mu_grad = grads.rowwise().sum();
+      omega_grad = grads.cwiseProduct(etas.topRows(dimension()))
+                       .rowwise()
+                       .sum();
+      B_grad.noalias() = grads * etas.bottomRows(rank()).transpose();
+    } else {
+      for (int i = 0, n_monte_carlo_drop = 0; i < n_monte_carlo_grad;) {
+        // Draw from standard normal and transform to real-coordinate space
+        for (int d = 0; d < eta.size(); ++d)
+          eta(d) = stan::math::normal_rng(0, 1, rng);
+        zeta = transform(eta);
+        try {
+          std::stringstream ss;
+          stan::model::gradient(m, zeta, tmp_lp, tmp_mu_grad, &ss);
+          if (ss.str().length() > 0)
+            logger.info(ss);
+          stan::math::check_finite(function, "Gradient of mu", tmp_mu_grad);
+          if (sticking_the_landing)
+            add_score(tmp_mu_grad, eta);
+          mu_grad += tmp_mu_grad;
+          omega_grad.array()
+              += tmp_mu_grad.array() * eta.head(dimension()).array();
+          B_grad.noalias() += tmp_mu_grad * eta.tail(rank()).transpose();
+          ++i;
+        } catch (const std::exception& e) {
+          ++n_monte_carlo_drop;
+          if (n_monte_carlo_drop >= n_retries * n_monte_carlo_grad) {
+            const char* name = "The number of dropped evaluations";
+            const char* msg1 = "has reached its maximum amount (";
+            int y = n_retries * n_monte_carlo_grad;
+            const char* msg2
+                = "). Your model may be either severely "
+                  "ill-conditioned or misspecified.";
+            stan::math::throw_domain_error(function, name, y, msg1, msg2);
+          }
+        }
+      }
+    }
+    mu_grad /= static_cast<double>(n_monte_carlo_grad);
+    omega_grad /= static_cast<double>(n_monte_carlo_grad);
+    B_grad /= static_cast<double>(n_monte_carlo_grad);
+
+    omega_grad.array() *= omega_.array().exp();
+
+    // Add gradient of entropy term, 0.5 * log det Sigma, which sticking
+    // the landing estimates.  With X = L^{-1} V^T, the gradient with
+    // respect to omega is 1 - diag(V (I + V^T V)^{-1} V^T)
+    // = 1 - colwise |X|^2
+    if (!sticking_the_landing) {
+      Eigen::MatrixXd X = V.transpose();
+      C_llt.matrixL().solveInPlace(X);
+      omega_grad.array()
+          += 1.0 - X.colwise().squaredNorm().transpose().array();
+      Eigen::MatrixXd C_inv_Bt = C_llt.solve(B_.transpose());
+      B_grad.noalias() += (-2.0 * omega_).array().exp().matrix().asDiagonal()
+                          * C_inv_Bt.transpose();
+    }
+
+    stan::math::check_not_nan(function, "Gradient of mu", mu_grad);
+    stan::math::check_not_nan(function, "Gradient of omega", omega_grad);
+    stan::math::check_not_nan(function, "Gradient of B", B_grad);
+  }
+};
+
+/**
+ * Return a new approximation resulting from adding the mean, log
+ * standard deviation and factor of the specified approximations.
+ *
+ * @param[in] lhs First approximation.
+ * @param[in] rhs Second approximation.
+ * @return Sum of the specified approximations.
+ * @throw std::invalid_argument If the dimensionalities or ranks do
+ * not match.
+ */
+inline normal_lowrank operator+(normal_lowrank lhs, const normal_lowrank& rhs) {
+  return lhs += rhs;
+}
+
+/**
+ * Return a new approximation resulting from elementwise division of
+ * of the first specified approximation by the second.
+ *
+ * @param[in] lhs First approximation.
+ * @param[in] rhs Second approximation.
+ * @return Elementwise division of the specified approximations.
+ * @throw std::invalid_argument If the dimensionalities or ranks do
+ * not match.
+ */
+inline normal_lowrank operator/(normal_lowrank lhs, const normal_lowrank& rhs) {
+  return lhs /= rhs;
+}
+
+/**
+ * Return a new approximation resulting from elementwise addition
+ * of the specified scalar to the mean, log standard deviation and
+ * factor entries of the specified approximation.
+ *
+ * @param[in] scalar Scalar value
+ * @param[in] rhs Approximation.
+ * @return Addition of scalar to specified approximation.
+ */
+inline normal_lowrank operator+(double scalar, normal_lowrank rhs) {
+  return rhs += scalar;
+}
+
+/**
+ * Return a new approximation resulting from elementwise
+ * multiplication of the specified scalar to the mean, log standard
+ * deviation and factor entries of the specified approximation.
+ *
+ * @param[in] scalar Scalar value
+ * @param[in] rhs Approximation.
+ * @return Multiplication of scalar by the specified approximation.
+ */
+inline normal_lowrank operator*(double scalar, normal_lowrank rhs) {
+  return rhs *= scalar;
+}
+
+}  // namespace variational
+}  // namespace stan
+#endif
@@ -1,10 +1,12 @@
 #ifndef STAN_VARIATIONAL_NORMAL_MEANFIELD_HPP
 #define STAN_VARIATIONAL_NORMAL_MEANFIELD_HPP
 
+#include <stan/analyze/reproducible_sum.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/math/prim.hpp>
 #include <stan/model/gradient.hpp>
 #include <stan/variational/base_family.hpp>
+#include <stan/variational/parallel_monte_carlo.hpp>
 #include <algorithm>
 #include <ostream>
 #include <vector>
@@ -137,8 +139,8 @@ class normal_meanfield : public base_family {
    * approximation to zero.
    */
   void set_to_zero() {
-    mu_ = Eigen::VectorXd::Zero(dimension());
-    omega_ = Eigen::VectorXd::Zero(dimension());
+    mu_.setZero();
+    omega_.setZero();
   }
 
   /**
@@ -266,6 +268,65 @@ class normal_meanfield : public base_family {
     return *this;
   }
 
+  /**
+   * Return this approximation after setting each entry in the mean
+   * and log standard deviation to <code>decay * x + weight * y^2</code>,
+   * where <code>y</code> is the corresponding entry of the specified
+   * approximation.  Equivalent to
+   * <code>*this = decay * *this + weight * rhs.square()</code>
+   * without temporaries.
+   *
+   * @param[in] rhs Approximation whose entries are squared.
+   * @param[in] decay Weight of the entries of this approximation.
+   * @param[in] weight Weight of the squared entries.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality of the specified
+   * approximation does not match this approximation's dimensionality.
+   */
+  normal_meanfield& add_weighted_square(const normal_meanfield& rhs,
+                                        double decay, double weight) {
+    static const char* function
+        = "stan::variational::normal_meanfield::add_weighted_square";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    mu_.array() = decay * mu_.array() + weight * rhs.mu_.array().square();
+    omega_.array()
+        = decay * omega_.array() + weight * rhs.omega_.array().square();
+    return *this;
+  }
+
+  /**
+   * Return this approximation after adding to each entry in the mean
+   * and log standard deviation <code>step * y / (offset + sqrt(h))</code>,
+   * where <code>y</code> and <code>h</code> are the corresponding
+   * entries of the specified approximations.  Equivalent to
+   * <code>*this += step * rhs / (offset + scale.sqrt())</code>
+   * without temporaries.
+   *
+   * @param[in] rhs Approximation giving the direction of the step.
+   * @param[in] scale Approximation whose square roots scale the step.
+   * @param[in] step Step size.
+   * @param[in] offset Scalar added to the square roots.
+   * @return This approximation after the update.
+   * @throw std::invalid_argument If the dimensionality of the specified
+   * approximations does not match this approximation's dimensionality.
+   */
+  normal_meanfield& add_scaled_step(const normal_meanfield& rhs,
+                                    const normal_meanfield& scale, double step,
+                                    double offset) {
+    static const char* function
+        = "stan::variational::normal_meanfield::add_scaled_step";
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of rhs", rhs.dimension());
+    stan::math::check_size_match(function, "Dimension of lhs", dimension(),
+                                 "Dimension of scale", scale.dimension());
+    mu_.array()
+        += (step * rhs.mu_.array()) / (scale.mu_.array().sqrt() + offset);
+    omega_.array()
+        += (step * rhs.omega_.array()) / (scale.omega_.array().sqrt() + offset);
+    return *this;
+  }
+
   /**
    * Returns the mean vector for this approximation.
    *
@@ -322,20 +383,27 @@ class normal_meanfield : public base_family {
    *
    * @tparam M Model class.
    * @tparam BaseRNG Class of base random number generator.
-   * @param[in] elbo_grad Parameters to store "blackbox" gradient
+   * @param[out] elbo_grad Parameters to store "blackbox" gradient, other
+   * than this approximation
    * @param[in] m Model.
    * @param[in] cont_params Continuous parameters.
    * @param[in] n_monte_carlo_grad Number of samples for gradient
    * computation.
    * @param[in,out] rng Random number generator.
    * @param[in,out] logger logger for messages
+   * @param[in] parallel evaluate the Monte Carlo draws in parallel, see
+   * parallel_monte_carlo()
+   * @param[in] sticking_the_landing use the "sticking the landing"
+   * estimator, see <code>advi</code>
    * @throw std::domain_error If the number of divergent
    * iterations exceeds its specified bounds.
    */
   template <class M, class BaseRNG>
   void calc_grad(normal_meanfield& elbo_grad, M& m,
                  Eigen::VectorXd& cont_params, int n_monte_carlo_grad,
-                 BaseRNG& rng, callbacks::logger& logger) const {
+                 BaseRNG& rng, callbacks::logger& logger,
+                 bool parallel = false,
+                 bool sticking_the_landing = false) const {
     static const char* function
         = "stan::variational::normal_meanfield::calc_grad";
 
@@ -346,39 +414,77 @@ class normal_meanfield : public base_family {
                                  dimension(), "Dimension of variables in model",
                                  cont_params.size());
 
-    Eigen::VectorXd mu_grad = Eigen::VectorXd::Zero(dimension());
-    Eigen::VectorXd omega_grad = Eigen::VectorXd::Zero(dimension());
+    // The gradient is accumulated in place
+    Eigen::VectorXd& mu_grad = elbo_grad.mu_;
+    Eigen::VectorXd& omega_grad = elbo_grad.omega_;
+    mu_grad.setZero();
+    omega_grad.setZero();
     double tmp_lp = 0.0;
     Eigen::VectorXd tmp_mu_grad = Eigen::VectorXd::Zero(dimension());
     Eigen::VectorXd eta = Eigen::VectorXd::Zero(dimension());
     Eigen::VectorXd zeta = Eigen::VectorXd::Zero(dimension());
+    // The gradient of -log q(zeta) with respect to zeta is
+    // eta / sigma, added to that of the model for sticking the landing
+    const Eigen::VectorXd inv_sigma = (-omega_).array().exp();
 
     // Naive Monte Carlo integration
     static const int n_retries = 10;
-    for (int i = 0, n_monte_carlo_drop = 0; i < n_monte_carlo_grad;) {
-      // Draw from standard normal and transform to real-coordinate space
-      for (int d = 0; d < dimension(); ++d)
-        eta(d) = stan::math::normal_rng(0, 1, rng);
-      zeta = transform(eta);
-      try {
-        std::stringstream ss;
-        stan::model::gradient(m, zeta, tmp_lp, tmp_mu_grad, &ss);
-        if (ss.str().length() > 0)
-          logger.info(ss);
-        stan::math::check_finite(function, "Gradient of mu", tmp_mu_grad);
-        mu_grad += tmp_mu_grad;
-        omega_grad.array() += tmp_mu_grad.array().cwiseProduct(eta.array());
-        ++i;
-      } catch (const std::exception& e) {
-        ++n_monte_carlo_drop;
-        if (n_monte_carlo_drop >= n_retries * n_monte_carlo_grad) {
-          const char* name = "The number of dropped evaluations";
-          const char* msg1 = "has reached its maximum amount (";
-          int y = n_retries * n_monte_carlo_grad;
-          const char* msg2
-              = "). Your model may be either severely "
-                "ill-conditioned or misspecified.";
-          stan::math::throw_domain_error(function, name, y, msg1, msg2);
+    if (parallel) {
+      Eigen::MatrixXd etas(dimension(), n_monte_carlo_grad);
+      Eigen::MatrixXd grads(dimension(), n_monte_carlo_grad);
+      parallel_monte_carlo(
+          function, n_monte_carlo_grad, n_retries * n_monte_carlo_grad,
+          [&](int i) {
+            for (int d = 0; d < dimension(); ++d)
+              etas(d, i) = stan::math::normal_rng(0, 1, rng);
+          },
+          [&](int i, std::ostream& msgs) {
+            double lp = 0.0;
+            Eigen::VectorXd grad;
+            try {
+              stan::model::gradient(m, transform(etas.col(i)), lp, grad,
+                                    &msgs);
+              stan::math::check_finite(function, "Gradient of mu", grad);
+            } catch (const std::exception& e) {
+              return false;
+            }
+            grads.col(i) = grad;
+            return true;
+          },
+          logger);
+      if (sticking_the_landing)
+        grads.noalias() += inv_sigma.asDiagonal() * etas;
+      mu_grad = stan::analyze::reproducible_rowwise_sum(grads);
+      omega_grad = stan::analyze::reproducible_rowwise_sum(
+          grads.cwiseProduct(etas));
+    } else {
+      for (int i = 0, n_monte_carlo_drop = 0; i < n_monte_carlo_grad;) {
+        // Draw from standard normal and transform to real-coordinate space
+        for (int d = 0; d < dimension(); ++d)
+          eta(d) = stan::math::normal_rng(0, 1, rng);
+        zeta = transform(eta);
+        try {
+          std::stringstream ss;
+          stan::model::gradient(m, zeta, tmp_lp, tmp_mu_grad, &ss);
+          if (ss.str().length() > 0)
+            logger.info(ss);
+          stan::math::check_finite(function, "Gradient of mu", tmp_mu_grad);
+          if (sticking_the_landing)
+            tmp_mu_grad.array() += inv_sigma.array() * eta.array();
+          mu_grad += tmp_mu_grad;
+          omega_grad.array() += tmp_mu_grad.array().cwiseProduct(eta.array());
+          ++i;
+        } catch (const std::exception& e) {
+          ++n_monte_carlo_drop;
+          if (n_monte_carlo_drop >= n_retries * n_monte_carlo_grad) {
+            const char* name = "The number of dropped evaluations";
+            const char* msg1 = "has reached its maximum amount (";
+            int y = n_retries * n_monte_carlo_grad;
+            const char* msg2
+                = "). Your model may be either severely "
+                  "ill-conditioned or misspecified.";
+            stan::math::throw_domain_error(function, name, y, msg1, msg2);
+          }
         }
       }
     }
@@ -387,10 +493,12 @@ class normal_meanfield : public base_family {
 
     omega_grad.array() = omega_grad.array().cwiseProduct(omega_.array().exp());
 
-    omega_grad.array() += 1.0;  // add entropy gradient (unit)
+    // add entropy gradient (unit), which sticking the landing estimates
+    if (!sticking_the_landing)
+      omega_grad.array() += 1.0;
 
-    elbo_grad.set_mu(mu_grad);
-    elbo_grad.set_omega(omega_grad);
+    stan::math::check_not_nan(function, "Gradient of mu", mu_grad);
+    stan::math::check_not_nan(function, "Gradient of omega", omega_grad);
   }
 };
 
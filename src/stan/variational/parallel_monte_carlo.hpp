@@ -0,0 +1,98 @@
+#ifndef STAN_VARIATIONAL_PARALLEL_MONTE_CARLO_HPP
+#define STAN_VARIATIONAL_PARALLEL_MONTE_CARLO_HPP
+
+#include <stan/callbacks/logger.hpp>
+#include <stan/math/prim.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stan {
+
+namespace variational {
+
+/**
+ * Evaluates a Monte Carlo estimate with its draws evaluated in
+ * parallel.
+ *
+ * The draws are generated serially in the calling thread, so the
+ * random number generator is advanced in the same order whatever the
+ * number of threads: <code>draw(i)</code> stores the i-th draw, then
+ * <code>eval(i, msgs)</code> evaluates it, writing messages to
+ * <code>msgs</code>, and returns false if the evaluation failed.  The
+ * evaluations of a round run in parallel.  After each round the
+ * messages are logged in the order of the draws, and the draws whose
+ * evaluation failed are redrawn and evaluated in the next round, until
+ * every draw succeeded.
+ *
+ * The caller reduces the stored results in the order of the draws, so
+ * the estimate depends only on the state of the random number
+ * generator.  If no evaluation fails, the draws are the same as those
+ * of the serial loop.
+ *
+ * The model must satisfy the thread safety contract of
+ * <code>stan::model::model_base</code>.  Gradients can only be
+ * evaluated in parallel if Stan Math is built with
+ * <code>STAN_THREADS</code>.
+ *
+ * @tparam F type of draw function, callable as
+ *   <code>void(int)</code>
+ * @tparam G type of evaluation function, callable as
+ *   <code>bool(int, std::ostream&)</code>
+ * @param[in] function name of the calling function, for error messages
+ * @param[in] n number of draws
+ * @param[in] max_drops number of failed evaluations allowed
+ * @param[in] draw function storing a new value of a draw
+ * @param[in] eval function evaluating a draw
+ * @param[in,out] logger logger for messages
+ * @throw std::domain_error if the number of failed evaluations reaches
+ * max_drops
+ */
+template <class F, class G>
+void parallel_monte_carlo(const char* function, int n, int max_drops,
+                          const F& draw, const G& eval,
+                          callbacks::logger& logger) {
+  std::vector<int> pending(n);
+  for (int i = 0; i < n; ++i)
+    pending[i] = i;
+  std::vector<std::string> msgs(n);
+  std::vector<char> failed(n);
+  int n_dropped = 0;
+  while (!pending.empty()) {
+    for (int i : pending)
+      draw(i);
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, pending.size()),
+                      [&](const tbb::blocked_range<std::size_t>& r) {
+                        for (std::size_t k = r.begin(); k != r.end(); ++k) {
+                          const int i = pending[k];
+                          std::stringstream ss;
+                          failed[i] = !eval(i, ss);
+                          msgs[i] = ss.str();
+                        }
+                      });
+
+    std::vector<int> retry;
+    for (int i : pending) {
+      if (msgs[i].length() > 0)
+        logger.info(msgs[i]);
+      if (failed[i])
+        retry.push_back(i);
+    }
+    n_dropped += retry.size();
+    if (n_dropped >= max_drops) {
+      const char* name = "The number of dropped evaluations";
+      const char* msg1 = "has reached its maximum amount (";
+      const char* msg2
+          = "). Your model may be either severely "
+            "ill-conditioned or misspecified.";
+      stan::math::throw_domain_error(function, name, max_drops, msg1, msg2);
+    }
+    pending.swap(retry);
+  }
+}
+
+}  // namespace variational
+}  // namespace stan
+#endif
@@ -0,0 +1,196 @@
+// Benchmark of the MCMC diagnostics of stan::analyze and
+// stan::mcmc::chains on large synthetic output.
+//
+// Built and run by `make bench-diagnostics`.  The draws are AR(1)
+// chains, with autocorrelations spread over [0, 0.95] across the
+// parameters, so that the effective sample sizes span the range seen
+// in practice.  Each invocation generates the draws and times one
+// stage, printing one JSON object on a line of its own, so that the
+// peak resident set size belongs to that stage and the draws alone:
+//
+//   <bench> stage=<stage> [num_chains=<n>] [num_draws=<n>]
+//           [num_params=<n>] [seed=<n>]
+//
+// Stages:
+//   generate          the draws alone, for the baseline peak RSS
+//   split_ess         compute_split_effective_sample_size of every
+//                     parameter, with one reused workspace
+//   split_rhat_rank   compute_split_potential_scale_reduction_rank of
+//                     every parameter, with one reused workspace
+//   chains_summary    chains::summary, in parallel over parameters,
+//                     after adding the draws to a chains object
+//   autocovariance    batch_autocovariance of every chain
+//
+// The defaults of 4 chains of 4000 draws of 10000 parameters take
+// 1.3GB; 100000 parameters take ten times as much.
+
+#include <stan/analyze/mcmc/autocovariance.hpp>
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/analyze/mcmc/compute_potential_scale_reduction.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <sys/resource.h>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct options {
+  std::string stage;
+  int num_chains = 4;
+  int num_draws = 4000;
+  int num_params = 10000;
+  unsigned int seed = 1234;
+};
+
+/**
+ * Return the peak resident set size of the process in kilobytes.
+ */
+long peak_rss_kb() {  // NOLINT(runtime/int)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * Return the draws of every chain, one column per parameter.
+ * Parameter <code>p</code> is a stationary AR(1) process with unit
+ * variance and autocorrelation <code>0.95 * p / num_params</code>.
+ */
+std::vector<Eigen::MatrixXd> generate(const options& opts) {
+  boost::ecuyer1988 rng(opts.seed);
+  boost::normal_distribution<double> normal;
+  std::vector<Eigen::MatrixXd> draws(opts.num_chains);
+  for (auto& chain : draws) {
+    chain.resize(opts.num_draws, opts.num_params);
+    for (int p = 0; p < opts.num_params; ++p) {
+      const double rho = 0.95 * p / opts.num_params;
+      const double sigma = std::sqrt(1 - rho * rho);
+      double x = normal(rng);
+      for (int n = 0; n < opts.num_draws; ++n) {
+        chain(n, p) = x;
+        x = rho * x + sigma * normal(rng);
+      }
+    }
+  }
+  return draws;
+}
+
+void write_json(std::ostream& out, const options& opts, double seconds,
+                double checksum) {
+  out << "{\"stage\":\"" << opts.stage << "\",\"num_chains\":"
+      << opts.num_chains << ",\"num_draws\":" << opts.num_draws
+      << ",\"num_params\":" << opts.num_params << ",\"seconds\":" << seconds
+      << ",\"us_per_param\":" << 1e6 * seconds / opts.num_params
+      << ",\"peak_rss_kb\":" << peak_rss_kb() << ",\"checksum\":" << checksum
+      << "}" << std::endl;
+}
+
+/**
+ * Time the stage of the options on the specified draws, returning the
+ * seconds taken and setting a checksum of the results, which keeps
+ * them from being discarded.
+ */
+double run_stage(const options& opts,
+                 const std::vector<Eigen::MatrixXd>& draws,
+                 double& checksum) {
+  const std::vector<size_t> sizes(opts.num_chains, opts.num_draws);
+  std::vector<const double*> param_draws(opts.num_chains);
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&start]() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                         - start)
+        .count();
+  };
+  checksum = 0;
+  if (opts.stage == "generate") {
+    return 0;
+  } else if (opts.stage == "split_ess") {
+    stan::analyze::autocovariance_workspace<double> workspace;
+    for (int p = 0; p < opts.num_params; ++p) {
+      for (int c = 0; c < opts.num_chains; ++c)
+        param_draws[c] = draws[c].col(p).data();
+      checksum += stan::analyze::compute_split_effective_sample_size(
+          param_draws, sizes, workspace);
+    }
+  } else if (opts.stage == "split_rhat_rank") {
+    stan::analyze::rank_workspace workspace;
+    for (int p = 0; p < opts.num_params; ++p) {
+      for (int c = 0; c < opts.num_chains; ++c)
+        param_draws[c] = draws[c].col(p).data();
+      checksum += stan::analyze::compute_split_potential_scale_reduction_rank(
+                      param_draws, sizes, workspace)
+                      .first;
+    }
+  } else if (opts.stage == "chains_summary") {
+    std::vector<std::string> names;
+    for (int p = 0; p < opts.num_params; ++p)
+      names.push_back("theta." + std::to_string(p + 1));
+    stan::mcmc::chains<> chains(names);
+    for (int c = 0; c < opts.num_chains; ++c)
+      chains.add(c, draws[c]);
+    chains.set_warmup(0);
+    start = std::chrono::steady_clock::now();
+    Eigen::VectorXd probs(3);
+    probs << 0.05, 0.5, 0.95;
+    stan::mcmc::chains_summary summary = chains.summary(probs);
+    checksum = summary.effective_sample_size.sum();
+  } else if (opts.stage == "autocovariance") {
+    Eigen::MatrixXd acov;
+    for (int c = 0; c < opts.num_chains; ++c) {
+      stan::analyze::batch_autocovariance<double>(draws[c], acov);
+      checksum += acov.row(1).sum();
+    }
+  } else {
+    std::cerr << "Unknown stage: " << opts.stage << std::endl;
+    std::exit(1);
+  }
+  return elapsed();
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const std::size_t eq = arg.find('=');
+    const std::string key = arg.substr(0, eq);
+    const std::string value
+        = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (key == "stage") {
+      opts.stage = value;
+    } else if (key == "num_chains") {
+      opts.num_chains = std::atoi(value.c_str());
+    } else if (key == "num_draws") {
+      opts.num_draws = std::atoi(value.c_str());
+    } else if (key == "num_params") {
+      opts.num_params = std::atoi(value.c_str());
+    } else if (key == "seed") {
+      opts.seed = std::strtoul(value.c_str(), nullptr, 10);
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return 1;
+    }
+  }
+  if (opts.stage.empty() || opts.num_chains < 1 || opts.num_draws < 4
+      || opts.num_params < 1) {
+    std::cerr << "Usage: " << argv[0] << " stage=<stage> [num_chains=<n>]"
+              << " [num_draws=<n>] [num_params=<n>] [seed=<n>]" << std::endl;
+    return 1;
+  }
+  const std::vector<Eigen::MatrixXd> draws = generate(opts);
+  double checksum;
+  const double seconds = run_stage(opts, draws, checksum);
+  write_json(std::cout, opts, seconds, checksum);
+  return 0;
+}
@@ -0,0 +1,318 @@
+// Microbenchmarks of the indexing of stan::model::rvalue and
+// stan::model::assign.
+//
+// Built and run by `make bench-indexing`.  Generated model code reads
+// and assigns every indexed expression through these functions.  For
+// vectors and matrices of double, of var, and var_value<Matrix>, and
+// several sizes, each case times calls with a single index (uni,
+// multi, min_max or omni, selecting elements of vectors and rows of
+// matrices) and prints one JSON object on a line of its own:
+//
+//   <bench> [min_time=<seconds>] [filter=<substring>]
+//
+// The forward pass of a call is the indexing alone.  For var and
+// var_value<Matrix> the reverse pass adds the gradient of the sum of
+// the result, or of the assigned container.  Every call records its
+// tape on a nested stack recovered at the end of the call; the inputs
+// are kept off the chaining stack so that the gradient only visits the
+// tape of the call.
+//
+// Allocations are the calls to malloc, which Eigen and the global
+// operator new use, counted with glibc and reported as -1 otherwise.
+// The blocks of the autodiff arena are reused from one call to the
+// next, so an allocation per call is a copy of the indexed data.
+
+#include <stan/model/indexing.hpp>
+#include <stan/math/rev.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(std::size_t size);
+
+namespace {
+std::atomic<std::size_t> num_allocations(0);
+}  // namespace
+
+extern "C" void* malloc(std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+#endif
+
+namespace {
+
+/**
+ * Return the number of allocations so far, -1 if they are not counted.
+ */
+inline double allocations() {
+#ifdef __GLIBC__
+  return num_allocations.load(std::memory_order_relaxed);
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Keep the compiler from discarding the computation of the specified
+ * value.
+ */
+template <typename T>
+inline void keep(const T& x) {
+  asm volatile("" : : "r"(&x) : "memory");
+}
+
+struct options {
+  double min_time = 0.2;
+  std::string filter;
+};
+
+struct bench_case {
+  std::string function;   // rvalue or assign
+  std::string index;      // uni, multi, min_max or omni
+  std::string container;  // vector or matrix
+  std::string scalar;     // double, var or varmat
+  std::string pass;       // forward or reverse
+  long size;              // NOLINT(runtime/int)
+};
+
+/**
+ * Time batches of calls of the specified function until the minimum
+ * time has elapsed and write the time and the allocations per call.
+ *
+ * @param c case
+ * @param opts options
+ * @param call function making one call
+ */
+template <typename Call>
+void run(const bench_case& c, const options& opts, Call&& call) {
+  const std::string name = c.function + " " + c.index + " " + c.container
+                           + " " + c.scalar + " " + c.pass;
+  if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+    return;
+  const int batch = 64;
+  call();  // warm up the arena
+  long calls = 0;  // NOLINT(runtime/int)
+  double seconds = 0;
+  double allocs = 0;
+  for (int n = 0; n < 10 || seconds < opts.min_time; ++n) {
+    const double allocs_start = allocations();
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < batch; ++k)
+      call();
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    allocs += allocations() - allocs_start;
+    calls += batch;
+  }
+  std::cout << "{\"function\":\"" << c.function << "\",\"index\":\""
+            << c.index << "\",\"container\":\"" << c.container
+            << "\",\"scalar\":\"" << c.scalar << "\",\"pass\":\"" << c.pass
+            << "\",\"size\":" << c.size << ",\"calls\":" << calls
+            << ",\"ns_per_call\":" << 1e9 * seconds / calls
+            << ",\"allocations_per_call\":"
+            << (allocations() < 0 ? -1.0 : allocs / calls) << "}"
+            << std::endl;
+}
+
+/**
+ * Return a container of the specified type with the specified values.
+ * Vars are kept off the chaining stack.
+ */
+template <typename T>
+T make(const Eigen::MatrixXd& m) {
+  if constexpr (stan::is_var_matrix<T>::value) {
+    using value_t = typename T::value_type;
+    return T(new stan::math::vari_value<value_t>(value_t(m), false));
+  } else if constexpr (stan::is_var<stan::scalar_type_t<T>>::value) {
+    T x(m.rows(), m.cols());
+    for (Eigen::Index i = 0; i < m.size(); ++i)
+      x(i) = stan::math::var(new stan::math::vari(m(i), false));
+    return x;
+  } else {
+    return T(m);
+  }
+}
+
+template <typename T>
+T make_scalar(double x) {
+  if constexpr (stan::is_var<T>::value)
+    return T(new stan::math::vari(x, false));
+  else
+    return x;
+}
+
+/**
+ * Set the assigned container back to the input.  Assigning to a
+ * var_value<Matrix> replaces its vari, which lives on the nested tape
+ * of the call; the Eigen containers are assigned in place.
+ */
+template <typename T>
+void reset(T& work, const T& x) {
+  if constexpr (stan::is_var_matrix<T>::value)
+    work = x;
+}
+
+template <typename X, typename... Idx>
+void bench_rvalue(bench_case c, const options& opts, const X& x,
+                  const Idx&... idx) {
+  c.function = "rvalue";
+  c.pass = "forward";
+  run(c, opts, [&]() {
+    stan::math::start_nested();
+    keep(stan::model::rvalue(x, "x", idx...));
+    stan::math::recover_memory_nested();
+  });
+  if constexpr (stan::is_var<stan::scalar_type_t<X>>::value) {
+    c.pass = "reverse";
+    run(c, opts, [&]() {
+      stan::math::start_nested();
+      stan::math::var lp = stan::math::sum(stan::model::rvalue(x, "x", idx...));
+      lp.grad();
+      stan::math::recover_memory_nested();
+    });
+  }
+}
+
+template <typename X, typename Y, typename... Idx>
+void bench_assign(bench_case c, const options& opts, const X& x, const Y& y,
+                  const Idx&... idx) {
+  c.function = "assign";
+  c.pass = "forward";
+  X work = x;
+  run(c, opts, [&]() {
+    stan::math::start_nested();
+    reset(work, x);
+    stan::model::assign(work, y, "x", idx...);
+    keep(work);
+    stan::math::recover_memory_nested();
+  });
+  if constexpr (stan::is_var<stan::scalar_type_t<X>>::value) {
+    c.pass = "reverse";
+    run(c, opts, [&]() {
+      stan::math::start_nested();
+      reset(work, x);
+      stan::model::assign(work, y, "x", idx...);
+      stan::math::var lp = stan::math::sum(work);
+      lp.grad();
+      stan::math::recover_memory_nested();
+    });
+  }
+}
+
+/**
+ * Return the one-based multi-index of every other of the specified
+ * number of elements or rows, in decreasing order.
+ */
+std::vector<int> every_other(int n) {
+  std::vector<int> ns;
+  for (int i = n; i >= 1; i -= 2)
+    ns.push_back(i);
+  return ns;
+}
+
+template <typename Vector>
+void bench_vector(const std::string& scalar, const options& opts) {
+  using stan::model::index_min_max;
+  using stan::model::index_multi;
+  using stan::model::index_omni;
+  using stan::model::index_uni;
+  using scalar_t = stan::scalar_type_t<Vector>;
+  for (int n : {10, 100, 1000}) {
+    const bench_case c{"", "", "vector", scalar, "", n};
+    const Vector x = make<Vector>(Eigen::VectorXd::LinSpaced(n, -1, 1));
+    const index_multi multi(every_other(n));
+    const int num_multi = multi.ns_.size();
+    const Vector y_multi = make<Vector>(Eigen::VectorXd::Ones(num_multi));
+    const Vector y_min_max = make<Vector>(Eigen::VectorXd::Ones(n - 2));
+    const Vector y_omni = make<Vector>(Eigen::VectorXd::Ones(n));
+    const scalar_t y_uni = make_scalar<scalar_t>(1);
+
+    bench_case uni = c, multi_c = c, min_max = c, omni = c;
+    uni.index = "uni";
+    multi_c.index = "multi";
+    min_max.index = "min_max";
+    omni.index = "omni";
+    bench_rvalue(uni, opts, x, index_uni(n / 2));
+    bench_rvalue(multi_c, opts, x, multi);
+    bench_rvalue(min_max, opts, x, index_min_max(2, n - 1));
+    bench_rvalue(omni, opts, x, index_omni());
+    bench_assign(uni, opts, x, y_uni, index_uni(n / 2));
+    bench_assign(multi_c, opts, x, y_multi, multi);
+    bench_assign(min_max, opts, x, y_min_max, index_min_max(2, n - 1));
+    bench_assign(omni, opts, x, y_omni, index_omni());
+    stan::math::recover_memory();
+  }
+}
+
+template <typename Matrix, typename RowVector>
+void bench_matrix(const std::string& scalar, const options& opts) {
+  using stan::model::index_min_max;
+  using stan::model::index_multi;
+  using stan::model::index_omni;
+  using stan::model::index_uni;
+  for (int K : {3, 10, 32}) {
+    const bench_case c{"", "", "matrix", scalar, "", K * K};
+    const Matrix x = make<Matrix>(
+        Eigen::VectorXd::LinSpaced(K * K, -1, 1).reshaped(K, K));
+    const index_multi multi(every_other(K));
+    const int num_multi = multi.ns_.size();
+    const Matrix y_multi = make<Matrix>(Eigen::MatrixXd::Ones(num_multi, K));
+    const Matrix y_min_max = make<Matrix>(Eigen::MatrixXd::Ones(K - 2, K));
+    const Matrix y_omni = make<Matrix>(Eigen::MatrixXd::Ones(K, K));
+    const RowVector y_uni = make<RowVector>(Eigen::MatrixXd::Ones(1, K));
+
+    bench_case uni = c, multi_c = c, min_max = c, omni = c;
+    uni.index = "uni";
+    multi_c.index = "multi";
+    min_max.index = "min_max";
+    omni.index = "omni";
+    bench_rvalue(uni, opts, x, index_uni(K / 2));
+    bench_rvalue(multi_c, opts, x, multi);
+    bench_rvalue(min_max, opts, x, index_min_max(2, K - 1));
+    bench_rvalue(omni, opts, x, index_omni());
+    bench_assign(uni, opts, x, y_uni, index_uni(K / 2));
+    bench_assign(multi_c, opts, x, y_multi, multi);
+    bench_assign(min_max, opts, x, y_min_max, index_min_max(2, K - 1));
+    bench_assign(omni, opts, x, y_omni, index_omni());
+    stan::math::recover_memory();
+  }
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  using stan::math::var;
+  using stan::math::var_value;
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const std::size_t eq = arg.find('=');
+    const std::string key = arg.substr(0, eq);
+    const std::string value
+        = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (key == "min_time") {
+      opts.min_time = std::atof(value.c_str());
+    } else if (key == "filter") {
+      opts.filter = value;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return 1;
+    }
+  }
+  bench_vector<Eigen::VectorXd>("double", opts);
+  bench_vector<Eigen::Matrix<var, -1, 1>>("var", opts);
+  bench_vector<var_value<Eigen::VectorXd>>("varmat", opts);
+  bench_matrix<Eigen::MatrixXd, Eigen::RowVectorXd>("double", opts);
+  bench_matrix<Eigen::Matrix<var, -1, -1>, Eigen::Matrix<var, 1, -1>>("var",
+                                                                     opts);
+  bench_matrix<var_value<Eigen::MatrixXd>, var_value<Eigen::RowVectorXd>>(
+      "varmat", opts);
+  return 0;
+}
@@ -0,0 +1,246 @@
+// Benchmark of the readers of data and of sampler output: json_data,
+// dump and stan_csv_reader::parse.
+//
+// Built and run by `make bench-ingestion`.  Each invocation generates
+// the text of one format in memory and times parsing it from a string
+// stream, printing one JSON object on a line of its own with the
+// throughput and the peak resident set size before and after parsing:
+//
+//   <bench> format=<format> [size=<n>] [num_chains=<n>]
+//           [num_draws=<n>] [num_params=<n>] [seed=<n>]
+//
+// Formats:
+//   json           a vector and an int array of size elements, a matrix
+//                  of size elements and an array of size / 4 tuples of
+//                  a real and a vector of 3 reals
+//   json_parallel  the same, with the parallel number parsing of
+//                  json_data
+//   dump           the vector, int array and matrix in the R dump format
+//   csv            num_chains Stan CSV files of num_draws draws of the
+//                  sampler diagnostics and num_params parameters, with
+//                  the adaptation and timing comments of CmdStan
+//
+// The generated text stays in memory while parsing, so the memory the
+// parse takes is the difference of the two peaks.
+
+#include <stan/io/dump.hpp>
+#include <stan/io/json/json_data.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <boost/random/additive_combine.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct options {
+  std::string format;
+  int size = 1000000;
+  int num_chains = 4;
+  int num_draws = 1000;
+  int num_params = 1000;
+  unsigned int seed = 1234;
+};
+
+/**
+ * Return the peak resident set size of the process in kilobytes.
+ */
+long peak_rss_kb() {  // NOLINT(runtime/int)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * Writes comma separated draws of a standard normal, with the six
+ * significant digits CmdStan writes.
+ */
+class normal_writer {
+ public:
+  explicit normal_writer(unsigned int seed) : rng_(seed) {}
+
+  void write(std::ostream& o, int n) {
+    for (int i = 0; i < n; ++i)
+      o << (i == 0 ? "" : ", ") << normal_(rng_);
+  }
+
+  double operator()() { return normal_(rng_); }
+
+ private:
+  boost::ecuyer1988 rng_;
+  boost::normal_distribution<double> normal_;
+};
+
+std::string make_json(const options& opts) {
+  normal_writer normal(opts.seed);
+  const int cols = 1000;
+  const int rows = std::max(1, opts.size / cols);
+  std::stringstream o;
+  o.precision(6);
+  o << "{\n\"x\": [";
+  normal.write(o, opts.size);
+  o << "],\n\"k\": [";
+  for (int i = 0; i < opts.size; ++i)
+    o << (i == 0 ? "" : ", ") << i % 1000;
+  o << "],\n\"m\": [";
+  for (int i = 0; i < rows; ++i) {
+    o << (i == 0 ? "[" : ",\n[");
+    normal.write(o, cols);
+    o << "]";
+  }
+  o << "],\n\"t\": [";
+  for (int i = 0; i < opts.size / 4; ++i) {
+    o << (i == 0 ? "" : ",\n") << "{\"1\": " << normal() << ", \"2\": [";
+    normal.write(o, 3);
+    o << "]}";
+  }
+  o << "]\n}\n";
+  return o.str();
+}
+
+std::string make_dump(const options& opts) {
+  normal_writer normal(opts.seed);
+  const int cols = 1000;
+  const int rows = std::max(1, opts.size / cols);
+  std::stringstream o;
+  o.precision(6);
+  o << "x <- c(";
+  normal.write(o, opts.size);
+  o << ")\nk <- c(";
+  for (int i = 0; i < opts.size; ++i)
+    o << (i == 0 ? "" : ", ") << i % 1000;
+  o << ")\nm <- structure(c(";
+  normal.write(o, rows * cols);
+  o << "), .Dim = c(" << rows << ", " << cols << "))\n";
+  return o.str();
+}
+
+std::string make_csv(const options& opts, int chain) {
+  normal_writer normal(opts.seed + chain);
+  std::stringstream o;
+  o.precision(6);
+  o << "# stan_version_major = 2\n"
+    << "# stan_version_minor = 36\n"
+    << "# stan_version_patch = 0\n"
+    << "# model = bench_model\n"
+    << "# method = sample (Default)\n"
+    << "#   sample\n"
+    << "#     num_samples = " << opts.num_draws << "\n"
+    << "#     num_warmup = 1000 (Default)\n"
+    << "#     save_warmup = 0 (Default)\n"
+    << "#     thin = 1 (Default)\n"
+    << "# id = " << chain + 1 << "\n"
+    << "# random\n"
+    << "#   seed = " << opts.seed << "\n";
+  o << "lp__,accept_stat__,stepsize__,treedepth__,n_leapfrog__,divergent__,"
+    << "energy__";
+  for (int p = 0; p < opts.num_params; ++p)
+    o << ",theta." << p + 1;
+  o << "\n# Adaptation terminated\n# Step size = 0.4\n"
+    << "# Diagonal elements of inverse mass matrix:\n# ";
+  for (int p = 0; p < opts.num_params; ++p)
+    o << (p == 0 ? "" : ", ") << 1 + 0.1 * (p % 10);
+  o << "\n";
+  for (int n = 0; n < opts.num_draws; ++n) {
+    o << -0.5 * opts.num_params + normal() << ",0.9," << 0.4 << ",3,7,0,"
+      << 0.5 * opts.num_params + normal();
+    for (int p = 0; p < opts.num_params; ++p)
+      o << "," << normal();
+    o << "\n";
+  }
+  o << "# \n"
+    << "#  Elapsed Time: 1.0 seconds (Warm-up)\n"
+    << "#                1.0 seconds (Sampling)\n"
+    << "#                2.0 seconds (Total)\n"
+    << "# \n";
+  return o.str();
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const std::size_t eq = arg.find('=');
+    const std::string key = arg.substr(0, eq);
+    const std::string value
+        = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (key == "format") {
+      opts.format = value;
+    } else if (key == "size") {
+      opts.size = std::atoi(value.c_str());
+    } else if (key == "num_chains") {
+      opts.num_chains = std::atoi(value.c_str());
+    } else if (key == "num_draws") {
+      opts.num_draws = std::atoi(value.c_str());
+    } else if (key == "num_params") {
+      opts.num_params = std::atoi(value.c_str());
+    } else if (key == "seed") {
+      opts.seed = std::strtoul(value.c_str(), nullptr, 10);
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::string> texts;
+  if (opts.format == "json" || opts.format == "json_parallel") {
+    texts.push_back(make_json(opts));
+  } else if (opts.format == "dump") {
+    texts.push_back(make_dump(opts));
+  } else if (opts.format == "csv") {
+    for (int chain = 0; chain < opts.num_chains; ++chain)
+      texts.push_back(make_csv(opts, chain));
+  } else {
+    std::cerr << "Usage: " << argv[0] << " format=<json|json_parallel|dump"
+              << "|csv> [size=<n>] [num_chains=<n>] [num_draws=<n>]"
+              << " [num_params=<n>] [seed=<n>]" << std::endl;
+    return 1;
+  }
+  std::size_t bytes = 0;
+  std::vector<std::istringstream> streams;
+  for (auto& text : texts) {
+    bytes += text.size();
+    streams.emplace_back(std::move(text));
+  }
+  const long rss_before_kb = peak_rss_kb();  // NOLINT(runtime/int)
+
+  // Keeps the parsed objects alive, as the interfaces do
+  std::vector<std::unique_ptr<stan::io::var_context>> data;
+  std::vector<stan::io::stan_csv> csvs;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& in : streams) {
+    if (opts.format == "json")
+      data.emplace_back(new stan::json::json_data(in));
+    else if (opts.format == "json_parallel")
+      data.emplace_back(new stan::json::json_data(in, true));
+    else if (opts.format == "dump")
+      data.emplace_back(new stan::io::dump(in));
+    else
+      csvs.push_back(stan::io::stan_csv_reader::parse(in, nullptr));
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  std::cout << "{\"format\":\"" << opts.format
+            << "\",\"files\":" << streams.size() << ",\"bytes\":" << bytes
+            << ",\"seconds\":" << seconds
+            << ",\"mb_per_s\":" << bytes / 1e6 / seconds
+            << ",\"peak_rss_kb_before\":" << rss_before_kb
+            << ",\"peak_rss_kb\":" << peak_rss_kb() << "}" << std::endl;
+  return 0;
+}
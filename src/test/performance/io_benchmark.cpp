@@ -0,0 +1,253 @@
+// Microbenchmarks of stan::io::deserializer and stan::io::serializer.
+//
+// Built and run by `make bench-io`.  Every read and write of the
+// generated model code goes through these classes: log_prob reads the
+// parameters with the deserializer and write_array and the transforms
+// of the inits write with the serializer.  For double and var scalars,
+// and several sizes, each case times passes of consecutive reads or
+// writes of one kind of object and prints one JSON object on a line of
+// its own:
+//
+//   <bench> [min_time=<seconds>] [filter=<substring>]
+//
+// Kinds: scalar (size reads of one scalar), vector, matrix (square, of
+// about size elements), and the constrained simplex, ordered and
+// cholesky_factor_corr (Cholesky factor of about size elements), read
+// with the Jacobian.  The cost is reported in nanoseconds per element
+// of the constrained object.  For var, every pass records its tape on a
+// nested stack which is recovered between passes, outside the timing.
+
+#include <stan/io/deserializer.hpp>
+#include <stan/io/serializer.hpp>
+#include <stan/math/rev.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Keep the compiler from discarding the computation of the specified
+ * value.
+ */
+template <typename T>
+inline void keep(const T& x) {
+  asm volatile("" : : "r"(&x) : "memory");
+}
+
+struct options {
+  double min_time = 0.2;
+  std::string filter;
+};
+
+/**
+ * Description of one case: the number of elements of the constrained
+ * object and of unconstrained scalars it is read from or written to.
+ */
+struct bench_case {
+  std::string benchmark;
+  std::string kind;
+  std::string scalar;
+  long size;          // NOLINT(runtime/int)
+  long elements;      // NOLINT(runtime/int)
+  long unconstrained;  // NOLINT(runtime/int)
+};
+
+void write_json(std::ostream& out, const bench_case& c,
+                long operations,  // NOLINT(runtime/int)
+                double seconds) {
+  out << "{\"benchmark\":\"" << c.benchmark << "\",\"kind\":\"" << c.kind
+      << "\",\"scalar\":\"" << c.scalar << "\",\"size\":" << c.size
+      << ",\"elements\":" << c.elements
+      << ",\"unconstrained\":" << c.unconstrained
+      << ",\"operations\":" << operations << ",\"seconds\":" << seconds
+      << ",\"ns_per_element\":"
+      << 1e9 * seconds / (static_cast<double>(operations) * c.elements)
+      << "}" << std::endl;
+}
+
+/**
+ * Time passes of the specified function until the minimum time has
+ * elapsed and write the result.  A pass makes as many operations as
+ * fit in about 4096 unconstrained scalars, so that the clock is read
+ * rarely compared to the work timed.
+ *
+ * @param c case
+ * @param opts options
+ * @param pass function making the specified number of operations
+ */
+template <typename Pass>
+void run(const bench_case& c, const options& opts, Pass&& pass) {
+  const std::string name = c.benchmark + " " + c.kind + " " + c.scalar;
+  if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+    return;
+  const long reps  // NOLINT(runtime/int)
+      = std::max(1L, 4096 / std::max(1L, c.unconstrained));
+  long operations = 0;  // NOLINT(runtime/int)
+  double seconds = 0;
+  for (int n = 0; n < 10 || seconds < opts.min_time; ++n) {
+    stan::math::start_nested();
+    auto start = std::chrono::steady_clock::now();
+    pass(reps);
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    stan::math::recover_memory_nested();
+    operations += reps;
+  }
+  write_json(std::cout, c, operations, seconds);
+}
+
+/**
+ * Return unconstrained values for the specified number of operations
+ * of the specified number of scalars each.
+ */
+template <typename T>
+std::vector<T> unconstrained_values(long reps,  // NOLINT(runtime/int)
+                                    long size) {  // NOLINT(runtime/int)
+  std::vector<T> values;
+  values.reserve(reps * size);
+  for (long i = 0; i < reps * size; ++i)  // NOLINT(runtime/int)
+    values.push_back(0.1 * (i % 7) - 0.3);
+  return values;
+}
+
+/**
+ * Time a deserializer case.
+ *
+ * @param read function making one read from a deserializer and a log
+ * density accumulator
+ */
+template <typename T, typename Read>
+void bench_read(bench_case c, const options& opts, Read&& read) {
+  c.benchmark = "deserializer";
+  const long reps  // NOLINT(runtime/int)
+      = std::max(1L, 4096 / std::max(1L, c.unconstrained));
+  std::vector<T> data_r = unconstrained_values<T>(reps, c.unconstrained);
+  std::vector<int> data_i;
+  run(c, opts, [&](long num) {  // NOLINT(runtime/int)
+    stan::io::deserializer<T> in(data_r, data_i);
+    T lp = 0;
+    for (long k = 0; k < num; ++k)  // NOLINT(runtime/int)
+      read(in, lp);
+    keep(lp);
+  });
+}
+
+/**
+ * Time a serializer case.
+ *
+ * @param value constrained object written
+ * @param write function making one write of the object to a serializer
+ */
+template <typename T, typename Value, typename Write>
+void bench_write(bench_case c, const options& opts, const Value& value,
+                 Write&& write) {
+  c.benchmark = "serializer";
+  const long reps  // NOLINT(runtime/int)
+      = std::max(1L, 4096 / std::max(1L, c.unconstrained));
+  std::vector<T> data_r(reps * c.unconstrained);
+  run(c, opts, [&](long num) {  // NOLINT(runtime/int)
+    stan::io::serializer<T> out(data_r);
+    for (long k = 0; k < num; ++k)  // NOLINT(runtime/int)
+      write(out, value);
+    keep(data_r.data());
+  });
+}
+
+template <typename T>
+void bench_scalar_type(const std::string& scalar, const options& opts) {
+  using vector_t = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+  using matrix_t = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+  for (long size : {1L, 10L, 100L, 1000L}) {  // NOLINT(runtime/int)
+    const long K = std::max(  // NOLINT(runtime/int)
+        2L, std::lround(std::sqrt(static_cast<double>(size))));
+    const long corr = K * (K - 1) / 2;  // NOLINT(runtime/int)
+    const bench_case scalars{"", "scalar", scalar, size, size, size};
+    const bench_case vector{"", "vector", scalar, size, size, size};
+    const bench_case matrix{"", "matrix", scalar, size, K * K, K * K};
+    const bench_case simplex{"", "simplex", scalar, size, size, size - 1};
+    const bench_case ordered{"", "ordered", scalar, size, size, size};
+    const bench_case cholesky{
+        "", "cholesky_factor_corr", scalar, size, K * K, corr};
+
+    bench_read<T>(scalars, opts, [&](auto& in, T& lp) {
+      for (long i = 0; i < size; ++i)  // NOLINT(runtime/int)
+        keep(in.template read<T>());
+    });
+    bench_read<T>(vector, opts, [&](auto& in, T& lp) {
+      keep(in.template read<vector_t>(size));
+    });
+    bench_read<T>(matrix, opts, [&](auto& in, T& lp) {
+      keep(in.template read<matrix_t>(K, K));
+    });
+    bench_read<T>(simplex, opts, [&](auto& in, T& lp) {
+      keep(in.template read_constrain_simplex<vector_t, true>(lp, size));
+    });
+    bench_read<T>(ordered, opts, [&](auto& in, T& lp) {
+      keep(in.template read_constrain_ordered<vector_t, true>(lp, size));
+    });
+    bench_read<T>(cholesky, opts, [&](auto& in, T& lp) {
+      keep(in.template read_constrain_cholesky_factor_corr<matrix_t, true>(
+          lp, K));
+    });
+
+    // Constrained values to write, made from the same unconstrained
+    // values as the reads.  The vars of the inputs of the reads and
+    // writes stay on the tape until all cases of this size are done.
+    std::vector<T> free = unconstrained_values<T>(1, size + K * K);
+    Eigen::Map<vector_t> free_vector(free.data(), size);
+    const vector_t vector_value = free_vector;
+    const matrix_t matrix_value = Eigen::Map<matrix_t>(free.data(), K, K);
+    const vector_t simplex_value
+        = stan::math::simplex_constrain(free_vector.head(size - 1));
+    const vector_t ordered_value = stan::math::ordered_constrain(free_vector);
+    const matrix_t cholesky_value = stan::math::cholesky_corr_constrain(
+        Eigen::Map<vector_t>(free.data(), corr), K);
+
+    bench_write<T>(scalars, opts, vector_value, [&](auto& out, auto& x) {
+      for (long i = 0; i < size; ++i)  // NOLINT(runtime/int)
+        out.write(x.coeff(i));
+    });
+    bench_write<T>(vector, opts, vector_value,
+                   [](auto& out, auto& x) { out.write(x); });
+    bench_write<T>(matrix, opts, matrix_value,
+                   [](auto& out, auto& x) { out.write(x); });
+    bench_write<T>(simplex, opts, simplex_value,
+                   [](auto& out, auto& x) { out.write_free_simplex(x); });
+    bench_write<T>(ordered, opts, ordered_value,
+                   [](auto& out, auto& x) { out.write_free_ordered(x); });
+    bench_write<T>(cholesky, opts, cholesky_value, [](auto& out, auto& x) {
+      out.write_free_cholesky_factor_corr(x);
+    });
+    stan::math::recover_memory();
+  }
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const std::size_t eq = arg.find('=');
+    const std::string key = arg.substr(0, eq);
+    const std::string value
+        = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (key == "min_time") {
+      opts.min_time = std::atof(value.c_str());
+    } else if (key == "filter") {
+      opts.filter = value;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return 1;
+    }
+  }
+  bench_scalar_type<double>("double", opts);
+  bench_scalar_type<stan::math::var>("var", opts);
+  return 0;
+}
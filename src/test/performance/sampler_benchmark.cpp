@@ -0,0 +1,377 @@
+// Throughput benchmark of the Stan algorithms on a single model.
+//
+// Built once per model in src/test/test-models/performance by
+// `make bench`, which includes the generated model header ahead of
+// this file.  Each invocation runs one algorithm and prints one JSON
+// object on a line of its own, so that the peak resident set size and
+// the allocation count belong to that algorithm alone:
+//
+//   <bench> model=<name> algorithm=<algorithm> [data=<file.json>]
+//           [num_warmup=<n>] [num_samples=<n>] [seed=<n>]
+//
+// Algorithms: log_prob_grad, nuts_diag_e, nuts_dense_e, nuts_unit_e,
+// static_diag_e, xhmc_diag_e, pathfinder, meanfield, lbfgs.
+//
+// Allocations are the calls to the global operator new; memory of the
+// autodiff arena is obtained with malloc in large blocks and is only
+// visible through the peak resident set size.
+
+#include <stan/analyze/mcmc/compute_effective_sample_size.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/writer.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/io/json/json_data.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_unit_e_nuts.hpp>
+#include <stan/mcmc/hmc/static/adapt_diag_e_static_hmc.hpp>
+#include <stan/mcmc/hmc/xhmc/adapt_diag_e_xhmc.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/services/experimental/advi/meanfield.hpp>
+#include <stan/services/optimize/lbfgs.hpp>
+#include <stan/services/pathfinder/single.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/services/util/initialize.hpp>
+#include <stan/services/util/run_adaptive_sampler.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<std::size_t> num_allocations(0);
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+/**
+ * Writer keeping the column names and the draws written to it.
+ */
+class draw_recorder : public stan::callbacks::writer {
+ public:
+  void operator()(const std::vector<std::string>& names) { names_ = names; }
+
+  void operator()(const std::vector<double>& state) {
+    draws_.push_back(state);
+  }
+
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    num_matrix_draws_ += values.cols();
+  }
+
+  /**
+   * Return the smallest effective sample size over the columns whose
+   * name does not end in a double underscore, or zero without draws.
+   */
+  double min_ess() const {
+    if (draws_.size() < 4)
+      return 0;
+    double min_ess = std::numeric_limits<double>::infinity();
+    std::vector<double> column(draws_.size());
+    for (std::size_t j = 0; j < names_.size(); ++j) {
+      const std::string& name = names_[j];
+      if (name.size() >= 2 && name.compare(name.size() - 2, 2, "__") == 0)
+        continue;
+      for (std::size_t i = 0; i < draws_.size(); ++i)
+        column[i] = draws_[i][j];
+      min_ess = std::min(min_ess,
+                         stan::analyze::compute_effective_sample_size(
+                             {column.data()}, column.size()));
+    }
+    return std::isfinite(min_ess) ? min_ess : 0;
+  }
+
+  std::size_t num_draws() const { return draws_.size() + num_matrix_draws_; }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<std::vector<double>> draws_;
+  std::size_t num_matrix_draws_ = 0;
+};
+
+/**
+ * Structured writer summing the gradient evaluations and gradient
+ * time over the records of a chain's instrumentation.
+ */
+class gradient_recorder : public stan::callbacks::structured_writer {
+ public:
+  void write(const std::string& key, std::size_t value) {
+    if (key == "gradient_evaluations")
+      num_gradient_evaluations += value;
+  }
+
+  void write(const std::string& key, double value) {
+    if (key == "gradient_time")
+      gradient_time += value;
+  }
+
+  std::size_t num_gradient_evaluations = 0;
+  double gradient_time = 0;
+};
+
+/**
+ * Settings and results of one benchmark run.
+ */
+struct benchmark {
+  std::string model_name;
+  std::string algorithm;
+  std::string data_file;
+  unsigned int seed = 1234;
+  int num_warmup = 1000;
+  int num_samples = 1000;
+
+  std::size_t num_params = 0;
+  double wall_time = 0;
+  long long num_gradient_evaluations = -1;  // NOLINT(runtime/int)
+  double gradient_time = 0;
+  double min_ess = -1;
+  std::size_t num_draws = 0;
+  int return_code = 0;
+};
+
+/**
+ * Run an adaptive sampler the way the sampling services do, with a
+ * unit initial metric and the default adaptation settings.
+ */
+template <class Sampler, class Model>
+void run_mcmc(Sampler& sampler, Model& model, std::vector<double>& cont_vector,
+              stan::rng_t& rng, benchmark& bench,
+              stan::callbacks::logger& logger, draw_recorder& draws) {
+  sampler.set_nominal_stepsize(1);
+  sampler.set_stepsize_jitter(0);
+  sampler.get_stepsize_adaptation().set_mu(std::log(10.0));
+  sampler.get_stepsize_adaptation().set_delta(0.8);
+  sampler.get_stepsize_adaptation().set_gamma(0.05);
+  sampler.get_stepsize_adaptation().set_kappa(0.75);
+  sampler.get_stepsize_adaptation().set_t0(10);
+
+  stan::callbacks::interrupt interrupt;
+  stan::callbacks::writer diagnostic_writer;
+  stan::callbacks::structured_writer metric_writer;
+  gradient_recorder gradients;
+  stan::services::util::run_adaptive_sampler(
+      sampler, model, cont_vector, bench.num_warmup, bench.num_samples, 1, 0,
+      false, rng, interrupt, logger, draws, diagnostic_writer, metric_writer,
+      gradients);
+  bench.num_gradient_evaluations = gradients.num_gradient_evaluations;
+  bench.gradient_time = gradients.gradient_time;
+  bench.min_ess = draws.min_ess();
+}
+
+template <class Sampler>
+void set_windows(Sampler& sampler, const benchmark& bench,
+                 stan::callbacks::logger& logger) {
+  sampler.set_window_params(bench.num_warmup, 75, 50, 25, logger);
+}
+
+template <class Model>
+int run(Model& model, benchmark& bench, stan::callbacks::logger& logger) {
+  stan::rng_t rng = stan::services::util::create_rng(bench.seed, 1);
+  stan::io::empty_var_context init;
+  stan::callbacks::writer init_writer;
+  stan::callbacks::interrupt interrupt;
+  std::vector<double> cont_vector = stan::services::util::initialize(
+      model, init, rng, 2, false, logger, init_writer);
+  bench.num_params = cont_vector.size();
+  draw_recorder draws;
+  stan::callbacks::writer diagnostic_writer;
+
+  if (bench.algorithm == "log_prob_grad") {
+    // At least 1000 evaluations and at least one second
+    std::vector<int> disc_vector;
+    std::vector<double> gradient;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    long long n = 0;  // NOLINT(runtime/int)
+    while (n < 1000 || elapsed < 1) {
+      stan::model::log_prob_grad<true, true>(model, cont_vector, disc_vector,
+                                             gradient);
+      ++n;
+      elapsed = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    }
+    bench.num_gradient_evaluations = n;
+    bench.gradient_time = elapsed;
+  } else if (bench.algorithm == "nuts_diag_e") {
+    stan::mcmc::adapt_diag_e_nuts<Model, stan::rng_t> sampler(model, rng);
+    sampler.set_max_depth(10);
+    set_windows(sampler, bench, logger);
+    run_mcmc(sampler, model, cont_vector, rng, bench, logger, draws);
+  } else if (bench.algorithm == "nuts_dense_e") {
+    stan::mcmc::adapt_dense_e_nuts<Model, stan::rng_t> sampler(model, rng);
+    sampler.set_max_depth(10);
+    set_windows(sampler, bench, logger);
+    run_mcmc(sampler, model, cont_vector, rng, bench, logger, draws);
+  } else if (bench.algorithm == "nuts_unit_e") {
+    stan::mcmc::adapt_unit_e_nuts<Model, stan::rng_t> sampler(model, rng);
+    sampler.set_max_depth(10);
+    run_mcmc(sampler, model, cont_vector, rng, bench, logger, draws);
+  } else if (bench.algorithm == "static_diag_e") {
+    stan::mcmc::adapt_diag_e_static_hmc<Model, stan::rng_t> sampler(model,
+                                                                    rng);
+    sampler.set_nominal_stepsize_and_T(1, 2 * stan::math::pi());
+    set_windows(sampler, bench, logger);
+    run_mcmc(sampler, model, cont_vector, rng, bench, logger, draws);
+  } else if (bench.algorithm == "xhmc_diag_e") {
+    stan::mcmc::adapt_diag_e_xhmc<Model, stan::rng_t> sampler(model, rng);
+    sampler.set_max_depth(10);
+    sampler.set_x_delta(0.1);
+    set_windows(sampler, bench, logger);
+    run_mcmc(sampler, model, cont_vector, rng, bench, logger, draws);
+  } else if (bench.algorithm == "pathfinder") {
+    stan::callbacks::structured_writer pathfinder_diagnostics;
+    bench.return_code = stan::services::pathfinder::pathfinder_lbfgs_single(
+        model, init, bench.seed, 1, 2, 5, 0.001, 1e-12, 10000, 1e-8, 1e7,
+        1e-8, 1000, 25, 1000, false, 0, interrupt, logger, init_writer, draws,
+        pathfinder_diagnostics);
+  } else if (bench.algorithm == "meanfield") {
+    bench.return_code = stan::services::experimental::advi::meanfield(
+        model, init, bench.seed, 1, 2, 1, 100, 10000, 0.01, 1.0, true, 50,
+        100, 1000, interrupt, logger, init_writer, draws, diagnostic_writer);
+  } else if (bench.algorithm == "lbfgs") {
+    bench.return_code = stan::services::optimize::lbfgs(
+        model, init, bench.seed, 1, 2, 5, 0.001, 1e-12, 1e4, 1e-8, 1e7, 1e-8,
+        2000, false, 0, interrupt, logger, init_writer, draws);
+  } else {
+    std::cerr << "Unknown algorithm " << bench.algorithm << std::endl;
+    return 64;
+  }
+  bench.num_draws = draws.num_draws();
+  return 0;
+}
+
+void write_number(std::ostream& out, const std::string& key, double value,
+                  bool known) {
+  out << ", \"" << key << "\": ";
+  if (known && std::isfinite(value))
+    out << value;
+  else
+    out << "null";
+}
+
+/**
+ * Write the results as one JSON object on a single line.
+ */
+void write_json(std::ostream& out, const benchmark& bench,
+                std::size_t allocations, long peak_rss_kb) {  // NOLINT
+  const bool has_gradients = bench.num_gradient_evaluations >= 0;
+  const bool has_ess = bench.min_ess >= 0;
+  out.precision(6);
+  out << "{\"model\": \"" << bench.model_name << "\", \"data\": \""
+      << bench.data_file << "\", \"algorithm\": \"" << bench.algorithm
+      << "\", \"num_params\": " << bench.num_params
+      << ", \"return_code\": " << bench.return_code
+      << ", \"num_draws\": " << bench.num_draws;
+  write_number(out, "wall_time", bench.wall_time, true);
+  write_number(out, "gradient_evaluations",
+               static_cast<double>(bench.num_gradient_evaluations),
+               has_gradients);
+  write_number(out, "gradients_per_second",
+               bench.num_gradient_evaluations / bench.wall_time,
+               has_gradients && bench.wall_time > 0);
+  write_number(out, "gradient_time_fraction",
+               bench.gradient_time / bench.wall_time,
+               has_gradients && bench.wall_time > 0);
+  write_number(out, "min_ess", bench.min_ess, has_ess);
+  write_number(out, "ess_per_second", bench.min_ess / bench.wall_time,
+               has_ess && bench.wall_time > 0);
+  out << ", \"peak_rss_kb\": " << peak_rss_kb
+      << ", \"allocations\": " << allocations << "}" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  benchmark bench;
+  std::map<std::string, std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    std::size_t eq = arg.find('=');
+    if (eq == std::string::npos) {
+      std::cerr << "Expected key=value, found " << arg << std::endl;
+      return 64;
+    }
+    args[arg.substr(0, eq)] = arg.substr(eq + 1);
+  }
+  bench.model_name = args["model"];
+  bench.algorithm = args["algorithm"];
+  bench.data_file = args["data"];
+  if (args.count("seed"))
+    bench.seed = std::stoul(args["seed"]);
+  if (args.count("num_warmup"))
+    bench.num_warmup = std::stoi(args["num_warmup"]);
+  if (args.count("num_samples"))
+    bench.num_samples = std::stoi(args["num_samples"]);
+
+  // Progress messages are discarded, warnings and errors kept
+  std::ostream messages(nullptr);
+  stan::callbacks::stream_logger logger(messages, messages, messages, std::cerr,
+                                        std::cerr);
+
+  std::unique_ptr<stan::io::var_context> data;
+  if (bench.data_file.empty()) {
+    data.reset(new stan::io::empty_var_context());
+  } else {
+    std::ifstream data_stream(bench.data_file);
+    if (!data_stream) {
+      std::cerr << "Cannot open " << bench.data_file << std::endl;
+      return 66;
+    }
+    data.reset(new stan::json::json_data(data_stream));
+  }
+  stan_model model(*data, bench.seed, &messages);
+
+  // Count the run alone, not the model construction
+  std::size_t allocations_before = num_allocations;
+  auto start = std::chrono::steady_clock::now();
+  int return_code = run(model, bench, logger);
+  bench.wall_time
+      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+  if (return_code != 0)
+    return return_code;
+  std::size_t allocations = num_allocations - allocations_before;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  long peak_rss_kb = usage.ru_maxrss / 1024;  // NOLINT(runtime/int)
+#else
+  long peak_rss_kb = usage.ru_maxrss;  // NOLINT(runtime/int)
+#endif
+
+  write_json(std::cout, bench, allocations, peak_rss_kb);
+  return 0;
+}
@@ -58,3 +58,56 @@ TEST(ProbAutocovariance, test2) {
   EXPECT_NEAR(1.10, ac(4), 0.01);
   EXPECT_NEAR(0.89, ac(5), 0.01);
 }
+
+TEST(ProbAutocovariance, workspace) {
+  std::fstream f("src/test/unit/analyze/mcmc/ar1.csv");
+  size_t N = 1000;
+  Eigen::VectorXd y(N);
+  for (size_t i = 0; i < N; ++i)
+    f >> y(i);
+
+  Eigen::VectorXd expected(N);
+  stan::analyze::autocovariance<double>(y, expected);
+
+  stan::analyze::autocovariance_workspace<double> workspace;
+  Eigen::VectorXd ac(N);
+  for (int rep = 0; rep < 3; ++rep) {
+    workspace.autocovariance(y, ac);
+    for (size_t i = 0; i < N; ++i)
+      EXPECT_EQ(expected(i), ac(i));
+  }
+
+  // a shorter sequence resizes the plan and buffers
+  Eigen::VectorXd head = y.head(101);
+  Eigen::VectorXd expected_head(101);
+  stan::analyze::autocovariance<double>(head, expected_head);
+  Eigen::VectorXd ac_head(101);
+  workspace.autocovariance(head, ac_head);
+  for (size_t i = 0; i < 101; ++i)
+    EXPECT_EQ(expected_head(i), ac_head(i));
+}
+
+TEST(ProbAutocovariance, batch) {
+  std::fstream f("src/test/unit/analyze/mcmc/ar1.csv");
+  size_t N = 1000;
+  Eigen::VectorXd y(N);
+  for (size_t i = 0; i < N; ++i)
+    f >> y(i);
+
+  const int K = 50;
+  Eigen::MatrixXd ys(N, K);
+  for (int k = 0; k < K; ++k)
+    ys.col(k) = y.array() * (k + 1) + k;
+
+  Eigen::MatrixXd acov;
+  stan::analyze::batch_autocovariance(ys, acov);
+  ASSERT_EQ(N, acov.rows());
+  ASSERT_EQ(K, acov.cols());
+  for (int k = 0; k < K; ++k) {
+    Eigen::VectorXd y_k = ys.col(k);
+    Eigen::VectorXd expected(N);
+    stan::analyze::autocovariance<double>(y_k, expected);
+    for (size_t i = 0; i < N; ++i)
+      EXPECT_EQ(expected(i), acov(i, k));
+  }
+}
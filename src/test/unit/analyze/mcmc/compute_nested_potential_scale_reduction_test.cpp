@@ -0,0 +1,42 @@
+#include <stan/analyze/mcmc/compute_nested_potential_scale_reduction.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+
+TEST(ComputeNestedRhat, matches_definition) {
+  // Two superchains of two chains of three draws
+  Eigen::MatrixXd draws(3, 4);
+  draws << 1, 2, 4, 6, 2, 3, 5, 6, 3, 7, 6, 9;
+  // Chain means 2, 4, 5, 7; superchain means 3, 6
+  // Within chain variances 1, 7, 1, 3, mean 3
+  // Between chain variances 2, 2, mean 2
+  // Between superchain variance 4.5
+  EXPECT_FLOAT_EQ(std::sqrt(1 + 4.5 / 5),
+                  stan::analyze::compute_nested_potential_scale_reduction(
+                      draws, 2));
+}
+
+TEST(ComputeNestedRhat, single_draw_chains) {
+  // Four superchains of two chains of one draw
+  Eigen::MatrixXd draws(1, 8);
+  draws << 0, 1, 1, 2, 0, 2, 1, 1;
+  // Superchain means 0.5, 1.5, 1, 1, between superchain variance 1/6
+  // Between chain variances 0.5, 0.5, 2, 0, mean 0.75
+  EXPECT_FLOAT_EQ(std::sqrt(1 + (1.0 / 6) / 0.75),
+                  stan::analyze::compute_nested_potential_scale_reduction(
+                      draws, 4));
+}
+
+TEST(ComputeNestedRhat, undefined) {
+  Eigen::MatrixXd draws = Eigen::MatrixXd::Ones(5, 4);
+  EXPECT_TRUE(std::isnan(
+      stan::analyze::compute_nested_potential_scale_reduction(draws, 2)));
+  draws(0, 0) = 2;
+  EXPECT_TRUE(std::isnan(
+      stan::analyze::compute_nested_potential_scale_reduction(draws, 3)));
+  EXPECT_TRUE(std::isnan(
+      stan::analyze::compute_nested_potential_scale_reduction(draws, 1)));
+  draws(0, 0) = std::numeric_limits<double>::infinity();
+  EXPECT_TRUE(std::isnan(
+      stan::analyze::compute_nested_potential_scale_reduction(draws, 2)));
+}
@@ -393,6 +393,64 @@ TEST_F(ComputeRhat, compute_split_potential_scale_reduction_rank) {
   }
 }
 
+TEST_F(ComputeRhat, compute_split_potential_scale_reduction_rank_workspace) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  EXPECT_EQ("", out.str());
+
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+
+  // One workspace reused over every parameter, including the constant
+  // ones, gives the same result as a fresh one per parameter
+  stan::analyze::rank_workspace workspace;
+  Eigen::Matrix<Eigen::VectorXd, Eigen::Dynamic, 1> samples(
+      chains.num_chains());
+  std::vector<const double*> draws(chains.num_chains());
+  std::vector<size_t> sizes(chains.num_chains());
+  for (int index = 0; index < chains.num_params(); index++) {
+    for (int chain = 0; chain < chains.num_chains(); ++chain) {
+      samples(chain) = chains.samples(chain, index);
+      draws[chain] = &samples(chain)(0);
+      sizes[chain] = samples(chain).size();
+    }
+
+    std::pair<double, double> expected
+        = stan::analyze::compute_split_potential_scale_reduction_rank(draws,
+                                                                      sizes);
+    std::pair<double, double> computed
+        = stan::analyze::compute_split_potential_scale_reduction_rank(
+            draws, sizes, workspace);
+    if (std::isnan(expected.first)) {
+      EXPECT_TRUE(std::isnan(computed.first));
+      EXPECT_TRUE(std::isnan(computed.second));
+    } else {
+      EXPECT_EQ(expected.first, computed.first);
+      EXPECT_EQ(expected.second, computed.second);
+    }
+  }
+}
+
+TEST(ComputeRankTransform, ties_and_folded_ranks) {
+  Eigen::MatrixXd chains(3, 2);
+  chains << 1, 4, 2, 2, 3, 0;
+
+  stan::analyze::rank_workspace workspace;
+  Eigen::MatrixXd bulk, tail;
+  workspace.rank_transform(chains, bulk, tail);
+  EXPECT_TRUE(bulk.isApprox(stan::analyze::rank_transform(chains)));
+
+  // The median is 2, so the folded draws are 1, 0, 1, 2, 0, 2
+  Eigen::MatrixXd folded(3, 2);
+  folded << 1, 2, 0, 0, 1, 2;
+  EXPECT_TRUE(tail.isApprox(stan::analyze::rank_transform(folded)));
+  EXPECT_EQ(bulk(1, 0), bulk(1, 1));
+  EXPECT_EQ(tail(0, 0), tail(2, 0));
+}
+
 TEST_F(ComputeRhat, compute_split_potential_scale_reduction_convenience) {
   std::stringstream out;
   stan::io::stan_csv blocker1
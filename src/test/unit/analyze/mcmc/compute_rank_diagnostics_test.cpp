@@ -0,0 +1,118 @@
+#include <stan/analyze/mcmc/compute_rank_diagnostics.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+class ComputeRankDiagnostics : public testing::Test {
+ public:
+  void SetUp() {
+    blocker1_stream.open("src/test/unit/mcmc/test_csv_files/blocker.1.csv");
+    blocker2_stream.open("src/test/unit/mcmc/test_csv_files/blocker.2.csv");
+  }
+
+  void TearDown() {
+    blocker1_stream.close();
+    blocker2_stream.close();
+  }
+  std::ifstream blocker1_stream, blocker2_stream;
+};
+
+// Effective sample size of the specified split chains, one per column
+double split_ess(const Eigen::MatrixXd& split) {
+  std::vector<const double*> draws(split.cols());
+  std::vector<size_t> sizes(split.cols(), split.rows());
+  for (int chain = 0; chain < split.cols(); ++chain)
+    draws[chain] = split.col(chain).data();
+  return stan::analyze::compute_effective_sample_size(draws, sizes);
+}
+
+TEST_F(ComputeRankDiagnostics, matches_separate_diagnostics) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  EXPECT_EQ("", out.str());
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+
+  stan::analyze::rank_diagnostics_workspace workspace;
+  Eigen::Matrix<Eigen::VectorXd, Eigen::Dynamic, 1> samples(
+      chains.num_chains());
+  std::vector<const double*> draws(chains.num_chains());
+  std::vector<size_t> sizes(chains.num_chains());
+  for (int index = 4; index < chains.num_params(); index++) {
+    for (int chain = 0; chain < chains.num_chains(); ++chain) {
+      samples(chain) = chains.samples(chain, index);
+      draws[chain] = &samples(chain)(0);
+      sizes[chain] = samples(chain).size();
+    }
+    stan::analyze::rank_diagnostics diagnostics
+        = stan::analyze::compute_split_rank_diagnostics(draws, sizes,
+                                                        workspace);
+
+    std::pair<double, double> rhat
+        = stan::analyze::compute_split_potential_scale_reduction_rank(draws,
+                                                                      sizes);
+    EXPECT_FLOAT_EQ(rhat.first, diagnostics.rhat_bulk)
+        << "parameter: " << chains.param_name(index);
+    EXPECT_FLOAT_EQ(rhat.second, diagnostics.rhat_tail)
+        << "parameter: " << chains.param_name(index);
+
+    const size_t half = sizes[0] / 2;
+    std::vector<const double*> split_draws
+        = stan::analyze::split_chains(draws, sizes);
+    Eigen::MatrixXd split(half, split_draws.size());
+    for (size_t chain = 0; chain < split_draws.size(); ++chain)
+      split.col(chain)
+          = Eigen::Map<const Eigen::VectorXd>(split_draws[chain], half);
+    std::vector<double> all(split.data(), split.data() + split.size());
+    double q05 = stan::math::quantile(all, 0.05);
+    double q95 = stan::math::quantile(all, 0.95);
+    Eigen::MatrixXd below_05 = (split.array() <= q05).cast<double>();
+    Eigen::MatrixXd below_95 = (split.array() <= q95).cast<double>();
+
+    EXPECT_NEAR(split_ess(stan::analyze::rank_transform(split)),
+                diagnostics.ess_bulk, 1e-6 * diagnostics.ess_bulk)
+        << "parameter: " << chains.param_name(index);
+    EXPECT_NEAR(std::min(split_ess(below_05), split_ess(below_95)),
+                diagnostics.ess_tail, 1e-6 * diagnostics.ess_tail)
+        << "parameter: " << chains.param_name(index);
+  }
+}
+
+TEST(ComputeRankDiagnosticsEdges, nan) {
+  std::vector<double> chain1(10, 1.5);
+  std::vector<double> chain2(10, 1.5);
+  std::vector<const double*> draws{chain1.data(), chain2.data()};
+  std::vector<size_t> sizes{10, 10};
+
+  stan::analyze::rank_diagnostics diagnostics
+      = stan::analyze::compute_split_rank_diagnostics(draws, sizes);
+  EXPECT_TRUE(std::isnan(diagnostics.ess_bulk));
+  EXPECT_TRUE(std::isnan(diagnostics.ess_tail));
+  EXPECT_TRUE(std::isnan(diagnostics.rhat_bulk));
+  EXPECT_TRUE(std::isnan(diagnostics.rhat_tail));
+
+  for (int n = 0; n < 10; ++n)
+    chain1[n] = chain2[n] = n;
+  chain2[3] = std::numeric_limits<double>::infinity();
+  diagnostics = stan::analyze::compute_split_rank_diagnostics(draws, sizes);
+  EXPECT_TRUE(std::isnan(diagnostics.ess_bulk));
+  EXPECT_TRUE(std::isnan(diagnostics.rhat_bulk));
+
+  // Three draws per split chain are too few for the effective sample
+  // sizes, but not for the potential scale reductions
+  chain2[3] = 3.5;
+  sizes = {6, 7};
+  diagnostics = stan::analyze::compute_split_rank_diagnostics(draws, sizes);
+  EXPECT_TRUE(std::isnan(diagnostics.ess_bulk));
+  EXPECT_TRUE(std::isnan(diagnostics.ess_tail));
+  EXPECT_FALSE(std::isnan(diagnostics.rhat_bulk));
+  EXPECT_FALSE(std::isnan(diagnostics.rhat_tail));
+}
@@ -0,0 +1,40 @@
+#include <stan/analyze/mcmc/online_batch_means.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+TEST(OnlineBatchMeans, batches) {
+  stan::analyze::online_batch_means acc(2, 4);
+  Eigen::VectorXd draw(2);
+  for (int n = 0; n < 11; ++n) {
+    draw << n, n * n;
+    acc.add(draw);
+  }
+  // 4 batches of one draw are merged into two of two, then four
+  // batches of two into two of four: 0..3, 4..7 and 8..10 pending
+  EXPECT_EQ(11, acc.num_draws());
+  EXPECT_EQ(4, acc.batch_size());
+  EXPECT_EQ(2, acc.num_batches());
+  EXPECT_EQ(8, acc.num_batched_draws());
+  EXPECT_FLOAT_EQ(1.5, acc.batch_means()(0, 0));
+  EXPECT_FLOAT_EQ(5.5, acc.batch_means()(0, 1));
+  EXPECT_FLOAT_EQ(3.5, acc.batch_means()(1, 0));
+  EXPECT_FLOAT_EQ(31.5, acc.batch_means()(1, 1));
+  EXPECT_FLOAT_EQ(5, acc.batch_m2()(0, 0));
+  EXPECT_FLOAT_EQ(5, acc.batch_m2()(0, 1));
+
+  double mean, m2;
+  acc.combine(0, 0, 2, mean, m2);
+  EXPECT_FLOAT_EQ(3.5, mean);
+  EXPECT_FLOAT_EQ(42, m2);
+
+  acc.clear();
+  EXPECT_EQ(0, acc.num_draws());
+  EXPECT_EQ(1, acc.batch_size());
+}
+
+TEST(OnlineBatchMeans, errors) {
+  EXPECT_THROW(stan::analyze::online_batch_means(2, 5), std::invalid_argument);
+  EXPECT_THROW(stan::analyze::online_batch_means(2, 2), std::invalid_argument);
+  stan::analyze::online_batch_means acc(2);
+  EXPECT_THROW(acc.add(Eigen::VectorXd::Zero(3)), std::invalid_argument);
+}
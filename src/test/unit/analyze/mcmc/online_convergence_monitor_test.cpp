@@ -0,0 +1,64 @@
+#include <stan/analyze/mcmc/online_convergence_monitor.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+// AR(1) draws with autocorrelation rho and unit marginal variance
+void ar1(stan::analyze::online_convergence_monitor& monitor, int chain,
+         double rho, double offset, int num_draws, unsigned int seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> normal(0, std::sqrt(1 - rho * rho));
+  Eigen::VectorXd draw(2);
+  double x = 0;
+  for (int n = 0; n < num_draws; ++n) {
+    x = rho * x + normal(rng);
+    draw << x + offset, normal(rng);
+    monitor.add(chain, draw);
+  }
+}
+}  // namespace
+
+TEST(OnlineConvergenceMonitor, too_few_draws) {
+  stan::analyze::online_convergence_monitor monitor(2, 1);
+  Eigen::VectorXd draw(1);
+  draw << 1;
+  for (int n = 0; n < 3; ++n)
+    monitor.add(0, draw);
+  EXPECT_TRUE(std::isnan(monitor.effective_sample_size(0)));
+  EXPECT_TRUE(std::isnan(monitor.split_potential_scale_reduction(0)));
+  EXPECT_EQ(3, monitor.num_draws(0));
+  EXPECT_EQ(0, monitor.num_draws(1));
+}
+
+TEST(OnlineConvergenceMonitor, ar1) {
+  const int num_chains = 4;
+  const int num_draws = 1 << 16;
+  const double rho = 0.5;
+  stan::analyze::online_convergence_monitor monitor(num_chains, 2);
+  std::vector<std::thread> threads;
+  for (int c = 0; c < num_chains; ++c)
+    threads.emplace_back(ar1, std::ref(monitor), c, rho, 0.0, num_draws,
+                         1234 + c);
+  for (auto& thread : threads)
+    thread.join();
+
+  // ESS of AR(1) is N (1 - rho) / (1 + rho)
+  double expected = num_chains * num_draws * (1 - rho) / (1 + rho);
+  Eigen::VectorXd ess = monitor.effective_sample_size();
+  EXPECT_NEAR(1, ess(0) / expected, 0.2);
+  EXPECT_NEAR(1, ess(1) / (num_chains * num_draws), 0.2);
+  Eigen::VectorXd rhat = monitor.split_potential_scale_reduction();
+  EXPECT_NEAR(1, rhat(0), 0.01);
+  EXPECT_NEAR(1, rhat(1), 0.01);
+}
+
+TEST(OnlineConvergenceMonitor, not_mixed) {
+  stan::analyze::online_convergence_monitor monitor(2, 2);
+  ar1(monitor, 0, 0.5, 0.0, 4096, 1);
+  ar1(monitor, 1, 0.5, 3.0, 4096, 2);
+  EXPECT_GT(monitor.split_potential_scale_reduction(0), 1.5);
+  EXPECT_NEAR(1, monitor.split_potential_scale_reduction(1), 0.05);
+}
@@ -0,0 +1,82 @@
+#include <stan/analyze/mcmc/stan_csv_diagnostics.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+class StanCsvDiagnostics : public testing::Test {
+ public:
+  void SetUp() {
+    std::ifstream blocker1_stream(
+        "src/test/unit/mcmc/test_csv_files/blocker.1.csv");
+    std::ifstream blocker2_stream(
+        "src/test/unit/mcmc/test_csv_files/blocker.2.csv");
+    std::stringstream out;
+    csvs.push_back(stan::io::stan_csv_reader::parse(blocker1_stream, &out));
+    csvs.push_back(stan::io::stan_csv_reader::parse(blocker2_stream, &out));
+    EXPECT_EQ("", out.str());
+  }
+
+  std::vector<stan::io::stan_csv> csvs;
+};
+
+TEST_F(StanCsvDiagnostics, matches_chains) {
+  stan::mcmc::chains<> chains(csvs[0]);
+  chains.add(csvs[1]);
+  stan::analyze::stan_csv_diagnostics diagnostics(csvs);
+
+  for (int index = 0; index < chains.num_params(); ++index) {
+    double ess = chains.split_effective_sample_size(index);
+    double rhat = chains.split_potential_scale_reduction(index);
+    std::pair<double, double> rhat_rank
+        = chains.split_potential_scale_reduction_rank(index);
+    if (std::isnan(ess))
+      EXPECT_TRUE(std::isnan(diagnostics.split_effective_sample_size(index)));
+    else
+      EXPECT_EQ(ess, diagnostics.split_effective_sample_size(index));
+    if (std::isnan(rhat))
+      EXPECT_TRUE(
+          std::isnan(diagnostics.split_potential_scale_reduction(index)));
+    else
+      EXPECT_EQ(rhat, diagnostics.split_potential_scale_reduction(index));
+    std::pair<double, double> computed
+        = diagnostics.split_potential_scale_reduction_rank(index);
+    if (std::isnan(rhat_rank.first)) {
+      EXPECT_TRUE(std::isnan(computed.first));
+    } else {
+      EXPECT_EQ(rhat_rank.first, computed.first);
+      EXPECT_EQ(rhat_rank.second, computed.second);
+    }
+  }
+}
+
+TEST_F(StanCsvDiagnostics, skips_saved_warmup) {
+  stan::io::stan_csv_metadata metadata;
+  EXPECT_EQ(0, stan::analyze::num_warmup_draws(metadata));
+  metadata.num_warmup = 1000;
+  EXPECT_EQ(0, stan::analyze::num_warmup_draws(metadata));
+  metadata.save_warmup = true;
+  metadata.thin = 3;
+  EXPECT_EQ(334, stan::analyze::num_warmup_draws(metadata));
+
+  // Prepend the first draws of each chain as warmup
+  std::vector<stan::io::stan_csv> with_warmup = csvs;
+  for (auto& csv : with_warmup) {
+    Eigen::MatrixXd samples(csv.samples.rows() + 10, csv.samples.cols());
+    samples.topRows(10) = csv.samples.topRows(10);
+    samples.bottomRows(csv.samples.rows()) = csv.samples;
+    csv.samples = samples;
+    csv.metadata.save_warmup = true;
+    csv.metadata.num_warmup = 10;
+    csv.metadata.thin = 1;
+  }
+  stan::analyze::stan_csv_diagnostics expected(csvs);
+  stan::analyze::stan_csv_diagnostics computed(with_warmup);
+  int index = csvs[0].header.size() - 1;
+  EXPECT_EQ(expected.split_effective_sample_size(index),
+            computed.split_effective_sample_size(index));
+  EXPECT_EQ(expected.split_potential_scale_reduction(index),
+            computed.split_potential_scale_reduction(index));
+}
@@ -0,0 +1,48 @@
+#include <stan/analyze/psis.hpp>
+#include <gtest/gtest.h>
+
+TEST(analyze_psis, largest_n_elements_unsorted) {
+  Eigen::Array<double, Eigen::Dynamic, 1> arr(10);
+  arr << 3, -1, 7, 7, 0, 9, -4, 2, 8, 5;
+  auto top = stan::analyze::internal::largest_n_elements(arr, 4);
+  ASSERT_EQ(4, top.first.size());
+  ASSERT_EQ(4, top.second.size());
+  Eigen::Array<double, Eigen::Dynamic, 1> top_ans(4);
+  top_ans << 7, 7, 8, 9;
+  Eigen::Array<Eigen::Index, Eigen::Dynamic, 1> idx_ans(4);
+  idx_ans << 2, 3, 8, 5;
+  for (Eigen::Index i = 0; i < 4; ++i) {
+    EXPECT_EQ(top_ans(i), top.first(i));
+    EXPECT_EQ(idx_ans(i), top.second(i));
+  }
+}
+
+TEST(analyze_psis, largest_n_elements_whole_array) {
+  Eigen::Array<double, Eigen::Dynamic, 1> arr(3);
+  arr << 2, 1, 3;
+  auto top = stan::analyze::internal::largest_n_elements(arr, 5);
+  ASSERT_EQ(3, top.first.size());
+  EXPECT_EQ(1, top.first(0));
+  EXPECT_EQ(3, top.first(2));
+  EXPECT_EQ(1, top.second(0));
+  EXPECT_EQ(2, top.second(2));
+}
+
+TEST(analyze_psis, tail_length) {
+  EXPECT_EQ(20, stan::analyze::psis_tail_length(100));
+  EXPECT_EQ(300, stan::analyze::psis_tail_length(10000));
+}
+
+TEST(analyze_psis, pareto_k) {
+  using array_t = Eigen::Array<double, Eigen::Dynamic, 1>;
+  // Quantiles of ratios uniform on (0, 1] have a bounded tail
+  array_t light = array_t::LinSpaced(1000, 0.0005, 0.9995).log();
+  EXPECT_LT(stan::analyze::psis_pareto_k(light, 100), 0.5);
+  // Quantiles of ratios with a Pareto tail of shape 1
+  array_t heavy = -(1 - array_t::LinSpaced(1000, 0.0005, 0.9995)).log();
+  EXPECT_GT(stan::analyze::psis_pareto_k(heavy, 100), 0.7);
+  // Too short or flat a tail
+  EXPECT_TRUE(std::isnan(stan::analyze::psis_pareto_k(heavy, 4)));
+  EXPECT_TRUE(
+      std::isnan(stan::analyze::psis_pareto_k(array_t::Zero(1000), 100)));
+}
@@ -0,0 +1,62 @@
+#include <stan/analyze/reproducible_sum.hpp>
+#include <gtest/gtest.h>
+#include <tbb/task_arena.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Terms of very different magnitudes, whose sum depends on the order of
+// the additions
+double term(std::size_t i) { return std::pow(-1.1, i % 300) / (1 + i); }
+
+}  // namespace
+
+TEST(AnalyzeReproducibleSum, same_for_any_thread_count) {
+  const std::size_t n = 100003;
+  double serial;
+  tbb::task_arena one_thread(1);
+  one_thread.execute(
+      [&] { serial = stan::analyze::reproducible_sum(n, term); });
+  for (int num_threads : {2, 3, 8}) {
+    tbb::task_arena arena(num_threads);
+    for (int k = 0; k < 5; ++k) {
+      double parallel;
+      arena.execute(
+          [&] { parallel = stan::analyze::reproducible_sum(n, term); });
+      EXPECT_EQ(serial, parallel);
+    }
+  }
+}
+
+TEST(AnalyzeReproducibleSum, chunks_in_pairwise_tree) {
+  Eigen::VectorXd x(7);
+  x << 1e16, 1, -1e16, 1, 2, 3, 4;
+  // Chunks {1e16, 1}, {-1e16, 1}, {2, 3}, {4} are added as
+  // ((1e16 + -1e16) + (5 + 4)): the ones are lost to rounding in the
+  // first two chunks
+  EXPECT_EQ(9.0, stan::analyze::reproducible_sum(x, 2));
+  // A single chunk is summed in order
+  EXPECT_EQ(10.0, stan::analyze::reproducible_sum(x, 7));
+  EXPECT_EQ(0.0, stan::analyze::reproducible_sum(Eigen::VectorXd(0)));
+}
+
+TEST(AnalyzeReproducibleSum, rowwise_sum) {
+  Eigen::MatrixXd x = Eigen::MatrixXd::Random(5, 301);
+  Eigen::VectorXd expected = x.rowwise().sum();
+  Eigen::VectorXd serial;
+  tbb::task_arena one_thread(1);
+  one_thread.execute(
+      [&] { serial = stan::analyze::reproducible_rowwise_sum(x, 8); });
+  tbb::task_arena arena(4);
+  Eigen::VectorXd parallel;
+  arena.execute(
+      [&] { parallel = stan::analyze::reproducible_rowwise_sum(x, 8); });
+  ASSERT_EQ(5, parallel.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(serial(i), parallel(i));
+    EXPECT_NEAR(expected(i), parallel(i), 1e-12);
+  }
+  EXPECT_EQ(0, stan::analyze::reproducible_rowwise_sum(Eigen::MatrixXd(3, 0))
+                   .squaredNorm());
+}
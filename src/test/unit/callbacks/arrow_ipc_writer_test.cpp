@@ -0,0 +1,266 @@
+#include <stan/callbacks/arrow_ipc_writer.hpp>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+using arrow_writer
+    = stan::callbacks::arrow_ipc_writer<std::stringstream, deleter_noop>;
+
+/**
+ * Reads the fields of a flatbuffer, following the offsets as Arrow
+ * readers do.
+ */
+struct flatbuffer_view {
+  const std::string& buf;
+
+  std::uint64_t get(std::size_t pos, std::size_t size) const {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i)
+      value |= std::uint64_t(static_cast<unsigned char>(buf.at(pos + i)))
+               << (8 * i);
+    return value;
+  }
+
+  std::size_t deref(std::size_t pos) const { return pos + get(pos, 4); }
+
+  std::size_t root() const { return deref(0); }
+
+  // Position of a field of a table, or 0 if absent
+  std::size_t field(std::size_t table, int slot) const {
+    const std::size_t vtable
+        = table - static_cast<std::int32_t>(get(table, 4));
+    if (4 + 2 * static_cast<std::size_t>(slot) >= get(vtable, 2))
+      return 0;
+    const std::size_t offset = get(vtable + 4 + 2 * slot, 2);
+    EXPECT_LT(offset, get(vtable + 2, 2));
+    return offset == 0 ? 0 : table + offset;
+  }
+
+  std::uint64_t scalar(std::size_t table, int slot, std::size_t size) const {
+    const std::size_t pos = field(table, slot);
+    if (pos != 0) {
+      EXPECT_EQ(0, pos % size);
+    }
+    return pos == 0 ? 0 : get(pos, size);
+  }
+
+  std::size_t child(std::size_t table, int slot) const {
+    const std::size_t pos = field(table, slot);
+    return pos == 0 ? 0 : deref(pos);
+  }
+
+  std::string string(std::size_t pos) const {
+    return buf.substr(pos + 4, get(pos, 4));
+  }
+
+  std::size_t element(std::size_t vector, std::size_t i) const {
+    return deref(vector + 4 + 4 * i);
+  }
+};
+
+struct message {
+  std::string metadata;
+  std::string body;
+};
+
+std::vector<message> read_messages(const std::string& stream) {
+  std::vector<message> messages;
+  std::size_t pos = 0;
+  flatbuffer_view view{stream};
+  while (true) {
+    EXPECT_EQ(0, pos % 8);
+    EXPECT_EQ(0xFFFFFFFF, view.get(pos, 4));
+    const std::size_t size = view.get(pos + 4, 4);
+    pos += 8;
+    if (size == 0)
+      break;
+    EXPECT_EQ(0, size % 8);
+    message m;
+    m.metadata = stream.substr(pos, size);
+    pos += size;
+    flatbuffer_view fb{m.metadata};
+    EXPECT_EQ(4, fb.scalar(fb.root(), 0, 2));
+    const std::size_t body_length = fb.scalar(fb.root(), 3, 8);
+    m.body = stream.substr(pos, body_length);
+    pos += body_length;
+    messages.push_back(m);
+  }
+  EXPECT_EQ(stream.size(), pos);
+  return messages;
+}
+
+std::string custom_metadata(const flatbuffer_view& fb, std::size_t table,
+                            int slot) {
+  const std::size_t vector = fb.child(table, slot);
+  if (vector == 0)
+    return "<none>";
+  EXPECT_EQ(1, fb.get(vector, 4));
+  const std::size_t kv = fb.element(vector, 0);
+  EXPECT_EQ("stan_messages", fb.string(fb.child(kv, 0)));
+  return fb.string(fb.child(kv, 1));
+}
+
+struct batch {
+  std::size_t length;
+  std::string messages;
+  std::vector<std::vector<double>> doubles;
+  std::vector<std::int32_t> ints;
+};
+
+batch read_batch(const message& m, bool has_int_column) {
+  flatbuffer_view fb{m.metadata};
+  EXPECT_EQ(3, fb.scalar(fb.root(), 1, 1));
+  const std::size_t record_batch = fb.child(fb.root(), 2);
+  batch b;
+  b.length = fb.scalar(record_batch, 0, 8);
+  b.messages = custom_metadata(fb, fb.root(), 4);
+  const std::size_t nodes = fb.child(record_batch, 1);
+  const std::size_t buffers = fb.child(record_batch, 2);
+  EXPECT_EQ(0, (nodes + 4) % 8);
+  EXPECT_EQ(0, (buffers + 4) % 8);
+  const std::size_t num_cols = fb.get(nodes, 4);
+  EXPECT_EQ(2 * num_cols, fb.get(buffers, 4));
+  for (std::size_t j = 0; j < num_cols; ++j) {
+    // FieldNode {length, null_count}, then the validity and data
+    // Buffer {offset, length} of the column
+    EXPECT_EQ(b.length, fb.get(nodes + 4 + 16 * j, 8));
+    EXPECT_EQ(0, fb.get(nodes + 12 + 16 * j, 8));
+    EXPECT_EQ(0, fb.get(buffers + 12 + 32 * j, 8));
+    const std::size_t offset = fb.get(buffers + 20 + 32 * j, 8);
+    const std::size_t length = fb.get(buffers + 28 + 32 * j, 8);
+    EXPECT_EQ(0, offset % 8);
+    if (j == 0 && has_int_column) {
+      EXPECT_EQ(4 * b.length, length);
+      b.ints.resize(b.length);
+      std::memcpy(b.ints.data(), m.body.data() + offset, length);
+    } else {
+      EXPECT_EQ(8 * b.length, length);
+      std::vector<double> column(b.length);
+      std::memcpy(column.data(), m.body.data() + offset, length);
+      b.doubles.push_back(column);
+    }
+  }
+  return b;
+}
+
+}  // namespace
+
+TEST(StanCallbacksArrowIpcWriter, roundtrip) {
+  std::stringstream ss;
+  std::vector<std::string> names{"lp__", "theta.1", "theta.2"};
+  {
+    arrow_writer writer(std::unique_ptr<std::stringstream, deleter_noop>(&ss),
+                        4);
+    writer("model = bernoulli");
+    writer();
+    writer(names);
+    for (int n = 0; n < 10; ++n)
+      writer(std::vector<double>{-1.0 * n, 0.5 * n, n + 0.25});
+    writer("Elapsed Time");
+  }
+
+  std::vector<message> messages = read_messages(ss.str());
+  ASSERT_EQ(4, messages.size());
+
+  flatbuffer_view fb{messages[0].metadata};
+  EXPECT_EQ(1, fb.scalar(fb.root(), 1, 1));
+  EXPECT_TRUE(messages[0].body.empty());
+  const std::size_t schema = fb.child(fb.root(), 2);
+  EXPECT_EQ("model = bernoulli\n", custom_metadata(fb, schema, 2));
+  const std::size_t fields = fb.child(schema, 1);
+  ASSERT_EQ(3, fb.get(fields, 4));
+  for (std::size_t j = 0; j < 3; ++j) {
+    const std::size_t field = fb.element(fields, j);
+    EXPECT_EQ(names[j], fb.string(fb.child(field, 0)));
+    EXPECT_EQ(0, fb.scalar(field, 1, 1));
+    EXPECT_EQ(3, fb.scalar(field, 2, 1));
+    EXPECT_EQ(2, fb.scalar(fb.child(field, 3), 0, 2));
+    EXPECT_EQ(0, fb.get(fb.child(field, 5), 4));
+  }
+
+  int n = 0;
+  const std::size_t lengths[] = {4, 4, 2};
+  for (std::size_t k = 0; k < 3; ++k) {
+    batch b = read_batch(messages[k + 1], false);
+    EXPECT_EQ(lengths[k], b.length);
+    // The last draws are written with the messages that follow them
+    EXPECT_EQ(k == 2 ? "Elapsed Time" : "<none>", b.messages);
+    ASSERT_EQ(3, b.doubles.size());
+    for (std::size_t i = 0; i < b.length; ++i, ++n) {
+      EXPECT_EQ(-1.0 * n, b.doubles[0][i]);
+      EXPECT_EQ(0.5 * n, b.doubles[1][i]);
+      EXPECT_EQ(n + 0.25, b.doubles[2][i]);
+    }
+  }
+  EXPECT_EQ(10, n);
+}
+
+TEST(StanCallbacksArrowIpcWriter, chain_column) {
+  std::stringstream ss;
+  {
+    arrow_writer writer(std::unique_ptr<std::stringstream, deleter_noop>(&ss),
+                        8, 3);
+    writer(std::vector<std::string>{"lp__", "mu"});
+    Eigen::MatrixXd values(2, 3);
+    values << 1, 2, 3, 4, 5, 6;
+    writer(values);
+    writer.flush();
+  }
+
+  std::vector<message> messages = read_messages(ss.str());
+  ASSERT_EQ(2, messages.size());
+  flatbuffer_view fb{messages[0].metadata};
+  const std::size_t schema = fb.child(fb.root(), 2);
+  EXPECT_EQ("<none>", custom_metadata(fb, schema, 2));
+  const std::size_t fields = fb.child(schema, 1);
+  ASSERT_EQ(3, fb.get(fields, 4));
+  const std::size_t chain = fb.element(fields, 0);
+  EXPECT_EQ("chain__", fb.string(fb.child(chain, 0)));
+  EXPECT_EQ(2, fb.scalar(chain, 2, 1));
+  EXPECT_EQ(32, fb.scalar(fb.child(chain, 3), 0, 4));
+  EXPECT_EQ(1, fb.scalar(fb.child(chain, 3), 1, 1));
+
+  batch b = read_batch(messages[1], true);
+  ASSERT_EQ(3, b.length);
+  EXPECT_EQ(std::vector<std::int32_t>({3, 3, 3}), b.ints);
+  ASSERT_EQ(2, b.doubles.size());
+  EXPECT_EQ(std::vector<double>({1, 2, 3}), b.doubles[0]);
+  EXPECT_EQ(std::vector<double>({4, 5, 6}), b.doubles[1]);
+}
+
+TEST(StanCallbacksArrowIpcWriter, no_header) {
+  std::stringstream ss;
+  {
+    arrow_writer writer{std::unique_ptr<std::stringstream, deleter_noop>(&ss)};
+    EXPECT_THROW(writer(std::vector<double>{1.0}), std::invalid_argument);
+    writer("Rejecting initial value");
+  }
+  // The stream still starts with a schema, without columns
+  std::vector<message> messages = read_messages(ss.str());
+  ASSERT_EQ(1, messages.size());
+  flatbuffer_view fb{messages[0].metadata};
+  const std::size_t schema = fb.child(fb.root(), 2);
+  EXPECT_EQ(0, fb.get(fb.child(schema, 1), 4));
+  EXPECT_EQ("Rejecting initial value", custom_metadata(fb, schema, 2));
+}
+
+TEST(StanCallbacksArrowIpcWriter, names_once) {
+  std::stringstream ss;
+  arrow_writer writer{std::unique_ptr<std::stringstream, deleter_noop>(&ss)};
+  writer(std::vector<std::string>{"lp__"});
+  EXPECT_THROW(writer(std::vector<std::string>{"lp__"}),
+               std::invalid_argument);
+  EXPECT_THROW(writer(std::vector<double>{1.0, 2.0}), std::invalid_argument);
+}
@@ -0,0 +1,78 @@
+#include <stan/callbacks/async_writer.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace test {
+class throwing_writer : public stan::callbacks::writer {
+ public:
+  int N;
+
+  throwing_writer() : N(0) {}
+
+  void operator()(const std::vector<double>& state) {
+    ++N;
+    throw std::runtime_error("disk full");
+  }
+};
+
+// Writes the same calls through the specified writer
+void write_all(stan::callbacks::writer& writer) {
+  std::vector<std::string> names{"lp__", "accept_stat__", "theta"};
+  writer(names);
+  writer("Adaptation terminated");
+  for (int n = 0; n < 500; ++n) {
+    std::vector<double> state{-0.5 * n, 0.25, n + 0.125};
+    writer(state);
+  }
+  writer();
+  Eigen::MatrixXd values(3, 2);
+  values << 1, 2, 3, 4, 5, 6;
+  writer(values);
+}
+}  // namespace test
+
+TEST(StanCallbacksAsyncWriter, matches_direct_writes) {
+  std::stringstream direct_stream;
+  stan::callbacks::stream_writer direct(direct_stream, "# ");
+  test::write_all(direct);
+
+  for (std::size_t capacity : {1, 3, 64}) {
+    std::stringstream async_stream;
+    stan::callbacks::stream_writer sink(async_stream, "# ");
+    {
+      stan::callbacks::async_writer writer(sink, capacity);
+      test::write_all(writer);
+      writer.flush();
+      EXPECT_EQ(direct_stream.str(), async_stream.str());
+    }
+    EXPECT_EQ(direct_stream.str(), async_stream.str());
+  }
+}
+
+TEST(StanCallbacksAsyncWriter, destructor_drains) {
+  std::stringstream direct_stream;
+  stan::callbacks::stream_writer direct(direct_stream);
+  test::write_all(direct);
+
+  std::stringstream async_stream;
+  stan::callbacks::stream_writer sink(async_stream);
+  {
+    stan::callbacks::async_writer writer(sink, 2);
+    test::write_all(writer);
+  }
+  EXPECT_EQ(direct_stream.str(), async_stream.str());
+}
+
+TEST(StanCallbacksAsyncWriter, rethrows_sink_errors) {
+  test::throwing_writer sink;
+  stan::callbacks::async_writer writer(sink);
+  std::vector<double> state{1, 2};
+  writer(state);
+  EXPECT_THROW(writer.flush(), std::runtime_error);
+  EXPECT_THROW(writer(state), std::runtime_error);
+  EXPECT_EQ(1, sink.N);
+}
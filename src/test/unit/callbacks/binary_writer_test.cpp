@@ -0,0 +1,90 @@
+#include <stan/callbacks/binary_writer.hpp>
+#include <stan/io/stan_binary_reader.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+class StanCallbacksBinaryWriter : public ::testing::Test {
+ public:
+  StanCallbacksBinaryWriter()
+      : names{"lp__", "theta.1", "theta.2"},
+        writer(std::unique_ptr<std::stringstream, deleter_noop>(&ss), 4) {}
+
+  void SetUp() {
+    ss.str(std::string());
+    ss.clear();
+  }
+
+  std::stringstream ss;
+  std::vector<std::string> names;
+  stan::callbacks::binary_writer<std::stringstream, deleter_noop> writer;
+};
+
+TEST_F(StanCallbacksBinaryWriter, roundtrip) {
+  writer(names);
+  writer("Adaptation terminated");
+  for (int n = 0; n < 10; ++n)
+    writer(std::vector<double>{-1.0 * n, 0.5 * n, n + 0.25});
+  writer();
+  writer.flush();
+
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, 0);
+  EXPECT_EQ(names, draws.header);
+  ASSERT_EQ(10, draws.samples.rows());
+  ASSERT_EQ(3, draws.samples.cols());
+  for (int n = 0; n < 10; ++n) {
+    EXPECT_EQ(-1.0 * n, draws.samples(n, 0));
+    EXPECT_EQ(0.5 * n, draws.samples(n, 1));
+    EXPECT_EQ(n + 0.25, draws.samples(n, 2));
+  }
+  ASSERT_EQ(2, draws.messages.size());
+  EXPECT_EQ("Adaptation terminated", draws.messages[0]);
+  EXPECT_EQ("", draws.messages[1]);
+}
+
+TEST_F(StanCallbacksBinaryWriter, matrix_of_draws) {
+  writer(names);
+  Eigen::MatrixXd values(3, 6);
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 6; ++j)
+      values(i, j) = 10 * i + j;
+  writer(values);
+  writer.flush();
+
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, 0);
+  ASSERT_EQ(6, draws.samples.rows());
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 6; ++j)
+      EXPECT_EQ(values(i, j), draws.samples(j, i));
+}
+
+TEST_F(StanCallbacksBinaryWriter, append) {
+  writer(names);
+  writer(std::vector<double>{1, 2, 3});
+  writer.flush();
+  {
+    stan::callbacks::binary_writer<std::stringstream, deleter_noop> appender{
+        std::unique_ptr<std::stringstream, deleter_noop>(&ss)};
+    appender(names);
+    appender(std::vector<double>{4, 5, 6});
+  }
+
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, 0);
+  ASSERT_EQ(2, draws.samples.rows());
+  EXPECT_EQ(1, draws.samples(0, 0));
+  EXPECT_EQ(6, draws.samples(1, 2));
+}
+
+TEST_F(StanCallbacksBinaryWriter, bad_rows) {
+  EXPECT_THROW(writer(std::vector<double>{1, 2, 3}), std::invalid_argument);
+  writer(names);
+  EXPECT_THROW(writer(std::vector<double>{1, 2}), std::invalid_argument);
+}
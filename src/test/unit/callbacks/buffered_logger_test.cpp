@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stan/callbacks/buffered_logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+
+TEST(StanInterfaceCallbacksBufferedLogger, replay) {
+  stan::callbacks::buffered_logger buffer;
+  std::stringstream message;
+  message << "message 2";
+  buffer.info("message 1");
+  buffer.warn(message);
+  buffer.debug("debug");
+  buffer.error("error");
+  buffer.fatal("fatal");
+  buffer.info(message);
+  ASSERT_EQ(6U, buffer.messages().size());
+  EXPECT_EQ(stan::callbacks::buffered_logger::level::warn,
+            buffer.messages()[1].first);
+  EXPECT_EQ("message 2", buffer.messages()[1].second);
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  buffer.replay(logger);
+  EXPECT_EQ("debug\n", debug.str());
+  EXPECT_EQ("message 1\nmessage 2\n", info.str());
+  EXPECT_EQ("message 2\n", warn.str());
+  EXPECT_EQ("error\n", error.str());
+  EXPECT_EQ("fatal\n", fatal.str());
+  EXPECT_TRUE(buffer.messages().empty());
+
+  buffer.info("discarded");
+  buffer.clear();
+  buffer.replay(logger);
+  EXPECT_EQ("message 1\nmessage 2\n", info.str());
+}
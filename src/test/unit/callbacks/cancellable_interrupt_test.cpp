@@ -0,0 +1,50 @@
+#include <stan/callbacks/cancellable_interrupt.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+namespace {
+class throwing_interrupt : public stan::callbacks::interrupt {
+ public:
+  void operator()() { throw std::runtime_error("interrupted"); }
+};
+}  // namespace
+
+TEST(StanCallbacksCancellableInterrupt, forwards_until_cancelled) {
+  stan::test::unit::instrumented_interrupt wrapped;
+  stan::callbacks::cancellation_token token;
+  stan::callbacks::cancellable_interrupt interrupt(wrapped, token);
+
+  interrupt();
+  interrupt();
+  EXPECT_EQ(2, wrapped.call_count());
+  token.cancel();
+  EXPECT_THROW(interrupt(), stan::callbacks::cancelled_error);
+  EXPECT_EQ(2, wrapped.call_count());
+}
+
+TEST(StanCallbacksCancellableInterrupt, wrapped_throw_cancels) {
+  throwing_interrupt wrapped;
+  stan::test::unit::instrumented_interrupt other_wrapped;
+  stan::callbacks::cancellation_token token;
+  stan::callbacks::cancellable_interrupt interrupt(wrapped, token);
+  stan::callbacks::cancellable_interrupt other(other_wrapped, token);
+
+  EXPECT_THROW(interrupt(), std::runtime_error);
+  EXPECT_TRUE(token.cancelled());
+  EXPECT_THROW(other(), stan::callbacks::cancelled_error);
+  EXPECT_EQ(0, other_wrapped.call_count());
+}
+
+TEST(StanCallbacksCancellableInterrupt, finish_cancels) {
+  stan::test::unit::instrumented_interrupt wrapped;
+  stan::callbacks::cancellation_token token;
+  stan::callbacks::cancellable_interrupt interrupt(wrapped, token);
+
+  EXPECT_FALSE(token.finished());
+  token.finish();
+  EXPECT_TRUE(token.cancelled());
+  EXPECT_TRUE(token.finished());
+  EXPECT_THROW(interrupt(), stan::callbacks::cancelled_error);
+  EXPECT_EQ(0, wrapped.call_count());
+}
@@ -0,0 +1,71 @@
+#include <stan/callbacks/column_major_writer.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(ColumnMajorWriter, allocated_buffer) {
+  stan::callbacks::column_major_writer writer(3);
+  stan::callbacks::writer& base = writer;
+  EXPECT_EQ(nullptr, writer.data());
+
+  base(std::vector<std::string>{"lp__", "a", "b"});
+  base("Adaptation terminated");
+  EXPECT_EQ(3, writer.num_cols());
+  EXPECT_EQ(3, writer.capacity());
+
+  base(std::vector<double>{1, 2, 3});
+  std::vector<double> sampler{4};
+  Eigen::VectorXd params(2);
+  params << 5, 6;
+  base({sampler, params});
+  EXPECT_EQ(2, writer.num_rows());
+  EXPECT_FLOAT_EQ(2, writer.data()[3]);
+  EXPECT_FLOAT_EQ(6, writer.data()[7]);
+
+  // the buffer grows in place past the expected rows
+  for (int i = 0; i < 20; ++i)
+    base(std::vector<double>{10.0 + i, 20.0 + i, 30.0 + i});
+  EXPECT_EQ(22, writer.num_rows());
+  EXPECT_EQ(0, writer.num_dropped());
+  EXPECT_LE(22, writer.capacity());
+  Eigen::MatrixXd values = writer.values();
+  ASSERT_EQ(22, values.rows());
+  ASSERT_EQ(3, values.cols());
+  EXPECT_FLOAT_EQ(1, values(0, 0));
+  EXPECT_FLOAT_EQ(6, values(1, 2));
+  EXPECT_FLOAT_EQ(29, values(21, 0));
+  EXPECT_FLOAT_EQ(39, values(21, 1));
+  EXPECT_FLOAT_EQ(49, values(21, 2));
+
+  EXPECT_EQ(std::vector<std::string>({"lp__", "a", "b"}), writer.names());
+  EXPECT_EQ(std::vector<std::string>({"Adaptation terminated"}),
+            writer.messages());
+
+  std::vector<double> released = writer.release();
+  ASSERT_EQ(22 * 3, released.size());
+  EXPECT_TRUE(
+      (Eigen::Map<Eigen::MatrixXd>(released.data(), 22, 3).array()
+       == values.array())
+          .all());
+  EXPECT_EQ(0, writer.num_rows());
+}
+
+TEST(ColumnMajorWriter, caller_buffer) {
+  std::vector<double> buffer(2 * 2, -1);
+  stan::callbacks::column_major_writer writer(buffer.data(), 2, 2);
+  stan::callbacks::writer& base = writer;
+
+  EXPECT_THROW(base(std::vector<std::string>{"a", "b", "c"}),
+               std::invalid_argument);
+  base(std::vector<std::string>{"a", "b"});
+  EXPECT_THROW(base(std::vector<double>{1}), std::invalid_argument);
+
+  Eigen::MatrixXd draws(2, 3);
+  draws << 1, 2, 3, 4, 5, 6;
+  base(draws);
+  EXPECT_EQ(2, writer.num_rows());
+  EXPECT_EQ(1, writer.num_dropped());
+  EXPECT_EQ(std::vector<double>({1, 2, 4, 5}), buffer);
+  EXPECT_THROW(writer.release(), std::logic_error);
+}
@@ -0,0 +1,24 @@
+#include <stan/callbacks/convergence_monitor_writer.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(StanCallbacksConvergenceMonitorWriter, forwards_draws) {
+  stan::analyze::online_convergence_monitor monitor(2, 3);
+  stan::callbacks::convergence_monitor_writer writer0(monitor, 0);
+  stan::callbacks::convergence_monitor_writer writer1(monitor, 1);
+
+  writer0(std::vector<std::string>{"lp__", "a", "b"});
+  EXPECT_THROW(writer0(std::vector<std::string>{"lp__"}),
+               std::invalid_argument);
+  writer0("Adaptation terminated");
+  writer0();
+  writer0(std::vector<double>{1, 2, 3});
+  Eigen::MatrixXd draws = Eigen::MatrixXd::Ones(3, 5);
+  writer1(draws);
+
+  EXPECT_EQ(1, monitor.num_draws(0));
+  EXPECT_EQ(5, monitor.num_draws(1));
+  EXPECT_THROW(writer0(std::vector<double>{1, 2}), std::invalid_argument);
+}
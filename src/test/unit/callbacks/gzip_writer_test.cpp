@@ -0,0 +1,84 @@
+#include <stan/callbacks/gzip_writer.hpp>
+#include <stan/io/gzip_istream.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::string decompress(const std::string& compressed) {
+  std::istringstream in(compressed);
+  stan::io::gzip_istream unzipped(in);
+  std::stringstream out;
+  out << unzipped.rdbuf();
+  return out.str();
+}
+}  // namespace
+
+TEST(gzipWriter, round_trip) {
+  std::stringstream sink;
+  {
+    stan::callbacks::gzip_ostream out(sink);
+    out << "lp__,theta" << std::endl << "-1.5,0.25" << std::endl;
+  }
+  EXPECT_NE("lp__,theta\n-1.5,0.25\n", sink.str());
+  EXPECT_EQ('\x1f', sink.str()[0]);
+  EXPECT_EQ("lp__,theta\n-1.5,0.25\n", decompress(sink.str()));
+}
+
+TEST(gzipWriter, many_members) {
+  std::stringstream sink;
+  std::stringstream expected;
+  {
+    stan::callbacks::gzip_streambuf buf(sink, 1, 100, 2);
+    std::ostream out(&buf);
+    for (int n = 0; n < 1000; ++n) {
+      out << n << ',' << 0.5 * n << '\n';
+      expected << n << ',' << 0.5 * n << '\n';
+    }
+    buf.close();
+    out << "dropped";
+    EXPECT_FALSE(out.good());
+  }
+  EXPECT_EQ(expected.str(), decompress(sink.str()));
+}
+
+TEST(gzipWriter, write_failure) {
+  std::stringstream sink;
+  sink.setstate(std::ios::badbit);
+  stan::callbacks::gzip_streambuf buf(sink, 1, 10);
+  std::ostream out(&buf);
+  out << "more than ten characters";
+  EXPECT_THROW(buf.close(), std::runtime_error);
+}
+
+TEST(gzipWriter, invalid_level) {
+  std::stringstream sink;
+  EXPECT_THROW(stan::callbacks::gzip_streambuf(sink, 42),
+               std::invalid_argument);
+}
+
+TEST(gzipWriter, stream_writer) {
+  std::stringstream sink;
+  {
+    stan::callbacks::gzip_stream_writer writer(
+        std::make_unique<stan::callbacks::gzip_ostream>(sink), "# ");
+    writer("comment");
+    writer(std::vector<std::string>{"a", "b"});
+    writer(std::vector<double>{1, 2.5});
+  }
+  EXPECT_EQ("# comment\na,b\n1,2.5\n", decompress(sink.str()));
+}
+
+TEST(gzipWriter, json_writer) {
+  std::stringstream sink;
+  {
+    stan::callbacks::gzip_json_writer writer(
+        std::make_unique<stan::callbacks::gzip_ostream>(sink));
+    writer.begin_record();
+    writer.write("x", 1.5);
+    writer.end_record();
+  }
+  EXPECT_EQ("\n{\n  \"x\" : 1.5\n}\n", decompress(sink.str()));
+}
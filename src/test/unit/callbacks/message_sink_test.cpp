@@ -0,0 +1,59 @@
+#include <stan/callbacks/message_sink.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+TEST(StanCallbacksMessageSink, starts_empty) {
+  stan::callbacks::message_sink msgs;
+  EXPECT_TRUE(msgs.empty());
+  EXPECT_EQ("", msgs.str());
+}
+
+TEST(StanCallbacksMessageSink, collects_messages) {
+  stan::callbacks::message_sink msgs;
+  std::ostream* o = &msgs;
+  *o << "x = " << 1.5 << ", n = " << 3 << '\n';
+  EXPECT_FALSE(msgs.empty());
+  EXPECT_EQ("x = 1.5, n = 3\n", msgs.str());
+}
+
+TEST(StanCallbacksMessageSink, clear_messages) {
+  stan::callbacks::message_sink msgs;
+  msgs << "message 1";
+  msgs.setstate(std::ios_base::badbit);
+  msgs.clear_messages();
+  EXPECT_TRUE(msgs.empty());
+  EXPECT_TRUE(msgs.good());
+  msgs << "message 2";
+  EXPECT_EQ("message 2", msgs.str());
+}
+
+TEST(StanCallbacksMessageSink, copy_is_empty) {
+  stan::callbacks::message_sink msgs;
+  msgs << "message";
+  stan::callbacks::message_sink copy(msgs);
+  EXPECT_TRUE(copy.empty());
+  copy << "copy";
+  EXPECT_EQ("message", msgs.str());
+  EXPECT_EQ("copy", copy.str());
+  copy = msgs;
+  EXPECT_EQ("copy", copy.str());
+}
+
+TEST(StanCallbacksMessageSink, flush_to) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::callbacks::message_sink msgs;
+
+  msgs.flush_to(logger);
+  EXPECT_EQ("", info.str());
+
+  msgs << "message";
+  msgs.flush_to(logger);
+  EXPECT_EQ("message\n", info.str());
+  EXPECT_TRUE(msgs.empty());
+
+  msgs.flush_to(logger);
+  EXPECT_EQ("message\n", info.str());
+}
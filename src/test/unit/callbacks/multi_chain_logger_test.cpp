@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stan/callbacks/multi_chain_logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+
+TEST(StanInterfaceCallbacksMultiChainLogger, batches) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::callbacks::multi_chain_logger chains(logger, 2, 3,
+                                             std::chrono::hours(1), 4);
+
+  // The first message of each chain is passed on as it arrives
+  chains.chain(0).info("zero");
+  chains.chain(1).info("zero");
+  EXPECT_EQ("Chain [4] zero\nChain [5] zero\n", info.str());
+  info.str("");
+
+  chains.chain(0).info("one");
+  chains.chain(1).warn("two");
+  chains.chain(0).debug("three");
+  EXPECT_EQ("", info.str() + warn.str() + debug.str());
+
+  // The third message fills the batch of the first chain
+  chains.chain(0).info("");
+  EXPECT_EQ("Chain [4] one\n\n", info.str());
+  EXPECT_EQ("Chain [4] three\n", debug.str());
+  EXPECT_EQ("", warn.str());
+
+  // Errors are passed on at once, with the messages logged before them
+  std::stringstream message;
+  message << "four";
+  chains.chain(1).error(message);
+  EXPECT_EQ("Chain [5] two\n", warn.str());
+  EXPECT_EQ("Chain [5] four\n", error.str());
+
+  chains.chain(1).info("five");
+  chains.chain(0).fatal("six");
+  EXPECT_EQ("Chain [4] six\n", fatal.str());
+  chains.flush();
+  EXPECT_EQ("Chain [4] one\n\nChain [5] five\n", info.str());
+}
+
+TEST(StanInterfaceCallbacksMultiChainLogger, threads) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  const int num_chains = 4;
+  const int num_messages = 1000;
+  {
+    stan::callbacks::multi_chain_logger chains(logger, num_chains, 16);
+    std::vector<std::thread> threads;
+    for (int n = 0; n < num_chains; ++n)
+      threads.emplace_back([&chains, n]() {
+        for (int i = 0; i < num_messages; ++i)
+          chains.chain(n).warn(std::to_string(i));
+      });
+    for (auto& thread : threads)
+      thread.join();
+  }
+
+  // The messages of each chain arrive whole and in order
+  std::vector<int> next(num_chains, 0);
+  std::string line;
+  int lines = 0;
+  while (std::getline(warn, line)) {
+    ++lines;
+    ASSERT_EQ("Chain [", line.substr(0, 7));
+    int chain = std::stoi(line.substr(7)) - 1;
+    ASSERT_EQ(std::to_string(next[chain]++),
+              line.substr(line.find("] ") + 2));
+  }
+  EXPECT_EQ(num_chains * num_messages, lines);
+}
+
+TEST(StanInterfaceCallbacksMultiChainLogger, flush_interval) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::callbacks::multi_chain_logger chains(logger, 1, 100,
+                                             std::chrono::milliseconds(0));
+  chains.chain(0).info("one");
+  chains.chain(0).info("Chain [1] Iteration: 1 / 2");
+  EXPECT_EQ("Chain [1] one\nChain [1] Iteration: 1 / 2\n", info.str());
+}
@@ -0,0 +1,124 @@
+#include <stan/callbacks/multi_chain_writer.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test {
+class throwing_writer : public stan::callbacks::writer {
+ public:
+  void operator()(const std::vector<double>& state) {
+    throw std::runtime_error("disk full");
+  }
+};
+
+// Records the calls it receives
+class recording_writer : public stan::callbacks::writer {
+ public:
+  void operator()(const std::vector<std::string>& names) {
+    header.push_back(names);
+  }
+
+  void operator()(const std::vector<double>& state) { rows.push_back(state); }
+
+  void operator()(const std::string& message) { messages.push_back(message); }
+
+  void operator()(const Eigen::Ref<Eigen::Matrix<double, -1, -1>>& values) {
+    matrices.push_back(values);
+  }
+
+  std::vector<std::vector<std::string>> header;
+  std::vector<std::vector<double>> rows;
+  std::vector<std::string> messages;
+  std::vector<Eigen::MatrixXd> matrices;
+};
+
+// Writes the output of a chain
+void write_chain(stan::callbacks::writer& writer, int num_draws) {
+  writer(std::vector<std::string>{"lp__", "theta"});
+  writer("Adaptation terminated");
+  for (int n = 0; n < num_draws; ++n)
+    writer(std::vector<double>{-0.5 * n, n + 0.125});
+}
+}  // namespace test
+
+TEST(StanCallbacksMultiChainWriter, gathers_chains) {
+  const int num_chains = 4;
+  const int num_draws = 300;
+  test::recording_writer sink;
+  {
+    stan::callbacks::multi_chain_writer writer(sink, num_chains, 8);
+    EXPECT_EQ(num_chains, writer.num_chains());
+    std::vector<std::thread> threads;
+    for (int n = 0; n < num_chains; ++n)
+      threads.emplace_back([&writer, n, num_draws] {
+        test::write_chain(writer.chain(n), num_draws);
+      });
+    for (auto& thread : threads)
+      thread.join();
+    writer.flush();
+    EXPECT_EQ(num_chains * num_draws, sink.rows.size());
+  }
+
+  ASSERT_EQ(1, sink.header.size());
+  EXPECT_EQ(std::vector<std::string>({"chain", "lp__", "theta"}),
+            sink.header[0]);
+  ASSERT_EQ(num_chains, sink.messages.size());
+  for (int n = 1; n <= num_chains; ++n)
+    EXPECT_EQ(1, std::count(sink.messages.begin(), sink.messages.end(),
+                            "Chain " + std::to_string(n)
+                                + ": Adaptation terminated"));
+
+  // The draws of each chain keep their order
+  std::vector<int> next_draw(num_chains, 0);
+  for (const auto& row : sink.rows) {
+    ASSERT_EQ(3, row.size());
+    int chain = static_cast<int>(row[0]) - 1;
+    ASSERT_GE(chain, 0);
+    ASSERT_LT(chain, num_chains);
+    EXPECT_FLOAT_EQ(next_draw[chain] + 0.125, row[2]);
+    ++next_draw[chain];
+  }
+  for (int n = 0; n < num_chains; ++n)
+    EXPECT_EQ(num_draws, next_draw[n]);
+}
+
+TEST(StanCallbacksMultiChainWriter, chain_ids_and_matrices) {
+  std::stringstream out;
+  stan::callbacks::stream_writer stream_sink(out);
+  test::recording_writer sink;
+  {
+    stan::callbacks::multi_chain_writer stream_writer(stream_sink, 2, 1, 5);
+    stan::callbacks::multi_chain_writer writer(sink, 2, 1, 5);
+    for (auto* w : {&stream_writer, &writer}) {
+      w->chain(1)(std::vector<std::string>{"x"});
+      w->chain(1)(std::vector<double>{1.5});
+      w->flush();
+      w->chain(0)(std::vector<std::string>{"x"});
+      w->chain(0)();
+      w->chain(0)(std::vector<double>{2.5});
+    }
+    Eigen::MatrixXd values(1, 2);
+    values << 2, 3;
+    writer.chain(0)(values);
+  }
+  EXPECT_EQ("chain,x\n6,1.5\n\n5,2.5\n", out.str());
+
+  ASSERT_EQ(1, sink.matrices.size());
+  Eigen::MatrixXd expected(2, 2);
+  expected << 5, 5, 2, 3;
+  EXPECT_EQ(expected, sink.matrices[0]);
+}
+
+TEST(StanCallbacksMultiChainWriter, rethrows_sink_errors) {
+  test::throwing_writer sink;
+  stan::callbacks::multi_chain_writer writer(sink, 2);
+  std::vector<double> state{1, 2};
+  writer.chain(0)(state);
+  EXPECT_THROW(writer.flush(), std::runtime_error);
+  EXPECT_THROW(writer.chain(1)(state), std::runtime_error);
+}
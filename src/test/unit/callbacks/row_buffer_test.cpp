@@ -0,0 +1,91 @@
+#include <stan/callbacks/row_buffer.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<double> test_values() {
+  return {0,
+          -0.0,
+          1,
+          0.1,
+          1.0 / 3,
+          123456789.123,
+          1e-300,
+          1e300,
+          -2.5e-7,
+          5e-324,
+          999999.5,
+          std::numeric_limits<double>::infinity(),
+          -std::numeric_limits<double>::infinity(),
+          std::numeric_limits<double>::quiet_NaN()};
+}
+
+// Formats the values directly and through a row buffer taking the
+// formatting state of the stream
+void expect_same_format(std::stringstream& format) {
+  std::stringstream direct;
+  direct.copyfmt(format);
+  stan::callbacks::internal::row_buffer row;
+  row.reset(format);
+  for (double x : test_values()) {
+    direct << x << ',';
+    row << x << ',';
+  }
+  direct << -42 << ' ' << "end";
+  row << -42 << ' ' << "end";
+  EXPECT_EQ(direct.str(), row.str());
+}
+}  // namespace
+
+TEST(StanCallbacksRowBuffer, matches_stream_formatting) {
+  const std::ios_base::fmtflags all
+      = std::ios_base::floatfield | std::ios_base::showpoint
+        | std::ios_base::showpos | std::ios_base::uppercase;
+  for (int precision : {0, 1, 3, 6, 9, 17, 25}) {
+    for (std::ios_base::fmtflags flags :
+         {std::ios_base::fmtflags(), std::ios_base::fmtflags(std::ios::fixed),
+          std::ios_base::fmtflags(std::ios::scientific),
+          std::ios_base::fmtflags(std::ios::floatfield),
+          std::ios_base::fmtflags(std::ios::showpoint),
+          std::ios_base::fmtflags(std::ios::showpos),
+          std::ios_base::fmtflags(std::ios::uppercase)}) {
+      std::stringstream format;
+      format.precision(precision);
+      format.setf(flags, all);
+      expect_same_format(format);
+    }
+  }
+  std::stringstream hex;
+  hex << std::hex;
+  expect_same_format(hex);
+}
+
+TEST(StanCallbacksRowBuffer, write_to) {
+  std::stringstream out;
+  out << std::setprecision(3);
+  stan::callbacks::internal::row_buffer row;
+  row.reset(out);
+  row << 1.0 / 3 << ',' << 2;
+  row.write_to(out);
+  EXPECT_EQ("0.333,2", out.str());
+
+  row.clear();
+  EXPECT_EQ("", row.str());
+  row << 0.25;
+  std::string generic;
+  struct string_stream {
+    std::string& s;
+    string_stream& operator<<(const std::string& x) {
+      s += x;
+      return *this;
+    }
+  } generic_out{generic};
+  row.write_to(generic_out);
+  EXPECT_EQ("0.25", generic);
+}
@@ -28,6 +28,19 @@ TEST_F(StanInterfaceCallbacksStreamWriter, double_vector) {
   EXPECT_EQ("0,1,2,3,4\n", ss.str());
 }
 
+TEST_F(StanInterfaceCallbacksStreamWriter, double_segments) {
+  std::vector<double> x{0, 1};
+  std::vector<double> empty;
+  Eigen::VectorXd y(3);
+  y << 2, 3, 4;
+
+  EXPECT_NO_THROW(writer({x, empty, y}));
+  EXPECT_EQ("0,1,2,3,4\n", ss.str());
+  ss.str(std::string());
+  EXPECT_NO_THROW(writer({empty}));
+  EXPECT_EQ("", ss.str());
+}
+
 TEST_F(StanInterfaceCallbacksStreamWriter, string_vector) {
   const int N = 5;
   std::vector<std::string> x;
@@ -0,0 +1,144 @@
+#include <stan/callbacks/structured_binary_writer.hpp>
+#include <stan/io/structured_binary_reader.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <complex>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+class StanInterfaceCallbacksStructuredBinaryWriter : public ::testing::Test {
+ public:
+  StanInterfaceCallbacksStructuredBinaryWriter()
+      : ss(), writer(std::unique_ptr<std::stringstream, deleter_noop>(&ss)) {}
+
+  stan::io::structured_value read() {
+    std::stringstream in(ss.str());
+    return stan::io::structured_binary_reader::parse(in);
+  }
+
+  std::stringstream ss;
+  stan::callbacks::structured_binary_writer<std::stringstream, deleter_noop>
+      writer;
+};
+
+using item_type = stan::io::structured_binary_format::item_type;
+
+TEST_F(StanInterfaceCallbacksStructuredBinaryWriter, nested_records) {
+  writer.begin_record();
+  writer.begin_record("1");
+  writer.write("key", "value");
+  writer.end_record();
+  writer.begin_record("2");
+  writer.write("dummy");
+  writer.end_record();
+  writer.end_record();
+
+  stan::io::structured_value root = read();
+  ASSERT_EQ(1, root.items.size());
+  const auto& record = root.items[0];
+  EXPECT_TRUE(record.is_record());
+  EXPECT_EQ("", record.key);
+  ASSERT_EQ(2, record.items.size());
+  EXPECT_EQ("value", record["1"]["key"].string_value);
+  EXPECT_EQ(item_type::null_value, record["2"]["dummy"].type);
+  EXPECT_THROW(record["3"], std::out_of_range);
+}
+
+TEST_F(StanInterfaceCallbacksStructuredBinaryWriter, scalars) {
+  writer.begin_record();
+  writer.write("string", std::string("a \"quoted\"\nstring"));
+  writer.write("true", true);
+  writer.write("false", false);
+  writer.write("int", -3);
+  writer.write("size_t", std::numeric_limits<std::size_t>::max());
+  writer.write("long long", -1234567890123LL);
+  writer.write("unsigned", 7u);
+  writer.write("double", 0.1);
+  writer.write("inf", -std::numeric_limits<double>::infinity());
+  writer.write("complex", std::complex<double>(1.5, -2.5));
+  writer.end_record();
+
+  stan::io::structured_value record = read().items[0];
+  EXPECT_EQ("a \"quoted\"\nstring", record["string"].string_value);
+  EXPECT_TRUE(record["true"].bool_value);
+  EXPECT_FALSE(record["false"].bool_value);
+  EXPECT_EQ(-3, record["int"].int_value);
+  EXPECT_EQ(std::numeric_limits<std::size_t>::max(),
+            record["size_t"].uint_value);
+  EXPECT_EQ(-1234567890123LL, record["long long"].int_value);
+  EXPECT_EQ(7u, record["unsigned"].uint_value);
+  // Doubles are kept exactly
+  EXPECT_EQ(0.1, record["double"].real_value);
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(),
+            record["inf"].real_value);
+  EXPECT_EQ(std::complex<double>(1.5, -2.5), record["complex"].complex_value);
+}
+
+TEST_F(StanInterfaceCallbacksStructuredBinaryWriter, arrays) {
+  std::vector<double> reals{1.0, 1.0 / 3, std::nan("")};
+  std::vector<int> ints{-1, 0, 2147483647};
+  std::vector<std::string> strings{"a", "", "c"};
+  std::vector<std::complex<double>> complexes{{1, 2}, {-3, 4}};
+  writer.begin_record();
+  writer.write("reals", reals);
+  writer.write("empty", std::vector<double>{});
+  writer.write("ints", ints);
+  writer.write("strings", strings);
+  writer.write("complexes", complexes);
+  writer.end_record();
+
+  stan::io::structured_value record = read().items[0];
+  ASSERT_EQ(3, record["reals"].reals.size());
+  EXPECT_EQ(reals[0], record["reals"].reals(0));
+  EXPECT_EQ(reals[1], record["reals"].reals(1));
+  EXPECT_TRUE(std::isnan(record["reals"].reals(2)));
+  EXPECT_EQ(0, record["empty"].reals.size());
+  EXPECT_EQ(ints, record["ints"].ints);
+  EXPECT_EQ(strings, record["strings"].strings);
+  EXPECT_EQ(complexes, record["complexes"].complexes);
+}
+
+TEST_F(StanInterfaceCallbacksStructuredBinaryWriter, eigen) {
+  Eigen::VectorXd vec = Eigen::VectorXd::LinSpaced(4, 0, 3);
+  Eigen::RowVectorXd row_vec = Eigen::RowVectorXd::LinSpaced(3, 1, 2);
+  Eigen::MatrixXd mat = Eigen::MatrixXd::Random(3, 5);
+  writer.begin_record("outputs");
+  writer.write("vector", vec);
+  writer.write("row_vector", row_vec);
+  writer.write("matrix", mat);
+  writer.end_record();
+
+  stan::io::structured_value record = read()["outputs"];
+  EXPECT_EQ(item_type::vector, record["vector"].type);
+  EXPECT_MATRIX_EQ(vec, record["vector"].reals);
+  EXPECT_EQ(item_type::row_vector, record["row_vector"].type);
+  EXPECT_MATRIX_EQ(row_vec, record["row_vector"].reals);
+  EXPECT_EQ(item_type::matrix, record["matrix"].type);
+  EXPECT_MATRIX_EQ(mat, record["matrix"].reals);
+}
+
+TEST_F(StanInterfaceCallbacksStructuredBinaryWriter, matrix_size) {
+  Eigen::MatrixXd mat = Eigen::MatrixXd::Random(100, 100);
+  writer.begin_record();
+  writer.write("hessian", mat);
+  writer.end_record();
+  // The matrix costs its raw bytes, plus the tag, the item type, the
+  // key, the dimensions and the record
+  EXPECT_EQ(4 + (1 + 4) + (1 + 4 + 7 + 16 + 8 * 100 * 100) + 1,
+            ss.str().size());
+}
+
+TEST(StanInterfaceCallbacksStructuredBinaryWriterNoop, noop) {
+  stan::callbacks::structured_binary_writer<std::stringstream> writer;
+  writer.begin_record();
+  writer.write("key", 1.0);
+  writer.write("matrix", Eigen::MatrixXd::Zero(2, 2).eval());
+  writer.end_record();
+}
@@ -43,6 +43,15 @@ TEST_F(StanCallbacksTeeWriter, state) {
   EXPECT_EQ(1, writer2.N);
 }
 
+TEST_F(StanCallbacksTeeWriter, segments) {
+  std::vector<double> x{1, 2};
+  std::vector<double> y{3};
+
+  tee_writer({x, y});
+  EXPECT_EQ(1, writer1.N);
+  EXPECT_EQ(1, writer2.N);
+}
+
 TEST_F(StanCallbacksTeeWriter, message) {
   tee_writer("message");
   EXPECT_EQ(1, writer1.N);
@@ -0,0 +1,39 @@
+#include <stan/callbacks/timed_interrupt.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+TEST(StanCallbacksTimedInterrupt, forwards_first_call) {
+  stan::test::unit::instrumented_interrupt wrapped;
+  stan::callbacks::timed_interrupt interrupt(wrapped, std::chrono::hours(1));
+
+  interrupt();
+  EXPECT_EQ(1, wrapped.call_count());
+  for (int i = 0; i < 100000; ++i)
+    interrupt();
+  EXPECT_EQ(1, wrapped.call_count());
+}
+
+TEST(StanCallbacksTimedInterrupt, forwards_after_interval) {
+  stan::test::unit::instrumented_interrupt wrapped;
+  stan::callbacks::timed_interrupt interrupt(wrapped,
+                                             std::chrono::milliseconds(5));
+
+  interrupt();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  // The clock is read every other call after the quick first one
+  interrupt();
+  interrupt();
+  EXPECT_EQ(2, wrapped.call_count());
+}
+
+TEST(StanCallbacksTimedInterrupt, zero_interval_forwards_every_call) {
+  stan::test::unit::instrumented_interrupt wrapped;
+  stan::callbacks::timed_interrupt interrupt(wrapped,
+                                             std::chrono::nanoseconds(0));
+
+  for (int i = 0; i < 10; ++i)
+    interrupt();
+  EXPECT_EQ(10, wrapped.call_count());
+}
@@ -31,6 +31,14 @@ TEST_F(StanInterfaceCallbacksStreamWriter, double_vector) {
   EXPECT_EQ("0,1,2,3,4\n", ss.str());
 }
 
+TEST_F(StanInterfaceCallbacksStreamWriter, double_segments) {
+  std::vector<double> x{0, 1, 2};
+  std::vector<double> y{3, 4};
+
+  EXPECT_NO_THROW(writer({x, y}));
+  EXPECT_EQ("0,1,2,3,4\n", ss.str());
+}
+
 TEST_F(StanInterfaceCallbacksStreamWriter, double_vector_precision2) {
   ss << std::setprecision(2);
   const int N = 5;
@@ -29,6 +29,12 @@ TEST_F(StanInterfaceCallbacksWriter, string_vector) {
 
 TEST_F(StanInterfaceCallbacksWriter, null) { EXPECT_NO_THROW(writer()); }
 
+TEST_F(StanInterfaceCallbacksWriter, double_segments) {
+  std::vector<double> x{1, 2};
+  std::vector<double> y{3};
+  EXPECT_NO_THROW(writer({x, y}));
+}
+
 TEST_F(StanInterfaceCallbacksWriter, string) {
   EXPECT_NO_THROW(writer("message"));
 }
@@ -0,0 +1,32 @@
+#include <stan/io/aligned_vector.hpp>
+#include <stan/io/values_view.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(ioAlignedVector, aligned) {
+  for (size_t n : {1, 3, 8, 9, 1000}) {
+    stan::io::aligned_vector<double> x(n, 1.5);
+    EXPECT_TRUE(stan::io::is_data_aligned(x.data()));
+    stan::io::aligned_vector<int> y(n, 2);
+    EXPECT_TRUE(stan::io::is_data_aligned(y.data()));
+    y.push_back(3);
+    EXPECT_TRUE(stan::io::is_data_aligned(y.data()));
+    EXPECT_EQ(3, y.back());
+  }
+  stan::io::aligned_vector<char> c(1, 'a');
+  EXPECT_TRUE(stan::io::is_data_aligned(c.data()));
+}
+
+TEST(ioAlignedVector, values_view_owns_aligned_copy) {
+  std::vector<double> values{1.0, 2.0, 3.0};
+  stan::io::values_view<double> copied{std::vector<double>(values)};
+  EXPECT_TRUE(copied.owns_values());
+  EXPECT_TRUE(copied.is_aligned());
+  EXPECT_EQ(values, copied.to_vector());
+
+  stan::io::aligned_vector<double> stored(values.begin(), values.end());
+  stan::io::values_view<double> view(stored);
+  EXPECT_FALSE(view.owns_values());
+  EXPECT_EQ(stored.data(), view.data());
+  EXPECT_TRUE(view.is_aligned());
+}
@@ -307,3 +307,48 @@ TEST(array_var_context, ctor_complex) {
   std::vector<std::complex<double>> eta;
   EXPECT_EQ(eta, avc.vals_c("eta"));
 }
+
+TEST(array_var_context, vals_views) {
+  std::vector<std::string> names_r{"alpha", "beta"};
+  std::vector<double> v_r{1.5, 2.5, 3.5, 4.5};
+  std::vector<std::vector<size_t>> dims_r{{}, {3}};
+  std::vector<std::string> names_i{"gamma"};
+  std::vector<int> v_i{7, 8};
+  std::vector<std::vector<size_t>> dims_i{{2}};
+  stan::io::array_var_context avc(names_r, v_r, dims_r, names_i, v_i,
+                                  dims_i);
+
+  stan::io::values_view<double> beta = avc.vals_r_view("beta");
+  EXPECT_FALSE(beta.owns_values());
+  EXPECT_EQ(beta.to_vector(), avc.vals_r("beta"));
+
+  stan::io::values_view<int> gamma_i = avc.vals_i_view("gamma");
+  EXPECT_FALSE(gamma_i.owns_values());
+  EXPECT_EQ(gamma_i.to_vector(), avc.vals_i("gamma"));
+
+  stan::io::values_view<double> gamma_r = avc.vals_r_view("gamma");
+  EXPECT_TRUE(gamma_r.owns_values());
+  EXPECT_EQ(gamma_r.to_vector(), avc.vals_r("gamma"));
+  EXPECT_TRUE(beta.is_aligned());
+  EXPECT_TRUE(gamma_i.is_aligned());
+
+  EXPECT_TRUE(avc.vals_r_view("delta").empty());
+  EXPECT_TRUE(avc.vals_i_view("alpha").empty());
+}
+
+TEST(array_var_context, names) {
+  std::vector<std::string> names_r{"alpha", "beta"};
+  std::vector<double> v_r{1.5, 2.5};
+  std::vector<std::vector<size_t>> dims_r{{}, {}};
+  std::vector<std::string> names_i{"gamma"};
+  std::vector<int> v_i{7};
+  std::vector<std::vector<size_t>> dims_i{{}};
+  stan::io::array_var_context avc(names_r, v_r, dims_r, names_i, v_i,
+                                  dims_i);
+
+  std::vector<std::string> names;
+  avc.names_r(names);
+  EXPECT_EQ(names_r, names);
+  avc.names_i(names);
+  EXPECT_EQ(names_i, names);
+}
@@ -0,0 +1,151 @@
+#include <stan/io/binary_var_context.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+stan::io::array_var_context make_context() {
+  std::vector<std::string> names_r{"a", "b", "z"};
+  std::vector<double> values_r{1.5, 2.5, 3.5, -1, -2, -3, -4, 0.25, 0.5};
+  std::vector<std::vector<size_t>> dims_r{{3}, {2, 2}, {1, 2}};
+  std::vector<std::string> names_i{"n", "x.1"};
+  std::vector<int> values_i{7, 1, 2, 3};
+  std::vector<std::vector<size_t>> dims_i{{}, {3}};
+  return stan::io::array_var_context(names_r, values_r, dims_r, names_i,
+                                     values_i, dims_i);
+}
+
+// Returns the bytes in a buffer aligned for the values
+std::vector<double> to_buffer(const std::string& bytes) {
+  std::vector<double> buffer((bytes.size() + 7) / 8);
+  std::memcpy(buffer.data(), bytes.data(), bytes.size());
+  return buffer;
+}
+
+std::string binary_data() {
+  std::stringstream out;
+  stan::io::write_binary_data(out, make_context());
+  return out.str();
+}
+
+void expect_same_context(const stan::io::var_context& expected,
+                         const stan::io::var_context& found) {
+  std::vector<std::string> names_i;
+  std::vector<std::string> names_r;
+  found.names_i(names_i);
+  found.names_r(names_r);
+  EXPECT_EQ(std::vector<std::string>({"n", "x.1"}), names_i);
+  EXPECT_EQ(std::vector<std::string>({"a", "b", "z"}), names_r);
+  for (const auto& name : names_i) {
+    EXPECT_TRUE(found.contains_i(name));
+    EXPECT_EQ(expected.vals_i(name), found.vals_i(name));
+    EXPECT_EQ(expected.dims_i(name), found.dims_i(name));
+  }
+  for (const auto& name : names_r) {
+    EXPECT_TRUE(found.contains_r(name));
+    EXPECT_FALSE(found.contains_i(name));
+    EXPECT_EQ(expected.vals_r(name), found.vals_r(name));
+    EXPECT_EQ(expected.dims_r(name), found.dims_r(name));
+  }
+}
+}  // namespace
+
+TEST(binaryVarContext, buffer) {
+  std::string bytes = binary_data();
+  EXPECT_EQ(0, bytes.size() % 8);
+  std::vector<double> buffer = to_buffer(bytes);
+  stan::io::binary_var_context context(
+      reinterpret_cast<const char*>(buffer.data()), bytes.size());
+  expect_same_context(make_context(), context);
+
+  EXPECT_EQ(std::vector<double>({7}), context.vals_r("n"));
+  EXPECT_EQ(std::vector<size_t>({3}), context.dims_r("x.1"));
+  EXPECT_FALSE(context.contains_r("y"));
+  EXPECT_TRUE(context.vals_r("y").empty());
+  EXPECT_TRUE(context.dims_r("y").empty());
+  EXPECT_TRUE(context.vals_i("a").empty());
+  EXPECT_TRUE(context.dims_i("a").empty());
+
+  std::vector<std::complex<double>> z = context.vals_c("z");
+  ASSERT_EQ(1, z.size());
+  EXPECT_EQ(std::complex<double>(0.25, 0.5), z[0]);
+
+  EXPECT_NO_THROW(context.validate_dims("data", "b", "double", {2, 2}));
+  EXPECT_THROW(context.validate_dims("data", "b", "int", {2, 2}),
+               std::runtime_error);
+  EXPECT_THROW(context.validate_dims("data", "b", "double", {4}),
+               std::runtime_error);
+}
+
+TEST(binaryVarContext, views) {
+  std::string bytes = binary_data();
+  std::vector<double> buffer = to_buffer(bytes);
+  const char* data = reinterpret_cast<const char*>(buffer.data());
+  stan::io::binary_var_context context(data, bytes.size());
+
+  stan::io::values_view<double> b = context.vals_r_view("b");
+  EXPECT_FALSE(b.owns_values());
+  EXPECT_GE(reinterpret_cast<const char*>(b.data()), data);
+  EXPECT_LT(reinterpret_cast<const char*>(b.data()), data + bytes.size());
+  EXPECT_EQ(context.vals_r("b"), b.to_vector());
+
+  stan::io::values_view<int> x = context.vals_i_view("x.1");
+  EXPECT_FALSE(x.owns_values());
+  EXPECT_EQ(context.vals_i("x.1"), x.to_vector());
+
+  stan::io::values_view<double> x_r = context.vals_r_view("x.1");
+  EXPECT_TRUE(x_r.owns_values());
+  EXPECT_EQ(context.vals_r("x.1"), x_r.to_vector());
+  EXPECT_TRUE(context.vals_i_view("b").empty());
+}
+
+TEST(binaryVarContext, file) {
+  const char* file_name = "binary_var_context_test.bin";
+  {
+    std::ofstream out(file_name, std::ios::binary);
+    stan::io::write_binary_data(out, make_context());
+  }
+  {
+    stan::io::binary_var_context context(file_name);
+    expect_same_context(make_context(), context);
+  }
+  std::remove(file_name);
+  EXPECT_THROW(stan::io::binary_var_context context(file_name),
+               std::invalid_argument);
+}
+
+TEST(binaryVarContext, ill_formed) {
+  std::string bytes = binary_data();
+  auto read = [](const std::string& bytes) {
+    std::vector<double> buffer = to_buffer(bytes);
+    stan::io::binary_var_context context(
+        reinterpret_cast<const char*>(buffer.data()), bytes.size());
+  };
+  EXPECT_NO_THROW(read(bytes));
+  EXPECT_THROW(read(""), std::invalid_argument);
+  EXPECT_THROW(read("SBH1"), std::invalid_argument);
+  EXPECT_THROW(read(bytes.substr(0, 30)), std::invalid_argument);
+  EXPECT_THROW(read(bytes.substr(0, bytes.size() - 8)), std::invalid_argument);
+
+  // The header of the first variable, "a", starts at byte 8: name
+  // length, name, type, number of dimensions, dimension and offset
+  std::string bad_type = bytes;
+  bad_type[13] = 2;
+  EXPECT_THROW(read(bad_type), std::invalid_argument);
+  std::string misaligned = bytes;
+  misaligned[29] += 4;
+  EXPECT_THROW(read(misaligned), std::invalid_argument);
+
+  std::vector<double> buffer = to_buffer(bytes);
+  EXPECT_THROW(stan::io::binary_var_context(
+                   reinterpret_cast<const char*>(buffer.data()) + 4,
+                   bytes.size() - 4),
+               std::invalid_argument);
+}
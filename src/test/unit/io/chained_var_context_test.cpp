@@ -1,6 +1,28 @@
 #include <stan/io/chained_var_context.hpp>
 #include <stan/io/array_var_context.hpp>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+// Context counting the calls to its contains methods
+class counting_var_context : public stan::io::array_var_context {
+ public:
+  using stan::io::array_var_context::array_var_context;
+
+  bool contains_r(const std::string& name) const {
+    ++num_contains;
+    return stan::io::array_var_context::contains_r(name);
+  }
+
+  bool contains_i(const std::string& name) const {
+    ++num_contains;
+    return stan::io::array_var_context::contains_i(name);
+  }
+
+  mutable int num_contains = 0;
+};
+}  // namespace
 
 TEST(chained_var_context, ctor) {
   std::vector<double> v;
@@ -53,3 +75,50 @@ TEST(chained_var_context, ctor) {
   std::vector<double> alpha(1, 0);
   EXPECT_EQ(alpha, vcc.vals_r("alpha"));
 }
+
+TEST(chained_var_context, resolved_lookup) {
+  counting_var_context vc1(std::vector<std::string>{"a", "b"},
+                           std::vector<double>{1, 2, 3},
+                           std::vector<std::vector<size_t>>{{}, {2}},
+                           std::vector<std::string>{"n"}, std::vector<int>{4},
+                           std::vector<std::vector<size_t>>{{}});
+  counting_var_context vc2(std::vector<std::string>{"a", "m"},
+                           std::vector<double>{10, 20},
+                           std::vector<std::vector<size_t>>{{}, {}},
+                           std::vector<std::string>{"b", "k"},
+                           std::vector<int>{5, 6, 7},
+                           std::vector<std::vector<size_t>>{{2}, {}});
+  stan::io::chained_var_context vcc(vc1, vc2);
+
+  // the first context takes precedence
+  EXPECT_EQ(&vc1, &vcc.resolve_r("a"));
+  EXPECT_EQ(&vc1, &vcc.resolve_r("b"));
+  EXPECT_EQ(&vc1, &vcc.resolve_r("n"));
+  EXPECT_EQ(&vc2, &vcc.resolve_r("m"));
+  EXPECT_EQ(&vc2, &vcc.resolve_r("k"));
+  EXPECT_EQ(&vc1, &vcc.resolve_i("n"));
+  EXPECT_EQ(&vc2, &vcc.resolve_i("b"));
+
+  EXPECT_EQ(std::vector<double>({1}), vcc.vals_r("a"));
+  EXPECT_EQ(std::vector<double>({2, 3}), vcc.vals_r("b"));
+  EXPECT_EQ(std::vector<double>({20}), vcc.vals_r("m"));
+  EXPECT_EQ(std::vector<int>({4}), vcc.vals_i("n"));
+  EXPECT_EQ(std::vector<int>({7}), vcc.vals_i("k"));
+  EXPECT_EQ(std::vector<size_t>({2}), vcc.dims_r("b"));
+  // integer b of the second context, not real b of the first
+  EXPECT_EQ(std::vector<int>({5, 6}), vcc.vals_i("b"));
+  EXPECT_EQ(std::vector<size_t>({2}), vcc.dims_i("b"));
+  EXPECT_TRUE(vcc.contains_i("b"));
+  EXPECT_TRUE(vcc.contains_r("k"));
+
+  // views refer to the values of the resolved context
+  EXPECT_EQ(vc1.vals_r_view("b").data(), vcc.vals_r_view("b").data());
+
+  // listed variables are found without asking the contexts
+  EXPECT_EQ(0, vc1.num_contains);
+  EXPECT_EQ(0, vc2.num_contains);
+
+  EXPECT_FALSE(vcc.contains_r("z"));
+  EXPECT_TRUE(vcc.vals_r("z").empty());
+  EXPECT_LT(0, vc1.num_contains);
+}
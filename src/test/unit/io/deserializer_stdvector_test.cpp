@@ -425,3 +425,80 @@ TEST(deserializer_array, corr_matrix) {
     EXPECT_FLOAT_EQ(lp_ref, lp);
   }
 }
+
+// batched
+
+TEST(deserializer_array, read_constrain_batch) {
+  std::vector<int> theta_i;
+  std::vector<double> theta;
+  for (int i = 0; i < 40; ++i)
+    theta.push_back(std::sin(i) * 2);
+  double lp = 0;
+  double lp_batch = 0;
+  {
+    stan::io::deserializer<double> deserializer(theta, theta_i);
+    stan::io::deserializer<double> batch(theta, theta_i);
+    auto x = deserializer.read_constrain_unit_vector<
+        std::vector<Eigen::VectorXd>, true>(lp, 3, 4);
+    Eigen::MatrixXd x_batch
+        = batch.read_constrain_unit_vector_batch<Eigen::MatrixXd, true>(
+            lp_batch, 3, 4);
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_TRUE(x[i] == x_batch.col(i));
+    EXPECT_EQ(deserializer.available(), batch.available());
+  }
+  {
+    stan::io::deserializer<double> deserializer(theta, theta_i);
+    stan::io::deserializer<double> batch(theta, theta_i);
+    auto x = deserializer.read_constrain_simplex<std::vector<Eigen::VectorXd>,
+                                                 true>(lp, 5, 3);
+    Eigen::MatrixXd x_batch
+        = batch.read_constrain_simplex_batch<Eigen::MatrixXd, true>(lp_batch,
+                                                                    5, 3);
+    EXPECT_EQ(3, x_batch.rows());
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_TRUE(x[i] == x_batch.col(i));
+    EXPECT_EQ(deserializer.available(), batch.available());
+  }
+  {
+    stan::io::deserializer<double> deserializer(theta, theta_i);
+    stan::io::deserializer<double> batch(theta, theta_i);
+    auto x = deserializer.read_constrain_ordered<std::vector<Eigen::VectorXd>,
+                                                 true>(lp, 4, 3);
+    Eigen::MatrixXd x_batch
+        = batch.read_constrain_ordered_batch<Eigen::MatrixXd, true>(lp_batch,
+                                                                    4, 3);
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_TRUE(x[i] == x_batch.col(i));
+    EXPECT_EQ(deserializer.available(), batch.available());
+  }
+  {
+    stan::io::deserializer<double> deserializer(theta, theta_i);
+    stan::io::deserializer<double> batch(theta, theta_i);
+    auto x = deserializer.read_constrain_cholesky_factor_corr<
+        std::vector<Eigen::MatrixXd>, true>(lp, 3, 4);
+    Eigen::MatrixXd x_batch
+        = batch.read_constrain_cholesky_factor_corr_batch<Eigen::MatrixXd,
+                                                          true>(lp_batch, 3,
+                                                                4);
+    EXPECT_EQ(4, x_batch.rows());
+    EXPECT_EQ(12, x_batch.cols());
+    for (size_t i = 0; i < x.size(); ++i)
+      EXPECT_TRUE(x[i] == x_batch.middleCols(i * 4, 4));
+    EXPECT_EQ(deserializer.available(), batch.available());
+  }
+  EXPECT_FLOAT_EQ(lp, lp_batch);
+
+  stan::io::deserializer<double> deserializer(theta, theta_i);
+  Eigen::MatrixXd x
+      = deserializer.read_constrain_simplex_batch<Eigen::MatrixXd, false>(
+          lp, 2, 1);
+  EXPECT_EQ(1, x.rows());
+  EXPECT_EQ(2, x.cols());
+  EXPECT_FLOAT_EQ(1.0, x(0, 1));
+  EXPECT_EQ(40U, deserializer.available());
+  EXPECT_THROW(
+      (deserializer.read_constrain_simplex_batch<Eigen::MatrixXd, false>(lp, 2,
+                                                                         0)),
+      std::domain_error);
+}
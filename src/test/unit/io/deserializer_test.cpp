@@ -277,6 +277,62 @@ TEST(deserializer_array, read_vector) {
   EXPECT_FLOAT_EQ(8.0, z);
 }
 
+TEST(deserializer, read_block) {
+  std::vector<int> theta_i{1, 2, 3};
+  std::vector<double> theta;
+  for (size_t i = 0; i < 20U; ++i)
+    theta.push_back(static_cast<double>(i));
+  stan::io::deserializer<double> deserializer(theta, theta_i);
+
+  std::array<double, 3> x = deserializer.read_block<double, 3>();
+  EXPECT_FLOAT_EQ(0.0, x[0]);
+  EXPECT_FLOAT_EQ(1.0, x[1]);
+  EXPECT_FLOAT_EQ(2.0, x[2]);
+
+  std::array<std::complex<double>, 2> z
+      = deserializer.read_block<std::complex<double>, 2>();
+  EXPECT_EQ(std::complex<double>(3.0, 4.0), z[0]);
+  EXPECT_EQ(std::complex<double>(5.0, 6.0), z[1]);
+
+  auto v = deserializer.read_block<Eigen::VectorXd, 2>(2);
+  EXPECT_EQ(2, v.size());
+  EXPECT_FLOAT_EQ(7.0, v[0](0));
+  EXPECT_FLOAT_EQ(8.0, v[0](1));
+  EXPECT_FLOAT_EQ(9.0, v[1](0));
+  EXPECT_FLOAT_EQ(10.0, v[1](1));
+
+  auto m = deserializer.read_block<Eigen::MatrixXd, 2>(2, 2);
+  EXPECT_FLOAT_EQ(11.0, m[0](0, 0));
+  EXPECT_FLOAT_EQ(12.0, m[0](1, 0));
+  EXPECT_FLOAT_EQ(14.0, m[0](1, 1));
+  EXPECT_FLOAT_EQ(15.0, m[1](0, 0));
+  EXPECT_FLOAT_EQ(18.0, m[1](1, 1));
+
+  auto empty = deserializer.read_block<Eigen::RowVectorXd, 3>(0);
+  EXPECT_EQ(0, empty[2].size());
+  EXPECT_FLOAT_EQ(19.0, deserializer.read<double>());
+
+  std::array<int, 2> n = deserializer.read_block<int, 2>();
+  EXPECT_EQ(1, n[0]);
+  EXPECT_EQ(2, n[1]);
+  EXPECT_EQ(1U, deserializer.available_i());
+  EXPECT_EQ(0U, deserializer.available());
+}
+
+TEST(deserializer, read_block_exception) {
+  std::vector<int> theta_i{1};
+  std::vector<double> theta(5);
+  stan::io::deserializer<double> deserializer(theta, theta_i);
+  EXPECT_THROW((deserializer.read_block<double, 6>()), std::runtime_error);
+  EXPECT_THROW((deserializer.read_block<std::complex<double>, 3>()),
+               std::runtime_error);
+  EXPECT_THROW((deserializer.read_block<Eigen::VectorXd, 3>(2)),
+               std::runtime_error);
+  EXPECT_THROW((deserializer.read_block<int, 2>()), std::runtime_error);
+  EXPECT_EQ(5U, deserializer.available());
+  EXPECT_EQ(1U, deserializer.available_i());
+}
+
 // size zero
 
 TEST(deserializer, zeroSizeVecs) {
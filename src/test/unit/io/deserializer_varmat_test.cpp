@@ -100,6 +100,46 @@ TEST(deserializer_var_matrix, read) {
   EXPECT_FLOAT_EQ(13.0, a.val());
 }
 
+// arrays
+
+TEST(deserializer_var_vector, read_array) {
+  std::vector<int> theta_i;
+  std::vector<stan::math::var> theta;
+  for (size_t i = 0; i < 10U; ++i)
+    theta.push_back(static_cast<double>(i));
+  stan::io::deserializer<stan::math::var> deserializer(theta, theta_i);
+  stan::math::var x = deserializer.read<stan::math::var>();
+  std::vector<var_vector_t> y
+      = deserializer.read<std::vector<var_vector_t>>(3, 2);
+  ASSERT_EQ(3, y.size());
+  for (size_t i = 0; i < y.size(); ++i) {
+    ASSERT_EQ(2, y[i].size());
+    EXPECT_FLOAT_EQ(1.0 + 2 * i, y[i].val()[0]);
+    EXPECT_FLOAT_EQ(2.0 + 2 * i, y[i].val()[1]);
+  }
+  std::vector<var_matrix_t> z
+      = deserializer.read<std::vector<var_matrix_t>>(1, 1, 2);
+  ASSERT_EQ(1, z.size());
+  EXPECT_FLOAT_EQ(7.0, z[0].val()(0, 0));
+  EXPECT_FLOAT_EQ(8.0, z[0].val()(0, 1));
+  EXPECT_FLOAT_EQ(9.0, deserializer.read<stan::math::var>().val());
+  EXPECT_TRUE(deserializer.read<std::vector<var_vector_t>>(0, 2).empty());
+
+  // The adjoints of each element go back to the scalars it was read from
+  stan::math::var lp = 0;
+  for (size_t i = 0; i < y.size(); ++i)
+    lp += (i + 1) * stan::math::sum(y[i]);
+  lp += 10 * z[0].val()(0, 1) * stan::math::sum(z[0]);
+  lp.grad();
+  EXPECT_FLOAT_EQ(0.0, theta[0].adj());
+  for (size_t i = 0; i < 6U; ++i)
+    EXPECT_FLOAT_EQ(1.0 + i / 2, theta[i + 1].adj());
+  EXPECT_FLOAT_EQ(80.0, theta[7].adj());
+  EXPECT_FLOAT_EQ(80.0, theta[8].adj());
+  EXPECT_FLOAT_EQ(0.0, theta[9].adj());
+  stan::math::recover_memory();
+}
+
 // lb
 
 TEST(deserializer, read_constrain_lb_constrain) {
@@ -292,6 +292,38 @@ TEST(io_dump, reader_nan_inf) {
   test_list2(reader, "a", expected_vals, expected_dims);
 }
 
+TEST(io_dump, reader_int_then_inf) {
+  std::vector<double> expected_vals{
+      1, 2, std::numeric_limits<double>::infinity(), 3,
+      std::numeric_limits<double>::quiet_NaN(), 4.5};
+  std::vector<size_t> expected_dims{expected_vals.size()};
+  std::stringstream in("a <- c(1, 2, Inf, 3, NaN, 4.5)");
+  stan::io::dump_reader reader(in);
+  test_list2(reader, "a", expected_vals, expected_dims);
+}
+
+TEST(io_dump, reader_large_seq) {
+  std::stringstream txt;
+  txt << "a <- c(";
+  std::vector<int> expected_i;
+  std::vector<double> expected_r;
+  for (int n = 0; n < 10000; ++n) {
+    txt << (n ? ", " : "") << n;
+    expected_i.push_back(n);
+  }
+  txt << ")\nb <- c(";
+  for (int n = 0; n < 10000; ++n) {
+    txt << (n ? ", " : "") << n << ".25";
+    expected_r.push_back(n + 0.25);
+  }
+  txt << ")\n";
+  std::stringstream in(txt.str());
+  stan::io::dump dump(in);
+  EXPECT_EQ(expected_i, dump.vals_i("a"));
+  EXPECT_EQ(expected_r, dump.vals_r("b"));
+  EXPECT_EQ(std::vector<size_t>{10000}, dump.dims_r("b"));
+}
+
 TEST(io_dump, reader_vec_double) {
   std::vector<double> expected_vals;
   expected_vals.push_back(1.0);
@@ -683,3 +715,26 @@ TEST(io_dump, too_large_zero_array) {
   test_exception(
       "a <- structure(double(999918446744073709551616L), .Dim = c(2,3))");
 }
+
+TEST(io_dump, vals_views) {
+  std::string txt = "foo <- c(1,2,3)\nbar <- c(1.5,2.5)";
+  std::stringstream in(txt);
+  stan::io::dump dump(in);
+
+  stan::io::values_view<int> foo_i = dump.vals_i_view("foo");
+  EXPECT_FALSE(foo_i.owns_values());
+  EXPECT_EQ(foo_i.to_vector(), dump.vals_i("foo"));
+
+  stan::io::values_view<double> foo_r = dump.vals_r_view("foo");
+  EXPECT_TRUE(foo_r.owns_values());
+  EXPECT_EQ(foo_r.to_vector(), dump.vals_r("foo"));
+
+  stan::io::values_view<double> bar_r = dump.vals_r_view("bar");
+  EXPECT_FALSE(bar_r.owns_values());
+  EXPECT_EQ(bar_r.to_vector(), dump.vals_r("bar"));
+  EXPECT_TRUE(foo_i.is_aligned());
+  EXPECT_TRUE(bar_r.is_aligned());
+
+  EXPECT_TRUE(dump.vals_r_view("baz").empty());
+  EXPECT_TRUE(dump.vals_i_view("bar").empty());
+}
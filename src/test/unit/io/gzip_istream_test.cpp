@@ -0,0 +1,73 @@
+#include <stan/io/gzip_istream.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <zlib.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+std::string gzip(const std::string& text) {
+  z_stream zstream;
+  zstream.zalloc = Z_NULL;
+  zstream.zfree = Z_NULL;
+  zstream.opaque = Z_NULL;
+  deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+               Z_DEFAULT_STRATEGY);
+  std::string compressed(deflateBound(&zstream, text.size()), '\0');
+  zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+  zstream.avail_in = text.size();
+  zstream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  zstream.avail_out = compressed.size();
+  deflate(&zstream, Z_FINISH);
+  compressed.resize(compressed.size() - zstream.avail_out);
+  deflateEnd(&zstream);
+  return compressed;
+}
+}  // namespace
+
+TEST(ioGzipIstream, members) {
+  std::istringstream in(gzip("first\n") + gzip("second\n"));
+  stan::io::gzip_istream unzipped(in);
+  std::string line;
+  ASSERT_TRUE(std::getline(unzipped, line));
+  EXPECT_EQ("first", line);
+  ASSERT_TRUE(std::getline(unzipped, line));
+  EXPECT_EQ("second", line);
+  EXPECT_FALSE(std::getline(unzipped, line));
+  EXPECT_FALSE(unzipped.bad());
+}
+
+TEST(ioGzipIstream, invalid) {
+  std::istringstream in("not compressed");
+  stan::io::gzip_istream unzipped(in);
+  std::string line;
+  EXPECT_FALSE(std::getline(unzipped, line));
+  EXPECT_TRUE(unzipped.bad());
+
+  std::string compressed = gzip("a longer line which gets truncated\n");
+  std::istringstream truncated(compressed.substr(0, compressed.size() - 4));
+  stan::io::gzip_istream unzipped_truncated(truncated);
+  while (std::getline(unzipped_truncated, line)) {
+  }
+  EXPECT_TRUE(unzipped_truncated.bad());
+}
+
+TEST(ioGzipIstream, stan_csv_reader) {
+  std::ifstream csv("src/test/unit/io/test_csv_files/blocker.0.csv");
+  std::stringstream text;
+  text << csv.rdbuf();
+  std::istringstream plain_in(text.str());
+  stan::io::stan_csv plain
+      = stan::io::stan_csv_reader::parse(plain_in, nullptr);
+
+  std::istringstream in(gzip(text.str()));
+  stan::io::gzip_istream unzipped(in);
+  stan::io::stan_csv compressed
+      = stan::io::stan_csv_reader::parse(unzipped, nullptr);
+
+  EXPECT_EQ(plain.header, compressed.header);
+  ASSERT_EQ(plain.samples.rows(), compressed.samples.rows());
+  EXPECT_TRUE(plain.samples == compressed.samples);
+  EXPECT_GT(compressed.samples.rows(), 0);
+}
@@ -13,6 +13,7 @@
 #include <gtest/gtest.h>
 
 #include <complex>
+#include <iomanip>
 
 TEST(ioJson, jsonData_scalar_int) {
   std::string txt = "{ \"foo\" : 1 }";
@@ -494,3 +495,133 @@ TEST(ioJson, jsonData_promote_extra_large_int_to_double) {
   test_real_var(jdata, "foo", foo_vals_r, expected_dims);
   test_real_var(jdata, "bar", bar_vals_r, expected_dims);
 }
+
+TEST(ioJson, jsonData_compact_ints) {
+  std::string txt
+      = "{ \"small\" : [1, -2, 127], \"medium\" : [300, -4000],"
+        " \"large\" : [70000, 1], \"real\" : [1.5] }";
+  std::stringstream in(txt);
+  stan::json::json_data jdata(in);
+  EXPECT_EQ(32, jdata.int_bits("small"));
+  EXPECT_EQ(0, jdata.int_bits("real"));
+  size_t small_bytes = jdata.memory_bytes("small");
+  EXPECT_GE(small_bytes, 3 * sizeof(int) + sizeof(size_t));
+  EXPECT_GT(jdata.memory_bytes("real"), 0);
+  EXPECT_EQ(0, jdata.memory_bytes("missing"));
+
+  jdata.compact_ints(16);
+  EXPECT_EQ(16, jdata.int_bits("small"));
+  jdata.compact_ints();
+  EXPECT_EQ(16, jdata.int_bits("small")) << "narrowing is done once";
+
+  std::stringstream in2(txt);
+  stan::json::json_data narrowed(in2);
+  narrowed.compact_ints();
+  EXPECT_EQ(8, narrowed.int_bits("small"));
+  EXPECT_EQ(16, narrowed.int_bits("medium"));
+  EXPECT_EQ(32, narrowed.int_bits("large"));
+  EXPECT_LT(narrowed.memory_bytes("small"), small_bytes);
+
+  EXPECT_EQ(jdata.vals_i("small"), narrowed.vals_i("small"));
+  EXPECT_EQ(std::vector<int>({1, -2, 127}), narrowed.vals_i("small"));
+  EXPECT_EQ(std::vector<double>({300, -4000}), narrowed.vals_r("medium"));
+  stan::io::values_view<int> small = narrowed.vals_i_view("small");
+  EXPECT_TRUE(small.owns_values());
+  EXPECT_EQ(-2, small[1]);
+  stan::io::values_view<int> large = narrowed.vals_i_view("large");
+  EXPECT_FALSE(large.owns_values());
+  EXPECT_EQ(70000, large[0]);
+  EXPECT_EQ(std::vector<size_t>({3}), narrowed.dims_i("small"));
+}
+
+TEST(ioJson, jsonData_vals_views) {
+  std::string txt = "{ \"foo\" : [1, 2, 3], \"bar\" : [1.5, 2.5] }";
+  std::stringstream in(txt);
+  stan::json::json_data jdata(in);
+
+  stan::io::values_view<int> foo_i = jdata.vals_i_view("foo");
+  ASSERT_EQ(3, foo_i.size());
+  EXPECT_FALSE(foo_i.owns_values());
+  EXPECT_EQ(foo_i.to_vector(), jdata.vals_i("foo"));
+
+  // integers read as reals are converted
+  stan::io::values_view<double> foo_r = jdata.vals_r_view("foo");
+  EXPECT_TRUE(foo_r.owns_values());
+  EXPECT_EQ(foo_r.to_vector(), jdata.vals_r("foo"));
+
+  stan::io::values_view<double> bar_r = jdata.vals_r_view("bar");
+  EXPECT_FALSE(bar_r.owns_values());
+  EXPECT_EQ(bar_r.data(), bar_r.begin());
+  EXPECT_EQ(bar_r.to_vector(), jdata.vals_r("bar"));
+  stan::io::values_view<double> bar_r2 = jdata.vals_r_view("bar");
+  EXPECT_EQ(bar_r.data(), bar_r2.data()) << "views share the storage";
+  EXPECT_TRUE(foo_i.is_aligned());
+  EXPECT_TRUE(foo_r.is_aligned());
+  EXPECT_TRUE(bar_r.is_aligned());
+
+  EXPECT_TRUE(jdata.vals_r_view("baz").empty());
+  EXPECT_TRUE(jdata.vals_i_view("bar").empty());
+}
+
+TEST(ioJson, jsonData_column_major_in_place) {
+  // foo[i][j][k] = 100 * i + 10 * j + k for a 2 x 3 x 4 array
+  std::stringstream txt;
+  txt << "{ \"foo\" : [";
+  for (int i = 0; i < 2; ++i) {
+    txt << (i ? ", [" : "[");
+    for (int j = 0; j < 3; ++j) {
+      txt << (j ? ", [" : "[");
+      for (int k = 0; k < 4; ++k)
+        txt << (k ? ", " : "") << 100 * i + 10 * j + k;
+      txt << "]";
+    }
+    txt << "]";
+  }
+  txt << "] }";
+  stan::json::json_data jdata(txt);
+  std::vector<int> vals = jdata.vals_i("foo");
+  ASSERT_EQ(24, vals.size());
+  for (int k = 0; k < 4; ++k)
+    for (int j = 0; j < 3; ++j)
+      for (int i = 0; i < 2; ++i)
+        EXPECT_EQ(100 * i + 10 * j + k, vals[i + 2 * (j + 3 * k)]);
+}
+
+TEST(ioJson, jsonData_parallel_parse) {
+  // arrays of about 2MB are parsed in parallel
+  std::stringstream txt;
+  txt << std::setprecision(17) << "{ \"x\" : [";
+  for (int n = 0; n < 100000; ++n)
+    txt << (n ? ", " : "") << 1.0 / (n + 3);
+  txt << "], \"y\" : [[";
+  for (int n = 0; n < 200000; ++n)
+    txt << (n ? ", " : "") << n;
+  txt << "], [";
+  for (int n = 0; n < 200000; ++n)
+    txt << (n ? ", " : "") << -n;
+  txt << "]], \"z\" : 3 }";
+  std::stringstream serial_in(txt.str());
+  stan::json::json_data serial(serial_in);
+  std::stringstream parallel_in(txt.str());
+  stan::json::json_data parallel(parallel_in, true);
+
+  EXPECT_EQ(serial.vals_r("x"), parallel.vals_r("x"));
+  EXPECT_EQ(serial.dims_r("x"), parallel.dims_r("x"));
+  EXPECT_EQ(serial.vals_i("y"), parallel.vals_i("y"));
+  EXPECT_EQ(serial.dims_i("y"), parallel.dims_i("y"));
+  EXPECT_EQ(serial.vals_i("z"), parallel.vals_i("z"));
+}
+
+TEST(ioJson, jsonData_names_sorted) {
+  std::string txt
+      = "{ \"zeta\" : 1.5, \"alpha\" : 2, \"mu\" : [0.5, 1],"
+        " \"t\" : {\"2\": 3, \"1\": {\"1\": 4.5, \"2\": 5}}, \"beta\" : 6 }";
+  std::stringstream in(txt);
+  stan::json::json_data jdata(in);
+  std::vector<std::string> names;
+  jdata.names_r(names);
+  EXPECT_EQ(std::vector<std::string>({"mu", "t.1.1", "zeta"}), names);
+  jdata.names_i(names);
+  EXPECT_EQ(std::vector<std::string>({"alpha", "beta", "t.1.2", "t.2"}),
+            names);
+}
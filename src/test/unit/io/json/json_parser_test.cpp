@@ -2,6 +2,7 @@
 #include <stan/io/json/json_data_handler.hpp>
 #include <stan/io/json/json_error.hpp>
 #include <stan/io/json/json_handler.hpp>
+#include <stan/io/json/rapidjson_parallel_parser.hpp>
 #include <stan/io/json/rapidjson_parser.hpp>
 
 #include <test/unit/io/json/util.hpp>
@@ -14,6 +15,28 @@ void test_parser(const std::string &input, const std::string &expected_output) {
   EXPECT_EQ(expected_output, handler.os_.str());
 }
 
+std::string parse_message(const std::string &input, bool parallel,
+                          size_t chunk_bytes) {
+  recording_handler handler;
+  std::stringstream s(input);
+  try {
+    if (parallel)
+      stan::json::rapidjson_parse_parallel(s, handler, 0, chunk_bytes);
+    else
+      stan::json::rapidjson_parse(s, handler);
+  } catch (const std::exception &e) {
+    return e.what();
+  }
+  return handler.os_.str();
+}
+
+void test_parallel_parser(const std::string &input) {
+  std::string expected = parse_message(input, false, 0);
+  for (size_t chunk_bytes : {1, 2, 3, 7, 100})
+    EXPECT_EQ(expected, parse_message(input, true, chunk_bytes))
+        << "chunk_bytes = " << chunk_bytes;
+}
+
 TEST(ioJson, jsonParserA0) {
   test_parser("[0]",
               "S:text"
@@ -686,3 +709,24 @@ TEST(ioJson, jsonParserErr19d) {
   test_exception("{ \"x\": [ 9.19191919191919e1000000000000 ]",
                  "Number too big to be stored in double.\n");
 }
+
+TEST(ioJson, jsonParserParallel) {
+  test_parallel_parser("[]");
+  test_parallel_parser("[5,10]");
+  test_parallel_parser(
+      "{ \"a\": [1, -2, 3000000000, -3000000000, 10000000000000000000,"
+      " 0.1, 1e-300, NaN, Infinity, -Infinity],"
+      " \"b\": [[1.5, 2], [3, 4]], \"c\": \"[1, 2]\", \"d\": [ ],"
+      " \"e\": [{\"1\": [0.5, 1.5]}, {\"2\": [2.5, 3.5]}],"
+      " \"f\": 1.25, \"g\": [\"x\", 1]}");
+}
+
+TEST(ioJson, jsonParserParallelErrors) {
+  test_parallel_parser("{ \"x\": [ -1, -2, ]");
+  test_parallel_parser("{ \"x\": [ -1, , -2 ]");
+  test_parallel_parser("{ \"x\": [ -1, -2 x ]");
+  test_parallel_parser("{ \"x\": [ 1, 2 ], \"y\": [ 3, 4 ] \"z\": 1 }");
+  test_parallel_parser("{ \"x\": [ 1, 2 ], \"y\": [ 3, 4 ] ");
+  test_parallel_parser("[ 1, 2 ], [ 3, 4 ]");
+  test_parallel_parser("1 ");
+}
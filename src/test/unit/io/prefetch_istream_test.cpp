@@ -0,0 +1,101 @@
+#include <stan/io/prefetch_istream.hpp>
+#include <stan/io/json/json_data.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+// Stream buffer which fails after serving some characters
+class failing_streambuf : public std::streambuf {
+ public:
+  explicit failing_streambuf(const std::string& text) : text_(text) {
+    setg(&text_[0], &text_[0], &text_[0] + text_.size());
+  }
+
+ protected:
+  int_type underflow() { throw std::runtime_error("device error"); }
+
+ private:
+  std::string text_;
+};
+}  // namespace
+
+TEST(ioPrefetchIstream, chunks) {
+  std::string text;
+  for (int i = 0; i < 5000; ++i)
+    text += "line " + std::to_string(i) + "\n";
+  for (std::size_t chunk_size : {1, 7, 4096, 1 << 20}) {
+    std::istringstream in(text);
+    stan::io::prefetch_istream prefetched(in, chunk_size);
+    std::stringstream read;
+    read << prefetched.rdbuf();
+    EXPECT_EQ(text, read.str());
+    EXPECT_FALSE(prefetched.bad());
+  }
+}
+
+TEST(ioPrefetchIstream, empty_and_early_destruction) {
+  std::istringstream empty("");
+  stan::io::prefetch_istream prefetched_empty(empty);
+  std::string line;
+  EXPECT_FALSE(std::getline(prefetched_empty, line));
+  EXPECT_FALSE(prefetched_empty.bad());
+
+  // the reader waits for buffers which are never consumed
+  std::istringstream in(std::string(1000, 'x'));
+  {
+    stan::io::prefetch_istream prefetched(in, 10);
+    char c;
+    EXPECT_TRUE(prefetched.get(c));
+    EXPECT_EQ('x', c);
+  }
+}
+
+TEST(ioPrefetchIstream, error) {
+  failing_streambuf buf(std::string(100, 'x'));
+  std::istream in(&buf);
+  stan::io::prefetch_istream prefetched(in, 16);
+  std::string read;
+  // the chunks read in full before the failure are delivered
+  std::getline(prefetched, read);
+  EXPECT_GE(read.size(), 96);
+  EXPECT_EQ(std::string(read.size(), 'x'), read);
+  EXPECT_TRUE(prefetched.bad());
+}
+
+TEST(ioPrefetchIstream, json_data) {
+  std::string text = "{\"N\": 2000, \"y\": [";
+  for (int i = 0; i < 2000; ++i)
+    text += (i > 0 ? ", " : "") + std::to_string(0.5 * i);
+  text += "]}";
+  std::istringstream in(text);
+  stan::io::prefetch_istream prefetched(in, 256);
+  stan::json::json_data data(prefetched);
+  EXPECT_EQ(2000, data.vals_i("N")[0]);
+  std::vector<double> y = data.vals_r("y");
+  ASSERT_EQ(2000, y.size());
+  EXPECT_FLOAT_EQ(999.5, y[1999]);
+}
+
+TEST(ioPrefetchIstream, stan_csv_reader) {
+  std::ifstream csv("src/test/unit/io/test_csv_files/blocker.0.csv");
+  std::stringstream text;
+  text << csv.rdbuf();
+  std::istringstream plain_in(text.str());
+  stan::io::stan_csv plain
+      = stan::io::stan_csv_reader::parse(plain_in, nullptr);
+
+  std::istringstream in(text.str());
+  stan::io::prefetch_istream prefetched(in, 512);
+  stan::io::stan_csv read
+      = stan::io::stan_csv_reader::parse(prefetched, nullptr);
+
+  EXPECT_EQ(plain.header, read.header);
+  ASSERT_EQ(plain.samples.rows(), read.samples.rows());
+  EXPECT_TRUE(plain.samples == read.samples);
+  EXPECT_GT(read.samples.rows(), 0);
+}
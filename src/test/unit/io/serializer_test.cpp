@@ -173,6 +173,47 @@ TEST(serializer_stdvector, complex_write) {
   EXPECT_THROW(serializer.write(4), std::runtime_error);
 }
 
+TEST(serializer_matrix, write_layouts) {
+  Eigen::MatrixXd x(3, 4);
+  for (Eigen::Index i = 0; i < x.size(); ++i) {
+    x.coeffRef(i) = static_cast<double>(i);
+  }
+  Eigen::Matrix<double, -1, -1, Eigen::RowMajor> x_row_major = x;
+  std::vector<double> theta(4 * x.size(), 0.0);
+  stan::io::serializer<double> serializer(theta);
+  serializer.write(x_row_major);
+  serializer.write(x.middleCols(1, 2));
+  serializer.write(x.topRows(2));
+  serializer.write(2 * x.col(3));
+  EXPECT_EQ(theta.size() - 12 - 6 - 8 - 3, serializer.available());
+
+  stan::io::deserializer<double> deserializer(theta, std::vector<int>{});
+  EXPECT_EQ(x, deserializer.read<Eigen::MatrixXd>(3, 4));
+  EXPECT_EQ(x.middleCols(1, 2), deserializer.read<Eigen::MatrixXd>(3, 2));
+  EXPECT_EQ(x.topRows(2), deserializer.read<Eigen::MatrixXd>(2, 4));
+  EXPECT_EQ(2 * x.col(3), deserializer.read<Eigen::VectorXd>(3));
+}
+
+TEST(serializer_stdvector, write_int) {
+  std::vector<double> theta(3, 0.0);
+  stan::io::serializer<double> serializer(theta);
+  serializer.write(std::vector<int>{1, 2, 3});
+  EXPECT_EQ(std::vector<double>({1.0, 2.0, 3.0}), theta);
+  EXPECT_THROW(serializer.write(std::vector<int>{4}), std::runtime_error);
+}
+
+TEST(serializer, unchecked_write) {
+  std::vector<double> theta(9, 0.0);
+  stan::io::serializer<double, false> serializer(theta);
+  serializer.write(1.0);
+  serializer.write(std::complex<double>(2.0, 3.0));
+  serializer.write(Eigen::VectorXd::Constant(2, 4.0));
+  serializer.write(std::vector<double>{5.0, 6.0});
+  serializer.write(Eigen::MatrixXd::Constant(1, 2, 7.0));
+  EXPECT_EQ(0U, serializer.available());
+  EXPECT_EQ(std::vector<double>({1, 2, 3, 4, 4, 5, 6, 7, 7}), theta);
+}
+
 // size zero
 
 TEST(serializer, zeroSizeVecs) {
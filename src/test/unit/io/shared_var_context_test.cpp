@@ -0,0 +1,77 @@
+#include <stan/io/shared_var_context.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+stan::io::array_var_context make_context() {
+  std::vector<std::string> names_r{"a", "b"};
+  std::vector<double> values_r{1.5, 2.5, 3.5, -1, -2, -3, -4};
+  std::vector<std::vector<size_t>> dims_r{{3}, {2, 2}};
+  std::vector<std::string> names_i{"n", "x.1"};
+  std::vector<int> values_i{7, 1, 2, 3};
+  std::vector<std::vector<size_t>> dims_i{{}, {3}};
+  return stan::io::array_var_context(names_r, values_r, dims_r, names_i,
+                                     values_i, dims_i);
+}
+
+std::string segment_name(const std::string& test) {
+  return "stan_shared_var_context_test_" + test;
+}
+}  // namespace
+
+TEST(sharedVarContext, publish_and_attach) {
+  stan::io::array_var_context context = make_context();
+  std::stringstream out;
+  stan::io::write_binary_data(out, context);
+
+  stan::io::shared_data_publisher publisher(segment_name("attach"), context);
+  EXPECT_EQ(segment_name("attach"), publisher.name());
+  EXPECT_EQ(out.str().size(), publisher.size());
+
+  stan::io::shared_var_context attached(segment_name("attach"));
+  stan::io::shared_var_context attached2(segment_name("attach"));
+  std::vector<std::string> names;
+  attached.names_r(names);
+  EXPECT_EQ(std::vector<std::string>({"a", "b"}), names);
+  attached.names_i(names);
+  EXPECT_EQ(std::vector<std::string>({"n", "x.1"}), names);
+  for (const std::string& name : {"a", "b"}) {
+    EXPECT_EQ(context.vals_r(name), attached.vals_r(name));
+    EXPECT_EQ(context.dims_r(name), attached.dims_r(name));
+  }
+  for (const std::string& name : {"n", "x.1"}) {
+    EXPECT_EQ(context.vals_i(name), attached.vals_i(name));
+    EXPECT_EQ(context.dims_i(name), attached.dims_i(name));
+  }
+
+  // both contexts view the same shared pages
+  stan::io::values_view<double> b = attached.vals_r_view("b");
+  stan::io::values_view<double> b2 = attached2.vals_r_view("b");
+  ASSERT_EQ(4, b.size());
+  EXPECT_FLOAT_EQ(-4, b[3]);
+  EXPECT_NE(b.data(), b2.data());
+  EXPECT_EQ(b[0], b2[0]);
+}
+
+TEST(sharedVarContext, lifetime) {
+  stan::io::array_var_context context = make_context();
+  std::unique_ptr<stan::io::shared_var_context> attached;
+  {
+    stan::io::shared_data_publisher publisher(segment_name("lifetime"),
+                                              context);
+    EXPECT_THROW(
+        stan::io::shared_data_publisher(segment_name("lifetime"), context),
+        std::invalid_argument);
+    attached.reset(new stan::io::shared_var_context(segment_name("lifetime")));
+  }
+  // the name is removed but the attached mapping stays valid
+  EXPECT_THROW(stan::io::shared_var_context(segment_name("lifetime")),
+               std::invalid_argument);
+  EXPECT_EQ(context.vals_r("a"), attached->vals_r("a"));
+  EXPECT_EQ(7, attached->vals_i("n")[0]);
+}
@@ -0,0 +1,61 @@
+#include <stan/io/stan_binary_chunk_reader.hpp>
+#include <stan/callbacks/binary_writer.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+}  // namespace
+
+TEST(StanIoStanBinaryChunkReader, chunks_span_row_groups) {
+  std::stringstream ss;
+  {
+    stan::callbacks::binary_writer<std::stringstream, deleter_noop> writer(
+        std::unique_ptr<std::stringstream, deleter_noop>(&ss), 3);
+    writer(std::vector<std::string>{"lp__", "mu", "tau"});
+    for (int n = 0; n < 10; ++n) {
+      writer(std::vector<double>{-1.0 * n, 10.0 + n, 20.0 + n});
+      if (n == 4)
+        writer("Adaptation terminated");
+    }
+  }
+  stan::io::stan_binary_chunk_reader reader(ss, {"tau", "mu"}, 0);
+  EXPECT_EQ(2, reader.num_columns());
+  Eigen::MatrixXd chunk;
+  int row = 0;
+  size_t rows;
+  while ((rows = reader.read(chunk, 4)) > 0) {
+    ASSERT_EQ(4, chunk.rows());
+    for (size_t i = 0; i < rows; ++i, ++row) {
+      EXPECT_FLOAT_EQ(20.0 + row, chunk(i, 0));
+      EXPECT_FLOAT_EQ(10.0 + row, chunk(i, 1));
+    }
+  }
+  EXPECT_EQ(10, row);
+  ASSERT_EQ(1, reader.messages().size());
+  EXPECT_EQ("Adaptation terminated", reader.messages()[0]);
+}
+
+TEST(StanIoStanBinaryChunkReader, missing_column) {
+  std::stringstream ss;
+  {
+    stan::callbacks::binary_writer<std::stringstream, deleter_noop> writer(
+        std::unique_ptr<std::stringstream, deleter_noop>(&ss), 3);
+    writer(std::vector<std::string>{"lp__", "mu"});
+  }
+  EXPECT_THROW(stan::io::stan_binary_chunk_reader(ss, {"tau"}, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryChunkReader, not_binary) {
+  std::stringstream ss("lp__,mu\n1,2\n");
+  EXPECT_THROW(stan::io::stan_binary_chunk_reader(ss, {"mu"}, 0),
+               std::invalid_argument);
+}
@@ -0,0 +1,93 @@
+#include <stan/io/stan_binary_mapping.hpp>
+#include <stan/io/stan_binary_reader.hpp>
+#include <stan/callbacks/binary_writer.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+void write_draws(std::stringstream& ss, const std::vector<std::string>& names,
+                 int num_draws) {
+  stan::callbacks::binary_writer<std::stringstream, deleter_noop> writer(
+      std::unique_ptr<std::stringstream, deleter_noop>(&ss), 3);
+  writer(names);
+  writer("# comment");
+  for (int n = 0; n < num_draws; ++n) {
+    std::vector<double> draw;
+    for (size_t j = 0; j < names.size(); ++j)
+      draw.push_back(10 * n + j);
+    writer(draw);
+  }
+}
+}  // namespace
+
+TEST(StanIoStanBinaryMapping, matches_reader) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu", "sigma"}, 8);
+  const std::string bytes = ss.str();
+  stan::io::stan_binary_mapping mapping(bytes.data(), bytes.size());
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, 0);
+
+  EXPECT_EQ(draws.header, mapping.header());
+  EXPECT_EQ(draws.messages, mapping.messages());
+  ASSERT_EQ(8, mapping.num_rows());
+  ASSERT_EQ(3, mapping.num_cols());
+  for (size_t j = 0; j < mapping.num_cols(); ++j)
+    EXPECT_TRUE(draws.samples.col(j) == mapping.column(j));
+}
+
+TEST(StanIoStanBinaryMapping, read_column_across_row_groups) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 8);
+  const std::string bytes = ss.str();
+  stan::io::stan_binary_mapping mapping(bytes.data(), bytes.size());
+
+  std::vector<double> x(4);
+  mapping.read_column(1, 2, 4, x.data());
+  EXPECT_EQ(std::vector<double>({21, 31, 41, 51}), x);
+  EXPECT_THROW(mapping.read_column(2, 0, 1, x.data()), std::out_of_range);
+  EXPECT_THROW(mapping.read_column(0, 6, 3, x.data()), std::out_of_range);
+}
+
+TEST(StanIoStanBinaryMapping, ill_formed) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 7);
+  const std::string bytes = ss.str();
+  EXPECT_THROW(stan::io::stan_binary_mapping(bytes.data(), bytes.size() - 5),
+               std::invalid_argument);
+  EXPECT_THROW(stan::io::stan_binary_mapping(bytes.data(), 0),
+               std::invalid_argument);
+  const std::string csv = "lp__,mu\n1,2\n";
+  EXPECT_THROW(stan::io::stan_binary_mapping(csv.data(), csv.size()),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryMapping, file) {
+  const char* file_name = "stan_binary_mapping_test.bin";
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 5);
+  {
+    std::ofstream out(file_name, std::ios::binary);
+    out << ss.str();
+  }
+  {
+    stan::io::stan_binary_mapping mapping(file_name);
+    EXPECT_EQ(5, mapping.num_rows());
+    Eigen::VectorXd mu(5);
+    mu << 1, 11, 21, 31, 41;
+    EXPECT_TRUE(mu == mapping.column(1));
+  }
+  std::remove(file_name);
+  EXPECT_THROW(stan::io::stan_binary_mapping mapping(file_name),
+               std::invalid_argument);
+}
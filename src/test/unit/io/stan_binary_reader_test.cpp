@@ -0,0 +1,79 @@
+#include <stan/io/stan_binary_reader.hpp>
+#include <stan/callbacks/binary_writer.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+void write_draws(std::stringstream& ss, const std::vector<std::string>& names,
+                 int num_draws) {
+  stan::callbacks::binary_writer<std::stringstream, deleter_noop> writer(
+      std::unique_ptr<std::stringstream, deleter_noop>(&ss), 3);
+  writer(names);
+  for (int n = 0; n < num_draws; ++n) {
+    std::vector<double> draw(names.size(), n);
+    writer(draw);
+  }
+}
+}  // namespace
+
+TEST(StanIoStanBinaryReader, empty_input) {
+  std::stringstream ss;
+  EXPECT_THROW(stan::io::stan_binary_reader::parse(ss, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryReader, header_only) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 0);
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, 0);
+  EXPECT_EQ(2, draws.header.size());
+  EXPECT_EQ(0, draws.samples.rows());
+  EXPECT_EQ(2, draws.samples.cols());
+}
+
+TEST(StanIoStanBinaryReader, not_binary) {
+  std::stringstream ss("lp__,mu\n1,2\n");
+  EXPECT_THROW(stan::io::stan_binary_reader::parse(ss, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryReader, truncated) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 7);
+  std::string bytes = ss.str();
+  std::stringstream truncated(bytes.substr(0, bytes.size() - 5));
+  EXPECT_THROW(stan::io::stan_binary_reader::parse(truncated, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryReader, mismatched_append) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 2);
+  write_draws(ss, {"lp__", "sigma"}, 2);
+  EXPECT_THROW(stan::io::stan_binary_reader::parse(ss, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanBinaryReader, skips_unknown_chunks) {
+  std::stringstream ss;
+  write_draws(ss, {"lp__", "mu"}, 4);
+  stan::io::binary_format::write_chunk_start(ss, "XXXX", 3);
+  ss.write("abc", 3);
+  write_draws(ss, {"lp__", "mu"}, 2);
+
+  std::stringstream out;
+  stan::io::stan_binary draws = stan::io::stan_binary_reader::parse(ss, &out);
+  EXPECT_EQ(6, draws.samples.rows());
+  EXPECT_EQ(3, draws.samples(3, 1));
+  EXPECT_EQ(1, draws.samples(5, 0));
+  EXPECT_NE(std::string::npos, out.str().find("XXXX"));
+}
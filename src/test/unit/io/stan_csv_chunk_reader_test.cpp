@@ -0,0 +1,56 @@
+#include <stan/io/stan_csv_chunk_reader.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(StanIoStanCsvChunkReader, chunks_match_parse) {
+  std::ifstream parse_stream(
+      "src/test/unit/io/test_csv_files/eight_schools.csv");
+  stan::io::stan_csv eight_schools
+      = stan::io::stan_csv_reader::parse(parse_stream, 0);
+
+  std::ifstream in("src/test/unit/io/test_csv_files/eight_schools.csv");
+  // Out of the order of the header, to check the permutation
+  stan::io::stan_csv_chunk_reader reader(in, {"tau", "theta.3", "mu"}, 0);
+  EXPECT_EQ(3, reader.num_columns());
+  // Column names are kept as written, as constrained_param_names has them
+  ASSERT_EQ(eight_schools.header.size(), reader.header().size());
+  EXPECT_EQ("theta.3", reader.header()[19]);
+  EXPECT_EQ(eight_schools.metadata.model, reader.metadata().model);
+  EXPECT_FLOAT_EQ(eight_schools.adaptation.step_size,
+                  reader.adaptation().step_size);
+
+  Eigen::MatrixXd chunk;
+  Eigen::Index row = 0;
+  size_t rows;
+  while ((rows = reader.read(chunk, 300)) > 0) {
+    ASSERT_EQ(300, chunk.rows());
+    for (size_t i = 0; i < rows; ++i, ++row) {
+      EXPECT_FLOAT_EQ(eight_schools.samples(row, 8), chunk(i, 0));
+      EXPECT_FLOAT_EQ(eight_schools.samples(row, 19), chunk(i, 1));
+      EXPECT_FLOAT_EQ(eight_schools.samples(row, 7), chunk(i, 2));
+    }
+  }
+  EXPECT_EQ(eight_schools.samples.rows(), row);
+  EXPECT_EQ(0, reader.read(chunk, 300));
+}
+
+TEST(StanIoStanCsvChunkReader, missing_column) {
+  std::ifstream in("src/test/unit/io/test_csv_files/eight_schools.csv");
+  EXPECT_THROW(stan::io::stan_csv_chunk_reader(in, {"mu", "sigma"}, 0),
+               std::invalid_argument);
+}
+
+TEST(StanIoStanCsvChunkReader, short_row) {
+  std::stringstream in("lp__,mu,tau\n1,2,3\n# comment\n4,5,6\n7,8\n");
+  stan::io::stan_csv_chunk_reader reader(in, {"mu"}, 0);
+  Eigen::MatrixXd chunk;
+  ASSERT_EQ(2, reader.read(chunk, 2));
+  EXPECT_FLOAT_EQ(2, chunk(0, 0));
+  EXPECT_FLOAT_EQ(5, chunk(1, 0));
+  EXPECT_THROW(reader.read(chunk, 2), std::invalid_argument);
+}
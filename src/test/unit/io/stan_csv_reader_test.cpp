@@ -1,9 +1,15 @@
 #include <stan/io/stan_csv_reader.hpp>
+#include <stan/callbacks/structured_binary_writer.hpp>
 #include <test/unit/util.hpp>
 #include <gtest/gtest.h>
 #include <fstream>
 #include <sstream>
 
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
 class StanIoStanCsvReader : public testing::Test {
  public:
   void SetUp() {
@@ -235,6 +241,36 @@ TEST_F(StanIoStanCsvReader, read_adaptation1) {
   EXPECT_FLOAT_EQ(0.0248957, adaptation.metric(46));
 }
 
+TEST(StanIoStanCsvReaderMetric, read_adaptation_metric_output) {
+  std::stringstream csv(
+      "# Adaptation terminated\n"
+      "# Step size = 0.25\n"
+      "# Inverse mass matrix written to the metric output\n"
+      "1,2\n");
+  stan::io::stan_csv_adaptation adaptation;
+  EXPECT_TRUE(stan::io::stan_csv_reader::read_adaptation(csv, adaptation, 0));
+  EXPECT_FLOAT_EQ(0.25, adaptation.step_size);
+  EXPECT_TRUE(adaptation.metric_in_metric_output);
+  EXPECT_EQ(0, adaptation.metric.size());
+
+  Eigen::MatrixXd inv_metric(2, 2);
+  inv_metric << 2, 0.5, 0.5, 3;
+  std::stringstream metric(std::ios::in | std::ios::out | std::ios::binary);
+  std::unique_ptr<std::stringstream, deleter_noop> metric_stream(&metric);
+  stan::callbacks::structured_binary_writer<std::stringstream, deleter_noop>
+      metric_writer(std::move(metric_stream));
+  metric_writer.begin_record();
+  metric_writer.write("stepsize", 0.25);
+  metric_writer.write("metric_type", "dense_e");
+  metric_writer.write("inv_metric", inv_metric);
+  metric_writer.end_record();
+  EXPECT_TRUE(stan::io::stan_csv_reader::read_metric(metric, adaptation));
+  EXPECT_MATRIX_EQ(inv_metric, adaptation.metric);
+
+  std::stringstream not_metric("not a metric output");
+  EXPECT_FALSE(stan::io::stan_csv_reader::read_metric(not_metric, adaptation));
+}
+
 TEST_F(StanIoStanCsvReader, read_samples1) {
   Eigen::MatrixXd samples;
   stan::io::stan_csv_timing timing;
@@ -537,3 +573,169 @@ TEST_F(StanIoStanCsvReader, ParseEightSchools) {
 
   EXPECT_EQ("", out.str());
 }
+
+TEST(StanIoStanCsvReaderSamples, spans_chunks) {
+  // more than one megabyte, so the lines are split over several chunks
+  const int rows = 80000;
+  const int cols = 5;
+  std::stringstream ss;
+  for (int i = 0; i < rows; ++i) {
+    if (i % 1000 == 999)
+      ss << "# Adaptation terminated\n\n";
+    for (int j = 0; j < cols; ++j)
+      ss << (j ? "," : "") << i * cols + j;
+    ss << "\n";
+  }
+  ss << "#  Elapsed Time: 0.25 seconds (Warm-up)\n";
+  ss << "#                0.5 seconds (Sampling)\n";
+  ASSERT_GT(ss.str().size(), 1 << 21);
+
+  Eigen::MatrixXd samples;
+  stan::io::stan_csv_timing timing;
+  EXPECT_TRUE(
+      stan::io::stan_csv_reader::read_samples(ss, samples, timing, 0));
+  ASSERT_EQ(rows, samples.rows());
+  ASSERT_EQ(cols, samples.cols());
+  for (int i = 0; i < rows; ++i)
+    for (int j = 0; j < cols; ++j)
+      ASSERT_EQ(i * cols + j, samples(i, j));
+  EXPECT_FLOAT_EQ(0.25, timing.warmup);
+  EXPECT_FLOAT_EQ(0.5, timing.sampling);
+}
+
+TEST(StanIoStanCsvReaderSamples, values) {
+  std::stringstream ss(" 1.5 ,+2,-3e2, inf,-inf\r\n4,5,6,7,8\n");
+  Eigen::MatrixXd samples;
+  stan::io::stan_csv_timing timing;
+  EXPECT_TRUE(
+      stan::io::stan_csv_reader::read_samples(ss, samples, timing, 0));
+  ASSERT_EQ(2, samples.rows());
+  ASSERT_EQ(5, samples.cols());
+  EXPECT_EQ(1.5, samples(0, 0));
+  EXPECT_EQ(2, samples(0, 1));
+  EXPECT_EQ(-300, samples(0, 2));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), samples(0, 3));
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), samples(0, 4));
+  EXPECT_EQ(8, samples(1, 4));
+}
+
+TEST(StanIoStanCsvReaderSamples, mismatched_row) {
+  std::stringstream ss(
+      "1,2,3\n"
+      "#  Elapsed Time: 0.25 seconds (Warm-up)\n"
+      "4,5,6\n"
+      "7,8\n"
+      "#                0.5 seconds (Sampling)\n"
+      "9,10,11,12\n");
+  Eigen::MatrixXd samples(1, 1);
+  samples << 42;
+  stan::io::stan_csv_timing timing;
+  std::stringstream out;
+  EXPECT_FALSE(
+      stan::io::stan_csv_reader::read_samples(ss, samples, timing, &out));
+  EXPECT_EQ("Error: expected 3 columns, but found 2 instead for row 3\n",
+            out.str());
+  ASSERT_EQ(1, samples.size());
+  EXPECT_EQ(42, samples(0, 0));
+  EXPECT_FLOAT_EQ(0.25, timing.warmup);
+  EXPECT_FLOAT_EQ(0, timing.sampling);
+}
+
+TEST_F(StanIoStanCsvReader, ParseBlockerColumns) {
+  stan::io::stan_csv blocker0 = stan::io::stan_csv_reader::parse(
+      blocker0_stream, 0, {"lp__", "mu.", "delta[", "sigma_"});
+
+  std::ifstream full_stream("src/test/unit/io/test_csv_files/blocker.0.csv");
+  stan::io::stan_csv full = stan::io::stan_csv_reader::parse(full_stream, 0);
+
+  ASSERT_EQ(1 + 22 + 22 + 1, blocker0.header.size());
+  ASSERT_EQ(blocker0.header.size(), blocker0.samples.cols());
+  ASSERT_EQ(full.samples.rows(), blocker0.samples.rows());
+  EXPECT_EQ("lp__", blocker0.header[0]);
+  EXPECT_EQ("mu[1]", blocker0.header[1]);
+  EXPECT_EQ("delta[22]", blocker0.header[44]);
+  EXPECT_EQ("sigma_delta", blocker0.header[45]);
+  for (std::size_t k = 0; k < blocker0.header.size(); ++k) {
+    auto it = std::find(full.header.begin(), full.header.end(),
+                        blocker0.header[k]);
+    ASSERT_NE(full.header.end(), it);
+    EXPECT_TRUE(full.samples.col(it - full.header.begin())
+                == blocker0.samples.col(k));
+  }
+  EXPECT_FLOAT_EQ(full.timing.warmup, blocker0.timing.warmup);
+  EXPECT_EQ(full.adaptation.metric, blocker0.adaptation.metric);
+}
+
+TEST(StanIoStanCsvReaderSamples, columns) {
+  std::stringstream ss("1,2,3,4\n5,6,7,8\n");
+  Eigen::MatrixXd samples;
+  stan::io::stan_csv_timing timing;
+  EXPECT_TRUE(stan::io::stan_csv_reader::read_samples(ss, samples, timing, 0,
+                                                      {1, 3}));
+  ASSERT_EQ(2, samples.rows());
+  ASSERT_EQ(2, samples.cols());
+  EXPECT_EQ(2, samples(0, 0));
+  EXPECT_EQ(4, samples(0, 1));
+  EXPECT_EQ(6, samples(1, 0));
+  EXPECT_EQ(8, samples(1, 1));
+
+  std::stringstream missing("1,2,3,4\n5,6,7,8\n");
+  std::stringstream out;
+  EXPECT_FALSE(stan::io::stan_csv_reader::read_samples(
+      missing, samples, timing, &out, {1, 4}));
+  EXPECT_EQ("Error: selected column 5, but found only 4 columns\n",
+            out.str());
+}
+
+TEST(StanIoStanCsvReaderSamples, skip_warmup_and_thin) {
+  std::ifstream csv("src/test/unit/io/test_csv_files/blocker.0.csv");
+  std::stringstream text;
+  text << csv.rdbuf();
+  std::istringstream full_in(text.str());
+  stan::io::stan_csv full = stan::io::stan_csv_reader::parse(full_in, 0);
+
+  // Save 3 warmup draws, one per thin = 2 of 6 iterations, after the
+  // header.  They are skipped unconverted, so their length is not
+  // checked.
+  std::string with_warmup = text.str();
+  with_warmup.replace(with_warmup.find("num_warmup = 2000"), 17,
+                      "num_warmup = 6");
+  with_warmup.replace(with_warmup.find("save_warmup = 0 (Default)"), 25,
+                      "save_warmup = 1");
+  std::size_t header_end = with_warmup.find("\nlp__");
+  header_end = with_warmup.find('\n', header_end + 1) + 1;
+  with_warmup.insert(header_end, "1,2\nnot a draw\n3\n");
+
+  stan::io::stan_csv_read_options options;
+  options.skip_warmup = true;
+  options.thin = 3;
+  std::istringstream in(with_warmup);
+  std::stringstream out;
+  stan::io::stan_csv thinned
+      = stan::io::stan_csv_reader::parse(in, &out, options);
+  EXPECT_EQ(std::string::npos, out.str().find("Error"));
+  EXPECT_FALSE(thinned.metadata.save_warmup);
+  EXPECT_EQ(6, thinned.metadata.thin);
+  EXPECT_EQ(full.header, thinned.header);
+  ASSERT_EQ((full.samples.rows() + 2) / 3, thinned.samples.rows());
+  for (int i = 0; i < thinned.samples.rows(); ++i)
+    EXPECT_TRUE(full.samples.row(3 * i) == thinned.samples.row(i));
+  EXPECT_FLOAT_EQ(full.timing.sampling, thinned.timing.sampling);
+
+  // Keeping the warmup draws checks their length
+  options.skip_warmup = false;
+  options.thin = 1;
+  std::istringstream with_warmup_in(with_warmup);
+  stan::io::stan_csv kept
+      = stan::io::stan_csv_reader::parse(with_warmup_in, &out, options);
+  EXPECT_NE(std::string::npos, out.str().find("Error: expected 2 columns"));
+  EXPECT_TRUE(kept.metadata.save_warmup);
+
+  std::istringstream columns_in(text.str());
+  options.thin = 10;
+  stan::io::stan_csv columns
+      = stan::io::stan_csv_reader::parse(columns_in, 0, {"lp__"}, options);
+  ASSERT_EQ(1, columns.samples.cols());
+  ASSERT_EQ((full.samples.rows() + 9) / 10, columns.samples.rows());
+  EXPECT_EQ(full.samples(10, 0), columns.samples(1, 0));
+}
@@ -0,0 +1,54 @@
+#include <stan/io/structured_binary_reader.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using stan::io::structured_binary_reader;
+namespace format = stan::io::structured_binary_format;
+
+TEST(structuredBinaryReader, empty_file) {
+  std::stringstream in(std::string(format::file_tag));
+  stan::io::structured_value root = structured_binary_reader::parse(in);
+  EXPECT_TRUE(root.is_record());
+  EXPECT_TRUE(root.items.empty());
+}
+
+TEST(structuredBinaryReader, not_the_format) {
+  std::stringstream in("{\"a\": 1}");
+  EXPECT_THROW(structured_binary_reader::parse(in), std::invalid_argument);
+}
+
+TEST(structuredBinaryReader, truncated) {
+  std::stringstream out;
+  out.write(format::file_tag, 4);
+  format::write_type(out, format::item_type::real_value);
+  format::write_string(out, "x");
+  out.write("\0\0\0", 3);
+  std::stringstream in(out.str());
+  EXPECT_THROW(structured_binary_reader::parse(in), std::invalid_argument);
+}
+
+TEST(structuredBinaryReader, unbalanced_records) {
+  std::stringstream out;
+  out.write(format::file_tag, 4);
+  format::write_type(out, format::item_type::begin_record);
+  format::write_string(out, "");
+  std::stringstream not_ended(out.str());
+  EXPECT_THROW(structured_binary_reader::parse(not_ended),
+               std::invalid_argument);
+
+  format::write_type(out, format::item_type::end_record);
+  format::write_type(out, format::item_type::end_record);
+  std::stringstream never_begun(out.str());
+  EXPECT_THROW(structured_binary_reader::parse(never_begun),
+               std::invalid_argument);
+}
+
+TEST(structuredBinaryReader, unknown_item_type) {
+  std::stringstream out;
+  out.write(format::file_tag, 4);
+  out.put(static_cast<char>(100));
+  format::write_string(out, "x");
+  std::stringstream in(out.str());
+  EXPECT_THROW(structured_binary_reader::parse(in), std::invalid_argument);
+}
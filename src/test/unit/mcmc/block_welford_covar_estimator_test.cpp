@@ -0,0 +1,71 @@
+#include <stan/mcmc/block_welford_covar_estimator.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+std::vector<Eigen::VectorXd> draws(int n, int num_draws) {
+  std::vector<Eigen::VectorXd> result;
+  for (int i = 0; i < num_draws; ++i) {
+    Eigen::VectorXd q(n);
+    for (int k = 0; k < n; ++k)
+      q(k) = 1e3 + (k + 1) * std::sin(1.7 * i + k) + 0.1 * i * k;
+    result.push_back(q);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(McmcBlockWelfordCovarEstimator, matches_two_pass) {
+  const int n = 4;
+  for (int block_size : {1, 3, 32}) {
+    for (int num_draws : {2, 7, 50}) {
+      std::vector<Eigen::VectorXd> qs = draws(n, num_draws);
+      stan::mcmc::block_welford_covar_estimator estimator(n, block_size);
+      for (const Eigen::VectorXd& q : qs)
+        estimator.add_sample(q);
+      EXPECT_EQ(num_draws, estimator.num_samples());
+
+      Eigen::VectorXd mean = Eigen::VectorXd::Zero(n);
+      for (const Eigen::VectorXd& q : qs)
+        mean += q / num_draws;
+      Eigen::MatrixXd covar = Eigen::MatrixXd::Zero(n, n);
+      for (const Eigen::VectorXd& q : qs)
+        covar += (q - mean) * (q - mean).transpose() / (num_draws - 1.0);
+
+      Eigen::VectorXd estimated_mean;
+      Eigen::MatrixXd estimated_covar;
+      estimator.sample_mean(estimated_mean);
+      estimator.sample_covariance(estimated_covar);
+      for (int i = 0; i < n; ++i) {
+        EXPECT_NEAR(mean(i), estimated_mean(i), 1e-9);
+        for (int j = 0; j < n; ++j)
+          EXPECT_NEAR(covar(i, j), estimated_covar(i, j), 1e-9);
+      }
+    }
+  }
+}
+
+TEST(McmcBlockWelfordCovarEstimator, interleaved_reads_and_restart) {
+  const int n = 3;
+  std::vector<Eigen::VectorXd> qs = draws(n, 40);
+  stan::mcmc::block_welford_covar_estimator estimator(n, 8);
+  stan::mcmc::block_welford_covar_estimator reference(n, 1);
+  Eigen::MatrixXd covar = Eigen::MatrixXd::Zero(n, n);
+  Eigen::MatrixXd reference_covar = Eigen::MatrixXd::Zero(n, n);
+
+  estimator.add_sample(qs[0]);
+  estimator.sample_covariance(covar);
+  EXPECT_TRUE(covar.isZero());
+
+  estimator.restart();
+  EXPECT_EQ(0, estimator.num_samples());
+  for (int i = 0; i < 40; ++i) {
+    estimator.add_sample(qs[i]);
+    reference.add_sample(qs[i]);
+    if (i % 5 == 4) {
+      estimator.sample_covariance(covar);
+      reference.sample_covariance(reference_covar);
+      EXPECT_TRUE(covar.isApprox(reference_covar, 1e-10));
+    }
+  }
+}
@@ -0,0 +1,46 @@
+#include <stan/mcmc/block_welford_var_estimator.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(McmcBlockWelfordVarEstimator, matches_two_pass) {
+  const int n = 4;
+  for (int block_size : {1, 3, 32}) {
+    for (int num_draws : {2, 7, 50}) {
+      std::vector<Eigen::VectorXd> qs;
+      for (int i = 0; i < num_draws; ++i) {
+        Eigen::VectorXd q(n);
+        for (int k = 0; k < n; ++k)
+          q(k) = 1e3 + (k + 1) * std::sin(1.7 * i + k);
+        qs.push_back(q);
+      }
+      stan::mcmc::block_welford_var_estimator estimator(n, block_size);
+      for (const Eigen::VectorXd& q : qs)
+        estimator.add_sample(q);
+      EXPECT_EQ(num_draws, estimator.num_samples());
+
+      Eigen::VectorXd mean = Eigen::VectorXd::Zero(n);
+      for (const Eigen::VectorXd& q : qs)
+        mean += q / num_draws;
+      Eigen::VectorXd var = Eigen::VectorXd::Zero(n);
+      for (const Eigen::VectorXd& q : qs)
+        var += (q - mean).cwiseAbs2() / (num_draws - 1.0);
+
+      Eigen::VectorXd estimated_mean;
+      Eigen::VectorXd estimated_var;
+      estimator.sample_mean(estimated_mean);
+      estimator.sample_variance(estimated_var);
+      for (int i = 0; i < n; ++i) {
+        EXPECT_NEAR(mean(i), estimated_mean(i), 1e-9);
+        EXPECT_NEAR(var(i), estimated_var(i), 1e-9);
+      }
+    }
+  }
+
+  stan::mcmc::block_welford_var_estimator estimator(n);
+  estimator.add_sample(Eigen::VectorXd::Ones(n));
+  Eigen::VectorXd var = Eigen::VectorXd::Zero(n);
+  estimator.sample_variance(var);
+  EXPECT_TRUE(var.isZero());
+  estimator.restart();
+  EXPECT_EQ(0, estimator.num_samples());
+}
@@ -1,6 +1,9 @@
 #include <stan/mcmc/chains.hpp>
 #include <stan/io/stan_csv_reader.hpp>
+#include <stan/callbacks/binary_writer.hpp>
+#include <stan/io/stan_binary_reader.hpp>
 #include <gtest/gtest.h>
+#include <cmath>
 #include <set>
 #include <exception>
 #include <utility>
@@ -49,6 +52,37 @@ TEST_F(McmcChains, constructor) {
   EXPECT_EQ(1000, chains2.num_samples(0));
 }
 
+TEST_F(McmcChains, binary_constructor) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  EXPECT_EQ("", out.str());
+
+  std::stringstream binary;
+  {
+    stan::callbacks::binary_writer<std::stringstream> writer(
+        std::make_unique<std::stringstream>());
+    writer(blocker1.header);
+    Eigen::MatrixXd draws = blocker1.samples.transpose();
+    writer(draws);
+    writer.flush();
+    binary << writer.get_stream().rdbuf();
+  }
+  stan::io::stan_binary blocker1_binary
+      = stan::io::stan_binary_reader::parse(binary, &out);
+  EXPECT_EQ("", out.str());
+
+  stan::mcmc::chains<> chains_csv(blocker1);
+  stan::mcmc::chains<> chains_binary(blocker1_binary);
+  EXPECT_EQ(1, chains_binary.num_chains());
+  EXPECT_EQ(chains_csv.num_params(), chains_binary.num_params());
+  EXPECT_EQ(chains_csv.num_samples(0), chains_binary.num_samples(0));
+  for (int i = 0; i < chains_csv.num_params(); i++) {
+    EXPECT_EQ(chains_csv.param_name(i), chains_binary.param_name(i));
+    EXPECT_TRUE(chains_csv.samples(0, i) == chains_binary.samples(0, i));
+  }
+}
+
 TEST_F(McmcChains, add) {
   std::stringstream out;
   stan::io::stan_csv blocker1
@@ -136,6 +170,41 @@ TEST_F(McmcChains, add) {
       << "validate state is identical to before";
 }
 
+TEST_F(McmcChains, add_in_batches) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  EXPECT_EQ("", out.str());
+
+  stan::mcmc::chains<> expected(blocker1);
+  expected.set_warmup(100);
+
+  stan::mcmc::chains<> chains(blocker1.header);
+  chains.add(0, blocker1.samples.topRows(1));
+  chains.reserve(0, 500);
+  for (int row = 1; row < blocker1.samples.rows(); row += 7) {
+    int n = std::min<int>(7, blocker1.samples.rows() - row);
+    chains.add(0, blocker1.samples.middleRows(row, n));
+  }
+  chains.set_warmup(100);
+
+  EXPECT_EQ(expected.num_samples(0), chains.num_samples(0));
+  EXPECT_EQ(expected.num_kept_samples(0), chains.num_kept_samples(0));
+  for (int index = 0; index < chains.num_params(); ++index) {
+    EXPECT_TRUE(expected.samples(0, index) == chains.samples(0, index));
+  }
+  EXPECT_FLOAT_EQ(expected.split_effective_sample_size(0),
+                  chains.split_effective_sample_size(0));
+  EXPECT_FLOAT_EQ(expected.split_effective_sample_size("sigmasq_delta"),
+                  chains.split_effective_sample_size("sigmasq_delta"));
+
+  chains.add(blocker1.samples);
+  EXPECT_EQ(2, chains.num_chains());
+  EXPECT_EQ(1000, chains.num_samples(0));
+  EXPECT_EQ(1000, chains.num_samples(1));
+  EXPECT_TRUE(expected.samples(0, 3) == chains.samples(0, 3));
+}
+
 TEST_F(McmcChains, add_adapter) {
   std::stringstream out;
   stan::io::stan_csv blocker1
@@ -220,6 +289,89 @@ TEST_F(McmcChains, blocker_num_samples) {
   EXPECT_EQ(1000, chains.num_samples(1));
 }
 
+TEST_F(McmcChains, read_stan_csv_files) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  stan::mcmc::chains<> expected(blocker1);
+  expected.add(blocker2);
+
+  std::vector<std::string> files{
+      "src/test/unit/mcmc/test_csv_files/blocker.1.csv",
+      "src/test/unit/mcmc/test_csv_files/blocker.2.csv"};
+  stan::mcmc::chains<> chains
+      = stan::mcmc::chains<>::read_stan_csv_files(files, &out);
+  EXPECT_EQ("", out.str());
+
+  ASSERT_EQ(expected.num_chains(), chains.num_chains());
+  ASSERT_EQ(expected.num_params(), chains.num_params());
+  for (int i = 0; i < expected.num_params(); ++i)
+    EXPECT_EQ(expected.param_name(i), chains.param_name(i));
+  for (int chain = 0; chain < expected.num_chains(); ++chain) {
+    EXPECT_EQ(expected.num_samples(chain), chains.num_samples(chain));
+    EXPECT_EQ(expected.warmup(chain), chains.warmup(chain));
+    for (int i = 0; i < expected.num_params(); ++i)
+      EXPECT_TRUE(expected.samples(chain, i) == chains.samples(chain, i));
+  }
+}
+
+TEST_F(McmcChains, read_stan_csv_files_errors) {
+  std::vector<std::string> mismatched{
+      "src/test/unit/mcmc/test_csv_files/blocker.1.csv",
+      "src/test/unit/mcmc/test_csv_files/epil.1.csv"};
+  EXPECT_THROW(stan::mcmc::chains<>::read_stan_csv_files(mismatched),
+               std::invalid_argument);
+
+  std::vector<std::string> missing{
+      "src/test/unit/mcmc/test_csv_files/blocker.1.csv",
+      "src/test/unit/mcmc/test_csv_files/missing.csv"};
+  EXPECT_THROW(stan::mcmc::chains<>::read_stan_csv_files(missing),
+               std::invalid_argument);
+
+  EXPECT_THROW(stan::mcmc::chains<>::read_stan_csv_files({}),
+               std::invalid_argument);
+}
+
+TEST_F(McmcChains, float_storage) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+  stan::mcmc::chains<float> float_chains(blocker1);
+  std::vector<stan::io::stan_csv> csvs{blocker2};
+  float_chains.add(std::move(csvs));
+  chains.set_warmup(100);
+  float_chains.set_warmup(100);
+
+  ASSERT_EQ(chains.num_chains(), float_chains.num_chains());
+  EXPECT_EQ(chains.num_kept_samples(), float_chains.num_kept_samples());
+  Eigen::VectorXd probs(2);
+  probs << 0.1, 0.9;
+  stan::mcmc::chains_summary summary = chains.summary(probs);
+  stan::mcmc::chains_summary float_summary = float_chains.summary(probs);
+  for (int index = 4; index < chains.num_params(); ++index) {
+    EXPECT_TRUE(chains.samples(index).cast<float>().cast<double>()
+                == float_chains.samples(index));
+    EXPECT_NEAR(chains.mean(index), float_chains.mean(index),
+                1e-6 * std::fabs(chains.mean(index)) + 1e-8);
+    EXPECT_NEAR(chains.effective_sample_size(index),
+                float_chains.effective_sample_size(index),
+                1e-3 * chains.effective_sample_size(index));
+    EXPECT_NEAR(chains.split_potential_scale_reduction(index),
+                float_chains.split_potential_scale_reduction(index), 1e-4);
+    EXPECT_FLOAT_EQ(float_chains.mean(index), float_summary.mean(index));
+    EXPECT_FLOAT_EQ(float_chains.effective_sample_size(index),
+                    float_summary.effective_sample_size(index));
+    EXPECT_NEAR(summary.quantiles(index, 0), float_summary.quantiles(index, 0),
+                1e-6 * std::fabs(summary.quantiles(index, 0)) + 1e-8);
+  }
+}
+
 TEST_F(McmcChains, blocker1_param_names) {
   std::stringstream out;
   stan::io::stan_csv blocker1
@@ -938,3 +1090,84 @@ TEST_F(McmcChains, blocker_split_potential_scale_reduction_rank) {
               chains.split_potential_scale_reduction_rank(name));
   }
 }
+
+TEST_F(McmcChains, quantiles_all_params) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  EXPECT_EQ("", out.str());
+
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+  chains.set_warmup(100);
+
+  // Unsorted, repeated probabilities are selected in one pass
+  Eigen::VectorXd probs(6);
+  probs << 0.95, 0.05, 0.5, 0.5, 0.25, 0.999;
+  Eigen::MatrixXd quantiles = chains.quantiles(probs);
+  ASSERT_EQ(chains.num_params(), quantiles.rows());
+  ASSERT_EQ(6, quantiles.cols());
+  for (int index = 0; index < chains.num_params(); ++index) {
+    for (int k = 0; k < probs.size(); ++k)
+      EXPECT_EQ(chains.quantile(index, probs(k)), quantiles(index, k))
+          << chains.param_name(index) << " " << probs(k);
+    Eigen::VectorXd param_quantiles = chains.quantiles(index, probs);
+    for (int k = 0; k < probs.size(); ++k)
+      EXPECT_EQ(param_quantiles(k), quantiles(index, k));
+  }
+}
+
+TEST_F(McmcChains, summary) {
+  std::stringstream out;
+  stan::io::stan_csv blocker1
+      = stan::io::stan_csv_reader::parse(blocker1_stream, &out);
+  stan::io::stan_csv blocker2
+      = stan::io::stan_csv_reader::parse(blocker2_stream, &out);
+  EXPECT_EQ("", out.str());
+
+  stan::mcmc::chains<> chains(blocker1);
+  chains.add(blocker2);
+  chains.set_warmup(100);
+
+  Eigen::VectorXd probs(3);
+  probs << 0.05, 0.5, 0.95;
+  stan::mcmc::chains_summary summary = chains.summary(probs);
+  ASSERT_EQ(chains.num_params(), summary.mean.size());
+  ASSERT_EQ(chains.num_params(), summary.quantiles.rows());
+  ASSERT_EQ(3, summary.quantiles.cols());
+  for (int index = 0; index < chains.num_params(); ++index) {
+    EXPECT_FLOAT_EQ(chains.mean(index), summary.mean(index));
+    EXPECT_FLOAT_EQ(chains.sd(index), summary.sd(index));
+    Eigen::VectorXd quantiles = chains.quantiles(index, probs);
+    for (int k = 0; k < probs.size(); ++k)
+      EXPECT_EQ(quantiles(k), summary.quantiles(index, k))
+          << chains.param_name(index) << " " << probs(k);
+    double ess = chains.effective_sample_size(index);
+    double rhat = chains.split_potential_scale_reduction(index);
+    if (std::isnan(ess)) {
+      EXPECT_TRUE(std::isnan(summary.effective_sample_size(index)));
+    } else {
+      EXPECT_EQ(ess, summary.effective_sample_size(index));
+    }
+    if (std::isnan(rhat)) {
+      EXPECT_TRUE(std::isnan(summary.split_potential_scale_reduction(index)));
+    } else {
+      EXPECT_EQ(rhat, summary.split_potential_scale_reduction(index));
+    }
+    std::pair<double, double> rhat_rank
+        = chains.split_potential_scale_reduction_rank(index);
+    if (std::isnan(rhat_rank.first)) {
+      EXPECT_TRUE(
+          std::isnan(summary.split_potential_scale_reduction_rank(index, 0)));
+      EXPECT_TRUE(
+          std::isnan(summary.split_potential_scale_reduction_rank(index, 1)));
+    } else {
+      EXPECT_EQ(rhat_rank.first,
+                summary.split_potential_scale_reduction_rank(index, 0));
+      EXPECT_EQ(rhat_rank.second,
+                summary.split_potential_scale_reduction_rank(index, 1));
+    }
+  }
+}
@@ -0,0 +1,185 @@
+#include <stan/mcmc/checkpoint.hpp>
+#include <stan/mcmc/covar_adaptation.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
+#include <stan/mcmc/hmc/nuts/diag_e_nuts.hpp>
+#include <stan/mcmc/stepsize_adaptation.hpp>
+#include <stan/mcmc/var_adaptation.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/mcmc/hmc/mock_hmc.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+namespace {
+Eigen::VectorXd draw(int n, int k) {
+  Eigen::VectorXd q(n);
+  for (int i = 0; i < n; ++i)
+    q(i) = std::sin(0.7 * k + 1.3 * i) * (i + 1);
+  return q;
+}
+}  // namespace
+
+TEST(McmcCheckpoint, stepsize_adaptation) {
+  stan::mcmc::stepsize_adaptation adaptation;
+  adaptation.set_mu(std::log(10 * 0.3));
+  adaptation.set_delta(0.9);
+  double epsilon = 0.3;
+  for (int k = 0; k < 7; ++k)
+    adaptation.learn_stepsize(epsilon, 0.1 * k);
+
+  std::stringstream checkpoint;
+  stan::mcmc::checkpoint_writer writer(checkpoint);
+  adaptation.write_checkpoint(writer);
+
+  stan::mcmc::stepsize_adaptation restored;
+  stan::mcmc::checkpoint_reader reader(checkpoint);
+  restored.read_checkpoint(reader);
+  EXPECT_EQ(adaptation.get_mu(), restored.get_mu());
+  EXPECT_EQ(adaptation.get_delta(), restored.get_delta());
+  EXPECT_EQ(adaptation.get_x_bar(), restored.get_x_bar());
+
+  double restored_epsilon = epsilon;
+  adaptation.learn_stepsize(epsilon, 0.8);
+  restored.learn_stepsize(restored_epsilon, 0.8);
+  EXPECT_EQ(epsilon, restored_epsilon);
+}
+
+TEST(McmcCheckpoint, var_adaptation_within_window) {
+  stan::test::unit::instrumented_logger logger;
+  const int n = 3;
+  stan::mcmc::var_adaptation adaptation(n);
+  adaptation.set_window_params(100, 15, 10, 25, logger);
+
+  Eigen::VectorXd var = Eigen::VectorXd::Ones(n);
+  // The second window is open, with draws pending in the estimator
+  for (int k = 0; k < 47; ++k)
+    adaptation.learn_variance(var, draw(n, k));
+
+  std::stringstream checkpoint;
+  stan::mcmc::checkpoint_writer writer(checkpoint);
+  adaptation.write_checkpoint(writer);
+
+  stan::mcmc::var_adaptation restored(n);
+  stan::mcmc::checkpoint_reader reader(checkpoint);
+  restored.read_checkpoint(reader);
+
+  Eigen::VectorXd restored_var = var;
+  for (int k = 47; k < 100; ++k) {
+    bool ended = adaptation.learn_variance(var, draw(n, k));
+    EXPECT_EQ(ended, restored.learn_variance(restored_var, draw(n, k)));
+    for (int i = 0; i < n; ++i)
+      EXPECT_EQ(var(i), restored_var(i));
+  }
+}
+
+TEST(McmcCheckpoint, covar_adaptation_within_window) {
+  stan::test::unit::instrumented_logger logger;
+  const int n = 3;
+  stan::mcmc::covar_adaptation adaptation(n);
+  adaptation.set_window_params(100, 15, 10, 25, logger);
+
+  Eigen::MatrixXd covar = Eigen::MatrixXd::Identity(n, n);
+  for (int k = 0; k < 47; ++k)
+    adaptation.learn_covariance(covar, draw(n, k));
+
+  std::stringstream checkpoint;
+  stan::mcmc::checkpoint_writer writer(checkpoint);
+  adaptation.write_checkpoint(writer);
+
+  stan::mcmc::covar_adaptation restored(n);
+  stan::mcmc::checkpoint_reader reader(checkpoint);
+  restored.read_checkpoint(reader);
+
+  Eigen::MatrixXd restored_covar = covar;
+  for (int k = 47; k < 100; ++k) {
+    bool ended = adaptation.learn_covariance(covar, draw(n, k));
+    EXPECT_EQ(ended, restored.learn_covariance(restored_covar, draw(n, k)));
+    for (int i = 0; i < n * n; ++i)
+      EXPECT_EQ(covar(i), restored_covar(i));
+  }
+}
+
+TEST(McmcCheckpoint, dimension_mismatch) {
+  stan::mcmc::var_adaptation adaptation(3);
+  std::stringstream checkpoint;
+  stan::mcmc::checkpoint_writer writer(checkpoint);
+  adaptation.write_checkpoint(writer);
+
+  stan::mcmc::var_adaptation restored(4);
+  stan::mcmc::checkpoint_reader reader(checkpoint);
+  EXPECT_THROW(restored.read_checkpoint(reader), std::runtime_error);
+}
+
+TEST(McmcCheckpoint, adaptive_sampler_resumes) {
+  std::stringstream output;
+  stan::callbacks::stream_logger logger(output, output, output, output,
+                                        output);
+  const int n = 2;
+  stan::mcmc::mock_model model(n);
+
+  stan::rng_t rng = stan::services::util::create_rng(3, 1);
+  stan::mcmc::adapt_diag_e_nuts<stan::mcmc::mock_model, stan::rng_t> sampler(
+      model, rng);
+  sampler.set_window_params(60, 15, 10, 20, logger);
+  sampler.get_stepsize_adaptation().set_mu(std::log(10 * 0.5));
+  sampler.set_nominal_stepsize(0.5);
+  sampler.set_max_depth(3);
+  sampler.engage_adaptation();
+
+  stan::mcmc::sample s(draw(n, 0), 0, 0);
+  for (int m = 0; m < 30; ++m)
+    s = sampler.transition(s, logger);
+
+  std::stringstream checkpoint;
+  stan::mcmc::write_checkpoint(sampler, 30, checkpoint);
+
+  stan::rng_t restored_rng = stan::services::util::create_rng(0, 0);
+  stan::mcmc::adapt_diag_e_nuts<stan::mcmc::mock_model, stan::rng_t>
+      restored(model, restored_rng);
+  restored.set_max_depth(3);
+  EXPECT_EQ(30, stan::mcmc::read_checkpoint(restored, checkpoint));
+  EXPECT_TRUE(restored.adapting());
+
+  stan::mcmc::sample restored_s(restored.z().q, -restored.z().V, 0);
+  for (int m = 30; m < 60; ++m) {
+    s = sampler.transition(s, logger);
+    restored_s = restored.transition(restored_s, logger);
+    for (int i = 0; i < n; ++i)
+      EXPECT_EQ(s.cont_params()(i), restored_s.cont_params()(i));
+    EXPECT_EQ(sampler.get_nominal_stepsize(), restored.get_nominal_stepsize());
+    for (int i = 0; i < n; ++i)
+      EXPECT_EQ(sampler.z().inv_e_metric_(i), restored.z().inv_e_metric_(i));
+  }
+}
+
+TEST(McmcCheckpoint, rejects_other_sampler) {
+  std::stringstream output;
+  stan::callbacks::stream_logger logger(output, output, output, output,
+                                        output);
+  stan::mcmc::mock_model model(2);
+  stan::rng_t rng = stan::services::util::create_rng(3, 1);
+  stan::mcmc::diag_e_nuts<stan::mcmc::mock_model, stan::rng_t> sampler(model,
+                                                                      rng);
+  std::stringstream checkpoint;
+  stan::mcmc::write_checkpoint(sampler, 5, checkpoint);
+  std::string contents = checkpoint.str();
+
+  stan::mcmc::adapt_diag_e_nuts<stan::mcmc::mock_model, stan::rng_t> adaptive(
+      model, rng);
+  std::stringstream other_sampler(contents);
+  EXPECT_THROW(stan::mcmc::read_checkpoint(adaptive, other_sampler),
+               std::runtime_error);
+
+  stan::mcmc::diag_e_nuts<stan::mcmc::mock_model, stan::rng_t> restored(model,
+                                                                       rng);
+  std::stringstream truncated(contents.substr(0, contents.size() - 4));
+  EXPECT_THROW(stan::mcmc::read_checkpoint(restored, truncated),
+               std::runtime_error);
+
+  std::stringstream not_a_checkpoint("Step size = 0.5");
+  EXPECT_THROW(stan::mcmc::read_checkpoint(restored, not_a_checkpoint),
+               std::runtime_error);
+}
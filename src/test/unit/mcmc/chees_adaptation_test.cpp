@@ -0,0 +1,102 @@
+#include <stan/mcmc/chees_adaptation.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+// Holds the statistics of the last transition of a chain
+struct mock_chees_sampler {
+  struct point {
+    Eigen::VectorXd q;
+  };
+  point z_;
+  Eigen::VectorXd q0, q1, v1, inv_metric;
+  double accept = 1;
+  double epsilon = 0.5;
+  double T = 1;
+
+  point& z() { return z_; }
+  double get_nominal_stepsize() const { return epsilon; }
+  double get_T() const { return T; }
+  int num_steps() const { return 2; }
+  const Eigen::VectorXd& initial_position() const { return q0; }
+  const Eigen::VectorXd& proposed_position() const { return q1; }
+  const Eigen::VectorXd& proposed_velocity() const { return v1; }
+  double accept_prob() const { return accept; }
+  void set_nominal_stepsize_and_T(double e, double t) {
+    epsilon = e;
+    T = t;
+  }
+  void set_metric(const Eigen::VectorXd& m) { inv_metric = m; }
+};
+
+std::vector<mock_chees_sampler> make_samplers(double spread) {
+  std::vector<mock_chees_sampler> samplers(4);
+  for (int k = 0; k < 4; ++k) {
+    samplers[k].q0 = Eigen::VectorXd::Constant(2, 0.1 * k);
+    samplers[k].q1 = Eigen::VectorXd::Constant(2, spread * k);
+    samplers[k].v1 = Eigen::VectorXd::Constant(2, k - 1.5);
+    samplers[k].z_.q = samplers[k].q1;
+  }
+  return samplers;
+}
+}  // namespace
+
+TEST(McmcCheesAdaptation, jitter) {
+  EXPECT_FLOAT_EQ(0.5, stan::mcmc::chees_adaptation::jitter(0));
+  EXPECT_FLOAT_EQ(0.25, stan::mcmc::chees_adaptation::jitter(1));
+  EXPECT_FLOAT_EQ(0.75, stan::mcmc::chees_adaptation::jitter(2));
+  EXPECT_FLOAT_EQ(0.125, stan::mcmc::chees_adaptation::jitter(3));
+  EXPECT_FLOAT_EQ(0.625, stan::mcmc::chees_adaptation::jitter(4));
+}
+
+TEST(McmcCheesAdaptation, learn_shares_settings) {
+  stan::mcmc::chees_adaptation adaptation;
+  adaptation.set_metric_adaptation_end(10);
+  std::vector<mock_chees_sampler> samplers = make_samplers(1);
+  samplers[2].accept = 0.5;
+  adaptation.learn(samplers);
+
+  for (auto& sampler : samplers) {
+    EXPECT_FLOAT_EQ(samplers[0].epsilon, sampler.epsilon);
+    EXPECT_FLOAT_EQ(samplers[0].T, sampler.T);
+    ASSERT_EQ(2, sampler.inv_metric.size());
+  }
+  // Positions 0, 1, 2, 3 have variance 5 / 3
+  const double var = (4 / 9.0) * (5 / 3.0) + 1e-3 * (5 / 9.0);
+  EXPECT_FLOAT_EQ(var, samplers[0].inv_metric(0));
+  EXPECT_FLOAT_EQ(var, samplers[0].inv_metric(1));
+}
+
+TEST(McmcCheesAdaptation, integration_time_follows_gradient) {
+  // Proposals moving apart along their velocities lengthen the time
+  stan::mcmc::chees_adaptation longer;
+  longer.get_stepsize_adaptation().set_mu(std::log(0.01));
+  std::vector<mock_chees_sampler> samplers = make_samplers(1);
+  longer.learn(samplers);
+  EXPECT_GT(samplers[0].T, 1);
+
+  // Proposals closer together than the initial positions shorten it
+  stan::mcmc::chees_adaptation shorter;
+  shorter.get_stepsize_adaptation().set_mu(std::log(0.01));
+  samplers = make_samplers(0.01);
+  for (auto& sampler : samplers) {
+    sampler.q0 *= 10;
+    sampler.T = 2;
+  }
+  shorter.learn(samplers);
+  EXPECT_LT(samplers[0].T, 2);
+}
+
+TEST(McmcCheesAdaptation, integration_time_bounded) {
+  stan::mcmc::chees_adaptation adaptation;
+  adaptation.set_max_num_steps(3);
+  adaptation.set_learning_rate(100);
+  std::vector<mock_chees_sampler> samplers = make_samplers(1);
+  adaptation.learn(samplers);
+  EXPECT_FLOAT_EQ(3 * samplers[0].epsilon, samplers[0].T);
+
+  adaptation.complete_adaptation(samplers);
+  EXPECT_LE(samplers[0].T, 3 * samplers[0].epsilon * (1 + 1e-12));
+  EXPECT_GE(samplers[0].T, samplers[0].epsilon);
+}
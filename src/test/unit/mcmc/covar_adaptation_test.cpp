@@ -27,3 +27,38 @@ TEST(McmcCovarAdaptation, learn_covariance) {
   }
   EXPECT_EQ(0, logger.call_count());
 }
+
+TEST(McmcCovarAdaptation, pool_windows) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 3;
+  const int n_learn = 10;
+
+  stan::mcmc::covar_adaptation adapter1(n);
+  stan::mcmc::covar_adaptation adapter2(n);
+  stan::mcmc::covar_adaptation adapter_all(n);
+  adapter1.set_window_params(50, 0, 0, n_learn, logger);
+  adapter2.set_window_params(50, 0, 0, n_learn, logger);
+  adapter_all.set_window_params(100, 0, 0, 2 * n_learn, logger);
+
+  Eigen::MatrixXd covar(Eigen::MatrixXd::Zero(n, n));
+  Eigen::MatrixXd covar_all(Eigen::MatrixXd::Zero(n, n));
+  for (int i = 0; i < n_learn; ++i) {
+    Eigen::VectorXd q1(n), q2(n);
+    q1 << i, 0.5 * i * i, -i;
+    q2 << 3 + i, 1 - i, 2 * i;
+    adapter1.learn_covariance(covar, q1);
+    adapter2.learn_covariance(covar, q2);
+    adapter_all.learn_covariance(covar_all, q1);
+    adapter_all.learn_covariance(covar_all, q2);
+  }
+
+  Eigen::MatrixXd pooled(Eigen::MatrixXd::Zero(n, n));
+  stan::mcmc::covar_adaptation::pool_windows(pooled, {&adapter1, &adapter2});
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      EXPECT_FLOAT_EQ(covar_all(i, j), pooled(i, j));
+    }
+  }
+}
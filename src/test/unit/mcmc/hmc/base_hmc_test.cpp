@@ -3,6 +3,9 @@
 #include <stan/mcmc/hmc/base_hmc.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
 #include <test/unit/util.hpp>
 #include <gtest/gtest.h>
 
@@ -26,6 +29,42 @@ class mock_hmc : public base_hmc<mock_model, mock_hamiltonian, mock_integrator,
   void get_sampler_params(std::vector<double>& values) {}
 };
 
+// Hamiltonian whose energy grows with the step size of the mock
+// integrator, for the step size search to settle on
+template <typename Model, typename BaseRNG>
+class probe_hamiltonian : public mock_hamiltonian<Model, BaseRNG> {
+ public:
+  explicit probe_hamiltonian(const Model& model)
+      : mock_hamiltonian<Model, BaseRNG>(model) {}
+
+  double T(ps_point& z) {
+    return 0.5 * z.p.squaredNorm() + 0.5 * z.q.squaredNorm();
+  }
+
+  void sample_p(ps_point& z, BaseRNG& rng) {
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_gaus(rng, boost::normal_distribution<>());
+    for (int i = 0; i < z.p.size(); ++i)
+      z.p(i) = rand_gaus();
+  }
+};
+
+class probe_hmc : public base_hmc<mock_model, probe_hamiltonian,
+                                  mock_integrator, stan::rng_t> {
+ public:
+  probe_hmc(const mock_model& m, stan::rng_t& rng)
+      : base_hmc<mock_model, probe_hamiltonian, mock_integrator, stan::rng_t>(
+          m, rng) {}
+
+  sample transition(sample& init_sample, callbacks::logger& logger) {
+    return init_sample;
+  }
+
+  void get_sampler_param_names(std::vector<std::string>& names) {}
+
+  void get_sampler_params(std::vector<double>& values) {}
+};
+
 }  // namespace mcmc
 
 }  // namespace stan
@@ -67,6 +106,30 @@ TEST(McmcBaseHMC, seed) {
     EXPECT_EQ(q(i), sampler.z().q(i));
 }
 
+TEST(McmcBaseHMC, seed_with_gradient) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  Eigen::VectorXd q(2);
+  q << 5, 1;
+  Eigen::VectorXd gradient(2);
+  gradient << -1, 2;
+
+  stan::mcmc::mock_model model(q.size());
+  stan::mcmc::mock_hmc sampler(model, base_rng);
+  stan::callbacks::logger logger;
+
+  sampler.seed(q, -3, gradient);
+  EXPECT_EQ(q, sampler.z().q);
+  EXPECT_EQ(3, sampler.z().V);
+  EXPECT_EQ(-gradient, sampler.z().g);
+
+  sampler.init_hamiltonian(logger);
+  EXPECT_EQ(0, sampler.num_gradient_evaluations());
+  EXPECT_EQ(1, sampler.num_gradient_cache_hits());
+  EXPECT_EQ(3, sampler.z().V);
+  EXPECT_EQ(-gradient, sampler.z().g);
+}
+
 TEST(McmcBaseHMC, set_nominal_stepsize) {
   stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
 
@@ -128,3 +191,37 @@ TEST(McmcBaseHMC, streams) {
   EXPECT_EQ("", stan::test::cout_ss.str());
   EXPECT_EQ("", stan::test::cerr_ss.str());
 }
+
+TEST(McmcBaseHMC, init_stepsize_concurrent_probes) {
+  stan::test::unit::instrumented_logger logger;
+  Eigen::VectorXd q(2);
+  q << 0.5, -0.25;
+  stan::mcmc::mock_model model(q.size());
+
+  for (double initial_stepsize : {1e-3, 0.1, 50.0}) {
+    for (int num_probes : {2, 3, 8}) {
+      stan::rng_t rng = stan::services::util::create_rng(7, 0);
+      stan::rng_t concurrent_rng = stan::services::util::create_rng(7, 0);
+      stan::mcmc::probe_hmc sampler(model, rng);
+      stan::mcmc::probe_hmc concurrent_sampler(model, concurrent_rng);
+      sampler.seed(q);
+      concurrent_sampler.seed(q);
+      sampler.set_nominal_stepsize(initial_stepsize);
+      concurrent_sampler.set_nominal_stepsize(initial_stepsize);
+      concurrent_sampler.set_stepsize_search_probes(num_probes);
+
+      sampler.init_stepsize(logger);
+      concurrent_sampler.init_stepsize(logger);
+
+      EXPECT_EQ(sampler.get_nominal_stepsize(),
+                concurrent_sampler.get_nominal_stepsize());
+      EXPECT_NE(initial_stepsize, sampler.get_nominal_stepsize());
+      EXPECT_EQ(q, concurrent_sampler.z().q);
+      // The generators are left in the same state
+      EXPECT_EQ(rng(), concurrent_rng());
+      EXPECT_GE(concurrent_sampler.num_gradient_evaluations(),
+                sampler.num_gradient_evaluations());
+    }
+  }
+  EXPECT_EQ(0, logger.call_count());
+}
@@ -0,0 +1,68 @@
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/mcmc/hmc/chees/diag_e_chees_hmc.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/lockstep_driver.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using chees_sampler
+    = stan::mcmc::diag_e_chees_hmc<gauss3D_model_namespace::gauss3D_model,
+                                   stan::rng_t>;
+
+TEST(McmcCheesHmc, num_steps) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+  chees_sampler sampler(model, base_rng);
+
+  sampler.set_nominal_stepsize_and_T(0.1, 1);
+  EXPECT_EQ(10, sampler.num_steps());
+  sampler.set_jitter(0.25);
+  EXPECT_FLOAT_EQ(0.25, sampler.get_jitter());
+  EXPECT_EQ(3, sampler.num_steps());
+  sampler.set_jitter(1e-6);
+  EXPECT_EQ(1, sampler.num_steps());
+  sampler.set_jitter(0);
+  EXPECT_FLOAT_EQ(1e-6, sampler.get_jitter());
+}
+
+TEST(McmcCheesHmc, lockstep_matches_transition) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+
+  std::vector<stan::rng_t> rngs;
+  for (int k = 0; k < 4; ++k)
+    rngs.push_back(stan::services::util::create_rng(1234, k % 2));
+  // Chains 0 and 1 run in lockstep, chains 2 and 3 on their own with
+  // the same random numbers
+  std::vector<chees_sampler> lockstep;
+  std::vector<chees_sampler> single;
+  for (int k = 0; k < 4; ++k) {
+    auto& samplers = k < 2 ? lockstep : single;
+    samplers.emplace_back(model, rngs[k]);
+    samplers.back().set_nominal_stepsize_and_T(0.2, 1);
+    samplers.back().set_jitter(0.7);
+  }
+
+  std::vector<stan::mcmc::sample> samples(
+      2, stan::mcmc::sample(Eigen::VectorXd::Zero(model.num_params_r()), 0, 0));
+  stan::mcmc::lockstep_driver<gauss3D_model_namespace::gauss3D_model> driver(
+      model);
+  for (int n = 0; n < 5; ++n)
+    driver.transition(lockstep, samples, logger);
+
+  for (int k = 0; k < 2; ++k) {
+    stan::mcmc::sample s(Eigen::VectorXd::Zero(model.num_params_r()), 0, 0);
+    for (int n = 0; n < 5; ++n)
+      s = single[k].transition(s, logger);
+    EXPECT_TRUE(s.cont_params().isApprox(samples[k].cont_params()));
+    EXPECT_FLOAT_EQ(s.accept_stat(), samples[k].accept_stat());
+    EXPECT_EQ(lockstep[k].proposed_position().size(), model.num_params_r());
+  }
+  EXPECT_EQ("", error.str());
+}
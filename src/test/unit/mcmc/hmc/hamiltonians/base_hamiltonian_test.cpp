@@ -39,6 +39,73 @@ TEST(BaseHamiltonian, update_potential_gradient) {
   EXPECT_EQ("", fatal.str());
 }
 
+TEST(BaseHamiltonian, gradient_cache) {
+  stan::io::empty_var_context data_var_context;
+
+  std::stringstream model_output;
+  funnel_model_namespace::funnel_model model(data_var_context, 0,
+                                             &model_output);
+
+  stan::mcmc::mock_hamiltonian<funnel_model_namespace::funnel_model,
+                               stan::rng_t>
+      metric(model);
+  stan::mcmc::ps_point z(11);
+  z.q.setOnes();
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  metric.update_potential_gradient(z, logger);
+  EXPECT_EQ(1, metric.num_gradient_evaluations());
+  EXPECT_EQ(0, metric.num_gradient_cache_hits());
+
+  // Nothing is cached until a sampler stores a point
+  stan::mcmc::ps_point z_same(11);
+  z_same.q.setOnes();
+  metric.init(z_same, logger);
+  EXPECT_EQ(2, metric.num_gradient_evaluations());
+  EXPECT_EQ(0, metric.num_gradient_cache_hits());
+
+  // A stored point serves init at the same position
+  metric.cache_gradient(z);
+  z_same.V = 0;
+  z_same.g.setZero();
+  metric.init(z_same, logger);
+  EXPECT_EQ(2, metric.num_gradient_evaluations());
+  EXPECT_EQ(1, metric.num_gradient_cache_hits());
+  EXPECT_FLOAT_EQ(z.V, z_same.V);
+  for (int i = 0; i < z.q.size(); ++i)
+    EXPECT_FLOAT_EQ(z.g(i), z_same.g(i));
+
+  // Gradients along a trajectory never consult the cache
+  metric.update_potential_gradient(z_same, logger);
+  EXPECT_EQ(3, metric.num_gradient_evaluations());
+  EXPECT_EQ(1, metric.num_gradient_cache_hits());
+
+  // Evaluating another position leaves the entry in place
+  stan::mcmc::ps_point z_other(11);
+  z_other.q.setZero();
+  metric.update_potential_gradient(z_other, logger);
+  EXPECT_EQ(4, metric.num_gradient_evaluations());
+  metric.init(z_same, logger);
+  EXPECT_EQ(4, metric.num_gradient_evaluations());
+  EXPECT_EQ(2, metric.num_gradient_cache_hits());
+  EXPECT_FLOAT_EQ(10.73223197, z_same.V);
+
+  metric.set_gradient_cache(false);
+  metric.init(z_same, logger);
+  EXPECT_EQ(5, metric.num_gradient_evaluations());
+  EXPECT_EQ(2, metric.num_gradient_cache_hits());
+  EXPECT_FLOAT_EQ(10.73223197, z_same.V);
+
+  metric.reset_gradient_counters();
+  EXPECT_EQ(0, metric.num_gradient_evaluations());
+  EXPECT_EQ(0, metric.num_gradient_cache_hits());
+
+  EXPECT_EQ("", model_output.str());
+  EXPECT_EQ("", error.str());
+}
+
 TEST(BaseHamiltonian, streams) {
   stan::test::capture_std_streams();
 
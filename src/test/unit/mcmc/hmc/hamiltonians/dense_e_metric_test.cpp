@@ -59,6 +59,110 @@ TEST(McmcDenseEMetric, sample_p) {
               < 5.0 * sqrt(var(1, 1) / n_samples));
 }
 
+TEST(McmcDenseEMetric, add_derivatives) {
+  Eigen::Matrix2d m_inv;
+  m_inv << 2.0, 0.5, 0.5, 1.0;
+
+  stan::mcmc::mock_model model(2);
+  stan::mcmc::dense_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(model);
+  stan::mcmc::dense_e_point z(2);
+  z.set_metric(m_inv);
+  z.q << 0.3, -1.2;
+  z.p << 1.0, -3.0;
+  z.g << -0.7, 2.5;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  Eigen::VectorXd q = z.q;
+  Eigen::VectorXd expected_q = q + 0.1 * metric.dtau_dp(z);
+  metric.add_dtau_dp(z, 0.1, q);
+  Eigen::VectorXd p = z.p;
+  Eigen::VectorXd expected_p = p - 0.1 * metric.dphi_dq(z, logger);
+  metric.add_dphi_dq(z, -0.1, p, logger);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_FLOAT_EQ(expected_q(i), q(i));
+    EXPECT_FLOAT_EQ(expected_p(i), p(i));
+  }
+}
+
+TEST(McmcDenseEMetric, cached_metric) {
+  Eigen::Matrix2d m_inv;
+  m_inv << 2.0, 0.5, 0.5, 1.0;
+
+  stan::mcmc::mock_model model(2);
+  stan::mcmc::dense_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(model);
+  stan::mcmc::dense_e_point z(2);
+  z.set_metric(m_inv);
+  z.p << 1.0, -3.0;
+
+  Eigen::VectorXd v = m_inv * z.p;
+  EXPECT_FLOAT_EQ(0.5 * z.p.dot(v), metric.T(z));
+  EXPECT_FLOAT_EQ(v(0), metric.dtau_dp(z)(0));
+  EXPECT_FLOAT_EQ(v(1), metric.dtau_dp(z)(1));
+
+  // a new momentum is picked up
+  z.p << 0.5, 2.0;
+  v = m_inv * z.p;
+  EXPECT_FLOAT_EQ(v(0), metric.dtau_dp(z)(0));
+  EXPECT_FLOAT_EQ(0.5 * z.p.dot(v), metric.tau(z));
+
+  // so is a metric modified in place, once notified
+  z.inv_e_metric_(1, 1) = 4.0;
+  z.notify_metric_changed();
+  v = z.inv_e_metric_ * z.p;
+  EXPECT_FLOAT_EQ(v(1), metric.dtau_dp(z)(1));
+  Eigen::MatrixXd U = z.inv_e_metric_.llt().matrixU();
+  Eigen::MatrixXd cached_U = z.inv_e_metric_llt().matrixU();
+  EXPECT_FLOAT_EQ(U(0, 0), cached_U(0, 0));
+  EXPECT_FLOAT_EQ(U(0, 1), cached_U(0, 1));
+  EXPECT_FLOAT_EQ(U(1, 1), cached_U(1, 1));
+
+  // and by sampling the momentum
+  stan::rng_t rng_cached = stan::services::util::create_rng(0, 0);
+  stan::rng_t rng_direct = stan::services::util::create_rng(0, 0);
+  boost::variate_generator<stan::rng_t&, boost::normal_distribution<> >
+      rand_gaus(rng_direct, boost::normal_distribution<>());
+  Eigen::VectorXd u(2);
+  for (int n = 0; n < 3; ++n) {
+    metric.sample_p(z, rng_cached);
+    u(0) = rand_gaus();
+    u(1) = rand_gaus();
+    Eigen::VectorXd p = z.inv_e_metric_.llt().matrixU().solve(u);
+    EXPECT_FLOAT_EQ(p(0), z.p(0));
+    EXPECT_FLOAT_EQ(p(1), z.p(1));
+  }
+}
+
+TEST(McmcDenseEMetric, precomputed_factorization) {
+  Eigen::MatrixXd m_inv(2, 2);
+  m_inv << 2.0, 0.5, 0.5, 1.0;
+  Eigen::LLT<Eigen::MatrixXd> m_inv_llt(m_inv);
+
+  stan::mcmc::mock_model model(2);
+  stan::mcmc::dense_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(model);
+  stan::mcmc::dense_e_point z(2);
+  stan::mcmc::dense_e_point z_factored(2);
+  z.set_metric(m_inv);
+  z_factored.set_metric(m_inv, m_inv_llt);
+
+  Eigen::MatrixXd U = m_inv_llt.matrixU();
+  Eigen::MatrixXd cached_U = z_factored.inv_e_metric_llt().matrixU();
+  EXPECT_FLOAT_EQ(U(0, 0), cached_U(0, 0));
+  EXPECT_FLOAT_EQ(U(0, 1), cached_U(0, 1));
+  EXPECT_FLOAT_EQ(U(1, 1), cached_U(1, 1));
+
+  stan::rng_t rng = stan::services::util::create_rng(0, 0);
+  stan::rng_t rng_factored = stan::services::util::create_rng(0, 0);
+  for (int n = 0; n < 3; ++n) {
+    metric.sample_p(z, rng);
+    metric.sample_p(z_factored, rng_factored);
+    EXPECT_FLOAT_EQ(z.p(0), z_factored.p(0));
+    EXPECT_FLOAT_EQ(z.p(1), z_factored.p(1));
+    EXPECT_FLOAT_EQ(metric.T(z), metric.T(z_factored));
+  }
+}
+
 TEST(McmcDenseEMetric, gradients) {
   Eigen::VectorXd q = Eigen::VectorXd::Ones(11);
 
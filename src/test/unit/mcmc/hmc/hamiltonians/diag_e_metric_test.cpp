@@ -41,6 +41,53 @@ TEST(McmcDiagEMetric, sample_p) {
   EXPECT_TRUE(std::fabs(var - 0.5 * q.size()) < 0.1 * q.size());
 }
 
+TEST(McmcDiagEMetric, H_and_dtau_dp) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  // Spans several blocks, the last one partial
+  int n = 1000;
+  stan::mcmc::mock_model model(n);
+  stan::mcmc::diag_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(model);
+  stan::mcmc::diag_e_point z(n);
+  for (int i = 0; i < n; ++i)
+    z.inv_e_metric_(i) = 0.5 + 0.001 * i;
+  z.V = 1.5;
+  metric.sample_p(z, base_rng);
+
+  Eigen::VectorXd p_sharp;
+  double H = metric.H_and_dtau_dp(z, p_sharp);
+
+  EXPECT_NEAR(metric.H(z), H, 1e-10);
+  Eigen::VectorXd expected_p_sharp = metric.dtau_dp(z);
+  ASSERT_EQ(n, p_sharp.size());
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(expected_p_sharp(i), p_sharp(i));
+}
+
+TEST(McmcDiagEMetric, add_derivatives) {
+  stan::mcmc::mock_model model(3);
+  stan::mcmc::diag_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(model);
+  stan::mcmc::diag_e_point z(3);
+  z.inv_e_metric_ << 0.5, 2.0, 1.5;
+  z.q << 0.3, -1.2, 4.0;
+  z.p << 1.0, -3.0, 0.25;
+  z.g << -0.7, 2.5, 1.1;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  Eigen::VectorXd q = z.q;
+  Eigen::VectorXd expected_q = q + 0.1 * metric.dtau_dp(z);
+  metric.add_dtau_dp(z, 0.1, q);
+  Eigen::VectorXd p = z.p;
+  Eigen::VectorXd expected_p = p - 0.1 * metric.dphi_dq(z, logger);
+  metric.add_dphi_dq(z, -0.1, p, logger);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(expected_q(i), q(i));
+    EXPECT_FLOAT_EQ(expected_p(i), p(i));
+  }
+}
+
 TEST(McmcDiagEMetric, gradients) {
   Eigen::VectorXd q = Eigen::VectorXd::Ones(11);
 
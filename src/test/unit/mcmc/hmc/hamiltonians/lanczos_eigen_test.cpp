@@ -0,0 +1,79 @@
+#include <stan/mcmc/hmc/hamiltonians/lanczos_eigen.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace {
+Eigen::MatrixXd test_matrix(int n) {
+  Eigen::MatrixXd a(n, n);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      a(i, j) = std::cos(1.0 + i * j) + 1.0 / (1.0 + i + 2.0 * j);
+  Eigen::MatrixXd s = a + a.transpose();
+  s.diagonal().array() += 0.5;
+  return s;
+}
+}  // namespace
+
+TEST(McmcLanczosEigen, full_decomposition) {
+  const int n = 7;
+  Eigen::MatrixXd a = test_matrix(n);
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> exact(a);
+
+  Eigen::VectorXd values;
+  Eigen::MatrixXd vectors;
+  stan::mcmc::lanczos_eigen([&](const Eigen::VectorXd& v) { return a * v; },
+                            Eigen::VectorXd::Ones(n), n, n, values, vectors);
+
+  ASSERT_EQ(n, values.size());
+  for (int j = 1; j < n; ++j)
+    EXPECT_GE(std::fabs(values(j - 1)), std::fabs(values(j)));
+
+  Eigen::MatrixXd reconstructed
+      = vectors * values.asDiagonal() * vectors.transpose();
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      EXPECT_NEAR(a(i, j), reconstructed(i, j), 1e-10);
+
+  Eigen::VectorXd sorted = values;
+  std::sort(sorted.data(), sorted.data() + n);
+  for (int i = 0; i < n; ++i)
+    EXPECT_NEAR(exact.eigenvalues()(i), sorted(i), 1e-10);
+}
+
+TEST(McmcLanczosEigen, leading_pairs) {
+  const int n = 40;
+  // Three well separated eigenvalues above a flat spectrum
+  Eigen::MatrixXd u = test_matrix(n).householderQr().householderQ();
+  Eigen::VectorXd lambda = Eigen::VectorXd::Constant(n, 0.1);
+  lambda(3) = 50;
+  lambda(10) = -20;
+  lambda(25) = 8;
+  Eigen::MatrixXd a = u * lambda.asDiagonal() * u.transpose();
+
+  Eigen::VectorXd values;
+  Eigen::MatrixXd vectors;
+  stan::mcmc::lanczos_eigen([&](const Eigen::VectorXd& v) { return a * v; },
+                            Eigen::VectorXd::Ones(n), 12, 3, values, vectors);
+
+  ASSERT_EQ(3, values.size());
+  EXPECT_NEAR(50, values(0), 1e-8);
+  EXPECT_NEAR(-20, values(1), 1e-8);
+  EXPECT_NEAR(8, values(2), 1e-8);
+  EXPECT_NEAR(1, std::fabs(vectors.col(0).dot(u.col(3))), 1e-8);
+  EXPECT_NEAR(1, std::fabs(vectors.col(1).dot(u.col(10))), 1e-8);
+  EXPECT_NEAR(1, std::fabs(vectors.col(2).dot(u.col(25))), 1e-8);
+}
+
+TEST(McmcLanczosEigen, invariant_start) {
+  const int n = 5;
+  Eigen::MatrixXd a = Eigen::MatrixXd::Identity(n, n) * 2;
+
+  Eigen::VectorXd values;
+  Eigen::MatrixXd vectors;
+  stan::mcmc::lanczos_eigen([&](const Eigen::VectorXd& v) { return a * v; },
+                            Eigen::VectorXd::Ones(n), n, 3, values, vectors);
+
+  ASSERT_EQ(1, values.size());
+  EXPECT_FLOAT_EQ(2, values(0));
+  EXPECT_FLOAT_EQ(1, vectors.col(0).norm());
+}
@@ -0,0 +1,102 @@
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/mcmc/hmc/mock_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_e_metric.hpp>
+#include <gtest/gtest.h>
+
+namespace {
+Eigen::MatrixXd dense_inv_metric(const stan::mcmc::lowrank_e_point& z) {
+  Eigen::MatrixXd inv_metric = z.inv_e_metric_lowrank_
+                               * z.inv_e_metric_lowrank_.transpose();
+  inv_metric.diagonal() += z.inv_e_metric_;
+  return inv_metric;
+}
+}  // namespace
+
+TEST(McmcLowrankEMetric, sample_p) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  Eigen::VectorXd q(2);
+  q(0) = 5;
+  q(1) = 1;
+
+  stan::mcmc::mock_model model(q.size());
+  stan::mcmc::lowrank_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(
+      model);
+  stan::mcmc::lowrank_e_point z(q.size());
+
+  Eigen::VectorXd d(2);
+  d << 2, 0.5;
+  Eigen::MatrixXd w(2, 1);
+  w << 1, -0.5;
+  z.set_metric(d, w);
+
+  int n_samples = 10000;
+  double m = 0;
+  double m2 = 0;
+
+  for (int i = 0; i < n_samples; ++i) {
+    metric.sample_p(z, base_rng);
+    double tau = metric.tau(z);
+
+    double delta = tau - m;
+    m += delta / static_cast<double>(i + 1);
+    m2 += delta * (tau - m);
+  }
+
+  double var = m2 / (n_samples + 1.0);
+
+  // Mean within 5sigma of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(m - 0.5 * q.size()) < 5.0 * sqrt(var));
+
+  // Variance within 10% of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(var - 0.5 * q.size()) < 0.1 * q.size());
+}
+
+TEST(McmcLowrankEMetric, matches_dense) {
+  const int n = 6;
+  stan::mcmc::mock_model model(n);
+  stan::mcmc::lowrank_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(
+      model);
+  stan::mcmc::lowrank_e_point z(n);
+
+  Eigen::VectorXd d(n);
+  d << 1, 2, 0.5, 3, 0.25, 1.5;
+  Eigen::MatrixXd w(n, 2);
+  w << 1, 0, 0.5, 1, -1, 0.25, 0, 2, 0.1, -0.3, 2, 0.5;
+  z.set_metric(d, w);
+  z.p << 0.3, -1, 2, 0.5, -0.25, 1;
+
+  Eigen::MatrixXd inv_metric = dense_inv_metric(z);
+  EXPECT_FLOAT_EQ(0.5 * z.p.dot(inv_metric * z.p), metric.T(z));
+
+  Eigen::VectorXd dtau_dp = metric.dtau_dp(z);
+  Eigen::VectorXd expected = inv_metric * z.p;
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(expected(i), dtau_dp(i));
+
+  // sqrt_e_metric_times applies a square root of the mass matrix
+  Eigen::MatrixXd root(n, n);
+  for (int j = 0; j < n; ++j)
+    root.col(j) = z.sqrt_e_metric_times(Eigen::VectorXd::Unit(n, j));
+  Eigen::MatrixXd identity = root * root.transpose() * inv_metric;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, identity(i, j), 1e-12);
+}
+
+TEST(McmcLowrankEMetric, diagonal_only) {
+  const int n = 3;
+  stan::mcmc::mock_model model(n);
+  stan::mcmc::lowrank_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(
+      model);
+  stan::mcmc::lowrank_e_point z(n);
+
+  Eigen::VectorXd d(n);
+  d << 1, 4, 0.5;
+  z.set_metric(d);
+  z.p << 1, 2, 3;
+
+  EXPECT_EQ(0, z.inv_e_metric_lowrank_.cols());
+  EXPECT_FLOAT_EQ(0.5 * (1 + 16 + 4.5), metric.T(z));
+  EXPECT_EQ("lowrank_e", z.metric_type());
+}
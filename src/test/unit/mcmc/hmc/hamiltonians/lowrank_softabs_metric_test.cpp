@@ -0,0 +1,190 @@
+#include <stan/io/empty_var_context.hpp>
+#include <stan/mcmc/hmc/hamiltonians/lowrank_softabs_metric.hpp>
+#include <stan/mcmc/hmc/hamiltonians/softabs_metric.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <test/unit/mcmc/hmc/mock_hmc.hpp>
+#include <test/test-models/good/mcmc/hmc/hamiltonians/funnel.hpp>
+#include <test/unit/util.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(McmcLowrankSoftAbs, sample_p) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  Eigen::VectorXd q(2);
+  q(0) = 5;
+  q(1) = 1;
+
+  stan::mcmc::mock_model model(q.size());
+  stan::mcmc::lowrank_softabs_metric<stan::mcmc::mock_model, stan::rng_t>
+      metric(model);
+  stan::mcmc::lowrank_softabs_point z(q.size());
+
+  int n_samples = 1000;
+  double m = 0;
+  double m2 = 0;
+
+  for (int i = 0; i < n_samples; ++i) {
+    metric.sample_p(z, base_rng);
+    double tau = metric.tau(z);
+
+    double delta = tau - m;
+    m += delta / static_cast<double>(i + 1);
+    m2 += delta * (tau - m);
+  }
+
+  double var = m2 / (n_samples + 1.0);
+
+  // Mean within 5sigma of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(m - 0.5 * q.size()) < 5.0 * sqrt(var));
+
+  // Variance within 10% of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(var - 0.5 * q.size()) < 0.1 * q.size());
+}
+
+TEST(McmcLowrankSoftAbs, gradients) {
+  Eigen::VectorXd q = Eigen::VectorXd::Ones(11);
+
+  stan::mcmc::lowrank_softabs_point z(q.size());
+  z.rank = 4;
+  z.q = q;
+  z.p.setOnes();
+
+  stan::io::empty_var_context data_var_context;
+
+  std::stringstream model_output;
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  funnel_model_namespace::funnel_model model(data_var_context, 0,
+                                             &model_output);
+
+  stan::mcmc::lowrank_softabs_metric<funnel_model_namespace::funnel_model,
+                                     stan::rng_t>
+      metric(model);
+
+  double epsilon = 1e-6;
+
+  // dtau_dp is exact for any rank
+  metric.init(z, logger);
+  Eigen::VectorXd g2 = metric.dtau_dp(z);
+
+  for (int i = 0; i < z.q.size(); ++i) {
+    double delta = 0;
+
+    z.p(i) += epsilon;
+    delta += metric.tau(z);
+
+    z.p(i) -= 2 * epsilon;
+    delta -= metric.tau(z);
+
+    z.p(i) += epsilon;
+
+    delta /= 2 * epsilon;
+
+    EXPECT_NEAR(delta, g2(i), epsilon);
+  }
+
+  // With every eigenpair kept the q gradients are exact as well
+  z.rank = q.size();
+  metric.init(z, logger);
+  Eigen::VectorXd g1 = metric.dtau_dq(z, logger);
+  Eigen::VectorXd g3 = metric.dphi_dq(z, logger);
+
+  for (int i = 0; i < z.q.size(); ++i) {
+    double delta_tau = 0;
+    double delta_phi = 0;
+
+    z.q(i) += epsilon;
+    metric.init(z, logger);
+    delta_tau += metric.tau(z);
+    delta_phi += metric.phi(z);
+
+    z.q(i) -= 2 * epsilon;
+    metric.init(z, logger);
+    delta_tau -= metric.tau(z);
+    delta_phi -= metric.phi(z);
+
+    z.q(i) += epsilon;
+
+    delta_tau /= 2 * epsilon;
+    delta_phi /= 2 * epsilon;
+
+    EXPECT_NEAR(delta_tau, g1(i), epsilon);
+    EXPECT_NEAR(delta_phi, g3(i), epsilon);
+  }
+
+  EXPECT_EQ("", model_output.str());
+  EXPECT_EQ("", debug.str());
+  EXPECT_EQ("", info.str());
+  EXPECT_EQ("", warn.str());
+  EXPECT_EQ("", error.str());
+  EXPECT_EQ("", fatal.str());
+}
+
+TEST(McmcLowrankSoftAbs, full_rank_matches_softabs) {
+  Eigen::VectorXd q = Eigen::VectorXd::Ones(11);
+  q(0) = 0.5;
+
+  stan::mcmc::lowrank_softabs_point z(q.size());
+  z.rank = q.size();
+  z.q = q;
+  z.p.setOnes();
+
+  stan::mcmc::softabs_point z_dense(q.size());
+  z_dense.q = q;
+  z_dense.p.setOnes();
+
+  stan::io::empty_var_context data_var_context;
+
+  std::stringstream model_output;
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  funnel_model_namespace::funnel_model model(data_var_context, 0,
+                                             &model_output);
+
+  stan::mcmc::lowrank_softabs_metric<funnel_model_namespace::funnel_model,
+                                     stan::rng_t>
+      metric(model);
+  stan::mcmc::softabs_metric<funnel_model_namespace::funnel_model, stan::rng_t>
+      dense_metric(model);
+
+  metric.init(z, logger);
+  dense_metric.init(z_dense, logger);
+
+  EXPECT_NEAR(dense_metric.T(z_dense), metric.T(z), 1e-8);
+  EXPECT_NEAR(dense_metric.phi(z_dense), metric.phi(z), 1e-8);
+
+  Eigen::VectorXd dtau_dq = metric.dtau_dq(z, logger);
+  Eigen::VectorXd dense_dtau_dq = dense_metric.dtau_dq(z_dense, logger);
+  Eigen::VectorXd dphi_dq = metric.dphi_dq(z, logger);
+  Eigen::VectorXd dense_dphi_dq = dense_metric.dphi_dq(z_dense, logger);
+  for (int i = 0; i < q.size(); ++i) {
+    EXPECT_NEAR(dense_dtau_dq(i), dtau_dq(i), 1e-8);
+    EXPECT_NEAR(dense_dphi_dq(i), dphi_dq(i), 1e-8);
+  }
+}
+
+TEST(McmcLowrankSoftAbs, streams) {
+  stan::test::capture_std_streams();
+
+  Eigen::VectorXd q(2);
+  q(0) = 5;
+  q(1) = 1;
+  stan::mcmc::mock_model model(q.size());
+
+  // for use in Google Test macros below
+  typedef stan::mcmc::lowrank_softabs_metric<stan::mcmc::mock_model,
+                                             stan::rng_t>
+      lowrank_softabs;
+
+  EXPECT_NO_THROW(lowrank_softabs metric(model));
+
+  stan::test::reset_std_streams();
+  EXPECT_EQ("", stan::test::cout_ss.str());
+  EXPECT_EQ("", stan::test::cerr_ss.str());
+}
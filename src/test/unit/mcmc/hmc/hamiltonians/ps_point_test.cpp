@@ -21,5 +21,40 @@ TEST(psPoint, write_metric_streams) {
   EXPECT_EQ("", stan::test::cerr_ss.str());
 }
 
+TEST(psPoint, diagnostic_fields) {
+  ps_point point(2);
+  point.q << 1, 2;
+  point.p << 3, 4;
+  point.g << 5, 6;
+  std::vector<std::string> model_names{"a", "b"};
+
+  std::vector<std::string> names{"lp__"};
+  std::vector<double> values{-1};
+  point.get_param_names(model_names, names);
+  point.get_params(values);
+  EXPECT_EQ(7, names.size());
+  EXPECT_EQ("p_a", names[3]);
+  EXPECT_EQ(std::vector<double>({-1, 1, 2, 3, 4, 5, 6}), values);
+
+  diagnostic_fields fields;
+  fields.momentum = false;
+  names.assign(1, "lp__");
+  values.assign(1, -1);
+  point.get_param_names(model_names, names, fields);
+  point.get_params(values, fields);
+  EXPECT_EQ(std::vector<std::string>({"lp__", "a", "b", "g_a", "g_b"}),
+            names);
+  EXPECT_EQ(std::vector<double>({-1, 1, 2, 5, 6}), values);
+
+  fields.position = false;
+  fields.gradient = false;
+  names.clear();
+  values.clear();
+  point.get_param_names(model_names, names, fields);
+  point.get_params(values, fields);
+  EXPECT_TRUE(names.empty());
+  EXPECT_TRUE(values.empty());
+}
+
 }  // namespace mcmc
 }  // namespace stan
@@ -0,0 +1,109 @@
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/mcmc/hmc/mock_hmc.hpp>
+#include <stan/mcmc/hmc/hamiltonians/sparse_e_metric.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+// Tridiagonal mass matrix with the specified diagonal and off-diagonal
+Eigen::SparseMatrix<double> tridiagonal(int n, double diag, double off) {
+  std::vector<Eigen::Triplet<double>> elements;
+  for (int i = 0; i < n; ++i) {
+    elements.emplace_back(i, i, diag);
+    if (i > 0) {
+      elements.emplace_back(i, i - 1, off);
+      elements.emplace_back(i - 1, i, off);
+    }
+  }
+  Eigen::SparseMatrix<double> m(n, n);
+  m.setFromTriplets(elements.begin(), elements.end());
+  return m;
+}
+}  // namespace
+
+TEST(McmcSparseEMetric, sample_p) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  Eigen::VectorXd q(3);
+  q << 5, 1, -2;
+
+  stan::mcmc::mock_model model(q.size());
+  stan::mcmc::sparse_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(
+      model);
+  stan::mcmc::sparse_e_point z(q.size());
+  z.set_metric(tridiagonal(3, 2, -0.8));
+
+  int n_samples = 10000;
+  double m = 0;
+  double m2 = 0;
+
+  for (int i = 0; i < n_samples; ++i) {
+    metric.sample_p(z, base_rng);
+    double tau = metric.tau(z);
+
+    double delta = tau - m;
+    m += delta / static_cast<double>(i + 1);
+    m2 += delta * (tau - m);
+  }
+
+  double var = m2 / (n_samples + 1.0);
+
+  // Mean within 5sigma of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(m - 0.5 * q.size()) < 5.0 * sqrt(var));
+
+  // Variance within 10% of expected value (d / 2)
+  EXPECT_TRUE(std::fabs(var - 0.5 * q.size()) < 0.1 * q.size());
+}
+
+TEST(McmcSparseEMetric, matches_dense) {
+  const int n = 6;
+  stan::mcmc::mock_model model(n);
+  stan::mcmc::sparse_e_metric<stan::mcmc::mock_model, stan::rng_t> metric(
+      model);
+  stan::mcmc::sparse_e_point z(n);
+
+  Eigen::SparseMatrix<double> e_metric = tridiagonal(n, 3, 1);
+  e_metric.coeffRef(0, 5) = 0.5;
+  e_metric.coeffRef(5, 0) = 0.5;
+  z.set_metric(e_metric);
+  z.p << 0.3, -1, 2, 0.5, -0.25, 1;
+
+  Eigen::MatrixXd dense_metric(e_metric);
+  Eigen::MatrixXd inv_metric = dense_metric.inverse();
+  EXPECT_FLOAT_EQ(0.5 * z.p.dot(inv_metric * z.p), metric.T(z));
+
+  Eigen::VectorXd dtau_dp = metric.dtau_dp(z);
+  Eigen::VectorXd expected = inv_metric * z.p;
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(expected(i), dtau_dp(i));
+
+  // sqrt_e_metric_times applies a square root of the mass matrix
+  Eigen::MatrixXd root(n, n);
+  for (int j = 0; j < n; ++j)
+    root.col(j) = z.sqrt_e_metric_times(Eigen::VectorXd::Unit(n, j));
+  Eigen::MatrixXd product = root * root.transpose();
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      EXPECT_NEAR(dense_metric(i, j), product(i, j), 1e-12);
+
+  // Copies share the factorization
+  stan::mcmc::sparse_e_point copy(z);
+  EXPECT_FLOAT_EQ(metric.T(z), metric.T(copy));
+  EXPECT_EQ("sparse_e", z.metric_type());
+}
+
+TEST(McmcSparseEMetric, not_positive_definite) {
+  stan::mcmc::sparse_e_point z(3);
+  EXPECT_THROW(z.set_metric(tridiagonal(3, 1, 2)), std::domain_error);
+}
+
+TEST(McmcSparseEMetric, metric_triplets) {
+  stan::mcmc::sparse_e_point z(3);
+  z.set_metric(tridiagonal(3, 2, -0.5));
+  std::vector<int> rows, cols;
+  std::vector<double> values;
+  z.get_metric_triplets(rows, cols, values);
+  EXPECT_EQ((std::vector<int>{0, 1, 1, 2, 2}), rows);
+  EXPECT_EQ((std::vector<int>{0, 0, 1, 1, 2}), cols);
+  EXPECT_EQ((std::vector<double>{2, -0.5, 2, -0.5, 2}), values);
+}
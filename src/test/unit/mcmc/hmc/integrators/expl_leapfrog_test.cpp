@@ -185,6 +185,35 @@ TEST_F(McmcHmcIntegratorsExplLeapfrogF, evolve_1) {
   EXPECT_EQ("", fatal.str());
 }
 
+TEST_F(McmcHmcIntegratorsExplLeapfrogF, evolve_steps) {
+  stan::mcmc::unit_e_metric<command_model_namespace::command_model, stan::rng_t>
+      hamiltonian(*model);
+  double epsilon = 0.1;
+
+  stan::mcmc::unit_e_point z(1);
+  z.q(0) = 1.99987371079118;
+  z.p(0) = -1.58612292129732;
+  hamiltonian.init(z, logger);
+  stan::mcmc::unit_e_point z_fused(z);
+
+  for (int n = 0; n < 7; ++n)
+    unit_e_integrator.evolve(z, hamiltonian, epsilon, logger);
+  long num_steps = unit_e_integrator.num_steps();
+  unit_e_integrator.evolve_steps(z_fused, hamiltonian, epsilon, 7, logger);
+
+  EXPECT_EQ(2 * num_steps, unit_e_integrator.num_steps());
+  EXPECT_NEAR(z.V, z_fused.V, 1e-13);
+  EXPECT_NEAR(z.q(0), z_fused.q(0), 1e-13);
+  EXPECT_NEAR(z.p(0), z_fused.p(0), 1e-13);
+  EXPECT_NEAR(z.g(0), z_fused.g(0), 1e-13);
+
+  EXPECT_EQ("", debug.str());
+  EXPECT_EQ("", info.str());
+  EXPECT_EQ("", warn.str());
+  EXPECT_EQ("", error.str());
+  EXPECT_EQ("", fatal.str());
+}
+
 TEST_F(McmcHmcIntegratorsExplLeapfrogF, evolve_2) {
   // setup z
   stan::mcmc::unit_e_point z(1);
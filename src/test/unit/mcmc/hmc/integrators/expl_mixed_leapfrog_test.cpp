@@ -0,0 +1,70 @@
+#include <stan/mcmc/hmc/integrators/expl_mixed_leapfrog.hpp>
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stan/callbacks/stream_logger.hpp>
+#include <test/test-models/good/mcmc/hmc/integrators/command.hpp>
+
+#include <stan/io/json/json_data.hpp>
+
+#include <stan/mcmc/hmc/hamiltonians/diag_e_metric.hpp>
+#include <stan/mcmc/hmc/hamiltonians/diag_e_mixed_metric.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/services/util/create_rng.hpp>
+
+class McmcHmcIntegratorsExplMixedLeapfrogF : public testing::Test {
+ public:
+  McmcHmcIntegratorsExplMixedLeapfrogF()
+      : logger(debug, info, warn, error, fatal) {}
+
+  void SetUp() {
+    static const std::string DATA("{\"mu\":0.0, \"y\":0}");
+    std::stringstream data_stream(DATA);
+    stan::json::json_data data_var_context(data_stream);
+
+    model = new command_model_namespace::command_model(data_var_context);
+  }
+
+  void TearDown() { delete (model); }
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger;
+
+  command_model_namespace::command_model *model;
+};
+
+TEST_F(McmcHmcIntegratorsExplMixedLeapfrogF, evolve_matches_expl_leapfrog) {
+  typedef stan::mcmc::diag_e_metric<command_model_namespace::command_model,
+                                    stan::rng_t>
+      double_metric;
+  typedef stan::mcmc::diag_e_mixed_metric<
+      command_model_namespace::command_model, stan::rng_t>
+      mixed_metric;
+
+  stan::rng_t rng = stan::services::util::create_rng(0, 0);
+
+  stan::mcmc::diag_e_point z(1);
+  z.q(0) = 1.99987371079118;
+  z.inv_e_metric_(0) = 0.7;
+
+  double_metric double_hamiltonian(*model);
+  mixed_metric mixed_hamiltonian(*model);
+  mixed_hamiltonian.sample_p(z, rng);
+  mixed_hamiltonian.init(z, logger);
+  stan::mcmc::diag_e_point z_mixed(z);
+
+  stan::mcmc::expl_leapfrog<double_metric> double_integrator;
+  stan::mcmc::expl_mixed_leapfrog<mixed_metric> mixed_integrator;
+
+  double epsilon = 0.1;
+  for (int n = 0; n < 10; ++n) {
+    double_integrator.evolve(z, double_hamiltonian, epsilon, logger);
+    mixed_integrator.evolve(z_mixed, mixed_hamiltonian, epsilon, logger);
+  }
+
+  EXPECT_NEAR(z.q(0), z_mixed.q(0), 1e-5);
+  EXPECT_NEAR(z.p(0), z_mixed.p(0), 1e-5);
+  EXPECT_NEAR(double_hamiltonian.H(z), mixed_hamiltonian.H(z_mixed), 1e-5);
+  EXPECT_EQ(10, mixed_integrator.num_steps());
+  EXPECT_EQ("", error.str());
+}
@@ -372,6 +372,36 @@ TEST(McmcNutsBaseNuts, transition) {
   EXPECT_EQ("", fatal.str());
 }
 
+TEST(McmcNutsBaseNuts, transition_recycles_storage) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  stan::mcmc::ps_point z_init(3);
+  z_init.q.setZero();
+  z_init.p.setConstant(1.5);
+
+  stan::mcmc::mock_model model(3);
+  stan::mcmc::mock_nuts sampler(model, base_rng);
+  sampler.set_nominal_stepsize(1);
+  sampler.set_stepsize_jitter(0);
+  sampler.sample_stepsize();
+  sampler.z() = z_init;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::mcmc::sample init_sample(z_init.q, 0, 0);
+  const double* recycled = init_sample.cont_params().data();
+  stan::mcmc::sample s = sampler.transition(init_sample, logger);
+  sampler.recycle(init_sample);
+
+  // The next draw is written into the storage of the recycled sample
+  stan::mcmc::sample next = sampler.transition(s, logger);
+  EXPECT_EQ(recycled, next.cont_params().data());
+  ASSERT_EQ(3, next.size_cont());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(sampler.z().q(i), next.cont_params()(i));
+}
+
 TEST(McmcNutsBaseNuts, transition_egde_momenta) {
   stan::rng_t base_rng = stan::services::util::create_rng(42424253, 0);
 
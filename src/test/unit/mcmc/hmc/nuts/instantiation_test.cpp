@@ -6,6 +6,7 @@
 #include <stan/mcmc/hmc/nuts/adapt_unit_e_nuts.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_diag_e_nuts.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_dense_e_nuts.hpp>
+#include <stan/mcmc/hmc/nuts/adapt_diag_e_mixed_nuts.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <stan/io/empty_var_context.hpp>
 #include <fstream>
@@ -43,4 +44,8 @@ TEST(McmcNuts, instantiaton_test) {
   stan::mcmc::adapt_dense_e_nuts<gauss3D_model_namespace::gauss3D_model,
                                  stan::rng_t>
       adapt_dense_e_sampler(model, base_rng);
+
+  stan::mcmc::adapt_diag_e_mixed_nuts<gauss3D_model_namespace::gauss3D_model,
+                                      stan::rng_t>
+      adapt_diag_e_mixed_sampler(model, base_rng);
 }
@@ -0,0 +1,36 @@
+#include <stan/mcmc/hmc/nuts/nuts_tree_scratch.hpp>
+#include <gtest/gtest.h>
+
+TEST(McmcNutsTreeScratch, reserve_sizes_buffers) {
+  stan::mcmc::nuts_tree_scratch scratch(3);
+  EXPECT_EQ(0, scratch.size());
+  EXPECT_EQ(3, scratch.dimension());
+
+  scratch.reserve(4);
+  EXPECT_EQ(5, scratch.size());
+  for (int d = 0; d < 5; ++d) {
+    EXPECT_EQ(3, scratch[d].z_propose_final.q.size());
+    EXPECT_EQ(3, scratch[d].p_init_end.size());
+    EXPECT_EQ(3, scratch[d].p_sharp_init_end.size());
+    EXPECT_EQ(3, scratch[d].rho_init.size());
+    EXPECT_EQ(3, scratch[d].p_final_beg.size());
+    EXPECT_EQ(3, scratch[d].p_sharp_final_beg.size());
+    EXPECT_EQ(3, scratch[d].rho_final.size());
+    EXPECT_EQ(3, scratch[d].rho_subtree.size());
+  }
+
+  scratch.reserve(-1);
+  EXPECT_EQ(5, scratch.size());
+}
+
+TEST(McmcNutsTreeScratch, reserve_keeps_existing_storage) {
+  stan::mcmc::nuts_tree_scratch scratch(2);
+  scratch.reserve(3);
+  const double* rho_init_data = scratch[3].rho_init.data();
+
+  // Reserving a depth already available must not touch the buffers
+  scratch.reserve(2);
+  scratch.reserve(3);
+  EXPECT_EQ(4, scratch.size());
+  EXPECT_EQ(rho_init_data, scratch[3].rho_init.data());
+}
@@ -353,3 +353,125 @@ TEST(McmcUnitENuts, transition_test) {
   EXPECT_EQ("", error.str());
   EXPECT_EQ("", fatal.str());
 }
+
+TEST(McmcUnitENuts, speculative_transition_test) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+  stan::rng_t spec_rng = stan::services::util::create_rng(4839294, 0);
+
+  stan::mcmc::unit_e_point z_init(3);
+  z_init.q(0) = 1;
+  z_init.q(1) = -1;
+  z_init.q(2) = 1;
+  z_init.p(0) = -1;
+  z_init.p(1) = 1;
+  z_init.p(2) = -1;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+
+  stan::mcmc::unit_e_nuts<gauss3D_model_namespace::gauss3D_model, stan::rng_t>
+      sampler(model, base_rng);
+  stan::mcmc::unit_e_nuts<gauss3D_model_namespace::gauss3D_model, stan::rng_t>
+      spec_sampler(model, spec_rng);
+  EXPECT_FALSE(spec_sampler.get_speculative());
+  spec_sampler.set_speculative(true);
+  EXPECT_TRUE(spec_sampler.get_speculative());
+
+  for (auto* s : {&sampler, &spec_sampler}) {
+    s->z() = z_init;
+    s->init_hamiltonian(logger);
+    s->set_nominal_stepsize(0.1);
+    s->set_stepsize_jitter(0);
+    s->sample_stepsize();
+  }
+
+  // the draws are exactly those of the sequential sampler
+  stan::mcmc::sample init_sample(z_init.q, 0, 0);
+  stan::mcmc::sample s = sampler.transition(init_sample, logger);
+  stan::mcmc::sample spec_s = spec_sampler.transition(init_sample, logger);
+  EXPECT_EQ(3, spec_sampler.depth_);
+  EXPECT_EQ((2 << 3) - 1, spec_sampler.n_leapfrog_);
+  EXPECT_FLOAT_EQ(0.70149082, spec_s.cont_params()(0));
+  EXPECT_FLOAT_EQ(0.99912512, spec_s.accept_stat());
+
+  for (int n = 0; n < 50; ++n) {
+    s = sampler.transition(s, logger);
+    spec_s = spec_sampler.transition(spec_s, logger);
+    ASSERT_EQ(sampler.n_leapfrog_, spec_sampler.n_leapfrog_);
+    ASSERT_EQ(sampler.depth_, spec_sampler.depth_);
+    for (int i = 0; i < 3; ++i)
+      ASSERT_EQ(s.cont_params()(i), spec_s.cont_params()(i));
+    ASSERT_EQ(s.log_prob(), spec_s.log_prob());
+    ASSERT_EQ(s.accept_stat(), spec_s.accept_stat());
+  }
+  // the speculated steps are counted whether used or not
+  EXPECT_GE(spec_sampler.num_gradient_evaluations(),
+            sampler.num_gradient_evaluations());
+  EXPECT_EQ("", error.str());
+}
+
+TEST(McmcUnitENuts, speculative_divergence_test) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+  stan::rng_t spec_rng = stan::services::util::create_rng(4839294, 0);
+
+  stan::mcmc::unit_e_point z_init(3);
+  z_init.q(0) = 1;
+  z_init.q(1) = -1;
+  z_init.q(2) = 1;
+  z_init.p(0) = -1;
+  z_init.p(1) = 1;
+  z_init.p(2) = -1;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+
+  stan::mcmc::unit_e_nuts<gauss3D_model_namespace::gauss3D_model, stan::rng_t>
+      sampler(model, base_rng);
+  stan::mcmc::unit_e_nuts<gauss3D_model_namespace::gauss3D_model, stan::rng_t>
+      spec_sampler(model, spec_rng);
+  spec_sampler.set_speculative(true);
+
+  for (auto* s : {&sampler, &spec_sampler}) {
+    s->z() = z_init;
+    s->init_hamiltonian(logger);
+    s->set_nominal_stepsize(0.1);
+    s->set_stepsize_jitter(0);
+    s->sample_stepsize();
+  }
+
+  // Trees ending in a U-turn at depth 3 or more with the default
+  // threshold, then trees diverging after some doublings as the
+  // threshold of the energy error is lowered, which stops both the
+  // trajectory and the speculation ahead of it
+  stan::mcmc::sample s(z_init.q, 0, 0);
+  stan::mcmc::sample spec_s(z_init.q, 0, 0);
+  bool saw_deep_uturn = false;
+  bool saw_deep_divergence = false;
+  for (double max_delta : {1000.0, 8e-3, 4e-3, 2e-3, 1e-3, 5e-4}) {
+    sampler.set_max_delta(max_delta);
+    spec_sampler.set_max_delta(max_delta);
+    for (int n = 0; n < 100; ++n) {
+      s = sampler.transition(s, logger);
+      spec_s = spec_sampler.transition(spec_s, logger);
+      ASSERT_EQ(sampler.depth_, spec_sampler.depth_);
+      ASSERT_EQ(sampler.n_leapfrog_, spec_sampler.n_leapfrog_);
+      ASSERT_EQ(sampler.divergent_, spec_sampler.divergent_);
+      for (int i = 0; i < 3; ++i)
+        ASSERT_EQ(s.cont_params()(i), spec_s.cont_params()(i));
+      ASSERT_EQ(s.log_prob(), spec_s.log_prob());
+      ASSERT_EQ(s.accept_stat(), spec_s.accept_stat());
+      saw_deep_uturn |= !sampler.divergent_ && sampler.depth_ >= 3
+                        && sampler.depth_ < sampler.get_max_depth();
+      saw_deep_divergence |= sampler.divergent_ && sampler.depth_ >= 3;
+    }
+  }
+  EXPECT_TRUE(saw_deep_uturn);
+  EXPECT_TRUE(saw_deep_divergence);
+  EXPECT_EQ("", error.str());
+}
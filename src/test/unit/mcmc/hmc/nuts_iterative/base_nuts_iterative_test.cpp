@@ -0,0 +1,206 @@
+#include <test/unit/mcmc/hmc/mock_hmc.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/hmc/nuts_iterative/base_nuts_iterative.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+// Hamiltonian of a standard normal target, with the potential
+// maintained by the integrator below
+template <typename Model, typename BaseRNG>
+class oscillator_hamiltonian
+    : public base_hamiltonian<Model, ps_point, BaseRNG> {
+ public:
+  explicit oscillator_hamiltonian(const Model& model)
+      : base_hamiltonian<Model, ps_point, BaseRNG>(model) {}
+
+  double T(ps_point& z) { return 0.5 * z.p.squaredNorm(); }
+  double tau(ps_point& z) { return T(z); }
+  double phi(ps_point& z) { return this->V(z); }
+  double dG_dt(ps_point& z, callbacks::logger& logger) {
+    return 2 * T(z) - z.q.dot(z.g);
+  }
+  Eigen::VectorXd dtau_dq(ps_point& z, callbacks::logger& logger) {
+    return Eigen::VectorXd::Zero(z.q.size());
+  }
+  Eigen::VectorXd dtau_dp(ps_point& z) { return z.p; }
+  Eigen::VectorXd dphi_dq(ps_point& z, callbacks::logger& logger) {
+    return z.g;
+  }
+  void sample_p(ps_point& z, BaseRNG& rng) {
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_gaus(rng, boost::normal_distribution<>());
+    for (int i = 0; i < z.p.size(); ++i)
+      z.p(i) = rand_gaus();
+  }
+  void init(ps_point& z, callbacks::logger& logger) {
+    z.g = z.q;
+    z.V = 0.5 * z.q.squaredNorm();
+  }
+};
+
+// Leapfrog for the oscillator with a slightly too large step so that
+// trajectories carry non-trivial weights
+template <typename Hamiltonian>
+class oscillator_leapfrog : public base_integrator<Hamiltonian> {
+ public:
+  void evolve(typename Hamiltonian::PointType& z, Hamiltonian& hamiltonian,
+              const double epsilon, callbacks::logger& logger) {
+    z.p -= 0.5 * epsilon * z.q;
+    z.q += epsilon * z.p;
+    z.p -= 0.5 * epsilon * z.q;
+    z.g = z.q;
+    z.V = 0.5 * z.q.squaredNorm();
+  }
+};
+
+typedef base_nuts<mock_model, oscillator_hamiltonian, oscillator_leapfrog,
+                  stan::rng_t>
+    recursive_nuts;
+
+typedef base_nuts_iterative<mock_model, oscillator_hamiltonian,
+                            oscillator_leapfrog, stan::rng_t>
+    iterative_nuts;
+
+class rho_inspector_iterative_nuts
+    : public base_nuts_iterative<mock_model, mock_hamiltonian, mock_integrator,
+                                 stan::rng_t> {
+ public:
+  std::vector<double> rho_values;
+  rho_inspector_iterative_nuts(const mock_model& m, stan::rng_t& rng)
+      : base_nuts_iterative<mock_model, mock_hamiltonian, mock_integrator,
+                            stan::rng_t>(m, rng) {}
+
+  bool compute_criterion(Eigen::VectorXd& p_sharp_minus,
+                         Eigen::VectorXd& p_sharp_plus, Eigen::VectorXd& rho) {
+    rho_values.push_back(rho(0));
+    return true;
+  }
+};
+
+}  // namespace mcmc
+}  // namespace stan
+
+TEST(McmcNutsBaseNutsIterative, build_tree_test) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  int model_size = 1;
+  double init_momentum = 1.5;
+
+  stan::mcmc::ps_point z_init(model_size);
+  z_init.q(0) = 0;
+  z_init.p(0) = init_momentum;
+
+  stan::mcmc::ps_point z_propose(model_size);
+
+  Eigen::VectorXd p_begin = Eigen::VectorXd::Zero(model_size);
+  Eigen::VectorXd p_sharp_begin = Eigen::VectorXd::Zero(model_size);
+  Eigen::VectorXd p_end = Eigen::VectorXd::Zero(model_size);
+  Eigen::VectorXd p_sharp_end = Eigen::VectorXd::Zero(model_size);
+  Eigen::VectorXd rho = z_init.p;
+
+  double log_sum_weight = -std::numeric_limits<double>::infinity();
+
+  double H0 = -0.1;
+  int n_leapfrog = 0;
+  double sum_metro_prob = 0;
+
+  stan::mcmc::mock_model model(model_size);
+  stan::mcmc::rho_inspector_iterative_nuts sampler(model, base_rng);
+
+  sampler.set_nominal_stepsize(1);
+  sampler.set_stepsize_jitter(0);
+  sampler.sample_stepsize();
+  sampler.z() = z_init;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  bool valid_subtree = sampler.build_tree(
+      3, z_propose, p_sharp_begin, p_sharp_end, rho, p_begin, p_end, H0, 1,
+      n_leapfrog, log_sum_weight, sum_metro_prob, logger);
+
+  EXPECT_TRUE(valid_subtree);
+
+  EXPECT_EQ(init_momentum * (n_leapfrog + 1), rho(0));
+  EXPECT_EQ(1.5, p_begin(0));
+  EXPECT_EQ(1.5, p_sharp_begin(0));
+  EXPECT_EQ(1.5, p_end(0));
+  EXPECT_EQ(12, p_sharp_end(0));
+
+  EXPECT_EQ(8 * init_momentum, sampler.z().q(0));
+  EXPECT_EQ(init_momentum, sampler.z().p(0));
+
+  EXPECT_EQ(8, n_leapfrog);
+  EXPECT_FLOAT_EQ(H0 + std::log(n_leapfrog), log_sum_weight);
+  EXPECT_FLOAT_EQ(std::exp(H0) * n_leapfrog, sum_metro_prob);
+
+  // Same criterion checks in the same order as the recursive builder
+  ASSERT_EQ(7 * 3, sampler.rho_values.size());
+  EXPECT_EQ(2 * init_momentum, sampler.rho_values[0]);
+  EXPECT_EQ(4 * init_momentum, sampler.rho_values[6]);
+  EXPECT_EQ(3 * init_momentum, sampler.rho_values[7]);
+  EXPECT_EQ(8 * init_momentum, sampler.rho_values[18]);
+  EXPECT_EQ(5 * init_momentum, sampler.rho_values[19]);
+  EXPECT_EQ(5 * init_momentum, sampler.rho_values[20]);
+
+  // Checkpoints are held for every depth up to the default maximum
+  EXPECT_EQ(sampler.get_max_depth(), sampler.checkpoints().size());
+
+  EXPECT_EQ("", debug.str());
+  EXPECT_EQ("", info.str());
+  EXPECT_EQ("", warn.str());
+  EXPECT_EQ("", error.str());
+  EXPECT_EQ("", fatal.str());
+}
+
+TEST(McmcNutsBaseNutsIterative, matches_recursive_transitions) {
+  int model_size = 3;
+  stan::mcmc::mock_model model(model_size);
+
+  stan::rng_t rng_recursive = stan::services::util::create_rng(1234, 0);
+  stan::rng_t rng_iterative = stan::services::util::create_rng(1234, 0);
+
+  stan::mcmc::recursive_nuts recursive(model, rng_recursive);
+  stan::mcmc::iterative_nuts iterative(model, rng_iterative);
+
+  recursive.set_max_depth(8);
+  iterative.set_max_depth(8);
+  recursive.set_nominal_stepsize(0.9);
+  iterative.set_nominal_stepsize(0.9);
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  Eigen::VectorXd q = Eigen::VectorXd::Constant(model_size, 0.5);
+  stan::mcmc::sample s_recursive(q, 0, 0);
+  stan::mcmc::sample s_iterative(q, 0, 0);
+
+  int min_depth = iterative.get_max_depth();
+  int max_depth = 0;
+  for (int n = 0; n < 200; ++n) {
+    s_recursive = recursive.transition(s_recursive, logger);
+    s_iterative = iterative.transition(s_iterative, logger);
+
+    ASSERT_EQ(recursive.depth_, iterative.depth_);
+    ASSERT_EQ(recursive.n_leapfrog_, iterative.n_leapfrog_);
+    ASSERT_EQ(recursive.divergent_, iterative.divergent_);
+    ASSERT_EQ(s_recursive.accept_stat(), s_iterative.accept_stat());
+    ASSERT_EQ(s_recursive.log_prob(), s_iterative.log_prob());
+    for (int i = 0; i < model_size; ++i)
+      ASSERT_EQ(s_recursive.cont_params(i), s_iterative.cont_params(i));
+    min_depth = std::min(min_depth, iterative.depth_);
+    max_depth = std::max(max_depth, iterative.depth_);
+  }
+
+  // Trajectories terminated at a range of depths
+  EXPECT_LT(min_depth, max_depth);
+}
@@ -0,0 +1,58 @@
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/mcmc/hmc/nuts_iterative/unit_e_nuts_iterative.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(McmcUnitENutsIterative, speculative_transition_test) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+  stan::rng_t spec_rng = stan::services::util::create_rng(4839294, 0);
+
+  stan::mcmc::unit_e_point z_init(3);
+  z_init.q(0) = 1;
+  z_init.q(1) = -1;
+  z_init.q(2) = 1;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+
+  stan::mcmc::unit_e_nuts_iterative<gauss3D_model_namespace::gauss3D_model,
+                                    stan::rng_t>
+      sampler(model, base_rng);
+  stan::mcmc::unit_e_nuts_iterative<gauss3D_model_namespace::gauss3D_model,
+                                    stan::rng_t>
+      spec_sampler(model, spec_rng);
+  spec_sampler.set_speculative(true);
+  EXPECT_FALSE(spec_sampler.get_speculative());
+
+  for (auto* s : {&sampler, &spec_sampler}) {
+    s->z() = z_init;
+    s->init_hamiltonian(logger);
+    s->set_nominal_stepsize(0.1);
+    s->set_stepsize_jitter(0);
+    s->sample_stepsize();
+  }
+
+  // the leaves are integrated by the iterative tree, so nothing is
+  // speculated and no gradient is evaluated twice
+  stan::mcmc::sample s(z_init.q, 0, 0);
+  stan::mcmc::sample spec_s(z_init.q, 0, 0);
+  for (int n = 0; n < 50; ++n) {
+    s = sampler.transition(s, logger);
+    spec_s = spec_sampler.transition(spec_s, logger);
+    ASSERT_EQ(sampler.depth_, spec_sampler.depth_);
+    ASSERT_EQ(sampler.n_leapfrog_, spec_sampler.n_leapfrog_);
+    for (int i = 0; i < 3; ++i)
+      ASSERT_EQ(s.cont_params()(i), spec_s.cont_params()(i));
+    ASSERT_EQ(s.log_prob(), spec_s.log_prob());
+    ASSERT_EQ(s.accept_stat(), spec_s.accept_stat());
+  }
+  EXPECT_EQ(sampler.num_gradient_evaluations(),
+            spec_sampler.num_gradient_evaluations());
+  EXPECT_EQ("", error.str());
+}
@@ -0,0 +1,213 @@
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/mcmc/hmc/nuts/base_nuts.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/base_nuts_lockstep.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/lockstep_driver.hpp>
+#include <stan/mcmc/hmc/hamiltonians/base_hamiltonian.hpp>
+#include <stan/mcmc/hmc/hamiltonians/ps_point.hpp>
+#include <stan/mcmc/hmc/integrators/expl_leapfrog.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace stan {
+namespace mcmc {
+
+// Standard normal target with a batched gradient that records how it
+// is called
+class batch_normal_model : public model::prob_grad {
+ public:
+  explicit batch_normal_model(size_t num_params_r)
+      : model::prob_grad(num_params_r) {}
+
+  template <bool propto, bool jacobian>
+  void log_prob_grad_batch(const Eigen::MatrixXd& params_r,
+                           Eigen::VectorXd& log_prob,
+                           Eigen::MatrixXd& gradient,
+                           std::ostream* msgs = 0) const {
+    ++num_batches;
+    max_batch_size
+        = std::max(max_batch_size, static_cast<int>(params_r.cols()));
+    if (fail)
+      throw std::domain_error("batch failed");
+    log_prob = -0.5 * params_r.colwise().squaredNorm().transpose();
+    gradient = -params_r;
+  }
+
+  mutable int num_batches = 0;
+  mutable int max_batch_size = 0;
+  bool fail = false;
+};
+
+// Euclidean Hamiltonian of the standard normal computing the potential
+// and its gradient in closed form
+template <typename Model, typename BaseRNG>
+class normal_hamiltonian : public base_hamiltonian<Model, ps_point, BaseRNG> {
+ public:
+  explicit normal_hamiltonian(const Model& model)
+      : base_hamiltonian<Model, ps_point, BaseRNG>(model) {}
+
+  double T(ps_point& z) { return 0.5 * z.p.squaredNorm(); }
+  double tau(ps_point& z) { return T(z); }
+  double phi(ps_point& z) { return this->V(z); }
+  double dG_dt(ps_point& z, callbacks::logger& logger) {
+    return 2 * T(z) - z.q.dot(z.g);
+  }
+  Eigen::VectorXd dtau_dq(ps_point& z, callbacks::logger& logger) {
+    return Eigen::VectorXd::Zero(z.q.size());
+  }
+  Eigen::VectorXd dtau_dp(ps_point& z) { return z.p; }
+  Eigen::VectorXd dphi_dq(ps_point& z, callbacks::logger& logger) {
+    return z.g;
+  }
+  void sample_p(ps_point& z, BaseRNG& rng) {
+    boost::variate_generator<BaseRNG&, boost::normal_distribution<> >
+        rand_gaus(rng, boost::normal_distribution<>());
+    for (int i = 0; i < z.p.size(); ++i)
+      z.p(i) = rand_gaus();
+  }
+  void init(ps_point& z, callbacks::logger& logger) {
+    update_potential_gradient(z, logger);
+  }
+  void update_potential_gradient(ps_point& z, callbacks::logger& logger) {
+    z.V = 0.5 * z.q.squaredNorm();
+    z.g = z.q;
+  }
+};
+
+typedef base_nuts<batch_normal_model, normal_hamiltonian, expl_leapfrog,
+                  stan::rng_t>
+    recursive_nuts;
+
+typedef base_nuts_lockstep<batch_normal_model, normal_hamiltonian,
+                           stan::rng_t>
+    lockstep_nuts;
+
+}  // namespace mcmc
+}  // namespace stan
+
+namespace {
+
+template <class Sampler>
+void configure(Sampler& sampler, const Eigen::VectorXd& q) {
+  sampler.set_nominal_stepsize(0.9);
+  sampler.set_stepsize_jitter(0);
+  sampler.set_max_depth(6);
+  sampler.z().q = q;
+}
+
+}  // namespace
+
+TEST(McmcNutsBaseNutsLockstep, matches_recursive_transitions) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  const int model_size = 3;
+  stan::mcmc::batch_normal_model model(model_size);
+  Eigen::VectorXd q0(model_size);
+  q0 << 1.5, -0.3, 2;
+
+  stan::rng_t rng_recursive = stan::services::util::create_rng(4839294, 1);
+  stan::mcmc::recursive_nuts recursive(model, rng_recursive);
+  configure(recursive, q0);
+
+  stan::rng_t rng_lockstep = stan::services::util::create_rng(4839294, 1);
+  stan::mcmc::lockstep_nuts lockstep(model, rng_lockstep);
+  configure(lockstep, q0);
+
+  stan::mcmc::sample s_recursive(q0, 0, 0);
+  stan::mcmc::sample s_lockstep(q0, 0, 0);
+  std::vector<int> depths;
+  for (int m = 0; m < 200; ++m) {
+    s_recursive = recursive.transition(s_recursive, logger);
+    s_lockstep = lockstep.transition(s_lockstep, logger);
+
+    ASSERT_EQ(recursive.depth_, lockstep.depth_);
+    ASSERT_EQ(recursive.n_leapfrog_, lockstep.n_leapfrog_);
+    ASSERT_EQ(recursive.divergent_, lockstep.divergent_);
+    ASSERT_EQ(recursive.energy_, lockstep.energy_);
+    ASSERT_EQ(s_recursive.log_prob(), s_lockstep.log_prob());
+    ASSERT_EQ(s_recursive.accept_stat(), s_lockstep.accept_stat());
+    for (int i = 0; i < model_size; ++i)
+      ASSERT_EQ(s_recursive.cont_params()(i), s_lockstep.cont_params()(i));
+    depths.push_back(lockstep.depth_);
+  }
+  EXPECT_NE(*std::min_element(depths.begin(), depths.end()),
+            *std::max_element(depths.begin(), depths.end()));
+  // The batched gradient is only used through the lockstep driver
+  EXPECT_EQ(0, model.num_batches);
+}
+
+namespace {
+
+// Run chains on their own and through the lockstep driver and check
+// that every chain produces the same draws either way
+void check_driver(bool fail_batches) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  const int model_size = 2;
+  const int num_chains = 3;
+  stan::mcmc::batch_normal_model model(model_size);
+  model.fail = fail_batches;
+
+  std::vector<stan::rng_t> rngs_single;
+  std::vector<stan::rng_t> rngs_batch;
+  rngs_single.reserve(num_chains);
+  rngs_batch.reserve(num_chains);
+  std::vector<stan::mcmc::lockstep_nuts> single;
+  std::vector<stan::mcmc::lockstep_nuts> batch;
+  single.reserve(num_chains);
+  batch.reserve(num_chains);
+  std::vector<stan::mcmc::sample> s_single;
+  std::vector<stan::mcmc::sample> s_batch;
+  for (int k = 0; k < num_chains; ++k) {
+    Eigen::VectorXd q0 = Eigen::VectorXd::Constant(model_size, k - 1.0);
+    rngs_single.emplace_back(stan::services::util::create_rng(123, k));
+    rngs_batch.emplace_back(stan::services::util::create_rng(123, k));
+    single.emplace_back(model, rngs_single[k]);
+    batch.emplace_back(model, rngs_batch[k]);
+    configure(single[k], q0);
+    configure(batch[k], q0);
+    s_single.emplace_back(q0, 0, 0);
+    s_batch.emplace_back(q0, 0, 0);
+  }
+
+  stan::mcmc::lockstep_driver<stan::mcmc::batch_normal_model> driver(model);
+  int num_leapfrog = 0;
+  for (int m = 0; m < 50; ++m) {
+    for (int k = 0; k < num_chains; ++k)
+      s_single[k] = single[k].transition(s_single[k], logger);
+    driver.transition(batch, s_batch, logger);
+
+    int max_leapfrog = 0;
+    for (int k = 0; k < num_chains; ++k) {
+      ASSERT_EQ(single[k].n_leapfrog_, batch[k].n_leapfrog_);
+      ASSERT_EQ(s_single[k].log_prob(), s_batch[k].log_prob());
+      ASSERT_EQ(s_single[k].accept_stat(), s_batch[k].accept_stat());
+      for (int i = 0; i < model_size; ++i)
+        ASSERT_EQ(s_single[k].cont_params()(i), s_batch[k].cont_params()(i));
+      max_leapfrog = std::max(max_leapfrog, batch[k].n_leapfrog_);
+    }
+    // One batch for the initial points plus one per leapfrog step of
+    // the longest trajectory
+    num_leapfrog += max_leapfrog + 1;
+  }
+
+  EXPECT_EQ(num_leapfrog, model.num_batches);
+  EXPECT_EQ(num_chains, model.max_batch_size);
+}
+
+}  // namespace
+
+TEST(McmcNutsBaseNutsLockstep, driver_matches_independent_chains) {
+  check_driver(false);
+}
+
+TEST(McmcNutsBaseNutsLockstep, driver_falls_back_when_batch_throws) {
+  check_driver(true);
+}
@@ -0,0 +1,36 @@
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/diag_e_nuts_lockstep.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/adapt_diag_e_nuts_lockstep.hpp>
+#include <stan/mcmc/hmc/nuts_lockstep/lockstep_driver.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(McmcNutsLockstep, instantiaton_test) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss3D_model_namespace::gauss3D_model model(data_var_context);
+
+  stan::mcmc::diag_e_nuts_lockstep<gauss3D_model_namespace::gauss3D_model,
+                                   stan::rng_t>
+      diag_e_sampler(model, base_rng);
+
+  std::vector<stan::mcmc::adapt_diag_e_nuts_lockstep<
+      gauss3D_model_namespace::gauss3D_model, stan::rng_t>>
+      adapt_diag_e_samplers;
+  adapt_diag_e_samplers.emplace_back(model, base_rng);
+  adapt_diag_e_samplers.emplace_back(model, base_rng);
+
+  std::vector<stan::mcmc::sample> samples(
+      2, stan::mcmc::sample(Eigen::VectorXd::Zero(model.num_params_r()), 0, 0));
+  stan::mcmc::lockstep_driver<gauss3D_model_namespace::gauss3D_model> driver(
+      model);
+  driver.transition(adapt_diag_e_samplers, samples, logger);
+}
@@ -0,0 +1,121 @@
+#include <stan/mcmc/hmc/static_da/diag_e_static_da_hmc.hpp>
+#include <stan/mcmc/hmc/static_da/dense_e_static_da_hmc.hpp>
+#include <stan/mcmc/hmc/static_da/gaussian_surrogate.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/services/util/create_rng.hpp>
+
+#include <test/test-models/good/mcmc/hmc/common/gauss.hpp>
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+TEST(McmcStaticDaHmc, gaussian_surrogate) {
+  Eigen::VectorXd mean(2);
+  mean << 1, -1;
+  Eigen::MatrixXd covar(2, 2);
+  covar << 4, 1, 1, 1;
+  stan::mcmc::gaussian_surrogate surrogate(mean, covar);
+  EXPECT_EQ(2, surrogate.num_params_r());
+
+  Eigen::VectorXd q(2);
+  q << 2, 0;
+  Eigen::VectorXd d = q - mean;
+  EXPECT_FLOAT_EQ(-0.5 * d.dot(covar.ldlt().solve(d)),
+                  surrogate.log_prob<true, true>(q, nullptr));
+
+  Eigen::MatrixXd not_pd(2, 2);
+  not_pd << 1, 2, 2, 1;
+  EXPECT_THROW(stan::mcmc::gaussian_surrogate(mean, not_pd),
+               std::invalid_argument);
+  EXPECT_THROW(
+      stan::mcmc::gaussian_surrogate(mean, Eigen::MatrixXd::Identity(3, 3)),
+      std::invalid_argument);
+
+  Eigen::MatrixXd draws(4, 2);
+  draws << 0, 0, 2, 0, 0, -2, 2, -2;
+  stan::mcmc::gaussian_surrogate fitted
+      = stan::mcmc::gaussian_surrogate::from_draws(draws);
+  EXPECT_FLOAT_EQ(1, fitted.mean()(0));
+  EXPECT_FLOAT_EQ(-1, fitted.mean()(1));
+  EXPECT_THROW(stan::mcmc::gaussian_surrogate::from_draws(draws.topRows(1)),
+               std::invalid_argument);
+}
+
+TEST(McmcStaticDaHmc, exact_surrogate) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss_model_namespace::gauss_model model(data_var_context);
+  stan::mcmc::gaussian_surrogate surrogate(Eigen::VectorXd::Zero(1),
+                                           Eigen::MatrixXd::Identity(1, 1));
+
+  stan::mcmc::diag_e_static_da_hmc<gauss_model_namespace::gauss_model,
+                                   stan::mcmc::gaussian_surrogate,
+                                   stan::rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize_and_T(0.5, 2);
+  sampler.set_stepsize_jitter(0);
+
+  std::vector<std::string> names;
+  sampler.get_sampler_param_names(names);
+  ASSERT_EQ(4, names.size());
+  EXPECT_EQ("da_accept_stat__", names[3]);
+
+  Eigen::VectorXd q(1);
+  q << 1;
+  stan::mcmc::sample s(q, 0, 0);
+  for (int n = 0; n < 100; ++n) {
+    s = sampler.transition(s, logger);
+    // the surrogate is the model, so the second stage always accepts
+    std::vector<double> values;
+    sampler.get_sampler_params(values);
+    if (values[3] > 0)
+      EXPECT_FLOAT_EQ(1, values[3]);
+    EXPECT_FLOAT_EQ(-0.5 * s.cont_params()(0) * s.cont_params()(0),
+                    s.log_prob());
+  }
+  EXPECT_LE(sampler.num_target_evaluations(), 101);
+  EXPECT_EQ("", error.str());
+}
+
+TEST(McmcStaticDaHmc, biased_surrogate) {
+  stan::rng_t base_rng = stan::services::util::create_rng(4839294, 0);
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::io::empty_var_context data_var_context;
+  gauss_model_namespace::gauss_model model(data_var_context);
+  stan::mcmc::gaussian_surrogate surrogate(Eigen::VectorXd::Constant(1, 0.3),
+                                           Eigen::MatrixXd::Constant(1, 1, 2));
+
+  stan::mcmc::dense_e_static_da_hmc<gauss_model_namespace::gauss_model,
+                                    stan::mcmc::gaussian_surrogate,
+                                    stan::rng_t>
+      sampler(model, surrogate, base_rng);
+  sampler.set_nominal_stepsize_and_T(0.5, 2);
+  sampler.set_stepsize_jitter(0);
+
+  Eigen::VectorXd q(1);
+  q << 0;
+  stan::mcmc::sample s(q, 0, 0);
+  const int num_draws = 10000;
+  double sum = 0;
+  double sum_sq = 0;
+  for (int n = 0; n < num_draws; ++n) {
+    s = sampler.transition(s, logger);
+    sum += s.cont_params()(0);
+    sum_sq += s.cont_params()(0) * s.cont_params()(0);
+  }
+  // the second stage corrects the surrogate to the standard normal
+  double mean = sum / num_draws;
+  EXPECT_NEAR(0, mean, 0.1);
+  EXPECT_NEAR(1, sum_sq / num_draws - mean * mean, 0.15);
+  EXPECT_LE(sampler.num_target_evaluations(), num_draws + 1);
+  EXPECT_EQ("", error.str());
+}
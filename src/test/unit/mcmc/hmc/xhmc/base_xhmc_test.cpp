@@ -161,6 +161,47 @@ TEST(McmcXHMCBaseXHMC, build_tree) {
   EXPECT_EQ("", fatal.str());
 }
 
+TEST(McmcXHMCBaseXHMC, build_tree_beyond_max_depth) {
+  stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
+
+  int model_size = 1;
+  double init_momentum = 1.5;
+
+  stan::mcmc::ps_point z_init(model_size);
+  z_init.q(0) = 0;
+  z_init.p(0) = init_momentum;
+
+  stan::mcmc::ps_point z_propose(model_size);
+
+  double ave = 0;
+  double log_sum_weight = -std::numeric_limits<double>::infinity();
+
+  double H0 = -0.1;
+  int n_leapfrog = 0;
+  double sum_metro_prob = 0;
+
+  stan::mcmc::mock_model model(model_size);
+  stan::mcmc::mock_xhmc sampler(model, base_rng);
+
+  sampler.set_max_depth(1);
+  sampler.set_nominal_stepsize(1);
+  sampler.set_stepsize_jitter(0);
+  sampler.sample_stepsize();
+  sampler.z() = z_init;
+
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  bool valid_subtree
+      = sampler.build_tree(3, z_propose, ave, log_sum_weight, H0, 1, n_leapfrog,
+                           sum_metro_prob, logger);
+
+  EXPECT_TRUE(valid_subtree);
+  EXPECT_EQ(8 * init_momentum, sampler.z().q(0));
+  EXPECT_EQ(8, n_leapfrog);
+  EXPECT_FLOAT_EQ(2, ave);
+}
+
 TEST(McmcXHMCBaseXHMC, divergence_test) {
   stan::rng_t base_rng = stan::services::util::create_rng(0, 0);
 
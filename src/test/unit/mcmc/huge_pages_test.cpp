@@ -0,0 +1,34 @@
+#include <stan/mcmc/huge_pages.hpp>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+
+TEST(McmcHugePages, small_ranges_are_not_advised) {
+  Eigen::VectorXd x(1000);
+  EXPECT_EQ(0U, stan::mcmc::advise_huge_pages(x));
+  EXPECT_EQ(0U, stan::mcmc::advise_huge_pages(nullptr, 0));
+}
+
+TEST(McmcHugePages, only_whole_pages_are_advised) {
+  const std::size_t page = stan::mcmc::huge_page_bytes;
+  char* data = static_cast<char*>(std::aligned_alloc(page, 4 * page));
+  ASSERT_NE(nullptr, data);
+
+  // Either the whole pages within the range or nothing, where
+  // transparent huge pages are not available
+  std::size_t bytes = stan::mcmc::advise_huge_pages(data + 1, 3 * page);
+  EXPECT_TRUE(bytes == 2 * page || bytes == 0);
+  bytes = stan::mcmc::advise_huge_pages(data, 4 * page);
+  EXPECT_TRUE(bytes == 4 * page || bytes == 0);
+  EXPECT_EQ(0U, stan::mcmc::advise_huge_pages(data + 1, page));
+  std::free(data);
+}
+
+TEST(McmcHugePages, vector) {
+  const std::size_t n = 4 * stan::mcmc::huge_page_bytes / sizeof(double);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+  std::size_t bytes = stan::mcmc::advise_huge_pages(x);
+  EXPECT_EQ(0U, bytes % stan::mcmc::huge_page_bytes);
+  EXPECT_LE(bytes, n * sizeof(double));
+  EXPECT_FLOAT_EQ(0, x.sum());
+}
@@ -0,0 +1,68 @@
+#include <stan/mcmc/lowrank_adaptation.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+
+TEST(McmcLowrankAdaptation, learn_lowrank) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 10;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd var(Eigen::VectorXd::Zero(n));
+  Eigen::MatrixXd lowrank(n, 0);
+
+  const int n_learn = 10;
+
+  Eigen::VectorXd target_var(Eigen::VectorXd::Ones(n));
+  target_var *= 1e-3 * 5.0 / (n_learn + 5.0);
+
+  stan::mcmc::lowrank_adaptation adapter(n, 2);
+  adapter.set_window_params(50, 0, 0, n_learn, logger);
+
+  for (int i = 0; i < n_learn; ++i)
+    adapter.learn_lowrank(var, lowrank, q);
+
+  for (int i = 0; i < n; ++i)
+    EXPECT_EQ(target_var(i), var(i));
+  EXPECT_EQ(n, lowrank.rows());
+  EXPECT_EQ(0, lowrank.cols());
+
+  EXPECT_EQ(0, logger.call_count());
+}
+
+TEST(McmcLowrankAdaptation, correlated_direction) {
+  stan::test::unit::instrumented_logger logger;
+  stan::rng_t rng = stan::services::util::create_rng(0, 0);
+  boost::variate_generator<stan::rng_t&, boost::normal_distribution<> >
+      rand_gaus(rng, boost::normal_distribution<>());
+
+  const int n = 5;
+  const int n_learn = 2000;
+  Eigen::VectorXd var(Eigen::VectorXd::Zero(n));
+  Eigen::MatrixXd lowrank(n, 0);
+
+  // Unit variance plus a common factor of variance 9
+  stan::mcmc::lowrank_adaptation adapter(n, 3);
+  adapter.set_window_params(n_learn + 50, 0, 0, n_learn, logger);
+  bool updated = false;
+  for (int i = 0; i < n_learn; ++i) {
+    double f = 3 * rand_gaus();
+    Eigen::VectorXd q(n);
+    for (int j = 0; j < n; ++j)
+      q(j) = f + rand_gaus();
+    updated = adapter.learn_lowrank(var, lowrank, q);
+  }
+  ASSERT_TRUE(updated);
+  ASSERT_EQ(1, lowrank.cols());
+
+  for (int i = 0; i < n; ++i)
+    EXPECT_NEAR(1.0, var(i), 0.5);
+
+  Eigen::MatrixXd inv_metric = lowrank * lowrank.transpose();
+  inv_metric.diagonal() += var;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      EXPECT_NEAR(i == j ? 10.0 : 9.0, inv_metric(i, j), 1.5);
+}
@@ -0,0 +1,84 @@
+#include <stan/mcmc/mapped_chains.hpp>
+#include <stan/mcmc/chains.hpp>
+#include <stan/callbacks/binary_writer.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class McmcMappedChains : public testing::Test {
+ public:
+  void SetUp() {
+    const std::vector<std::string> csv_files{
+        "src/test/unit/mcmc/test_csv_files/blocker.1.csv",
+        "src/test/unit/mcmc/test_csv_files/blocker.2.csv"};
+    for (size_t i = 0; i < csv_files.size(); ++i) {
+      std::ifstream in(csv_files[i]);
+      std::stringstream out;
+      csvs.push_back(stan::io::stan_csv_reader::parse(in, &out));
+      file_names.push_back("mapped_chains_test." + std::to_string(i) + ".bin");
+      auto output = std::make_unique<std::ofstream>(file_names.back(),
+                                                    std::ios::binary);
+      stan::callbacks::binary_writer<std::ofstream> writer(std::move(output),
+                                                           64);
+      writer(csvs.back().header);
+      Eigen::MatrixXd draws = csvs.back().samples.transpose();
+      writer(draws);
+    }
+  }
+
+  void TearDown() {
+    for (const auto& file_name : file_names)
+      std::remove(file_name.c_str());
+  }
+
+  std::vector<stan::io::stan_csv> csvs;
+  std::vector<std::string> file_names;
+};
+
+TEST_F(McmcMappedChains, matches_chains) {
+  stan::mcmc::chains<> chains(csvs[0]);
+  chains.add(csvs[1]);
+  stan::mcmc::mapped_chains mapped(file_names);
+
+  ASSERT_EQ(chains.num_chains(), mapped.num_chains());
+  ASSERT_EQ(chains.num_params(), mapped.num_params());
+  EXPECT_EQ(chains.param_names(), mapped.param_names());
+  EXPECT_EQ(chains.num_samples(), mapped.num_samples());
+  for (int index = 0; index < chains.num_params(); ++index) {
+    for (int chain = 0; chain < chains.num_chains(); ++chain)
+      EXPECT_TRUE(chains.samples(chain, index)
+                  == mapped.samples(chain, index));
+    EXPECT_FLOAT_EQ(chains.mean(index), mapped.mean(index));
+    EXPECT_FLOAT_EQ(chains.sd(index), mapped.sd(index));
+    EXPECT_FLOAT_EQ(chains.effective_sample_size(index),
+                    mapped.effective_sample_size(index));
+    EXPECT_FLOAT_EQ(chains.split_potential_scale_reduction(index),
+                    mapped.split_potential_scale_reduction(index));
+  }
+}
+
+TEST_F(McmcMappedChains, warmup) {
+  stan::mcmc::chains<> chains(csvs[0]);
+  chains.add(csvs[1]);
+  chains.set_warmup(100);
+  stan::mcmc::mapped_chains mapped(file_names);
+  mapped.set_warmup(100);
+
+  const std::string& name = csvs[0].header[6];
+  EXPECT_EQ(chains.num_kept_samples(), mapped.num_kept_samples());
+  EXPECT_TRUE(chains.samples(name) == mapped.samples(name));
+  EXPECT_FLOAT_EQ(chains.split_effective_sample_size(name),
+                  mapped.split_effective_sample_size(name));
+}
+
+TEST_F(McmcMappedChains, errors) {
+  EXPECT_THROW(stan::mcmc::mapped_chains({}), std::invalid_argument);
+  EXPECT_THROW(stan::mcmc::mapped_chains({file_names[0], "missing.bin"}),
+               std::invalid_argument);
+}
@@ -0,0 +1,94 @@
+#include <stan/mcmc/replica_exchange.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+std::vector<stan::mcmc::sample> make_states(int num_replicas) {
+  std::vector<stan::mcmc::sample> states;
+  for (int k = 0; k < num_replicas; ++k)
+    states.emplace_back(Eigen::VectorXd::Constant(2, k), -k, 0.5);
+  return states;
+}
+}  // namespace
+
+TEST(McmcReplicaExchange, valid_ladder) {
+  using stan::mcmc::replica_exchange;
+  EXPECT_TRUE(replica_exchange::is_valid_ladder({1}));
+  EXPECT_TRUE(replica_exchange::is_valid_ladder({1, 0.5, 0}));
+  EXPECT_FALSE(replica_exchange::is_valid_ladder({}));
+  EXPECT_FALSE(replica_exchange::is_valid_ladder({0.9, 0.5}));
+  EXPECT_FALSE(replica_exchange::is_valid_ladder({1, 0.5, 0.5}));
+  EXPECT_FALSE(replica_exchange::is_valid_ladder({1, 0.5, -0.1}));
+  EXPECT_FALSE(replica_exchange::is_valid_ladder(
+      {1, std::numeric_limits<double>::quiet_NaN()}));
+  EXPECT_THROW(replica_exchange({1, 2}), std::invalid_argument);
+}
+
+TEST(McmcReplicaExchange, alternating_pairs) {
+  stan::mcmc::replica_exchange exchange({1, 0.5, 0.25, 0});
+  EXPECT_EQ(4, exchange.num_replicas());
+  EXPECT_FLOAT_EQ(0.25, exchange.inverse_temperature(2));
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  std::vector<stan::mcmc::sample> states = make_states(4);
+
+  // Equal log density ratios always swap
+  Eigen::VectorXd log_ratio = Eigen::VectorXd::Zero(4);
+  exchange.exchange(states, log_ratio, rng);
+  EXPECT_FLOAT_EQ(1, states[0].cont_params(0));
+  EXPECT_FLOAT_EQ(0, states[1].cont_params(0));
+  EXPECT_FLOAT_EQ(3, states[2].cont_params(0));
+  EXPECT_FLOAT_EQ(2, states[3].cont_params(0));
+  EXPECT_EQ(1, exchange.num_proposed(0));
+  EXPECT_EQ(0, exchange.num_proposed(1));
+  EXPECT_EQ(1, exchange.num_proposed(2));
+
+  exchange.exchange(states, log_ratio, rng);
+  EXPECT_FLOAT_EQ(1, states[0].cont_params(0));
+  EXPECT_FLOAT_EQ(3, states[1].cont_params(0));
+  EXPECT_FLOAT_EQ(0, states[2].cont_params(0));
+  EXPECT_FLOAT_EQ(2, states[3].cont_params(0));
+  EXPECT_FLOAT_EQ(-3, states[1].log_prob());
+  EXPECT_EQ(1, exchange.num_accepted(1));
+  EXPECT_FLOAT_EQ(1, exchange.swap_rate(1));
+  EXPECT_TRUE(std::isnan(exchange.swap_rate(3)));
+
+  exchange.reset_counters();
+  EXPECT_EQ(0, exchange.num_proposed(0));
+  EXPECT_TRUE(std::isnan(exchange.swap_rate(0)));
+}
+
+TEST(McmcReplicaExchange, acceptance) {
+  stan::mcmc::replica_exchange exchange({1, 0.5});
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  std::vector<stan::mcmc::sample> states = make_states(2);
+  Eigen::VectorXd log_ratio(2);
+
+  // The hot state is far less likely under the posterior
+  log_ratio << 0, -1000;
+  for (int n = 0; n < 10; ++n)
+    exchange.exchange(states, log_ratio, rng);
+  EXPECT_EQ(5, exchange.num_proposed(0));
+  EXPECT_EQ(0, exchange.num_accepted(0));
+  EXPECT_FLOAT_EQ(0, states[0].cont_params(0));
+
+  // A state that cannot be evaluated never moves to the posterior
+  log_ratio << 0, -std::numeric_limits<double>::infinity();
+  exchange.exchange(states, log_ratio, rng);
+  EXPECT_EQ(0, exchange.num_accepted(0));
+
+  // Rate of exp(-1) from a difference of 2 at half the temperature
+  exchange.reset_counters();
+  log_ratio << 0, -2;
+  for (int n = 0; n < 20000; ++n) {
+    exchange.exchange(states, log_ratio, rng);
+    if (states[0].cont_params(0) != 0) {
+      std::swap(states[0], states[1]);
+      std::swap(log_ratio(0), log_ratio(1));
+    }
+  }
+  EXPECT_NEAR(std::exp(-1.0), exchange.swap_rate(0), 0.02);
+}
@@ -66,3 +66,21 @@ TEST(McmcSample, accept_stat) {
 
   EXPECT_EQ(accept_stat, s.accept_stat());
 }
+
+TEST(McmcSample, swap_cont_params) {
+  Eigen::VectorXd q(2);
+  q(0) = 5;
+  q(1) = 1;
+  stan::mcmc::sample s(q, -10, 0.5);
+
+  Eigen::VectorXd other(3);
+  other << 1, 2, 3;
+  const double* other_data = other.data();
+  s.swap_cont_params(other);
+
+  EXPECT_EQ(3, s.size_cont());
+  EXPECT_EQ(other_data, s.cont_params().data());
+  ASSERT_EQ(2, other.size());
+  EXPECT_EQ(5, other(0));
+  EXPECT_EQ(1, other(1));
+}
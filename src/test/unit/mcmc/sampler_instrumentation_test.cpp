@@ -0,0 +1,89 @@
+#include <stan/mcmc/sampler_instrumentation.hpp>
+#include <stan/callbacks/json_writer.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+TEST(McmcSamplerInstrumentation, construction) {
+  stan::mcmc::sampler_instrumentation stats;
+  EXPECT_EQ(0U, stats.num_transitions);
+  EXPECT_EQ(0U, stats.num_gradient_evaluations);
+  EXPECT_EQ(0U, stats.num_leapfrog_steps);
+  EXPECT_EQ(0, stats.transition_time);
+  EXPECT_EQ(0, stats.gradient_time);
+  EXPECT_EQ(0, stats.output_time);
+  EXPECT_EQ(0, stats.adaptation_time);
+  EXPECT_TRUE(stats.tree_depth_histogram.empty());
+  EXPECT_EQ(0U, stats.huge_page_bytes);
+}
+
+TEST(McmcSamplerInstrumentation, add_tree_depth) {
+  stan::mcmc::sampler_instrumentation stats;
+  stats.add_tree_depth(3);
+  stats.add_tree_depth(1);
+  stats.add_tree_depth(3);
+  stats.add_tree_depth(-1);
+
+  ASSERT_EQ(4U, stats.tree_depth_histogram.size());
+  EXPECT_EQ(0, stats.tree_depth_histogram[0]);
+  EXPECT_EQ(1, stats.tree_depth_histogram[1]);
+  EXPECT_EQ(0, stats.tree_depth_histogram[2]);
+  EXPECT_EQ(2, stats.tree_depth_histogram[3]);
+
+  stats.add_tape_usage(4096, 10);
+  stats.add_tape_usage(2048, 12);
+  EXPECT_EQ(4096U, stats.peak_tape_bytes);
+  EXPECT_EQ(12U, stats.peak_tape_vars);
+
+  stats.add_huge_page_usage(4194304);
+  stats.add_huge_page_usage(2097152);
+  EXPECT_EQ(4194304U, stats.huge_page_bytes);
+
+  stats.num_transitions = 3;
+  stats.reset();
+  EXPECT_EQ(0U, stats.huge_page_bytes);
+  EXPECT_EQ(0U, stats.peak_tape_bytes);
+  EXPECT_EQ(0U, stats.peak_tape_vars);
+  EXPECT_EQ(0U, stats.num_transitions);
+  EXPECT_TRUE(stats.tree_depth_histogram.empty());
+}
+
+TEST(McmcSamplerInstrumentation, write) {
+  std::stringstream ss;
+  std::unique_ptr<std::stringstream, deleter_noop> output(&ss);
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> writer(
+      std::move(output));
+
+  stan::mcmc::sampler_instrumentation stats;
+  stats.num_transitions = 2;
+  stats.num_gradient_evaluations = 7;
+  stats.num_leapfrog_steps = 6;
+  stats.add_tree_depth(1);
+  stats.add_tree_depth(2);
+  stats.add_tape_usage(65536, 40);
+
+  writer.begin_record();
+  stats.write(writer, "sampling");
+  writer.end_record();
+
+  std::string out = ss.str();
+  out.erase(std::remove_if(out.begin(), out.end(),
+                           [](char c) { return c == ' ' || c == '\n'; }),
+            out.end());
+  EXPECT_NE(std::string::npos, out.find("\"sampling\":{"));
+  EXPECT_NE(std::string::npos, out.find("\"transitions\":2"));
+  EXPECT_NE(std::string::npos, out.find("\"gradient_evaluations\":7"));
+  EXPECT_NE(std::string::npos, out.find("\"leapfrog_steps\":6"));
+  EXPECT_NE(std::string::npos, out.find("\"tree_depth_histogram\":[0,1,1]"));
+  EXPECT_NE(std::string::npos, out.find("\"adaptation_time\":0"));
+  EXPECT_NE(std::string::npos, out.find("\"peak_tape_bytes\":65536"));
+  EXPECT_NE(std::string::npos, out.find("\"peak_tape_vars\":40"));
+  EXPECT_NE(std::string::npos, out.find("\"huge_page_bytes\":0"));
+}
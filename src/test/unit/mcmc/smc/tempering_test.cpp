@@ -0,0 +1,52 @@
+#include <stan/mcmc/smc/tempering.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+TEST(McmcSmcTempering, effective_sample_size) {
+  Eigen::VectorXd log_weights = Eigen::VectorXd::Constant(4, -3);
+  EXPECT_FLOAT_EQ(4, stan::mcmc::effective_sample_size(log_weights));
+  log_weights(0) = -std::numeric_limits<double>::infinity();
+  EXPECT_FLOAT_EQ(3, stan::mcmc::effective_sample_size(log_weights));
+  log_weights.setConstant(-std::numeric_limits<double>::infinity());
+  EXPECT_EQ(0, stan::mcmc::effective_sample_size(log_weights));
+}
+
+TEST(McmcSmcTempering, log_mean_exp) {
+  Eigen::VectorXd values(3);
+  values << 1000, 1000 + std::log(2.0),
+      -std::numeric_limits<double>::infinity();
+  EXPECT_FLOAT_EQ(1000, stan::mcmc::log_mean_exp(values));
+}
+
+TEST(McmcSmcTempering, next_temperature) {
+  Eigen::VectorXd log_ratio(100);
+  for (int i = 0; i < 100; ++i)
+    log_ratio(i) = -0.5 * i;
+  const double next = stan::mcmc::next_temperature(log_ratio, 0.1, 50);
+  EXPECT_GT(next, 0.1);
+  EXPECT_LT(next, 1);
+  EXPECT_NEAR(50, stan::mcmc::effective_sample_size((next - 0.1) * log_ratio),
+              1e-6);
+
+  // Equal log ratios leave the weights equal
+  log_ratio.setConstant(-7);
+  EXPECT_EQ(1, stan::mcmc::next_temperature(log_ratio, 0.1, 50));
+}
+
+TEST(McmcSmcTempering, systematic_resample) {
+  Eigen::VectorXd log_weights(4);
+  log_weights << std::log(0.1), std::log(0.4),
+      -std::numeric_limits<double>::infinity(), std::log(0.5);
+  std::vector<Eigen::Index> ancestors;
+  stan::mcmc::systematic_resample(log_weights, 0.2, ancestors);
+  // Points 0.05, 0.3, 0.55, 0.8 of cumulative weights 0.1, 0.5, 0.5, 1
+  std::vector<Eigen::Index> expected{0, 1, 3, 3};
+  EXPECT_EQ(expected, ancestors);
+
+  log_weights.setZero(1000);
+  stan::mcmc::systematic_resample(log_weights, 0.3, ancestors);
+  for (Eigen::Index j = 0; j < 1000; ++j)
+    EXPECT_EQ(j, ancestors[j]);
+}
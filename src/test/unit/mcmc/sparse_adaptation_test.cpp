@@ -0,0 +1,87 @@
+#include <stan/mcmc/sparse_adaptation.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(McmcSparseAdaptation, banded_pattern) {
+  std::vector<std::vector<int>> pattern = stan::mcmc::banded_pattern(4, 1);
+  ASSERT_EQ(4, pattern.size());
+  EXPECT_EQ((std::vector<int>{0, 1}), pattern[0]);
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), pattern[1]);
+  EXPECT_EQ((std::vector<int>{2, 3}), pattern[3]);
+}
+
+TEST(McmcSparseAdaptation, invalid_pattern) {
+  EXPECT_THROW(
+      stan::mcmc::sparse_adaptation(3, stan::mcmc::banded_pattern(2, 1)),
+      std::invalid_argument);
+  std::vector<std::vector<int>> pattern{{0}, {1, 3}, {2}};
+  EXPECT_THROW(stan::mcmc::sparse_adaptation(3, pattern),
+               std::invalid_argument);
+}
+
+TEST(McmcSparseAdaptation, learn_metric) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 5;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n);
+  Eigen::SparseMatrix<double> metric;
+
+  const int n_learn = 10;
+  const double target_var = 1e-3 * 5.0 / (n_learn + 5.0);
+
+  stan::mcmc::sparse_adaptation adapter(n, stan::mcmc::banded_pattern(n, 1));
+  adapter.set_window_params(50, 0, 0, n_learn, logger);
+
+  bool updated = false;
+  for (int i = 0; i < n_learn; ++i)
+    updated = adapter.learn_metric(metric, q);
+  ASSERT_TRUE(updated);
+
+  Eigen::MatrixXd dense_metric(metric);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      EXPECT_FLOAT_EQ(i == j ? 1.0 / target_var : 0.0, dense_metric(i, j));
+
+  EXPECT_EQ(0, logger.call_count());
+}
+
+TEST(McmcSparseAdaptation, autoregressive) {
+  stan::test::unit::instrumented_logger logger;
+  stan::rng_t rng = stan::services::util::create_rng(0, 0);
+  boost::variate_generator<stan::rng_t&, boost::normal_distribution<> >
+      rand_gaus(rng, boost::normal_distribution<>());
+
+  // Stationary AR(1) with coefficient 0.8 and unit innovations, whose
+  // precision is tridiagonal
+  const int n = 6;
+  const int n_learn = 5000;
+  const double phi = 0.8;
+  Eigen::SparseMatrix<double> metric;
+
+  stan::mcmc::sparse_adaptation adapter(n, stan::mcmc::banded_pattern(n, 1));
+  adapter.set_window_params(n_learn + 50, 0, 0, n_learn, logger);
+  bool updated = false;
+  for (int i = 0; i < n_learn; ++i) {
+    Eigen::VectorXd q(n);
+    q(0) = rand_gaus() / std::sqrt(1 - phi * phi);
+    for (int j = 1; j < n; ++j)
+      q(j) = phi * q(j - 1) + rand_gaus();
+    updated = adapter.learn_metric(metric, q);
+  }
+  ASSERT_TRUE(updated);
+  EXPECT_EQ(3 * n - 2, metric.nonZeros());
+
+  Eigen::MatrixXd dense_metric(metric);
+  for (int i = 0; i < n; ++i) {
+    double expected_diag = (i == 0 || i == n - 1) ? 1.0 : 1.0 + phi * phi;
+    EXPECT_NEAR(expected_diag, dense_metric(i, i), 0.1);
+    if (i > 0) {
+      EXPECT_NEAR(-phi, dense_metric(i, i - 1), 0.1);
+      EXPECT_FLOAT_EQ(dense_metric(i, i - 1), dense_metric(i - 1, i));
+    }
+  }
+}
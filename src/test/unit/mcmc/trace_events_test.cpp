@@ -0,0 +1,76 @@
+#define STAN_TRACE
+#include <stan/mcmc/trace_events.hpp>
+#include <stan/mcmc/windowed_adaptation.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+size_t count(const std::string& s, const std::string& pattern) {
+  size_t n = 0;
+  for (size_t pos = s.find(pattern); pos != std::string::npos;
+       pos = s.find(pattern, pos + 1))
+    ++n;
+  return n;
+}
+
+void nested_scopes() {
+  STAN_TRACE_SCOPE("outer");
+  for (int n = 0; n < 3; ++n) {
+    STAN_TRACE_SCOPE("inner");
+  }
+}
+}  // namespace
+
+TEST(McmcTraceEvents, scopes_of_threads) {
+  stan::mcmc::trace_registry::instance().clear();
+  nested_scopes();
+  std::thread thread(nested_scopes);
+  thread.join();
+
+  std::stringstream json;
+  stan::mcmc::trace_registry::instance().write_json(json);
+  const std::string trace = json.str();
+  EXPECT_EQ(0, trace.find("{\"traceEvents\":["));
+  EXPECT_EQ(4, count(trace, "\"name\":\"outer\""));
+  EXPECT_EQ(12, count(trace, "\"name\":\"inner\""));
+  EXPECT_EQ(8, count(trace, "\"ph\":\"B\""));
+  EXPECT_EQ(8, count(trace, "\"ph\":\"E\""));
+  EXPECT_EQ(16, count(trace, "\"tid\":"));
+  EXPECT_LT(trace.find("\"name\":\"outer\",\"ph\":\"B\""),
+            trace.find("\"name\":\"inner\",\"ph\":\"B\""));
+}
+
+TEST(McmcTraceEvents, ring_buffer_keeps_newest) {
+  stan::mcmc::trace_buffer buffer(3);
+  const size_t n = stan::mcmc::trace_buffer::capacity + 10;
+  for (size_t k = 0; k < n; ++k)
+    buffer.record(k < 10 ? "old" : "new", 'i');
+  EXPECT_EQ(stan::mcmc::trace_buffer::capacity, buffer.size());
+  size_t num_old = 0;
+  std::int64_t last = 0;
+  buffer.for_each([&](const stan::mcmc::trace_event& event) {
+    num_old += std::string(event.name) == "old";
+    EXPECT_LE(last, event.time_ns);
+    last = event.time_ns;
+  });
+  EXPECT_EQ(0, num_old);
+  buffer.clear();
+  EXPECT_EQ(0, buffer.size());
+}
+
+TEST(McmcTraceEvents, adaptation_window_close) {
+  stan::mcmc::trace_registry::instance().clear();
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::mcmc::windowed_adaptation adaptation("test");
+  adaptation.set_window_params(1000, 75, 50, 25, logger);
+  adaptation.compute_next_window();
+
+  std::stringstream json;
+  stan::mcmc::trace_registry::instance().write_json(json);
+  EXPECT_EQ(1, count(json.str(), "\"name\":\"adaptation_window_close\""));
+  EXPECT_EQ(1, count(json.str(), "\"ph\":\"i\""));
+}
@@ -25,3 +25,103 @@ TEST(McmcVarAdaptation, learn_variance) {
 
   EXPECT_EQ(0, logger.call_count());
 }
+
+TEST(McmcVarAdaptation, pool_windows) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 3;
+  const int n_learn = 10;
+
+  stan::mcmc::var_adaptation adapter1(n);
+  stan::mcmc::var_adaptation adapter2(n);
+  stan::mcmc::var_adaptation adapter_all(n);
+  adapter1.set_window_params(50, 0, 0, n_learn, logger);
+  adapter2.set_window_params(50, 0, 0, n_learn, logger);
+  adapter_all.set_window_params(100, 0, 0, 2 * n_learn, logger);
+
+  Eigen::VectorXd var(Eigen::VectorXd::Zero(n));
+  Eigen::VectorXd var_all(Eigen::VectorXd::Zero(n));
+  for (int i = 0; i < n_learn; ++i) {
+    Eigen::VectorXd q1(n), q2(n);
+    q1 << i, 0.5 * i * i, -i;
+    q2 << 3 + i, 1 - i, 2 * i;
+    adapter1.learn_variance(var, q1);
+    adapter2.learn_variance(var, q2);
+    adapter_all.learn_variance(var_all, q1);
+    adapter_all.learn_variance(var_all, q2);
+  }
+
+  Eigen::VectorXd pooled(Eigen::VectorXd::Zero(n));
+  stan::mcmc::var_adaptation::pool_windows(pooled, {&adapter1, &adapter2});
+
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(var_all(i), pooled(i));
+}
+
+namespace {
+// Reduction over two processes holding the same chains
+struct duplicate_reducer {
+  void sum(double& x) const { x *= 2; }
+  template <typename Derived>
+  void sum(Eigen::MatrixBase<Derived>& x) const {
+    x *= 2;
+  }
+  size_t chain_offset(size_t num_chains) const { return 0; }
+};
+}  // namespace
+
+TEST(McmcVarAdaptation, pool_windows_reducer) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 3;
+  const int n_learn = 10;
+
+  stan::mcmc::var_adaptation adapter1(n);
+  stan::mcmc::var_adaptation adapter2(n);
+  adapter1.set_window_params(50, 0, 0, n_learn, logger);
+  adapter2.set_window_params(50, 0, 0, n_learn, logger);
+
+  Eigen::VectorXd var(Eigen::VectorXd::Zero(n));
+  for (int i = 0; i < n_learn; ++i) {
+    Eigen::VectorXd q1(n), q2(n);
+    q1 << i, 0.5 * i * i, -i;
+    q2 << 3 + i, 1 - i, 2 * i;
+    adapter1.learn_variance(var, q1);
+    adapter2.learn_variance(var, q2);
+  }
+
+  Eigen::VectorXd expected(Eigen::VectorXd::Zero(n));
+  stan::mcmc::var_adaptation::pool_windows(
+      expected, {&adapter1, &adapter2, &adapter1, &adapter2});
+  Eigen::VectorXd pooled(Eigen::VectorXd::Zero(n));
+  stan::mcmc::var_adaptation::pool_windows(pooled, {&adapter1, &adapter2},
+                                           duplicate_reducer());
+
+  for (int i = 0; i < n; ++i)
+    EXPECT_FLOAT_EQ(expected(i), pooled(i));
+}
+
+TEST(McmcVarAdaptation, end_slow_adaptation) {
+  stan::test::unit::instrumented_logger logger;
+
+  const int n = 2;
+  Eigen::VectorXd q = Eigen::VectorXd::Zero(n);
+  Eigen::VectorXd var(Eigen::VectorXd::Ones(n));
+
+  stan::mcmc::var_adaptation adapter(n);
+  adapter.set_window_params(100, 10, 10, 20, logger);
+  EXPECT_EQ(30, adapter.iterations_to_window_end());
+
+  for (int i = 0; i < 29; ++i)
+    EXPECT_FALSE(adapter.learn_variance(var, q));
+  EXPECT_EQ(1, adapter.iterations_to_window_end());
+  EXPECT_TRUE(adapter.learn_variance(var, q));
+  EXPECT_EQ(60, adapter.iterations_to_window_end());
+
+  EXPECT_EQ(10, adapter.end_slow_adaptation());
+  EXPECT_EQ(0, adapter.iterations_to_window_end());
+  Eigen::VectorXd var_end = var;
+  for (int i = 0; i < 70; ++i)
+    EXPECT_FALSE(adapter.learn_variance(var, q));
+  EXPECT_EQ(var_end, var);
+}
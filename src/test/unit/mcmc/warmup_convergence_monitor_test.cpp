@@ -0,0 +1,51 @@
+#include <stan/mcmc/warmup_convergence_monitor.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+TEST(McmcWarmupConvergenceMonitor, first_window_never_converges) {
+  stan::mcmc::warmup_convergence_monitor monitor;
+  Eigen::VectorXd metric = Eigen::VectorXd::Ones(3);
+  std::vector<double> lp = {1, -1, 1, -1, 1, -1, 1, -1};
+
+  EXPECT_FALSE(monitor.end_window(metric, 0.0, lp));
+  EXPECT_EQ(1, monitor.num_windows());
+  EXPECT_TRUE(std::isinf(monitor.metric_change()));
+}
+
+TEST(McmcWarmupConvergenceMonitor, stable_windows_converge) {
+  stan::mcmc::warmup_convergence_monitor monitor;
+  Eigen::VectorXd metric = Eigen::VectorXd::Ones(3);
+  std::vector<double> lp = {1, -1, 1, -1, 1, -1, 1, -1};
+
+  monitor.end_window(metric, 0.0, lp);
+  metric(0) = 1.01;
+  EXPECT_TRUE(monitor.end_window(metric, 0.01, lp));
+  EXPECT_NEAR(0.01 / std::sqrt(3.0), monitor.metric_change(), 1e-12);
+  EXPECT_NEAR(0.01, monitor.stepsize_change(), 1e-12);
+  EXPECT_LT(monitor.lp_rhat(), 1.05);
+
+  monitor.restart();
+  EXPECT_EQ(0, monitor.num_windows());
+  EXPECT_FALSE(monitor.converged());
+}
+
+TEST(McmcWarmupConvergenceMonitor, each_criterion_blocks) {
+  std::vector<double> stationary = {1, -1, 1, -1, 1, -1, 1, -1};
+  std::vector<double> drifting = {-10, -9, -8, -7, -3, -2, -1, 0};
+  Eigen::MatrixXd metric = Eigen::MatrixXd::Identity(2, 2);
+
+  stan::mcmc::warmup_convergence_monitor monitor;
+  monitor.end_window(metric, 0.0, stationary);
+  EXPECT_FALSE(monitor.end_window(Eigen::MatrixXd(2 * metric), 0.0,
+                                  stationary));
+
+  monitor.restart();
+  monitor.end_window(metric, 0.0, stationary);
+  EXPECT_FALSE(monitor.end_window(metric, 0.5, stationary));
+
+  monitor.restart();
+  monitor.end_window(metric, 0.0, stationary);
+  EXPECT_FALSE(monitor.end_window(metric, 0.0, drifting));
+  EXPECT_GT(monitor.lp_rhat(), 1.05);
+}
@@ -0,0 +1,36 @@
+#include <stan/model/double_arena.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(ModelUtil, double_arena_scope_reuses_memory) {
+  stan::model::double_arena_scope outer;
+  double* first = nullptr;
+  for (int n = 0; n < 100; ++n) {
+    stan::model::double_arena_scope scope;
+    double* x = stan::model::double_arena_alloc<double>(1000);
+    for (int i = 0; i < 1000; ++i)
+      x[i] = i;
+    if (n == 0)
+      first = x;
+    // each evaluation gets the memory released by the previous one
+    EXPECT_EQ(first, x);
+    EXPECT_TRUE(stan::model::double_arena().in_stack(x));
+  }
+  size_t bytes = stan::model::double_arena().bytes_allocated();
+  {
+    stan::model::double_arena_scope scope;
+    stan::model::double_arena_alloc<double>(1000);
+  }
+  EXPECT_EQ(bytes, stan::model::double_arena().bytes_allocated());
+}
+
+TEST(ModelUtil, double_arena_per_thread) {
+  stan::math::stack_alloc* main_arena = &stan::model::double_arena();
+  stan::math::stack_alloc* other_arena = nullptr;
+  std::thread other([&]() {
+    stan::model::double_arena_scope scope;
+    other_arena = &stan::model::double_arena();
+  });
+  other.join();
+  EXPECT_NE(main_arena, other_arena);
+}
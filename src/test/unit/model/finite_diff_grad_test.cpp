@@ -4,7 +4,32 @@
 #include <test/test-models/good/model/valid.hpp>
 #include <test/unit/util.hpp>
 #include <stan/callbacks/interrupt.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
 #include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+namespace test {
+// Quadratic log density writing the index of the largest parameter to
+// the message stream
+class quadratic_model {
+ public:
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    T__ lp = 0;
+    size_t largest = 0;
+    for (size_t k = 0; k < params_r__.size(); ++k) {
+      lp -= (k + 1) * params_r__[k] * params_r__[k];
+      if (params_r__[k] > params_r__[largest])
+        largest = k;
+    }
+    if (pstream__)
+      *pstream__ << largest << ";";
+    return lp;
+  }
+};
+}  // namespace test
 
 TEST(ModelUtil, finite_diff_grad__false_false) {
   TestModel_uniform_01 model;
@@ -127,3 +152,32 @@ TEST(ModelUtil, streams) {
   EXPECT_EQ("", stan::test::cout_ss.str());
   EXPECT_EQ("", stan::test::cerr_ss.str());
 }
+
+TEST(ModelUtil, finite_diff_grad_parallel) {
+  test::quadratic_model model;
+  std::vector<double> params_r(50);
+  for (size_t k = 0; k < params_r.size(); ++k)
+    params_r[k] = 0.1 * k - 2;
+  std::vector<int> params_i(0);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  std::stringstream serial_msgs;
+  std::vector<double> serial_gradient;
+  stan::model::finite_diff_grad<false, true>(model, interrupt, params_r,
+                                             params_i, serial_gradient, 1e-6,
+                                             &serial_msgs);
+  EXPECT_EQ(50, interrupt.call_count());
+
+  for (size_t grainsize : {1, 7, 64}) {
+    std::stringstream msgs;
+    std::vector<double> gradient;
+    stan::model::finite_diff_grad_parallel<false, true>(
+        model, interrupt, params_r, params_i, gradient, 1e-6, &msgs,
+        grainsize);
+    EXPECT_EQ(serial_gradient, gradient) << grainsize;
+    EXPECT_EQ(serial_msgs.str(), msgs.str()) << grainsize;
+    for (size_t k = 0; k < params_r.size(); ++k)
+      EXPECT_NEAR(-2.0 * (k + 1) * params_r[k], gradient[k], 1e-4);
+  }
+  EXPECT_GT(interrupt.call_count(), 50);
+}
@@ -31,3 +31,29 @@ TEST(ModelUtil, gradient_dot_vector) {
   //             std::domain_error);
   // EXPECT_EQ("", output.str());
 }
+
+TEST(ModelUtil, gradient_dot_vector_directions) {
+  stan::io::empty_var_context data_var_context;
+  std::stringstream output;
+  valid_model_namespace::valid_model valid_model(data_var_context, 0, &output);
+
+  Eigen::VectorXd x(1);
+  x << 1.5;
+  Eigen::MatrixXd v(1, 3);
+  v << 1, -2, 0.5;
+  double f;
+  Eigen::VectorXd grad_f_dot_v;
+  stan::model::gradient_dot_vector(valid_model, x, v, f, grad_f_dot_v);
+  EXPECT_FLOAT_EQ(-1.125, f);
+  ASSERT_EQ(3, grad_f_dot_v.size());
+  for (Eigen::Index k = 0; k < v.cols(); ++k) {
+    double single;
+    double single_f;
+    stan::model::gradient_dot_vector(valid_model, x, Eigen::VectorXd(v.col(k)),
+                                     single_f, single);
+    EXPECT_FLOAT_EQ(single_f, f);
+    EXPECT_FLOAT_EQ(single, grad_f_dot_v(k));
+    EXPECT_FLOAT_EQ(-1.5 * v(0, k), grad_f_dot_v(k));
+  }
+  EXPECT_EQ("", output.str());
+}
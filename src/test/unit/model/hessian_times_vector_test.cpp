@@ -32,3 +32,36 @@ TEST(ModelUtil, hessian_times_vector) {
   //             std::domain_error);
   // EXPECT_EQ("", output.str());
 }
+
+TEST(ModelUtil, hessian_times_vector_directions) {
+  stan::io::empty_var_context data_var_context;
+  std::stringstream output;
+  valid_model_namespace::valid_model valid_model(data_var_context, 0, &output);
+
+  Eigen::VectorXd x(1);
+  x << 1.5;
+  Eigen::MatrixXd v(1, 3);
+  v << 1, -2, 0.5;
+  double f;
+  Eigen::MatrixXd hess_f_dot_v;
+  stan::model::hessian_times_vector(valid_model, x, v, f, hess_f_dot_v);
+  EXPECT_FLOAT_EQ(-1.125, f);
+  ASSERT_EQ(1, hess_f_dot_v.rows());
+  ASSERT_EQ(3, hess_f_dot_v.cols());
+  for (Eigen::Index k = 0; k < v.cols(); ++k) {
+    Eigen::VectorXd single;
+    double single_f;
+    stan::model::hessian_times_vector(valid_model, x,
+                                      Eigen::VectorXd(v.col(k)), single_f,
+                                      single);
+    EXPECT_FLOAT_EQ(single_f, f);
+    EXPECT_FLOAT_EQ(single(0), hess_f_dot_v(0, k));
+    EXPECT_FLOAT_EQ(-v(0, k), hess_f_dot_v(0, k));
+  }
+
+  Eigen::MatrixXd none(1, 0);
+  stan::model::hessian_times_vector(valid_model, x, none, f, hess_f_dot_v);
+  EXPECT_FLOAT_EQ(-1.125, f);
+  EXPECT_EQ(0, hess_f_dot_v.cols());
+  EXPECT_EQ("", output.str());
+}
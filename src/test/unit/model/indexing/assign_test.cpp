@@ -1,4 +1,5 @@
 #include <stan/model/indexing.hpp>
+#include <test/unit/util.hpp>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <stdexcept>
@@ -396,6 +397,57 @@ TEST(ModelIndexing, lvalueVecMulti) {
   test_throw_ia(xs, ys, index_multi(ns));
 }
 
+TEST(ModelIndexing, lvalueVecMultiRange) {
+  VectorXd xs(6);
+  xs << 0, 1, 2, 3, 4, 5;
+  VectorXd ys(3);
+  ys << 10, 11, 12;
+  assign(xs, ys, "", index_multi(vector<int>{2, 3, 4}));
+  VectorXd expected(6);
+  expected << 0, 10, 11, 12, 4, 5;
+  EXPECT_MATRIX_EQ(expected, xs);
+
+  assign(xs, ys, "", index_multi(vector<int>{1, 3, 5}));
+  expected << 10, 10, 11, 12, 12, 5;
+  EXPECT_MATRIX_EQ(expected, xs);
+
+  test_throw(xs, ys, index_multi(vector<int>{0, 1, 2}));
+  test_throw(xs, ys, index_multi(vector<int>{5, 6, 7}));
+  test_throw(xs, ys, index_multi(vector<int>{2, 5, 8}));
+  test_throw_ia(xs, ys, index_multi(vector<int>{1, 2}));
+}
+
+TEST(ModelIndexing, lvalueMatrixMultiRange) {
+  MatrixXd x = MatrixXd::Zero(5, 2);
+  MatrixXd y(2, 2);
+  y << 1, 2, 3, 4;
+  assign(x, y, "", index_multi(vector<int>{3, 4}));
+  EXPECT_MATRIX_EQ(y, x.middleRows(2, 2));
+  EXPECT_MATRIX_EQ(MatrixXd::Zero(2, 2), x.topRows(2));
+  EXPECT_MATRIX_EQ(MatrixXd::Zero(1, 2), x.bottomRows(1));
+
+  x.setZero();
+  assign(x, y, "", index_multi(vector<int>{1, 5}));
+  EXPECT_MATRIX_EQ(y.row(0), x.row(0));
+  EXPECT_MATRIX_EQ(y.row(1), x.row(4));
+  EXPECT_MATRIX_EQ(MatrixXd::Zero(3, 2), x.middleRows(1, 3));
+  test_throw(x, y, index_multi(vector<int>{5, 6}));
+
+  x.setZero();
+  assign(x, y, "", index_multi(vector<int>{2, 3}),
+         index_multi(vector<int>{1, 2}));
+  EXPECT_MATRIX_EQ(y, x.block(1, 0, 2, 2));
+  EXPECT_FLOAT_EQ(0, x.row(0).sum() + x.bottomRows(2).sum());
+  test_throw(x, y, index_multi(vector<int>{2, 3}),
+             index_multi(vector<int>{2, 3}));
+
+  x.setZero();
+  RowVectorXd r(2);
+  r << 7, 8;
+  assign(x, r, "", index_uni(4), index_multi(vector<int>{1, 2}));
+  EXPECT_MATRIX_EQ(r, x.row(3));
+}
+
 TEST(ModelIndexing, lvalueRowVecMulti) {
   RowVectorXd xs(5);
   xs << 0, 1, 2, 3, 4;
@@ -647,6 +699,14 @@ TEST(ModelIndexing, lvalueMatrixMultiMulti) {
 
   ns[ns.size() - 1] = 10;
   test_throw(x, y, index_multi(ms), index_multi(ns));
+
+  // Indexes are all checked before anything is assigned
+  MatrixXd x_copy = x;
+  ms[ms.size() - 1] = 10;
+  ns[ns.size() - 1] = 1;
+  test_throw(x, MatrixXd::Zero(2, 3), index_multi(ms), index_multi(ns));
+  test_throw(x, MatrixXd::Zero(2, 4), index_multi(ms));
+  EXPECT_EQ(x_copy, x);
 }
 TEST(ModelIndexing, doubleToVar) {
   using Eigen::Dynamic;
@@ -187,6 +187,74 @@ void test_multi_alias_vec() {
 
 TEST_F(VarAssign, multi_alias_vec) { test_multi_alias_vec<Eigen::VectorXd>(); }
 
+template <typename Vec, typename RhsScalar>
+void test_multi_range_vec() {
+  using stan::model::test::conditionally_generate_linear_var_vector;
+  auto x = conditionally_generate_linear_var_vector<Vec>(5);
+  Vec x_val = x.val();
+  auto y = conditionally_generate_linear_var_vector<Vec, RhsScalar>(3, 10);
+  assign(x, y, "", index_multi(vector<int>{2, 3, 4}));
+  EXPECT_MATRIX_EQ(x.val().segment(1, 3), stan::math::value_of(y));
+  EXPECT_FLOAT_EQ(x_val[0], x.val()[0]);
+  EXPECT_FLOAT_EQ(x_val[4], x.val()[4]);
+  stan::math::sum(x).grad();
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+  Vec exp_adj(5);
+  exp_adj << 1, 0, 0, 0, 1;
+  EXPECT_MATRIX_EQ(x.adj(), exp_adj);
+  if (stan::is_var<RhsScalar>::value) {
+    EXPECT_MATRIX_EQ(stan::math::adjoint_of(y), Vec::Ones(3));
+  }
+  test_throw_out_of_range(x, y, index_multi(vector<int>{4, 5, 6}));
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+}
+
+TEST_F(VarAssign, multi_range_vec) {
+  test_multi_range_vec<Eigen::VectorXd, stan::math::var>();
+  test_multi_range_vec<Eigen::VectorXd, double>();
+  test_multi_range_vec<Eigen::RowVectorXd, stan::math::var>();
+}
+
+TEST_F(VarAssign, multi_range_alias_vec) {
+  using stan::model::test::conditionally_generate_linear_var_vector;
+  auto x = conditionally_generate_linear_var_vector<Eigen::VectorXd>(5, 1);
+  Eigen::VectorXd x_val = x.val();
+  assign(x, x.segment(0, 4), "", index_multi(vector<int>{2, 3, 4, 5}));
+  EXPECT_FLOAT_EQ(x_val[0], x.val()[0]);
+  EXPECT_MATRIX_EQ(x.val().segment(1, 4), x_val.segment(0, 4));
+  stan::math::sum(x).grad();
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+  Eigen::VectorXd exp_adj(5);
+  exp_adj << 2, 1, 1, 1, 0;
+  EXPECT_MATRIX_EQ(x.adj(), exp_adj);
+}
+
+TEST_F(VarAssign, multi_vec_sparse) {
+  using stan::model::test::conditionally_generate_linear_var_vector;
+  // Few indexes into a long vector
+  auto x = conditionally_generate_linear_var_vector<Eigen::VectorXd>(1000);
+  Eigen::VectorXd x_val = x.val();
+  auto y = conditionally_generate_linear_var_vector<Eigen::VectorXd>(3, 10);
+  vector<int> ns{900, 3, 900};
+  assign(x, y, "", index_multi(ns));
+  EXPECT_FLOAT_EQ(y.val()[2], x.val()[899]);
+  EXPECT_FLOAT_EQ(y.val()[1], x.val()[2]);
+  EXPECT_FLOAT_EQ(x_val[0], x.val()[0]);
+  stan::math::sum(x).grad();
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+  EXPECT_FLOAT_EQ(0, x.adj()[899]);
+  EXPECT_FLOAT_EQ(0, x.adj()[2]);
+  EXPECT_FLOAT_EQ(1, x.adj()[0]);
+  Eigen::VectorXd exp_adj(3);
+  exp_adj << 0, 1, 1;
+  EXPECT_MATRIX_EQ(y.adj(), exp_adj);
+
+  // Indexes are all checked before anything is assigned
+  ns[2] = 1001;
+  test_throw_out_of_range(x, y, index_multi(ns));
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+}
+
 template <typename Vec, typename RhsScalar>
 void test_omni_vec() {
   using stan::math::sum;
@@ -674,6 +742,23 @@ TEST_F(VarAssign, multi_matrix) {
   multi_mat_test<double>();
 }
 
+TEST_F(VarAssign, multi_range_matrix) {
+  using stan::model::test::conditionally_generate_linear_var_matrix;
+  auto x = conditionally_generate_linear_var_matrix(5, 3);
+  Eigen::MatrixXd x_val = x.val();
+  auto y = conditionally_generate_linear_var_matrix(2, 3, 10);
+  assign(x, y, "", index_multi(vector<int>{3, 4}));
+  EXPECT_MATRIX_EQ(x.val().middleRows(2, 2), y.val());
+  EXPECT_MATRIX_EQ(x.val().topRows(2), x_val.topRows(2));
+  stan::math::sum(x).grad();
+  EXPECT_MATRIX_EQ(x.val(), x_val);
+  Eigen::MatrixXd exp_adj = Eigen::MatrixXd::Ones(5, 3);
+  exp_adj.middleRows(2, 2).setZero();
+  EXPECT_MATRIX_EQ(x.adj(), exp_adj);
+  EXPECT_MATRIX_EQ(y.adj(), Eigen::MatrixXd::Ones(2, 3));
+  test_throw_out_of_range(x, y, index_multi(vector<int>{5, 6}));
+}
+
 TEST_F(VarAssign, multi_alias_matrix) {
   using stan::math::sum;
   using stan::math::var_value;
@@ -99,3 +99,46 @@ TEST(modelIndexingDeepCopy, stdVectorStdVectorDouble) {
   EXPECT_FLOAT_EQ(20, ac[1][1]);
   EXPECT_FLOAT_EQ(11, a[1][1]);
 }
+
+TEST(modelIndexingDeepCopy, assignElementWithoutOverlap) {
+  using stan::model::assign;
+  using stan::model::deep_copy;
+  using stan::model::index_uni;
+  std::vector<Eigen::VectorXd> mu(3, Eigen::VectorXd::Zero(2));
+  mu[0] << 1, 2;
+  EXPECT_FALSE(stan::model::internal::assign_may_alias(mu, mu[0],
+                                                       index_uni(2)));
+  assign(mu, deep_copy(mu[0]), "mu", index_uni(2));
+  EXPECT_FLOAT_EQ(1, mu[1](0));
+  EXPECT_FLOAT_EQ(2, mu[1](1));
+
+  std::vector<std::vector<double>> a(2, std::vector<double>{1, 2});
+  a[1][0] = 3;
+  assign(a, deep_copy(a[1]), "a", index_uni(1));
+  EXPECT_FLOAT_EQ(3, a[0][0]);
+  EXPECT_FLOAT_EQ(2, a[0][1]);
+
+  std::vector<std::vector<Eigen::VectorXd>> nested(2, mu);
+  nested[1][0] << 5, 6;
+  assign(nested, deep_copy(nested[1]), "nested", index_uni(1));
+  EXPECT_FLOAT_EQ(5, nested[0][0](0));
+  EXPECT_FLOAT_EQ(6, nested[0][0](1));
+}
+
+TEST(modelIndexingDeepCopy, assignOverlapCopies) {
+  using stan::model::assign;
+  using stan::model::deep_copy;
+  using stan::model::index_multi;
+  using stan::model::index_uni;
+  Eigen::VectorXd v(3);
+  v << 1, 2, 3;
+  EXPECT_TRUE(stan::model::internal::assign_may_alias(
+      v, v, index_multi(std::vector<int>{3, 2, 1})));
+  assign(v, deep_copy(v), "v", index_multi(std::vector<int>{3, 2, 1}));
+  EXPECT_FLOAT_EQ(3, v(0));
+  EXPECT_FLOAT_EQ(2, v(1));
+  EXPECT_FLOAT_EQ(1, v(2));
+
+  std::vector<Eigen::VectorXd> mu(2, Eigen::VectorXd::Ones(2));
+  EXPECT_TRUE(stan::model::internal::assign_may_alias(mu, mu, index_uni(1)));
+}
@@ -1,6 +1,7 @@
 #include <stan/model/indexing.hpp>
 #include <gtest/gtest.h>
 #include <boost/type_traits/is_same.hpp>
+#include <type_traits>
 #include <vector>
 
 using stan::model::index_max;
@@ -26,6 +27,26 @@ TEST(MathIndexingIndex, index_multi) {
     EXPECT_EQ(ns[i], idx.ns_[i]);
 }
 
+TEST(MathIndexingIndex, index_multi_stride) {
+  EXPECT_EQ(0, index_multi(std::vector<int>{}).stride_);
+  EXPECT_EQ(1, index_multi(std::vector<int>{7}).stride_);
+  EXPECT_TRUE(index_multi(std::vector<int>{7}).is_contiguous());
+  EXPECT_EQ(1, index_multi(std::vector<int>{2, 3, 4, 5}).stride_);
+  EXPECT_TRUE(index_multi(std::vector<int>{2, 3, 4, 5}).is_contiguous());
+  EXPECT_EQ(3, index_multi(std::vector<int>{1, 4, 7}).stride_);
+  EXPECT_FALSE(index_multi(std::vector<int>{1, 4, 7}).is_contiguous());
+  EXPECT_EQ(0, index_multi(std::vector<int>{1, 2, 4}).stride_);
+  EXPECT_EQ(0, index_multi(std::vector<int>{3, 2, 1}).stride_);
+  EXPECT_EQ(0, index_multi(std::vector<int>{2, 2, 2}).stride_);
+  EXPECT_EQ(0, index_multi(std::vector<int>{-2147483647, 2147483647}).stride_);
+
+  // The indexes cannot be changed after the stride is found
+  index_multi idx(std::vector<int>{1, 2, 3});
+  EXPECT_FALSE(
+      (std::is_assignable<decltype((idx.ns_)), std::vector<int>>::value));
+  EXPECT_FALSE((std::is_assignable<decltype((idx.ns_[0])), int>::value));
+}
+
 TEST(MathIndexingIndex, index_omni) {
   index_omni idx;
   (void)idx;  // just to silence compiler griping about idx being unused
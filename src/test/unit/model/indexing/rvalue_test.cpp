@@ -1038,3 +1038,87 @@ TEST(ModelIndexing, rvalueMatrixMultiMulti) {
     }
   }
 }
+
+TEST(ModelIndexing, rvalueMultiViews) {
+  Eigen::MatrixXd x(3, 4);
+  x << 0.0, 0.1, 0.2, 0.3, 1.0, 1.1, 1.2, 1.3, 2.0, 2.1, 2.2, 2.3;
+  Eigen::VectorXd v = x.col(1);
+
+  // Multiple indexes return views of the indexed values, which hold a
+  // copy of the indexes, so temporary indexes may go out of scope
+  auto v_view = rvalue(v, "", index_multi(std::vector<int>{3, 1, 3}));
+  auto x_rows = rvalue(x, "", index_multi(std::vector<int>{3, 1, 3}));
+  auto x_row = rvalue(x, "", index_uni(2),
+                      index_multi(std::vector<int>{4, 2}));
+  auto x_col = rvalue(x, "", index_multi(std::vector<int>{3, 1, 3}),
+                      index_uni(2));
+  auto x_both = rvalue(x, "", index_multi(std::vector<int>{3, 1, 3}),
+                       index_multi(std::vector<int>{4, 2}));
+  x(2, 1) = 5;
+  v(2) = 5;
+  Eigen::VectorXd v_expected(3);
+  v_expected << 5, 0.1, 5;
+  EXPECT_EQ(v_expected, Eigen::VectorXd(v_view));
+  Eigen::MatrixXd rows_expected(3, 4);
+  rows_expected << 2.0, 5, 2.2, 2.3, 0.0, 0.1, 0.2, 0.3, 2.0, 5, 2.2, 2.3;
+  EXPECT_EQ(rows_expected, Eigen::MatrixXd(x_rows));
+  Eigen::RowVectorXd row_expected(2);
+  row_expected << 1.3, 1.1;
+  EXPECT_EQ(row_expected, Eigen::RowVectorXd(x_row));
+  EXPECT_EQ(v_expected, Eigen::VectorXd(x_col));
+  Eigen::MatrixXd both_expected(3, 2);
+  both_expected << 2.3, 5, 0.3, 0.1, 2.3, 5;
+  EXPECT_EQ(both_expected, Eigen::MatrixXd(x_both));
+
+  // Nested multiple indexes
+  index_multi rows(std::vector<int>{3, 1, 3});
+  index_multi cols(std::vector<int>{4, 2});
+  index_multi nested(std::vector<int>{2, 3});
+  Eigen::MatrixXd y = rvalue(rvalue(x, "", rows, cols), "", nested);
+  Eigen::MatrixXd expected(2, 2);
+  expected << 0.3, 0.1, 2.3, 5;
+  EXPECT_EQ(expected, y);
+
+  // Indexes are checked when indexing, not when the view is used
+  index_multi bad(std::vector<int>{1, 4});
+  EXPECT_THROW(rvalue(v, "", bad), std::out_of_range);
+  EXPECT_THROW(rvalue(x, "", bad), std::out_of_range);
+  EXPECT_THROW(rvalue(x, "", bad, index_uni(1)), std::out_of_range);
+  EXPECT_THROW(rvalue(x, "", rows, bad), std::out_of_range);
+}
+
+TEST(ModelIndexing, rvalueMultiSelfAssign) {
+  using stan::model::assign;
+  using stan::model::deep_copy;
+  // Views assigned back to the indexed value go through deep_copy(), as
+  // in generated code, which reads every value before any is overwritten
+  Eigen::VectorXd v(3);
+  v << 1, 2, 3;
+  assign(v, deep_copy(rvalue(v, "", index_multi(std::vector<int>{3, 2, 1}))),
+         "");
+  Eigen::VectorXd v_expected(3);
+  v_expected << 3, 2, 1;
+  EXPECT_EQ(v_expected, v);
+
+  Eigen::MatrixXd m(2, 2);
+  m << 1, 2, 3, 4;
+  index_multi swap(std::vector<int>{2, 1});
+  assign(m, deep_copy(rvalue(m, "", swap)), "");
+  Eigen::MatrixXd m_expected(2, 2);
+  m_expected << 3, 4, 1, 2;
+  EXPECT_EQ(m_expected, m);
+
+  assign(m, deep_copy(rvalue(m, "", swap, swap)), "");
+  m_expected << 2, 1, 4, 3;
+  EXPECT_EQ(m_expected, m);
+
+  assign(m, deep_copy(rvalue(m, "", swap, index_uni(1))), "", index_omni(),
+         index_uni(1));
+  m_expected << 4, 1, 2, 3;
+  EXPECT_EQ(m_expected, m);
+
+  assign(m, deep_copy(rvalue(m, "", index_uni(1), swap)), "", index_uni(1),
+         index_omni());
+  m_expected << 1, 4, 2, 3;
+  EXPECT_EQ(m_expected, m);
+}
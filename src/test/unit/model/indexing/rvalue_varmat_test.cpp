@@ -112,6 +112,46 @@ TEST_F(RvalueRev, multi_vec) { test_multi_varvector<Eigen::VectorXd>(); }
 
 TEST_F(RvalueRev, multi_rowvec) { test_multi_varvector<Eigen::RowVectorXd>(); }
 
+template <typename T>
+void test_multi_range_varvector() {
+  using stan::math::var_value;
+  T v(5);
+  v << 0, 1, 2, 3, 4;
+  var_value<T> rv(v);
+  var_value<T> vi = rvalue(rv, "", index_multi(std::vector<int>{2, 3, 4}));
+  EXPECT_MATRIX_EQ(v.segment(1, 3), vi.val());
+  test_throw_out_of_range(rv, index_multi(std::vector<int>{4, 5, 6}));
+  stan::math::sum(vi).grad();
+  T exp_adj(5);
+  exp_adj << 0, 1, 1, 1, 0;
+  EXPECT_MATRIX_EQ(exp_adj, rv.adj());
+}
+
+TEST_F(RvalueRev, multi_range_vec) {
+  test_multi_range_varvector<Eigen::VectorXd>();
+}
+
+TEST_F(RvalueRev, multi_range_rowvec) {
+  test_multi_range_varvector<Eigen::RowVectorXd>();
+}
+
+TEST_F(RvalueRev, multi_sorted_vec) {
+  using stan::math::var_value;
+  Eigen::VectorXd v(5);
+  v << 0, 1, 2, 3, 4;
+  var_value<Eigen::VectorXd> rv(v);
+  std::vector<int> ns{1, 1, 2, 4, 4, 4};
+  var_value<Eigen::VectorXd> vi = rvalue(rv, "", index_multi(ns));
+  Eigen::VectorXd expected(6);
+  expected << 0, 0, 1, 3, 3, 3;
+  EXPECT_MATRIX_EQ(expected, vi.val());
+  stan::math::sum(vi).grad();
+  // counts are how many times they were accessed
+  Eigen::VectorXd exp_adj(5);
+  exp_adj << 2, 1, 0, 3, 0;
+  EXPECT_MATRIX_EQ(exp_adj, rv.adj());
+}
+
 // omni
 template <typename T>
 void test_omni_varvector() {
@@ -604,6 +644,39 @@ TEST_F(RvalueRev, multi_mat) {
   test_throw_out_of_range(x, index_multi(row_idx));
 }
 
+TEST_F(RvalueRev, multi_range_mat) {
+  using stan::math::var_value;
+  using stan::model::test::conditionally_generate_linear_var_matrix;
+
+  auto x = conditionally_generate_linear_var_matrix(5, 3);
+  var_value<Eigen::MatrixXd> y
+      = rvalue(x, "", index_multi(std::vector<int>{2, 3, 4}));
+  EXPECT_MATRIX_EQ(x.val().middleRows(1, 3), y.val());
+  sum(y).grad();
+  Eigen::MatrixXd exp_adj = Eigen::MatrixXd::Zero(5, 3);
+  exp_adj.middleRows(1, 3).setOnes();
+  EXPECT_MATRIX_EQ(exp_adj, x.adj());
+  test_throw_out_of_range(x, index_multi(std::vector<int>{4, 5, 6}));
+}
+
+TEST_F(RvalueRev, multi_sorted_mat) {
+  using stan::math::var_value;
+  using stan::model::test::conditionally_generate_linear_var_matrix;
+
+  auto x = conditionally_generate_linear_var_matrix(5, 3);
+  std::vector<int> row_idx{1, 3, 3, 5};
+  var_value<Eigen::MatrixXd> y = rvalue(x, "", index_multi(row_idx));
+  for (int i = 0; i < row_idx.size(); ++i) {
+    EXPECT_MATRIX_EQ(x.val().row(row_idx[i] - 1), y.val().row(i));
+  }
+  sum(y).grad();
+  Eigen::MatrixXd exp_adj = Eigen::MatrixXd::Zero(5, 3);
+  exp_adj.row(0).setOnes();
+  exp_adj.row(2).setConstant(2);
+  exp_adj.row(4).setOnes();
+  EXPECT_MATRIX_EQ(exp_adj, x.adj());
+}
+
 TEST_F(RvalueRev, uni_multi_matrix) {
   using stan::math::sum;
   using stan::math::var_value;
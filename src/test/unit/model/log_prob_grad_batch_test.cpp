@@ -0,0 +1,89 @@
+#include <stan/model/log_prob_grad_batch.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+
+namespace {
+
+// Standard normal log density, evaluated one point at a time
+class normal_model : public stan::model::prob_grad {
+ public:
+  explicit normal_model(size_t n) : stan::model::prob_grad(n) {}
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = 0) const {
+    T lp = 0;
+    for (int i = 0; i < params_r.size(); ++i)
+      lp -= 0.5 * params_r(i) * params_r(i);
+    return lp;
+  }
+};
+
+// Standard normal log density with its own batched gradient
+class batched_normal_model : public normal_model {
+ public:
+  explicit batched_normal_model(size_t n) : normal_model(n) {}
+
+  template <bool propto, bool jacobian>
+  void log_prob_grad_batch(const Eigen::MatrixXd& params_r,
+                           Eigen::VectorXd& log_prob,
+                           Eigen::MatrixXd& gradient,
+                           std::ostream* msgs = 0) const {
+    ++num_calls;
+    log_prob = -0.5 * params_r.colwise().squaredNorm().transpose();
+    gradient = -params_r;
+  }
+
+  mutable int num_calls = 0;
+};
+
+}  // namespace
+
+TEST(ModelUtil, log_prob_grad_batch_detects_member) {
+  EXPECT_FALSE(stan::model::internal::has_log_prob_grad_batch<
+               normal_model>::value);
+  EXPECT_TRUE(stan::model::internal::has_log_prob_grad_batch<
+              batched_normal_model>::value);
+}
+
+TEST(ModelUtil, log_prob_grad_batch_fallback_loop) {
+  normal_model model(2);
+  Eigen::MatrixXd params_r(2, 3);
+  params_r << 0, 1, -2, 0.5, 3, 1;
+
+  Eigen::VectorXd log_prob;
+  Eigen::MatrixXd gradient;
+  stan::model::log_prob_grad_batch<true, true>(model, params_r, log_prob,
+                                              gradient);
+
+  ASSERT_EQ(3, log_prob.size());
+  ASSERT_EQ(2, gradient.rows());
+  ASSERT_EQ(3, gradient.cols());
+  for (int k = 0; k < 3; ++k) {
+    Eigen::VectorXd theta = params_r.col(k);
+    Eigen::VectorXd grad;
+    double lp = stan::model::log_prob_grad<true, true>(model, theta, grad);
+    EXPECT_FLOAT_EQ(lp, log_prob(k));
+    for (int i = 0; i < 2; ++i)
+      EXPECT_FLOAT_EQ(grad(i), gradient(i, k));
+  }
+}
+
+TEST(ModelUtil, log_prob_grad_batch_dispatches_to_member) {
+  batched_normal_model model(2);
+  Eigen::MatrixXd params_r(2, 3);
+  params_r << 0, 1, -2, 0.5, 3, 1;
+
+  Eigen::VectorXd log_prob;
+  Eigen::MatrixXd gradient;
+  stan::model::log_prob_grad_batch<true, true>(model, params_r, log_prob,
+                                              gradient);
+
+  EXPECT_EQ(1, model.num_calls);
+  EXPECT_FLOAT_EQ(-0.125, log_prob(0));
+  EXPECT_FLOAT_EQ(-5, log_prob(1));
+  EXPECT_FLOAT_EQ(-2.5, log_prob(2));
+  EXPECT_FLOAT_EQ(2, gradient(0, 2));
+  EXPECT_FLOAT_EQ(-3, gradient(1, 1));
+}
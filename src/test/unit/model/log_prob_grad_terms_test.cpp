@@ -0,0 +1,103 @@
+#include <stan/model/log_prob_grad_terms.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Independent normal groups sharing a scale parameter
+class grouped_normal_model : public stan::model::prob_grad {
+ public:
+  explicit grouped_normal_model(size_t num_groups)
+      : stan::model::prob_grad(num_groups + 1), num_groups_(num_groups) {}
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = 0) const {
+    T lp = 0;
+    for (size_t k = 0; k < num_groups_; ++k)
+      lp += log_prob_group(k, params_r);
+    return lp;
+  }
+
+ protected:
+  size_t num_groups_;
+
+  template <typename T>
+  T log_prob_group(size_t k, Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r)
+      const {
+    using std::exp;
+    T log_sigma = params_r(num_groups_);
+    T z = (params_r(k) - static_cast<double>(k)) / exp(log_sigma);
+    return -0.5 * z * z - log_sigma;
+  }
+};
+
+// The same model exposing one term per group
+class grouped_normal_terms_model : public grouped_normal_model {
+ public:
+  explicit grouped_normal_terms_model(size_t num_groups)
+      : grouped_normal_model(num_groups) {}
+
+  size_t num_log_prob_terms() const { return num_groups_; }
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob_term(size_t k, Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+                  std::ostream* msgs = 0) const {
+    if (params_r(k) > 100)
+      throw std::domain_error("term out of support");
+    if (msgs && k == 1)
+      *msgs << "term 1";
+    return log_prob_group(k, params_r);
+  }
+};
+
+}  // namespace
+
+TEST(ModelUtil, log_prob_grad_terms_detects_members) {
+  EXPECT_FALSE(stan::model::internal::has_log_prob_terms<
+               grouped_normal_model>::value);
+  EXPECT_TRUE(stan::model::internal::has_log_prob_terms<
+              grouped_normal_terms_model>::value);
+}
+
+TEST(ModelUtil, log_prob_grad_terms_matches_log_prob_grad) {
+  const size_t num_groups = 17;
+  grouped_normal_model model(num_groups);
+  grouped_normal_terms_model terms_model(num_groups);
+  Eigen::VectorXd params_r(num_groups + 1);
+  for (size_t k = 0; k <= num_groups; ++k)
+    params_r(k) = 0.25 * k - 1;
+
+  Eigen::VectorXd expected_gradient;
+  double expected_lp = stan::model::log_prob_grad<true, true>(
+      model, params_r, expected_gradient);
+
+  Eigen::VectorXd fallback_gradient;
+  double fallback_lp = stan::model::log_prob_grad_terms<true, true>(
+      model, params_r, fallback_gradient);
+  EXPECT_FLOAT_EQ(expected_lp, fallback_lp);
+
+  std::stringstream msgs;
+  Eigen::VectorXd gradient;
+  double lp = stan::model::log_prob_grad_terms<true, true>(
+      terms_model, params_r, gradient, &msgs);
+  EXPECT_FLOAT_EQ(expected_lp, lp);
+  ASSERT_EQ(expected_gradient.size(), gradient.size());
+  for (int i = 0; i < gradient.size(); ++i) {
+    EXPECT_FLOAT_EQ(expected_gradient(i), fallback_gradient(i));
+    EXPECT_FLOAT_EQ(expected_gradient(i), gradient(i));
+  }
+  EXPECT_EQ("term 1", msgs.str());
+}
+
+TEST(ModelUtil, log_prob_grad_terms_throws) {
+  grouped_normal_terms_model model(4);
+  Eigen::VectorXd params_r = Eigen::VectorXd::Zero(5);
+  params_r(2) = 1000;
+  Eigen::VectorXd gradient;
+  EXPECT_THROW(
+      stan::model::log_prob_grad_terms<true, true>(model, params_r, gradient),
+      std::domain_error);
+}
@@ -0,0 +1,154 @@
+#include <stan/model/minibatch_model.hpp>
+#include <stan/model/gradient.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Normal observations with unknown location and a normal prior on it
+class normal_model : public stan::model::prob_grad {
+ public:
+  explicit normal_model(size_t num_rows) : stan::model::prob_grad(1) {
+    for (size_t n = 0; n < num_rows; ++n)
+      y_.push_back(0.1 * n - 2);
+  }
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = 0) const {
+    T lp = log_prior_impl(params_r);
+    for (size_t n = 0; n < y_.size(); ++n)
+      lp += log_likelihood_row(n, params_r);
+    return lp;
+  }
+
+ protected:
+  std::vector<double> y_;
+
+  template <typename T>
+  T log_prior_impl(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r) const {
+    return -0.005 * params_r(0) * params_r(0);
+  }
+
+  template <typename T>
+  T log_likelihood_row(size_t n,
+                       Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r) const {
+    T z = y_[n] - params_r(0);
+    return -0.5 * z * z;
+  }
+};
+
+// The same model declaring its rows of data
+class normal_rows_model : public normal_model {
+ public:
+  explicit normal_rows_model(size_t num_rows) : normal_model(num_rows) {}
+
+  size_t num_minibatch_rows() const { return y_.size(); }
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prior(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+              std::ostream* msgs = 0) const {
+    return log_prior_impl(params_r);
+  }
+
+  template <bool propto, typename T>
+  T log_likelihood_rows(const std::vector<size_t>& rows,
+                        Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+                        std::ostream* msgs = 0) const {
+    T lp = 0;
+    for (size_t n : rows)
+      lp += log_likelihood_row(n, params_r);
+    return lp;
+  }
+};
+
+}  // namespace
+
+TEST(ModelUtil, minibatch_model_detects_members) {
+  EXPECT_EQ(0, stan::model::num_minibatch_rows(normal_model(10)));
+  EXPECT_EQ(10, stan::model::num_minibatch_rows(normal_rows_model(10)));
+  normal_model model(10);
+  EXPECT_THROW(stan::model::minibatch_model<normal_model>(model, 2),
+               std::invalid_argument);
+  normal_rows_model rows_model(10);
+  EXPECT_THROW(stan::model::minibatch_model<normal_rows_model>(rows_model, 0),
+               std::invalid_argument);
+  EXPECT_THROW(
+      stan::model::minibatch_model<normal_rows_model>(rows_model, 11),
+      std::invalid_argument);
+}
+
+TEST(ModelUtil, minibatch_model_draws_distinct_sorted_rows) {
+  normal_rows_model model(50);
+  stan::model::minibatch_model<normal_rows_model> minibatch(model, 20);
+  stan::rng_t rng = stan::services::util::create_rng(3, 1);
+  std::vector<int> counts(50, 0);
+  for (int k = 0; k < 500; ++k) {
+    minibatch.draw_rows(rng);
+    const std::vector<size_t>& rows = minibatch.rows();
+    ASSERT_EQ(20, rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      ASSERT_LT(rows[i], 50);
+      if (i > 0) {
+        ASSERT_LT(rows[i - 1], rows[i]);
+      }
+      ++counts[rows[i]];
+    }
+  }
+  // Each row is drawn with probability 20 / 50
+  for (int count : counts) {
+    EXPECT_GT(count, 140);
+    EXPECT_LT(count, 260);
+  }
+}
+
+TEST(ModelUtil, minibatch_model_all_rows_matches_model) {
+  normal_rows_model model(30);
+  stan::model::minibatch_model<normal_rows_model> minibatch(model, 30);
+  Eigen::VectorXd params_r(1);
+  params_r << 0.7;
+  double lp;
+  Eigen::VectorXd grad;
+  stan::model::gradient(model, params_r, lp, grad);
+  double batch_lp;
+  Eigen::VectorXd batch_grad;
+  stan::model::gradient(minibatch, params_r, batch_lp, batch_grad);
+  EXPECT_FLOAT_EQ(lp, batch_lp);
+  EXPECT_FLOAT_EQ(grad(0), batch_grad(0));
+}
+
+TEST(ModelUtil, minibatch_model_unbiased) {
+  // Averaged over the rows, single-row minibatches give the log density
+  const size_t num_rows = 12;
+  normal_rows_model model(num_rows);
+  stan::model::minibatch_model<normal_rows_model> minibatch(model, 1);
+  Eigen::VectorXd params_r(1);
+  params_r << -0.4;
+  double lp;
+  Eigen::VectorXd grad;
+  stan::model::gradient(model, params_r, lp, grad);
+
+  // Draw until every row has been seen once
+  stan::rng_t rng = stan::services::util::create_rng(5, 1);
+  std::vector<bool> seen(num_rows, false);
+  double sum_lp = 0;
+  double sum_grad = 0;
+  for (size_t num_seen = 0; num_seen < num_rows;) {
+    minibatch.draw_rows(rng);
+    if (seen[minibatch.rows()[0]])
+      continue;
+    seen[minibatch.rows()[0]] = true;
+    ++num_seen;
+    double batch_lp;
+    Eigen::VectorXd batch_grad;
+    stan::model::gradient(minibatch, params_r, batch_lp, batch_grad);
+    sum_lp += batch_lp;
+    sum_grad += batch_grad(0);
+  }
+  EXPECT_FLOAT_EQ(lp, sum_lp / num_rows);
+  EXPECT_FLOAT_EQ(grad(0), sum_grad / num_rows);
+}
@@ -0,0 +1,80 @@
+#include <stan/model/model_metadata.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+// Parameters mu and sigma[2], transformed parameter tau, generated
+// quantity y[2, 2]
+struct names_model {
+  mutable int num_calls = 0;
+  std::vector<std::vector<size_t>> block_dims{{}, {2}, {}, {2, 2}};
+
+  std::string model_name() const { return "names_model"; }
+
+  void constrained_param_names(std::vector<std::string>& names,
+                               bool include_tparams = true,
+                               bool include_gqs = true) const {
+    ++num_calls;
+    names.emplace_back("mu");
+    names.emplace_back("sigma.1");
+    names.emplace_back("sigma.2");
+    if (include_tparams)
+      names.emplace_back("tau");
+    if (include_gqs) {
+      names.emplace_back("y.1.1");
+      names.emplace_back("y.2.1");
+      names.emplace_back("y.1.2");
+      names.emplace_back("y.2.2");
+    }
+  }
+
+  void get_dims(std::vector<std::vector<size_t>>& dimss,
+                bool include_tparams = true, bool include_gqs = true) const {
+    dimss.assign(block_dims.begin(), block_dims.begin() + 2);
+    if (include_tparams)
+      dimss.push_back(block_dims[2]);
+    if (include_gqs)
+      dimss.push_back(block_dims[3]);
+  }
+};
+
+template <class Model>
+std::vector<std::string> names_of(const Model& model, bool include_tparams,
+                                  bool include_gqs) {
+  std::vector<std::string> names{"lp__"};
+  model.constrained_param_names(names, include_tparams, include_gqs);
+  return names;
+}
+}  // namespace
+
+TEST(ModelMetadata, names_match_model) {
+  names_model model;
+  stan::model::model_metadata metadata(model);
+  EXPECT_EQ(1, model.num_calls);
+  EXPECT_EQ("names_model", metadata.model_name());
+  EXPECT_EQ(8, metadata.constrained_param_names().size());
+  for (bool tparams : {false, true}) {
+    for (bool gqs : {false, true}) {
+      EXPECT_EQ(names_of(model, tparams, gqs),
+                names_of(metadata, tparams, gqs));
+      EXPECT_EQ(names_of(model, tparams, gqs).size() - 1,
+                metadata.num_constrained_params(tparams, gqs));
+      std::vector<std::vector<size_t>> model_dims;
+      std::vector<std::vector<size_t>> metadata_dims{{7}};
+      model.get_dims(model_dims, tparams, gqs);
+      metadata.get_dims(metadata_dims, tparams, gqs);
+      EXPECT_EQ(model_dims, metadata_dims);
+    }
+  }
+}
+
+TEST(ModelMetadata, dims_not_matching_names) {
+  // Sizes are taken from the names when the dimensions do not add up
+  names_model model;
+  model.block_dims[1] = {3};
+  stan::model::model_metadata metadata(model);
+  EXPECT_EQ(3, model.num_calls);
+  EXPECT_EQ(3, metadata.num_constrained_params(false, false));
+  EXPECT_EQ(names_of(model, false, true), names_of(metadata, false, true));
+}
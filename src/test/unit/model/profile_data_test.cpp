@@ -0,0 +1,39 @@
+#include <stan/model/profile_data.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace {
+void run_profiled(stan::math::profile_map& profiles, int times) {
+  for (int i = 0; i < times; ++i) {
+    stan::math::profile<double> p("likelihood", profiles);
+  }
+}
+}  // namespace
+
+TEST(ModelProfileData, unregistered_snapshot_is_empty) {
+  stan::model::set_profile_data(nullptr);
+  stan::math::profile_map profiles;
+  run_profiled(profiles, 3);
+  EXPECT_TRUE(stan::model::profile_snapshot::current_thread().totals().empty());
+}
+
+TEST(ModelProfileData, snapshots_difference_calling_thread) {
+  stan::math::profile_map profiles;
+  stan::model::set_profile_data(&profiles);
+  run_profiled(profiles, 2);
+  auto start = stan::model::profile_snapshot::current_thread();
+
+  run_profiled(profiles, 3);
+  // Blocks run by other threads are not counted
+  std::thread other([&profiles]() { run_profiled(profiles, 5); });
+  other.join();
+
+  auto phase = stan::model::profile_snapshot::current_thread().since(start);
+  ASSERT_EQ(1, phase.totals().size());
+  const auto& totals = phase.totals().at("likelihood");
+  EXPECT_EQ(3, totals.no_ad_fwd_passes);
+  EXPECT_EQ(0, totals.ad_fwd_passes);
+  EXPECT_EQ(0, totals.rev_passes);
+  EXPECT_GE(totals.fwd_time, 0);
+  stan::model::set_profile_data(nullptr);
+}
@@ -0,0 +1,88 @@
+#include <stan/model/sparse_hessian.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/model/banded.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+class ModelSparseHessian : public ::testing::Test {
+ public:
+  ModelSparseHessian() : model(context, 0, nullptr), params_r(10) {
+    for (int i = 0; i < 10; ++i)
+      params_r(i) = 0.3 * i - 1;
+  }
+
+  // Hessian of the log density of banded.stan, which is tridiagonal
+  Eigen::MatrixXd expected_hessian() const {
+    Eigen::MatrixXd H = Eigen::MatrixXd::Zero(10, 10);
+    H(0, 0) = -1;
+    for (int i = 0; i < 9; ++i) {
+      H(i, i) -= 4;
+      H(i + 1, i + 1) -= 4;
+      H(i, i + 1) = 4;
+      H(i + 1, i) = 4;
+    }
+    return H;
+  }
+
+  stan::io::empty_var_context context;
+  stan_model model;
+  Eigen::VectorXd params_r;
+};
+
+TEST_F(ModelSparseHessian, sparsity_of_banded_hessian) {
+  stan::model::hessian_coloring coloring
+      = stan::model::hessian_sparsity<true>(model, params_r);
+  ASSERT_EQ(10, coloring.pattern.size());
+  EXPECT_EQ(28, coloring.num_nonzeros());
+  EXPECT_EQ((std::vector<int>{0, 1}), coloring.pattern[0]);
+  EXPECT_EQ((std::vector<int>{3, 4, 5}), coloring.pattern[4]);
+  EXPECT_EQ((std::vector<int>{8, 9}), coloring.pattern[9]);
+  EXPECT_EQ(3, coloring.num_colors);
+  for (int j = 0; j < 10; ++j)
+    EXPECT_EQ(j % 3, coloring.colors[j]);
+}
+
+TEST_F(ModelSparseHessian, coloring_separates_columns_sharing_a_row) {
+  // an arrow pattern: the first column shares a row with every other one,
+  // which share no row with each other
+  stan::model::hessian_coloring coloring;
+  coloring.pattern.resize(5);
+  coloring.pattern[0] = {0, 1, 2, 3, 4};
+  for (int j = 1; j < 5; ++j)
+    coloring.pattern[j] = {0, j};
+  stan::model::color_hessian_pattern(coloring);
+  // columns 1 to 4 all have a nonzero in row 0
+  EXPECT_EQ(5, coloring.num_colors);
+
+  coloring.pattern.assign(4, std::vector<int>());
+  for (int j = 0; j < 4; ++j)
+    coloring.pattern[j] = {j};
+  stan::model::color_hessian_pattern(coloring);
+  EXPECT_EQ(1, coloring.num_colors);
+  EXPECT_EQ((std::vector<int>{0, 0, 0, 0}), coloring.colors);
+}
+
+TEST_F(ModelSparseHessian, sparse_hessian_matches_dense) {
+  stan::model::hessian_coloring coloring
+      = stan::model::hessian_sparsity<true>(model, params_r);
+  Eigen::VectorXd gradient;
+  Eigen::SparseMatrix<double> hessian;
+  double lp = stan::model::sparse_hessian<true>(model, params_r, coloring,
+                                                gradient, hessian);
+
+  Eigen::VectorXd expected_gradient;
+  Eigen::VectorXd params(params_r);
+  double expected_lp = stan::model::log_prob_grad<true, true>(
+      model, params, expected_gradient);
+  EXPECT_FLOAT_EQ(expected_lp, lp);
+  ASSERT_EQ(10, gradient.size());
+  for (int i = 0; i < 10; ++i)
+    EXPECT_FLOAT_EQ(expected_gradient(i), gradient(i));
+
+  EXPECT_EQ(28, hessian.nonZeros());
+  Eigen::MatrixXd H(hessian);
+  Eigen::MatrixXd expected = expected_hessian();
+  for (int i = 0; i < 10; ++i)
+    for (int j = 0; j < 10; ++j)
+      EXPECT_NEAR(expected(i, j), H(i, j), 1e-6) << i << ", " << j;
+}
@@ -0,0 +1,64 @@
+#include <stan/model/test_concurrent_log_prob_grad.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+// Normal log density with fixed data, read only after construction
+class normal_model : public stan::model::prob_grad {
+ public:
+  explicit normal_model(size_t n)
+      : stan::model::prob_grad(n), mu_(Eigen::VectorXd::LinSpaced(n, -1, 1)) {}
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = 0) const {
+    T lp = 0;
+    for (int i = 0; i < params_r.size(); ++i)
+      lp -= 0.5 * (params_r(i) - mu_(i)) * (params_r(i) - mu_(i));
+    return lp;
+  }
+
+ private:
+  Eigen::VectorXd mu_;
+};
+
+// Breaks the contract by counting its evaluations
+class counting_model : public normal_model {
+ public:
+  explicit counting_model(size_t n) : normal_model(n) {}
+
+  template <bool propto, bool jacobian, typename T>
+  T log_prob(Eigen::Matrix<T, Eigen::Dynamic, 1>& params_r,
+             std::ostream* msgs = 0) const {
+    double num_calls = ++num_calls_;
+    return normal_model::log_prob<propto, jacobian>(params_r, msgs)
+           + num_calls;
+  }
+
+ private:
+  mutable std::atomic<int> num_calls_{0};
+};
+
+std::vector<Eigen::VectorXd> points(int n, int num_points) {
+  std::vector<Eigen::VectorXd> params_r;
+  for (int k = 0; k < num_points; ++k)
+    params_r.push_back(Eigen::VectorXd::Constant(n, 0.25 * k));
+  return params_r;
+}
+
+}  // namespace
+
+TEST(ModelUtil, test_concurrent_log_prob_grad_thread_safe) {
+  normal_model model(5);
+  EXPECT_EQ(0, (stan::model::test_concurrent_log_prob_grad<true, true>(
+                   model, points(5, 8), 50)));
+}
+
+TEST(ModelUtil, test_concurrent_log_prob_grad_stateful) {
+  counting_model model(5);
+  EXPECT_EQ(8 * 50, (stan::model::test_concurrent_log_prob_grad<true, true>(
+                        model, points(5, 8), 50)));
+}
@@ -0,0 +1,68 @@
+#include <stan/model/test_gradients_projection.hpp>
+#include <stan/callbacks/interrupt.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+namespace test {
+// Standard normal log density, with a term wrongly added when
+// differentiating if the gradient is to be wrong
+class normal_model {
+ public:
+  explicit normal_model(bool wrong_gradient)
+      : wrong_gradient_(wrong_gradient) {}
+
+  template <typename T__>
+  T__ log_density(const T__* x, size_t size) const {
+    T__ lp = 0;
+    for (size_t k = 0; k < size; ++k)
+      lp -= 0.5 * x[k] * x[k];
+    if (wrong_gradient_ && !std::is_same<T__, double>::value)
+      lp += x[0];
+    return lp;
+  }
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(Eigen::Matrix<T__, Eigen::Dynamic, 1>& params_r__,
+               std::ostream* pstream__ = 0) const {
+    return log_density(params_r__.data(), params_r__.size());
+  }
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    return log_density(params_r__.data(), params_r__.size());
+  }
+
+  bool wrong_gradient_;
+};
+}  // namespace test
+
+TEST(ModelUtil, test_gradients_projection) {
+  std::vector<double> params_r{0.5, -1, 2};
+  std::vector<int> params_i(0);
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::test::unit::instrumented_logger logger;
+  std::stringstream out;
+  stan::callbacks::stream_writer writer(out);
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+
+  test::normal_model model(false);
+  EXPECT_EQ(0, stan::model::test_gradients_projection(
+                   model, params_r, params_i, 1e-6, 1e-6, 4, rng, interrupt,
+                   logger, writer));
+  EXPECT_EQ(4, interrupt.call_count());
+  EXPECT_EQ(1, logger.find_info("Log probability=-2.625"));
+  EXPECT_EQ(1, logger.find_info("direction"));
+  EXPECT_NE(std::string::npos, out.str().find("Log probability=-2.625"));
+
+  test::normal_model wrong_model(true);
+  EXPECT_EQ(4, stan::model::test_gradients_projection(
+                   wrong_model, params_r, params_i, 1e-6, 1e-6, 4, rng,
+                   interrupt, logger, writer));
+  EXPECT_EQ(8, interrupt.call_count());
+}
@@ -192,3 +192,43 @@ TEST(OptimizationBfgsLinesearch, wolfeLineSearch) {
   EXPECT_LE(f1, f0 + c1 * alpha * p.dot(gradx0));
   EXPECT_LE(std::fabs(p.dot(gradx1)), c2 * std::fabs(p.dot(gradx0)));
 }
+
+class counting_testfunc : public linesearch_testfunc {
+ public:
+  int evals = 0;
+  int operator()(const Eigen::Matrix<double, Eigen::Dynamic, 1> &x, double &f,
+                 Eigen::Matrix<double, Eigen::Dynamic, 1> &g) {
+    ++evals;
+    return linesearch_testfunc::operator()(x, f, g);
+  }
+};
+
+TEST(OptimizationBfgsLinesearch, LineSearchCache) {
+  typedef Eigen::Matrix<double, -1, 1> XType;
+  counting_testfunc func;
+  stan::optimization::LineSearchCache<double, XType> cache;
+  XType x0 = XType::Ones(3);
+  XType p = -XType::LinSpaced(3, 1.0, 2.0);
+  XType x, g, g_first;
+  double f, f_first;
+
+  EXPECT_EQ(0, cache(func, 0.5, x, f_first, g_first, x0, p));
+  EXPECT_EQ(1, func.evals);
+  cache(func, 0.25, x, f, g, x0, p);
+  EXPECT_EQ(2, func.evals);
+
+  // A step size tried before is looked up, at the same point
+  EXPECT_EQ(0, cache(func, 0.5, x, f, g, x0, p));
+  EXPECT_EQ(2, func.evals);
+  EXPECT_EQ(f_first, f);
+  EXPECT_FLOAT_EQ(0.0, (g - g_first).norm());
+  EXPECT_FLOAT_EQ(0.0, (x - (x0 + 0.5 * p)).norm());
+
+  // The oldest evaluations are forgotten
+  for (double alpha : {0.1, 0.2, 0.3, 0.4})
+    cache(func, alpha, x, f, g, x0, p);
+  EXPECT_EQ(6, func.evals);
+  cache(func, 0.5, x, f, g, x0, p);
+  EXPECT_EQ(7, func.evals);
+  EXPECT_EQ(f_first, f);
+}
@@ -76,3 +76,36 @@ TEST(OptimizationBfgsUpdate, BFGSUpdate_HInv_search_direction) {
     }
   }
 }
+
+TEST(OptimizationBfgsUpdate, BFGSUpdate_HInv_packed_matches_dense) {
+  const int nDim = 7;
+  typedef stan::optimization::BFGSUpdate_HInv<> DenseT;
+  typedef stan::optimization::BFGSUpdate_HInv_packed<> PackedT;
+  typedef DenseT::VectorT VectorT;
+
+  DenseT dense;
+  PackedT packed;
+  // a positive definite Hessian, so every update has positive curvature
+  Eigen::MatrixXd A = Eigen::MatrixXd::Random(nDim, nDim);
+  Eigen::MatrixXd B = A * A.transpose()
+                      + nDim * Eigen::MatrixXd::Identity(nDim, nDim);
+  VectorT sdir_dense(nDim), sdir_packed(nDim);
+  for (int i = 0; i < 2 * nDim; i++) {
+    VectorT sk = VectorT::Random(nDim);
+    VectorT yk = B * sk;
+    EXPECT_FLOAT_EQ(dense.update(yk, sk, i % 5 == 0),
+                    packed.update(yk, sk, i % 5 == 0));
+
+    VectorT gk = VectorT::Random(nDim);
+    dense.search_direction(sdir_dense, gk);
+    packed.search_direction(sdir_packed, gk);
+    for (int j = 0; j < nDim; j++)
+      EXPECT_NEAR(sdir_dense[j], sdir_packed[j], 1e-10);
+
+    // the secant equation holds for the latest update
+    packed.search_direction(sdir_packed, yk);
+    EXPECT_NEAR((sdir_packed + sk).norm(), 0.0, 1e-10);
+    Eigen::MatrixXd H = packed.inverse_hessian();
+    EXPECT_NEAR((H - H.transpose()).norm(), 0.0, 1e-14);
+  }
+}
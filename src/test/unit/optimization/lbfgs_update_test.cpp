@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <stan/optimization/lbfgs_update.hpp>
+#include <algorithm>
+#include <vector>
 
 TEST(OptimizationLbfgsUpdate, lbfgs_update_secant) {
   typedef stan::optimization::LBFGSUpdate<> QNUpdateT;
@@ -55,7 +57,7 @@ class mock_lbfgs_update : public LBFGSUpdate<> {
  public:
   mock_lbfgs_update(size_t L) : LBFGSUpdate<>(L){};
 
-  size_t get_history_size() { return this->_buf.capacity(); }
+  size_t get_history_size() { return this->_capacity; }
 };
 }  // namespace optimization
 }  // namespace stan
@@ -119,3 +121,169 @@ TEST(OptimizationLbfgsUpdate, search_direction) {
     }
   }
 }
+
+namespace {
+// Two-loop recursion over the last L updates, oldest first
+Eigen::VectorXd two_loop(const std::vector<Eigen::VectorXd>& ys,
+                         const std::vector<Eigen::VectorXd>& ss, size_t L,
+                         const Eigen::VectorXd& gk) {
+  size_t begin = ys.size() > L ? ys.size() - L : 0;
+  std::vector<double> alphas(ys.size());
+  Eigen::VectorXd pk = -gk;
+  for (size_t i = ys.size(); i-- > begin;) {
+    alphas[i] = ss[i].dot(pk) / ys[i].dot(ss[i]);
+    pk -= alphas[i] * ys[i];
+  }
+  pk *= ys.back().dot(ss.back()) / ys.back().squaredNorm();
+  for (size_t i = begin; i < ys.size(); ++i) {
+    double beta = ys[i].dot(pk) / ys[i].dot(ss[i]);
+    pk += (alphas[i] - beta) * ss[i];
+  }
+  return pk;
+}
+}  // namespace
+
+TEST(OptimizationLbfgsUpdate, history_wraps_around) {
+  typedef stan::optimization::LBFGSUpdate<> QNUpdateT;
+  typedef QNUpdateT::VectorT VectorT;
+
+  const int nDim = 7;
+  QNUpdateT bfgsUp(3);
+  std::vector<Eigen::VectorXd> ys, ss;
+  VectorT gk = VectorT::LinSpaced(nDim, -1.0, 2.0);
+  VectorT sdir(nDim);
+  for (int i = 0; i < 8; ++i) {
+    VectorT sk = VectorT::Random(nDim);
+    VectorT yk = sk + 0.1 * VectorT::Random(nDim);
+    bfgsUp.update(yk, sk, i == 0);
+    ys.push_back(yk);
+    ss.push_back(sk);
+
+    bfgsUp.search_direction(sdir, gk);
+    EXPECT_NEAR(0.0, (sdir - two_loop(ys, ss, 3, gk)).norm(), 1e-10);
+  }
+
+  // Shrinking and growing the history keeps the most recent updates
+  bfgsUp.set_history_size(2);
+  bfgsUp.search_direction(sdir, gk);
+  EXPECT_NEAR(0.0, (sdir - two_loop(ys, ss, 2, gk)).norm(), 1e-10);
+  bfgsUp.set_history_size(4);
+  bfgsUp.search_direction(sdir, gk);
+  EXPECT_NEAR(0.0, (sdir - two_loop(ys, ss, 2, gk)).norm(), 1e-10);
+
+  VectorT sk = VectorT::Random(nDim);
+  VectorT yk = sk + 0.1 * VectorT::Random(nDim);
+  bfgsUp.update(yk, sk);
+  ys.push_back(yk);
+  ss.push_back(sk);
+  bfgsUp.search_direction(sdir, gk);
+  EXPECT_NEAR(0.0, (sdir - two_loop(ys, ss, 3, gk)).norm(), 1e-10);
+}
+
+TEST(OptimizationLbfgsUpdate, history_block) {
+  typedef stan::optimization::LBFGSUpdate<> QNUpdateT;
+  typedef QNUpdateT::VectorT VectorT;
+
+  const int nDim = 5;
+  QNUpdateT bfgsUp(3);
+  std::vector<Eigen::VectorXd> ys, ss;
+  EXPECT_EQ(0, bfgsUp.history_size());
+  for (int i = 0; i < 11; ++i) {
+    VectorT sk = VectorT::Random(nDim);
+    VectorT yk = sk + 0.1 * VectorT::Random(nDim);
+    bfgsUp.update(yk, sk, i == 0);
+    ys.push_back(yk);
+    ss.push_back(sk);
+
+    // The newest updates, oldest first
+    const size_t size = std::min<size_t>(ys.size(), 3);
+    ASSERT_EQ(size, bfgsUp.history_size());
+    ASSERT_EQ(size, bfgsUp.y_history().cols());
+    ASSERT_EQ(size, bfgsUp.s_history().cols());
+    for (size_t j = 0; j < size; ++j) {
+      const size_t k = ys.size() - size + j;
+      EXPECT_EQ(0.0, (bfgsUp.y_history().col(j) - ys[k]).norm());
+      EXPECT_EQ(0.0, (bfgsUp.s_history().col(j) - ss[k]).norm());
+    }
+  }
+
+  VectorT sk = VectorT::Random(nDim);
+  bfgsUp.update(sk, sk, true);
+  EXPECT_EQ(1, bfgsUp.history_size());
+}
+
+TEST(OptimizationLbfgsUpdate, diagonal_inverse_hessian_update) {
+  Eigen::VectorXd diag(3), yk(3), sk(3);
+  diag << 1.0, 2.0, 0.5;
+  yk << 1.0, -0.5, 2.0;
+  sk << 0.5, 0.25, 1.0;
+
+  // eq 4.9 of Gilbert and Lemarechal (1989), term by term
+  const double y_diag_y = 1.0 * 1.0 + 2.0 * 0.25 + 0.5 * 4.0;
+  const double y_s = 0.5 - 0.125 + 2.0;
+  const double s_inv_diag_s = 0.25 / 1.0 + 0.0625 / 2.0 + 1.0 / 0.5;
+  Eigen::VectorXd expected(3);
+  for (int i = 0; i < 3; ++i) {
+    expected(i) = y_s
+                  / (y_diag_y / diag(i) + yk(i) * yk(i)
+                     - y_diag_y / s_inv_diag_s * (sk(i) / diag(i))
+                           * (sk(i) / diag(i)));
+  }
+  Eigen::VectorXd updated
+      = stan::optimization::diagonal_inverse_hessian_update(diag, yk, sk);
+  EXPECT_NEAR(0.0, (updated - expected).norm(), 1e-12);
+
+  EXPECT_TRUE(
+      stan::optimization::update_diagonal_inverse_hessian(diag, yk, sk));
+  EXPECT_NEAR(0.0, (diag - expected).norm(), 1e-12);
+
+  // Pairs of nonpositive curvature are skipped
+  EXPECT_FALSE(
+      stan::optimization::update_diagonal_inverse_hessian(diag, -yk, sk));
+  EXPECT_NEAR(0.0, (diag - expected).norm(), 1e-12);
+}
+
+TEST(OptimizationLbfgsUpdate, diagonal_scaling_secant) {
+  typedef stan::optimization::LBFGSUpdate<> QNUpdateT;
+  typedef QNUpdateT::VectorT VectorT;
+
+  const int nDim = 6;
+  QNUpdateT bfgsUp(3);
+  bfgsUp.set_diagonal_scaling(true);
+  EXPECT_EQ(0, bfgsUp.diagonal().size());
+  VectorT sdir(nDim);
+  for (int i = 0; i < 5; ++i) {
+    VectorT sk = VectorT::Random(nDim);
+    VectorT yk = sk + 0.1 * VectorT::Random(nDim);
+    bfgsUp.update(yk, sk, i == 0);
+    ASSERT_EQ(nDim, bfgsUp.diagonal().size());
+    EXPECT_TRUE((bfgsUp.diagonal().array() > 0).all());
+
+    // The newest update satisfies the secant equation whatever the
+    // initial approximation
+    bfgsUp.search_direction(sdir, yk);
+    EXPECT_NEAR(0.0, (sdir + sk).norm(), 1e-10);
+  }
+
+  // The diagonal restarts from the identity with the history
+  VectorT sk = VectorT::Unit(nDim, 0);
+  bfgsUp.update(sk, sk, true);
+  EXPECT_NEAR(0.0, (bfgsUp.diagonal() - VectorT::Ones(nDim)).norm(), 1e-12);
+}
+
+TEST(OptimizationLbfgsUpdate, diagonal_scaling_no_history) {
+  typedef stan::optimization::LBFGSUpdate<> QNUpdateT;
+  typedef QNUpdateT::VectorT VectorT;
+
+  // Without history, the direction is the scaled negative gradient
+  QNUpdateT bfgsUp(0);
+  bfgsUp.set_diagonal_scaling(true);
+  VectorT sk(2), yk(2), gk(2), sdir(2);
+  sk << 1.0, 1.0;
+  yk << 1.0, 100.0;
+  gk << 1.0, 1.0;
+  bfgsUp.update(yk, sk, true);
+  bfgsUp.search_direction(sdir, gk);
+  EXPECT_NEAR(0.0, (sdir + bfgsUp.diagonal()).norm(), 1e-12);
+  EXPECT_GT(bfgsUp.diagonal()(0), bfgsUp.diagonal()(1));
+}
@@ -0,0 +1,96 @@
+#include <stan/services/batch/fit_datasets.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+struct mock_data {
+  double y;
+};
+
+struct mock_model {
+  explicit mock_model(const mock_data& data) : y(data.y) {}
+  double y;
+};
+
+struct mock_workspace {
+  std::vector<double> buffer;
+  int num_fits = 0;
+};
+}  // namespace
+
+TEST(ServicesBatch, fit_datasets) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  std::vector<double> fitted(20, 0);
+  std::vector<int> return_codes = stan::services::batch::fit_datasets(
+      20, [](size_t i) { return mock_data{static_cast<double>(i)}; },
+      [](mock_data& data) { return mock_model(data); },
+      [&fitted](size_t i, mock_model& model) {
+        fitted[i] = 2 * model.y;
+        return stan::services::error_codes::OK;
+      },
+      logger);
+
+  ASSERT_EQ(20, return_codes.size());
+  for (size_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(stan::services::error_codes::OK, return_codes[i]);
+    EXPECT_FLOAT_EQ(2.0 * i, fitted[i]);
+  }
+  EXPECT_EQ("", error.str());
+}
+
+TEST(ServicesBatch, fit_datasets_workspace) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  std::vector<int> num_fits(50, 0);
+  std::vector<int> return_codes
+      = stan::services::batch::fit_datasets<mock_workspace>(
+          50, [](size_t i) { return mock_data{static_cast<double>(i)}; },
+          [](mock_data& data) { return mock_model(data); },
+          [&num_fits](size_t i, mock_model& model, mock_workspace& workspace) {
+            // The buffer is allocated once per thread
+            if (workspace.buffer.empty())
+              workspace.buffer.resize(100);
+            num_fits[i] = ++workspace.num_fits;
+            return stan::services::error_codes::OK;
+          },
+          logger);
+
+  for (size_t i = 0; i < 50; ++i) {
+    EXPECT_EQ(stan::services::error_codes::OK, return_codes[i]);
+    EXPECT_GE(num_fits[i], 1);
+  }
+}
+
+TEST(ServicesBatch, fit_datasets_error) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  std::vector<int> return_codes = stan::services::batch::fit_datasets(
+      5,
+      [](size_t i) {
+        if (i == 1)
+          throw std::domain_error("bad data");
+        return mock_data{static_cast<double>(i)};
+      },
+      [](mock_data& data) { return mock_model(data); },
+      [](size_t i, mock_model& model) {
+        if (i == 3)
+          throw std::runtime_error("fit failed");
+        return stan::services::error_codes::OK;
+      },
+      logger);
+
+  EXPECT_EQ(stan::services::error_codes::OK, return_codes[0]);
+  EXPECT_EQ(stan::services::error_codes::SOFTWARE, return_codes[1]);
+  EXPECT_EQ(stan::services::error_codes::OK, return_codes[2]);
+  EXPECT_EQ(stan::services::error_codes::SOFTWARE, return_codes[3]);
+  EXPECT_EQ(stan::services::error_codes::OK, return_codes[4]);
+  EXPECT_NE(std::string::npos, error.str().find("Dataset 1: bad data"));
+  EXPECT_NE(std::string::npos, error.str().find("Dataset 3: fit failed"));
+}
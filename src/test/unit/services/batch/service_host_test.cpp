@@ -0,0 +1,85 @@
+#include <stan/services/batch/service_host.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+struct mock_model {
+  double y = 2;
+};
+
+struct mock_workspace {
+  std::vector<double> buffer;
+  int num_requests = 0;
+};
+}  // namespace
+
+TEST(ServicesBatch, service_host_run) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::services::batch::service_host<mock_model, mock_workspace> host(
+      std::make_unique<mock_model>());
+  EXPECT_FLOAT_EQ(2, host.model().y);
+
+  for (int n = 1; n <= 5; ++n) {
+    double result = 0;
+    int return_code = host.run(
+        [&](mock_model& model, mock_workspace& workspace) {
+          // The buffer is allocated by the first request only
+          if (workspace.buffer.empty())
+            workspace.buffer.resize(100, model.y);
+          EXPECT_EQ(100, workspace.buffer.size());
+          result = workspace.buffer[0] * n;
+          ++workspace.num_requests;
+          return stan::services::error_codes::OK;
+        },
+        logger);
+    EXPECT_EQ(stan::services::error_codes::OK, return_code);
+    EXPECT_FLOAT_EQ(2.0 * n, result);
+  }
+  EXPECT_EQ("", error.str());
+}
+
+TEST(ServicesBatch, service_host_run_policy) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::services::util::execution_policy policy;
+  policy.num_threads = 1;
+  stan::services::batch::service_host<mock_model> host(
+      std::make_unique<mock_model>(), policy);
+  int return_code = host.run(
+      [](mock_model&, stan::services::batch::internal::no_workspace&) {
+        EXPECT_EQ(1, tbb::this_task_arena::max_concurrency());
+        return stan::services::error_codes::OK;
+      },
+      logger);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+}
+
+TEST(ServicesBatch, service_host_run_exception) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+
+  stan::services::batch::service_host<mock_model> host(
+      std::make_unique<mock_model>());
+  int return_code = host.run(
+      [](mock_model&, stan::services::batch::internal::no_workspace&) -> int {
+        throw std::domain_error("bad request");
+      },
+      logger);
+  EXPECT_EQ(stan::services::error_codes::SOFTWARE, return_code);
+  EXPECT_NE(std::string::npos, error.str().find("bad request"));
+
+  // The host keeps serving requests after a failed one
+  return_code = host.run(
+      [](mock_model&, stan::services::batch::internal::no_workspace&) {
+        return stan::services::error_codes::OK;
+      },
+      logger);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+}
@@ -108,3 +108,15 @@ TEST(experimental_advi_defaults, output_draws) {
 
   EXPECT_EQ(1000, output_draws::default_value());
 }
+
+TEST(experimental_advi_defaults, rank) {
+  using stan::services::experimental::advi::rank;
+  EXPECT_EQ("Rank of the covariance factor of the low rank approximation.",
+            rank::description());
+
+  EXPECT_NO_THROW(rank::validate(rank::default_value()));
+  EXPECT_NO_THROW(rank::validate(5));
+  EXPECT_THROW(rank::validate(0), std::invalid_argument);
+
+  EXPECT_EQ(1, rank::default_value());
+}
@@ -93,5 +93,5 @@ TEST_F(ServicesExperimentalAdvi, meanfield) {
   ASSERT_EQ(output_samples + 1, parameter.vector_double_values().size());
   ASSERT_EQ(eval_elbo, diagnostic.vector_double_values().size());
 
-  EXPECT_EQ(0, interrupt.call_count());
+  EXPECT_GT(interrupt.call_count(), 0);
 }
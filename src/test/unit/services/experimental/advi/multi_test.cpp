@@ -0,0 +1,72 @@
+#include <stan/services/experimental/advi/multi.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/services/test_lp.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <memory>
+
+class ServicesExperimentalAdviMulti : public testing::Test {
+ public:
+  ServicesExperimentalAdviMulti()
+      : init_writers(num_runs), diagnostics(num_runs),
+        model(context, 0, &model_log) {
+    for (size_t k = 0; k < num_runs; ++k)
+      contexts.push_back(std::make_shared<stan::io::empty_var_context>());
+  }
+
+  static constexpr size_t num_runs = 4;
+  std::stringstream model_log;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> contexts;
+  std::vector<stan::test::unit::instrumented_writer> init_writers;
+  std::vector<stan::test::unit::instrumented_writer> diagnostics;
+  stan::test::unit::instrumented_writer parameter;
+  stan::test::unit::instrumented_logger logger;
+  stan::io::empty_var_context context;
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan_model model;
+};
+
+TEST_F(ServicesExperimentalAdviMulti, meanfield_multi) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 2;
+  int grad_samples = 1;
+  int elbo_samples = 100;
+  int max_iterations = 10000;
+  double tol_rel_obj = 0.01;
+  double eta = 1.0;
+  bool adapt_engaged = true;
+  int adapt_iterations = 50;
+  int eval_elbo = 100;
+  int output_samples = 1000;
+
+  int return_code = stan::services::experimental::advi::meanfield_multi(
+      model, contexts, seed, chain, init_radius, grad_samples, elbo_samples,
+      max_iterations, tol_rel_obj, eta, adapt_engaged, adapt_iterations,
+      eval_elbo, output_samples, num_runs, interrupt, logger, init_writers,
+      diagnostics, parameter);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(1, logger.find_info("EXPERIMENTAL ALGORITHM"));
+  EXPECT_EQ(1, logger.find_info("Kept run"));
+
+  // One header, and the mean and draws of the kept run only
+  ASSERT_EQ(1, parameter.vector_string_values().size());
+  EXPECT_EQ(8, parameter.vector_string_values()[0].size());
+  EXPECT_EQ(output_samples + 1, parameter.vector_double_values().size());
+  for (size_t k = 0; k < num_runs; ++k) {
+    EXPECT_EQ(1, init_writers[k].vector_double_values().size());
+    EXPECT_GT(diagnostics[k].vector_double_values().size(), 0);
+  }
+  EXPECT_GT(interrupt.call_count(), 0);
+}
+
+TEST_F(ServicesExperimentalAdviMulti, fullrank_multi_abandons) {
+  int return_code = stan::services::experimental::advi::fullrank_multi(
+      model, contexts, 0, 1, 2, 1, 100, 10000, 0.01, 1.0, true, 50, 100,
+      1000, num_runs, interrupt, logger, init_writers, diagnostics,
+      parameter, 0.0, 0);
+  EXPECT_EQ(0, return_code);
+  // Runs may be abandoned, but the leader always completes
+  EXPECT_EQ(1, logger.find_info("Kept run"));
+  EXPECT_EQ(1001, parameter.vector_double_values().size());
+}
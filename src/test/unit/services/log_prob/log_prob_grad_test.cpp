@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/json/json_data.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <stan/model/log_prob_grad.hpp>
+#include <stan/model/log_prob_propto.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/log_prob/log_prob_grad.hpp>
+#include <test/test-models/good/services/bernoulli.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+class ServicesLogProbGrad : public ::testing::Test {
+ public:
+  ServicesLogProbGrad()
+      : data_var_context([]() {
+          std::fstream data_stream(
+              "src/test/test-models/good/services/bernoulli.data.json",
+              std::fstream::in);
+          stan::json::json_data data_context(data_stream);
+          data_stream.close();
+          return data_context;
+        }()),
+        logger(logger_ss, logger_ss, logger_ss, logger_ss, logger_ss),
+        model(data_var_context) {
+    std::stringstream out;
+    std::ifstream csv_stream(
+        "src/test/test-models/good/services/bernoulli_fit.csv");
+    stan::io::stan_csv fit = stan::io::stan_csv_reader::parse(csv_stream, &out);
+    theta = fit.samples.middleCols<1>(7);
+  }
+  stan::json::json_data data_var_context;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::stringstream logger_ss;
+  stan::callbacks::stream_logger logger;
+  stan_model model;
+  Eigen::MatrixXd theta;
+};
+
+TEST_F(ServicesLogProbGrad, constrained_matches_log_prob_grad) {
+  stan::test::unit::instrumented_writer writer;
+  int return_code = stan::services::log_prob::log_prob_grad(
+      model, theta, true, true, true, interrupt, logger, writer);
+  ASSERT_EQ(stan::services::error_codes::OK, return_code);
+
+  std::vector<std::vector<std::string>> names = writer.vector_string_values();
+  ASSERT_EQ(1, names.size());
+  EXPECT_EQ((std::vector<std::string>{"lp__", "g_1"}), names[0]);
+  std::vector<std::vector<double>> values = writer.vector_double_values();
+  ASSERT_EQ(theta.rows(), values.size());
+  EXPECT_EQ(theta.rows(), interrupt.call_count());
+  for (Eigen::Index i = 0; i < theta.rows(); ++i) {
+    Eigen::VectorXd params_r(1);
+    params_r(0) = stan::math::logit(theta(i, 0));
+    Eigen::VectorXd gradient;
+    double lp = stan::model::log_prob_grad<true, true>(model, params_r,
+                                                        gradient);
+    ASSERT_EQ(2, values[i].size());
+    EXPECT_FLOAT_EQ(lp, values[i][0]);
+    EXPECT_FLOAT_EQ(gradient(0), values[i][1]);
+  }
+}
+
+TEST_F(ServicesLogProbGrad, unconstrained_matches_constrained) {
+  Eigen::MatrixXd unconstrained = stan::math::logit(theta.array()).matrix();
+  stan::test::unit::instrumented_writer constrained_writer;
+  stan::test::unit::instrumented_writer unconstrained_writer;
+  EXPECT_EQ(stan::services::error_codes::OK,
+            stan::services::log_prob::log_prob_grad(model, theta, true, true,
+                                                    true, interrupt, logger,
+                                                    constrained_writer));
+  EXPECT_EQ(stan::services::error_codes::OK,
+            stan::services::log_prob::log_prob_grad(
+                model, unconstrained, false, true, true, interrupt, logger,
+                unconstrained_writer));
+  std::vector<std::vector<double>> expected
+      = constrained_writer.vector_double_values();
+  std::vector<std::vector<double>> values
+      = unconstrained_writer.vector_double_values();
+  ASSERT_EQ(expected.size(), values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_FLOAT_EQ(expected[i][0], values[i][0]);
+    EXPECT_FLOAT_EQ(expected[i][1], values[i][1]);
+  }
+}
+
+TEST_F(ServicesLogProbGrad, log_prob_without_gradient_or_jacobian) {
+  stan::test::unit::instrumented_writer writer;
+  int return_code = stan::services::log_prob::log_prob_grad(
+      model, theta, true, false, false, interrupt, logger, writer);
+  ASSERT_EQ(stan::services::error_codes::OK, return_code);
+  EXPECT_EQ((std::vector<std::string>{"lp__"}),
+            writer.vector_string_values()[0]);
+  std::vector<std::vector<double>> values = writer.vector_double_values();
+  ASSERT_EQ(theta.rows(), values.size());
+  for (Eigen::Index i = 0; i < theta.rows(); ++i) {
+    Eigen::VectorXd params_r(1);
+    params_r(0) = stan::math::logit(theta(i, 0));
+    ASSERT_EQ(1, values[i].size());
+    EXPECT_FLOAT_EQ(stan::model::log_prob_propto<false>(model, params_r),
+                    values[i][0]);
+  }
+}
+
+TEST_F(ServicesLogProbGrad, wrong_number_of_columns) {
+  stan::test::unit::instrumented_writer writer;
+  Eigen::MatrixXd draws = Eigen::MatrixXd::Constant(3, 2, 0.5);
+  int return_code = stan::services::log_prob::log_prob_grad(
+      model, draws, true, true, true, interrupt, logger, writer);
+  EXPECT_EQ(stan::services::error_codes::DATAERR, return_code);
+  EXPECT_EQ(0, writer.call_count());
+  EXPECT_NE(std::string::npos, logger_ss.str().find("Expecting 1 columns"));
+}
+
+TEST_F(ServicesLogProbGrad, constrained_draw_out_of_support) {
+  stan::test::unit::instrumented_writer writer;
+  Eigen::MatrixXd draws(3, 1);
+  draws << 0.2, 1.5, 0.4;
+  int return_code = stan::services::log_prob::log_prob_grad(
+      model, draws, true, true, true, interrupt, logger, writer);
+  EXPECT_EQ(stan::services::error_codes::DATAERR, return_code);
+  // The draw before the bad one is written
+  EXPECT_EQ(1, writer.call_count("vector_double"));
+}
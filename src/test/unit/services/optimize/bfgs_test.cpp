@@ -3,7 +3,14 @@
 #include <stan/io/empty_var_context.hpp>
 #include <test/test-models/good/optimization/rosenbrock.hpp>
 #include <test/unit/services/instrumented_callbacks.hpp>
+#include <stan/callbacks/json_writer.hpp>
 #include <stan/callbacks/stream_writer.hpp>
+#include <memory>
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
 
 struct ServicesOptimize : public testing::Test {
   ServicesOptimize()
@@ -57,3 +64,51 @@ TEST_F(ServicesOptimize, rosenbrock) {
   EXPECT_FLOAT_EQ(return_code, 0);
   EXPECT_EQ(19, interrupt.call_count());
 }
+
+TEST_F(ServicesOptimize, rosenbrock_iteration_record) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::stringstream record_ss;
+  std::unique_ptr<std::stringstream, deleter_noop> record_stream(&record_ss);
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> record(
+      std::move(record_stream));
+
+  int return_code = stan::services::optimize::bfgs(
+      model, context, 0, 1, 0, 0.001, 1e-12, 10000, 1e-8, 10000000, 1e-8,
+      2000, false, 0, interrupt, logger, init, parameter, record);
+
+  EXPECT_EQ(0, return_code);
+  std::string json = record_ss.str();
+  EXPECT_NE(std::string::npos, json.find("\"algorithm\" : \"bfgs\""));
+  EXPECT_NE(std::string::npos, json.find("\"1\" : {"));
+  EXPECT_NE(std::string::npos, json.find("\"19\" : {"));
+  EXPECT_EQ(std::string::npos, json.find("\"20\" : {"));
+  EXPECT_NE(std::string::npos, json.find("\"line_search_trials\""));
+  EXPECT_NE(std::string::npos, json.find("\"model_time\""));
+  EXPECT_NE(std::string::npos, json.find("\"return_code\" : 0"));
+}
+
+TEST_F(ServicesOptimize, rosenbrock_memory_limit) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  // The dense approximation for the 2 parameters takes 96 bytes and the
+  // packed one 24 bytes
+  const double packed_mb = 50.0 / (1024 * 1024);
+  int return_code = stan::services::optimize::bfgs(
+      model, context, 0, 1, 0, 0.001, 1e-12, 10000, 1e-8, 10000000, 1e-8,
+      2000, false, 0, interrupt, logger, init, parameter, packed_mb);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(1, logger.find("Storing the BFGS inverse Hessian approximation "
+                           "packed"));
+  ASSERT_EQ(1, parameter.states_.size());
+  EXPECT_NEAR(1, parameter.states_.back()[1], 1e-3);
+  EXPECT_NEAR(1, parameter.states_.back()[2], 1e-3);
+
+  const double lbfgs_mb = 10.0 / (1024 * 1024);
+  return_code = stan::services::optimize::bfgs(
+      model, context, 0, 1, 0, 0.001, 1e-12, 10000, 1e-8, 10000000, 1e-8,
+      2000, false, 0, interrupt, logger, init, parameter, lbfgs_mb);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(1, logger.find("using L-BFGS with a history size of 5"));
+  ASSERT_EQ(2, parameter.states_.size());
+  EXPECT_NEAR(1, parameter.states_.back()[1], 1e-3);
+  EXPECT_NEAR(1, parameter.states_.back()[2], 1e-3);
+}
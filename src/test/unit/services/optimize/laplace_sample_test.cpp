@@ -10,6 +10,7 @@
 #include <test/test-models/good/services/multi_normal.hpp>
 #include <test/unit/services/instrumented_callbacks.hpp>
 #include <test/unit/util.hpp>
+#include <tbb/task_arena.h>
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -205,3 +206,298 @@ TEST_F(ServicesLaplaceSample, consoleOutput) {
   EXPECT_EQ(1, count_matches("Generating draws\niteration: 0\niteration: 1",
                              console_str));
 }
+
+TEST_F(ServicesLaplaceSample, parallelHessianMatchesSerial) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  double log_p;
+  Eigen::VectorXd grad;
+  Eigen::MatrixXd hessian;
+  std::stringstream msgs;
+  stan::services::internal::parallel_finite_diff_hessian<true>(
+      *model, theta_hat, log_p, grad, hessian, msgs);
+
+  auto log_density_fun
+      = [&](const Eigen::Matrix<stan::math::var, -1, 1>& theta) {
+          return model->template log_prob<true, true, stan::math::var>(
+              const_cast<Eigen::Matrix<stan::math::var, -1, 1>&>(theta),
+              &msgs);
+        };
+  double serial_log_p;
+  Eigen::VectorXd serial_grad;
+  Eigen::MatrixXd serial_hessian;
+  stan::math::internal::finite_diff_hessian_auto(
+      log_density_fun, theta_hat, serial_log_p, serial_grad, serial_hessian);
+
+  EXPECT_EQ(serial_log_p, log_p);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(serial_grad(i), grad(i));
+    for (int j = 0; j < 2; ++j)
+      EXPECT_EQ(serial_hessian(i, j), hessian(i, j));
+  }
+}
+
+TEST_F(ServicesLaplaceSample, autodiffHessian) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  int draws = 10;
+  unsigned int seed = 1234;
+  int refresh = 0;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  stan::callbacks::structured_writer dummy_hessian_writer;
+
+  int return_code = stan::services::laplace_sample<true>(
+      *model, theta_hat, draws, true, seed, refresh, interrupt, logger,
+      sample_writer, dummy_hessian_writer, true);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+
+  std::stringstream out;
+  stan::io::stan_csv draws_csv
+      = stan::io::stan_csv_reader::parse(sample_ss, &out);
+  Eigen::MatrixXd sample = draws_csv.samples;
+  EXPECT_EQ(draws, sample.rows());
+  // because target is normal, laplace approx is exact
+  for (int m = 0; m < draws; ++m) {
+    EXPECT_FLOAT_EQ(0, sample(m, 0) - sample(m, 1));
+  }
+}
+
+TEST_F(ServicesLaplaceSample, lowRankValues) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  int draws = 50000;
+  unsigned int seed = 1234;
+  int refresh = 0;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  std::stringstream hessian_ss;
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> hessian_writer{
+      std::unique_ptr<std::stringstream, deleter_noop>(&hessian_ss)};
+
+  // a rank 2 approximation of a 2 x 2 Hessian is exact
+  int return_code = stan::services::laplace_sample_low_rank<true>(
+      *model, theta_hat, draws, true, 2, 4, seed, refresh, interrupt, logger,
+      sample_writer, hessian_writer);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+
+  std::string hessian_str = hessian_ss.str();
+  ASSERT_TRUE(stan::test::is_valid_JSON(hessian_str));
+  EXPECT_EQ(1, count_matches("lp_mode", hessian_str));
+  EXPECT_EQ(1, count_matches("neg_hessian_diagonal", hessian_str));
+  EXPECT_EQ(1, count_matches("neg_hessian_eigenvalues", hessian_str));
+  EXPECT_EQ(1, count_matches("neg_hessian_eigenvectors", hessian_str));
+  EXPECT_EQ(0, count_matches("\"Hessian\"", hessian_str));
+
+  std::stringstream out;
+  stan::io::stan_csv draws_csv
+      = stan::io::stan_csv_reader::parse(sample_ss, &out);
+  Eigen::MatrixXd sample = draws_csv.samples;
+  ASSERT_EQ(draws, sample.rows());
+  Eigen::VectorXd y1 = sample.col(2);
+  Eigen::VectorXd y2 = sample.col(3);
+  for (int m = 0; m < draws; ++m) {
+    EXPECT_NEAR(0, sample(m, 0) - sample(m, 1), 1e-4);
+  }
+  EXPECT_NEAR(2, stan::math::mean(y1), 0.05);
+  EXPECT_NEAR(3, stan::math::mean(y2), 0.05);
+  double sum1 = 0;
+  double sum2 = 0;
+  double sum12 = 0;
+  for (int m = 0; m < draws; ++m) {
+    sum1 += std::pow(y1(m) - 2, 2);
+    sum2 += std::pow(y2(m) - 3, 2);
+    sum12 += (y1(m) - 2) * (y2(m) - 3);
+  }
+  EXPECT_NEAR(1, sum1 / draws, 0.05);
+  EXPECT_NEAR(1, sum2 / draws, 0.05);
+  EXPECT_NEAR(0.8, sum12 / draws, 0.05);
+}
+
+TEST_F(ServicesLaplaceSample, lowRankArgumentErrors) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  unsigned int seed = 1234;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  stan::callbacks::structured_writer dummy_hessian_writer;
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::laplace_sample_low_rank<true>(
+                *model, theta_hat, 10, true, -1, 4, seed, 0, interrupt,
+                logger, sample_writer, dummy_hessian_writer));
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::laplace_sample_low_rank<true>(
+                *model, theta_hat, 10, true, 1, 0, seed, 0, interrupt, logger,
+                sample_writer, dummy_hessian_writer));
+}
+
+TEST_F(ServicesLaplaceSample, lbfgsValues) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  int draws = 50000;
+  unsigned int seed = 1234;
+  int refresh = 0;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  std::stringstream hessian_ss;
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> hessian_writer{
+      std::unique_ptr<std::stringstream, deleter_noop>(&hessian_ss)};
+
+  // Updates along conjugate directions of the quadratic negative log
+  // density determine its inverse Hessian exactly
+  Eigen::MatrixXd Sigma(2, 2);
+  Sigma << 1, 0.8, 0.8, 1;
+  Eigen::MatrixXd s_history(2, 2);
+  s_history << 1, 0.8, 0, 1;
+  Eigen::MatrixXd y_history = Sigma.inverse() * s_history;
+  int return_code = stan::services::laplace_sample_lbfgs<true>(
+      *model, theta_hat, y_history, s_history, draws, true, seed, refresh,
+      interrupt, logger, sample_writer, hessian_writer);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+
+  std::string hessian_str = hessian_ss.str();
+  ASSERT_TRUE(stan::test::is_valid_JSON(hessian_str));
+  EXPECT_EQ(1, count_matches("inv_hessian_initial_diagonal", hessian_str));
+  EXPECT_EQ(1, count_matches("log_det_cholesky_inv_hessian", hessian_str));
+  EXPECT_EQ(0, count_matches("\"Hessian\"", hessian_str));
+
+  std::stringstream out;
+  stan::io::stan_csv draws_csv
+      = stan::io::stan_csv_reader::parse(sample_ss, &out);
+  Eigen::MatrixXd sample = draws_csv.samples;
+  ASSERT_EQ(draws, sample.rows());
+  Eigen::VectorXd y1 = sample.col(2);
+  Eigen::VectorXd y2 = sample.col(3);
+  for (int m = 0; m < draws; ++m) {
+    EXPECT_NEAR(0, sample(m, 0) - sample(m, 1), 1e-6);
+  }
+  EXPECT_NEAR(2, stan::math::mean(y1), 0.05);
+  EXPECT_NEAR(3, stan::math::mean(y2), 0.05);
+  double sum1 = 0;
+  double sum2 = 0;
+  double sum12 = 0;
+  for (int m = 0; m < draws; ++m) {
+    sum1 += std::pow(y1(m) - 2, 2);
+    sum2 += std::pow(y2(m) - 3, 2);
+    sum12 += (y1(m) - 2) * (y2(m) - 3);
+  }
+  EXPECT_NEAR(1, sum1 / draws, 0.05);
+  EXPECT_NEAR(1, sum2 / draws, 0.05);
+  EXPECT_NEAR(0.8, sum12 / draws, 0.05);
+}
+
+TEST_F(ServicesLaplaceSample, lbfgsPoorApproximationWarns) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  stan::callbacks::structured_writer dummy_hessian_writer;
+  // A single update along the first axis, with a curvature far too high,
+  // gives an approximation much narrower than the target
+  Eigen::MatrixXd s_history(2, 1);
+  s_history << 1, 0;
+  Eigen::MatrixXd y_history(2, 1);
+  y_history << 100, 0;
+  int return_code = stan::services::laplace_sample_lbfgs<true>(
+      *model, theta_hat, y_history, s_history, 4000, true, 1234, 0,
+      interrupt, logger, sample_writer, dummy_hessian_writer);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+  EXPECT_EQ(1, count_matches("Pareto k", msgs.str()));
+}
+
+TEST_F(ServicesLaplaceSample, lbfgsHistoryErrors) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  stan::callbacks::structured_writer dummy_hessian_writer;
+  Eigen::MatrixXd wrong_rows = Eigen::MatrixXd::Identity(3, 1);
+  Eigen::MatrixXd empty(2, 0);
+  Eigen::MatrixXd s_history = Eigen::MatrixXd::Identity(2, 1);
+  Eigen::MatrixXd negative_curvature = -s_history;
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::laplace_sample_lbfgs<true>(
+                *model, theta_hat, wrong_rows, wrong_rows, 10, true, 1234, 0,
+                interrupt, logger, sample_writer, dummy_hessian_writer));
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::laplace_sample_lbfgs<true>(
+                *model, theta_hat, empty, empty, 10, true, 1234, 0, interrupt,
+                logger, sample_writer, dummy_hessian_writer));
+  EXPECT_EQ(stan::services::error_codes::CONFIG,
+            stan::services::laplace_sample_lbfgs<true>(
+                *model, theta_hat, negative_curvature, s_history, 10, true,
+                1234, 0, interrupt, logger, sample_writer,
+                dummy_hessian_writer));
+}
+
+TEST_F(ServicesLaplaceSample, drawsIndependentOfThreads) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  int draws = 300;  // several chunks of draws
+  unsigned int seed = 1234;
+  stan::callbacks::structured_writer dummy_hessian_writer;
+
+  std::stringstream serial_ss;
+  stan::callbacks::stream_writer serial_writer(serial_ss, "");
+  tbb::task_arena serial_arena(1);
+  serial_arena.execute([&] {
+    stan::services::laplace_sample<true>(*model, theta_hat, draws, true, seed,
+                                         0, interrupt, logger, serial_writer,
+                                         dummy_hessian_writer);
+  });
+
+  std::stringstream parallel_ss;
+  stan::callbacks::stream_writer parallel_writer(parallel_ss, "");
+  int return_code = stan::services::laplace_sample<true>(
+      *model, theta_hat, draws, true, seed, 0, interrupt, logger,
+      parallel_writer, dummy_hessian_writer);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+  EXPECT_EQ(serial_ss.str(), parallel_ss.str());
+  EXPECT_EQ(draws + 1, count_matches("\n", parallel_ss.str()));
+}
+
+TEST_F(ServicesLaplaceSample, sparseValues) {
+  Eigen::VectorXd theta_hat(2);
+  theta_hat << 2, 3;
+  int draws = 50000;
+  unsigned int seed = 1234;
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  std::stringstream hessian_ss;
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> hessian_writer{
+      std::unique_ptr<std::stringstream, deleter_noop>(&hessian_ss)};
+  int return_code = stan::services::laplace_sample_sparse<true>(
+      *model, theta_hat, draws, true, seed, 0, interrupt, logger,
+      sample_writer, hessian_writer);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+
+  std::string hessian_str = hessian_ss.str();
+  ASSERT_TRUE(stan::test::is_valid_JSON(hessian_str));
+  EXPECT_EQ(1, count_matches("lp_mode", hessian_str));
+  EXPECT_EQ(1, count_matches("hessian_rows", hessian_str));
+  EXPECT_EQ(1, count_matches("hessian_values", hessian_str));
+
+  std::stringstream out;
+  stan::io::stan_csv draws_csv
+      = stan::io::stan_csv_reader::parse(sample_ss, &out);
+  Eigen::MatrixXd sample = draws_csv.samples;
+  ASSERT_EQ(draws, sample.rows());
+  Eigen::VectorXd y1 = sample.col(2);
+  Eigen::VectorXd y2 = sample.col(3);
+  for (int m = 0; m < draws; ++m) {
+    EXPECT_NEAR(0, sample(m, 0) - sample(m, 1), 1e-6);
+  }
+  EXPECT_NEAR(2, stan::math::mean(y1), 0.05);
+  EXPECT_NEAR(3, stan::math::mean(y2), 0.05);
+  double sum1 = 0;
+  double sum2 = 0;
+  double sum12 = 0;
+  for (int m = 0; m < draws; ++m) {
+    sum1 += std::pow(y1(m) - 2, 2);
+    sum2 += std::pow(y2(m) - 3, 2);
+    sum12 += (y1(m) - 2) * (y2(m) - 3);
+  }
+  EXPECT_NEAR(1, sum1 / draws, 0.05);
+  EXPECT_NEAR(1, sum2 / draws, 0.05);
+  EXPECT_NEAR(0.8, sum12 / draws, 0.05);
+}
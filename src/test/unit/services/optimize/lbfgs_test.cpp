@@ -3,7 +3,15 @@
 #include <stan/io/empty_var_context.hpp>
 #include <test/test-models/good/optimization/rosenbrock.hpp>
 #include <test/unit/services/instrumented_callbacks.hpp>
+#include <stan/callbacks/json_writer.hpp>
 #include <stan/callbacks/stream_writer.hpp>
+#include <memory>
+#include <vector>
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
 
 struct ServicesOptimize : public testing::Test {
   ServicesOptimize()
@@ -57,3 +65,96 @@ TEST_F(ServicesOptimize, rosenbrock) {
   EXPECT_FLOAT_EQ(return_code, 0);
   EXPECT_EQ(22, interrupt.call_count());
 }
+
+TEST_F(ServicesOptimize, rosenbrock_iteration_record) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::stringstream record_ss;
+  std::unique_ptr<std::stringstream, deleter_noop> record_stream(&record_ss);
+  stan::callbacks::json_writer<std::stringstream, deleter_noop> record(
+      std::move(record_stream));
+
+  int return_code = stan::services::optimize::lbfgs(
+      model, context, 0, 1, 0, 5, 0.001, 1e-12, 10000, 1e-8, 10000000, 1e-8,
+      2000, false, 0, interrupt, logger, init, parameter, record);
+
+  EXPECT_EQ(0, return_code);
+  std::string json = record_ss.str();
+  EXPECT_NE(std::string::npos, json.find("\"algorithm\" : \"lbfgs\""));
+  EXPECT_NE(std::string::npos, json.find("\"1\" : {"));
+  EXPECT_NE(std::string::npos, json.find("\"22\" : {"));
+  EXPECT_EQ(std::string::npos, json.find("\"23\" : {"));
+  EXPECT_NE(std::string::npos, json.find("\"line_search_trials\""));
+  EXPECT_NE(std::string::npos, json.find("\"model_time\""));
+  EXPECT_NE(std::string::npos, json.find("\"return_code\" : 0"));
+}
+
+TEST_F(ServicesOptimize, rosenbrock_multi_start) {
+  const size_t num_starts = 4;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> inits;
+  std::vector<std::stringstream> init_streams(num_starts);
+  std::vector<std::stringstream> parameter_streams(num_starts);
+  std::vector<stan::callbacks::stream_writer> init_writers;
+  std::vector<stan::test::unit::values_writer> parameter_writers;
+  for (size_t i = 0; i < num_starts; ++i) {
+    inits.emplace_back(std::make_shared<stan::io::empty_var_context>());
+    init_writers.emplace_back(init_streams[i]);
+    parameter_writers.emplace_back(parameter_streams[i]);
+  }
+  std::stringstream best_ss;
+  stan::test::unit::values_writer best(best_ss);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int return_code = stan::services::optimize::lbfgs(
+      model, num_starts, inits, 0, 1, 2, 5, 0.001, 1e-12, 10000, 1e-8,
+      10000000, 1e-8, 2000, false, 0, 0, 1e-3, interrupt, logger,
+      init_writers, parameter_writers, best);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(logger.call_count(), logger.call_count_info())
+      << "all output to info";
+  EXPECT_EQ(1, logger.find("Start [1] Initial log joint probability"));
+  EXPECT_EQ(1, logger.find("Start [4] Initial log joint probability"));
+  EXPECT_EQ(1, logger.find("Best mode found by start ["));
+  for (size_t i = 0; i < num_starts; ++i) {
+    ASSERT_EQ(1, parameter_writers[i].states_.size());
+    EXPECT_NEAR(1, parameter_writers[i].states_.back()[1], 1e-3);
+    EXPECT_NEAR(1, parameter_writers[i].states_.back()[2], 1e-3);
+  }
+
+  ASSERT_EQ(3, best.names_.size());
+  EXPECT_EQ("lp__", best.names_[0]);
+  EXPECT_EQ("x", best.names_[1]);
+  EXPECT_EQ("y", best.names_[2]);
+  ASSERT_EQ(1, best.states_.size());
+  EXPECT_NEAR(1, best.states_[0][1], 1e-3);
+  EXPECT_NEAR(1, best.states_[0][2], 1e-3);
+}
+
+TEST_F(ServicesOptimize, rosenbrock_multi_start_agree) {
+  const size_t num_starts = 4;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> inits;
+  std::vector<std::stringstream> init_streams(num_starts);
+  std::vector<std::stringstream> parameter_streams(num_starts);
+  std::vector<stan::callbacks::stream_writer> init_writers;
+  std::vector<stan::test::unit::values_writer> parameter_writers;
+  for (size_t i = 0; i < num_starts; ++i) {
+    inits.emplace_back(std::make_shared<stan::io::empty_var_context>());
+    init_writers.emplace_back(init_streams[i]);
+    parameter_writers.emplace_back(parameter_streams[i]);
+  }
+  std::stringstream best_ss;
+  stan::test::unit::values_writer best(best_ss);
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  // Every start is initialized at (0, 0), so the first converged start
+  // agrees with itself and cancels the starts still running
+  int return_code = stan::services::optimize::lbfgs(
+      model, num_starts, inits, 0, 1, 0, 5, 0.001, 1e-12, 10000, 1e-8,
+      10000000, 1e-8, 2000, false, 0, 1, 1e-3, interrupt, logger,
+      init_writers, parameter_writers, best);
+
+  EXPECT_EQ(0, return_code);
+  ASSERT_EQ(1, best.states_.size());
+  EXPECT_FLOAT_EQ(0.99998301, best.states_[0][1]);
+  EXPECT_FLOAT_EQ(0.99996597, best.states_[0][2]);
+}
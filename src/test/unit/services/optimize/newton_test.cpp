@@ -88,3 +88,49 @@ TEST_F(ServicesOptimize, rosenbrock_no_save_iterations) {
   EXPECT_FLOAT_EQ(return_code, 0);
   EXPECT_LT(0, interrupt.call_count());
 }
+
+TEST_F(ServicesOptimize, rosenbrock_hessian_reuse) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+
+  int num_iterations = 1000;
+  bool save_iterations = false;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  int return_code = stan::services::optimize::newton(
+      model, context, seed, chain, init_radius, num_iterations, save_iterations,
+      interrupt, logger, init, parameter, 3, 0.25);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(1, logger.find("Initial log joint probability = -1"));
+  ASSERT_EQ(1, parameter.states_.size());
+  EXPECT_NEAR(1, parameter.states_.back()[1], 1e-3)
+      << "optimal value should be (1, 1)";
+  EXPECT_NEAR(1, parameter.states_.back()[2], 1e-3)
+      << "optimal value should be (1, 1)";
+}
+
+TEST_F(ServicesOptimize, rosenbrock_sparse_hessian) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+
+  int num_iterations = 1000;
+  bool save_iterations = false;
+  stan::test::unit::instrumented_interrupt interrupt;
+
+  // the Hessian is dense and not negative definite everywhere, so this
+  // also takes the fallback to the eigendecomposition
+  int return_code = stan::services::optimize::newton(
+      model, context, seed, chain, init_radius, num_iterations, save_iterations,
+      interrupt, logger, init, parameter, 0, 0.25, true);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(1, logger.find("Sparse Hessian with 4 nonzeros and 2 colors"));
+  ASSERT_EQ(1, parameter.states_.size());
+  EXPECT_NEAR(1, parameter.states_.back()[1], 1e-3)
+      << "optimal value should be (1, 1)";
+  EXPECT_NEAR(1, parameter.states_.back()[2], 1e-3)
+      << "optimal value should be (1, 1)";
+}
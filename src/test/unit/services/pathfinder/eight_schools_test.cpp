@@ -145,6 +145,196 @@ TEST_F(ServicesPathfinderEightSchools, multi) {
   }
 }
 
+TEST_F(ServicesPathfinderEightSchools, multi_constrain_selected_only) {
+  constexpr unsigned int seed = 0;
+  constexpr unsigned int stride_id = 1;
+  constexpr double init_radius = 1;
+  constexpr size_t num_multi_draws = 10000;
+  constexpr size_t num_paths = 16;
+  constexpr double num_elbo_draws = 1000;
+  constexpr double num_draws = 10000;
+  constexpr int history_size = 10;
+  constexpr double init_alpha = 1;
+  constexpr double tol_obj = 1e-12;
+  constexpr double tol_rel_obj = 1000000;
+  constexpr double tol_grad = 1e-12;
+  constexpr double tol_rel_grad = 10000000;
+  constexpr double tol_param = 1e-12;
+  constexpr int num_iterations = 2000;
+  constexpr int refresh = 0;
+  constexpr bool save_iterations = false;
+  std::unique_ptr<std::ostream> empty_ostream(nullptr);
+  stan::test::test_logger logger(std::move(empty_ostream));
+  std::vector<stan::callbacks::writer> single_path_parameter_writer(num_paths);
+  std::vector<stan::callbacks::json_writer<std::stringstream>>
+      single_path_diagnostic_writer(num_paths);
+  std::vector<std::unique_ptr<decltype(init_init_context())>> single_path_inits;
+  for (int i = 0; i < num_paths; ++i) {
+    single_path_inits.emplace_back(
+        std::make_unique<decltype(init_init_context())>(init_init_context()));
+  }
+  stan::test::mock_callback callback;
+
+  int return_code = stan::services::pathfinder::pathfinder_lbfgs_multi(
+      model, single_path_inits, seed, stride_id, init_radius, history_size,
+      init_alpha, tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+      num_iterations, num_elbo_draws, num_draws, num_multi_draws, num_paths,
+      save_iterations, refresh, callback, logger,
+      std::vector<stan::callbacks::stream_writer>(num_paths, init),
+      single_path_parameter_writer, single_path_diagnostic_writer, parameter,
+      diagnostics, true, true, 1.0, true);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+  ASSERT_EQ(num_multi_draws, parameter.eigen_states_.size());
+
+  Eigen::MatrixXd param_vals(parameter.eigen_states_.size(),
+                             parameter.eigen_states_[0].size());
+  for (size_t i = 0; i < parameter.eigen_states_.size(); ++i) {
+    param_vals.row(i) = parameter.eigen_states_[i];
+  }
+  ASSERT_EQ(20, param_vals.cols());
+  Eigen::RowVectorXd mean_vals = param_vals.colwise().mean();
+  Eigen::RowVectorXd r_mean_vals(20);
+  r_mean_vals << -17.9537, -47.016, 1.89104, 3.66449, 0.22256, 0.119645,
+      -0.146812, 0.23633, -0.244868, -0.227134, 0.504507, 0.0476979, 3.66491,
+      2.57979, 1.21644, 2.81399, 1.53776, 1.39865, 3.99508, 2.41488;
+  for (Eigen::Index i = 0; i < mean_vals.size(); i++) {
+    EXPECT_NEAR(r_mean_vals(i), mean_vals(i), 1);
+  }
+}
+
+TEST(ServicesPathfinderElboLeader, trails) {
+  stan::services::pathfinder::internal::elbo_leader leader(3, 1.0);
+  leader.update(-10);
+  leader.update(-20);
+  EXPECT_FALSE(leader.trails(5, -10));
+  EXPECT_FALSE(leader.trails(5, -10.5));
+  EXPECT_TRUE(leader.trails(5, -12));
+  // Not before the minimum number of iterations
+  EXPECT_FALSE(leader.trails(2, -12));
+  stan::services::pathfinder::internal::elbo_leader never(
+      0, std::numeric_limits<double>::infinity());
+  never.update(0);
+  EXPECT_FALSE(never.trails(100, -1e300));
+}
+
+TEST_F(ServicesPathfinderEightSchools, multi_abandon_paths) {
+  constexpr unsigned int seed = 0;
+  constexpr unsigned int stride_id = 1;
+  constexpr double init_radius = 1;
+  constexpr size_t num_multi_draws = 10000;
+  constexpr size_t num_paths = 16;
+  constexpr double num_elbo_draws = 1000;
+  constexpr double num_draws = 10000;
+  constexpr int history_size = 10;
+  constexpr double init_alpha = 1;
+  constexpr double tol_obj = 1e-12;
+  constexpr double tol_rel_obj = 1000000;
+  constexpr double tol_grad = 1e-12;
+  constexpr double tol_rel_grad = 10000000;
+  constexpr double tol_param = 1e-12;
+  constexpr int num_iterations = 2000;
+  constexpr int refresh = 0;
+  constexpr bool save_iterations = false;
+  std::unique_ptr<std::ostream> empty_ostream(nullptr);
+  stan::test::test_logger logger(std::move(empty_ostream));
+  std::vector<stan::callbacks::writer> single_path_parameter_writer(num_paths);
+  std::vector<stan::callbacks::json_writer<std::stringstream>>
+      single_path_diagnostic_writer(num_paths);
+  std::vector<std::unique_ptr<decltype(init_init_context())>> single_path_inits;
+  for (int i = 0; i < num_paths; ++i) {
+    single_path_inits.emplace_back(
+        std::make_unique<decltype(init_init_context())>(init_init_context()));
+  }
+  stan::test::mock_callback callback;
+
+  // A margin of 10 after 5 iterations leaves out the worst paths only
+  int return_code = stan::services::pathfinder::pathfinder_lbfgs_multi(
+      model, single_path_inits, seed, stride_id, init_radius, history_size,
+      init_alpha, tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+      num_iterations, num_elbo_draws, num_draws, num_multi_draws, num_paths,
+      save_iterations, refresh, callback, logger,
+      std::vector<stan::callbacks::stream_writer>(num_paths, init),
+      single_path_parameter_writer, single_path_diagnostic_writer, parameter,
+      diagnostics, true, true, 1.0, false, 10.0, 5);
+  EXPECT_EQ(stan::services::error_codes::OK, return_code);
+  ASSERT_EQ(num_multi_draws, parameter.eigen_states_.size());
+
+  Eigen::MatrixXd param_vals(parameter.eigen_states_.size(),
+                             parameter.eigen_states_[0].size());
+  for (size_t i = 0; i < parameter.eigen_states_.size(); ++i) {
+    param_vals.row(i) = parameter.eigen_states_[i];
+  }
+  ASSERT_EQ(20, param_vals.cols());
+  Eigen::RowVectorXd mean_vals = param_vals.colwise().mean();
+  Eigen::RowVectorXd r_mean_vals(20);
+  r_mean_vals << -17.9537, -47.016, 1.89104, 3.66449, 0.22256, 0.119645,
+      -0.146812, 0.23633, -0.244868, -0.227134, 0.504507, 0.0476979, 3.66491,
+      2.57979, 1.21644, 2.81399, 1.53776, 1.39865, 3.99508, 2.41488;
+  for (Eigen::Index i = 2; i < mean_vals.size(); i++) {
+    EXPECT_NEAR(r_mean_vals(i), mean_vals(i), 1);
+  }
+}
+
+TEST_F(ServicesPathfinderEightSchools, multi_stream_paths) {
+  constexpr unsigned int seed = 0;
+  constexpr unsigned int stride_id = 1;
+  constexpr double init_radius = 1;
+  constexpr size_t num_multi_draws = 1000;
+  constexpr size_t num_paths = 8;
+  constexpr double num_elbo_draws = 100;
+  constexpr double num_draws = 1000;
+  constexpr int history_size = 10;
+  constexpr double init_alpha = 1;
+  constexpr double tol_obj = 1e-12;
+  constexpr double tol_rel_obj = 1000000;
+  constexpr double tol_grad = 1e-12;
+  constexpr double tol_rel_grad = 10000000;
+  constexpr double tol_param = 1e-12;
+  constexpr int num_iterations = 2000;
+  constexpr int refresh = 0;
+  constexpr bool save_iterations = false;
+  std::unique_ptr<std::ostream> empty_ostream(nullptr);
+  stan::test::test_logger logger(std::move(empty_ostream));
+  std::vector<stan::callbacks::writer> single_path_parameter_writer(num_paths);
+  std::vector<stan::callbacks::json_writer<std::stringstream>>
+      single_path_diagnostic_writer(num_paths);
+  std::vector<std::unique_ptr<decltype(init_init_context())>> single_path_inits;
+  for (int i = 0; i < num_paths; ++i) {
+    single_path_inits.emplace_back(
+        std::make_unique<decltype(init_init_context())>(init_init_context()));
+  }
+  stan::test::mock_callback callback;
+
+  int return_code = stan::services::pathfinder::pathfinder_lbfgs_multi(
+      model, single_path_inits, seed, stride_id, init_radius, history_size,
+      init_alpha, tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+      num_iterations, num_elbo_draws, num_draws, num_multi_draws, num_paths,
+      save_iterations, refresh, callback, logger,
+      std::vector<stan::callbacks::stream_writer>(num_paths, init),
+      single_path_parameter_writer, single_path_diagnostic_writer, parameter,
+      diagnostics);
+  ASSERT_EQ(stan::services::error_codes::OK, return_code);
+
+  // The resampled draws read back from the temporary file are the same
+  std::stringstream streamed_ss;
+  stan::test::in_memory_writer streamed(streamed_ss);
+  return_code = stan::services::pathfinder::pathfinder_lbfgs_multi(
+      model, single_path_inits, seed, stride_id, init_radius, history_size,
+      init_alpha, tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+      num_iterations, num_elbo_draws, num_draws, num_multi_draws, num_paths,
+      save_iterations, refresh, callback, logger,
+      std::vector<stan::callbacks::stream_writer>(num_paths, init),
+      single_path_parameter_writer, single_path_diagnostic_writer, streamed,
+      diagnostics, true, true, 1.0, false,
+      std::numeric_limits<double>::infinity(), 0, true);
+  ASSERT_EQ(stan::services::error_codes::OK, return_code);
+  EXPECT_EQ(parameter.names_, streamed.names_);
+  ASSERT_EQ(num_multi_draws, streamed.eigen_states_.size());
+  for (size_t i = 0; i < num_multi_draws; ++i) {
+    EXPECT_TRUE(parameter.eigen_states_[i] == streamed.eigen_states_[i]);
+  }
+}
+
 TEST_F(ServicesPathfinderEightSchools, single) {
   constexpr unsigned int seed = 0;
   constexpr unsigned int stride_id = 1;
@@ -277,3 +467,79 @@ TEST_F(ServicesPathfinderEightSchools, single) {
     EXPECT_NEAR(0, all_sd_vals(2, i), 100);
   }
 }
+
+TEST_F(ServicesPathfinderEightSchools, single_elbo_spacing) {
+  constexpr unsigned int seed = 0;
+  constexpr unsigned int stride_id = 1;
+  constexpr double init_radius = 1;
+  constexpr double num_elbo_draws = 80;
+  constexpr double num_draws = 1000;
+  constexpr int history_size = 10;
+  constexpr double init_alpha = 1;
+  constexpr double tol_obj = 1e-12;
+  constexpr double tol_rel_obj = 1000000;
+  constexpr double tol_grad = 1e-12;
+  constexpr double tol_rel_grad = 10000000;
+  constexpr double tol_param = 1e-12;
+  constexpr int num_iterations = 2000;
+  constexpr bool save_iterations = false;
+  constexpr int refresh = 0;
+  std::unique_ptr<std::ostream> empty_ostream(nullptr);
+  stan::test::test_logger logger(std::move(empty_ostream));
+  stan::test::mock_callback callback;
+  auto every_ret = stan::services::pathfinder::pathfinder_lbfgs_single<true>(
+      model, context, seed, stride_id, init_radius, history_size, init_alpha,
+      tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param, num_iterations,
+      num_elbo_draws, num_draws, save_iterations, refresh, callback, logger,
+      init, parameter, diagnostics);
+  auto spaced_ret = stan::services::pathfinder::pathfinder_lbfgs_single<true>(
+      model, context, seed, stride_id, init_radius, history_size, init_alpha,
+      tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param, num_iterations,
+      num_elbo_draws, num_draws, save_iterations, refresh, callback, logger,
+      init, parameter, diagnostics, true, 2.0);
+
+  EXPECT_EQ(stan::services::error_codes::OK, std::get<0>(every_ret));
+  EXPECT_EQ(stan::services::error_codes::OK, std::get<0>(spaced_ret));
+  EXPECT_EQ(num_draws, std::get<2>(spaced_ret).cols());
+  EXPECT_LT(std::get<3>(spaced_ret), std::get<3>(every_ret));
+}
+
+TEST_F(ServicesPathfinderEightSchools, single_min_elbo_draws) {
+  constexpr unsigned int seed = 0;
+  constexpr unsigned int stride_id = 1;
+  constexpr double init_radius = 1;
+  constexpr double num_elbo_draws = 400;
+  constexpr double num_draws = 1000;
+  constexpr int history_size = 10;
+  constexpr double init_alpha = 1;
+  constexpr double tol_obj = 1e-12;
+  constexpr double tol_rel_obj = 1000000;
+  constexpr double tol_grad = 1e-12;
+  constexpr double tol_rel_grad = 10000000;
+  constexpr double tol_param = 1e-12;
+  constexpr int num_iterations = 2000;
+  constexpr bool save_iterations = false;
+  constexpr int refresh = 0;
+  std::unique_ptr<std::ostream> empty_ostream(nullptr);
+  stan::test::test_logger logger(std::move(empty_ostream));
+  stan::test::mock_callback callback;
+  auto fixed_ret = stan::services::pathfinder::pathfinder_lbfgs_single<true>(
+      model, context, seed, stride_id, init_radius, history_size, init_alpha,
+      tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param, num_iterations,
+      num_elbo_draws, num_draws, save_iterations, refresh, callback, logger,
+      init, parameter, diagnostics);
+  auto adaptive_ret
+      = stan::services::pathfinder::pathfinder_lbfgs_single<true>(
+          model, context, seed, stride_id, init_radius, history_size,
+          init_alpha, tol_obj, tol_rel_obj, tol_grad, tol_rel_grad, tol_param,
+          num_iterations, num_elbo_draws, num_draws, save_iterations, refresh,
+          callback, logger, init, parameter, diagnostics, true, 1.0, true,
+          nullptr, 25);
+
+  EXPECT_EQ(stan::services::error_codes::OK, std::get<0>(fixed_ret));
+  EXPECT_EQ(stan::services::error_codes::OK, std::get<0>(adaptive_ret));
+  EXPECT_LT(std::get<3>(adaptive_ret), std::get<3>(fixed_ret));
+  // The same iteration is selected, from the same random draws
+  ASSERT_EQ(num_draws, std::get<2>(adaptive_ret).cols());
+  EXPECT_TRUE(std::get<2>(fixed_ret) == std::get<2>(adaptive_ret));
+}
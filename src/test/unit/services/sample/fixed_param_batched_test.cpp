@@ -0,0 +1,73 @@
+#include <stan/services/sample/fixed_param.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <iostream>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+class ServicesSamplesFixedParamBatched : public testing::Test {
+ public:
+  ServicesSamplesFixedParamBatched() : model(context, 0, &model_log) {}
+
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_writer init, parameter, diagnostic;
+  stan::io::empty_var_context context;
+  stan_model model;
+};
+
+TEST_F(ServicesSamplesFixedParamBatched, matches_serial) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_iterations = 100;
+  int refresh = 0;
+
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::test::unit::instrumented_logger serial_logger;
+  stan::test::unit::instrumented_writer serial_init, serial_parameter,
+      serial_diagnostic;
+  stan::services::sample::fixed_param(
+      model, context, seed, chain, init_radius, num_iterations, 3, refresh,
+      interrupt, serial_logger, serial_init, serial_parameter,
+      serial_diagnostic);
+
+  stan::test::unit::instrumented_interrupt batched_interrupt;
+  int return_code = stan::services::sample::fixed_param_batched(
+      model, context, seed, chain, init_radius, num_iterations, 3, refresh, 8,
+      batched_interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+
+  // The model draws no random numbers, so the output is the same
+  EXPECT_EQ(num_iterations, batched_interrupt.call_count());
+  EXPECT_EQ(serial_parameter.vector_string_values(),
+            parameter.vector_string_values());
+  EXPECT_EQ(serial_parameter.vector_double_values(),
+            parameter.vector_double_values());
+  EXPECT_EQ(serial_diagnostic.vector_double_values(),
+            diagnostic.vector_double_values());
+  EXPECT_EQ(34, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, logger.find_info("seconds (Sampling)"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSamplesFixedParamBatched, refresh) {
+  unsigned int seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_iterations = 10;
+  int refresh = 5;
+
+  stan::test::unit::instrumented_interrupt interrupt;
+  int return_code = stan::services::sample::fixed_param_batched(
+      model, context, seed, chain, init_radius, num_iterations, 1, refresh, 3,
+      interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(num_iterations, interrupt.call_count());
+  EXPECT_EQ(num_iterations, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, logger.find_info("Iteration:  1 / 10"));
+  EXPECT_EQ(1, logger.find_info("Iteration:  5 / 10"));
+  EXPECT_EQ(1, logger.find_info("Iteration: 10 / 10"));
+}
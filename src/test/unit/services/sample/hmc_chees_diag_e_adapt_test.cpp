@@ -0,0 +1,72 @@
+#include <stan/services/sample/hmc_chees_diag_e_adapt.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <memory>
+
+static constexpr size_t num_chains = 32;
+static constexpr size_t num_superchains = 4;
+
+class ServicesSampleHmcCheesDiagEAdapt : public testing::Test {
+ public:
+  ServicesSampleHmcCheesDiagEAdapt()
+      : model(data_context, 0, &model_log), metric(num_chains) {
+    for (int i = 0; i < num_chains; ++i) {
+      init.push_back(stan::test::unit::instrumented_writer{});
+      parameter.push_back(stan::test::unit::instrumented_writer{});
+      diagnostic.push_back(stan::test::unit::instrumented_writer{});
+    }
+    for (int i = 0; i < num_superchains; ++i)
+      context.push_back(std::make_shared<stan::io::empty_var_context>());
+  }
+
+  int run(size_t superchains, int num_warmup, int num_samples) {
+    return stan::services::sample::hmc_chees_diag_e_adapt(
+        model, num_chains, superchains, context, 0, 1, 2, num_warmup,
+        num_samples, 1, true, 0, 0.1, 100, 0.8, 0.05, 0.75, 10, 0.025,
+        interrupt, logger, init, parameter, diagnostic, metric);
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::vector<stan::test::unit::instrumented_writer> init;
+  std::vector<stan::test::unit::instrumented_writer> parameter;
+  std::vector<stan::test::unit::instrumented_writer> diagnostic;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> context;
+  stan_model model;
+  std::vector<stan::callbacks::structured_writer> metric;
+};
+
+TEST_F(ServicesSampleHmcCheesDiagEAdapt, call_count) {
+  int num_warmup = 100;
+  int num_samples = 5;
+  EXPECT_EQ(0, run(num_superchains, num_warmup, num_samples));
+
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+  std::vector<std::string> names = parameter[0].vector_string_values()[0];
+  ASSERT_EQ(8, names.size());
+  EXPECT_EQ("int_time__", names[3]);
+  EXPECT_EQ("n_leapfrog__", names[4]);
+  const std::vector<double>& last = parameter[0].vector_double_values().back();
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_EQ(num_warmup + num_samples,
+              parameter[i].call_count("vector_double"));
+    // Every chain shares the step size and integration time
+    EXPECT_FLOAT_EQ(last[2], parameter[i].vector_double_values().back()[2]);
+    EXPECT_FLOAT_EQ(last[3], parameter[i].vector_double_values().back()[3]);
+    // The chains of a superchain start from the same initial value
+    EXPECT_EQ(init[i - i % 8].vector_double_values()[0],
+              init[i].vector_double_values()[0]);
+  }
+  EXPECT_EQ(1, logger.find("Largest nested R-hat"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleHmcCheesDiagEAdapt, bad_superchains) {
+  EXPECT_EQ(stan::services::error_codes::CONFIG, run(3, 10, 1));
+  EXPECT_EQ(stan::services::error_codes::CONFIG, run(1, 10, 1));
+  EXPECT_EQ(0, interrupt.call_count());
+}
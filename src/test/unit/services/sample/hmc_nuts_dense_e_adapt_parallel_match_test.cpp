@@ -68,7 +68,8 @@ class ServicesSampleHmcNutsDenseEAdaptParMatch : public testing::Test {
  * This test checks that running multiple chains in one call
  * with the same initial id is the same as running multiple calls
  * with incrementing chain ids.
- * It also checks that the metric can be saved as json.
+ * It also checks that the metric can be saved as json, in which case it
+ * is not also written to the draws.
  */
 TEST_F(ServicesSampleHmcNutsDenseEAdaptParMatch, single_multi_match) {
   constexpr unsigned int random_seed = 0;
@@ -116,7 +117,9 @@ TEST_F(ServicesSampleHmcNutsDenseEAdaptParMatch, single_multi_match) {
   std::vector<std::string> par_metrics;
   for (int i = 0; i < num_chains; ++i) {
     auto par_str = par_parameters[i].get_stream().str();
-    auto sub_par_str = par_str.substr(par_str.find("Elements") - 1);
+    // the metric is only in the metric output
+    EXPECT_EQ(std::string::npos, par_str.find("Elements"));
+    auto sub_par_str = par_str.substr(par_str.find("Step size") - 2);
     std::istringstream sub_par_stream(sub_par_str);
     Eigen::MatrixXd par_mat
         = stan::test::read_stan_sample_csv(sub_par_stream, 80, 9);
@@ -134,7 +137,7 @@ TEST_F(ServicesSampleHmcNutsDenseEAdaptParMatch, single_multi_match) {
   std::vector<std::string> seq_metrics;
   for (int i = 0; i < num_chains; ++i) {
     auto seq_str = seq_parameters[i].get_stream().str();
-    auto sub_seq_str = seq_str.substr(seq_str.find("Elements") - 1);
+    auto sub_seq_str = seq_str.substr(seq_str.find("Step size") - 2);
     std::istringstream sub_seq_stream(sub_seq_str);
     Eigen::MatrixXd seq_mat
         = stan::test::read_stan_sample_csv(sub_seq_stream, 80, 9);
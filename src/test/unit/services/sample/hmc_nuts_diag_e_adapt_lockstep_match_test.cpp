@@ -0,0 +1,165 @@
+#include <stan/services/sample/hmc_nuts_diag_e_adapt.hpp>
+#include <stan/services/sample/hmc_nuts_diag_e_adapt_lockstep.hpp>
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/callbacks/unique_stream_writer.hpp>
+#include <stan/callbacks/structured_writer.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <src/test/unit/services/util.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <test/unit/util.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+static constexpr size_t num_chains = 4;
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+class ServicesSampleHmcNutsDiagEAdaptLockstepMatch : public testing::Test {
+ public:
+  ServicesSampleHmcNutsDiagEAdaptLockstepMatch()
+      : ss_par(num_chains),
+        ss_lock(num_chains),
+        ss_metric(num_chains),
+        ss_lock_metric(num_chains),
+        model(std::make_unique<rosenbrock_model_namespace::rosenbrock_model>(
+            data_context, 0, &model_log)) {
+    for (int i = 0; i < num_chains; ++i) {
+      init.push_back(stan::test::unit::instrumented_writer{});
+      par_parameters.emplace_back(
+          std::unique_ptr<std::stringstream, deleter_noop>(&ss_par[i]), "#");
+      lock_parameters.emplace_back(
+          std::unique_ptr<std::stringstream, deleter_noop>(&ss_lock[i]), "#");
+      metrics.emplace_back(
+          stan::callbacks::json_writer<std::stringstream, deleter_noop>(
+              std::unique_ptr<std::stringstream, deleter_noop>(&ss_metric[i])));
+      lock_metrics.emplace_back(
+          stan::callbacks::json_writer<std::stringstream, deleter_noop>(
+              std::unique_ptr<std::stringstream, deleter_noop>(
+                  &ss_lock_metric[i])));
+      lock_init.push_back(stan::test::unit::instrumented_writer{});
+      lock_diagnostics.push_back(stan::test::unit::instrumented_writer{});
+      inv_metric.emplace_back(std::make_shared<stan::io::array_var_context>(
+          stan::services::util::create_unit_e_diag_inv_metric(2)));
+      diagnostics.push_back(stan::test::unit::instrumented_writer{});
+      context.push_back(std::make_shared<stan::io::empty_var_context>());
+    }
+  }
+
+  void SetUp() {
+    for (int i = 0; i < num_chains; ++i) {
+      ss_metric[i].str(std::string());
+      ss_metric[i].clear();
+      ss_lock_metric[i].str(std::string());
+      ss_lock_metric[i].clear();
+    }
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  std::vector<stan::test::unit::instrumented_writer> init;
+  std::vector<std::stringstream> ss_par;
+  std::vector<std::stringstream> ss_lock;
+  std::vector<std::stringstream> ss_metric;
+  std::vector<std::stringstream> ss_lock_metric;
+  using str_writer
+      = stan::callbacks::unique_stream_writer<std::stringstream, deleter_noop>;
+  std::vector<str_writer> par_parameters;
+  std::vector<str_writer> lock_parameters;
+  std::vector<stan::callbacks::json_writer<std::stringstream, deleter_noop>>
+      metrics;
+  std::vector<stan::callbacks::json_writer<std::stringstream, deleter_noop>>
+      lock_metrics;
+  std::vector<stan::test::unit::instrumented_writer> diagnostics;
+  std::vector<stan::test::unit::instrumented_writer> lock_init;
+  std::vector<stan::test::unit::instrumented_writer> lock_diagnostics;
+  std::vector<std::shared_ptr<stan::io::array_var_context>> inv_metric;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> context;
+  std::unique_ptr<rosenbrock_model_namespace::rosenbrock_model> model;
+};
+
+/**
+ * This test checks that running the chains in lockstep with batched
+ * gradients gives the same draws and adapted parameters as running
+ * them in parallel.
+ */
+TEST_F(ServicesSampleHmcNutsDiagEAdaptLockstepMatch, parallel_lockstep_match) {
+  constexpr unsigned int random_seed = 0;
+  constexpr unsigned int chain = 0;
+  constexpr double init_radius = 0;
+  constexpr int num_warmup = 200;
+  constexpr int num_samples = 400;
+  constexpr int num_thin = 5;
+  constexpr bool save_warmup = true;
+  constexpr int refresh = 0;
+  constexpr double stepsize = 0.1;
+  constexpr double stepsize_jitter = 0;
+  constexpr int max_depth = 8;
+  constexpr double delta = .1;
+  constexpr double gamma = .1;
+  constexpr double kappa = .1;
+  constexpr double t0 = .1;
+  constexpr unsigned int init_buffer = 50;
+  constexpr unsigned int term_buffer = 50;
+  constexpr unsigned int window = 100;
+  stan::test::unit::instrumented_interrupt interrupt;
+  EXPECT_EQ(interrupt.call_count(), 0);
+
+  int return_code = stan::services::sample::hmc_nuts_diag_e_adapt(
+      *model, num_chains, context, random_seed, chain, init_radius, num_warmup,
+      num_samples, num_thin, save_warmup, refresh, stepsize, stepsize_jitter,
+      max_depth, delta, gamma, kappa, t0, init_buffer, term_buffer, window,
+      interrupt, logger, init, par_parameters, diagnostics, metrics);
+  EXPECT_EQ(0, return_code);
+
+  stan::test::unit::instrumented_interrupt lock_interrupt;
+  return_code = stan::services::sample::hmc_nuts_diag_e_adapt_lockstep(
+      *model, num_chains, context, inv_metric, random_seed, chain, init_radius,
+      num_warmup, num_samples, num_thin, save_warmup, refresh, stepsize,
+      stepsize_jitter, max_depth, delta, gamma, kappa, t0, init_buffer,
+      term_buffer, window, lock_interrupt, logger, lock_init, lock_parameters,
+      lock_diagnostics, lock_metrics);
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(num_warmup + num_samples, lock_interrupt.call_count());
+
+  std::vector<Eigen::MatrixXd> par_res;
+  std::vector<std::string> par_metrics;
+  for (int i = 0; i < num_chains; ++i) {
+    auto par_str = par_parameters[i].get_stream().str();
+    auto sub_par_str = par_str.substr(par_str.find("Step size") - 2);
+    std::istringstream sub_par_stream(sub_par_str);
+    Eigen::MatrixXd par_mat
+        = stan::test::read_stan_sample_csv(sub_par_stream, 80, 9);
+    par_res.push_back(par_mat);
+    par_metrics.push_back(ss_metric[i].str());
+    ASSERT_TRUE(stan::test::is_valid_JSON(par_metrics[i]));
+    EXPECT_EQ(count_matches("stepsize", par_metrics[i]), 1);
+    EXPECT_EQ(count_matches("metric_type", par_metrics[i]), 1);
+    EXPECT_EQ(count_matches("inv_metric", par_metrics[i]), 1);
+    EXPECT_EQ(count_matches("[", par_metrics[i]), 1);  // single list
+  }
+
+  std::vector<Eigen::MatrixXd> lock_res;
+  std::vector<std::string> lock_metric_json;
+  for (int i = 0; i < num_chains; ++i) {
+    auto lock_str = lock_parameters[i].get_stream().str();
+    auto sub_lock_str = lock_str.substr(lock_str.find("Step size") - 2);
+    std::istringstream sub_lock_stream(sub_lock_str);
+    Eigen::MatrixXd lock_mat
+        = stan::test::read_stan_sample_csv(sub_lock_stream, 80, 9);
+    lock_res.push_back(lock_mat);
+    lock_metric_json.push_back(ss_lock_metric[i].str());
+  }
+  for (int i = 0; i < num_chains; ++i) {
+    Eigen::MatrixXd diff_res
+        = (par_res[i].array() - lock_res[i].array()).matrix();
+    EXPECT_MATRIX_EQ(diff_res, Eigen::MatrixXd::Zero(80, 9));
+    EXPECT_EQ(par_metrics[i], lock_metric_json[i]);
+  }
+}
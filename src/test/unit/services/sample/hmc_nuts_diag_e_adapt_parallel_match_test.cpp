@@ -116,7 +116,7 @@ TEST_F(ServicesSampleHmcNutsDiagEAdaptParMatch, single_multi_match) {
   std::vector<std::string> par_metrics;
   for (int i = 0; i < num_chains; ++i) {
     auto par_str = par_parameters[i].get_stream().str();
-    auto sub_par_str = par_str.substr(par_str.find("Diagonal") - 1);
+    auto sub_par_str = par_str.substr(par_str.find("Step size") - 2);
     std::istringstream sub_par_stream(sub_par_str);
     Eigen::MatrixXd par_mat
         = stan::test::read_stan_sample_csv(sub_par_stream, 80, 9);
@@ -133,7 +133,7 @@ TEST_F(ServicesSampleHmcNutsDiagEAdaptParMatch, single_multi_match) {
   std::vector<std::string> seq_metrics;
   for (int i = 0; i < num_chains; ++i) {
     auto seq_str = seq_parameters[i].get_stream().str();
-    auto sub_seq_str = seq_str.substr(seq_str.find("Diagonal") - 1);
+    auto sub_seq_str = seq_str.substr(seq_str.find("Step size") - 2);
     std::istringstream sub_seq_stream(sub_seq_str);
     Eigen::MatrixXd seq_mat
         = stan::test::read_stan_sample_csv(sub_seq_stream, 80, 9);
@@ -173,3 +173,53 @@ TEST_F(ServicesSampleHmcNutsDiagEAdaptPar, output_regression) {
   EXPECT_EQ(num_chains, logger.find_info("seconds (Total)"));
   EXPECT_EQ(0, logger.call_count_error());
 }
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptPar, sampling_target) {
+  unsigned int random_seed = 0;
+  unsigned int chain = 1;
+  double init_radius = 0;
+  int num_warmup = 200;
+  int num_samples = 5000;
+  int num_thin = 1;
+  bool save_warmup = true;
+  int refresh = 0;
+  double stepsize = 0.1;
+  double stepsize_jitter = 0;
+  int max_depth = 8;
+  double delta = .8;
+  double gamma = .05;
+  double kappa = .75;
+  double t0 = 10;
+  unsigned int init_buffer = 50;
+  unsigned int term_buffer = 50;
+  unsigned int window = 100;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::vector<std::shared_ptr<stan::io::var_context>> inv_metric;
+  std::vector<stan::callbacks::structured_writer> metric(num_chains);
+  for (size_t i = 0; i < num_chains; ++i)
+    inv_metric.push_back(std::make_shared<stan::io::array_var_context>(
+        stan::services::util::create_unit_e_diag_inv_metric(2)));
+  stan::services::util::sampling_target target;
+  target.min_ess = 50;
+  target.max_rhat = 1.2;
+  target.check_every = 50;
+
+  int return_code = stan::services::sample::hmc_nuts_diag_e_adapt(
+      model, num_chains, context, inv_metric, random_seed, chain, init_radius,
+      num_warmup, num_samples, num_thin, save_warmup, refresh, stepsize,
+      stepsize_jitter, max_depth, delta, gamma, kappa, t0, init_buffer,
+      term_buffer, window, interrupt, logger, init, parameter, diagnostic,
+      metric, target);
+
+  EXPECT_EQ(0, return_code);
+  EXPECT_EQ(0, logger.call_count_error());
+  EXPECT_EQ(1, logger.find_info("Sampling target reached"));
+  // The chains stop well before the upper bound on the draws
+  EXPECT_LT(interrupt.call_count(), (num_warmup + num_samples) * num_chains);
+  for (size_t i = 0; i < num_chains; ++i) {
+    EXPECT_EQ(1, parameter[i].call_count("vector_string"));
+    EXPECT_GT(parameter[i].call_count("vector_double"), num_warmup);
+    EXPECT_LT(parameter[i].call_count("vector_double"),
+              num_warmup + num_samples);
+  }
+}
@@ -0,0 +1,88 @@
+#include <stan/services/sample/hmc_nuts_diag_e_adapt_pathfinder.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <memory>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+static constexpr size_t num_chains = 4;
+static constexpr int num_paths = 4;
+
+class ServicesSampleHmcNutsDiagEAdaptPathfinder : public testing::Test {
+ public:
+  ServicesSampleHmcNutsDiagEAdaptPathfinder()
+      : model(data_context, 0, &model_log), metric(num_chains) {
+    for (int i = 0; i < num_chains; ++i) {
+      init.push_back(stan::test::unit::instrumented_writer{});
+      parameter.push_back(stan::test::unit::instrumented_writer{});
+      diagnostic.push_back(stan::test::unit::instrumented_writer{});
+    }
+    for (int i = 0; i < num_paths; ++i)
+      context.push_back(std::make_shared<stan::io::empty_var_context>());
+  }
+
+  int run(int num_warmup, int num_samples) {
+    return stan::services::sample::hmc_nuts_diag_e_adapt_pathfinder(
+        model, num_chains, context, 0, 1, 2, num_paths, 5, 0.001, 1e-12,
+        10000, 1e-8, 1e7, 1e-8, 1000, 25, 100, num_warmup, num_samples, 1,
+        true, 0, 1, 0, 8, 0.8, 0.05, 0.75, 10, 15, 20, 25, interrupt, logger,
+        init, parameter, diagnostic, metric);
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::vector<stan::test::unit::instrumented_writer> init;
+  std::vector<stan::test::unit::instrumented_writer> parameter;
+  std::vector<stan::test::unit::instrumented_writer> diagnostic;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> context;
+  stan_model model;
+  std::vector<stan::callbacks::structured_writer> metric;
+};
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptPathfinder, call_count) {
+  int num_warmup = 150;
+  int num_samples = 100;
+  EXPECT_EQ(0, run(num_warmup, num_samples));
+
+  for (int i = 0; i < num_chains; ++i) {
+    // One unconstrained init of the two parameters per chain
+    ASSERT_EQ(1, init[i].call_count("vector_double"));
+    EXPECT_EQ(2, init[i].vector_double_values()[0].size());
+    EXPECT_EQ(1, parameter[i].call_count("vector_string"));
+    EXPECT_EQ(num_warmup + num_samples,
+              parameter[i].call_count("vector_double"));
+    EXPECT_EQ(num_warmup + num_samples,
+              diagnostic[i].call_count("vector_double"));
+  }
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptPathfinder, inits_from_pathfinder) {
+  EXPECT_EQ(0, run(150, 10));
+
+  // The chains start from Pathfinder draws near the mode at (1, 1) rather
+  // than at the initial value of the paths
+  for (int i = 0; i < num_chains; ++i) {
+    const std::vector<double>& init_value = init[i].vector_double_values()[0];
+    EXPECT_NE(0, init_value[0]);
+    EXPECT_NE(0, init_value[1]);
+  }
+}
+
+TEST(ServicesSampleWeightedDiagInvMetric, weighted_variance) {
+  Eigen::MatrixXd draws(2, 4);
+  draws << 1, 2, 3, 100, 0, 0, 2, -50;
+  Eigen::VectorXd weights(4);
+  weights << 0.25, 0.25, 0.5, 0;
+  Eigen::VectorXd inv_metric
+      = stan::services::sample::internal::weighted_diag_inv_metric(draws,
+                                                                    weights);
+  // Weighted means are 2.25 and 1, variances 0.6875 and 1
+  const double n = 1 / 0.375;
+  EXPECT_FLOAT_EQ((n / (n + 5)) * 0.6875 + 1e-3 * 5 / (n + 5), inv_metric(0));
+  EXPECT_FLOAT_EQ((n / (n + 5)) * 1 + 1e-3 * 5 / (n + 5), inv_metric(1));
+}
@@ -0,0 +1,83 @@
+#include <stan/services/sample/hmc_nuts_diag_e_adapt.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/array_var_context.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <memory>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+static constexpr size_t num_chains = 4;
+
+class ServicesSampleHmcNutsDiagEAdaptPooled : public testing::Test {
+ public:
+  ServicesSampleHmcNutsDiagEAdaptPooled()
+      : model(data_context, 0, &model_log), metric(num_chains) {
+    for (int i = 0; i < num_chains; ++i) {
+      init.push_back(stan::test::unit::instrumented_writer{});
+      parameter.push_back(stan::test::unit::instrumented_writer{});
+      diagnostic.push_back(stan::test::unit::instrumented_writer{});
+      context.push_back(std::make_shared<stan::io::empty_var_context>());
+      inv_metric.push_back(std::make_shared<stan::io::array_var_context>(
+          stan::services::util::create_unit_e_diag_inv_metric(
+              model.num_params_r())));
+    }
+  }
+
+  int run(int num_warmup, int num_samples, double max_warmup_rhat) {
+    return stan::services::sample::hmc_nuts_diag_e_adapt(
+        model, num_chains, context, inv_metric, 0, 1, 0, num_warmup,
+        num_samples, 1, true, 0, 0.1, 0, 8, 0.8, 0.05, 0.75, 10, 15, 20, 25,
+        max_warmup_rhat, interrupt, logger, init, parameter, diagnostic,
+        metric);
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::vector<stan::test::unit::instrumented_writer> init;
+  std::vector<stan::test::unit::instrumented_writer> parameter;
+  std::vector<stan::test::unit::instrumented_writer> diagnostic;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> context;
+  std::vector<std::shared_ptr<stan::io::array_var_context>> inv_metric;
+  stan_model model;
+  std::vector<stan::callbacks::structured_writer> metric;
+};
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptPooled, shared_tuning) {
+  int num_warmup = 200;
+  int num_samples = 100;
+  EXPECT_EQ(0, run(num_warmup, num_samples, 0));
+
+  EXPECT_EQ((num_warmup + num_samples) * num_chains, interrupt.call_count());
+  double stepsize = parameter[0].vector_double_values().back()[2];
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_EQ(num_warmup + num_samples,
+              parameter[i].call_count("vector_double"));
+    EXPECT_EQ(num_warmup + num_samples,
+              diagnostic[i].call_count("vector_double"));
+    // Every chain samples with the same step size
+    EXPECT_FLOAT_EQ(stepsize, parameter[i].vector_double_values().back()[2]);
+  }
+  EXPECT_EQ(0, logger.find_info("Potential scale reduction of lp__"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptPooled, early_stop) {
+  int num_warmup = 200;
+  int num_samples = 100;
+  EXPECT_EQ(0, run(num_warmup, num_samples, 1e10));
+
+  // The first window closes after 40 iterations, leaving the terminal
+  // fast interval of 20 iterations
+  int warmup_end = 60;
+  EXPECT_EQ((warmup_end + num_samples) * num_chains, interrupt.call_count());
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_EQ(warmup_end + num_samples,
+              parameter[i].call_count("vector_double"));
+  }
+  EXPECT_EQ(1, logger.find_info("Potential scale reduction of lp__"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
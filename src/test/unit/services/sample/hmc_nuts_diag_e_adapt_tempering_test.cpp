@@ -0,0 +1,73 @@
+#include <stan/services/sample/hmc_nuts_diag_e_adapt_tempering.hpp>
+#include <stan/services/sample/hmc_nuts_diag_e_adapt.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <vector>
+
+class ServicesSampleHmcNutsDiagEAdaptTempering : public testing::Test {
+ public:
+  ServicesSampleHmcNutsDiagEAdaptTempering()
+      : model(context, 0, &model_log) {}
+
+  int run(const std::vector<double>& inverse_temperatures, int swap_every,
+          stan::test::unit::instrumented_writer& parameter) {
+    auto inv_metric = stan::services::util::create_unit_e_diag_inv_metric(
+        model.num_params_r());
+    return stan::services::sample::hmc_nuts_diag_e_adapt_tempering(
+        model, context, inv_metric, inverse_temperatures, swap_every, 0, 1,
+        2, 200, 400, 1, false, 0, 1, 0, 10, 0.8, 0.05, 0.75, 10, 75, 50, 25,
+        interrupt, logger, init, parameter, diagnostic, metric);
+  }
+
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::test::unit::instrumented_writer init, parameter, diagnostic;
+  stan::callbacks::structured_writer metric;
+  stan::io::empty_var_context context;
+  gauss3D_model_namespace::gauss3D_model model;
+};
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptTempering, call_count) {
+  EXPECT_EQ(0, run({1, 0.5, 0.25, 0}, 1, parameter));
+
+  EXPECT_EQ(600, interrupt.call_count());
+  EXPECT_EQ(1, parameter.call_count("vector_string"));
+  EXPECT_EQ(400, parameter.call_count("vector_double"));
+  EXPECT_EQ(1, diagnostic.call_count("vector_string"));
+  EXPECT_EQ(400, diagnostic.call_count("vector_double"));
+  EXPECT_EQ(3, logger.find("Swap rate between inverse temperatures"));
+  EXPECT_EQ(0, logger.call_count_error());
+
+  double mean = 0;
+  for (const std::vector<double>& draw : parameter.vector_double_values())
+    mean += draw[7] / 400;
+  EXPECT_NEAR(0, mean, 0.3);
+}
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptTempering, single_replica_matches) {
+  // Without hot replicas the draws are those of hmc_nuts_diag_e_adapt
+  EXPECT_EQ(0, run({1}, 1, parameter));
+  stan::test::unit::instrumented_writer untempered;
+  stan::test::unit::instrumented_writer untempered_diagnostic;
+  auto inv_metric = stan::services::util::create_unit_e_diag_inv_metric(
+      model.num_params_r());
+  EXPECT_EQ(0, stan::services::sample::hmc_nuts_diag_e_adapt(
+                   model, context, inv_metric, 0, 1, 2, 200, 400, 1, false, 0,
+                   1, 0, 10, 0.8, 0.05, 0.75, 10, 75, 50, 25, interrupt,
+                   logger, init, untempered, untempered_diagnostic,
+                   metric));
+  EXPECT_EQ(untempered.vector_double_values(),
+            parameter.vector_double_values());
+}
+
+TEST_F(ServicesSampleHmcNutsDiagEAdaptTempering, bad_arguments) {
+  using stan::services::error_codes;
+  EXPECT_EQ(error_codes::CONFIG, run({0.5, 0.25}, 1, parameter));
+  EXPECT_EQ(error_codes::CONFIG, run({1, 0.25, 0.5}, 1, parameter));
+  EXPECT_EQ(error_codes::CONFIG, run({1, 0.5}, 0, parameter));
+  EXPECT_EQ(0, interrupt.call_count());
+  EXPECT_EQ(3, logger.call_count_error());
+}
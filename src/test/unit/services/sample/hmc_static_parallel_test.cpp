@@ -0,0 +1,130 @@
+#include <stan/services/sample/hmc_static_dense_e.hpp>
+#include <stan/services/sample/hmc_static_dense_e_adapt.hpp>
+#include <stan/services/sample/hmc_static_diag_e.hpp>
+#include <stan/services/sample/hmc_static_diag_e_adapt.hpp>
+#include <stan/services/sample/hmc_static_unit_e.hpp>
+#include <stan/services/sample/hmc_static_unit_e_adapt.hpp>
+#include <stan/callbacks/json_writer.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/optimization/rosenbrock.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <iostream>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+static constexpr size_t num_chains = 4;
+
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
+class ServicesSampleHmcStaticPar : public testing::Test {
+ public:
+  ServicesSampleHmcStaticPar()
+      : model(data_context, 0, &model_log), ss_metric(num_chains) {
+    for (int i = 0; i < num_chains; ++i) {
+      init.push_back(stan::test::unit::instrumented_writer{});
+      parameter.push_back(stan::test::unit::instrumented_writer{});
+      diagnostic.push_back(stan::test::unit::instrumented_writer{});
+      metric.push_back(
+          stan::callbacks::json_writer<std::stringstream, deleter_noop>(
+              std::unique_ptr<std::stringstream, deleter_noop>(&ss_metric[i])));
+      context.push_back(std::make_shared<stan::io::empty_var_context>());
+    }
+  }
+
+  void check_output(int num_warmup, int num_samples, int num_thin) {
+    int num_output_lines = (num_warmup + num_samples) / num_thin;
+    EXPECT_EQ((num_warmup + num_samples) * num_chains, interrupt.call_count());
+    for (int i = 0; i < num_chains; ++i) {
+      EXPECT_EQ(1, parameter[i].call_count("vector_string"));
+      EXPECT_EQ(num_output_lines, parameter[i].call_count("vector_double"));
+      EXPECT_EQ(1, diagnostic[i].call_count("vector_string"));
+      EXPECT_EQ(num_output_lines, diagnostic[i].call_count("vector_double"));
+
+      std::vector<std::vector<std::string>> parameter_names
+          = parameter[i].vector_string_values();
+      ASSERT_EQ(7, parameter_names[0].size());
+      EXPECT_EQ("lp__", parameter_names[0][0]);
+      EXPECT_EQ("accept_stat__", parameter_names[0][1]);
+      EXPECT_EQ("stepsize__", parameter_names[0][2]);
+      EXPECT_EQ("int_time__", parameter_names[0][3]);
+      EXPECT_EQ("energy__", parameter_names[0][4]);
+      EXPECT_EQ("x", parameter_names[0][5]);
+      EXPECT_EQ("y", parameter_names[0][6]);
+    }
+    EXPECT_EQ(num_chains, logger.find_info("Elapsed Time:"));
+    EXPECT_EQ(0, logger.call_count_error());
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  std::vector<stan::test::unit::instrumented_writer> init;
+  std::vector<stan::test::unit::instrumented_writer> parameter;
+  std::vector<stan::test::unit::instrumented_writer> diagnostic;
+  std::vector<std::shared_ptr<stan::io::empty_var_context>> context;
+  stan_model model;
+  std::vector<std::stringstream> ss_metric;
+  std::vector<stan::callbacks::json_writer<std::stringstream, deleter_noop>>
+      metric;
+};
+
+TEST_F(ServicesSampleHmcStaticPar, dense_e) {
+  int return_code = stan::services::sample::hmc_static_dense_e(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+}
+
+TEST_F(ServicesSampleHmcStaticPar, diag_e) {
+  int return_code = stan::services::sample::hmc_static_diag_e(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+}
+
+TEST_F(ServicesSampleHmcStaticPar, unit_e) {
+  int return_code = stan::services::sample::hmc_static_unit_e(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+}
+
+TEST_F(ServicesSampleHmcStaticPar, dense_e_adapt) {
+  int return_code = stan::services::sample::hmc_static_dense_e_adapt(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      0.8, 0.05, 0.75, 10, 75, 50, 25, interrupt, logger, init, parameter,
+      diagnostic, metric);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_NE(std::string::npos, ss_metric[i].str().find("inv_metric"));
+  }
+}
+
+TEST_F(ServicesSampleHmcStaticPar, diag_e_adapt) {
+  int return_code = stan::services::sample::hmc_static_diag_e_adapt(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      0.8, 0.05, 0.75, 10, 75, 50, 25, interrupt, logger, init, parameter,
+      diagnostic, metric);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+  for (int i = 0; i < num_chains; ++i) {
+    EXPECT_NE(std::string::npos, ss_metric[i].str().find("inv_metric"));
+  }
+}
+
+TEST_F(ServicesSampleHmcStaticPar, unit_e_adapt) {
+  int return_code = stan::services::sample::hmc_static_unit_e_adapt(
+      model, num_chains, context, 0, 1, 0, 200, 400, 5, true, 0, 0.1, 0, 1,
+      0.8, 0.05, 0.75, 10, interrupt, logger, init, parameter, diagnostic);
+  EXPECT_EQ(0, return_code);
+  check_output(200, 400, 5);
+}
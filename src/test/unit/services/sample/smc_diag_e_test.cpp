@@ -0,0 +1,62 @@
+#include <stan/services/sample/smc_diag_e.hpp>
+#include <gtest/gtest.h>
+#include <stan/io/empty_var_context.hpp>
+#include <test/test-models/good/mcmc/hmc/common/gauss3D.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <cmath>
+
+class ServicesSampleSmcDiagE : public testing::Test {
+ public:
+  ServicesSampleSmcDiagE() : model(data_context, 0, &model_log) {}
+
+  int run(int num_particles, double ess_fraction) {
+    return stan::services::sample::smc_diag_e(
+        model, 0, 1, 2, num_particles, ess_fraction, 5, 0.5, 2, 0.8, 100, 0,
+        interrupt, logger, parameter, diagnostic);
+  }
+
+  stan::io::empty_var_context data_context;
+  std::stringstream model_log;
+  stan::test::unit::instrumented_logger logger;
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::test::unit::instrumented_writer parameter;
+  stan::test::unit::instrumented_writer diagnostic;
+  gauss3D_model_namespace::gauss3D_model model;
+};
+
+TEST_F(ServicesSampleSmcDiagE, marginal_likelihood) {
+  EXPECT_EQ(0, run(1000, 0.5));
+
+  // One draw per particle
+  EXPECT_EQ(1000, parameter.call_count("vector_double"));
+  std::vector<std::string> names = parameter.vector_string_values()[0];
+  ASSERT_EQ(8, names.size());
+  EXPECT_EQ("lp__", names[0]);
+  EXPECT_EQ("x.1", names[5]);
+
+  // The standard normal density of the model integrates to one
+  std::vector<std::vector<double>> stages = diagnostic.vector_double_values();
+  ASSERT_GT(stages.size(), 1);
+  EXPECT_EQ(stages.size(), interrupt.call_count());
+  EXPECT_FLOAT_EQ(1, stages.back()[1]);
+  EXPECT_NEAR(0, stages.back()[3], 0.2);
+  for (size_t n = 1; n < stages.size(); ++n)
+    EXPECT_GT(stages[n][1], stages[n - 1][1]);
+
+  double mean = 0;
+  double var = 0;
+  for (const std::vector<double>& draw : parameter.vector_double_values()) {
+    mean += draw[5] / 1000;
+    var += draw[5] * draw[5] / 1000;
+  }
+  EXPECT_NEAR(0, mean, 0.2);
+  EXPECT_NEAR(1, var, 0.3);
+  EXPECT_EQ(1, logger.find("Log marginal likelihood estimate"));
+  EXPECT_EQ(0, logger.call_count_error());
+}
+
+TEST_F(ServicesSampleSmcDiagE, bad_arguments) {
+  EXPECT_EQ(stan::services::error_codes::CONFIG, run(1, 0.5));
+  EXPECT_EQ(stan::services::error_codes::CONFIG, run(100, 1));
+  EXPECT_EQ(0, interrupt.call_count());
+}
@@ -2,8 +2,10 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/stream_writer.hpp>
 #include <stan/callbacks/unique_stream_writer.hpp>
 #include <stan/io/json/json_data.hpp>
+#include <stan/io/stan_csv_chunk_reader.hpp>
 #include <stan/io/stan_csv_reader.hpp>
 #include <stan/services/error_codes.hpp>
 #include <stan/services/sample/standalone_gqs.hpp>
@@ -78,3 +80,94 @@ TEST_F(ServicesStandaloneGQ, genDraws_bernoulli) {
     match_csv_columns(bern_csv.samples, sample_ss[i].str(), 1000, 1, 8);
   }
 }
+
+TEST_F(ServicesStandaloneGQ, genDraws_bernoulli_blocks) {
+  stan::io::stan_csv bern_csv;
+  std::stringstream out;
+  std::ifstream csv_stream;
+  csv_stream.open("src/test/test-models/good/services/bernoulli_fit.csv");
+  bern_csv = stan::io::stan_csv_reader::parse(csv_stream, &out);
+  csv_stream.close();
+  ASSERT_EQ(1000, bern_csv.samples.rows());
+  Eigen::MatrixXd draws = bern_csv.samples.middleCols<1>(7);
+
+  auto generate = [&](size_t block_size, std::stringstream& sample_ss) {
+    stan::callbacks::stream_writer sample_writer(sample_ss, "");
+    if (block_size == 0)
+      return stan::services::standalone_generate(model, draws, 12345,
+                                                 interrupt, logger,
+                                                 sample_writer);
+    return stan::services::standalone_generate_parallel(
+        model, draws, 12345, block_size, interrupt, logger, sample_writer);
+  };
+
+  // One block uses the same generator as the serial service
+  std::stringstream serial_ss;
+  std::stringstream one_block_ss;
+  EXPECT_EQ(stan::services::error_codes::OK, generate(0, serial_ss));
+  EXPECT_EQ(stan::services::error_codes::OK, generate(1000, one_block_ss));
+  EXPECT_EQ(serial_ss.str(), one_block_ss.str());
+
+  // The output does not depend on the scheduling of the blocks
+  std::stringstream sample_ss;
+  std::stringstream repeat_ss;
+  EXPECT_EQ(stan::services::error_codes::OK, generate(64, sample_ss));
+  EXPECT_EQ(stan::services::error_codes::OK, generate(64, repeat_ss));
+  EXPECT_EQ(sample_ss.str(), repeat_ss.str());
+  EXPECT_EQ(count_matches("mu", sample_ss.str()), 1);
+  EXPECT_EQ(count_matches("y_rep", sample_ss.str()), 10);
+  EXPECT_EQ(count_matches("\n", sample_ss.str()), 1001);
+  match_csv_columns(bern_csv.samples, sample_ss.str(), 1000, 1, 8);
+}
+
+TEST_F(ServicesStandaloneGQ, genDraws_parallel_bad) {
+  Eigen::MatrixXd draws(2, 2);
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  int return_code = stan::services::standalone_generate_parallel(
+      model, draws, 12345, 64, interrupt, logger, sample_writer);
+  EXPECT_EQ(return_code, stan::services::error_codes::DATAERR);
+  EXPECT_EQ(count_matches("Wrong number of parameter values", logger_ss.str()),
+            1);
+}
+
+TEST_F(ServicesStandaloneGQ, genDraws_streaming_matches_parallel) {
+  std::stringstream out;
+  std::ifstream csv_stream(
+      "src/test/test-models/good/services/bernoulli_fit.csv");
+  stan::io::stan_csv bern_csv
+      = stan::io::stan_csv_reader::parse(csv_stream, &out);
+  csv_stream.close();
+  Eigen::MatrixXd draws = bern_csv.samples.middleCols<1>(7);
+  std::stringstream parallel_ss;
+  stan::callbacks::stream_writer parallel_writer(parallel_ss, "");
+  EXPECT_EQ(stan::services::error_codes::OK,
+            stan::services::standalone_generate_parallel(
+                model, draws, 12345, 64, interrupt, logger, parallel_writer));
+
+  // A chunk size which is not a multiple of the block size is rounded up
+  for (size_t chunk_size : {64, 100, 5000}) {
+    std::ifstream in("src/test/test-models/good/services/bernoulli_fit.csv");
+    stan::io::stan_csv_chunk_reader reader(in, {"theta"}, &out);
+    std::stringstream streaming_ss;
+    stan::callbacks::stream_writer streaming_writer(streaming_ss, "");
+    EXPECT_EQ(stan::services::error_codes::OK,
+              stan::services::standalone_generate_streaming(
+                  model, reader, 12345, 64, chunk_size, interrupt, logger,
+                  streaming_writer));
+    EXPECT_EQ(parallel_ss.str(), streaming_ss.str());
+  }
+}
+
+TEST_F(ServicesStandaloneGQ, genDraws_streaming_bad_row) {
+  std::stringstream in("lp__,theta\n-7,0.2\n-7,0.3\n-7\n");
+  stan::io::stan_csv_chunk_reader reader(in, {"theta"}, nullptr);
+  std::stringstream sample_ss;
+  stan::callbacks::stream_writer sample_writer(sample_ss, "");
+  int return_code = stan::services::standalone_generate_streaming(
+      model, reader, 12345, 1, 1, interrupt, logger, sample_writer);
+  EXPECT_EQ(stan::services::error_codes::DATAERR, return_code);
+  // The draws before the bad row are written
+  EXPECT_EQ(count_matches("\n", sample_ss.str()), 3);
+  EXPECT_EQ(count_matches("Expected 2 columns", logger_ss.str()), 1);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/json/json_data.hpp>
+#include <stan/io/stan_csv_reader.hpp>
+#include <stan/services/error_codes.hpp>
+#include <stan/services/transform/transform_draws.hpp>
+#include <test/test-models/good/services/bernoulli.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+auto&& blah = stan::math::init_threadpool_tbb();
+
+class ServicesTransformDraws : public ::testing::Test {
+ public:
+  ServicesTransformDraws()
+      : data_var_context([]() {
+          std::fstream data_stream(
+              "src/test/test-models/good/services/bernoulli.data.json",
+              std::fstream::in);
+          stan::json::json_data data_context(data_stream);
+          data_stream.close();
+          return data_context;
+        }()),
+        logger(logger_ss, logger_ss, logger_ss, logger_ss, logger_ss),
+        model(data_var_context) {
+    std::stringstream out;
+    std::ifstream csv_stream(
+        "src/test/test-models/good/services/bernoulli_fit.csv");
+    stan::io::stan_csv fit = stan::io::stan_csv_reader::parse(csv_stream, &out);
+    theta = fit.samples.middleCols<1>(7);
+  }
+  stan::json::json_data data_var_context;
+  std::stringstream logger_ss;
+  stan::callbacks::stream_logger logger;
+  stan_model model;
+  Eigen::MatrixXd theta;
+};
+
+TEST_F(ServicesTransformDraws, unconstrain_and_constrain_round_trip) {
+  Eigen::MatrixXd unconstrained;
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::unconstrain_draws(model, theta, 7,
+                                                         unconstrained,
+                                                         logger));
+  ASSERT_EQ(theta.rows(), unconstrained.rows());
+  ASSERT_EQ(1, unconstrained.cols());
+  for (Eigen::Index i = 0; i < theta.rows(); ++i)
+    EXPECT_FLOAT_EQ(stan::math::logit(theta(i, 0)), unconstrained(i, 0));
+
+  Eigen::MatrixXd constrained;
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::constrain_draws(
+                model, unconstrained, false, false, 1234, 7, constrained,
+                logger));
+  ASSERT_EQ(theta.rows(), constrained.rows());
+  ASSERT_EQ(1, constrained.cols());
+  for (Eigen::Index i = 0; i < theta.rows(); ++i)
+    EXPECT_FLOAT_EQ(theta(i, 0), constrained(i, 0));
+}
+
+TEST_F(ServicesTransformDraws, matrix_unconstrain_array) {
+  const stan::model::model_base_crtp<stan_model>& base = model;
+  Eigen::MatrixXd unconstrained;
+  base.unconstrain_array(theta, unconstrained);
+  Eigen::MatrixXd expected;
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::unconstrain_draws(model, theta, 64,
+                                                         expected, logger));
+  ASSERT_EQ(expected.rows(), unconstrained.rows());
+  ASSERT_EQ(expected.cols(), unconstrained.cols());
+  for (Eigen::Index i = 0; i < theta.rows(); ++i)
+    EXPECT_FLOAT_EQ(expected(i, 0), unconstrained(i, 0));
+}
+
+TEST_F(ServicesTransformDraws, constrain_with_generated_quantities) {
+  Eigen::MatrixXd unconstrained;
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::unconstrain_draws(model, theta, 64,
+                                                         unconstrained,
+                                                         logger));
+  Eigen::MatrixXd first;
+  Eigen::MatrixXd second;
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::constrain_draws(
+                model, unconstrained, true, true, 1234, 16, first, logger));
+  ASSERT_EQ(stan::services::error_codes::OK,
+            stan::services::transform::constrain_draws(
+                model, unconstrained, true, true, 1234, 16, second, logger));
+  std::vector<std::string> names;
+  model.constrained_param_names(names, true, true);
+  ASSERT_EQ(names.size(), first.cols());
+  ASSERT_EQ(theta.rows(), first.rows());
+  // theta, then mu = theta, then the replicated data
+  for (Eigen::Index i = 0; i < theta.rows(); ++i) {
+    EXPECT_FLOAT_EQ(theta(i, 0), first(i, 0));
+    EXPECT_FLOAT_EQ(theta(i, 0), first(i, 1));
+  }
+  EXPECT_TRUE(((first.rightCols(names.size() - 2).array() == 0)
+               || (first.rightCols(names.size() - 2).array() == 1))
+                  .all());
+  // The generators depend on the block, not on the thread
+  EXPECT_EQ(first, second);
+}
+
+TEST_F(ServicesTransformDraws, wrong_number_of_columns) {
+  Eigen::MatrixXd draws = Eigen::MatrixXd::Constant(3, 2, 0.5);
+  Eigen::MatrixXd out;
+  EXPECT_EQ(stan::services::error_codes::DATAERR,
+            stan::services::transform::unconstrain_draws(model, draws, 64, out,
+                                                         logger));
+  EXPECT_EQ(stan::services::error_codes::DATAERR,
+            stan::services::transform::constrain_draws(
+                model, draws, false, false, 1234, 64, out, logger));
+}
+
+TEST_F(ServicesTransformDraws, draw_out_of_support) {
+  Eigen::MatrixXd draws(5, 1);
+  draws << 0.2, 0.3, 1.5, 0.4, -1;
+  Eigen::MatrixXd out;
+  EXPECT_EQ(stan::services::error_codes::DATAERR,
+            stan::services::transform::unconstrain_draws(model, draws, 2, out,
+                                                         logger));
+  EXPECT_NE(std::string::npos,
+            logger_ss.str().find("Error unconstraining draw 3"));
+}
@@ -28,3 +28,22 @@ TEST(rng, initialize_with_zero) {
   rng2();
   EXPECT_NE(rng1, rng2);
 }
+
+TEST(rng, substreams) {
+  stan::rng_t chain_rng = stan::services::util::create_rng(0, 1);
+  stan::rng_t rng1 = stan::services::util::create_rng(0, 1, 0);
+  stan::rng_t rng2 = stan::services::util::create_rng(0, 1, 0);
+  EXPECT_EQ(rng1, rng2);
+  EXPECT_NE(chain_rng, rng1);
+
+  for (unsigned int n = 1; n < 20; n++) {
+    EXPECT_NE(rng1, stan::services::util::create_rng(0, 1, n));
+    EXPECT_NE(rng1, stan::services::util::create_rng(0, n + 1, 0));
+    EXPECT_NE(rng1, stan::services::util::create_rng(n, 1, 0));
+  }
+
+  // Independent of the order in which substreams are created
+  stan::rng_t rng3 = stan::services::util::create_rng(0, 1, 3);
+  rng1();
+  EXPECT_EQ(rng3(), stan::services::util::create_rng(0, 1, 3)());
+}
@@ -0,0 +1,122 @@
+#include <stan/services/util/data_snapshot_cache.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+// Model whose transformed data is the sum of its data, counting how
+// often the constructor runs
+struct snapshot_model {
+  static int num_constructed;
+  double sum = 0;
+
+  snapshot_model(stan::io::var_context& data, unsigned int seed,
+                 std::ostream* msgs) {
+    ++num_constructed;
+    for (double y : data.vals_r("y"))
+      sum += y;
+  }
+
+  explicit snapshot_model(double sum) : sum(sum) {}
+
+  bool write_data_snapshot(std::ostream& out) const {
+    out.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    return true;
+  }
+
+  static std::unique_ptr<snapshot_model> read_data_snapshot(std::istream& in) {
+    double sum;
+    in.read(reinterpret_cast<char*>(&sum), sizeof(sum));
+    if (!in)
+      return nullptr;
+    return std::make_unique<snapshot_model>(sum);
+  }
+};
+
+int snapshot_model::num_constructed = 0;
+
+// Model without snapshot support
+struct plain_model {
+  plain_model(stan::io::var_context& data, unsigned int seed,
+              std::ostream* msgs) {}
+
+  bool write_data_snapshot(std::ostream& out) const { return false; }
+
+  static std::unique_ptr<plain_model> read_data_snapshot(std::istream& in) {
+    return nullptr;
+  }
+};
+
+stan::io::array_var_context make_data(double y) {
+  std::vector<std::string> names{"y"};
+  std::vector<double> values{y, 2.0, 3.0};
+  std::vector<std::vector<size_t>> dims{{3}};
+  return stan::io::array_var_context(names, values, dims);
+}
+}  // namespace
+
+TEST(ServicesUtil, data_snapshot_cache_key) {
+  stan::io::array_var_context data = make_data(1.0);
+  stan::io::array_var_context other_data = make_data(1.5);
+  using stan::services::util::data_snapshot_cache;
+  std::string key = data_snapshot_cache::key<snapshot_model>(data);
+  EXPECT_EQ(16, key.size());
+  EXPECT_EQ(key, data_snapshot_cache::key<snapshot_model>(make_data(1.0)));
+  EXPECT_NE(key, data_snapshot_cache::key<snapshot_model>(other_data));
+  EXPECT_NE(key, data_snapshot_cache::key<plain_model>(data));
+}
+
+TEST(ServicesUtil, construct_model_from_snapshot) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::services::util::data_snapshot_cache cache(".");
+  stan::io::array_var_context data = make_data(1.0);
+  const std::string path = cache.path(cache.key<snapshot_model>(data));
+  std::remove(path.c_str());
+  snapshot_model::num_constructed = 0;
+
+  auto model = stan::services::util::construct_model<snapshot_model>(
+      data, 0, cache, logger);
+  EXPECT_EQ(6.0, model->sum);
+  EXPECT_EQ(1, snapshot_model::num_constructed);
+  EXPECT_NE(std::string::npos, info.str().find("Wrote data snapshot"));
+
+  auto restored = stan::services::util::construct_model<snapshot_model>(
+      data, 0, cache, logger);
+  EXPECT_EQ(6.0, restored->sum);
+  EXPECT_EQ(1, snapshot_model::num_constructed);
+  EXPECT_NE(std::string::npos, info.str().find("Restored model"));
+
+  stan::io::array_var_context other_data = make_data(2.0);
+  auto other = stan::services::util::construct_model<snapshot_model>(
+      other_data, 0, cache, logger);
+  EXPECT_EQ(7.0, other->sum);
+  EXPECT_EQ(2, snapshot_model::num_constructed);
+
+  std::remove(path.c_str());
+  std::remove(cache.path(cache.key<snapshot_model>(other_data)).c_str());
+  EXPECT_EQ("", warn.str());
+}
+
+TEST(ServicesUtil, construct_model_without_snapshot_support) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  stan::services::util::data_snapshot_cache cache(".");
+  stan::io::array_var_context data = make_data(1.0);
+  const std::string key = cache.key<plain_model>(data);
+
+  auto model = stan::services::util::construct_model<plain_model>(
+      data, 0, cache, logger);
+  EXPECT_TRUE(model != nullptr);
+  EXPECT_EQ("", info.str());
+  EXPECT_FALSE(std::ifstream(cache.path(key)).good());
+  EXPECT_FALSE(std::ifstream(cache.path(key) + ".tmp").good());
+}
@@ -0,0 +1,46 @@
+#include <stan/services/util/execution_policy.hpp>
+#include <gtest/gtest.h>
+#include <tbb/parallel_for.h>
+#include <atomic>
+#include <stdexcept>
+
+TEST(ServicesUtil, execution_policy_num_threads) {
+  stan::services::util::execution_policy policy;
+  policy.num_threads = 2;
+  int concurrency = stan::services::util::execute(
+      policy, []() { return tbb::this_task_arena::max_concurrency(); });
+  EXPECT_EQ(2, concurrency);
+
+  // Parallel work spawned by the function stays in the arena
+  std::atomic<int> sum{0};
+  std::atomic<int> max_arena_concurrency{0};
+  stan::services::util::execute(policy, [&]() {
+    tbb::parallel_for(0, 100, [&](int i) {
+      sum += i;
+      max_arena_concurrency = tbb::this_task_arena::max_concurrency();
+    });
+  });
+  EXPECT_EQ(4950, sum);
+  EXPECT_EQ(2, max_arena_concurrency);
+}
+
+TEST(ServicesUtil, execution_policy_default) {
+  stan::services::util::execution_policy policy;
+  int concurrency = stan::services::util::execute(
+      policy, []() { return tbb::this_task_arena::max_concurrency(); });
+  EXPECT_EQ(tbb::this_task_arena::max_concurrency(), concurrency);
+}
+
+TEST(ServicesUtil, execution_policy_invalid) {
+  stan::services::util::execution_policy policy;
+  policy.num_threads = 0;
+  EXPECT_THROW(stan::services::util::execute(policy, []() {}),
+               std::invalid_argument);
+  policy.num_threads = -2;
+  EXPECT_THROW(stan::services::util::make_task_arena(policy),
+               std::invalid_argument);
+  policy.num_threads = 1;
+  policy.numa_node = 1 << 20;
+  EXPECT_THROW(stan::services::util::make_task_arena(policy),
+               std::invalid_argument);
+}
@@ -128,3 +128,43 @@ TEST_F(ServicesSamplesGenerateTransitions, output_sizes) {
   EXPECT_EQ(parameter_names[0].size(), parameter_values[0].size());
   EXPECT_EQ(diagnostic_names[0].size(), diagnostic_values[0].size());
 }
+
+namespace {
+class recording_progress : public stan::callbacks::progress {
+ public:
+  void operator()(size_t chain_id, int iteration, int num_iterations,
+                  bool warmup) {
+    chain_ids.push_back(chain_id);
+    iterations.push_back(iteration);
+    EXPECT_EQ(20, num_iterations);
+    EXPECT_TRUE(warmup);
+  }
+  std::vector<size_t> chain_ids;
+  std::vector<int> iterations;
+};
+}  // namespace
+
+TEST_F(ServicesSamplesGenerateTransitions, progress_callback) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  std::vector<double> cont_vector = stan::services::util::initialize(
+      model, context, rng, 0, false, logger, diagnostic);
+
+  stan::mcmc::fixed_param_sampler sampler;
+  stan::services::util::mcmc_writer writer(parameter, diagnostic, logger);
+  Eigen::VectorXd cont_params
+      = Eigen::Map<Eigen::VectorXd>(cont_vector.data(), cont_vector.size());
+  stan::mcmc::sample s(cont_params, 0, 0);
+
+  recording_progress progress;
+  stan::mcmc::sampler_instrumentation instrumentation;
+  stan::services::util::generate_transitions(
+      sampler, 10, 10, 20, 1, 4, false, true, writer, s, model, rng, interrupt,
+      logger, progress, instrumentation, 3);
+
+  // The progress callback replaces the iteration messages
+  EXPECT_EQ(0, logger.find_info("Iteration"));
+  EXPECT_EQ(std::vector<size_t>(4, 3), progress.chain_ids);
+  EXPECT_EQ(std::vector<int>({11, 14, 18, 20}), progress.iterations);
+  EXPECT_EQ(10, interrupt.call_count());
+}
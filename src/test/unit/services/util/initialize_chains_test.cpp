@@ -0,0 +1,168 @@
+#include <stan/services/util/initialize_chains.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <stan/model/prob_grad.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace test {
+// Mock model with one parameter theta, rejecting values above a
+// threshold and failing for values above another
+class mock_chain_model : public stan::model::prob_grad {
+ public:
+  mock_chain_model(double reject_above, double fail_above)
+      : stan::model::prob_grad(1),
+        reject_above_(reject_above),
+        fail_above_(fail_above) {}
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    if (stan::math::value_of(params_r__[0]) > fail_above_)
+      throw std::out_of_range("out_of_range error in log_prob");
+    if (stan::math::value_of(params_r__[0]) > reject_above_)
+      throw std::domain_error("rejecting within log_prob");
+    return -0.5 * params_r__[0] * params_r__[0];
+  }
+
+  void transform_inits(const stan::io::var_context& context__,
+                       std::vector<int>& params_i__,
+                       std::vector<double>& params_r__,
+                       std::ostream* pstream__) const {
+    params_r__ = context__.vals_r("theta");
+  }
+
+  void get_dims(std::vector<std::vector<size_t> >& dimss__,
+                bool include_tparams = true, bool include_gqs = true) const {
+    dimss__.clear();
+    dimss__.push_back(std::vector<size_t>());
+  }
+
+  void get_param_names(std::vector<std::string>& names,
+                       bool include_tparams = true,
+                       bool include_gqs = true) const {
+    names.clear();
+    names.push_back("theta");
+  }
+
+  void constrained_param_names(std::vector<std::string>& param_names__,
+                               bool include_tparams__ = true,
+                               bool include_gqs__ = true) const {
+    get_param_names(param_names__);
+  }
+
+  void unconstrained_param_names(std::vector<std::string>& param_names__,
+                                 bool include_tparams__ = true,
+                                 bool include_gqs__ = true) const {
+    get_param_names(param_names__);
+  }
+
+  template <typename RNG>
+  void write_array(RNG& base_rng__, std::vector<double>& params_r__,
+                   std::vector<int>& params_i__, std::vector<double>& vars__,
+                   bool include_tparams__ = true, bool include_gqs__ = true,
+                   std::ostream* pstream__ = 0) const {
+    vars__ = params_r__;
+  }
+
+  double reject_above_;
+  double fail_above_;
+};
+
+using context_ptr = std::shared_ptr<stan::io::var_context>;
+
+context_ptr theta_context(double theta) {
+  std::vector<std::string> names{"theta"};
+  std::vector<double> values{theta};
+  std::vector<std::vector<size_t> > dims{{}};
+  return std::make_shared<stan::io::array_var_context>(names, values, dims);
+}
+}  // namespace test
+
+TEST(ServicesUtilInitializeChains, matches_initialize) {
+  std::vector<test::mock_chain_model> models{
+      test::mock_chain_model(-1.5, 10), test::mock_chain_model(-1.5, 1.5)};
+  const size_t num_chains = 3;
+  std::vector<test::context_ptr> init(
+      num_chains, std::make_shared<stan::io::empty_var_context>());
+  for (auto& model : models) {
+    std::stringstream serial_log;
+    stan::callbacks::stream_logger serial_logger(serial_log, serial_log,
+                                                 serial_log, serial_log,
+                                                 serial_log);
+    std::vector<std::vector<double> > serial_inits;
+    std::vector<stan::rng_t::result_type> serial_draws;
+    for (size_t i = 0; i < num_chains; ++i) {
+      stan::test::unit::instrumented_writer writer;
+      stan::rng_t rng = stan::services::util::create_rng(7, i + 1);
+      try {
+        serial_inits.push_back(stan::services::util::initialize(
+            model, *init[i], rng, 2, false, serial_logger, writer));
+      } catch (const std::exception& e) {
+        serial_logger.error(e.what());
+        serial_inits.emplace_back();
+      }
+      serial_draws.push_back(rng());
+    }
+
+    for (size_t pool_size : {1, 3, 16}) {
+      std::stringstream log;
+      stan::callbacks::stream_logger logger(log, log, log, log, log);
+      std::vector<stan::test::unit::instrumented_writer> writers(num_chains);
+      std::vector<stan::rng_t> rngs;
+      for (size_t i = 0; i < num_chains; ++i)
+        rngs.push_back(stan::services::util::create_rng(7, i + 1));
+      std::vector<stan::services::util::chain_init> inits
+          = stan::services::util::initialize_chains(
+              model, init, rngs, 2, false, pool_size, logger, writers);
+      EXPECT_EQ(serial_log.str(), log.str()) << pool_size;
+      ASSERT_EQ(num_chains, inits.size());
+      for (size_t i = 0; i < num_chains; ++i) {
+        EXPECT_EQ(!serial_inits[i].empty(), inits[i].ok);
+        EXPECT_EQ(serial_inits[i], inits[i].cont_vector);
+        EXPECT_EQ(serial_draws[i], rngs[i]());
+        EXPECT_EQ(inits[i].ok ? 1 : 0, writers[i].call_count());
+        if (inits[i].ok) {
+          double theta = inits[i].cont_vector[0];
+          EXPECT_FLOAT_EQ(-0.5 * theta * theta, inits[i].log_prob);
+          EXPECT_EQ(1, inits[i].gradient.size());
+        }
+      }
+    }
+  }
+}
+
+TEST(ServicesUtilInitializeChains, chain_failure) {
+  test::mock_chain_model model(1, 10);
+  std::vector<test::context_ptr> init{test::theta_context(0.5),
+                                      test::theta_context(5),
+                                      test::theta_context(-0.5)};
+  std::vector<stan::rng_t> rngs;
+  for (size_t i = 0; i < init.size(); ++i)
+    rngs.push_back(stan::services::util::create_rng(0, i + 1));
+  stan::test::unit::instrumented_logger logger;
+  std::vector<stan::test::unit::instrumented_writer> writers(init.size());
+
+  std::vector<stan::services::util::chain_init> inits
+      = stan::services::util::initialize_chains(model, init, rngs, 2, false,
+                                                4, logger, writers);
+  ASSERT_EQ(3, inits.size());
+  EXPECT_TRUE(inits[0].ok);
+  EXPECT_FALSE(inits[1].ok);
+  EXPECT_TRUE(inits[2].ok);
+  EXPECT_EQ(std::vector<double>{0.5}, inits[0].cont_vector);
+  EXPECT_EQ(std::vector<double>{-0.5}, inits[2].cont_vector);
+  EXPECT_FLOAT_EQ(-0.125, inits[2].log_prob);
+  EXPECT_EQ(1, writers[0].call_count());
+  EXPECT_EQ(0, writers[1].call_count());
+  EXPECT_EQ(1, writers[2].call_count());
+  EXPECT_EQ(1, logger.find_warn("rejecting within log_prob"));
+  EXPECT_EQ(1, logger.find_error("Initialization failed."));
+}
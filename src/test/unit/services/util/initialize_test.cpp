@@ -578,3 +578,86 @@ TEST_F(ServicesUtilInitialize, model_throws_in_write_array__full_init) {
   EXPECT_EQ(2, logger.call_count_error());
   EXPECT_EQ(100, logger.find_warn("throwing within write_array"));
 }
+
+
+namespace test {
+// Mock model rejecting initial values of theta above a threshold and
+// failing for values above another
+class mock_threshold_model : public mock_throwing_model {
+ public:
+  mock_threshold_model(double reject_above, double fail_above)
+      : reject_above_(reject_above), fail_above_(fail_above) {}
+
+  template <bool propto__, bool jacobian__, typename T__>
+  T__ log_prob(std::vector<T__>& params_r__, std::vector<int>& params_i__,
+               std::ostream* pstream__ = 0) const {
+    if (stan::math::value_of(params_r__[0]) > fail_above_)
+      throw std::out_of_range("out_of_range error in log_prob");
+    if (stan::math::value_of(params_r__[0]) > reject_above_)
+      throw std::domain_error("rejecting within log_prob");
+    return T__(0);
+  }
+
+  double reject_above_;
+  double fail_above_;
+};
+
+// Return the result of a serial or parallel initialization, its log and
+// the next draw of the generator
+template <typename Model>
+std::string initialize_log(Model& model, size_t batch_size,
+                           std::vector<double>& params, unsigned& next_draw) {
+  stan::io::empty_var_context empty_context;
+  std::stringstream log;
+  stan::callbacks::stream_logger logger(log, log, log, log, log);
+  stan::test::unit::instrumented_writer init;
+  stan::rng_t rng = stan::services::util::create_rng(3, 1);
+  try {
+    if (batch_size == 0)
+      params = stan::services::util::initialize(model, empty_context, rng, 2,
+                                                false, logger, init);
+    else
+      params = stan::services::util::initialize_parallel(
+          model, empty_context, rng, 2, false, batch_size, logger, init);
+  } catch (const std::exception& e) {
+    log << "threw " << e.what();
+  }
+  next_draw = rng();
+  return log.str();
+}
+}  // namespace test
+
+TEST_F(ServicesUtilInitialize, parallel_matches_serial) {
+  std::vector<test::mock_threshold_model> models{
+      test::mock_threshold_model(-1.5, 10), test::mock_threshold_model(-3, 10),
+      test::mock_threshold_model(-1.5, 1.5)};
+  for (auto& threshold_model : models) {
+    std::vector<double> serial_params;
+    unsigned serial_draw;
+    std::string serial_log
+        = test::initialize_log(threshold_model, 0, serial_params, serial_draw);
+    for (size_t batch_size : {1, 3, 8, 200}) {
+      std::vector<double> params;
+      unsigned draw;
+      EXPECT_EQ(serial_log,
+                test::initialize_log(threshold_model, batch_size, params, draw))
+          << batch_size;
+      EXPECT_EQ(serial_params, params);
+      EXPECT_EQ(serial_draw, draw);
+    }
+  }
+}
+
+TEST_F(ServicesUtilInitialize, parallel_model_throws__radius_two) {
+  test::mock_throwing_model throwing_model;
+
+  double init_radius = 2;
+  bool print_timing = false;
+  EXPECT_THROW(stan::services::util::initialize_parallel(
+                   throwing_model, empty_context, rng, init_radius,
+                   print_timing, 8, logger, init),
+               std::domain_error);
+  EXPECT_EQ(303, logger.call_count());
+  EXPECT_EQ(300, logger.call_count_warn());
+  EXPECT_EQ(100, logger.find_warn("throwing within log_prob"));
+}
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <test/unit/services/instrumented_callbacks.hpp>
 #include <test/test-models/good/services/test_lp.hpp>
+#include <stan/callbacks/json_writer.hpp>
 #include <stan/callbacks/logger.hpp>
 #include <stan/callbacks/writer.hpp>
 #include <stan/io/empty_var_context.hpp>
@@ -187,6 +188,8 @@ class mock_sampler : public stan::mcmc::base_mcmc {
   int n_get_sampler_param_names;
   int n_get_sampler_params;
   int n_write_sampler_state;
+  int n_write_sampler_stepsize;
+  int n_write_sampler_state_struct;
   int n_get_sampler_diagnostic_names;
   int n_get_sampler_diagnostics;
 
@@ -197,6 +200,8 @@ class mock_sampler : public stan::mcmc::base_mcmc {
     n_get_sampler_param_names = 0;
     n_get_sampler_params = 0;
     n_write_sampler_state = 0;
+    n_write_sampler_stepsize = 0;
+    n_write_sampler_state_struct = 0;
     n_get_sampler_diagnostic_names = 0;
     n_get_sampler_diagnostics = 0;
   }
@@ -220,6 +225,15 @@ class mock_sampler : public stan::mcmc::base_mcmc {
     ++n_write_sampler_state;
   }
 
+  void write_sampler_stepsize(stan::callbacks::writer& writer) {
+    ++n_write_sampler_stepsize;
+  }
+
+  void write_sampler_state_struct(
+      stan::callbacks::structured_writer& struct_writer) {
+    ++n_write_sampler_state_struct;
+  }
+
   void get_sampler_diagnostic_names(std::vector<std::string>& model_names,
                                     std::vector<std::string>& names) {
     ++n_get_sampler_diagnostic_names;
@@ -259,6 +273,76 @@ TEST_F(ServicesUtil, write_sample_params) {
   EXPECT_EQ(0, logger.call_count());
 }
 
+TEST_F(ServicesUtil, write_sample_params_deferred) {
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(2);
+  stan::mcmc::sample sample(x, 1, 2);
+  mock_sampler sampler;
+
+  mcmc_writer.defer_model_values(2);
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  EXPECT_EQ(0, sample_writer.call_count());
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  EXPECT_EQ(2, sample_writer.call_count("vector_double"));
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  EXPECT_EQ(2, sample_writer.call_count("vector_double"));
+  mcmc_writer.flush_deferred();
+  EXPECT_EQ(3, sample_writer.call_count("vector_double"));
+
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  mcmc_writer.write_adapt_finish(sampler);
+  EXPECT_EQ(4, sample_writer.call_count("vector_double"));
+  EXPECT_EQ(1, sample_writer.call_count("string"));
+  EXPECT_EQ(0, logger.call_count());
+
+  mcmc_writer.defer_model_values(0);
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  EXPECT_EQ(5, sample_writer.call_count("vector_double"));
+}
+
+TEST_F(ServicesUtil, write_sample_params_output_spec) {
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(2);
+  stan::mcmc::sample sample(x, 1.23456, 0.5);
+  mock_sampler sampler;
+
+  stan::services::util::sample_output_spec spec;
+  spec.columns = {"lp__", "y", "xgq"};
+  spec.include_gqs = false;
+  spec.sampler_digits = 3;
+  mcmc_writer.set_output_spec(spec);
+  mcmc_writer.write_sample_names(sample, sampler, model);
+  mcmc_writer.write_sample_params(rng, sample, sampler, model);
+  EXPECT_EQ(4, mcmc_writer.num_model_params_);
+
+  std::vector<std::string> expected_names{"lp__", "y.1", "y.2"};
+  ASSERT_EQ(1, sample_writer.vector_string_values().size());
+  EXPECT_EQ(expected_names, sample_writer.vector_string_values()[0]);
+  ASSERT_EQ(1, sample_writer.vector_double_values().size());
+  std::vector<double> values = sample_writer.vector_double_values()[0];
+  ASSERT_EQ(3, values.size());
+  EXPECT_EQ(1.23, values[0]);
+  EXPECT_FLOAT_EQ(0, values[1]);
+  EXPECT_FLOAT_EQ(0, values[2]);
+}
+
+TEST_F(ServicesUtil, write_sample_params_output_spec_sampler_only) {
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(2);
+  stan::mcmc::sample sample(x, 1, 2);
+  mock_sampler sampler;
+
+  stan::services::util::sample_output_spec spec;
+  spec.columns = {"accept_stat__"};
+  mcmc_writer.set_output_spec(spec);
+  mcmc_writer.write_sample_names(sample, sampler, throwing_model);
+  // write_array, which throws, is not called for the sampler columns
+  mcmc_writer.write_sample_params(rng, sample, sampler, throwing_model);
+  EXPECT_EQ(0, logger.call_count());
+  ASSERT_EQ(1, sample_writer.vector_double_values().size());
+  EXPECT_EQ(std::vector<double>{2}, sample_writer.vector_double_values()[0]);
+}
+
 TEST_F(ServicesUtil, write_adapt_finish) {
   mock_sampler sampler;
 
@@ -269,6 +353,26 @@ TEST_F(ServicesUtil, write_adapt_finish) {
   EXPECT_EQ(0, logger.call_count());
 }
 
+TEST_F(ServicesUtil, write_adapted_state) {
+  mock_sampler sampler;
+  stan::callbacks::structured_writer no_metric_writer;
+
+  mcmc_writer.write_adapted_state(sampler, no_metric_writer);
+  EXPECT_EQ(1, sampler.n_write_sampler_state);
+  EXPECT_EQ(0, sampler.n_write_sampler_stepsize);
+  EXPECT_EQ(1, sampler.n_write_sampler_state_struct);
+  EXPECT_EQ(0, sample_writer.call_count());
+
+  sampler.reset();
+  stan::callbacks::json_writer<std::stringstream> metric_writer(
+      std::unique_ptr<std::stringstream>(new std::stringstream));
+  mcmc_writer.write_adapted_state(sampler, metric_writer);
+  EXPECT_EQ(0, sampler.n_write_sampler_state);
+  EXPECT_EQ(1, sampler.n_write_sampler_stepsize);
+  EXPECT_EQ(1, sampler.n_write_sampler_state_struct);
+  EXPECT_EQ(1, sample_writer.call_count("string"));
+}
+
 TEST_F(ServicesUtil, write_diagnostic_names) {
   Eigen::VectorXd x = Eigen::VectorXd::Zero(2);
   stan::mcmc::sample sample(x, 1, 2);
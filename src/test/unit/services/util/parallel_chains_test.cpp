@@ -0,0 +1,120 @@
+#include <stan/callbacks/cancellable_interrupt.hpp>
+#include <stan/services/util/parallel_chains.hpp>
+#include <test/unit/services/instrumented_callbacks.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ServicesUtil, parallel_chains) {
+  std::vector<int> runs(7, 0);
+  stan::services::util::parallel_chains(7, [&runs](size_t i) { ++runs[i]; });
+  for (int run : runs)
+    EXPECT_EQ(1, run);
+}
+
+TEST(ServicesUtil, parallel_chains_numa_nodes) {
+  stan::services::util::execution_policy policy;
+  policy.num_threads = 2;
+  // -1 runs the chains of a node without binding them
+  policy.chain_numa_nodes = {-1, -1, -1};
+  std::vector<int> runs(7, 0);
+  std::vector<int> concurrency(7, 0);
+  stan::services::util::execute(policy, [&]() {
+    stan::services::util::parallel_chains(7, [&](size_t i) {
+      ++runs[i];
+      concurrency[i] = tbb::this_task_arena::max_concurrency();
+    });
+  });
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(1, runs[i]);
+    // The threads are split between the nodes, with at least one each
+    EXPECT_EQ(1, concurrency[i]);
+  }
+}
+
+TEST(ServicesUtil, parallel_chains_throw) {
+  stan::services::util::execution_policy policy;
+  policy.chain_numa_nodes = {-1, -1};
+  std::atomic<int> runs{0};
+  auto run_chains = [&runs]() {
+    stan::services::util::parallel_chains(4, [&runs](size_t i) {
+      ++runs;
+      if (i == 1)
+        throw std::domain_error("chain");
+    });
+  };
+  EXPECT_THROW(stan::services::util::execute(policy, run_chains),
+               std::domain_error);
+  EXPECT_EQ(4, runs);
+
+  policy.chain_numa_nodes = {1 << 20};
+  EXPECT_THROW(stan::services::util::execute(policy, []() {}),
+               std::invalid_argument);
+}
+
+TEST(ServicesUtil, parallel_chains_cancel) {
+  stan::test::unit::instrumented_interrupt interrupt;
+  stan::callbacks::cancellation_token cancel;
+  stan::callbacks::cancellable_interrupt chain_interrupt(interrupt, cancel);
+  std::vector<int> iterations(4, 0);
+  auto run_chain = [&](size_t i) {
+    if (i == 0)
+      throw std::domain_error("chain");
+    // The other chains stop once the failing chain cancels the token
+    for (int m = 0; m < 100000000; ++m) {
+      chain_interrupt();
+      ++iterations[i];
+    }
+  };
+  EXPECT_THROW(
+      stan::services::util::parallel_chains(4, run_chain, &cancel),
+      std::domain_error);
+  EXPECT_TRUE(cancel.cancelled());
+  for (int i = 0; i < 4; ++i)
+    EXPECT_LT(iterations[i], 100000000);
+}
+
+namespace {
+// Interrupt which throws once it has been called the specified number
+// of times, as an interface does on ctrl-c
+class counting_interrupt : public stan::callbacks::interrupt {
+ public:
+  explicit counting_interrupt(int max_calls) : max_calls_(max_calls) {}
+
+  void operator()() {
+    if (++calls_ > max_calls_)
+      throw std::runtime_error("interrupted");
+  }
+
+ private:
+  std::atomic<int> calls_{0};
+  const int max_calls_;
+};
+}  // namespace
+
+TEST(ServicesUtil, parallel_chains_interrupt) {
+  counting_interrupt interrupt(1000);
+  std::vector<int> iterations(4, 0);
+  auto run_chain = [&](size_t i, stan::callbacks::interrupt& chain_interrupt) {
+    for (int m = 0; m < 100000000; ++m) {
+      chain_interrupt();
+      ++iterations[i];
+    }
+  };
+  EXPECT_THROW(
+      stan::services::util::parallel_chains(4, interrupt, run_chain),
+      std::runtime_error);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_LT(iterations[i], 100000000);
+
+  // A token of the caller is cancelled as well
+  stan::callbacks::cancellation_token cancel;
+  auto poll = [](size_t i, stan::callbacks::interrupt& chain_interrupt) {
+    chain_interrupt();
+  };
+  EXPECT_THROW(
+      stan::services::util::parallel_chains(4, interrupt, poll, cancel),
+      std::runtime_error);
+  EXPECT_TRUE(cancel.cancelled());
+}
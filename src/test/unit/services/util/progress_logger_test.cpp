@@ -0,0 +1,34 @@
+#include <stan/services/util/progress_logger.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(ServicesUtilProgressLogger, single_chain) {
+  std::stringstream out;
+  stan::callbacks::stream_logger logger(out, out, out, out, out);
+  stan::services::util::progress_logger progress(logger);
+
+  progress(1, 1, 2000, true);
+  progress(1, 1001, 2000, false);
+  progress(1, 2000, 2000, false);
+
+  EXPECT_EQ(
+      "Iteration:    1 / 2000 [  0%]  (Warmup)\n"
+      "Iteration: 1001 / 2000 [ 50%]  (Sampling)\n"
+      "Iteration: 2000 / 2000 [100%]  (Sampling)\n",
+      out.str());
+}
+
+TEST(ServicesUtilProgressLogger, multiple_chains) {
+  std::stringstream out;
+  stan::callbacks::stream_logger logger(out, out, out, out, out);
+  stan::services::util::progress_logger progress(logger, 4);
+
+  progress(2, 5, 20, true);
+  progress(3, 20, 20, false);
+
+  EXPECT_EQ(
+      "Chain [2] Iteration:  5 / 20 [ 25%]  (Warmup)\n"
+      "Chain [3] Iteration: 20 / 20 [100%]  (Sampling)\n",
+      out.str());
+}
@@ -0,0 +1,107 @@
+#include <stan/services/util/rebind_model.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+// Model whose transformed data is the sum of its data, counting how
+// often the constructor runs
+struct streaming_model {
+  static int num_constructed;
+  std::vector<double> y;
+  double sum = 0;
+
+  streaming_model(stan::io::var_context& data, unsigned int seed,
+                  std::ostream* msgs)
+      : y(data.vals_r("y")) {
+    ++num_constructed;
+    for (double x : y)
+      sum += x;
+  }
+
+  bool rebind_data(const stan::io::var_context& data, std::ostream* msgs) {
+    if (data.dims_r("y") != std::vector<size_t>{y.size()})
+      return false;
+    y = data.vals_r("y");
+    sum = 0;
+    for (double x : y)
+      sum += x;
+    return true;
+  }
+};
+
+int streaming_model::num_constructed = 0;
+
+// Model without rebinding support
+struct plain_model {
+  static int num_constructed;
+
+  plain_model(stan::io::var_context& data, unsigned int seed,
+              std::ostream* msgs) {
+    ++num_constructed;
+  }
+
+  bool rebind_data(const stan::io::var_context& data, std::ostream* msgs) {
+    return false;
+  }
+};
+
+int plain_model::num_constructed = 0;
+
+stan::io::array_var_context make_data(std::vector<double> values) {
+  std::vector<std::string> names{"y"};
+  std::vector<std::vector<size_t>> dims{{values.size()}};
+  return stan::io::array_var_context(names, values, dims);
+}
+}  // namespace
+
+TEST(ServicesUtil, rebind_model) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  streaming_model::num_constructed = 0;
+
+  std::unique_ptr<streaming_model> model;
+  const stan::io::array_var_context data = make_data({1, 2, 3});
+  EXPECT_FALSE(stan::services::util::rebind_model(model, data, 0, logger));
+  EXPECT_EQ("", info.str());
+  ASSERT_TRUE(model != nullptr);
+  EXPECT_EQ(1, streaming_model::num_constructed);
+  EXPECT_FLOAT_EQ(6, model->sum);
+
+  // Same dimensions: the data is rebound into the same model
+  const streaming_model* first = model.get();
+  stan::io::array_var_context next_data = make_data({4, 5, 6});
+  EXPECT_TRUE(stan::services::util::rebind_model(model, next_data, 0, logger));
+  EXPECT_EQ(first, model.get());
+  EXPECT_EQ(1, streaming_model::num_constructed);
+  EXPECT_FLOAT_EQ(15, model->sum);
+  EXPECT_NE(std::string::npos, info.str().find("Rebound"));
+
+  // New dimensions: a new model is constructed
+  stan::io::array_var_context larger_data = make_data({1, 1, 1, 1});
+  EXPECT_FALSE(
+      stan::services::util::rebind_model(model, larger_data, 0, logger));
+  EXPECT_EQ(2, streaming_model::num_constructed);
+  EXPECT_FLOAT_EQ(4, model->sum);
+  EXPECT_NE(std::string::npos, info.str().find("Could not rebind"));
+  EXPECT_EQ("", error.str());
+}
+
+TEST(ServicesUtil, rebind_model_unsupported) {
+  std::stringstream debug, info, warn, error, fatal;
+  stan::callbacks::stream_logger logger(debug, info, warn, error, fatal);
+  plain_model::num_constructed = 0;
+
+  std::unique_ptr<plain_model> model;
+  stan::io::array_var_context data = make_data({1, 2, 3});
+  EXPECT_FALSE(stan::services::util::rebind_model(model, data, 0, logger));
+  EXPECT_EQ("", info.str());
+  EXPECT_FALSE(stan::services::util::rebind_model(model, data, 0, logger));
+  EXPECT_EQ(2, plain_model::num_constructed);
+  EXPECT_NE(std::string::npos, info.str().find("Could not rebind"));
+}
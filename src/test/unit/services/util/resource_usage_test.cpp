@@ -0,0 +1,73 @@
+#include <stan/services/util/resource_usage.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Records the keys written, with the nesting of the records
+class key_writer : public stan::callbacks::structured_writer {
+ public:
+  std::vector<std::string> keys;
+  void begin_record(const std::string& key) { keys.push_back(key + "{"); }
+  void end_record() { keys.push_back("}"); }
+  void write(const std::string& key, double value) { keys.push_back(key); }
+  void write(const std::string& key,
+             long long int value) {  // NOLINT(runtime/int)
+    keys.push_back(key);
+  }
+};
+
+// Spin for the specified time on the calling thread
+void busy(std::chrono::milliseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  volatile double x = 0;
+  while (std::chrono::steady_clock::now() < end)
+    x = x + 1;
+}
+
+}  // namespace
+
+TEST(ServicesUtilResourceUsage, since_counts_calling_thread) {
+  using stan::services::util::resource_snapshot;
+  auto start = resource_snapshot::current_thread();
+  busy(std::chrono::milliseconds(50));
+  // CPU used by other threads is not counted
+  std::thread other([]() { busy(std::chrono::milliseconds(300)); });
+  other.join();
+  auto phase = resource_snapshot::current_thread().since(start);
+#ifdef RUSAGE_THREAD
+  ASSERT_TRUE(phase.per_thread());
+  EXPECT_GT(phase.user_time() + phase.system_time(), 0.02);
+  EXPECT_LT(phase.user_time() + phase.system_time(), 0.25);
+  EXPECT_GE(phase.voluntary_context_switches(), 0);
+  EXPECT_GE(phase.minor_page_faults(), 0);
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+  EXPECT_GT(phase.peak_rss_bytes(), 0);
+#endif
+}
+
+TEST(ServicesUtilResourceUsage, write_record) {
+  using stan::services::util::resource_snapshot;
+  key_writer writer;
+  resource_snapshot().write(writer, "empty");
+  EXPECT_TRUE(writer.keys.empty());
+
+  auto start = resource_snapshot::current_thread();
+  resource_snapshot::current_thread().since(start).write(writer, "sampling");
+#ifdef RUSAGE_THREAD
+  std::vector<std::string> expected{"sampling{",
+                                    "peak_rss_bytes",
+                                    "user_time",
+                                    "system_time",
+                                    "voluntary_context_switches",
+                                    "involuntary_context_switches",
+                                    "minor_page_faults",
+                                    "major_page_faults",
+                                    "}"};
+  EXPECT_EQ(expected, writer.keys);
+#endif
+}
@@ -3,12 +3,18 @@
 #include <gtest/gtest.h>
 #include <test/test-models/good/services/test_lp.hpp>
 #include <stan/callbacks/structured_writer.hpp>
+#include <stan/callbacks/json_writer.hpp>
 #include <stan/io/empty_var_context.hpp>
 #include <stan/services/util/create_rng.hpp>
 #include <test/unit/services/instrumented_callbacks.hpp>
 #include <test/unit/mcmc/hmc/mock_hmc.hpp>
 #include <stan/mcmc/hmc/nuts/adapt_unit_e_nuts.hpp>
 
+struct deleter_noop {
+  template <typename T>
+  constexpr void operator()(T* arg) const {}
+};
+
 class ServicesUtil : public testing::Test {
  public:
   ServicesUtil()
@@ -208,3 +214,31 @@ TEST_F(ServicesUtil, num_warmup_num_samples_refresh) {
   EXPECT_EQ(num_samples, diagnostic_writer.call_count("vector_double"))
       << "draws";
 }
+
+TEST_F(ServicesUtil, instrumentation) {
+  num_warmup = 100;
+  num_samples = 50;
+  std::stringstream ss;
+  std::unique_ptr<std::stringstream, deleter_noop> output(&ss);
+  stan::callbacks::json_writer<std::stringstream, deleter_noop>
+      instrumentation_writer(std::move(output));
+  stan::services::util::run_adaptive_sampler(
+      sampler, model, cont_vector, num_warmup, num_samples, num_thin, refresh,
+      save_warmup, rng, interrupt, logger, sample_writer, diagnostic_writer,
+      dummy_metric_writer, instrumentation_writer);
+  EXPECT_EQ(num_warmup + num_samples, interrupt.call_count());
+
+  std::string out = ss.str();
+  out.erase(std::remove_if(out.begin(), out.end(),
+                           [](char c) { return c == ' ' || c == '\n'; }),
+            out.end());
+  EXPECT_NE(std::string::npos, out.find("\"chain_id\":1"));
+  EXPECT_NE(std::string::npos, out.find("\"warmup\":{\"transitions\":100,"));
+  EXPECT_NE(std::string::npos, out.find("\"sampling\":{\"transitions\":50,"));
+  EXPECT_NE(std::string::npos, out.find("\"tree_depth_histogram\":["));
+  EXPECT_NE(std::string::npos, out.find("\"peak_tape_bytes\":"));
+  EXPECT_EQ(std::string::npos, out.find("\"peak_tape_vars\":0"))
+      << "every gradient records a tape";
+  EXPECT_EQ(std::string::npos, out.find("\"gradient_evaluations\":0,"))
+      << "every transition evaluates the gradient";
+}
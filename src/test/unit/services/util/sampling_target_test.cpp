@@ -0,0 +1,101 @@
+#include <stan/services/util/sampling_target.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::string> names() { return {"lp__", "accept_stat__", "mu"}; }
+}  // namespace
+
+TEST(ServicesUtil, sampling_target_reached) {
+  stan::callbacks::cancellation_token cancel;
+  stan::services::util::sampling_target target;
+  target.min_ess = 200;
+  target.max_rhat = 1.1;
+  target.check_every = 50;
+  stan::services::util::sampling_target_monitor monitor(target, 2, cancel);
+  monitor.set_names(names());
+
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> normal;
+  int num_draws = 0;
+  while (!cancel.cancelled() && num_draws < 10000) {
+    for (size_t chain = 0; chain < 2; ++chain) {
+      std::vector<double> draw{-1.0, 0.9, normal(rng)};
+      monitor.add(chain, {stan::callbacks::value_span(draw)});
+    }
+    ++num_draws;
+  }
+  EXPECT_TRUE(monitor.reached());
+  EXPECT_TRUE(cancel.finished());
+  EXPECT_TRUE(monitor.check());
+  EXPECT_EQ(0, monitor.reached_num_draws() % 50);
+  // Independent draws reach the target with a few hundred draws
+  EXPECT_LT(num_draws, 1000);
+}
+
+TEST(ServicesUtil, sampling_target_not_reached) {
+  stan::callbacks::cancellation_token cancel;
+  stan::services::util::sampling_target target;
+  target.params = {"mu"};
+  target.check_every = 10;
+  stan::services::util::sampling_target_monitor monitor(target, 2, cancel);
+  monitor.set_names(names());
+
+  // Chains stuck at different values never converge
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> normal;
+  for (int n = 0; n < 1000; ++n) {
+    for (size_t chain = 0; chain < 2; ++chain) {
+      std::vector<double> draw{-1.0, 0.9, 10.0 * chain + normal(rng)};
+      monitor.add(chain, {stan::callbacks::value_span(draw)});
+    }
+  }
+  EXPECT_FALSE(monitor.reached());
+  EXPECT_FALSE(cancel.cancelled());
+}
+
+TEST(ServicesUtil, sampling_target_unknown_param) {
+  stan::callbacks::cancellation_token cancel;
+  stan::services::util::sampling_target target;
+  target.params = {"sigma"};
+  stan::services::util::sampling_target_monitor monitor(target, 1, cancel);
+  EXPECT_THROW(monitor.set_names(names()), std::invalid_argument);
+
+  target.check_every = 0;
+  EXPECT_THROW(
+      stan::services::util::sampling_target_monitor(target, 1, cancel),
+      std::invalid_argument);
+}
+
+TEST(ServicesUtil, sampling_target_writer) {
+  stan::callbacks::cancellation_token cancel;
+  stan::services::util::sampling_target target;
+  target.check_every = 1;
+  stan::services::util::sampling_target_monitor monitor(target, 1, cancel);
+  std::stringstream out;
+  stan::callbacks::stream_writer sample_writer(out);
+  stan::services::util::sampling_target_writer writer(sample_writer, monitor,
+                                                      0, 2);
+
+  writer(names());
+  writer("Adaptation terminated");
+  std::vector<double> draw{-1.0, 0.9, 0.5};
+  // The skipped warmup draws are written but not monitored
+  writer(draw);
+  writer(draw);
+  EXPECT_FALSE(monitor.check());
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> normal;
+  for (int n = 0; n < 10000 && !cancel.cancelled(); ++n) {
+    draw[2] = normal(rng);
+    writer({stan::callbacks::value_span(draw)});
+  }
+  EXPECT_TRUE(monitor.reached());
+  EXPECT_NE(std::string::npos, out.str().find("lp__,accept_stat__,mu"));
+  EXPECT_NE(std::string::npos, out.str().find("Adaptation terminated"));
+}
@@ -0,0 +1,53 @@
+#include <stan/services/util/std_normal_batch.hpp>
+#include <stan/services/util/create_rng.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+TEST(StdNormalBatch, reproducible_for_seed) {
+  stan::rng_t rng1 = stan::services::util::create_rng(0, 1);
+  stan::rng_t rng2 = stan::services::util::create_rng(0, 1);
+  stan::services::util::std_normal_batch<stan::rng_t> normal1(rng1);
+  stan::services::util::std_normal_batch<stan::rng_t> normal2(rng2);
+
+  for (int n = 0; n < 1000; ++n)
+    EXPECT_EQ(normal1(), normal2());
+}
+
+TEST(StdNormalBatch, fill_matches_scalar_draws) {
+  stan::rng_t rng1 = stan::services::util::create_rng(3, 1);
+  stan::rng_t rng2 = stan::services::util::create_rng(3, 1);
+  stan::services::util::std_normal_batch<stan::rng_t> normal1(rng1);
+  stan::services::util::std_normal_batch<stan::rng_t> normal2(rng2);
+
+  // Start part way into a block and span several blocks
+  normal1();
+  normal2();
+  Eigen::MatrixXd x(100, 7);
+  normal1.fill(x);
+  for (Eigen::Index j = 0; j < x.cols(); ++j)
+    for (Eigen::Index i = 0; i < x.rows(); ++i)
+      EXPECT_EQ(normal2(), x(i, j));
+
+  Eigen::MatrixXd y = Eigen::MatrixXd::Zero(10, 10);
+  normal1.fill(y.block(2, 3, 4, 5));
+  EXPECT_EQ(0, y.block(0, 0, 2, 10).squaredNorm());
+  EXPECT_EQ(0, y.block(0, 0, 10, 3).squaredNorm());
+  for (Eigen::Index j = 3; j < 8; ++j)
+    for (Eigen::Index i = 2; i < 6; ++i)
+      EXPECT_EQ(normal2(), y(i, j));
+}
+
+TEST(StdNormalBatch, moments) {
+  stan::rng_t rng = stan::services::util::create_rng(0, 1);
+  stan::services::util::std_normal_batch<stan::rng_t> normal(rng);
+
+  Eigen::VectorXd x(100000);
+  normal.fill(x);
+  EXPECT_TRUE(x.allFinite());
+  double mean = x.mean();
+  double var = (x.array() - mean).square().sum() / (x.size() - 1);
+  double kurtosis = (x.array() - mean).pow(4).mean() / (var * var);
+  EXPECT_NEAR(0, mean, 0.02);
+  EXPECT_NEAR(1, var, 0.02);
+  EXPECT_NEAR(3, kurtosis, 0.1);
+}
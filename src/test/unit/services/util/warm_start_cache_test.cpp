@@ -0,0 +1,68 @@
+#include <stan/services/util/warm_start_cache.hpp>
+#include <stan/io/array_var_context.hpp>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct mock_model {
+  std::string model_name() const { return "mock_model"; }
+  size_t num_params_r() const { return 3; }
+};
+
+stan::io::array_var_context make_data(double y) {
+  std::vector<std::string> names{"y", "mu"};
+  std::vector<double> values{y, 2.0, 3.0, 0.5};
+  std::vector<std::vector<size_t>> dims{{3}, {}};
+  return stan::io::array_var_context(names, values, dims);
+}
+}  // namespace
+
+TEST(ServicesUtil, warm_start_cache_key) {
+  mock_model model;
+  stan::io::array_var_context data = make_data(1.0);
+  stan::io::array_var_context same_data = make_data(1.0);
+  stan::io::array_var_context other_data = make_data(1.5);
+
+  std::string key = stan::services::util::warm_start_cache::key(model, data);
+  EXPECT_EQ(16, key.size());
+  EXPECT_EQ(key,
+            stan::services::util::warm_start_cache::key(model, same_data));
+  EXPECT_NE(key,
+            stan::services::util::warm_start_cache::key(model, other_data));
+}
+
+TEST(ServicesUtil, warm_start_cache_read_write) {
+  stan::services::util::warm_start_cache cache(".");
+  const std::string key = "warm_start_cache_test";
+  std::remove(cache.path(key).c_str());
+
+  stan::services::util::warm_start state;
+  EXPECT_FALSE(cache.read(key, state));
+
+  state.model_name = "mock_model";
+  state.stepsize = 0.37;
+  state.inv_metric = Eigen::VectorXd::LinSpaced(3, 0.5, 1.5);
+  state.cont_params = {1.0, -2.0, 0.25};
+  cache.write(key, state);
+
+  stan::services::util::warm_start read_state;
+  ASSERT_TRUE(cache.read(key, read_state));
+  EXPECT_EQ("mock_model", read_state.model_name);
+  EXPECT_EQ(0.37, read_state.stepsize);
+  ASSERT_EQ(3, read_state.inv_metric.rows());
+  ASSERT_EQ(1, read_state.inv_metric.cols());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(state.inv_metric(i), read_state.inv_metric(i));
+  EXPECT_EQ(state.cont_params, read_state.cont_params);
+
+  // A corrupt entry is a miss
+  {
+    std::ofstream out(cache.path(key), std::ios::binary | std::ios::trunc);
+    out << "stanwarm";
+  }
+  EXPECT_FALSE(cache.read(key, read_state));
+  std::remove(cache.path(key).c_str());
+}
@@ -0,0 +1,109 @@
+#include <test/test-models/good/variational/multivariate_no_constraint.hpp>
+#include <stan/variational/advi.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/callbacks/stream_writer.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <gtest/gtest.h>
+#include <test/unit/util.hpp>
+#include <vector>
+#include <string>
+#include <stan/services/util/create_rng.hpp>
+
+typedef multivariate_no_constraint_model_namespace::
+    multivariate_no_constraint_model Model;
+
+class advi_parallel_test : public ::testing::Test {
+ public:
+  advi_parallel_test()
+      : logger(log_stream, log_stream, log_stream, log_stream, log_stream),
+        model(dummy_context),
+        cont_params(Eigen::VectorXd::Constant(2, 0.75)),
+        serial_rng(stan::services::util::create_rng(0, 0)),
+        parallel_rng(stan::services::util::create_rng(0, 0)) {}
+
+  std::stringstream log_stream;
+  stan::callbacks::stream_logger logger;
+  stan::io::empty_var_context dummy_context;
+  Model model;
+  Eigen::VectorXd cont_params;
+  stan::rng_t serial_rng;
+  stan::rng_t parallel_rng;
+};
+
+TEST_F(advi_parallel_test, meanfield_matches_serial) {
+  stan::variational::advi<Model, stan::variational::normal_meanfield,
+                          stan::rng_t>
+      serial_advi(model, cont_params, serial_rng, 10, 100, 100, 1);
+  stan::variational::advi<Model, stan::variational::normal_meanfield,
+                          stan::rng_t>
+      parallel_advi(model, cont_params, parallel_rng, 10, 100, 100, 1, true);
+
+  Eigen::VectorXd mu = Eigen::VectorXd::Constant(2, 2.5);
+  Eigen::VectorXd omega = Eigen::VectorXd::Constant(2, 0.1);
+  stan::variational::normal_meanfield q(mu, omega);
+
+  EXPECT_EQ(serial_advi.calc_ELBO(q, logger),
+            parallel_advi.calc_ELBO(q, logger));
+
+  stan::variational::normal_meanfield serial_grad(2);
+  stan::variational::normal_meanfield parallel_grad(2);
+  serial_advi.calc_ELBO_grad(q, serial_grad, logger);
+  parallel_advi.calc_ELBO_grad(q, parallel_grad, logger);
+  for (int d = 0; d < 2; ++d) {
+    EXPECT_EQ(serial_grad.mu()(d), parallel_grad.mu()(d));
+    EXPECT_EQ(serial_grad.omega()(d), parallel_grad.omega()(d));
+  }
+
+  // Both generators were advanced by the same draws
+  EXPECT_EQ(serial_rng(), parallel_rng());
+}
+
+TEST_F(advi_parallel_test, fullrank_matches_serial) {
+  stan::variational::advi<Model, stan::variational::normal_fullrank,
+                          stan::rng_t>
+      serial_advi(model, cont_params, serial_rng, 10, 100, 100, 1);
+  stan::variational::advi<Model, stan::variational::normal_fullrank,
+                          stan::rng_t>
+      parallel_advi(model, cont_params, parallel_rng, 10, 100, 100, 1, true);
+
+  Eigen::VectorXd mu = Eigen::VectorXd::Constant(2, 2.5);
+  Eigen::MatrixXd L_chol(2, 2);
+  L_chol << 1.0, 0.0, 0.3, 0.8;
+  stan::variational::normal_fullrank q(mu, L_chol);
+
+  EXPECT_EQ(serial_advi.calc_ELBO(q, logger),
+            parallel_advi.calc_ELBO(q, logger));
+
+  stan::variational::normal_fullrank serial_grad(2);
+  stan::variational::normal_fullrank parallel_grad(2);
+  serial_advi.calc_ELBO_grad(q, serial_grad, logger);
+  parallel_advi.calc_ELBO_grad(q, parallel_grad, logger);
+  for (int d = 0; d < 2; ++d)
+    EXPECT_EQ(serial_grad.mu()(d), parallel_grad.mu()(d));
+  for (int i = 0; i < 2; ++i)
+    for (int j = 0; j < 2; ++j)
+      EXPECT_EQ(serial_grad.L_chol()(i, j), parallel_grad.L_chol()(i, j));
+
+  EXPECT_EQ(serial_rng(), parallel_rng());
+}
+
+TEST_F(advi_parallel_test, run_draws_deterministic) {
+  auto run = [&](stan::rng_t& rng) {
+    Eigen::VectorXd init = cont_params;
+    stan::variational::advi<Model, stan::variational::normal_meanfield,
+                            stan::rng_t>
+        parallel_advi(model, init, rng, 10, 100, 100, 300, true);
+    std::stringstream parameter_ss;
+    std::stringstream diagnostic_ss;
+    stan::callbacks::stream_writer parameter_writer(parameter_ss);
+    stan::callbacks::stream_writer diagnostic_writer(diagnostic_ss);
+    EXPECT_EQ(0, parallel_advi.run(0.1, false, 50, 0.01, 100, logger,
+                                   parameter_writer, diagnostic_writer));
+    return parameter_ss.str();
+  };
+  std::string first = run(serial_rng);
+  std::string second = run(parallel_rng);
+  EXPECT_EQ(first, second);
+  // The mean and the draws, in several chunks
+  EXPECT_EQ(1 + 300, count_matches("\n", first));
+}
@@ -0,0 +1,128 @@
+#include <test/test-models/good/variational/multivariate_no_constraint.hpp>
+#include <stan/variational/advi.hpp>
+#include <stan/callbacks/stream_logger.hpp>
+#include <stan/io/empty_var_context.hpp>
+#include <gtest/gtest.h>
+#include <test/unit/util.hpp>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <stan/services/util/create_rng.hpp>
+
+typedef multivariate_no_constraint_model_namespace::
+    multivariate_no_constraint_model Model;
+
+// The posterior of the model is normal with mean (3.5, 2.5) and
+// covariance I / 3
+class advi_sticking_the_landing_test : public ::testing::Test {
+ public:
+  advi_sticking_the_landing_test()
+      : logger(log_stream, log_stream, log_stream, log_stream, log_stream),
+        model(dummy_context),
+        cont_params(Eigen::VectorXd::Constant(2, 0.75)),
+        rng(stan::services::util::create_rng(0, 0)),
+        posterior_mu(2),
+        posterior_omega(Eigen::VectorXd::Constant(2, -0.5 * std::log(3.0))) {
+    posterior_mu << 3.5, 2.5;
+  }
+
+  template <class Q>
+  stan::variational::advi<Model, Q, stan::rng_t> make_advi(
+      int n_monte_carlo_grad, bool parallel, bool sticking_the_landing) {
+    return stan::variational::advi<Model, Q, stan::rng_t>(
+        model, cont_params, rng, n_monte_carlo_grad, 100, 100, 1, parallel,
+        sticking_the_landing);
+  }
+
+  std::stringstream log_stream;
+  stan::callbacks::stream_logger logger;
+  stan::io::empty_var_context dummy_context;
+  Model model;
+  Eigen::VectorXd cont_params;
+  stan::rng_t rng;
+  Eigen::VectorXd posterior_mu;
+  Eigen::VectorXd posterior_omega;
+};
+
+TEST_F(advi_sticking_the_landing_test, meanfield_zero_at_posterior) {
+  stan::variational::normal_meanfield q(posterior_mu, posterior_omega);
+  stan::variational::normal_meanfield grad(2);
+  for (bool parallel : {false, true}) {
+    make_advi<stan::variational::normal_meanfield>(10, parallel, true)
+        .calc_ELBO_grad(q, grad, logger);
+    for (int d = 0; d < 2; ++d) {
+      EXPECT_NEAR(0.0, grad.mu()(d), 1e-10);
+      EXPECT_NEAR(0.0, grad.omega()(d), 1e-10);
+    }
+  }
+
+  // Without it the gradient is only zero on average
+  make_advi<stan::variational::normal_meanfield>(10, false, false)
+      .calc_ELBO_grad(q, grad, logger);
+  EXPECT_GT(grad.mu().norm(), 1e-3);
+}
+
+TEST_F(advi_sticking_the_landing_test, fullrank_zero_at_posterior) {
+  Eigen::MatrixXd L_chol = posterior_omega.array().exp().matrix().asDiagonal();
+  stan::variational::normal_fullrank q(posterior_mu, L_chol);
+  stan::variational::normal_fullrank grad(2);
+  for (bool parallel : {false, true}) {
+    make_advi<stan::variational::normal_fullrank>(10, parallel, true)
+        .calc_ELBO_grad(q, grad, logger);
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NEAR(0.0, grad.mu()(i), 1e-10);
+      for (int j = 0; j < 2; ++j)
+        EXPECT_NEAR(0.0, grad.L_chol()(i, j), 1e-10);
+    }
+  }
+}
+
+TEST_F(advi_sticking_the_landing_test, lowrank_zero_at_posterior) {
+  stan::variational::normal_lowrank q(posterior_mu, posterior_omega,
+                                      Eigen::MatrixXd::Zero(2, 1));
+  stan::variational::normal_lowrank grad(2, 1);
+  for (bool parallel : {false, true}) {
+    make_advi<stan::variational::normal_lowrank>(10, parallel, true)
+        .calc_ELBO_grad(q, grad, logger);
+    for (int d = 0; d < 2; ++d) {
+      EXPECT_NEAR(0.0, grad.mu()(d), 1e-10);
+      EXPECT_NEAR(0.0, grad.omega()(d), 1e-10);
+      EXPECT_NEAR(0.0, grad.B()(d, 0), 1e-10);
+    }
+  }
+}
+
+TEST_F(advi_sticking_the_landing_test, meanfield_same_expectation) {
+  Eigen::VectorXd mu = Eigen::VectorXd::Constant(2, 2.5);
+  Eigen::VectorXd omega = Eigen::VectorXd::Constant(2, 0.1);
+  stan::variational::normal_meanfield q(mu, omega);
+  stan::variational::normal_meanfield grad(2);
+  stan::variational::normal_meanfield stl_grad(2);
+  make_advi<stan::variational::normal_meanfield>(10000, false, false)
+      .calc_ELBO_grad(q, grad, logger);
+  make_advi<stan::variational::normal_meanfield>(10000, false, true)
+      .calc_ELBO_grad(q, stl_grad, logger);
+  for (int d = 0; d < 2; ++d) {
+    EXPECT_NEAR(grad.mu()(d), stl_grad.mu()(d), 0.1);
+    EXPECT_NEAR(grad.omega()(d), stl_grad.omega()(d), 0.1);
+  }
+}
+
+TEST_F(advi_sticking_the_landing_test, lowrank_same_expectation) {
+  Eigen::VectorXd mu = Eigen::VectorXd::Constant(2, 2.5);
+  Eigen::VectorXd omega = Eigen::VectorXd::Constant(2, -0.3);
+  Eigen::MatrixXd B(2, 1);
+  B << 0.4, -0.2;
+  stan::variational::normal_lowrank q(mu, omega, B);
+  stan::variational::normal_lowrank grad(2, 1);
+  stan::variational::normal_lowrank stl_grad(2, 1);
+  make_advi<stan::variational::normal_lowrank>(10000, false, false)
+      .calc_ELBO_grad(q, grad, logger);
+  make_advi<stan::variational::normal_lowrank>(10000, true, true)
+      .calc_ELBO_grad(q, stl_grad, logger);
+  for (int d = 0; d < 2; ++d) {
+    EXPECT_NEAR(grad.mu()(d), stl_grad.mu()(d), 0.1);
+    EXPECT_NEAR(grad.omega()(d), stl_grad.omega()(d), 0.1);
+    EXPECT_NEAR(grad.B()(d, 0), stl_grad.B()(d, 0), 0.1);
+  }
+}
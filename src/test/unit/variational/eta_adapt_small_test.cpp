@@ -62,3 +62,18 @@ TEST_F(eta_adapt_small_test, eta_should_be_small) {
   EXPECT_EQ(0.1, advi_meanfield_->adapt_eta(meanfield_init, 1000, logger));
   EXPECT_EQ(0.1, advi_fullrank_->adapt_eta(fullrank_init, 1000, logger));
 }
+
+TEST_F(eta_adapt_small_test, eta_should_be_small_parallel) {
+  stan::variational::normal_meanfield meanfield_init
+      = stan::variational::normal_meanfield(cont_params_);
+  stan::variational::normal_fullrank fullrank_init
+      = stan::variational::normal_fullrank(cont_params_);
+
+  EXPECT_EQ(0.1,
+            advi_meanfield_->adapt_eta_parallel(meanfield_init, 1000, logger));
+  EXPECT_EQ(0.1,
+            advi_fullrank_->adapt_eta_parallel(fullrank_init, 1000, logger));
+  // The messages of the trials are logged in the order of eta
+  EXPECT_LT(log_stream_.str().find("Iteration: 1000 / 5000"),
+            log_stream_.str().find("Iteration: 2000 / 5000"));
+}
@@ -157,3 +157,39 @@ TEST(normal_fullrank_test, calc_log_g) {
 
   EXPECT_FLOAT_EQ(log_g_out, log_g_true);
 }
+
+TEST(normal_fullrank_test, in_place_updates) {
+  Eigen::Vector3d mu;
+  mu << 5.7, -3.2, 0.1332;
+  Eigen::Matrix3d L;
+  L << 1.3, 0, 0, -0.2, 0.8, 0, 0.4, 1.1, 2.0;
+  Eigen::Vector3d grad_mu;
+  grad_mu << 0.3, -1.1, 2.5;
+  Eigen::Matrix3d grad_L;
+  grad_L << -0.7, 0, 0, 0.05, 1.9, 0, 0.6, -0.3, 0.2;
+
+  stan::variational::normal_fullrank q(mu, L);
+  stan::variational::normal_fullrank grad(grad_mu, grad_L);
+  stan::variational::normal_fullrank history(mu.cwiseAbs(), L.cwiseAbs());
+
+  stan::variational::normal_fullrank expected_history
+      = 0.9 * history + 0.1 * grad.square();
+  history.add_weighted_square(grad, 0.9, 0.1);
+  stan::variational::normal_fullrank expected_q
+      = q + 0.25 * grad / (1.0 + history.sqrt());
+  q.add_scaled_step(grad, history, 0.25, 1.0);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(expected_history.mu()(i), history.mu()(i));
+    EXPECT_FLOAT_EQ(expected_q.mu()(i), q.mu()(i));
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_FLOAT_EQ(expected_history.L_chol()(i, j),
+                      history.L_chol()(i, j));
+      EXPECT_FLOAT_EQ(expected_q.L_chol()(i, j), q.L_chol()(i, j));
+    }
+  }
+
+  stan::variational::normal_fullrank other(2);
+  EXPECT_THROW(q.add_weighted_square(other, 0.9, 0.1), std::invalid_argument);
+  EXPECT_THROW(q.add_scaled_step(grad, other, 0.25, 1.0), std::invalid_argument);
+}
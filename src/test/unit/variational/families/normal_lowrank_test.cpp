@@ -0,0 +1,150 @@
+#include <stan/variational/families/normal_lowrank.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+
+namespace {
+Eigen::VectorXd lowrank_mu() {
+  Eigen::VectorXd mu(4);
+  mu << 5.7, -3.2, 0.1332, 1.1;
+  return mu;
+}
+
+Eigen::VectorXd lowrank_omega() {
+  Eigen::VectorXd omega(4);
+  omega << -0.42, 0.8922, 0.34, -1.2;
+  return omega;
+}
+
+Eigen::MatrixXd lowrank_B() {
+  Eigen::MatrixXd B(4, 2);
+  B << 1.3, 0.2, -0.7, 2.3, 0.4, -1.1, 0.0, 0.6;
+  return B;
+}
+
+Eigen::MatrixXd lowrank_covariance() {
+  Eigen::MatrixXd Sigma = lowrank_B() * lowrank_B().transpose();
+  Sigma.diagonal().array() += (2 * lowrank_omega()).array().exp();
+  return Sigma;
+}
+}  // namespace
+
+TEST(normal_lowrank_test, zero_init) {
+  stan::variational::normal_lowrank q(10, 3);
+  EXPECT_EQ(10, q.dimension());
+  EXPECT_EQ(3, q.rank());
+  EXPECT_EQ(10, q.B().rows());
+  EXPECT_EQ(3, q.B().cols());
+  EXPECT_FLOAT_EQ(0.0, q.mu().squaredNorm());
+  EXPECT_FLOAT_EQ(0.0, q.omega().squaredNorm());
+  EXPECT_FLOAT_EQ(0.0, q.B().squaredNorm());
+
+  EXPECT_THROW(stan::variational::normal_lowrank(10, 0), std::domain_error);
+}
+
+TEST(normal_lowrank_test, cont_params_init) {
+  stan::variational::normal_lowrank q(lowrank_mu(), 2);
+  EXPECT_EQ(4, q.dimension());
+  EXPECT_EQ(2, q.rank());
+  for (int i = 0; i < 4; ++i)
+    EXPECT_FLOAT_EQ(lowrank_mu()(i), q.mean()(i));
+
+  // Identity covariance, as for the mean field approximation
+  EXPECT_FLOAT_EQ(0.5 * 4 * (1 + stan::math::LOG_TWO_PI), q.entropy());
+}
+
+TEST(normal_lowrank_test, validation) {
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  Eigen::VectorXd mu_nan = Eigen::VectorXd::Constant(4, nan);
+  Eigen::MatrixXd B_nan = Eigen::MatrixXd::Constant(4, 2, nan);
+
+  EXPECT_THROW(stan::variational::normal_lowrank(mu_nan, lowrank_omega(),
+                                                 lowrank_B()),
+               std::domain_error);
+  EXPECT_THROW(stan::variational::normal_lowrank(lowrank_mu(), mu_nan,
+                                                 lowrank_B()),
+               std::domain_error);
+  EXPECT_THROW(
+      stan::variational::normal_lowrank(lowrank_mu(), lowrank_omega(), B_nan),
+      std::domain_error);
+  EXPECT_THROW(stan::variational::normal_lowrank(
+                   lowrank_mu(), lowrank_omega(), Eigen::MatrixXd(3, 2)),
+               std::invalid_argument);
+
+  stan::variational::normal_lowrank q(lowrank_mu(), lowrank_omega(),
+                                      lowrank_B());
+  EXPECT_THROW(q.set_B(Eigen::MatrixXd::Zero(4, 3)), std::invalid_argument);
+  EXPECT_THROW(q.set_omega(mu_nan), std::domain_error);
+  stan::variational::normal_lowrank other_rank(4, 3);
+  EXPECT_THROW(q += other_rank, std::invalid_argument);
+}
+
+TEST(normal_lowrank_test, entropy) {
+  stan::variational::normal_lowrank q(lowrank_mu(), lowrank_omega(),
+                                      lowrank_B());
+  double entropy_true
+      = 0.5 * 4 * (1 + stan::math::LOG_TWO_PI)
+        + 0.5 * std::log(lowrank_covariance().determinant());
+  EXPECT_FLOAT_EQ(entropy_true, q.entropy());
+}
+
+TEST(normal_lowrank_test, transform) {
+  stan::variational::normal_lowrank q(lowrank_mu(), lowrank_omega(),
+                                      lowrank_B());
+  Eigen::VectorXd eta(6);
+  eta << 7.1, -9.2, 0.59, 0.3, -1.4, 2.2;
+
+  Eigen::VectorXd zeta_true
+      = lowrank_mu()
+        + Eigen::VectorXd(eta.head(4).array() * lowrank_omega().array().exp())
+        + lowrank_B() * eta.tail(2);
+  Eigen::VectorXd zeta = q.transform(eta);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_FLOAT_EQ(zeta_true(i), zeta(i));
+
+  EXPECT_THROW(q.transform(Eigen::VectorXd::Zero(4)), std::invalid_argument);
+  Eigen::VectorXd eta_nan
+      = Eigen::VectorXd::Constant(6, std::numeric_limits<double>::quiet_NaN());
+  EXPECT_THROW(q.transform(eta_nan), std::domain_error);
+}
+
+TEST(normal_lowrank_test, calc_log_g) {
+  stan::variational::normal_lowrank q(lowrank_mu(), lowrank_omega(),
+                                      lowrank_B());
+  Eigen::VectorXd eta(6);
+  eta << 7.1, -9.2, 0.59, 0.3, -1.4, 2.2;
+
+  Eigen::VectorXd r = q.transform(eta) - lowrank_mu();
+  double log_g_true = -0.5 * r.dot(lowrank_covariance().ldlt().solve(r));
+  EXPECT_FLOAT_EQ(log_g_true, q.calc_log_g(eta));
+}
+
+TEST(normal_lowrank_test, in_place_updates) {
+  stan::variational::normal_lowrank q(lowrank_mu(), lowrank_omega(),
+                                      lowrank_B());
+  stan::variational::normal_lowrank grad(
+      Eigen::VectorXd(-0.5 * lowrank_mu()), lowrank_omega().reverse(),
+      Eigen::MatrixXd(0.3 * lowrank_B()));
+  stan::variational::normal_lowrank history = q.square();
+
+  stan::variational::normal_lowrank history_expected
+      = 0.9 * history + 0.1 * grad.square();
+  history.add_weighted_square(grad, 0.9, 0.1);
+  stan::variational::normal_lowrank q_expected
+      = q + 0.25 * grad / (1.0 + history.sqrt());
+  q.add_scaled_step(grad, history, 0.25, 1.0);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_FLOAT_EQ(history_expected.mu()(i), history.mu()(i));
+    EXPECT_FLOAT_EQ(history_expected.omega()(i), history.omega()(i));
+    EXPECT_FLOAT_EQ(q_expected.mu()(i), q.mu()(i));
+    EXPECT_FLOAT_EQ(q_expected.omega()(i), q.omega()(i));
+    for (int j = 0; j < 2; ++j) {
+      EXPECT_FLOAT_EQ(history_expected.B()(i, j), history.B()(i, j));
+      EXPECT_FLOAT_EQ(q_expected.B()(i, j), q.B()(i, j));
+    }
+  }
+
+  q.set_to_zero();
+  EXPECT_FLOAT_EQ(0.0, q.B().squaredNorm());
+}
@@ -153,3 +153,37 @@ TEST(normal_meanfield_test, calc_log_g) {
 
   EXPECT_FLOAT_EQ(log_g_out, log_g_true);
 }
+
+TEST(normal_meanfield_test, in_place_updates) {
+  Eigen::Vector3d mu;
+  mu << 5.7, -3.2, 0.1332;
+  Eigen::Vector3d omega;
+  omega << -0.42, 0.8922, 1.4;
+  Eigen::Vector3d grad_mu;
+  grad_mu << 0.3, -1.1, 2.5;
+  Eigen::Vector3d grad_omega;
+  grad_omega << -0.7, 0.05, 1.9;
+
+  stan::variational::normal_meanfield q(mu, omega);
+  stan::variational::normal_meanfield grad(grad_mu, grad_omega);
+  stan::variational::normal_meanfield history(omega.cwiseAbs(),
+                                              mu.cwiseAbs());
+
+  stan::variational::normal_meanfield expected_history
+      = 0.9 * history + 0.1 * grad.square();
+  history.add_weighted_square(grad, 0.9, 0.1);
+  stan::variational::normal_meanfield expected_q
+      = q + 0.25 * grad / (1.0 + history.sqrt());
+  q.add_scaled_step(grad, history, 0.25, 1.0);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(expected_history.mu()(i), history.mu()(i));
+    EXPECT_FLOAT_EQ(expected_history.omega()(i), history.omega()(i));
+    EXPECT_FLOAT_EQ(expected_q.mu()(i), q.mu()(i));
+    EXPECT_FLOAT_EQ(expected_q.omega()(i), q.omega()(i));
+  }
+
+  stan::variational::normal_meanfield other(2);
+  EXPECT_THROW(q.add_weighted_square(other, 0.9, 0.1), std::invalid_argument);
+  EXPECT_THROW(q.add_scaled_step(grad, other, 0.25, 1.0), std::invalid_argument);
+}